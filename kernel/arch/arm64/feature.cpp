@@ -21,6 +21,9 @@ uint32_t arm64_zva_size = 32;
 uint32_t arm64_icache_size = 32;
 uint32_t arm64_dcache_size = 32;
 
+// the number of asid bits in use, set on the boot cpu
+uint32_t arm64_asid_bits = 16;
+
 static void parse_ccsid(arm64_cache_desc_t* desc, uint64_t ccsid) {
     desc->write_through = BIT(ccsid, 31) > 0;
     desc->write_back = BIT(ccsid, 30) > 0;
@@ -252,9 +255,16 @@ void arm64_feature_init() {
     // read the cache info for each cpu
     arm64_get_cache_info(&(cache_info[cpu]));
 
-    // check to make sure implementation supports 16 bit asids
+    // use 16 bit asids if the boot cpu supports them, in which case the
+    // others must too
     uint64_t mmfr0 = ARM64_READ_SYSREG(ID_AA64MMFR0_EL1);
-    ASSERT((mmfr0 & ARM64_MMFR0_ASIDBITS_MASK) == ARM64_MMFR0_ASIDBITS_16);
+    uint32_t asid_bits =
+        (mmfr0 & ARM64_MMFR0_ASIDBITS_MASK) == ARM64_MMFR0_ASIDBITS_16 ? 16 : 8;
+    if (cpu == 0) {
+        arm64_asid_bits = asid_bits;
+    } else {
+        ASSERT(asid_bits >= arm64_asid_bits);
+    }
 }
 
 static void print_feature() {
@@ -301,6 +311,7 @@ void arm64_feature_debug(bool full) {
         print_feature();
         dprintf(INFO, "ARM cache line sizes: icache %u dcache %u zva %u\n",
                 arm64_icache_size, arm64_dcache_size, arm64_zva_size);
+        dprintf(INFO, "ARM ASID bits: %u\n", arm64_asid_bits);
         if (LK_DEBUGLEVEL > 0) {
             arm64_dump_cache_info(arch_curr_cpu_num());
         }
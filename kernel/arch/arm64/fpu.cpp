@@ -9,10 +9,14 @@
 #include <assert.h>
 #include <bits.h>
 #include <kernel/thread.h>
+#include <lib/counters.h>
 #include <trace.h>
 
 #define LOCAL_TRACE 0
 
+KCOUNTER(fpu_save, "kernel.arm64.fpu.save");
+KCOUNTER(fpu_lazy_restore, "kernel.arm64.fpu.lazy_restore");
+
 /* FPEN bits in the cpacr register
  * 0 means all fpu instructions fault
  * 3 means no faulting at all EL levels
@@ -96,6 +100,7 @@ __NO_SAFESTACK void arm64_fpu_context_switch(struct thread* oldthread,
 
         /* save the state */
         arm64_fpu_save_state(oldthread);
+        kcounter_add(fpu_save, 1);
 
         /* disable the fpu again */
         ARM64_WRITE_SYSREG(cpacr_el1, cpacr & ~FPU_ENABLE_MASK);
@@ -118,6 +123,8 @@ void arm64_fpu_exception(struct arm64_iframe_long* iframe, uint exception_flags)
 
     /* load the state from the current cpu */
     thread_t* t = get_current_thread();
-    if (likely(t))
+    if (likely(t)) {
         arm64_fpu_load_state(t);
+        kcounter_add(fpu_lazy_restore, 1);
+    }
 }
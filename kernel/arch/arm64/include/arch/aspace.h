@@ -8,6 +8,7 @@
 #pragma once
 
 #include <arch/arm64/mmu.h>
+#include <fbl/atomic.h>
 #include <fbl/canary.h>
 #include <fbl/mutex.h>
 #include <vm/arch_vm_aspace.h>
@@ -40,7 +41,16 @@ public:
                      vaddr_t align, size_t size, uint mmu_flags) override;
 
     paddr_t arch_table_phys() const override { return tt_phys_; }
-    uint16_t arch_asid() const { return asid_; }
+    // User aspaces are given an ASID when they are switched to, and it may
+    // change whenever they are. Returns MMU_ARM64_UNUSED_ASID for a user
+    // aspace which has never run.
+    uint16_t arch_asid() const {
+        if (flags_ & (ARCH_ASPACE_FLAG_KERNEL | ARCH_ASPACE_FLAG_GUEST)) {
+            return asid_;
+        }
+        return static_cast<uint16_t>(asid_context_.load(fbl::memory_order_relaxed) &
+                                     ((1u << MMU_ARM64_ASID_BITS) - 1));
+    }
     void arch_set_asid(uint16_t asid) { asid_ = asid; }
 
     static void ContextSwitch(ArmArchVmAspace* from, ArmArchVmAspace* to);
@@ -94,8 +104,13 @@ private:
 
     fbl::Mutex lock_;
 
+    // The ASID of the kernel aspace, or the VMID of a guest aspace.
     uint16_t asid_ = MMU_ARM64_UNUSED_ASID;
 
+    // The generation and ASID the ASID allocator gave a user aspace, or zero
+    // if it has never run.
+    fbl::atomic<uint64_t> asid_context_{0};
+
     // Pointer to the translation table.
     paddr_t tt_phys_ = 0;
     volatile pte_t* tt_virt_ = nullptr;
@@ -6,6 +6,7 @@
 // https://opensource.org/licenses/MIT
 
 #include <arch/arm64/el2_state.h>
+#include <arch/arm64/feature.h>
 #include <arch/arm64/mmu.h>
 #include <arch/aspace.h>
 #include <arch/mmu.h>
@@ -19,7 +20,11 @@
 #include <fbl/auto_call.h>
 #include <fbl/auto_lock.h>
 #include <inttypes.h>
+#include <kernel/cpu.h>
+#include <kernel/lockdep.h>
 #include <kernel/mutex.h>
+#include <kernel/spinlock.h>
+#include <lib/counters.h>
 #include <lib/heap.h>
 #include <lib/ktrace.h>
 #include <rand.h>
@@ -70,69 +75,190 @@ pte_t* arm64_get_kernel_ptable() {
     return arm64_kernel_translation_table;
 }
 
+KCOUNTER(asid_rollovers, "kernel.arm64.asid.rollovers");
+KCOUNTER(asid_new_contexts, "kernel.arm64.asid.new_contexts");
+
 namespace {
 
+// User aspaces are given ASIDs in generations, on the first switch to them
+// in each generation, and keep them for as long as the generation lasts.
+// Once a generation runs out of ASIDs, a rollover starts the next one. Every
+// cpu then flushes its own TLB before it next switches aspaces, and aspaces
+// are given new ASIDs as they are next switched to. The ASIDs in use on each
+// cpu at the rollover carry over into the new generation.
+//
+// An aspace's context holds its generation above its ASID, or is zero if it
+// has never been switched to.
 class AsidAllocator {
 public:
     AsidAllocator() { bitmap_.Reset(MMU_ARM64_MAX_USER_ASID + 1); }
     ~AsidAllocator() = default;
 
-    zx_status_t Alloc(uint16_t* asid);
-    zx_status_t Free(uint16_t asid);
+    // Returns the context to switch the current cpu to for an aspace whose
+    // context is |*context|, giving the aspace a new ASID first if its own
+    // is from an earlier generation. Interrupts must be disabled.
+    uint64_t Switch(fbl::atomic<uint64_t>* context);
+
+    static uint16_t ContextAsid(uint64_t context) {
+        return static_cast<uint16_t>(context & (kGenerationStep - 1));
+    }
 
 private:
     DISALLOW_COPY_ASSIGN_AND_MOVE(AsidAllocator);
 
-    fbl::Mutex lock_;
+    static constexpr uint64_t kGenerationStep = 1ull << MMU_ARM64_ASID_BITS;
+
+    static uint16_t MaxAsid() {
+        return arm64_asid_bits == 16 ? MMU_ARM64_MAX_USER_ASID
+                                     : static_cast<uint16_t>((1u << arm64_asid_bits) - 1);
+    }
+
+    bool IsCurrent(uint64_t context) const {
+        return (context & ~(kGenerationStep - 1)) == generation_.load(fbl::memory_order_relaxed);
+    }
+
+    uint64_t NewContextLocked(uint64_t context) TA_REQ(lock_);
+    bool UpdateReservedLocked(uint64_t context, uint64_t new_context) TA_REQ(lock_);
+    void RolloverLocked() TA_REQ(lock_);
+
+    DECLARE_SPINLOCK(AsidAllocator) lock_;
+
+    fbl::atomic<uint64_t> generation_{kGenerationStep};
     uint16_t last_ TA_GUARDED(lock_) = MMU_ARM64_FIRST_USER_ASID - 1;
 
+    // The ASIDs given out in the current generation.
     bitmap::RawBitmapGeneric<bitmap::FixedStorage<MMU_ARM64_MAX_USER_ASID + 1>> bitmap_ TA_GUARDED(lock_);
 
+    // The context each cpu last switched to, or zero if there has been a
+    // rollover since.
+    fbl::atomic<uint64_t> active_[SMP_MAX_CPUS] = {};
+
+    // The context each cpu was running at the last rollover, whose ASID
+    // stays with its aspace.
+    uint64_t reserved_[SMP_MAX_CPUS] TA_GUARDED(lock_) = {};
+
+    // The cpus which must flush their TLB before switching to an aspace of
+    // the current generation.
+    cpu_mask_t flush_pending_ TA_GUARDED(lock_) = 0;
+
     static_assert(MMU_ARM64_ASID_BITS <= 16, "");
 };
 
-zx_status_t AsidAllocator::Alloc(uint16_t* asid) {
-    uint16_t new_asid;
+uint64_t AsidAllocator::Switch(fbl::atomic<uint64_t>* context) {
+    DEBUG_ASSERT(arch_ints_disabled());
+    const cpu_num_t cpu = arch_curr_cpu_num();
+
+    // If the aspace's ASID is from the current generation and no rollover
+    // has taken over this cpu's active context in the meantime, which the
+    // exchange fails for, there is nothing to do.
+    uint64_t ctx = context->load(fbl::memory_order_relaxed);
+    uint64_t old_active = active_[cpu].load(fbl::memory_order_relaxed);
+    if (likely(old_active != 0 && IsCurrent(ctx) &&
+               active_[cpu].compare_exchange_strong(&old_active, ctx,
+                                                    fbl::memory_order_relaxed,
+                                                    fbl::memory_order_relaxed))) {
+        return ctx;
+    }
 
-    // use the bitmap allocator to allocate ids in the range of
-    // [MMU_ARM64_FIRST_USER_ASID, MMU_ARM64_MAX_USER_ASID]
-    // start the search from the last found id + 1 and wrap when hitting the end of the range
-    {
-        fbl::AutoLock al(&lock_);
-
-        size_t val;
-        bool notfound = bitmap_.Get(last_ + 1, MMU_ARM64_MAX_USER_ASID + 1, &val);
-        if (unlikely(notfound)) {
-            // search again from the start
-            notfound = bitmap_.Get(MMU_ARM64_FIRST_USER_ASID, MMU_ARM64_MAX_USER_ASID + 1, &val);
-            if (unlikely(notfound)) {
-                TRACEF("ARM64: out of ASIDs\n");
-                return ZX_ERR_NO_MEMORY;
-            }
-        }
-        bitmap_.SetOne(val);
+    Guard<SpinLock, NoIrqSave> guard{&lock_};
 
-        DEBUG_ASSERT(val <= UINT16_MAX);
+    ctx = context->load(fbl::memory_order_relaxed);
+    if (!IsCurrent(ctx)) {
+        ctx = NewContextLocked(ctx);
+        context->store(ctx, fbl::memory_order_relaxed);
+    }
 
-        new_asid = (uint16_t)val;
-        last_ = new_asid;
+    const cpu_mask_t mask = cpu_num_to_mask(cpu);
+    if (flush_pending_ & mask) {
+        flush_pending_ &= ~mask;
+        // Drops the entries of every earlier generation from this cpu only.
+        __asm__ volatile("dsb nshst" ::: "memory");
+        ARM64_TLBI_NOADDR(vmalle1);
+        __asm__ volatile("dsb nsh" ::: "memory");
+        ISB;
     }
 
-    LTRACEF("new asid %#x\n", new_asid);
+    active_[cpu].store(ctx, fbl::memory_order_relaxed);
+    return ctx;
+}
+
+uint64_t AsidAllocator::NewContextLocked(uint64_t context) {
+    kcounter_add(asid_new_contexts, 1);
 
-    *asid = new_asid;
+    uint64_t generation = generation_.load(fbl::memory_order_relaxed);
+    if (context != 0) {
+        const uint16_t old_asid = ContextAsid(context);
+        const uint64_t new_context = generation | old_asid;
 
-    return ZX_OK;
-}
+        // The aspace was running at the last rollover, so it keeps its ASID.
+        if (UpdateReservedLocked(context, new_context)) {
+            return new_context;
+        }
+        // Otherwise keep the same ASID if no other aspace has been given it
+        // in this generation yet.
+        if (!bitmap_.GetOne(old_asid)) {
+            bitmap_.SetOne(old_asid);
+            return new_context;
+        }
+    }
 
-zx_status_t AsidAllocator::Free(uint16_t asid) {
-    LTRACEF("free asid %#x\n", asid);
+    // ASIDs are only returned by a rollover, so there is no point looking
+    // below the last one given out.
+    size_t val;
+    bool notfound = bitmap_.Get(last_ + 1, MaxAsid() + 1, &val);
+    if (unlikely(notfound)) {
+        RolloverLocked();
+        generation = generation_.load(fbl::memory_order_relaxed);
+        notfound = bitmap_.Get(MMU_ARM64_FIRST_USER_ASID, MaxAsid() + 1, &val);
+        // Only the ASIDs reserved for the cpus are taken.
+        ASSERT(!notfound);
+    }
+    bitmap_.SetOne(val);
 
-    fbl::AutoLock al(&lock_);
+    DEBUG_ASSERT(val <= UINT16_MAX);
+    last_ = static_cast<uint16_t>(val);
 
-    bitmap_.ClearOne(asid);
+    LTRACEF("new asid %#" PRIxPTR " generation %#" PRIx64 "\n", val, generation);
 
-    return ZX_OK;
+    return generation | val;
+}
+
+bool AsidAllocator::UpdateReservedLocked(uint64_t context, uint64_t new_context) {
+    // The same context may be reserved for more than one cpu, and all of
+    // them must be updated.
+    bool hit = false;
+    for (cpu_num_t i = 0; i < arch_max_num_cpus(); i++) {
+        if (reserved_[i] == context) {
+            reserved_[i] = new_context;
+            hit = true;
+        }
+    }
+    return hit;
+}
+
+void AsidAllocator::RolloverLocked() {
+    kcounter_add(asid_rollovers, 1);
+
+    // Bumping the generation first fails the fast path of any switch to an
+    // aspace of the old one, which the exchanges below make certain of for
+    // switches already past that check.
+    generation_.fetch_add(kGenerationStep, fbl::memory_order_relaxed);
+
+    bitmap_.ClearAll();
+    for (cpu_num_t i = 0; i < arch_max_num_cpus(); i++) {
+        uint64_t context = active_[i].exchange(0, fbl::memory_order_relaxed);
+        // A cpu which has not switched aspaces since the last rollover is
+        // still running the context reserved for it then.
+        if (context == 0) {
+            context = reserved_[i];
+        }
+        if (context != 0) {
+            bitmap_.SetOne(ContextAsid(context));
+        }
+        reserved_[i] = context;
+    }
+    flush_pending_ = CPU_MASK_ALL;
+    last_ = MMU_ARM64_FIRST_USER_ASID - 1;
 }
 
 AsidAllocator asid;
@@ -502,11 +628,18 @@ void ArmArchVmAspace::FlushTLBEntry(vaddr_t vaddr, bool terminal) {
             ARM64_TLBI(vaae1is, vaddr >> 12);
         }
     } else {
+        // A user aspace which has never run has nothing in any TLB.  If its
+        // ASID has gone to another aspace since it last ran, this flushes
+        // the other aspace's entry too, which is harmless.
+        uint16_t asid = arch_asid();
+        if (asid == MMU_ARM64_UNUSED_ASID) {
+            return;
+        }
         // flush this address for the specific asid
         if (terminal) {
-            ARM64_TLBI(vale1is, vaddr >> 12 | (vaddr_t)asid_ << 48);
+            ARM64_TLBI(vale1is, vaddr >> 12 | (vaddr_t)asid << 48);
         } else {
-            ARM64_TLBI(vae1is, vaddr >> 12 | (vaddr_t)asid_ << 48);
+            ARM64_TLBI(vae1is, vaddr >> 12 | (vaddr_t)asid << 48);
         }
     }
 }
@@ -752,7 +885,7 @@ ssize_t ArmArchVmAspace::MapPages(vaddr_t vaddr, paddr_t paddr, size_t size,
 
     LTRACEF("vaddr %#" PRIxPTR ", paddr %#" PRIxPTR ", size %#" PRIxPTR
             ", attrs %#" PRIx64 ", asid %#x\n",
-            vaddr, paddr, size, attrs, asid_);
+            vaddr, paddr, size, attrs, arch_asid());
 
     if (vaddr_rel > vaddr_rel_max - size || size > vaddr_rel_max) {
         TRACEF("vaddr %#" PRIxPTR ", size %#" PRIxPTR " out of range vaddr %#" PRIxPTR ", size %#" PRIxPTR "\n",
@@ -775,7 +908,7 @@ ssize_t ArmArchVmAspace::UnmapPages(vaddr_t vaddr, size_t size,
     vaddr_t vaddr_rel = vaddr - vaddr_base;
     vaddr_t vaddr_rel_max = 1UL << top_size_shift;
 
-    LTRACEF("vaddr 0x%lx, size 0x%lx, asid 0x%x\n", vaddr, size, asid_);
+    LTRACEF("vaddr 0x%lx, size 0x%lx, asid 0x%x\n", vaddr, size, arch_asid());
 
     if (vaddr_rel > vaddr_rel_max - size || size > vaddr_rel_max) {
         TRACEF("vaddr 0x%lx, size 0x%lx out of range vaddr 0x%lx, size 0x%lx\n",
@@ -799,7 +932,7 @@ zx_status_t ArmArchVmAspace::ProtectPages(vaddr_t vaddr, size_t size, pte_t attr
 
     LTRACEF("vaddr %#" PRIxPTR ", size %#" PRIxPTR ", attrs %#" PRIx64
             ", asid %#x\n",
-            vaddr, size, attrs, asid_);
+            vaddr, size, attrs, arch_asid());
 
     if (vaddr_rel > vaddr_rel_max - size || size > vaddr_rel_max) {
         TRACEF("vaddr %#" PRIxPTR ", size %#" PRIxPTR " out of range vaddr %#" PRIxPTR ", size %#" PRIxPTR "\n",
@@ -1058,9 +1191,8 @@ zx_status_t ArmArchVmAspace::Init(vaddr_t base, size_t size, uint flags) {
         if (flags & ARCH_ASPACE_FLAG_GUEST) {
             DEBUG_ASSERT(base + size <= 1UL << MMU_GUEST_SIZE_SHIFT);
         } else {
+            // The ASID comes on the first switch to the aspace.
             DEBUG_ASSERT(base + size <= 1UL << MMU_USER_SIZE_SHIFT);
-            if (asid.Alloc(&asid_) != ZX_OK)
-                return ZX_ERR_NO_MEMORY;
         }
 
         base_ = base;
@@ -1109,9 +1241,13 @@ zx_status_t ArmArchVmAspace::Destroy() {
         __UNUSED zx_status_t status = arm64_el2_tlbi_vmid(vttbr);
         DEBUG_ASSERT(status == ZX_OK);
     } else {
-        ARM64_TLBI(ASIDE1IS, asid_);
-        asid.Free(asid_);
-        asid_ = MMU_ARM64_UNUSED_ASID;
+        // The ASID is only handed on after a rollover, which flushes it
+        // anyway, but its entries point into the page tables freed here.
+        uint16_t asid = arch_asid();
+        if (asid != MMU_ARM64_UNUSED_ASID) {
+            ARM64_TLBI(aside1is, (uint64_t)asid << 48);
+        }
+        asid_context_.store(0, fbl::memory_order_relaxed);
     }
 
     return ZX_OK;
@@ -1128,7 +1264,8 @@ void ArmArchVmAspace::ContextSwitch(ArmArchVmAspace* old_aspace, ArmArchVmAspace
         DEBUG_ASSERT((aspace->flags_ & (ARCH_ASPACE_FLAG_KERNEL | ARCH_ASPACE_FLAG_GUEST)) == 0);
 
         tcr = MMU_TCR_FLAGS_USER;
-        ttbr = ((uint64_t)aspace->asid_ << 48) | aspace->tt_phys_;
+        uint64_t context = asid.Switch(&aspace->asid_context_);
+        ttbr = ((uint64_t)AsidAllocator::ContextAsid(context) << 48) | aspace->tt_phys_;
         ARM64_WRITE_SYSREG(ttbr0_el1, ttbr);
 
         if (TRACE_CONTEXT_SWITCH)
@@ -1141,6 +1278,10 @@ void ArmArchVmAspace::ContextSwitch(ArmArchVmAspace* old_aspace, ArmArchVmAspace
             TRACEF("tcr %#" PRIx64 "\n", tcr);
     }
 
+    if (arm64_asid_bits < 16) {
+        // TCR_EL1.AS is RES0 without 16-bit ASIDs.
+        tcr &= ~MMU_TCR_AS;
+    }
     ARM64_WRITE_SYSREG(tcr_el1, tcr);
 }
 
@@ -71,6 +71,18 @@ cpu_num_t arch_mpid_to_cpu_num(uint cluster, uint cpu) {
     return arm64_cpu_map[cluster][cpu];
 }
 
+cpu_mask_t arch_mp_cache_domain_mask(cpu_num_t cpu) {
+    // cpus within a cluster share the L2
+    cpu_mask_t mask = 0;
+    uint cluster = arm64_cpu_cluster_ids[cpu];
+    for (uint i = 0; i < arm_num_cpus; i++) {
+        if (arm64_cpu_cluster_ids[i] == cluster) {
+            mask |= cpu_num_to_mask(i);
+        }
+    }
+    return mask;
+}
+
 void arch_prepare_current_cpu_idle_state(bool idle) {
     // no-op
 }
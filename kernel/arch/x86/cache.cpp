@@ -26,6 +26,13 @@ void arch_sync_cache_range(addr_t start, size_t len) {
     cpuid(0, &v, &v, &v, &v);
 }
 
+void arch_clean_cache_range_pou(addr_t start, size_t len) {
+}
+
+void arch_invalidate_icache_all(void) {
+    arch_sync_cache_range(0, 0);
+}
+
 void arch_invalidate_cache_range(addr_t start, size_t len) {
 }
 
@@ -359,7 +359,9 @@ static void handle_exception_types(x86_iframe_t* frame) {
 
     case X86_INT_DEVICE_NA:
         kcounter_add(exceptions_dev_na, 1);
-        exception_die(frame, "device na fault\n");
+        if (!x86_extended_register_device_na_handler()) {
+            exception_die(frame, "device na fault\n");
+        }
         break;
 
     case X86_INT_DOUBLE_FAULT:
@@ -455,6 +457,17 @@ static void handle_exception_types(x86_iframe_t* frame) {
 
 /* top level x86 exception handler for most exceptions and irqs */
 void x86_exception_handler(x86_iframe_t* frame) {
+    // Faults taken by x86_copy_from_user_nofault() just fail the copy. This
+    // has to come first as it is used from interrupt handlers.
+    if (unlikely(frame->vector == X86_INT_PAGE_FAULT)) {
+        struct x86_percpu* percpu = x86_get_percpu();
+        if (unlikely(percpu->nofault_return_target)) {
+            ASSERT(!is_from_user(frame));
+            frame->ip = reinterpret_cast<uintptr_t>(percpu->nofault_return_target);
+            return;
+        }
+    }
+
     // are we recursing?
     if (unlikely(arch_blocking_disallowed()) && frame->vector != X86_INT_NMI) {
         exception_die(frame, "recursion in interrupt handler\n");
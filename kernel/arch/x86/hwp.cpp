@@ -6,7 +6,10 @@
 // https://opensource.org/licenses/MIT
 
 #include <arch/x86/feature.h>
+#include <arch/x86/hwp.h>
+#include <arch/ops.h>
 #include <err.h>
+#include <fbl/atomic.h>
 #include <inttypes.h>
 #include <kernel/auto_lock.h>
 #include <kernel/mp.h>
@@ -17,6 +20,11 @@
 
 static bool hwp_enabled = false;
 
+// Whether each cpu's energy-performance preference follows its load.
+static fbl::atomic<bool> hwp_auto(false);
+// The preference last picked for each cpu in automatic mode.
+static uint8_t hwp_auto_hint[SMP_MAX_CPUS];
+
 static SpinLock lock;
 
 static void hwp_enable_sync_task(void* ctx) {
@@ -66,9 +74,51 @@ static void hwp_set_hint(unsigned long hint) {
         printf("HWP hint not supported\n");
         return;
     }
+    hwp_auto.store(false);
     mp_sync_exec(MP_IPI_TARGET_ALL, 0, hwp_set_hint_sync_task, (void*)hint);
 }
 
+static void hwp_set_auto(void) {
+    AutoSpinLockNoIrqSave guard(&lock);
+
+    if (!hwp_enabled) {
+        printf("Enable HWP first\n");
+        return;
+    }
+    if (!x86_feature_test(X86_FEATURE_HWP_PREF)) {
+        printf("HWP hint not supported\n");
+        return;
+    }
+    memset(hwp_auto_hint, 0, sizeof(hwp_auto_hint));
+    hwp_auto.store(true);
+}
+
+void x86_hwp_update_load(uint32_t busy_percent) {
+    if (!hwp_auto.load()) {
+        return;
+    }
+
+    // Mostly idle cpus favor energy efficiency, busy ones performance, and
+    // everything in between keeps the default balance.
+    uint8_t hint;
+    if (busy_percent < 10) {
+        hint = 0xc0;
+    } else if (busy_percent < 50) {
+        hint = 0x80;
+    } else {
+        hint = 0x40;
+    }
+
+    spin_lock_saved_state_t state;
+    arch_interrupt_save(&state, SPIN_LOCK_FLAG_INTERRUPTS);
+    cpu_num_t cpu = arch_curr_cpu_num();
+    if (hwp_auto_hint[cpu] != hint) {
+        hwp_auto_hint[cpu] = hint;
+        hwp_set_hint_sync_task((void*)(unsigned long)hint);
+    }
+    arch_interrupt_restore(state, SPIN_LOCK_FLAG_INTERRUPTS);
+}
+
 static int cmd_hwp(int argc, const cmd_args* argv, uint32_t flags) {
     if (argc < 2) {
     notenoughargs:
@@ -77,6 +127,7 @@ static int cmd_hwp(int argc, const cmd_args* argv, uint32_t flags) {
         printf("usage:\n");
         printf("%s enable\n", argv[0].str);
         printf("%s hint <0-255>\n", argv[0].str);
+        printf("%s auto\n", argv[0].str);
         return ZX_ERR_INTERNAL;
     }
 
@@ -91,6 +142,8 @@ static int cmd_hwp(int argc, const cmd_args* argv, uint32_t flags) {
             goto usage;
         }
         hwp_set_hint(argv[2].u);
+    } else if (!strcmp(argv[1].str, "auto")) {
+        hwp_set_auto();
     } else {
         printf("unknown command\n");
         goto usage;
@@ -8,29 +8,54 @@
 #include <arch/x86/feature.h>
 #include <zircon/syscalls/hypervisor.h>
 
+#include "vcpu_priv.h"
+#include "vmexit_priv.h"
 #include "vmx_cpu_state_priv.h"
 
-static void ignore_msr(VmxPage* msr_bitmaps_page, bool ignore_writes, uint32_t msr) {
+static void clear_msr_bit(VmxPage* msr_bitmaps_page, bool write, uint32_t msr) {
     // From Volume 3, Section 24.6.9.
     uint8_t* msr_bitmaps = msr_bitmaps_page->VirtualAddress<uint8_t>();
     if (msr >= 0xc0000000) {
         msr_bitmaps += 1 << 10;
     }
+    if (write) {
+        msr_bitmaps += 2 << 10;
+    }
 
     uint16_t msr_low = msr & 0x1fff;
     uint16_t msr_byte = msr_low / 8;
     uint8_t msr_bit = msr_low % 8;
+    msr_bitmaps[msr_byte] &= (uint8_t) ~(1 << msr_bit);
+}
 
+static void ignore_msr(VmxPage* msr_bitmaps_page, bool ignore_writes, uint32_t msr) {
     // Ignore reads to the MSR.
-    msr_bitmaps[msr_byte] &= (uint8_t) ~(1 << msr_bit);
+    clear_msr_bit(msr_bitmaps_page, false, msr);
 
     if (ignore_writes) {
         // Ignore writes to the MSR.
-        msr_bitmaps += 2 << 10;
-        msr_bitmaps[msr_byte] &= (uint8_t) ~(1 << msr_bit);
+        clear_msr_bit(msr_bitmaps_page, true, msr);
     }
 }
 
+static void ignore_x2apic_msrs(VmxPage* msr_bitmaps_page) {
+    // From Volume 3, Section 29.5: With APIC-register virtualization, reads of
+    // these registers come from the virtual-APIC page, where the processor
+    // maintains them.
+    ignore_msr(msr_bitmaps_page, false, static_cast<uint32_t>(X2ApicMsr::TPR));
+    ignore_msr(msr_bitmaps_page, false, static_cast<uint32_t>(X2ApicMsr::PPR));
+    for (uint32_t msr = static_cast<uint32_t>(X2ApicMsr::ISR_31_0);
+         msr <= static_cast<uint32_t>(X2ApicMsr::IRR_255_224); msr++) {
+        ignore_msr(msr_bitmaps_page, false, msr);
+    }
+
+    // With virtual-interrupt delivery, writes to the TPR, EOI and self-IPI
+    // registers are virtualized.
+    clear_msr_bit(msr_bitmaps_page, true, static_cast<uint32_t>(X2ApicMsr::TPR));
+    clear_msr_bit(msr_bitmaps_page, true, static_cast<uint32_t>(X2ApicMsr::EOI));
+    clear_msr_bit(msr_bitmaps_page, true, static_cast<uint32_t>(X2ApicMsr::SELF_IPI));
+}
+
 // static
 zx_status_t Guest::Create(fbl::unique_ptr<Guest>* out) {
     // Check that the CPU supports VMX.
@@ -74,6 +99,9 @@ zx_status_t Guest::Create(fbl::unique_ptr<Guest>* out) {
     ignore_msr(&guest->msr_bitmaps_page_, true, X86_MSR_IA32_SYSENTER_CS);
     ignore_msr(&guest->msr_bitmaps_page_, true, X86_MSR_IA32_SYSENTER_ESP);
     ignore_msr(&guest->msr_bitmaps_page_, true, X86_MSR_IA32_SYSENTER_EIP);
+    if (posted_interrupts_supported()) {
+        ignore_x2apic_msrs(&guest->msr_bitmaps_page_);
+    }
 
     // Setup VPID allocator
     fbl::AutoLock lock(&guest->vcpu_mutex_);
@@ -110,9 +138,9 @@ zx_status_t Guest::SetTrap(uint32_t kind, zx_vaddr_t addr, size_t len,
         }
         break;
     case ZX_GUEST_TRAP_IO:
-        if (port) {
-            return ZX_ERR_INVALID_ARGS;
-        } else if (addr + len > UINT16_MAX) {
+        // With a port, writes are delivered through the port and reads, which
+        // need a value to continue, through vcpu_resume.
+        if (addr + len > UINT16_MAX) {
             return ZX_ERR_OUT_OF_RANGE;
         }
         return traps_.InsertTrap(kind, addr, len, fbl::move(port), key);
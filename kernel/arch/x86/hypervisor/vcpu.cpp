@@ -9,6 +9,8 @@
 #include <arch/x86/descriptor.h>
 #include <arch/x86/feature.h>
 #include <arch/x86/pvclock.h>
+#include <arch/x86/registers.h>
+#include <fbl/algorithm.h>
 #include <fbl/auto_call.h>
 #include <hypervisor/cpu.h>
 #include <hypervisor/ktrace.h>
@@ -270,9 +272,23 @@ static void edit_msr_list(VmxPage* msr_list_page, size_t index, uint32_t msr, ui
     entry->value = value;
 }
 
+bool posted_interrupts_supported() {
+    // From Volume 3, Appendix A.3: Bits 63:32 report the allowed 1-settings of
+    // the controls.
+    uint32_t procbased_ctls2 = static_cast<uint32_t>(
+        BITS_SHIFT(read_msr(X86_MSR_IA32_VMX_PROCBASED_CTLS2), 63, 32));
+    uint32_t pinbased_ctls = static_cast<uint32_t>(
+        BITS_SHIFT(read_msr(X86_MSR_IA32_VMX_TRUE_PINBASED_CTLS), 63, 32));
+    const uint32_t required_ctls2 = kProcbasedCtls2ApicRegisterVirt |
+                                    kProcbasedCtls2VirtIntDelivery;
+    return (procbased_ctls2 & required_ctls2) == required_ctls2 &&
+           (pinbased_ctls & kPinbasedCtlsPostedInterrupts);
+}
+
 static zx_status_t vmcs_init(paddr_t vmcs_address, uint16_t vpid, uintptr_t entry,
                              paddr_t msr_bitmaps_address, paddr_t pml4_address, VmxState* vmx_state,
-                             VmxPage* host_msr_page, VmxPage* guest_msr_page) {
+                             VmxPage* host_msr_page, VmxPage* guest_msr_page,
+                             paddr_t virtual_apic_address, paddr_t posted_interrupts_address) {
     zx_status_t status = vmclear(vmcs_address);
     if (status != ZX_OK)
         return status;
@@ -304,15 +320,30 @@ static zx_status_t vmcs_init(paddr_t vmcs_address, uint16_t vpid, uintptr_t entr
                     kProcbasedCtls2Invpcid,
                     0);
 
+    // External interrupts and non-maskable interrupts cause a VM exit.
+    uint32_t pinbased_ctls = kPinbasedCtlsExtIntExiting | kPinbasedCtlsNmiExiting;
+    if (posted_interrupts_address != 0) {
+        status = vmcs.SetControl(VmcsField32::PROCBASED_CTLS2,
+                                 read_msr(X86_MSR_IA32_VMX_PROCBASED_CTLS2),
+                                 vmcs.Read(VmcsField32::PROCBASED_CTLS2),
+                                 // Read the APIC registers the processor
+                                 // maintains from the virtual-APIC page.
+                                 kProcbasedCtls2ApicRegisterVirt |
+                                     // Deliver interrupts from the virtual-APIC
+                                     // page, and virtualize EOIs and self-IPIs.
+                                     kProcbasedCtls2VirtIntDelivery,
+                                 0);
+        if (status != ZX_OK)
+            return status;
+        // Deliver posted interrupts without a VM exit.
+        pinbased_ctls |= kPinbasedCtlsPostedInterrupts;
+    }
+
     // Setup pin-based VMCS controls.
     status = vmcs.SetControl(VmcsField32::PINBASED_CTLS,
                              read_msr(X86_MSR_IA32_VMX_TRUE_PINBASED_CTLS),
                              read_msr(X86_MSR_IA32_VMX_PINBASED_CTLS),
-                             // External interrupts cause a VM exit.
-                             kPinbasedCtlsExtIntExiting |
-                                 // Non-maskable interrupts cause a VM exit.
-                                 kPinbasedCtlsNmiExiting,
-                             0);
+                             pinbased_ctls, 0);
     if (status != ZX_OK)
         return status;
 
@@ -399,6 +430,25 @@ static zx_status_t vmcs_init(paddr_t vmcs_address, uint16_t vpid, uintptr_t entr
     vmcs.Write(VmcsField32::PAGEFAULT_ERRORCODE_MASK, 0);
     vmcs.Write(VmcsField32::PAGEFAULT_ERRORCODE_MATCH, 0);
 
+    // From Volume 3, Section 29.1: The virtual-APIC page holds the virtual TPR
+    // used by TPR shadowing and, with virtual-interrupt delivery, the virtual
+    // IRR and ISR of the guest.
+    vmcs.Write(VmcsField64::VIRTUAL_APIC_ADDRESS, virtual_apic_address);
+    if (posted_interrupts_address != 0) {
+        // From Volume 3, Section 29.6: The processor processes posted
+        // interrupts when it receives the notification vector in VMX non-root
+        // operation. We use the vector we interrupt a running VCPU with, which
+        // the host already handles if the VCPU has exited.
+        vmcs.Write(VmcsField16::POSTED_INTERRUPT_NOTIFICATION_VECTOR, X86_INT_IPI_INTERRUPT);
+        vmcs.Write(VmcsField64::POSTED_INTERRUPT_DESC_ADDRESS, posted_interrupts_address);
+        vmcs.Write(VmcsField16::GUEST_INTERRUPT_STATUS, 0);
+        // We do not emulate level-triggered interrupts, so EOIs never exit.
+        vmcs.Write(VmcsField64::EOI_EXIT_BITMAP_0, 0);
+        vmcs.Write(VmcsField64::EOI_EXIT_BITMAP_1, 0);
+        vmcs.Write(VmcsField64::EOI_EXIT_BITMAP_2, 0);
+        vmcs.Write(VmcsField64::EOI_EXIT_BITMAP_3, 0);
+    }
+
     // From Volume 3, Section 28.1: Virtual-processor identifiers (VPIDs)
     // introduce to VMX operation a facility by which a logical processor may
     // cache information for multiple linear-address spaces. When VPIDs are
@@ -471,7 +521,8 @@ static zx_status_t vmcs_init(paddr_t vmcs_address, uint16_t vpid, uintptr_t entr
     x86_percpu* percpu = x86_get_percpu();
     vmcs.Write(VmcsField64::HOST_IA32_PAT, read_msr(X86_MSR_IA32_PAT));
     vmcs.Write(VmcsField64::HOST_IA32_EFER, read_msr(X86_MSR_IA32_EFER));
-    vmcs.Write(VmcsFieldXX::HOST_CR0, x86_get_cr0());
+    // VM exit loads CR0 from here, and must not leave the FPU trapping.
+    vmcs.Write(VmcsFieldXX::HOST_CR0, x86_get_cr0() & ~X86_CR0_TS);
     vmcs.Write(VmcsFieldXX::HOST_CR3, x86_get_cr3());
     vmcs.Write(VmcsFieldXX::HOST_CR4, x86_get_cr4());
     vmcs.Write(VmcsField16::HOST_ES_SELECTOR, 0);
@@ -669,13 +720,29 @@ zx_status_t Vcpu::Create(Guest* guest, zx_vaddr_t entry, fbl::unique_ptr<Vcpu>*
     status = vcpu->vmcs_page_.Alloc(vmx_info, 0);
     if (status != ZX_OK)
         return status;
+
+    status = vcpu->virtual_apic_page_.Alloc(vmx_info, 0);
+    if (status != ZX_OK)
+        return status;
+    vcpu->local_apic_state_.virtual_apic = vcpu->virtual_apic_page_.VirtualAddress<uint8_t>();
+
+    paddr_t posted_interrupts_address = 0;
+    if (posted_interrupts_supported()) {
+        status = vcpu->posted_interrupts_page_.Alloc(vmx_info, 0);
+        if (status != ZX_OK)
+            return status;
+        vcpu->local_apic_state_.posted_interrupts =
+            vcpu->posted_interrupts_page_.VirtualAddress<PostedInterruptDescriptor>();
+        posted_interrupts_address = vcpu->posted_interrupts_page_.PhysicalAddress();
+    }
     auto_call.cancel();
 
     VmxRegion* region = vcpu->vmcs_page_.VirtualAddress<VmxRegion>();
     region->revision_id = vmx_info.revision_id;
     zx_paddr_t table = gpas->arch_aspace()->arch_table_phys();
     status = vmcs_init(vcpu->vmcs_page_.PhysicalAddress(), vpid, entry, guest->MsrBitmapsAddress(),
-                       table, &vcpu->vmx_state_, &vcpu->host_msr_page_, &vcpu->guest_msr_page_);
+                       table, &vcpu->vmx_state_, &vcpu->host_msr_page_, &vcpu->guest_msr_page_,
+                       vcpu->virtual_apic_page_.PhysicalAddress(), posted_interrupts_address);
     if (status != ZX_OK)
         return status;
 
@@ -699,6 +766,38 @@ Vcpu::~Vcpu() {
     DEBUG_ASSERT(status == ZX_OK);
 }
 
+// Requests the interrupts set in |vectors|, the |index|th 32 of them, in the
+// virtual-APIC page, for the processor to deliver once the guest can take them.
+static void local_apic_request_virtual(AutoVmcs* vmcs, LocalApicState* local_apic_state,
+                                       uint32_t index, uint32_t vectors) {
+    uint32_t* irr = reinterpret_cast<uint32_t*>(local_apic_state->virtual_apic + kVirtualApicIrr +
+                                                index * kVirtualApicRegisterStride);
+    *irr |= vectors;
+
+    // From Volume 3, Section 29.2.1: RVI is the highest requested vector.
+    uint16_t interrupt_status = vmcs->Read(VmcsField16::GUEST_INTERRUPT_STATUS);
+    uint16_t highest = static_cast<uint16_t>(index * 32 + 31 - __builtin_clz(vectors));
+    if (highest > (interrupt_status & kInterruptStatusRviMask)) {
+        interrupt_status = static_cast<uint16_t>(
+            (interrupt_status & ~kInterruptStatusRviMask) | highest);
+        vmcs->Write(VmcsField16::GUEST_INTERRUPT_STATUS, interrupt_status);
+    }
+}
+
+// Moves the interrupts posted for the guest into the virtual-APIC page.
+static void local_apic_sync_posted(AutoVmcs* vmcs, LocalApicState* local_apic_state) {
+    PostedInterruptDescriptor* posted_interrupts = local_apic_state->posted_interrupts;
+    if (posted_interrupts == nullptr || !posted_interrupts->ClearOutstanding()) {
+        return;
+    }
+    for (uint32_t i = 0; i < fbl::count_of(posted_interrupts->requests); i++) {
+        uint32_t vectors = posted_interrupts->requests[i].exchange(0);
+        if (vectors != 0) {
+            local_apic_request_virtual(vmcs, local_apic_state, i, vectors);
+        }
+    }
+}
+
 // Injects an interrupt into the guest, if there is one pending.
 static zx_status_t local_apic_maybe_interrupt(AutoVmcs* vmcs, LocalApicState* local_apic_state) {
     uint32_t vector;
@@ -707,6 +806,20 @@ static zx_status_t local_apic_maybe_interrupt(AutoVmcs* vmcs, LocalApicState* lo
         return status == ZX_ERR_NOT_FOUND ? ZX_OK : status;
     }
 
+    if (local_apic_state->posted_interrupts != nullptr) {
+        // With virtual-interrupt delivery the processor delivers interrupts
+        // from the virtual-APIC page, so we only have to inject exceptions.
+        while (vector >= X86_INT_PLATFORM_BASE) {
+            local_apic_request_virtual(vmcs, local_apic_state, vector / 32, 1u << (vector % 32));
+            status = local_apic_state->interrupt_tracker.Pop(&vector);
+            if (status != ZX_OK) {
+                return status == ZX_ERR_NOT_FOUND ? ZX_OK : status;
+            }
+        }
+        vmcs->IssueInterrupt(vector);
+        return ZX_OK;
+    }
+
     if (vector < X86_INT_PLATFORM_BASE || vmcs->Read(VmcsFieldXX::GUEST_RFLAGS) & X86_FLAGS_IF) {
         // If the vector is non-maskable or interrupts are enabled, we inject an interrupt.
         vmcs->IssueInterrupt(vector);
@@ -739,6 +852,13 @@ zx_status_t Vcpu::Resume(zx_port_packet_t* packet) {
 
         ktrace(TAG_VCPU_ENTER, 0, 0, 0, 0);
         running_.store(true);
+        // Interrupts posted before we are marked as running are picked up
+        // here. Those posted after it send a notification, which is held
+        // until we enter the guest, as interrupts are disabled.
+        local_apic_sync_posted(&vmcs, &local_apic_state_);
+        // The guest runs on this thread's FPU state, which a lazy context
+        // switch may not have loaded.
+        x86_extended_register_ensure_loaded();
         status = vmx_enter(&vmx_state_);
         running_.store(false);
         if (x86_feature_test(X86_FEATURE_XSAVE)) {
@@ -772,11 +892,29 @@ void vmx_exit(VmxState* vmx_state) {
 }
 
 zx_status_t Vcpu::Interrupt(uint32_t vector) {
+    PostedInterruptDescriptor* posted_interrupts = local_apic_state_.posted_interrupts;
+    if (posted_interrupts != nullptr && vector >= X86_INT_PLATFORM_BASE &&
+        vector < X86_INT_COUNT) {
+        bool notify = posted_interrupts->Post(vector);
+        if (!running_.load()) {
+            // The interrupt is picked up when the VCPU next enters the guest,
+            // so only wake the VCPU in case it is halted.
+            local_apic_state_.interrupt_tracker.Signal();
+        } else if (notify) {
+            // The processor delivers the interrupt to the running VCPU without
+            // a VM exit.
+            mp_interrupt(MP_IPI_TARGET_MASK, cpu_num_to_mask(hypervisor::cpu_of(vpid_)));
+        }
+        return ZX_OK;
+    }
+
     bool signaled = false;
     zx_status_t status = local_apic_state_.interrupt_tracker.Interrupt(vector, &signaled);
     if (status != ZX_OK) {
         return status;
     } else if (!signaled && running_.load()) {
+        // With posted interrupts this notification does not cause a VM exit,
+        // and the exception is injected on the next one.
         mp_interrupt(MP_IPI_TARGET_MASK, cpu_num_to_mask(hypervisor::cpu_of(vpid_)));
     }
     return ZX_OK;
@@ -337,10 +337,28 @@ static zx_status_t handle_cpuid(const ExitInfo& exit_info, AutoVmcs* vmcs,
     }
 }
 
+// Returns whether the highest interrupt requested in the virtual-APIC page has
+// a higher priority class than the guest's processor priority, in which case
+// the processor delivers it when we resume the guest.
+static bool local_apic_virtual_pending(AutoVmcs* vmcs, LocalApicState* local_apic_state) {
+    uint16_t rvi = vmcs->Read(VmcsField16::GUEST_INTERRUPT_STATUS) & kInterruptStatusRviMask;
+    uint32_t ppr = *reinterpret_cast<uint32_t*>(local_apic_state->virtual_apic + kVirtualApicPpr);
+    return (rvi & 0xf0) > (ppr & 0xf0);
+}
+
 static zx_status_t handle_hlt(const ExitInfo& exit_info, AutoVmcs* vmcs,
                               LocalApicState* local_apic_state) {
     next_rip(exit_info, vmcs);
-    return local_apic_state->interrupt_tracker.Wait(vmcs);
+    PostedInterruptDescriptor* posted_interrupts = local_apic_state->posted_interrupts;
+    if (posted_interrupts == nullptr) {
+        return local_apic_state->interrupt_tracker.Wait(vmcs);
+    }
+    if (posted_interrupts->Pending() || local_apic_virtual_pending(vmcs, local_apic_state)) {
+        return ZX_OK;
+    }
+    return local_apic_state->interrupt_tracker.Wait(vmcs, [posted_interrupts] {
+        return posted_interrupts->Pending();
+    });
 }
 
 static zx_status_t handle_cr0_write(AutoVmcs* vmcs, GuestState* guest_state, uint64_t val) {
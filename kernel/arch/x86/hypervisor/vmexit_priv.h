@@ -162,6 +162,7 @@ enum class X2ApicMsr : uint32_t {
     VERSION             = 0x803,
     EOI                 = 0x80b,
     TPR                 = 0x808,
+    PPR                 = 0x80a,
     LDR                 = 0x80d,
     SVR                 = 0x80f,
     ISR_31_0            = 0x810,
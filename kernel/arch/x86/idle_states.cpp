@@ -0,0 +1,218 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <arch/x86/idle_states.h>
+
+#include <arch/ops.h>
+#include <arch/x86.h>
+#include <arch/x86/feature.h>
+#include <arch/x86/hwp.h>
+#include <debug.h>
+#include <fbl/algorithm.h>
+#include <inttypes.h>
+#include <kernel/align.h>
+#include <kernel/cmdline.h>
+#include <kernel/percpu.h>
+#include <lib/console.h>
+#include <platform.h>
+#include <stdio.h>
+#include <string.h>
+#include <zircon/time.h>
+#include <zircon/types.h>
+
+namespace {
+
+// CPUID enumerates MWAIT C-states C1 through C7, whatever the platform
+// calls them.
+constexpr uint kMaxIdleStates = 7;
+
+// The number of recent idle periods the prediction is made from.
+constexpr uint kHistoryLength = 8;
+
+// How often the load behind the HWP energy-performance preference is
+// sampled.
+constexpr zx_duration_t kLoadSamplePeriod = ZX_MSEC(100);
+
+struct IdleState {
+    uint32_t mwait_hint;
+    // How long the cpu may take to come out of this state.
+    zx_duration_t exit_latency;
+    // How long the cpu must stay in this state to save more power than the
+    // next shallower state.
+    zx_duration_t target_residency;
+};
+
+// CPUID does not report latencies, and nothing parses ACPI _CST yet.  These
+// are upper bounds taken from the deepest state commonly behind each MWAIT
+// C-state number on recent Intel parts, so the governor errs towards
+// shallower states.
+const IdleState kMwaitStates[kMaxIdleStates] = {
+    {0x00, ZX_USEC(2), ZX_USEC(2)},
+    {0x10, ZX_USEC(80), ZX_USEC(200)},
+    {0x20, ZX_USEC(100), ZX_USEC(300)},
+    {0x30, ZX_USEC(200), ZX_USEC(800)},
+    {0x40, ZX_USEC(300), ZX_USEC(1000)},
+    {0x50, ZX_USEC(500), ZX_USEC(2000)},
+    {0x60, ZX_USEC(900), ZX_USEC(5000)},
+};
+
+struct IdleCpu {
+    // The most recent idle periods, as a ring.
+    zx_duration_t history[kHistoryLength];
+    uint history_index;
+
+    // Per-state residency counters.
+    uint64_t entries[kMaxIdleStates];
+    zx_duration_t residency[kMaxIdleStates];
+
+    // Idle time since the start of the current load sample.
+    zx_time_t sample_start;
+    zx_duration_t sample_idle;
+} __CPU_ALIGN;
+
+// The states this cpu supports, shallowest first.
+IdleState idle_states[kMaxIdleStates];
+// The MWAIT C-state number of each entry in |idle_states|.
+uint idle_state_cstate[kMaxIdleStates];
+uint idle_state_count = 0;
+
+IdleCpu idle_cpus[SMP_MAX_CPUS];
+
+zx_duration_t max_exit_latency = ZX_TIME_INFINITE;
+
+// Predicts how long the current cpu will stay idle: the average of its
+// recent idle periods, but no longer than until its next timer fires.
+zx_duration_t predict_idle(const IdleCpu* idle, cpu_num_t cpu, zx_time_t now) {
+    zx_duration_t predicted = 0;
+    for (uint i = 0; i < kHistoryLength; i++) {
+        predicted = zx_duration_add_duration(predicted, idle->history[i]);
+    }
+    predicted /= kHistoryLength;
+
+    zx_time_t deadline = percpu[cpu].next_timer_deadline;
+    if (deadline != ZX_TIME_INFINITE) {
+        predicted = fbl::min(predicted, zx_time_sub_time(deadline, now));
+    }
+    return predicted;
+}
+
+uint select_state(zx_duration_t predicted) {
+    uint selected = 0;
+    for (uint i = 1; i < idle_state_count; i++) {
+        if (idle_states[i].target_residency > predicted ||
+            idle_states[i].exit_latency > max_exit_latency) {
+            break;
+        }
+        selected = i;
+    }
+    return selected;
+}
+
+} // namespace
+
+void x86_idle_states_init(void) {
+    // Only C1 keeps the local APIC timer running everywhere.  Deeper states
+    // need it to be always running, or the cpu would sleep through its
+    // timers.
+    uint max_cstate = x86_feature_test(X86_FEATURE_ARAT) ? kMaxIdleStates : 1;
+
+    // CPUID.5:EDX holds the number of sub-states of each MWAIT C-state, if
+    // CPUID.5:ECX says it is valid.  Only the first sub-state of each is
+    // used.
+    const struct cpuid_leaf* leaf = x86_get_cpuid_leaf(X86_CPUID_MON);
+    uint32_t substates = (leaf != nullptr && (leaf->c & 1)) ? leaf->d : 0;
+
+    idle_state_count = 0;
+    idle_states[idle_state_count] = kMwaitStates[0];
+    idle_state_cstate[idle_state_count++] = 1;
+    for (uint cstate = 2; cstate <= max_cstate; cstate++) {
+        if ((substates >> (cstate * 4)) & 0xf) {
+            idle_states[idle_state_count] = kMwaitStates[cstate - 1];
+            idle_state_cstate[idle_state_count++] = cstate;
+        }
+    }
+
+    uint32_t max_latency_us = cmdline_get_uint32("kernel.x86.idle.max-latency-us", UINT32_MAX);
+    if (max_latency_us != UINT32_MAX) {
+        max_exit_latency = ZX_USEC(max_latency_us);
+    }
+
+    dprintf(INFO, "x86: %u mwait idle states\n", idle_state_count);
+}
+
+void x86_idle_states_mwait(void) {
+    DEBUG_ASSERT(!arch_ints_disabled());
+
+    cpu_num_t cpu = arch_curr_cpu_num();
+    IdleCpu* idle = &idle_cpus[cpu];
+
+    zx_time_t start = current_time();
+    uint state = select_state(predict_idle(idle, cpu, start));
+
+    x86_mwait(idle_states[state].mwait_hint);
+
+    zx_time_t end = current_time();
+    zx_duration_t slept = zx_time_sub_time(end, start);
+
+    idle->history[idle->history_index] = slept;
+    idle->history_index = (idle->history_index + 1) % kHistoryLength;
+    idle->entries[state]++;
+    idle->residency[state] = zx_duration_add_duration(idle->residency[state], slept);
+
+    idle->sample_idle = zx_duration_add_duration(idle->sample_idle, slept);
+    zx_duration_t sample = zx_time_sub_time(end, idle->sample_start);
+    if (sample >= kLoadSamplePeriod) {
+        // A cpu which stays busy never gets here, so its preference only
+        // catches up once it next goes idle.  HWP still raises the
+        // frequency of a busy cpu on its own in the meantime.
+        uint32_t idle_percent =
+            static_cast<uint32_t>(fbl::min<zx_duration_t>(idle->sample_idle, sample) * 100 / sample);
+        x86_hwp_update_load(100 - idle_percent);
+        idle->sample_start = end;
+        idle->sample_idle = 0;
+    }
+}
+
+static int cmd_idle(int argc, const cmd_args* argv, uint32_t flags) {
+    if (argc < 2) {
+        printf("max exit latency: ");
+        if (max_exit_latency == ZX_TIME_INFINITE) {
+            printf("none\n");
+        } else {
+            printf("%" PRIi64 " us\n", max_exit_latency / ZX_USEC(1));
+        }
+        for (uint i = 0; i < idle_state_count; i++) {
+            printf("C%u: hint %#x exit latency %" PRIi64 " us target residency %" PRIi64 " us\n",
+                   idle_state_cstate[i], idle_states[i].mwait_hint,
+                   idle_states[i].exit_latency / ZX_USEC(1),
+                   idle_states[i].target_residency / ZX_USEC(1));
+        }
+        for (cpu_num_t cpu = 0; cpu < arch_max_num_cpus(); cpu++) {
+            const IdleCpu* idle = &idle_cpus[cpu];
+            printf("cpu %u:", cpu);
+            for (uint i = 0; i < idle_state_count; i++) {
+                printf(" C%u %" PRIu64 " entries %" PRIi64 " ms", idle_state_cstate[i],
+                       idle->entries[i], idle->residency[i] / ZX_MSEC(1));
+            }
+            printf("\n");
+        }
+        return ZX_OK;
+    }
+
+    if (!strcmp(argv[1].str, "latency") && argc >= 3) {
+        max_exit_latency = ZX_USEC(argv[2].u);
+        return ZX_OK;
+    }
+
+    printf("usage:\n");
+    printf("%s                show the mwait idle states and their residency\n", argv[0].str);
+    printf("%s latency <us>   only use idle states with a shorter exit latency\n", argv[0].str);
+    return ZX_ERR_INTERNAL;
+}
+
+STATIC_COMMAND_START
+STATIC_COMMAND("idle", "mwait idle states\n", &cmd_idle)
+STATIC_COMMAND_END(idle);
@@ -40,6 +40,9 @@ struct arch_thread {
     /* Buffer to save fpu and extended register (e.g., PT) state */
     void* extended_register_state;
     uint8_t extended_register_buffer[X86_MAX_EXTENDED_REGISTER_SIZE + 64];
+    /* Whether |extended_register_state| is loaded into the registers; only ever
+     * set for the running thread */
+    bool extended_register_live;
 
     /* if non-NULL, address to return to on page fault */
     void *page_fault_resume;
@@ -85,6 +85,11 @@ public:
     zx_status_t Unmap(vaddr_t vaddr, size_t count, size_t* unmapped) override;
     zx_status_t Protect(vaddr_t vaddr, size_t count, uint mmu_flags) override;
     zx_status_t Query(vaddr_t vaddr, paddr_t* paddr, uint* mmu_flags) override;
+    zx_status_t HarvestAccessed(vaddr_t vaddr, size_t count,
+                                arch_accessed_fn_t accessed_fn, void* context) override;
+
+    void BeginTlbBatch() override { pt_->BeginTlbBatch(); }
+    void EndTlbBatch() override { pt_->EndTlbBatch(); }
 
     vaddr_t PickSpot(vaddr_t base, uint prev_region_mmu_flags,
                      vaddr_t end, uint next_region_mmu_flags,
@@ -9,6 +9,7 @@
 #include <arch/x86/apic.h>
 #include <arch/x86/interrupts.h>
 #include <arch/x86/vmx_state.h>
+#include <fbl/atomic.h>
 #include <fbl/ref_ptr.h>
 #include <fbl/unique_ptr.h>
 #include <hypervisor/guest_physical_address_space.h>
@@ -60,12 +61,45 @@ private:
     Guest() = default;
 };
 
+// Posted-interrupt descriptor. See Volume 3, Section 29.6.
+struct PostedInterruptDescriptor {
+    static constexpr uint32_t kOutstandingNotification = 1u << 0;
+
+    // Posted-interrupt requests, one bit for each vector.
+    fbl::atomic<uint32_t> requests[8];
+    // Bit 0 is the outstanding-notification bit.
+    fbl::atomic<uint32_t> control;
+    uint32_t reserved[7];
+
+    // Posts the given interrupt, and returns whether a notification should be
+    // sent for it, which is the case if none is outstanding.
+    bool Post(uint32_t vector) {
+        requests[vector / 32].fetch_or(1u << (vector % 32));
+        return !(control.fetch_or(kOutstandingNotification) & kOutstandingNotification);
+    }
+
+    // Clears the outstanding-notification bit, and returns whether it was set.
+    // The requests must be picked up after calling this.
+    bool ClearOutstanding() {
+        return control.fetch_and(~kOutstandingNotification) & kOutstandingNotification;
+    }
+
+    // Returns whether there are requests that have not been picked up.
+    bool Pending() const { return control.load() & kOutstandingNotification; }
+};
+static_assert(sizeof(PostedInterruptDescriptor) == 64, "");
+
 // Stores the local APIC state across VM exits.
 struct LocalApicState {
     // Timer for APIC timer.
     timer_t timer;
-    // Tracks pending interrupts.
+    // Tracks pending interrupts. With posted interrupts, this only tracks the
+    // interrupts raised on the VCPU's own thread.
     hypervisor::InterruptTracker<X86_INT_COUNT> interrupt_tracker;
+    // Virtual-APIC page of the VCPU.
+    uint8_t* virtual_apic = nullptr;
+    // Posted-interrupt descriptor of the VCPU, if the processor supports it.
+    PostedInterruptDescriptor* posted_interrupts = nullptr;
     // LVT timer configuration
     uint32_t lvt_timer = LVT_MASKED; // Initial state is masked (Vol 3 Section 10.12.5.1).
     uint32_t lvt_initial_count;
@@ -105,6 +139,8 @@ private:
     VmxPage host_msr_page_;
     VmxPage guest_msr_page_;
     VmxPage vmcs_page_;
+    VmxPage virtual_apic_page_;
+    VmxPage posted_interrupts_page_;
 
     Vcpu(Guest* guest, uint16_t vpid, const thread_t* thread);
 };
@@ -138,6 +138,12 @@ void apic_io_configure_irq_vector(
     uint32_t global_irq,
     uint8_t vector);
 uint8_t apic_io_fetch_irq_vector(uint32_t global_irq);
+// Changes only the destination of the IRQ, leaving the rest of its
+// configuration, including whether it is masked, alone.
+void apic_io_configure_irq_dst(
+    uint32_t global_irq,
+    enum apic_interrupt_dst_mode dst_mode,
+    uint8_t dst);
 
 void apic_io_mask_isa_irq(uint8_t isa_irq, bool mask);
 // For ISA configuration, we don't need to specify the trigger mode
@@ -140,6 +140,7 @@ void x86_feature_debug(void);
 #define X86_FEATURE_SSE2                X86_CPUID_BIT(0x1, 3, 26)
 #define X86_FEATURE_TM                  X86_CPUID_BIT(0x1, 3, 29)
 #define X86_FEATURE_DTS                 X86_CPUID_BIT(0x6, 0, 0)
+#define X86_FEATURE_ARAT                X86_CPUID_BIT(0x6, 0, 2)
 #define X86_FEATURE_PLN                 X86_CPUID_BIT(0x6, 0, 4)
 #define X86_FEATURE_PTM                 X86_CPUID_BIT(0x6, 0, 6)
 #define X86_FEATURE_HWP                 X86_CPUID_BIT(0x6, 0, 7)
@@ -161,6 +162,7 @@ void x86_feature_debug(void);
 #define X86_FEATURE_PT                  X86_CPUID_BIT(0x7, 1, 25)
 #define X86_FEATURE_UMIP                X86_CPUID_BIT(0x7, 2, 2)
 #define X86_FEATURE_PKU                 X86_CPUID_BIT(0x7, 2, 3)
+#define X86_FEATURE_FSRM                X86_CPUID_BIT(0x7, 3, 4)
 #define X86_FEATURE_IBRS_IBPB           X86_CPUID_BIT(0x7, 3, 26)
 #define X86_FEATURE_STIBP               X86_CPUID_BIT(0x7, 3, 27)
 #define X86_FEATURE_SSBD                X86_CPUID_BIT(0x7, 3, 31)
@@ -0,0 +1,19 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <stdint.h>
+#include <zircon/compiler.h>
+
+__BEGIN_CDECLS
+
+// Reports the fraction of the last sample period the current cpu was busy,
+// in percent.  While HWP is in automatic mode, this picks the cpu's
+// energy-performance preference.  Called from the idle thread.
+void x86_hwp_update_load(uint32_t busy_percent);
+
+__END_CDECLS
@@ -0,0 +1,22 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <zircon/compiler.h>
+
+__BEGIN_CDECLS
+
+// Enumerates the MWAIT C-states this cpu supports.  Called once on the boot
+// cpu, before the idle threads start using x86_idle_states_mwait().
+void x86_idle_states_init(void);
+
+// Waits in MWAIT on the current cpu's armed monitor, in the deepest C-state
+// whose exit latency and target residency fit the predicted idle duration.
+// Must be called from the idle thread with interrupts enabled.
+void x86_idle_states_mwait(void);
+
+__END_CDECLS
@@ -73,6 +73,10 @@ struct x86_percpu {
 
     /* Reserved space for interrupt stacks */
     uint8_t interrupt_stacks[NUM_ASSIGNED_IST_ENTRIES][PAGE_SIZE] __ALIGNED(16);
+
+    /* If nonzero and we receive a page fault, change the return IP to this
+     * value. Set by x86_copy_from_user_nofault(). */
+    void* nofault_return_target;
 } __CPU_ALIGN;
 
 static_assert(__offsetof(struct x86_percpu, direct) == PERCPU_DIRECT_OFFSET, "");
@@ -96,6 +100,7 @@ void x86_init_percpu(uint cpu_num);
 void x86_set_local_apic_id(uint32_t apic_id);
 
 int x86_apic_id_to_cpu_num(uint32_t apic_id);
+uint32_t x86_cpu_num_to_apic_id(cpu_num_t cpu_num);
 
 // Allocate all of the necessary structures for all of the APs to run.
 zx_status_t x86_allocate_ap_structures(uint32_t *apic_ids, uint8_t cpu_count);
@@ -258,6 +258,15 @@ typedef struct thread thread_t;
 void x86_extended_register_context_switch(
         thread_t *old_thread, thread_t *new_thread);
 
+/* Load the current thread's state if a lazy context switch left it unloaded.
+ * Must be called with interrupts disabled, and before anything that uses the
+ * thread's FPU state without trapping, such as entering a guest. */
+void x86_extended_register_ensure_loaded(void);
+
+/* Handle a device-not-available fault from a lazy context switch.  Returns
+ * false if the fault was not caused by one. */
+bool x86_extended_register_device_na_handler(void);
+
 void x86_set_extended_register_pt_state(bool threads);
 
 uint64_t x86_xgetbv(uint32_t reg);
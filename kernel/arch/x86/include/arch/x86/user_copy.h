@@ -21,4 +21,9 @@ zx_status_t _x86_copy_to_or_from_user(
         size_t len,
         void **fault_return);
 
+/* Copy from user memory with interrupts disabled, e.g. from an interrupt
+ * handler. Instead of being handled, a page fault fails the copy with
+ * ZX_ERR_INVALID_ARGS, so only memory that is already mapped in can be read. */
+zx_status_t x86_copy_from_user_nofault(void *dst, const void *src, size_t len);
+
 __END_CDECLS
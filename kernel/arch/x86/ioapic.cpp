@@ -45,6 +45,7 @@
 #define IO_APIC_RTE_DELIVERY_MODE(dm) ((((uint64_t)(dm)) & 0x7) << 8)
 #define IO_APIC_RTE_VECTOR(x) (((uint64_t)(x)) & 0xff)
 #define IO_APIC_RTE_MASK IO_APIC_RTE_VECTOR(0xff)
+#define IO_APIC_RTE_DST_MASK (IO_APIC_RTE_DST(0xff) | IO_APIC_RTE_DST_MODE(1))
 // Macros for reading REG_RTE entries
 #define IO_APIC_RTE_REMOTE_IRR (1ULL << 14)
 #define IO_APIC_RTE_DELIVERY_STATUS (1ULL << 12)
@@ -363,6 +364,21 @@ void apic_io_configure_irq_vector(
     apic_io_write_redirection_entry(io_apic, global_irq, reg);
 }
 
+void apic_io_configure_irq_dst(
+    uint32_t global_irq,
+    enum apic_interrupt_dst_mode dst_mode,
+    uint8_t dst) {
+    struct io_apic* io_apic = apic_io_resolve_global_irq(global_irq);
+
+    AutoSpinLock guard(&lock);
+
+    uint64_t reg = apic_io_read_redirection_entry(io_apic, global_irq);
+    reg &= ~IO_APIC_RTE_DST_MASK;
+    reg |= IO_APIC_RTE_DST_MODE(dst_mode);
+    reg |= IO_APIC_RTE_DST(dst);
+    apic_io_write_redirection_entry(io_apic, global_irq, reg);
+}
+
 uint8_t apic_io_fetch_irq_vector(uint32_t global_irq) {
     struct io_apic* io_apic = apic_io_resolve_global_irq(global_irq);
 
@@ -17,6 +17,7 @@
 #include <arch/x86/mmu.h>
 #include <arch/x86/mmu_mem_types.h>
 #include <kernel/mp.h>
+#include <lib/counters.h>
 #include <vm/arch_vm_aspace.h>
 #include <vm/physmap.h>
 #include <vm/pmm.h>
@@ -26,6 +27,14 @@
 
 #define LOCAL_TRACE 0
 
+// TLB shootdown rounds performed, how many of them were full flushes, how many
+// remote cpus were sent an IPI, and how many single page invalidations the
+// non-full rounds carried.
+KCOUNTER(tlb_shootdown_rounds, "kernel.mmu.tlb.shootdown.rounds");
+KCOUNTER(tlb_shootdown_full, "kernel.mmu.tlb.shootdown.full");
+KCOUNTER(tlb_shootdown_ipis, "kernel.mmu.tlb.shootdown.ipis");
+KCOUNTER(tlb_shootdown_pages, "kernel.mmu.tlb.shootdown.pages");
+
 /* Default address width including virtual/physical address.
  * newer versions fetched below */
 uint8_t g_vaddr_width = 48;
@@ -182,10 +191,17 @@ static void TlbInvalidatePage_task(void* raw_context) {
  * @param pending The planned invalidation
  */
 static void x86_tlb_invalidate_page(const X86PageTableBase* pt, PendingTlbInvalidation* pending) {
-    if (pending->count == 0) {
+    if (pending->count == 0 && !pending->full_shootdown) {
         return;
     }
 
+    kcounter_add(tlb_shootdown_rounds, 1);
+    if (pending->full_shootdown) {
+        kcounter_add(tlb_shootdown_full, 1);
+    } else {
+        kcounter_add(tlb_shootdown_pages, pending->count);
+    }
+
     ulong cr3 = pt ? pt->phys() : x86_get_cr3();
     struct TlbInvalidatePage_context task_context = {
         .target_cr3 = cr3, .pending = pending,
@@ -205,6 +221,10 @@ static void x86_tlb_invalidate_page(const X86PageTableBase* pt, PendingTlbInvali
         target_mask = static_cast<X86ArchVmAspace*>(pt->ctx())->active_cpus();
     }
 
+    cpu_mask_t remote_mask = (target == MP_IPI_TARGET_ALL) ? mp_get_online_mask() : target_mask;
+    remote_mask &= ~cpu_num_to_mask(arch_curr_cpu_num());
+    kcounter_add(tlb_shootdown_ipis, __builtin_popcount(remote_mask));
+
     mp_sync_exec(target, target_mask, TlbInvalidatePage_task, &task_context);
     pending->clear();
 }
@@ -677,6 +697,18 @@ zx_status_t X86ArchVmAspace::Query(vaddr_t vaddr, paddr_t* paddr, uint* mmu_flag
     return pt_->QueryVaddr(vaddr, paddr, mmu_flags);
 }
 
+zx_status_t X86ArchVmAspace::HarvestAccessed(vaddr_t vaddr, size_t count,
+                                             arch_accessed_fn_t accessed_fn, void* context) {
+    if (!IsValidVaddr(vaddr))
+        return ZX_ERR_INVALID_ARGS;
+
+    // EPT entries only carry an accessed flag when the EPTP enables it.
+    if (flags_ & ARCH_ASPACE_FLAG_GUEST)
+        return ZX_ERR_NOT_SUPPORTED;
+
+    return pt_->HarvestAccessed(vaddr, count, accessed_fn, context);
+}
+
 void x86_mmu_percpu_init(void) {
     ulong cr0 = x86_get_cr0();
     /* Set write protect bit in CR0*/
@@ -20,6 +20,7 @@
 #include <arch/x86/cpu_topology.h>
 #include <arch/x86/descriptor.h>
 #include <arch/x86/feature.h>
+#include <arch/x86/idle_states.h>
 #include <arch/x86/interrupts.h>
 #include <arch/x86/mmu.h>
 #include <arch/x86/mp.h>
@@ -73,6 +74,8 @@ struct x86_percpu bp_percpu = {
 
     .default_tss = {},
     .interrupt_stacks = {},
+
+    .nofault_return_target = {},
 };
 
 zx_status_t x86_allocate_ap_structures(uint32_t* apic_ids, uint8_t cpu_count) {
@@ -104,6 +107,7 @@ zx_status_t x86_allocate_ap_structures(uint32_t* apic_ids, uint8_t cpu_count) {
             for (uint i = 1; i < cpu_count; ++i) {
                 ap_percpus[i - 1].monitor = monitors + (i * monitor_size);
             }
+            x86_idle_states_init();
         }
     }
 
@@ -258,6 +262,37 @@ int x86_apic_id_to_cpu_num(uint32_t apic_id) {
     return -1;
 }
 
+uint32_t x86_cpu_num_to_apic_id(cpu_num_t cpu_num) {
+    DEBUG_ASSERT(cpu_num < (cpu_num_t)x86_num_cpus);
+    if (cpu_num == 0) {
+        return bp_percpu.apic_id;
+    }
+    return ap_percpus[cpu_num - 1].apic_id;
+}
+
+cpu_mask_t arch_mp_cache_domain_mask(cpu_num_t cpu_num) {
+    DEBUG_ASSERT(cpu_num < (cpu_num_t)x86_num_cpus);
+
+    // cpus on the same node within a package share the last level cache
+    x86_cpu_topology_t topo;
+    const struct x86_percpu* percpu = cpu_num ? &ap_percpus[cpu_num - 1] : &bp_percpu;
+    x86_cpu_topology_decode(percpu->apic_id, &topo);
+
+    cpu_mask_t mask = 0;
+    for (cpu_num_t i = 0; i < (cpu_num_t)x86_num_cpus; ++i) {
+        const struct x86_percpu* other = i ? &ap_percpus[i - 1] : &bp_percpu;
+        if (other->apic_id == INVALID_APIC_ID) {
+            continue;
+        }
+        x86_cpu_topology_t other_topo;
+        x86_cpu_topology_decode(other->apic_id, &other_topo);
+        if (other_topo.package_id == topo.package_id && other_topo.node_id == topo.node_id) {
+            mask |= cpu_num_to_mask(i);
+        }
+    }
+    return mask | cpu_num_to_mask(cpu_num);
+}
+
 zx_status_t arch_mp_reschedule(cpu_mask_t mask) {
     DEBUG_ASSERT(thread_lock_held());
 
@@ -306,7 +341,7 @@ __NO_RETURN int arch_idle_thread_routine(void*) {
                 // the monitor being armed. Any writes after arming the monitor will trigger
                 // it and cause mwait to return, so there aren't races after this check.
                 if (*percpu->monitor) {
-                    x86_mwait();
+                    x86_idle_states_mwait();
                 }
             }
             thread_preempt();
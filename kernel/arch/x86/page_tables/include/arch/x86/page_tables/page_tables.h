@@ -10,6 +10,7 @@
 #include <fbl/canary.h>
 #include <fbl/mutex.h>
 #include <hwreg/bitfields.h>
+#include <kernel/thread.h>
 // Needed for ARCH_MMU_FLAG_*
 #include <vm/arch_vm_aspace.h>
 
@@ -53,6 +54,10 @@ struct PendingTlbInvalidation {
     // bit set.
     void enqueue(vaddr_t v, PageTableLevel level, bool is_global_page, bool is_terminal);
 
+    // Add all of the invalidations pending in |other| to this set, falling back to a full
+    // shootdown if they do not fit.
+    void merge(const PendingTlbInvalidation& other);
+
     // Clear the list of pending invalidations
     void clear();
 
@@ -91,6 +96,21 @@ public:
 
     zx_status_t QueryVaddr(vaddr_t vaddr, paddr_t* paddr, uint* mmu_flags);
 
+    // Clear the accessed flag of every page mapped in [vaddr, vaddr + count * PAGE_SIZE),
+    // calling |accessed_fn| with the physical address of each page that had it set.
+    // Only meaningful for page tables whose entries use the MMU's accessed flag.
+    zx_status_t HarvestAccessed(vaddr_t vaddr, size_t count, arch_accessed_fn_t accessed_fn,
+                                void* context);
+
+    // Start accumulating the TLB invalidations of subsequent operations issued
+    // by the calling thread, rather than performing them as each operation
+    // completes. Operations that free page tables, and operations issued by
+    // other threads, still invalidate immediately and take the accumulated
+    // invalidations with them. Batches do not nest.
+    void BeginTlbBatch();
+    // Perform all invalidations accumulated since BeginTlbBatch().
+    void EndTlbBatch();
+
 protected:
     // Initialize an empty page table, assigning this given context to it.
     zx_status_t Init(void* ctx);
@@ -164,6 +184,11 @@ private:
                                 const MappingCursor& start_cursor, MappingCursor* new_cursor,
                                 ConsistencyManager* cm) TA_REQ(lock_);
 
+    void HarvestMapping(volatile pt_entry_t* table, PageTableLevel level,
+                        const MappingCursor& start_cursor, MappingCursor* new_cursor,
+                        arch_accessed_fn_t accessed_fn, void* context,
+                        ConsistencyManager* cm) TA_REQ(lock_);
+
     zx_status_t GetMapping(volatile pt_entry_t* table, vaddr_t vaddr,
                            PageTableLevel level,
                            PageTableLevel* ret_level,
@@ -185,4 +210,9 @@ private:
 
     // low lock to protect the mmu code
     fbl::Mutex lock_;
+
+    // Thread that currently has a TLB batch open, if any, and the
+    // invalidations it has deferred.
+    thread_t* tlb_batch_owner_ TA_GUARDED(lock_) = nullptr;
+    PendingTlbInvalidation tlb_batch_ TA_GUARDED(lock_);
 };
@@ -105,6 +105,17 @@ void PendingTlbInvalidation::enqueue(vaddr_t v, PageTableLevel level, bool is_gl
     count++;
 }
 
+void PendingTlbInvalidation::merge(const PendingTlbInvalidation& other) {
+    contains_global |= other.contains_global;
+    if (full_shootdown || other.full_shootdown || count + other.count > fbl::count_of(item)) {
+        full_shootdown = true;
+        return;
+    }
+    for (uint i = 0; i < other.count; ++i) {
+        item[count++] = other.item[i];
+    }
+}
+
 void PendingTlbInvalidation::clear() {
     count = 0;
     full_shootdown = false;
@@ -186,7 +197,9 @@ public:
     PendingTlbInvalidation* pending_tlb() { return &tlb_; }
 
     // This function must be called while holding pt_->lock_.
-    void Finish();
+    // Disable thread safety analysis here because it has trouble identifying
+    // that |pt_->lock_| is held here.
+    void Finish() TA_NO_THREAD_SAFETY_ANALYSIS;
 private:
     X86PageTableBase* pt_;
 
@@ -217,7 +230,7 @@ X86PageTableBase::ConsistencyManager::~ConsistencyManager() {
     }
 }
 
-void X86PageTableBase::ConsistencyManager::Finish() {
+void X86PageTableBase::ConsistencyManager::Finish() TA_NO_THREAD_SAFETY_ANALYSIS {
     DEBUG_ASSERT(pt_->lock_.IsHeld());
 
     clf_.ForceFlush();
@@ -227,6 +240,18 @@ void X86PageTableBase::ConsistencyManager::Finish() {
         // invalidations.
         mb();
     }
+    if (pt_->tlb_batch_owner_ != nullptr) {
+        // Defer our invalidations to the open batch if it is ours and we are not about
+        // to free page tables that may still be cached by the MMU. Otherwise take
+        // everything the batch has accumulated along with us.
+        if (pt_->tlb_batch_owner_ == get_current_thread() && list_is_empty(&to_free_)) {
+            pt_->tlb_batch_.merge(tlb_);
+            tlb_.clear();
+        } else {
+            tlb_.merge(pt_->tlb_batch_);
+            pt_->tlb_batch_.clear();
+        }
+    }
     pt_->TlbInvalidate(&tlb_);
     pt_ = nullptr;
 }
@@ -802,6 +827,62 @@ zx_status_t X86PageTableBase::UpdateMappingL0(volatile pt_entry_t* table, uint m
     return ZX_OK;
 }
 
+// Clears the accessed flag of the terminal entries covered by |start_cursor|,
+// reporting every 4K page of the entries that had it set. The flag is cleared
+// with a locked operation since the MMU may be setting the dirty flag of the
+// same entry concurrently.
+void X86PageTableBase::HarvestMapping(volatile pt_entry_t* table, PageTableLevel level,
+                                      const MappingCursor& start_cursor,
+                                      MappingCursor* new_cursor,
+                                      arch_accessed_fn_t accessed_fn, void* context,
+                                      ConsistencyManager* cm) {
+    DEBUG_ASSERT(table);
+    LTRACEF("L: %d, %016" PRIxPTR " %016zx\n", level, start_cursor.vaddr,
+            start_cursor.size);
+
+    *new_cursor = start_cursor;
+
+    size_t ps = page_size(level);
+    uint index = vaddr_to_index(level, new_cursor->vaddr);
+    for (; index != NO_OF_PT_ENTRIES && new_cursor->size != 0; ++index) {
+        volatile pt_entry_t* e = table + index;
+        pt_entry_t pt_val = *e;
+        if (!IS_PAGE_PRESENT(pt_val)) {
+            new_cursor->SkipEntry(level);
+            continue;
+        }
+
+        // At the lowest level the large page bit is the PAT bit.
+        if (level != PT_L && !IS_LARGE_PAGE(pt_val)) {
+            MappingCursor cursor;
+            volatile pt_entry_t* next_table = get_next_table_from_entry(pt_val);
+            HarvestMapping(next_table, lower_level(level), *new_cursor, &cursor,
+                           accessed_fn, context, cm);
+            *new_cursor = cursor;
+            DEBUG_ASSERT(new_cursor->size <= start_cursor.size);
+            continue;
+        }
+
+        if (pt_val & X86_MMU_PG_A) {
+            __atomic_fetch_and(const_cast<pt_entry_t*>(e), ~static_cast<pt_entry_t>(X86_MMU_PG_A),
+                               __ATOMIC_RELAXED);
+            cm->cache_line_flusher()->FlushPtEntry(e);
+
+            // The MMU will not set the flag again while the translation is cached.
+            const vaddr_t page_vaddr = new_cursor->vaddr & ~(ps - 1);
+            cm->pending_tlb()->enqueue(page_vaddr, level, is_kernel_address(page_vaddr),
+                                       true /* was_terminal */);
+
+            const paddr_t page_paddr = paddr_from_pte(level, pt_val);
+            const vaddr_t end = fbl::min(page_vaddr + ps, new_cursor->vaddr + new_cursor->size);
+            for (vaddr_t v = new_cursor->vaddr; v < end; v += PAGE_SIZE) {
+                accessed_fn(context, page_paddr + (v - page_vaddr));
+            }
+        }
+        new_cursor->SkipEntry(level);
+    }
+}
+
 zx_status_t X86PageTableBase::UnmapPages(vaddr_t vaddr, const size_t count,
                                          size_t* unmapped) {
     LTRACEF("aspace %p, vaddr %#" PRIxPTR ", count %#zx\n", this, vaddr, count);
@@ -860,6 +941,8 @@ zx_status_t X86PageTableBase::MapPages(vaddr_t vaddr, paddr_t* phys, size_t coun
 
         // TODO(teisenbe): Improve performance of this function by integrating deeper into
         // the algorithm (e.g. make the cursors aware of the page array).
+        // Runs of physically contiguous pages are handed to AddMapping as a single cursor so
+        // that it can use large pages whenever a run covers a suitably aligned range.
         size_t idx = 0;
         auto undo = fbl::MakeAutoCall([&]() TA_NO_THREAD_SAFETY_ANALYSIS {
             if (idx > 0) {
@@ -875,9 +958,14 @@ zx_status_t X86PageTableBase::MapPages(vaddr_t vaddr, paddr_t* phys, size_t coun
         });
 
         vaddr_t v = vaddr;
-        for (; idx < count; ++idx) {
+        while (idx < count) {
+            size_t run = 1;
+            while (idx + run < count && phys[idx + run] == phys[idx] + run * PAGE_SIZE) {
+                ++run;
+            }
+
             MappingCursor start = {
-                .paddr = phys[idx], .vaddr = v, .size = PAGE_SIZE,
+                .paddr = phys[idx], .vaddr = v, .size = run * PAGE_SIZE,
             };
             MappingCursor result;
             zx_status_t status = AddMapping(virt_, mmu_flags, top, start, &result, &cm);
@@ -887,7 +975,8 @@ zx_status_t X86PageTableBase::MapPages(vaddr_t vaddr, paddr_t* phys, size_t coun
             }
             DEBUG_ASSERT(result.size == 0);
 
-            v += PAGE_SIZE;
+            idx += run;
+            v += run * PAGE_SIZE;
         }
 
         undo.cancel();
@@ -941,6 +1030,24 @@ zx_status_t X86PageTableBase::MapPagesContiguous(vaddr_t vaddr, paddr_t paddr,
     return ZX_OK;
 }
 
+void X86PageTableBase::BeginTlbBatch() {
+    canary_.Assert();
+
+    fbl::AutoLock a(&lock_);
+    DEBUG_ASSERT(tlb_batch_owner_ == nullptr);
+    DEBUG_ASSERT(tlb_batch_.count == 0 && !tlb_batch_.full_shootdown);
+    tlb_batch_owner_ = get_current_thread();
+}
+
+void X86PageTableBase::EndTlbBatch() {
+    canary_.Assert();
+
+    fbl::AutoLock a(&lock_);
+    DEBUG_ASSERT(tlb_batch_owner_ == get_current_thread());
+    tlb_batch_owner_ = nullptr;
+    TlbInvalidate(&tlb_batch_);
+}
+
 zx_status_t X86PageTableBase::ProtectPages(vaddr_t vaddr, size_t count, uint mmu_flags) {
     canary_.Assert();
 
@@ -972,6 +1079,32 @@ zx_status_t X86PageTableBase::ProtectPages(vaddr_t vaddr, size_t count, uint mmu
     return ZX_OK;
 }
 
+zx_status_t X86PageTableBase::HarvestAccessed(vaddr_t vaddr, size_t count,
+                                              arch_accessed_fn_t accessed_fn, void* context) {
+    canary_.Assert();
+
+    LTRACEF("aspace %p, vaddr %#" PRIxPTR " count %#zx\n", this, vaddr, count);
+
+    if (!check_vaddr(vaddr))
+        return ZX_ERR_INVALID_ARGS;
+    if (count == 0)
+        return ZX_OK;
+
+    MappingCursor start = {
+        .paddr = 0, .vaddr = vaddr, .size = count * PAGE_SIZE,
+    };
+    MappingCursor result;
+    ConsistencyManager cm(this);
+    {
+        fbl::AutoLock a(&lock_);
+        DEBUG_ASSERT(virt_);
+        HarvestMapping(virt_, top_level(), start, &result, accessed_fn, context, &cm);
+        cm.Finish();
+    }
+    DEBUG_ASSERT(result.size == 0);
+    return ZX_OK;
+}
+
 zx_status_t X86PageTableBase::QueryVaddr(vaddr_t vaddr, paddr_t* paddr, uint* mmu_flags) {
     canary_.Assert();
 
@@ -41,9 +41,11 @@
 #include <arch/mmu.h>
 #include <arch/x86.h>
 #include <arch/x86/apic.h>
+#include <arch/x86/descriptor.h>
 #include <arch/x86/feature.h>
 #include <arch/x86/mmu.h>
 #include <arch/x86/perf_mon.h>
+#include <arch/x86/user_copy.h>
 #include <assert.h>
 #include <err.h>
 #include <fbl/algorithm.h>
@@ -316,6 +318,9 @@ struct PerfmonState {
     // True if last branch records have been requested.
     bool request_lbr_record = false;
 
+    // True if call stack records have been requested.
+    bool request_callstack_record = false;
+
     // Number of entries in |cpu_data|.
     const unsigned num_cpus;
 
@@ -608,6 +613,8 @@ size_t get_max_space_needed_for_all_records(PerfmonState* state) {
                            num_events * kMaxEventRecordSize);
     if (state->request_lbr_record)
         space_needed += sizeof(cpuperf_last_branch_record_t);
+    if (state->request_callstack_record)
+        space_needed += sizeof(cpuperf_callstack_record_t);
     return space_needed;
 }
 
@@ -907,7 +914,8 @@ static zx_status_t x86_ipm_verify_misc_config(
             }
             // Currently we only support the MCHBAR events.
             // They cannot provide pc. We ignore the OS/USER bits.
-            if (config->misc_flags[i] & (IPM_CONFIG_FLAG_PC | IPM_CONFIG_FLAG_LBR)) {
+            if (config->misc_flags[i] & (IPM_CONFIG_FLAG_PC | IPM_CONFIG_FLAG_LBR |
+                                         IPM_CONFIG_FLAG_CALLSTACK)) {
                 TRACEF("Invalid bits (0x%x) in |misc_flags[%zu]|\n",
                        config->misc_flags[i], i);
                 return ZX_ERR_INVALID_ARGS;
@@ -1103,6 +1111,16 @@ zx_status_t x86_ipm_stage_config(zx_x86_ipm_config_t* config) {
         state->request_lbr_record = true;
     }
 
+    state->request_callstack_record = false;
+    for (unsigned i = 0; i < IPM_MAX_FIXED_COUNTERS; ++i) {
+        if (config->fixed_flags[i] & IPM_CONFIG_FLAG_CALLSTACK)
+            state->request_callstack_record = true;
+    }
+    for (unsigned i = 0; i < IPM_MAX_PROGRAMMABLE_COUNTERS; ++i) {
+        if (config->programmable_flags[i] & IPM_CONFIG_FLAG_CALLSTACK)
+            state->request_callstack_record = true;
+    }
+
     x86_ipm_stage_fixed_config(config, state);
     x86_ipm_stage_programmable_config(config, state);
     x86_ipm_stage_misc_config(config, state);
@@ -1857,6 +1875,72 @@ static cpuperf_record_header_t* x86_perfmon_write_last_branches(
     return next;
 }
 
+// Write out a |cpuperf_callstack_record_t| record for the code interrupted
+// by |frame|.
+// Both stacks are walked by following frame pointers. The kernel stack is
+// bounded by the current thread's stack. The user stack can be anywhere, and
+// since page faults can't be serviced here it is read with
+// x86_copy_from_user_nofault(): the walk stops at the first frame that isn't
+// mapped in, which rarely matters as the stack near the interrupted code was
+// just used.
+// Only one of the stacks is walked: a sample taken in the kernel doesn't
+// include the user frames of the syscall it is in.
+static cpuperf_record_header_t* x86_perfmon_write_callstack(
+        const x86_iframe_t* frame, uint64_t cr3, cpuperf_record_header_t* hdr,
+        cpuperf_event_id_t id) {
+    auto rec = reinterpret_cast<cpuperf_callstack_record_t*>(hdr);
+    static_assert(CPUPERF_MAX_NUM_CALLSTACK_FRAMES ==
+                  countof(cpuperf_callstack_record_t::frames), "");
+    x86_perfmon_write_header(&rec->header, CPUPERF_RECORD_CALLSTACK, id);
+    thread_t* thread = get_current_thread();
+    rec->aspace = cr3;
+    rec->pid = thread->user_pid;
+    rec->tid = thread->user_tid;
+
+    unsigned n = 0;
+    rec->frames[n++] = frame->ip;
+    uint64_t fp = frame->rbp;
+    bool from_user = SELECTOR_PL(frame->cs) != 0;
+    if (from_user) {
+        while (n < CPUPERF_MAX_NUM_CALLSTACK_FRAMES && (fp & 7) == 0) {
+            // The saved frame pointer, followed by the return address.
+            uint64_t words[2];
+            if (x86_copy_from_user_nofault(words, reinterpret_cast<void*>(fp),
+                                           sizeof(words)) != ZX_OK)
+                break;
+            if (words[1] == 0)
+                break;
+            rec->frames[n++] = words[1];
+            // Stacks grow down, anything else is the end of the chain or junk.
+            if (words[0] <= fp)
+                break;
+            fp = words[0];
+        }
+        rec->num_kernel_frames = 0;
+    } else {
+        const vaddr_t stack_base = thread->stack.base;
+        const vaddr_t stack_end = stack_base + thread->stack.size;
+        while (WITH_FRAME_POINTERS && n < CPUPERF_MAX_NUM_CALLSTACK_FRAMES &&
+               (fp & 7) == 0 && fp >= stack_base && fp + 2 * sizeof(uint64_t) <= stack_end) {
+            auto words = reinterpret_cast<const uint64_t*>(fp);
+            if (words[1] == 0)
+                break;
+            rec->frames[n++] = words[1];
+            if (words[0] <= fp)
+                break;
+            fp = words[0];
+        }
+        rec->num_kernel_frames = static_cast<uint16_t>(n);
+    }
+    rec->num_frames = static_cast<uint16_t>(n);
+
+    auto next = reinterpret_cast<cpuperf_record_header_t*>(
+        reinterpret_cast<char*>(rec) + CPUPERF_CALLSTACK_RECORD_SIZE(rec));
+    LTRACEF("callstack record: num frames %u (kernel %u), @%p, next @%p\n",
+            rec->num_frames, rec->num_kernel_frames, hdr, next);
+    return next;
+}
+
 // Helper function so that there is only one place where we enable/disable
 // interrupts (our caller).
 // Returns true if success, false if buffer is full.
@@ -1903,6 +1987,9 @@ static bool pmi_interrupt_handler(x86_iframe_t *frame, PerfmonState* state) {
         // We can't record every event that requested LBR data.
         // It is unspecified which one we pick.
         cpuperf_event_id_t lbr_id = CPUPERF_EVENT_ID_NONE;
+        // Likewise for call stacks.
+        bool request_callstack = false;
+        cpuperf_event_id_t callstack_id = CPUPERF_EVENT_ID_NONE;
 
         next = x86_perfmon_write_time_record(next, CPUPERF_EVENT_ID_NONE, now);
 
@@ -1933,6 +2020,10 @@ static bool pmi_interrupt_handler(x86_iframe_t *frame, PerfmonState* state) {
                 request_lbr = true;
                 lbr_id = id;
             }
+            if (state->programmable_flags[i] & IPM_CONFIG_FLAG_CALLSTACK) {
+                request_callstack = true;
+                callstack_id = id;
+            }
             LTRACEF("cpu %u: resetting PMC %u to 0x%" PRIx64 "\n",
                     cpu, i, state->programmable_initial_value[i]);
             write_msr(IA32_PMC_FIRST + i, state->programmable_initial_value[i]);
@@ -1961,6 +2052,10 @@ static bool pmi_interrupt_handler(x86_iframe_t *frame, PerfmonState* state) {
                 request_lbr = true;
                 lbr_id = id;
             }
+            if (state->fixed_flags[i] & IPM_CONFIG_FLAG_CALLSTACK) {
+                request_callstack = true;
+                callstack_id = id;
+            }
             LTRACEF("cpu %u: resetting FIXED %u to 0x%" PRIx64 "\n",
                     cpu, hw_num, state->fixed_initial_value[i]);
             write_msr(IA32_FIXED_CTR0 + hw_num, state->fixed_initial_value[i]);
@@ -2030,6 +2125,9 @@ static bool pmi_interrupt_handler(x86_iframe_t *frame, PerfmonState* state) {
         if (request_lbr) {
             next = x86_perfmon_write_last_branches(state, cr3, next, lbr_id);
         }
+        if (request_callstack) {
+            next = x86_perfmon_write_callstack(frame, cr3, next, callstack_id);
+        }
 
         data->buffer_next = next;
     }
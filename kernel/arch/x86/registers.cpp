@@ -28,8 +28,11 @@
 #include <fbl/auto_call.h>
 #include <inttypes.h>
 #include <kernel/auto_lock.h>
+#include <kernel/cmdline.h>
 #include <kernel/spinlock.h>
 #include <kernel/thread.h>
+#include <lib/counters.h>
+#include <lk/init.h>
 #include <string.h>
 #include <trace.h>
 #include <vm/vm.h>
@@ -51,6 +54,11 @@
 // Bit in XCOMP_BV field of xsave indicating compacted format.
 #define XSAVE_XCOMP_BV_COMPACT (1ULL << 63)
 
+KCOUNTER(fpu_save, "kernel.x86.fpu.save");
+KCOUNTER(fpu_restore, "kernel.x86.fpu.restore");
+KCOUNTER(fpu_lazy_restore, "kernel.x86.fpu.lazy_restore");
+KCOUNTER(fpu_deferred, "kernel.x86.fpu.deferred");
+
 static void fxsave(void* register_state);
 static void fxrstor(void* register_state);
 static void xrstor(void* register_state, uint64_t feature_mask);
@@ -94,6 +102,12 @@ static bool fxsave_supported = false;
 static size_t register_state_size = 0;
 /* Spinlock to guard register state size changes */
 static SpinLock state_lock;
+/* Whether to leave the incoming thread's state unloaded on context switch, with
+ * CR0.TS set, until it first uses the FPU */
+static bool lazy_restore_enabled = false;
+/* Whether PT traces threads.  Its state is part of the xsave area, and must be
+ * restored on every switch rather than on first FPU use */
+static bool pt_traces_threads = false;
 
 /* For FXRSTOR, we need 512 bytes to save the state.  For XSAVE-based
  * mechanisms, we only need 512 + 64 bytes for the initial state, since
@@ -239,9 +253,10 @@ bool x86_extended_register_enable_feature(
             return false;
         }
 
-        /* No x87 emul, monitor co-processor */
+        /* No x87 emul, monitor co-processor, not lazily switched out */
         ulong cr0 = x86_get_cr0();
         cr0 &= ~X86_CR0_EM;
+        cr0 &= ~X86_CR0_TS;
         cr0 |= X86_CR0_NE;
         cr0 |= X86_CR0_MP;
         x86_set_cr0(cr0);
@@ -378,14 +393,66 @@ void x86_extended_register_restore_state(void* register_state) {
     }
 }
 
+/* CR0.TS is clear exactly when the current thread's state is loaded, that is
+ * when |extended_register_live| is set.  A thread whose state was never loaded
+ * since it was switched in has nothing to save when it is switched out. */
 void x86_extended_register_context_switch(
     thread_t* old_thread, thread_t* new_thread) {
+    bool ts_set = false;
     if (likely(old_thread)) {
-        x86_extended_register_save_state(old_thread->arch.extended_register_state);
+        if (old_thread->arch.extended_register_live) {
+            x86_extended_register_save_state(old_thread->arch.extended_register_state);
+            old_thread->arch.extended_register_live = false;
+            kcounter_add(fpu_save, 1);
+        } else {
+            ts_set = true;
+        }
+    }
+
+    if (lazy_restore_enabled && !pt_traces_threads) {
+        if (!ts_set) {
+            x86_set_cr0(x86_get_cr0() | X86_CR0_TS);
+        }
+        kcounter_add(fpu_deferred, 1);
+        return;
+    }
+
+    if (ts_set) {
+        x86_clts();
     }
     x86_extended_register_restore_state(new_thread->arch.extended_register_state);
+    new_thread->arch.extended_register_live = true;
+    kcounter_add(fpu_restore, 1);
 }
 
+void x86_extended_register_ensure_loaded(void) {
+    DEBUG_ASSERT(arch_ints_disabled());
+
+    thread_t* t = get_current_thread();
+    if (t->arch.extended_register_live) {
+        return;
+    }
+    x86_clts();
+    x86_extended_register_restore_state(t->arch.extended_register_state);
+    t->arch.extended_register_live = true;
+    kcounter_add(fpu_lazy_restore, 1);
+}
+
+bool x86_extended_register_device_na_handler(void) {
+    /* Only a lazy context switch sets CR0.TS, and only until the state is loaded */
+    if (get_current_thread()->arch.extended_register_live) {
+        return false;
+    }
+    x86_extended_register_ensure_loaded();
+    return true;
+}
+
+static void x86_extended_register_lazy_init(uint level) {
+    lazy_restore_enabled = cmdline_get_bool("kernel.x86.lazy-fpu", false);
+}
+
+LK_INIT_HOOK(x86_extended_register_lazy, &x86_extended_register_lazy_init, LK_INIT_LEVEL_ARCH);
+
 static void read_xsave_state_info(void) {
     xsave_supported = x86_feature_test(X86_FEATURE_XSAVE);
     if (!xsave_supported) {
@@ -669,6 +736,8 @@ void x86_set_extended_register_pt_state(bool threads) {
     if (!xsaves_supported || !(xss_component_bitmap & X86_XSAVE_STATE_BIT_PT))
         return;
 
+    pt_traces_threads = threads;
+
     uint64_t xss = read_msr(IA32_XSS_MSR);
     if (threads)
         xss |= X86_XSAVE_STATE_BIT_PT;
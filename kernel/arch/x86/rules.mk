@@ -49,6 +49,7 @@ MODULE_SRCS += \
 	$(LOCAL_DIR)/feature.cpp \
 	$(LOCAL_DIR)/gdt.S \
 	$(LOCAL_DIR)/hwp.cpp \
+	$(LOCAL_DIR)/idle_states.cpp \
 	$(LOCAL_DIR)/idt.cpp \
 	$(LOCAL_DIR)/ioapic.cpp \
 	$(LOCAL_DIR)/ioport.cpp \
@@ -70,6 +71,7 @@ MODULE_SRCS += \
 	$(LOCAL_DIR)/tsc.cpp \
 	$(LOCAL_DIR)/user_copy.S \
 	$(LOCAL_DIR)/user_copy.cpp \
+	$(LOCAL_DIR)/user_copy_tests.cpp \
 	$(LOCAL_DIR)/uspace_entry.S \
 
 MODULE_DEPS += \
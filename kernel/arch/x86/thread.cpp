@@ -53,6 +53,7 @@ void arch_thread_initialize(thread_t* t, vaddr_t entry_point) {
                  x86_extended_register_size());
     t->arch.extended_register_state = (vaddr_t*)buf;
     x86_extended_register_init_state(t->arch.extended_register_state);
+    t->arch.extended_register_live = false;
 
     // set the stack pointer
     t->arch.sp = (vaddr_t)frame;
@@ -75,6 +76,8 @@ void arch_thread_initialize(thread_t* t, vaddr_t entry_point) {
 }
 
 void arch_thread_construct_first(thread_t* t) {
+    // whatever is in the registers now belongs to this thread
+    t->arch.extended_register_live = true;
 }
 
 void arch_dump_thread(thread_t* t) {
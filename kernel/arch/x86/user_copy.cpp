@@ -11,6 +11,7 @@
 #include <arch/user_copy.h>
 #include <arch/x86.h>
 #include <arch/x86/feature.h>
+#include <arch/x86/mp.h>
 #include <arch/x86/user_copy.h>
 #include <kernel/thread.h>
 #include <lib/code_patching.h>
@@ -46,6 +47,37 @@ void fill_out_clac_instruction(const CodePatchInfo* patch) {
         memset(patch->dest_addr, kNopInstruction, kSize);
     }
 }
+
+// Copy strategies in user_copy.S; these are labels inside
+// _x86_copy_to_or_from_user, not functions that can be called.
+extern const uint8_t _x86_user_copy_select[];
+extern const uint8_t _x86_user_copy_fsrm[];
+extern const uint8_t _x86_user_copy_erms[];
+extern const uint8_t _x86_user_copy_quad[];
+
+void x86_user_copy_select(const CodePatchInfo* patch) {
+    // We are patching a jmp rel8 instruction, which is two bytes.  The rel8
+    // value is a signed 8-bit value specifying an offset relative to the
+    // address of the next instruction in memory after the jmp instruction.
+    const size_t kSize = 2;
+    const intptr_t jmp_from_address = reinterpret_cast<intptr_t>(_x86_user_copy_select) + kSize;
+
+    DEBUG_ASSERT(patch->dest_size == kSize);
+    DEBUG_ASSERT(patch->dest_addr == _x86_user_copy_select);
+
+    const uint8_t* target;
+    if (x86_feature_test(X86_FEATURE_FSRM)) {
+        target = _x86_user_copy_fsrm;
+    } else if (x86_feature_test(X86_FEATURE_ERMS)) {
+        target = _x86_user_copy_erms;
+    } else {
+        target = _x86_user_copy_quad;
+    }
+    intptr_t offset = reinterpret_cast<intptr_t>(target) - jmp_from_address;
+    DEBUG_ASSERT(offset >= -128 && offset <= 127);
+    patch->dest_addr[0] = 0xeb; /* jmp rel8 */
+    patch->dest_addr[1] = static_cast<uint8_t>(offset);
+}
 }
 
 static inline bool ac_flag(void) {
@@ -76,6 +108,22 @@ zx_status_t arch_copy_from_user(void* dst, const void* src, size_t len) {
     return status;
 }
 
+zx_status_t x86_copy_from_user_nofault(void* dst, const void* src, size_t len) {
+    DEBUG_ASSERT(arch_ints_disabled());
+    DEBUG_ASSERT(!ac_flag());
+
+    if (!can_access(src, len))
+        return ZX_ERR_INVALID_ARGS;
+
+    // The page fault handler sends faults to this target before looking at
+    // anything else, so none are resolved and the copy can't block.
+    zx_status_t status = _x86_copy_to_or_from_user(dst, src, len,
+                                                   &x86_get_percpu()->nofault_return_target);
+
+    DEBUG_ASSERT(!ac_flag());
+    return status;
+}
+
 zx_status_t arch_copy_to_user(void* dst, const void* src, size_t len) {
     DEBUG_ASSERT(!ac_flag());
 
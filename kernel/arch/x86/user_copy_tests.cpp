@@ -0,0 +1,82 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <arch/user_copy.h>
+
+#include <fbl/alloc_checker.h>
+#include <fbl/unique_ptr.h>
+#include <lib/unittest/unittest.h>
+#include <lib/unittest/user_memory.h>
+#include <string.h>
+
+namespace {
+
+using testing::UserMemory;
+
+// Lengths on either side of the cutoffs between copy strategies in
+// user_copy.S, plus some odd ones.
+constexpr size_t kLengths[] = {
+    0, 1, 7, 8, 9, 63, 127, 128, 129, 4095, 4096,
+    64 * 1024 - 1, 64 * 1024, 64 * 1024 + 63, 64 * 1024 + 65,
+};
+constexpr size_t kMaxLen = 64 * 1024 + 65;
+
+// Copy to user memory and back at every alignment of either end, checking
+// that the bytes arrive and that the bytes around them are untouched.
+static bool copy_lengths_and_alignments() {
+    BEGIN_TEST;
+
+    constexpr size_t kBufLen = kMaxLen + 16;
+    fbl::unique_ptr<UserMemory> mem = UserMemory::Create(kBufLen);
+    ASSERT_NONNULL(mem, "");
+    uint8_t* user = static_cast<uint8_t*>(mem->out());
+
+    fbl::AllocChecker ac;
+    auto src = fbl::unique_ptr<uint8_t[]>(new (&ac) uint8_t[kBufLen]);
+    ASSERT_TRUE(ac.check(), "");
+    auto dst = fbl::unique_ptr<uint8_t[]>(new (&ac) uint8_t[kBufLen]);
+    ASSERT_TRUE(ac.check(), "");
+    for (size_t i = 0; i < kBufLen; ++i) {
+        src[i] = static_cast<uint8_t>(i * 7 + 1);
+    }
+
+    for (size_t len : kLengths) {
+        for (size_t user_offset = 0; user_offset < 8; ++user_offset) {
+            for (size_t kernel_offset = 0; kernel_offset < 8; kernel_offset += 3) {
+                memset(dst.get(), 0, kBufLen);
+                ASSERT_EQ(ZX_OK, arch_copy_to_user(user, dst.get(), kBufLen), "");
+
+                ASSERT_EQ(ZX_OK, arch_copy_to_user(user + user_offset,
+                                                   src.get() + kernel_offset, len),
+                          "");
+                ASSERT_EQ(ZX_OK, arch_copy_from_user(dst.get() + kernel_offset,
+                                                     user + user_offset, len),
+                          "");
+                EXPECT_EQ(0, memcmp(dst.get() + kernel_offset,
+                                    src.get() + kernel_offset, len),
+                          "copied bytes differ");
+
+                // Read the whole user buffer back to check what surrounds
+                // the copy.
+                ASSERT_EQ(ZX_OK, arch_copy_from_user(dst.get(), user, kBufLen), "");
+                for (size_t i = 0; i < user_offset; ++i) {
+                    EXPECT_EQ(0u, dst[i], "wrote before the destination");
+                }
+                for (size_t i = user_offset + len; i < kBufLen; ++i) {
+                    EXPECT_EQ(0u, dst[i], "wrote past the destination");
+                }
+            }
+        }
+    }
+
+    END_TEST;
+}
+
+} // namespace
+
+UNITTEST_START_TESTCASE(x86_user_copy_tests)
+UNITTEST("copy lengths and alignments", copy_lengths_and_alignments)
+UNITTEST_END_TESTCASE(x86_user_copy_tests, "x86_user_copy", "x86 user copy tests");
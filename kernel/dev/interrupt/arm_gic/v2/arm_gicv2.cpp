@@ -237,6 +237,31 @@ static zx_status_t gic_configure_interrupt(unsigned int vector,
     return ZX_OK;
 }
 
+static zx_status_t gic_set_affinity(unsigned int vector, cpu_num_t cpu) {
+    // Only SPIs can be steered
+    if ((vector >= max_irqs) || (vector < GIC_BASE_SPI)) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+    // ITARGETSR holds a target bit for each of up to 8 CPU interfaces
+    if (cpu >= 8 || cpu >= arch_max_num_cpus() || !mp_is_cpu_online(cpu)) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+
+    // targets are encoded with a byte per irq, 4 irqs per ITARGETSR register
+    uint32_t reg_ndx = vector / 4;
+    uint32_t shift = (vector % 4) * 8;
+
+    spin_lock_saved_state_t state;
+    spin_lock_save(&gicd_lock, &state, GICD_LOCK_FLAGS);
+    uint32_t reg_val = GICREG(0, GICD_ITARGETSR(reg_ndx));
+    reg_val &= ~(0xffu << shift);
+    reg_val |= (1u << cpu) << shift;
+    GICREG(0, GICD_ITARGETSR(reg_ndx)) = reg_val;
+    spin_unlock_restore(&gicd_lock, state, GICD_LOCK_FLAGS);
+
+    return ZX_OK;
+}
+
 static zx_status_t gic_get_interrupt_config(unsigned int vector,
                                             enum interrupt_trigger_mode* tm,
                                             enum interrupt_polarity* pol) {
@@ -378,6 +403,7 @@ static const struct pdev_interrupt_ops gic_ops = {
     .unmask = gic_unmask_interrupt,
     .configure = gic_configure_interrupt,
     .get_config = gic_get_interrupt_config,
+    .set_affinity = gic_set_affinity,
     .is_valid = gic_is_valid_interrupt,
     .get_base_vector = gic_get_base_vector,
     .get_max_vector = gic_get_max_vector,
@@ -395,6 +421,7 @@ static const struct pdev_interrupt_ops gic_ops = {
     .msi_alloc_block = arm_gicv2m_msi_alloc_block,
     .msi_free_block = arm_gicv2m_msi_free_block,
     .msi_register_handler = arm_gicv2m_msi_register_handler,
+    .msi_set_affinity = arm_gicv2m_msi_set_affinity,
 };
 
 static void arm_gic_v2_init(const void* driver_data, uint32_t length) {
@@ -174,3 +174,28 @@ void arm_gicv2m_msi_mask_unmask(const msi_block_t* block, uint msi_id, bool mask
     else
         unmask_interrupt(block->base_irq_id + msi_id);
 }
+
+zx_status_t arm_gicv2m_msi_set_affinity(msi_block_t* block, cpu_num_t cpu) {
+    DEBUG_ASSERT(block && block->allocated);
+
+    /* Each MSI is an SPI of its own, so the doorbell and data stay the same
+     * and only the SPIs need to be steered. */
+    for (uint i = 0; i < block->num_irq; ++i) {
+        zx_status_t status = set_interrupt_affinity(block->base_irq_id + i, cpu);
+        if (status != ZX_OK)
+            return status;
+    }
+    return ZX_OK;
+}
+
+zx_status_t arm_gicv2m_msi_set_vector_affinity(const msi_block_t* block, uint msi_id,
+                                               cpu_num_t cpu, uint64_t* out_tgt_addr) {
+    DEBUG_ASSERT(block && block->allocated);
+    DEBUG_ASSERT(msi_id < block->num_irq);
+
+    zx_status_t status = set_interrupt_affinity(block->base_irq_id + msi_id, cpu);
+    if (status != ZX_OK)
+        return status;
+    *out_tgt_addr = block->tgt_addr;
+    return ZX_OK;
+}
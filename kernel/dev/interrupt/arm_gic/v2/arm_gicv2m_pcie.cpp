@@ -44,6 +44,17 @@ public:
         arm_gicv2m_msi_register_handler(block, msi_id, handler, ctx);
     }
 
+    zx_status_t SetMsiAffinity(msi_block_t* block, cpu_num_t cpu) override {
+        return arm_gicv2m_msi_set_affinity(block, cpu);
+    }
+
+    zx_status_t SetMsiVectorAffinity(const msi_block_t* block,
+                                     uint msi_id,
+                                     cpu_num_t cpu,
+                                     uint64_t* out_tgt_addr) override {
+        return arm_gicv2m_msi_set_vector_affinity(block, msi_id, cpu, out_tgt_addr);
+    }
+
     void MaskUnmaskMsi(const msi_block_t* block,
                        uint msi_id,
                        bool mask) override {
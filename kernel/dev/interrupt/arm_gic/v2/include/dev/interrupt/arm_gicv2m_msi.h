@@ -29,3 +29,6 @@ void arm_gicv2m_msi_register_handler(const msi_block_t* block,
                                      uint msi_id,
                                      int_handler handler,
                                      void* ctx);
+zx_status_t arm_gicv2m_msi_set_affinity(msi_block_t* block, cpu_num_t cpu);
+zx_status_t arm_gicv2m_msi_set_vector_affinity(const msi_block_t* block, uint msi_id,
+                                               cpu_num_t cpu, uint64_t* out_tgt_addr);
@@ -299,6 +299,23 @@ static zx_status_t gic_configure_interrupt(unsigned int vector,
     return ZX_OK;
 }
 
+static zx_status_t gic_set_affinity(unsigned int vector, cpu_num_t cpu) {
+    // Only SPIs can be steered
+    if (vector < 32 || vector >= gic_max_int) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+    if (cpu >= arch_max_num_cpus() || !mp_is_cpu_online(cpu)) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+
+    // TODO(maniscalco): If/when we support AFF2/AFF3, route to those as well.
+    uint64_t aff0 = arch_cpu_num_to_cpu_id(cpu);
+    uint64_t aff1 = arch_cpu_num_to_cluster_id(cpu);
+    GICREG64(0, GICD_IROUTER(vector)) = (aff1 << 8) | aff0;
+
+    return ZX_OK;
+}
+
 static zx_status_t gic_get_interrupt_config(unsigned int vector,
                                             enum interrupt_trigger_mode* tm,
                                             enum interrupt_polarity* pol) {
@@ -458,6 +475,10 @@ static bool gic_msi_supports_masking() {
     return false;
 }
 
+static zx_status_t gic_msi_set_affinity(msi_block_t* block, cpu_num_t cpu) {
+    return ZX_ERR_NOT_SUPPORTED;
+}
+
 static void gic_msi_mask_unmask(const msi_block_t* block, uint msi_id, bool mask) {
     PANIC_UNIMPLEMENTED;
 }
@@ -485,6 +506,7 @@ static const struct pdev_interrupt_ops gic_ops = {
     .unmask = gic_unmask_interrupt,
     .configure = gic_configure_interrupt,
     .get_config = gic_get_interrupt_config,
+    .set_affinity = gic_set_affinity,
     .is_valid = gic_is_valid_interrupt,
     .get_base_vector = gic_get_base_vector,
     .get_max_vector = gic_get_max_vector,
@@ -502,6 +524,7 @@ static const struct pdev_interrupt_ops gic_ops = {
     .msi_alloc_block = gic_msi_alloc_block,
     .msi_free_block = gic_msi_free_block,
     .msi_register_handler = gic_msi_register_handler,
+    .msi_set_affinity = gic_msi_set_affinity,
 };
 
 static void arm_gic_v3_init(const void* driver_data, uint32_t length) {
@@ -46,6 +46,11 @@ zx_status_t get_interrupt_config(unsigned int vector,
                                  enum interrupt_trigger_mode* tm,
                                  enum interrupt_polarity* pol);
 
+// Steer the specified interrupt vector to |cpu|, which must be online.  Until
+// this is called, interrupts are taken by the boot CPU.  Returns
+// ZX_ERR_NOT_SUPPORTED if the interrupt controller cannot target |cpu|.
+zx_status_t set_interrupt_affinity(unsigned int vector, cpu_num_t cpu);
+
 typedef void (*int_handler)(void* arg);
 
 zx_status_t register_int_handler(unsigned int vector, int_handler handler, void* arg);
@@ -121,4 +126,22 @@ void msi_free_block(msi_block_t* block);
 // NULL handler will effectively unregister a handler for a given msi_id within the
 // block.
 void msi_register_handler(const msi_block_t* block, uint msi_id, int_handler handler, void *ctx);
+
+// Method used to steer every IRQ within an msi_block_t to |cpu|, which must be
+// online.  The IRQs of a block share a single target, so they cannot be steered
+// individually.  On success, the block's tgt_addr and tgt_data hold what the
+// device has to be reprogrammed with for the change to take effect.
+//
+// @return ZX_ERR_NOT_SUPPORTED if the platform cannot target |cpu|.
+zx_status_t msi_set_affinity(msi_block_t* block, cpu_num_t cpu);
+
+// Method used to steer the single IRQ |msi_id| within an msi_block_t to |cpu|,
+// which must be online.  This is only of use to MSI-X, where every IRQ has a
+// target write transaction of its own.  On success, |out_tgt_addr| holds the
+// address the IRQ's target write has to be reprogrammed with; its data is
+// unchanged.  The block's tgt_addr is left alone.
+//
+// @return ZX_ERR_NOT_SUPPORTED if the platform cannot target |cpu|.
+zx_status_t msi_set_vector_affinity(const msi_block_t* block, uint msi_id, cpu_num_t cpu,
+                                    uint64_t* out_tgt_addr);
 __END_CDECLS
@@ -44,3 +44,12 @@ __WEAK void msi_register_handler(const msi_block_t* block,
                                  void *ctx) {
     PANIC_UNIMPLEMENTED;
 }
+
+__WEAK zx_status_t msi_set_affinity(msi_block_t* block, cpu_num_t cpu) {
+    return ZX_ERR_NOT_SUPPORTED;
+}
+
+__WEAK zx_status_t msi_set_vector_affinity(const msi_block_t* block, uint msi_id, cpu_num_t cpu,
+                                           uint64_t* out_tgt_addr) {
+    return ZX_ERR_NOT_SUPPORTED;
+}
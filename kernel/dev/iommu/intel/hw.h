@@ -274,6 +274,37 @@ public:
     DEF_BIT(63, fault);
 };
 
+class InvalidationQueueHead : public hwreg::RegisterBase<InvalidationQueueHead, uint64_t> {
+public:
+    static constexpr uint32_t kAddr = 0x80;
+    static auto Get() { return hwreg::RegisterAddr<InvalidationQueueHead>(kAddr); }
+
+    DEF_RSVDZ_FIELD(3, 0);
+    DEF_FIELD(18, 4, queue_head);
+    DEF_RSVDZ_FIELD(63, 19);
+};
+
+class InvalidationQueueTail : public hwreg::RegisterBase<InvalidationQueueTail, uint64_t> {
+public:
+    static constexpr uint32_t kAddr = 0x88;
+    static auto Get() { return hwreg::RegisterAddr<InvalidationQueueTail>(kAddr); }
+
+    DEF_RSVDZ_FIELD(3, 0);
+    DEF_FIELD(18, 4, queue_tail);
+    DEF_RSVDZ_FIELD(63, 19);
+};
+
+class InvalidationQueueAddress : public hwreg::RegisterBase<InvalidationQueueAddress, uint64_t> {
+public:
+    static constexpr uint32_t kAddr = 0x90;
+    static auto Get() { return hwreg::RegisterAddr<InvalidationQueueAddress>(kAddr); }
+
+    // The queue is 2^|queue_size| pages long.
+    DEF_FIELD(2, 0, queue_size);
+    DEF_RSVDZ_FIELD(11, 3);
+    DEF_FIELD(63, 12, queue_address);
+};
+
 } // namespace reg
 
 namespace ds {
@@ -494,6 +525,60 @@ struct PasidState {
 static_assert(fbl::is_pod<PasidState>::value, "not POD");
 static_assert(sizeof(PasidState) == 8, "wrong size");
 
+// An entry in the invalidation queue.  Which fields are meaningful depends on
+// the type of the descriptor.
+struct InvalidationDescriptor {
+    uint64_t raw[2];
+
+    DEF_SUBFIELD(raw[0], 3, 0, type);
+
+    // Context-cache and IOTLB invalidation.  The granularities are encoded
+    // as in reg::ContextCommand and reg::IotlbInvalidate.
+    DEF_SUBFIELD(raw[0], 5, 4, granularity);
+    DEF_SUBFIELD(raw[0], 31, 16, domain_id);
+
+    // Context-cache invalidation
+    DEF_SUBFIELD(raw[0], 47, 32, source_id);
+    DEF_SUBFIELD(raw[0], 49, 48, function_mask);
+
+    // IOTLB invalidation
+    DEF_SUBBIT(raw[0], 6, drain_writes);
+    DEF_SUBBIT(raw[0], 7, drain_reads);
+    DEF_SUBFIELD(raw[1], 5, 0, address_mask);
+    DEF_SUBBIT(raw[1], 6, invld_hint);
+    DEF_SUBFIELD(raw[1], 63, 12, address);
+
+    // Invalidation wait
+    DEF_SUBBIT(raw[0], 4, interrupt_flag);
+    DEF_SUBBIT(raw[0], 5, status_write);
+    DEF_SUBBIT(raw[0], 6, fence);
+    DEF_SUBFIELD(raw[0], 63, 32, status_data);
+    DEF_SUBFIELD(raw[1], 63, 2, status_address);
+
+    void WriteTo(volatile InvalidationDescriptor* dst) {
+        dst->raw[0] = raw[0];
+        dst->raw[1] = raw[1];
+
+        // Hardware access to the invalidation queue may not be coherent, so flush just in case.
+        arch_clean_cache_range(reinterpret_cast<addr_t>(dst), sizeof(*dst));
+    }
+
+    enum Type {
+        kContextCacheInvld = 0x1,
+        kIotlbInvld = 0x2,
+        kInvldWait = 0x5,
+    };
+};
+static_assert(fbl::is_pod<InvalidationDescriptor>::value, "not POD");
+static_assert(sizeof(InvalidationDescriptor) == 16, "wrong size");
+
+struct InvalidationQueue {
+    static constexpr size_t kNumEntries = 256;
+    InvalidationDescriptor entry[kNumEntries];
+};
+static_assert(fbl::is_pod<InvalidationQueue>::value, "not POD");
+static_assert(sizeof(InvalidationQueue) == 4096, "wrong size");
+
 } // namespace ds
 
 } // namespace intel_iommu
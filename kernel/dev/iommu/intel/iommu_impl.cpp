@@ -6,6 +6,7 @@
 
 #include "iommu_impl.h"
 
+#include <arch/ops.h>
 #include <dev/interrupt.h>
 #include <err.h>
 #include <fbl/algorithm.h>
@@ -86,6 +87,10 @@ IommuImpl::~IommuImpl() {
     zx_status_t status = SetTranslationEnableLocked(false, ZX_TIME_INFINITE);
     ASSERT(status == ZX_OK);
 
+    if (queued_invld_enabled_) {
+        DisableQueuedInvalidationLocked();
+    }
+
     DisableFaultsLocked();
     msi_free_block(&irq_block_);
 
@@ -393,6 +398,16 @@ zx_status_t IommuImpl::Initialize() {
         return status;
     }
 
+    // Switch to queued invalidation if we can, before anything else needs
+    // invalidating.
+    if (extended_caps_.supports_queued_invld()) {
+        status = EnableQueuedInvalidationLocked();
+        if (status != ZX_OK) {
+            LTRACEF("enabling queued invalidation failed\n");
+            return status;
+        }
+    }
+
     // Enable interrupts before we enable translation
     status = ConfigureFaultEventInterruptLocked();
     if (status != ZX_OK) {
@@ -500,6 +515,15 @@ zx_status_t IommuImpl::SetTranslationEnableLocked(bool enabled, zx_time_t deadli
 void IommuImpl::InvalidateContextCacheGlobalLocked() {
     DEBUG_ASSERT(lock_.IsHeld());
 
+    if (queued_invld_enabled_) {
+        ds::InvalidationDescriptor desc = {};
+        desc.set_type(ds::InvalidationDescriptor::kContextCacheInvld);
+        desc.set_granularity(reg::ContextCommand::kGlobalInvld);
+        QueueInvalidationLocked(desc);
+        WaitForInvalidationsLocked();
+        return;
+    }
+
     auto context_cmd = reg::ContextCommand::Get().FromValue(0);
     context_cmd.set_invld_context_cache(1);
     context_cmd.set_invld_request_granularity(reg::ContextCommand::kGlobalInvld);
@@ -512,6 +536,16 @@ void IommuImpl::InvalidateContextCacheGlobalLocked() {
 void IommuImpl::InvalidateContextCacheDomainLocked(uint32_t domain_id) {
     DEBUG_ASSERT(lock_.IsHeld());
 
+    if (queued_invld_enabled_) {
+        ds::InvalidationDescriptor desc = {};
+        desc.set_type(ds::InvalidationDescriptor::kContextCacheInvld);
+        desc.set_granularity(reg::ContextCommand::kDomainInvld);
+        desc.set_domain_id(domain_id);
+        QueueInvalidationLocked(desc);
+        WaitForInvalidationsLocked();
+        return;
+    }
+
     auto context_cmd = reg::ContextCommand::Get().FromValue(0);
     context_cmd.set_invld_context_cache(1);
     context_cmd.set_invld_request_granularity(reg::ContextCommand::kDomainInvld);
@@ -536,6 +570,15 @@ void IommuImpl::InvalidateIotlbGlobalLocked() {
     DEBUG_ASSERT(lock_.IsHeld());
     ASSERT(!caps_.required_write_buf_flushing());
 
+    if (queued_invld_enabled_) {
+        ds::InvalidationDescriptor desc = {};
+        desc.set_type(ds::InvalidationDescriptor::kIotlbInvld);
+        desc.set_granularity(reg::IotlbInvalidate::kGlobalInvld);
+        QueueInvalidationLocked(desc);
+        WaitForInvalidationsLocked();
+        return;
+    }
+
     // TODO(teisenbe): Read/write draining?
     auto iotlb_invld = reg::IotlbInvalidate::Get(iotlb_reg_offset_).ReadFrom(&mmio_);
     iotlb_invld.set_invld_iotlb(1);
@@ -550,6 +593,16 @@ void IommuImpl::InvalidateIotlbDomainAllLocked(uint32_t domain_id) {
     DEBUG_ASSERT(lock_.IsHeld());
     ASSERT(!caps_.required_write_buf_flushing());
 
+    if (queued_invld_enabled_) {
+        ds::InvalidationDescriptor desc = {};
+        desc.set_type(ds::InvalidationDescriptor::kIotlbInvld);
+        desc.set_granularity(reg::IotlbInvalidate::kDomainAllInvld);
+        desc.set_domain_id(domain_id);
+        QueueInvalidationLocked(desc);
+        WaitForInvalidationsLocked();
+        return;
+    }
+
     // TODO(teisenbe): Read/write draining?
     auto iotlb_invld = reg::IotlbInvalidate::Get(iotlb_reg_offset_).ReadFrom(&mmio_);
     iotlb_invld.set_invld_iotlb(1);
@@ -568,6 +621,18 @@ void IommuImpl::InvalidateIotlbPageLocked(uint32_t domain_id, dev_vaddr_t vaddr,
     DEBUG_ASSERT(pages_pow2 <= caps_.max_addr_mask_value());
     ASSERT(!caps_.required_write_buf_flushing());
 
+    if (queued_invld_enabled_) {
+        ds::InvalidationDescriptor desc = {};
+        desc.set_type(ds::InvalidationDescriptor::kIotlbInvld);
+        desc.set_granularity(reg::IotlbInvalidate::kDomainPageInvld);
+        desc.set_domain_id(domain_id);
+        desc.set_address(vaddr >> 12);
+        desc.set_invld_hint(0);
+        desc.set_address_mask(pages_pow2);
+        QueueInvalidationLocked(desc);
+        return;
+    }
+
     auto invld_addr = reg::InvalidateAddress::Get(iotlb_reg_offset_).FromValue(0);
     invld_addr.set_address(vaddr >> 12);
     invld_addr.set_invld_hint(0);
@@ -585,6 +650,124 @@ void IommuImpl::InvalidateIotlbPageLocked(uint32_t domain_id, dev_vaddr_t vaddr,
                        ZX_TIME_INFINITE);
 }
 
+void IommuImpl::WaitForInvalidationsLocked() {
+    DEBUG_ASSERT(lock_.IsHeld());
+
+    if (!queued_invld_enabled_ || !invld_pending_) {
+        return;
+    }
+
+    // Have hardware write a new sequence number to the status page once all
+    // of the descriptors before this one are done, and spin until it
+    // appears.  Invalidations complete in about a microsecond, so sleeping
+    // would only add latency.
+    const uint32_t seq = ++invld_wait_seq_;
+    ds::InvalidationDescriptor desc = {};
+    desc.set_type(ds::InvalidationDescriptor::kInvldWait);
+    desc.set_status_write(1);
+    desc.set_fence(1);
+    desc.set_status_data(seq);
+    desc.set_status_address(invld_wait_status_page_.paddr() >> 2);
+    QueueInvalidationLocked(desc);
+    SubmitInvalidationsLocked();
+
+    while (*invld_wait_status() != seq) {
+        auto fault_status = reg::FaultStatus::Get().ReadFrom(&mmio_);
+        if (fault_status.invld_queue_error()) {
+            panic("IOMMU invalidation queue error at head %#lx\n",
+                  reg::InvalidationQueueHead::Get().ReadFrom(&mmio_).queue_head());
+        }
+        arch_spinloop_pause();
+    }
+    invld_pending_ = false;
+}
+
+void IommuImpl::QueueInvalidationLocked(const ds::InvalidationDescriptor& desc) {
+    DEBUG_ASSERT(lock_.IsHeld());
+    DEBUG_ASSERT(queued_invld_enabled_);
+
+    constexpr uint32_t kNumEntries = ds::InvalidationQueue::kNumEntries;
+    const uint32_t next_tail = (invld_queue_tail_ + 1) % kNumEntries;
+
+    // If the queue is full, let hardware drain it before reusing the slot.
+    auto head = reg::InvalidationQueueHead::Get().ReadFrom(&mmio_);
+    if (next_tail == head.queue_head()) {
+        SubmitInvalidationsLocked();
+        do {
+            arch_spinloop_pause();
+            head.ReadFrom(&mmio_);
+        } while (next_tail == head.queue_head());
+    }
+
+    ds::InvalidationDescriptor entry = desc;
+    entry.WriteTo(&invld_queue()->entry[invld_queue_tail_]);
+    invld_queue_tail_ = next_tail;
+    invld_pending_ = true;
+}
+
+void IommuImpl::SubmitInvalidationsLocked() {
+    DEBUG_ASSERT(lock_.IsHeld());
+
+    auto tail = reg::InvalidationQueueTail::Get().FromValue(0);
+    tail.set_queue_tail(invld_queue_tail_);
+    tail.WriteTo(&mmio_);
+}
+
+zx_status_t IommuImpl::EnableQueuedInvalidationLocked() {
+    DEBUG_ASSERT(lock_.IsHeld());
+    DEBUG_ASSERT(!queued_invld_enabled_);
+
+    zx_status_t status = IommuPage::AllocatePage(&invld_queue_page_);
+    if (status != ZX_OK) {
+        return status;
+    }
+    status = IommuPage::AllocatePage(&invld_wait_status_page_);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    // The tail must be zero when the queue is enabled, which resets the head
+    // to match.
+    invld_queue_tail_ = 0;
+    reg::InvalidationQueueTail::Get().FromValue(0).WriteTo(&mmio_);
+
+    auto queue_addr = reg::InvalidationQueueAddress::Get().FromValue(0);
+    queue_addr.set_queue_size(0);
+    queue_addr.set_queue_address(invld_queue_page_.paddr() >> PAGE_SIZE_SHIFT);
+    queue_addr.WriteTo(&mmio_);
+
+    auto global_ctl = reg::GlobalControl::Get().ReadFrom(&mmio_);
+    global_ctl.set_queued_invld_enable(1);
+    global_ctl.WriteTo(&mmio_);
+    status = WaitForValueLocked(&global_ctl, &decltype(global_ctl)::queued_invld_enable,
+                                1, zx_time_add_duration(current_time(), ZX_SEC(1)));
+    if (status != ZX_OK) {
+        LTRACEF("Timed out waiting for queued_invld_enable bit to take\n");
+        return status;
+    }
+
+    queued_invld_enabled_ = true;
+    return ZX_OK;
+}
+
+void IommuImpl::DisableQueuedInvalidationLocked() {
+    DEBUG_ASSERT(lock_.IsHeld());
+    DEBUG_ASSERT(queued_invld_enabled_);
+
+    // Hardware requires the queue to be empty before it is disabled.
+    WaitForInvalidationsLocked();
+
+    auto global_ctl = reg::GlobalControl::Get().ReadFrom(&mmio_);
+    global_ctl.set_queued_invld_enable(0);
+    global_ctl.WriteTo(&mmio_);
+    zx_status_t status = WaitForValueLocked(&global_ctl,
+                                            &decltype(global_ctl)::queued_invld_enable, 0,
+                                            ZX_TIME_INFINITE);
+    ASSERT(status == ZX_OK);
+
+    queued_invld_enabled_ = false;
+}
+
 void IommuImpl::InvalidateIotlbGlobal() {
     fbl::AutoLock guard(&lock_);
     InvalidateIotlbGlobalLocked();
@@ -67,9 +67,16 @@ public:
     // Invalidate the IOTLB entries for the specified translations.
     // |pages_pow2| indicates how many pages should be invalidated (calculated
     // as 2^|pages_pow2|).
+    //
+    // With queued invalidation this only queues the request, so that a batch
+    // of them can be waited on at once with WaitForInvalidationsLocked().
     void InvalidateIotlbPageLocked(uint32_t domain_id, dev_vaddr_t vaddr,
                                    uint pages_pow2) TA_REQ(lock_);
 
+    // Wait until every invalidation requested so far has completed.  This is
+    // a no-op unless queued invalidation is in use.
+    void WaitForInvalidationsLocked() TA_REQ(lock_);
+
 private:
     DISALLOW_COPY_ASSIGN_AND_MOVE(IommuImpl);
     IommuImpl(volatile void* register_base, fbl::unique_ptr<const uint8_t[]> desc,
@@ -96,6 +103,18 @@ private:
     // IOTLB invalidation
     void InvalidateIotlbGlobalLocked() TA_REQ(lock_);
 
+    // Queued invalidation.  Once enabled, invalidations are submitted as
+    // descriptors on the invalidation queue instead of through the
+    // invalidation registers, which lets a batch of them complete with a
+    // single wait.
+    zx_status_t EnableQueuedInvalidationLocked() TA_REQ(lock_);
+    void DisableQueuedInvalidationLocked() TA_REQ(lock_);
+    // Append |desc| to the queue.  Hardware isn't told about it until the
+    // next WaitForInvalidationsLocked(), unless the queue fills up first.
+    void QueueInvalidationLocked(const ds::InvalidationDescriptor& desc) TA_REQ(lock_);
+    // Hand the queued descriptors to hardware.
+    void SubmitInvalidationsLocked() TA_REQ(lock_);
+
     zx_status_t SetRootTablePointerLocked(paddr_t pa) TA_REQ(lock_);
     zx_status_t SetTranslationEnableLocked(bool enabled, zx_time_t deadline) TA_REQ(lock_);
     zx_status_t ConfigureFaultEventInterruptLocked() TA_REQ(lock_);
@@ -120,6 +139,12 @@ private:
     volatile ds::RootTable* root_table() const TA_REQ(lock_) {
         return reinterpret_cast<volatile ds::RootTable*>(root_table_page_.vaddr());
     }
+    volatile ds::InvalidationQueue* invld_queue() const TA_REQ(lock_) {
+        return reinterpret_cast<volatile ds::InvalidationQueue*>(invld_queue_page_.vaddr());
+    }
+    volatile uint32_t* invld_wait_status() const TA_REQ(lock_) {
+        return reinterpret_cast<volatile uint32_t*>(invld_wait_status_page_.vaddr());
+    }
 
     fbl::Mutex lock_;
 
@@ -138,6 +163,19 @@ private:
     // List of allocated context tables
     fbl::DoublyLinkedList<fbl::unique_ptr<ContextTableState>> context_tables_ TA_GUARDED(lock_);
 
+    // Invalidation queue, and the page hardware writes the status of
+    // invalidation wait descriptors to.  Only allocated if the hardware
+    // supports queued invalidation.
+    IommuPage invld_queue_page_ TA_GUARDED(lock_);
+    IommuPage invld_wait_status_page_ TA_GUARDED(lock_);
+    bool queued_invld_enabled_ TA_GUARDED(lock_) = false;
+    // The index of the next descriptor slot to fill.
+    uint32_t invld_queue_tail_ TA_GUARDED(lock_) = 0;
+    // Whether descriptors have been queued since the last wait completed.
+    bool invld_pending_ TA_GUARDED(lock_) = false;
+    // The status data of the last invalidation wait descriptor queued.
+    uint32_t invld_wait_seq_ TA_GUARDED(lock_) = 0;
+
     DomainAllocator domain_allocator_ TA_GUARDED(lock_);
 
     // A mask with bits set for each usable bit in an address with the largest allowed
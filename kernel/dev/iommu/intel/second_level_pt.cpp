@@ -136,13 +136,30 @@ void SecondLevelPageTable::TlbInvalidate(PendingTlbInvalidation* pending)
 
     DEBUG_ASSERT(!pending->contains_global);
 
-    if (pending->full_shootdown) {
+    constexpr uint kBitsPerLevel = 9;
+    const uint max_address_mask = static_cast<uint>(iommu_->caps()->max_addr_mask_value());
+
+    // Page-selective invalidation can't cover a large page whose size is past
+    // the largest address mask hardware supports, so fall back to flushing
+    // the whole domain.
+    bool domain_all = pending->full_shootdown ||
+                      !iommu_->caps()->supports_page_selective_invld();
+    for (uint i = 0; !domain_all && i < pending->count; ++i) {
+        const auto& item = pending->item[i];
+        if (item.is_terminal() &&
+            kBitsPerLevel * static_cast<uint>(item.page_level()) > max_address_mask) {
+            domain_all = true;
+        }
+    }
+
+    if (domain_all) {
         iommu_->InvalidateIotlbDomainAllLocked(parent_->domain_id());
         pending->clear();
         return;
     }
 
-    constexpr uint kBitsPerLevel = 9;
+    // With queued invalidation these are only queued up here, and complete
+    // together with the wait below.
     for (uint i = 0; i < pending->count; ++i) {
         const auto& item = pending->item[i];
         uint address_mask = kBitsPerLevel * static_cast<uint>(item.page_level());
@@ -157,6 +174,7 @@ void SecondLevelPageTable::TlbInvalidate(PendingTlbInvalidation* pending)
         }
         iommu_->InvalidateIotlbPageLocked(parent_->domain_id(), item.addr(), address_mask);
     }
+    iommu_->WaitForInvalidationsLocked();
     pending->clear();
 }
 
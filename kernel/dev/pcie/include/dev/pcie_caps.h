@@ -57,6 +57,34 @@ constexpr uint8_t PCIE_CAP_ID_ENHANCED_ALLOCATION      = 0x14;
 
 #define PCIE_CAP_MSI_CTRL_SET_MME(val, ctrl)    (uint16_t)((ctrl & ~0x0070) | ((val & 0x7) << 4))
 #define PCIE_CAP_MSI_CTRL_SET_ENB(val, ctrl)    (uint16_t)((ctrl & ~0x0001) | (!!val))
+
+/**
+ * Structure definitions for capability PCIE_CAP_ID_MSIX
+ *
+ * @see The PCI Local Bus specification v3.0 Section 6.8.2
+ */
+#define PCIE_CAP_MSIX_CTRL_GET_TABLE_SIZE(ctrl) ((ctrl & 0x07FF) + 1u)
+#define PCIE_CAP_MSIX_CTRL_GET_FUNC_MASK(ctrl)  ((ctrl & 0x4000) != 0)
+#define PCIE_CAP_MSIX_CTRL_GET_ENB(ctrl)        ((ctrl & 0x8000) != 0)
+
+#define PCIE_CAP_MSIX_CTRL_SET_FUNC_MASK(val, ctrl) (uint16_t)((ctrl & ~0x4000) | ((!!val) << 14))
+#define PCIE_CAP_MSIX_CTRL_SET_ENB(val, ctrl)       (uint16_t)((ctrl & ~0x8000) | ((!!val) << 15))
+
+/* The table and PBA registers hold a BAR indicator in their low 3 bits, and
+ * the (8 byte aligned) offset of the structure within that BAR above them. */
+#define PCIE_CAP_MSIX_GET_BIR(reg)              ((reg) & 0x7)
+#define PCIE_CAP_MSIX_GET_OFFSET(reg)           ((reg) & ~0x7u)
+
+/* Each MSI-X vector has a 16 byte entry of its own in the vector table. */
+typedef struct pcie_msix_table_entry {
+    uint32_t msg_addr;
+    uint32_t msg_upper_addr;
+    uint32_t msg_data;
+    uint32_t vector_ctrl;
+} pcie_msix_table_entry_t;
+static_assert(sizeof(pcie_msix_table_entry_t) == 16, "MSI-X table entries are 16 bytes");
+
+#define PCIE_MSIX_VECTOR_CTRL_MASKED            (0x00000001u)
 #define PCS_CAPS_V1_ENDPOINT_SIZE        ((uint)offsetof(pcie_capabilities_t, link))
 #define PCS_CAPS_V1_UPSTREAM_PORT_SIZE   ((uint)offsetof(pcie_capabilities_t, slot))
 #define PCS_CAPS_V1_DOWNSTREAM_PORT_SIZE ((uint)offsetof(pcie_capabilities_t, root))
@@ -255,6 +283,46 @@ private:
     PciReg32 pending_bits_;
 };
 
+/* MSI-X Interrupts.
+ * @see PCI Local Bus Spec v3.0 section 6.8.2.
+ */
+class PciCapMsix : public PciStdCapability {
+public:
+    static constexpr uint16_t kControlOffset = 0x02;
+    static constexpr uint16_t kTableOffset   = 0x04;
+    static constexpr uint16_t kPbaOffset     = 0x08;
+    static constexpr uint16_t kCapSize       = 0x0C;
+
+    PciCapMsix(const PcieDevice& dev, uint16_t base, uint8_t id);
+    ~PciCapMsix();
+
+    // Accessors
+    unsigned int max_irqs() const { return table_size_; }
+    uint table_bir() const { return table_bir_; }
+    uint32_t table_offset() const { return table_offset_; }
+    uint pba_bir() const { return pba_bir_; }
+    uint32_t pba_offset() const { return pba_offset_; }
+    PciReg16 ctrl_reg() const { return ctrl_; }
+    msi_block_t irq_block() const { return irq_block_; }
+
+private:
+    // The vector table lives in one of the device's BARs and is mapped into the
+    // kernel by PcieDevice only while the device is in MSI-X mode.
+    friend class PcieDevice;
+    unsigned int table_size_ = 0;
+    uint         table_bir_;
+    uint32_t     table_offset_;
+    uint         pba_bir_;
+    uint32_t     pba_offset_;
+    msi_block_t  irq_block_;
+
+    void* mapping_ = nullptr;
+    volatile pcie_msix_table_entry_t* table_ = nullptr;
+
+    // Cached registers
+    PciReg16 ctrl_;
+};
+
 /* PCI Express Capability classes */
 
 class PciCapPcie : public PciStdCapability {
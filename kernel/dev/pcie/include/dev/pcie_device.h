@@ -280,6 +280,31 @@ public:
      */
     zx_status_t MaskUnmaskIrq(uint irq_id, bool mask);
 
+    /**
+     * Steer the specified IRQ of the given device to a CPU.
+     *
+     * @param irq_id The ID of the IRQ to steer.
+     * @param cpu The CPU which should take the IRQ from now on.
+     *
+     * @note The vectors in a device's block of MSIs share a single target, so
+     * steering one of them steers all of them.
+     *
+     * @return A zx_status_t indicating the success or failure of the operation.
+     * Status codes may include (but are not limited to)...
+     *
+     * ++ ZX_ERR_UNAVAILABLE
+     *    The device has become unplugged and is waiting to be released.
+     * ++ ZX_ERR_BAD_STATE
+     *    Attempting to steer an IRQ while in the DISABLED mode.
+     * ++ ZX_ERR_INVALID_ARGS
+     *    The irq_id parameter is out of range for the currently configured
+     *    mode, or the CPU is not online.
+     * ++ ZX_ERR_NOT_SUPPORTED
+     *    The device is operating in legacy mode, whose IRQ is shared with other
+     *    devices, or the platform cannot steer the device's MSIs.
+     */
+    zx_status_t SetIrqAffinity(uint irq_id, cpu_num_t cpu);
+
     void SetQuirksDone() { quirks_done_ = true; }
 
     /**
@@ -396,6 +421,7 @@ private:
     zx_status_t SetIrqModeLocked(pcie_irq_mode_t mode, uint requested_irqs);
     zx_status_t RegisterIrqHandlerLocked(uint irq_id, pcie_irq_handler_fn_t handler, void* ctx);
     zx_status_t MaskUnmaskIrqLocked(uint irq_id, bool mask);
+    zx_status_t SetIrqAffinityLocked(uint irq_id, cpu_num_t cpu);
 
     // Internal Legacy IRQ support.
     zx_status_t MaskUnmaskLegacyIrq(bool mask);
@@ -414,7 +440,8 @@ private:
     zx_status_t MaskUnmaskMsiIrq(uint irq_id, bool mask);
     void        MaskAllMsiVectors();
     void        SetMsiTarget(uint64_t tgt_addr, uint32_t tgt_data);
-    void        FreeMsiBlock();
+    zx_status_t SetMsiAffinity(cpu_num_t cpu);
+    void        FreeMsiBlock(msi_block_t* block);
     void        SetMsiMultiMessageEnb(uint requested_irqs);
     void        LeaveMsiIrqMode();
     zx_status_t EnterMsiIrqMode(uint requested_irqs);
@@ -422,6 +449,26 @@ private:
     void        MsiIrqHandler(pcie_irq_handler_state_t& hstate);
     static void MsiIrqHandlerThunk(void *arg);
 
+    // Internal MSI-X IRQ support.
+    void SetMsixEnb(bool enb) {
+        DEBUG_ASSERT(irq_.msix);
+        DEBUG_ASSERT(irq_.msix->is_valid());
+        cfg_->Write(irq_.msix->ctrl_reg(),
+                PCIE_CAP_MSIX_CTRL_SET_ENB(enb, cfg_->Read(irq_.msix->ctrl_reg())));
+    }
+
+    bool        MaskUnmaskMsixIrqLocked(uint irq_id, bool mask);
+    zx_status_t MaskUnmaskMsixIrq(uint irq_id, bool mask);
+    void        SetMsixTarget(uint irq_id, uint64_t tgt_addr, uint32_t tgt_data);
+    zx_status_t SetMsixAffinity(uint irq_id, cpu_num_t cpu);
+    zx_status_t MapMsixTable();
+    void        UnmapMsixTable();
+    void        LeaveMsixIrqMode();
+    zx_status_t EnterMsixIrqMode(uint requested_irqs);
+
+    void        MsixIrqHandler(pcie_irq_handler_state_t& hstate);
+    static void MsixIrqHandlerThunk(void *arg);
+
     // Common Internal IRQ support.
     void        ResetCommonIrqBookkeeping();
     zx_status_t AllocIrqHandlers(uint requested_irqs, bool is_masked);
@@ -456,7 +503,6 @@ private:
         } legacy;
 
         PciCapMsi* msi = nullptr;
-        /* TODO(johngro) : Add MSI-X state */
-        struct { } msi_x;
+        PciCapMsix* msix = nullptr;
     } irq_;
 };
@@ -123,6 +123,41 @@ public:
         DEBUG_ASSERT(false);
     }
 
+    /**
+     * Method used to steer every MSI within a block to a given CPU.
+     *
+     * @param block A pointer to a block of MSIs allocated using a platform supplied
+     *        platform_msi_alloc_block_t callback.  On success, its target
+     *        address and data hold what the device must be programmed with.
+     * @param cpu The CPU to steer the block to.
+     *
+     * @return ZX_ERR_NOT_SUPPORTED if the platform cannot steer MSIs.
+     */
+    virtual zx_status_t SetMsiAffinity(msi_block_t* block, cpu_num_t cpu) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+
+    /**
+     * Method used to steer a single MSI within a block to a given CPU.  Only
+     * MSI-X can make use of this, as every MSI-X vector has a target write
+     * transaction of its own.
+     *
+     * @param block A pointer to a block of MSIs allocated using a platform supplied
+     *        platform_msi_alloc_block_t callback.  It is not modified.
+     * @param msi_id The 0-indexed MSI within the block to steer.
+     * @param cpu The CPU to steer the MSI to.
+     * @param out_tgt_addr On success, the target address the vector must be
+     *        programmed with.  Its target data is unchanged.
+     *
+     * @return ZX_ERR_NOT_SUPPORTED if the platform cannot steer MSIs.
+     */
+    virtual zx_status_t SetMsiVectorAffinity(const msi_block_t* block,
+                                             uint msi_id,
+                                             cpu_num_t cpu,
+                                             uint64_t* out_tgt_addr) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+
     DISALLOW_COPY_ASSIGN_AND_MOVE(PciePlatformInterface);
 protected:
     enum class MsiSupportLevel { NONE, MSI, MSI_WITH_MASKING };
@@ -13,6 +13,7 @@
 #include <fbl/algorithm.h>
 #include <dev/pci_config.h>
 #include <dev/pcie_device.h>
+#include <vm/vm_aspace.h>
 
 #include <fbl/alloc_checker.h>
 
@@ -256,6 +257,68 @@ PciCapMsi::PciCapMsi(const PcieDevice& dev, uint16_t base, uint8_t id)
     is_valid_ = true;
 }
 
+PciCapMsix::PciCapMsix(const PcieDevice& dev, uint16_t base, uint8_t id)
+    : PciStdCapability(dev, base, id) {
+    DEBUG_ASSERT(id == PCIE_CAP_ID_MSIX);
+    auto cfg = dev.config();
+
+    ctrl_ = PciReg16(static_cast<uint16_t>(base_ + kControlOffset));
+    memset(&irq_block_, 0, sizeof(irq_block_));
+
+    uint16_t msix_end = static_cast<uint16_t>(base_ + kCapSize);
+    uint16_t cfgend = PCIE_BASE_CONFIG_SIZE;
+    if (msix_end > cfgend) {
+        TRACEF("Device %02x:%02x.%01x (%04hx:%04hx) has illegally positioned MSI-X "
+               "capability structure.  The structure ends at %u, %u bytes past the "
+               "end of config space\n",
+               dev.bus_id(), dev.dev_id(), dev.func_id(),
+               dev.vendor_id(), dev.device_id(),
+               msix_end, static_cast<unsigned int>(msix_end - cfgend));
+        return;
+    }
+
+    uint16_t ctrl = cfg->Read(ctrl_reg());
+    uint32_t table = cfg->Read(PciReg32(static_cast<uint16_t>(base_ + kTableOffset)));
+    uint32_t pba = cfg->Read(PciReg32(static_cast<uint16_t>(base_ + kPbaOffset)));
+
+    table_size_   = PCIE_CAP_MSIX_CTRL_GET_TABLE_SIZE(ctrl);
+    table_bir_    = PCIE_CAP_MSIX_GET_BIR(table);
+    table_offset_ = PCIE_CAP_MSIX_GET_OFFSET(table);
+    pba_bir_      = PCIE_CAP_MSIX_GET_BIR(pba);
+    pba_offset_   = PCIE_CAP_MSIX_GET_OFFSET(pba);
+
+    /* The BAR indicator values 6 and 7 are reserved. */
+    if ((table_bir_ >= PCIE_MAX_BAR_REGS) || (pba_bir_ >= PCIE_MAX_BAR_REGS)) {
+        TRACEF("Device %02x:%02x.%01x (%04hx:%04hx) has invalid MSI-X table (BIR %u) "
+               "or PBA (BIR %u) location\n",
+               dev.bus_id(), dev.dev_id(), dev.func_id(),
+               dev.vendor_id(), dev.device_id(),
+               table_bir_, pba_bir_);
+        table_size_ = 0;
+        return;
+    }
+
+    /* Success!
+     *
+     * Make sure that MSI-X is disabled and that the function is not masked.
+     * Individual vectors are masked in the vector table when MSI-X mode is
+     * entered.
+     */
+    cfg->Write(ctrl_reg(), PCIE_CAP_MSIX_CTRL_SET_FUNC_MASK(0,
+                           PCIE_CAP_MSIX_CTRL_SET_ENB(0, ctrl)));
+
+    is_valid_ = true;
+}
+
+PciCapMsix::~PciCapMsix() {
+    /* The table is unmapped when the device leaves MSI-X mode, so this should
+     * only ever be needed if a device goes away while still in MSI-X mode. */
+    DEBUG_ASSERT(!irq_block_.allocated);
+    if (mapping_ != nullptr) {
+        VmAspace::kernel_aspace()->FreeRegion(reinterpret_cast<vaddr_t>(mapping_));
+    }
+}
+
 /* Catch quirks and invalid capability offsets we may see */
 inline zx_status_t validate_capability_offset(uint8_t offset) {
     if (offset == 0xFF
@@ -316,6 +379,8 @@ zx_status_t PcieDevice::ParseStdCapabilitiesLocked() {
         switch(id) {
             case PCIE_CAP_ID_MSI:
                 cap = irq_.msi = new (&ac) PciCapMsi(*this, cap_offset, id); break;
+            case PCIE_CAP_ID_MSIX:
+                cap = irq_.msix = new (&ac) PciCapMsix(*this, cap_offset, id); break;
             case PCIE_CAP_ID_PCI_EXPRESS:
                 cap = pcie_ = new (&ac) PciCapPcie(*this, cap_offset, id); break;
             case PCIE_CAP_ID_ADVANCED_FEATURES:
@@ -12,12 +12,16 @@
 #include <dev/pcie_bridge.h>
 #include <dev/pcie_root.h>
 #include <err.h>
+#include <inttypes.h>
 #include <kernel/spinlock.h>
 #include <list.h>
 #include <pow2.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <trace.h>
 #include <vm/vm.h>
+#include <vm/vm_aspace.h>
 
 #include <dev/pci_config.h>
 #include <dev/pcie_device.h>
@@ -359,26 +363,62 @@ void PcieDevice::SetMsiTarget(uint64_t tgt_addr, uint32_t tgt_data) {
     cfg_->Write(irq_.msi->data_reg(), static_cast<uint16_t>(tgt_data & 0xFFFF));
 }
 
-void PcieDevice::FreeMsiBlock() {
+zx_status_t PcieDevice::SetMsiAffinity(cpu_num_t cpu) {
+    DEBUG_ASSERT(irq_.msi);
+    DEBUG_ASSERT(irq_.msi->is_valid());
+    DEBUG_ASSERT(irq_.msi->irq_block_.allocated);
+
+    msi_block_t& block = irq_.msi->irq_block_;
+    uint64_t old_tgt_addr = block.tgt_addr;
+    uint32_t old_tgt_data = block.tgt_data;
+    zx_status_t res = bus_drv_.platform().SetMsiAffinity(&block, cpu);
+    if (res != ZX_OK)
+        return res;
+
+    /* Some platforms steer MSIs at the interrupt controller, leaving the
+     * target write transaction as it was. */
+    if ((block.tgt_addr == old_tgt_addr) && (block.tgt_data == old_tgt_data))
+        return ZX_OK;
+
+    /* Reprogramming the target masks every vector, so remember which ones were
+     * unmasked and unmask them again once the new target is in place. */
+    DEBUG_ASSERT(irq_.handler_count <= PCIE_MAX_MSI_IRQS);
+    uint32_t unmasked = 0;
+    for (uint i = 0; i < irq_.handler_count; i++) {
+        AutoSpinLock handler_lock(&irq_.handlers[i].lock);
+        if (!irq_.handlers[i].masked)
+            unmasked |= (static_cast<uint32_t>(1u) << i);
+    }
+
+    SetMsiTarget(block.tgt_addr, block.tgt_data);
+    for (uint i = 0; i < irq_.handler_count; i++) {
+        if (unmasked & (static_cast<uint32_t>(1u) << i))
+            MaskUnmaskMsiIrq(i, false);
+    }
+    SetMsiEnb(true);
+
+    return ZX_OK;
+}
+
+void PcieDevice::FreeMsiBlock(msi_block_t* block) {
     /* If no block has been allocated, there is nothing to do */
-    if (!irq_.msi->irq_block_.allocated)
+    if (!block->allocated)
         return;
 
     DEBUG_ASSERT(bus_drv_.platform().supports_msi());
 
     /* Mask the IRQ at the platform interrupt controller level if we can, and
      * unregister any registered handler. */
-    const msi_block_t* b = &irq_.msi->irq_block_;
-    for (uint i = 0; i < b->num_irq; i++) {
+    for (uint i = 0; i < block->num_irq; i++) {
         if (bus_drv_.platform().supports_msi_masking()) {
-            bus_drv_.platform().MaskUnmaskMsi(b, i, true);
+            bus_drv_.platform().MaskUnmaskMsi(block, i, true);
         }
-        bus_drv_.platform().RegisterMsiHandler(b, i, nullptr, nullptr);
+        bus_drv_.platform().RegisterMsiHandler(block, i, nullptr, nullptr);
     }
 
     /* Give the block of IRQs back to the plaform */
-    bus_drv_.platform().FreeMsiBlock(&irq_.msi->irq_block_);
-    DEBUG_ASSERT(!irq_.msi->irq_block_.allocated);
+    bus_drv_.platform().FreeMsiBlock(block);
+    DEBUG_ASSERT(!block->allocated);
 }
 
 void PcieDevice::SetMsiMultiMessageEnb(uint requested_irqs) {
@@ -403,7 +443,7 @@ void PcieDevice::LeaveMsiIrqMode() {
     /* Return any allocated irq_ block to the platform, unregistering with
      * the interrupt controller and synchronizing with the dispatchers in
      * the process. */
-    FreeMsiBlock();
+    FreeMsiBlock(&irq_.msi->irq_block_);
 
     /* Reset our common state, free any allocated handlers */
     ResetCommonIrqBookkeeping();
@@ -522,6 +562,262 @@ void PcieDevice::MsiIrqHandlerThunk(void *arg) {
     return hstate.dev->MsiIrqHandler(hstate);
 }
 
+/******************************************************************************
+ *
+ * MSI-X IRQ mode routines.
+ *
+ ******************************************************************************/
+bool PcieDevice::MaskUnmaskMsixIrqLocked(uint irq_id, bool mask) {
+    DEBUG_ASSERT(irq_.mode == PCIE_IRQ_MODE_MSI_X);
+    DEBUG_ASSERT(irq_id < irq_.handler_count);
+    DEBUG_ASSERT(irq_.handlers);
+    DEBUG_ASSERT(irq_.msix->table_);
+
+    pcie_irq_handler_state_t& hstate = irq_.handlers[irq_id];
+    DEBUG_ASSERT(hstate.lock.IsHeld());
+
+    /* Every MSI-X vector can be masked in the vector table, so there is no need
+     * to involve the platform interrupt controller.  The rest of the vector
+     * control register is reserved and must be preserved. */
+    volatile pcie_msix_table_entry_t& entry = irq_.msix->table_[irq_id];
+    uint32_t val = entry.vector_ctrl;
+    if (mask) val |=  PCIE_MSIX_VECTOR_CTRL_MASKED;
+    else      val &= ~PCIE_MSIX_VECTOR_CTRL_MASKED;
+    entry.vector_ctrl = val;
+
+    bool ret = hstate.masked;
+    hstate.masked = mask;
+    return ret;
+}
+
+zx_status_t PcieDevice::MaskUnmaskMsixIrq(uint irq_id, bool mask) {
+    if (irq_id >= irq_.handler_count)
+        return ZX_ERR_INVALID_ARGS;
+
+    DEBUG_ASSERT(irq_.handlers);
+
+    {
+        AutoSpinLock handler_lock(&irq_.handlers[irq_id].lock);
+        MaskUnmaskMsixIrqLocked(irq_id, mask);
+    }
+
+    return ZX_OK;
+}
+
+void PcieDevice::SetMsixTarget(uint irq_id, uint64_t tgt_addr, uint32_t tgt_data) {
+    DEBUG_ASSERT(irq_.msix);
+    DEBUG_ASSERT(irq_.msix->table_);
+    DEBUG_ASSERT(irq_id < irq_.msix->max_irqs());
+
+    /* The result of changing the target of an unmasked vector is undefined, so
+     * callers must mask the vector first. */
+    volatile pcie_msix_table_entry_t& entry = irq_.msix->table_[irq_id];
+    DEBUG_ASSERT(entry.vector_ctrl & PCIE_MSIX_VECTOR_CTRL_MASKED);
+    entry.msg_addr       = static_cast<uint32_t>(tgt_addr & 0xFFFFFFFF);
+    entry.msg_upper_addr = static_cast<uint32_t>(tgt_addr >> 32);
+    entry.msg_data       = tgt_data;
+}
+
+zx_status_t PcieDevice::SetMsixAffinity(uint irq_id, cpu_num_t cpu) {
+    DEBUG_ASSERT(irq_.msix);
+    DEBUG_ASSERT(irq_.msix->irq_block_.allocated);
+    DEBUG_ASSERT(irq_id < irq_.handler_count);
+
+    /* Unlike MSI, every MSI-X vector has a target of its own, so vectors can be
+     * steered one at a time. */
+    const msi_block_t& block = irq_.msix->irq_block_;
+    uint64_t tgt_addr;
+    zx_status_t res = bus_drv_.platform().SetMsiVectorAffinity(&block, irq_id, cpu, &tgt_addr);
+    if (res != ZX_OK)
+        return res;
+
+    AutoSpinLock handler_lock(&irq_.handlers[irq_id].lock);
+    bool was_masked = MaskUnmaskMsixIrqLocked(irq_id, true);
+    SetMsixTarget(irq_id, tgt_addr, block.tgt_data + irq_id);
+    if (!was_masked)
+        MaskUnmaskMsixIrqLocked(irq_id, false);
+
+    return ZX_OK;
+}
+
+zx_status_t PcieDevice::MapMsixTable() {
+    DEBUG_ASSERT(irq_.msix);
+    DEBUG_ASSERT(irq_.msix->is_valid());
+    DEBUG_ASSERT(!irq_.msix->mapping_);
+
+    /* The vector table lives in one of our MMIO BARs, which must have been
+     * allocated and must be large enough to hold it. */
+    const pcie_bar_info_t& bar = bars_[irq_.msix->table_bir()];
+    uint64_t table_offset = irq_.msix->table_offset();
+    uint64_t table_size = irq_.msix->max_irqs() * sizeof(pcie_msix_table_entry_t);
+    if (!bar.is_mmio || (bar.allocation == nullptr) ||
+        (table_offset > bar.size) || (table_size > bar.size - table_offset)) {
+        TRACEF("Device %02x:%02x.%01x has an MSI-X table (BIR %u offset %#" PRIx64
+               " size %#" PRIx64 ") which does not fit in an allocated MMIO BAR\n",
+               bus_id_, dev_id_, func_id_,
+               irq_.msix->table_bir(), table_offset, table_size);
+        return ZX_ERR_BAD_STATE;
+    }
+
+    paddr_t table_phys = bar.bus_addr + table_offset;
+    paddr_t map_base = ROUNDDOWN(table_phys, PAGE_SIZE);
+    size_t map_size = ROUNDUP(table_phys + table_size, PAGE_SIZE) - map_base;
+
+    char name_buf[32];
+    snprintf(name_buf, sizeof(name_buf), "pcie_msix_%02x_%02x_%01x", bus_id_, dev_id_, func_id_);
+
+    void* vaddr;
+    zx_status_t res = VmAspace::kernel_aspace()->AllocPhysical(
+        name_buf,
+        map_size,
+        &vaddr,
+        PAGE_SIZE_SHIFT,
+        map_base,
+        0 /* vmm flags */,
+        ARCH_MMU_FLAG_UNCACHED_DEVICE |
+            ARCH_MMU_FLAG_PERM_READ |
+            ARCH_MMU_FLAG_PERM_WRITE);
+    if (res != ZX_OK)
+        return res;
+
+    irq_.msix->mapping_ = vaddr;
+    irq_.msix->table_ = reinterpret_cast<volatile pcie_msix_table_entry_t*>(
+        static_cast<uint8_t*>(vaddr) + (table_phys - map_base));
+    return ZX_OK;
+}
+
+void PcieDevice::UnmapMsixTable() {
+    if (!irq_.msix->mapping_)
+        return;
+
+    VmAspace::kernel_aspace()->FreeRegion(reinterpret_cast<vaddr_t>(irq_.msix->mapping_));
+    irq_.msix->mapping_ = nullptr;
+    irq_.msix->table_ = nullptr;
+}
+
+void PcieDevice::LeaveMsixIrqMode() {
+    /* Disable MSI-X, then mask every vector in the table (including the ones we
+     * were not using) and zero out their targets. */
+    SetMsixEnb(false);
+    if (irq_.msix->table_) {
+        for (uint i = 0; i < irq_.msix->max_irqs(); i++) {
+            irq_.msix->table_[i].vector_ctrl |= PCIE_MSIX_VECTOR_CTRL_MASKED;
+            SetMsixTarget(i, 0x0, 0x0);
+        }
+    }
+
+    /* Return any allocated irq_ block to the platform, unregistering with
+     * the interrupt controller and synchronizing with the dispatchers in
+     * the process. */
+    FreeMsiBlock(&irq_.msix->irq_block_);
+    UnmapMsixTable();
+
+    /* Reset our common state, free any allocated handlers */
+    ResetCommonIrqBookkeeping();
+}
+
+zx_status_t PcieDevice::EnterMsixIrqMode(uint requested_irqs) {
+    DEBUG_ASSERT(requested_irqs);
+
+    zx_status_t res = ZX_OK;
+    const msi_block_t* block;
+
+    // We cannot go into MSI-X mode if we don't support MSI-X at all, or we
+    // don't support the number of IRQs requested.  The platform allocates
+    // blocks of IRQs no larger than an MSI block, whatever the size of the
+    // device's vector table.
+    if (!irq_.msix                              ||
+        !irq_.msix->is_valid()                  ||
+        !bus_drv_.platform().supports_msi()     ||
+        (requested_irqs > irq_.msix->max_irqs()) ||
+        (requested_irqs > PCIE_MAX_MSI_IRQS))
+        return ZX_ERR_NOT_SUPPORTED;
+
+    block = &irq_.msix->irq_block_;
+
+    // The vector table is programmed through MMIO, so the device has to be
+    // decoding memory space accesses.
+    ModifyCmdLocked(0, PCI_COMMAND_MEM_EN);
+    res = MapMsixTable();
+    if (res != ZX_OK)
+        goto bailout;
+
+    // Make sure that every vector is masked before a block of IRQs is
+    // allocated.
+    for (uint i = 0; i < irq_.msix->max_irqs(); i++)
+        irq_.msix->table_[i].vector_ctrl |= PCIE_MSIX_VECTOR_CTRL_MASKED;
+
+    /* Ask the platform for a chunk of MSI-X compatible IRQs.  Vector table
+     * entries always hold a 64 bit address. */
+    DEBUG_ASSERT(!block->allocated);
+    res = bus_drv_.platform().AllocMsiBlock(requested_irqs,
+                                            true,  /* can_target_64bit == true */
+                                            true,  /* is_msix == true */
+                                            &irq_.msix->irq_block_);
+    if (res != ZX_OK) {
+        LTRACEF("Failed to allocate a block of %u MSI-X IRQs for device "
+                "%02x:%02x.%01x (res %d)\n",
+                requested_irqs, bus_id_, dev_id_, func_id_, res);
+        goto bailout;
+    }
+
+    /* Allocate our handler table.  Every vector starts out masked. */
+    res = AllocIrqHandlers(requested_irqs, true);
+    if (res != ZX_OK)
+        goto bailout;
+
+    /* Record our new IRQ mode */
+    irq_.mode = PCIE_IRQ_MODE_MSI_X;
+
+    /* Program each vector's target write transaction and register each IRQ
+     * with the dispatcher. */
+    DEBUG_ASSERT(irq_.handler_count <= block->num_irq);
+    for (uint i = 0; i < irq_.handler_count; ++i) {
+        SetMsixTarget(i, block->tgt_addr, block->tgt_data + i);
+        bus_drv_.platform().RegisterMsiHandler(block,
+                                               i,
+                                               PcieDevice::MsixIrqHandlerThunk,
+                                               irq_.handlers + i);
+    }
+
+    /* Enable MSI-X at the top level */
+    SetMsixEnb(true);
+
+bailout:
+    if (res != ZX_OK)
+        LeaveMsixIrqMode();
+
+    return res;
+}
+
+void PcieDevice::MsixIrqHandler(pcie_irq_handler_state_t& hstate) {
+    DEBUG_ASSERT(irq_.msix);
+    /* No need to save IRQ state; we are in an IRQ handler at the moment. */
+    AutoSpinLockNoIrqSave handler_lock(&hstate.lock);
+
+    /* Mask our IRQ.  MSI-X vectors can always be masked. */
+    bool was_masked = MaskUnmaskMsixIrqLocked(hstate.pci_irq_id, true);
+
+    /* If the IRQ was masked or the handler removed by the time we got here,
+     * leave the IRQ masked, unlock and get out. */
+    if (was_masked || !hstate.handler)
+        return;
+
+    /* Dispatch */
+    pcie_irq_handler_retval_t irq_ret = hstate.handler(*this, hstate.pci_irq_id, hstate.ctx);
+
+    /* Re-enable the IRQ if asked to do so */
+    if (!(irq_ret & PCIE_IRQRET_MASK))
+        MaskUnmaskMsixIrqLocked(hstate.pci_irq_id, false);
+}
+
+void PcieDevice::MsixIrqHandlerThunk(void *arg) {
+    DEBUG_ASSERT(arg);
+    auto& hstate = *(reinterpret_cast<pcie_irq_handler_state_t*>(arg));
+    DEBUG_ASSERT(hstate.dev);
+    return hstate.dev->MsixIrqHandler(hstate);
+}
+
 /******************************************************************************
  *
  * Internal implementation of the Kernel facing API.
@@ -575,8 +871,15 @@ zx_status_t PcieDevice::QueryIrqModeCapabilitiesLocked(pcie_irq_mode_t mode,
         if (!bus_drv_.platform().supports_msi())
             return ZX_ERR_NOT_SUPPORTED;
 
-        /* TODO(johngro) : finish MSI-X implementation. */
-        return ZX_ERR_NOT_SUPPORTED;
+        if (!irq_.msix || !irq_.msix->is_valid())
+            return ZX_ERR_NOT_SUPPORTED;
+
+        /* Every MSI-X vector can be masked in the vector table.  The platform
+         * hands out blocks of IRQs no larger than an MSI block, so that is as
+         * many vectors as may be used, whatever the size of the table. */
+        out_caps->max_irqs = fbl::min(irq_.msix->max_irqs(), PCIE_MAX_MSI_IRQS);
+        out_caps->per_vector_masking_supported = true;
+        break;
 
     default:
         return ZX_ERR_INVALID_ARGS;
@@ -626,9 +929,12 @@ zx_status_t PcieDevice::SetIrqModeLocked(pcie_irq_mode_t mode, uint requested_ir
         LeaveMsiIrqMode();
         break;
 
-        // Right now, there should be no way to get into MSI-X mode
     case PCIE_IRQ_MODE_MSI_X:
-        return ZX_ERR_NOT_SUPPORTED;
+        DEBUG_ASSERT(irq_.msix);
+        DEBUG_ASSERT(irq_.msix->is_valid());
+        DEBUG_ASSERT(irq_.msix->irq_block_.allocated);
+        LeaveMsixIrqMode();
+        break;
 
     // If we're disabled we have no work to do besides some sanity checks
     case PCIE_IRQ_MODE_DISABLED:
@@ -644,6 +950,7 @@ zx_status_t PcieDevice::SetIrqModeLocked(pcie_irq_mode_t mode, uint requested_ir
     case PCIE_IRQ_MODE_DISABLED: return ZX_OK;
     case PCIE_IRQ_MODE_LEGACY: return EnterLegacyIrqMode(requested_irqs);
     case PCIE_IRQ_MODE_MSI:    return EnterMsiIrqMode   (requested_irqs);
+    case PCIE_IRQ_MODE_MSI_X:  return EnterMsixIrqMode  (requested_irqs);
     default:                   return ZX_ERR_NOT_SUPPORTED;
     }
 }
@@ -714,7 +1021,7 @@ zx_status_t PcieDevice::MaskUnmaskIrqLocked(uint irq_id, bool mask) {
     switch (irq_.mode) {
     case PCIE_IRQ_MODE_LEGACY: return MaskUnmaskLegacyIrq(mask);
     case PCIE_IRQ_MODE_MSI:    return MaskUnmaskMsiIrq(irq_id, mask);
-    case PCIE_IRQ_MODE_MSI_X:  return ZX_ERR_NOT_SUPPORTED;
+    case PCIE_IRQ_MODE_MSI_X:  return MaskUnmaskMsixIrq(irq_id, mask);
     default:
         DEBUG_ASSERT(false); /* This should be un-possible! */
         return ZX_ERR_INTERNAL;
@@ -723,6 +1030,29 @@ zx_status_t PcieDevice::MaskUnmaskIrqLocked(uint irq_id, bool mask) {
     return ZX_OK;
 }
 
+zx_status_t PcieDevice::SetIrqAffinityLocked(uint irq_id, cpu_num_t cpu) {
+    DEBUG_ASSERT(plugged_in_);
+    DEBUG_ASSERT(dev_lock_.IsHeld());
+
+    /* Cannot steer IRQs while in the DISABLED state */
+    if (irq_.mode == PCIE_IRQ_MODE_DISABLED)
+        return ZX_ERR_BAD_STATE;
+
+    /* Make sure that the IRQ ID is within range */
+    if (irq_id >= irq_.handler_count)
+        return ZX_ERR_INVALID_ARGS;
+
+    switch (irq_.mode) {
+    /* The legacy IRQ is shared with other devices, steering it is not ours to do */
+    case PCIE_IRQ_MODE_LEGACY: return ZX_ERR_NOT_SUPPORTED;
+    case PCIE_IRQ_MODE_MSI:    return SetMsiAffinity(cpu);
+    case PCIE_IRQ_MODE_MSI_X:  return SetMsixAffinity(irq_id, cpu);
+    default:
+        DEBUG_ASSERT(false); /* This should be un-possible! */
+        return ZX_ERR_INTERNAL;
+    }
+}
+
 /******************************************************************************
  *
  * Kernel API; prototypes in dev/pcie_irqs.h
@@ -775,6 +1105,14 @@ zx_status_t PcieDevice::MaskUnmaskIrq(uint irq_id, bool mask) {
         : ZX_ERR_BAD_STATE;
 }
 
+zx_status_t PcieDevice::SetIrqAffinity(uint irq_id, cpu_num_t cpu) {
+    AutoLock dev_lock(&dev_lock_);
+
+    return (plugged_in_ && !disabled_)
+        ? SetIrqAffinityLocked(irq_id, cpu)
+        : ZX_ERR_BAD_STATE;
+}
+
 
 // Map from a device's interrupt pin ID to the proper system IRQ ID.  Follow the
 // PCIe graph up to the root, swizzling as we traverse PCIe switches,
@@ -59,6 +59,10 @@ static zx_status_t default_get_config(unsigned int vector,
     return ZX_ERR_NOT_CONFIGURED;
 }
 
+static zx_status_t default_set_affinity(unsigned int vector, cpu_num_t cpu) {
+    return ZX_ERR_NOT_SUPPORTED;
+}
+
 static bool default_is_valid(unsigned int vector, uint32_t flags) {
     return false;
 }
@@ -107,6 +111,10 @@ static void default_msi_free_block(msi_block_t* block) {
 static void default_msi_register_handler(const msi_block_t* block, uint msi_id, int_handler handler, void* ctx) {
 }
 
+static zx_status_t default_msi_set_affinity(msi_block_t* block, cpu_num_t cpu) {
+    return ZX_ERR_NOT_SUPPORTED;
+}
+
 static void default_msi_mask_unmask(const msi_block_t* block, uint msi_id, bool mask) {
 }
 
@@ -126,6 +134,7 @@ static const struct pdev_interrupt_ops default_ops = {
     .unmask = default_unmask,
     .configure = default_configure,
     .get_config = default_get_config,
+    .set_affinity = default_set_affinity,
     .is_valid = default_is_valid,
     .get_base_vector = default_get_base_vector,
     .get_max_vector = default_get_max_vector,
@@ -143,6 +152,7 @@ static const struct pdev_interrupt_ops default_ops = {
     .msi_alloc_block = default_msi_alloc_block,
     .msi_free_block = default_msi_free_block,
     .msi_register_handler = default_msi_register_handler,
+    .msi_set_affinity = default_msi_set_affinity,
 };
 
 static const struct pdev_interrupt_ops* intr_ops = &default_ops;
@@ -165,6 +175,10 @@ zx_status_t get_interrupt_config(unsigned int vector, enum interrupt_trigger_mod
     return intr_ops->get_config(vector, tm, pol);
 }
 
+zx_status_t set_interrupt_affinity(unsigned int vector, cpu_num_t cpu) {
+    return intr_ops->set_affinity(vector, cpu);
+}
+
 uint32_t interrupt_get_base_vector() {
     return intr_ops->get_base_vector();
 }
@@ -239,4 +253,8 @@ void msi_register_handler(const msi_block_t* block, uint msi_id, int_handler han
     intr_ops->msi_register_handler(block, msi_id, handler, ctx);
 }
 
+zx_status_t msi_set_affinity(msi_block_t* block, cpu_num_t cpu) {
+    return intr_ops->msi_set_affinity(block, cpu);
+}
+
 LK_INIT_HOOK_FLAGS(interrupt_init_percpu_early, interrupt_init_percpu_early, LK_INIT_LEVEL_PLATFORM_EARLY, LK_INIT_FLAG_SECONDARY_CPUS);
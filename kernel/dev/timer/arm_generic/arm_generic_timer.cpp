@@ -226,6 +226,16 @@ zx_ticks_t current_ticks(void) {
     return read_ct();
 }
 
+bool ticks_to_time_factor(struct fp_32_64* ns_per_tick) {
+    // zx_ticks_get reads the virtual counter, which can be offset from
+    // the physical one.
+    if (reg_procs != &cntv_procs) {
+        return false;
+    }
+    *ns_per_tick = ns_per_cntpct;
+    return true;
+}
+
 zx_ticks_t ticks_per_second(void) {
     return u64_mul_u32_fp32_64(1000 * 1000 * 1000, cntpct_per_ns);
 }
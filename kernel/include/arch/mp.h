@@ -25,6 +25,11 @@ zx_status_t arch_mp_reschedule(cpu_mask_t mask);
  * thread lock. */
 void arch_prepare_current_cpu_idle_state(bool idle);
 
+/* Returns the mask of cpus that share a cache domain (die/cluster) with |cpu|,
+ * including |cpu| itself. Used by the scheduler to prefer cache-local work
+ * when stealing. Will be called under the thread lock. */
+cpu_mask_t arch_mp_cache_domain_mask(cpu_num_t cpu);
+
 /* Bring a CPU up and enter it into the scheduler */
 zx_status_t platform_mp_cpu_hotplug(cpu_num_t cpu_id);
 
@@ -44,6 +44,12 @@ void arch_clean_invalidate_cache_range(addr_t start, size_t len);
 void arch_invalidate_cache_range(addr_t start, size_t len);
 void arch_sync_cache_range(addr_t start, size_t len);
 
+/* The two halves of arch_sync_cache_range(), for syncing many ranges at once:
+ * clean the data cache over each range to the point of unification, then
+ * invalidate the whole instruction cache on every cpu once. */
+void arch_clean_cache_range_pou(addr_t start, size_t len);
+void arch_invalidate_icache_all(void);
+
 /* Used to suspend work on a CPU until it is further shutdown.
  * This will only be invoked with interrupts disabled.  This function
  * must not re-enter the scheduler.
@@ -15,6 +15,11 @@ __BEGIN_CDECLS
 
 #define DPC_THREAD_PRIORITY HIGH_PRIORITY
 
+// dpc priority levels. every queued latency-sensitive dpc runs before the next bulk one.
+#define DPC_PRIORITY_LATENCY 0
+#define DPC_PRIORITY_BULK 1
+#define DPC_PRIORITY_COUNT 2
+
 struct dpc;
 typedef void (*dpc_func_t)(struct dpc*);
 
@@ -23,6 +28,9 @@ typedef struct dpc {
 
     dpc_func_t func;
     void* arg;
+
+    // when the dpc was queued, for latency accounting; owned by the dpc code
+    zx_time_t queued_time;
 } dpc_t;
 
 #define DPC_INITIAL_VALUE                   \
@@ -30,6 +38,7 @@ typedef struct dpc {
         .node = LIST_INITIAL_CLEARED_VALUE, \
         .func = 0,                          \
         .arg = 0,                           \
+        .queued_time = 0,                   \
     }
 
 // initializes dpc for the current cpu
@@ -37,9 +46,16 @@ void dpc_init_for_cpu(void);
 
 // queue an already filled out dpc, optionally reschedule immediately to run the dpc thread.
 // the deferred procedure runs in a dedicated thread that runs at DPC_THREAD_PRIORITY
+//
+// the dpc thread is only woken when its queues were empty; dpcs queued while it is already
+// pending are picked up by the same wakeup.
 zx_status_t dpc_queue(dpc_t* dpc, bool reschedule);
 
-// queue a dpc, but must be holding the thread lock
+// queue a dpc at the given DPC_PRIORITY_* level. dpc_queue() queues at DPC_PRIORITY_LATENCY;
+// DPC_PRIORITY_BULK is for work which may wait behind any latency-sensitive dpcs.
+zx_status_t dpc_queue_priority(dpc_t* dpc, uint priority, bool reschedule);
+
+// queue a latency-sensitive dpc, but must be holding the thread lock
 // does not force a reschedule
 zx_status_t dpc_queue_thread_locked(dpc_t* dpc) TA_REQ(thread_lock);
 
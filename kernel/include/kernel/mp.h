@@ -87,6 +87,8 @@ struct mp_state {
     volatile cpu_mask_t online_cpus;
     // cpus that are currently schedulable
     volatile cpu_mask_t active_cpus;
+    // cpus which have been asked to reschedule and have not yet done so
+    volatile cpu_mask_t resched_pending_cpus;
 
     // both are only safely accessible with thread lock held
     cpu_mask_t idle_cpus TA_GUARDED(thread_lock);
@@ -163,6 +165,12 @@ static inline void mp_set_curr_cpu_active(bool active) {
     }
 }
 
+// called by the scheduler when the current cpu reschedules, which satisfies
+// every reschedule request made of it so far
+static inline void mp_clear_curr_cpu_resched_pending(void) {
+    atomic_and((volatile int*)&mp.resched_pending_cpus, ~cpu_num_to_mask(arch_curr_cpu_num()));
+}
+
 static inline cpu_mask_t mp_get_active_mask(void) {
     return atomic_load((volatile int*)&mp.active_cpus);
 }
@@ -7,6 +7,7 @@
 
 #include <arch/ops.h>
 #include <kernel/align.h>
+#include <kernel/dpc.h>
 #include <kernel/event.h>
 #include <kernel/stats.h>
 #include <kernel/thread.h>
@@ -18,9 +19,6 @@
 __BEGIN_CDECLS
 
 struct percpu {
-    // per cpu timer queue
-    struct list_node timer_queue;
-
     // per cpu preemption timer; ZX_TIME_INFINITE means not set
     zx_time_t preempt_timer_deadline;
 
@@ -30,6 +28,18 @@ struct percpu {
     // per cpu run queue and bitmap to indicate which queues are non empty
     struct list_node run_queue[NUM_PRIORITIES];
     uint32_t run_queue_bitmap;
+    // number of threads sitting in the run queues, used to pick a victim when stealing
+    uint32_t run_queue_count;
+
+    // ready deadline threads with budget left, earliest deadline first, and the ones that
+    // used up their budget and wait for their next period
+    struct list_node deadline_run_queue;
+    struct list_node deadline_throttled;
+    // starts the next period of the earliest throttled thread; ZX_TIME_INFINITE means not set
+    timer_t deadline_timer;
+    zx_time_t deadline_timer_deadline;
+    // share of this cpu reserved by deadline threads, in parts per million
+    uint32_t deadline_utilization;
 
 #if WITH_LOCK_DEP
     // state for runtime lock validation when in irq context
@@ -39,14 +49,27 @@ struct percpu {
     // thread/cpu level statistics
     struct cpu_stats stats;
 
+    // time threads spent in this cpu's run queue before running on it, guarded by thread_lock
+    struct sched_wait_stats run_queue_wait;
+
+    // bumped each time this cpu passes through an rcu quiescent state; see kernel/rcu.h
+    volatile uint64_t rcu_quiescent_count;
+
     // per cpu idle thread
     thread_t idle_thread;
 
     // kernel counters arena
     int64_t* counters;
 
-    // dpc context
-    list_node_t dpc_list;
+    // dpc context, guarded by dpc_lock
+    // one queue per DPC_PRIORITY_* level
+    list_node_t dpc_list[DPC_PRIORITY_COUNT];
+    // number of dpcs queued in all the levels, and the most there have been
+    uint32_t dpc_depth;
+    uint32_t dpc_max_depth;
+    // time dpcs spent queued before they ran
+    struct sched_wait_stats dpc_wait;
+    // signaled while any dpc is queued
     event_t dpc_event;
     // request the dpc thread to stop by setting to true; guarded by dpc_lock
     bool dpc_stop;
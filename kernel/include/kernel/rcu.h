@@ -0,0 +1,174 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+#pragma once
+
+#include <kernel/atomic.h>
+#include <kernel/percpu.h>
+#include <kernel/thread.h>
+#include <zircon/compiler.h>
+
+// Deferred reclamation for read-mostly data structures (RCU).
+//
+// Readers walk the data structure between rcu_read_lock() and
+// rcu_read_unlock() without taking any locks.  Writers, which still
+// serialize among themselves, unpublish an object and then hand it to
+// rcu_call() (or wait in rcu_synchronize()) instead of freeing it at once.
+// The object is freed once every cpu has passed through a quiescent state:
+// a point at which it cannot be inside a read-side critical section.
+//
+// Read-side critical sections run with preemption disabled, so every
+// reschedule is a quiescent state for its cpu, and so is being idle.  A
+// grace period therefore takes about as long as the longest stretch any
+// cpu runs without rescheduling, which is bounded by the time slice for
+// everything but real-time threads.
+//
+// Read-side critical sections must not block, and must not be entered
+// from interrupt handlers.
+
+__BEGIN_CDECLS
+
+struct rcu_head;
+typedef void (*rcu_callback_t)(struct rcu_head*);
+
+// Embed an rcu_head in an object to pass it to rcu_call().
+struct rcu_head {
+    struct rcu_head* next;
+    rcu_callback_t func;
+};
+
+// Begins a read-side critical section.  These may nest.
+static inline void rcu_read_lock(void) {
+    thread_preempt_disable();
+}
+
+// Ends a read-side critical section.  Pointers read in the section may
+// not be used after this.
+static inline void rcu_read_unlock(void) {
+    thread_preempt_reenable();
+}
+
+// Calls |func| on |head| on the rcu thread once all read-side critical
+// sections which are in progress now have finished.  |head| must stay
+// untouched until then.
+//
+// This may be called from any thread context, including with preemption
+// disabled, but not while holding the thread lock or from an interrupt
+// handler.
+void rcu_call(struct rcu_head* head, rcu_callback_t func);
+
+// Waits until all read-side critical sections which are in progress now
+// have finished.  Must not be called from a read-side critical section.
+void rcu_synchronize(void);
+
+// Called by the scheduler whenever |cpu| passes through a quiescent
+// state.
+static inline void rcu_note_quiescent_state(cpu_num_t cpu) {
+    // Orders the reads of the critical sections before this with the rcu
+    // thread seeing the new count.
+    atomic_add_u64(&percpu[cpu].rcu_quiescent_count, 1);
+}
+
+__END_CDECLS
+
+#ifdef __cplusplus
+
+#include <fbl/alloc_checker.h>
+#include <fbl/atomic.h>
+#include <fbl/macros.h>
+#include <fbl/ref_ptr.h>
+
+// RAII wrapper for rcu_read_lock() and rcu_read_unlock().
+class AutoRcuReadLock {
+public:
+    AutoRcuReadLock() { rcu_read_lock(); }
+    ~AutoRcuReadLock() { rcu_read_unlock(); }
+
+    DISALLOW_COPY_ASSIGN_AND_MOVE(AutoRcuReadLock);
+};
+
+// Drops |ptr|'s reference once all read-side critical sections which are
+// in progress now have finished.  Falls back to waiting in
+// rcu_synchronize() if it is out of memory, so it may block.
+template <typename T>
+void rcu_release(fbl::RefPtr<T> ptr) {
+    struct Deferred {
+        explicit Deferred(fbl::RefPtr<T> ptr)
+            : ptr(fbl::move(ptr)) {}
+
+        static void Release(rcu_head* head) {
+            delete containerof(head, Deferred, head);
+        }
+
+        rcu_head head = {};
+        fbl::RefPtr<T> ptr;
+    };
+
+    if (ptr == nullptr) {
+        return;
+    }
+    fbl::AllocChecker ac;
+    Deferred* deferred = new (&ac) Deferred(fbl::move(ptr));
+    if (!ac.check()) {
+        // |ptr| was not moved from.
+        rcu_synchronize();
+        return;
+    }
+    rcu_call(&deferred->head, &Deferred::Release);
+}
+
+// RcuPtr<T> is a fbl::RefPtr<T> which readers may load without taking a
+// lock, inside a read-side critical section:
+//
+//     AutoRcuReadLock rcu;
+//     Foo* foo = foo_ptr_.Get();
+//     if (foo != nullptr) {
+//         // |foo| stays alive until the end of the critical section.
+//     }
+//
+// The pointer holds a reference to its object.  When a writer replaces
+// or clears it, that reference is dropped with rcu_release(), so readers
+// which still see the old object never see it destroyed.  Writers must
+// serialize among themselves.
+template <typename T>
+class RcuPtr {
+public:
+    constexpr RcuPtr() {}
+    explicit RcuPtr(fbl::RefPtr<T> ptr) { Publish(fbl::move(ptr)); }
+    ~RcuPtr() { Publish(nullptr); }
+
+    // Returns the current object, or nullptr.  Must be called inside a
+    // read-side critical section, outside of which the object must not be
+    // used without taking a reference with Ref().
+    T* Get() const {
+        DEBUG_ASSERT(thread_preempt_disable_count() > 0);
+        return ptr_.load(fbl::memory_order_acquire);
+    }
+
+    // Returns a new reference to the current object.  This may be called
+    // anywhere.
+    fbl::RefPtr<T> Ref() const {
+        AutoRcuReadLock rcu;
+        return fbl::RefPtr<T>(ptr_.load(fbl::memory_order_acquire));
+    }
+
+    // Replaces the current object with |ptr|.  The old object's reference
+    // is dropped after a grace period.  Must not be called from a
+    // read-side critical section.
+    void Publish(fbl::RefPtr<T> ptr) {
+        T* old = ptr_.exchange(ptr.leak_ref(), fbl::memory_order_acq_rel);
+        if (old != nullptr) {
+            // Adopts the reference which |ptr_| held.
+            rcu_release(fbl::internal::MakeRefPtrNoAdopt(old));
+        }
+    }
+
+    DISALLOW_COPY_ASSIGN_AND_MOVE(RcuPtr);
+
+private:
+    fbl::atomic<T*> ptr_{nullptr};
+};
+
+#endif // __cplusplus
@@ -30,6 +30,12 @@ void sched_migrate(thread_t* t) TA_REQ(thread_lock);
 // pri should be <= MAX_PRIORITY, negative values disable priority inheritance.
 void sched_inherit_priority(thread_t* t, int pri, bool* local_resched) TA_REQ(thread_lock);
 
+// account for a thread of priority |pri| blocking on a priority-inheriting futex owned
+// by |t|, and for it going away. |t| runs at least at the highest such priority until
+// all of these waiters are gone.
+void sched_futex_pi_block(thread_t* t, int pri, bool* local_resched) TA_REQ(thread_lock);
+void sched_futex_pi_unblock(thread_t* t, bool* local_resched) TA_REQ(thread_lock);
+
 // set the priority of a thread and reset the boost value. This function might reschedule.
 // pri should be 0 <= to <= MAX_PRIORITY.
 void sched_change_priority(thread_t* t, int pri) TA_REQ(thread_lock);
@@ -41,9 +47,19 @@ bool sched_unblock_list(struct list_node* list) __WARN_UNUSED_RESULT TA_REQ(thre
 
 void sched_transition_off_cpu(cpu_num_t old_cpu) TA_REQ(thread_lock);
 
+// give |t| a reservation of |capacity| every |period|, to be delivered within |relative_deadline|
+// of the period's start, or drop its reservation if |period| is zero. returns ZX_ERR_NO_RESOURCES
+// if no cpu in |t|'s affinity mask has enough unreserved time. This function might reschedule.
+zx_status_t sched_set_deadline(thread_t* t, zx_duration_t capacity,
+                               zx_duration_t relative_deadline, zx_duration_t period)
+    TA_REQ(thread_lock);
+
 // sched_preempt_timer_tick is called when the preemption timer for a CPU has fired.
 //
 // This function is logically private and should only be called by timer.cpp.
 void sched_preempt_timer_tick(zx_time_t now);
 
+// adds one wait of |wait| to the totals and histogram in |s|.
+void sched_wait_stats_add(struct sched_wait_stats* s, zx_duration_t wait);
+
 __END_CDECLS
@@ -78,6 +78,18 @@ typedef struct lockdep_state {
     uint8_t last_result;
 } lockdep_state_t;
 
+// number of buckets in a run queue wait histogram, see sched_wait_stats
+#define SCHED_WAIT_BUCKETS 16
+
+// time spent ready to run but waiting for a cpu. bucket 0 of the histogram counts waits
+// under 1024ns; bucket i counts waits in [2^(9+i), 2^(10+i)) ns and the last one also
+// counts anything longer.
+struct sched_wait_stats {
+    zx_duration_t total;
+    zx_duration_t max;
+    uint64_t histogram[SCHED_WAIT_BUCKETS];
+};
+
 typedef struct thread {
     int magic;
     struct list_node thread_list_node;
@@ -95,6 +107,13 @@ typedef struct thread {
     // left the scheduler.
     zx_duration_t runtime_ns;
 
+    // scheduler statistics, see thread_get_sched_stats(). ready_since is when the thread
+    // last entered a run queue, or 0 if it is not waiting in one.
+    zx_time_t ready_since;
+    struct sched_wait_stats run_queue_wait;
+    uint64_t context_switches;
+    uint64_t preemptions;
+
     // priority: in the range of [MIN_PRIORITY, MAX_PRIORITY], from low to high.
     // base_priority is set at creation time, and can be tuned with thread_set_priority().
     // priority_boost is a signed value that is moved around within a range by the scheduler.
@@ -107,6 +126,12 @@ typedef struct thread {
     int priority_boost;
     int inherited_priority;
 
+    // priority inherited from threads blocked on priority-inheriting futexes owned by this
+    // thread, -1 if none, and the number of such threads. kept apart from inherited_priority
+    // so that releasing kernel mutexes does not drop it.
+    int futex_pi_priority;
+    int futex_pi_waiters;
+
     // current cpu the thread is either running on or in the ready queue, undefined otherwise
     cpu_num_t curr_cpu;
     cpu_num_t last_cpu;      // last cpu the thread ran on, INVALID_CPU if it's never run
@@ -124,6 +149,34 @@ typedef struct thread {
     // are we allowed to be interrupted on the current thing we're blocked/sleeping on
     bool interruptable;
 
+    // how late the timeout of a block or sleep of this thread may fire, so that it can be
+    // coalesced with other timers. see thread_set_timer_slack().
+    zx_duration_t timer_slack;
+
+    // deadline scheduling parameters and state, see sched_set_deadline(). a period of
+    // zero means the thread is scheduled by priority alone.
+    struct {
+        zx_duration_t capacity;
+        zx_duration_t relative_deadline;
+        zx_duration_t period;
+        // share of |cpu| reserved by this thread, in parts per million
+        uint32_t utilization;
+        cpu_num_t cpu;
+        // the current period and what is left of its budget
+        zx_time_t period_start;
+        zx_time_t abs_deadline;
+        zx_duration_t budget;
+        // the budget has been charged for running up to this time
+        zx_time_t charged_until;
+        // set once a miss has been counted for the current period
+        bool missed;
+    } sched_deadline;
+
+    // if set, the next thread this thread wakes is run on the current cpu, since this
+    // thread is about to block waiting on it. only touched by the thread itself.
+    // see AutoSchedHandoff.
+    bool sched_handoff;
+
     // number of mutexes we currently hold
     int mutexes_held;
 
@@ -232,6 +285,11 @@ void thread_construct_first(thread_t* t, const char* name);
 thread_t* thread_create_idle_thread(uint cpu_num);
 void thread_set_name(const char* name);
 void thread_set_priority(thread_t* t, int priority);
+void thread_futex_pi_block(thread_t* owner, int priority);
+void thread_futex_pi_unblock(thread_t* owner);
+void thread_set_timer_slack(thread_t* t, zx_duration_t slack);
+zx_status_t thread_set_deadline(thread_t* t, zx_duration_t capacity,
+                                zx_duration_t relative_deadline, zx_duration_t period);
 void thread_set_user_callback(thread_t* t, thread_user_callback_t cb);
 thread_t* thread_create(const char* name, thread_start_routine entry, void* arg, int priority);
 thread_t* thread_create_etc(thread_t* t, const char* name, thread_start_routine entry, void* arg,
@@ -295,6 +353,11 @@ zx_status_t thread_sleep_relative(zx_duration_t delay);
 // return the number of nanoseconds a thread has been running for
 zx_duration_t thread_runtime(const thread_t* t);
 
+// copy out a thread's run queue wait statistics and context switch and preemption counts.
+// a wait that is still in progress is not included.
+void thread_get_sched_stats(const thread_t* t, struct sched_wait_stats* wait,
+                            uint64_t* context_switches, uint64_t* preemptions);
+
 // deliver a kill signal to a thread
 void thread_kill(thread_t* t);
 
@@ -322,6 +385,10 @@ static inline bool thread_is_realtime(thread_t* t) {
     return (t->flags & THREAD_FLAG_REAL_TIME) && t->base_priority > DEFAULT_PRIORITY;
 }
 
+static inline bool thread_is_deadline(const thread_t* t) {
+    return t->sched_deadline.period != 0;
+}
+
 static inline bool thread_is_idle(thread_t* t) {
     return !!(t->flags & THREAD_FLAG_IDLE);
 }
@@ -526,4 +593,22 @@ private:
     bool started_ = false;
 };
 
+// AutoSchedHandoff is an RAII helper telling the scheduler that the
+// current thread is about to block until the next thread it wakes has
+// done some work, as in a channel call waking the server which will
+// eventually wake us with the reply.
+//
+// Instead of sending the woken thread to another (possibly idle) cpu,
+// the scheduler then puts it at the front of the current cpu's run
+// queue so that it runs as soon as we block on it, while its working
+// set is still hot in our caches.  Only the first thread woken within
+// the scope is affected, and only when it is allowed on this cpu.
+class AutoSchedHandoff {
+public:
+    AutoSchedHandoff() { get_current_thread()->sched_handoff = true; }
+    ~AutoSchedHandoff() { get_current_thread()->sched_handoff = false; }
+
+    DISALLOW_COPY_ASSIGN_AND_MOVE(AutoSchedHandoff);
+};
+
 #endif // __cplusplus
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <fbl/intrusive_wavl_tree.h>
 #include <kernel/spinlock.h>
 #include <list.h>
 #include <sys/types.h>
@@ -30,7 +31,9 @@ enum slack_mode {
 
 typedef struct timer {
     int magic;
-    struct list_node node;
+    // node in the timer queue of |queue_cpu|, which is ordered by scheduled_time.
+    fbl::WAVLTreeNodeState<struct timer*> node;
+    int queue_cpu;
 
     zx_time_t scheduled_time;
     zx_duration_t slack; // Stores the applied slack adjustment from
@@ -45,7 +48,8 @@ typedef struct timer {
 #define TIMER_INITIAL_VALUE(t)              \
     {                                       \
         .magic = TIMER_MAGIC,               \
-        .node = LIST_INITIAL_CLEARED_VALUE, \
+        .node = {},                         \
+        .queue_cpu = -1,                    \
         .scheduled_time = 0,                \
         .slack = 0,                         \
         .callback = NULL,                   \
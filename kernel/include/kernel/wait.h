@@ -26,6 +26,8 @@ extern spin_lock_t thread_lock;
 typedef struct wait_queue {
     int magic;
     int count;
+    // bit n is set while any thread of priority n is queued
+    uint32_t priority_bitmap;
     struct list_node heads;
 } wait_queue_t;
 
@@ -33,6 +35,7 @@ typedef struct wait_queue {
     {                                           \
         .magic = WAIT_QUEUE_MAGIC,              \
         .count = 0,                             \
+        .priority_bitmap = 0,                   \
         .heads = LIST_INITIAL_VALUE((q).heads), \
     }
 
@@ -20,8 +20,9 @@ __BEGIN_CDECLS
 //   - after N seconds how many outstanding <x> things are allocated?
 //   - up to this point has <Y> ever happened?
 //
-// Currently the only query interface to the counters is the console
-// k counters command. Issue 'k counters help' to learn what it can do.
+// The counters can be queried with the console k counters command. Issue
+// 'k counters help' to learn what it can do. They are also published to
+// userspace as read-only VMOs; see lib/zircon-internal/kcounters.h.
 //
 // Kernel counters public API:
 // 1- define a new counter.
@@ -94,3 +95,18 @@ static inline void kcounter_add(const struct k_counter_desc* var,
 }
 
 __END_CDECLS
+
+#ifdef __cplusplus
+
+#include <fbl/ref_ptr.h>
+#include <zircon/types.h>
+
+class VmObject;
+
+// Returns the VMOs that publish the counters to userspace: the
+// descriptors, and the live arena, whose pages are those of the kernel's
+// own counters.  Both are created on the first call.
+zx_status_t kcounters_get_vmos(fbl::RefPtr<VmObject>* desc_vmo,
+                               fbl::RefPtr<VmObject>* arena_vmo);
+
+#endif // __cplusplus
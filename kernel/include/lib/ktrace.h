@@ -66,6 +66,12 @@ static inline void ktrace_name(uint32_t tag, uint32_t id, uint32_t arg, const ch
     ktrace_name_etc(tag, id, arg, name, false);
 }
 
+// Records the start (KTRACE_BOOT_BEGIN) or end (KTRACE_BOOT_END) of a step of
+// booting, as the probe "boot:|category|:|name|". |category| and |name| must be
+// static strings: spans recorded before ktrace is initialized keep pointers to
+// them until they can be written into the trace.
+void ktrace_boot_span(const char* category, const char* name, uint32_t phase, uint32_t arg);
+
 ssize_t ktrace_read_user(void* ptr, uint32_t off, size_t len);
 zx_status_t ktrace_control(uint32_t action, uint32_t options, void* ptr);
 
@@ -76,4 +76,16 @@ struct lk_init_struct {
 #define LK_INIT_HOOK(_name, _hook, _level) \
     LK_INIT_HOOK_FLAGS(_name, _hook, _level, LK_INIT_FLAG_PRIMARY_CPU)
 
+/*
+ * For init hooks with work that is slow and splits into independent
+ * pieces, such as setting up the page arrays of large memory arenas.
+ * Calls |fn(index, arg)| for every index in [0, count), spread over one
+ * thread for each online cpu including the caller's, and returns once all
+ * of them are done. Must be called from a thread; before the secondary
+ * cpus are online it runs everything on the calling one.
+ */
+typedef void (*lk_init_parallel_fn)(size_t index, void *arg);
+
+void lk_init_parallel(const char *name, size_t count, lk_init_parallel_fn fn, void *arg);
+
 __END_CDECLS
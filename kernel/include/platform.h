@@ -38,6 +38,12 @@ zx_ticks_t ticks_per_second(void);
 /* high-precision timer current_ticks */
 zx_ticks_t current_ticks(void);
 
+/* if current_time() is current_ticks() scaled by a fixed factor, and user
+ * mode reads the same counter for zx_ticks_get, store the factor in
+ * ns_per_tick and return true */
+struct fp_32_64;
+bool ticks_to_time_factor(struct fp_32_64* ns_per_tick);
+
 /* super early platform initialization, before almost everything */
 void platform_early_init(void);
 
@@ -6,20 +6,55 @@
 
 #include <assert.h>
 #include <err.h>
+#include <inttypes.h>
 #include <list.h>
 #include <trace.h>
 
 #include <kernel/dpc.h>
 #include <kernel/event.h>
 #include <kernel/percpu.h>
+#include <kernel/sched.h>
 #include <kernel/spinlock.h>
+#include <lib/console.h>
+#include <lib/counters.h>
 #include <lk/init.h>
+#include <platform.h>
+#include <zircon/time.h>
+
+KCOUNTER(dpc_queued, "kernel.dpc.queued");
+KCOUNTER(dpc_wakeups, "kernel.dpc.wakeups");
 
 static spin_lock_t dpc_lock = SPIN_LOCK_INITIAL_VALUE;
 
+// puts |dpc| at the tail of |cpu|'s queue for |priority|, with dpc_lock held.
+// returns whether the worker needs signaling: it does only when nothing was queued,
+// since otherwise the event is still signaled and the worker drains this dpc along
+// with the rest.
+static bool dpc_enqueue_locked(struct percpu* cpu, dpc_t* dpc, uint priority) {
+    bool was_empty = (cpu->dpc_depth == 0);
+
+    dpc->queued_time = current_time();
+    list_add_tail(&cpu->dpc_list[priority], &dpc->node);
+    cpu->dpc_depth++;
+    if (cpu->dpc_depth > cpu->dpc_max_depth) {
+        cpu->dpc_max_depth = cpu->dpc_depth;
+    }
+
+    kcounter_add(dpc_queued, 1);
+    if (was_empty) {
+        kcounter_add(dpc_wakeups, 1);
+    }
+    return was_empty;
+}
+
 zx_status_t dpc_queue(dpc_t* dpc, bool reschedule) {
+    return dpc_queue_priority(dpc, DPC_PRIORITY_LATENCY, reschedule);
+}
+
+zx_status_t dpc_queue_priority(dpc_t* dpc, uint priority, bool reschedule) {
     DEBUG_ASSERT(dpc);
     DEBUG_ASSERT(dpc->func);
+    DEBUG_ASSERT(priority < DPC_PRIORITY_COUNT);
 
     // disable interrupts before finding lock
     spin_lock_saved_state_t state;
@@ -32,12 +67,14 @@ zx_status_t dpc_queue(dpc_t* dpc, bool reschedule) {
 
     struct percpu* cpu = get_local_percpu();
 
-    // put the dpc at the tail of the list and signal the worker
-    list_add_tail(&cpu->dpc_list, &dpc->node);
+    // put the dpc at the tail of the list and signal the worker if it is not already
+    bool signal = dpc_enqueue_locked(cpu, dpc, priority);
 
     spin_unlock_irqrestore(&dpc_lock, state);
 
-    event_signal(&cpu->dpc_event, reschedule);
+    if (signal) {
+        event_signal(&cpu->dpc_event, reschedule);
+    }
 
     return ZX_OK;
 }
@@ -56,9 +93,10 @@ zx_status_t dpc_queue_thread_locked(dpc_t* dpc) {
 
     struct percpu* cpu = get_local_percpu();
 
-    // put the dpc at the tail of the list and signal the worker
-    list_add_tail(&cpu->dpc_list, &dpc->node);
-    event_signal_thread_locked(&cpu->dpc_event);
+    // put the dpc at the tail of the list and signal the worker if it is not already
+    if (dpc_enqueue_locked(cpu, dpc, DPC_PRIORITY_LATENCY)) {
+        event_signal_thread_locked(&cpu->dpc_event);
+    }
 
     spin_unlock(&dpc_lock);
 
@@ -105,20 +143,32 @@ void dpc_shutdown_transition_off_cpu(uint cpu_id) {
     DEBUG_ASSERT(percpu[cpu_id].dpc_stop);
     DEBUG_ASSERT(percpu[cpu_id].dpc_thread == nullptr);
 
-    list_node_t* src_list = &percpu[cpu_id].dpc_list;
-    list_node_t* dst_list = &percpu[cur_cpu].dpc_list;
+    struct percpu* src = &percpu[cpu_id];
+    struct percpu* dst = &percpu[cur_cpu];
+    bool signal = (dst->dpc_depth == 0 && src->dpc_depth != 0);
 
-    dpc_t* dpc;
-    while ((dpc = list_remove_head_type(src_list, dpc_t, node))) {
-        list_add_tail(dst_list, &dpc->node);
+    for (uint priority = 0; priority < DPC_PRIORITY_COUNT; priority++) {
+        dpc_t* dpc;
+        while ((dpc = list_remove_head_type(&src->dpc_list[priority], dpc_t, node))) {
+            list_add_tail(&dst->dpc_list[priority], &dpc->node);
+        }
+        DEBUG_ASSERT(list_is_empty(&src->dpc_list[priority]));
+    }
+    dst->dpc_depth += src->dpc_depth;
+    if (dst->dpc_depth > dst->dpc_max_depth) {
+        dst->dpc_max_depth = dst->dpc_depth;
     }
+    src->dpc_depth = 0;
 
     // Reset the state so we can restart DPC processing if the CPU comes back online.
-    DEBUG_ASSERT(list_is_empty(&percpu[cpu_id].dpc_list));
-    percpu[cpu_id].dpc_stop = false;
-    event_destroy(&percpu[cpu_id].dpc_event);
+    src->dpc_stop = false;
+    event_destroy(&src->dpc_event);
 
     spin_unlock_irqrestore(&dpc_lock, state);
+
+    if (signal) {
+        event_signal(&dst->dpc_event, false);
+    }
 }
 
 static int dpc_thread(void* arg) {
@@ -129,12 +179,12 @@ static int dpc_thread(void* arg) {
 
     struct percpu* cpu = get_local_percpu();
     event_t* event = &cpu->dpc_event;
-    list_node_t* list = &cpu->dpc_list;
 
     arch_interrupt_restore(state, SPIN_LOCK_FLAG_INTERRUPTS);
 
     for (;;) {
-        // wait for a dpc to fire
+        // wait for a dpc to fire. the event stays signaled until every queue is empty, so a
+        // single wakeup drains everything queued in the meantime.
         __UNUSED zx_status_t err = event_wait(event);
         DEBUG_ASSERT(err == ZX_OK);
 
@@ -145,14 +195,21 @@ static int dpc_thread(void* arg) {
             return 0;
         }
 
-        // pop a dpc off the list, make a local copy.
-        dpc_t* dpc = list_remove_head_type(list, dpc_t, node);
+        // pop a dpc off the highest priority list that has one, make a local copy.
+        dpc_t* dpc = nullptr;
+        for (uint priority = 0; priority < DPC_PRIORITY_COUNT && !dpc; priority++) {
+            dpc = list_remove_head_type(&cpu->dpc_list[priority], dpc_t, node);
+        }
 
-        // if the list is now empty, unsignal the event so we block until it is
+        // if the lists are now empty, unsignal the event so we block until they are not
         if (!dpc) {
+            DEBUG_ASSERT(cpu->dpc_depth == 0);
             event_unsignal(event);
             dpc_local.func = NULL;
         } else {
+            cpu->dpc_depth--;
+            sched_wait_stats_add(&cpu->dpc_wait, zx_time_sub_time(current_time(),
+                                                                  dpc->queued_time));
             dpc_local = *dpc;
         }
 
@@ -176,7 +233,10 @@ void dpc_init_for_cpu(void) {
         return;
     }
 
-    list_initialize(&cpu->dpc_list);
+    for (uint priority = 0; priority < DPC_PRIORITY_COUNT; priority++) {
+        list_initialize(&cpu->dpc_list[priority]);
+    }
+    cpu->dpc_depth = 0;
     event_init(&cpu->dpc_event, false, 0);
     cpu->dpc_stop = false;
 
@@ -193,3 +253,28 @@ static void dpc_init(unsigned int level) {
 }
 
 LK_INIT_HOOK(dpc, dpc_init, LK_INIT_LEVEL_THREADING);
+
+static int cmd_dpc(int argc, const cmd_args* argv, uint32_t flags) {
+    for (cpu_num_t i = 0; i < arch_max_num_cpus(); i++) {
+        spin_lock_saved_state_t state;
+        spin_lock_irqsave(&dpc_lock, state);
+        uint32_t depth = percpu[i].dpc_depth;
+        uint32_t max_depth = percpu[i].dpc_max_depth;
+        struct sched_wait_stats wait = percpu[i].dpc_wait;
+        spin_unlock_irqrestore(&dpc_lock, state);
+
+        uint64_t count = 0;
+        for (uint b = 0; b < SCHED_WAIT_BUCKETS; b++) {
+            count += wait.histogram[b];
+        }
+        printf("cpu %u: depth %u max %u ran %" PRIu64 " avg latency %" PRIi64
+               " ns max %" PRIi64 " ns\n",
+               i, depth, max_depth, count, count ? wait.total / (zx_duration_t)count : 0,
+               wait.max);
+    }
+    return ZX_OK;
+}
+
+STATIC_COMMAND_START
+STATIC_COMMAND("dpc", "dpc queue depth and latency per cpu", &cmd_dpc)
+STATIC_COMMAND_END(dpc);
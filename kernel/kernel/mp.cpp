@@ -24,6 +24,7 @@
 #include <kernel/spinlock.h>
 #include <kernel/stats.h>
 #include <kernel/timer.h>
+#include <lib/counters.h>
 #include <lk/init.h>
 #include <platform.h>
 #include <platform/timer.h>
@@ -33,6 +34,8 @@
 
 #define LOCAL_TRACE 0
 
+KCOUNTER(resched_coalesced, "kernel.mp.resched.coalesced");
+
 // a global state structure, aligned on cpu cache line to minimize aliasing
 struct mp_state mp __CPU_ALIGN_EXCLUSIVE;
 
@@ -77,6 +80,18 @@ void mp_reschedule(cpu_mask_t mask, uint flags) {
         return;
     }
 
+    // a cpu which was already asked to reschedule, and has not done so yet,
+    // will pick up the new work when it does, so it needs no second IPI or
+    // monitor write.  the bits are cleared by each cpu as it reschedules.
+    const cpu_mask_t pending = atomic_or((volatile int*)&mp.resched_pending_cpus, mask);
+    if (pending & mask) {
+        kcounter_add(resched_coalesced, __builtin_popcount(pending & mask));
+        mask &= ~pending;
+        if (mask == 0) {
+            return;
+        }
+    }
+
     arch_mp_reschedule(mask);
 }
 
@@ -419,6 +434,9 @@ void mp_mbx_reschedule_irq(void*) {
 
     if (mp.active_cpus & cpu_num_to_mask(cpu)) {
         thread_preempt_set_pending();
+    } else {
+        // no reschedule is coming, so let the next request through
+        mp_clear_curr_cpu_resched_pending();
     }
 }
 
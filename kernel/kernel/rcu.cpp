@@ -0,0 +1,151 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <kernel/rcu.h>
+
+#include <assert.h>
+#include <debug.h>
+#include <kernel/event.h>
+#include <kernel/mp.h>
+#include <kernel/percpu.h>
+#include <kernel/spinlock.h>
+#include <kernel/thread.h>
+#include <kernel/thread_lock.h>
+#include <lib/counters.h>
+#include <lk/init.h>
+#include <zircon/time.h>
+
+// How often the rcu thread checks whether a grace period has finished.
+#define RCU_POLL_INTERVAL ZX_MSEC(1)
+
+KCOUNTER(rcu_grace_periods, "kernel.rcu.grace_periods");
+KCOUNTER(rcu_callbacks, "kernel.rcu.callbacks");
+
+static spin_lock_t rcu_lock = SPIN_LOCK_INITIAL_VALUE;
+
+// callbacks waiting for the next grace period to start; guarded by rcu_lock
+static struct rcu_head* rcu_pending_head;
+static struct rcu_head** rcu_pending_tail = &rcu_pending_head;
+
+// signaled while there are pending callbacks
+static event_t rcu_event = EVENT_INITIAL_VALUE(rcu_event, false, 0);
+
+void rcu_call(struct rcu_head* head, rcu_callback_t func) {
+    DEBUG_ASSERT(head);
+    DEBUG_ASSERT(func);
+    DEBUG_ASSERT(!arch_blocking_disallowed());
+
+    head->next = nullptr;
+    head->func = func;
+
+    spin_lock_saved_state_t state;
+    spin_lock_irqsave(&rcu_lock, state);
+    *rcu_pending_tail = head;
+    rcu_pending_tail = &head->next;
+    spin_unlock_irqrestore(&rcu_lock, state);
+
+    event_signal(&rcu_event, false);
+}
+
+namespace {
+
+struct SynchronizeHead {
+    struct rcu_head head;
+    event_t done;
+};
+
+} // namespace
+
+static void rcu_synchronize_callback(struct rcu_head* head) {
+    event_signal(&containerof(head, SynchronizeHead, head)->done, true);
+}
+
+void rcu_synchronize(void) {
+    DEBUG_ASSERT(thread_preempt_disable_count() == 0);
+
+    SynchronizeHead sync;
+    event_init(&sync.done, false, 0);
+    rcu_call(&sync.head, rcu_synchronize_callback);
+    event_wait(&sync.done);
+    event_destroy(&sync.done);
+}
+
+// Waits until every cpu has passed through a quiescent state since this
+// was called.
+static void rcu_wait_for_grace_period(void) {
+    uint64_t counts[SMP_MAX_CPUS];
+    for (cpu_num_t cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
+        counts[cpu] = atomic_load_u64(&percpu[cpu].rcu_quiescent_count);
+    }
+
+    // Nothing here runs in a read-side critical section, so this cpu is
+    // quiescent already and only the others need checking.
+    cpu_mask_t waiting = mp_get_online_mask() & ~cpu_num_to_mask(arch_curr_cpu_num());
+    while (waiting != 0) {
+        cpu_mask_t idle;
+        {
+            Guard<spin_lock_t, IrqSave> guard{ThreadLock::Get()};
+            idle = mp_get_idle_mask();
+        }
+        for (cpu_num_t cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
+            cpu_mask_t mask = cpu_num_to_mask(cpu);
+            if (!(waiting & mask)) {
+                continue;
+            }
+            // A cpu which is idle now either was idle all along, or went
+            // idle through a reschedule.  Either way it holds no readers
+            // from before the grace period.
+            if ((idle & mask) ||
+                atomic_load_u64(&percpu[cpu].rcu_quiescent_count) != counts[cpu]) {
+                waiting &= ~mask;
+            }
+        }
+        waiting &= mp_get_online_mask();
+        if (waiting != 0) {
+            thread_sleep_relative(RCU_POLL_INTERVAL);
+        }
+    }
+
+    kcounter_add(rcu_grace_periods, 1);
+}
+
+static int rcu_thread(void* arg) {
+    for (;;) {
+        event_wait(&rcu_event);
+
+        // Everything queued so far waits for the same grace period.
+        spin_lock_saved_state_t state;
+        spin_lock_irqsave(&rcu_lock, state);
+        struct rcu_head* head = rcu_pending_head;
+        rcu_pending_head = nullptr;
+        rcu_pending_tail = &rcu_pending_head;
+        event_unsignal(&rcu_event);
+        spin_unlock_irqrestore(&rcu_lock, state);
+
+        if (head == nullptr) {
+            continue;
+        }
+
+        rcu_wait_for_grace_period();
+
+        while (head != nullptr) {
+            struct rcu_head* next = head->next;
+            head->func(head);
+            kcounter_add(rcu_callbacks, 1);
+            head = next;
+        }
+    }
+
+    return 0;
+}
+
+static void rcu_init(unsigned int level) {
+    thread_t* t = thread_create("rcu", &rcu_thread, nullptr, HIGH_PRIORITY);
+    ASSERT(t);
+    thread_detach_and_resume(t);
+}
+
+LK_INIT_HOOK(rcu, rcu_init, LK_INIT_LEVEL_THREADING);
@@ -28,6 +28,7 @@ MODULE_SRCS := \
 	$(LOCAL_DIR)/mp.cpp \
 	$(LOCAL_DIR)/mutex.cpp \
 	$(LOCAL_DIR)/percpu.cpp \
+	$(LOCAL_DIR)/rcu.cpp \
 	$(LOCAL_DIR)/sched.cpp \
 	$(LOCAL_DIR)/thread.cpp \
 	$(LOCAL_DIR)/timer.cpp \
@@ -6,13 +6,16 @@
 // https://opensource.org/licenses/MIT
 #include <kernel/sched.h>
 
+#include <arch/mp.h>
 #include <assert.h>
 #include <debug.h>
 #include <err.h>
 #include <inttypes.h>
 #include <kernel/mp.h>
 #include <kernel/percpu.h>
+#include <kernel/rcu.h>
 #include <kernel/thread.h>
+#include <lib/counters.h>
 #include <lib/ktrace.h>
 #include <list.h>
 #include <platform.h>
@@ -27,6 +30,9 @@
 // disable priority boosting
 #define NO_BOOST 0
 
+// disable pulling ready threads from other cpus when going idle
+#define NO_WORK_STEALING 0
+
 #define MAX_PRIORITY_ADJ 4 // +/- priority levels from the base priority
 
 // ktraces just local to this file
@@ -53,6 +59,27 @@
 // threads get 10ms to run before they use up their time slice and the scheduler is invoked
 #define THREAD_INITIAL_TIME_SLICE ZX_MSEC(10)
 
+KCOUNTER(sched_steal_attempts, "kernel.sched.steal.attempts");
+KCOUNTER(sched_steal_success, "kernel.sched.steal.success");
+KCOUNTER(sched_steal_cache_domain, "kernel.sched.steal.cache_domain");
+KCOUNTER(sched_handoff, "kernel.sched.handoff");
+KCOUNTER(sched_deadline_admitted, "kernel.sched.deadline.admitted");
+KCOUNTER(sched_deadline_rejected, "kernel.sched.deadline.rejected");
+KCOUNTER(sched_deadline_missed, "kernel.sched.deadline.missed");
+KCOUNTER(sched_deadline_throttled, "kernel.sched.deadline.throttled");
+
+// Deadline threads are pinned to the cpu that admitted their reservation and run ahead of
+// every priority band, earliest absolute deadline first. A thread that uses up its budget for
+// the period is throttled, taken off the run queues until the next period starts, so it cannot
+// take more than it reserved from the priority-scheduled threads.
+
+// reservations are accounted in parts per million of a cpu
+#define DEADLINE_UTILIZATION_UNIT 1000000u
+
+// share of each cpu that deadline threads may reserve between them, leaving the rest to the
+// priority bands
+#define DEADLINE_UTILIZATION_MAX 800000u
+
 static bool local_migrate_if_needed(thread_t* curr_thread);
 
 // compute the effective priority of a thread
@@ -61,6 +88,9 @@ static void compute_effec_priority(thread_t* t) {
     if (t->inherited_priority > ep) {
         ep = t->inherited_priority;
     }
+    if (t->futex_pi_priority > ep) {
+        ep = t->futex_pi_priority;
+    }
 
     DEBUG_ASSERT(ep >= LOWEST_PRIORITY && ep <= HIGHEST_PRIORITY);
 
@@ -152,8 +182,28 @@ static cpu_mask_t rand_cpu(cpu_mask_t mask) {
     }
 }
 
+// whether |t| is pinned to a deadline cpu it can actually run on. if that cpu went offline or
+// was dropped from its affinity mask, it is scheduled on the remaining cpus like anything else.
+static bool deadline_cpu_usable(const thread_t* t) {
+    return thread_is_deadline(t) &&
+           (cpu_num_to_mask(t->sched_deadline.cpu) & t->cpu_affinity & mp_get_active_mask());
+}
+
+// whether |t| may stay on |cpu|
+static bool thread_allowed_on_cpu(const thread_t* t, cpu_num_t cpu) {
+    if (!(t->cpu_affinity & cpu_num_to_mask(cpu))) {
+        return false;
+    }
+    return !deadline_cpu_usable(t) || cpu == t->sched_deadline.cpu;
+}
+
 // find a cpu to wake up
 static cpu_mask_t find_cpu_mask(thread_t* t) TA_REQ(thread_lock) {
+    // deadline threads run on the cpu their reservation is on
+    if (deadline_cpu_usable(t)) {
+        return cpu_num_to_mask(t->sched_deadline.cpu);
+    }
+
     // get the last cpu the thread ran on
     cpu_mask_t last_ran_cpu_mask = cpu_num_to_mask(t->last_cpu);
 
@@ -163,6 +213,17 @@ static cpu_mask_t find_cpu_mask(thread_t* t) TA_REQ(thread_lock) {
     // the thread's affinity mask
     cpu_mask_t cpu_affinity = t->cpu_affinity;
 
+    // the current thread is about to block waiting on this one, so hand the
+    // cpu over to it directly (see AutoSchedHandoff). wakeups from interrupt
+    // context are not on behalf of the interrupted thread.
+    thread_t* current_thread = get_current_thread();
+    if (current_thread->sched_handoff && !arch_blocking_disallowed() &&
+        (cpu_affinity & curr_cpu_mask)) {
+        current_thread->sched_handoff = false;
+        kcounter_add(sched_handoff, 1);
+        return curr_cpu_mask;
+    }
+
     LTRACEF_LEVEL(2, "last %#x curr %#x aff %#x name %s\n",
                   last_ran_cpu_mask, curr_cpu_mask, cpu_affinity, t->name);
 
@@ -212,12 +273,113 @@ static cpu_mask_t find_cpu_mask(thread_t* t) TA_REQ(thread_lock) {
     return mask;
 }
 
+// start a new period for |t| if the current one is over. a thread that was runnable throughout
+// and still had budget left at the end did not get its reservation in time.
+static void deadline_replenish(thread_t* t, zx_time_t now, bool runnable) {
+    auto* d = &t->sched_deadline;
+    zx_time_t period_end = zx_time_add_duration(d->period_start, d->period);
+    if (now < period_end) {
+        return;
+    }
+
+    if (runnable && d->budget > 0 && !d->missed) {
+        kcounter_add(sched_deadline_missed, 1);
+    }
+
+    // a thread that slept through whole periods starts afresh rather than catching up
+    d->period_start = (now < zx_time_add_duration(period_end, d->period)) ? period_end : now;
+    d->abs_deadline = zx_time_add_duration(d->period_start, d->relative_deadline);
+    d->budget = d->capacity;
+    d->missed = false;
+}
+
+// charge |t| for the time it has been running up to |now|
+static void deadline_charge(thread_t* t, zx_time_t now) {
+    auto* d = &t->sched_deadline;
+    zx_time_t from = MAX(t->last_started_running, d->charged_until);
+    if (now > from) {
+        zx_duration_t ran = zx_time_sub_time(now, from);
+        d->budget = zx_duration_sub_duration(d->budget, MIN(ran, d->budget));
+    }
+    d->charged_until = now;
+
+    // still wanting the cpu past its deadline with budget to spare means it was kept waiting
+    if (t->state == THREAD_READY && d->budget > 0 && now > d->abs_deadline && !d->missed) {
+        d->missed = true;
+        kcounter_add(sched_deadline_missed, 1);
+    }
+}
+
+// start timing the thread's wait for a cpu. a thread moved between run queues keeps the
+// time it first became ready.
+static void mark_ready(thread_t* t) TA_REQ(thread_lock) {
+    if (t->ready_since == 0) {
+        t->ready_since = current_time();
+    }
+}
+
+void sched_wait_stats_add(struct sched_wait_stats* s, zx_duration_t wait) {
+    s->total = zx_duration_add_duration(s->total, wait);
+    s->max = MAX(s->max, wait);
+
+    uint bucket = 0;
+    if (wait >= 1024) {
+        bucket = MIN(64 - __builtin_clzll(static_cast<uint64_t>(wait) >> 10),
+                     SCHED_WAIT_BUCKETS - 1);
+    }
+    s->histogram[bucket]++;
+}
+
+// deadline threads bypass the priority queues: those with budget left go in the cpu's deadline
+// queue, and those without are parked until their next period
+static void insert_in_deadline_queue(cpu_num_t cpu, thread_t* t) TA_REQ(thread_lock) {
+    struct percpu* c = &percpu[cpu];
+    zx_time_t now = current_time();
+
+    // the current thread is coming off the cpu, bring its budget up to date first
+    if (t == get_current_thread()) {
+        deadline_charge(t, now);
+    }
+    deadline_replenish(t, now, true);
+
+    c->run_queue_count++;
+
+    if (t->sched_deadline.budget == 0) {
+        // sched_resched_internal() arms the timer that lets it back in
+        kcounter_add(sched_deadline_throttled, 1);
+        list_add_tail(&c->deadline_throttled, &t->queue_node);
+        return;
+    }
+
+    // the queue is kept sorted; it only ever holds a handful of threads
+    thread_t* entry;
+    list_for_every_entry (&c->deadline_run_queue, entry, thread_t, queue_node) {
+        if (t->sched_deadline.abs_deadline < entry->sched_deadline.abs_deadline) {
+            list_add_before(&entry->queue_node, &t->queue_node);
+            mp_set_cpu_busy(cpu);
+            return;
+        }
+    }
+    list_add_tail(&c->deadline_run_queue, &t->queue_node);
+
+    // mark the cpu as busy since the run queue now has at least one item in it
+    mp_set_cpu_busy(cpu);
+}
+
 // run queue manipulation
 static void insert_in_run_queue_head(cpu_num_t cpu, thread_t* t) TA_REQ(thread_lock) {
     DEBUG_ASSERT(!list_in_list(&t->queue_node));
 
+    mark_ready(t);
+
+    if (unlikely(thread_is_deadline(t))) {
+        insert_in_deadline_queue(cpu, t);
+        return;
+    }
+
     list_add_head(&percpu[cpu].run_queue[t->effec_priority], &t->queue_node);
     percpu[cpu].run_queue_bitmap |= (1u << t->effec_priority);
+    percpu[cpu].run_queue_count++;
 
     // mark the cpu as busy since the run queue now has at least one item in it
     mp_set_cpu_busy(cpu);
@@ -226,8 +388,16 @@ static void insert_in_run_queue_head(cpu_num_t cpu, thread_t* t) TA_REQ(thread_l
 static void insert_in_run_queue_tail(cpu_num_t cpu, thread_t* t) TA_REQ(thread_lock) {
     DEBUG_ASSERT(!list_in_list(&t->queue_node));
 
+    mark_ready(t);
+
+    if (unlikely(thread_is_deadline(t))) {
+        insert_in_deadline_queue(cpu, t);
+        return;
+    }
+
     list_add_tail(&percpu[cpu].run_queue[t->effec_priority], &t->queue_node);
     percpu[cpu].run_queue_bitmap |= (1u << t->effec_priority);
+    percpu[cpu].run_queue_count++;
 
     // mark the cpu as busy since the run queue now has at least one item in it
     mp_set_cpu_busy(cpu);
@@ -242,6 +412,11 @@ static void remove_from_run_queue(thread_t* t, int prio_queue) TA_REQ(thread_loc
 
     // clear the old cpu's queue bitmap if that was the last entry
     struct percpu* c = &percpu[t->curr_cpu];
+    DEBUG_ASSERT(c->run_queue_count > 0);
+    c->run_queue_count--;
+    if (unlikely(thread_is_deadline(t))) {
+        return;
+    }
     if (list_is_empty(&c->run_queue[prio_queue])) {
         c->run_queue_bitmap &= ~(1u << prio_queue);
     }
@@ -258,6 +433,17 @@ static thread_t* sched_get_top_thread(cpu_num_t cpu) TA_REQ(thread_lock) {
     // queued up on the passed in cpu.
 
     struct percpu* c = &percpu[cpu];
+
+    // deadline threads with budget left come before any priority band
+    thread_t* deadline_thread =
+        list_remove_head_type(&c->deadline_run_queue, thread_t, queue_node);
+    if (unlikely(deadline_thread)) {
+        DEBUG_ASSERT(deadline_thread->curr_cpu == cpu);
+        DEBUG_ASSERT(c->run_queue_count > 0);
+        c->run_queue_count--;
+        return deadline_thread;
+    }
+
     if (likely(c->run_queue_bitmap)) {
         uint highest_queue = highest_run_queue(c);
 
@@ -269,6 +455,8 @@ static thread_t* sched_get_top_thread(cpu_num_t cpu) TA_REQ(thread_lock) {
                          newthread->cpu_affinity, cpu);
         DEBUG_ASSERT(newthread->curr_cpu == cpu);
 
+        DEBUG_ASSERT(c->run_queue_count > 0);
+        c->run_queue_count--;
         if (list_is_empty(&c->run_queue[highest_queue])) {
             c->run_queue_bitmap &= ~(1u << highest_queue);
         }
@@ -282,10 +470,98 @@ static thread_t* sched_get_top_thread(cpu_num_t cpu) TA_REQ(thread_lock) {
     return &c->idle_thread;
 }
 
+// find the highest priority thread queued on |victim| that is allowed to run on |cpu|
+static thread_t* find_stealable_thread(cpu_num_t victim, cpu_num_t cpu) TA_REQ(thread_lock) {
+    const struct percpu* c = &percpu[victim];
+    cpu_mask_t cpu_mask = cpu_num_to_mask(cpu);
+
+    uint32_t bitmap = c->run_queue_bitmap;
+    while (bitmap) {
+        uint queue = HIGHEST_PRIORITY - __builtin_clz(bitmap) -
+                     (sizeof(bitmap) * CHAR_BIT - NUM_PRIORITIES);
+        bitmap &= ~(1u << queue);
+
+        thread_t* t;
+        list_for_every_entry (&c->run_queue[queue], t, thread_t, queue_node) {
+            if ((t->cpu_affinity & cpu_mask) && !thread_is_idle(t)) {
+                return t;
+            }
+        }
+    }
+    return nullptr;
+}
+
+// pick the cpu in |mask| with the deepest run queue, or INVALID_CPU if none of them
+// have any queued threads
+static cpu_num_t find_busiest_cpu(cpu_mask_t mask) TA_REQ(thread_lock) {
+    cpu_num_t busiest = INVALID_CPU;
+    uint32_t busiest_count = 0;
+    for (cpu_num_t i = 0; mask != 0; i++, mask >>= 1) {
+        if ((mask & 1) && percpu[i].run_queue_count > busiest_count) {
+            busiest = i;
+            busiest_count = percpu[i].run_queue_count;
+        }
+    }
+    return busiest;
+}
+
+// called when |cpu| is about to go idle. look for a ready thread sitting in another cpu's
+// run queue, preferring cpus that share a cache with this one, and pull it over.
+static thread_t* sched_steal_thread(cpu_num_t cpu) TA_REQ(thread_lock) {
+    if (NO_WORK_STEALING) {
+        return nullptr;
+    }
+
+    // a cpu that is being taken offline should not pick up new work
+    cpu_mask_t active = mp_get_active_mask();
+    if (!(active & cpu_num_to_mask(cpu))) {
+        return nullptr;
+    }
+
+    cpu_mask_t others = active & ~cpu_num_to_mask(cpu);
+    if (others == 0) {
+        return nullptr;
+    }
+
+    kcounter_add(sched_steal_attempts, 1);
+
+    // first pass looks at cpus in the same cache domain, second pass at everything else
+    cpu_mask_t domain = arch_mp_cache_domain_mask(cpu) & others;
+    cpu_mask_t passes[] = {domain, others & ~domain};
+    for (cpu_mask_t mask : passes) {
+        while (mask != 0) {
+            cpu_num_t victim = find_busiest_cpu(mask);
+            if (victim == INVALID_CPU) {
+                break;
+            }
+            mask &= ~cpu_num_to_mask(victim);
+
+            thread_t* t = find_stealable_thread(victim, cpu);
+            if (!t) {
+                continue;
+            }
+
+            remove_from_run_queue(t, t->effec_priority);
+            t->curr_cpu = cpu;
+
+            LOCAL_KTRACE2("sched_steal", victim, cpu);
+            kcounter_add(sched_steal_success, 1);
+            if (cpu_num_to_mask(victim) & domain) {
+                kcounter_add(sched_steal_cache_domain, 1);
+            }
+            return t;
+        }
+    }
+
+    return nullptr;
+}
+
 void sched_init_thread(thread_t* t, int priority) {
     t->base_priority = priority;
     t->priority_boost = 0;
     t->inherited_priority = -1;
+    t->futex_pi_priority = -1;
+    t->futex_pi_waiters = 0;
     compute_effec_priority(t);
 }
 
@@ -338,6 +614,11 @@ bool sched_unblock(thread_t* t) {
     // thread is being woken up, boost its priority
     boost_thread(t);
 
+    // it was blocked, so whatever budget it did not use is not a miss
+    if (unlikely(thread_is_deadline(t))) {
+        deadline_replenish(t, current_time(), false);
+    }
+
     // stuff the new thread in the run queue
     t->state = THREAD_READY;
 
@@ -368,6 +649,10 @@ bool sched_unblock_list(struct list_node* list) {
         // thread is being woken up, boost its priority
         boost_thread(t);
 
+        if (unlikely(thread_is_deadline(t))) {
+            deadline_replenish(t, current_time(), false);
+        }
+
         // stuff the new thread in the run queue
         t->state = THREAD_READY;
         find_cpu_and_insert(t, &local_resched, &accum_cpu_mask);
@@ -531,6 +816,18 @@ void sched_transition_off_cpu(cpu_num_t old_cpu) {
         }
     }
 
+    // Throttled deadline threads aren't in the run queues proper; move them too.
+    while ((t = list_remove_head_type(&percpu[old_cpu].deadline_throttled, thread_t,
+                                      queue_node)) != NULL) {
+        percpu[old_cpu].run_queue_count--;
+        if (t->cpu_affinity != pinned_mask) {
+            find_cpu_and_insert(t, &local_resched, &accum_cpu_mask);
+            DEBUG_ASSERT(!local_resched);
+        } else {
+            list_add_head(&pinned_threads, &t->queue_node);
+        }
+    }
+
     // Put pinned threads back on old_cpu's queue.
     while ((t = list_remove_head_type(&pinned_threads, thread_t, queue_node)) != NULL) {
         insert_in_run_queue_head(old_cpu, t);
@@ -547,8 +844,9 @@ static bool local_migrate_if_needed(thread_t* curr_thread) TA_REQ(thread_lock) {
     DEBUG_ASSERT(curr_thread == get_current_thread());
     DEBUG_ASSERT(curr_thread->state == THREAD_READY);
 
-    // if the affinity mask does not include the current cpu, migrate us right now
-    if (unlikely((curr_thread->cpu_affinity & cpu_num_to_mask(curr_thread->curr_cpu)) == 0)) {
+    // if the affinity mask does not include the current cpu, or this is a deadline thread away
+    // from its cpu, migrate us right now
+    if (unlikely(!thread_allowed_on_cpu(curr_thread, curr_thread->curr_cpu))) {
         migrate_current_thread(curr_thread);
         return true;
     }
@@ -565,7 +863,7 @@ void sched_migrate(thread_t* t) {
     switch (t->state) {
     case THREAD_RUNNING:
         // see if we need to migrate
-        if (t->cpu_affinity & cpu_num_to_mask(t->curr_cpu)) {
+        if (thread_allowed_on_cpu(t, t->curr_cpu)) {
             // it's running and the new mask contains the core it's already running on, nothing to do.
             //TRACEF("t %p nomigrate\n", t);
             return;
@@ -582,7 +880,7 @@ void sched_migrate(thread_t* t) {
         }
         break;
     case THREAD_READY:
-        if (t->cpu_affinity & cpu_num_to_mask(t->curr_cpu)) {
+        if (thread_allowed_on_cpu(t, t->curr_cpu)) {
             // it's ready and the new mask contains the core it's already waiting on, nothing to do.
             //TRACEF("t %p nomigrate\n", t);
             return;
@@ -692,6 +990,51 @@ void sched_inherit_priority(thread_t* t, int pri, bool* local_resched) {
     }
 }
 
+static void set_futex_pi_priority(thread_t* t, int pri, bool* local_resched)
+    TA_REQ(thread_lock) {
+    if (unlikely(t->state == THREAD_DEATH)) {
+        return;
+    }
+
+    t->futex_pi_priority = pri;
+    int old_ep = t->effec_priority;
+    compute_effec_priority(t);
+    if (old_ep == t->effec_priority) {
+        return;
+    }
+
+    cpu_mask_t accum_cpu_mask = 0;
+    sched_priority_changed(t, old_ep, local_resched, &accum_cpu_mask);
+    if (accum_cpu_mask) {
+        mp_reschedule(accum_cpu_mask, 0);
+    }
+}
+
+void sched_futex_pi_block(thread_t* t, int pri, bool* local_resched) {
+    DEBUG_ASSERT(spin_lock_held(&thread_lock));
+
+    t->futex_pi_waiters++;
+
+    if (pri > HIGHEST_PRIORITY) {
+        pri = HIGHEST_PRIORITY;
+    }
+    if (pri > t->futex_pi_priority) {
+        set_futex_pi_priority(t, pri, local_resched);
+    }
+}
+
+void sched_futex_pi_unblock(thread_t* t, bool* local_resched) {
+    DEBUG_ASSERT(spin_lock_held(&thread_lock));
+    DEBUG_ASSERT(t->futex_pi_waiters > 0);
+
+    // the priority is only dropped once the last waiter is gone, rather than
+    // recomputed from the remaining ones, which may keep |t| boosted a bit
+    // longer than strictly needed.
+    if (--t->futex_pi_waiters == 0) {
+        set_futex_pi_priority(t, -1, local_resched);
+    }
+}
+
 // changes the thread's base priority and if the re-computed effective priority changed
 //  then the thread is moved to the proper queue on the same processor and a re-schedule
 //  might be issued.
@@ -731,10 +1074,184 @@ void sched_change_priority(thread_t* t, int pri) {
     }
 }
 
+zx_status_t sched_set_deadline(thread_t* t, zx_duration_t capacity,
+                               zx_duration_t relative_deadline, zx_duration_t period) {
+    DEBUG_ASSERT(spin_lock_held(&thread_lock));
+    DEBUG_ASSERT(!thread_is_idle(t));
+
+    if (unlikely(t->state == THREAD_DEATH)) {
+        return ZX_ERR_BAD_STATE;
+    }
+    if (period != 0 &&
+        (capacity <= 0 || capacity > relative_deadline || relative_deadline > period)) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+
+    auto* d = &t->sched_deadline;
+
+    // admission control: pick the cpu with the most unreserved time that fits the new
+    // reservation, counting what |t| holds already as free
+    uint32_t utilization = 0;
+    cpu_num_t cpu = INVALID_CPU;
+    if (period != 0) {
+        utilization = static_cast<uint32_t>(
+            (static_cast<uint64_t>(capacity) * DEADLINE_UTILIZATION_UNIT + period - 1) / period);
+        uint32_t best_free = 0;
+        cpu_mask_t mask = t->cpu_affinity & mp_get_active_mask();
+        for (cpu_num_t i = 0; mask != 0; i++, mask >>= 1) {
+            if (!(mask & 1)) {
+                continue;
+            }
+            uint32_t reserved = percpu[i].deadline_utilization;
+            if (thread_is_deadline(t) && d->cpu == i) {
+                reserved -= d->utilization;
+            }
+            uint32_t free = DEADLINE_UTILIZATION_MAX - MIN(reserved, DEADLINE_UTILIZATION_MAX);
+            if (free >= utilization && (cpu == INVALID_CPU || free > best_free)) {
+                cpu = i;
+                best_free = free;
+            }
+        }
+        if (cpu == INVALID_CPU) {
+            kcounter_add(sched_deadline_rejected, 1);
+            return ZX_ERR_NO_RESOURCES;
+        }
+    }
+
+    // take |t| out of whichever run queue it is in while its class changes
+    bool ready = (t->state == THREAD_READY);
+    if (ready) {
+        remove_from_run_queue(t, t->effec_priority);
+    }
+
+    if (thread_is_deadline(t)) {
+        percpu[d->cpu].deadline_utilization -= d->utilization;
+    }
+
+    if (period != 0) {
+        zx_time_t now = current_time();
+        d->capacity = capacity;
+        d->relative_deadline = relative_deadline;
+        d->period = period;
+        d->utilization = utilization;
+        d->cpu = cpu;
+        d->period_start = now;
+        d->abs_deadline = zx_time_add_duration(now, relative_deadline);
+        d->budget = capacity;
+        d->charged_until = now;
+        d->missed = false;
+        percpu[cpu].deadline_utilization += utilization;
+        kcounter_add(sched_deadline_admitted, 1);
+    } else {
+        memset(d, 0, sizeof(*d));
+    }
+
+    bool local_resched = false;
+    cpu_mask_t accum_cpu_mask = 0;
+    if (ready) {
+        find_cpu_and_insert(t, &local_resched, &accum_cpu_mask);
+    } else if (t->state == THREAD_RUNNING && period != 0) {
+        // move it to its cpu, and its preemption timer to its budget
+        if (t == get_current_thread()) {
+            local_resched = true;
+        } else {
+            accum_cpu_mask |= cpu_num_to_mask(t->curr_cpu);
+        }
+    }
+
+    if (accum_cpu_mask) {
+        mp_reschedule(accum_cpu_mask, 0);
+    }
+    if (local_resched) {
+        sched_reschedule();
+    }
+    return ZX_OK;
+}
+
+// let throttled deadline threads on |cpu| whose next period has started back into the run
+// queue. returns true if there were any.
+static bool deadline_unthrottle(cpu_num_t cpu, zx_time_t now) TA_REQ(thread_lock) {
+    struct percpu* c = &percpu[cpu];
+    bool unthrottled = false;
+    thread_t* t;
+    thread_t* temp;
+    list_for_every_entry_safe (&c->deadline_throttled, t, temp, thread_t, queue_node) {
+        if (now >= zx_time_add_duration(t->sched_deadline.period_start,
+                                        t->sched_deadline.period)) {
+            list_delete(&t->queue_node);
+            c->run_queue_count--;
+            insert_in_deadline_queue(cpu, t);
+            unthrottled = true;
+        }
+    }
+    return unthrottled;
+}
+
+static void deadline_timer_update(cpu_num_t cpu) TA_REQ(thread_lock);
+
+static void deadline_timer_handler(timer_t* timer, zx_time_t now, void* arg) {
+    struct percpu* c = static_cast<struct percpu*>(arg);
+    cpu_num_t cpu = static_cast<cpu_num_t>(c - percpu);
+
+    // spin trylocking on the thread lock since this cpu may be trying to simultaneously
+    // re-arm this timer while holding the thread_lock.
+    if (timer_trylock_or_cancel(timer, &thread_lock)) {
+        return;
+    }
+
+    c->deadline_timer_deadline = ZX_TIME_INFINITE;
+    if (deadline_unthrottle(cpu, now)) {
+        // the irq handler will call back into us with sched_preempt()
+        thread_preempt_set_pending();
+    }
+    deadline_timer_update(cpu);
+
+    spin_unlock(&thread_lock);
+}
+
+// point |cpu|'s deadline timer at the earliest next period among its throttled threads.
+// must be called on |cpu|, since the timer fires on the cpu that set it.
+static void deadline_timer_update(cpu_num_t cpu) TA_REQ(thread_lock) {
+    DEBUG_ASSERT(cpu == arch_curr_cpu_num());
+
+    struct percpu* c = &percpu[cpu];
+    zx_time_t next = ZX_TIME_INFINITE;
+    thread_t* t;
+    list_for_every_entry (&c->deadline_throttled, t, thread_t, queue_node) {
+        next = MIN(next, zx_time_add_duration(t->sched_deadline.period_start,
+                                              t->sched_deadline.period));
+    }
+
+    if (next == c->deadline_timer_deadline) {
+        return;
+    }
+    if (c->deadline_timer_deadline != ZX_TIME_INFINITE) {
+        timer_cancel(&c->deadline_timer);
+    }
+    c->deadline_timer_deadline = next;
+    if (next != ZX_TIME_INFINITE) {
+        timer_set_oneshot(&c->deadline_timer, next, deadline_timer_handler, c);
+    }
+}
+
 // preemption timer that is set whenever a thread is scheduled
 void sched_preempt_timer_tick(zx_time_t now) {
     // if the preemption timer went off on the idle or a real time thread, ignore it
     thread_t* current_thread = get_current_thread();
+
+    // deadline threads run until their budget is gone
+    if (unlikely(thread_is_deadline(current_thread))) {
+        const auto* d = &current_thread->sched_deadline;
+        zx_time_t from = MAX(current_thread->last_started_running, d->charged_until);
+        if (zx_time_sub_time(now, from) >= d->budget) {
+            timer_preempt_reset(zx_time_add_duration(now, THREAD_INITIAL_TIME_SLICE));
+            thread_preempt_set_pending();
+        } else {
+            timer_preempt_reset(zx_time_add_duration(from, d->budget));
+        }
+        return;
+    }
+
     if (unlikely(thread_is_real_time_or_idle(current_thread))) {
         return;
     }
@@ -787,11 +1304,30 @@ void sched_resched_internal() {
 
     CPU_STATS_INC(reschedules);
 
+    // the current thread can't be in an rcu read-side critical section here, since those
+    // run with preemption disabled and do not block
+    rcu_note_quiescent_state(cpu);
+
+    // anything a remote cpu asked us to reschedule for is queued by now, and
+    // later requests must prod us again
+    mp_clear_curr_cpu_resched_pending();
+
     // pick a new thread to run
     thread_t* newthread = sched_get_top_thread(cpu);
 
+    // about to go idle, see if another cpu has surplus work we can take
+    if (newthread == &percpu[cpu].idle_thread) {
+        thread_t* stolen = sched_steal_thread(cpu);
+        if (stolen) {
+            newthread = stolen;
+        }
+    }
+
     DEBUG_ASSERT(newthread);
 
+    // a thread may have been throttled on the way off the cpu
+    deadline_timer_update(cpu);
+
     newthread->state = THREAD_RUNNING;
 
     thread_t* oldthread = current_thread;
@@ -806,17 +1342,33 @@ void sched_resched_internal() {
 
     // if it's the same thread as we're already running, exit
     if (newthread == oldthread) {
+        newthread->ready_since = 0;
         return;
     }
 
     zx_time_t now = current_time();
 
+    // account for the time the new thread spent waiting for the cpu
+    if (newthread->ready_since != 0) {
+        zx_duration_t wait = zx_time_sub_time(now, MIN(newthread->ready_since, now));
+        sched_wait_stats_add(&newthread->run_queue_wait, wait);
+        sched_wait_stats_add(&percpu[cpu].run_queue_wait, wait);
+        newthread->ready_since = 0;
+    }
+    newthread->context_switches++;
+    if (oldthread->state == THREAD_READY) {
+        oldthread->preemptions++;
+    }
+
     // account for time used on the old thread
     DEBUG_ASSERT(now >= oldthread->last_started_running);
     zx_duration_t old_runtime = zx_time_sub_time(now, oldthread->last_started_running);
     oldthread->runtime_ns = zx_duration_add_duration(oldthread->runtime_ns, old_runtime);
     oldthread->remaining_time_slice = zx_duration_sub_duration(
         oldthread->remaining_time_slice, MIN(old_runtime, oldthread->remaining_time_slice));
+    if (thread_is_deadline(oldthread)) {
+        deadline_charge(oldthread, now);
+    }
 
     // set up quantum for the new thread if it was consumed
     if (newthread->remaining_time_slice == 0) {
@@ -859,7 +1411,11 @@ void sched_resched_internal() {
             (oldthread->effec_priority << 16) | (newthread->effec_priority << 24)),
            (uint32_t)(uintptr_t)oldthread, (uint32_t)(uintptr_t)newthread);
 
-    if (thread_is_real_time_or_idle(newthread)) {
+    if (thread_is_deadline(newthread)) {
+        // run until the budget for this period is used up
+        DEBUG_ASSERT(newthread->sched_deadline.budget > 0);
+        timer_preempt_reset(zx_time_add_duration(now, newthread->sched_deadline.budget));
+    } else if (thread_is_real_time_or_idle(newthread)) {
         if (!thread_is_real_time_or_idle(oldthread)) {
             // if we're switching from a non real time to a real time, cancel
             // the preemption timer.
@@ -900,8 +1456,13 @@ void sched_resched_internal() {
 
 void sched_init_early() {
     // initialize the run queues
-    for (unsigned int cpu = 0; cpu < SMP_MAX_CPUS; cpu++)
+    for (unsigned int cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
         for (unsigned int i = 0; i < NUM_PRIORITIES; i++) {
             list_initialize(&percpu[cpu].run_queue[i]);
         }
+        list_initialize(&percpu[cpu].deadline_run_queue);
+        list_initialize(&percpu[cpu].deadline_throttled);
+        timer_init(&percpu[cpu].deadline_timer);
+        percpu[cpu].deadline_timer_deadline = ZX_TIME_INFINITE;
+    }
 }
@@ -477,6 +477,11 @@ __NO_RETURN static void thread_exit_locked(thread_t* current_thread,
     // reusing the stack before the function exits
     dpc_t free_dpc = DPC_INITIAL_VALUE;
 
+    // give back any cpu time reserved for it
+    if (thread_is_deadline(current_thread)) {
+        sched_set_deadline(current_thread, 0, 0, 0);
+    }
+
     // enter the dead state
     current_thread->state = THREAD_DEATH;
     current_thread->retcode = retcode;
@@ -896,8 +901,8 @@ zx_status_t thread_sleep_etc(zx_time_t deadline, bool interruptable) {
     }
 
     // set a one shot timer to wake us up and reschedule
-    timer_set(&timer, deadline,
-              TIMER_SLACK_LATE, sleep_slack(deadline, now), thread_sleep_handler, current_thread);
+    zx_duration_t slack = MAX(sleep_slack(deadline, now), current_thread->timer_slack);
+    timer_set(&timer, deadline, TIMER_SLACK_LATE, slack, thread_sleep_handler, current_thread);
 
     current_thread->state = THREAD_SLEEPING;
     current_thread->blocked_status = ZX_OK;
@@ -935,6 +940,15 @@ zx_duration_t thread_runtime(const thread_t* t) {
     return runtime;
 }
 
+void thread_get_sched_stats(const thread_t* t, struct sched_wait_stats* wait,
+                            uint64_t* context_switches, uint64_t* preemptions) {
+    Guard<spin_lock_t, IrqSave> guard{ThreadLock::Get()};
+
+    *wait = t->run_queue_wait;
+    *context_switches = t->context_switches;
+    *preemptions = t->preemptions;
+}
+
 /**
  * @brief Construct a thread t around the current running state
  *
@@ -1023,6 +1037,76 @@ void thread_set_priority(thread_t* t, int priority) {
     sched_change_priority(t, priority);
 }
 
+/**
+ * @brief Set how late the timeouts of a thread may fire
+ *
+ * Timed blocks and sleeps of |t| may then time out anywhere up to |slack|
+ * nanoseconds past their deadline, which lets the timer code coalesce them
+ * with other timers instead of firing them separately. Timeouts never fire
+ * before their deadline.
+ */
+void thread_set_timer_slack(thread_t* t, zx_duration_t slack) {
+    DEBUG_ASSERT(t->magic == THREAD_MAGIC);
+    DEBUG_ASSERT(slack >= 0);
+
+    Guard<spin_lock_t, IrqSave> guard{ThreadLock::Get()};
+    t->timer_slack = slack;
+}
+
+/**
+ * @brief Give a thread a deadline scheduling reservation
+ *
+ * |t| is then guaranteed |capacity| of cpu time in every |period|, delivered
+ * within |relative_deadline| of the start of the period, and runs ahead of
+ * all priority-scheduled threads while it has budget left. A |period| of zero
+ * drops the reservation.
+ *
+ * @return ZX_ERR_NO_RESOURCES if no cpu |t| may run on has enough
+ * unreserved time left.
+ */
+zx_status_t thread_set_deadline(thread_t* t, zx_duration_t capacity,
+                                zx_duration_t relative_deadline, zx_duration_t period) {
+    DEBUG_ASSERT(t->magic == THREAD_MAGIC);
+
+    Guard<spin_lock_t, IrqSave> guard{ThreadLock::Get()};
+    return sched_set_deadline(t, capacity, relative_deadline, period);
+}
+
+/**
+ * @brief Lend a priority to the owner of a priority-inheriting futex
+ *
+ * Called when a thread of priority |priority| blocks on a futex owned by
+ * |owner|.  |owner| then runs at least at that priority until a matching
+ * number of thread_futex_pi_unblock() calls is made for it.
+ */
+void thread_futex_pi_block(thread_t* owner, int priority) {
+    DEBUG_ASSERT(owner->magic == THREAD_MAGIC);
+
+    Guard<spin_lock_t, IrqSave> guard{ThreadLock::Get()};
+
+    // the blocking thread is about to give up the cpu anyway
+    bool unused;
+    sched_futex_pi_block(owner, priority, &unused);
+}
+
+/**
+ * @brief Stop lending a priority to the owner of a priority-inheriting futex
+ *
+ * Called when a thread that called thread_futex_pi_block() for |owner| is
+ * woken, times out or is moved to another futex.
+ */
+void thread_futex_pi_unblock(thread_t* owner) {
+    DEBUG_ASSERT(owner->magic == THREAD_MAGIC);
+
+    Guard<spin_lock_t, IrqSave> guard{ThreadLock::Get()};
+
+    bool local_resched = false;
+    sched_futex_pi_unblock(owner, &local_resched);
+    if (local_resched) {
+        sched_reschedule();
+    }
+}
+
 /**
  * @brief  Become an idle thread
  *
@@ -31,7 +31,6 @@
 #include <kernel/stats.h>
 #include <kernel/thread.h>
 #include <kernel/timer.h>
-#include <list.h>
 #include <malloc.h>
 #include <platform.h>
 #include <platform/timer.h>
@@ -46,6 +45,41 @@ namespace {
 spin_lock_t timer_lock __CPU_ALIGN_EXCLUSIVE = SPIN_LOCK_INITIAL_VALUE;
 DECLARE_SINGLETON_LOCK_WRAPPER(TimerLock, timer_lock);
 
+// Timers are kept in per cpu balanced trees ordered by scheduled_time, so
+// that finding where to insert a timer, and the timers it can be coalesced
+// with, takes logarithmic time. Removing a timer takes amortized constant
+// time. Timers scheduled at the same time are ordered by address, as the
+// keys of the tree must be unique.
+struct TimerQueueTraits {
+    struct Key {
+        zx_time_t time;
+        uintptr_t addr;
+    };
+
+    static Key GetKey(const timer_t& timer) {
+        return {timer.scheduled_time, reinterpret_cast<uintptr_t>(&timer)};
+    }
+    static bool LessThan(const Key& a, const Key& b) {
+        return a.time < b.time || (a.time == b.time && a.addr < b.addr);
+    }
+    static bool EqualTo(const Key& a, const Key& b) {
+        return a.time == b.time && a.addr == b.addr;
+    }
+    static fbl::WAVLTreeNodeState<timer_t*>& node_state(timer_t& timer) {
+        return timer.node;
+    }
+};
+
+using TimerQueue = fbl::WAVLTree<TimerQueueTraits::Key, timer_t*,
+                                 TimerQueueTraits, TimerQueueTraits>;
+
+TimerQueue timer_queues[SMP_MAX_CPUS];
+
+timer_t* timer_queue_head(uint cpu) {
+    TimerQueue& queue = timer_queues[cpu];
+    return queue.is_empty() ? nullptr : &queue.front();
+}
+
 } // anonymous namespace
 
 void timer_init(timer_t* timer) {
@@ -74,110 +108,68 @@ static void insert_timer_in_queue(uint cpu, timer_t* timer,
     LTRACEF("timer %p, cpu %u, scheduled %" PRIi64 "\n", timer, cpu, timer->scheduled_time);
 
     // For inserting the timer we consider several cases. In general we
-    // want to coalesce with the current timer unless we can prove that
+    // want to coalesce with an existing timer unless we can prove that
     // either that:
-    //  1- there is no slack overlap with current timer OR
-    //  2- the next timer is a better fit.
+    //  1- there is no slack overlap with it OR
+    //  2- another timer is a better fit.
     //
+    // Only the timers right before and right after the new one can be a fit.
     // In diagrams that follow
-    // - Let |e| be the current (existing) timer deadline
     // - Let |t| be the deadline of the timer we are inserting
-    // - Let |n| be the next timer deadline if any
-    // - Let |x| be the end of the list (not a timer)
+    // - Let |p| be the last timer deadline before |t|, if any
+    // - Let |n| be the first timer deadline at or after |t|, if any
     // - Let |(| and |)| the earliest_deadline and latest_deadline.
     //
-    timer_t* entry;
-
-    list_for_every_entry (&percpu[cpu].timer_queue, entry, timer_t, node) {
-        if (entry->scheduled_time > latest_deadline) {
-            // New timer latest is earlier than the current timer.
-            // Just add upfront as is, without slack.
-            //
-            //   ---------t---)--e-------------------------------> time
-            //
-            timer->slack = 0ll;
-            list_add_before(&entry->node, &timer->node);
-            return;
-        }
-
-        if (entry->scheduled_time >= timer->scheduled_time) {
-            //  New timer slack overlaps and is to the left (or equal). We
-            //  coalesce with current by scheduling late.
-            //
-            //  --------(----t---e-)----------------------------> time
-            //
-            timer->slack = zx_time_sub_time(entry->scheduled_time, timer->scheduled_time);
-            timer->scheduled_time = entry->scheduled_time;
-            list_add_after(&entry->node, &timer->node);
-            return;
-        }
+    TimerQueue& queue = timer_queues[cpu];
+    const zx_time_t deadline = timer->scheduled_time;
+
+    auto next_iter = queue.lower_bound({deadline, 0});
+    const timer_t* next = next_iter.IsValid() ? &*next_iter : nullptr;
+    const timer_t* prev = nullptr;
+    if (next_iter != queue.begin()) {
+        auto prev_iter = next_iter;
+        --prev_iter;
+        prev = &*prev_iter;
+    }
 
-        if (entry->scheduled_time < earliest_deadline) {
-            // new timer earliest is later than the current timer. This case
-            // is handled in a future iteration.
-            //
-            //   ----------------e--(---t-----------------------> time
-            //
-            continue;
-        }
+    zx_time_t scheduled_time = deadline;
 
-        // New timer is to the right of current timer and there is overlap
-        // with the current timer, but could the next timer (if any) be
-        // a better fit?
+    if (prev != nullptr && prev->scheduled_time >= earliest_deadline) {
+        // There is overlap with the previous timer, but could the next
+        // timer (if any) be a better fit?
         //
-        //  -------------(--e---t-----?-------------------> time
+        //  -------------(--p---t-----?-------------------> time
         //
-
-        const timer_t* next =
-            list_next_type(&percpu[cpu].timer_queue, &entry->node, timer_t, node);
-
-        if (next != NULL) {
-            if (next->scheduled_time <= timer->scheduled_time) {
-                // The new timer is to the right of the next timer. There is no
-                // chance the current timer is a better fit.
-                //
-                //  -------------(--e---n---t----------------------> time
-                //
-                continue;
-            }
-
-            if (next->scheduled_time < latest_deadline) {
-                // There is slack overlap with the next timer, and also with the
-                // current timer. Which coalescing is a better match?
-                //
-                //  --------------(-e---t---n-)-----------------------> time
-                //
-                zx_duration_t delta_entry =
-                    zx_time_sub_time(timer->scheduled_time, entry->scheduled_time);
-                zx_duration_t delta_next =
-                    zx_time_sub_time(next->scheduled_time, timer->scheduled_time);
-                if (delta_next < delta_entry) {
-                    // New timer is closer to the next timer, handle it in the
-                    // next iteration.
-                    continue;
-                }
+        // We coalesce by scheduling early, unless there is slack overlap
+        // with the next timer too and it is closer.
+        //
+        //  --------------(-p---t-n---)-----------------------> time
+        //
+        scheduled_time = prev->scheduled_time;
+        if (next != nullptr && next->scheduled_time < latest_deadline) {
+            zx_duration_t delta_prev = zx_time_sub_time(deadline, prev->scheduled_time);
+            zx_duration_t delta_next = zx_time_sub_time(next->scheduled_time, deadline);
+            if (delta_next < delta_prev) {
+                scheduled_time = next->scheduled_time;
             }
         }
-
-        // Handles the remaining cases, note that there is overlap with
-        // the current timer.
+    } else if (next != nullptr && next->scheduled_time <= latest_deadline) {
+        //  New timer slack overlaps with the next timer only. We coalesce
+        //  with it by scheduling late.
         //
-        //  1- this is the last timer (next == NULL) or
-        //  2- there is no overlap with the next timer, or
-        //  3- there is overlap with both current and next but
-        //     current is closer.
+        //  --------(----t---n-)----------------------------> time
         //
-        //  So we coalesce by scheduling early.
-        //
-        timer->slack = zx_time_sub_time(entry->scheduled_time, timer->scheduled_time);
-        timer->scheduled_time = entry->scheduled_time;
-        list_add_after(&entry->node, &timer->node);
-        return;
+        scheduled_time = next->scheduled_time;
     }
+    // Otherwise there is no overlap and the timer is added as is, without slack.
+    //
+    //   ------p--(--t---)--n-----------------------------> time
+    //
 
-    // Walked off the end of the list and there was no overlap.
-    timer->slack = 0;
-    list_add_tail(&percpu[cpu].timer_queue, &timer->node);
+    timer->slack = zx_time_sub_time(scheduled_time, deadline);
+    timer->scheduled_time = scheduled_time;
+    timer->queue_cpu = cpu;
+    queue.insert(timer);
 }
 
 void timer_set(timer_t* timer, zx_time_t deadline,
@@ -190,7 +182,7 @@ void timer_set(timer_t* timer, zx_time_t deadline,
     DEBUG_ASSERT(mode <= TIMER_SLACK_EARLY);
     DEBUG_ASSERT(slack >= 0);
 
-    if (list_in_list(&timer->node)) {
+    if (timer->node.InContainer()) {
         panic("timer %p already in list\n", timer);
     }
 
@@ -244,9 +236,9 @@ void timer_set(timer_t* timer, zx_time_t deadline,
 
     insert_timer_in_queue(cpu, timer, earliest_deadline, latest_deadline);
 
-    if (list_peek_head_type(&percpu[cpu].timer_queue, timer_t, node) == timer) {
+    if (timer_queue_head(cpu) == timer) {
         // we just modified the head of the timer queue
-        update_platform_timer(cpu, deadline);
+        update_platform_timer(cpu, timer->scheduled_time);
     }
 }
 
@@ -299,14 +291,15 @@ bool timer_cancel(timer_t* timer) {
     bool callback_not_running;
 
     // if the timer is in a queue, remove it and adjust hardware timers if needed
-    if (list_in_list(&timer->node)) {
+    if (timer->node.InContainer()) {
         callback_not_running = true;
 
         // save a copy of the old head of the queue so later we can see if we modified the head
-        timer_t* oldhead = list_peek_head_type(&percpu[cpu].timer_queue, timer_t, node);
+        timer_t* oldhead = timer_queue_head(cpu);
 
         // remove our timer from the queue
-        list_delete(&timer->node);
+        timer_queues[timer->queue_cpu].erase(*timer);
+        timer->queue_cpu = -1;
 
         // TODO(cpu): if  after removing |timer| there is one other single timer with
         // the same scheduled_time and slack non-zero then it is possible to return
@@ -316,7 +309,7 @@ bool timer_cancel(timer_t* timer) {
         // if we modified another cpu's queue, we'll just let it fire and sort itself out
         if (unlikely(oldhead == timer)) {
             // timer we're canceling was at head of queue, see if we should update platform timer
-            timer_t* newhead = list_peek_head_type(&percpu[cpu].timer_queue, timer_t, node);
+            timer_t* newhead = timer_queue_head(cpu);
             if (newhead) {
                 update_platform_timer(cpu, newhead->scheduled_time);
             } else if (percpu[cpu].next_timer_deadline == ZX_TIME_INFINITE) {
@@ -367,7 +360,7 @@ void timer_tick(zx_time_t now) {
 
     for (;;) {
         // see if there's an event to process
-        timer = list_peek_head_type(&percpu[cpu].timer_queue, timer_t, node);
+        timer = timer_queue_head(cpu);
         if (likely(timer == 0)) {
             break;
         }
@@ -382,7 +375,8 @@ void timer_tick(zx_time_t now) {
         DEBUG_ASSERT_MSG(timer && timer->magic == TIMER_MAGIC,
                          "ASSERT: timer failed magic check: timer %p, magic 0x%x\n",
                          timer, (uint)timer->magic);
-        list_delete(&timer->node);
+        timer_queues[cpu].erase(*timer);
+        timer->queue_cpu = -1;
 
         // mark the timer busy
         timer->active_cpu = cpu;
@@ -409,7 +403,7 @@ void timer_tick(zx_time_t now) {
 
     // get the deadline of the event at the head of the queue (if any)
     zx_time_t deadline = ZX_TIME_INFINITE;
-    timer = list_peek_head_type(&percpu[cpu].timer_queue, timer_t, node);
+    timer = timer_queue_head(cpu);
     if (timer) {
         deadline = timer->scheduled_time;
 
@@ -447,19 +441,18 @@ void timer_transition_off_cpu(uint old_cpu) {
     Guard<spin_lock_t, IrqSave> guard{TimerLock::Get()};
     uint cpu = arch_curr_cpu_num();
 
-    timer_t* old_head = list_peek_head_type(&percpu[cpu].timer_queue, timer_t, node);
+    timer_t* old_head = timer_queue_head(cpu);
 
-    timer_t *entry = NULL, *tmp_entry = NULL;
     // Move all timers from old_cpu to this cpu
-    list_for_every_entry_safe (&percpu[old_cpu].timer_queue, entry, tmp_entry, timer_t, node) {
-        list_delete(&entry->node);
+    while (!timer_queues[old_cpu].is_empty()) {
+        timer_t* entry = timer_queues[old_cpu].pop_front();
         // We lost the original asymmetric slack information so when we combine them
         // with the other timer queue they are not coalesced again.
         // TODO(cpu): figure how important this case is.
         insert_timer_in_queue(cpu, entry, entry->scheduled_time, entry->scheduled_time);
     }
 
-    timer_t* new_head = list_peek_head_type(&percpu[cpu].timer_queue, timer_t, node);
+    timer_t* new_head = timer_queue_head(cpu);
     if (new_head != NULL && new_head != old_head) {
         // we just modified the head of the timer queue
         update_platform_timer(cpu, new_head->scheduled_time);
@@ -480,7 +473,7 @@ void timer_thaw_percpu(void) {
     percpu[cpu].next_timer_deadline = ZX_TIME_INFINITE;
     zx_time_t deadline = percpu[cpu].preempt_timer_deadline;
 
-    timer_t* t = list_peek_head_type(&percpu[cpu].timer_queue, timer_t, node);
+    timer_t* t = timer_queue_head(cpu);
     if (t) {
         if (t->scheduled_time < deadline) {
             deadline = t->scheduled_time;
@@ -494,7 +487,6 @@ void timer_thaw_percpu(void) {
 
 void timer_queue_init(void) {
     for (uint i = 0; i < SMP_MAX_CPUS; i++) {
-        list_initialize(&percpu[i].timer_queue);
         percpu[i].preempt_timer_deadline = ZX_TIME_INFINITE;
         percpu[i].next_timer_deadline = ZX_TIME_INFINITE;
     }
@@ -511,15 +503,14 @@ static void dump_timer_queues(char* buf, size_t len) {
         if (mp_is_cpu_online(i)) {
             ptr += snprintf(buf + ptr, len - ptr, "cpu %u:\n", i);
 
-            timer_t* t;
             zx_time_t last = now;
-            list_for_every_entry (&percpu[i].timer_queue, t, timer_t, node) {
-                zx_duration_t delta_now = zx_time_sub_time(t->scheduled_time, now);
-                zx_duration_t delta_last = zx_time_sub_time(t->scheduled_time, last);
+            for (const timer_t& t : timer_queues[i]) {
+                zx_duration_t delta_now = zx_time_sub_time(t.scheduled_time, now);
+                zx_duration_t delta_last = zx_time_sub_time(t.scheduled_time, last);
                 ptr += snprintf(buf + ptr, len - ptr,
                                 "\ttime %" PRIi64 " delta_now %" PRIi64 " delta_last %" PRIi64 " func %p arg %p\n",
-                                t->scheduled_time, delta_now, delta_last, t->callback, t->arg);
-                last = t->scheduled_time;
+                                t.scheduled_time, delta_now, delta_last, t.callback, t.arg);
+                last = t.scheduled_time;
             }
         }
     }
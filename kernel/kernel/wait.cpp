@@ -26,6 +26,9 @@
 //
 // Implemented as a simple structure that contains a count of the number of threads
 // blocked and a list of thread_ts acting as individual queue heads, one per priority.
+// A bitmap of the priorities that have a head, like the one the scheduler keeps for
+// its run queues, gives the highest blocked priority directly and tells insertion how
+// many heads lie on either side of its priority, so it walks in from the nearer end.
 
 // +----------------+
 // |                |
@@ -67,8 +70,10 @@ void wait_queue_validate_queue(wait_queue_t* wait) {
     // validate that the queue is sorted properly
     thread_t* last = NULL;
     thread_t* temp;
+    uint32_t bitmap = 0;
     list_for_every_entry (&wait->heads, temp, thread_t, wait_queue_heads_node) {
         DEBUG_ASSERT(temp->magic == THREAD_MAGIC);
+        bitmap |= 1u << temp->effec_priority;
 
         // validate that the queue is sorted high to low priority
         if (last) {
@@ -90,47 +95,67 @@ void wait_queue_validate_queue(wait_queue_t* wait) {
 
         last = temp;
     }
+
+    DEBUG_ASSERT_MSG(bitmap == wait->priority_bitmap, "%#x  %#x", bitmap, wait->priority_bitmap);
+}
+
+static_assert(NUM_PRIORITIES <= sizeof(((wait_queue_t*)0)->priority_bitmap) * CHAR_BIT, "");
+
+// return the node in the list of queue heads that the head for |pri| follows: either the
+// head for the nearest higher priority or, if there is none, the list itself
+static struct list_node* wait_queue_find_heads_above(wait_queue_t* wait, int pri) {
+    const uint32_t at_or_below = (2u << pri) - 1;
+    const int above = __builtin_popcount(wait->priority_bitmap & ~at_or_below);
+    const int rest = __builtin_popcount(wait->priority_bitmap & at_or_below);
+
+    struct list_node* node = &wait->heads;
+    if (above <= rest) {
+        for (int i = 0; i < above; i++) {
+            node = node->next;
+        }
+    } else {
+        for (int i = 0; i <= rest; i++) {
+            node = node->prev;
+        }
+    }
+    return node;
 }
 
 // add a thread to the tail of a wait queue, sorted by priority
 static void wait_queue_insert(wait_queue_t* wait, thread_t* t) {
-    if (likely(list_is_empty(&wait->heads))) {
+    const int pri = t->effec_priority;
+    const uint32_t bit = 1u << pri;
+
+    if (likely(wait->priority_bitmap == 0)) {
         // we're the first thread
         list_initialize(&t->queue_node);
         list_add_head(&wait->heads, &t->wait_queue_heads_node);
+    } else if (wait->priority_bitmap & bit) {
+        // same priority as an existing head, add ourself to the tail of its queue
+        struct list_node* node = wait_queue_find_heads_above(wait, pri)->next;
+        thread_t* head = containerof(node, thread_t, wait_queue_heads_node);
+        DEBUG_ASSERT(head->effec_priority == pri);
+        list_add_tail(&head->queue_node, &t->queue_node);
+        list_clear_node(&t->wait_queue_heads_node);
+        return;
     } else {
-        int pri = t->effec_priority;
-
-        // walk through the sorted list of wait queue heads
-        thread_t* temp;
-        list_for_every_entry (&wait->heads, temp, thread_t, wait_queue_heads_node) {
-            if (pri > temp->effec_priority) {
-                // insert ourself here as a new queue head
-                list_initialize(&t->queue_node);
-                list_add_before(&temp->wait_queue_heads_node, &t->wait_queue_heads_node);
-                return;
-            } else if (temp->effec_priority == pri) {
-                // same priority, add ourself to the tail of this queue
-                list_add_tail(&temp->queue_node, &t->queue_node);
-                list_clear_node(&t->wait_queue_heads_node);
-                return;
-            }
-        }
-
-        // we walked off the end, add ourself as a new queue head at the end
+        // insert ourself as a new queue head just below the higher priorities
         list_initialize(&t->queue_node);
-        list_add_tail(&wait->heads, &t->wait_queue_heads_node);
+        list_add_after(wait_queue_find_heads_above(wait, pri), &t->wait_queue_heads_node);
     }
+
+    wait->priority_bitmap |= bit;
 }
 
 // remove a thread from whatever wait queue its in
-// thread must be the head of a queue
-static void remove_queue_head(thread_t* t) {
+// thread must be the head of a queue, queued at priority |pri|
+static void remove_queue_head(wait_queue_t* wait, thread_t* t, int pri) {
     // are there any nodes in the queue for this priority?
     if (list_is_empty(&t->queue_node)) {
         // no, remove ourself from the the queue list
         list_delete(&t->wait_queue_heads_node);
         list_clear_node(&t->queue_node);
+        wait->priority_bitmap &= ~(1u << pri);
     } else {
         // there are other threads in this list, make the next thread in the queue the head
         thread_t* newhead = list_peek_head_type(&t->queue_node, thread_t, queue_node);
@@ -150,30 +175,30 @@ static thread_t* wait_queue_pop_head(wait_queue_t* wait) {
         return NULL;
     }
 
-    remove_queue_head(t);
+    remove_queue_head(wait, t, t->effec_priority);
 
     return t;
 }
 
-// remove the thread from whatever wait queue its in
-static void wait_queue_remove_thread(thread_t* t) {
+// remove the thread from whatever wait queue its in, where it was queued at priority |pri|
+static void wait_queue_remove_thread(thread_t* t, int pri) {
     if (!list_in_list(&t->wait_queue_heads_node)) {
         // we're just in a queue, not a head
         list_delete(&t->queue_node);
     } else {
         // we're the head of a queue
-        remove_queue_head(t);
+        remove_queue_head(t->blocking_wait_queue, t, pri);
     }
 }
 
 // return the numeric priority of the highest priority thread queued
 int wait_queue_blocked_priority(wait_queue_t* wait) {
-    thread_t* t = list_peek_head_type(&wait->heads, thread_t, wait_queue_heads_node);
-    if (!t) {
+    if (wait->priority_bitmap == 0) {
         return -1;
     }
 
-    return t->effec_priority;
+    return (int)(sizeof(wait->priority_bitmap) * CHAR_BIT - 1) -
+           __builtin_clz(wait->priority_bitmap);
 }
 
 static void wait_queue_timeout_handler(timer_t* timer, zx_time_t now,
@@ -231,7 +256,8 @@ static zx_status_t wait_queue_block_worker(wait_queue_t* wait, zx_time_t deadlin
     // if the deadline is nonzero or noninfinite, set a callback to yank us out of the queue
     if (deadline != ZX_TIME_INFINITE) {
         timer_init(&timer);
-        timer_set_oneshot(&timer, deadline, wait_queue_timeout_handler, (void*)current_thread);
+        timer_set(&timer, deadline, TIMER_SLACK_LATE, current_thread->timer_slack,
+                  wait_queue_timeout_handler, (void*)current_thread);
     }
 
     ktrace_ptr(TAG_KWAIT_BLOCK, wait, 0, 0);
@@ -482,7 +508,7 @@ zx_status_t wait_queue_unblock_thread(thread_t* t, zx_status_t wait_queue_error)
         wait_queue_validate_queue(t->blocking_wait_queue);
     }
 
-    wait_queue_remove_thread(t);
+    wait_queue_remove_thread(t, t->effec_priority);
     t->blocking_wait_queue->count--;
     t->blocking_wait_queue = NULL;
     t->blocked_status = wait_queue_error;
@@ -509,7 +535,7 @@ void wait_queue_priority_changed(struct thread* t, int old_prio) {
     // TODO: implement optimal algorithm depending on all the different edge
     // cases of how the thread was previously queued and what priority its
     // switching to.
-    wait_queue_remove_thread(t);
+    wait_queue_remove_thread(t, old_prio);
     wait_queue_insert(t->blocking_wait_queue, t);
 
     // TODO: find a way to call into wrapper mutex object if present and
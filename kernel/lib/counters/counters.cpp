@@ -23,9 +23,13 @@
 #include <lk/init.h>
 
 #include <lib/console.h>
+#include <lib/zircon-internal/kcounters.h>
+
+#include <vm/vm_object_paged.h>
 
 // The arena is allocated in kernel.ld linker script.
 extern int64_t kcounters_arena[];
+extern int64_t kcounters_arena_end[];
 
 struct watched_counter_t {
     list_node node;
@@ -77,6 +81,80 @@ static void counters_init(unsigned level) {
     }
 }
 
+// The VMOs are never released: the arena VMO holds pages of the kernel
+// image, which must not go back to the pmm.
+static fbl::Mutex vmo_lock;
+static fbl::RefPtr<VmObject> desc_vmo;
+static fbl::RefPtr<VmObject> arena_vmo;
+
+static zx_status_t create_desc_vmo(fbl::RefPtr<VmObject>* out) {
+    const size_t num_counters = get_num_counters();
+    const size_t size = sizeof(kcounters_desc_header_t) +
+                        num_counters * sizeof(kcounters_desc_entry_t);
+
+    fbl::RefPtr<VmObject> vmo;
+    zx_status_t status = VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, 0u,
+                                               ROUNDUP(size, PAGE_SIZE), &vmo);
+    if (status != ZX_OK)
+        return status;
+
+    kcounters_desc_header_t header = {};
+    header.magic = KCOUNTERS_MAGIC;
+    header.version = KCOUNTERS_VERSION;
+    header.num_counters = static_cast<uint32_t>(num_counters);
+    header.max_cpus = SMP_MAX_CPUS;
+    header.entry_size = sizeof(kcounters_desc_entry_t);
+    status = vmo->Write(&header, 0u, sizeof(header));
+    if (status != ZX_OK)
+        return status;
+
+    uint64_t offset = sizeof(header);
+    for (auto it = kcountdesc_begin; it != kcountdesc_end; ++it) {
+        kcounters_desc_entry_t entry = {};
+        strlcpy(entry.name, it->name, sizeof(entry.name));
+        status = vmo->Write(&entry, offset, sizeof(entry));
+        if (status != ZX_OK)
+            return status;
+        offset += sizeof(entry);
+    }
+
+    vmo->set_name(KCOUNTERS_DESC_VMO_NAME, sizeof(KCOUNTERS_DESC_VMO_NAME) - 1);
+    *out = fbl::move(vmo);
+    return ZX_OK;
+}
+
+static zx_status_t create_arena_vmo(fbl::RefPtr<VmObject>* out) {
+    // kernel.ld gives the arena whole pages, so the VMO exposes nothing else.
+    const size_t size = reinterpret_cast<uintptr_t>(kcounters_arena_end) -
+                        reinterpret_cast<uintptr_t>(kcounters_arena);
+    fbl::RefPtr<VmObject> vmo;
+    zx_status_t status = VmObjectPaged::CreateFromROData(kcounters_arena, size, &vmo);
+    if (status != ZX_OK)
+        return status;
+
+    vmo->set_name(KCOUNTERS_ARENA_VMO_NAME, sizeof(KCOUNTERS_ARENA_VMO_NAME) - 1);
+    *out = fbl::move(vmo);
+    return ZX_OK;
+}
+
+zx_status_t kcounters_get_vmos(fbl::RefPtr<VmObject>* desc_vmo_out,
+                               fbl::RefPtr<VmObject>* arena_vmo_out) {
+    fbl::AutoLock lock(&vmo_lock);
+    if (!desc_vmo) {
+        zx_status_t status = create_desc_vmo(&desc_vmo);
+        if (status != ZX_OK)
+            return status;
+    }
+    if (!arena_vmo) {
+        zx_status_t status = create_arena_vmo(&arena_vmo);
+        if (status != ZX_OK)
+            return status;
+    }
+    *desc_vmo_out = desc_vmo;
+    *arena_vmo_out = arena_vmo;
+    return ZX_OK;
+}
+
 static void dump_counter(const k_counter_desc* desc) {
     size_t counter_index = kcounter_index(desc);
 
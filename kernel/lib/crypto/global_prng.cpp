@@ -11,6 +11,8 @@
 #include <err.h>
 #include <explicit-memory/bytes.h>
 #include <fbl/algorithm.h>
+#include <fbl/atomic.h>
+#include <kernel/align.h>
 #include <kernel/auto_lock.h>
 #include <kernel/cmdline.h>
 #include <kernel/mutex.h>
@@ -21,6 +23,7 @@
 #include <lib/crypto/entropy/quality_test.h>
 #include <lib/crypto/prng.h>
 #include <zxcpp/new.h>
+#include <kernel/mp.h>
 #include <lk/init.h>
 #include <string.h>
 #include <trace.h>
@@ -38,6 +41,63 @@ PRNG* GetInstance() {
     return kGlobalPrng;
 }
 
+namespace {
+
+struct PerCpuPrng {
+    alignas(alignof(PRNG)) uint8_t space[sizeof(PRNG)];
+    PRNG* prng;
+    // Bytes drawn since the last reseed.
+    fbl::atomic<uint64_t> drawn;
+    // The value of |entropy_generation| as of the last reseed.
+    fbl::atomic<uint64_t> generation;
+} __CPU_ALIGN;
+
+PerCpuPrng per_cpu_prngs[SMP_MAX_CPUS];
+
+// Bumped by each AddEntropy(), so that the per-cpu instances pick the new
+// entropy up before they next draw.
+fbl::atomic<uint64_t> entropy_generation(0);
+
+void Reseed(PerCpuPrng* cpu) {
+    uint64_t generation = entropy_generation.load();
+    uint8_t seed[PRNG::kMinEntropy];
+    kGlobalPrng->Draw(seed, sizeof(seed));
+    cpu->prng->AddEntropy(seed, sizeof(seed));
+    mandatory_memset(seed, 0, sizeof(seed));
+    cpu->drawn.store(0);
+    cpu->generation.store(generation);
+}
+
+// Creates and seeds the per-cpu instances, once the global PRNG is
+// thread-safe.
+void InitPerCpu() {
+    for (PerCpuPrng& cpu : per_cpu_prngs) {
+        uint8_t seed[PRNG::kMinEntropy];
+        kGlobalPrng->Draw(seed, sizeof(seed));
+        cpu.prng = new (&cpu.space) PRNG(seed, sizeof(seed));
+        mandatory_memset(seed, 0, sizeof(seed));
+    }
+}
+
+} // namespace
+
+void DrawPerCpu(void* out, size_t size) {
+    // The thread may move to another cpu once it has picked an instance,
+    // which is harmless: every instance is thread-safe.
+    PerCpuPrng* cpu = &per_cpu_prngs[arch_curr_cpu_num()];
+    ASSERT(cpu->prng);
+    if (cpu->generation.load() != entropy_generation.load() ||
+        cpu->drawn.fetch_add(size) + size > kPerCpuReseedBytes) {
+        Reseed(cpu);
+    }
+    cpu->prng->Draw(out, size);
+}
+
+void AddEntropy(const void* data, size_t size) {
+    GetInstance()->AddEntropy(data, size);
+    entropy_generation.fetch_add(1);
+}
+
 // Returns true if the kernel cmdline provided at least PRNG::kMinEntropy bytes
 // of entropy, and false otherwise.
 //
@@ -162,9 +222,11 @@ static void EarlyBootSeed(uint level) {
     }
 }
 
-// Migrate the global PRNG to enter thread-safe mode.
+// Migrate the global PRNG to enter thread-safe mode, and set up the per-cpu
+// instances.
 static void BecomeThreadSafe(uint level) {
     GetInstance()->BecomeThreadSafe();
+    InitPerCpu();
 }
 
 } //namespace GlobalPRNG
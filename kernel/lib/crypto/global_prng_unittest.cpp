@@ -8,6 +8,7 @@
 
 #include <lib/unittest/unittest.h>
 #include <stdint.h>
+#include <string.h>
 
 namespace crypto {
 
@@ -24,10 +25,37 @@ bool identical() {
     END_TEST;
 }
 
+bool per_cpu_draws_differ() {
+    BEGIN_TEST;
+
+    uint8_t first[32];
+    uint8_t second[32];
+    uint8_t zero[32] = {};
+    GlobalPRNG::DrawPerCpu(first, sizeof(first));
+    GlobalPRNG::DrawPerCpu(second, sizeof(second));
+    EXPECT_NE(0, memcmp(first, second, sizeof(first)), "");
+    EXPECT_NE(0, memcmp(first, zero, sizeof(first)), "");
+
+    // Adding entropy reseeds the per-cpu instances, and drawing past the
+    // reseed interval does too; neither may get in the way of drawing.
+    GlobalPRNG::AddEntropy(zero, sizeof(zero));
+    GlobalPRNG::DrawPerCpu(first, sizeof(first));
+    EXPECT_NE(0, memcmp(first, second, sizeof(first)), "");
+    for (size_t drawn = 0; drawn <= GlobalPRNG::kPerCpuReseedBytes; drawn += 4096) {
+        uint8_t buf[4096];
+        GlobalPRNG::DrawPerCpu(buf, sizeof(buf));
+    }
+    GlobalPRNG::DrawPerCpu(second, sizeof(second));
+    EXPECT_NE(0, memcmp(first, second, sizeof(first)), "");
+
+    END_TEST;
+}
+
 } // namespace
 
 UNITTEST_START_TESTCASE(global_prng_tests)
 UNITTEST("Identical", identical)
+UNITTEST("PerCpuDrawsDiffer", per_cpu_draws_differ)
 UNITTEST_END_TESTCASE(global_prng_tests, "global_prng",
                       "Validate global PRNG singleton");
 
@@ -16,6 +16,20 @@ namespace GlobalPRNG {
 // guaranteed to be non-null.
 PRNG* GetInstance();
 
+// Fills |out| with |size| bytes from the current cpu's instance of the PRNG,
+// so that many cpus can draw at once without contending on the global one.
+// Each instance is seeded from the global PRNG, and reseeded from it after
+// every kPerCpuReseedBytes of output and before its next draw after
+// AddEntropy().  Reseeding takes a mutex, so this must not be called with a
+// spinlock held.  |size| MUST NOT be greater than PRNG::kMaxDrawLen.
+void DrawPerCpu(void* out, size_t size);
+
+// Mixes |size| bytes of |data| into the global PRNG and, through it, into
+// the per-cpu instances.  |size| MUST NOT be greater than PRNG::kMaxEntropy.
+void AddEntropy(const void* data, size_t size);
+
+constexpr size_t kPerCpuReseedBytes = 1u << 20;
+
 } //namespace GlobalPRNG
 
 } // namespace crypto
@@ -9,6 +9,7 @@
 #include <dev/udisplay.h>
 #include <err.h>
 #include <fbl/atomic.h>
+#include <kernel/align.h>
 #include <kernel/spinlock.h>
 #include <kernel/thread.h>
 #include <lib/crashlog.h>
@@ -103,9 +104,107 @@ bool dlog_bypass(void) {
 //           H         H
 
 #define ALIGN4(n) (((n) + 3) & (~3))
+#define ALIGN8(n) (((n) + 7) & (~7))
 
-zx_status_t dlog_write(uint32_t flags, const void* data_ptr, size_t len) {
+// Writers which find the log lock taken do not spin on it.  They park the
+// record in their cpu's staging ring instead, without any lock: only the
+// cpu itself adds to its ring, with interrupts disabled, and only a holder
+// of the log lock takes from it.  Staged records move into the log when
+// the cpu next gets the lock, or when a reader or the notifier thread
+// looks at the log, so records from different cpus may land slightly out
+// of timestamp order.  A writer only waits for the lock if its ring is
+// full.
+#define DLOG_STAGE_RECORDS (8u)
+#define DLOG_STAGE_MASK (DLOG_STAGE_RECORDS - 1u)
+
+static_assert((DLOG_STAGE_RECORDS & DLOG_STAGE_MASK) == 0u, "must be power of two");
+
+namespace {
+
+struct DlogStage {
+    // Records are added at head and taken from tail.
+    fbl::atomic<uint32_t> head;
+    fbl::atomic<uint32_t> tail;
+    dlog_record_t records[DLOG_STAGE_RECORDS];
+} __CPU_ALIGN;
+
+DlogStage dlog_stages[SMP_MAX_CPUS];
+
+} // namespace
+
+// Copies a record into the fifo, discarding the oldest records to make room.
+static void dlog_append_locked(dlog_t* log, const dlog_header_t* hdr, const void* data_ptr) {
     const uint8_t* ptr = static_cast<const uint8_t*>(data_ptr);
+    size_t len = hdr->datalen;
+    size_t wiresize = DLOG_HDR_GET_FIFOLEN(hdr->header);
+
+    // Discard records at tail until there is enough
+    // space for the new record.
+    while ((log->head - log->tail) > (DLOG_SIZE - wiresize)) {
+        uint32_t header = *reinterpret_cast<uint32_t*>(log->data + (log->tail & DLOG_MASK));
+        log->tail += DLOG_HDR_GET_FIFOLEN(header);
+    }
+
+    size_t offset = (log->head & DLOG_MASK);
+
+    size_t fifospace = DLOG_SIZE - offset;
+
+    if (fifospace >= wiresize) {
+        // everything fits in one write, simple case!
+        memcpy(log->data + offset, hdr, sizeof(*hdr));
+        memcpy(log->data + offset + sizeof(*hdr), ptr, len);
+    } else if (fifospace < sizeof(*hdr)) {
+        // the wrap happens in the header
+        memcpy(log->data + offset, hdr, fifospace);
+        memcpy(log->data, reinterpret_cast<const uint8_t*>(hdr) + fifospace,
+               sizeof(*hdr) - fifospace);
+        memcpy(log->data + (sizeof(*hdr) - fifospace), ptr, len);
+    } else {
+        // the wrap happens in the data
+        memcpy(log->data + offset, hdr, sizeof(*hdr));
+        offset += sizeof(*hdr);
+        fifospace -= sizeof(*hdr);
+        memcpy(log->data + offset, ptr, fifospace);
+        memcpy(log->data, ptr + fifospace, len - fifospace);
+    }
+    log->head += wiresize;
+}
+
+// Moves the records staged on one cpu into the fifo.
+static void dlog_drain_stage_locked(dlog_t* log, DlogStage* stage) {
+    uint32_t tail = stage->tail.load(fbl::memory_order_relaxed);
+    const uint32_t head = stage->head.load(fbl::memory_order_acquire);
+    while (tail != head) {
+        const dlog_record_t* rec = &stage->records[tail & DLOG_STAGE_MASK];
+        dlog_append_locked(log, &rec->hdr, rec->data);
+        tail++;
+    }
+    stage->tail.store(tail, fbl::memory_order_release);
+}
+
+// Moves the records staged on every cpu into the fifo.
+static void dlog_drain_stages_locked(dlog_t* log) {
+    for (cpu_num_t cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
+        dlog_drain_stage_locked(log, &dlog_stages[cpu]);
+    }
+}
+
+// Adds a record to the current cpu's staging ring, if it has room.
+static bool dlog_stage(DlogStage* stage, const dlog_header_t* hdr, const void* ptr) {
+    const uint32_t head = stage->head.load(fbl::memory_order_relaxed);
+    if (head - stage->tail.load(fbl::memory_order_acquire) == DLOG_STAGE_RECORDS) {
+        return false;
+    }
+    dlog_record_t* rec = &stage->records[head & DLOG_STAGE_MASK];
+    rec->hdr = *hdr;
+    memcpy(rec->data, ptr, hdr->datalen);
+    stage->head.store(head + 1, fbl::memory_order_release);
+    return true;
+}
+
+// Whether this takes the log lock depends on the staging ring, which the
+// analysis cannot follow.
+zx_status_t dlog_write(uint32_t flags, const void* ptr, size_t len) TA_NO_THREAD_SAFETY_ANALYSIS {
     dlog_t* log = &DLOG;
 
     if (len > DLOG_MAX_DATA) {
@@ -137,42 +236,25 @@ zx_status_t dlog_write(uint32_t flags, const void* data_ptr, size_t len) {
     }
 
     spin_lock_saved_state_t state;
-    spin_lock_irqsave(&log->lock, state);
+    arch_interrupt_save(&state, SPIN_LOCK_FLAG_INTERRUPTS);
 
-    // Discard records at tail until there is enough
-    // space for the new record.
-    while ((log->head - log->tail) > (DLOG_SIZE - wiresize)) {
-        uint32_t header = *reinterpret_cast<uint32_t*>(log->data + (log->tail & DLOG_MASK));
-        log->tail += DLOG_HDR_GET_FIFOLEN(header);
+    DlogStage* stage = &dlog_stages[arch_curr_cpu_num()];
+    bool locked = spin_trylock(&log->lock) == 0;
+    if (!locked && !dlog_stage(stage, &hdr, ptr)) {
+        spin_lock(&log->lock);
+        locked = true;
     }
-
-    size_t offset = (log->head & DLOG_MASK);
-
-    size_t fifospace = DLOG_SIZE - offset;
-
-    if (fifospace >= wiresize) {
-        // everything fits in one write, simple case!
-        memcpy(log->data + offset, &hdr, sizeof(hdr));
-        memcpy(log->data + offset + sizeof(hdr), ptr, len);
-    } else if (fifospace < sizeof(hdr)) {
-        // the wrap happens in the header
-        memcpy(log->data + offset, &hdr, fifospace);
-        memcpy(log->data, reinterpret_cast<uint8_t*>(&hdr) + fifospace, sizeof(hdr) - fifospace);
-        memcpy(log->data + (sizeof(hdr) - fifospace), ptr, len);
-    } else {
-        // the wrap happens in the data
-        memcpy(log->data + offset, &hdr, sizeof(hdr));
-        offset += sizeof(hdr);
-        fifospace -= sizeof(hdr);
-        memcpy(log->data + offset, ptr, fifospace);
-        memcpy(log->data, ptr + fifospace, len - fifospace);
+    if (locked) {
+        // Anything this cpu staged earlier goes first.
+        dlog_drain_stage_locked(log, stage);
+        dlog_append_locked(log, &hdr, ptr);
+        spin_unlock(&log->lock);
     }
-    log->head += wiresize;
 
-    // Need to check this before re-releasing the log lock, since we may
-    // re-enable interrupts while doing that.  If interrupts are enabled when we
-    // make this check, we could see the following sequence of events between
-    // two CPUs and incorrectly conclude we are holding the thread lock:
+    // Need to check this before re-enabling interrupts.  If interrupts are
+    // enabled when we make this check, we could see the following sequence
+    // of events between two CPUs and incorrectly conclude we are holding the
+    // thread lock:
     // C2: Acquire thread_lock
     // C1: Running this thread, evaluate spin_lock_holder_cpu(&thread_lock) -> C2
     // C1: Context switch away
@@ -181,7 +263,7 @@ zx_status_t dlog_write(uint32_t flags, const void* data_ptr, size_t len) {
     // C2: Running this thread, evaluate arch_curr_cpu_num() -> C2
     bool holding_thread_lock = spin_lock_holder_cpu(&thread_lock) == arch_curr_cpu_num();
 
-    spin_unlock_irqrestore(&log->lock, state);
+    arch_interrupt_restore(state, SPIN_LOCK_FLAG_INTERRUPTS);
 
     [log, holding_thread_lock]() TA_NO_THREAD_SAFETY_ANALYSIS {
         // if we happen to be called from within the global thread lock, use a
@@ -197,7 +279,6 @@ zx_status_t dlog_write(uint32_t flags, const void* data_ptr, size_t len) {
     return ZX_OK;
 }
 
-// TODO: support reading multiple messages at a time
 // TODO: filter with flags
 zx_status_t dlog_read(dlog_reader_t* rdr, uint32_t flags, void* data_ptr,
                       size_t len, size_t* _actual) {
@@ -213,6 +294,8 @@ zx_status_t dlog_read(dlog_reader_t* rdr, uint32_t flags, void* data_ptr,
     spin_lock_saved_state_t state;
     spin_lock_irqsave(&log->lock, state);
 
+    dlog_drain_stages_locked(log);
+
     size_t rtail = rdr->tail;
 
     // If the read-tail is not within the range of log-tail..log-head
@@ -223,24 +306,42 @@ zx_status_t dlog_read(dlog_reader_t* rdr, uint32_t flags, void* data_ptr,
         rtail = log->tail;
     }
 
-    if (rtail != log->head) {
+    // A batch holds as many whole records as fit, each starting on an
+    // 8 byte boundary.
+    size_t copied = 0;
+    while (rtail != log->head) {
         size_t offset = (rtail & DLOG_MASK);
         uint32_t header = *reinterpret_cast<uint32_t*>(log->data + offset);
 
         size_t actual = DLOG_HDR_GET_READLEN(header);
+        size_t padded = ALIGN8(actual);
+        if (padded > len - copied) {
+            break;
+        }
+
         size_t fifospace = DLOG_SIZE - offset;
 
         if (fifospace >= actual) {
-            memcpy(ptr, log->data + offset, actual);
+            memcpy(ptr + copied, log->data + offset, actual);
         } else {
-            memcpy(ptr, log->data + offset, fifospace);
-            memcpy(ptr + fifospace, log->data, actual - fifospace);
+            memcpy(ptr + copied, log->data + offset, fifospace);
+            memcpy(ptr + copied + fifospace, log->data, actual - fifospace);
         }
+        memset(ptr + copied + actual, 0, padded - actual);
 
-        *_actual = actual;
         status = ZX_OK;
 
         rtail += DLOG_HDR_GET_FIFOLEN(header);
+
+        if (!(flags & DLOG_READ_BATCH)) {
+            copied += actual;
+            break;
+        }
+        copied += padded;
+    }
+
+    if (status == ZX_OK) {
+        *_actual = copied;
     }
 
     rdr->tail = rtail;
@@ -264,6 +365,7 @@ void dlog_reader_init(dlog_reader_t* rdr, void (*notify)(void*), void* cookie) {
 
     spin_lock_saved_state_t state;
     spin_lock_irqsave(&log->lock, state);
+    dlog_drain_stages_locked(log);
     rdr->tail = log->tail;
     do_notify = (log->tail != log->head);
     spin_unlock_irqrestore(&log->lock, state);
@@ -297,6 +399,13 @@ static int debuglog_notifier(void* arg) {
         }
         event_wait(&log->event);
 
+        // Publish records which were staged when their writers found the
+        // log busy, so readers see them.
+        spin_lock_saved_state_t state;
+        spin_lock_irqsave(&log->lock, state);
+        dlog_drain_stages_locked(log);
+        spin_unlock_irqrestore(&log->lock, state);
+
         // notify readers that new log items were posted
         mutex_acquire(&log->readers_lock);
         dlog_reader_t* rdr;
@@ -73,6 +73,10 @@ struct dlog_record {
 static_assert(sizeof(dlog_header_t) == DLOG_MIN_RECORD, "");
 static_assert(sizeof(dlog_record_t) == DLOG_MAX_RECORD, "");
 
+// dlog_read() flag: copy as many whole records as fit rather than one, each
+// starting on an 8 byte boundary.
+#define DLOG_READ_BATCH (1u)
+
 void dlog_reader_init(dlog_reader_t* rdr, void (*notify)(void*), void* cookie);
 void dlog_reader_destroy(dlog_reader_t* rdr);
 zx_status_t dlog_write(uint32_t flags, const void* ptr, size_t len);
@@ -192,7 +192,9 @@ void* Arena::Pool::Pop() {
         }
     }
     char* slot = top_;
-    top_ += slot_size_;
+    // Publish the slot only once its memory is committed, for
+    // InRangeUnlocked().
+    __atomic_store_n(&top_, top_ + slot_size_, __ATOMIC_RELEASE);
     return slot;
 }
 
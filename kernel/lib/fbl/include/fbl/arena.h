@@ -41,6 +41,14 @@ public:
         return in_range(reinterpret_cast<uintptr_t>(addr));
     }
 
+    // Like in_range(), but may be called without serializing against
+    // Alloc() and Free(). Object memory is never decommitted once it has
+    // been allocated, so an address for which this returns true can always
+    // be read, even if its slot has since been freed.
+    bool in_range_unlocked(uintptr_t addr) const {
+        return data_.InRangeUnlocked(addr);
+    }
+
     void* start() const { return data_.start(); }
     void* end() const { return data_.end(); }
 
@@ -94,6 +102,13 @@ private:
             return InRange(reinterpret_cast<uintptr_t>(addr));
         }
 
+        // Like InRange(), but may be called concurrently with Pop().
+        bool InRangeUnlocked(uintptr_t addr) const {
+            char* top = __atomic_load_n(&top_, __ATOMIC_ACQUIRE);
+            return (addr >= reinterpret_cast<uintptr_t>(start_) &&
+                    addr < reinterpret_cast<uintptr_t>(top));
+        }
+
         // The lowest address of the memory managed by this Pool.
         // Pop will only return values > |start| (besides nullptr).
         char* start() const { return start_; }
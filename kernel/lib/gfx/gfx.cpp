@@ -170,44 +170,59 @@ static void putpixel(gfx_surface* surface, uint x, uint y, uint color) {
 
 template <typename T>
 static void copyrect(gfx_surface* surface, uint x, uint y, uint width, uint height, uint x2, uint y2) {
-    // copy
     const T* src = static_cast<const T*>(surface->ptr) + (x + y * surface->stride);
     T* dest = static_cast<T*>(surface->ptr) + (x2 + y2 * surface->stride);
-    uint stride_diff = surface->stride - width;
 
-    if (dest < src) {
-        uint i, j;
-        for (i = 0; i < height; i++) {
-            for (j = 0; j < width; j++) {
-                *dest = *src;
-                dest++;
-                src++;
-            }
-            dest += stride_diff;
-            src += stride_diff;
+    // memmove() handles the overlap within each row; the rows must go
+    // bottom up if the copy moves down.
+    if (dest <= src) {
+        for (uint i = 0; i < height; i++) {
+            memmove(dest, src, width * sizeof(T));
+            dest += surface->stride;
+            src += surface->stride;
         }
     } else {
-        // copy backwards
-        src += height * surface->stride + width;
-        dest += height * surface->stride + width;
-
-        uint i, j;
-        for (i = 0; i < height; i++) {
-            for (j = 0; j < width; j++) {
-                *dest = *src;
-                dest--;
-                src--;
-            }
-            dest -= stride_diff;
-            src -= stride_diff;
+        src += (height - 1) * surface->stride;
+        dest += (height - 1) * surface->stride;
+        for (uint i = 0; i < height; i++) {
+            memmove(dest, src, width * sizeof(T));
+            dest -= surface->stride;
+            src -= surface->stride;
         }
     }
 }
 
+// The kernel cannot use the vector registers, so fills store a word of
+// pixels at a time.
+typedef uint64_t __attribute__((__may_alias__)) fill_word_t;
+
+template <typename T>
+static void fill_row(T* dest, T color, uint count) {
+    if (sizeof(T) == 1) {
+        memset(dest, color, count);
+        return;
+    }
+    while (count > 0 && (reinterpret_cast<uintptr_t>(dest) & (sizeof(fill_word_t) - 1))) {
+        *dest++ = color;
+        count--;
+    }
+    fill_word_t pattern = color;
+    for (size_t bits = sizeof(T) * 8; bits < sizeof(fill_word_t) * 8; bits *= 2) {
+        pattern |= pattern << bits;
+    }
+    fill_word_t* words = reinterpret_cast<fill_word_t*>(dest);
+    for (; count >= sizeof(fill_word_t) / sizeof(T); count -= sizeof(fill_word_t) / sizeof(T)) {
+        *words++ = pattern;
+    }
+    dest = reinterpret_cast<T*>(words);
+    while (count-- > 0) {
+        *dest++ = color;
+    }
+}
+
 template <typename T>
 static void fillrect(gfx_surface* surface, uint x, uint y, uint width, uint height, uint _color) {
     T* dest = static_cast<T*>(surface->ptr) + (x + y * surface->stride);
-    uint stride_diff = surface->stride - width;
 
     T color;
     if (sizeof(_color) == sizeof(color)) {
@@ -216,13 +231,13 @@ static void fillrect(gfx_surface* surface, uint x, uint y, uint width, uint heig
         color = static_cast<T>(surface->translate_color(_color));
     }
 
-    uint i, j;
-    for (i = 0; i < height; i++) {
-        for (j = 0; j < width; j++) {
-            *dest = color;
-            dest++;
-        }
-        dest += stride_diff;
+    if (width == surface->stride) {
+        fill_row(dest, color, width * height);
+        return;
+    }
+    for (uint i = 0; i < height; i++) {
+        fill_row(dest, color, width);
+        dest += surface->stride;
     }
 }
 
@@ -1034,6 +1034,12 @@ void cmpct_free(void* payload) {
     unlock();
 }
 
+size_t cmpct_usable_size(void* payload) {
+    header_t* header = (header_t*)payload - 1;
+    DEBUG_ASSERT(!is_tagged_as_free(header));
+    return header->size - sizeof(header_t);
+}
+
 void* cmpct_realloc(void* payload, size_t size) {
     if (payload == NULL) {
         return cmpct_alloc(size);
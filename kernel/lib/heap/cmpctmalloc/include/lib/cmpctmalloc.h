@@ -18,6 +18,9 @@ void* cmpct_alloc(size_t);
 void* cmpct_realloc(void*, size_t);
 void cmpct_free(void*);
 void* cmpct_memalign(size_t size, size_t alignment);
+// Returns the number of bytes usable in the allocated block at |payload|,
+// which is at least the size it was allocated with.
+size_t cmpct_usable_size(void* payload);
 
 void cmpct_init(void);
 void cmpct_dump(bool panic_time);
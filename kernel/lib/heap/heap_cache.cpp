@@ -0,0 +1,192 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include "heap_cache.h"
+
+#include <arch/ops.h>
+#include <debug.h>
+#include <fbl/algorithm.h>
+#include <kernel/spinlock.h>
+#include <lib/cmpctmalloc.h>
+#include <lib/counters.h>
+#include <stdio.h>
+#include <string.h>
+
+// Each cpu keeps up to kMagazineSize freed blocks per size class. When a
+// magazine overflows, half of it is given back to cmpctmalloc at once, so
+// that a cpu that keeps freeing what another one allocates does not end up
+// taking the heap lock on every free.
+//
+// The lock of a cpu's cache is only ever taken by that cpu, except when
+// flushing all the caches, so it is not contended in practice.
+
+namespace {
+
+constexpr size_t kClassSizes[] = {32, 48, 64, 96, 128, 192, 256, 384, 512};
+constexpr size_t kNumClasses = fbl::count_of(kClassSizes);
+// Blocks at least this large are not cached in the last class, as that
+// would waste more than the spacing between the classes.
+constexpr size_t kMaxUsableSize = 768;
+constexpr size_t kMagazineSize = 16;
+
+struct Magazine {
+    size_t count;
+    void* blocks[kMagazineSize];
+};
+
+struct CpuCache {
+    spin_lock_t lock;
+    Magazine magazines[kNumClasses];
+};
+
+CpuCache caches[SMP_MAX_CPUS];
+
+#define CLASS_COUNTERS(size)                                                  \
+    KCOUNTER(cache_##size##_hit, "kernel.heap.cache." #size ".hit");          \
+    KCOUNTER(cache_##size##_miss, "kernel.heap.cache." #size ".miss");       \
+    KCOUNTER(cache_##size##_overflow, "kernel.heap.cache." #size ".overflow")
+
+CLASS_COUNTERS(32);
+CLASS_COUNTERS(48);
+CLASS_COUNTERS(64);
+CLASS_COUNTERS(96);
+CLASS_COUNTERS(128);
+CLASS_COUNTERS(192);
+CLASS_COUNTERS(256);
+CLASS_COUNTERS(384);
+CLASS_COUNTERS(512);
+
+#undef CLASS_COUNTERS
+
+const k_counter_desc* const kHitCounters[kNumClasses] = {
+    cache_32_hit, cache_48_hit, cache_64_hit, cache_96_hit, cache_128_hit,
+    cache_192_hit, cache_256_hit, cache_384_hit, cache_512_hit,
+};
+const k_counter_desc* const kMissCounters[kNumClasses] = {
+    cache_32_miss, cache_48_miss, cache_64_miss, cache_96_miss, cache_128_miss,
+    cache_192_miss, cache_256_miss, cache_384_miss, cache_512_miss,
+};
+const k_counter_desc* const kOverflowCounters[kNumClasses] = {
+    cache_32_overflow, cache_48_overflow, cache_64_overflow, cache_96_overflow,
+    cache_128_overflow, cache_192_overflow, cache_256_overflow, cache_384_overflow,
+    cache_512_overflow,
+};
+
+// Returns the smallest class that fits |size| bytes, or kNumClasses.
+size_t alloc_class(size_t size) {
+    size_t c = 0;
+    while (c < kNumClasses && kClassSizes[c] < size)
+        c++;
+    return c;
+}
+
+// Returns the largest class a block of |usable_size| bytes can serve, or
+// kNumClasses.
+size_t free_class(size_t usable_size) {
+    if (usable_size < kClassSizes[0] || usable_size >= kMaxUsableSize)
+        return kNumClasses;
+    size_t c = kNumClasses - 1;
+    while (kClassSizes[c] > usable_size)
+        c--;
+    return c;
+}
+
+// Disables interrupts and locks the cache of the cpu we end up on.
+CpuCache* lock_local_cache(spin_lock_saved_state_t* state) TA_NO_THREAD_SAFETY_ANALYSIS {
+    arch_interrupt_save(state, SPIN_LOCK_FLAG_INTERRUPTS);
+    CpuCache* cache = &caches[arch_curr_cpu_num()];
+    spin_lock(&cache->lock);
+    return cache;
+}
+
+void unlock_cache(CpuCache* cache, spin_lock_saved_state_t state) TA_NO_THREAD_SAFETY_ANALYSIS {
+    spin_unlock(&cache->lock);
+    arch_interrupt_restore(state, SPIN_LOCK_FLAG_INTERRUPTS);
+}
+
+} // namespace
+
+void* heap_cache_alloc(size_t size, size_t* alloc_size) {
+    *alloc_size = size;
+
+    size_t c = alloc_class(size);
+    if (size == 0 || c == kNumClasses)
+        return nullptr;
+
+    spin_lock_saved_state_t state;
+    CpuCache* cache = lock_local_cache(&state);
+    Magazine* magazine = &cache->magazines[c];
+    void* ptr = nullptr;
+    if (magazine->count > 0)
+        ptr = magazine->blocks[--magazine->count];
+    unlock_cache(cache, state);
+
+    if (ptr) {
+        kcounter_add(kHitCounters[c], 1);
+    } else {
+        kcounter_add(kMissCounters[c], 1);
+        *alloc_size = kClassSizes[c];
+    }
+    return ptr;
+}
+
+bool heap_cache_free(void* ptr, size_t usable_size) {
+    size_t c = free_class(usable_size);
+    if (c == kNumClasses)
+        return false;
+
+    void* overflow[kMagazineSize / 2];
+    size_t overflow_count = 0;
+
+    spin_lock_saved_state_t state;
+    CpuCache* cache = lock_local_cache(&state);
+    Magazine* magazine = &cache->magazines[c];
+    if (magazine->count == kMagazineSize) {
+        overflow_count = fbl::count_of(overflow);
+        magazine->count -= overflow_count;
+        memcpy(overflow, &magazine->blocks[magazine->count], sizeof(overflow));
+    }
+    magazine->blocks[magazine->count++] = ptr;
+    unlock_cache(cache, state);
+
+    if (overflow_count) {
+        kcounter_add(kOverflowCounters[c], 1);
+        for (size_t i = 0; i < overflow_count; i++)
+            cmpct_free(overflow[i]);
+    }
+    return true;
+}
+
+void heap_cache_flush() {
+    for (CpuCache& cache : caches) {
+        for (Magazine& magazine : cache.magazines) {
+            void* blocks[kMagazineSize];
+            size_t count;
+
+            spin_lock_saved_state_t state;
+            spin_lock_irqsave(&cache.lock, state);
+            count = magazine.count;
+            memcpy(blocks, magazine.blocks, count * sizeof(void*));
+            magazine.count = 0;
+            spin_unlock_irqrestore(&cache.lock, state);
+
+            for (size_t i = 0; i < count; i++)
+                cmpct_free(blocks[i]);
+        }
+    }
+}
+
+void heap_cache_dump() {
+    printf("\tper-cpu cache, blocks per class:\n");
+    for (size_t cpu = 0; cpu < arch_max_num_cpus(); cpu++) {
+        printf("\t\tcpu %zu:", cpu);
+        for (size_t c = 0; c < kNumClasses; c++) {
+            // Racy, but this is only informative.
+            printf(" %zu:%zu", kClassSizes[c], caches[cpu].magazines[c].count);
+        }
+        printf("\n");
+    }
+}
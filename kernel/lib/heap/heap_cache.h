@@ -0,0 +1,31 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <stddef.h>
+
+// A per-cpu cache of freed small heap blocks, sitting between the heap
+// wrapper and cmpctmalloc. Blocks in the cache are still allocated as far as
+// cmpctmalloc is concerned, so they keep their header and can be handed out
+// again without taking the heap lock.
+
+// Returns a block of at least |size| bytes from the current cpu's cache, or
+// nullptr if |size| is not cached or the cache is empty. In the latter case,
+// |*alloc_size| is set to the size to request from cmpctmalloc so that the
+// block can be cached once freed.
+void* heap_cache_alloc(size_t size, size_t* alloc_size);
+
+// Offers |ptr|, whose usable size is |usable_size|, to the current cpu's
+// cache. Returns false if the block was not taken and must be freed to
+// cmpctmalloc.
+bool heap_cache_free(void* ptr, size_t usable_size);
+
+// Frees the blocks cached by every cpu to cmpctmalloc.
+void heap_cache_flush();
+
+// Prints how many blocks each cpu caches per size class.
+void heap_cache_dump();
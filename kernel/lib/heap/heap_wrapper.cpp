@@ -23,6 +23,8 @@
 #include <vm/pmm.h>
 #include <vm/vm.h>
 
+#include "heap_cache.h"
+
 #define LOCAL_TRACE 0
 
 #ifndef HEAP_PANIC_ON_ALLOC_FAIL
@@ -126,6 +128,26 @@ void dump_stats() {
     }
 }
 
+// small blocks go through the per-cpu caches first, see heap_cache.h
+void* heap_alloc(size_t size) {
+    if (HEAP_PERCPU_CACHE) {
+        size_t alloc_size;
+        void* ptr = heap_cache_alloc(size, &alloc_size);
+        if (ptr) {
+            return ptr;
+        }
+        size = alloc_size;
+    }
+    return cmpct_alloc(size);
+}
+
+void heap_free(void* ptr) {
+    if (HEAP_PERCPU_CACHE && ptr && heap_cache_free(ptr, cmpct_usable_size(ptr))) {
+        return;
+    }
+    cmpct_free(ptr);
+}
+
 } // namespace
 
 void heap_init() {
@@ -133,6 +155,9 @@ void heap_init() {
 }
 
 void heap_trim() {
+    if (HEAP_PERCPU_CACHE) {
+        heap_cache_flush();
+    }
     cmpct_trim();
 }
 
@@ -143,7 +168,7 @@ void* malloc(size_t size) {
 
     add_stat(__GET_CALLER(), size);
 
-    void* ptr = cmpct_alloc(size);
+    void* ptr = heap_alloc(size);
     if (unlikely(heap_trace)) {
         printf("caller %p malloc %zu -> %p\n", __GET_CALLER(), size, ptr);
     }
@@ -162,7 +187,7 @@ void* malloc_debug_caller_(size_t size, void* caller) {
 
     add_stat(caller, size);
 
-    void* ptr = cmpct_alloc(size);
+    void* ptr = heap_alloc(size);
     if (unlikely(heap_trace)) {
         printf("caller %p malloc %zu -> %p\n", caller, size, ptr);
     }
@@ -202,7 +227,7 @@ void* calloc(size_t count, size_t size) {
 
     size_t realsize = count * size;
 
-    void* ptr = cmpct_alloc(realsize);
+    void* ptr = heap_alloc(realsize);
     if (likely(ptr)) {
         memset(ptr, 0, realsize);
     }
@@ -239,11 +264,14 @@ void free(void* ptr) {
         printf("caller %p free %p\n", __GET_CALLER(), ptr);
     }
 
-    cmpct_free(ptr);
+    heap_free(ptr);
 }
 
 static void heap_dump(bool panic_time) {
     cmpct_dump(panic_time);
+    if (HEAP_PERCPU_CACHE) {
+        heap_cache_dump();
+    }
 }
 
 void heap_get_info(size_t* size_bytes, size_t* free_bytes) {
@@ -16,6 +16,12 @@ __BEGIN_CDECLS
 // define this to enable collection of all unique call sites with unique sizes
 #define HEAP_COLLECT_STATS 0
 
+// define this to 0 to send all small allocations straight to the heap
+// rather than through the per-cpu caches of freed blocks
+#ifndef HEAP_PERCPU_CACHE
+#define HEAP_PERCPU_CACHE 1
+#endif
+
 // standard heap definitions
 void *malloc(size_t size) __MALLOC;
 void *memalign(size_t boundary, size_t size) __MALLOC;
@@ -12,6 +12,7 @@ KERNEL_INCLUDES += $(LOCAL_DIR)/include
 MODULE := $(LOCAL_DIR)
 
 MODULE_SRCS += \
+	$(LOCAL_DIR)/heap_cache.cpp \
 	$(LOCAL_DIR)/heap_wrapper.cpp
 
 # use the cmpctmalloc heap implementation
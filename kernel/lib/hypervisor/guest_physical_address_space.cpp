@@ -8,6 +8,7 @@
 
 #include <fbl/alloc_checker.h>
 #include <kernel/range_check.h>
+#include <lib/counters.h>
 #include <vm/fault.h>
 #include <vm/vm_object_physical.h>
 
@@ -22,6 +23,13 @@ static constexpr uint kGuestMmuFlags =
     ARCH_MMU_FLAG_PERM_READ |
     ARCH_MMU_FLAG_PERM_WRITE;
 
+// The sizes of the aligned runs of guest physical memory we try to map in one
+// go, largest first, so that the arch layer can back them with 1GB and 2MB
+// entries.
+static constexpr size_t kLargeRunSizes[] = {1ul << 30, LARGE_PAGE_SIZE};
+
+KCOUNTER(guest_large_run_fault, "hypervisor.guest.large_run.fault");
+
 namespace hypervisor {
 
 zx_status_t GuestPhysicalAddressSpace::Create(
@@ -114,6 +122,53 @@ zx_status_t GuestPhysicalAddressSpace::GetPage(zx_gpaddr_t guest_paddr, zx_paddr
     return mapping->vmo()->Lookup(offset, PAGE_SIZE, kPfFlags, guest_lookup_page, host_paddr);
 }
 
+// If the VMO of |mapping| is backed by contiguous memory that can't be
+// decommitted, maps the largest aligned run around |guest_paddr| that lies
+// within both the mapping and the VMO, and whose memory is aligned as well.
+// Paged VMOs are left to the mapping, which maps them with large pages where
+// it can. Returns ZX_ERR_NOT_FOUND if there is no run to map.
+static zx_status_t MapLargeRun(ArchVmAspace* arch_aspace, VmMapping* mapping,
+                               zx_gpaddr_t guest_paddr) {
+    const fbl::RefPtr<VmObject>& vmo = mapping->vmo();
+    if (vmo->is_paged() && !vmo->is_contiguous()) {
+        return ZX_ERR_NOT_FOUND;
+    }
+    for (size_t run_size : kLargeRunSizes) {
+        const zx_gpaddr_t run_base = ROUNDDOWN(guest_paddr, run_size);
+        if (run_base < mapping->base() || !InRange(run_base - mapping->base(), run_size,
+                                                   mapping->size())) {
+            continue;
+        }
+        const uint64_t run_offset = mapping->object_offset() + (run_base - mapping->base());
+        if (!InRange(run_offset, run_size, vmo->size())) {
+            continue;
+        }
+        zx_paddr_t run_paddr;
+        zx_status_t status = vmo->Lookup(run_offset, PAGE_SIZE, 0, guest_lookup_page, &run_paddr);
+        if (status != ZX_OK || !IS_ALIGNED(run_paddr, run_size)) {
+            continue;
+        }
+
+        // Clear out any single pages mapped before, such as by a mapping that
+        // was faulting before the run could be looked up.
+        const size_t count = run_size / PAGE_SIZE;
+        status = arch_aspace->Unmap(run_base, count, nullptr);
+        if (status != ZX_OK) {
+            return status;
+        }
+        size_t mapped;
+        status = arch_aspace->MapContiguous(run_base, run_paddr, count, mapping->arch_mmu_flags(),
+                                            &mapped);
+        if (status != ZX_OK) {
+            return status;
+        }
+        DEBUG_ASSERT(mapped == count);
+        kcounter_add(guest_large_run_fault, 1);
+        return ZX_OK;
+    }
+    return ZX_ERR_NOT_FOUND;
+}
+
 zx_status_t GuestPhysicalAddressSpace::PageFault(zx_gpaddr_t guest_paddr) {
     fbl::RefPtr<VmMapping> mapping = FindMapping(RootVmar(), guest_paddr);
     if (!mapping) {
@@ -132,7 +187,11 @@ zx_status_t GuestPhysicalAddressSpace::PageFault(zx_gpaddr_t guest_paddr) {
         pf_flags |= VMM_PF_FLAG_INSTRUCTION;
     }
     Guard<fbl::Mutex> guard{guest_aspace_->lock()};
-    return mapping->PageFault(guest_paddr, pf_flags);
+    zx_status_t status = MapLargeRun(arch_aspace(), mapping.get(), guest_paddr);
+    if (status != ZX_ERR_NOT_FOUND) {
+        return status;
+    }
+    return mapping->PageFault(guest_paddr, pf_flags, nullptr);
 }
 
 zx_status_t GuestPhysicalAddressSpace::CreateGuestPtr(zx_gpaddr_t guest_paddr, size_t len,
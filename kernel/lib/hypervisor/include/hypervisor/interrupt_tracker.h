@@ -77,8 +77,19 @@ public:
         return ZX_OK;
     }
 
+    // Signals any waiters, for an interrupt that is tracked elsewhere.
+    void Signal() {
+        event_signal(&event_, true);
+    }
+
     // Waits for an interrupt.
     zx_status_t Wait(StateInvalidator* invalidator) {
+        return Wait(invalidator, [] { return false; });
+    }
+
+    // Waits for an interrupt, or for |pending| to return true after a signal.
+    template <typename F>
+    zx_status_t Wait(StateInvalidator* invalidator, F pending) {
         if (invalidator != nullptr) {
             invalidator->Invalidate();
         }
@@ -89,7 +100,7 @@ public:
                 ktrace_vcpu(TAG_VCPU_UNBLOCK, VCPU_INTERRUPT);
                 return ZX_ERR_CANCELED;
             }
-        } while (!Pending());
+        } while (!Pending() && !pending());
         ktrace_vcpu(TAG_VCPU_UNBLOCK, VCPU_INTERRUPT);
         return ZX_OK;
     }
@@ -9,12 +9,16 @@
 #include <fbl/alloc_checker.h>
 #include <fbl/auto_lock.h>
 #include <hypervisor/ktrace.h>
+#include <lib/counters.h>
 #include <lib/ktrace.h>
 #include <zircon/syscalls/hypervisor.h>
 #include <zircon/types.h>
 
 static constexpr size_t kMaxPacketsPerRange = 256;
 
+KCOUNTER(trap_bell_packets, "hypervisor.trap.bell_packets");
+KCOUNTER(trap_io_packets, "hypervisor.trap.io_packets");
+
 namespace hypervisor {
 
 BlockingPortAllocator::BlockingPortAllocator() : semaphore_(kMaxPacketsPerRange) {}
@@ -74,8 +78,14 @@ zx_status_t Trap::Queue(const zx_port_packet_t& packet, StateInvalidator* invali
     zx_status_t status = port_->Queue(port_packet, ZX_SIGNAL_NONE, 0);
     if (status != ZX_OK) {
         port_allocator_.Free(port_packet);
+        return status;
     }
-    return status;
+    if (kind_ == ZX_GUEST_TRAP_IO) {
+        kcounter_add(trap_io_packets, 1);
+    } else {
+        kcounter_add(trap_bell_packets, 1);
+    }
+    return ZX_OK;
 }
 
 zx_status_t TrapMap::InsertTrap(uint32_t kind, zx_gpaddr_t addr, size_t len,
@@ -6,12 +6,14 @@
 
 #include <debug.h>
 #include <err.h>
+#include <inttypes.h>
 #include <platform.h>
 #include <string.h>
 
 #include <arch/ops.h>
 #include <arch/user_copy.h>
 #include <hypervisor/ktrace.h>
+#include <kernel/align.h>
 #include <kernel/cmdline.h>
 #include <lib/ktrace.h>
 #include <lk/init.h>
@@ -19,7 +21,10 @@
 #include <vm/vm_aspace.h>
 #include <zircon/thread_annotations.h>
 
-#define ktrace_timestamp() current_ticks();
+#include <fbl/algorithm.h>
+#include <fbl/atomic.h>
+
+#define ktrace_timestamp() current_ticks()
 #define ktrace_ticks_per_ms() (ticks_per_second() / 1000)
 
 // Generated struct that has the syscall index and name.
@@ -67,6 +72,22 @@ static void ktrace_add_probe(ktrace_probe_info_t* probe) TA_REQ(probe_list_lock)
     ktrace_name_etc(TAG_PROBE_NAME, probe->num, 0, probe->name, true);
 }
 
+// Returns the probe called |name|, creating it if need be.
+static ktrace_probe_info_t* ktrace_new_probe(const char* name) TA_REQ(probe_list_lock) {
+    ktrace_probe_info_t* probe;
+    if ((probe = ktrace_find_probe(name)) != nullptr) {
+        return probe;
+    }
+    probe = (ktrace_probe_info_t*) calloc(sizeof(*probe) + ZX_MAX_NAME_LEN, 1);
+    if (probe == nullptr) {
+        return nullptr;
+    }
+    probe->name = (const char*) (probe + 1);
+    strlcpy((char*) (probe + 1), name, ZX_MAX_NAME_LEN);
+    ktrace_add_probe(probe);
+    return probe;
+}
+
 static void ktrace_report_probes(void) {
     fbl::AutoLock lock(&probe_list_lock);
     ktrace_probe_info_t *probe;
@@ -75,101 +96,187 @@ static void ktrace_report_probes(void) {
     }
 }
 
-typedef struct ktrace_state {
-    // where the next record will be written
-    int offset;
+// Records are written to a buffer per cpu so that tracing cores don't contend on a shared
+// write offset. Name records have no timestamp or cpu, so they go in a separate metadata
+// buffer along with the version and tick rate records.
+//
+// In circular mode a cpu buffer wraps and overwrites its oldest records. It is made of
+// fixed-size chunks that records never straddle; a record that would is replaced by padding,
+// so the oldest complete chunk always starts on a record boundary.
+static constexpr uint64_t kChunkSize = 64 * 1024;
 
+typedef struct ktrace_cpu_buffer {
+    // position where the next record will be written, counted from the start of the trace.
+    // in circular mode the buffer holds the bufsize bytes before it.
+    fbl::atomic<uint64_t> offset;
+
+    // position where tracing was stopped
+    uint64_t marker;
+
+    uint8_t* buffer;
+} __CPU_ALIGN ktrace_cpu_buffer_t;
+
+typedef struct ktrace_state {
     // mask of groups we allow, 0 == tracing disabled
     int grpmask;
 
-    // total size of the trace buffer
-    uint32_t bufsize;
+    // true if the cpu buffers wrap rather than stop tracing when full
+    bool circular;
 
-    // offset where tracing was stopped, 0 if tracing active
-    uint32_t marker;
+    // true if tracing was stopped and the markers are valid
+    bool marked;
 
-    // raw trace buffer
-    uint8_t* buffer;
+    // where the next metadata record will be written, and where tracing was stopped
+    int meta_offset;
+    uint32_t meta_marker;
+
+    // size of the metadata buffer and of each cpu buffer
+    uint32_t meta_bufsize;
+    uint64_t cpu_bufsize;
+    uint32_t cpu_count;
+
+    uint8_t* meta_buffer;
+    ktrace_cpu_buffer_t cpu[SMP_MAX_CPUS];
 } ktrace_state_t;
 
 static ktrace_state_t KTRACE_STATE;
 
-ssize_t ktrace_read_user(void* ptr, uint32_t off, size_t len) {
+// Calls |fn(data, len)| on each piece of the readable trace, in order, until it returns false:
+// the metadata, then for each cpu a CPU_BUFFER record giving the cpu number and the length of
+// the records that follow.
+template <typename F>
+static void ktrace_for_each_span(F fn) {
     ktrace_state_t* ks = &KTRACE_STATE;
 
-    // Buffer size is limited by the marker if set,
-    // otherwise limited by offset (last written point).
-    // Offset can end up pointing past the end, so clip
-    // it to the actual buffer size to be safe.
-    uint32_t max;
-    if (ks->marker) {
-        max = ks->marker;
-    } else {
-        max = ks->offset;
-        if (max > ks->bufsize) {
-            max = ks->bufsize;
-        }
+    // Limited by the marker if set, otherwise by the last written point, which can end up
+    // past the end of the buffer.
+    uint32_t meta_len = ks->marked ? ks->meta_marker : atomic_load(&ks->meta_offset);
+    if (meta_len > ks->meta_bufsize) {
+        meta_len = ks->meta_bufsize;
+    }
+    if (!fn(ks->meta_buffer, meta_len)) {
+        return;
     }
 
-    // null read is a query for trace buffer size
-    if (ptr == nullptr) {
-        return max;
+    for (uint32_t cpu = 0; cpu < ks->cpu_count; cpu++) {
+        ktrace_cpu_buffer_t* cb = &ks->cpu[cpu];
+        uint64_t head = ks->marked ? cb->marker : cb->offset.load();
+
+        uint64_t start = 0;
+        if (!ks->circular) {
+            head = fbl::min(head, ks->cpu_bufsize);
+        } else if (head > ks->cpu_bufsize) {
+            // skip the chunk being overwritten by the one at the head
+            start = ROUNDUP(head - ks->cpu_bufsize, kChunkSize);
+        }
+        uint64_t len = head - start;
+
+        ktrace_rec_32b_t rec = {};
+        rec.tag = TAG_CPU_BUFFER;
+        rec.a = cpu;
+        rec.b = static_cast<uint32_t>(len);
+        rec.c = static_cast<uint32_t>(len >> 32);
+        if (!fn(&rec, sizeof(rec))) {
+            return;
+        }
+
+        uint64_t first = start % ks->cpu_bufsize;
+        uint64_t first_len = fbl::min(len, ks->cpu_bufsize - first);
+        if (!fn(cb->buffer + first, first_len) ||
+            (first_len < len && !fn(cb->buffer, len - first_len))) {
+            return;
+        }
     }
+}
 
-    // constrain read to available buffer
-    if (off >= max) {
+ssize_t ktrace_read_user(void* ptr, uint32_t off, size_t len) {
+    if (KTRACE_STATE.meta_buffer == nullptr) {
         return 0;
     }
-    if (len > (max - off)) {
-        len = max - off;
+
+    // null read is a query for trace buffer size
+    if (ptr == nullptr) {
+        size_t total = 0;
+        ktrace_for_each_span([&total](const void*, size_t span_len) {
+            total += span_len;
+            return true;
+        });
+        return total;
     }
 
-    if (arch_copy_to_user(ptr, ks->buffer + off, len) != ZX_OK) {
+    // copy out the part of each span that overlaps the read
+    uint8_t* out = static_cast<uint8_t*>(ptr);
+    size_t pos = 0;
+    size_t copied = 0;
+    zx_status_t status = ZX_OK;
+    ktrace_for_each_span([&](const void* data, size_t span_len) {
+        if (pos + span_len > off) {
+            size_t skip = off > pos ? off - pos : 0;
+            size_t n = fbl::min(span_len - skip, len - copied);
+            status = arch_copy_to_user(out + copied, static_cast<const uint8_t*>(data) + skip, n);
+            if (status != ZX_OK) {
+                return false;
+            }
+            copied += n;
+        }
+        pos += span_len;
+        return copied < len;
+    });
+
+    if (status != ZX_OK) {
         return ZX_ERR_INVALID_ARGS;
     }
-    return len;
+    return copied;
+}
+
+static void ktrace_rewind_cpus(ktrace_state_t* ks) {
+    for (uint32_t cpu = 0; cpu < ks->cpu_count; cpu++) {
+        ks->cpu[cpu].offset.store(0);
+    }
 }
 
 zx_status_t ktrace_control(uint32_t action, uint32_t options, void* ptr) {
     ktrace_state_t* ks = &KTRACE_STATE;
     switch (action) {
     case KTRACE_ACTION_START:
+    case KTRACE_ACTION_START_CIRCULAR: {
+        bool circular = (action == KTRACE_ACTION_START_CIRCULAR);
         options = KTRACE_GRP_TO_MASK(options);
-        ks->marker = 0;
+        ks->marked = false;
+        if (circular != ks->circular) {
+            // records written in the other mode can't be read back in this one
+            ks->circular = circular;
+            ktrace_rewind_cpus(ks);
+        }
         atomic_store(&ks->grpmask, options ? options : KTRACE_GRP_TO_MASK(KTRACE_GRP_ALL));
         ktrace_report_live_processes();
         ktrace_report_live_threads();
         break;
+    }
     case KTRACE_ACTION_STOP: {
         atomic_store(&ks->grpmask, 0);
-        uint32_t n = ks->offset;
-        if (n > ks->bufsize) {
-            ks->marker = ks->bufsize;
-        } else {
-            ks->marker = n;
+        uint32_t n = atomic_load(&ks->meta_offset);
+        ks->meta_marker = fbl::min(n, ks->meta_bufsize);
+        for (uint32_t cpu = 0; cpu < ks->cpu_count; cpu++) {
+            ks->cpu[cpu].marker = ks->cpu[cpu].offset.load();
         }
+        ks->marked = true;
         break;
     }
     case KTRACE_ACTION_REWIND:
         // roll back to just after the metadata
-        atomic_store(&ks->offset, KTRACE_RECSIZE * 2);
+        atomic_store(&ks->meta_offset, KTRACE_RECSIZE * 2);
+        ktrace_rewind_cpus(ks);
         ktrace_report_syscalls(kt_syscall_info);
         ktrace_report_probes();
         ktrace_report_vcpu_meta();
         break;
     case KTRACE_ACTION_NEW_PROBE: {
         fbl::AutoLock lock(&probe_list_lock);
-        ktrace_probe_info_t* probe;
-        if ((probe = ktrace_find_probe((const char*) ptr)) != nullptr) {
-            return probe->num;
-        }
-        probe = (ktrace_probe_info_t*) calloc(sizeof(*probe) + ZX_MAX_NAME_LEN, 1);
+        ktrace_probe_info_t* probe = ktrace_new_probe((const char*) ptr);
         if (probe == nullptr) {
             return ZX_ERR_NO_MEMORY;
         }
-        probe->name = (const char*) (probe + 1);
-        memcpy(probe + 1, ptr, ZX_MAX_NAME_LEN);
-        ktrace_add_probe(probe);
         return probe->num;
     }
     default:
@@ -180,6 +287,74 @@ zx_status_t ktrace_control(uint32_t action, uint32_t options, void* ptr) {
 
 int trace_not_ready = 0;
 
+// Boot spans recorded before ktrace_init(), when there is neither a trace buffer nor a
+// heap to make probes with. ktrace_init() replays them into the trace with their original
+// timestamps. Until then only the boot cpu may record spans.
+struct early_boot_span {
+    const char* category;
+    const char* name;
+    uint64_t ts;
+    uint32_t phase;
+    uint32_t arg;
+};
+
+static constexpr uint32_t kMaxEarlyBootSpans = 512;
+static early_boot_span early_boot_spans[kMaxEarlyBootSpans];
+static uint32_t early_boot_span_count;
+
+// set once the trace is ready for boot spans to go straight into it
+static fbl::atomic<bool> boot_spans_live;
+
+static void* ktrace_open_etc(uint32_t tag, uint64_t ts, uint32_t tid);
+
+static void ktrace_write_boot_span(const char* category, const char* name, uint64_t ts,
+                                   uint32_t tid, uint32_t phase, uint32_t arg) {
+    char probe_name[ZX_MAX_NAME_LEN];
+    snprintf(probe_name, sizeof(probe_name), KTRACE_BOOT_PREFIX "%s:%s", category, name);
+
+    uint32_t num;
+    {
+        fbl::AutoLock lock(&probe_list_lock);
+        ktrace_probe_info_t* probe = ktrace_new_probe(probe_name);
+        if (probe == nullptr) {
+            return;
+        }
+        num = probe->num;
+    }
+
+    uint32_t* args = static_cast<uint32_t*>(ktrace_open_etc(TAG_PROBE_24(num), ts, tid));
+    if (args != nullptr) {
+        args[0] = phase;
+        args[1] = arg;
+    }
+}
+
+void ktrace_boot_span(const char* category, const char* name, uint32_t phase, uint32_t arg) {
+    if (boot_spans_live.load()) {
+        ktrace_write_boot_span(category, name, ktrace_timestamp(),
+                               (uint32_t)get_current_thread()->user_tid, phase, arg);
+        return;
+    }
+    if (early_boot_span_count < kMaxEarlyBootSpans) {
+        early_boot_span* span = &early_boot_spans[early_boot_span_count++];
+        span->category = category;
+        span->name = name;
+        span->ts = ktrace_timestamp();
+        span->phase = phase;
+        span->arg = arg;
+    }
+}
+
+static void ktrace_replay_early_boot_spans() {
+    for (uint32_t n = 0; n < early_boot_span_count; n++) {
+        const early_boot_span* span = &early_boot_spans[n];
+        ktrace_write_boot_span(span->category, span->name, span->ts, 0, span->phase, span->arg);
+    }
+    if (early_boot_span_count == kMaxEarlyBootSpans) {
+        dprintf(INFO, "ktrace: early boot span buffer overflowed\n");
+    }
+}
+
 void ktrace_init(unsigned level) {
     ktrace_state_t* ks = &KTRACE_STATE;
 
@@ -193,19 +368,36 @@ void ktrace_init(unsigned level) {
 
     mb *= (1024*1024);
 
+    // a sixteenth goes to names and the rest is shared between the cpus in whole chunks
+    uint32_t cpu_count = arch_max_num_cpus();
+    uint32_t meta_size = ROUNDUP(mb / 16, PAGE_SIZE);
+    uint64_t cpu_size = ROUNDDOWN((mb - meta_size) / cpu_count, kChunkSize);
+    if (cpu_size == 0) {
+        dprintf(INFO, "ktrace: buffer too small for %u cpus\n", cpu_count);
+        return;
+    }
+    size_t size = meta_size + cpu_size * cpu_count;
+
     zx_status_t status;
+    uint8_t* buffer;
     VmAspace* aspace = VmAspace::kernel_aspace();
-    if ((status = aspace->Alloc("ktrace", mb, (void**)&ks->buffer, 0, VmAspace::VMM_FLAG_COMMIT,
+    if ((status = aspace->Alloc("ktrace", size, (void**)&buffer, 0, VmAspace::VMM_FLAG_COMMIT,
                                 ARCH_MMU_FLAG_PERM_READ | ARCH_MMU_FLAG_PERM_WRITE)) < 0) {
         dprintf(INFO, "ktrace: cannot alloc buffer %d\n", status);
         return;
     }
 
-    // The last packet written can overhang the end of the buffer,
-    // so we reduce the reported size by the max size of a record
-    ks->bufsize = mb - 256;
+    ks->meta_buffer = buffer;
+    ks->meta_bufsize = meta_size;
+    ks->cpu_bufsize = cpu_size;
+    ks->cpu_count = cpu_count;
+    for (uint32_t cpu = 0; cpu < cpu_count; cpu++) {
+        ks->cpu[cpu].buffer = buffer + meta_size + cpu_size * cpu;
+    }
+    ks->circular = cmdline_get_bool("ktrace.circular", false);
 
-    dprintf(INFO, "ktrace: buffer at %p (%u bytes)\n", ks->buffer, mb);
+    dprintf(INFO, "ktrace: buffer at %p (%zu bytes, %" PRIu64 " per cpu%s)\n", buffer, size,
+            cpu_size, ks->circular ? ", circular" : "");
 
     // register all static probes
     {
@@ -219,7 +411,7 @@ void ktrace_init(unsigned level) {
 
     // write metadata to the first two event slots
     uint64_t n = ktrace_ticks_per_ms();
-    ktrace_rec_32b_t* rec = (ktrace_rec_32b_t*) ks->buffer;
+    ktrace_rec_32b_t* rec = (ktrace_rec_32b_t*) ks->meta_buffer;
     rec[0].tag = TAG_VERSION;
     rec[0].a = KTRACE_VERSION;
     rec[1].tag = TAG_TICKS_PER_MS;
@@ -227,7 +419,7 @@ void ktrace_init(unsigned level) {
     rec[1].b = (uint32_t)(n >> 32);
 
     // enable tracing
-    atomic_store(&ks->offset, KTRACE_RECSIZE * 2);
+    atomic_store(&ks->meta_offset, KTRACE_RECSIZE * 2);
     ktrace_report_syscalls(kt_syscall_info);
     ktrace_report_probes();
     atomic_store(&ks->grpmask, KTRACE_GRP_TO_MASK(grpmask));
@@ -238,6 +430,10 @@ void ktrace_init(unsigned level) {
     // report metadata for VCPUs
     ktrace_report_vcpu_meta();
 
+    // catch up on the boot timeline so far
+    ktrace_replay_early_boot_spans();
+    boot_spans_live.store(true);
+
     // Report an event for "tracing is all set up now".  This also
     // serves to ensure that there will be at least one static probe
     // entry so that the __{start,stop}_ktrace_probe symbols above
@@ -245,16 +441,52 @@ void ktrace_init(unsigned level) {
     ktrace_probe0("ktrace_ready");
 }
 
+// Fills |len| bytes at trace position |pos| of |cb| with a padding record.
+static void ktrace_pad(ktrace_state_t* ks, ktrace_cpu_buffer_t* cb, uint64_t pos, uint32_t len) {
+    uint32_t* tag = reinterpret_cast<uint32_t*>(cb->buffer + pos % ks->cpu_bufsize);
+    *tag = KTRACE_TAG_PAD(len);
+}
+
+// Claims |len| bytes for a record in the current cpu's buffer. Returns nullptr, and stops
+// tracing, if the buffer is full.
+static void* ktrace_reserve(ktrace_state_t* ks, uint32_t len) {
+    if (ks->cpu_count == 0) {
+        return nullptr;
+    }
+
+    // A thread may migrate after picking the buffer; the offset is atomic, so at worst it
+    // writes to another cpu's buffer.
+    ktrace_cpu_buffer_t* cb = &ks->cpu[arch_curr_cpu_num()];
+    for (;;) {
+        uint64_t pos = cb->offset.fetch_add(len);
+        if (!ks->circular) {
+            if (pos + len > ks->cpu_bufsize) {
+                // if we arrive at the end, stop
+                atomic_store(&ks->grpmask, 0);
+                return nullptr;
+            }
+            return cb->buffer + pos;
+        }
+
+        uint64_t in_chunk = pos % kChunkSize;
+        if (in_chunk + len <= kChunkSize) {
+            return cb->buffer + pos % ks->cpu_bufsize;
+        }
+
+        // the record would straddle two chunks; pad out what we claimed on both sides of the
+        // boundary and try again in the next one
+        uint32_t before = static_cast<uint32_t>(kChunkSize - in_chunk);
+        ktrace_pad(ks, cb, pos, before);
+        ktrace_pad(ks, cb, pos + before, len - before);
+    }
+}
+
 void ktrace_tiny(uint32_t tag, uint32_t arg) {
     ktrace_state_t* ks = &KTRACE_STATE;
     if (tag & atomic_load(&ks->grpmask)) {
         tag = (tag & 0xFFFFFFF0) | 2;
-        int off;
-        if ((off = atomic_add(&ks->offset, KTRACE_HDRSIZE)) >= (int)ks->bufsize) {
-            // if we arrive at the end, stop
-            atomic_store(&ks->grpmask, 0);
-        } else {
-            ktrace_header_t* hdr = (ktrace_header_t*) (ks->buffer + off);
+        ktrace_header_t* hdr = static_cast<ktrace_header_t*>(ktrace_reserve(ks, KTRACE_HDRSIZE));
+        if (hdr != nullptr) {
             hdr->ts = ktrace_timestamp();
             hdr->tag = tag;
             hdr->tid = arg;
@@ -262,26 +494,27 @@ void ktrace_tiny(uint32_t tag, uint32_t arg) {
     }
 }
 
-void* ktrace_open(uint32_t tag) {
+static void* ktrace_open_etc(uint32_t tag, uint64_t ts, uint32_t tid) {
     ktrace_state_t* ks = &KTRACE_STATE;
     if (!(tag & atomic_load(&ks->grpmask))) {
         return nullptr;
     }
 
-    int off;
-    if ((off = atomic_add(&ks->offset, KTRACE_LEN(tag))) >= (int)ks->bufsize) {
-        // if we arrive at the end, stop
-        atomic_store(&ks->grpmask, 0);
+    ktrace_header_t* hdr = static_cast<ktrace_header_t*>(ktrace_reserve(ks, KTRACE_LEN(tag)));
+    if (hdr == nullptr) {
         return nullptr;
     }
 
-    ktrace_header_t* hdr = (ktrace_header_t*) (ks->buffer + off);
-    hdr->ts = ktrace_timestamp();
+    hdr->ts = ts;
     hdr->tag = tag;
-    hdr->tid = (uint32_t)get_current_thread()->user_tid;
+    hdr->tid = tid;
     return hdr + 1;
 }
 
+void* ktrace_open(uint32_t tag) {
+    return ktrace_open_etc(tag, ktrace_timestamp(), (uint32_t)get_current_thread()->user_tid);
+}
+
 void ktrace_name_etc(uint32_t tag, uint32_t id, uint32_t arg, const char* name, bool always) {
     ktrace_state_t* ks = &KTRACE_STATE;
     if ((tag & atomic_load(&ks->grpmask)) || always) {
@@ -290,12 +523,11 @@ void ktrace_name_etc(uint32_t tag, uint32_t id, uint32_t arg, const char* name,
         // set size to: sizeof(hdr) + len + 1, round up to multiple of 8
         tag = (tag & 0xFFFFFFF0) | ((KTRACE_NAMESIZE + len + 1 + 7) >> 3);
 
+        // names are dropped once the metadata buffer is full, the cpu buffers carry on
+        int len_rec = KTRACE_LEN(tag);
         int off;
-        if ((off = atomic_add(&ks->offset, KTRACE_LEN(tag))) >= (int)ks->bufsize) {
-            // if we arrive at the end, stop
-            atomic_store(&ks->grpmask, 0);
-        } else {
-            ktrace_rec_name_t* rec = (ktrace_rec_name_t*) (ks->buffer + off);
+        if ((off = atomic_add(&ks->meta_offset, len_rec)) + len_rec <= (int)ks->meta_bufsize) {
+            ktrace_rec_name_t* rec = (ktrace_rec_name_t*) (ks->meta_buffer + off);
             rec->tag = tag;
             rec->id = id;
             rec->arg = arg;
@@ -305,4 +537,5 @@ void ktrace_name_etc(uint32_t tag, uint32_t id, uint32_t arg, const char* name,
     }
 }
 
-LK_INIT_HOOK(ktrace, ktrace_init, LK_INIT_LEVEL_USER);
+// Just before userboot, so that its boot spans go straight into the trace.
+LK_INIT_HOOK(ktrace, ktrace_init, LK_INIT_LEVEL_USER - 1);
@@ -9,7 +9,9 @@
 #include <kernel/event.h>
 #include <kernel/percpu.h>
 #include <kernel/thread.h>
+#include <lib/ktrace.h>
 #include <lk/init.h>
+#include <platform.h>
 #include <vm/vm.h>
 
 #include <lib/console.h>
@@ -18,6 +20,7 @@
 #include <inttypes.h>
 #include <string.h>
 
+#include <fbl/algorithm.h>
 #include <fbl/atomic.h>
 #include <fbl/new.h>
 #include <lockdep/lockdep.h>
@@ -81,6 +84,95 @@ void DumpLockClassState() {
     }
 }
 
+#if LOCK_DEP_ENABLE_PROFILING
+
+// The id used for a lock class in ktrace records. Lock class states live in the
+// kernel image, so the low bits of their addresses are unique.
+uint32_t KtraceLockClassId(const lockdep::LockClassState& state) {
+    return static_cast<uint32_t>(state.id());
+}
+
+// Dumps the contention statistics of every lock class that has been contended,
+// most waited-for first.
+void DumpLockProfile() {
+    printf("Lock contention (threshold %" PRIu64 "ns):\n", lockdep::kLockContentionThresholdNs);
+
+    // Repeatedly pick the class with the most wait time below the last one
+    // printed; there are only a few hundred classes and this needs no memory.
+    uint64_t limit = UINT64_MAX;
+    const lockdep::LockClassState* last = nullptr;
+    while (true) {
+        const lockdep::LockClassState* next = nullptr;
+        uint64_t next_wait = 0;
+        bool past_last = (last == nullptr);
+        for (auto& state : lockdep::LockClassState::Iter()) {
+            if (&state == last) {
+                past_last = true;
+                continue;
+            }
+            const auto& profile = state.profile();
+            uint64_t wait = profile.wait_ns.load(fbl::memory_order_relaxed);
+            if (profile.contended.load(fbl::memory_order_relaxed) == 0)
+                continue;
+            // Ties with the last class printed are taken in list order.
+            if (wait > limit || (wait == limit && !past_last))
+                continue;
+            if (next == nullptr || wait > next_wait) {
+                next = &state;
+                next_wait = wait;
+            }
+        }
+        if (next == nullptr)
+            break;
+
+        const auto& profile = next->profile();
+        printf("  %s\n", next->name());
+        printf("    acquisitions %" PRIu64 " contended %" PRIu64
+               " wait %" PRIu64 "us max %" PRIu64 "us\n",
+               profile.acquisitions.load(fbl::memory_order_relaxed),
+               profile.contended.load(fbl::memory_order_relaxed),
+               next_wait / 1000,
+               profile.max_wait_ns.load(fbl::memory_order_relaxed) / 1000);
+        for (const auto& site : profile.call_sites) {
+            uintptr_t address = site.address.load(fbl::memory_order_relaxed);
+            if (address == 0)
+                break;
+            printf("    caller %#" PRIxPTR " contended %" PRIu64 " wait %" PRIu64 "us\n",
+                   address, site.contended.load(fbl::memory_order_relaxed),
+                   site.wait_ns.load(fbl::memory_order_relaxed) / 1000);
+        }
+        uint64_t other = profile.other_contended.load(fbl::memory_order_relaxed);
+        if (other != 0) {
+            printf("    other callers contended %" PRIu64 " wait %" PRIu64 "us\n", other,
+                   profile.other_wait_ns.load(fbl::memory_order_relaxed) / 1000);
+        }
+
+        limit = next_wait;
+        last = next;
+    }
+}
+
+// Writes the name and contention totals of every lock class to the trace.
+void TraceLockProfile() {
+    for (auto& state : lockdep::LockClassState::Iter()) {
+        const auto& profile = state.profile();
+        const uint32_t id = KtraceLockClassId(state);
+        ktrace_name(TAG_LOCK_CLASS_NAME, id, 0, state.name());
+        ktrace(TAG_LOCK_PROFILE, id,
+               static_cast<uint32_t>(profile.acquisitions.load(fbl::memory_order_relaxed)),
+               static_cast<uint32_t>(profile.contended.load(fbl::memory_order_relaxed)),
+               static_cast<uint32_t>(profile.wait_ns.load(fbl::memory_order_relaxed) / 1000));
+    }
+}
+
+void ResetLockProfile() {
+    for (auto& state : lockdep::LockClassState::Iter()) {
+        state.ResetProfile();
+    }
+}
+
+#endif // LOCK_DEP_ENABLE_PROFILING
+
 // Top-level lockdep command.
 int CommandLockDep(int argc, const cmd_args* argv, uint32_t flags) {
     if (argc < 2) {
@@ -88,6 +180,11 @@ int CommandLockDep(int argc, const cmd_args* argv, uint32_t flags) {
     usage:
         printf("%s dump              : dump lock classes\n", argv[0].str);
         printf("%s loop              : trigger loop detection pass\n", argv[0].str);
+#if LOCK_DEP_ENABLE_PROFILING
+        printf("%s prof              : dump lock contention\n", argv[0].str);
+        printf("%s prof ktrace       : write lock contention to ktrace\n", argv[0].str);
+        printf("%s prof reset        : clear lock contention\n", argv[0].str);
+#endif
         return -1;
     }
 
@@ -96,6 +193,19 @@ int CommandLockDep(int argc, const cmd_args* argv, uint32_t flags) {
     } else if (strcmp(argv[1].str, "loop") == 0) {
         printf("Triggering loop detection pass:\n");
         lockdep::SystemTriggerLoopDetection();
+#if LOCK_DEP_ENABLE_PROFILING
+    } else if (strcmp(argv[1].str, "prof") == 0) {
+        if (argc < 3) {
+            DumpLockProfile();
+        } else if (strcmp(argv[2].str, "ktrace") == 0) {
+            TraceLockProfile();
+        } else if (strcmp(argv[2].str, "reset") == 0) {
+            ResetLockProfile();
+        } else {
+            printf("Unrecognized subcommand: '%s'\n", argv[2].str);
+            goto usage;
+        }
+#endif
     } else {
         printf("Unrecognized subcommand: '%s'\n", argv[1].str);
         goto usage;
@@ -204,6 +314,24 @@ void SystemTriggerLoopDetection() {
     event_signal(&graph_edge_event, /*reschedule=*/false);
 }
 
+#if LOCK_DEP_ENABLE_PROFILING
+
+// Returns the timestamp used to time lock acquisitions.
+uint64_t SystemGetLockProfileTimestamp() {
+    return current_time();
+}
+
+// Records a contended acquisition in the trace. ktrace writes are lock free, so
+// this cannot recurse into the profiler.
+void SystemLockContended(LockClassState* lock_class, uint64_t wait_ns, void* caller_address) {
+    const uintptr_t caller = reinterpret_cast<uintptr_t>(caller_address);
+    ktrace(TAG_LOCK_CONTENDED, KtraceLockClassId(*lock_class),
+           static_cast<uint32_t>(fbl::min<uint64_t>(wait_ns, UINT32_MAX)),
+           static_cast<uint32_t>(caller >> 32), static_cast<uint32_t>(caller));
+}
+
+#endif // LOCK_DEP_ENABLE_PROFILING
+
 } // namespace lockdep
 
 #endif
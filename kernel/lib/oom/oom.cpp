@@ -12,6 +12,7 @@
 #include <lib/console.h>
 #include <platform.h>
 #include <pretty/sizes.h>
+#include <vm/page_reclaim.h>
 #include <vm/pmm.h>
 #include <zircon/errors.h>
 #include <zircon/time.h>
@@ -57,6 +58,7 @@ static int oom_loop(void* arg) {
         const size_t free_bytes = pmm_count_free_pages() * PAGE_SIZE;
 
         bool lowmem = false;
+        bool simulated = false;
         bool printing = false;
         size_t shortfall_bytes = 0;
         oom_lowmem_callback_t* lowmem_callback = nullptr;
@@ -70,6 +72,7 @@ static int oom_loop(void* arg) {
                 printf("OOM: simulating low-memory situation\n");
             }
             lowmem = free_bytes < oom_redline_bytes || oom_simulate_lowmem;
+            simulated = oom_simulate_lowmem;
             if (lowmem) {
                 shortfall_bytes =
                     oom_simulate_lowmem
@@ -107,7 +110,17 @@ static int oom_loop(void* arg) {
         last_free_bytes = free_bytes;
 
         if (lowmem) {
-            lowmem_callback(shortfall_bytes);
+            // Evicting pages nobody has touched in a while is much cheaper
+            // than killing something, so only fall back to that when it does
+            // not free enough. A simulated event exercises the fallback.
+            const size_t shortfall_pages = ROUNDUP(shortfall_bytes, PAGE_SIZE) / PAGE_SIZE;
+            const size_t reclaimed_pages = simulated ? 0 : vm_reclaim_pages(shortfall_pages);
+            if (reclaimed_pages > 0) {
+                printf("OOM: reclaimed %zu of %zu pages\n", reclaimed_pages, shortfall_pages);
+            }
+            if (reclaimed_pages < shortfall_pages) {
+                lowmem_callback((shortfall_pages - reclaimed_pages) * PAGE_SIZE);
+            }
         }
 
         thread_sleep_relative(sleep_duration_ns);
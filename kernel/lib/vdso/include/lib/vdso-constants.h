@@ -16,7 +16,7 @@
 // hash. There is also a 4 byte 'git-' prefix, and possibly a 6 byte
 // '-dirty' suffix. Let's be generous and use 64 bytes.
 #define MAX_BUILDID_SIZE 64
-#define VDSO_CONSTANTS_SIZE (4 * 4 + 2 * 8 + MAX_BUILDID_SIZE)
+#define VDSO_CONSTANTS_SIZE (8 * 4 + 2 * 8 + MAX_BUILDID_SIZE)
 
 #ifndef __ASSEMBLER__
 
@@ -47,6 +47,19 @@ struct vdso_constants {
     // Number of bytes in an instruction cache line.
     uint32_t icache_line_size;
 
+    // Nonzero if ZX_CLOCK_MONOTONIC is exactly the zx_ticks_get counter
+    // scaled by ns_per_tick, so the vDSO can compute it without entering
+    // the kernel.  When zero, the vDSO time calls use the syscalls.
+    uint32_t clock_monotonic_via_ticks;
+
+    // Nanoseconds per tick, in the layout of the kernel's struct fp_32_64:
+    // the integer part followed by two 32-bit words of fraction.
+    struct {
+        uint32_t l0;
+        uint32_t l32;
+        uint32_t l64;
+    } ns_per_tick;
+
     // Conversion factor for zx_ticks_get return values to seconds.
     zx_ticks_t ticks_per_second;
 
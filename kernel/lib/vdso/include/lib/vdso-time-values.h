@@ -0,0 +1,39 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#pragma once
+
+// This file is used both in the kernel and in the vDSO implementation.
+// So it must be compatible with both the kernel and userland header
+// environments.  It must use only the basic types so that struct
+// layouts match exactly in both contexts.
+
+#define VDSO_TIME_VALUES_ALIGN 8
+#define VDSO_TIME_VALUES_SIZE (2 * 8)
+
+#ifndef __ASSEMBLER__
+
+#include <stdint.h>
+
+// Unlike vdso_constants, this struct is updated by the kernel while
+// processes are using it, so every vDSO VMO sees the new values.  The
+// kernel bumps |seq| to an odd value before it changes anything and to
+// the next even value once it is done.  Readers retry until they see
+// the same even |seq| before and after reading the other members.
+struct vdso_time_values {
+    uint64_t seq;
+
+    // The value added to ZX_CLOCK_MONOTONIC to get ZX_CLOCK_UTC,
+    // as set by zx_clock_adjust.
+    int64_t utc_offset;
+};
+
+static_assert(VDSO_TIME_VALUES_SIZE == sizeof(vdso_time_values),
+              "Need to adjust VDSO_TIME_VALUES_SIZE");
+static_assert(VDSO_TIME_VALUES_ALIGN == alignof(vdso_time_values),
+              "Need to adjust VDSO_TIME_VALUES_ALIGN");
+
+#endif // __ASSEMBLER__
@@ -10,6 +10,7 @@
 #include <vm/vm_object.h>
 
 class VmMapping;
+struct vdso_time_values;
 
 class VDso : public RoDso {
 public:
@@ -24,6 +25,11 @@ public:
         return instance_->RoDso::valid_code_mapping(vmo_offset, size);
     }
 
+    // Publish a new ZX_CLOCK_UTC offset to every vDSO.  Callers must
+    // serialize calls and must not be preemptible, since vDSO readers
+    // spin while an update is in progress.
+    static void SetUtcOffset(int64_t offset);
+
     // Given VmAspace::vdso_code_mapping_, return the vDSO base address or 0.
     static uintptr_t base_address(const fbl::RefPtr<VmMapping>& code_mapping);
 
@@ -69,6 +75,9 @@ private:
         return static_cast<size_t>(v) - 1;
     }
 
+    // Kernel mappings of the vdso_time_values struct, indexed by Variant.
+    vdso_time_values* time_values_[static_cast<size_t>(Variant::COUNT)] = {};
+
     fbl::RefPtr<VmObjectDispatcher> variant_vmo_[
         static_cast<size_t>(Variant::COUNT) - 1];
 
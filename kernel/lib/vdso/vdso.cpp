@@ -6,10 +6,12 @@
 
 #include <lib/vdso.h>
 #include <lib/vdso-constants.h>
+#include <lib/vdso-time-values.h>
 
 #include <fbl/alloc_checker.h>
 #include <fbl/type_support.h>
 #include <kernel/cmdline.h>
+#include <lib/fixed_point.h>
 #include <object/handle.h>
 #include <platform.h>
 #include <vm/pmm.h>
@@ -200,6 +202,23 @@ void blacklist_##category##_syscalls(VDsoDynSymWindow& dynsym_window, \
 #undef SYSCALL_IN_CATEGORY_END
 #undef SYSCALL_CATEGORY_END
 
+// Map a window onto the vdso_time_values struct in the given vDSO VMO and
+// initialize it.  The window is never destroyed, so the kernel mapping of
+// that page stays in place and VDso::SetUtcOffset never takes a fault.
+vdso_time_values* CreateTimeValuesWindow(fbl::RefPtr<VmObject> vmo) {
+    static_assert(sizeof(vdso_time_values) == VDSO_DATA_TIME_VALUES_SIZE,
+                  "gen-rodso-code.sh is suspect");
+    fbl::AllocChecker ac;
+    auto window = new(&ac) KernelVmoWindow<vdso_time_values>(
+        "vDSO time values", fbl::move(vmo), VDSO_DATA_TIME_VALUES);
+    ASSERT(ac.check());
+    *window->data() = (vdso_time_values) {
+        0,
+        0,
+    };
+    return window->data();
+}
+
 } // anonymous namespace
 
 const VDso* VDso::instance_ = NULL;
@@ -223,6 +242,12 @@ const VDso* VDso::Create() {
         "vDSO constants", vdso->vmo()->vmo(), VDSO_DATA_CONSTANTS);
     zx_ticks_t per_second = ticks_per_second();
 
+    // The vDSO can compute ZX_CLOCK_MONOTONIC by itself only when the
+    // kernel's clock is the same counter zx_ticks_get reads.
+    struct fp_32_64 ns_per_tick = {};
+    bool via_ticks = per_second != 0 && ticks_to_time_factor(&ns_per_tick) &&
+        !cmdline_get_bool("vdso.kernel_clock", false);
+
     // Initialize the constants that should be visible to the vDSO.
     // Rather than assigning each member individually, do this with
     // struct assignment and a compound literal so that the compiler
@@ -232,6 +257,8 @@ const VDso* VDso::Create() {
         {arch_cpu_features()},
         arch_dcache_line_size(),
         arch_icache_line_size(),
+        via_ticks,
+        {ns_per_tick.l0, ns_per_tick.l32, ns_per_tick.l64},
         per_second,
         pmm_count_total_bytes(),
         BUILDID,
@@ -248,6 +275,9 @@ const VDso* VDso::Create() {
         REDIRECT_SYSCALL(dynsym_window, zx_ticks_get, soft_ticks_get);
     }
 
+    vdso->time_values_[static_cast<size_t>(Variant::FULL)] =
+        CreateTimeValuesWindow(vdso->vmo()->vmo());
+
     for (size_t v = static_cast<size_t>(Variant::FULL) + 1;
          v < static_cast<size_t>(Variant::COUNT);
          ++v)
@@ -257,6 +287,19 @@ const VDso* VDso::Create() {
     return instance_;
 }
 
+// The writer side of the sequence lock described in vdso-time-values.h.
+// Every vDSO VMO has its own copy of the page, so each one is updated.
+void VDso::SetUtcOffset(int64_t offset) {
+    DEBUG_ASSERT(instance_);
+    for (vdso_time_values* values : instance_->time_values_) {
+        uint64_t seq = __atomic_load_n(&values->seq, __ATOMIC_RELAXED);
+        __atomic_store_n(&values->seq, seq + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        __atomic_store_n(&values->utc_offset, offset, __ATOMIC_RELAXED);
+        __atomic_store_n(&values->seq, seq + 2, __ATOMIC_RELEASE);
+    }
+}
+
 uintptr_t VDso::base_address(const fbl::RefPtr<VmMapping>& code_mapping) {
     return code_mapping ? code_mapping->base() - VDSO_CODE_START : 0;
 }
@@ -313,6 +356,10 @@ void VDso::CreateVariant(Variant variant) {
         PANIC("VDso::CreateVariant called with bad variant");
     }
 
+    // Writing the time values now gives the clone its own copy of that
+    // page before any process can map it.
+    time_values_[static_cast<size_t>(variant)] = CreateTimeValuesWindow(new_vmo);
+
     fbl::RefPtr<Dispatcher> dispatcher;
     zx_rights_t rights;
     status = VmObjectDispatcher::Create(fbl::move(new_vmo),
@@ -6,6 +6,108 @@
 
 #include <object/buffer_chain.h>
 
+#include <kernel/align.h>
+#include <kernel/lockdep.h>
+#include <kernel/spinlock.h>
+#include <lib/counters.h>
+
+KCOUNTER(buffer_pool_hit, "kernel.buffer_chain.pool.hit");
+KCOUNTER(buffer_pool_miss, "kernel.buffer_chain.pool.miss");
+KCOUNTER(buffer_pool_overflow, "kernel.buffer_chain.pool.overflow");
+KCOUNTER(buffer_pool_trimmed, "kernel.buffer_chain.pool.trimmed");
+
+namespace {
+
+// Each cpu pools at most this many pages, which covers several messages of the largest size in
+// flight at once.
+constexpr size_t kPoolCapacity = 64;
+
+struct PagePool {
+    DECLARE_SPINLOCK(PagePool) lock;
+    list_node pages TA_GUARDED(lock) = LIST_INITIAL_VALUE(pages);
+    size_t count TA_GUARDED(lock) = 0;
+} __CPU_ALIGN;
+
+// Like the pmm's page caches, it doesn't matter if we migrate after picking a pool; the lock keeps
+// things consistent and being off by a cpu is harmless.
+PagePool page_pools[SMP_MAX_CPUS];
+
+} // namespace
+
+zx_status_t BufferChain::AllocPages(size_t count, list_node* pages) {
+    PagePool& pool = page_pools[arch_curr_cpu_num()];
+    {
+        Guard<SpinLock, IrqSave> guard{&pool.lock};
+        while (count > 0 && pool.count > 0) {
+            vm_page_t* page = list_remove_head_type(&pool.pages, vm_page_t, queue_node);
+            DEBUG_ASSERT(page->state == VM_PAGE_STATE_IPC);
+            list_add_tail(pages, &page->queue_node);
+            pool.count--;
+            count--;
+        }
+    }
+
+    if (count == 0) {
+        kcounter_add(buffer_pool_hit, 1);
+        return ZX_OK;
+    }
+    kcounter_add(buffer_pool_miss, 1);
+
+    list_node fresh = LIST_INITIAL_VALUE(fresh);
+    zx_status_t status = pmm_alloc_pages(count, 0, &fresh);
+    if (unlikely(status != ZX_OK)) {
+        // Put back whatever came from the pool.
+        FreePages(pages);
+        return status;
+    }
+    vm_page_t* page;
+    list_for_every_entry (&fresh, page, vm_page_t, queue_node) {
+        DEBUG_ASSERT(page->state == VM_PAGE_STATE_ALLOC);
+        page->state = VM_PAGE_STATE_IPC;
+    }
+    // Append after the pooled pages.
+    list_splice_after(&fresh, pages->prev);
+    return ZX_OK;
+}
+
+void BufferChain::FreePages(list_node* pages) {
+    PagePool& pool = page_pools[arch_curr_cpu_num()];
+    {
+        Guard<SpinLock, IrqSave> guard{&pool.lock};
+        while (pool.count < kPoolCapacity) {
+            vm_page_t* page = list_remove_head_type(pages, vm_page_t, queue_node);
+            if (page == nullptr) {
+                return;
+            }
+            list_add_head(&pool.pages, &page->queue_node);
+            pool.count++;
+        }
+    }
+
+    if (!list_is_empty(pages)) {
+        kcounter_add(buffer_pool_overflow, 1);
+        pmm_free(pages);
+    }
+}
+
+size_t BufferChain::TrimPool() {
+    list_node trimmed = LIST_INITIAL_VALUE(trimmed);
+    size_t count = 0;
+
+    for (auto& pool : page_pools) {
+        Guard<SpinLock, IrqSave> guard{&pool.lock};
+        count += pool.count;
+        list_splice_after(&pool.pages, &trimmed);
+        pool.count = 0;
+    }
+
+    if (count > 0) {
+        kcounter_add(buffer_pool_trimmed, count);
+        pmm_free(&trimmed);
+    }
+    return count;
+}
+
 // Makes a const void* look like a user_in_ptr<const void>.
 //
 // Sometimes we need to copy data from kernel space. KernelPtrAdapter allows us to implement the
@@ -138,9 +138,41 @@ static bool copy_in_copy_out() {
     END_TEST;
 }
 
+static bool pool_reuse_and_trim() {
+    BEGIN_TEST;
+
+    BufferChain::TrimPool();
+
+    // Freed pages are pooled rather than returned to the pmm, and every pooled page goes back on
+    // a trim.
+    BufferChain* bc = BufferChain::Alloc(2 * BufferChain::kRawDataSize);
+    ASSERT_NE(bc, nullptr, "");
+    ASSERT_EQ(bc->buffers()->size_slow(), 3u, "");
+    BufferChain::Free(bc);
+    EXPECT_GE(BufferChain::TrimPool(), 3u, "");
+    EXPECT_EQ(BufferChain::TrimPool(), 0u, "");
+
+    // Chains built partly from pooled pages are whole and usable.
+    bc = BufferChain::Alloc(0);
+    ASSERT_NE(bc, nullptr, "");
+    BufferChain::Free(bc);
+    bc = BufferChain::Alloc(100 * BufferChain::kRawDataSize);
+    ASSERT_NE(bc, nullptr, "");
+    ASSERT_EQ(bc->buffers()->size_slow(), 101u, "");
+    for (auto& buf : *bc->buffers()) {
+        memset(buf.data(), 'A', buf.size());
+    }
+    BufferChain::Free(bc);
+
+    BufferChain::TrimPool();
+
+    END_TEST;
+}
+
 }  // namespace
 
 UNITTEST_START_TESTCASE(buffer_chain_tests)
 UNITTEST("alloc_free_basic", alloc_free_basic)
 UNITTEST("copy_in_copy_out", copy_in_copy_out)
+UNITTEST("pool_reuse_and_trim", pool_reuse_and_trim)
 UNITTEST_END_TESTCASE(buffer_chain_tests, "buffer_chain", "BufferChain tests");
@@ -35,6 +35,10 @@ KCOUNTER(channel_packet_depth_64, "kernel.channel.depth.64");
 KCOUNTER(channel_packet_depth_256, "kernel.channel.depth.256");
 KCOUNTER(channel_packet_depth_unbounded, "kernel.channel.depth.unbounded");
 
+// Every channel endpoint takes at least one handle, so there cannot be more
+// live endpoints than handles.
+DECLARE_OBJECT_CACHE(ChannelDispatcher, Handle::kMaxHandleCount);
+
 // static
 zx_status_t ChannelDispatcher::Create(fbl::RefPtr<Dispatcher>* dispatcher0,
                                       fbl::RefPtr<Dispatcher>* dispatcher1,
@@ -45,12 +49,12 @@ zx_status_t ChannelDispatcher::Create(fbl::RefPtr<Dispatcher>* dispatcher0,
         return ZX_ERR_NO_MEMORY;
     auto holder1 = holder0;
 
-    auto ch0 = fbl::AdoptRef(new (&ac) ChannelDispatcher(fbl::move(holder0)));
-    if (!ac.check())
+    auto ch0 = fbl::AdoptRef(ObjectCache<ChannelDispatcher>::New(fbl::move(holder0)));
+    if (!ch0)
         return ZX_ERR_NO_MEMORY;
 
-    auto ch1 = fbl::AdoptRef(new (&ac) ChannelDispatcher(fbl::move(holder1)));
-    if (!ac.check())
+    auto ch1 = fbl::AdoptRef(ObjectCache<ChannelDispatcher>::New(fbl::move(holder1)));
+    if (!ch1)
         return ZX_ERR_NO_MEMORY;
 
     ch0->Init(ch1);
@@ -273,7 +277,10 @@ alloc_txid:
         // waiter to the list.
         waiters_.push_back(waiter);
 
-        // (1) Write outbound message to opposing endpoint.
+        // (1) Write outbound message to opposing endpoint. We are about to
+        // block on the reply, so a server thread woken by this message can
+        // run right here instead of on another cpu.
+        AutoSchedHandoff handoff;
         peer_->WriteSelf(fbl::move(msg));
     }
 
@@ -325,6 +332,29 @@ size_t ChannelDispatcher::TxMessageMax() const {
     return SIZE_MAX;
 }
 
+void ChannelDispatcher::RecordSent(uint64_t copied, uint64_t moved) {
+    messages_sent_.fetch_add(1u, fbl::memory_order_relaxed);
+    bytes_copied_in_.fetch_add(copied, fbl::memory_order_relaxed);
+    if (moved > 0u)
+        vmo_bytes_moved_.fetch_add(moved, fbl::memory_order_relaxed);
+}
+
+void ChannelDispatcher::RecordReceived(uint64_t copied) {
+    messages_received_.fetch_add(1u, fbl::memory_order_relaxed);
+    bytes_copied_out_.fetch_add(copied, fbl::memory_order_relaxed);
+}
+
+void ChannelDispatcher::GetStats(zx_info_channel_stats_t* info) const {
+    canary_.Assert();
+
+    *info = {};
+    info->messages_sent = messages_sent_.load(fbl::memory_order_relaxed);
+    info->messages_received = messages_received_.load(fbl::memory_order_relaxed);
+    info->bytes_copied_in = bytes_copied_in_.load(fbl::memory_order_relaxed);
+    info->bytes_copied_out = bytes_copied_out_.load(fbl::memory_order_relaxed);
+    info->vmo_bytes_moved = vmo_bytes_moved_.load(fbl::memory_order_relaxed);
+}
+
 void ChannelDispatcher::WriteSelf(fbl::unique_ptr<MessagePacket> msg) {
     canary_.Assert();
 
@@ -382,6 +412,10 @@ void ChannelDispatcher::MessageWaiter::Deliver(fbl::unique_ptr<MessagePacket> ms
 
     msg_ = fbl::move(msg);
     status_ = ZX_OK;
+
+    // The reply completes the call, so switch to the caller on this cpu,
+    // where the server just touched the reply, rather than on another one.
+    AutoSchedHandoff handoff;
     event_.Signal(ZX_OK);
 }
 
@@ -12,6 +12,9 @@
 
 #include <lib/console.h>
 #include <lib/ktrace.h>
+#include <fbl/algorithm.h>
+#include <fbl/alloc_checker.h>
+#include <fbl/array.h>
 #include <fbl/auto_lock.h>
 #include <object/handle.h>
 #include <object/job_dispatcher.h>
@@ -60,7 +63,7 @@ static void DumpProcessListKeyMap() {
 }
 
 static const char* ObjectTypeToString(zx_obj_type_t type) {
-    static_assert(ZX_OBJ_TYPE_LAST == 28, "need to update switch below");
+    static_assert(ZX_OBJ_TYPE_LAST == 29, "need to update switch below");
 
     switch (type) {
         case ZX_OBJ_TYPE_PROCESS: return "process";
@@ -86,6 +89,7 @@ static const char* ObjectTypeToString(zx_obj_type_t type) {
         case ZX_OBJ_TYPE_PROFILE: return "profile";
         case ZX_OBJ_TYPE_PMT: return "pmt";
         case ZX_OBJ_TYPE_SUSPEND_TOKEN: return "suspend-token";
+        case ZX_OBJ_TYPE_PAGER: return "pager";
         default: return "???";
     }
 }
@@ -114,7 +118,7 @@ static uint32_t BuildHandleStats(const ProcessDispatcher& pd,
 // buffer as strings.
 static void FormatHandleTypeCount(const ProcessDispatcher& pd,
                                   char *buf, size_t buf_len) {
-    static_assert(ZX_OBJ_TYPE_LAST == 28, "need to update table below");
+    static_assert(ZX_OBJ_TYPE_LAST == 29, "need to update table below");
 
     uint32_t types[ZX_OBJ_TYPE_LAST] = {0};
     uint32_t handle_count = BuildHandleStats(pd, types, sizeof(types));
@@ -137,7 +141,7 @@ static void FormatHandleTypeCount(const ProcessDispatcher& pd,
              types[ZX_OBJ_TYPE_GUEST] + types[ZX_OBJ_TYPE_VCPU] +
              types[ZX_OBJ_TYPE_IOMMU] + types[ZX_OBJ_TYPE_BTI] +
              types[ZX_OBJ_TYPE_PROFILE] + types[ZX_OBJ_TYPE_PMT] +
-             types[ZX_OBJ_TYPE_SUSPEND_TOKEN]
+             types[ZX_OBJ_TYPE_SUSPEND_TOKEN] + types[ZX_OBJ_TYPE_PAGER]
              );
 }
 
@@ -456,6 +460,46 @@ unsigned int arch_mmu_flags_to_vm_flags(unsigned int arch_mmu_flags) {
     return ret;
 }
 
+zx_info_maps_t AspaceToMapsEntry(const VmAspace* aspace) {
+    zx_info_maps_t entry = {};
+    strlcpy(entry.name, aspace->name(), sizeof(entry.name));
+    entry.base = aspace->base();
+    entry.size = aspace->size();
+    entry.depth = 0;
+    entry.type = ZX_INFO_MAPS_TYPE_ASPACE;
+    return entry;
+}
+
+// |depth| is as passed to a VmEnumerator.
+zx_info_maps_t VmarToMapsEntry(const VmAddressRegion* vmar, uint depth) {
+    zx_info_maps_t entry = {};
+    strlcpy(entry.name, vmar->name(), sizeof(entry.name));
+    entry.base = vmar->base();
+    entry.size = vmar->size();
+    entry.depth = depth + 1; // The root aspace is depth 0.
+    entry.type = ZX_INFO_MAPS_TYPE_VMAR;
+    return entry;
+}
+
+// |depth| is as passed to a VmEnumerator.
+zx_info_maps_t MappingToMapsEntry(const VmMapping* map, uint depth) {
+    zx_info_maps_t entry = {};
+    auto vmo = map->vmo();
+    vmo->get_name(entry.name, sizeof(entry.name));
+    entry.base = map->base();
+    entry.size = map->size();
+    entry.depth = depth + 1; // The root aspace is depth 0.
+    entry.type = ZX_INFO_MAPS_TYPE_MAPPING;
+    zx_info_maps_mapping_t* u = &entry.u.mapping;
+    u->mmu_flags =
+        arch_mmu_flags_to_vm_flags(map->arch_mmu_flags());
+    u->vmo_koid = vmo->user_id();
+    u->committed_pages = vmo->AllocatedPagesInRange(
+        map->object_offset(), map->size());
+    u->vmo_offset = map->object_offset();
+    return entry;
+}
+
 // Builds a description of an apsace/vmar/mapping hierarchy.
 class VmMapBuilder final : public VmEnumerator {
 public:
@@ -467,12 +511,7 @@ public:
     bool OnVmAddressRegion(const VmAddressRegion* vmar, uint depth) override {
         available_++;
         if (nelem_ < max_) {
-            zx_info_maps_t entry = {};
-            strlcpy(entry.name, vmar->name(), sizeof(entry.name));
-            entry.base = vmar->base();
-            entry.size = vmar->size();
-            entry.depth = depth + 1; // The root aspace is depth 0.
-            entry.type = ZX_INFO_MAPS_TYPE_VMAR;
+            zx_info_maps_t entry = VmarToMapsEntry(vmar, depth);
             if (maps_.copy_array_to_user(&entry, 1, nelem_) != ZX_OK) {
                 return false;
             }
@@ -485,20 +524,7 @@ public:
                      uint depth) override {
         available_++;
         if (nelem_ < max_) {
-            zx_info_maps_t entry = {};
-            auto vmo = map->vmo();
-            vmo->get_name(entry.name, sizeof(entry.name));
-            entry.base = map->base();
-            entry.size = map->size();
-            entry.depth = depth + 1; // The root aspace is depth 0.
-            entry.type = ZX_INFO_MAPS_TYPE_MAPPING;
-            zx_info_maps_mapping_t* u = &entry.u.mapping;
-            u->mmu_flags =
-                arch_mmu_flags_to_vm_flags(map->arch_mmu_flags());
-            u->vmo_koid = vmo->user_id();
-            u->committed_pages = vmo->AllocatedPagesInRange(
-                map->object_offset(), map->size());
-            u->vmo_offset = map->object_offset();
+            zx_info_maps_t entry = MappingToMapsEntry(map, depth);
             if (maps_.copy_array_to_user(&entry, 1, nelem_) != ZX_OK) {
                 return false;
             }
@@ -531,12 +557,7 @@ zx_status_t GetVmAspaceMaps(fbl::RefPtr<VmAspace> aspace,
         return ZX_ERR_BAD_STATE;
     }
     if (max > 0) {
-        zx_info_maps_t entry = {};
-        strlcpy(entry.name, aspace->name(), sizeof(entry.name));
-        entry.base = aspace->base();
-        entry.size = aspace->size();
-        entry.depth = 0;
-        entry.type = ZX_INFO_MAPS_TYPE_ASPACE;
+        zx_info_maps_t entry = AspaceToMapsEntry(aspace.get());
         if (maps.copy_array_to_user(&entry, 1, 0) != ZX_OK) {
             return ZX_ERR_INVALID_ARGS;
         }
@@ -657,6 +678,270 @@ zx_status_t GetProcessVmosViaHandles(ProcessDispatcher* process,
     return ZX_OK;
 }
 
+namespace {
+// The most entries the paged walks gather per hold of the locks they walk
+// under. Each batch is copied out to the user after dropping them, so a
+// large snapshot stalls the target only for about this many entries at a
+// time.
+constexpr size_t kInfoBatchSize = 64;
+
+// The most handles or VMARs a paged walk steps over per hold of the lock,
+// whether or not they produce an entry.
+constexpr size_t kInfoBatchVisits = 512;
+
+// A ZX_INFO_PROCESS_MAPS cursor names the next entry to return by its base
+// and its depth. Bases are page aligned, so the depth fits under them.
+// Entries which share a base are nested, in order of depth.
+bool MapsCursorBefore(uint64_t cursor, vaddr_t base, size_t depth) {
+    vaddr_t cursor_base = cursor & ~static_cast<uint64_t>(PAGE_MASK);
+    return base > cursor_base ||
+           (base == cursor_base && depth >= (cursor & PAGE_MASK));
+}
+
+// A ZX_INFO_PROCESS_VMOS cursor is either the value of the next handle in
+// the process's handle table to look at, or, once that walk is done, the
+// lowest base address of the mappings still to be returned.
+constexpr uint64_t kVmosCursorMappings = 1ull << 63;
+
+// Gathers the entries of an aspace/vmar/mapping hierarchy at or after a
+// cursor, up to a batch at a time.
+class PagedMapBuilder final : public VmEnumerator {
+public:
+    PagedMapBuilder(zx_info_maps_t* maps, size_t max, uint64_t cursor)
+        : maps_(maps), max_(max), cursor_(cursor) {}
+
+    // The root VmAspace is not visited by VmAspace::EnumerateChildren(),
+    // so the caller must add it before the walk.
+    bool OnVmAspace(const VmAspace* aspace) {
+        if (!Reserve(aspace->base(), 0)) {
+            return false;
+        }
+        if (reserved_) {
+            maps_[nelem_++] = AspaceToMapsEntry(aspace);
+        }
+        return true;
+    }
+
+    bool OnVmAddressRegion(const VmAddressRegion* vmar, uint depth) override {
+        if (!Reserve(vmar->base(), depth + 1)) {
+            return false;
+        }
+        if (reserved_) {
+            maps_[nelem_++] = VmarToMapsEntry(vmar, depth);
+        }
+        return true;
+    }
+
+    bool OnVmMapping(const VmMapping* map, const VmAddressRegion* vmar,
+                     uint depth) override {
+        if (!Reserve(map->base(), depth + 1)) {
+            return false;
+        }
+        if (reserved_) {
+            maps_[nelem_++] = MappingToMapsEntry(map, depth);
+        }
+        return true;
+    }
+
+    size_t nelem() const { return nelem_; }
+    uint64_t next_cursor() const { return next_cursor_; }
+    zx_status_t status() const { return status_; }
+
+private:
+    // Returns false if the walk must stop before the entry at |base| and
+    // |depth|. Otherwise sets |reserved_| if the entry is to be returned,
+    // rather than skipped as coming before the cursor.
+    bool Reserve(vaddr_t base, size_t depth) {
+        reserved_ = MapsCursorBefore(cursor_, base, depth);
+        if (!reserved_ || nelem_ < max_) {
+            return true;
+        }
+        if (depth > PAGE_MASK) {
+            // Too deep to name with a cursor.
+            status_ = ZX_ERR_NOT_SUPPORTED;
+        }
+        next_cursor_ = base | depth;
+        return false;
+    }
+
+    zx_info_maps_t* const maps_;
+    const size_t max_;
+    const uint64_t cursor_;
+
+    size_t nelem_ = 0;
+    bool reserved_ = false;
+    uint64_t next_cursor_ = ZX_INFO_CURSOR_END;
+    zx_status_t status_ = ZX_OK;
+};
+
+// Gathers the VMOs mapped into a VmAspace at or after an address, up to a
+// batch at a time.
+class PagedAspaceVmoEnumerator final : public VmEnumerator {
+public:
+    PagedAspaceVmoEnumerator(zx_info_vmo_t* vmos, size_t max, vaddr_t start)
+        : vmos_(vmos), max_(max), start_(start) {}
+
+    bool OnVmAddressRegion(const VmAddressRegion* vmar, uint depth) override {
+        return Visit(vmar->base());
+    }
+
+    bool OnVmMapping(const VmMapping* map, const VmAddressRegion* vmar,
+                     uint depth) override {
+        if (map->base() < start_) {
+            return true;
+        }
+        // Mappings never share a base, so stopping here always moves the
+        // cursor forward once a mapping has been returned.
+        if (nelem_ == max_ || !Visit(map->base())) {
+            next_cursor_ = kVmosCursorMappings | map->base();
+            return false;
+        }
+        vmos_[nelem_++] = VmoToInfoEntry(map->vmo().get(),
+                                         /*is_handle=*/false,
+                                         /*handle_rights=*/0);
+        return true;
+    }
+
+    size_t nelem() const { return nelem_; }
+    uint64_t next_cursor() const { return next_cursor_; }
+
+private:
+    // Counts a visit to a region at |base|. Returns false, after setting
+    // the cursor, if the batch has run out of visits. The region at |start_|
+    // never stops the walk, so every batch makes progress.
+    bool Visit(vaddr_t base) {
+        if (base < start_) {
+            // The regions containing |start_|, which were seen already.
+            return true;
+        }
+        if (base > start_ && visits_ == kInfoBatchVisits) {
+            next_cursor_ = kVmosCursorMappings | base;
+            return false;
+        }
+        visits_++;
+        return true;
+    }
+
+    zx_info_vmo_t* const vmos_;
+    const size_t max_;
+    const vaddr_t start_;
+
+    size_t nelem_ = 0;
+    size_t visits_ = 0;
+    uint64_t next_cursor_ = ZX_INFO_CURSOR_END;
+};
+} // namespace
+
+// NOTE: Code outside of the syscall layer should not typically know about
+// user_ptrs; do not use this pattern as an example.
+zx_status_t GetVmAspaceMapsPaged(fbl::RefPtr<VmAspace> aspace, uint64_t cursor,
+                                 user_out_ptr<zx_info_maps_t> maps, size_t max,
+                                 size_t* actual, uint64_t* next_cursor) {
+    DEBUG_ASSERT(aspace != nullptr);
+    DEBUG_ASSERT(actual != nullptr);
+    DEBUG_ASSERT(next_cursor != nullptr);
+    *actual = 0;
+    *next_cursor = cursor;
+
+    fbl::AllocChecker ac;
+    fbl::Array<zx_info_maps_t> batch(new (&ac) zx_info_maps_t[kInfoBatchSize],
+                                     kInfoBatchSize);
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+
+    size_t count = 0;
+    while (count < max && cursor != ZX_INFO_CURSOR_END) {
+        if (aspace->is_destroyed()) {
+            return ZX_ERR_BAD_STATE;
+        }
+        PagedMapBuilder b(batch.get(), fbl::min(max - count, kInfoBatchSize), cursor);
+        if (b.OnVmAspace(aspace.get())) {
+            aspace->EnumerateChildren(&b, cursor & ~static_cast<uint64_t>(PAGE_MASK));
+        }
+        if (b.status() != ZX_OK) {
+            return b.status();
+        }
+        // The aspace lock is not held here, so the buffer may even be in
+        // the aspace being walked.
+        if (maps.copy_array_to_user(batch.get(), b.nelem(), count) != ZX_OK) {
+            return ZX_ERR_INVALID_ARGS;
+        }
+        count += b.nelem();
+        cursor = b.next_cursor();
+    }
+    *actual = count;
+    *next_cursor = cursor;
+    return ZX_OK;
+}
+
+// NOTE: Code outside of the syscall layer should not typically know about
+// user_ptrs; do not use this pattern as an example.
+zx_status_t GetProcessVmosPaged(ProcessDispatcher* process, uint64_t cursor,
+                                user_out_ptr<zx_info_vmo_t> vmos, size_t max,
+                                size_t* actual, uint64_t* next_cursor) {
+    DEBUG_ASSERT(process != nullptr);
+    DEBUG_ASSERT(actual != nullptr);
+    DEBUG_ASSERT(next_cursor != nullptr);
+    *actual = 0;
+    *next_cursor = cursor;
+    if (cursor != ZX_INFO_CURSOR_END && !(cursor & kVmosCursorMappings) &&
+        cursor > UINT32_MAX) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+
+    fbl::AllocChecker ac;
+    fbl::Array<zx_info_vmo_t> batch(new (&ac) zx_info_vmo_t[kInfoBatchSize],
+                                    kInfoBatchSize);
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+
+    fbl::RefPtr<VmAspace> aspace = process->aspace();
+    size_t count = 0;
+    while (count < max && cursor != ZX_INFO_CURSOR_END) {
+        const size_t limit = fbl::min(max - count, kInfoBatchSize);
+        size_t nelem = 0;
+        if (!(cursor & kVmosCursorMappings)) {
+            // We may see multiple handles to the same VMO, but leave it to
+            // userspace to do deduping.
+            size_t visits = 0;
+            zx_handle_t next = process->ForEachHandleFrom(
+                static_cast<zx_handle_t>(cursor),
+                [&](zx_handle_t handle, zx_rights_t rights, const Dispatcher* disp) {
+                    if (nelem == limit || visits == kInfoBatchVisits) {
+                        return false;
+                    }
+                    visits++;
+                    auto vmod = DownCastDispatcher<const VmObjectDispatcher>(disp);
+                    if (vmod != nullptr) {
+                        batch[nelem++] = VmoToInfoEntry(vmod->vmo().get(),
+                                                        /*is_handle=*/true,
+                                                        rights);
+                    }
+                    return true;
+                });
+            cursor = next != ZX_HANDLE_INVALID ? next : kVmosCursorMappings;
+        } else {
+            if (aspace->is_destroyed()) {
+                return ZX_ERR_BAD_STATE;
+            }
+            vaddr_t start = cursor & ~kVmosCursorMappings;
+            PagedAspaceVmoEnumerator ave(batch.get(), limit, start);
+            aspace->EnumerateChildren(&ave, start);
+            nelem = ave.nelem();
+            cursor = ave.next_cursor();
+        }
+        if (vmos.copy_array_to_user(batch.get(), nelem, count) != ZX_OK) {
+            return ZX_ERR_INVALID_ARGS;
+        }
+        count += nelem;
+    }
+    *actual = count;
+    *next_cursor = cursor;
+    return ZX_OK;
+}
+
 void DumpProcessAddressSpace(zx_koid_t id) {
     auto pd = ProcessDispatcher::LookupProcessById(id);
     if (!pd) {
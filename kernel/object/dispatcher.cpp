@@ -100,44 +100,86 @@ zx_status_t Dispatcher::add_observer(StateObserver* observer) {
     return ZX_OK;
 }
 
-namespace {
+void Dispatcher::InsertObserverLocked(StateObserver* observer) {
+    observer->interest_ = observer->interest();
+
+    // Join the group with the same interest, if there is one. There are only ever a few distinct
+    // interests, so this is short.
+    StateObserver* head;
+    list_for_every_entry (&observer_groups_, head, StateObserver, group_head_node_) {
+        if (head->interest_ == observer->interest_) {
+            list_add_tail(&head->group_node_, &observer->group_node_);
+            list_clear_node(&observer->group_head_node_);
+            return;
+        }
+    }
+
+    // Start a new group.
+    list_initialize(&observer->group_node_);
+    list_add_tail(&observer_groups_, &observer->group_head_node_);
+}
 
-template <typename Func, typename LockType>
-StateObserver::Flags CancelWithFunc(Dispatcher::ObserverList* observers,
-                                    Lock<LockType>* observer_lock, Func f) {
+void Dispatcher::RemoveObserverLocked(StateObserver* observer) {
+    if (!list_in_list(&observer->group_head_node_)) {
+        // Not the first of its group.
+        list_delete(&observer->group_node_);
+    } else if (list_is_empty(&observer->group_node_)) {
+        // The last of its group.
+        list_delete(&observer->group_head_node_);
+        list_clear_node(&observer->group_node_);
+    } else {
+        // Make the next observer the first of the group.
+        StateObserver* next = list_peek_head_type(&observer->group_node_, StateObserver,
+                                                  group_node_);
+        list_delete(&observer->group_node_);
+        list_replace_node(&observer->group_head_node_, &next->group_head_node_);
+    }
+}
+
+template <typename Func>
+StateObserver::Flags Dispatcher::ForEachObserverLocked(ObserverList* obs_to_remove,
+                                                       zx_signals_t signals, bool all,
+                                                       Func func) {
     StateObserver::Flags flags = 0;
 
-    Dispatcher::ObserverList obs_to_remove;
+    // Removing an observer only ever unlinks that observer, so the next group and the next and
+    // last observers of the group can be found before calling |func|.
+    list_node* node = observer_groups_.next;
+    while (node != &observer_groups_) {
+        StateObserver* head = containerof(node, StateObserver, group_head_node_);
+        node = node->next;
 
-    {
-        Guard<LockType> guard{observer_lock};
-        for (auto it = observers->begin(); it != observers->end();) {
-            StateObserver::Flags it_flags = f(it.CopyPointer());
+        if (!all && head->interest_ != StateObserver::kAllChanges &&
+            (head->interest_ & signals) == 0u) {
+            continue;
+        }
+
+        StateObserver* const last = containerof(head->group_node_.prev, StateObserver,
+                                                group_node_);
+        StateObserver* observer = head;
+        for (;;) {
+            StateObserver* next = containerof(observer->group_node_.next, StateObserver,
+                                              group_node_);
+            StateObserver::Flags it_flags = func(observer);
             flags |= it_flags;
             if (it_flags & StateObserver::kNeedRemoval) {
-                auto to_remove = it;
-                ++it;
-                obs_to_remove.push_back(observers->erase(to_remove));
-            } else {
-                ++it;
+                RemoveObserverLocked(observer);
+                obs_to_remove->push_back(observer);
             }
+            if (observer == last) {
+                break;
+            }
+            observer = next;
         }
     }
 
-    while (!obs_to_remove.is_empty()) {
-        obs_to_remove.pop_front()->OnRemoved();
-    }
-
-    // We've processed the removal flag, so strip it
-    return flags & (~StateObserver::kNeedRemoval);
+    return flags;
 }
 
-}  // namespace
-
 // Since this conditionally takes the dispatcher's |lock_|, based on
 // the type of Mutex (either fbl::Mutex or fbl::NullLock), the thread
 // safety analysis is unable to prove that the accesses to |signals_|
-// and to |observers_| are always protected.
+// and to |observer_groups_| are always protected.
 template <typename LockType>
 void Dispatcher::AddObserverHelper(StateObserver* observer,
                                    const StateObserver::CountInfo* cinfo,
@@ -151,7 +193,7 @@ void Dispatcher::AddObserverHelper(StateObserver* observer,
 
         flags = observer->OnInitialize(signals_, cinfo);
         if (!(flags & StateObserver::kNeedRemoval))
-            observers_.push_front(observer);
+            InsertObserverLocked(observer);
     }
     if (flags & StateObserver::kNeedRemoval)
         observer->OnRemoved();
@@ -171,20 +213,29 @@ void Dispatcher::AddObserverLocked(StateObserver* observer, const StateObserver:
     AddObserverHelper(observer, cinfo, &lock);
 }
 
-void Dispatcher::RemoveObserver(StateObserver* observer) {
+zx_signals_t Dispatcher::RemoveObserver(StateObserver* observer) {
     ZX_DEBUG_ASSERT(is_waitable());
 
     Guard<fbl::Mutex> guard{get_lock()};
     DEBUG_ASSERT(observer != nullptr);
-    observers_.erase(*observer);
+    RemoveObserverLocked(observer);
+    return signals_;
 }
 
 void Dispatcher::Cancel(const Handle* handle) {
     ZX_DEBUG_ASSERT(is_waitable());
 
-    CancelWithFunc(&observers_, get_lock(), [handle](StateObserver* obs) {
-        return obs->OnCancel(handle);
-    });
+    ObserverList obs_to_remove;
+    {
+        Guard<fbl::Mutex> guard{get_lock()};
+        ForEachObserverLocked(&obs_to_remove, 0u, true, [handle](StateObserver* obs) {
+            return obs->OnCancel(handle);
+        });
+    }
+
+    while (!obs_to_remove.is_empty()) {
+        obs_to_remove.pop_front()->OnRemoved();
+    }
 
     kcounter_add(dispatcher_cancel_bh_count, 1);
 }
@@ -192,10 +243,19 @@ void Dispatcher::Cancel(const Handle* handle) {
 bool Dispatcher::CancelByKey(const Handle* handle, const void* port, uint64_t key) {
     ZX_DEBUG_ASSERT(is_waitable());
 
-    StateObserver::Flags flags = CancelWithFunc(&observers_, get_lock(),
-                                                [handle, port, key](StateObserver* obs) {
-        return obs->OnCancelByKey(handle, port, key);
-    });
+    ObserverList obs_to_remove;
+    StateObserver::Flags flags;
+    {
+        Guard<fbl::Mutex> guard{get_lock()};
+        flags = ForEachObserverLocked(&obs_to_remove, 0u, true,
+                                      [handle, port, key](StateObserver* obs) {
+            return obs->OnCancelByKey(handle, port, key);
+        });
+    }
+
+    while (!obs_to_remove.is_empty()) {
+        obs_to_remove.pop_front()->OnRemoved();
+    }
 
     kcounter_add(dispatcher_cancel_bk_count, 1);
 
@@ -245,16 +305,9 @@ void Dispatcher::UpdateStateLocked(zx_signals_t clear_mask,
 void Dispatcher::UpdateInternalLocked(ObserverList* obs_to_remove, zx_signals_t signals) {
     ZX_DEBUG_ASSERT(is_waitable());
 
-    for (auto it = observers_.begin(); it != observers_.end();) {
-        StateObserver::Flags it_flags = it->OnStateChange(signals);
-        if (it_flags & StateObserver::kNeedRemoval) {
-            auto to_remove = it;
-            ++it;
-            obs_to_remove->push_back(observers_.erase(to_remove));
-        } else {
-            ++it;
-        }
-    }
+    ForEachObserverLocked(obs_to_remove, signals, false, [signals](StateObserver* obs) {
+        return obs->OnStateChange(signals);
+    });
 }
 
 zx_status_t Dispatcher::SetCookie(CookieJar* cookiejar, zx_koid_t scope, uint64_t cookie) {
@@ -8,14 +8,17 @@
 
 #include <err.h>
 
+#include <object/handle.h>
 #include <zircon/rights.h>
-#include <fbl/alloc_checker.h>
+
+// Every event takes at least one handle, so there cannot be more live events
+// than handles.
+DECLARE_OBJECT_CACHE(EventDispatcher, Handle::kMaxHandleCount);
 
 zx_status_t EventDispatcher::Create(uint32_t options, fbl::RefPtr<Dispatcher>* dispatcher,
                                     zx_rights_t* rights) {
-    fbl::AllocChecker ac;
-    auto disp = new (&ac) EventDispatcher(options);
-    if (!ac.check())
+    auto disp = ObjectCache<EventDispatcher>::New(options);
+    if (!disp)
         return ZX_ERR_NO_MEMORY;
 
     *rights = default_rights();
@@ -65,7 +65,8 @@ FifoDispatcher::FifoDispatcher(fbl::RefPtr<PeerHolder<FifoDispatcher>> holder,
                                fbl::unique_ptr<uint8_t[]> data)
     : PeeredDispatcher(fbl::move(holder), ZX_FIFO_WRITABLE),
       elem_count_(count), elem_size_(elem_size), mask_(count - 1),
-      head_(0u), tail_(0u), data_(fbl::move(data)) {
+      head_(0u), tail_(0u), read_threshold_(0u), write_threshold_(0u),
+      data_(fbl::move(data)) {
 }
 
 FifoDispatcher::~FifoDispatcher() {
@@ -91,7 +92,7 @@ void FifoDispatcher::on_zero_handles_locked() {
 void FifoDispatcher::OnPeerZeroHandlesLocked() {
     canary_.Assert();
 
-    UpdateStateLocked(ZX_FIFO_WRITABLE, ZX_FIFO_PEER_CLOSED);
+    UpdateStateLocked(ZX_FIFO_WRITABLE | ZX_FIFO_WRITE_THRESHOLD, ZX_FIFO_PEER_CLOSED);
 }
 
 zx_status_t FifoDispatcher::WriteFromUser(size_t elem_size, user_in_ptr<const uint8_t> ptr,
@@ -152,13 +153,31 @@ zx_status_t FifoDispatcher::WriteSelfLocked(size_t elem_size, user_in_ptr<const
         ptr = ptr.byte_offset(to_copy * elem_size_);
     }
 
+    zx_signals_t set = 0u;
+    zx_signals_t clear = 0u;
+
     // if was empty, we've become readable
     if (was_empty)
-        UpdateStateLocked(0u, ZX_FIFO_READABLE);
+        set |= ZX_FIFO_READABLE;
+
+    // Assert signal if we reached the read threshold
+    if ((read_threshold_ > 0) && ((head_ - tail_) >= read_threshold_))
+        set |= ZX_FIFO_READ_THRESHOLD;
+
+    if (set)
+        UpdateStateLocked(0u, set);
 
     // if now full, we're no longer writable
     if (elem_count_ == (head_ - tail_))
-        peer_->UpdateStateLocked(ZX_FIFO_WRITABLE, 0u);
+        clear |= ZX_FIFO_WRITABLE;
+
+    // If free space falls below the peer's write threshold, de-signal
+    if ((peer_->write_threshold_ > 0) &&
+        ((elem_count_ - (head_ - tail_)) < peer_->write_threshold_))
+        clear |= ZX_FIFO_WRITE_THRESHOLD;
+
+    if (clear)
+        peer_->UpdateStateLocked(clear, 0u);
 
     *actual = (head_ - old_head);
     return ZX_OK;
@@ -213,14 +232,80 @@ zx_status_t FifoDispatcher::ReadToUser(size_t elem_size, user_out_ptr<uint8_t> p
         ptr = ptr.byte_offset(to_copy * elem_size_);
     }
 
-    // if we were full, we have become writable
-    if (was_full && peer_)
-        peer_->UpdateStateLocked(0u, ZX_FIFO_WRITABLE);
+    if (peer_) {
+        zx_signals_t set = 0u;
+
+        // if we were full, we have become writable
+        if (was_full)
+            set |= ZX_FIFO_WRITABLE;
+
+        // Assert signal if free space reached the peer's write threshold
+        if ((peer_->write_threshold_ > 0) &&
+            ((elem_count_ - (head_ - tail_)) >= peer_->write_threshold_))
+            set |= ZX_FIFO_WRITE_THRESHOLD;
+
+        if (set)
+            peer_->UpdateStateLocked(0u, set);
+    }
+
+    zx_signals_t clear = 0u;
 
     // if we've become empty, we're no longer readable
     if ((head_ - tail_) == 0)
-        UpdateStateLocked(ZX_FIFO_READABLE, 0u);
+        clear |= ZX_FIFO_READABLE;
+
+    // Deassert signal if we fell below the read threshold
+    if ((read_threshold_ > 0) && ((head_ - tail_) < read_threshold_))
+        clear |= ZX_FIFO_READ_THRESHOLD;
+
+    if (clear)
+        UpdateStateLocked(clear, 0u);
 
     *actual = (tail_ - old_tail);
     return ZX_OK;
 }
+
+uint32_t FifoDispatcher::GetReadThreshold() const TA_NO_THREAD_SAFETY_ANALYSIS {
+    canary_.Assert();
+    Guard<fbl::Mutex> guard{get_lock()};
+    return read_threshold_;
+}
+
+uint32_t FifoDispatcher::GetWriteThreshold() const TA_NO_THREAD_SAFETY_ANALYSIS {
+    canary_.Assert();
+    Guard<fbl::Mutex> guard{get_lock()};
+    return write_threshold_;
+}
+
+zx_status_t FifoDispatcher::SetReadThreshold(size_t value) TA_NO_THREAD_SAFETY_ANALYSIS {
+    canary_.Assert();
+    Guard<fbl::Mutex> guard{get_lock()};
+    if (value > elem_count_)
+        return ZX_ERR_INVALID_ARGS;
+    read_threshold_ = static_cast<uint32_t>(value);
+    // Setting 0 disables thresholding. Deassert signal unconditionally.
+    if ((value > 0) && ((head_ - tail_) >= read_threshold_)) {
+        UpdateStateLocked(0u, ZX_FIFO_READ_THRESHOLD);
+    } else {
+        UpdateStateLocked(ZX_FIFO_READ_THRESHOLD, 0u);
+    }
+    return ZX_OK;
+}
+
+zx_status_t FifoDispatcher::SetWriteThreshold(size_t value) TA_NO_THREAD_SAFETY_ANALYSIS {
+    canary_.Assert();
+    Guard<fbl::Mutex> guard{get_lock()};
+    if (!peer_)
+        return ZX_ERR_PEER_CLOSED;
+    if (value > peer_->elem_count_)
+        return ZX_ERR_INVALID_ARGS;
+    write_threshold_ = static_cast<uint32_t>(value);
+    // Setting 0 disables thresholding. Deassert signal unconditionally.
+    if ((value > 0) &&
+        ((peer_->elem_count_ - (peer_->head_ - peer_->tail_)) >= write_threshold_)) {
+        UpdateStateLocked(0u, ZX_FIFO_WRITE_THRESHOLD);
+    } else {
+        UpdateStateLocked(ZX_FIFO_WRITE_THRESHOLD, 0u);
+    }
+    return ZX_OK;
+}
@@ -7,6 +7,7 @@
 #include <object/futex_context.h>
 
 #include <assert.h>
+#include <lib/counters.h>
 #include <lib/user_copy/user_ptr.h>
 #include <object/thread_dispatcher.h>
 #include <trace.h>
@@ -14,6 +15,11 @@
 
 #define LOCAL_TRACE 0
 
+KCOUNTER(futex_bucket_acquire, "kernel.futex.bucket.acquire");
+KCOUNTER(futex_bucket_contended, "kernel.futex.bucket.contended");
+KCOUNTER(futex_requeue_two_buckets, "kernel.futex.requeue.two_buckets");
+KCOUNTER(futex_pi_wait, "kernel.futex.pi_wait");
+
 FutexContext::FutexContext() {
     LTRACE_ENTRY;
 }
@@ -23,15 +29,36 @@ FutexContext::~FutexContext() {
 
     // All of the threads should have removed themselves from wait queues
     // by the time the process has exited.
-    DEBUG_ASSERT(futex_table_.is_empty());
+    for (auto& bucket : buckets_) {
+        Guard<fbl::Mutex> guard{&bucket.lock};
+        DEBUG_ASSERT(bucket.futex_table.is_empty());
+    }
+}
+
+FutexContext::Bucket* FutexContext::GetBucket(uintptr_t futex_key) {
+    // Futexes are at least int aligned and often packed together in one
+    // structure, so skip the low bits to spread neighbours over buckets.
+    return &buckets_[(futex_key / sizeof(int)) % kNumBuckets];
+}
+
+// static
+void FutexContext::CountBucketAcquire(Bucket* bucket) {
+    kcounter_add(futex_bucket_acquire, 1);
+    // This is only a hint, the lock may get released or taken before we try.
+    if (mutex_val(bucket->lock.lock().GetInternal()) != 0)
+        kcounter_add(futex_bucket_contended, 1);
 }
 
-zx_status_t FutexContext::FutexWait(user_in_ptr<const int> value_ptr, int current_value, zx_time_t deadline) {
+zx_status_t FutexContext::FutexWait(user_in_ptr<const int> value_ptr, int current_value, zx_time_t deadline,
+                                    fbl::RefPtr<ThreadDispatcher> owner) {
     LTRACE_ENTRY;
 
     uintptr_t futex_key = reinterpret_cast<uintptr_t>(value_ptr.get());
     if (futex_key % sizeof(int))
         return ZX_ERR_INVALID_ARGS;
+    // Waiting for ourselves would never end.
+    if (owner && owner.get() == ThreadDispatcher::GetCurrent())
+        return ZX_ERR_INVALID_ARGS;
 
     // FutexWait() checks that the address value_ptr still contains
     // current_value, and if so it sleeps awaiting a FutexWake() on value_ptr.
@@ -39,7 +66,9 @@ zx_status_t FutexContext::FutexWait(user_in_ptr<const int> value_ptr, int curren
     // If a FutexWake() operation could occur between them, a userland mutex
     // operation built on top of futexes would have a race condition that
     // could miss wakeups.
-    Guard<fbl::Mutex> guard{&lock_};
+    Bucket* bucket = GetBucket(futex_key);
+    CountBucketAcquire(bucket);
+    Guard<fbl::Mutex> guard{&bucket->lock};
 
     int value;
     zx_status_t result = value_ptr.copy_from_user(&value);
@@ -54,9 +83,13 @@ zx_status_t FutexContext::FutexWait(user_in_ptr<const int> value_ptr, int curren
     node.set_hash_key(futex_key);
     node.SetAsSingletonList();
 
-    QueueNodesLocked(&node);
+    QueueNodesLocked(bucket, &node);
+    if (owner) {
+        kcounter_add(futex_pi_wait, 1);
+        node.SetPiOwner(fbl::move(owner), get_current_thread()->effec_priority);
+    }
 
-    // Block current thread.  This releases lock_ and does not reacquire it.
+    // Block current thread.  This releases the bucket lock and does not reacquire it.
     result = node.BlockThread(guard.take(), deadline);
     if (result == ZX_OK) {
         DEBUG_ASSERT(!node.IsInQueue());
@@ -70,8 +103,8 @@ zx_status_t FutexContext::FutexWait(user_in_ptr<const int> value_ptr, int curren
     //
     // We need to ensure that the thread's node is removed from the wait
     // queue, because FutexWake() probably didn't do that.
-    Guard<fbl::Mutex> guard2{&lock_};
-    if (UnqueueNodeLocked(&node)) {
+    if (UnqueueNode(&node)) {
+        DEBUG_ASSERT(!node.has_pi_owner());
         return result;
     }
     // The current thread was not found on the wait queue.  This means
@@ -106,23 +139,35 @@ zx_status_t FutexContext::FutexWake(user_in_ptr<const int> value_ptr,
     if (futex_key % sizeof(int))
         return ZX_ERR_INVALID_ARGS;
 
+    Bucket* bucket = GetBucket(futex_key);
+
     AutoReschedDisable resched_disable; // Must come before the Guard.
     resched_disable.Disable();
-    Guard<fbl::Mutex> guard{&lock_};
+    CountBucketAcquire(bucket);
+    Guard<fbl::Mutex> guard{&bucket->lock};
 
-    FutexNode* node = futex_table_.erase(futex_key);
+    FutexNode* node = bucket->futex_table.erase(futex_key);
     if (!node) {
         // nothing blocked on this futex if we can't find it
         return ZX_OK;
     }
     DEBUG_ASSERT(node->GetKey() == futex_key);
 
+    // For priority-inheriting futexes, the thread woken by a single wake is
+    // the likely next owner, so the remaining waiters boost it instead.
+    const bool pi = node->has_pi_owner();
+    fbl::RefPtr<ThreadDispatcher> next_owner;
+    if (pi && count == 1)
+        next_owner = node->GetWaiter();
+
     FutexNode* remaining_waiters =
         FutexNode::WakeThreads(node, count, futex_key);
 
     if (remaining_waiters) {
         DEBUG_ASSERT(remaining_waiters->GetKey() == futex_key);
-        futex_table_.insert(remaining_waiters);
+        if (pi)
+            FutexNode::ReassignPiOwner(remaining_waiters, next_owner);
+        bucket->futex_table.insert(remaining_waiters);
     }
 
     return ZX_OK;
@@ -135,8 +180,35 @@ zx_status_t FutexContext::FutexRequeue(user_in_ptr<const int> wake_ptr, uint32_t
     if ((requeue_ptr.get() == nullptr) && requeue_count)
         return ZX_ERR_INVALID_ARGS;
 
+    Bucket* wake_bucket = GetBucket(reinterpret_cast<uintptr_t>(wake_ptr.get()));
+    Bucket* requeue_bucket = GetBucket(reinterpret_cast<uintptr_t>(requeue_ptr.get()));
+
     AutoReschedDisable resched_disable; // Must come before the Guard.
-    Guard<fbl::Mutex> guard{&lock_};
+    CountBucketAcquire(wake_bucket);
+    if (wake_bucket == requeue_bucket) {
+        Guard<fbl::Mutex> guard{&wake_bucket->lock};
+        return FutexRequeueLocked(wake_bucket, requeue_bucket, &resched_disable,
+                                  wake_ptr, wake_count, current_value,
+                                  requeue_ptr, requeue_count);
+    }
+
+    // Both futexes must be updated atomically. GuardMultiple takes the two
+    // bucket locks in address order.
+    kcounter_add(futex_requeue_two_buckets, 1);
+    CountBucketAcquire(requeue_bucket);
+    GuardMultiple<2, fbl::Mutex> guard{&wake_bucket->lock, &requeue_bucket->lock};
+    return FutexRequeueLocked(wake_bucket, requeue_bucket, &resched_disable,
+                              wake_ptr, wake_count, current_value,
+                              requeue_ptr, requeue_count);
+}
+
+zx_status_t FutexContext::FutexRequeueLocked(Bucket* wake_bucket, Bucket* requeue_bucket,
+                                             AutoReschedDisable* resched_disable,
+                                             user_in_ptr<const int> wake_ptr, uint32_t wake_count,
+                                             int current_value, user_in_ptr<const int> requeue_ptr,
+                                             uint32_t requeue_count) {
+    DEBUG_ASSERT(wake_bucket->lock.lock().IsHeld());
+    DEBUG_ASSERT(requeue_bucket->lock.lock().IsHeld());
 
     int value;
     zx_status_t result = wake_ptr.copy_from_user(&value);
@@ -152,7 +224,7 @@ zx_status_t FutexContext::FutexRequeue(user_in_ptr<const int> wake_ptr, uint32_t
     // This must happen before RemoveFromHead() calls set_hash_key() on
     // nodes below, because operations on futex_table_ look at the GetKey
     // field of the list head nodes for wake_key and requeue_key.
-    FutexNode* node = futex_table_.erase(wake_key);
+    FutexNode* node = wake_bucket->futex_table.erase(wake_key);
     if (!node) {
         // nothing blocked on this futex if we can't find it
         return ZX_OK;
@@ -160,7 +232,7 @@ zx_status_t FutexContext::FutexRequeue(user_in_ptr<const int> wake_ptr, uint32_t
 
     // This must come before WakeThreads() to be useful, but we want to
     // avoid doing it before copy_from_user() in case that faults.
-    resched_disable.Disable();
+    resched_disable->Disable();
 
     if (wake_count > 0) {
         node = FutexNode::WakeThreads(node, wake_count, wake_key);
@@ -176,21 +248,22 @@ zx_status_t FutexContext::FutexRequeue(user_in_ptr<const int> wake_ptr, uint32_t
 
             // now requeue our nodes to requeue_ptr mutex
             DEBUG_ASSERT(requeue_head->GetKey() == requeue_key);
-            QueueNodesLocked(requeue_head);
+            QueueNodesLocked(requeue_bucket, requeue_head);
         }
     }
 
     // add any remaining nodes back to wake_key futex
     if (node != nullptr) {
         DEBUG_ASSERT(node->GetKey() == wake_key);
-        futex_table_.insert(node);
+        wake_bucket->futex_table.insert(node);
     }
 
     return ZX_OK;
 }
 
-void FutexContext::QueueNodesLocked(FutexNode* head) {
-    DEBUG_ASSERT(lock_.lock().IsHeld());
+// static
+void FutexContext::QueueNodesLocked(Bucket* bucket, FutexNode* head) {
+    DEBUG_ASSERT(bucket->lock.lock().IsHeld());
 
     FutexNode::HashTable::iterator iter;
 
@@ -198,29 +271,39 @@ void FutexContext::QueueNodesLocked(FutexNode* head) {
     // succeeds, then the current thread is first to block on this futex and we
     // are finished.  If the insert fails, then there is already a thread
     // waiting on this futex.  Add ourselves to that thread's list.
-    if (!futex_table_.insert_or_find(head, &iter))
+    if (!bucket->futex_table.insert_or_find(head, &iter))
         iter->AppendList(head);
 }
 
 // This attempts to unqueue a thread (which may or may not be waiting on a
 // futex), given its FutexNode.  This returns whether the FutexNode was
 // found and removed from a futex wait queue.
-bool FutexContext::UnqueueNodeLocked(FutexNode* node) {
-    DEBUG_ASSERT(lock_.lock().IsHeld());
-
-    if (!node->IsInQueue())
-        return false;
-
+bool FutexContext::UnqueueNode(FutexNode* node) {
     // Note: When UnqueueNode() is called from FutexWait(), it might be
     // tempting to reuse the futex key that was passed to FutexWait().
     // However, that could be out of date if the thread was requeued by
     // FutexRequeue(), so we need to re-get the hash table key here.
-    uintptr_t futex_key = node->GetKey();
-
-    FutexNode* old_head = futex_table_.erase(futex_key);
-    DEBUG_ASSERT(old_head);
-    FutexNode* new_head = FutexNode::RemoveNodeFromList(old_head, node);
-    if (new_head)
-        futex_table_.insert(new_head);
-    return true;
+    //
+    // The key only changes while the lock of the bucket for the old key is
+    // held, so once we hold the lock for the key we read, it is either still
+    // the node's key or the node was requeued meanwhile and we try again.
+    while (true) {
+        uintptr_t futex_key = node->GetKey();
+        Bucket* bucket = GetBucket(futex_key);
+        CountBucketAcquire(bucket);
+        Guard<fbl::Mutex> guard{&bucket->lock};
+        if (node->GetKey() != futex_key)
+            continue;
+
+        if (!node->IsInQueue())
+            return false;
+
+        FutexNode* old_head = bucket->futex_table.erase(futex_key);
+        DEBUG_ASSERT(old_head);
+        FutexNode* new_head = FutexNode::RemoveNodeFromList(old_head, node);
+        node->ReleasePiOwner();
+        if (new_head)
+            bucket->futex_table.insert(new_head);
+        return true;
+    }
 }
@@ -17,7 +17,9 @@
 
 #define LOCAL_TRACE 0
 
-FutexNode::FutexNode() {
+// A FutexNode lives on the stack of the thread waiting with it.
+FutexNode::FutexNode()
+    : waiter_(ThreadDispatcher::GetCurrent()) {
     LTRACE_ENTRY;
 }
 
@@ -25,6 +27,59 @@ FutexNode::~FutexNode() {
     LTRACE_ENTRY;
 
     DEBUG_ASSERT(!IsInQueue());
+    DEBUG_ASSERT(!has_pi_owner());
+    // Any owner references are dropped here, by the waiting thread, once it
+    // holds no bucket lock.
+}
+
+bool FutexNode::SetPiOwner(fbl::RefPtr<ThreadDispatcher> owner, int priority) {
+    DEBUG_ASSERT(!has_pi_owner());
+    DEBUG_ASSERT(owner.get() != waiter_);
+    if (pi_owner_) {
+        // A previous owner's reference can't be dropped with the bucket lock
+        // held, so keep it until the node is destroyed. If there is no room
+        // for it, keep lending to nobody rather than lose it.
+        if (!pi_old_owner_) {
+            pi_old_owner_ = fbl::move(pi_owner_);
+        } else if (pi_old_owner_ == pi_owner_) {
+            // Not the last reference, since pi_old_owner_ still holds one.
+            pi_owner_.reset();
+        } else {
+            return false;
+        }
+    }
+    owner->FutexPiBlock(priority);
+    pi_owner_ = fbl::move(owner);
+    pi_priority_ = priority;
+    pi_lending_ = true;
+    return true;
+}
+
+void FutexNode::ReleasePiOwner() {
+    if (pi_lending_) {
+        pi_owner_->FutexPiUnblock();
+        pi_lending_ = false;
+    }
+}
+
+fbl::RefPtr<ThreadDispatcher> FutexNode::GetWaiter() const {
+    DEBUG_ASSERT(IsInQueue());
+    return fbl::WrapRefPtr(waiter_);
+}
+
+// static
+void FutexNode::ReassignPiOwner(FutexNode* list_head,
+                                const fbl::RefPtr<ThreadDispatcher>& new_owner) {
+    FutexNode* node = list_head;
+    do {
+        if (node->has_pi_owner()) {
+            node->ReleasePiOwner();
+            if (new_owner && new_owner.get() != node->waiter_)
+                node->SetPiOwner(new_owner, node->pi_priority_);
+            // else the node keeps the old owner's reference, unlent
+        }
+        node = node->queue_next_;
+    } while (node != list_head);
 }
 
 bool FutexNode::IsInQueue() const {
@@ -83,8 +138,9 @@ FutexNode* FutexNode::WakeThreads(FutexNode* node, uint32_t count,
     FutexNode* const list_end = node->queue_prev_;
     for (uint32_t i = 0; i < count; i++) {
         DEBUG_ASSERT(node->GetKey() == old_hash_key);
-        // Clear this field to avoid any possible confusion.
-        node->set_hash_key(0);
+        // The key is left in place so that a FutexWait() which timed out
+        // concurrently waits for the bucket lock we are holding before it
+        // looks at |node| again.
 
         const bool is_last_node = (node == list_end);
         FutexNode* next = node->queue_next_;
@@ -128,6 +184,8 @@ FutexNode* FutexNode::RemoveFromHead(FutexNode* list_head, uint32_t count,
         // For requeuing, update the key so that FutexWait() can remove the
         // thread from its current queue if the wait operation times out.
         node->set_hash_key(new_hash_key);
+        // The owner of the futex the node moves to is unknown.
+        node->ReleasePiOwner();
 
         node = node->queue_next_;
         if (node == list_head) {
@@ -175,14 +233,15 @@ void FutexNode::WakeThread() {
     // cases to consider:
     //  1) The thread's wait times out, or the thread is killed or
     //     suspended.  In those cases, FutexWait() will reacquire the
-    //     FutexContext lock.  We are currently holding that lock, so
-    //     FutexWait() will not race with us.
+    //     FutexContext bucket lock for the futex.  We are currently holding
+    //     that lock, so FutexWait() will not race with us.
     //  2) The thread is woken by our wait_queue_wake_one() call.  In
     //     this case, FutexWait() will *not* reacquire the FutexContext
-    //     lock.  To handle this correctly, we must not access |this|
+    //     bucket lock.  To handle this correctly, we must not access |this|
     //     after wait_queue_wake_one().
 
     // We must do this before we wake the thread, to handle case 2.
+    ReleasePiOwner();
     MarkAsNotInQueue();
 
     Guard<spin_lock_t, IrqSave> thread_lock_guard{ThreadLock::Get()};
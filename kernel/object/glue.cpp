@@ -21,6 +21,7 @@
 
 #include <lib/oom.h>
 
+#include <object/buffer_chain.h>
 #include <object/diagnostics.h>
 #include <object/excp_port.h>
 #include <object/job_dispatcher.h>
@@ -52,6 +53,15 @@ PolicyManager* GetSystemPolicyManager() {
 static void oom_lowmem(size_t shortfall_bytes) {
     printf("OOM: oom_lowmem(shortfall_bytes=%zu) called\n", shortfall_bytes);
 
+    // Pages pooled for channel messages go before anything is killed.
+    const size_t trimmed_bytes = BufferChain::TrimPool() * PAGE_SIZE;
+    if (trimmed_bytes > 0) {
+        printf("OOM: trimmed %zu bytes of channel buffers\n", trimmed_bytes);
+    }
+    if (trimmed_bytes >= shortfall_bytes) {
+        return;
+    }
+
     bool found = false;
     JobDispatcher::ForEachJob([&found](JobDispatcher* job) {
         if (job->get_kill_on_oom()) {
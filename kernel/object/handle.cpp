@@ -14,8 +14,7 @@
 
 namespace {
 
-// The number of possible handles in the arena.
-constexpr size_t kMaxHandleCount = 256 * 1024u;
+constexpr size_t kMaxHandleCount = Handle::kMaxHandleCount;
 
 // Warning level: high_handle_count() is called when
 // there are this many outstanding handles.
@@ -141,8 +140,10 @@ HandleOwner Handle::Dup(Handle* source, zx_rights_t rights) {
 }
 
 // Called only by Dup.
+// The new handle does not belong to any process until it is added to one,
+// so that it cannot be looked up before then.
 Handle::Handle(Handle* rhs, zx_rights_t rights, uint32_t base_value)
-    : process_id_(rhs->process_id()),
+    : process_id_(0u),
       dispatcher_(rhs->dispatcher_),
       rights_(rights),
       base_value_(base_value) {
@@ -199,11 +200,11 @@ void Handle::Delete() {
 
 Handle* Handle::FromU32(uint32_t value) TA_NO_THREAD_SAFETY_ANALYSIS {
     uintptr_t handle_addr = IndexToHandle(value & kHandleIndexMask);
-    {
-        Guard<fbl::Mutex> guard{ArenaLock::Get()};
-        if (unlikely(!arena_.in_range(handle_addr)))
-            return nullptr;
-    }
+    // Not taking the arena lock is fine, since the memory of a slot stays
+    // valid once allocated. The caller is responsible for checking that the
+    // handle is live, e.g. with process_id().
+    if (unlikely(!arena_.in_range_unlocked(handle_addr)))
+        return nullptr;
     auto handle = reinterpret_cast<Handle*>(handle_addr);
     return likely(handle->base_value() == value) ? handle : nullptr;
 }
@@ -24,6 +24,9 @@
 // It's designed for use with channel messages.  Pages backing a BufferChain are marked as
 // VM_PAGE_STATE_IPC.
 //
+// Freed pages are kept in a small per-cpu pool and reused by later chains, so that steady channel
+// traffic does not need to take the PMM lock.  TrimPool returns them to the PMM.
+//
 // The BufferChain object itself lives *inside* its first buffer.  Here's what it looks like:
 //
 //   +--------------------------------+     +--------------------------------+
@@ -92,7 +95,7 @@ public:
 
         // Allocate a list of pages.
         list_node pages = LIST_INITIAL_VALUE(pages);
-        zx_status_t status = pmm_alloc_pages(num_buffers, 0, &pages);
+        zx_status_t status = AllocPages(num_buffers, &pages);
         if (unlikely(status != ZX_OK)) {
             return nullptr;
         }
@@ -101,8 +104,7 @@ public:
         BufferChain::BufferList temp;
         vm_page_t* page;
         list_for_every_entry (&pages, page, vm_page_t, queue_node) {
-            DEBUG_ASSERT(page->state == VM_PAGE_STATE_ALLOC);
-            page->state = VM_PAGE_STATE_IPC;
+            DEBUG_ASSERT(page->state == VM_PAGE_STATE_IPC);
             void* va = paddr_to_physmap(page->paddr());
             temp.push_front(new (va) BufferChain::Buffer);
         }
@@ -128,9 +130,14 @@ public:
             BufferChain::Buffer* buf = buffers.pop_front();
             buf->Buffer::~Buffer();
         }
-        pmm_free(&pages);
+        FreePages(&pages);
     }
 
+    // Returns the pages pooled by every cpu to the PMM.
+    //
+    // Returns the number of pages freed.
+    static size_t TrimPool();
+
     // Copies |size| bytes from |src| to this chain starting at offset |dst_offset|.
     //
     // |dst_offset| must be in the range [0, kContig).
@@ -180,6 +187,12 @@ private:
         DEBUG_ASSERT(list_is_empty(&pages_));
     }
 
+    // Appends |count| VM_PAGE_STATE_IPC pages to |pages|, from the pool where possible.
+    static zx_status_t AllocPages(size_t count, list_node* pages);
+
+    // Moves |pages| to the pool, and frees whatever does not fit.
+    static void FreePages(list_node* pages);
+
     // |PTR_IN| is a user_in_ptr-like type.
     template <typename PTR_IN>
     zx_status_t CopyInCommon(PTR_IN src, size_t dst_offset, size_t size) {
@@ -11,10 +11,13 @@
 #include <kernel/event.h>
 #include <object/dispatcher.h>
 #include <object/message_packet.h>
+#include <object/object_cache.h>
 
 #include <zircon/rights.h>
+#include <zircon/syscalls/object.h>
 #include <zircon/types.h>
 
+#include <fbl/atomic.h>
 #include <fbl/canary.h>
 #include <fbl/intrusive_double_list.h>
 #include <fbl/mutex.h>
@@ -22,7 +25,8 @@
 #include <fbl/unique_ptr.h>
 
 class ChannelDispatcher final :
-    public PeeredDispatcher<ChannelDispatcher, ZX_DEFAULT_CHANNEL_RIGHTS> {
+    public PeeredDispatcher<ChannelDispatcher, ZX_DEFAULT_CHANNEL_RIGHTS>,
+    public ObjectCached<ChannelDispatcher> {
 public:
     class MessageWaiter;
 
@@ -68,6 +72,16 @@ public:
     // ZX_PROP_CHANNEL_TX_MSG_MAX object property.
     size_t TxMessageMax() const;
 
+    // Counts a message written through this endpoint: |copied| payload bytes copied into the
+    // kernel, and |moved| bytes of VMOs whose handles travel with it.
+    void RecordSent(uint64_t copied, uint64_t moved);
+
+    // Counts a message read through this endpoint, including a call's reply, whose |copied|
+    // payload bytes were copied out of the kernel.
+    void RecordReceived(uint64_t copied);
+
+    void GetStats(zx_info_channel_stats_t* info) const;
+
     // MessageWaiter's state is guarded by the lock of the
     // owning ChannelDispatcher, and Deliver(), Signal(), Cancel(),
     // and EndWait() methods must only be called under
@@ -117,6 +131,7 @@ private:
 
     void RemoveWaiter(MessageWaiter* waiter);
 
+    friend ObjectCache<ChannelDispatcher>;
     explicit ChannelDispatcher(fbl::RefPtr<PeerHolder<ChannelDispatcher>> holder);
     void Init(fbl::RefPtr<ChannelDispatcher> other);
     void WriteSelf(fbl::unique_ptr<MessagePacket> msg) TA_REQ(get_lock());
@@ -136,4 +151,14 @@ private:
 
     uint32_t txid_ TA_GUARDED(get_lock()) = 0;
     WaiterList waiters_ TA_GUARDED(get_lock());
+
+    // Transfer counters for ZX_INFO_CHANNEL_STATS. They are only statistics, so they are
+    // updated without the lock.
+    fbl::atomic<uint64_t> messages_sent_{0};
+    fbl::atomic<uint64_t> messages_received_{0};
+    fbl::atomic<uint64_t> bytes_copied_in_{0};
+    fbl::atomic<uint64_t> bytes_copied_out_{0};
+    fbl::atomic<uint64_t> vmo_bytes_moved_{0};
 };
+
+FWD_DECL_OBJECT_CACHE(ChannelDispatcher)
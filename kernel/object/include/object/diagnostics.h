@@ -44,6 +44,26 @@ zx_status_t GetProcessVmosViaHandles(ProcessDispatcher* process,
                                      user_out_ptr<zx_info_vmo_t> vmos, size_t max,
                                      size_t* actual, size_t* available);
 
+// Like GetVmAspaceMaps(), but starts at the entry named by |cursor|, and
+// returns the cursor for the entry after the last one written via
+// |next_cursor|, or ZX_INFO_CURSOR_END if there are no more. The aspace is
+// walked a batch at a time, and its lock is dropped to copy each batch out.
+// NOTE: Code outside of the syscall layer should not typically know about
+// user_ptrs; do not use this pattern as an example.
+zx_status_t GetVmAspaceMapsPaged(fbl::RefPtr<VmAspace> aspace, uint64_t cursor,
+                                 user_out_ptr<zx_info_maps_t> maps, size_t max,
+                                 size_t* actual, uint64_t* next_cursor);
+
+// Writes an entry into |vmos| for every VMO in the process's handle table and
+// then for every VMO mapped into its aspace, like GetProcessVmosViaHandles()
+// followed by GetVmAspaceVmos(). Pages through them with cursors, a batch
+// per hold of the locks, like GetVmAspaceMapsPaged().
+// NOTE: Code outside of the syscall layer should not typically know about
+// user_ptrs; do not use this pattern as an example.
+zx_status_t GetProcessVmosPaged(ProcessDispatcher* process, uint64_t cursor,
+                                user_out_ptr<zx_info_vmo_t> vmos, size_t max,
+                                size_t* actual, uint64_t* next_cursor);
+
 // Prints (with the supplied prefix) the number of mapped, committed bytes for
 // each process in the system whose page count > |min_pages|. Does not take
 // sharing into account, and does not count unmapped VMOs.
@@ -66,6 +66,7 @@ DECLARE_DISPTAG(BusTransactionInitiatorDispatcher, ZX_OBJ_TYPE_BTI)
 DECLARE_DISPTAG(ProfileDispatcher, ZX_OBJ_TYPE_PROFILE)
 DECLARE_DISPTAG(PinnedMemoryTokenDispatcher, ZX_OBJ_TYPE_PMT)
 DECLARE_DISPTAG(SuspendTokenDispatcher, ZX_OBJ_TYPE_SUSPEND_TOKEN)
+DECLARE_DISPTAG(PagerDispatcher, ZX_OBJ_TYPE_PAGER)
 
 #undef DECLARE_DISPTAG
 
@@ -126,8 +127,9 @@ public:
     void AddObserverLocked(StateObserver* observer,
                            const StateObserver::CountInfo* cinfo) TA_REQ(get_lock());
 
-    // Remove an observer (which must have been added).
-    void RemoveObserver(StateObserver* observer);
+    // Remove an observer (which must have been added). Returns the object's signals at the time of
+    // removal.
+    zx_signals_t RemoveObserver(StateObserver* observer);
 
     // Called when observers of the handle's state (e.g., waits on the handle) should be
     // "cancelled", i.e., when a handle (for the object that owns this StateTracker) is being
@@ -215,13 +217,25 @@ private:
     void UpdateInternalLocked(ObserverList* obs_to_remove,
                               zx_signals_t signals) TA_REQ(get_lock());
 
+    // Calls |func| on the observers which are waiting for any of |signals|, or on every observer
+    // if |all| is true. Observers which |func| flags with kNeedRemoval are moved to
+    // |obs_to_remove|. Returns the union of the flags that |func| returned.
+    template <typename Func>
+    StateObserver::Flags ForEachObserverLocked(ObserverList* obs_to_remove, zx_signals_t signals,
+                                               bool all, Func func) TA_REQ(get_lock());
+
+    void InsertObserverLocked(StateObserver* observer) TA_REQ(get_lock());
+    void RemoveObserverLocked(StateObserver* observer) TA_REQ(get_lock());
+
     const zx_koid_t koid_;
     uint32_t handle_count_ TA_GUARDED(Handle::ArenaLock::Get());
 
     zx_signals_t signals_ TA_GUARDED(get_lock());
 
-    // Active observers are elements in |observers_|.
-    ObserverList observers_ TA_GUARDED(get_lock());
+    // Active observers, grouped by their interest() so that a state change only visits the groups
+    // waiting for one of the new state's signals. This links the first observer of each group, and
+    // the others are linked to it, like the threads in a wait_queue_t.
+    list_node observer_groups_ TA_GUARDED(get_lock()) = LIST_INITIAL_VALUE(observer_groups_);
 
     // Used to store this dispatcher on the dispatcher deleter list.
     fbl::SinglyLinkedListNodeState<Dispatcher*> deleter_ll_;
@@ -11,11 +11,13 @@
 
 #include <fbl/canary.h>
 #include <object/dispatcher.h>
+#include <object/object_cache.h>
 
 #include <sys/types.h>
 
 class EventDispatcher final :
-    public SoloDispatcher<EventDispatcher, ZX_DEFAULT_EVENT_RIGHTS, ZX_EVENT_SIGNALED> {
+    public SoloDispatcher<EventDispatcher, ZX_DEFAULT_EVENT_RIGHTS, ZX_EVENT_SIGNALED>,
+    public ObjectCached<EventDispatcher> {
 public:
     static zx_status_t Create(uint32_t options, fbl::RefPtr<Dispatcher>* dispatcher,
                               zx_rights_t* rights);
@@ -25,7 +27,10 @@ public:
     CookieJar* get_cookie_jar() final { return &cookie_jar_; }
 
 private:
+    friend ObjectCache<EventDispatcher>;
     explicit EventDispatcher(uint32_t options);
     fbl::Canary<fbl::magic("EVTD")> canary_;
     CookieJar cookie_jar_;
 };
+
+FWD_DECL_OBJECT_CACHE(EventDispatcher)
@@ -34,6 +34,15 @@ public:
     zx_status_t ReadToUser(size_t elem_size, user_out_ptr<uint8_t> dst, size_t count,
                            size_t* actual);
 
+    // Thresholds are counted in elements. ZX_FIFO_READ_THRESHOLD is asserted while at least the
+    // read threshold's worth of elements can be read from this endpoint, and
+    // ZX_FIFO_WRITE_THRESHOLD while at least the write threshold's worth can be written to it.
+    // A threshold of zero disables its signal.
+    uint32_t GetReadThreshold() const;
+    zx_status_t SetReadThreshold(size_t value);
+    uint32_t GetWriteThreshold() const;
+    zx_status_t SetWriteThreshold(size_t value);
+
     // PeeredDispatcher implementation.
     void on_zero_handles_locked() TA_REQ(get_lock());
     void OnPeerZeroHandlesLocked() TA_REQ(get_lock());
@@ -54,6 +63,8 @@ private:
 
     uint32_t head_ TA_GUARDED(get_lock());
     uint32_t tail_ TA_GUARDED(get_lock());
+    uint32_t read_threshold_ TA_GUARDED(get_lock());
+    uint32_t write_threshold_ TA_GUARDED(get_lock());
     fbl::unique_ptr<uint8_t[]> data_ TA_GUARDED(get_lock());
 
     static constexpr uint32_t kMaxSizeBytes = PAGE_SIZE;
@@ -9,12 +9,14 @@
 #include <lib/user_copy/user_ptr.h>
 #include <zircon/types.h>
 #include <fbl/mutex.h>
+#include <fbl/ref_ptr.h>
 #include <kernel/lockdep.h>
 #include <object/futex_node.h>
 
 // FutexContext is a class that encapsulates support for futex operations.
 // FutexContext uses a hash table keyed on the futex address (a pointer to integer in userspace)
-// to contain all active futexes.
+// to contain all active futexes. The table is split into buckets, each with its own lock,
+// so that operations on unrelated futexes do not serialize on a single per-process lock.
 // A futex is considered active if there is one or more threads blocked on the futex.
 // After no threads are left blocked on a futex it is removed from the hash table.
 // The value in the futex hash table is the FutexNode object associated with the head
@@ -34,7 +36,14 @@ public:
     // Otherwise it will block the current thread until the |deadline| passes,
     // or until the thread is woken by a FutexWake or FutexRequeue operation
     // on the same |value_ptr| futex.
-    zx_status_t FutexWait(user_in_ptr<const int> value_ptr, int current_value, zx_time_t deadline);
+    //
+    // If |owner| is not null, the futex is priority-inheriting: while the current
+    // thread is blocked, |owner| runs at least at the current thread's priority.
+    // If the waker then wakes a single thread, the threads still blocked lend
+    // their priority to the woken thread instead, which is expected to become
+    // the new owner.
+    zx_status_t FutexWait(user_in_ptr<const int> value_ptr, int current_value, zx_time_t deadline,
+                          fbl::RefPtr<ThreadDispatcher> owner = nullptr);
 
     // FutexWake will wake up to |count| number of threads blocked on the |value_ptr| futex.
     zx_status_t FutexWake(user_in_ptr<const int> value_ptr, uint32_t count);
@@ -52,14 +61,35 @@ private:
     FutexContext(const FutexContext&) = delete;
     FutexContext& operator=(const FutexContext&) = delete;
 
-    void QueueNodesLocked(FutexNode* head) TA_REQ(lock_);
+    static constexpr size_t kNumBuckets = 16u;
 
-    bool UnqueueNodeLocked(FutexNode* node) TA_REQ(lock_);
+    struct Bucket {
+        // protects futex_table
+        DECLARE_MUTEX(Bucket) lock;
 
-    // protects futex_table_
-    DECLARE_MUTEX(FutexContext) lock_;
+        // Hash table for the futexes of this bucket.
+        // Key is futex address, value is the FutexNode for the head of futex's blocked
+        // thread list.
+        FutexNode::HashTable futex_table TA_GUARDED(lock);
+    };
 
-    // Hash table for futexes in this context.
-    // Key is futex address, value is the FutexNode for the head of futex's blocked thread list.
-    FutexNode::HashTable futex_table_ TA_GUARDED(lock_);
+    Bucket* GetBucket(uintptr_t futex_key);
+
+    // Accounts for an acquisition of the lock of |bucket|, and whether it looked
+    // contended. Called right before acquiring it.
+    static void CountBucketAcquire(Bucket* bucket);
+
+    zx_status_t FutexRequeueLocked(Bucket* wake_bucket, Bucket* requeue_bucket,
+                                   AutoReschedDisable* resched_disable,
+                                   user_in_ptr<const int> wake_ptr, uint32_t wake_count,
+                                   int current_value, user_in_ptr<const int> requeue_ptr,
+                                   uint32_t requeue_count) TA_NO_THREAD_SAFETY_ANALYSIS;
+
+    static void QueueNodesLocked(Bucket* bucket, FutexNode* head) TA_REQ(bucket->lock);
+
+    // Removes |node| from the futex wait queue it is on, if any. Returns whether it was
+    // found. Acquires the lock of the bucket of the node's current futex.
+    bool UnqueueNode(FutexNode* node);
+
+    Bucket buckets_[kNumBuckets];
 };
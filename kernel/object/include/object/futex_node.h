@@ -13,12 +13,17 @@
 #include <zircon/types.h>
 #include <fbl/intrusive_hash_table.h>
 #include <fbl/mutex.h>
+#include <fbl/ref_ptr.h>
+
+class ThreadDispatcher;
 
 // Node for linked list of threads blocked on a futex
 // Intended to be embedded within a ThreadDispatcher Instance
 class FutexNode : public fbl::SinglyLinkedListable<FutexNode*> {
 public:
-    using HashTable = fbl::HashTable<uintptr_t, FutexNode*>;
+    // Each FutexContext bucket has its own table, so a few chains per table are enough.
+    using HashTable = fbl::HashTable<uintptr_t, FutexNode*, fbl::SinglyLinkedList<FutexNode*>,
+                                     size_t, 7>;
 
     FutexNode();
     ~FutexNode();
@@ -50,6 +55,25 @@ public:
         hash_key_ = key;
     }
 
+    // Makes the waiting thread lend |priority| to |owner| until the node is
+    // woken, requeued or removed from its queue. Returns false, lending
+    // nothing, if the node has no room left for the references of the owners
+    // it lent to before.
+    bool SetPiOwner(fbl::RefPtr<ThreadDispatcher> owner, int priority);
+    bool has_pi_owner() const { return pi_lending_; }
+    // Stops lending the waiting thread's priority to the owner, if any. The
+    // reference to the owner is kept until the node is destroyed, since the
+    // last reference must not be dropped with a bucket lock held.
+    void ReleasePiOwner();
+    // Returns a reference to the waiting thread, while it is still queued.
+    fbl::RefPtr<ThreadDispatcher> GetWaiter() const;
+
+    // Points every node of the list at |list_head| that lends its priority
+    // to a futex owner at |new_owner| instead, or makes them stop lending it
+    // if |new_owner| is null.
+    static void ReassignPiOwner(FutexNode* list_head,
+                                const fbl::RefPtr<ThreadDispatcher>& new_owner);
+
     // Trait implementation for fbl::HashTable
     uintptr_t GetKey() const { return hash_key_; }
     static size_t GetHash(uintptr_t key) { return (key >> 3); }
@@ -64,7 +88,9 @@ private:
 
     // hash_key_ contains the futex address.  This field has two roles:
     //  * It is used by FutexWait() to determine which queue to remove the
-    //    thread from when a wait operation times out.
+    //    thread from when a wait operation times out.  It is only changed
+    //    with the FutexContext bucket lock for the key held, and keeps its
+    //    value when the thread is woken.
     //  * Additionally, when this FutexNode is the head of a futex wait
     //    queue, this field is used by the HashTable (because it uses
     //    intrusive SinglyLinkedLists).
@@ -80,4 +106,15 @@ private:
     //  * When the thread is not waiting on a futex, queue_next_ is null.
     FutexNode* queue_prev_ = nullptr;
     FutexNode* queue_next_ = nullptr;
+
+    // For priority-inheriting waits, the thread owning the futex, to which
+    // this thread's priority is lent while |pi_lending_|, a previous owner
+    // whose reference is kept until the node is destroyed, and the waiting
+    // thread itself. Only changed with the FutexContext bucket lock for the
+    // key held.
+    fbl::RefPtr<ThreadDispatcher> pi_owner_;
+    fbl::RefPtr<ThreadDispatcher> pi_old_owner_;
+    ThreadDispatcher* const waiter_;
+    int pi_priority_ = -1;
+    bool pi_lending_ = false;
 };
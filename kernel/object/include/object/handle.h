@@ -83,6 +83,9 @@ public:
     // other things like |Dispatcher::handle_count_|.
     DECLARE_SINGLETON_MUTEX(ArenaLock);
 
+    // The number of possible handles in the arena.
+    static constexpr size_t kMaxHandleCount = 256 * 1024u;
+
     // Returns the Dispatcher to which this instance points.
     const fbl::RefPtr<Dispatcher>& dispatcher() const { return dispatcher_; }
 
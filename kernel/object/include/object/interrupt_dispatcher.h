@@ -38,13 +38,21 @@ public:
     zx_status_t Ack();
     zx_status_t Destroy();
     void InterruptHandler();
+    // |options| may hold ZX_INTERRUPT_BIND_POLL, which keeps the interrupt
+    // masked from when its packet is queued until it is acked, so that the
+    // driver can poll the device for as long as it has work.
     zx_status_t Bind(fbl::RefPtr<PortDispatcher> port_dispatcher,
-                     fbl::RefPtr<InterruptDispatcher> interrupt, uint64_t key);
+                     fbl::RefPtr<InterruptDispatcher> interrupt, uint64_t key,
+                     uint32_t options);
+    // Steers the interrupt to |cpu|.
+    zx_status_t SetAffinity(cpu_num_t cpu);
 
 protected:
     virtual void MaskInterrupt() = 0;
     virtual void UnmaskInterrupt() = 0;
     virtual void UnregisterInterruptHandler() = 0;
+    // Interrupts which cannot be steered, like virtual ones, keep this.
+    virtual zx_status_t SetInterruptAffinity(cpu_num_t cpu) { return ZX_ERR_NOT_SUPPORTED; }
     InterruptDispatcher();
     void on_zero_handles() final;
     void Signal() {
@@ -25,6 +25,7 @@ protected:
     void MaskInterrupt() final;
     void UnmaskInterrupt() final;
     void UnregisterInterruptHandler() final;
+    zx_status_t SetInterruptAffinity(cpu_num_t cpu) final;
 
 private:
     explicit InterruptEventDispatcher(uint32_t vector)
@@ -124,6 +124,10 @@ public:
     // false if any methods of |je| return false; returns true otherwise.
     bool EnumerateChildren(JobEnumerator* je, bool recurse);
 
+    // Sums the scheduler stats of every thread that has run in this job or
+    // any of its descendants, including those that have since exited.
+    void GetSchedStats(zx_info_task_sched_stats_t* stats);
+
     fbl::RefPtr<ProcessDispatcher> LookupProcessById(zx_koid_t koid);
     fbl::RefPtr<JobDispatcher> LookupJobById(zx_koid_t koid);
 
@@ -179,6 +183,8 @@ private:
     uint32_t job_count_ TA_GUARDED(get_lock());
     // TODO(cpu): The OOM kill system is incomplete, see ZX-2731 for details.
     bool kill_on_oom_ TA_GUARDED(get_lock());
+    // scheduler stats of the processes and jobs that have left |procs_| and |jobs_|
+    zx_info_task_sched_stats_t retired_sched_stats_ TA_GUARDED(get_lock()) = {};
 
     using RawJobList =
         fbl::DoublyLinkedList<JobDispatcher*, ListTraitsRaw>;
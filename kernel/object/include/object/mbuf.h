@@ -8,6 +8,7 @@
 
 #include <stdint.h>
 
+#include <arch/defines.h>
 #include <lib/user_copy/user_ptr.h>
 #include <zircon/types.h>
 #include <fbl/intrusive_single_list.h>
@@ -21,12 +22,18 @@ public:
     MBufChain() = default;
     ~MBufChain();
 
-    // Writes |len| bytes of stream data from |src| and sets |written| to number of bytes written.
+    // Writes the stream data held in the |iov_count| user buffers described by |iov| and sets
+    // |written| to number of bytes written. The buffers are consumed in order, so a short write
+    // leaves the chain holding a prefix of their concatenation.
+    //
+    // |iov| itself must be in kernel memory; the buffers it points to are user memory.
     //
     // Returns an error on failure.
-    zx_status_t WriteStream(user_in_ptr<const void> src, size_t len, size_t* written);
+    zx_status_t WriteStream(const zx_iovec_t* iov, size_t iov_count, size_t* written);
 
-    // Writes a datagram of |len| bytes from |src| and sets |written| to number of bytes written.
+    // Writes a datagram of |len| bytes gathered from the |iov_count| user buffers described by
+    // |iov| and sets |written| to number of bytes written. |len| must be the sum of the buffer
+    // lengths.
     //
     // This operation is atomic in that either the entire datagram is written successfully or the
     // chain is unmodified.
@@ -34,9 +41,11 @@ public:
     // Writing a zero-length datagram is an error.
     //
     // Returns an error on failure.
-    zx_status_t WriteDatagram(user_in_ptr<const void> src, size_t len, size_t* written);
+    zx_status_t WriteDatagram(const zx_iovec_t* iov, size_t iov_count, size_t len,
+                              size_t* written);
 
-    // Reads upto |len| bytes from chain into |dst|.
+    // Reads upto |len| bytes from chain, scattering them across the |iov_count| user buffers
+    // described by |iov|. |len| must not exceed the sum of the buffer lengths.
     //
     // When |datagram| is false, the data in the chain is treated as a stream (no boundaries).
     //
@@ -45,7 +54,7 @@ public:
     // partial datagram is returned and its remaining bytes are discarded.
     //
     // Returns number of bytes read.
-    size_t Read(user_out_ptr<void> dst, size_t len, bool datagram);
+    size_t Read(const zx_iovec_t* iov, size_t iov_count, size_t len, bool datagram);
 
     bool is_full() const;
     bool is_empty() const;
@@ -61,20 +70,37 @@ public:
     }
 
     // Returns the maximum number of bytes that can be stored in the chain.
-    size_t max_size() const { return kSizeMax; }
+    size_t max_size() const { return max_size_; }
+
+    // Sets the maximum number of bytes that can be stored in the chain to |max_size|, which must
+    // be in the range [1, kMaxSizeLimit] and no smaller than the number of bytes already stored.
+    //
+    // When |page_backed| is true, buffers allocated from now on are whole pages from the PMM
+    // rather than small heap blocks, so bulk transfers need fewer, larger buffers. Data already in
+    // the chain stays where it is.
+    zx_status_t SetMaxSize(size_t max_size, bool page_backed);
 
 private:
-    // An MBuf is a small fixed-size chainable memory buffer.
+    // An MBuf is a fixed-size chainable memory buffer. It is either a small heap block or, when
+    // the chain is page backed, a whole page with the header at its start.
     struct MBuf : public fbl::SinglyLinkedListable<MBuf*> {
         // 8 for the linked list and 4 for the explicit uint32_t fields.
         static constexpr size_t kHeaderSize = 8 + (4 * 4);
         // 16 is for the malloc header.
         static constexpr size_t kMallocSize = 2048 - 16;
         static constexpr size_t kPayloadSize = kMallocSize - kHeaderSize;
+        static constexpr size_t kPagePayloadSize = PAGE_SIZE - kHeaderSize;
 
         // Returns number of bytes of free space in this MBuf.
         size_t rem() const;
 
+        bool is_page() const { return cap_ == kPagePayloadSize; }
+
+        // Returns the start of the payload. A page-backed MBuf's payload runs on past the end of
+        // the struct to the end of its page, so the payload is always reached through this
+        // pointer and never by indexing |payload_|.
+        char* data() { return reinterpret_cast<char*>(this) + kHeaderSize; }
+
         uint32_t off_ = 0u;
         uint32_t len_ = 0u;
         // pkt_len_ is set to the total number of bytes in a packet
@@ -83,19 +109,35 @@ private:
         //
         // Always 0 in ZX_SOCKET_STREAM mode.
         uint32_t pkt_len_ = 0u;
-        uint32_t unused_;
-        char data_[kPayloadSize] = {0};
-        // TODO: maybe union data_ with char* blocks for large messages
+        // Number of bytes of payload space starting at data().
+        uint32_t cap_ = kPayloadSize;
+        // Reserves the payload space of a heap MBuf. Use data() instead.
+        char payload_[kPayloadSize];
     };
     static_assert(sizeof(MBuf) == MBuf::kMallocSize, "");
 
-    static constexpr size_t kSizeMax = 128 * MBuf::kPayloadSize;
+public:
+    static constexpr size_t kDefaultSizeMax = 128 * MBuf::kPayloadSize;
+    // Nothing charges a socket's buffered data to its owner, so the limit is kept to a small
+    // multiple of the default to bound the kernel memory a process can pin per socket.
+    static constexpr size_t kMaxSizeLimit = 4 * kDefaultSizeMax;
+
+private:
+    // Number of free page-backed MBufs kept around for reuse. The rest go back to the PMM so that
+    // an idle socket with a large capacity doesn't pin its peak usage.
+    static constexpr size_t kMaxFreePages = 8;
 
     MBuf* AllocMBuf();
     void FreeMBuf(MBuf* buf);
+    static MBuf* AllocPageMBuf();
+    static void DestroyMBuf(MBuf* buf);
 
     fbl::SinglyLinkedList<MBuf*> freelist_;
+    fbl::SinglyLinkedList<MBuf*> page_freelist_;
+    size_t page_freelist_count_ = 0u;
     fbl::SinglyLinkedList<MBuf*> tail_;
     MBuf* head_ = nullptr;
     size_t size_ = 0u;
+    size_t max_size_ = kDefaultSizeMax;
+    bool page_backed_ = false;
 };
@@ -0,0 +1,53 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <fbl/mutex.h>
+#include <fbl/slab_allocator.h>
+#include <zircon/syscalls/object.h>
+#include <zircon/types.h>
+
+// Kernel objects which are created and destroyed at a high rate, like
+// channels and events, are carved out of dedicated slabs of fixed size
+// blocks instead of coming from the general heap. This keeps them from
+// fragmenting the heap and makes their allocation a free list pop.
+//
+// A cached type T derives from ObjectCached<T>, befriends ObjectCache<T>
+// so that it can call its constructor, and is created with
+// ObjectCache<T>::New(). Deleting a T returns its block to the cache.
+// The storage of the cache is declared with DECLARE_OBJECT_CACHE(T, ...)
+// in the .cpp file of the type, and with FWD_DECL_OBJECT_CACHE(T) after
+// the type in its header.
+//
+// Slabs are never given back to the heap, so the number of slabs of each
+// cache is bounded.
+
+constexpr size_t kObjectCacheSlabSize = 16 * 1024u;
+
+template <typename T>
+using ObjectCacheTraits =
+    fbl::StaticSlabAllocatorTraits<T*, kObjectCacheSlabSize, fbl::Mutex, true>;
+
+template <typename T>
+using ObjectCache = fbl::SlabAllocator<ObjectCacheTraits<T>>;
+
+template <typename T>
+using ObjectCached = fbl::SlabAllocated<ObjectCacheTraits<T>>;
+
+// Declares the storage of the cache for |T|, allowing up to |max_objects|
+// live objects.
+#define DECLARE_OBJECT_CACHE(T, max_objects)                      \
+    DECLARE_STATIC_SLAB_ALLOCATOR_STORAGE(                        \
+        ObjectCacheTraits<T>,                                     \
+        ((max_objects) + ObjectCache<T>::AllocsPerSlab - 1) /     \
+            ObjectCache<T>::AllocsPerSlab)
+
+#define FWD_DECL_OBJECT_CACHE(T) FWD_DECL_STATIC_SLAB_ALLOCATOR(ObjectCacheTraits<T>)
+
+// Fills in up to |count| entries of |info| with the state of the object
+// caches, and returns the total number of caches.
+size_t GetObjectCacheInfo(zx_info_kmem_object_cache_t* info, size_t count);
@@ -0,0 +1,77 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <zircon/rights.h>
+#include <zircon/types.h>
+
+#include <fbl/canary.h>
+#include <fbl/intrusive_double_list.h>
+#include <object/dispatcher.h>
+#include <object/port_dispatcher.h>
+#include <vm/page_source.h>
+#include <vm/vm_object.h>
+
+#include <sys/types.h>
+
+class PagerDispatcher;
+
+// The page source of a VMO created by a pager. Pages missing from the VMO are
+// requested by queuing ZX_PKT_TYPE_PAGE_REQUEST packets on the pager's port.
+class PagerSource final : public PageSource,
+                          public fbl::DoublyLinkedListable<fbl::RefPtr<PagerSource>> {
+public:
+    PagerSource(fbl::RefPtr<PagerDispatcher> pager, fbl::RefPtr<PortDispatcher> port,
+                uint64_t key);
+    ~PagerSource() final;
+
+    const PagerDispatcher* pager() const { return pager_.get(); }
+
+private:
+    zx_status_t SendRequest(uint64_t offset, uint64_t len) final;
+    void OnDetach() final;
+
+    zx_status_t QueuePacket(uint16_t command, uint64_t offset, uint64_t len);
+
+    const fbl::RefPtr<PagerDispatcher> pager_;
+    const fbl::RefPtr<PortDispatcher> port_;
+    const uint64_t key_;
+};
+
+// A pager creates VMOs whose contents are supplied from user mode: every
+// page a VMO is missing is requested on the port the VMO was created with,
+// and stays missing until the pager supplies it with SupplyPages().
+class PagerDispatcher final : public SoloDispatcher<PagerDispatcher, ZX_DEFAULT_PAGER_RIGHTS> {
+public:
+    static zx_status_t Create(fbl::RefPtr<Dispatcher>* dispatcher, zx_rights_t* rights);
+
+    ~PagerDispatcher() final;
+    zx_obj_type_t get_type() const final { return ZX_OBJ_TYPE_PAGER; }
+    void on_zero_handles() final;
+
+    // Creates a VMO of |size| bytes whose missing pages are requested on
+    // |port| with packets carrying |key|.
+    zx_status_t CreateVmo(fbl::RefPtr<PortDispatcher> port, uint64_t key, uint64_t size,
+                          fbl::RefPtr<VmObject>* vmo);
+
+    // Moves the pages of [aux_offset, aux_offset + length) out of |aux_vmo|
+    // into [offset, offset + length) of |vmo|, which must have been created by
+    // this pager. All offsets and the length must be page aligned.
+    zx_status_t SupplyPages(VmObject* vmo, uint64_t offset, uint64_t length,
+                            VmObject* aux_vmo, uint64_t aux_offset);
+
+    // Forgets about a source once its VMO or this pager goes away.
+    void RemoveSource(PagerSource* src);
+
+private:
+    PagerDispatcher();
+
+    fbl::Canary<fbl::magic("PGRD")> canary_;
+
+    bool closed_ TA_GUARDED(get_lock()) = false;
+    fbl::DoublyLinkedList<fbl::RefPtr<PagerSource>> srcs_ TA_GUARDED(get_lock());
+};
@@ -28,6 +28,7 @@ protected:
     void MaskInterrupt() final;
     void UnmaskInterrupt() final;
     void UnregisterInterruptHandler() final;
+    zx_status_t SetInterruptAffinity(cpu_num_t cpu) final;
 
 private:
     static pcie_irq_handler_retval_t IrqThunk(const PcieDevice& dev,
@@ -14,6 +14,7 @@
 #include <zircon/syscalls/port.h>
 #include <zircon/types.h>
 
+#include <fbl/atomic.h>
 #include <fbl/canary.h>
 #include <fbl/intrusive_double_list.h>
 #include <fbl/mutex.h>
@@ -94,6 +95,11 @@ struct PortPacket final : public fbl::DoublyLinkedListable<PortPacket*> {
     const void* const handle;
     fbl::unique_ptr<const PortObserver> observer;
     PortAllocator* const allocator;
+    // For ZX_WAIT_ASYNC_LEVEL waits, the latest state of the observed object.
+    // Written by the observer under the object's lock and read by the port
+    // under its spinlock, hence atomic.
+    fbl::atomic<zx_signals_t> level_state;
+    bool is_level = false;
 
     PortPacket(const void* handle, PortAllocator* allocator);
     PortPacket(const PortPacket&) = delete;
@@ -114,8 +120,8 @@ struct PortInterruptPacket final : public fbl::DoublyLinkedListable<PortInterrup
 // callbacks.
 class PortObserver final : public StateObserver {
 public:
-    PortObserver(uint32_t type, const Handle* handle, fbl::RefPtr<PortDispatcher> port,
-                 uint64_t key, zx_signals_t signals);
+    PortObserver(uint32_t type, bool level, const Handle* handle,
+                 fbl::RefPtr<PortDispatcher> port, uint64_t key, zx_signals_t signals);
     ~PortObserver() = default;
 
 private:
@@ -123,6 +129,8 @@ private:
     PortObserver& operator=(const PortObserver&) = delete;
 
     // StateObserver overrides.
+    // Level-triggered packets track every change while queued.
+    zx_signals_t interest() const final { return packet_.is_level ? kAllChanges : trigger_; }
     Flags OnInitialize(zx_signals_t initial_state, const StateObserver::CountInfo* cinfo) final;
     Flags OnStateChange(zx_signals_t new_state) final;
     Flags OnCancel(const Handle* handle) final;
@@ -147,6 +155,7 @@ private:
 //  2- Object state change notification: zx_object_wait_async()
 //      a) single-shot mode
 //      b) repeating mode
+//      c) level-triggered mode
 //  3- Manual queuing: zx_port_queue()
 //  4- Interrupt change notification: zx_interrupt_bind()
 //
@@ -160,6 +169,19 @@ private:
 // When a packet from any of the sources arrives to the port, one waiting
 // thread unblocks and gets the packet. In all cases |sema_| is used to signal
 // and manage the waiting threads.
+//
+// Both packet lists are protected by |spinlock_| rather than the dispatcher
+// lock, which is only used for the exception port bookkeeping. Queuing and
+// dequeuing only hold the spinlock for the few instructions it takes to link
+// or unlink a packet, so many threads queuing to and waiting on one port do
+// not end up blocking on each other. Anything that might need to free memory
+// (ephemeral packets, reaped observers) is done after dropping the spinlock.
+//
+// A level-triggered wait (2c) keeps its packet in |packets_| for as long as
+// the watched signals stay asserted: dequeuing it hands out a copy and puts
+// it back at the tail, and a dequeue that finds the signals deasserted drops
+// it until the next state change queues it again. The waits registered on a
+// port thus form a persistent readiness list, in the manner of epoll.
 
 class PortDispatcher final : public SoloDispatcher<PortDispatcher, ZX_DEFAULT_PORT_RIGHTS> {
 public:
@@ -178,6 +200,12 @@ public:
     zx_status_t QueueUser(const zx_port_packet_t& packet);
     bool QueueInterruptPacket(PortInterruptPacket* port_packet, zx_time_t timestamp);
     zx_status_t Dequeue(zx_time_t deadline, zx_port_packet_t* packet);
+    // Like Dequeue() but once at least one packet is available, also takes
+    // up to |count| - 1 more that are already queued, without blocking again.
+    // |count| must be between 1 and kMaxDequeueCount.
+    zx_status_t DequeueMany(zx_time_t deadline, zx_port_packet_t* packets, size_t count,
+                            size_t* actual);
+    static constexpr size_t kMaxDequeueCount = 16u;
     bool RemoveInterruptPacket(PortInterruptPacket* port_packet);
 
     // Decides who is going to destroy the observer. If it returns the
@@ -199,7 +227,17 @@ private:
 
     explicit PortDispatcher(uint32_t options);
 
-    void FreePacket(PortPacket* port_packet) TA_REQ(get_lock());
+    // Packets removed from |packets_| are released in two steps. Under
+    // |spinlock_|, DetachPacket() takes ownership of whatever has to be
+    // destroyed with the packet, since once the lock is dropped the packet
+    // itself may be destroyed by its observer at any time. After dropping
+    // the lock, ReleasePacket() destroys it.
+    struct DetachedPacket {
+        fbl::unique_ptr<const PortObserver> observer;
+        PortPacket* ephemeral = nullptr;
+    };
+    DetachedPacket DetachPacket(PortPacket* port_packet) TA_REQ(spinlock_);
+    static void ReleasePacket(DetachedPacket detached);
 
     // Adopts a RefPtr to |eport|, and adds it to |eports_|.
     // Called by ExceptionPort.
@@ -213,13 +251,13 @@ private:
     fbl::Canary<fbl::magic("PORT")> canary_;
     const uint32_t options_;
     Semaphore sema_;
-    bool zero_handles_ TA_GUARDED(get_lock());
-
-    // Next three members handle the object, manual and exception notifications.
-    size_t num_packets_ TA_GUARDED(get_lock());
-    fbl::DoublyLinkedList<PortPacket*> packets_ TA_GUARDED(get_lock());
     fbl::DoublyLinkedList<fbl::RefPtr<ExceptionPort>> eports_ TA_GUARDED(get_lock());
-    // Next two members handle the interrupt notifications.
+
     DECLARE_SPINLOCK(PortDispatcher) spinlock_;
+    bool zero_handles_ TA_GUARDED(spinlock_);
+    // Next two members handle the object, manual and exception notifications.
+    size_t num_packets_ TA_GUARDED(spinlock_);
+    fbl::DoublyLinkedList<PortPacket*> packets_ TA_GUARDED(spinlock_);
+    // Next member handles the interrupt notifications.
     fbl::DoublyLinkedList<PortInterruptPacket*> interrupt_packets_ TA_GUARDED(spinlock_);
 };
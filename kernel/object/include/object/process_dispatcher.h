@@ -180,6 +180,35 @@ public:
         return ZX_OK;
     }
 
+    // Calls the provided
+    // |bool func(zx_handle_t, zx_rights_t, const Dispatcher*)|
+    // on the handles owned by the process, starting at the handle whose value
+    // is |start|. Starts at the first handle if |start| is ZX_HANDLE_INVALID
+    // or no longer names a handle owned by the process. Stops if |func|
+    // returns false, returning the value of the handle it stopped at, which
+    // was not consumed. Returns ZX_HANDLE_INVALID after the last handle.
+    //
+    // New handles go at the front of the table, so a walk resumed this way
+    // does not see handles added since it started.
+    template <typename T>
+    zx_handle_t ForEachHandleFrom(zx_handle_t start, T func) {
+        Guard<fbl::Mutex> guard{&handle_table_lock_};
+        auto itr = handles_.begin();
+        if (start != ZX_HANDLE_INVALID) {
+            Handle* handle = GetHandleLocked(start, /*skip_policy=*/true);
+            if (handle != nullptr) {
+                itr = handles_.make_iterator(*handle);
+            }
+        }
+        for (; itr != handles_.end(); ++itr) {
+            const Dispatcher* dispatcher = itr->dispatcher().get();
+            if (!func(MapHandleToValue(&*itr), itr->rights(), dispatcher)) {
+                return MapHandleToValue(&*itr);
+            }
+        }
+        return ZX_HANDLE_INVALID;
+    }
+
     // accessors
     Lock<fbl::Mutex>* handle_table_lock() TA_RET_CAP(handle_table_lock_) {
         return &handle_table_lock_;
@@ -198,12 +227,18 @@ public:
     // Syscall helpers
     zx_status_t GetInfo(zx_info_process_t* info);
     zx_status_t GetStats(zx_info_task_stats_t* stats);
+    // Sums the scheduler stats of the live and exited threads of the process.
+    void GetSchedStats(zx_info_task_sched_stats_t* stats);
     // NOTE: Code outside of the syscall layer should not typically know about
     // user_ptrs; do not use this pattern as an example.
     zx_status_t GetAspaceMaps(user_out_ptr<zx_info_maps_t> maps, size_t max,
                               size_t* actual, size_t* available);
     zx_status_t GetVmos(user_out_ptr<zx_info_vmo_t> vmos, size_t max,
                         size_t* actual, size_t* available);
+    zx_status_t GetAspaceMapsPaged(uint64_t cursor, user_out_ptr<zx_info_maps_t> maps,
+                                   size_t max, size_t* actual, uint64_t* next_cursor);
+    zx_status_t GetVmosPaged(uint64_t cursor, user_out_ptr<zx_info_vmo_t> vmos,
+                             size_t max, size_t* actual, uint64_t* next_cursor);
 
     zx_status_t GetThreads(fbl::Array<zx_koid_t>* threads);
 
@@ -277,6 +312,17 @@ private:
     zx_status_t GetDispatcherInternal(zx_handle_t handle_value, fbl::RefPtr<Dispatcher>* dispatcher,
                                       zx_rights_t* rights);
 
+    // Looks up |handle_value| without taking |handle_table_lock_|. Returns
+    // false if the handle was not found, in which case the lookup must be
+    // retried with the lock held.
+    bool GetDispatcherUnlocked(zx_handle_t handle_value, fbl::RefPtr<Dispatcher>* dispatcher,
+                               zx_rights_t* rights);
+
+    // Waits until no cpu is reading the handle table without holding
+    // |handle_table_lock_|. Must be called after removing handles from the
+    // table and before they can be torn down.
+    void WaitForHandleReadersLocked() TA_REQ(handle_table_lock_);
+
     zx_status_t GetDispatcherWithRightsInternal(zx_handle_t handle_value, zx_rights_t desired_rights,
                                                 fbl::RefPtr<Dispatcher>* dispatcher_out,
                                                 zx_rights_t* out_rights);
@@ -313,6 +359,9 @@ private:
     using ThreadList = fbl::DoublyLinkedList<ThreadDispatcher*, ThreadDispatcher::ThreadListTraits>;
     ThreadList thread_list_ TA_GUARDED(get_lock());
 
+    // scheduler stats of the threads that have left |thread_list_|
+    zx_info_task_sched_stats_t exited_sched_stats_ TA_GUARDED(get_lock()) = {};
+
     // our address space
     fbl::RefPtr<VmAspace> aspace_;
 
@@ -35,6 +35,10 @@ public:
     // Socket methods.
     zx_status_t Write(user_in_ptr<const void> src, size_t len, size_t* written);
 
+    // Gathers data from the |iov_count| user buffers described by |iov|. |iov|
+    // itself must already be in kernel memory.
+    zx_status_t WriteV(const zx_iovec_t* iov, size_t iov_count, size_t* written);
+
     zx_status_t WriteControl(user_in_ptr<const void> src, size_t len);
 
     // Shut this endpoint of the socket down for reading, writing, or both.
@@ -44,6 +48,10 @@ public:
 
     zx_status_t Read(user_out_ptr<void> dst, size_t len, size_t* nread);
 
+    // Scatters data into the |iov_count| user buffers described by |iov|.
+    // |iov| itself must already be in kernel memory.
+    zx_status_t ReadV(const zx_iovec_t* iov, size_t iov_count, size_t* nread);
+
     zx_status_t ReadControl(user_out_ptr<void> dst, size_t len, size_t* nread);
 
     // On success, the share queue takes ownership of |h|. On failure,
@@ -55,6 +63,7 @@ public:
 
     // Property methods.
     size_t ReceiveBufferMax() const;
+    zx_status_t SetReceiveBufferMax(size_t value);
     size_t ReceiveBufferSize() const;
     size_t TransmitBufferMax() const;
     size_t TransmitBufferSize() const;
@@ -82,7 +91,8 @@ private:
                      zx_signals_t starting_signals, uint32_t flags,
                      fbl::unique_ptr<ControlMsg> control_msg);
     void Init(fbl::RefPtr<SocketDispatcher> other);
-    zx_status_t WriteSelfLocked(user_in_ptr<const void> src, size_t len, size_t* nwritten) TA_REQ(get_lock());
+    zx_status_t WriteSelfLocked(const zx_iovec_t* iov, size_t iov_count, size_t len,
+                                size_t* nwritten) TA_REQ(get_lock());
     zx_status_t WriteControlSelfLocked(user_in_ptr<const void> src, size_t len) TA_REQ(get_lock());
     zx_status_t UserSignalSelfLocked(uint32_t clear_mask, uint32_t set_mask) TA_REQ(get_lock());
     zx_status_t ShutdownOtherLocked(uint32_t how) TA_REQ(get_lock());
@@ -10,7 +10,9 @@
 
 #include <fbl/canary.h>
 #include <fbl/intrusive_double_list.h>
+#include <list.h>
 
+class Dispatcher;
 class Handle;
 
 // Observer base class for state maintained by StateTracker.
@@ -36,6 +38,14 @@ public:
     static constexpr Flags kNeedRemoval = 1;
     static constexpr Flags kHandled = 2;
 
+    // Return value of interest() for observers that need to see every change.
+    static constexpr zx_signals_t kAllChanges = ~0u;
+
+    // The signals this observer is waiting for. OnStateChange() is only called for a new state
+    // that asserts at least one of them, unless this is kAllChanges. It is read once, when the
+    // observer is added.
+    virtual zx_signals_t interest() const { return kAllChanges; }
+
     // Called when this object is added to a StateTracker, to give it the initial state.
     // Note that |cinfo| might be null.
     // May return flags: kNeedRemoval
@@ -76,9 +86,18 @@ private:
 
     friend struct StateObserverListTraits;
     fbl::DoublyLinkedListNodeState<StateObserver*> state_observer_list_node_state_;
+
+    // A Dispatcher groups its observers by interest(); see Dispatcher::observer_groups_. These
+    // are guarded by the dispatcher's lock.
+    friend class Dispatcher;
+    zx_signals_t interest_ = 0u;
+    // Links the first observer of each group into the dispatcher's list of groups.
+    list_node group_head_node_ = LIST_INITIAL_CLEARED_VALUE;
+    // Links the observers of a group together, starting at the first.
+    list_node group_node_ = LIST_INITIAL_CLEARED_VALUE;
 };
 
-// For use by StateTracker to maintain a list of StateObservers. (We don't use the default traits so
+// For use by Dispatcher to maintain a list of StateObservers. (We don't use the default traits so
 // that implementations of StateObserver can themselves use the default traits if they need to be on
 // a different list.)
 struct StateObserverListTraits {
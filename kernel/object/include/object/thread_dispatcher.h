@@ -148,12 +148,27 @@ public:
     // Fetch per thread stats for userspace.
     zx_status_t GetStatsForUserspace(zx_info_thread_stats_t* info);
 
+    // Fetch the thread's scheduler stats, for ZX_INFO_TASK_SCHED_STATS.
+    void GetSchedStats(zx_info_task_sched_stats_t* info);
+
     // For debugger usage.
     zx_status_t ReadState(zx_thread_state_topic_t state_kind, void* buffer, size_t buffer_len);
     zx_status_t WriteState(zx_thread_state_topic_t state_kind, const void* buffer,
                            size_t buffer_len);
     // Profile support
     zx_status_t SetPriority(int32_t priority);
+    // Gives the thread a deadline reservation, or drops it when |period| is zero.
+    zx_status_t SetDeadline(zx_duration_t capacity, zx_duration_t relative_deadline,
+                            zx_duration_t period);
+
+    // Priority inheritance for priority-inheriting futexes owned by this
+    // thread. Every FutexPiBlock() must be balanced by a FutexPiUnblock().
+    void FutexPiBlock(int priority) { thread_futex_pi_block(&thread_, priority); }
+    void FutexPiUnblock() { thread_futex_pi_unblock(&thread_); }
+
+    // How late the timeouts of this thread's waits may fire.
+    zx_duration_t GetTimerSlack() const { return thread_.timer_slack; }
+    void SetTimerSlack(zx_duration_t slack) { thread_set_timer_slack(&thread_, slack); }
 
     // For ChannelDispatcher use.
     ChannelDispatcher::MessageWaiter* GetMessageWaiter() { return &channel_waiter_; }
@@ -267,3 +282,7 @@ private:
     // start and will send a process start exception.
     bool is_initial_thread_ = false;
 };
+
+// Adds |stats| into |total|, as when summing the threads of a process or job.
+void AccumulateSchedStats(zx_info_task_sched_stats_t* total,
+                          const zx_info_task_sched_stats_t& stats);
@@ -39,6 +39,10 @@ public:
                      uint64_t offset);
     zx_status_t Write(user_in_ptr<const void> user_data, size_t length,
                       uint64_t offset);
+    // Copies |length| bytes at |src_offset| in |src| to |offset| in this vmo. With
+    // ZX_VMO_TRANSFER_MOVE, whole pages are moved over instead where both objects allow.
+    zx_status_t TransferData(uint32_t options, uint64_t offset, uint64_t length,
+                             VmObject* src, uint64_t src_offset);
     zx_status_t SetSize(uint64_t);
     zx_status_t GetSize(uint64_t* size);
     zx_status_t RangeOp(uint32_t op, uint64_t offset, uint64_t size, user_inout_ptr<void> buffer,
@@ -50,6 +54,7 @@ public:
     zx_status_t SetMappingCachePolicy(uint32_t cache_policy);
 
     zx_info_vmo_t GetVmoInfo();
+    zx_info_vmo_working_set_t GetWorkingSetInfo();
 
     const fbl::RefPtr<VmObject>& vmo() const { return vmo_; }
 
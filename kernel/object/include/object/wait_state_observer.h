@@ -37,6 +37,7 @@ private:
     WaitStateObserver& operator=(const WaitStateObserver&) = delete;
 
     // StateObserver implementation:
+    zx_signals_t interest() const final { return watched_signals_; }
     Flags OnInitialize(zx_signals_t initial_state, const StateObserver::CountInfo* cinfo) final;
     Flags OnStateChange(zx_signals_t new_state) final;
     Flags OnCancel(const Handle* handle) final;
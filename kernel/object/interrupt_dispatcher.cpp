@@ -5,12 +5,17 @@
 // https://opensource.org/licenses/MIT
 
 #include <dev/interrupt.h>
+#include <lib/counters.h>
 #include <object/interrupt_dispatcher.h>
 #include <object/port_dispatcher.h>
 #include <object/process_dispatcher.h>
 #include <platform.h>
 #include <zircon/syscalls/port.h>
 
+// Interrupts taken while the packet of the last one was waiting to be acked.
+// These are what ZX_INTERRUPT_BIND_POLL saves.
+KCOUNTER(interrupt_pending_count, "kernel.interrupt.pending");
+
 InterruptDispatcher::InterruptDispatcher()
     : timestamp_(0), state_(InterruptState::IDLE) {
     event_init(&event_, false, EVENT_FLAG_AUTOUNSIGNAL);
@@ -112,6 +117,7 @@ void InterruptDispatcher::InterruptHandler() {
         timestamp_ = current_time();
     }
     if (state_ == InterruptState::NEEDACK && port_dispatcher_) {
+        kcounter_add(interrupt_pending_count, 1);
         return;
     }
     if (port_dispatcher_) {
@@ -126,6 +132,18 @@ void InterruptDispatcher::InterruptHandler() {
     }
 }
 
+zx_status_t InterruptDispatcher::SetAffinity(cpu_num_t cpu) {
+    {
+        Guard<SpinLock, IrqSave> guard{&spinlock_};
+        if (state_ == InterruptState::DESTROYED) {
+            return ZX_ERR_CANCELED;
+        }
+    }
+    // Steering may need to take locks of its own, such as those of a PCI
+    // device, so it can't be done under spinlock_.
+    return SetInterruptAffinity(cpu);
+}
+
 zx_status_t InterruptDispatcher::Destroy() {
     // Using AutoReschedDisable is necessary for correctness to prevent
     // context-switching to the woken thread while holding spinlock_.
@@ -157,7 +175,8 @@ zx_status_t InterruptDispatcher::Destroy() {
 }
 
 zx_status_t InterruptDispatcher::Bind(fbl::RefPtr<PortDispatcher> port_dispatcher,
-                                      fbl::RefPtr<InterruptDispatcher> interrupt, uint64_t key) {
+                                      fbl::RefPtr<InterruptDispatcher> interrupt, uint64_t key,
+                                      uint32_t options) {
     Guard<SpinLock, IrqSave> guard{&spinlock_};
     if (state_ == InterruptState::DESTROYED) {
         return ZX_ERR_CANCELED;
@@ -169,6 +188,12 @@ zx_status_t InterruptDispatcher::Bind(fbl::RefPtr<PortDispatcher> port_dispatche
         return ZX_ERR_BAD_STATE;
     }
 
+    // Interrupts which are unmasked before waiting already mask themselves
+    // until they are acked.
+    if ((options & ZX_INTERRUPT_BIND_POLL) && !(flags_ & INTERRUPT_UNMASK_PREWAIT)) {
+        flags_ |= INTERRUPT_UNMASK_PREWAIT | INTERRUPT_MASK_POSTWAIT;
+    }
+
     port_dispatcher_ = fbl::move(port_dispatcher);
     port_packet_.key = key;
     return ZX_OK;
@@ -115,6 +115,10 @@ void InterruptEventDispatcher::UnmaskInterrupt() {
     unmask_interrupt(vector_);
 }
 
+zx_status_t InterruptEventDispatcher::SetInterruptAffinity(cpu_num_t cpu) {
+    return set_interrupt_affinity(vector_, cpu);
+}
+
 zx_status_t InterruptEventDispatcher::RegisterInterruptHandler() {
     return register_int_handler(vector_, IrqHandler, this);
 }
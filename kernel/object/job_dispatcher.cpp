@@ -228,12 +228,16 @@ bool JobDispatcher::AddChildJob(const fbl::RefPtr<JobDispatcher>& job) {
 void JobDispatcher::RemoveChildProcess(ProcessDispatcher* process) {
     canary_.Assert();
 
+    zx_info_task_sched_stats_t stats;
+    process->GetSchedStats(&stats);
+
     Guard<fbl::Mutex> guard{get_lock()};
     // The process dispatcher can call us in its destructor, Kill(),
     // or RemoveThread().
     if (!ProcessDispatcher::JobListTraitsRaw::node_state(*process).InContainer())
         return;
     procs_.erase(*process);
+    AccumulateSchedStats(&retired_sched_stats_, stats);
     --process_count_;
     UpdateSignalsDecrementLocked();
 }
@@ -241,10 +245,14 @@ void JobDispatcher::RemoveChildProcess(ProcessDispatcher* process) {
 void JobDispatcher::RemoveChildJob(JobDispatcher* job) {
     canary_.Assert();
 
+    zx_info_task_sched_stats_t stats;
+    job->GetSchedStats(&stats);
+
     Guard<fbl::Mutex> guard{get_lock()};
     if (!JobDispatcher::ListTraitsRaw::node_state(*job).InContainer())
         return;
     jobs_.erase(*job);
+    AccumulateSchedStats(&retired_sched_stats_, stats);
     --job_count_;
     UpdateSignalsDecrementLocked();
 }
@@ -364,6 +372,45 @@ zx_status_t JobDispatcher::SetPolicy(
     return ZX_OK;
 }
 
+void JobDispatcher::GetSchedStats(zx_info_task_sched_stats_t* stats) {
+    canary_.Assert();
+
+    // Live descendants report their own threads; the ones that are gone
+    // have already been folded into the retired stats of their parent.
+    class StatsEnumerator final : public JobEnumerator {
+    public:
+        explicit StatsEnumerator(zx_info_task_sched_stats_t* stats) : stats_(stats) {}
+
+        bool OnJob(JobDispatcher* job) override {
+            zx_info_task_sched_stats_t retired;
+            {
+                Guard<fbl::Mutex> guard{job->get_lock()};
+                retired = job->retired_sched_stats_;
+            }
+            AccumulateSchedStats(stats_, retired);
+            return true;
+        }
+
+        bool OnProcess(ProcessDispatcher* proc) override {
+            zx_info_task_sched_stats_t proc_stats;
+            proc->GetSchedStats(&proc_stats);
+            AccumulateSchedStats(stats_, proc_stats);
+            return true;
+        }
+
+    private:
+        zx_info_task_sched_stats_t* stats_;
+    };
+
+    {
+        Guard<fbl::Mutex> guard{get_lock()};
+        *stats = retired_sched_stats_;
+    }
+
+    StatsEnumerator se(stats);
+    EnumerateChildren(&se, /* recurse */ true);
+}
+
 bool JobDispatcher::EnumerateChildren(JobEnumerator* je, bool recurse) {
     canary_.Assert();
 
@@ -65,7 +65,8 @@ zx_status_t LogDispatcher::Read(uint32_t flags, void* ptr, size_t len, size_t* a
 
     Guard<fbl::Mutex> guard{get_lock()};
 
-    zx_status_t status = dlog_read(&reader_, 0, ptr, len, actual);
+    zx_status_t status = dlog_read(&reader_, (flags & ZX_LOG_READ_BATCH) ? DLOG_READ_BATCH : 0,
+                                   ptr, len, actual);
     if (status == ZX_ERR_SHOULD_WAIT) {
         UpdateStateLocked(ZX_CHANNEL_READABLE, 0);
     }
@@ -10,34 +10,89 @@
 
 #include <fbl/algorithm.h>
 #include <fbl/alloc_checker.h>
+#include <vm/page.h>
+#include <vm/physmap.h>
+#include <vm/pmm.h>
+#include <zxcpp/new.h>
 
 #define LOCAL_TRACE 0
 
 constexpr size_t MBufChain::MBuf::kHeaderSize;
 constexpr size_t MBufChain::MBuf::kMallocSize;
 constexpr size_t MBufChain::MBuf::kPayloadSize;
-constexpr size_t MBufChain::kSizeMax;
+constexpr size_t MBufChain::MBuf::kPagePayloadSize;
+constexpr size_t MBufChain::kDefaultSizeMax;
+constexpr size_t MBufChain::kMaxSizeLimit;
+constexpr size_t MBufChain::kMaxFreePages;
+
+namespace {
+
+// Walks the user buffers described by an iovec array as if they were a
+// single contiguous range, skipping any empty buffers.
+class IovecCursor {
+public:
+    IovecCursor(const zx_iovec_t* iov, size_t iov_count)
+        : iov_(iov), end_(iov + iov_count) {
+        SkipEmpty();
+    }
+
+    // Returns the number of bytes left in the current buffer, or 0 once all
+    // buffers have been consumed.
+    size_t avail() const { return iov_ == end_ ? 0 : iov_->capacity - off_; }
+
+    user_in_ptr<const void> in() const {
+        return make_user_in_ptr(static_cast<const void*>(iov_->buffer)).byte_offset(off_);
+    }
+
+    user_out_ptr<void> out() const {
+        return make_user_out_ptr(iov_->buffer).byte_offset(off_);
+    }
+
+    // Consumes |len| bytes, which must not exceed avail().
+    void Advance(size_t len) {
+        off_ += len;
+        if (off_ == iov_->capacity) {
+            iov_++;
+            off_ = 0;
+            SkipEmpty();
+        }
+    }
+
+private:
+    void SkipEmpty() {
+        while (iov_ != end_ && iov_->capacity == 0)
+            iov_++;
+    }
+
+    const zx_iovec_t* iov_;
+    const zx_iovec_t* const end_;
+    size_t off_ = 0;
+};
+
+} // namespace
 
 size_t MBufChain::MBuf::rem() const {
-    return kPayloadSize - (off_ + len_);
+    return cap_ - (off_ + len_);
 }
 
 MBufChain::~MBufChain() {
     while (!tail_.is_empty())
-        delete tail_.pop_front();
+        DestroyMBuf(tail_.pop_front());
     while (!freelist_.is_empty())
-        delete freelist_.pop_front();
+        DestroyMBuf(freelist_.pop_front());
+    while (!page_freelist_.is_empty())
+        DestroyMBuf(page_freelist_.pop_front());
 }
 
 bool MBufChain::is_full() const {
-    return size_ >= kSizeMax;
+    return size_ >= max_size_;
 }
 
 bool MBufChain::is_empty() const {
     return size_ == 0;
 }
 
-size_t MBufChain::Read(user_out_ptr<void> dst, size_t len, bool datagram) {
+size_t MBufChain::Read(const zx_iovec_t* iov, size_t iov_count, size_t len, bool datagram) {
     if (size_ == 0) {
         return 0;
     }
@@ -45,18 +100,21 @@ size_t MBufChain::Read(user_out_ptr<void> dst, size_t len, bool datagram) {
     if (datagram && len > tail_.front().pkt_len_)
         len = tail_.front().pkt_len_;
 
+    IovecCursor dst(iov, iov_count);
     size_t pos = 0;
     while (pos < len && !tail_.is_empty()) {
         MBuf& cur = tail_.front();
-        char* src = cur.data_ + cur.off_;
-        size_t copy_len = MIN(cur.len_, len - pos);
-        if (dst.byte_offset(pos).copy_array_to_user(src, copy_len) != ZX_OK)
+        char* src = cur.data() + cur.off_;
+        size_t copy_len = MIN(MIN(cur.len_, len - pos), dst.avail());
+        if (dst.out().copy_array_to_user(src, copy_len) != ZX_OK)
             return pos;
+        dst.Advance(copy_len);
         pos += copy_len;
         cur.off_ += static_cast<uint32_t>(copy_len);
         cur.len_ -= static_cast<uint32_t>(copy_len);
         size_ -= copy_len;
-        if (cur.len_ == 0 || datagram) {
+        // A datagram's unread tail is discarded once |len| bytes are read.
+        if (cur.len_ == 0 || (datagram && pos == len)) {
             size_ -= cur.len_;
             if (head_ == &cur)
                 head_ = nullptr;
@@ -76,18 +134,19 @@ size_t MBufChain::Read(user_out_ptr<void> dst, size_t len, bool datagram) {
     return pos;
 }
 
-zx_status_t MBufChain::WriteDatagram(user_in_ptr<const void> src, size_t len,
+zx_status_t MBufChain::WriteDatagram(const zx_iovec_t* iov, size_t iov_count, size_t len,
                                      size_t* written) {
     if (len == 0) {
         return ZX_ERR_INVALID_ARGS;
     }
-    if (len > kSizeMax)
+    if (len > max_size_)
         return ZX_ERR_OUT_OF_RANGE;
-    if (len + size_ > kSizeMax)
+    if (len + size_ > max_size_)
         return ZX_ERR_SHOULD_WAIT;
 
+    const size_t payload_size = page_backed_ ? MBuf::kPagePayloadSize : MBuf::kPayloadSize;
     fbl::SinglyLinkedList<MBuf*> bufs;
-    for (size_t need = 1 + ((len - 1) / MBuf::kPayloadSize); need != 0; need--) {
+    for (size_t need = 1 + ((len - 1) / payload_size); need != 0; need--) {
         auto buf = AllocMBuf();
         if (buf == nullptr) {
             while (!bufs.is_empty())
@@ -97,16 +156,22 @@ zx_status_t MBufChain::WriteDatagram(user_in_ptr<const void> src, size_t len,
         bufs.push_front(buf);
     }
 
+    IovecCursor src(iov, iov_count);
     size_t pos = 0;
     for (auto& buf : bufs) {
-        size_t copy_len = fbl::min(MBuf::kPayloadSize, len - pos);
-        if (src.byte_offset(pos).copy_array_from_user(buf.data_, copy_len) != ZX_OK) {
-            while (!bufs.is_empty())
-                FreeMBuf(bufs.pop_front());
-            return ZX_ERR_INVALID_ARGS; // Bad user buffer.
+        size_t buf_len = fbl::min(static_cast<size_t>(buf.cap_), len - pos);
+        while (buf.len_ < buf_len) {
+            size_t copy_len = fbl::min(buf_len - buf.len_, src.avail());
+            if (copy_len == 0 ||
+                src.in().copy_array_from_user(buf.data() + buf.len_, copy_len) != ZX_OK) {
+                while (!bufs.is_empty())
+                    FreeMBuf(bufs.pop_front());
+                return ZX_ERR_INVALID_ARGS; // Bad user buffer.
+            }
+            src.Advance(copy_len);
+            buf.len_ += static_cast<uint32_t>(copy_len);
         }
-        pos += copy_len;
-        buf.len_ += static_cast<uint32_t>(copy_len);
+        pos += buf_len;
     }
 
     bufs.front().pkt_len_ = static_cast<uint32_t>(len);
@@ -127,7 +192,7 @@ zx_status_t MBufChain::WriteDatagram(user_in_ptr<const void> src, size_t len,
     return ZX_OK;
 }
 
-zx_status_t MBufChain::WriteStream(user_in_ptr<const void> src, size_t len, size_t* written) {
+zx_status_t MBufChain::WriteStream(const zx_iovec_t* iov, size_t iov_count, size_t* written) {
     if (head_ == nullptr) {
         head_ = AllocMBuf();
         if (head_ == nullptr)
@@ -135,8 +200,9 @@ zx_status_t MBufChain::WriteStream(user_in_ptr<const void> src, size_t len, size
         tail_.push_front(head_);
     }
 
+    IovecCursor src(iov, iov_count);
     size_t pos = 0;
-    while (pos < len) {
+    while (src.avail() > 0) {
         if (head_->rem() == 0) {
             auto next = AllocMBuf();
             if (next == nullptr)
@@ -144,15 +210,16 @@ zx_status_t MBufChain::WriteStream(user_in_ptr<const void> src, size_t len, size
             tail_.insert_after(tail_.make_iterator(*head_), next);
             head_ = next;
         }
-        void* dst = head_->data_ + head_->off_ + head_->len_;
-        size_t copy_len = fbl::min(head_->rem(), len - pos);
-        if (size_ + copy_len > kSizeMax) {
-            copy_len = kSizeMax - size_;
+        void* dst = head_->data() + head_->off_ + head_->len_;
+        size_t copy_len = fbl::min(head_->rem(), src.avail());
+        if (size_ + copy_len > max_size_) {
+            copy_len = max_size_ - size_;
             if (copy_len == 0)
                 break;
         }
-        if (src.byte_offset(pos).copy_array_from_user(dst, copy_len) != ZX_OK)
+        if (src.in().copy_array_from_user(dst, copy_len) != ZX_OK)
             break;
+        src.Advance(copy_len);
         pos += copy_len;
         head_->len_ += static_cast<uint32_t>(copy_len);
         size_ += copy_len;
@@ -165,7 +232,31 @@ zx_status_t MBufChain::WriteStream(user_in_ptr<const void> src, size_t len, size
     return ZX_OK;
 }
 
+zx_status_t MBufChain::SetMaxSize(size_t max_size, bool page_backed) {
+    if (max_size == 0 || max_size > kMaxSizeLimit)
+        return ZX_ERR_OUT_OF_RANGE;
+    if (max_size < size_)
+        return ZX_ERR_BAD_STATE;
+
+    max_size_ = max_size;
+    if (page_backed != page_backed_) {
+        // Free buffers of the old kind will not be handed out again.
+        auto& stale = page_backed ? freelist_ : page_freelist_;
+        while (!stale.is_empty())
+            DestroyMBuf(stale.pop_front());
+        page_freelist_count_ = 0u;
+        page_backed_ = page_backed;
+    }
+    return ZX_OK;
+}
+
 MBufChain::MBuf* MBufChain::AllocMBuf() {
+    if (page_backed_) {
+        if (page_freelist_.is_empty())
+            return AllocPageMBuf();
+        page_freelist_count_--;
+        return page_freelist_.pop_front();
+    }
     if (freelist_.is_empty()) {
         fbl::AllocChecker ac;
         MBuf* buf = new (&ac) MBuf();
@@ -177,5 +268,41 @@ MBufChain::MBuf* MBufChain::AllocMBuf() {
 void MBufChain::FreeMBuf(MBuf* buf) {
     buf->off_ = 0u;
     buf->len_ = 0u;
-    freelist_.push_front(buf);
+    buf->pkt_len_ = 0u;
+    if (!buf->is_page()) {
+        if (page_backed_) {
+            DestroyMBuf(buf);
+        } else {
+            freelist_.push_front(buf);
+        }
+    } else if (page_backed_ && page_freelist_count_ < kMaxFreePages) {
+        page_freelist_.push_front(buf);
+        page_freelist_count_++;
+    } else {
+        DestroyMBuf(buf);
+    }
+}
+
+// static
+MBufChain::MBuf* MBufChain::AllocPageMBuf() {
+    vm_page_t* page;
+    paddr_t pa;
+    if (pmm_alloc_page(0, &page, &pa) != ZX_OK)
+        return nullptr;
+    page->state = VM_PAGE_STATE_IPC;
+
+    MBuf* buf = new (paddr_to_physmap(pa)) MBuf;
+    buf->cap_ = static_cast<uint32_t>(MBuf::kPagePayloadSize);
+    return buf;
+}
+
+// static
+void MBufChain::DestroyMBuf(MBuf* buf) {
+    if (!buf->is_page()) {
+        delete buf;
+        return;
+    }
+    vm_page_t* page = paddr_to_vm_page(physmap_to_paddr(buf));
+    buf->~MBuf();
+    pmm_free_page(page);
 }
@@ -0,0 +1,50 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <object/object_cache.h>
+
+#include <fbl/algorithm.h>
+#include <object/channel_dispatcher.h>
+#include <object/event_dispatcher.h>
+#include <string.h>
+
+namespace {
+
+template <typename T>
+void FillCacheInfo(const char* name, zx_info_kmem_object_cache_t* info) {
+    using Cache = ObjectCache<T>;
+
+    *info = {};
+    strlcpy(info->name, name, sizeof(info->name));
+    info->object_size = sizeof(T);
+    // These are read without the cache lock, so they may be slightly out of
+    // sync with each other.
+    size_t live = Cache::obj_count();
+    size_t capacity = Cache::slab_count() * Cache::AllocsPerSlab;
+    info->live_objects = live;
+    info->free_objects = capacity > live ? capacity - live : 0;
+    info->slab_count = Cache::slab_count();
+    info->max_slab_count = Cache::max_slabs();
+    info->slab_size = kObjectCacheSlabSize;
+}
+
+struct CacheEntry {
+    const char* name;
+    void (*fill)(const char* name, zx_info_kmem_object_cache_t* info);
+};
+
+const CacheEntry kCaches[] = {
+    {"channel", FillCacheInfo<ChannelDispatcher>},
+    {"event", FillCacheInfo<EventDispatcher>},
+};
+
+} // namespace
+
+size_t GetObjectCacheInfo(zx_info_kmem_object_cache_t* info, size_t count) {
+    for (size_t i = 0; i < count && i < fbl::count_of(kCaches); i++)
+        kCaches[i].fill(kCaches[i].name, &info[i]);
+    return fbl::count_of(kCaches);
+}
@@ -0,0 +1,156 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <object/pager_dispatcher.h>
+
+#include <err.h>
+
+#include <fbl/alloc_checker.h>
+#include <lib/counters.h>
+#include <vm/vm_object_paged.h>
+#include <zircon/syscalls/port.h>
+
+KCOUNTER(pager_request_count, "kernel.pager.request");
+KCOUNTER(pager_supply_count, "kernel.pager.supply");
+
+PagerSource::PagerSource(fbl::RefPtr<PagerDispatcher> pager, fbl::RefPtr<PortDispatcher> port,
+                         uint64_t key)
+    : pager_(fbl::move(pager)), port_(fbl::move(port)), key_(key) {}
+
+PagerSource::~PagerSource() {}
+
+zx_status_t PagerSource::SendRequest(uint64_t offset, uint64_t len) {
+    zx_status_t status = QueuePacket(ZX_PAGER_VMO_READ, offset, len);
+    // a full port means the pager is not keeping up; don't let the caller
+    // mistake that for a request it can wait on
+    if (status == ZX_ERR_SHOULD_WAIT) {
+        return ZX_ERR_NO_RESOURCES;
+    }
+    if (status == ZX_OK) {
+        kcounter_add(pager_request_count, 1);
+    }
+    return status;
+}
+
+void PagerSource::OnDetach() {
+    // Let the pager drop whatever it keeps for this VMO. Nobody is waiting for
+    // this packet, so it is fine if it can't be queued.
+    QueuePacket(ZX_PAGER_VMO_COMPLETE, 0, 0);
+
+    pager_->RemoveSource(this);
+}
+
+zx_status_t PagerSource::QueuePacket(uint16_t command, uint64_t offset, uint64_t len) {
+    PortPacket* port_packet = PortDispatcher::DefaultPortAllocator()->Alloc();
+    if (!port_packet) {
+        return ZX_ERR_NO_MEMORY;
+    }
+
+    port_packet->packet.key = key_;
+    port_packet->packet.type = ZX_PKT_TYPE_PAGE_REQUEST;
+    port_packet->packet.status = ZX_OK;
+    port_packet->packet.page_request.command = command;
+    port_packet->packet.page_request.offset = offset;
+    port_packet->packet.page_request.length = len;
+
+    zx_status_t status = port_->Queue(port_packet, 0u, 0u);
+    if (status != ZX_OK) {
+        port_packet->Free();
+    }
+    return status;
+}
+
+zx_status_t PagerDispatcher::Create(fbl::RefPtr<Dispatcher>* dispatcher, zx_rights_t* rights) {
+    fbl::AllocChecker ac;
+    auto disp = new (&ac) PagerDispatcher();
+    if (!ac.check())
+        return ZX_ERR_NO_MEMORY;
+
+    *rights = default_rights();
+    *dispatcher = fbl::AdoptRef<Dispatcher>(disp);
+    return ZX_OK;
+}
+
+PagerDispatcher::PagerDispatcher() {}
+
+PagerDispatcher::~PagerDispatcher() {
+    DEBUG_ASSERT(srcs_.is_empty());
+}
+
+zx_status_t PagerDispatcher::CreateVmo(fbl::RefPtr<PortDispatcher> port, uint64_t key,
+                                       uint64_t size, fbl::RefPtr<VmObject>* vmo_out) {
+    canary_.Assert();
+
+    fbl::AllocChecker ac;
+    auto src = fbl::AdoptRef(new (&ac) PagerSource(fbl::WrapRefPtr(this), fbl::move(port), key));
+    if (!ac.check())
+        return ZX_ERR_NO_MEMORY;
+
+    fbl::RefPtr<VmObject> vmo;
+    zx_status_t status = VmObjectPaged::CreateExternal(src, size, &vmo);
+    if (status != ZX_OK)
+        return status;
+
+    {
+        Guard<fbl::Mutex> guard{get_lock()};
+        if (!closed_) {
+            srcs_.push_back(fbl::move(src));
+            *vmo_out = fbl::move(vmo);
+            return ZX_OK;
+        }
+    }
+
+    // the last handle to us went away meanwhile; dropping the vmo detaches
+    // its source, which takes our lock
+    return ZX_ERR_BAD_STATE;
+}
+
+zx_status_t PagerDispatcher::SupplyPages(VmObject* vmo, uint64_t offset, uint64_t length,
+                                         VmObject* aux_vmo, uint64_t aux_offset) {
+    canary_.Assert();
+
+    // PagerSource is the only kind of page source user mode can get at
+    auto src = static_cast<PagerSource*>(vmo->page_source());
+    if (!src || src->pager() != this)
+        return ZX_ERR_INVALID_ARGS;
+
+    // taking pages out of a vmo that waits on a pager could end up waiting
+    // on the very thread doing the supplying
+    if (aux_vmo->is_pager_backed())
+        return ZX_ERR_INVALID_ARGS;
+
+    list_node pages;
+    list_initialize(&pages);
+    zx_status_t status = aux_vmo->TakePages(aux_offset, length, &pages);
+    if (status != ZX_OK)
+        return status;
+
+    status = vmo->SupplyPages(offset, length, &pages);
+    if (status == ZX_OK)
+        kcounter_add(pager_supply_count, length / PAGE_SIZE);
+    return status;
+}
+
+void PagerDispatcher::RemoveSource(PagerSource* src) {
+    Guard<fbl::Mutex> guard{get_lock()};
+    if (src->InContainer()) {
+        srcs_.erase(*src);
+    }
+}
+
+void PagerDispatcher::on_zero_handles() {
+    canary_.Assert();
+
+    Guard<fbl::Mutex> guard{get_lock()};
+    closed_ = true;
+
+    // Without a pager nobody will supply the missing pages, so fail everyone
+    // waiting for them. Detaching a source removes it from |srcs_|, hence
+    // it is taken off the list first and detached without the lock.
+    while (auto src = srcs_.pop_front()) {
+        guard.CallUnlocked([&src]() { src->Detach(); });
+    }
+}
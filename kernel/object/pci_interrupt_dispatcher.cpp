@@ -78,6 +78,10 @@ void PciInterruptDispatcher::UnmaskInterrupt() {
         device_->UnmaskIrq(vector_);
 }
 
+zx_status_t PciInterruptDispatcher::SetInterruptAffinity(cpu_num_t cpu) {
+    return device_->SetIrqAffinity(vector_, cpu);
+}
+
 zx_status_t PciInterruptDispatcher::RegisterInterruptHandler() {
     return device_->RegisterIrqHandler(vector_, IrqThunk, this);
 }
@@ -77,7 +77,7 @@ void ArenaPortAllocator::Free(PortPacket* port_packet) {
 }
 
 PortPacket::PortPacket(const void* handle, PortAllocator* allocator)
-    : packet{}, handle(handle), observer(nullptr), allocator(allocator) {
+    : packet{}, handle(handle), observer(nullptr), allocator(allocator), level_state(0u) {
     // Note that packet is initialized to zeros.
     if (handle) {
         // Currently |handle| is only valid if the packets are not ephemeral
@@ -86,14 +86,16 @@ PortPacket::PortPacket(const void* handle, PortAllocator* allocator)
     }
 }
 
-PortObserver::PortObserver(uint32_t type, const Handle* handle, fbl::RefPtr<PortDispatcher> port,
-                           uint64_t key, zx_signals_t signals)
+PortObserver::PortObserver(uint32_t type, bool level, const Handle* handle,
+                           fbl::RefPtr<PortDispatcher> port, uint64_t key, zx_signals_t signals)
     : type_(type),
       trigger_(signals),
       packet_(handle, nullptr),
       port_(fbl::move(port)) {
 
     DEBUG_ASSERT(handle != nullptr);
+    DEBUG_ASSERT(!level || type == ZX_PKT_TYPE_SIGNAL_REP);
+    packet_.is_level = level;
 
     auto& packet = packet_.packet;
     packet.status = ZX_OK;
@@ -144,6 +146,11 @@ void PortObserver::OnRemoved() {
 
 StateObserver::Flags PortObserver::MaybeQueue(zx_signals_t new_state, uint64_t count) {
     // Always called with the object state lock being held.
+    // The port reads this when it dequeues the packet, so it must be
+    // updated before queuing.
+    if (packet_.is_level)
+        packet_.level_state.store(new_state, fbl::memory_order_release);
+
     if ((trigger_ & new_state) == 0u)
         return 0;
 
@@ -195,22 +202,37 @@ PortDispatcher::~PortDispatcher() {
 void PortDispatcher::on_zero_handles() {
     canary_.Assert();
 
-    Guard<fbl::Mutex> guard{get_lock()};
-    zero_handles_ = true;
+    {
+        Guard<SpinLock, IrqSave> guard{&spinlock_};
+        zero_handles_ = true;
+    }
 
-    // Unlink and unbind exception ports.
-    while (!eports_.is_empty()) {
-        auto eport = eports_.pop_back();
+    {
+        Guard<fbl::Mutex> guard{get_lock()};
 
-        // Tell the eport to unbind itself, then drop our ref to it. Called
-        // unlocked because the eport may call our ::UnlinkExceptionPort.
-        guard.CallUnlocked([&eport]() { eport->OnPortZeroHandles(); });
+        // Unlink and unbind exception ports.
+        while (!eports_.is_empty()) {
+            auto eport = eports_.pop_back();
+
+            // Tell the eport to unbind itself, then drop our ref to it. Called
+            // unlocked because the eport may call our ::UnlinkExceptionPort.
+            guard.CallUnlocked([&eport]() { eport->OnPortZeroHandles(); });
+        }
     }
 
-    // Free any queued packets.
-    while (!packets_.is_empty()) {
-        FreePacket(packets_.pop_front());
-        --num_packets_;
+    // Free any queued packets. Popping them one at a time keeps the port
+    // consistent for any observer that concurrently gets reaped.
+    while (true) {
+        DetachedPacket detached;
+        {
+            Guard<SpinLock, IrqSave> guard{&spinlock_};
+            PortPacket* port_packet = packets_.pop_front();
+            if (port_packet == nullptr)
+                break;
+            --num_packets_;
+            detached = DetachPacket(port_packet);
+        }
+        ReleasePacket(fbl::move(detached));
     }
 }
 
@@ -255,7 +277,7 @@ zx_status_t PortDispatcher::Queue(PortPacket* port_packet, zx_signals_t observed
     canary_.Assert();
 
     AutoReschedDisable resched_disable; // Must come before the lock guard.
-    Guard<fbl::Mutex> guard{get_lock()};
+    Guard<SpinLock, IrqSave> guard{&spinlock_};
     if (zero_handles_)
         return ZX_ERR_BAD_STATE;
 
@@ -284,31 +306,71 @@ zx_status_t PortDispatcher::Queue(PortPacket* port_packet, zx_signals_t observed
 }
 
 zx_status_t PortDispatcher::Dequeue(zx_time_t deadline, zx_port_packet_t* out_packet) {
+    size_t actual;
+    return DequeueMany(deadline, out_packet, 1u, &actual);
+}
+
+zx_status_t PortDispatcher::DequeueMany(zx_time_t deadline, zx_port_packet_t* out_packets,
+                                        size_t count, size_t* actual) {
     canary_.Assert();
+    DEBUG_ASSERT(count > 0u && count <= kMaxDequeueCount);
 
     while (true) {
-        if (options_ == ZX_PORT_BIND_TO_INTERRUPT) {
+        DetachedPacket detached[kMaxDequeueCount];
+        size_t dequeued = 0u;
+        {
             Guard<SpinLock, IrqSave> guard{&spinlock_};
-            PortInterruptPacket* port_interrupt_packet = interrupt_packets_.pop_front();
-            if (port_interrupt_packet != nullptr) {
-                *out_packet = {};
-                out_packet->key = port_interrupt_packet->key;
-                out_packet->type = ZX_PKT_TYPE_INTERRUPT;
-                out_packet->status = ZX_OK;
-                out_packet->interrupt.timestamp = port_interrupt_packet->timestamp;
-                return ZX_OK;
+            if (options_ == ZX_PORT_BIND_TO_INTERRUPT) {
+                while (dequeued < count) {
+                    PortInterruptPacket* port_interrupt_packet = interrupt_packets_.pop_front();
+                    if (port_interrupt_packet == nullptr)
+                        break;
+                    zx_port_packet_t* out_packet = &out_packets[dequeued++];
+                    *out_packet = {};
+                    out_packet->key = port_interrupt_packet->key;
+                    out_packet->type = ZX_PKT_TYPE_INTERRUPT;
+                    out_packet->status = ZX_OK;
+                    out_packet->interrupt.timestamp = port_interrupt_packet->timestamp;
+                }
             }
-        }
-        {
-            Guard<fbl::Mutex> guard{get_lock()};
-            PortPacket* port_packet = packets_.pop_front();
-            if (port_packet != nullptr) {
+
+            // Level-triggered packets that are still ready go back on the
+            // queue, but only after this batch so that each is returned at
+            // most once per call. They're requeued before the lock is
+            // dropped: a packet whose observer is still live belongs to the
+            // observer, which may be reaped as soon as the lock is released.
+            fbl::DoublyLinkedList<PortPacket*> requeue;
+            while (dequeued < count) {
+                PortPacket* port_packet = packets_.pop_front();
+                if (port_packet == nullptr)
+                    break;
                 --num_packets_;
-                *out_packet = port_packet->packet;
-                FreePacket(port_packet);
-                return ZX_OK;
+                if (port_packet->is_level && !port_packet->observer) {
+                    zx_signals_t state =
+                        port_packet->level_state.load(fbl::memory_order_acquire);
+                    if ((state & port_packet->packet.signal.trigger) == 0u)
+                        continue; // No longer ready; the next state change requeues it.
+                    port_packet->packet.signal.observed = state;
+                    out_packets[dequeued++] = port_packet->packet;
+                    requeue.push_back(port_packet);
+                    continue;
+                }
+                out_packets[dequeued] = port_packet->packet;
+                detached[dequeued] = DetachPacket(port_packet);
+                ++dequeued;
+            }
+            while (!requeue.is_empty()) {
+                packets_.push_back(requeue.pop_front());
+                ++num_packets_;
+                sema_.Post();
             }
         }
+        if (dequeued > 0u) {
+            for (size_t ix = 0; ix < dequeued; ++ix)
+                ReleasePacket(fbl::move(detached[ix]));
+            *actual = dequeued;
+            return ZX_OK;
+        }
 
         {
             ThreadDispatcher::AutoBlocked by(ThreadDispatcher::Blocked::PORT);
@@ -319,25 +381,30 @@ zx_status_t PortDispatcher::Dequeue(zx_time_t deadline, zx_port_packet_t* out_pa
     }
 }
 
-void PortDispatcher::FreePacket(PortPacket* port_packet) {
+PortDispatcher::DetachedPacket PortDispatcher::DetachPacket(PortPacket* port_packet) {
+    DetachedPacket detached;
     // We need to move the observer pointer out, as it's potentially containing us.
-    fbl::unique_ptr<const PortObserver> observer = fbl::move(port_packet->observer);
-
-    if (observer) {
-        // Deleting the observer under |get_lock()| is fine because the
-        // reference that holds to this PortDispatcher is by construction
-        // not the last one. We need to do this under |get_lock()| because
-        // another thread can call MaybeReap().
-    } else if (port_packet->is_ephemeral()) {
-        port_packet->Free();
-    }
+    // MaybeReap() only stores it while the packet is queued, so once the packet
+    // has been removed under |spinlock_| nobody else can touch it.
+    detached.observer = fbl::move(port_packet->observer);
+    if (!detached.observer && port_packet->is_ephemeral())
+        detached.ephemeral = port_packet;
+    return detached;
+}
+
+void PortDispatcher::ReleasePacket(DetachedPacket detached) {
+    // Deleting the observer is fine because the reference that holds to this
+    // PortDispatcher is by construction not the last one.
+    detached.observer.reset();
+    if (detached.ephemeral != nullptr)
+        detached.ephemeral->Free();
 }
 
 fbl::unique_ptr<PortObserver> PortDispatcher::MaybeReap(fbl::unique_ptr<PortObserver> observer,
                                                         PortPacket* port_packet) {
     canary_.Assert();
 
-    Guard<fbl::Mutex> guard{get_lock()};
+    Guard<SpinLock, IrqSave> guard{&spinlock_};
     if (port_packet->InContainer()) {
         // The destruction will happen when the packet is dequeued or in CancelQueued()
         DEBUG_ASSERT(port_packet->observer == nullptr);
@@ -357,6 +424,7 @@ zx_status_t PortDispatcher::MakeObserver(uint32_t options, Handle* handle, uint6
         return ZX_ERR_NOT_SUPPORTED;
 
     uint32_t type;
+    bool level = false;
     switch (options) {
         case ZX_WAIT_ASYNC_ONCE:
             type = ZX_PKT_TYPE_SIGNAL_ONE;
@@ -364,13 +432,17 @@ zx_status_t PortDispatcher::MakeObserver(uint32_t options, Handle* handle, uint6
         case ZX_WAIT_ASYNC_REPEATING:
             type = ZX_PKT_TYPE_SIGNAL_REP;
             break;
+        case ZX_WAIT_ASYNC_LEVEL:
+            type = ZX_PKT_TYPE_SIGNAL_REP;
+            level = true;
+            break;
         default:
             return ZX_ERR_INVALID_ARGS;
     }
 
     fbl::AllocChecker ac;
-    auto observer = new (&ac) PortObserver(type, handle, fbl::RefPtr<PortDispatcher>(this), key,
-                                           signals);
+    auto observer = new (&ac) PortObserver(type, level, handle, fbl::RefPtr<PortDispatcher>(this),
+                                           key, signals);
     if (!ac.check())
         return ZX_ERR_NO_MEMORY;
 
@@ -381,8 +453,6 @@ zx_status_t PortDispatcher::MakeObserver(uint32_t options, Handle* handle, uint6
 bool PortDispatcher::CancelQueued(const void* handle, uint64_t key) {
     canary_.Assert();
 
-    Guard<fbl::Mutex> guard{get_lock()};
-
     // This loop can take a while if there are many items.
     // In practice, the number of pending signal packets is
     // approximately the number of signaled _and_ watched
@@ -405,19 +475,32 @@ bool PortDispatcher::CancelQueued(const void* handle, uint64_t key) {
 
     bool packet_removed = false;
 
-    for (auto it = packets_.begin(); it != packets_.end();) {
-        if ((it->handle == handle) && (it->key() == key)) {
-            auto to_remove = it++;
-            // Destroyed as we go around the loop.
-            fbl::unique_ptr<const PortObserver> observer =
-                fbl::move(packets_.erase(to_remove)->observer);
-            --num_packets_;
-            packet_removed = true;
-        } else {
-            ++it;
+    // Packets whose observer has already been reaped are owned by it; they
+    // are collected here and destroyed once |spinlock_| is dropped. MaybeReap()
+    // has run for all of them, so nothing else can reach them anymore.
+    fbl::DoublyLinkedList<PortPacket*> reaped;
+
+    {
+        Guard<SpinLock, IrqSave> guard{&spinlock_};
+        for (auto it = packets_.begin(); it != packets_.end();) {
+            if ((it->handle == handle) && (it->key() == key)) {
+                auto to_remove = it++;
+                PortPacket* port_packet = packets_.erase(to_remove);
+                if (port_packet->observer)
+                    reaped.push_back(port_packet);
+                --num_packets_;
+                packet_removed = true;
+            } else {
+                ++it;
+            }
         }
     }
 
+    while (!reaped.is_empty()) {
+        // Destroyed as we go around the loop.
+        fbl::unique_ptr<const PortObserver> observer = fbl::move(reaped.pop_front()->observer);
+    }
+
     return packet_removed;
 }
 
@@ -14,12 +14,15 @@
 #include <trace.h>
 
 #include <arch/defines.h>
+#include <arch/ops.h>
 
+#include <kernel/align.h>
 #include <kernel/thread.h>
 #include <vm/vm.h>
 #include <vm/vm_aspace.h>
 #include <vm/vm_object.h>
 
+#include <lib/counters.h>
 #include <lib/crypto/global_prng.h>
 #include <lib/ktrace.h>
 
@@ -54,6 +57,26 @@ static Handle* map_value_to_handle(zx_handle_t value, uint32_t mixer) {
     return Handle::FromU32(handle_id);
 }
 
+KCOUNTER(handle_lookup_unlocked, "kernel.handles.lookup.unlocked");
+KCOUNTER(handle_lookup_locked, "kernel.handles.lookup.locked");
+
+// Handle lookups on behalf of syscalls don't take |handle_table_lock_|.
+// Instead, each cpu publishes the process whose handle table it is reading
+// in its slot below, with preemption disabled for the duration of the read.
+//
+// A handle can only be torn down after it has been removed from the table
+// of the process it belongs to, under that process' |handle_table_lock_|.
+// Removal clears the handle's process_id() and then waits for every cpu
+// that may be reading the same table to be done with it. A reader that
+// still sees a handle as belonging to its process once it has published
+// itself can thus use it until it unpublishes itself, even if the handle is
+// concurrently being removed.
+struct HandleReader {
+    fbl::atomic<const ProcessDispatcher*> process;
+} __CPU_ALIGN;
+
+static HandleReader handle_readers[SMP_MAX_CPUS];
+
 zx_status_t ProcessDispatcher::Create(
     fbl::RefPtr<JobDispatcher> job, fbl::StringPiece name, uint32_t flags,
     fbl::RefPtr<Dispatcher>* dispatcher, zx_rights_t* rights,
@@ -275,13 +298,17 @@ void ProcessDispatcher::RemoveThread(ThreadDispatcher* t) {
     // ZX-880: Call RemoveChildProcess outside of |get_lock()|.
     bool became_dead = false;
 
+    DEBUG_ASSERT(t != nullptr);
+    zx_info_task_sched_stats_t stats;
+    t->GetSchedStats(&stats);
+
     {
         // we're going to check for state and possibly transition below
         Guard<fbl::Mutex> guard{get_lock()};
 
-        // remove the thread from our list
-        DEBUG_ASSERT(t != nullptr);
+        // remove the thread from our list, keeping its share of the process's stats
         thread_list_.erase(*t);
+        AccumulateSchedStats(&exited_sched_stats_, stats);
 
         // if this was the last thread, transition directly to DEAD state
         if (thread_list_.is_empty()) {
@@ -295,6 +322,19 @@ void ProcessDispatcher::RemoveThread(ThreadDispatcher* t) {
         FinishDeadTransition();
 }
 
+void ProcessDispatcher::GetSchedStats(zx_info_task_sched_stats_t* stats) {
+    canary_.Assert();
+
+    Guard<fbl::Mutex> guard{get_lock()};
+
+    *stats = exited_sched_stats_;
+    for (auto& thread : thread_list_) {
+        zx_info_task_sched_stats_t thread_stats;
+        thread.GetSchedStats(&thread_stats);
+        AccumulateSchedStats(stats, thread_stats);
+    }
+}
+
 zx_koid_t ProcessDispatcher::get_related_koid() const {
     return job_->get_koid();
 }
@@ -347,6 +387,7 @@ void ProcessDispatcher::FinishDeadTransition() {
         for (auto& handle : handles_) {
             handle.set_process_id(ZX_KOID_INVALID);
         }
+        WaitForHandleReadersLocked();
         to_clean.swap(handles_);
     }
 
@@ -431,10 +472,51 @@ HandleOwner ProcessDispatcher::RemoveHandleLocked(zx_handle_t handle_value) {
 
     handle->set_process_id(ZX_KOID_INVALID);
     handles_.erase(*handle);
+    WaitForHandleReadersLocked();
 
     return HandleOwner(handle);
 }
 
+void ProcessDispatcher::WaitForHandleReadersLocked() {
+    // Order clearing the process_id() of the removed handles before checking
+    // for readers; see GetDispatcherUnlocked().
+    fbl::atomic_thread_fence();
+    for (uint i = 0; i < arch_max_num_cpus(); i++) {
+        while (handle_readers[i].process.load(fbl::memory_order_acquire) == this)
+            arch_spinloop_pause();
+    }
+}
+
+bool ProcessDispatcher::GetDispatcherUnlocked(zx_handle_t handle_value,
+                                              fbl::RefPtr<Dispatcher>* dispatcher,
+                                              zx_rights_t* rights) {
+    bool found = false;
+
+    thread_preempt_disable();
+    HandleReader* reader = &handle_readers[arch_curr_cpu_num()];
+    reader->process.store(this);
+    // Order publishing the reader before loading the handle's process_id(),
+    // pairing with the fence in WaitForHandleReadersLocked(): either the
+    // remover sees us and waits, or we see the cleared process_id().
+    fbl::atomic_thread_fence();
+
+    // The slot may be freed and reused at any time until we have checked
+    // that the handle belongs to us, so check again that it is the one we
+    // are looking for once it can no longer go away.
+    Handle* handle = map_value_to_handle(handle_value, handle_rand_);
+    if (handle && handle->process_id() == get_koid() &&
+        map_handle_to_value(handle, handle_rand_) == handle_value) {
+        *dispatcher = handle->dispatcher();
+        *rights = handle->rights();
+        found = true;
+    }
+
+    reader->process.store(nullptr, fbl::memory_order_release);
+    thread_preempt_reenable();
+
+    return found;
+}
+
 
 zx_status_t ProcessDispatcher::RemoveHandles(user_in_ptr<const zx_handle_t> user_handles,
                                              size_t num_handles) {
@@ -481,6 +563,16 @@ zx_koid_t ProcessDispatcher::GetKoidForHandle(zx_handle_t handle_value) {
 zx_status_t ProcessDispatcher::GetDispatcherInternal(zx_handle_t handle_value,
                                                      fbl::RefPtr<Dispatcher>* dispatcher,
                                                      zx_rights_t* rights) {
+    zx_rights_t handle_rights;
+    if (likely(GetDispatcherUnlocked(handle_value, dispatcher, &handle_rights))) {
+        kcounter_add(handle_lookup_unlocked, 1);
+        if (rights)
+            *rights = handle_rights;
+        return ZX_OK;
+    }
+
+    // Take the slow path so that a bad handle is reported to the job policy.
+    kcounter_add(handle_lookup_locked, 1);
     Guard<fbl::Mutex> guard{&handle_table_lock_};
     Handle* handle = GetHandleLocked(handle_value);
     if (!handle)
@@ -496,6 +588,19 @@ zx_status_t ProcessDispatcher::GetDispatcherWithRightsInternal(zx_handle_t handl
                                                                zx_rights_t desired_rights,
                                                                fbl::RefPtr<Dispatcher>* dispatcher_out,
                                                                zx_rights_t* out_rights) {
+    fbl::RefPtr<Dispatcher> dispatcher;
+    zx_rights_t rights;
+    if (likely(GetDispatcherUnlocked(handle_value, &dispatcher, &rights))) {
+        kcounter_add(handle_lookup_unlocked, 1);
+        if ((rights & desired_rights) != desired_rights)
+            return ZX_ERR_ACCESS_DENIED;
+        *dispatcher_out = fbl::move(dispatcher);
+        if (out_rights)
+            *out_rights = rights;
+        return ZX_OK;
+    }
+
+    kcounter_add(handle_lookup_locked, 1);
     Guard<fbl::Mutex> guard{&handle_table_lock_};
     Handle* handle = GetHandleLocked(handle_value);
     if (!handle)
@@ -593,6 +698,26 @@ zx_status_t ProcessDispatcher::GetVmos(
     return ZX_OK;
 }
 
+zx_status_t ProcessDispatcher::GetAspaceMapsPaged(
+    uint64_t cursor, user_out_ptr<zx_info_maps_t> maps, size_t max,
+    size_t* actual, uint64_t* next_cursor) {
+    // Unlike GetAspaceMaps(), don't hold the process lock for the walk,
+    // which may drop and retake the aspace lock many times.
+    if (state() == State::DEAD) {
+        return ZX_ERR_BAD_STATE;
+    }
+    return GetVmAspaceMapsPaged(aspace_, cursor, maps, max, actual, next_cursor);
+}
+
+zx_status_t ProcessDispatcher::GetVmosPaged(
+    uint64_t cursor, user_out_ptr<zx_info_vmo_t> vmos, size_t max,
+    size_t* actual, uint64_t* next_cursor) {
+    if (state() != State::RUNNING) {
+        return ZX_ERR_BAD_STATE;
+    }
+    return GetProcessVmosPaged(this, cursor, vmos, max, actual, next_cursor);
+}
+
 zx_status_t ProcessDispatcher::GetThreads(fbl::Array<zx_koid_t>* out_threads) {
     Guard<fbl::Mutex> guard{get_lock()};
     size_t n = thread_list_.size_slow();
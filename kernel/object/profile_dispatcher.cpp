@@ -15,13 +15,28 @@
 
 #include <zircon/rights.h>
 
+// Bounds on deadline reservations: shorter budgets would mostly be spent in the
+// scheduler, and longer periods make for a useless latency guarantee.
+static constexpr zx_duration_t kMinDeadlineCapacity = ZX_USEC(10);
+static constexpr zx_duration_t kMaxDeadlinePeriod = ZX_SEC(10);
+
 zx_status_t validate_profile(const zx_profile_info_t& info) {
-    if (info.type != ZX_PROFILE_INFO_SCHEDULER)
+    switch (info.type) {
+    case ZX_PROFILE_INFO_SCHEDULER:
+        if ((info.scheduler.priority < LOWEST_PRIORITY) ||
+            (info.scheduler.priority  > HIGHEST_PRIORITY))
+            return ZX_ERR_INVALID_ARGS;
+        return ZX_OK;
+    case ZX_PROFILE_INFO_DEADLINE:
+        if ((info.deadline.capacity < kMinDeadlineCapacity) ||
+            (info.deadline.capacity > info.deadline.relative_deadline) ||
+            (info.deadline.relative_deadline > info.deadline.period) ||
+            (info.deadline.period > kMaxDeadlinePeriod))
+            return ZX_ERR_INVALID_ARGS;
+        return ZX_OK;
+    default:
         return ZX_ERR_NOT_SUPPORTED;
-    if ((info.scheduler.priority < LOWEST_PRIORITY) ||
-        (info.scheduler.priority  > HIGHEST_PRIORITY))
-        return ZX_ERR_INVALID_ARGS;
-    return ZX_OK;
+    }
 }
 
 zx_status_t ProfileDispatcher::Create(const zx_profile_info_t& info,
@@ -48,6 +63,14 @@ ProfileDispatcher::~ProfileDispatcher() {
 }
 
 zx_status_t ProfileDispatcher::ApplyProfile(fbl::RefPtr<ThreadDispatcher> thread) {
-    // At the moment, the only thing we support is the priority.
+    if (info_.type == ZX_PROFILE_INFO_DEADLINE) {
+        return thread->SetDeadline(info_.deadline.capacity, info_.deadline.relative_deadline,
+                                   info_.deadline.period);
+    }
+
+    // A priority profile replaces any deadline reservation the thread had.
+    zx_status_t status = thread->SetDeadline(0, 0, 0);
+    if (status != ZX_OK)
+        return status;
     return thread->SetPriority(info_.scheduler.priority);
 }
@@ -26,6 +26,24 @@
 
 #define LOCAL_TRACE 0
 
+namespace {
+
+// Sums the buffer lengths of |iov| into |len|. Fails if the total would not
+// fit the 32-bit lengths the socket buffers track.
+zx_status_t IovecLength(const zx_iovec_t* iov, size_t iov_count, size_t* len) {
+    size_t total = 0u;
+    for (size_t i = 0; i < iov_count; i++) {
+        if (add_overflow(total, iov[i].capacity, &total))
+            return ZX_ERR_INVALID_ARGS;
+    }
+    if (total != static_cast<size_t>(static_cast<uint32_t>(total)))
+        return ZX_ERR_INVALID_ARGS;
+    *len = total;
+    return ZX_OK;
+}
+
+} // namespace
+
 // static
 zx_status_t SocketDispatcher::Create(uint32_t flags,
                                      fbl::RefPtr<Dispatcher>* dispatcher0,
@@ -183,11 +201,20 @@ zx_status_t SocketDispatcher::ShutdownOtherLocked(uint32_t how) {
 }
 
 zx_status_t SocketDispatcher::Write(user_in_ptr<const void> src, size_t len,
-                                    size_t* nwritten) TA_NO_THREAD_SAFETY_ANALYSIS {
+                                    size_t* nwritten) {
+    zx_iovec_t iov = {const_cast<void*>(src.get()), len};
+    return WriteV(&iov, 1u, nwritten);
+}
+
+zx_status_t SocketDispatcher::WriteV(const zx_iovec_t* iov, size_t iov_count,
+                                     size_t* nwritten) TA_NO_THREAD_SAFETY_ANALYSIS {
     canary_.Assert();
 
     LTRACE_ENTRY;
 
+    size_t len;
+    zx_status_t status = IovecLength(iov, iov_count, &len);
+
     Guard<fbl::Mutex> guard{get_lock()};
 
     if (!peer_)
@@ -196,14 +223,14 @@ zx_status_t SocketDispatcher::Write(user_in_ptr<const void> src, size_t len,
     if (signals & ZX_SOCKET_WRITE_DISABLED)
         return ZX_ERR_BAD_STATE;
 
+    if (status != ZX_OK)
+        return status;
     if (len == 0) {
         *nwritten = 0;
         return ZX_OK;
     }
-    if (len != static_cast<size_t>(static_cast<uint32_t>(len)))
-        return ZX_ERR_INVALID_ARGS;
 
-    return peer_->WriteSelfLocked(src, len, nwritten);
+    return peer_->WriteSelfLocked(iov, iov_count, len, nwritten);
 }
 
 zx_status_t SocketDispatcher::WriteControl(user_in_ptr<const void> src, size_t len)
@@ -245,8 +272,9 @@ zx_status_t SocketDispatcher::WriteControlSelfLocked(user_in_ptr<const void> src
     return ZX_OK;
 }
 
-zx_status_t SocketDispatcher::WriteSelfLocked(user_in_ptr<const void> src, size_t len,
-                                              size_t* written) TA_NO_THREAD_SAFETY_ANALYSIS {
+zx_status_t SocketDispatcher::WriteSelfLocked(const zx_iovec_t* iov, size_t iov_count,
+                                              size_t len, size_t* written)
+    TA_NO_THREAD_SAFETY_ANALYSIS {
     canary_.Assert();
 
     if (is_full())
@@ -257,9 +285,9 @@ zx_status_t SocketDispatcher::WriteSelfLocked(user_in_ptr<const void> src, size_
     size_t st = 0u;
     zx_status_t status;
     if (flags_ & ZX_SOCKET_DATAGRAM) {
-        status = data_.WriteDatagram(src, len, &st);
+        status = data_.WriteDatagram(iov, iov_count, len, &st);
     } else {
-        status = data_.WriteStream(src, len, &st);
+        status = data_.WriteStream(iov, iov_count, &st);
     }
     if (status)
         return status;
@@ -297,20 +325,31 @@ zx_status_t SocketDispatcher::WriteSelfLocked(user_in_ptr<const void> src, size_
 
 zx_status_t SocketDispatcher::Read(user_out_ptr<void> dst, size_t len,
                                    size_t* nread) TA_NO_THREAD_SAFETY_ANALYSIS {
-    canary_.Assert();
-
-    LTRACE_ENTRY;
-
-    Guard<fbl::Mutex> guard{get_lock()};
-
     // Just query for bytes outstanding.
     if (!dst && len == 0) {
+        canary_.Assert();
+
+        Guard<fbl::Mutex> guard{get_lock()};
         *nread = data_.size(flags_ & ZX_SOCKET_DATAGRAM);
         return ZX_OK;
     }
 
-    if (len != (size_t)((uint32_t)len))
-        return ZX_ERR_INVALID_ARGS;
+    zx_iovec_t iov = {dst.get(), len};
+    return ReadV(&iov, 1u, nread);
+}
+
+zx_status_t SocketDispatcher::ReadV(const zx_iovec_t* iov, size_t iov_count,
+                                    size_t* nread) TA_NO_THREAD_SAFETY_ANALYSIS {
+    canary_.Assert();
+
+    LTRACE_ENTRY;
+
+    size_t len;
+    zx_status_t status = IovecLength(iov, iov_count, &len);
+    if (status != ZX_OK)
+        return status;
+
+    Guard<fbl::Mutex> guard{get_lock()};
 
     if (is_empty()) {
         if (!peer_)
@@ -324,7 +363,7 @@ zx_status_t SocketDispatcher::Read(user_out_ptr<void> dst, size_t len,
 
     bool was_full = is_full();
 
-    auto st = data_.Read(dst, len, flags_ & ZX_SOCKET_DATAGRAM);
+    auto st = data_.Read(iov, iov_count, len, flags_ & ZX_SOCKET_DATAGRAM);
 
     zx_signals_t clear = 0u;
     zx_signals_t set = 0u;
@@ -450,6 +489,43 @@ size_t SocketDispatcher::ReceiveBufferMax() const {
     return data_.max_size();
 }
 
+zx_status_t SocketDispatcher::SetReceiveBufferMax(size_t value) TA_NO_THREAD_SAFETY_ANALYSIS {
+    canary_.Assert();
+    Guard<fbl::Mutex> guard{get_lock()};
+    if (value < read_threshold_ || (peer_ && value < peer_->write_threshold_))
+        return ZX_ERR_INVALID_ARGS;
+
+    // Capacities beyond the default are for bulk streaming, which is better
+    // served by page-sized buffers. Datagram sockets keep small buffers so
+    // that small packets don't each pin a page.
+    bool page_backed = !(flags_ & ZX_SOCKET_DATAGRAM) && value > MBufChain::kDefaultSizeMax;
+
+    bool was_full = is_full();
+    zx_status_t status = data_.SetMaxSize(value, page_backed);
+    if (status != ZX_OK)
+        return status;
+
+    if (peer_) {
+        zx_signals_t clear = 0u;
+        zx_signals_t set = 0u;
+        if (was_full && !is_full())
+            set |= ZX_SOCKET_WRITABLE;
+        if (!was_full && is_full())
+            clear |= ZX_SOCKET_WRITABLE;
+        size_t peer_write_threshold = peer_->write_threshold_;
+        if (peer_write_threshold > 0) {
+            if ((data_.max_size() - data_.size()) >= peer_write_threshold) {
+                set |= ZX_SOCKET_WRITE_THRESHOLD;
+            } else {
+                clear |= ZX_SOCKET_WRITE_THRESHOLD;
+            }
+        }
+        if (clear || set)
+            peer_->UpdateStateLocked(clear, set);
+    }
+    return ZX_OK;
+}
+
 size_t SocketDispatcher::ReceiveBufferSize() const {
     canary_.Assert();
     Guard<fbl::Mutex> guard{get_lock()};
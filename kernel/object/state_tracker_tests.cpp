@@ -6,6 +6,8 @@
 
 #include <object/dispatcher.h>
 
+#include <fbl/alloc_checker.h>
+#include <fbl/array.h>
 #include <lib/unittest/unittest.h>
 #include <object/state_observer.h>
 
@@ -22,6 +24,11 @@ public:
         UpdateState(0, 1);
     }
 
+    // Helper: Calls UpdateState() with arbitrary masks.
+    void CallUpdateState(zx_signals_t clear_mask, zx_signals_t set_mask) {
+        UpdateState(clear_mask, set_mask);
+    }
+
     // Helper: Causes most On*() hooks (except for OnInitialized) to
     // be called on all of |st|'s observers.
     void CallAllOnHooks() {
@@ -180,6 +187,157 @@ bool on_cancel_by_key() {
 
 } // namespace removal
 
+// Tests for delivering state changes only to interested observers
+namespace interest {
+
+class CountingObserver : public StateObserver {
+public:
+    CountingObserver() = default;
+    explicit CountingObserver(zx_signals_t interest)
+        : watched_(interest) {}
+
+    zx_signals_t interest() const override { return watched_; }
+
+    void set_interest(zx_signals_t interest) { watched_ = interest; }
+
+    int changes() const { return changes_; }
+    void reset_changes() { changes_ = 0; }
+    void set_remove_on_change(bool remove) { remove_on_change_ = remove; }
+
+private:
+    Flags OnInitialize(zx_signals_t initial_state,
+                       const StateObserver::CountInfo* cinfo) override {
+        return 0;
+    }
+    Flags OnStateChange(zx_signals_t new_state) override {
+        changes_++;
+        return remove_on_change_ ? kNeedRemoval : 0;
+    }
+    Flags OnCancel(const Handle* handle) override { return 0; }
+
+    zx_signals_t watched_ = kAllChanges;
+    int changes_ = 0;
+    bool remove_on_change_ = false;
+};
+
+constexpr zx_signals_t kSignalA = ZX_USER_SIGNAL_0;
+constexpr zx_signals_t kSignalB = ZX_USER_SIGNAL_1;
+
+bool filtered_by_interest() {
+    BEGIN_TEST;
+
+    TestDispatcher st;
+    CountingObserver a1(kSignalA), b(kSignalB), a2(kSignalA), ab(kSignalA | kSignalB), all;
+    CountingObserver* const observers[] = {&a1, &b, &a2, &ab, &all};
+    for (CountingObserver* obs : observers) {
+        st.AddObserver(obs, nullptr);
+    }
+
+    st.CallUpdateState(0, kSignalB);
+    EXPECT_EQ(0, a1.changes(), "");
+    EXPECT_EQ(1, b.changes(), "");
+    EXPECT_EQ(0, a2.changes(), "");
+    EXPECT_EQ(1, ab.changes(), "");
+    EXPECT_EQ(1, all.changes(), "");
+
+    // Clearing everything only reaches the observer of every change.
+    st.CallUpdateState(kSignalB, 0);
+    EXPECT_EQ(1, b.changes(), "");
+    EXPECT_EQ(1, ab.changes(), "");
+    EXPECT_EQ(2, all.changes(), "");
+
+    // Removing the first observer of a group keeps the rest of it.
+    st.RemoveObserver(&a1);
+    st.CallUpdateState(0, kSignalA);
+    EXPECT_EQ(0, a1.changes(), "");
+    EXPECT_EQ(1, a2.changes(), "");
+    EXPECT_EQ(2, ab.changes(), "");
+    EXPECT_EQ(3, all.changes(), "");
+
+    for (CountingObserver* obs : observers) {
+        if (obs != &a1) {
+            st.RemoveObserver(obs);
+        }
+    }
+
+    END_TEST;
+}
+
+bool removal_within_group() {
+    BEGIN_TEST;
+
+    constexpr size_t kCount = 5;
+    TestDispatcher st;
+    CountingObserver observers[kCount];
+    for (auto& obs : observers) {
+        obs.set_interest(kSignalA);
+        st.AddObserver(&obs, nullptr);
+    }
+
+    // The first, a middle and the last observer of the group remove
+    // themselves; all of them still see the change.
+    observers[0].set_remove_on_change(true);
+    observers[2].set_remove_on_change(true);
+    observers[4].set_remove_on_change(true);
+    st.CallUpdateState(0, kSignalA);
+    for (auto& obs : observers) {
+        EXPECT_EQ(1, obs.changes(), "");
+    }
+
+    st.CallUpdateState(kSignalA, 0);
+    st.CallUpdateState(0, kSignalA);
+    EXPECT_EQ(1, observers[0].changes(), "");
+    EXPECT_EQ(2, observers[1].changes(), "");
+    EXPECT_EQ(1, observers[2].changes(), "");
+    EXPECT_EQ(2, observers[3].changes(), "");
+    EXPECT_EQ(1, observers[4].changes(), "");
+
+    st.RemoveObserver(&observers[1]);
+    st.RemoveObserver(&observers[3]);
+
+    END_TEST;
+}
+
+// A state change which interests one observer reaches only that one, with a
+// growing number of other observers waiting for a different signal.
+bool many_uninterested_observers() {
+    BEGIN_TEST;
+
+    constexpr size_t kMaxWaiters = 4096;
+    constexpr int kUpdates = 1000;
+
+    fbl::AllocChecker ac;
+    fbl::Array<CountingObserver> waiters(new (&ac) CountingObserver[kMaxWaiters], kMaxWaiters);
+    ASSERT_TRUE(ac.check(), "");
+
+    for (size_t count = 16; count <= kMaxWaiters; count *= 4) {
+        TestDispatcher st;
+        CountingObserver interested(kSignalB);
+        st.AddObserver(&interested, nullptr);
+        for (size_t i = 0; i < count; i++) {
+            waiters[i].reset_changes();
+            waiters[i].set_interest(kSignalA);
+            st.AddObserver(&waiters[i], nullptr);
+        }
+
+        for (int i = 0; i < kUpdates; i++) {
+            st.CallUpdateState(0, kSignalB);
+            st.CallUpdateState(kSignalB, 0);
+        }
+
+        EXPECT_EQ(kUpdates, interested.changes(), "");
+        for (size_t i = 0; i < count; i++) {
+            EXPECT_EQ(0, waiters[i].changes(), "");
+            st.RemoveObserver(&waiters[i]);
+        }
+        st.RemoveObserver(&interested);
+    }
+
+    END_TEST;
+}
+
+} // namespace interest
+
 #define ST_UNITTEST(fname) UNITTEST(#fname, fname)
 
 UNITTEST_START_TESTCASE(state_tracker_tests)
@@ -188,6 +346,9 @@ ST_UNITTEST(removal::on_initialize)
 ST_UNITTEST(removal::on_state_change_via_update_state)
 ST_UNITTEST(removal::on_cancel)
 ST_UNITTEST(removal::on_cancel_by_key)
+ST_UNITTEST(interest::filtered_by_interest)
+ST_UNITTEST(interest::removal_within_group)
+ST_UNITTEST(interest::many_uninterested_observers)
 
 UNITTEST_END_TESTCASE(
     state_tracker_tests, "statetracker", "StateTracker test");
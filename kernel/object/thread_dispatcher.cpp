@@ -25,6 +25,7 @@
 
 #include <zircon/rights.h>
 #include <zircon/syscalls/debug.h>
+#include <zircon/time.h>
 #include <zircon/types.h>
 
 #include <object/c_user_thread.h>
@@ -348,8 +349,9 @@ void ThreadDispatcher::Exiting() {
         // switch will effectively reenable interrupts in the new thread.
         arch_disable_ints();
 
-        // queue without reschdule since us exiting is a reschedule event already
-        dpc_queue(&cleanup_dpc_, false);
+        // queue without reschdule since us exiting is a reschedule event already. freeing the
+        // dispatcher can wait behind any latency-sensitive dpcs.
+        dpc_queue_priority(&cleanup_dpc_, DPC_PRIORITY_BULK, false);
     }
 
     // after this point the thread will stop permanently
@@ -841,6 +843,36 @@ zx_status_t ThreadDispatcher::GetStatsForUserspace(zx_info_thread_stats_t* info)
     return ZX_OK;
 }
 
+void ThreadDispatcher::GetSchedStats(zx_info_task_sched_stats_t* info) {
+    canary_.Assert();
+
+    *info = {};
+
+    info->total_runtime = runtime_ns();
+
+    struct sched_wait_stats wait;
+    thread_get_sched_stats(&thread_, &wait, &info->context_switches, &info->preemptions);
+    info->total_run_queue_wait = wait.total;
+    info->max_run_queue_wait = wait.max;
+    static_assert(SCHED_WAIT_BUCKETS == ZX_INFO_RUN_QUEUE_WAIT_BUCKETS, "");
+    for (size_t i = 0; i < SCHED_WAIT_BUCKETS; i++) {
+        info->run_queue_wait_histogram[i] = wait.histogram[i];
+    }
+}
+
+void AccumulateSchedStats(zx_info_task_sched_stats_t* total,
+                          const zx_info_task_sched_stats_t& stats) {
+    total->total_runtime = zx_duration_add_duration(total->total_runtime, stats.total_runtime);
+    total->total_run_queue_wait = zx_duration_add_duration(total->total_run_queue_wait,
+                                                           stats.total_run_queue_wait);
+    total->max_run_queue_wait = fbl::max(total->max_run_queue_wait, stats.max_run_queue_wait);
+    total->context_switches += stats.context_switches;
+    total->preemptions += stats.preemptions;
+    for (size_t i = 0; i < ZX_INFO_RUN_QUEUE_WAIT_BUCKETS; i++) {
+        total->run_queue_wait_histogram[i] += stats.run_queue_wait_histogram[i];
+    }
+}
+
 zx_status_t ThreadDispatcher::GetExceptionReport(zx_exception_report_t* report) {
     canary_.Assert();
 
@@ -975,6 +1007,19 @@ zx_status_t ThreadDispatcher::SetPriority(int32_t priority) {
     return ZX_OK;
 }
 
+zx_status_t ThreadDispatcher::SetDeadline(zx_duration_t capacity,
+                                          zx_duration_t relative_deadline,
+                                          zx_duration_t period) {
+    Guard<fbl::Mutex> guard{get_lock()};
+    if ((state_.lifecycle() == ThreadState::Lifecycle::INITIAL) ||
+        (state_.lifecycle() == ThreadState::Lifecycle::DYING) ||
+        (state_.lifecycle() == ThreadState::Lifecycle::DEAD)) {
+        return ZX_ERR_BAD_STATE;
+    }
+    // The parameters were already validated by the Profile dispatcher.
+    return thread_set_deadline(&thread_, capacity, relative_deadline, period);
+}
+
 void get_user_thread_process_name(const void* user_thread,
                                   char out_name[ZX_MAX_NAME_LEN]) {
     const ThreadDispatcher* ut =
@@ -6,12 +6,17 @@
 
 #include <object/vm_object_dispatcher.h>
 
+#include <lib/counters.h>
+#include <vm/physmap.h>
+#include <vm/pmm.h>
 #include <vm/vm_aspace.h>
 #include <vm/vm_object.h>
 
 #include <zircon/rights.h>
 
+#include <fbl/algorithm.h>
 #include <fbl/alloc_checker.h>
+#include <fbl/auto_call.h>
 
 #include <assert.h>
 #include <err.h>
@@ -20,6 +25,9 @@
 
 #define LOCAL_TRACE 0
 
+KCOUNTER(vmo_transfer_moved_pages, "kernel.vmo.transfer.moved_pages");
+KCOUNTER(vmo_transfer_copied_bytes, "kernel.vmo.transfer.copied_bytes");
+
 zx_status_t VmObjectDispatcher::Create(fbl::RefPtr<VmObject> vmo,
                                        fbl::RefPtr<Dispatcher>* dispatcher,
                                        zx_rights_t* rights) {
@@ -81,6 +89,104 @@ zx_status_t VmObjectDispatcher::Write(user_in_ptr<const void> user_data,
     return vmo_->WriteUser(user_data, offset, length);
 }
 
+// Copies |length| bytes from |src| to |dst| a page at a time through a kernel page.
+static zx_status_t CopyData(VmObject* dst, uint64_t offset, uint64_t length,
+                            VmObject* src, uint64_t src_offset) {
+    vm_page_t* page;
+    paddr_t pa;
+    zx_status_t status = pmm_alloc_page(0, &page, &pa);
+    if (status != ZX_OK)
+        return status;
+    auto free_page = fbl::MakeAutoCall([page]() { pmm_free_page(page); });
+    void* buffer = paddr_to_physmap(pa);
+
+    while (length > 0) {
+        // line the chunks up with the source's pages, so each chunk is one page lookup
+        size_t chunk = static_cast<size_t>(
+            fbl::min<uint64_t>(length, PAGE_SIZE - (src_offset & (PAGE_SIZE - 1))));
+        status = src->Read(buffer, src_offset, chunk);
+        if (status != ZX_OK)
+            return status;
+        status = dst->Write(buffer, offset, chunk);
+        if (status != ZX_OK)
+            return status;
+        kcounter_add(vmo_transfer_copied_bytes, chunk);
+        offset += chunk;
+        src_offset += chunk;
+        length -= chunk;
+    }
+    return ZX_OK;
+}
+
+// Writes the contents of |pages| to |dst| starting at |offset|, then frees them.
+static zx_status_t WritePages(VmObject* dst, uint64_t offset, list_node* pages) {
+    zx_status_t status = ZX_OK;
+    vm_page_t* p;
+    list_for_every_entry (pages, p, vm_page_t, queue_node) {
+        status = dst->Write(paddr_to_physmap(p->paddr()), offset, PAGE_SIZE);
+        if (status != ZX_OK)
+            break;
+        kcounter_add(vmo_transfer_copied_bytes, PAGE_SIZE);
+        offset += PAGE_SIZE;
+    }
+    pmm_free(pages);
+    return status;
+}
+
+zx_status_t VmObjectDispatcher::TransferData(uint32_t options, uint64_t offset, uint64_t length,
+                                             VmObject* src, uint64_t src_offset) {
+    canary_.Assert();
+
+    if (options & ~ZX_VMO_TRANSFER_MOVE)
+        return ZX_ERR_INVALID_ARGS;
+
+    uint64_t end, src_end;
+    if (add_overflow(offset, length, &end) || add_overflow(src_offset, length, &src_end))
+        return ZX_ERR_OUT_OF_RANGE;
+    if (length == 0)
+        return ZX_OK;
+
+    // a transfer between overlapping ranges would read back what it has already written
+    if (src == vmo_.get() && offset < src_end && src_offset < end)
+        return ZX_ERR_INVALID_ARGS;
+
+    if (!(options & ZX_VMO_TRANSFER_MOVE))
+        return CopyData(vmo_.get(), offset, length, src, src_offset);
+
+    if (!IS_PAGE_ALIGNED(offset) || !IS_PAGE_ALIGNED(length) || !IS_PAGE_ALIGNED(src_offset))
+        return ZX_ERR_INVALID_ARGS;
+
+    // taking the pages of a pager-backed vmo would commit them from the pager first,
+    // which copying does only for the pages it reads
+    if (!src->is_paged() || src->is_pager_backed() || !vmo_->is_paged())
+        return CopyData(vmo_.get(), offset, length, src, src_offset);
+    // pages moved between cache policies could show stale data through the cache
+    if (src->GetMappingCachePolicy() != ARCH_MMU_FLAG_CACHED ||
+        vmo_->GetMappingCachePolicy() != ARCH_MMU_FLAG_CACHED)
+        return CopyData(vmo_.get(), offset, length, src, src_offset);
+
+    list_node pages;
+    list_initialize(&pages);
+    zx_status_t status = src->TakePages(src_offset, length, &pages);
+    if (status == ZX_ERR_BAD_STATE) {
+        // the source's pages have to stay where they are: they are contiguous, pinned
+        // or shared with a clone
+        return CopyData(vmo_.get(), offset, length, src, src_offset);
+    }
+    if (status != ZX_OK)
+        return status;
+
+    const size_t taken = list_length(&pages);
+    status = vmo_->ReplacePages(offset, length, &pages);
+    const size_t left = list_length(&pages);
+    kcounter_add(vmo_transfer_moved_pages, taken - left);
+    if (status == ZX_OK)
+        return ZX_OK;
+
+    // whatever this vmo could not take is copied into it instead
+    return WritePages(vmo_.get(), offset + (taken - left) * PAGE_SIZE, &pages);
+}
+
 zx_status_t VmObjectDispatcher::SetSize(uint64_t size) {
     canary_.Assert();
 
@@ -125,6 +231,13 @@ zx_info_vmo_t VmObjectDispatcher::GetVmoInfo(void)
     return VmoToInfoEntry(vmo().get(), true, 0);
 }
 
+zx_info_vmo_working_set_t VmObjectDispatcher::GetWorkingSetInfo() {
+    zx_info_vmo_working_set_t info = {};
+    info.committed_bytes = vmo_->AllocatedPages() * PAGE_SIZE;
+    info.working_set_bytes = vmo_->ActivePages() * PAGE_SIZE;
+    return info;
+}
+
 zx_status_t VmObjectDispatcher::RangeOp(uint32_t op, uint64_t offset, uint64_t size,
                                         user_inout_ptr<void> buffer, size_t buffer_size,
                                         zx_rights_t rights) {
@@ -43,11 +43,12 @@ zx_signals_t WaitStateObserver::End() {
     canary_.Assert();
     DEBUG_ASSERT(dispatcher_);
 
-    dispatcher_->RemoveObserver(this);
+    wakeup_reasons_ |= dispatcher_->RemoveObserver(this);
     dispatcher_.reset();
 
     // Return the set of reasons that we may have been woken.  Basically, this
-    // is set of satisfied bits which were ever set while we were waiting on the list.
+    // is set of satisfied bits which were set when we started waiting, when
+    // any watched signal was asserted, and when we stopped.
     return wakeup_reasons_;
 }
 
@@ -70,10 +71,8 @@ StateObserver::Flags WaitStateObserver::OnInitialize(zx_signals_t initial_state,
 StateObserver::Flags WaitStateObserver::OnStateChange(zx_signals_t new_state) {
     canary_.Assert();
 
-    // If we are still on our StateTracker's list of observers, and the
-    // StateTracker's state has changed, accumulate the reasons that we may have
-    // woken up.  In particular any satisfied bits which have become set
-    // while we were on the list may have been reasons to wake up.
+    // We are only told about states which assert one of our watched signals
+    // (see interest()), so accumulate the reasons that we may have woken up.
     wakeup_reasons_ |= new_state;
 
     if (new_state & watched_signals_) {
@@ -9,13 +9,17 @@
 #include <acpica/acpi.h>
 
 #include <assert.h>
+#include <debug.h>
 #include <err.h>
+#include <inttypes.h>
 #include <trace.h>
 
 #include <lk/init.h>
 
 #include <arch/x86/apic.h>
+#include <arch/x86/mp.h>
 #include <platform/pc/acpi.h>
+#include <vm/pmm.h>
 #include <zircon/types.h>
 
 #define LOCAL_TRACE 0
@@ -307,3 +311,102 @@ zx_status_t platform_find_hpet(struct acpi_hpet_descriptor* hpet) {
 
     return ZX_OK;
 }
+
+// Map an ACPI proximity domain onto a dense pmm numa node id, allocating a
+// new id the first time a domain is seen. Returns false if we ran out of ids.
+static bool acpi_proximity_domain_to_node(uint32_t domain, uint32_t* node) {
+    static uint32_t domains[PMM_MAX_NUMA_NODES];
+    static uint32_t domain_count = 0;
+
+    for (uint32_t i = 0; i < domain_count; i++) {
+        if (domains[i] == domain) {
+            *node = i;
+            return true;
+        }
+    }
+    if (domain_count == PMM_MAX_NUMA_NODES) {
+        return false;
+    }
+    domains[domain_count] = domain;
+    *node = domain_count++;
+    return true;
+}
+
+/* @brief Tag physical memory and cpus with their NUMA node from the SRAT
+ *
+ * Must be called after the cpu structures have been set up so that local
+ * apic ids can be translated to cpu numbers. If there is no SRAT the whole
+ * system is treated as a single node.
+ */
+void platform_init_numa(void) {
+    ACPI_TABLE_HEADER* table = NULL;
+    ACPI_STATUS acpi_status = AcpiGetTable((char*)ACPI_SIG_SRAT, 1, &table);
+    if (acpi_status != AE_OK) {
+        LTRACEF("no SRAT, assuming a single numa node\n");
+        return;
+    }
+
+    uintptr_t records_start = ((uintptr_t)table) + sizeof(ACPI_TABLE_SRAT);
+    uintptr_t records_end = ((uintptr_t)table) + table->Length;
+
+    uintptr_t addr;
+    ACPI_SUBTABLE_HEADER* record_hdr;
+    for (addr = records_start; addr < records_end; addr += record_hdr->Length) {
+        record_hdr = (ACPI_SUBTABLE_HEADER*)addr;
+        if (record_hdr->Length == 0) {
+            break;
+        }
+
+        uint32_t node;
+        switch (record_hdr->Type) {
+        case ACPI_SRAT_TYPE_CPU_AFFINITY: {
+            ACPI_SRAT_CPU_AFFINITY* cpu = (ACPI_SRAT_CPU_AFFINITY*)record_hdr;
+            if (!(cpu->Flags & ACPI_SRAT_CPU_ENABLED)) {
+                continue;
+            }
+            uint32_t domain = cpu->ProximityDomainLo |
+                              ((uint32_t)cpu->ProximityDomainHi[0] << 8) |
+                              ((uint32_t)cpu->ProximityDomainHi[1] << 16) |
+                              ((uint32_t)cpu->ProximityDomainHi[2] << 24);
+            int cpu_num = x86_apic_id_to_cpu_num(cpu->ApicId);
+            if (cpu_num >= 0 && acpi_proximity_domain_to_node(domain, &node)) {
+                LTRACEF("cpu %d (apic %u) -> node %u\n", cpu_num, cpu->ApicId, node);
+                pmm_set_cpu_numa_node(cpu_num, node);
+            }
+            break;
+        }
+        case ACPI_SRAT_TYPE_X2APIC_CPU_AFFINITY: {
+            ACPI_SRAT_X2APIC_CPU_AFFINITY* cpu = (ACPI_SRAT_X2APIC_CPU_AFFINITY*)record_hdr;
+            if (!(cpu->Flags & ACPI_SRAT_CPU_ENABLED)) {
+                continue;
+            }
+            int cpu_num = x86_apic_id_to_cpu_num(cpu->ApicId);
+            if (cpu_num >= 0 && acpi_proximity_domain_to_node(cpu->ProximityDomain, &node)) {
+                LTRACEF("cpu %d (x2apic %u) -> node %u\n", cpu_num, cpu->ApicId, node);
+                pmm_set_cpu_numa_node(cpu_num, node);
+            }
+            break;
+        }
+        case ACPI_SRAT_TYPE_MEMORY_AFFINITY: {
+            ACPI_SRAT_MEM_AFFINITY* mem = (ACPI_SRAT_MEM_AFFINITY*)record_hdr;
+            if (!(mem->Flags & ACPI_SRAT_MEM_ENABLED) || mem->Length == 0) {
+                continue;
+            }
+            if (!acpi_proximity_domain_to_node(mem->ProximityDomain, &node)) {
+                TRACEF("too many numa nodes, ignoring proximity domain %u\n",
+                       mem->ProximityDomain);
+                continue;
+            }
+            LTRACEF("mem %#" PRIx64 " len %#" PRIx64 " -> node %u\n",
+                    mem->BaseAddress, mem->Length, node);
+            pmm_set_numa_node_range(mem->BaseAddress, mem->Length, node);
+            break;
+        }
+        }
+    }
+    if (addr != records_end) {
+        TRACEF("malformed SRAT\n");
+    }
+
+    dprintf(INFO, "PMM: %u numa node(s)\n", pmm_numa_node_count());
+}
@@ -36,5 +36,6 @@ zx_status_t platform_enumerate_interrupt_source_overrides(
     uint32_t len,
     uint32_t* num_isos);
 zx_status_t platform_find_hpet(struct acpi_hpet_descriptor* hpet);
+void platform_init_numa(void);
 
 __END_CDECLS
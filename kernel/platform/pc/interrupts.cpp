@@ -10,6 +10,7 @@
 #include <arch/x86.h>
 #include <arch/x86/apic.h>
 #include <arch/x86/interrupts.h>
+#include <arch/x86/mp.h>
 #include <assert.h>
 #include <debug.h>
 #include <dev/interrupt.h>
@@ -17,6 +18,7 @@
 #include <fbl/algorithm.h>
 #include <kernel/auto_lock.h>
 #include <kernel/spinlock.h>
+#include <kernel/stats.h>
 #include <kernel/thread.h>
 #include <lib/pow2_range_allocator.h>
 #include <lk/init.h>
@@ -159,12 +161,48 @@ zx_status_t get_interrupt_config(unsigned int vector,
     return apic_io_fetch_irq_config(vector, tm, pol);
 }
 
+// Fetch the physical destination ID which targets the Local APIC of |cpu|.
+static zx_status_t cpu_to_apic_dst(cpu_num_t cpu, uint8_t* dst) {
+    if (cpu >= arch_max_num_cpus() || !mp_is_cpu_online(cpu)) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+
+    // Without interrupt remapping, both IO APIC redirection entries and MSI
+    // target addresses carry an 8 bit destination ID.
+    uint32_t apic_id = x86_cpu_num_to_apic_id(cpu);
+    if (apic_id > UINT8_MAX) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+
+    *dst = static_cast<uint8_t>(apic_id);
+    return ZX_OK;
+}
+
+zx_status_t set_interrupt_affinity(unsigned int vector, cpu_num_t cpu) {
+    if (!is_valid_interrupt(vector, 0)) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+
+    uint8_t dst;
+    zx_status_t status = cpu_to_apic_dst(cpu, &dst);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    AutoSpinLock guard(&lock);
+    apic_io_configure_irq_dst(vector, DST_MODE_PHYSICAL, dst);
+    return ZX_OK;
+}
+
 void platform_irq(x86_iframe_t* frame) {
     // get the current vector
     uint64_t x86_vector = frame->vector;
     DEBUG_ASSERT(x86_vector >= X86_INT_PLATFORM_BASE &&
                  x86_vector <= X86_INT_PLATFORM_MAX);
 
+    // tracking external hardware irqs in this variable
+    CPU_STATS_INC(interrupts);
+
     // deliver the interrupt
     struct int_handler_struct* handler = &int_handler_table[x86_vector];
 
@@ -279,6 +317,18 @@ bool msi_is_supported(void) {
     return true;
 }
 
+// Compute the MSI target address which delivers to the Local APIC with the
+// physical destination ID |dst|.
+// See section 10.11.1 of the Intel 64 and IA-32 Architectures Software
+// Developer's Manual Volume 3A.
+static uint32_t msi_target_addr(uint8_t dst) {
+    uint32_t tgt_addr = 0xFEE00000;              // base addr
+    tgt_addr |= ((uint32_t)dst) << 12;           // Dest ID
+    tgt_addr |= 0x08;                            // Redir hint == 1
+    tgt_addr &= ~0x04;                           // Dest Mode == Physical
+    return tgt_addr;
+}
+
 zx_status_t msi_alloc_block(uint requested_irqs,
                                 bool can_target_64bit,
                                 bool is_msix,
@@ -301,19 +351,9 @@ zx_status_t msi_alloc_block(uint requested_irqs,
 
     res = p2ra_allocate_range(&x86_irq_vector_allocator, alloc_size, &alloc_start);
     if (res == ZX_OK) {
-        // Compute the target address.
-        // See section 10.11.1 of the Intel 64 and IA-32 Architectures Software
-        // Developer's Manual Volume 3A.
-        //
-        // TODO(johngro) : don't just bind this block to the Local APIC of the
-        // processor which is active when calling msi_alloc_block.  Instead,
-        // there should either be a system policy (like, always send to any
-        // processor, or just processor 0, or something), or the decision of
-        // which CPUs to bind to should be left to the caller.
-        uint32_t tgt_addr = 0xFEE00000;              // base addr
-        tgt_addr |= ((uint32_t)apic_bsp_id()) << 12; // Dest ID == the BSP APIC ID
-        tgt_addr |= 0x08;                            // Redir hint == 1
-        tgt_addr &= ~0x04;                           // Dest Mode == Physical
+        // Target the BSP to begin with.  The caller may steer the block to
+        // another CPU with msi_set_affinity.
+        uint32_t tgt_addr = msi_target_addr(apic_bsp_id());
 
         // Compute the target data.
         // See section 10.11.2 of the Intel 64 and IA-32 Architectures Software
@@ -345,6 +385,36 @@ void msi_free_block(msi_block_t* block) {
     memset(block, 0, sizeof(*block));
 }
 
+zx_status_t msi_set_affinity(msi_block_t* block, cpu_num_t cpu) {
+    DEBUG_ASSERT(block && block->allocated);
+
+    uint8_t dst;
+    zx_status_t status = cpu_to_apic_dst(cpu, &dst);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    block->tgt_addr = msi_target_addr(dst);
+    return ZX_OK;
+}
+
+zx_status_t msi_set_vector_affinity(const msi_block_t* block, uint msi_id, cpu_num_t cpu,
+                                    uint64_t* out_tgt_addr) {
+    DEBUG_ASSERT(block && block->allocated);
+    DEBUG_ASSERT(msi_id < block->num_irq);
+
+    uint8_t dst;
+    zx_status_t status = cpu_to_apic_dst(cpu, &dst);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    // The destination lives in the address, so the vector (in the data) is
+    // the same whichever cpu it is delivered to.
+    *out_tgt_addr = msi_target_addr(dst);
+    return ZX_OK;
+}
+
 void msi_register_handler(const msi_block_t* block, uint msi_id, int_handler handler, void* ctx) {
     DEBUG_ASSERT(block && block->allocated);
     DEBUG_ASSERT(msi_id < block->num_irq);
@@ -912,6 +912,8 @@ void platform_init(void) {
 
     platform_init_smp();
 
+    platform_init_numa();
+
     pc_init_smbios();
 
     SmbiosWalkStructs([](smbios::SpecVersion version, const smbios::Header* h,
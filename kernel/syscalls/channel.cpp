@@ -15,6 +15,7 @@
 #include <object/handle.h>
 #include <object/message_packet.h>
 #include <object/process_dispatcher.h>
+#include <object/vm_object_dispatcher.h>
 #include <zircon/syscalls/policy.h>
 #include <zircon/types.h>
 
@@ -34,8 +35,31 @@ KCOUNTER(channel_msg_16k_bytes, "kernel.channel.bytes.16k");
 KCOUNTER(channel_msg_64k_bytes, "kernel.channel.bytes.64k");
 KCOUNTER(channel_msg_received,  "kernel.channel.messages");
 
-static void record_recv_msg_sz(uint32_t size) {
+// Payload bytes copied into and out of the kernel, versus bytes of VMOs
+// whose handles were transferred, which move without being copied.
+KCOUNTER(channel_bytes_copied_in,  "kernel.channel.copy.in_bytes");
+KCOUNTER(channel_bytes_copied_out, "kernel.channel.copy.out_bytes");
+KCOUNTER(channel_bytes_moved,      "kernel.channel.vmo.moved_bytes");
+
+static void record_sent_msg(ChannelDispatcher* channel, const MessagePacket* msg) {
+    kcounter_add(channel_bytes_copied_in, msg->data_size());
+
+    uint64_t moved = 0u;
+    for (uint32_t ix = 0; ix != msg->num_handles(); ++ix) {
+        fbl::RefPtr<Dispatcher> dispatcher = msg->handles()[ix]->dispatcher();
+        auto vmo = DownCastDispatcher<VmObjectDispatcher>(&dispatcher);
+        if (vmo)
+            moved += vmo->vmo()->size();
+    }
+    if (moved > 0u)
+        kcounter_add(channel_bytes_moved, static_cast<int64_t>(moved));
+    channel->RecordSent(msg->data_size(), moved);
+}
+
+static void record_recv_msg_sz(ChannelDispatcher* channel, uint32_t size) {
     kcounter_add(channel_msg_received, 1);
+    kcounter_add(channel_bytes_copied_out, size);
+    channel->RecordReceived(size);
 
     switch(size) {
         case     0          : kcounter_add(channel_msg_0_bytes, 1);   break;
@@ -164,7 +188,7 @@ static zx_status_t channel_read(zx_handle_t handle_value, uint32_t options,
         msg_get_handles(up, msg.get(), handles, num_handles);
     }
 
-    record_recv_msg_sz(num_bytes);
+    record_recv_msg_sz(channel.get(), num_bytes);
     ktrace(TAG_CHANNEL_READ, (uint32_t)channel->get_koid(), num_bytes, num_handles, 0);
     return result;
 }
@@ -222,7 +246,7 @@ static zx_status_t channel_read_out(ProcessDispatcher* up,
     return ZX_OK;
 }
 
-static zx_status_t channel_call_epilogue(ProcessDispatcher* up,
+static zx_status_t channel_call_epilogue(ProcessDispatcher* up, ChannelDispatcher* channel,
                                          fbl::unique_ptr<MessagePacket> reply,
                                          zx_channel_call_args_t* args,
                                          user_out_ptr<uint32_t> actual_bytes,
@@ -231,7 +255,7 @@ static zx_status_t channel_call_epilogue(ProcessDispatcher* up,
     zx_status_t status = channel_read_out(up, fbl::move(reply), args, actual_bytes, actual_handles);
     if (status != ZX_OK)
         return status;
-    record_recv_msg_sz(bytes);
+    record_recv_msg_sz(channel, bytes);
     return ZX_OK;
 }
 
@@ -309,6 +333,8 @@ zx_status_t sys_channel_write(zx_handle_t handle_value, uint32_t options,
             return status;
     }
 
+    record_sent_msg(channel.get(), msg.get());
+
     status = channel->Write(up->get_koid(), fbl::move(msg));
     if (status != ZX_OK)
         return status;
@@ -364,6 +390,8 @@ zx_status_t sys_channel_call_noretry(zx_handle_t handle_value, uint32_t options,
             return status;
     }
 
+    record_sent_msg(channel.get(), msg.get());
+
     // TODO(ZX-970): ktrace channel calls; maybe two traces, maybe with txid.
 
     // Write message and wait for reply, deadline, or cancelation
@@ -371,7 +399,8 @@ zx_status_t sys_channel_call_noretry(zx_handle_t handle_value, uint32_t options,
     status = channel->Call(up->get_koid(), fbl::move(msg), deadline, &reply);
     if (status != ZX_OK)
         return status;
-    return channel_call_epilogue(up, fbl::move(reply), &args, actual_bytes, actual_handles);
+    return channel_call_epilogue(up, channel.get(), fbl::move(reply), &args, actual_bytes,
+                                 actual_handles);
 }
 
 // zx_status_t zx_channel_call_finish
@@ -396,6 +425,7 @@ zx_status_t sys_channel_call_finish(zx_time_t deadline,
     status = channel->ResumeInterruptedCall(waiter, deadline, &reply);
     if (status != ZX_OK)
         return status;
-    return channel_call_epilogue(up, fbl::move(reply), &args, actual_bytes, actual_handles);
+    return channel_call_epilogue(up, channel.get(), fbl::move(reply), &args, actual_bytes,
+                                 actual_handles);
 
 }
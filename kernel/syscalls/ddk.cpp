@@ -463,7 +463,7 @@ zx_status_t sys_interrupt_create(zx_handle_t src_obj, uint32_t src_num,
 zx_status_t sys_interrupt_bind(zx_handle_t inth, zx_handle_t porth,
                                uint64_t key, uint32_t options) {
     LTRACEF("handle %x\n", inth);
-    if (options) {
+    if (options & ~ZX_INTERRUPT_BIND_POLL) {
         return ZX_ERR_INVALID_ARGS;
     }
 
@@ -483,7 +483,7 @@ zx_status_t sys_interrupt_bind(zx_handle_t inth, zx_handle_t porth,
         return ZX_ERR_WRONG_TYPE;
     }
 
-    return interrupt->Bind(port, interrupt, key);
+    return interrupt->Bind(port, interrupt, key, options);
 }
 
 // zx_status_t zx_interrupt_ack
@@ -550,6 +550,30 @@ zx_status_t sys_interrupt_trigger(zx_handle_t handle,
     return interrupt->Trigger(timestamp);
 }
 
+// zx_status_t zx_interrupt_set_affinity
+zx_status_t sys_interrupt_set_affinity(zx_handle_t handle,
+                                       uint32_t options,
+                                       uint32_t cpu) {
+    LTRACEF("handle %x cpu %u\n", handle, cpu);
+
+    if (options) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+
+    zx_status_t status;
+    auto up = ProcessDispatcher::GetCurrent();
+    fbl::RefPtr<InterruptDispatcher> interrupt;
+    status = up->GetDispatcherWithRights(handle, ZX_RIGHT_WRITE, &interrupt);
+    if (status != ZX_OK)
+        return status;
+
+    if (cpu >= arch_max_num_cpus()) {
+        return ZX_ERR_OUT_OF_RANGE;
+    }
+
+    return interrupt->SetAffinity(cpu);
+}
+
 // zx_status_t zx_smc_call
 zx_status_t sys_smc_call(zx_handle_t handle,
                          user_in_ptr<const zx_smc_parameters_t> parameters,
@@ -9,6 +9,8 @@
 #include <trace.h>
 
 #include <object/process_dispatcher.h>
+#include <object/thread_dispatcher.h>
+#include <zircon/rights.h>
 #include <zircon/types.h>
 
 #include "priv.h"
@@ -23,6 +25,21 @@ zx_status_t sys_futex_wait(user_in_ptr<const zx_futex_t> value_ptr, int32_t curr
         value_ptr, current_value, deadline);
 }
 
+// zx_status_t zx_futex_wait_pi
+zx_status_t sys_futex_wait_pi(user_in_ptr<const zx_futex_t> value_ptr, int32_t current_value,
+                              zx_handle_t owner_handle, zx_time_t deadline) {
+    LTRACEF("futex %p current %d owner %x\n", value_ptr.get(), current_value, owner_handle);
+
+    auto up = ProcessDispatcher::GetCurrent();
+
+    fbl::RefPtr<ThreadDispatcher> owner;
+    zx_status_t status = up->GetDispatcherWithRights(owner_handle, ZX_RIGHT_MANAGE_THREAD, &owner);
+    if (status != ZX_OK)
+        return status;
+
+    return up->futex_context()->FutexWait(value_ptr, current_value, deadline, fbl::move(owner));
+}
+
 // zx_status_t zx_futex_wake
 zx_status_t sys_futex_wake(user_in_ptr<const zx_futex_t> value_ptr, uint32_t count) {
     LTRACEF("futex %p count %" PRIu32 "\n", value_ptr.get(), count);
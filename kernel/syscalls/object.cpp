@@ -17,11 +17,15 @@
 #include <vm/vm.h>
 #include <zircon/time.h>
 #include <zircon/types.h>
+#include <zircon/zx-syscall-numbers.h>
 
 #include <object/bus_transaction_initiator_dispatcher.h>
+#include <object/channel_dispatcher.h>
 #include <object/diagnostics.h>
+#include <object/fifo_dispatcher.h>
 #include <object/handle.h>
 #include <object/job_dispatcher.h>
+#include <object/object_cache.h>
 #include <object/process_dispatcher.h>
 #include <object/resource_dispatcher.h>
 #include <object/resource.h>
@@ -33,6 +37,7 @@
 #include <fbl/ref_ptr.h>
 
 #include "priv.h"
+#include "syscall_stats.h"
 
 #define LOCAL_TRACE 0
 
@@ -304,6 +309,30 @@ zx_status_t sys_object_get_info(zx_handle_t handle, uint32_t topic,
         return single_record_result(
             _buffer, buffer_size, _actual, _avail, &info, sizeof(info));
     }
+    case ZX_INFO_TASK_SCHED_STATS: {
+        // grab a reference to the dispatcher
+        fbl::RefPtr<Dispatcher> dispatcher;
+        auto error = up->GetDispatcherWithRights(handle, ZX_RIGHT_INSPECT, &dispatcher);
+        if (error < 0)
+            return error;
+
+        // build the info structure; processes and jobs report the sum over
+        // their threads
+        zx_info_task_sched_stats_t info = {};
+
+        if (auto thread = DownCastDispatcher<ThreadDispatcher>(&dispatcher)) {
+            thread->GetSchedStats(&info);
+        } else if (auto process = DownCastDispatcher<ProcessDispatcher>(&dispatcher)) {
+            process->GetSchedStats(&info);
+        } else if (auto job = DownCastDispatcher<JobDispatcher>(&dispatcher)) {
+            job->GetSchedStats(&info);
+        } else {
+            return ZX_ERR_WRONG_TYPE;
+        }
+
+        return single_record_result(
+            _buffer, buffer_size, _actual, _avail, &info, sizeof(info));
+    }
     case ZX_INFO_TASK_STATS: {
         // TODO(ZX-458): Handle forward/backward compatibility issues
         // with changes to the struct.
@@ -415,6 +444,16 @@ zx_status_t sys_object_get_info(zx_handle_t handle, uint32_t topic,
         }
         return status;
     }
+    case ZX_INFO_VMO_WORKING_SET: {
+        fbl::RefPtr<VmObjectDispatcher> vmo;
+        zx_status_t status = up->GetDispatcherWithRights(handle, ZX_RIGHT_INSPECT, &vmo);
+        if (status != ZX_OK)
+            return status;
+
+        zx_info_vmo_working_set_t info = vmo->GetWorkingSetInfo();
+        return single_record_result(
+            _buffer, buffer_size, _actual, _avail, &info, sizeof(info));
+    }
     case ZX_INFO_VMAR: {
         fbl::RefPtr<VmAddressRegionDispatcher> vmar;
         zx_status_t status = up->GetDispatcherWithRights(handle, ZX_RIGHT_INSPECT, &vmar);
@@ -501,6 +540,55 @@ zx_status_t sys_object_get_info(zx_handle_t handle, uint32_t topic,
         }
         return ZX_OK;
     }
+    case ZX_INFO_CPU_SCHED_STATS: {
+        auto status = validate_resource(handle, ZX_RSRC_KIND_ROOT);
+        if (status != ZX_OK)
+            return status;
+
+        size_t num_cpus = arch_max_num_cpus();
+        size_t num_space_for = buffer_size / sizeof(zx_info_cpu_sched_stats_t);
+        size_t num_to_copy = MIN(num_cpus, num_space_for);
+
+        // build an alias to the output buffer that is in units of the cpu stat structure
+        user_out_ptr<zx_info_cpu_sched_stats_t> cpu_buf =
+            _buffer.reinterpret<zx_info_cpu_sched_stats_t>();
+
+        for (unsigned int i = 0; i < static_cast<unsigned int>(num_to_copy); i++) {
+            const auto cpu = &percpu[i];
+
+            zx_info_cpu_sched_stats_t stats = {};
+            stats.cpu_number = i;
+            stats.flags = mp_is_cpu_online(i) ? ZX_INFO_CPU_STATS_FLAG_ONLINE : 0;
+
+            // the wait stats are updated under the thread lock on each
+            // context switch
+            {
+                Guard<spin_lock_t, IrqSave> thread_lock_guard{ThreadLock::Get()};
+
+                stats.total_run_queue_wait = cpu->run_queue_wait.total;
+                stats.max_run_queue_wait = cpu->run_queue_wait.max;
+                for (size_t b = 0; b < ZX_INFO_RUN_QUEUE_WAIT_BUCKETS; b++) {
+                    stats.run_queue_wait_histogram[b] = cpu->run_queue_wait.histogram[b];
+                }
+            }
+
+            // copy out one at a time
+            if (cpu_buf.copy_array_to_user(&stats, 1, i) != ZX_OK)
+                return ZX_ERR_INVALID_ARGS;
+        }
+
+        if (_actual) {
+            zx_status_t status = _actual.copy_to_user(num_to_copy);
+            if (status != ZX_OK)
+                return status;
+        }
+        if (_avail) {
+            zx_status_t status = _avail.copy_to_user(num_cpus);
+            if (status != ZX_OK)
+                return status;
+        }
+        return ZX_OK;
+    }
     case ZX_INFO_KMEM_STATS: {
         auto status = validate_resource(handle, ZX_RSRC_KIND_ROOT);
         if (status != ZX_OK)
@@ -528,7 +616,9 @@ zx_status_t sys_object_get_info(zx_handle_t handle, uint32_t topic,
         stats.total_bytes = total * PAGE_SIZE;
         size_t other_bytes = stats.total_bytes;
 
-        stats.free_bytes = state_count[VM_PAGE_STATE_FREE] * PAGE_SIZE;
+        // Pages sitting in the per-cpu pmm caches are free for all intents and purposes.
+        stats.free_bytes = (state_count[VM_PAGE_STATE_FREE] +
+                            state_count[VM_PAGE_STATE_CACHED]) * PAGE_SIZE;
         other_bytes -= stats.free_bytes;
 
         stats.wired_bytes = state_count[VM_PAGE_STATE_WIRED] * PAGE_SIZE;
@@ -553,6 +643,99 @@ zx_status_t sys_object_get_info(zx_handle_t handle, uint32_t topic,
         return single_record_result(
             _buffer, buffer_size, _actual, _avail, &stats, sizeof(stats));
     }
+    case ZX_INFO_KMEM_NUMA_STATS: {
+        auto status = validate_resource(handle, ZX_RSRC_KIND_ROOT);
+        if (status != ZX_OK)
+            return status;
+
+        size_t num_nodes = pmm_numa_node_count();
+        size_t num_space_for = buffer_size / sizeof(zx_info_kmem_numa_node_t);
+        size_t num_to_copy = MIN(num_nodes, num_space_for);
+
+        auto node_buf = _buffer.reinterpret<zx_info_kmem_numa_node_t>();
+        for (uint32_t i = 0; i < static_cast<uint32_t>(num_to_copy); i++) {
+            zx_info_kmem_numa_node_t node = {};
+            node.node = i;
+            node.free_bytes = pmm_count_free_pages_node(i) * PAGE_SIZE;
+            if (node_buf.copy_array_to_user(&node, 1, i) != ZX_OK)
+                return ZX_ERR_INVALID_ARGS;
+        }
+
+        if (_actual) {
+            zx_status_t status = _actual.copy_to_user(num_to_copy);
+            if (status != ZX_OK)
+                return status;
+        }
+        if (_avail) {
+            zx_status_t status = _avail.copy_to_user(num_nodes);
+            if (status != ZX_OK)
+                return status;
+        }
+        return ZX_OK;
+    }
+    case ZX_INFO_KMEM_OBJECT_CACHES: {
+        auto status = validate_resource(handle, ZX_RSRC_KIND_ROOT);
+        if (status != ZX_OK)
+            return status;
+
+        zx_info_kmem_object_cache_t caches[8];
+        size_t num_caches = GetObjectCacheInfo(caches, fbl::count_of(caches));
+        DEBUG_ASSERT(num_caches <= fbl::count_of(caches));
+        size_t num_space_for = buffer_size / sizeof(zx_info_kmem_object_cache_t);
+        size_t num_to_copy = MIN(num_caches, num_space_for);
+
+        user_out_ptr<zx_info_kmem_object_cache_t> cache_buf =
+            _buffer.reinterpret<zx_info_kmem_object_cache_t>();
+        if (cache_buf.copy_array_to_user(caches, num_to_copy) != ZX_OK)
+            return ZX_ERR_INVALID_ARGS;
+
+        if (_actual) {
+            zx_status_t status = _actual.copy_to_user(num_to_copy);
+            if (status != ZX_OK)
+                return status;
+        }
+        if (_avail) {
+            zx_status_t status = _avail.copy_to_user(num_caches);
+            if (status != ZX_OK)
+                return status;
+        }
+        return ZX_OK;
+    }
+    case ZX_INFO_SYSCALL_STATS: {
+        auto status = validate_resource(handle, ZX_RSRC_KIND_ROOT);
+        if (status != ZX_OK)
+            return status;
+
+        // Only syscalls which have been made since the last reset are listed.
+        size_t num_space_for = buffer_size / sizeof(zx_info_syscall_stats_t);
+        size_t num_copied = 0;
+        size_t num_avail = 0;
+        user_out_ptr<zx_info_syscall_stats_t> stats_buf =
+            _buffer.reinterpret<zx_info_syscall_stats_t>();
+        for (uint32_t num = 0; num < ZX_SYS_COUNT; num++) {
+            zx_info_syscall_stats_t stats;
+            if (!syscall_stats_read(num, &stats))
+                continue;
+            num_avail++;
+            if (num_copied < num_space_for) {
+                if (stats_buf.copy_array_to_user(&stats, 1, num_copied) != ZX_OK)
+                    return ZX_ERR_INVALID_ARGS;
+                num_copied++;
+            }
+        }
+
+        if (_actual) {
+            zx_status_t status = _actual.copy_to_user(num_copied);
+            if (status != ZX_OK)
+                return status;
+        }
+        if (_avail) {
+            zx_status_t status = _avail.copy_to_user(num_avail);
+            if (status != ZX_OK)
+                return status;
+        }
+        return ZX_OK;
+    }
     case ZX_INFO_RESOURCE: {
         // grab a reference to the dispatcher
         fbl::RefPtr<ResourceDispatcher> resource;
@@ -630,12 +813,71 @@ zx_status_t sys_object_get_info(zx_handle_t handle, uint32_t topic,
         return single_record_result(
             _buffer, buffer_size, _actual, _avail, &info, sizeof(info));
     }
+    case ZX_INFO_CHANNEL_STATS: {
+        fbl::RefPtr<ChannelDispatcher> channel;
+        auto status = up->GetDispatcherWithRights(handle, ZX_RIGHT_INSPECT, &channel);
+        if (status != ZX_OK)
+            return status;
+
+        zx_info_channel_stats_t info;
+        channel->GetStats(&info);
+
+        return single_record_result(
+            _buffer, buffer_size, _actual, _avail, &info, sizeof(info));
+    }
 
     default:
         return ZX_ERR_NOT_SUPPORTED;
     }
 }
 
+// Returns the records of a multi-record topic starting at |cursor|, and the
+// cursor at which to continue in |_next_cursor|. The target is walked a
+// batch at a time, without holding its locks while copying to the buffer, so
+// unlike zx_object_get_info() a process may inspect itself.
+
+// zx_status_t zx_object_get_info_paged
+zx_status_t sys_object_get_info_paged(zx_handle_t handle, uint32_t topic, uint64_t cursor,
+                                      user_out_ptr<void> _buffer, size_t buffer_size,
+                                      user_out_ptr<size_t> _actual,
+                                      user_out_ptr<uint64_t> _next_cursor) {
+    LTRACEF("handle %x topic %u cursor %#" PRIx64 "\n", handle, topic, cursor);
+
+    if (topic != ZX_INFO_PROCESS_MAPS && topic != ZX_INFO_PROCESS_VMOS)
+        return ZX_ERR_NOT_SUPPORTED;
+
+    ProcessDispatcher* up = ProcessDispatcher::GetCurrent();
+    fbl::RefPtr<ProcessDispatcher> process;
+    zx_status_t status =
+        up->GetDispatcherWithRights(handle, ZX_RIGHT_INSPECT, &process);
+    if (status != ZX_OK)
+        return status;
+
+    size_t count = 0;
+    uint64_t next_cursor = cursor;
+    if (topic == ZX_INFO_PROCESS_MAPS) {
+        status = process->GetAspaceMapsPaged(
+            cursor, _buffer.reinterpret<zx_info_maps_t>(),
+            buffer_size / sizeof(zx_info_maps_t), &count, &next_cursor);
+    } else {
+        status = process->GetVmosPaged(
+            cursor, _buffer.reinterpret<zx_info_vmo_t>(),
+            buffer_size / sizeof(zx_info_vmo_t), &count, &next_cursor);
+    }
+
+    if (_actual) {
+        zx_status_t status = _actual.copy_to_user(count);
+        if (status != ZX_OK)
+            return status;
+    }
+    if (_next_cursor) {
+        zx_status_t status = _next_cursor.copy_to_user(next_cursor);
+        if (status != ZX_OK)
+            return status;
+    }
+    return status;
+}
+
 // zx_status_t zx_object_get_property
 zx_status_t sys_object_get_property(zx_handle_t handle_value, uint32_t property,
                                     user_out_ptr<void> _value, size_t size) {
@@ -729,6 +971,24 @@ zx_status_t sys_object_get_property(zx_handle_t handle_value, uint32_t property,
         size_t value = socket->GetWriteThreshold();
         return _value.reinterpret<size_t>().copy_to_user(value);
     }
+    case ZX_PROP_FIFO_RX_THRESHOLD: {
+        if (size < sizeof(size_t))
+            return ZX_ERR_BUFFER_TOO_SMALL;
+        auto fifo = DownCastDispatcher<FifoDispatcher>(&dispatcher);
+        if (!fifo)
+            return ZX_ERR_WRONG_TYPE;
+        size_t value = fifo->GetReadThreshold();
+        return _value.reinterpret<size_t>().copy_to_user(value);
+    }
+    case ZX_PROP_FIFO_TX_THRESHOLD: {
+        if (size < sizeof(size_t))
+            return ZX_ERR_BUFFER_TOO_SMALL;
+        auto fifo = DownCastDispatcher<FifoDispatcher>(&dispatcher);
+        if (!fifo)
+            return ZX_ERR_WRONG_TYPE;
+        size_t value = fifo->GetWriteThreshold();
+        return _value.reinterpret<size_t>().copy_to_user(value);
+    }
     case ZX_PROP_CHANNEL_TX_MSG_MAX: {
         if (size < sizeof(size_t)) {
             return ZX_ERR_BUFFER_TOO_SMALL;
@@ -740,6 +1000,15 @@ zx_status_t sys_object_get_property(zx_handle_t handle_value, uint32_t property,
         size_t depth = channel->TxMessageMax();
         return _value.reinterpret<size_t>().copy_to_user(depth);
     }
+    case ZX_PROP_THREAD_TIMER_SLACK: {
+        if (size < sizeof(zx_duration_t))
+            return ZX_ERR_BUFFER_TOO_SMALL;
+        auto thread = DownCastDispatcher<ThreadDispatcher>(&dispatcher);
+        if (!thread)
+            return ZX_ERR_WRONG_TYPE;
+        zx_duration_t value = thread->GetTimerSlack();
+        return _value.reinterpret<zx_duration_t>().copy_to_user(value);
+    }
     default:
         return ZX_ERR_INVALID_ARGS;
     }
@@ -826,6 +1095,18 @@ zx_status_t sys_object_set_property(zx_handle_t handle_value, uint32_t property,
             return status;
         return process->set_debug_addr(value);
     }
+    case ZX_PROP_SOCKET_RX_BUF_MAX: {
+        if (size < sizeof(size_t))
+            return ZX_ERR_BUFFER_TOO_SMALL;
+        auto socket = DownCastDispatcher<SocketDispatcher>(&dispatcher);
+        if (!socket)
+            return ZX_ERR_WRONG_TYPE;
+        size_t value = 0;
+        zx_status_t status = _value.reinterpret<const size_t>().copy_from_user(&value);
+        if (status != ZX_OK)
+            return status;
+        return socket->SetReceiveBufferMax(value);
+    }
     case ZX_PROP_SOCKET_RX_THRESHOLD: {
         if (size < sizeof(size_t))
             return ZX_ERR_BUFFER_TOO_SMALL;
@@ -850,6 +1131,45 @@ zx_status_t sys_object_set_property(zx_handle_t handle_value, uint32_t property,
             return status;
         return socket->SetWriteThreshold(value);
     }
+    case ZX_PROP_FIFO_RX_THRESHOLD: {
+        if (size < sizeof(size_t))
+            return ZX_ERR_BUFFER_TOO_SMALL;
+        auto fifo = DownCastDispatcher<FifoDispatcher>(&dispatcher);
+        if (!fifo)
+            return ZX_ERR_WRONG_TYPE;
+        size_t value = 0;
+        zx_status_t status = _value.reinterpret<const size_t>().copy_from_user(&value);
+        if (status != ZX_OK)
+            return status;
+        return fifo->SetReadThreshold(value);
+    }
+    case ZX_PROP_FIFO_TX_THRESHOLD: {
+        if (size < sizeof(size_t))
+            return ZX_ERR_BUFFER_TOO_SMALL;
+        auto fifo = DownCastDispatcher<FifoDispatcher>(&dispatcher);
+        if (!fifo)
+            return ZX_ERR_WRONG_TYPE;
+        size_t value = 0;
+        zx_status_t status = _value.reinterpret<const size_t>().copy_from_user(&value);
+        if (status != ZX_OK)
+            return status;
+        return fifo->SetWriteThreshold(value);
+    }
+    case ZX_PROP_THREAD_TIMER_SLACK: {
+        if (size < sizeof(zx_duration_t))
+            return ZX_ERR_BUFFER_TOO_SMALL;
+        auto thread = DownCastDispatcher<ThreadDispatcher>(&dispatcher);
+        if (!thread)
+            return ZX_ERR_WRONG_TYPE;
+        zx_duration_t value = 0;
+        zx_status_t status = _value.reinterpret<const zx_duration_t>().copy_from_user(&value);
+        if (status != ZX_OK)
+            return status;
+        if (value < 0)
+            return ZX_ERR_INVALID_ARGS;
+        thread->SetTimerSlack(value);
+        return ZX_OK;
+    }
     case ZX_PROP_JOB_KILL_ON_OOM: {
         auto job = DownCastDispatcher<JobDispatcher>(&dispatcher);
         if (!job)
@@ -900,6 +1220,69 @@ zx_status_t sys_object_signal_peer(zx_handle_t handle_value, uint32_t clear_mask
     return dispatcher->user_signal_peer(clear_mask, set_mask);
 }
 
+// zx_status_t zx_object_signal_many
+zx_status_t sys_object_signal_many(user_in_ptr<const zx_signal_item_t> user_items, size_t count,
+                                   user_out_ptr<size_t> actual_out) {
+    LTRACEF("count %zu\n", count);
+
+    if (count > ZX_SIGNAL_MANY_MAX_ITEMS)
+        return ZX_ERR_OUT_OF_RANGE;
+
+    zx_signal_item_t items[ZX_SIGNAL_MANY_MAX_ITEMS];
+    if (user_items.copy_array_from_user(items, count) != ZX_OK)
+        return ZX_ERR_INVALID_ARGS;
+
+    for (size_t ix = 0; ix != count; ++ix) {
+        if (items[ix].options & ~ZX_SIGNAL_ITEM_PEER)
+            return ZX_ERR_INVALID_ARGS;
+    }
+
+    // Look up every handle before signaling anything, so that a bad handle
+    // leaves all the objects untouched.
+    fbl::RefPtr<Dispatcher> dispatchers[ZX_SIGNAL_MANY_MAX_ITEMS];
+    {
+        auto up = ProcessDispatcher::GetCurrent();
+        Guard<fbl::Mutex> guard{up->handle_table_lock()};
+
+        for (size_t ix = 0; ix != count; ++ix) {
+            Handle* handle = up->GetHandleLocked(items[ix].handle);
+            if (!handle)
+                return ZX_ERR_BAD_HANDLE;
+            const zx_rights_t right = (items[ix].options & ZX_SIGNAL_ITEM_PEER) ?
+                ZX_RIGHT_SIGNAL_PEER : ZX_RIGHT_SIGNAL;
+            if (!handle->HasRights(right))
+                return ZX_ERR_ACCESS_DENIED;
+            dispatchers[ix] = handle->dispatcher();
+        }
+    }
+
+    // Threads woken along the way only get to run once every item has been
+    // applied, so the whole batch ends in at most one reschedule.
+    size_t applied = 0;
+    zx_status_t status = ZX_OK;
+    {
+        AutoReschedDisable resched_disable;
+        resched_disable.Disable();
+
+        for (; applied != count; ++applied) {
+            const zx_signal_item_t& item = items[applied];
+            status = (item.options & ZX_SIGNAL_ITEM_PEER) ?
+                dispatchers[applied]->user_signal_peer(item.clear_mask, item.set_mask) :
+                dispatchers[applied]->user_signal_self(item.clear_mask, item.set_mask);
+            if (status != ZX_OK)
+                break;
+        }
+    }
+
+    if (actual_out) {
+        zx_status_t copy_status = actual_out.copy_to_user(applied);
+        if (copy_status != ZX_OK)
+            return copy_status;
+    }
+
+    return status;
+}
+
 // Given a kernel object with children objects, obtain a handle to the
 // child specified by the provided kernel object id.
 // zx_status_t zx_object_get_child
@@ -0,0 +1,119 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <err.h>
+#include <inttypes.h>
+#include <trace.h>
+
+#include <object/handle.h>
+#include <object/pager_dispatcher.h>
+#include <object/port_dispatcher.h>
+#include <object/process_dispatcher.h>
+#include <object/vm_object_dispatcher.h>
+
+#include <fbl/ref_ptr.h>
+#include <vm/vm.h>
+
+#include "priv.h"
+
+#define LOCAL_TRACE 0
+
+// zx_status_t zx_pager_create
+zx_status_t sys_pager_create(uint32_t options, user_out_handle* out) {
+    if (options) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+
+    fbl::RefPtr<Dispatcher> dispatcher;
+    zx_rights_t rights;
+    zx_status_t status = PagerDispatcher::Create(&dispatcher, &rights);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    return out->make(fbl::move(dispatcher), rights);
+}
+
+// zx_status_t zx_pager_create_vmo
+zx_status_t sys_pager_create_vmo(zx_handle_t pager, zx_handle_t port, uint64_t key,
+                                 uint64_t size, uint32_t options, user_out_handle* out) {
+    LTRACEF("pager %x port %x key %#" PRIx64 " size %#" PRIx64 "\n", pager, port, key, size);
+
+    if (options) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+
+    auto up = ProcessDispatcher::GetCurrent();
+    zx_status_t status = up->QueryPolicy(ZX_POL_NEW_VMO);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    fbl::RefPtr<PagerDispatcher> pager_dispatcher;
+    status = up->GetDispatcher(pager, &pager_dispatcher);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    fbl::RefPtr<PortDispatcher> port_dispatcher;
+    status = up->GetDispatcherWithRights(port, ZX_RIGHT_WRITE, &port_dispatcher);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    fbl::RefPtr<VmObject> vmo;
+    status = pager_dispatcher->CreateVmo(fbl::move(port_dispatcher), key, size, &vmo);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    fbl::RefPtr<Dispatcher> dispatcher;
+    zx_rights_t rights;
+    status = VmObjectDispatcher::Create(fbl::move(vmo), &dispatcher, &rights);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    return out->make(fbl::move(dispatcher), rights);
+}
+
+// zx_status_t zx_pager_supply_pages
+zx_status_t sys_pager_supply_pages(zx_handle_t pager, zx_handle_t pager_vmo, uint64_t offset,
+                                   uint64_t length, zx_handle_t aux_vmo_handle,
+                                   uint64_t aux_offset) {
+    LTRACEF("pager %x pager_vmo %x offset %#" PRIx64 " length %#" PRIx64 "\n",
+            pager, pager_vmo, offset, length);
+
+    auto up = ProcessDispatcher::GetCurrent();
+
+    fbl::RefPtr<PagerDispatcher> pager_dispatcher;
+    zx_status_t status = up->GetDispatcherWithRights(pager, ZX_RIGHT_WRITE, &pager_dispatcher);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    // supplying pages changes the contents of the pager vmo
+    fbl::RefPtr<VmObjectDispatcher> pager_vmo_dispatcher;
+    status = up->GetDispatcherWithRights(pager_vmo, ZX_RIGHT_WRITE, &pager_vmo_dispatcher);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    // the pages are moved out of the aux vmo, which reads as zeroes afterwards
+    fbl::RefPtr<VmObjectDispatcher> aux_vmo_dispatcher;
+    status = up->GetDispatcherWithRights(aux_vmo_handle, ZX_RIGHT_READ | ZX_RIGHT_WRITE,
+                                         &aux_vmo_dispatcher);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    if (!IS_PAGE_ALIGNED(offset) || !IS_PAGE_ALIGNED(length) || !IS_PAGE_ALIGNED(aux_offset)) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+
+    return pager_dispatcher->SupplyPages(pager_vmo_dispatcher->vmo().get(), offset, length,
+                                         aux_vmo_dispatcher->vmo().get(), aux_offset);
+}
@@ -13,6 +13,7 @@
 #include <object/port_dispatcher.h>
 #include <object/process_dispatcher.h>
 
+#include <fbl/algorithm.h>
 #include <fbl/alloc_checker.h>
 #include <fbl/ref_ptr.h>
 
@@ -94,6 +95,59 @@ zx_status_t sys_port_wait(zx_handle_t handle, zx_time_t deadline,
     return ZX_OK;
 }
 
+// zx_status_t zx_port_wait_many
+zx_status_t sys_port_wait_many(zx_handle_t handle, zx_time_t deadline,
+                               user_out_ptr<zx_port_packet_t> packets_out, size_t count,
+                               user_out_ptr<size_t> actual_out) {
+    LTRACEF("handle %x count %zu\n", handle, count);
+
+    if (count == 0u)
+        return ZX_ERR_INVALID_ARGS;
+
+    auto up = ProcessDispatcher::GetCurrent();
+
+    fbl::RefPtr<PortDispatcher> port;
+    zx_status_t status = up->GetDispatcherWithRights(handle, ZX_RIGHT_READ, &port);
+    if (status != ZX_OK)
+        return status;
+
+    ktrace(TAG_PORT_WAIT, (uint32_t)port->get_koid(), 0, 0, 0);
+
+    // Only the first batch waits for |deadline|; the following ones just
+    // drain whatever is already queued.
+    zx_port_packet_t pp[PortDispatcher::kMaxDequeueCount];
+    size_t total = 0u;
+    zx_status_t st = ZX_OK;
+    while (total < count) {
+        size_t batch = fbl::min(count - total, PortDispatcher::kMaxDequeueCount);
+        size_t dequeued = 0u;
+        st = port->DequeueMany(total == 0u ? deadline : 0, pp, batch, &dequeued);
+        if (st != ZX_OK)
+            break;
+
+        status = packets_out.copy_array_to_user(pp, dequeued, total);
+        if (status != ZX_OK)
+            return status;
+        total += dequeued;
+
+        if (dequeued < batch)
+            break;
+    }
+
+    ktrace(TAG_PORT_WAIT_DONE, (uint32_t)port->get_koid(), st, 0, 0);
+
+    if (total == 0u)
+        return st;
+
+    if (actual_out) {
+        status = actual_out.copy_to_user(total);
+        if (status != ZX_OK)
+            return status;
+    }
+
+    return ZX_OK;
+}
+
 // zx_status_t zx_port_cancel
 zx_status_t sys_port_cancel(zx_handle_t handle, zx_handle_t source, uint64_t key) {
     auto up = ProcessDispatcher::GetCurrent();
@@ -32,10 +32,12 @@ MODULE_SRCS := \
     $(LOCAL_DIR)/zircon.cpp \
     $(LOCAL_DIR)/object.cpp \
     $(LOCAL_DIR)/object_wait.cpp \
+    $(LOCAL_DIR)/pager.cpp \
     $(LOCAL_DIR)/port.cpp \
     $(LOCAL_DIR)/profile.cpp \
     $(LOCAL_DIR)/resource.cpp \
     $(LOCAL_DIR)/socket.cpp \
+    $(LOCAL_DIR)/syscall_stats.cpp \
     $(LOCAL_DIR)/system.cpp \
     $(LOCAL_DIR)/task.cpp \
     $(LOCAL_DIR)/test.cpp \
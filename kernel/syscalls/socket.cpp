@@ -124,6 +124,80 @@ zx_status_t sys_socket_read(zx_handle_t handle, uint32_t options,
     return status;
 }
 
+// zx_status_t zx_socket_writev
+zx_status_t sys_socket_writev(zx_handle_t handle, uint32_t options,
+                              user_in_ptr<const zx_iovec_t> user_iov, size_t iov_count,
+                              user_out_ptr<size_t> actual) {
+    LTRACEF("handle %x iov_count %zu\n", handle, iov_count);
+
+    if (options != 0u)
+        return ZX_ERR_INVALID_ARGS;
+    if (iov_count > ZX_SOCKET_IOV_MAX)
+        return ZX_ERR_OUT_OF_RANGE;
+
+    // Only the descriptors are copied in here; the data they point to is
+    // copied straight from the caller's buffers into the socket.
+    zx_iovec_t iov[ZX_SOCKET_IOV_MAX];
+    if (user_iov.copy_array_from_user(iov, iov_count) != ZX_OK)
+        return ZX_ERR_INVALID_ARGS;
+    for (size_t i = 0; i < iov_count; i++) {
+        if (iov[i].capacity > 0u && !iov[i].buffer)
+            return ZX_ERR_INVALID_ARGS;
+    }
+
+    auto up = ProcessDispatcher::GetCurrent();
+
+    fbl::RefPtr<SocketDispatcher> socket;
+    zx_status_t status = up->GetDispatcherWithRights(handle, ZX_RIGHT_WRITE, &socket);
+    if (status != ZX_OK)
+        return status;
+
+    size_t nwritten;
+    status = socket->WriteV(iov, iov_count, &nwritten);
+
+    // Caller may ignore results if desired.
+    if (status == ZX_OK && actual)
+        status = actual.copy_to_user(nwritten);
+
+    return status;
+}
+
+// zx_status_t zx_socket_readv
+zx_status_t sys_socket_readv(zx_handle_t handle, uint32_t options,
+                             user_in_ptr<const zx_iovec_t> user_iov, size_t iov_count,
+                             user_out_ptr<size_t> actual) {
+    LTRACEF("handle %x iov_count %zu\n", handle, iov_count);
+
+    if (options != 0u)
+        return ZX_ERR_INVALID_ARGS;
+    if (iov_count > ZX_SOCKET_IOV_MAX)
+        return ZX_ERR_OUT_OF_RANGE;
+
+    zx_iovec_t iov[ZX_SOCKET_IOV_MAX];
+    if (user_iov.copy_array_from_user(iov, iov_count) != ZX_OK)
+        return ZX_ERR_INVALID_ARGS;
+    for (size_t i = 0; i < iov_count; i++) {
+        if (iov[i].capacity > 0u && !iov[i].buffer)
+            return ZX_ERR_INVALID_ARGS;
+    }
+
+    auto up = ProcessDispatcher::GetCurrent();
+
+    fbl::RefPtr<SocketDispatcher> socket;
+    zx_status_t status = up->GetDispatcherWithRights(handle, ZX_RIGHT_READ, &socket);
+    if (status != ZX_OK)
+        return status;
+
+    size_t nread;
+    status = socket->ReadV(iov, iov_count, &nread);
+
+    // Caller may ignore results if desired.
+    if (status == ZX_OK && actual)
+        status = actual.copy_to_user(nread);
+
+    return status;
+}
+
 // zx_status_t zx_socket_share
 zx_status_t sys_socket_share(zx_handle_t handle, zx_handle_t other) {
     auto up = ProcessDispatcher::GetCurrent();
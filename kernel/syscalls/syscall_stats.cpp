@@ -0,0 +1,169 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include "syscall_stats.h"
+
+#include <arch/ops.h>
+#include <debug.h>
+#include <fbl/algorithm.h>
+#include <fbl/alloc_checker.h>
+#include <fbl/mutex.h>
+#include <inttypes.h>
+#include <kernel/cmdline.h>
+#include <kernel/lockdep.h>
+#include <lib/console.h>
+#include <lk/init.h>
+#include <string.h>
+#include <zircon/time.h>
+#include <zircon/zx-syscall-numbers.h>
+
+namespace {
+
+struct SyscallStats {
+    uint64_t calls;
+    zx_duration_t total_time;
+    zx_duration_t max_time;
+    uint64_t histogram[ZX_INFO_SYSCALL_LATENCY_BUCKETS];
+};
+
+DECLARE_SINGLETON_MUTEX(SyscallStatsLock);
+
+// ZX_SYS_COUNT entries for each cpu, allocated the first time recording is
+// turned on.
+SyscallStats* stats_table = nullptr;
+size_t stats_cpu_count = 0;
+
+SyscallStats* get_table() {
+    return __atomic_load_n(&stats_table, __ATOMIC_ACQUIRE);
+}
+
+uint latency_bucket(zx_duration_t duration) {
+    if (duration < 128) {
+        return 0;
+    }
+    return fbl::min(64u - __builtin_clzll(static_cast<uint64_t>(duration) >> 7),
+                    ZX_INFO_SYSCALL_LATENCY_BUCKETS - 1);
+}
+
+} // namespace
+
+bool syscall_stats_enabled = false;
+
+zx_status_t syscall_stats_set_enabled(bool enabled) {
+    Guard<fbl::Mutex> guard{SyscallStatsLock::Get()};
+    if (enabled && stats_table == nullptr) {
+        size_t cpu_count = arch_max_num_cpus();
+        fbl::AllocChecker ac;
+        SyscallStats* table = new (&ac) SyscallStats[cpu_count * ZX_SYS_COUNT]();
+        if (!ac.check()) {
+            return ZX_ERR_NO_MEMORY;
+        }
+        stats_cpu_count = cpu_count;
+        // Pairs with get_table(), so that recording never sees the table
+        // before it is zeroed.
+        __atomic_store_n(&stats_table, table, __ATOMIC_RELEASE);
+    }
+    __atomic_store_n(&syscall_stats_enabled, enabled, __ATOMIC_RELAXED);
+    return ZX_OK;
+}
+
+void syscall_stats_record(uint64_t syscall_num, zx_duration_t duration) {
+    DEBUG_ASSERT(arch_ints_disabled());
+
+    SyscallStats* table = get_table();
+    cpu_num_t cpu = arch_curr_cpu_num();
+    if (table == nullptr || syscall_num >= ZX_SYS_COUNT || cpu >= stats_cpu_count) {
+        return;
+    }
+
+    // Only this cpu writes its entries, with interrupts disabled, so plain
+    // updates suffice. Readers may see a torn set of fields, but not a
+    // torn field.
+    SyscallStats* s = &table[cpu * ZX_SYS_COUNT + syscall_num];
+    s->calls++;
+    s->total_time = zx_duration_add_duration(s->total_time, duration);
+    s->max_time = fbl::max(s->max_time, duration);
+    s->histogram[latency_bucket(duration)]++;
+}
+
+bool syscall_stats_read(uint32_t syscall_num, zx_info_syscall_stats_t* info) {
+    *info = {};
+    info->syscall_num = syscall_num;
+
+    const SyscallStats* table = get_table();
+    if (table == nullptr || syscall_num >= ZX_SYS_COUNT) {
+        return false;
+    }
+    for (size_t cpu = 0; cpu < stats_cpu_count; cpu++) {
+        const SyscallStats* s = &table[cpu * ZX_SYS_COUNT + syscall_num];
+        info->calls += s->calls;
+        info->total_time = zx_duration_add_duration(info->total_time, s->total_time);
+        info->max_time = fbl::max(info->max_time, s->max_time);
+        for (size_t b = 0; b < ZX_INFO_SYSCALL_LATENCY_BUCKETS; b++) {
+            info->latency_histogram[b] += s->histogram[b];
+        }
+    }
+    return info->calls != 0;
+}
+
+static void syscall_stats_reset() {
+    Guard<fbl::Mutex> guard{SyscallStatsLock::Get()};
+    if (stats_table != nullptr) {
+        // Calls recorded while this runs may be lost or half-cleared.
+        memset(stats_table, 0, sizeof(SyscallStats) * stats_cpu_count * ZX_SYS_COUNT);
+    }
+}
+
+static void syscall_stats_init(uint level) {
+    if (cmdline_get_bool("kernel.syscall-stats", false)) {
+        if (syscall_stats_set_enabled(true) != ZX_OK) {
+            dprintf(INFO, "syscalls: no memory for syscall stats\n");
+        }
+    }
+}
+
+LK_INIT_HOOK(syscall_stats, &syscall_stats_init, LK_INIT_LEVEL_USER);
+
+static void syscall_stats_dump() {
+    printf("syscall stats are %s\n",
+           __atomic_load_n(&syscall_stats_enabled, __ATOMIC_RELAXED) ? "enabled" : "disabled");
+    printf("%5s %12s %12s %12s\n", "num", "calls", "avg ns", "max ns");
+    for (uint32_t num = 0; num < ZX_SYS_COUNT; num++) {
+        zx_info_syscall_stats_t info;
+        if (!syscall_stats_read(num, &info)) {
+            continue;
+        }
+        printf("%5u %12" PRIu64 " %12" PRIi64 " %12" PRIi64 "\n", num, info.calls,
+               info.total_time / static_cast<zx_duration_t>(info.calls), info.max_time);
+    }
+}
+
+static int cmd_syscalls(int argc, const cmd_args* argv, uint32_t flags) {
+    if (argc < 2) {
+        syscall_stats_dump();
+        return ZX_OK;
+    }
+
+    if (!strcmp(argv[1].str, "enable")) {
+        return syscall_stats_set_enabled(true);
+    } else if (!strcmp(argv[1].str, "disable")) {
+        return syscall_stats_set_enabled(false);
+    } else if (!strcmp(argv[1].str, "reset")) {
+        syscall_stats_reset();
+        return ZX_OK;
+    }
+
+    printf("usage:\n");
+    printf("%s           show call counts and latencies by syscall number\n", argv[0].str);
+    printf("%s enable    start recording syscall stats\n", argv[0].str);
+    printf("%s disable   stop recording syscall stats\n", argv[0].str);
+    printf("%s reset     clear the recorded syscall stats\n", argv[0].str);
+    return ZX_ERR_INTERNAL;
+}
+
+STATIC_COMMAND_START
+STATIC_COMMAND("syscalls", "per-syscall call counts and latencies\n", &cmd_syscalls)
+STATIC_COMMAND_END(syscalls);
@@ -0,0 +1,32 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <stdint.h>
+#include <zircon/compiler.h>
+#include <zircon/syscalls/object.h>
+#include <zircon/types.h>
+
+// Per-syscall call counts and latency histograms, kept per cpu.
+//
+// Recording is off unless kernel.syscall-stats is set on the command line
+// or the "syscalls" console command turns it on. While it is off the
+// dispatch path only tests |syscall_stats_enabled|, which is read and written
+// with relaxed atomics. Turning it on for the first time allocates the per-cpu
+// tables, which are never freed.
+
+extern bool syscall_stats_enabled;
+
+zx_status_t syscall_stats_set_enabled(bool enabled);
+
+// Records one call of |syscall_num| which took |duration|, on the current
+// cpu. Interrupts must be disabled.
+void syscall_stats_record(uint64_t syscall_num, zx_duration_t duration);
+
+// Fills |info| with the sum over all cpus of the statistics for
+// |syscall_num|. Returns false if it has never been recorded.
+bool syscall_stats_read(uint32_t syscall_num, zx_info_syscall_stats_t* info);
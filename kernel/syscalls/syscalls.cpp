@@ -13,12 +13,14 @@
 #include <platform.h>
 #include <syscalls/syscalls.h>
 #include <trace.h>
+#include <zircon/time.h>
 #include <zircon/zx-syscall-numbers.h>
 
 #include <inttypes.h>
 #include <stdint.h>
 
 #include "priv.h"
+#include "syscall_stats.h"
 #include "vdso-valid-sysret.h"
 
 #define LOCAL_TRACE 0
@@ -42,6 +44,9 @@ inline syscall_result do_syscall(uint64_t syscall_num, uint64_t pc,
 
     CPU_STATS_INC(syscalls);
 
+    const zx_time_t stats_start =
+        unlikely(__atomic_load_n(&syscall_stats_enabled, __ATOMIC_RELAXED)) ? current_time() : 0;
+
     /* re-enable interrupts to maintain kernel preemptiveness
        This must be done after the above ktrace_tiny call, and after the
        above CPU_STATS_INC call as it also calls arch_curr_cpu_num. */
@@ -66,6 +71,10 @@ inline syscall_result do_syscall(uint64_t syscall_num, uint64_t pc,
        This must be done before the below ktrace_tiny call. */
     arch_disable_ints();
 
+    if (unlikely(stats_start != 0)) {
+        syscall_stats_record(syscall_num, zx_time_sub_time(current_time(), stats_start));
+    }
+
     ktrace_tiny(TAG_SYSCALL_EXIT, (static_cast<uint32_t>(syscall_num << 8)) | arch_curr_cpu_num());
 
     // The assembler caller will re-disable interrupts at the appropriate time.
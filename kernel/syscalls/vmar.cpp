@@ -131,10 +131,22 @@ zx_status_t sys_vmar_map(zx_handle_t vmar_handle, zx_vm_option_t options,
         options &= ~ZX_VM_MAP_RANGE;
     }
 
-    if (do_map_range && (options & ZX_VM_SPECIFIC_OVERWRITE)) {
+    bool do_commit = false;
+    if (options & ZX_VM_COMMIT) {
+        do_commit = true;
+        options &= ~ZX_VM_COMMIT;
+    }
+
+    if ((do_map_range || do_commit) && (options & ZX_VM_SPECIFIC_OVERWRITE)) {
         return ZX_ERR_INVALID_ARGS;
     }
 
+    // Pages of a pager-backed VMO can only be supplied asynchronously, which
+    // committing them here has no way to wait for.
+    if (do_commit && vmo->vmo()->is_pager_backed()) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+
     // Usermode is not allowed to specify these flags on mappings, though we may
     // set them below.
     if (options & (ZX_VM_CAN_MAP_READ | ZX_VM_CAN_MAP_WRITE | ZX_VM_CAN_MAP_EXECUTE)) {
@@ -174,8 +186,9 @@ zx_status_t sys_vmar_map(zx_handle_t vmar_handle, zx_vm_option_t options,
         vm_mapping->Destroy();
     });
 
-    if (do_map_range) {
-        status = vm_mapping->MapRange(vmo_offset, len, false);
+    // MapRange() takes an offset into the mapping, which starts at |vmo_offset|.
+    if (do_map_range || do_commit) {
+        status = vm_mapping->MapRange(0, len, do_commit);
         if (status != ZX_OK) {
             return status;
         }
@@ -8,6 +8,7 @@
 #include <inttypes.h>
 #include <trace.h>
 
+#include <vm/pmm.h>
 #include <vm/vm_object.h>
 #include <vm/vm_object_paged.h>
 
@@ -42,6 +43,16 @@ zx_status_t sys_vmo_create(uint64_t size, uint32_t options,
                            user_out_handle* out) {
     LTRACEF("size %#" PRIx64 "\n", size);
 
+    uint32_t pmm_alloc_flags = PMM_ALLOC_FLAG_ANY;
+    if (options & ZX_VMO_PREFER_NUMA_NODE) {
+        uint32_t node = (options & ZX_VMO_NUMA_NODE_MASK) >> ZX_VMO_NUMA_NODE_SHIFT;
+        if (node >= pmm_numa_node_count()) {
+            return ZX_ERR_INVALID_ARGS;
+        }
+        pmm_alloc_flags = PMM_ALLOC_FLAG_NODE(node);
+        options &= ~(ZX_VMO_PREFER_NUMA_NODE | ZX_VMO_NUMA_NODE_MASK);
+    }
+
     switch (options) {
     case 0: options = VmObjectPaged::kResizable; break;
     case ZX_VMO_NON_RESIZABLE: options = 0u; break;
@@ -55,7 +66,7 @@ zx_status_t sys_vmo_create(uint64_t size, uint32_t options,
 
     // create a vm object
     fbl::RefPtr<VmObject> vmo;
-    res = VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, options, size, &vmo);
+    res = VmObjectPaged::Create(pmm_alloc_flags, options, size, &vmo);
     if (res != ZX_OK)
         return res;
 
@@ -144,6 +155,32 @@ zx_status_t sys_vmo_write(zx_handle_t handle, user_in_ptr<const void> _data,
     return vmo->Write(_data, len, offset);
 }
 
+// zx_status_t zx_vmo_transfer_data
+zx_status_t sys_vmo_transfer_data(zx_handle_t dst_handle, uint32_t options, uint64_t offset,
+                                  uint64_t length, zx_handle_t src_handle, uint64_t src_offset) {
+    LTRACEF("dst %x, options %#x, offset %#" PRIx64 ", length %#" PRIx64
+            ", src %x, src_offset %#" PRIx64 "\n",
+            dst_handle, options, offset, length, src_handle, src_offset);
+
+    auto up = ProcessDispatcher::GetCurrent();
+
+    fbl::RefPtr<VmObjectDispatcher> dst;
+    zx_status_t status = up->GetDispatcherWithRights(dst_handle, ZX_RIGHT_WRITE, &dst);
+    if (status != ZX_OK)
+        return status;
+
+    // moving pages out of the source leaves the range reading as zeroes
+    zx_rights_t src_rights = ZX_RIGHT_READ;
+    if (options & ZX_VMO_TRANSFER_MOVE)
+        src_rights |= ZX_RIGHT_WRITE;
+    fbl::RefPtr<VmObjectDispatcher> src;
+    status = up->GetDispatcherWithRights(src_handle, src_rights, &src);
+    if (status != ZX_OK)
+        return status;
+
+    return dst->TransferData(options, offset, length, src->vmo().get(), src_offset);
+}
+
 // zx_status_t zx_vmo_get_size
 zx_status_t sys_vmo_get_size(zx_handle_t handle, user_out_ptr<uint64_t> _size) {
     LTRACEF("handle %x, sizep %p\n", handle, _size.get());
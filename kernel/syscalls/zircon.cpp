@@ -15,9 +15,11 @@
 
 #include <explicit-memory/bytes.h>
 #include <kernel/auto_lock.h>
+#include <kernel/spinlock.h>
 #include <kernel/thread.h>
 #include <lib/crypto/global_prng.h>
 #include <lib/user_copy/user_ptr.h>
+#include <lib/vdso.h>
 #include <object/event_dispatcher.h>
 #include <object/event_pair_dispatcher.h>
 #include <object/handle.h>
@@ -41,6 +43,11 @@
 constexpr size_t kMaxCPRNGDraw = ZX_CPRNG_DRAW_MAX_LEN;
 constexpr size_t kMaxCPRNGSeed = ZX_CPRNG_ADD_ENTROPY_MAX_LEN;
 
+// A batched debuglog read returns at most about a log's worth of records,
+// copied out through a bounce buffer of this size.
+constexpr size_t kMaxDebuglogRead = 128 * 1024;
+constexpr size_t kDebuglogReadChunk = 1024;
+
 // zx_status_t zx_nanosleep
 zx_status_t sys_nanosleep(zx_time_t deadline) {
     LTRACEF("nseconds %" PRIi64 "\n", deadline);
@@ -63,7 +70,10 @@ zx_status_t sys_nanosleep(zx_time_t deadline) {
 // update pvclock too.
 fbl::atomic<int64_t> utc_offset;
 
-zx_time_t sys_clock_get(zx_clock_t clock_id) {
+// Serializes zx_clock_adjust's updates of utc_offset and the vDSO's copy.
+DECLARE_SINGLETON_SPINLOCK(UtcOffsetLock);
+
+zx_time_t sys_clock_get_via_kernel(zx_clock_t clock_id) {
     switch (clock_id) {
     case ZX_CLOCK_MONOTONIC:
         return current_time();
@@ -97,7 +107,7 @@ zx_status_t sys_clock_get_new(zx_clock_t clock_id, user_out_ptr<zx_time_t> out_t
     return out_time.copy_to_user(time);
 }
 
-zx_time_t sys_clock_get_monotonic() {
+zx_time_t sys_clock_get_monotonic_via_kernel() {
     return current_time();
 }
 
@@ -112,9 +122,13 @@ zx_status_t sys_clock_adjust(zx_handle_t hrsrc, zx_clock_t clock_id, int64_t off
     switch (clock_id) {
     case ZX_CLOCK_MONOTONIC:
         return ZX_ERR_ACCESS_DENIED;
-    case ZX_CLOCK_UTC:
+    case ZX_CLOCK_UTC: {
+        // The vDSO reads its own copy of the offset, so keep the two in step.
+        Guard<SpinLock, IrqSave> guard{UtcOffsetLock::Get()};
         utc_offset.store(offset);
+        VDso::SetUtcOffset(offset);
         return ZX_OK;
+    }
     default:
         return ZX_ERR_INVALID_ARGS;
     }
@@ -225,7 +239,7 @@ zx_status_t sys_debuglog_read(zx_handle_t log_handle, uint32_t options,
                               user_out_ptr<void> ptr, size_t len) {
     LTRACEF("log handle %x, opt %x, ptr 0x%p, len %zu\n", log_handle, options, ptr.get(), len);
 
-    if (options != 0)
+    if (options & ~ZX_LOG_READ_BATCH)
         return ZX_ERR_INVALID_ARGS;
 
     auto up = ProcessDispatcher::GetCurrent();
@@ -235,15 +249,40 @@ zx_status_t sys_debuglog_read(zx_handle_t log_handle, uint32_t options,
     if (status != ZX_OK)
         return status;
 
-    char buf[DLOG_MAX_RECORD];
-    size_t actual;
-    if ((status = log->Read(options, buf, DLOG_MAX_RECORD, &actual)) < 0)
-        return status;
+    if (!(options & ZX_LOG_READ_BATCH)) {
+        char buf[DLOG_MAX_RECORD];
+        size_t actual;
+        if ((status = log->Read(options, buf, DLOG_MAX_RECORD, &actual)) < 0)
+            return status;
 
-    if (ptr.copy_array_to_user(buf, actual) != ZX_OK)
-        return ZX_ERR_INVALID_ARGS;
+        if (ptr.copy_array_to_user(buf, actual) != ZX_OK)
+            return ZX_ERR_INVALID_ARGS;
+
+        return static_cast<zx_status_t>(actual);
+    }
+
+    if (len < DLOG_MAX_RECORD)
+        return ZX_ERR_BUFFER_TOO_SMALL;
+    len = MIN(len, kMaxDebuglogRead);
+
+    // Fill the buffer a chunk at a time, for as long as the next record
+    // surely fits.
+    char buf[kDebuglogReadChunk];
+    size_t total = 0;
+    while (len - total >= DLOG_MAX_RECORD) {
+        size_t actual;
+        status = log->Read(options, buf, MIN(len - total, sizeof(buf)), &actual);
+        if (status != ZX_OK) {
+            if (total == 0)
+                return status;
+            break;
+        }
+        if (ptr.byte_offset(total).reinterpret<char>().copy_array_to_user(buf, actual) != ZX_OK)
+            return ZX_ERR_INVALID_ARGS;
+        total += actual;
+    }
 
-    return static_cast<zx_status_t>(actual);
+    return static_cast<zx_status_t>(total);
 }
 
 // zx_status_t zx_log_write
@@ -265,9 +304,7 @@ zx_status_t sys_cprng_draw_once(user_out_ptr<void> buffer, size_t len) {
     // Ensure we get rid of the stack copy of the random data as this function returns.
     explicit_memory::ZeroDtor<uint8_t> zero_guard(kernel_buf, sizeof(kernel_buf));
 
-    auto prng = crypto::GlobalPRNG::GetInstance();
-    ASSERT(prng->is_thread_safe());
-    prng->Draw(kernel_buf, len);
+    crypto::GlobalPRNG::DrawPerCpu(kernel_buf, len);
 
     if (buffer.copy_array_to_user(kernel_buf, len) != ZX_OK)
         return ZX_ERR_INVALID_ARGS;
@@ -287,9 +324,8 @@ zx_status_t sys_cprng_add_entropy(user_in_ptr<const void> buffer, size_t len) {
     if (buffer.copy_array_from_user(kernel_buf, len) != ZX_OK)
         return ZX_ERR_INVALID_ARGS;
 
-    auto prng = crypto::GlobalPRNG::GetInstance();
-    ASSERT(prng->is_thread_safe());
-    prng->AddEntropy(kernel_buf, len);
+    ASSERT(crypto::GlobalPRNG::GetInstance()->is_thread_safe());
+    crypto::GlobalPRNG::AddEntropy(kernel_buf, len);
 
     return ZX_OK;
 }
@@ -8,12 +8,15 @@
 #include "tests.h"
 
 #include <arch/ops.h>
+#include <arch/user_copy.h>
 #include <err.h>
 #include <inttypes.h>
 #include <kernel/mp.h>
 #include <kernel/mutex.h>
 #include <kernel/spinlock.h>
 #include <kernel/thread.h>
+#include <kernel/timer.h>
+#include <lib/unittest/user_memory.h>
 #include <platform.h>
 #include <rand.h>
 #include <stdio.h>
@@ -207,6 +210,62 @@ __NO_INLINE static void bench_memcpy() {
     free(buf);
 }
 
+__NO_INLINE static void bench_user_copy() {
+    // The copies need a user address space, which is there when "k bench"
+    // is sent from a process but not when it is typed on the kernel console.
+    if (get_current_thread()->aspace == nullptr) {
+        printf("no user address space, skipping user copy benchmark\n");
+        return;
+    }
+
+    constexpr size_t kMaxLen = 1024 * 1024;
+    constexpr size_t kBytesPerSize = 256 * 1024 * 1024;
+    fbl::unique_ptr<testing::UserMemory> mem = testing::UserMemory::Create(kMaxLen);
+    uint8_t* buf = (uint8_t*)calloc(1, kMaxLen);
+    if (mem == nullptr || buf == nullptr) {
+        TRACEF("error: allocation failed\n");
+        free(buf);
+        return;
+    }
+
+    // Fault in the user pages first, since faults can't be handled with
+    // interrupts disabled.
+    if (arch_copy_to_user(mem->out(), buf, kMaxLen) != ZX_OK) {
+        TRACEF("error: arch_copy_to_user failed\n");
+        free(buf);
+        return;
+    }
+
+    for (size_t len = 64; len <= kMaxLen; len *= 4) {
+        const size_t iter = kBytesPerSize / len;
+
+        spin_lock_saved_state_t state;
+        arch_interrupt_save(&state, ARCH_DEFAULT_SPIN_LOCK_FLAG_INTERRUPTS);
+        uint64_t to_count = arch_cycle_count();
+        for (size_t i = 0; i < iter; i++) {
+            arch_copy_to_user(mem->out(), buf, len);
+        }
+        to_count = arch_cycle_count() - to_count;
+
+        uint64_t from_count = arch_cycle_count();
+        for (size_t i = 0; i < iter; i++) {
+            arch_copy_from_user(buf, mem->in(), len);
+        }
+        from_count = arch_cycle_count() - from_count;
+        arch_interrupt_restore(state, ARCH_DEFAULT_SPIN_LOCK_FLAG_INTERRUPTS);
+
+        uint64_t to_bytes_cycle = (len * iter * 1000ULL) / to_count;
+        uint64_t from_bytes_cycle = (len * iter * 1000ULL) / from_count;
+        printf("user copy of %7zu bytes %6zu times: "
+               "to user %" PRIu64 ".%03" PRIu64 " bytes/cycle, "
+               "from user %" PRIu64 ".%03" PRIu64 " bytes/cycle\n",
+               len, iter, to_bytes_cycle / 1000, to_bytes_cycle % 1000,
+               from_bytes_cycle / 1000, from_bytes_cycle % 1000);
+    }
+
+    free(buf);
+}
+
 __NO_INLINE static void bench_spinlock() {
     spin_lock_saved_state_t state;
     spin_lock_saved_state_t state2;
@@ -270,6 +329,53 @@ __NO_INLINE static void bench_mutex() {
     printf("%" PRIu64 " cycles to acquire/release uncontended mutex %u times (%" PRIu64 " cycles per)\n", c, count, c / count);
 }
 
+static void bench_timer_cb(timer_t*, zx_time_t, void*) {
+    panic("benchmark timer fired\n");
+}
+
+// Measures how the cost of setting and canceling a timer grows with the
+// number of timers already pending on the cpu.
+__NO_INLINE static void bench_timer_set_cancel() {
+    static const size_t max_count = 16 * 1024;
+    timer_t* timers = static_cast<timer_t*>(malloc(sizeof(timer_t) * max_count));
+    if (timers == nullptr) {
+        TRACEF("error: malloc failed\n");
+        return;
+    }
+
+    for (size_t count = 16; count <= max_count; count *= 4) {
+        for (size_t i = 0; i < count; i++)
+            timer_init(&timers[i]);
+
+        // Keep all the timers on the same cpu queue, and far enough out
+        // that none of them fires.
+        spin_lock_saved_state_t state;
+        arch_interrupt_save(&state, ARCH_DEFAULT_SPIN_LOCK_FLAG_INTERRUPTS);
+        zx_time_t base = current_time() + ZX_HOUR(1);
+
+        uint64_t set_cycles = arch_cycle_count();
+        for (size_t i = 0; i < count; i++) {
+            zx_time_t deadline = base + ZX_USEC(rand() % (1000 * 1000));
+            timer_set(&timers[i], deadline, TIMER_SLACK_CENTER, 0, bench_timer_cb, nullptr);
+        }
+        set_cycles = arch_cycle_count() - set_cycles;
+
+        uint64_t cancel_cycles = arch_cycle_count();
+        for (size_t i = 0; i < count; i++) {
+            // Cancel in an order unrelated to the deadlines.
+            timer_cancel(&timers[(i * 7919) % count]);
+        }
+        cancel_cycles = arch_cycle_count() - cancel_cycles;
+
+        arch_interrupt_restore(state, ARCH_DEFAULT_SPIN_LOCK_FLAG_INTERRUPTS);
+
+        printf("%zu timers: %" PRIu64 " cycles per set, %" PRIu64 " cycles per cancel\n",
+               count, set_cycles / count, cancel_cycles / count);
+    }
+
+    free(timers);
+}
+
 int benchmarks(int, const cmd_args*, uint32_t) {
     bench_set_overhead();
     bench_memcpy();
@@ -278,6 +384,8 @@ int benchmarks(int, const cmd_args*, uint32_t) {
     bench_memset_per_page();
     bench_zero_page();
 
+    bench_user_copy();
+
     bench_cset<uint8_t>();
     bench_cset<uint16_t>();
     bench_cset<uint32_t>();
@@ -287,5 +395,7 @@ int benchmarks(int, const cmd_args*, uint32_t) {
     bench_spinlock();
     bench_mutex();
 
+    bench_timer_set_cancel();
+
     return 0;
 }
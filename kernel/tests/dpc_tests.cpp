@@ -0,0 +1,73 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <arch/ops.h>
+#include <kernel/dpc.h>
+#include <kernel/event.h>
+#include <lib/unittest/unittest.h>
+
+namespace {
+
+struct OrderContext {
+    int order[3];
+    int count;
+    event_t done;
+};
+
+struct OrderDpc {
+    dpc_t dpc;
+    int id;
+    OrderContext* context;
+};
+
+void order_dpc(dpc_t* dpc) {
+    // |dpc| is the dpc thread's copy, so find our state through |arg|.
+    OrderDpc* self = static_cast<OrderDpc*>(dpc->arg);
+    OrderContext* context = self->context;
+    context->order[context->count++] = self->id;
+    if (context->count == 3) {
+        event_signal(&context->done, false);
+    }
+}
+
+} // namespace
+
+// Test that latency-sensitive dpcs run before bulk ones queued earlier.
+static bool test_priority_order() {
+    BEGIN_TEST;
+
+    OrderContext context = {};
+    event_init(&context.done, false, 0);
+
+    OrderDpc dpcs[3] = {};
+    for (int i = 0; i < 3; i++) {
+        dpcs[i].dpc.func = order_dpc;
+        dpcs[i].dpc.arg = &dpcs[i];
+        dpcs[i].id = i;
+        dpcs[i].context = &context;
+    }
+
+    // Queue everything before the dpc thread gets a chance to run.
+    arch_disable_ints();
+    EXPECT_EQ(ZX_OK, dpc_queue_priority(&dpcs[0].dpc, DPC_PRIORITY_BULK, false), "");
+    EXPECT_EQ(ZX_OK, dpc_queue(&dpcs[1].dpc, false), "");
+    EXPECT_EQ(ZX_OK, dpc_queue_priority(&dpcs[2].dpc, DPC_PRIORITY_LATENCY, false), "");
+    EXPECT_EQ(ZX_ERR_ALREADY_EXISTS, dpc_queue(&dpcs[0].dpc, false), "");
+    arch_enable_ints();
+
+    event_wait(&context.done);
+    event_destroy(&context.done);
+
+    EXPECT_EQ(1, context.order[0], "");
+    EXPECT_EQ(2, context.order[1], "");
+    EXPECT_EQ(0, context.order[2], "");
+
+    END_TEST;
+}
+
+UNITTEST_START_TESTCASE(dpc_tests)
+UNITTEST("test_priority_order", test_priority_order)
+UNITTEST_END_TESTCASE(dpc_tests, "dpc_tests", "dpc_tests");
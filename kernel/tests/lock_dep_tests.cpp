@@ -714,9 +714,68 @@ static bool lock_dep_static_analysis_tests() {
     END_TEST;
 }
 
+#if LOCK_DEP_ENABLE_PROFILING
+static bool lock_dep_profile_tests() {
+    BEGIN_TEST;
+
+    using lockdep::kLockContentionThresholdNs;
+    using lockdep::LockClassState;
+    using lockdep::LockDependencySet;
+    using lockdep::LockFlagsNone;
+
+    // A lock class of our own so that no real lock adds to the counts.
+    static LockDependencySet dependency_set;
+    static LockClassState state{"test::ProfileLock", &dependency_set, LockFlagsNone};
+    state.ResetProfile();
+    const auto& profile = state.profile();
+
+    void* const site_a = reinterpret_cast<void*>(0x1000);
+    void* const site_b = reinterpret_cast<void*>(0x2000);
+
+    // Short waits only count as acquisitions.
+    state.RecordAcquire(0, site_a);
+    state.RecordAcquire(kLockContentionThresholdNs - 1, site_a);
+    EXPECT_EQ(2u, profile.acquisitions.load(), "");
+    EXPECT_EQ(0u, profile.contended.load(), "");
+    EXPECT_EQ(0u, profile.call_sites[0].address.load(), "");
+
+    // Contended waits are charged to the lock class and the call site.
+    state.RecordAcquire(kLockContentionThresholdNs, site_a);
+    state.RecordAcquire(3 * kLockContentionThresholdNs, site_b);
+    state.RecordAcquire(2 * kLockContentionThresholdNs, site_a);
+    EXPECT_EQ(5u, profile.acquisitions.load(), "");
+    EXPECT_EQ(3u, profile.contended.load(), "");
+    EXPECT_EQ(6 * kLockContentionThresholdNs, profile.wait_ns.load(), "");
+    EXPECT_EQ(3 * kLockContentionThresholdNs, profile.max_wait_ns.load(), "");
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(site_a), profile.call_sites[0].address.load(), "");
+    EXPECT_EQ(2u, profile.call_sites[0].contended.load(), "");
+    EXPECT_EQ(3 * kLockContentionThresholdNs, profile.call_sites[0].wait_ns.load(), "");
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(site_b), profile.call_sites[1].address.load(), "");
+    EXPECT_EQ(1u, profile.call_sites[1].contended.load(), "");
+
+    // Call sites that don't fit are lumped together.
+    for (uintptr_t i = 0; i < LockClassState::kMaxProfileCallSites; i++) {
+        state.RecordAcquire(kLockContentionThresholdNs, reinterpret_cast<void*>(0x3000 + i));
+    }
+    EXPECT_EQ(2u, profile.other_contended.load(), "");
+    EXPECT_EQ(2 * kLockContentionThresholdNs, profile.other_wait_ns.load(), "");
+
+    state.ResetProfile();
+    EXPECT_EQ(0u, profile.acquisitions.load(), "");
+    EXPECT_EQ(0u, profile.contended.load(), "");
+    EXPECT_EQ(0u, profile.call_sites[0].address.load(), "");
+    EXPECT_EQ(0u, profile.other_contended.load(), "");
+
+    END_TEST;
+}
+#endif
+
 UNITTEST_START_TESTCASE(lock_dep_tests)
 UNITTEST("lock_dep_dynamic_analysis_tests", lock_dep_dynamic_analysis_tests)
 UNITTEST("lock_dep_static_analysis_tests", lock_dep_static_analysis_tests)
+#if LOCK_DEP_ENABLE_PROFILING
+UNITTEST("lock_dep_profile_tests", lock_dep_profile_tests)
+#endif
 UNITTEST_END_TESTCASE(lock_dep_tests, "lock_dep_tests", "lock_dep_tests");
 
 #endif
@@ -0,0 +1,119 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <debug.h>
+#include <fbl/alloc_checker.h>
+#include <fbl/atomic.h>
+#include <fbl/ref_counted.h>
+#include <fbl/ref_ptr.h>
+#include <kernel/rcu.h>
+#include <lib/unittest/unittest.h>
+
+namespace {
+
+struct FlagHead {
+    struct rcu_head head;
+    fbl::atomic<bool> called{false};
+};
+
+void set_flag(struct rcu_head* head) {
+    containerof(head, FlagHead, head)->called.store(true);
+}
+
+class Tracked : public fbl::RefCounted<Tracked> {
+public:
+    explicit Tracked(fbl::atomic<int>* destroyed)
+        : destroyed_(destroyed) {}
+    ~Tracked() { destroyed_->fetch_add(1); }
+
+private:
+    fbl::atomic<int>* destroyed_;
+};
+
+} // namespace
+
+// Test that a callback waits for a read-side critical section which was in
+// progress when it was queued.
+static bool test_call_waits_for_reader() {
+    BEGIN_TEST;
+
+    FlagHead flag;
+    rcu_read_lock();
+    rcu_call(&flag.head, set_flag);
+    // Give the rcu thread time to notice, if it wrongly ignores us.
+    spin(10000);
+    EXPECT_FALSE(flag.called.load(), "callback ran during a read-side critical section");
+    rcu_read_unlock();
+
+    rcu_synchronize();
+    EXPECT_TRUE(flag.called.load(), "callback did not run before rcu_synchronize() returned");
+
+    END_TEST;
+}
+
+// Test that read-side critical sections nest.
+static bool test_nested_read_lock() {
+    BEGIN_TEST;
+
+    uint32_t count = thread_preempt_disable_count();
+    {
+        AutoRcuReadLock outer;
+        {
+            AutoRcuReadLock inner;
+            EXPECT_EQ(count + 2, thread_preempt_disable_count(), "");
+        }
+        EXPECT_EQ(count + 1, thread_preempt_disable_count(), "");
+    }
+    EXPECT_EQ(count, thread_preempt_disable_count(), "");
+
+    END_TEST;
+}
+
+// Test that RcuPtr keeps replaced objects alive until readers are done.
+static bool test_rcu_ptr() {
+    BEGIN_TEST;
+
+    fbl::atomic<int> destroyed(0);
+    fbl::AllocChecker ac;
+    fbl::RefPtr<Tracked> first = fbl::AdoptRef(new (&ac) Tracked(&destroyed));
+    ASSERT_TRUE(ac.check(), "");
+    fbl::RefPtr<Tracked> second = fbl::AdoptRef(new (&ac) Tracked(&destroyed));
+    ASSERT_TRUE(ac.check(), "");
+    Tracked* first_raw = first.get();
+
+    {
+        RcuPtr<Tracked> ptr(fbl::move(first));
+        EXPECT_TRUE(ptr.Ref() == fbl::WrapRefPtr(first_raw), "");
+
+        rcu_read_lock();
+        Tracked* seen = ptr.Get();
+        EXPECT_EQ(first_raw, seen, "");
+        rcu_read_unlock();
+
+        // The reference held by |ptr| is the last one, and it is dropped
+        // only after a grace period.
+        ptr.Publish(fbl::move(second));
+        rcu_synchronize();
+        // The callback dropping the reference ran before ours.
+        EXPECT_EQ(1, destroyed.load(), "");
+
+        rcu_read_lock();
+        EXPECT_NE(first_raw, ptr.Get(), "");
+        rcu_read_unlock();
+    }
+
+    // Destroying the RcuPtr defers the drop too.
+    rcu_synchronize();
+    EXPECT_EQ(2, destroyed.load(), "");
+
+    END_TEST;
+}
+
+UNITTEST_START_TESTCASE(rcu_tests)
+UNITTEST("test_call_waits_for_reader", test_call_waits_for_reader)
+UNITTEST("test_nested_read_lock", test_nested_read_lock)
+UNITTEST("test_rcu_ptr", test_rcu_ptr)
+UNITTEST_END_TESTCASE(rcu_tests, "rcu_tests", "rcu_tests");
@@ -14,12 +14,14 @@ MODULE_SRCS += \
     $(LOCAL_DIR)/benchmarks.cpp \
     $(LOCAL_DIR)/cache_tests.cpp \
     $(LOCAL_DIR)/clock_tests.cpp \
+    $(LOCAL_DIR)/dpc_tests.cpp \
     $(LOCAL_DIR)/fibo.cpp \
     $(LOCAL_DIR)/lock_dep_tests.cpp \
     $(LOCAL_DIR)/mem_tests.cpp \
     $(LOCAL_DIR)/mp_hotplug_tests.cpp \
     $(LOCAL_DIR)/preempt_disable_tests.cpp \
     $(LOCAL_DIR)/printf_tests.cpp \
+    $(LOCAL_DIR)/rcu_tests.cpp \
     $(LOCAL_DIR)/resource_tests.cpp \
     $(LOCAL_DIR)/sleep_tests.cpp \
     $(LOCAL_DIR)/string_tests.cpp \
@@ -28,6 +30,7 @@ MODULE_SRCS += \
     $(LOCAL_DIR)/thread_tests.cpp \
     $(LOCAL_DIR)/timer_tests.cpp \
     $(LOCAL_DIR)/uart_tests.cpp \
+    $(LOCAL_DIR)/wait_queue_tests.cpp \
 
 MODULE_DEPS += \
     kernel/lib/crypto \
@@ -0,0 +1,111 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <fbl/algorithm.h>
+#include <fbl/atomic.h>
+#include <kernel/thread.h>
+#include <kernel/thread_lock.h>
+#include <kernel/wait.h>
+#include <lib/unittest/unittest.h>
+#include <zircon/time.h>
+
+namespace {
+
+struct Waiter {
+    wait_queue_t* wait;
+    fbl::atomic<int>* next_slot;
+    int woken_slot = -1;
+};
+
+int waiter_thread(void* arg) {
+    Waiter* waiter = static_cast<Waiter*>(arg);
+    {
+        Guard<spin_lock_t, IrqSave> guard{ThreadLock::Get()};
+        wait_queue_block(waiter->wait, ZX_TIME_INFINITE);
+    }
+    waiter->woken_slot = waiter->next_slot->fetch_add(1);
+    return 0;
+}
+
+int queued(wait_queue_t* wait) {
+    Guard<spin_lock_t, IrqSave> guard{ThreadLock::Get()};
+    wait_queue_validate_queue(wait);
+    return wait->count;
+}
+
+} // namespace
+
+// Test that waiters are woken highest priority first, in FIFO order within a
+// priority, and that blocked_priority tracks the queue, including across a
+// priority change of a blocked thread.
+static bool test_priority_order() {
+    BEGIN_TEST;
+
+    wait_queue_t wait;
+    wait_queue_init(&wait);
+    fbl::atomic<int> next_slot(0);
+
+    // The order each waiter is woken in, after waiter 4 is raised from 4 to 26.
+    constexpr int kPriorities[] = {8, 20, 16, 20, 4, 24, 8};
+    constexpr int kExpectedSlot[] = {5, 2, 4, 3, 0, 1, 6};
+    constexpr size_t kWaiters = fbl::count_of(kPriorities);
+
+    Waiter waiters[kWaiters];
+    thread_t* threads[kWaiters];
+    for (size_t i = 0; i < kWaiters; i++) {
+        waiters[i].wait = &wait;
+        waiters[i].next_slot = &next_slot;
+        threads[i] = thread_create("wait queue waiter", waiter_thread, &waiters[i],
+                                   kPriorities[i]);
+        ASSERT_NONNULL(threads[i], "");
+        thread_resume(threads[i]);
+        // Queue them one at a time so the FIFO order is known.
+        while (queued(&wait) != static_cast<int>(i + 1)) {
+            thread_sleep_relative(ZX_MSEC(1));
+        }
+    }
+
+    {
+        Guard<spin_lock_t, IrqSave> guard{ThreadLock::Get()};
+        EXPECT_EQ(24, wait_queue_blocked_priority(&wait), "");
+    }
+
+    thread_set_priority(threads[4], 26);
+    {
+        Guard<spin_lock_t, IrqSave> guard{ThreadLock::Get()};
+        wait_queue_validate_queue(&wait);
+        EXPECT_EQ(26, wait_queue_blocked_priority(&wait), "");
+    }
+
+    for (size_t i = 0; i < kWaiters; i++) {
+        {
+            Guard<spin_lock_t, IrqSave> guard{ThreadLock::Get()};
+            wait_queue_wake_one(&wait, false, ZX_OK);
+            wait_queue_validate_queue(&wait);
+        }
+        while (next_slot.load() != static_cast<int>(i + 1)) {
+            thread_sleep_relative(ZX_MSEC(1));
+        }
+    }
+
+    {
+        Guard<spin_lock_t, IrqSave> guard{ThreadLock::Get()};
+        EXPECT_EQ(-1, wait_queue_blocked_priority(&wait), "");
+    }
+
+    for (size_t i = 0; i < kWaiters; i++) {
+        thread_join(threads[i], nullptr, ZX_TIME_INFINITE);
+        EXPECT_EQ(kExpectedSlot[i], waiters[i].woken_slot, "");
+    }
+
+    wait_queue_destroy(&wait);
+
+    END_TEST;
+}
+
+UNITTEST_START_TESTCASE(wait_queue_tests)
+UNITTEST("test_priority_order", test_priority_order)
+UNITTEST_END_TESTCASE(wait_queue_tests, "wait_queue", "Wait queue tests");
@@ -11,6 +11,7 @@
  * initialized.
  */
 #include <arch/ops.h>
+#include <lib/ktrace.h>
 #include <lk/init.h>
 
 #include <assert.h>
@@ -82,7 +83,16 @@ void lk_init_level(enum lk_init_flags required_flag, uint start_level, uint stop
             }
         }
 
+        // Only hooks run by the boot cpu are on the boot timeline; the early
+        // boot span buffer is not safe for other cpus to write to.
+        bool boot_span = (required_flag == LK_INIT_FLAG_PRIMARY_CPU);
+        if (boot_span) {
+            ktrace_boot_span("init", found->name, KTRACE_BOOT_BEGIN, found->level);
+        }
         found->hook(found->level);
+        if (boot_span) {
+            ktrace_boot_span("init", found->name, KTRACE_BOOT_END, found->level);
+        }
         last_called_level = found->level;
         last = found;
     }
@@ -0,0 +1,76 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <lk/init.h>
+
+#include <arch/ops.h>
+#include <debug.h>
+#include <fbl/atomic.h>
+#include <kernel/mp.h>
+#include <kernel/thread.h>
+#include <trace.h>
+#include <zircon/time.h>
+
+#define LOCAL_TRACE 0
+
+namespace {
+
+struct ParallelWork {
+    lk_init_parallel_fn fn;
+    void* arg;
+    size_t count;
+    // The next index to hand out. Pieces of work need not take the same
+    // time, so each thread takes one at a time until they run out.
+    fbl::atomic<size_t> next;
+};
+
+void run_parallel_work(ParallelWork* work) {
+    for (;;) {
+        size_t index = work->next.fetch_add(1);
+        if (index >= work->count) {
+            return;
+        }
+        work->fn(index, work->arg);
+    }
+}
+
+int parallel_worker(void* arg) {
+    run_parallel_work(static_cast<ParallelWork*>(arg));
+    return 0;
+}
+
+} // namespace
+
+void lk_init_parallel(const char* name, size_t count, lk_init_parallel_fn fn, void* arg) {
+    ParallelWork work = {fn, arg, count, {0}};
+
+    // One worker pinned to each of the other online cpus; the caller does
+    // its share on its own cpu.
+    thread_t* workers[SMP_MAX_CPUS];
+    size_t worker_count = 0;
+    cpu_num_t self = arch_curr_cpu_num();
+    cpu_mask_t online = mp_get_online_mask();
+    for (cpu_num_t cpu = 0; cpu < SMP_MAX_CPUS && worker_count + 1 < count; cpu++) {
+        if (cpu == self || !(online & cpu_num_to_mask(cpu))) {
+            continue;
+        }
+        thread_t* t = thread_create(name, &parallel_worker, &work, DEFAULT_PRIORITY);
+        if (t == nullptr) {
+            // The work still gets done, by fewer threads.
+            break;
+        }
+        thread_set_cpu_affinity(t, cpu_num_to_mask(cpu));
+        thread_resume(t);
+        workers[worker_count++] = t;
+    }
+
+    LTRACEF("%s: %zu pieces of work on %zu cpus\n", name, count, worker_count + 1);
+
+    run_parallel_work(&work);
+    for (size_t i = 0; i < worker_count; i++) {
+        thread_join(workers[i], nullptr, ZX_TIME_INFINITE);
+    }
+}
@@ -16,6 +16,7 @@ MODULE_DEPS := \
 
 MODULE_SRCS := \
 	$(LOCAL_DIR)/init.cpp \
+	$(LOCAL_DIR)/init_parallel.cpp \
 	$(LOCAL_DIR)/main.cpp \
 
 include make/module.mk
@@ -29,6 +29,10 @@ const uint ARCH_MMU_FLAG_INVALID = (1u << 7); // Indicates that flags are not sp
 const uint ARCH_ASPACE_FLAG_KERNEL = (1u << 0);
 const uint ARCH_ASPACE_FLAG_GUEST = (1u << 1);
 
+// Called by HarvestAccessed() with the physical address of each accessed page.
+// Runs with the page table lock held, so it must not block.
+typedef void (*arch_accessed_fn_t)(void* context, paddr_t pa);
+
 // per arch base class api to encapsulate the mmu routines on an aspace
 class ArchVmAspaceInterface {
 public:
@@ -58,6 +62,22 @@ public:
 
     virtual zx_status_t Query(vaddr_t vaddr, paddr_t* paddr, uint* mmu_flags) = 0;
 
+    // Clear the hardware accessed flag of every page mapped in the given
+    // virtual address range, calling |accessed_fn| for each page that was
+    // accessed since the flag was last cleared. Architectures that do not
+    // track accesses in their page tables return ZX_ERR_NOT_SUPPORTED.
+    virtual zx_status_t HarvestAccessed(vaddr_t vaddr, size_t count,
+                                        arch_accessed_fn_t accessed_fn, void* context) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+
+    // Accumulate the TLB invalidations of Protect() calls made by the calling
+    // thread between these two calls and perform them once at the end, rather
+    // than after each call. Architectures whose invalidations do not need a
+    // round of IPIs may ignore this.
+    virtual void BeginTlbBatch() {}
+    virtual void EndTlbBatch() {}
+
     virtual vaddr_t PickSpot(vaddr_t base, uint prev_region_mmu_flags,
                              vaddr_t end, uint next_region_mmu_flags,
                              vaddr_t align, size_t size, uint mmu_flags) = 0;
@@ -30,12 +30,14 @@ typedef struct kstack {
 #endif
 } kstack_t;
 
-// Allocates a kernel stack with appropriate overrun padding.
+// Allocates a kernel stack with appropriate overrun padding.  Stacks freed
+// recently on the same cpu are reused, so the stack's contents are undefined.
 //
 // Assumes stack has been zero-initialized.
 zx_status_t vm_allocate_kstack(kstack_t* stack);
 
-// Frees a stack allocated by |vm_allocate_kstack|.
+// Frees a stack allocated by |vm_allocate_kstack|.  A small number of freed
+// stacks are kept mapped per cpu for reuse.
 zx_status_t vm_free_kstack(kstack_t* stack);
 
 __END_CDECLS
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <arch/defines.h>
 #include <fbl/algorithm.h>
 #include <list.h>
 #include <stdint.h>
@@ -22,24 +23,40 @@ enum vm_page_state {
     VM_PAGE_STATE_MMU,   // allocated to serve arch-specific mmu purposes
     VM_PAGE_STATE_IOMMU, // allocated for platform-specific iommu structures
     VM_PAGE_STATE_IPC,
+    VM_PAGE_STATE_CACHED, // free, but parked in a per-cpu pmm page cache
 
     VM_PAGE_STATE_COUNT_
 };
 
-#define VM_PAGE_STATE_BITS 3
+#define VM_PAGE_STATE_BITS 4
 static_assert((1u << VM_PAGE_STATE_BITS) >= VM_PAGE_STATE_COUNT_, "");
 
+#define VM_PAGE_NUMA_NODE_BITS 3
+
+// pages are tracked by page frame number, which limits the physical
+// addresses the pmm can manage
+#define VM_PAGE_PFN_BITS 32
+#define VM_PAGE_MAX_PADDR (1ull << (VM_PAGE_PFN_BITS + PAGE_SIZE_SHIFT))
+
 // core per page structure allocated at pmm arena creation time
+//
+// There is one of these for every page of memory, so it is kept small: the
+// physical address is stored as a page frame number and the state shares a
+// byte with the other per page bits.
 typedef struct vm_page {
     struct list_node queue_node;
-    paddr_t paddr_priv; // use paddr() accessor
-    // offset 0x18
+    uint32_t pfn_priv; // use paddr() accessor
+    // offset 0x14
 
     struct {
-        uint32_t flags : 8;
-        uint32_t state : VM_PAGE_STATE_BITS;
+        uint8_t state : VM_PAGE_STATE_BITS;
+        // numa node the page is local to, see pmm_set_arena_numa_node()
+        uint8_t numa_node : VM_PAGE_NUMA_NODE_BITS;
+        // set while the page is free (or freshly allocated) if its contents are
+        // known to be all zero, see pmm's background zeroing thread
+        uint8_t zeroed : 1;
     };
-    // offset: 0x1c
+    // offset: 0x15
 
     union {
         struct {
@@ -47,6 +64,18 @@ typedef struct vm_page {
 #define VM_PAGE_OBJECT_MAX_PIN_COUNT ((1ul << VM_PAGE_OBJECT_PIN_COUNT_BITS) - 1)
 
             uint8_t pin_count : VM_PAGE_OBJECT_PIN_COUNT_BITS;
+
+// aging passes without an access after which a page leaves the object's
+// working set, and the age at which pages stop getting older
+#define VM_PAGE_OBJECT_INACTIVE_AGE 2
+#define VM_PAGE_OBJECT_MAX_AGE 8
+
+            // set when the page tables report an access to the page; written
+            // without the object's lock, so it must not share a byte with the
+            // fields above
+            uint8_t accessed;
+            // number of aging passes the page went through without an access
+            uint8_t age;
         } object; // attached to a vm object
     };
 
@@ -58,12 +87,14 @@ typedef struct vm_page {
     void dump() const;
 
     // return the physical address
-    // future plan to store in a compressed form
-    paddr_t paddr() const { return paddr_priv; }
+    paddr_t paddr() const { return static_cast<paddr_t>(pfn_priv) << PAGE_SIZE_SHIFT; }
+    void set_paddr(paddr_t pa) {
+        pfn_priv = static_cast<uint32_t>(pa >> PAGE_SIZE_SHIFT);
+    }
 } vm_page_t;
 
 // assert that the page structure isn't growing uncontrollably
-static_assert(sizeof(vm_page) == 0x20, "");
+static_assert(sizeof(vm_page) == 0x18, "");
 
 // helpers
 const char* page_state_to_string(unsigned int state);
@@ -0,0 +1,24 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <sys/types.h>
+#include <zircon/compiler.h>
+
+__BEGIN_CDECLS
+
+// Harvests the page table accessed flags of all user address spaces and then
+// ages the pages of every VMO by one pass. Normally run periodically by the
+// page aging thread, see kernel.vm.page-aging-ms.
+void vm_age_pages(void);
+
+// Tries to free |target_pages| pages by evicting inactive VMO pages that can
+// be rebuilt without their contents, oldest first. Returns the number of
+// pages freed, which may fall short of the target.
+size_t vm_reclaim_pages(size_t target_pages);
+
+__END_CDECLS
@@ -0,0 +1,109 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <fbl/intrusive_double_list.h>
+#include <fbl/macros.h>
+#include <fbl/mutex.h>
+#include <fbl/ref_counted.h>
+#include <fbl/ref_ptr.h>
+#include <kernel/event.h>
+#include <kernel/lockdep.h>
+#include <kernel/mutex.h>
+#include <stdint.h>
+#include <zircon/thread_annotations.h>
+#include <zircon/types.h>
+
+class PageSource;
+
+// A thread's request for a page that a PageSource has yet to supply.
+//
+// Requests live on the stack of the thread that found the page missing. The
+// thread registers the request through PageSource::GetPages() while holding
+// the VMO lock, then drops all of its locks before calling Wait(). Once Wait()
+// returns the request may be reused for another page.
+class PageRequest : public fbl::DoublyLinkedListable<PageRequest*> {
+public:
+    PageRequest() = default;
+    ~PageRequest();
+
+    // Blocks until the page has been supplied, the source has gone away or
+    // the thread is interrupted. Returns ZX_OK in the first case, after which
+    // the caller should retry whatever needed the page.
+    zx_status_t Wait();
+
+private:
+    friend PageSource;
+
+    // The source this request is queued on, or null when it is not queued.
+    fbl::RefPtr<PageSource> src_;
+    // The page this request is waiting for.
+    uint64_t offset_ = 0;
+    // The range that was sent to the source on behalf of this request, if
+    // any. Requests for pages in this range wait on it instead of sending
+    // their own.
+    uint64_t sent_offset_ = 0;
+    uint64_t sent_len_ = 0;
+
+    Event event_;
+
+    DISALLOW_COPY_ASSIGN_AND_MOVE(PageRequest);
+};
+
+// Backs the pages of a VMO with something other than zero-filled memory,
+// such as a user-space pager. The VMO asks for a page missing from it with
+// GetPages(); whoever implements the source supplies it later by adding it to
+// the VMO and calling OnPagesSupplied().
+class PageSource : public fbl::RefCounted<PageSource> {
+public:
+    virtual ~PageSource();
+
+    // Queues |request| for the page at |offset| and, unless an earlier
+    // request already covers that page, asks the source for the |len| bytes
+    // starting there. Both must be page aligned. Returns ZX_ERR_SHOULD_WAIT
+    // if |request| was queued, or an error if the source can't supply pages.
+    zx_status_t GetPages(uint64_t offset, uint64_t len, PageRequest* request);
+
+    // Wakes up all of the requests for pages in [offset, offset + len). A
+    // request that was waiting on a range sent for another one is sent on
+    // its own if that range is no longer pending, so supplying only part of
+    // a readahead range can't leave it waiting forever.
+    void OnPagesSupplied(uint64_t offset, uint64_t len);
+
+    // Fails all outstanding and future requests with ZX_ERR_BAD_STATE. Called
+    // when either the VMO or whatever supplies its pages goes away.
+    void Detach();
+
+protected:
+    PageSource() = default;
+
+    // Asks the backing store for the |len| bytes at |offset|. Called with
+    // the source's lock held, so it must not block.
+    virtual zx_status_t SendRequest(uint64_t offset, uint64_t len) = 0;
+
+    // Called once, after the first Detach() has failed the pending requests.
+    virtual void OnDetach() {}
+
+private:
+    friend PageRequest;
+
+    // Removes a request whose thread stopped waiting for it.
+    void CancelRequest(PageRequest* request);
+
+    // Returns whether a pending request has sent a range including |offset|.
+    bool IsCoveredLocked(uint64_t offset) const TA_REQ(lock_);
+
+    // Sends requests for the pages of the pending requests no longer covered
+    // by any sent range, failing those for which sending fails.
+    void ResendOrphansLocked() TA_REQ(lock_);
+
+    DECLARE_MUTEX(PageSource) lock_;
+    bool detached_ TA_GUARDED(lock_) = false;
+    fbl::DoublyLinkedList<PageRequest*> pending_ TA_GUARDED(lock_);
+
+    DISALLOW_COPY_ASSIGN_AND_MOVE(PageSource);
+};
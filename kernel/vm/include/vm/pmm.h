@@ -8,6 +8,7 @@
 #pragma once
 
 #include <sys/types.h>
+#include <kernel/cpu.h>
 #include <vm/page.h>
 #include <zircon/compiler.h>
 #include <zircon/types.h>
@@ -25,6 +26,9 @@ typedef struct pmm_arena_info {
 
 #define PMM_ARENA_FLAG_LO_MEM (0x1) // this arena is contained within architecturally-defined 'low memory'
 
+// maximum number of numa nodes the pmm keeps separate free lists for
+#define PMM_MAX_NUMA_NODES (1u << VM_PAGE_NUMA_NODE_BITS)
+
 // Add a pre-filled memory arena to the physical allocator.
 // The arena data will be copied.
 zx_status_t pmm_add_arena(const pmm_arena_info_t* arena) __NONNULL((1));
@@ -32,6 +36,20 @@ zx_status_t pmm_add_arena(const pmm_arena_info_t* arena) __NONNULL((1));
 // flags for allocation routines below
 #define PMM_ALLOC_FLAG_ANY (0x0)    // no restrictions on which arena to allocate from
 #define PMM_ALLOC_FLAG_LO_MEM (0x1) // allocate only from arenas marked LO_MEM
+#define PMM_ALLOC_FLAG_NODE_VALID (0x2) // prefer the numa node encoded in PMM_ALLOC_FLAG_NODE_MASK
+#define PMM_ALLOC_FLAG_PREFER_ZEROED (0x4) // prefer pages that are already zero, see vm_page::zeroed
+
+// Without PMM_ALLOC_FLAG_NODE_VALID pages come from the numa node of the cpu
+// doing the allocation, falling back to other nodes when it runs out.
+#define PMM_ALLOC_FLAG_NODE_SHIFT 8
+#define PMM_ALLOC_FLAG_NODE_MASK (0xffu << PMM_ALLOC_FLAG_NODE_SHIFT)
+#define PMM_ALLOC_FLAG_NODE(n) \
+    (PMM_ALLOC_FLAG_NODE_VALID | (((uint)(n) << PMM_ALLOC_FLAG_NODE_SHIFT) & PMM_ALLOC_FLAG_NODE_MASK))
+
+// Without PMM_ALLOC_FLAG_PREFER_ZEROED allocations use pages that have not been
+// zeroed by the background zeroing thread first, saving the zeroed ones for
+// callers that need them. Either way the zeroed bit of the returned pages says
+// whether they are known to be zero.
 
 // Allocate count pages of physical memory, adding to the tail of the passed list.
 // The list must be initialized.
@@ -57,9 +75,32 @@ void pmm_free(list_node* list) __NONNULL((1));
 // Free a single page.
 void pmm_free_page(vm_page_t* page) __NONNULL((1));
 
+// Return all the free pages held in per-cpu caches back to the global free list.
+// Useful under memory pressure or before large contiguous allocations.
+// Returns the number of pages that were returned.
+size_t pmm_flush_page_caches();
+
 // Return count of unallocated physical pages in system.
 uint64_t pmm_count_free_pages();
 
+// Return count of unallocated physical pages that are known to be zero.
+uint64_t pmm_count_zeroed_pages();
+
+// Return count of unallocated physical pages local to numa |node|.
+uint64_t pmm_count_free_pages_node(uint32_t node);
+
+// Tag the pages in [base, base + size) as local to numa |node|. Typically
+// called once at boot by the platform after parsing firmware tables (ACPI
+// SRAT on x86). Nodes >= PMM_MAX_NUMA_NODES are rejected.
+zx_status_t pmm_set_numa_node_range(paddr_t base, size_t size, uint32_t node);
+
+// Record that |cpu| is local to numa |node|. Allocations made on |cpu|
+// without an explicit node prefer pages from |node|.
+zx_status_t pmm_set_cpu_numa_node(cpu_num_t cpu, uint32_t node);
+
+// Return the number of numa nodes known to the pmm. Always at least 1.
+uint32_t pmm_numa_node_count();
+
 // Return amount of physical memory in system, in bytes.
 uint64_t pmm_count_total_bytes();
 
@@ -19,6 +19,13 @@
 #define ROUNDUP_PAGE_SIZE(x) ROUNDUP((x), PAGE_SIZE)
 #define IS_PAGE_ALIGNED(x) IS_ALIGNED((x), PAGE_SIZE)
 
+// size of the large pages the fault path may opportunistically install when a
+// vmo range is backed by suitably aligned, physically contiguous pages
+#define LARGE_PAGE_SIZE_SHIFT 21
+#define LARGE_PAGE_SIZE (1UL << LARGE_PAGE_SIZE_SHIFT)
+#define LARGE_PAGE_COUNT (LARGE_PAGE_SIZE / PAGE_SIZE)
+#define IS_LARGE_PAGE_ALIGNED(x) IS_ALIGNED((x), LARGE_PAGE_SIZE)
+
 // kernel address space
 static_assert(KERNEL_ASPACE_BASE + (KERNEL_ASPACE_SIZE - 1) > KERNEL_ASPACE_BASE, "");
 
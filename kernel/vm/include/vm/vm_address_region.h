@@ -117,7 +117,9 @@ public:
 
     // Page fault in an address within the region.  Recursively traverses
     // the regions to find the target mapping, if it exists.
-    virtual zx_status_t PageFault(vaddr_t va, uint pf_flags) = 0;
+    // If the page has to come from a page source, returns ZX_ERR_SHOULD_WAIT
+    // with |page_request| queued on the source; see VmObject::GetPageLocked().
+    virtual zx_status_t PageFault(vaddr_t va, uint pf_flags, PageRequest* page_request) = 0;
 
     // WAVL tree key function
     vaddr_t GetKey() const { return base(); }
@@ -243,7 +245,7 @@ public:
     bool has_parent() const;
 
     void Dump(uint depth, bool verbose) const override;
-    zx_status_t PageFault(vaddr_t va, uint pf_flags) override;
+    zx_status_t PageFault(vaddr_t va, uint pf_flags, PageRequest* page_request) override;
 
 protected:
     // constructor for use in creating a VmAddressRegionDummy
@@ -256,7 +258,7 @@ protected:
     size_t AllocatedPagesLocked() const override;
     // Used to implement VmAspace::EnumerateChildren.
     // |aspace_->lock()| must be held.
-    virtual bool EnumerateChildrenLocked(VmEnumerator* ve, uint depth);
+    virtual bool EnumerateChildrenLocked(VmEnumerator* ve, uint depth, vaddr_t start);
 
     friend class VmMapping;
     // Remove *region* from the subregion list
@@ -384,7 +386,7 @@ public:
         return;
     }
 
-    zx_status_t PageFault(vaddr_t va, uint pf_flags) override {
+    zx_status_t PageFault(vaddr_t va, uint pf_flags, PageRequest* page_request) override {
         // We should never be trying to page fault on this...
         ASSERT(false);
         return ZX_ERR_BAD_STATE;
@@ -412,7 +414,7 @@ public:
         return;
     }
 
-    bool EnumerateChildrenLocked(VmEnumerator* ve, uint depth) override {
+    bool EnumerateChildrenLocked(VmEnumerator* ve, uint depth, vaddr_t start) override {
         return false;
     }
 };
@@ -448,7 +450,7 @@ public:
     bool is_mapping() const override { return true; }
 
     void Dump(uint depth, bool verbose) const override;
-    zx_status_t PageFault(vaddr_t va, uint pf_flags) override;
+    zx_status_t PageFault(vaddr_t va, uint pf_flags, PageRequest* page_request) override;
 
 protected:
     ~VmMapping() override;
@@ -486,6 +488,11 @@ private:
     // Version of AllocatedPages() that does not acquire the aspace lock
     size_t AllocatedPagesLocked() const override;
 
+    // Called by PageFault() once |va| is mapped to map, read-only, the pages around it
+    // which the vmo already has, so that touching them later does not fault again.
+    // Both the aspace and the object_ lock must be held.
+    void FaultAroundLocked(vaddr_t va);
+
     void Activate() override;
 
     // Version of Activate that does not take the object_ lock.
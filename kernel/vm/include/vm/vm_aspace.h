@@ -76,6 +76,11 @@ public:
     // given an address, return either the kernel aspace or the current user one
     static VmAspace* vaddr_to_aspace(uintptr_t address);
 
+    // Clears the page table accessed flags of every user address space,
+    // marking the VmObject pages that had them set as accessed for the next
+    // aging pass.
+    static void HarvestAllAccessed();
+
     // set the per thread aspace pointer to this
     void AttachToThread(thread_t* t);
 
@@ -84,7 +89,12 @@ public:
     // Traverses the VM tree rooted at this node, in depth-first pre-order. If
     // any methods of |ve| return false, the traversal stops and this method
     // returns false. Returns true otherwise.
-    bool EnumerateChildren(VmEnumerator* ve);
+    bool EnumerateChildren(VmEnumerator* ve) { return EnumerateChildren(ve, 0); }
+
+    // Like EnumerateChildren(), but skips the subtrees which end at or before
+    // |start|.  The regions which contain |start| are still visited, so
+    // callers resuming a walk at |start| must skip the ones they have seen.
+    bool EnumerateChildren(VmEnumerator* ve, vaddr_t start);
 
     // A collection of memory usage counts.
     struct vm_usage_t {
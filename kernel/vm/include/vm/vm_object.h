@@ -12,7 +12,8 @@
 #include <fbl/intrusive_double_list.h>
 #include <fbl/macros.h>
 #include <fbl/name.h>
-#include <fbl/ref_counted.h>
+#include <fbl/recycler.h>
+#include <fbl/ref_counted_upgradeable.h>
 #include <fbl/ref_ptr.h>
 #include <kernel/lockdep.h>
 #include <kernel/mutex.h>
@@ -25,6 +26,8 @@
 #include <zircon/thread_annotations.h>
 #include <zircon/types.h>
 
+class PageRequest;
+class PageSource;
 class VmMapping;
 
 typedef zx_status_t (*vmo_lookup_fn_t)(void* context, size_t offset, size_t index, paddr_t pa);
@@ -39,7 +42,8 @@ public:
 //
 // Can be created without mapping and used as a container of data, or mappable
 // into an address space via VmAddressRegion::CreateVmMapping
-class VmObject : public fbl::RefCounted<VmObject>,
+class VmObject : public fbl::RefCountedUpgradeable<VmObject>,
+                 public fbl::Recyclable<VmObject>,
                  public fbl::DoublyLinkedListable<VmObject*> {
 public:
     // public API
@@ -91,6 +95,50 @@ public:
         panic("Unpin should only be called on a pinned range");
     }
 
+    // Ages the committed pages of the object by one pass: pages accessed since
+    // the previous pass become the youngest and all others get older.
+    virtual void AgePages() {}
+
+    // Returns the number of committed pages accessed within the last
+    // VM_PAGE_OBJECT_INACTIVE_AGE aging passes, an estimate of the object's
+    // working set.
+    virtual size_t ActivePages() const { return 0; }
+
+    // Frees up to |max_pages| committed pages that are at least |min_age|
+    // aging passes old and whose contents can be rebuilt without the pages.
+    // Returns the number of pages freed.
+    virtual size_t ReclaimPages(size_t max_pages, uint8_t min_age) { return 0; }
+
+    // Moves the pages of the page-aligned range [offset, offset + len) out of
+    // the object onto |pages|, in offset order, committing any that are
+    // missing first. The range reads as zeroes afterwards.
+    virtual zx_status_t TakePages(uint64_t offset, uint64_t len, list_node* pages) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+
+    // Installs the pages on |pages| in the page-aligned range [offset, offset + len), in
+    // offset order, freeing any pages they displace. On failure, the pages that were
+    // not installed are left on |pages|, for the tail of the range.
+    virtual zx_status_t ReplacePages(uint64_t offset, uint64_t len, list_node* pages) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+
+    // Hands the pages on |pages| to an object backed by a page source for the
+    // page-aligned range [offset, offset + len), waking up any threads waiting
+    // for them. Pages for offsets the object already has are freed instead.
+    // |pages| is left empty.
+    virtual zx_status_t SupplyPages(uint64_t offset, uint64_t len, list_node* pages) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+
+    // Returns the source this object's missing pages come from, or null if
+    // they are zero filled.
+    virtual PageSource* page_source() const { return nullptr; }
+
+    // Returns true if pages missing from this object may have to be waited
+    // for from a page source, either its own or one of its ancestors'.
+    virtual bool is_pager_backed() const { return false; }
+
     // read/write operators against kernel pointers only
     virtual zx_status_t Read(void* ptr, uint64_t offset, size_t len) {
         return ZX_ERR_NOT_SUPPORTED;
@@ -136,7 +184,9 @@ public:
 
     // Returns the parent's user_id() if this VMO has a parent,
     // otherwise returns zero.
-    uint64_t parent_user_id() const;
+    uint64_t parent_user_id() const
+        // Reads the parent's state under the shared lock, which confuses analysis.
+        TA_NO_THREAD_SAFETY_ANALYSIS;
 
     // Sets the value returned by |user_id()|. May only be called once.
     void set_user_id(uint64_t user_id);
@@ -177,8 +227,22 @@ public:
 
     // get a pointer to the page structure and/or physical address at the specified offset.
     // valid flags are VMM_PF_FLAG_*
+    //
+    // If the page has to come from a page source and |page_request| is not null, the request
+    // is queued on the source and ZX_ERR_SHOULD_WAIT is returned. The caller should then drop
+    // its locks, wait on |page_request| and try again.
     virtual zx_status_t GetPageLocked(uint64_t offset, uint pf_flags, list_node* free_list,
-                                      vm_page_t** page, paddr_t* pa) TA_REQ(lock_) {
+                                      PageRequest* page_request, vm_page_t** page, paddr_t* pa)
+        TA_REQ(lock_) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+
+    // get the physical address of a LARGE_PAGE_SIZE run of physically contiguous pages starting
+    // at the LARGE_PAGE_SIZE aligned |offset|, faulting the whole run in if requested and the
+    // range is completely uncommitted. Returns an error if the range cannot be backed this way,
+    // in which case the caller should fall back to GetPageLocked().
+    virtual zx_status_t GetLargePageLocked(uint64_t offset, uint pf_flags, paddr_t* pa)
+        TA_REQ(lock_) {
         return ZX_ERR_NOT_SUPPORTED;
     }
 
@@ -216,6 +280,31 @@ public:
         return ZX_OK;
     }
 
+    // Calls the provided |func(VmObject*)| on every live VMO in the system,
+    // from oldest to newest, holding a reference to the VMO but not the global
+    // VMO lock during the call. Stops if |func| returns an error.
+    template <typename T>
+    static void ForEachRef(T func) {
+        fbl::RefPtr<VmObject> vmo;
+        for (;;) {
+            fbl::RefPtr<VmObject> next;
+            {
+                Guard<fbl::Mutex> guard{AllVmosLock::Get()};
+                // |vmo| is still referenced, so it is still in the list
+                auto iter = vmo ? ++all_vmos_.make_iterator(*vmo) : all_vmos_.begin();
+                for (; iter.IsValid() && !next; ++iter) {
+                    next = fbl::MakeRefPtrUpgradeFromRaw(&*iter, AllVmosLock::Get());
+                }
+            }
+            // dropping the last reference destroys the VMO, which takes the
+            // global VMO lock
+            vmo = fbl::move(next);
+            if (!vmo || func(vmo.get()) != ZX_OK) {
+                return;
+            }
+        }
+    }
+
 protected:
     // private constructor (use Create())
     explicit VmObject(fbl::RefPtr<VmObject> parent);
@@ -226,6 +315,16 @@ protected:
     virtual ~VmObject();
     friend fbl::RefPtr<VmObject>;
 
+    // Called by refptr when the last reference goes away. An object whose
+    // clones still read through it may outlive its references.
+    friend fbl::Recyclable<VmObject>;
+    virtual void fbl_recycle() { delete this; }
+
+    // Called on the parent after a child has been removed from it, with the
+    // shared lock held. Returns true if the parent has to be destroyed
+    // once the lock is dropped.
+    virtual bool OnChildRemovedLocked() TA_REQ(lock_) { return false; }
+
     DISALLOW_COPY_ASSIGN_AND_MOVE(VmObject);
 
     // inform all mappings and children that a range of this vmo's pages were added or removed.
@@ -256,7 +355,9 @@ protected:
     fbl::DoublyLinkedList<VmObject*> children_list_ TA_GUARDED(lock_);
 
     // parent pointer (may be null)
-    fbl::RefPtr<VmObject> parent_ TA_GUARDED(lock_);
+    // The parent stays around for as long as it has children, so this doesn't
+    // keep a reference to it.
+    VmObject* parent_ TA_GUARDED(lock_) = nullptr;
 
     // lengths of corresponding lists
     uint32_t mapping_list_len_ TA_GUARDED(lock_) = 0;
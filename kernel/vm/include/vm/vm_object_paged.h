@@ -11,12 +11,14 @@
 #include <fbl/canary.h>
 #include <fbl/intrusive_double_list.h>
 #include <fbl/macros.h>
+#include <fbl/recycler.h>
 #include <fbl/ref_counted.h>
 #include <fbl/ref_ptr.h>
 #include <kernel/mutex.h>
 #include <lib/user_copy/user_ptr.h>
 #include <list.h>
 #include <stdint.h>
+#include <vm/page_source.h>
 #include <vm/pmm.h>
 #include <vm/vm.h>
 #include <vm/vm_aspace.h>
@@ -26,7 +28,13 @@
 #include <zircon/types.h>
 
 // the main VM object type, holding a list of pages
-class VmObjectPaged final : public VmObject {
+//
+// A clone reads whatever pages it doesn't have from its parent. Once the last
+// reference to a parent with clones goes away the parent is hidden: it stays
+// around for its clones, but keeps only the pages at least one of them can
+// still see. A hidden parent down to a single clone hands that clone its
+// pages and leaves the chain, so clones of clones don't pile up lookups.
+class VmObjectPaged final : public VmObject, public fbl::Recyclable<VmObjectPaged> {
 public:
     // |options_| is a bitmask of:
     static constexpr uint32_t kResizable = (1u << 0);
@@ -44,6 +52,11 @@ public:
 
     static zx_status_t CreateFromROData(const void* data, size_t size, fbl::RefPtr<VmObject>* vmo);
 
+    // Create a VMO whose pages are supplied by |src| rather than zero filled.
+    // The returned vmo is not resizable.
+    static zx_status_t CreateExternal(fbl::RefPtr<PageSource> src, uint64_t size,
+                                      fbl::RefPtr<VmObject>* vmo);
+
     zx_status_t Resize(uint64_t size) override;
     zx_status_t ResizeLocked(uint64_t size) override TA_REQ(lock_);
     uint32_t create_options() const override { return options_; }
@@ -63,6 +76,16 @@ public:
     zx_status_t Pin(uint64_t offset, uint64_t len) override;
     void Unpin(uint64_t offset, uint64_t len) override;
 
+    void AgePages() override;
+    size_t ActivePages() const override;
+    size_t ReclaimPages(size_t max_pages, uint8_t min_age) override;
+
+    zx_status_t TakePages(uint64_t offset, uint64_t len, list_node* pages) override;
+    zx_status_t ReplacePages(uint64_t offset, uint64_t len, list_node* pages) override;
+    zx_status_t SupplyPages(uint64_t offset, uint64_t len, list_node* pages) override;
+    PageSource* page_source() const override { return page_source_.get(); }
+    bool is_pager_backed() const override { return pager_backed_; }
+
     zx_status_t Read(void* ptr, uint64_t offset, size_t len) override;
     zx_status_t Write(const void* ptr, uint64_t offset, size_t len) override;
     zx_status_t Lookup(uint64_t offset, uint64_t len, uint pf_flags,
@@ -82,10 +105,13 @@ public:
     zx_status_t SyncCache(const uint64_t offset, const uint64_t len) override;
 
     zx_status_t GetPageLocked(uint64_t offset, uint pf_flags, list_node* free_list,
-                              vm_page_t**, paddr_t*) override
+                              PageRequest* page_request, vm_page_t**, paddr_t*) override
         // Calls a Locked method of the parent, which confuses analysis.
         TA_NO_THREAD_SAFETY_ANALYSIS;
 
+    zx_status_t GetLargePageLocked(uint64_t offset, uint pf_flags, paddr_t* pa) override
+        TA_REQ(lock_);
+
     zx_status_t CloneCOW(bool resizable, uint64_t offset, uint64_t size, bool copy_name,
                          fbl::RefPtr<VmObject>* clone_vmo) override
         // Calls a Locked method of the child, which confuses analysis.
@@ -104,12 +130,47 @@ public:
 private:
     // private constructor (use Create())
     VmObjectPaged(
-        uint32_t options, uint32_t pmm_alloc_flags, uint64_t size, fbl::RefPtr<VmObject> parent);
+        uint32_t options, uint32_t pmm_alloc_flags, uint64_t size, fbl::RefPtr<VmObject> parent,
+        fbl::RefPtr<PageSource> page_source);
 
     // private destructor, only called from refptr
     ~VmObjectPaged() override;
     friend fbl::RefPtr<VmObjectPaged>;
 
+    // hides the object instead of destroying it while it has children
+    friend fbl::Recyclable<VmObjectPaged>;
+    void fbl_recycle() override;
+    bool OnChildRemovedLocked() override TA_REQ(lock_);
+
+    // Trims a hidden object down to what its children can still see, merging
+    // it into its only child if it has one. Returns true if the object has no
+    // children left and has to be destroyed once the lock is dropped.
+    bool CollapseHiddenLocked()
+        // Touches its children under the shared lock, which confuses analysis.
+        TA_NO_THREAD_SAFETY_ANALYSIS;
+
+    // Stops the children of a hidden object from looking past what they can
+    // see of it now, so that pages they can't see can be freed for good.
+    void ClipChildLimitsLocked()
+        // Touches its children under the shared lock, which confuses analysis.
+        TA_NO_THREAD_SAFETY_ANALYSIS;
+
+    // Moves the pages of a hidden object that |child|, its only child, can see
+    // into |child| and frees the rest. Returns false, leaving the pages that
+    // weren't moved, if |child| is out of memory for them.
+    bool MergeIntoChildLocked(VmObjectPaged* child)
+        // Touches the child under the shared lock, which confuses analysis.
+        TA_NO_THREAD_SAFETY_ANALYSIS;
+
+    // Returns true if reading |offset| in any child of a hidden object may
+    // end up at the object's page there.
+    bool IsPageVisibleLocked(uint64_t offset)
+        // Touches its children under the shared lock, which confuses analysis.
+        TA_NO_THREAD_SAFETY_ANALYSIS;
+
+    // Frees the page of a hidden object at |offset| if no child can see it.
+    void FreePageIfInvisibleLocked(uint64_t offset) TA_REQ(lock_);
+
     DISALLOW_COPY_ASSIGN_AND_MOVE(VmObjectPaged);
 
     // perform a cache maintenance operation against the vmo.
@@ -130,6 +191,12 @@ private:
     zx_status_t PinLocked(uint64_t offset, uint64_t len) TA_REQ(lock_);
     void UnpinLocked(uint64_t offset, uint64_t len) TA_REQ(lock_);
 
+    // commit the range of a vmo backed by a page source, waiting for the source
+    zx_status_t CommitRangeFromSource(uint64_t offset, uint64_t len, uint64_t* committed);
+
+    // the length of the run of missing pages at |offset| to ask the page source for
+    uint64_t ReadaheadLengthLocked(uint64_t offset) TA_REQ(lock_);
+
     // internal check if any pages in a range are pinned
     bool AnyPagesPinnedLocked(uint64_t offset, size_t len) TA_REQ(lock_);
 
@@ -144,9 +211,19 @@ private:
     const uint32_t options_;
     uint64_t size_ TA_GUARDED(lock_) = 0;
     uint64_t parent_offset_ TA_GUARDED(lock_) = 0;
+    // offsets at or past this don't look in the parent
+    uint64_t parent_limit_ TA_GUARDED(lock_) = UINT64_MAX;
+    // set once the last reference is gone while there are children
+    bool hidden_ TA_GUARDED(lock_) = false;
     uint32_t pmm_alloc_flags_ TA_GUARDED(lock_) = PMM_ALLOC_FLAG_ANY;
     uint32_t cache_policy_ TA_GUARDED(lock_) = ARCH_MMU_FLAG_CACHED;
 
     // a tree of pages
     VmPageList page_list_ TA_GUARDED(lock_);
+
+    // where missing pages come from, if not zero filled
+    const fbl::RefPtr<PageSource> page_source_;
+
+    // whether this object or one of its ancestors has a page source
+    const bool pager_backed_;
 };
@@ -188,12 +188,48 @@ public:
         return ZX_OK;
     }
 
+    // walk the page tree, calling |func(vm_page* p, uint64_t offset)| on every page and
+    // removing the pages it returns true for, which then belong to |func|
+    template <typename T>
+    void RemovePagesIf(T func) {
+        for (auto itr = list_.begin(); itr.IsValid();) {
+            auto& pl = *itr;
+            ++itr;
+            pl.ForEveryPage([&func](vm_page*& p, uint64_t offset) {
+                if (func(p, offset)) {
+                    p = nullptr;
+                }
+                return ZX_ERR_NEXT;
+            }, pl.offset(), pl.offset() + pl.kPageFanOut * PAGE_SIZE);
+            if (pl.IsEmpty()) {
+                EraseNode(&pl);
+            }
+        }
+    }
+
     zx_status_t AddPage(vm_page*, uint64_t offset);
     vm_page* GetPage(uint64_t offset);
     zx_status_t FreePage(uint64_t offset);
+    // remove the page at |offset| without freeing it, handing it to the caller
+    zx_status_t RemovePage(uint64_t offset, vm_page** page_out);
+    // move the pages in [start_offset, end_offset) onto the tail of |removed| in
+    // offset order, visiting only the nodes of the range that exist, and return
+    // how many there were
+    size_t RemovePages(uint64_t start_offset, uint64_t end_offset, list_node* removed);
+    // free the pages in [start_offset, end_offset) all at once, returning how many
+    // there were
+    size_t FreePages(uint64_t start_offset, uint64_t end_offset);
     size_t FreeAllPages();
     bool IsEmpty();
 
 private:
+    // the node covering |node_offset|, or null
+    VmPageListNode* FindNode(uint64_t node_offset);
+    void EraseNode(VmPageListNode* node);
+
     fbl::WAVLTree<uint64_t, fbl::unique_ptr<VmPageListNode>> list_;
+
+    // The node last looked up. Faults and commits mostly walk a range in
+    // order, so consecutive lookups tend to hit the same node.
+    VmPageListNode* last_node_ = nullptr;
 };
@@ -11,6 +11,9 @@
 #include <string.h>
 #include <trace.h>
 
+#include <kernel/align.h>
+#include <kernel/spinlock.h>
+#include <lib/counters.h>
 #include <vm/vm.h>
 #include <vm/vm_address_region.h>
 #include <vm/vm_aspace.h>
@@ -24,6 +27,67 @@
 
 #define LOCAL_TRACE 0
 
+// Number of freed stacks kept for reuse by each cpu.
+#define KSTACK_CACHE_SIZE 8
+
+KCOUNTER(kstack_cache_hit, "kernel.kstack.cache.hit");
+KCOUNTER(kstack_cache_miss, "kernel.kstack.cache.miss");
+
+namespace {
+
+// Creating a stack takes a VMO, a VMAR, a mapping and committing its pages,
+// and freeing it tears all of that down again.  Threads which come and go
+// quickly reuse freed stacks from here instead.
+//
+// A stack is cached on whichever cpu frees it and taken by whichever cpu
+// allocates next, so it stays warm in that cpu's caches.  The lock only
+// guards against the rare migration in between.
+struct KstackCache {
+    spin_lock_t lock;
+    size_t count;
+    kstack_t stacks[KSTACK_CACHE_SIZE];
+} __CPU_ALIGN;
+
+KstackCache kstack_cache[SMP_MAX_CPUS] = {};
+
+// Moves a cached stack to |stack|, if this cpu has one.
+bool kstack_cache_get(kstack_t* stack) {
+    KstackCache* cache = &kstack_cache[arch_curr_cpu_num()];
+    bool found = false;
+
+    spin_lock_saved_state_t state;
+    spin_lock_irqsave(&cache->lock, state);
+    if (cache->count > 0) {
+        cache->count--;
+        *stack = cache->stacks[cache->count];
+        cache->stacks[cache->count] = {};
+        found = true;
+    }
+    spin_unlock_irqrestore(&cache->lock, state);
+
+    return found;
+}
+
+// Moves |stack| into this cpu's cache, if there is room.
+bool kstack_cache_put(kstack_t* stack) {
+    KstackCache* cache = &kstack_cache[arch_curr_cpu_num()];
+    bool stored = false;
+
+    spin_lock_saved_state_t state;
+    spin_lock_irqsave(&cache->lock, state);
+    if (cache->count < KSTACK_CACHE_SIZE) {
+        cache->stacks[cache->count] = *stack;
+        cache->count++;
+        *stack = {};
+        stored = true;
+    }
+    spin_unlock_irqrestore(&cache->lock, state);
+
+    return stored;
+}
+
+} // namespace
+
 // Allocates and maps a kernel stack with one page of padding before and after the mapping.
 static zx_status_t allocate_vmar(bool unsafe,
                                  fbl::RefPtr<VmMapping>* out_kstack_mapping,
@@ -101,6 +165,39 @@ static zx_status_t allocate_vmar(bool unsafe,
     return ZX_OK;
 }
 
+// Unmaps |stack| and frees its memory.
+static zx_status_t destroy_kstack(kstack_t* stack) {
+    stack->base = 0;
+    stack->size = 0;
+    stack->top = 0;
+
+    if (stack->vmar != nullptr) {
+        fbl::RefPtr<VmAddressRegion> vmar =
+            fbl::internal::MakeRefPtrNoAdopt(static_cast<VmAddressRegion*>(stack->vmar));
+        zx_status_t status = vmar->Destroy();
+        if (status != ZX_OK) {
+            return status;
+        }
+        stack->vmar = nullptr;
+    }
+
+#if __has_feature(safe_stack)
+    stack->unsafe_base = 0;
+
+    if (stack->unsafe_vmar != nullptr) {
+        fbl::RefPtr<VmAddressRegion> vmar =
+            fbl::internal::MakeRefPtrNoAdopt(static_cast<VmAddressRegion*>(stack->unsafe_vmar));
+        zx_status_t status = vmar->Destroy();
+        if (status != ZX_OK) {
+            return status;
+        }
+        stack->unsafe_vmar = nullptr;
+    }
+#endif
+
+    return ZX_OK;
+}
+
 zx_status_t vm_allocate_kstack(kstack_t* stack) {
     DEBUG_ASSERT(stack->base == 0);
     DEBUG_ASSERT(stack->size == 0);
@@ -111,6 +208,12 @@ zx_status_t vm_allocate_kstack(kstack_t* stack) {
     DEBUG_ASSERT(stack->unsafe_vmar == nullptr);
 #endif
 
+    if (kstack_cache_get(stack)) {
+        kcounter_add(kstack_cache_hit, 1);
+        return ZX_OK;
+    }
+    kcounter_add(kstack_cache_miss, 1);
+
     fbl::RefPtr<VmMapping> mapping;
     fbl::RefPtr<VmAddressRegion> vmar;
     zx_status_t status = allocate_vmar(false, &mapping, &vmar);
@@ -127,7 +230,7 @@ zx_status_t vm_allocate_kstack(kstack_t* stack) {
 #if __has_feature(safe_stack)
     status = allocate_vmar(true, &mapping, &vmar);
     if (status != ZX_OK) {
-        vm_free_kstack(stack);
+        destroy_kstack(stack);
         return status;
     }
     stack->size = mapping->size();
@@ -141,33 +244,13 @@ zx_status_t vm_allocate_kstack(kstack_t* stack) {
 }
 
 zx_status_t vm_free_kstack(kstack_t* stack) {
-    stack->base = 0;
-    stack->size = 0;
-    stack->top = 0;
-
-    if (stack->vmar != nullptr) {
-        fbl::RefPtr<VmAddressRegion> vmar =
-            fbl::internal::MakeRefPtrNoAdopt(static_cast<VmAddressRegion*>(stack->vmar));
-        zx_status_t status = vmar->Destroy();
-        if (status != ZX_OK) {
-            return status;
-        }
-        stack->vmar = nullptr;
-    }
-
+    // There is nothing to keep from a stack which was never allocated.
+    bool complete = stack->vmar != nullptr;
 #if __has_feature(safe_stack)
-    stack->unsafe_base = 0;
-
-    if (stack->unsafe_vmar != nullptr) {
-        fbl::RefPtr<VmAddressRegion> vmar =
-            fbl::internal::MakeRefPtrNoAdopt(static_cast<VmAddressRegion*>(stack->unsafe_vmar));
-        zx_status_t status = vmar->Destroy();
-        if (status != ZX_OK) {
-            return status;
-        }
-        stack->unsafe_vmar = nullptr;
-    }
+    complete = complete && stack->unsafe_vmar != nullptr;
 #endif
-
-    return ZX_OK;
+    if (complete && kstack_cache_put(stack)) {
+        return ZX_OK;
+    }
+    return destroy_kstack(stack);
 }
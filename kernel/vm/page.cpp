@@ -34,14 +34,16 @@ const char* page_state_to_string(unsigned int state) {
         return "mmu";
     case VM_PAGE_STATE_IPC:
         return "ipc";
+    case VM_PAGE_STATE_CACHED:
+        return "cached";
     default:
         return "unknown";
     }
 }
 
 void vm_page::dump() const {
-    printf("page %p: address %#" PRIxPTR " state %s flags %#x\n", this, paddr(),
-           page_state_to_string(state), flags);
+    printf("page %p: address %#" PRIxPTR " state %s\n", this, paddr(),
+           page_state_to_string(state));
 }
 
 static int cmd_vm_page(int argc, const cmd_args* argv, uint32_t flags) {
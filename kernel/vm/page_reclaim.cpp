@@ -0,0 +1,77 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <vm/page_reclaim.h>
+
+#include "vm_priv.h"
+#include <kernel/cmdline.h>
+#include <kernel/thread.h>
+#include <lib/counters.h>
+#include <lk/init.h>
+#include <trace.h>
+#include <vm/vm_aspace.h>
+#include <vm/vm_object.h>
+#include <zircon/time.h>
+#include <zircon/types.h>
+
+#define LOCAL_TRACE MAX(VM_GLOBAL_TRACE, 0)
+
+KCOUNTER(vm_page_aging_pass, "kernel.vm.page_aging.pass");
+KCOUNTER(vm_reclaim_pass, "kernel.vm.reclaim.pass");
+
+void vm_age_pages() {
+    VmAspace::HarvestAllAccessed();
+    VmObject::ForEachRef([](VmObject* vmo) {
+        vmo->AgePages();
+        return ZX_OK;
+    });
+    kcounter_add(vm_page_aging_pass, 1);
+}
+
+size_t vm_reclaim_pages(size_t target_pages) {
+    kcounter_add(vm_reclaim_pass, 1);
+
+    // Sweep all VMOs once per age, so the pages that went unused the longest
+    // anywhere in the system go before any younger ones.
+    size_t freed = 0;
+    for (uint age = VM_PAGE_OBJECT_MAX_AGE;
+         age >= VM_PAGE_OBJECT_INACTIVE_AGE && freed < target_pages; age--) {
+        VmObject::ForEachRef([&freed, target_pages, age](VmObject* vmo) {
+            freed += vmo->ReclaimPages(target_pages - freed, static_cast<uint8_t>(age));
+            return freed < target_pages ? ZX_OK : ZX_ERR_STOP;
+        });
+    }
+
+    LTRACEF("freed %zu of %zu pages\n", freed, target_pages);
+    return freed;
+}
+
+static int page_aging_thread(void* arg) {
+    const zx_duration_t interval = *static_cast<zx_duration_t*>(arg);
+    for (;;) {
+        thread_sleep_relative(interval);
+        vm_age_pages();
+    }
+    return 0;
+}
+
+static void vm_page_aging_init(uint level) {
+    static zx_duration_t interval;
+    interval = ZX_MSEC(cmdline_get_uint64("kernel.vm.page-aging-ms", 1000));
+    if (interval == 0) {
+        return;
+    }
+
+    thread_t* t = thread_create("vm page aging", &page_aging_thread, &interval,
+                                LOW_PRIORITY);
+    if (!t) {
+        printf("VM: failed to create page aging thread\n");
+        return;
+    }
+    thread_detach_and_resume(t);
+}
+
+LK_INIT_HOOK(vm_page_aging, &vm_page_aging_init, LK_INIT_LEVEL_THREADING);
@@ -0,0 +1,149 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <vm/page_source.h>
+
+#include <assert.h>
+#include <inttypes.h>
+#include <trace.h>
+#include <vm/vm.h>
+
+#include "vm_priv.h"
+
+#define LOCAL_TRACE MAX(VM_GLOBAL_TRACE, 0)
+
+PageRequest::~PageRequest() {
+    if (src_) {
+        src_->CancelRequest(this);
+    }
+}
+
+zx_status_t PageRequest::Wait() {
+    DEBUG_ASSERT(src_);
+
+    zx_status_t status = event_.Wait(ZX_TIME_INFINITE);
+    LTRACEF("request %p offset %#" PRIx64 " woke with %d\n", this, offset_, status);
+
+    // if the thread was interrupted the request is still queued
+    src_->CancelRequest(this);
+    event_.Unsignal();
+    src_.reset();
+
+    return status;
+}
+
+PageSource::~PageSource() {
+    DEBUG_ASSERT(pending_.is_empty());
+}
+
+zx_status_t PageSource::GetPages(uint64_t offset, uint64_t len, PageRequest* request) {
+    DEBUG_ASSERT(IS_PAGE_ALIGNED(offset) && IS_PAGE_ALIGNED(len) && len > 0);
+    DEBUG_ASSERT(!request->src_);
+
+    Guard<fbl::Mutex> guard{&lock_};
+    if (detached_) {
+        return ZX_ERR_BAD_STATE;
+    }
+
+    request->offset_ = offset;
+    request->sent_offset_ = 0;
+    request->sent_len_ = 0;
+
+    // several threads faulting on the same range only need one request
+    if (!IsCoveredLocked(offset)) {
+        LTRACEF("requesting offset %#" PRIx64 " len %#" PRIx64 "\n", offset, len);
+        zx_status_t status = SendRequest(offset, len);
+        if (status != ZX_OK) {
+            return status;
+        }
+        request->sent_offset_ = offset;
+        request->sent_len_ = len;
+    }
+
+    request->src_ = fbl::RefPtr<PageSource>(this);
+    pending_.push_back(request);
+
+    return ZX_ERR_SHOULD_WAIT;
+}
+
+void PageSource::OnPagesSupplied(uint64_t offset, uint64_t len) {
+    Guard<fbl::Mutex> guard{&lock_};
+
+    for (auto iter = pending_.begin(); iter != pending_.end();) {
+        PageRequest* r = &*iter;
+        ++iter;
+        if (r->offset_ >= offset && r->offset_ - offset < len) {
+            // the waiter may return and destroy the request as soon as it is
+            // signaled, so it has to be off the list by then
+            pending_.erase(*r);
+            r->event_.Signal();
+        }
+    }
+
+    // the pages may have been a subset of a readahead range other threads
+    // are waiting on
+    ResendOrphansLocked();
+}
+
+void PageSource::Detach() {
+    Guard<fbl::Mutex> guard{&lock_};
+    if (detached_) {
+        return;
+    }
+    detached_ = true;
+
+    while (PageRequest* r = pending_.pop_front()) {
+        r->event_.Signal(ZX_ERR_BAD_STATE);
+    }
+    guard.Release();
+
+    OnDetach();
+}
+
+void PageSource::CancelRequest(PageRequest* request) {
+    Guard<fbl::Mutex> guard{&lock_};
+    if (request->InContainer()) {
+        pending_.erase(*request);
+        if (request->sent_len_) {
+            ResendOrphansLocked();
+        }
+    }
+}
+
+bool PageSource::IsCoveredLocked(uint64_t offset) const {
+    for (const auto& r : pending_) {
+        if (r.sent_len_ && offset >= r.sent_offset_ && offset - r.sent_offset_ < r.sent_len_) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void PageSource::ResendOrphansLocked() {
+    if (detached_) {
+        return;
+    }
+
+    for (auto iter = pending_.begin(); iter != pending_.end();) {
+        PageRequest* r = &*iter;
+        ++iter;
+        if (r->sent_len_ || IsCoveredLocked(r->offset_)) {
+            continue;
+        }
+
+        // the request that covered this page is gone without the page having
+        // been supplied, so ask for the page again
+        LTRACEF("re-requesting offset %#" PRIx64 "\n", r->offset_);
+        zx_status_t status = SendRequest(r->offset_, PAGE_SIZE);
+        if (status != ZX_OK) {
+            pending_.erase(*r);
+            r->event_.Signal(status);
+            continue;
+        }
+        r->sent_offset_ = r->offset_;
+        r->sent_len_ = PAGE_SIZE;
+    }
+}
@@ -10,6 +10,7 @@
 #include <assert.h>
 #include <err.h>
 #include <inttypes.h>
+#include <kernel/cmdline.h>
 #include <kernel/mp.h>
 #include <kernel/timer.h>
 #include <lib/console.h>
@@ -45,8 +46,22 @@ static void pmm_enforce_fill(uint level) {
     pmm_node.EnforceFill();
 }
 LK_INIT_HOOK(pmm_fill, &pmm_enforce_fill, LK_INIT_LEVEL_VM);
+#else
+// zeroing free pages would trample the fill pattern, so only do it when not filling
+static void pmm_start_zeroing(uint level) {
+    if (cmdline_get_bool("kernel.pmm.zero-free-pages", true)) {
+        pmm_node.StartZeroingThread();
+    }
+}
+LK_INIT_HOOK(pmm_zeroing, &pmm_start_zeroing, LK_INIT_LEVEL_THREADING);
 #endif
 
+// the other cpus are up by now, so they can help set up the rest of the pages
+static void pmm_init_deferred(uint level) {
+    pmm_node.InitDeferredPages();
+}
+LK_INIT_HOOK(pmm_deferred, &pmm_init_deferred, LK_INIT_LEVEL_PLATFORM);
+
 vm_page_t* paddr_to_vm_page(paddr_t addr) {
     return pmm_node.PaddrToPage(addr);
 }
@@ -99,10 +114,34 @@ void pmm_free_page(vm_page* page) {
     pmm_node.FreePage(page);
 }
 
+size_t pmm_flush_page_caches() {
+    return pmm_node.FlushPageCaches();
+}
+
 uint64_t pmm_count_free_pages() {
     return pmm_node.CountFreePages();
 }
 
+uint64_t pmm_count_zeroed_pages() {
+    return pmm_node.CountZeroedPages();
+}
+
+uint64_t pmm_count_free_pages_node(uint32_t node) {
+    return pmm_node.CountFreePagesNode(node);
+}
+
+zx_status_t pmm_set_numa_node_range(paddr_t base, size_t size, uint32_t node) {
+    return pmm_node.SetNumaNodeRange(base, size, node);
+}
+
+zx_status_t pmm_set_cpu_numa_node(cpu_num_t cpu, uint32_t node) {
+    return pmm_node.SetCpuNumaNode(cpu, node);
+}
+
+uint32_t pmm_numa_node_count() {
+    return pmm_node.NumaNodeCount();
+}
+
 uint64_t pmm_count_total_bytes() {
     return pmm_node.CountTotalBytes();
 }
@@ -127,6 +166,7 @@ static int cmd_pmm(int argc, const cmd_args* argv, uint32_t flags) {
         printf("%s dump\n", argv[0].str);
         if (!is_panic) {
             printf("%s free\n", argv[0].str);
+            printf("%s flush\n", argv[0].str);
         }
         return ZX_ERR_INTERNAL;
     }
@@ -151,6 +191,9 @@ static int cmd_pmm(int argc, const cmd_args* argv, uint32_t flags) {
             timer_cancel(&timer);
             show_mem = false;
         }
+    } else if (!strcmp(argv[1].str, "flush")) {
+        size_t flushed = pmm_node.FlushPageCaches();
+        printf("returned %zu cached pages to the free list\n", flushed);
     } else {
         printf("unknown command\n");
         goto usage;
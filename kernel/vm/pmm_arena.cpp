@@ -6,6 +6,7 @@
 #include "pmm_arena.h"
 
 #include <err.h>
+#include <fbl/algorithm.h>
 #include <inttypes.h>
 #include <pretty/sizes.h>
 #include <string.h>
@@ -20,10 +21,17 @@
 
 #define LOCAL_TRACE MAX(VM_GLOBAL_TRACE, 0)
 
-zx_status_t PmmArena::Init(const pmm_arena_info_t* info, PmmNode* node) {
+zx_status_t PmmArena::Init(const pmm_arena_info_t* info, PmmNode* node, size_t eager_pages) {
     // TODO: validate that info is sane (page aligned, etc)
     info_ = *info;
 
+    // pages past what a vm_page_t can address can't be managed
+    if (base() >= VM_PAGE_MAX_PADDR || size() > VM_PAGE_MAX_PADDR - base()) {
+        printf("PMM: arena at %#" PRIxPTR " size %#zx is past the addressable range\n",
+               base(), size());
+        return ZX_ERR_OUT_OF_RANGE;
+    }
+
     // allocate an array of pages to back this one
     size_t page_count = size() / PAGE_SIZE;
     size_t page_array_size = ROUNDUP_PAGE_SIZE(page_count * sizeof(vm_page));
@@ -49,47 +57,70 @@ zx_status_t PmmArena::Init(const pmm_arena_info_t* info, PmmNode* node) {
     LTRACEF("arena for base 0%#" PRIxPTR " size %#zx page array at %p size %#zx\n", base(), size(),
             raw_page_array, page_array_size);
 
-    memset(raw_page_array, 0, page_array_size);
-
     page_array_ = (vm_page_t*)raw_page_array;
 
     // compute the range of the array that backs the array itself
-    size_t array_start_index = (PAGE_ALIGN(range.pa) - info_.base) / PAGE_SIZE;
-    size_t array_end_index = array_start_index + page_array_size / PAGE_SIZE;
+    array_start_index_ = (PAGE_ALIGN(range.pa) - info_.base) / PAGE_SIZE;
+    array_end_index_ = array_start_index_ + page_array_size / PAGE_SIZE;
     LTRACEF("array_start_index %zu, array_end_index %zu, page_count %zu\n",
-            array_start_index, array_end_index, page_count);
+            array_start_index_, array_end_index_, page_count);
 
-    DEBUG_ASSERT(array_start_index < page_count && array_end_index <= page_count);
+    DEBUG_ASSERT(array_start_index_ < page_count && array_end_index_ <= page_count);
+
+    // the boot reserved ranges are wired by pmm_alloc_range() before the
+    // deferred pages come online, so they have to be set up now
+    size_t init_count = fbl::min(eager_pages, page_count);
+    boot_reserve_foreach([this, &init_count](const reserve_range_t r) {
+        if (r.pa + r.len > base() && r.pa < base() + size()) {
+            size_t end = (ROUNDUP_PAGE_SIZE(fbl::min(r.pa + r.len, base() + size())) - base()) / PAGE_SIZE;
+            init_count = fbl::max(init_count, end);
+        }
+        return true;
+    });
 
     // add all pages that aren't part of the page array to the free list
     // pages part of the free array go to the WIRED state
     list_node list;
     list_initialize(&list);
-    for (size_t i = 0; i < page_count; i++) {
+    InitPages(0, init_count, &list);
+    init_count_ = init_count;
+
+    node->AddFreePages(&list);
+
+    if (init_count_ < page_count) {
+        dprintf(INFO, "PMM: arena '%s' deferring %zu of %zu pages until the other cpus are up\n",
+                name(), page_count - init_count_, page_count);
+    }
+
+    return ZX_OK;
+}
+
+void PmmArena::InitPages(size_t start, size_t end, list_node* free_list) {
+    DEBUG_ASSERT(start >= init_count_ && start <= end && end <= page_count());
+
+    memset(&page_array_[start], 0, (end - start) * sizeof(vm_page));
+
+    for (size_t i = start; i < end; i++) {
         auto& p = page_array_[i];
 
-        p.paddr_priv = base() + i * PAGE_SIZE;
-        if (i >= array_start_index && i < array_end_index) {
+        p.set_paddr(base() + i * PAGE_SIZE);
+        if (i >= array_start_index_ && i < array_end_index_) {
             p.state = VM_PAGE_STATE_WIRED;
         } else {
             p.state = VM_PAGE_STATE_FREE;
-            list_add_tail(&list, &p.queue_node);
+            list_add_tail(free_list, &p.queue_node);
         }
     }
-
-    node->AddFreePages(&list);
-
-    return ZX_OK;
 }
 
 vm_page_t* PmmArena::FindSpecific(paddr_t pa) {
-    if (!address_in_arena(pa)) {
+    if (!page_initialized(pa)) {
         return nullptr;
     }
 
     size_t index = (pa - base()) / PAGE_SIZE;
 
-    DEBUG_ASSERT(index < size() / PAGE_SIZE);
+    DEBUG_ASSERT(index < init_count_);
 
     return get_page(index);
 }
@@ -111,8 +142,8 @@ vm_page_t* PmmArena::FindFreeContiguous(size_t count, uint8_t alignment_log2) {
 
 retry:
     // search while we're still within the arena and have a chance of finding a slot
-    // (start + count < end of arena)
-    while ((start < size() / PAGE_SIZE) && ((start + count) <= size() / PAGE_SIZE)) {
+    // (start + count < end of the set up part of the arena)
+    while ((start < init_count_) && ((start + count) <= init_count_)) {
         vm_page_t* p = &page_array_[start];
         for (uint i = 0; i < count; i++) {
             if (!p->is_free()) {
@@ -136,20 +167,24 @@ retry:
 }
 
 void PmmArena::CountStates(size_t state_count[VM_PAGE_STATE_COUNT_]) const {
-    for (size_t i = 0; i < size() / PAGE_SIZE; i++) {
+    for (size_t i = 0; i < init_count_; i++) {
         state_count[page_array_[i].state]++;
     }
 }
 
 void PmmArena::Dump(bool dump_pages, bool dump_free_ranges) const {
     char pbuf[16];
-    printf("  arena %p: name '%s' base %#" PRIxPTR " size %s (0x%zx) priority %u flags 0x%x\n",
-           this, name(), base(), format_size(pbuf, sizeof(pbuf), size()), size(), priority(), flags());
+    printf("  arena %p: name '%s' base %#" PRIxPTR " size %s (0x%zx) priority %u flags 0x%x node %u\n",
+           this, name(), base(), format_size(pbuf, sizeof(pbuf), size()), size(), priority(), flags(),
+           numa_node());
     printf("\tpage_array %p\n", page_array_);
+    if (init_count_ < page_count()) {
+        printf("\t%zu pages not yet set up\n", page_count() - init_count_);
+    }
 
     // dump all of the pages
     if (dump_pages) {
-        for (size_t i = 0; i < size() / PAGE_SIZE; i++) {
+        for (size_t i = 0; i < init_count_; i++) {
             page_array_[i].dump();
         }
     }
@@ -168,7 +203,7 @@ void PmmArena::Dump(bool dump_pages, bool dump_free_ranges) const {
     if (dump_free_ranges) {
         printf("\tfree ranges:\n");
         ssize_t last = -1;
-        for (size_t i = 0; i < size() / PAGE_SIZE; i++) {
+        for (size_t i = 0; i < init_count_; i++) {
             if (page_array_[i].is_free()) {
                 if (last == -1) {
                     last = i;
@@ -183,7 +218,8 @@ void PmmArena::Dump(bool dump_pages, bool dump_free_ranges) const {
         }
 
         if (last != -1) {
-            printf("\t\t%#" PRIxPTR " - %#" PRIxPTR "\n", base() + last * PAGE_SIZE, base() + size());
+            printf("\t\t%#" PRIxPTR " - %#" PRIxPTR "\n", base() + last * PAGE_SIZE,
+                   base() + init_count_ * PAGE_SIZE);
         }
     }
 }
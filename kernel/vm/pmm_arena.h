@@ -21,8 +21,11 @@ public:
 
     DISALLOW_COPY_ASSIGN_AND_MOVE(PmmArena);
 
-    // initialize the arena and allocate memory for internal data structures
-    zx_status_t Init(const pmm_arena_info_t* info, PmmNode* node);
+    // initialize the arena and allocate memory for internal data structures.
+    // only the vm_page_t of the first |eager_pages| pages (or more, to cover
+    // any boot reserved ranges) are set up and freed to |node|; the rest of
+    // the pages are deferred, see InitPages().
+    zx_status_t Init(const pmm_arena_info_t* info, PmmNode* node, size_t eager_pages);
 
     // accessors
     const pmm_arena_info_t& info() const { return info_; }
@@ -31,6 +34,8 @@ public:
     size_t size() const { return info_.size; }
     unsigned int flags() const { return info_.flags; }
     unsigned int priority() const { return info_.priority; }
+    uint32_t numa_node() const { return numa_node_; }
+    void set_numa_node(uint32_t node) { numa_node_ = node; }
 
     // Counts the number of pages in every state. For each page in the arena,
     // increments the corresponding VM_PAGE_STATE_*-indexed entry of
@@ -39,6 +44,21 @@ public:
 
     vm_page_t* get_page(size_t index) { return &page_array_[index]; }
 
+    size_t page_count() const { return size() / PAGE_SIZE; }
+
+    // number of pages at the start of the arena whose vm_page_t is set up.
+    // lookups treat the pages past it as if they were not in the arena.
+    size_t init_page_count() const { return init_count_; }
+
+    // set up the vm_page_t of each page in [start, end), which must lie in
+    // the deferred part of the arena, and add the free ones to |free_list|.
+    // ranges that do not overlap may be set up concurrently.
+    void InitPages(size_t start, size_t end, list_node* free_list);
+
+    // make the deferred pages visible to lookups, once InitPages() has set
+    // up all of them
+    void FinishDeferredInit() { init_count_ = page_count(); }
+
     // find a free run of contiguous pages
     vm_page_t* FindFreeContiguous(size_t count, uint8_t alignment_log2);
 
@@ -54,9 +74,18 @@ public:
         return (address >= info_.base && address <= info_.base + info_.size - 1);
     }
 
+    bool page_initialized(paddr_t address) const {
+        return address_in_arena(address) && (address - base()) / PAGE_SIZE < init_count_;
+    }
+
     void Dump(bool dump_pages, bool dump_free_ranges) const;
 
 private:
     pmm_arena_info_t info_ = {};
     vm_page_t* page_array_ = nullptr;
+    size_t init_count_ = 0;
+    // the part of the page array that backs the array itself
+    size_t array_start_index_ = 0;
+    size_t array_end_index_ = 0;
+    uint32_t numa_node_ = 0;
 };
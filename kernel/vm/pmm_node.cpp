@@ -5,23 +5,40 @@
 // https://opensource.org/licenses/MIT
 #include "pmm_node.h"
 
+#include <arch/ops.h>
+#include <fbl/alloc_checker.h>
+#include <fbl/unique_ptr.h>
 #include <inttypes.h>
+#include <kernel/cmdline.h>
 #include <kernel/mp.h>
+#include <lib/counters.h>
+#include <lk/init.h>
+#include <platform.h>
 #include <trace.h>
 #include <vm/bootalloc.h>
 #include <vm/physmap.h>
+#include <zircon/time.h>
 #include <zxcpp/new.h>
 
 #include "vm_priv.h"
 
 #define LOCAL_TRACE MAX(VM_GLOBAL_TRACE, 0)
 
+KCOUNTER(pmm_cache_alloc_hit, "kernel.pmm.cache.alloc_hit");
+KCOUNTER(pmm_cache_refill, "kernel.pmm.cache.refill");
+KCOUNTER(pmm_cache_drain, "kernel.pmm.cache.drain");
+KCOUNTER(pmm_cache_flush, "kernel.pmm.cache.flush");
+KCOUNTER(pmm_numa_remote_alloc, "kernel.pmm.numa.remote_alloc");
+KCOUNTER(pmm_zero_pages, "kernel.pmm.zero.pages");
+KCOUNTER(pmm_zero_alloc_hit, "kernel.pmm.zero.alloc_hit");
+KCOUNTER(pmm_zero_alloc_miss, "kernel.pmm.zero.alloc_miss");
+
 namespace {
 
 void set_state_alloc(vm_page* page) {
     LTRACEF("page %p: prev state %s\n", page, page_state_to_string(page->state));
 
-    DEBUG_ASSERT(page->state == VM_PAGE_STATE_FREE);
+    DEBUG_ASSERT(page->state == VM_PAGE_STATE_FREE || page->state == VM_PAGE_STATE_CACHED);
 
     page->state = VM_PAGE_STATE_ALLOC;
 }
@@ -29,6 +46,12 @@ void set_state_alloc(vm_page* page) {
 } // namespace
 
 PmmNode::PmmNode() {
+    for (auto& list : free_list_) {
+        list_initialize(&list);
+    }
+    for (auto& list : zeroed_list_) {
+        list_initialize(&list);
+    }
 }
 
 PmmNode::~PmmNode() {
@@ -51,14 +74,21 @@ zx_status_t PmmNode::AddArena(const pmm_arena_info_t* info) TA_NO_THREAD_SAFETY_
     // allocate a c++ arena object
     PmmArena* arena = new (boot_alloc_mem(sizeof(PmmArena))) PmmArena();
 
+    // whatever is left of the budget for pages to set up now
+    uint64_t eager_mb = fbl::max(cmdline_get_uint64("kernel.pmm.eager-init-mb", kDefaultEagerInitMB),
+                                 kMinEagerInitMB);
+    size_t eager_pages = static_cast<size_t>(eager_mb * MB / PAGE_SIZE);
+    eager_pages = eager_pages > eager_init_pages_ ? eager_pages - eager_init_pages_ : 0;
+
     // initialize the object
-    auto status = arena->Init(info, this);
+    auto status = arena->Init(info, this, eager_pages);
     if (status != ZX_OK) {
         // leaks boot allocator memory
         arena->~PmmArena();
         printf("PMM: pmm_add_arena failed to initialize arena\n");
         return status;
     }
+    eager_init_pages_ += arena->init_page_count();
 
     // walk the arena list and add arena based on priority order
     for (auto& a : arena_list_) {
@@ -84,25 +114,318 @@ void PmmNode::AddFreePages(list_node* list) TA_NO_THREAD_SAFETY_ANALYSIS {
     vm_page *temp, *page;
     list_for_every_entry_safe (list, page, temp, vm_page, queue_node) {
         list_delete(&page->queue_node);
-        list_add_tail(&free_list_, &page->queue_node);
-        free_count_++;
+        page->zeroed = 0;
+        list_add_tail(&free_list_[page->numa_node], &page->queue_node);
+        free_count_[page->numa_node]++;
     }
 
-    LTRACEF("free count now %" PRIu64 "\n", free_count_);
+    LTRACEF("free count now %" PRIu64 "\n", CountFreePages());
 }
 
-zx_status_t PmmNode::AllocPage(uint alloc_flags, vm_page_t** page_out, paddr_t* pa_out) {
-    Guard<fbl::Mutex> guard{&lock_};
+struct PmmNode::DeferredChunk {
+    PmmNode* node;
+    PmmArena* arena;
+    size_t start;
+    size_t end;
 
-    vm_page* page = list_remove_head_type(&free_list_, vm_page, queue_node);
-    if (!page) {
-        return ZX_ERR_NO_MEMORY;
+    // the free pages of the chunk, by numa node
+    list_node free_list[PMM_MAX_NUMA_NODES];
+    uint64_t free_count[PMM_MAX_NUMA_NODES];
+};
+
+void PmmNode::InitDeferredChunk(size_t index, void* arg) {
+    DeferredChunk* chunk = &static_cast<DeferredChunk*>(arg)[index];
+    chunk->node->InitDeferredChunk(chunk);
+}
+
+void PmmNode::InitDeferredChunk(DeferredChunk* chunk) {
+    list_node list = LIST_INITIAL_VALUE(list);
+    chunk->arena->InitPages(chunk->start, chunk->end, &list);
+
+    // the ranges are all tagged early in boot, before this runs
+    NumaRange ranges[kMaxDeferredNumaRanges];
+    size_t range_count;
+    {
+        Guard<fbl::Mutex> guard{&lock_};
+        range_count = deferred_numa_range_count_;
+        memcpy(ranges, deferred_numa_ranges_, range_count * sizeof(ranges[0]));
+    }
+    paddr_t chunk_base = chunk->arena->base() + chunk->start * PAGE_SIZE;
+    paddr_t chunk_end = chunk->arena->base() + chunk->end * PAGE_SIZE;
+    for (size_t i = 0; i < range_count; i++) {
+        paddr_t start = MAX(ranges[i].base, chunk_base);
+        paddr_t end = MIN(ranges[i].base + ranges[i].size, chunk_end);
+        for (paddr_t pa = start; pa < end; pa += PAGE_SIZE) {
+            chunk->arena->get_page((pa - chunk->arena->base()) / PAGE_SIZE)->numa_node =
+                ranges[i].node & ((1u << VM_PAGE_NUMA_NODE_BITS) - 1);
+        }
     }
 
-    DEBUG_ASSERT(free_count_ > 0);
-    free_count_--;
+    vm_page *temp, *page;
+    list_for_every_entry_safe (&list, page, temp, vm_page, queue_node) {
+        list_delete(&page->queue_node);
+#if PMM_ENABLE_FREE_FILL
+        if (enforce_fill_) {
+            FreeFill(page);
+        }
+#endif
+        list_add_tail(&chunk->free_list[page->numa_node], &page->queue_node);
+        chunk->free_count[page->numa_node]++;
+    }
+}
+
+void PmmNode::InitDeferredPages() {
+    size_t chunk_count = 0;
+    {
+        Guard<fbl::Mutex> guard{&lock_};
+        for (auto& a : arena_list_) {
+            size_t deferred = a.page_count() - a.init_page_count();
+            chunk_count += (deferred + kDeferredChunkPages - 1) / kDeferredChunkPages;
+        }
+    }
+    if (chunk_count == 0) {
+        return;
+    }
+
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<DeferredChunk[]> chunks(new (&ac) DeferredChunk[chunk_count]);
+    if (!ac.check()) {
+        panic("PMM: no memory to set up the deferred pages\n");
+    }
+
+    size_t pages = 0;
+    {
+        Guard<fbl::Mutex> guard{&lock_};
+        size_t i = 0;
+        for (auto& a : arena_list_) {
+            for (size_t start = a.init_page_count(); start < a.page_count();
+                 start += kDeferredChunkPages) {
+                DeferredChunk* chunk = &chunks[i++];
+                chunk->node = this;
+                chunk->arena = &a;
+                chunk->start = start;
+                chunk->end = MIN(start + kDeferredChunkPages, a.page_count());
+                for (size_t n = 0; n < PMM_MAX_NUMA_NODES; n++) {
+                    list_initialize(&chunk->free_list[n]);
+                    chunk->free_count[n] = 0;
+                }
+                pages += chunk->end - chunk->start;
+            }
+        }
+        DEBUG_ASSERT(i == chunk_count);
+    }
 
+    zx_time_t start_time = current_time();
+    lk_init_parallel("pmm init", chunk_count, &PmmNode::InitDeferredChunk, chunks.get());
+    zx_duration_t elapsed = zx_time_sub_time(current_time(), start_time);
+
+    {
+        Guard<fbl::Mutex> guard{&lock_};
+        for (auto& a : arena_list_) {
+            a.FinishDeferredInit();
+        }
+        for (size_t i = 0; i < chunk_count; i++) {
+            for (size_t n = 0; n < PMM_MAX_NUMA_NODES; n++) {
+                list_splice_after(&chunks[i].free_list[n], free_list_[n].prev);
+                free_count_[n] += chunks[i].free_count[n];
+            }
+        }
+
+        if (zeroing_thread_waiting_) {
+            zeroing_thread_waiting_ = false;
+            event_signal(&zeroing_event_, false);
+        }
+    }
+
+    dprintf(INFO, "PMM: set up %zu deferred pages (%zu MB) in %" PRIi64 " ms\n",
+            pages, pages * PAGE_SIZE / MB, elapsed / ZX_MSEC(1));
+}
+
+// figure out which numa node an allocation with |alloc_flags| should come from
+uint32_t PmmNode::PreferredNode(uint alloc_flags) const {
+    if (alloc_flags & PMM_ALLOC_FLAG_NODE_VALID) {
+        uint32_t node = (alloc_flags & PMM_ALLOC_FLAG_NODE_MASK) >> PMM_ALLOC_FLAG_NODE_SHIFT;
+        if (node < numa_node_count_) {
+            return node;
+        }
+    }
+
+    // first touch: use the node of the cpu we're running on
+    return cpu_numa_node_[arch_curr_cpu_num()];
+}
+
+// pull a free page off of |preferred|'s free lists, falling back to the other nodes in order.
+// within a node, take a page from the zeroed list first only if |prefer_zeroed|.
+vm_page* PmmNode::RemoveFreePageLocked(uint32_t preferred, bool prefer_zeroed) {
+    for (uint32_t i = 0; i < numa_node_count_; i++) {
+        uint32_t node = (preferred + i) % numa_node_count_;
+        list_node* first = prefer_zeroed ? &zeroed_list_[node] : &free_list_[node];
+        list_node* second = prefer_zeroed ? &free_list_[node] : &zeroed_list_[node];
+        vm_page* page = list_remove_head_type(first, vm_page, queue_node);
+        if (!page) {
+            page = list_remove_head_type(second, vm_page, queue_node);
+        }
+        if (page) {
+            DEBUG_ASSERT(page->numa_node == node);
+            DEBUG_ASSERT(free_count_[node] > 0);
+            free_count_[node]--;
+            if (page->zeroed) {
+                DEBUG_ASSERT(zeroed_count_[node] > 0);
+                zeroed_count_[node]--;
+            }
+            DEBUG_ASSERT(page->is_free());
+            if (i != 0) {
+                kcounter_add(pmm_numa_remote_alloc, 1);
+            }
+            return page;
+        }
+    }
+    return nullptr;
+}
+
+// take a specific free page off of whichever node free list it is sitting on
+void PmmNode::RemoveSpecificFreePageLocked(vm_page* page) {
     DEBUG_ASSERT(page->is_free());
+    DEBUG_ASSERT(list_in_list(&page->queue_node));
+    DEBUG_ASSERT(free_count_[page->numa_node] > 0);
+
+    list_delete(&page->queue_node);
+    free_count_[page->numa_node]--;
+    if (page->zeroed) {
+        DEBUG_ASSERT(zeroed_count_[page->numa_node] > 0);
+        zeroed_count_[page->numa_node]--;
+    }
+}
+
+// mark a page free and put it back on its node's free list
+void PmmNode::InsertFreePageLocked(vm_page* page) {
+    DEBUG_ASSERT(!list_in_list(&page->queue_node));
+
+    page->state = VM_PAGE_STATE_FREE;
+    page->zeroed = 0;
+    list_add_head(&free_list_[page->numa_node], &page->queue_node);
+    free_count_[page->numa_node]++;
+
+    // give the zeroing thread something to do once enough has piled up
+    if (zeroing_thread_waiting_ && ++freed_since_zeroing_ >= kZeroBatch) {
+        zeroing_thread_waiting_ = false;
+        event_signal(&zeroing_event_, false);
+    }
+}
+
+// mark a page that has just been zeroed free and put it on its node's zeroed list
+void PmmNode::InsertZeroedPageLocked(vm_page* page) {
+    DEBUG_ASSERT(!list_in_list(&page->queue_node));
+
+    page->state = VM_PAGE_STATE_FREE;
+    page->zeroed = 1;
+    list_add_head(&zeroed_list_[page->numa_node], &page->queue_node);
+    free_count_[page->numa_node]++;
+    zeroed_count_[page->numa_node]++;
+}
+
+zx_status_t PmmNode::SetNumaNodeRange(paddr_t base, size_t size, uint32_t node) {
+    if (node >= PMM_MAX_NUMA_NODES || size == 0) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+
+    // pages in the per-cpu caches are tracked by node, so get them out of the way first
+    FlushPageCaches();
+
+    Guard<fbl::Mutex> guard{&lock_};
+
+    size_t tagged = 0;
+    for (auto& a : arena_list_) {
+        paddr_t start = MAX(ROUNDDOWN(base, PAGE_SIZE), a.base());
+        paddr_t end = MIN(ROUNDUP(base + size, PAGE_SIZE), a.base() + a.size());
+        if (start >= end) {
+            continue;
+        }
+
+        // pages that are not set up yet are tagged when they are
+        paddr_t init_end = MAX(MIN(end, a.base() + a.init_page_count() * PAGE_SIZE), start);
+        if (init_end < end) {
+            if (deferred_numa_range_count_ < kMaxDeferredNumaRanges) {
+                deferred_numa_ranges_[deferred_numa_range_count_++] = {init_end, end - init_end, node};
+            } else {
+                printf("PMM: too many numa ranges, leaving [%#" PRIxPTR ", %#" PRIxPTR ") on node 0\n",
+                       init_end, end);
+            }
+            end = init_end;
+        }
+
+        for (paddr_t pa = start; pa < end; pa += PAGE_SIZE) {
+            vm_page* page = a.FindSpecific(pa);
+            DEBUG_ASSERT(page);
+            if (page->numa_node == node) {
+                continue;
+            }
+
+            // free pages need to move to the new node's free list, allocated pages
+            // will land there when they are freed
+            if (page->is_free()) {
+                RemoveSpecificFreePageLocked(page);
+                page->numa_node = node;
+                if (page->zeroed) {
+                    list_add_tail(&zeroed_list_[node], &page->queue_node);
+                    zeroed_count_[node]++;
+                } else {
+                    list_add_tail(&free_list_[node], &page->queue_node);
+                }
+                free_count_[node]++;
+            } else {
+                page->numa_node = node;
+            }
+            tagged++;
+        }
+
+        // an arena is reported as belonging to the node that owns its first page
+        if (a.init_page_count() > 0) {
+            a.set_numa_node(a.get_page(0)->numa_node);
+        } else if (start == a.base()) {
+            a.set_numa_node(node);
+        }
+    }
+
+    if (node >= numa_node_count_) {
+        numa_node_count_ = node + 1;
+    }
+
+    LTRACEF("tagged %zu pages in [%#" PRIxPTR ", %#" PRIxPTR ") as node %u\n",
+            tagged, base, base + size, node);
+
+    return ZX_OK;
+}
+
+zx_status_t PmmNode::SetCpuNumaNode(cpu_num_t cpu, uint32_t node) {
+    if (cpu >= SMP_MAX_CPUS || node >= PMM_MAX_NUMA_NODES) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+
+    Guard<fbl::Mutex> guard{&lock_};
+    cpu_numa_node_[cpu] = node;
+    if (node >= numa_node_count_) {
+        numa_node_count_ = node + 1;
+    }
+    return ZX_OK;
+}
+
+zx_status_t PmmNode::AllocPage(uint alloc_flags, vm_page_t** page_out, paddr_t* pa_out) {
+    uint32_t node = PreferredNode(alloc_flags);
+
+    vm_page* page = nullptr;
+    if (alloc_flags & PMM_ALLOC_FLAG_PREFER_ZEROED) {
+        page = AllocZeroedPage(node);
+    }
+    if (!page && likely(node == cpu_numa_node_[arch_curr_cpu_num()])) {
+        page = CacheAllocPage();
+    }
+    if (!page) {
+        page = CacheRefillAndAllocPage(node);
+        if (!page) {
+            return ZX_ERR_NO_MEMORY;
+        }
+    }
 
     set_state_alloc(page);
 
@@ -123,6 +446,119 @@ zx_status_t PmmNode::AllocPage(uint alloc_flags, vm_page_t** page_out, paddr_t*
     return ZX_OK;
 }
 
+// take a page off of |node|'s zeroed list, if it has any. pages from the
+// per-cpu caches are never zeroed, so this has to go to the node lists.
+vm_page* PmmNode::AllocZeroedPage(uint32_t node) {
+    // avoid the lock entirely if it looks like there is nothing to be had
+    bool empty = [this, node]() TA_NO_THREAD_SAFETY_ANALYSIS {
+        return zeroed_count_[node] == 0;
+    }();
+    if (empty) {
+        kcounter_add(pmm_zero_alloc_miss, 1);
+        return nullptr;
+    }
+
+    Guard<fbl::Mutex> guard{&lock_};
+    vm_page* page = list_remove_head_type(&zeroed_list_[node], vm_page, queue_node);
+    if (!page) {
+        kcounter_add(pmm_zero_alloc_miss, 1);
+        return nullptr;
+    }
+    DEBUG_ASSERT(page->is_free() && page->zeroed);
+    DEBUG_ASSERT(free_count_[node] > 0 && zeroed_count_[node] > 0);
+    free_count_[node]--;
+    zeroed_count_[node]--;
+    kcounter_add(pmm_zero_alloc_hit, 1);
+    return page;
+}
+
+// pop a page off of the current cpu's cache, if it has any
+vm_page* PmmNode::CacheAllocPage() {
+    // it doesn't matter if we migrate after reading the cpu number, the cache
+    // lock keeps things consistent and being off by a cpu is harmless.
+    PageCache& cache = page_caches_[arch_curr_cpu_num()];
+
+    Guard<SpinLock, IrqSave> guard{&cache.lock};
+    vm_page* page = list_remove_head_type(&cache.pages, vm_page, queue_node);
+    if (page) {
+        DEBUG_ASSERT(cache.count > 0);
+        DEBUG_ASSERT(page->state == VM_PAGE_STATE_CACHED);
+        cache.count--;
+        kcounter_add(pmm_cache_alloc_hit, 1);
+    }
+    return page;
+}
+
+// the current cpu's cache is empty (or the caller wants a page from a remote
+// node); pull a page off of |node|'s free list. For local allocations also
+// grab a batch of pages to stash in the cache.
+vm_page* PmmNode::CacheRefillAndAllocPage(uint32_t node) {
+    list_node batch = LIST_INITIAL_VALUE(batch);
+    vm_page* page = nullptr;
+    cpu_num_t cpu = arch_curr_cpu_num();
+    bool refill = (node == cpu_numa_node_[cpu]);
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        {
+            Guard<fbl::Mutex> guard{&lock_};
+
+            page = RemoveFreePageLocked(node, false);
+            if (page) {
+                // only stock the cache with pages that are actually local
+                for (size_t i = 1; refill && i < kPageCacheBatch; i++) {
+                    vm_page* p = list_remove_head_type(&free_list_[node], vm_page, queue_node);
+                    if (!p) {
+                        break;
+                    }
+                    DEBUG_ASSERT(free_count_[node] > 0);
+                    free_count_[node]--;
+                    DEBUG_ASSERT(p->is_free());
+                    p->state = VM_PAGE_STATE_CACHED;
+                    list_add_tail(&batch, &p->queue_node);
+                }
+                break;
+            }
+        }
+
+        // the node is out of pages, reclaim whatever the other cpus have parked
+        // and try one more time
+        if (FlushPageCaches() == 0) {
+            break;
+        }
+    }
+
+    if (!page) {
+        return nullptr;
+    }
+
+    if (list_is_empty(&batch)) {
+        return page;
+    }
+
+    kcounter_add(pmm_cache_refill, 1);
+
+    PageCache& cache = page_caches_[cpu];
+    {
+        Guard<SpinLock, IrqSave> guard{&cache.lock};
+        while (cache.count < kPageCacheCapacity) {
+            vm_page* p = list_remove_head_type(&batch, vm_page, queue_node);
+            if (!p) {
+                break;
+            }
+            list_add_tail(&cache.pages, &p->queue_node);
+            cache.count++;
+        }
+    }
+
+    // someone else filled the cache while we weren't looking, give the rest back
+    if (!list_is_empty(&batch)) {
+        Guard<fbl::Mutex> guard{&lock_};
+        FreeListLocked(&batch);
+    }
+
+    return page;
+}
+
 zx_status_t PmmNode::AllocPages(size_t count, uint alloc_flags, list_node* list) {
     LTRACEF("count %zu\n", count);
 
@@ -133,10 +569,28 @@ zx_status_t PmmNode::AllocPages(size_t count, uint alloc_flags, list_node* list)
         return ZX_OK;
     }
 
-    Guard<fbl::Mutex> guard{&lock_};
+    uint32_t node = PreferredNode(alloc_flags);
+    bool prefer_zeroed = (alloc_flags & PMM_ALLOC_FLAG_PREFER_ZEROED) != 0;
 
+    for (int attempt = 0;; attempt++) {
+        {
+            Guard<fbl::Mutex> guard{&lock_};
+            if (AllocPagesLocked(count, node, prefer_zeroed, list) == ZX_OK) {
+                return ZX_OK;
+            }
+        }
+
+        // the node free list ran dry; reclaim pages parked in the per-cpu caches and retry
+        if (attempt > 0 || FlushPageCaches() == 0) {
+            return ZX_ERR_NO_MEMORY;
+        }
+    }
+}
+
+zx_status_t PmmNode::AllocPagesLocked(size_t count, uint32_t node, bool prefer_zeroed,
+                                      list_node* list) {
     while (count > 0) {
-        vm_page* page = list_remove_head_type(&free_list_, vm_page, queue_node);
+        vm_page* page = RemoveFreePageLocked(node, prefer_zeroed);
         if (unlikely(!page)) {
             // free pages that have already been allocated
             FreeListLocked(list);
@@ -145,11 +599,6 @@ zx_status_t PmmNode::AllocPages(size_t count, uint alloc_flags, list_node* list)
 
         LTRACEF("allocating page %p, pa %#" PRIxPTR "\n", page, page->paddr());
 
-        DEBUG_ASSERT(free_count_ > 0);
-
-        free_count_--;
-
-        DEBUG_ASSERT(page->is_free());
 #if PMM_ENABLE_FREE_FILL
         CheckFreeFill(page);
 #endif
@@ -169,14 +618,29 @@ zx_status_t PmmNode::AllocRange(paddr_t address, size_t count, list_node* list)
     // list must be initialized prior to calling this
     DEBUG_ASSERT(list);
 
-    size_t allocated = 0;
     if (count == 0) {
         return ZX_OK;
     }
 
     address = ROUNDDOWN(address, PAGE_SIZE);
 
-    Guard<fbl::Mutex> guard{&lock_};
+    for (int attempt = 0;; attempt++) {
+        {
+            Guard<fbl::Mutex> guard{&lock_};
+            if (AllocRangeLocked(address, count, list) == ZX_OK) {
+                return ZX_OK;
+            }
+        }
+
+        // some of the pages may be sitting in a per-cpu cache, pull them back and retry
+        if (attempt > 0 || FlushPageCaches() == 0) {
+            return ZX_ERR_NOT_FOUND;
+        }
+    }
+}
+
+zx_status_t PmmNode::AllocRangeLocked(paddr_t address, size_t count, list_node* list) {
+    size_t allocated = 0;
 
     // walk through the arenas, looking to see if the physical page belongs to it
     for (auto& a : arena_list_) {
@@ -190,7 +654,7 @@ zx_status_t PmmNode::AllocRange(paddr_t address, size_t count, list_node* list)
                 break;
             }
 
-            list_delete(&page->queue_node);
+            RemoveSpecificFreePageLocked(page);
 
             page->state = VM_PAGE_STATE_ALLOC;
 
@@ -198,7 +662,6 @@ zx_status_t PmmNode::AllocRange(paddr_t address, size_t count, list_node* list)
 
             allocated++;
             address += PAGE_SIZE;
-            free_count_--;
         }
 
         if (allocated == count) {
@@ -230,39 +693,60 @@ zx_status_t PmmNode::AllocContiguous(const size_t count, uint alloc_flags, uint8
     DEBUG_ASSERT(pa);
     DEBUG_ASSERT(list);
 
-    Guard<fbl::Mutex> guard{&lock_};
+    uint32_t node = PreferredNode(alloc_flags);
 
-    for (auto& a : arena_list_) {
-        vm_page_t* p = a.FindFreeContiguous(count, alignment_log2);
-        if (!p) {
-            continue;
+    for (int attempt = 0;; attempt++) {
+        {
+            Guard<fbl::Mutex> guard{&lock_};
+            if (AllocContiguousLocked(count, alignment_log2, node, pa, list) == ZX_OK) {
+                return ZX_OK;
+            }
         }
 
-        *pa = p->paddr();
+        // pages held in the per-cpu caches may be fragmenting the run, return them and retry
+        if (attempt > 0 || FlushPageCaches() == 0) {
+            break;
+        }
+    }
+
+    LTRACEF("couldn't find run\n");
+    return ZX_ERR_NOT_FOUND;
+}
 
-        // remove the pages from the run out of the free list
-        for (size_t i = 0; i < count; i++, p++) {
-            DEBUG_ASSERT_MSG(p->is_free(), "p %p state %u\n", p, p->state);
-            DEBUG_ASSERT(list_in_list(&p->queue_node));
+zx_status_t PmmNode::AllocContiguousLocked(size_t count, uint8_t alignment_log2, uint32_t node,
+                                           paddr_t* pa, list_node* list) {
+    // first look in the arenas local to |node|, then anywhere
+    for (int pass = 0; pass < 2; pass++) {
+        for (auto& a : arena_list_) {
+            if ((pass == 0) != (a.numa_node() == node)) {
+                continue;
+            }
+
+            vm_page_t* p = a.FindFreeContiguous(count, alignment_log2);
+            if (!p) {
+                continue;
+            }
 
-            list_delete(&p->queue_node);
-            p->state = VM_PAGE_STATE_ALLOC;
+            *pa = p->paddr();
 
-            DEBUG_ASSERT(free_count_ > 0);
+            // remove the pages from the run out of the free list
+            for (size_t i = 0; i < count; i++, p++) {
+                DEBUG_ASSERT_MSG(p->is_free(), "p %p state %u\n", p, p->state);
 
-            free_count_--;
+                RemoveSpecificFreePageLocked(p);
+                p->state = VM_PAGE_STATE_ALLOC;
 
 #if PMM_ENABLE_FREE_FILL
-            CheckFreeFill(p);
+                CheckFreeFill(p);
 #endif
 
-            list_add_tail(list, &p->queue_node);
-        }
+                list_add_tail(list, &p->queue_node);
+            }
 
-        return ZX_OK;
+            return ZX_OK;
+        }
     }
 
-    LTRACEF("couldn't find run\n");
     return ZX_ERR_NOT_FOUND;
 }
 
@@ -281,19 +765,174 @@ void PmmNode::FreePageLocked(vm_page* page) {
         list_delete(&page->queue_node);
     }
 
-    // mark it free
-    page->state = VM_PAGE_STATE_FREE;
+    // mark it free and add it to its node's free queue
+    InsertFreePageLocked(page);
+}
+
+void PmmNode::FreePage(vm_page* page) {
+    CacheFreePage(page);
+}
 
-    // add it to the free queue
-    list_add_head(&free_list_, &page->queue_node);
+// park a page in the current cpu's cache, draining a batch back to the node
+// free list if the cache overflows
+void PmmNode::CacheFreePage(vm_page* page) {
+    LTRACEF("page %p state %u paddr %#" PRIxPTR "\n", page, page->state, page->paddr());
+
+    DEBUG_ASSERT(page->state != VM_PAGE_STATE_OBJECT || page->object.pin_count == 0);
+    DEBUG_ASSERT(!page->is_free() && page->state != VM_PAGE_STATE_CACHED);
+
+#if PMM_ENABLE_FREE_FILL
+    FreeFill(page);
+#endif
 
-    free_count_++;
+    // remove it from its old queue
+    if (list_in_list(&page->queue_node)) {
+        list_delete(&page->queue_node);
+    }
+
+    // whatever the page was used for, it can't be assumed to be zero anymore
+    page->zeroed = 0;
+
+    // remote pages go straight back to their own node
+    cpu_num_t cpu = arch_curr_cpu_num();
+    if (page->numa_node != cpu_numa_node_[cpu]) {
+        Guard<fbl::Mutex> guard{&lock_};
+        InsertFreePageLocked(page);
+        return;
+    }
+
+    list_node drain = LIST_INITIAL_VALUE(drain);
+    PageCache& cache = page_caches_[cpu];
+    {
+        Guard<SpinLock, IrqSave> guard{&cache.lock};
+
+        page->state = VM_PAGE_STATE_CACHED;
+        list_add_head(&cache.pages, &page->queue_node);
+        cache.count++;
+
+        if (cache.count <= kPageCacheCapacity) {
+            return;
+        }
+
+        // the coldest pages are at the tail
+        for (size_t i = 0; i < kPageCacheBatch; i++) {
+            vm_page* p = list_remove_tail_type(&cache.pages, vm_page, queue_node);
+            list_add_head(&drain, &p->queue_node);
+        }
+        cache.count -= kPageCacheBatch;
+    }
+
+    kcounter_add(pmm_cache_drain, 1);
+
+    Guard<fbl::Mutex> guard{&lock_};
+    while ((page = list_remove_head_type(&drain, vm_page, queue_node)) != nullptr) {
+        InsertFreePageLocked(page);
+    }
 }
 
-void PmmNode::FreePage(vm_page* page) {
+size_t PmmNode::FlushPageCaches() {
+    list_node flush = LIST_INITIAL_VALUE(flush);
+    size_t flushed = 0;
+
+    for (auto& cache : page_caches_) {
+        Guard<SpinLock, IrqSave> guard{&cache.lock};
+        if (cache.count == 0) {
+            continue;
+        }
+        flushed += cache.count;
+        list_splice_after(&cache.pages, &flush);
+        cache.count = 0;
+    }
+
+    if (flushed == 0) {
+        return 0;
+    }
+
+    kcounter_add(pmm_cache_flush, 1);
+
     Guard<fbl::Mutex> guard{&lock_};
+    vm_page* page;
+    while ((page = list_remove_head_type(&flush, vm_page, queue_node)) != nullptr) {
+        DEBUG_ASSERT(page->state == VM_PAGE_STATE_CACHED);
+        InsertFreePageLocked(page);
+    }
+
+    return flushed;
+}
+
+void PmmNode::StartZeroingThread() {
+    DEBUG_ASSERT(!zeroing_thread_);
+
+    zeroing_thread_ = thread_create("pmm zeroing", &PmmNode::ZeroingThread, this,
+                                    LOWEST_PRIORITY);
+    if (!zeroing_thread_) {
+        printf("PMM: failed to create zeroing thread\n");
+        return;
+    }
+    thread_detach_and_resume(zeroing_thread_);
+}
+
+int PmmNode::ZeroingThread(void* arg) {
+    PmmNode* pmm = static_cast<PmmNode*>(arg);
+
+    for (;;) {
+        if (pmm->ZeroFreePages() == 0) {
+            event_wait(&pmm->zeroing_event_);
+        }
+    }
+
+    return 0;
+}
 
-    FreePageLocked(page);
+// zero a batch of free pages that aren't known to be zero yet, returning how
+// many were zeroed. if there are none left, arrange to be woken up once more
+// pages get freed.
+size_t PmmNode::ZeroFreePages() {
+    list_node batch = LIST_INITIAL_VALUE(batch);
+    size_t count = 0;
+
+    {
+        Guard<fbl::Mutex> guard{&lock_};
+        for (uint32_t node = 0; node < numa_node_count_ && count < kZeroBatch; node++) {
+            while (count < kZeroBatch) {
+                // the coldest pages are at the tail
+                vm_page* page = list_remove_tail_type(&free_list_[node], vm_page, queue_node);
+                if (!page) {
+                    break;
+                }
+                DEBUG_ASSERT(page->is_free() && !page->zeroed);
+                DEBUG_ASSERT(free_count_[node] > 0);
+                free_count_[node]--;
+
+                // keep range and contiguous allocations from finding the page while
+                // it is being zeroed
+                page->state = VM_PAGE_STATE_ALLOC;
+                list_add_tail(&batch, &page->queue_node);
+                count++;
+            }
+        }
+
+        if (count == 0) {
+            zeroing_thread_waiting_ = true;
+            freed_since_zeroing_ = 0;
+            return 0;
+        }
+    }
+
+    vm_page* page;
+    list_for_every_entry (&batch, page, vm_page, queue_node) {
+        arch_zero_page(paddr_to_physmap(page->paddr()));
+    }
+
+    {
+        Guard<fbl::Mutex> guard{&lock_};
+        while ((page = list_remove_head_type(&batch, vm_page, queue_node)) != nullptr) {
+            InsertZeroedPageLocked(page);
+        }
+    }
+
+    kcounter_add(pmm_zero_pages, count);
+    return count;
 }
 
 void PmmNode::FreeListLocked(list_node* list) {
@@ -314,7 +953,38 @@ void PmmNode::FreeList(list_node* list) {
 
 // okay if accessed outside of a lock
 uint64_t PmmNode::CountFreePages() const TA_NO_THREAD_SAFETY_ANALYSIS {
-    return free_count_;
+    uint64_t count = 0;
+    for (auto c : free_count_) {
+        count += c;
+    }
+    for (const auto& cache : page_caches_) {
+        count += cache.count;
+    }
+    return count;
+}
+
+// okay if accessed outside of a lock
+uint64_t PmmNode::CountZeroedPages() const TA_NO_THREAD_SAFETY_ANALYSIS {
+    uint64_t count = 0;
+    for (auto c : zeroed_count_) {
+        count += c;
+    }
+    return count;
+}
+
+// okay if accessed outside of a lock
+uint64_t PmmNode::CountFreePagesNode(uint32_t node) const TA_NO_THREAD_SAFETY_ANALYSIS {
+    if (node >= PMM_MAX_NUMA_NODES) {
+        return 0;
+    }
+
+    uint64_t count = free_count_[node];
+    for (size_t i = 0; i < fbl::count_of(page_caches_); i++) {
+        if (cpu_numa_node_[i] == node) {
+            count += page_caches_[i].count;
+        }
+    }
+    return count;
 }
 
 uint64_t PmmNode::CountTotalBytes() const TA_NO_THREAD_SAFETY_ANALYSIS {
@@ -338,8 +1008,18 @@ void PmmNode::DumpFree() const TA_NO_THREAD_SAFETY_ANALYSIS {
 void PmmNode::Dump(bool is_panic) const {
     // No lock analysis here, as we want to just go for it in the panic case without the lock.
     auto dump = [this]() TA_NO_THREAD_SAFETY_ANALYSIS {
+        uint64_t free_count = CountFreePages();
         printf("pmm node %p: free_count %zu (%zu bytes), total size %zu\n",
-               this, free_count_, free_count_ * PAGE_SIZE, arena_cumulative_size_);
+               this, free_count, free_count * PAGE_SIZE, arena_cumulative_size_);
+        for (uint32_t i = 0; i < numa_node_count_; i++) {
+            printf("\tnuma node %u free_count %zu zeroed %zu\n", i, free_count_[i],
+                   zeroed_count_[i]);
+        }
+        for (size_t i = 0; i < fbl::count_of(page_caches_); i++) {
+            if (page_caches_[i].count) {
+                printf("\tcpu %zu cached %zu\n", i, page_caches_[i].count);
+            }
+        }
         for (auto& a : arena_list_) {
             a.Dump(false, false);
         }
@@ -358,8 +1038,16 @@ void PmmNode::EnforceFill() {
     DEBUG_ASSERT(!enforce_fill_);
 
     vm_page* page;
-    list_for_every_entry (&free_list_, page, vm_page, queue_node) {
-        FreeFill(page);
+    for (auto& list : free_list_) {
+        list_for_every_entry (&list, page, vm_page, queue_node) {
+            FreeFill(page);
+        }
+    }
+    // the zeroing thread is never started when filling, but be thorough
+    for (auto& list : zeroed_list_) {
+        list_for_every_entry (&list, page, vm_page, queue_node) {
+            FreeFill(page);
+        }
     }
 
     enforce_fill_ = true;
@@ -9,7 +9,11 @@
 #include <fbl/intrusive_double_list.h>
 #include <fbl/mutex.h>
 
+#include <kernel/align.h>
+#include <kernel/event.h>
 #include <kernel/lockdep.h>
+#include <kernel/spinlock.h>
+#include <kernel/thread.h>
 #include <vm/pmm.h>
 
 #include "pmm_arena.h"
@@ -17,7 +21,8 @@
 #define PMM_ENABLE_FREE_FILL 0
 #define PMM_FREE_FILL_BYTE 0x42
 
-// per numa node collection of pmm arenas and worker threads
+// collection of pmm arenas and worker threads. free pages are kept on a
+// separate list per numa node so allocations can prefer local memory.
 class PmmNode {
 public:
     PmmNode();
@@ -37,6 +42,8 @@ public:
     void FreeList(list_node* list);
 
     uint64_t CountFreePages() const;
+    uint64_t CountZeroedPages() const;
+    uint64_t CountFreePagesNode(uint32_t node) const;
     uint64_t CountTotalBytes() const;
     void CountTotalStates(uint64_t state_count[VM_PAGE_STATE_COUNT_]) const;
 
@@ -52,10 +59,94 @@ public:
 
     zx_status_t AddArena(const pmm_arena_info_t* info);
 
+    // set up the pages that AddArena() deferred, spread over the online
+    // cpus, and make them available
+    void InitDeferredPages();
+
     // add new pages to the free queue. used when boostrapping a PmmArena
     void AddFreePages(list_node* list);
 
+    // return every page parked in the per-cpu caches to the node free list.
+    // returns the number of pages that were returned.
+    size_t FlushPageCaches();
+
+    // numa topology, see pmm.h
+    zx_status_t SetNumaNodeRange(paddr_t base, size_t size, uint32_t node);
+    zx_status_t SetCpuNumaNode(cpu_num_t cpu, uint32_t node);
+    uint32_t NumaNodeCount() const { return numa_node_count_; }
+
+    // start the low priority thread that zeroes free pages in the background
+    void StartZeroingThread();
+
 private:
+    // Each cpu keeps a small magazine of free pages so that single page
+    // allocations and frees usually only touch a cpu-local spinlock. The
+    // magazine is refilled from and drained to the node free list
+    // kPageCacheBatch pages at a time, and never holds more than
+    // kPageCacheCapacity pages.
+    static constexpr size_t kPageCacheBatch = 32;
+    static constexpr size_t kPageCacheCapacity = 2 * kPageCacheBatch;
+
+    struct PageCache {
+        DECLARE_SPINLOCK(PageCache) lock;
+        list_node pages TA_GUARDED(lock) = LIST_INITIAL_VALUE(pages);
+        size_t count TA_GUARDED(lock) = 0;
+    } __CPU_ALIGN;
+
+    vm_page* CacheAllocPage();
+    vm_page* CacheRefillAndAllocPage(uint32_t node);
+    void CacheFreePage(vm_page* page);
+
+    uint32_t PreferredNode(uint alloc_flags) const;
+    vm_page* AllocZeroedPage(uint32_t node);
+    vm_page* RemoveFreePageLocked(uint32_t preferred, bool prefer_zeroed) TA_REQ(lock_);
+    void RemoveSpecificFreePageLocked(vm_page* page) TA_REQ(lock_);
+    void InsertFreePageLocked(vm_page* page) TA_REQ(lock_);
+    void InsertZeroedPageLocked(vm_page* page) TA_REQ(lock_);
+
+    // The zeroing thread takes up to kZeroBatch dirty pages off of the free
+    // lists at a time, zeroes them without holding lock_, and returns them to
+    // the zeroed lists. It sleeps once every free page is zeroed and is woken
+    // once kZeroBatch pages have been freed since.
+    static constexpr size_t kZeroBatch = 16;
+
+    static int ZeroingThread(void* arg);
+    size_t ZeroFreePages();
+
+    // While the boot cpu is alone, arenas only set up the vm_page_t of the
+    // first kernel.pmm.eager-init-mb of memory (in all), which is plenty to
+    // boot with. InitDeferredPages() sets up the rest in chunks of
+    // kDeferredChunkPages, each on whichever cpu gets to it first, into
+    // free lists of their own. Those are spliced onto the node free lists
+    // only once every chunk is done, so no page is handed out before
+    // lookups by address can find it.
+    static constexpr uint64_t kDefaultEagerInitMB = 4096;
+    static constexpr uint64_t kMinEagerInitMB = 256;
+    static constexpr size_t kDeferredChunkPages = (1024 * MB) / PAGE_SIZE;
+
+    struct DeferredChunk;
+    static void InitDeferredChunk(size_t index, void* arg);
+    void InitDeferredChunk(DeferredChunk* chunk);
+
+    // pages set up by AddArena() so far
+    size_t eager_init_pages_ = 0;
+
+    // numa ranges tagged by SetNumaNodeRange() that cover deferred pages,
+    // applied as the pages are set up
+    struct NumaRange {
+        paddr_t base;
+        size_t size;
+        uint32_t node;
+    };
+    static constexpr size_t kMaxDeferredNumaRanges = 32;
+    NumaRange deferred_numa_ranges_[kMaxDeferredNumaRanges] TA_GUARDED(lock_) = {};
+    size_t deferred_numa_range_count_ TA_GUARDED(lock_) = 0;
+
+    zx_status_t AllocPagesLocked(size_t count, uint32_t node, bool prefer_zeroed,
+                                 list_node* list) TA_REQ(lock_);
+    zx_status_t AllocRangeLocked(paddr_t address, size_t count, list_node* list) TA_REQ(lock_);
+    zx_status_t AllocContiguousLocked(size_t count, uint8_t alignment_log2, uint32_t node,
+                                      paddr_t* pa, list_node* list) TA_REQ(lock_);
     void FreePageLocked(vm_page* page) TA_REQ(lock_);
     void FreeListLocked(list_node* list) TA_REQ(lock_);
 
@@ -64,17 +155,31 @@ private:
     mutable DECLARE_MUTEX(PmmNode) lock_;
 
     uint64_t arena_cumulative_size_ TA_GUARDED(lock_) = 0;
-    uint64_t free_count_ TA_GUARDED(lock_) = 0;
+    uint64_t free_count_[PMM_MAX_NUMA_NODES] TA_GUARDED(lock_) = {};
+
+    // written under lock_ once at boot, read locklessly on the allocation paths
+    uint32_t numa_node_count_ = 1;
+    uint32_t cpu_numa_node_[SMP_MAX_CPUS] = {};
 
     fbl::DoublyLinkedList<PmmArena*> arena_list_ TA_GUARDED(lock_);
 
-    // page queues
-    list_node free_list_ TA_GUARDED(lock_) = LIST_INITIAL_VALUE(free_list_);
+    // page queues. free pages whose contents are known to be zero are kept
+    // apart from the rest; free_count_ counts both.
+    list_node free_list_[PMM_MAX_NUMA_NODES] TA_GUARDED(lock_);
+    list_node zeroed_list_[PMM_MAX_NUMA_NODES] TA_GUARDED(lock_);
+    uint64_t zeroed_count_[PMM_MAX_NUMA_NODES] TA_GUARDED(lock_) = {};
     list_node inactive_list_ TA_GUARDED(lock_) = LIST_INITIAL_VALUE(inactive_list_);
     list_node active_list_ TA_GUARDED(lock_) = LIST_INITIAL_VALUE(active_list_);
     list_node modified_list_ TA_GUARDED(lock_) = LIST_INITIAL_VALUE(modified_list_);
     list_node wired_list_ TA_GUARDED(lock_) = LIST_INITIAL_VALUE(wired_list_);
 
+    PageCache page_caches_[SMP_MAX_CPUS];
+
+    thread_t* zeroing_thread_ = nullptr;
+    event_t zeroing_event_ = EVENT_INITIAL_VALUE(zeroing_event_, false, EVENT_FLAG_AUTOUNSIGNAL);
+    bool zeroing_thread_waiting_ TA_GUARDED(lock_) = false;
+    size_t freed_since_zeroing_ TA_GUARDED(lock_) = 0;
+
 #if PMM_ENABLE_FREE_FILL
     void FreeFill(vm_page_t* page);
     void CheckFreeFill(vm_page_t* page);
@@ -84,10 +189,14 @@ private:
 };
 
 // We don't need to hold the arena lock while executing this, since it is
-// only accesses values that are set once during system initialization.
+// only accesses values that are set once during system initialization. The
+// deferred pages become visible before any of them can be allocated.
 inline vm_page_t* PmmNode::PaddrToPage(paddr_t addr) TA_NO_THREAD_SAFETY_ANALYSIS {
     for (auto& a : arena_list_) {
         if (a.address_in_arena(addr)) {
+            if (!a.page_initialized(addr)) {
+                return nullptr;
+            }
             size_t index = (addr - a.base()) / PAGE_SIZE;
             return a.get_page(index);
         }
@@ -10,7 +10,9 @@
 #include <assert.h>
 #include <err.h>
 #include <fbl/alloc_checker.h>
+#include <fbl/auto_call.h>
 #include <inttypes.h>
+#include <lib/counters.h>
 #include <lib/vdso.h>
 #include <pow2.h>
 #include <trace.h>
@@ -21,6 +23,8 @@
 
 #define LOCAL_TRACE MAX(VM_GLOBAL_TRACE, 0)
 
+KCOUNTER(vm_unmap_coalesced, "kernel.vm.unmap.coalesced");
+
 VmAddressRegion::VmAddressRegion(VmAspace& aspace, vaddr_t base, size_t size, uint32_t vmar_flags)
     : VmAddressRegionOrMapping(base, size, vmar_flags | VMAR_CAN_RWX_FLAGS,
                                &aspace, nullptr) {
@@ -378,14 +382,14 @@ size_t VmAddressRegion::AllocatedPagesLocked() const {
     return sum;
 }
 
-zx_status_t VmAddressRegion::PageFault(vaddr_t va, uint pf_flags) {
+zx_status_t VmAddressRegion::PageFault(vaddr_t va, uint pf_flags, PageRequest* page_request) {
     canary_.Assert();
     DEBUG_ASSERT(aspace_->lock()->lock().IsHeld());
 
     auto vmar = WrapRefPtr(this);
     while (auto next = vmar->FindRegionLocked(va)) {
         if (next->is_mapping()) {
-            return next->PageFault(va, pf_flags);
+            return next->PageFault(va, pf_flags, page_request);
         }
         vmar = next->as_vm_address_region();
     }
@@ -530,13 +534,13 @@ zx_status_t VmAddressRegion::AllocSpotLocked(size_t size, uint8_t align_pow2, ui
     return LinearRegionAllocatorLocked(size, align_pow2, arch_mmu_flags, spot);
 }
 
-bool VmAddressRegion::EnumerateChildrenLocked(VmEnumerator* ve, uint depth) {
+bool VmAddressRegion::EnumerateChildrenLocked(VmEnumerator* ve, uint depth, vaddr_t start) {
     canary_.Assert();
     DEBUG_ASSERT(ve != nullptr);
     DEBUG_ASSERT(aspace_->lock()->lock().IsHeld());
 
     const uint min_depth = depth;
-    for (auto itr = subregions_.begin(), end = subregions_.end(); itr != end;) {
+    for (auto itr = UpperBoundInternalLocked(start), end = subregions_.end(); itr != end;) {
         DEBUG_ASSERT(itr->IsAliveLocked());
         auto curr = itr++;
         VmAddressRegion* up = curr->parent_;
@@ -553,9 +557,13 @@ bool VmAddressRegion::EnumerateChildrenLocked(VmEnumerator* ve, uint depth) {
             if (!ve->OnVmAddressRegion(vmar, depth)) {
                 return false;
             }
-            if (!vmar->subregions_.is_empty()) {
-                // If the sub-VMAR is not empty, iterate through its children.
-                itr = vmar->subregions_.begin();
+            // Siblings never overlap, so only the sub-VMARs which contain
+            // |start| can have children before it.
+            auto first = vmar->UpperBoundInternalLocked(start);
+            if (first.IsValid()) {
+                // If the sub-VMAR has children after |start|, iterate through
+                // them.
+                itr = first;
                 end = vmar->subregions_.end();
                 depth++;
                 continue;
@@ -690,6 +698,20 @@ zx_status_t VmAddressRegion::UnmapInternalLocked(vaddr_t base, size_t size,
         }
     }
 
+    // If more than one subregion is involved, clear every page table entry in
+    // the range up front with a single arch unmap, so that all of the TLB
+    // invalidations go out in one shootdown round instead of one per mapping.
+    // Everything mapped in the range is about to be unmapped below anyway, and
+    // doing it first ensures no pages can be released by the mappings' objects
+    // while stale translations for them remain.
+    auto second = begin;
+    if (second != end && ++second != end) {
+        __UNUSED zx_status_t status = aspace_->arch_aspace().Unmap(base, size / PAGE_SIZE,
+                                                                   nullptr);
+        DEBUG_ASSERT(status == ZX_OK);
+        kcounter_add(vm_unmap_coalesced, 1);
+    }
+
     bool at_top = true;
     for (auto itr = begin; itr != end;) {
         // Create a copy of the iterator, in case we destroy this element
@@ -822,6 +844,11 @@ zx_status_t VmAddressRegion::Protect(vaddr_t base, size_t size, uint new_arch_mm
         return ZX_ERR_NOT_FOUND;
     }
 
+    // Changing permissions never frees any pages, so the TLB invalidations for
+    // all of the mappings involved can safely be performed together at the end.
+    aspace_->arch_aspace().BeginTlbBatch();
+    auto end_batch = fbl::MakeAutoCall([this]() { aspace_->arch_aspace().EndTlbBatch(); });
+
     for (auto itr = begin; itr != end;) {
         DEBUG_ASSERT(itr->is_mapping());
 
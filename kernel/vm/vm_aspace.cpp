@@ -26,6 +26,8 @@
 #include <string.h>
 #include <trace.h>
 #include <vm/fault.h>
+#include <vm/page_source.h>
+#include <vm/pmm.h>
 #include <vm/vm.h>
 #include <vm/vm_address_region.h>
 #include <vm/vm_object.h>
@@ -557,12 +559,28 @@ zx_status_t VmAspace::PageFault(vaddr_t va, uint flags) {
         flags |= VMM_PF_FLAG_GUEST;
     }
 
-    // for now, hold the aspace lock across the page fault operation,
-    // which stops any other operations on the address space from moving
-    // the region out from underneath it
-    Guard<fbl::Mutex> guard{&lock_};
+    PageRequest page_request;
+    for (;;) {
+        zx_status_t status;
+        {
+            // for now, hold the aspace lock across the page fault operation,
+            // which stops any other operations on the address space from moving
+            // the region out from underneath it
+            Guard<fbl::Mutex> guard{&lock_};
+
+            status = root_vmar_->PageFault(va, flags, &page_request);
+        }
+        if (status != ZX_ERR_SHOULD_WAIT) {
+            return status;
+        }
 
-    return root_vmar_->PageFault(va, flags);
+        // the page is coming from a page source; wait for it with no locks held
+        // and fault again, since the mapping may have changed meanwhile
+        status = page_request.Wait();
+        if (status != ZX_OK) {
+            return status;
+        }
+    }
 }
 
 void VmAspace::Dump(bool verbose) const {
@@ -577,7 +595,7 @@ void VmAspace::Dump(bool verbose) const {
     }
 }
 
-bool VmAspace::EnumerateChildren(VmEnumerator* ve) {
+bool VmAspace::EnumerateChildren(VmEnumerator* ve, vaddr_t start) {
     canary_.Assert();
     DEBUG_ASSERT(ve != nullptr);
     Guard<fbl::Mutex> guard{&lock_};
@@ -589,7 +607,7 @@ bool VmAspace::EnumerateChildren(VmEnumerator* ve) {
     if (!ve->OnVmAddressRegion(root_vmar_.get(), 0)) {
         return false;
     }
-    return root_vmar_->EnumerateChildrenLocked(ve, 1);
+    return root_vmar_->EnumerateChildrenLocked(ve, 1, start);
 }
 
 void DumpAllAspaces(bool verbose) {
@@ -600,6 +618,28 @@ void DumpAllAspaces(bool verbose) {
     }
 }
 
+// Runs under the page table lock of the aspace mapping |pa|, which keeps the
+// page from being unmapped and freed.
+static void MarkPageAccessed(void* context, paddr_t pa) {
+    vm_page_t* p = paddr_to_vm_page(pa);
+    if (p && p->state == VM_PAGE_STATE_OBJECT) {
+        __atomic_store_n(&p->object.accessed, 1, __ATOMIC_RELAXED);
+    }
+}
+
+void VmAspace::HarvestAllAccessed() {
+    // Holding the list lock keeps every aspace's arch portion alive, since
+    // the destructor leaves the list before destroying it.
+    Guard<fbl::Mutex> guard{&aspace_list_lock};
+
+    for (auto& a : aspaces) {
+        if (a.is_user()) {
+            a.arch_aspace().HarvestAccessed(a.base(), a.size() / PAGE_SIZE,
+                                            MarkPageAccessed, nullptr);
+        }
+    }
+}
+
 VmAspace* VmAspace::vaddr_to_aspace(uintptr_t address) {
     if (is_kernel_address(address)) {
         return kernel_aspace();
@@ -9,9 +9,13 @@
 #include "vm_priv.h"
 #include <assert.h>
 #include <err.h>
+#include <fbl/algorithm.h>
 #include <fbl/alloc_checker.h>
 #include <fbl/auto_call.h>
 #include <inttypes.h>
+#include <kernel/cmdline.h>
+#include <lib/counters.h>
+#include <lk/init.h>
 #include <trace.h>
 #include <vm/fault.h>
 #include <vm/vm.h>
@@ -21,6 +25,29 @@
 
 #define LOCAL_TRACE MAX(VM_GLOBAL_TRACE, 0)
 
+KCOUNTER(vm_large_page_fault, "kernel.vm.large_page.fault");
+KCOUNTER(vm_fault_around_pages, "kernel.vm.fault_around.pages");
+
+// whether page faults may map LARGE_PAGE_SIZE runs of a vmo in one go
+static bool large_pages_enabled = false;
+
+static void vm_mapping_large_page_init(uint level) {
+    large_pages_enabled = cmdline_get_bool("kernel.vm.large-pages", true);
+}
+LK_INIT_HOOK(vm_mapping_large_page, &vm_mapping_large_page_init, LK_INIT_LEVEL_VM);
+
+// the largest fault-around window, bounded by the bitmap FaultAroundLocked keeps
+static constexpr uint32_t kMaxFaultAroundPages = 64;
+
+// how many pages around a faulting page, including it, a page fault may map in one go
+static uint32_t fault_around_pages = 16;
+
+static void vm_mapping_fault_around_init(uint level) {
+    fault_around_pages = fbl::min(cmdline_get_uint32("kernel.vm.fault-around", 16),
+                                  kMaxFaultAroundPages);
+}
+LK_INIT_HOOK(vm_mapping_fault_around, &vm_mapping_fault_around_init, LK_INIT_LEVEL_VM);
+
 VmMapping::VmMapping(VmAddressRegion& parent, vaddr_t base, size_t size, uint32_t vmar_flags,
                      fbl::RefPtr<VmObject> vmo, uint64_t vmo_offset, uint arch_mmu_flags)
     : VmAddressRegionOrMapping(base, size, vmar_flags,
@@ -392,6 +419,7 @@ namespace {
 class VmMappingCoalescer {
 public:
     VmMappingCoalescer(VmMapping* mapping, vaddr_t base);
+    VmMappingCoalescer(VmMapping* mapping, vaddr_t base, uint mmu_flags);
     ~VmMappingCoalescer();
 
     // Add a page to the mapping run.  If this fails, the VmMappingCoalescer is
@@ -426,13 +454,17 @@ private:
 
     VmMapping* mapping_;
     vaddr_t base_;
+    uint mmu_flags_;
     paddr_t phys_[16];
     size_t count_;
     bool aborted_;
 };
 
 VmMappingCoalescer::VmMappingCoalescer(VmMapping* mapping, vaddr_t base)
-    : mapping_(mapping), base_(base), count_(0), aborted_(false) {}
+    : VmMappingCoalescer(mapping, base, mapping->arch_mmu_flags()) {}
+
+VmMappingCoalescer::VmMappingCoalescer(VmMapping* mapping, vaddr_t base, uint mmu_flags)
+    : mapping_(mapping), base_(base), mmu_flags_(mmu_flags), count_(0), aborted_(false) {}
 
 VmMappingCoalescer::~VmMappingCoalescer() {
     // Make sure we've flushed or aborted
@@ -444,7 +476,7 @@ zx_status_t VmMappingCoalescer::Flush() {
         return ZX_OK;
     }
 
-    uint flags = mapping_->arch_mmu_flags();
+    uint flags = mmu_flags_;
     if (flags & ARCH_MMU_FLAG_PERM_RWX_MASK) {
         size_t mapped;
         zx_status_t ret = mapping_->aspace()->arch_aspace().Map(base_, phys_, count_, flags,
@@ -484,8 +516,13 @@ zx_status_t VmMapping::MapRange(size_t offset, size_t len, bool commit) {
     }
 
     // precompute the flags we'll pass GetPageLocked
-    // if committing, then tell it to soft fault in a page
-    uint pf_flags = VMM_PF_FLAG_WRITE;
+    // if committing, then tell it to soft fault in a page. Read-only mappings are
+    // populated the way read faults would populate them, with the zero page or the
+    // parent's pages, so that committing them does not allocate anything.
+    uint pf_flags = 0;
+    if (arch_mmu_flags_ & ARCH_MMU_FLAG_PERM_WRITE) {
+        pf_flags |= VMM_PF_FLAG_WRITE;
+    }
     if (commit) {
         pf_flags |= VMM_PF_FLAG_SW_FAULT;
     }
@@ -507,7 +544,7 @@ zx_status_t VmMapping::MapRange(size_t offset, size_t len, bool commit) {
 
         zx_status_t status;
         paddr_t pa;
-        status = object_->GetPageLocked(vmo_offset, pf_flags, nullptr, nullptr, &pa);
+        status = object_->GetPageLocked(vmo_offset, pf_flags, nullptr, nullptr, nullptr, &pa);
         if (status != ZX_OK) {
             // no page to map
             if (commit) {
@@ -597,7 +634,7 @@ zx_status_t VmMapping::DestroyLocked() {
     return ZX_OK;
 }
 
-zx_status_t VmMapping::PageFault(vaddr_t va, const uint pf_flags) {
+zx_status_t VmMapping::PageFault(vaddr_t va, const uint pf_flags, PageRequest* page_request) {
     canary_.Assert();
     DEBUG_ASSERT(aspace_->lock()->lock().IsHeld());
 
@@ -644,10 +681,68 @@ zx_status_t VmMapping::PageFault(vaddr_t va, const uint pf_flags) {
     currently_faulting_ = true;
     auto ac = fbl::MakeAutoCall([&]() { currently_faulting_ = false; });
 
+    // if we read faulted, make sure we map or modify the page without any write permissions
+    // this ensures we will fault again if a write is attempted so we can potentially
+    // replace this page with a copy or a new one
+    uint mmu_flags = arch_mmu_flags_;
+    if (!(pf_flags & VMM_PF_FLAG_WRITE)) {
+        // we read faulted, so only map with read permissions
+        mmu_flags &= ~ARCH_MMU_FLAG_PERM_WRITE;
+    }
+
+    // if the large page surrounding the fault lies entirely within this mapping and the vmo
+    // can back it with an aligned, physically contiguous run, map the whole run at once so the
+    // arch layer can install a single large page entry. Partial unmaps, protects and decommits
+    // later split the entry back up in the arch page table code.
+    vaddr_t large_va = ROUNDDOWN(va, LARGE_PAGE_SIZE);
+    uint64_t large_vmo_offset = vmo_offset - (va - large_va);
+    if (large_pages_enabled && large_va >= base_ && large_va - base_ + LARGE_PAGE_SIZE <= size_ &&
+        IS_LARGE_PAGE_ALIGNED(large_vmo_offset)) {
+        paddr_t large_pa;
+        if (object_->GetLargePageLocked(large_vmo_offset, pf_flags, &large_pa) == ZX_OK) {
+            paddr_t expected_pa = large_pa + (va - large_va);
+            uint page_flags;
+            paddr_t pa;
+            zx_status_t status;
+            if (aspace_->arch_aspace().Query(va, &pa, &page_flags) == ZX_OK && pa == expected_pa) {
+                // another thread beat us to it, or we are upgrading a read only mapping
+                if (page_flags == arch_mmu_flags_ || page_flags == mmu_flags) {
+                    return ZX_OK;
+                }
+                status = aspace_->arch_aspace().Protect(large_va, LARGE_PAGE_COUNT, mmu_flags);
+            } else {
+                // clear out whatever single pages (such as the zero page) were mapped before
+                status = aspace_->arch_aspace().Unmap(large_va, LARGE_PAGE_COUNT, nullptr);
+                if (status == ZX_OK) {
+                    size_t mapped;
+                    status = aspace_->arch_aspace().MapContiguous(large_va, large_pa,
+                                                                  LARGE_PAGE_COUNT, mmu_flags,
+                                                                  &mapped);
+                    DEBUG_ASSERT(status != ZX_OK || mapped == LARGE_PAGE_COUNT);
+                }
+            }
+            if (status != ZX_OK) {
+                TRACEF("failed to map large page\n");
+                return ZX_ERR_NO_MEMORY;
+            }
+            kcounter_add(vm_large_page_fault, 1);
+
+            LTRACEF("mapped large page pa %#" PRIxPTR " to va %#" PRIxPTR "\n", large_pa, large_va);
+
+#if ARCH_ARM64
+            if (!(pf_flags & VMM_PF_FLAG_GUEST) && (arch_mmu_flags_ & ARCH_MMU_FLAG_PERM_EXECUTE)) {
+                arch_sync_cache_range(large_va, LARGE_PAGE_SIZE);
+            }
+#endif
+            return ZX_OK;
+        }
+    }
+
     // fault in or grab an existing page
     paddr_t new_pa;
     vm_page_t* page;
-    zx_status_t status = object_->GetPageLocked(vmo_offset, pf_flags, nullptr, &page, &new_pa);
+    zx_status_t status = object_->GetPageLocked(vmo_offset, pf_flags, nullptr, page_request,
+                                                &page, &new_pa);
     if (status != ZX_OK) {
         // TODO(cpu): This trace was originally TRACEF() always on, but it fires if the
         // VMO was resized, rather than just when the system is running out of memory.
@@ -656,15 +751,6 @@ zx_status_t VmMapping::PageFault(vaddr_t va, const uint pf_flags) {
         return status;
     }
 
-    // if we read faulted, make sure we map or modify the page without any write permissions
-    // this ensures we will fault again if a write is attempted so we can potentially
-    // replace this page with a copy or a new one
-    uint mmu_flags = arch_mmu_flags_;
-    if (!(pf_flags & VMM_PF_FLAG_WRITE)) {
-        // we read faulted, so only map with read permissions
-        mmu_flags &= ~ARCH_MMU_FLAG_PERM_WRITE;
-    }
-
     // see if something is mapped here now
     // this may happen if we are one of multiple threads racing on a single address
     uint page_flags;
@@ -741,9 +827,76 @@ zx_status_t VmMapping::PageFault(vaddr_t va, const uint pf_flags) {
         arch_sync_cache_range(va, PAGE_SIZE);
     }
 #endif
+
+    if (!(pf_flags & VMM_PF_FLAG_GUEST)) {
+        FaultAroundLocked(va);
+    }
     return ZX_OK;
 }
 
+void VmMapping::FaultAroundLocked(vaddr_t va) {
+    DEBUG_ASSERT(aspace_->lock()->lock().IsHeld());
+    DEBUG_ASSERT(object_->lock()->lock().IsHeld());
+    DEBUG_ASSERT(currently_faulting_);
+
+    if (fault_around_pages <= 1 || !(arch_mmu_flags_ & ARCH_MMU_FLAG_PERM_READ)) {
+        return;
+    }
+
+    // map the aligned window of pages around the fault, clipped to the mapping and the vmo
+    const size_t window = fault_around_pages * PAGE_SIZE;
+    size_t start = (va - base_) / window * window;
+    size_t end = fbl::min(start + window, size_);
+    const uint64_t vmo_size = object_->size();
+    if (object_offset_ >= vmo_size) {
+        return;
+    }
+    end = fbl::min(end, static_cast<size_t>(ROUNDUP(vmo_size - object_offset_, PAGE_SIZE)));
+
+    // only pages the vmo already has are mapped, and always read-only: the neighbours
+    // may be the parent's or shared copy-on-write pages, and a later write faults as
+    // it would have anyway
+    const uint mmu_flags = arch_mmu_flags_ & ~ARCH_MMU_FLAG_PERM_WRITE;
+    VmMappingCoalescer coalescer(this, base_ + start, mmu_flags);
+    __UNUSED uint64_t mapped_pages = 0;
+    size_t count = 0;
+    for (size_t o = start; o < end; o += PAGE_SIZE) {
+        vaddr_t page_va = base_ + o;
+        if (page_va == va) {
+            continue;
+        }
+
+        paddr_t pa;
+        uint page_flags;
+        if (aspace_->arch_aspace().Query(page_va, &pa, &page_flags) == ZX_OK) {
+            continue;
+        }
+        if (object_->GetPageLocked(object_offset_ + o, 0, nullptr, nullptr, nullptr,
+                                   &pa) != ZX_OK) {
+            continue;
+        }
+        if (coalescer.Append(page_va, pa) != ZX_OK) {
+            return;
+        }
+        mapped_pages |= 1ull << ((o - start) / PAGE_SIZE);
+        ++count;
+    }
+    if (count == 0 || coalescer.Flush() != ZX_OK) {
+        return;
+    }
+    kcounter_add(vm_fault_around_pages, count);
+
+#if ARCH_ARM64
+    if (arch_mmu_flags_ & ARCH_MMU_FLAG_PERM_EXECUTE) {
+        for (size_t o = start; o < end; o += PAGE_SIZE) {
+            if (mapped_pages & (1ull << ((o - start) / PAGE_SIZE))) {
+                arch_sync_cache_range(base_ + o, PAGE_SIZE);
+            }
+        }
+    }
+#endif
+}
+
 // We disable thread safety analysis here because one of the common uses of this
 // function is for splitting one mapping object into several that will be backed
 // by the same VmObject.  In that case, object_->lock() gets aliased across all
@@ -30,7 +30,7 @@ VmObject::GlobalList VmObject::all_vmos_ = {};
 
 VmObject::VmObject(fbl::RefPtr<VmObject> parent)
     : lock_(parent ? parent->lock_ref() : local_lock_),
-      parent_(fbl::move(parent)) {
+      parent_(parent.get()) {
     LTRACEF("%p\n", this);
 
     // Add ourself to the global VMO list, newer VMOs at the end.
@@ -45,8 +45,9 @@ VmObject::~VmObject() {
     LTRACEF("%p\n", this);
 
     // remove ourself from our parent (if present)
+    VmObject* dead_parent = nullptr;
     if (parent_) {
-        LTRACEF("removing ourself from our parent %p\n", parent_.get());
+        LTRACEF("removing ourself from our parent %p\n", parent_);
 
         // conditionally grab our shared lock with the parent, but only if it's
         // not held. There are some destruction paths that may try to tear
@@ -55,7 +56,14 @@ VmObject::~VmObject() {
         if (need_lock) {
             Guard<fbl::Mutex> guard{&lock_};
             parent_->RemoveChildLocked(this);
+            // the parent may own the lock we hold, so it's destroyed after
+            // the lock has been dropped
+            if (parent_->OnChildRemovedLocked()) {
+                dead_parent = parent_;
+            }
         } else {
+            // hidden parents only ever lose children with the lock dropped,
+            // so there is nothing to clean up here
             parent_->RemoveChildLocked(this);
         }
     }
@@ -69,6 +77,12 @@ VmObject::~VmObject() {
         DEBUG_ASSERT(global_list_state_.InContainer() == true);
         all_vmos_.erase(*this);
     }
+
+    // Nothing of ours may be touched once our parent goes, since our lock
+    // could be the parent's.
+    if (dead_parent) {
+        delete dead_parent;
+    }
 }
 
 void VmObject::get_name(char* out_name, size_t len) const {
@@ -96,17 +110,13 @@ uint64_t VmObject::user_id() const {
 
 uint64_t VmObject::parent_user_id() const {
     canary_.Assert();
-    // Don't hold both our lock and our parent's lock at the same time, because
-    // it's probably the same lock.
-    fbl::RefPtr<VmObject> parent;
-    {
-        Guard<fbl::Mutex> guard{&lock_};
-        if (parent_ == nullptr) {
-            return 0u;
-        }
-        parent = parent_;
+    // The parent shares our lock, and may be kept around by its children
+    // alone, so it can't be referenced.
+    Guard<fbl::Mutex> guard{&lock_};
+    if (parent_ == nullptr) {
+        return 0u;
     }
-    return parent->user_id();
+    return parent_->user_id_;
 }
 
 bool VmObject::is_cow_clone() const {
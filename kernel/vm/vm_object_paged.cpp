@@ -14,7 +14,10 @@
 #include <fbl/alloc_checker.h>
 #include <fbl/auto_call.h>
 #include <inttypes.h>
+#include <kernel/mp.h>
+#include <kernel/thread.h>
 #include <lib/console.h>
+#include <lib/counters.h>
 #include <stdlib.h>
 #include <string.h>
 #include <trace.h>
@@ -26,6 +29,14 @@
 
 #define LOCAL_TRACE MAX(VM_GLOBAL_TRACE, 0)
 
+KCOUNTER(vm_large_page_alloc, "kernel.vm.large_page.alloc");
+KCOUNTER(vm_large_page_alloc_fail, "kernel.vm.large_page.alloc_fail");
+KCOUNTER(vm_commit_large_run, "kernel.vm.commit.large_run");
+KCOUNTER(vm_commit_parallel_zero, "kernel.vm.commit.parallel_zero");
+KCOUNTER(vm_reclaim_zero_page, "kernel.vm.reclaim.zero_page");
+KCOUNTER(vm_cache_op_run, "kernel.vm.cache_op.run");
+KCOUNTER(vm_cache_op_icache_all, "kernel.vm.cache_op.icache_all");
+
 namespace {
 
 void ZeroPage(paddr_t pa) {
@@ -40,10 +51,103 @@ void ZeroPage(vm_page_t* p) {
     ZeroPage(pa);
 }
 
+// Committing at least this many pages that need zeroing spreads the zeroing
+// over several threads, each taking at least kMinPagesPerZeroWorker pages.
+constexpr size_t kParallelZeroPages = 16384;
+constexpr size_t kMinPagesPerZeroWorker = 4096;
+// Past a handful of cpus zeroing is limited by memory bandwidth.
+constexpr uint kMaxZeroWorkers = 8;
+
+// Syncing at least this much invalidates the whole instruction cache rather
+// than going line by line; that is several times the size of any icache.
+constexpr uint64_t kCacheOpSyncAllThreshold = 256 * 1024;
+
+struct ZeroPagesWork {
+    list_node_t* first;
+    size_t count;
+};
+
+// Zero |work->count| pages starting with the page at |work->first|, skipping
+// any the pmm already zeroed.
+int ZeroPagesWorker(void* arg) {
+    auto work = static_cast<ZeroPagesWork*>(arg);
+    list_node_t* node = work->first;
+    for (size_t i = 0; i < work->count; i++) {
+        vm_page_t* p = containerof(node, vm_page_t, queue_node);
+        if (!p->zeroed) {
+            ZeroPage(p);
+        }
+        node = node->next;
+    }
+    return 0;
+}
+
+// Zero the pages of a freshly allocated page list.  Large lists are split
+// into contiguous slices zeroed by worker threads in parallel with the
+// calling thread, which waits for all of them.  The list is left untouched.
+void ZeroPageList(list_node_t* list, size_t count) {
+    if (count == 0) {
+        return;
+    }
+
+    uint workers = 1;
+    if (count >= kParallelZeroPages) {
+        workers = __builtin_popcount(mp_get_online_mask());
+        workers = MIN(workers, kMaxZeroWorkers);
+        workers = static_cast<uint>(MIN(workers, count / kMinPagesPerZeroWorker));
+    }
+
+    ZeroPagesWork work[kMaxZeroWorkers];
+    thread_t* threads[kMaxZeroWorkers] = {};
+    list_node_t* node = list->next;
+    for (uint i = 0; i < workers; i++) {
+        work[i].first = node;
+        work[i].count = count / workers + (i < count % workers ? 1 : 0);
+        for (size_t j = 0; j < work[i].count; j++) {
+            node = node->next;
+        }
+    }
+    DEBUG_ASSERT(node == list);
+
+    // slice 0 is done by the calling thread, and so is any slice whose
+    // thread could not be created
+    for (uint i = 1; i < workers; i++) {
+        threads[i] = thread_create("vmo zero", ZeroPagesWorker, &work[i], DEFAULT_PRIORITY);
+        if (threads[i]) {
+            thread_resume(threads[i]);
+        }
+    }
+    if (workers > 1) {
+        kcounter_add(vm_commit_parallel_zero, 1);
+    }
+
+    for (uint i = 0; i < workers; i++) {
+        if (threads[i]) {
+            thread_join(threads[i], nullptr, ZX_TIME_INFINITE);
+        } else {
+            ZeroPagesWorker(&work[i]);
+        }
+    }
+}
+
 void InitializeVmPage(vm_page_t* p) {
     DEBUG_ASSERT(p->state == VM_PAGE_STATE_ALLOC);
     p->state = VM_PAGE_STATE_OBJECT;
     p->object.pin_count = 0;
+    p->object.accessed = 0;
+    p->object.age = 0;
+}
+
+bool IsZeroPage(const vm_page_t* p) {
+    auto word = static_cast<const uint64_t*>(paddr_to_physmap(p->paddr()));
+    DEBUG_ASSERT(word);
+
+    for (size_t i = 0; i < PAGE_SIZE / sizeof(*word); i++) {
+        if (word[i] != 0) {
+            return false;
+        }
+    }
+    return true;
 }
 
 // round up the size to the next page size boundary and make sure we dont wrap
@@ -64,11 +168,14 @@ zx_status_t RoundSize(uint64_t size, uint64_t* out_size) {
 } // namespace
 
 VmObjectPaged::VmObjectPaged(
-    uint32_t options, uint32_t pmm_alloc_flags, uint64_t size, fbl::RefPtr<VmObject> parent)
+    uint32_t options, uint32_t pmm_alloc_flags, uint64_t size, fbl::RefPtr<VmObject> parent,
+    fbl::RefPtr<PageSource> page_source)
     : VmObject(fbl::move(parent)),
       options_(options),
       size_(size),
-      pmm_alloc_flags_(pmm_alloc_flags) {
+      pmm_alloc_flags_(pmm_alloc_flags),
+      page_source_(fbl::move(page_source)),
+      pager_backed_(page_source_ || (parent_ && parent_->is_pager_backed())) {
     LTRACEF("%p\n", this);
 
     DEBUG_ASSERT(IS_PAGE_ALIGNED(size_));
@@ -90,6 +197,10 @@ VmObjectPaged::~VmObjectPaged() {
 
     // free all of the pages attached to us
     page_list_.FreeAllPages();
+
+    if (page_source_) {
+        page_source_->Detach();
+    }
 }
 
 zx_status_t VmObjectPaged::Create(uint32_t pmm_alloc_flags,
@@ -108,7 +219,7 @@ zx_status_t VmObjectPaged::Create(uint32_t pmm_alloc_flags,
 
     fbl::AllocChecker ac;
     auto vmo = fbl::AdoptRef<VmObject>(
-        new (&ac) VmObjectPaged(options, pmm_alloc_flags, size, nullptr));
+        new (&ac) VmObjectPaged(options, pmm_alloc_flags, size, nullptr, nullptr));
     if (!ac.check()) {
         return ZX_ERR_NO_MEMORY;
     }
@@ -129,7 +240,7 @@ zx_status_t VmObjectPaged::CreateContiguous(uint32_t pmm_alloc_flags, uint64_t s
 
     fbl::AllocChecker ac;
     auto vmo = fbl::AdoptRef<VmObject>(
-        new (&ac) VmObjectPaged(kContiguous, pmm_alloc_flags, size, nullptr));
+        new (&ac) VmObjectPaged(kContiguous, pmm_alloc_flags, size, nullptr, nullptr));
     if (!ac.check()) {
         return ZX_ERR_NO_MEMORY;
     }
@@ -145,7 +256,8 @@ zx_status_t VmObjectPaged::CreateContiguous(uint32_t pmm_alloc_flags, uint64_t s
 
     size_t num_pages = size / PAGE_SIZE;
     paddr_t pa;
-    status = pmm_alloc_contiguous(num_pages, pmm_alloc_flags, alignment_log2, &pa, &page_list);
+    status = pmm_alloc_contiguous(num_pages, pmm_alloc_flags | PMM_ALLOC_FLAG_PREFER_ZEROED,
+                                  alignment_log2, &pa, &page_list);
     if (status != ZX_OK) {
         LTRACEF("failed to allocate enough pages (asked for %zu)\n", num_pages);
         return ZX_ERR_NO_MEMORY;
@@ -160,11 +272,12 @@ zx_status_t VmObjectPaged::CreateContiguous(uint32_t pmm_alloc_flags, uint64_t s
         vm_page_t* p = list_remove_head_type(&page_list, vm_page_t, queue_node);
         ASSERT(p);
 
+        // the pmm may already have zeroed the page in the background
+        if (!p->zeroed) {
+            ZeroPage(p);
+        }
         InitializeVmPage(p);
 
-        // TODO: remove once pmm returns zeroed pages
-        ZeroPage(p);
-
         // We don't need thread-safety analysis here, since this VMO has not
         // been shared anywhere yet.
         [&]() TA_NO_THREAD_SAFETY_ANALYSIS {
@@ -235,6 +348,26 @@ zx_status_t VmObjectPaged::CreateFromROData(const void* data, size_t size, fbl::
     return ZX_OK;
 }
 
+zx_status_t VmObjectPaged::CreateExternal(fbl::RefPtr<PageSource> src, uint64_t size,
+                                          fbl::RefPtr<VmObject>* obj) {
+    // make sure size is page aligned
+    zx_status_t status = RoundSize(size, &size);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    fbl::AllocChecker ac;
+    auto vmo = fbl::AdoptRef<VmObject>(
+        new (&ac) VmObjectPaged(0, PMM_ALLOC_FLAG_ANY, size, nullptr, fbl::move(src)));
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+
+    *obj = fbl::move(vmo);
+
+    return ZX_OK;
+}
+
 zx_status_t VmObjectPaged::CloneCOW(bool resizable, uint64_t offset, uint64_t size,
                                     bool copy_name, fbl::RefPtr<VmObject>* clone_vmo) {
     LTRACEF("vmo %p offset %#" PRIx64 " size %#" PRIx64 "\n", this, offset, size);
@@ -252,7 +385,8 @@ zx_status_t VmObjectPaged::CloneCOW(bool resizable, uint64_t offset, uint64_t si
     // allocate the clone up front outside of our lock
     fbl::AllocChecker ac;
     auto vmo = fbl::AdoptRef<VmObjectPaged>(
-        new (&ac) VmObjectPaged(options, pmm_alloc_flags_, size, fbl::WrapRefPtr(this)));
+        new (&ac) VmObjectPaged(options, pmm_alloc_flags_, size, fbl::WrapRefPtr(this),
+                                nullptr));
     if (!ac.check()) {
         return ZX_ERR_NO_MEMORY;
     }
@@ -283,6 +417,171 @@ zx_status_t VmObjectPaged::CloneCOW(bool resizable, uint64_t offset, uint64_t si
     return ZX_OK;
 }
 
+void VmObjectPaged::fbl_recycle() {
+    canary_.Assert();
+
+    {
+        Guard<fbl::Mutex> guard{&lock_};
+        if (!children_list_.is_empty()) {
+            // our clones still read through us
+            hidden_ = true;
+            if (!CollapseHiddenLocked()) {
+                return;
+            }
+        }
+    }
+
+    delete this;
+}
+
+bool VmObjectPaged::OnChildRemovedLocked() {
+    DEBUG_ASSERT(lock_.lock().IsHeld());
+
+    return hidden_ && CollapseHiddenLocked();
+}
+
+bool VmObjectPaged::CollapseHiddenLocked() {
+    canary_.Assert();
+    DEBUG_ASSERT(lock_.lock().IsHeld());
+    DEBUG_ASSERT(hidden_);
+
+    if (children_list_.is_empty()) {
+        return true;
+    }
+
+    // pages from a page source may have to be requested again, and the pages
+    // of a contiguous object stay pinned, so those are left where they are
+    if (page_source_ || is_contiguous()) {
+        return false;
+    }
+
+    ClipChildLimitsLocked();
+
+    if (children_list_len_ > 1) {
+        list_node freed;
+        list_initialize(&freed);
+        page_list_.RemovePagesIf([this, &freed](vm_page_t* p, uint64_t offset) {
+            if (IsPageVisibleLocked(offset)) {
+                return false;
+            }
+            list_add_tail(&freed, &p->queue_node);
+            return true;
+        });
+        pmm_free(&freed);
+        return false;
+    }
+
+    auto& child = static_cast<VmObjectPaged&>(children_list_.front());
+    if (!MergeIntoChildLocked(&child)) {
+        return false;
+    }
+
+    LTRACEF("vmo %p merged into child %p\n", this, &child);
+
+    if (!parent_) {
+        // The child shares the lock we hold, so we stay around until it goes,
+        // but there's nothing left for it to look at.
+        child.parent_limit_ = 0;
+        return false;
+    }
+
+    // The child takes our place under our parent, seeing as much of it as it
+    // saw through us.
+    uint64_t limit = child.parent_limit_;
+    if (parent_limit_ > child.parent_offset_) {
+        limit = MIN(limit, parent_limit_ - child.parent_offset_);
+    } else {
+        limit = 0;
+    }
+    // our window into the parent lies within 64 bits, so a non-empty one
+    // doesn't overflow
+    child.parent_offset_ = limit ? child.parent_offset_ + parent_offset_ : 0;
+    child.parent_limit_ = limit;
+
+    // add before removing, so that watchers of the parent don't see it
+    // losing all its children
+    parent_->AddChildLocked(&child);
+    RemoveChildLocked(&child);
+    child.parent_ = parent_;
+
+    return true;
+}
+
+void VmObjectPaged::ClipChildLimitsLocked() {
+    DEBUG_ASSERT(lock_.lock().IsHeld());
+    DEBUG_ASSERT(hidden_);
+
+    for (auto& c : children_list_) {
+        auto& child = static_cast<VmObjectPaged&>(c);
+        uint64_t limit = MIN(child.parent_limit_, child.size_);
+        if (size_ > child.parent_offset_) {
+            limit = MIN(limit, size_ - child.parent_offset_);
+        } else {
+            limit = 0;
+        }
+        child.parent_limit_ = limit;
+    }
+}
+
+bool VmObjectPaged::MergeIntoChildLocked(VmObjectPaged* child) {
+    DEBUG_ASSERT(lock_.lock().IsHeld());
+    DEBUG_ASSERT(children_list_len_ == 1);
+
+    bool merged = true;
+    list_node freed;
+    list_initialize(&freed);
+    page_list_.RemovePagesIf([child, &freed, &merged](vm_page_t* p, uint64_t offset) {
+        if (offset >= child->parent_offset_) {
+            const uint64_t child_offset = offset - child->parent_offset_;
+            if (child_offset < child->parent_limit_ && !child->page_list_.GetPage(child_offset)) {
+                // The child reads this page already, so nothing of it has to
+                // be unmapped.
+                if (child->page_list_.AddPage(p, child_offset) != ZX_OK) {
+                    merged = false;
+                    return false;
+                }
+                return true;
+            }
+        }
+        list_add_tail(&freed, &p->queue_node);
+        return true;
+    });
+    pmm_free(&freed);
+
+    return merged;
+}
+
+bool VmObjectPaged::IsPageVisibleLocked(uint64_t offset) {
+    DEBUG_ASSERT(lock_.lock().IsHeld());
+
+    // A child having its own page hides ours from its children, too.
+    for (auto& c : children_list_) {
+        auto& child = static_cast<VmObjectPaged&>(c);
+        if (offset < child.parent_offset_) {
+            continue;
+        }
+        const uint64_t child_offset = offset - child.parent_offset_;
+        if (child_offset < child.parent_limit_ && !child.page_list_.GetPage(child_offset)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void VmObjectPaged::FreePageIfInvisibleLocked(uint64_t offset) {
+    DEBUG_ASSERT(lock_.lock().IsHeld());
+
+    if (!hidden_ || page_source_ || is_contiguous()) {
+        return;
+    }
+
+    ClipChildLimitsLocked();
+    if (!IsPageVisibleLocked(offset)) {
+        LTRACEF("vmo %p freeing hidden page at %#" PRIx64 "\n", this, offset);
+        page_list_.FreePage(offset);
+    }
+}
+
 void VmObjectPaged::Dump(uint depth, bool verbose) {
     canary_.Assert();
 
@@ -326,13 +625,12 @@ size_t VmObjectPaged::AllocatedPagesInRange(uint64_t offset, uint64_t len) const
     size_t count = 0;
     // TODO: Figure out what to do with our parent's pages. If we're a clone,
     // page_list_ only contains pages that we've made copies of.
-    page_list_.ForEveryPage(
-        [&count, offset, new_len](const auto p, uint64_t off) {
-            if (off >= offset && off < offset + new_len) {
-                count++;
-            }
+    page_list_.ForEveryPageInRange(
+        [&count](const auto p, uint64_t off) {
+            count++;
             return ZX_ERR_NEXT;
-        });
+        },
+        ROUNDUP_PAGE_SIZE(offset), ROUNDUP_PAGE_SIZE(offset + new_len));
     return count;
 }
 
@@ -365,6 +663,21 @@ zx_status_t VmObjectPaged::AddPageLocked(vm_page_t* p, uint64_t offset) {
     return ZX_OK;
 }
 
+// Asking for several pages at once spares the page source a round trip per page
+// when a range is read sequentially, as executables and files mostly are.
+static constexpr uint64_t kPageSourceReadahead = 16 * PAGE_SIZE;
+
+uint64_t VmObjectPaged::ReadaheadLengthLocked(uint64_t offset) {
+    DEBUG_ASSERT(lock_.lock().IsHeld());
+
+    uint64_t len = PAGE_SIZE;
+    while (len < kPageSourceReadahead && offset + len < size_ &&
+           !page_list_.GetPage(offset + len)) {
+        len += PAGE_SIZE;
+    }
+    return len;
+}
+
 // Looks up the page at the requested offset, faulting it in if requested and necessary.  If
 // this VMO has a parent and the requested page isn't found, the parent will be searched.
 //
@@ -372,7 +685,12 @@ zx_status_t VmObjectPaged::AddPageLocked(vm_page_t* p, uint64_t offset) {
 // this function may allocate from.  This function will need at most one entry,
 // and will not fail if |free_list| is a non-empty list, faulting in was requested,
 // and offset is in range.
+//
+// A VMO backed by a page source never makes up pages; missing ones are requested
+// from the source through |page_request|, whether or not faulting in was requested,
+// so that a clone's lookup in its parent reaches the source too.
 zx_status_t VmObjectPaged::GetPageLocked(uint64_t offset, uint pf_flags, list_node* free_list,
+                                         PageRequest* page_request,
                                          vm_page_t** const page_out, paddr_t* const pa_out) {
     canary_.Assert();
     DEBUG_ASSERT(lock_.lock().IsHeld());
@@ -387,6 +705,8 @@ zx_status_t VmObjectPaged::GetPageLocked(uint64_t offset, uint pf_flags, list_no
     // see if we already have a page at that offset
     p = page_list_.GetPage(offset);
     if (p) {
+        // looking a page up means it is about to be used
+        p->object.age = 0;
         if (page_out) {
             *page_out = p;
         }
@@ -401,7 +721,7 @@ zx_status_t VmObjectPaged::GetPageLocked(uint64_t offset, uint pf_flags, list_no
             vmm_pf_flags_to_string(pf_flags, pf_string));
 
     // if we have a parent see if they have a page for us
-    if (parent_) {
+    if (parent_ && offset < parent_limit_) {
         uint64_t parent_offset;
         bool overflowed = add_overflow(parent_offset_, offset, &parent_offset);
         ASSERT(!overflowed);
@@ -410,7 +730,10 @@ zx_status_t VmObjectPaged::GetPageLocked(uint64_t offset, uint pf_flags, list_no
         uint parent_pf_flags = pf_flags & ~(VMM_PF_FLAG_FAULT_MASK);
 
         zx_status_t status = parent_->GetPageLocked(parent_offset, parent_pf_flags,
-                                                    nullptr, &p, &pa);
+                                                    nullptr, page_request, &p, &pa);
+        if (status == ZX_ERR_SHOULD_WAIT) {
+            return status;
+        }
         if (status == ZX_OK) {
             // we have a page from them. if we're read-only faulting, return that page so they can map
             // or read from it directly
@@ -457,6 +780,12 @@ zx_status_t VmObjectPaged::GetPageLocked(uint64_t offset, uint pf_flags, list_no
             status = AddPageLocked(p_clone, offset);
             DEBUG_ASSERT(status == ZX_OK);
 
+            // a hidden parent may have been keeping the page for us alone
+            auto parent = static_cast<VmObjectPaged*>(parent_);
+            if (parent->page_list_.GetPage(parent_offset) == p) {
+                parent->FreePageIfInvisibleLocked(parent_offset);
+            }
+
             LTRACEF("copy-on-write faulted in page %p, pa %#" PRIxPTR " copied from %p, pa %#" PRIxPTR "\n",
                     p, pa, p_clone, pa_clone);
 
@@ -471,6 +800,13 @@ zx_status_t VmObjectPaged::GetPageLocked(uint64_t offset, uint pf_flags, list_no
         }
     }
 
+    if (page_source_) {
+        if (!page_request) {
+            return ZX_ERR_NOT_FOUND;
+        }
+        return page_source_->GetPages(offset, ReadaheadLengthLocked(offset), page_request);
+    }
+
     // if we're not being asked to sw or hw fault in the page, return not found
     if ((pf_flags & VMM_PF_FLAG_FAULT_MASK) == 0) {
         return ZX_ERR_NOT_FOUND;
@@ -497,17 +833,18 @@ zx_status_t VmObjectPaged::GetPageLocked(uint64_t offset, uint pf_flags, list_no
         }
     }
     if (!p) {
-        pmm_alloc_page(pmm_alloc_flags_, &p, &pa);
+        pmm_alloc_page(pmm_alloc_flags_ | PMM_ALLOC_FLAG_PREFER_ZEROED, &p, &pa);
     }
     if (!p) {
         return ZX_ERR_NO_MEMORY;
     }
 
+    // the pmm may already have zeroed the page in the background
+    if (!p->zeroed) {
+        ZeroPage(pa);
+    }
     InitializeVmPage(p);
 
-    // TODO: remove once pmm returns zeroed pages
-    ZeroPage(pa);
-
 // if ARM and not fully cached, clean/invalidate the page after zeroing it
 #if ARCH_ARM64
     if (cache_policy_ != ARCH_MMU_FLAG_CACHED) {
@@ -533,6 +870,107 @@ zx_status_t VmObjectPaged::GetPageLocked(uint64_t offset, uint pf_flags, list_no
     return ZX_OK;
 }
 
+// Looks up a LARGE_PAGE_SIZE run of pages at the requested aligned offset that
+// could be mapped with a single large page entry. If every page in the run is
+// already committed the run must be physically contiguous and suitably aligned.
+// If none are committed and a write fault was requested, try to allocate an
+// aligned contiguous run from the pmm and commit all of it. Anything else
+// (partially committed ranges, cow clones, allocation failure) fails and the
+// caller falls back to faulting in single pages.
+zx_status_t VmObjectPaged::GetLargePageLocked(uint64_t offset, uint pf_flags, paddr_t* pa_out) {
+    canary_.Assert();
+    DEBUG_ASSERT(lock_.lock().IsHeld());
+
+    if (!IS_LARGE_PAGE_ALIGNED(offset)) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+    uint64_t end;
+    if (add_overflow(offset, LARGE_PAGE_SIZE, &end) || end > size_) {
+        return ZX_ERR_OUT_OF_RANGE;
+    }
+
+    // pages of a cow clone may come from the parent on read and be copied on
+    // write, and those of a page source come from the source one request at a
+    // time, so there is no single run to back the range with
+    if (parent_ || page_source_) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+
+    // see what is already committed in the range
+    size_t present = 0;
+    paddr_t base_pa = 0;
+    bool contiguous = true;
+    for (uint64_t o = offset; o < end; o += PAGE_SIZE) {
+        vm_page_t* p = page_list_.GetPage(o);
+        if (!p) {
+            continue;
+        }
+        if (present == 0) {
+            base_pa = p->paddr() - (o - offset);
+        } else if (p->paddr() != base_pa + (o - offset)) {
+            contiguous = false;
+        }
+        present++;
+    }
+
+    if (present == LARGE_PAGE_COUNT) {
+        if (!contiguous || !IS_LARGE_PAGE_ALIGNED(base_pa)) {
+            return ZX_ERR_NOT_FOUND;
+        }
+        *pa_out = base_pa;
+        return ZX_OK;
+    }
+
+    // only fault in a whole run if nothing has been committed yet, and never on a
+    // read fault, which should keep being served from the zero page
+    if (present != 0 || (pf_flags & VMM_PF_FLAG_FAULT_MASK) == 0 ||
+        (pf_flags & VMM_PF_FLAG_WRITE) == 0) {
+        return ZX_ERR_NOT_FOUND;
+    }
+
+    list_node page_list;
+    list_initialize(&page_list);
+
+    paddr_t pa;
+    zx_status_t status = pmm_alloc_contiguous(LARGE_PAGE_COUNT,
+                                              pmm_alloc_flags_ | PMM_ALLOC_FLAG_PREFER_ZEROED,
+                                              LARGE_PAGE_SIZE_SHIFT, &pa, &page_list);
+    if (status != ZX_OK) {
+        kcounter_add(vm_large_page_alloc_fail, 1);
+        return ZX_ERR_NO_MEMORY;
+    }
+
+    for (uint64_t o = offset; o < end; o += PAGE_SIZE) {
+        vm_page_t* p = list_remove_head_type(&page_list, vm_page_t, queue_node);
+        DEBUG_ASSERT(p);
+
+        // the pmm may already have zeroed the page in the background
+        if (!p->zeroed) {
+            ZeroPage(p);
+        }
+        InitializeVmPage(p);
+
+// if ARM and not fully cached, clean/invalidate the page after zeroing it
+#if ARCH_ARM64
+        if (cache_policy_ != ARCH_MMU_FLAG_CACHED) {
+            arch_clean_invalidate_cache_range((addr_t)paddr_to_physmap(p->paddr()), PAGE_SIZE);
+        }
+#endif
+
+        status = page_list_.AddPage(p, o);
+        DEBUG_ASSERT(status == ZX_OK);
+    }
+    kcounter_add(vm_large_page_alloc, 1);
+
+    // other mappings may have covered this range of the vmo, so unmap those ranges
+    RangeChangeUpdateLocked(offset, LARGE_PAGE_SIZE);
+
+    LTRACEF("faulted in large page at offset %#" PRIx64 ", pa %#" PRIxPTR "\n", offset, pa);
+
+    *pa_out = pa;
+    return ZX_OK;
+}
+
 zx_status_t VmObjectPaged::CommitRange(uint64_t offset, uint64_t len, uint64_t* committed) {
     canary_.Assert();
     LTRACEF("offset %#" PRIx64 ", len %#" PRIx64 "\n", offset, len);
@@ -541,6 +979,10 @@ zx_status_t VmObjectPaged::CommitRange(uint64_t offset, uint64_t len, uint64_t*
         *committed = 0;
     }
 
+    if (is_pager_backed()) {
+        return CommitRangeFromSource(offset, len, committed);
+    }
+
     Guard<fbl::Mutex> guard{&lock_};
 
     // trim the size
@@ -579,39 +1021,126 @@ zx_status_t VmObjectPaged::CommitRange(uint64_t offset, uint64_t len, uint64_t*
         return ZX_OK;
     }
 
-    // allocate count number of pages
+    // Without a parent, every empty LARGE_PAGE_SIZE aligned run in the range
+    // can be backed by a physically contiguous run of pages, so faults on it
+    // can later be satisfied with a single large page mapping.
+    auto is_empty_large_run = [this, end](uint64_t o) {
+        if (parent_ || !IS_LARGE_PAGE_ALIGNED(o) || end - o < LARGE_PAGE_SIZE) {
+            return false;
+        }
+        bool empty = true;
+        page_list_.ForEveryPageInRange(
+            [&empty](const auto p, uint64_t off) {
+                empty = false;
+                return ZX_ERR_STOP;
+            },
+            o, o + LARGE_PAGE_SIZE);
+        return empty;
+    };
+
+    // allocate contiguous runs for the empty large runs, in offset order,
+    // until the pmm can't find one
+    list_node runs;
+    list_initialize(&runs);
+    size_t run_count = 0;
+    for (uint64_t o = ROUNDUP(offset, LARGE_PAGE_SIZE); o < end && end - o >= LARGE_PAGE_SIZE;
+         o += LARGE_PAGE_SIZE) {
+        if (!is_empty_large_run(o)) {
+            continue;
+        }
+        paddr_t pa;
+        if (pmm_alloc_contiguous(LARGE_PAGE_COUNT,
+                                 pmm_alloc_flags_ | PMM_ALLOC_FLAG_PREFER_ZEROED,
+                                 LARGE_PAGE_SIZE_SHIFT, &pa, &runs) != ZX_OK) {
+            break;
+        }
+        run_count++;
+    }
+
+    // allocate the rest of the pages in one batch
     list_node page_list;
     list_initialize(&page_list);
 
-    zx_status_t status = pmm_alloc_pages(count, pmm_alloc_flags_, &page_list);
+    const size_t single_count = count - run_count * LARGE_PAGE_COUNT;
+    zx_status_t status = pmm_alloc_pages(single_count,
+                                         pmm_alloc_flags_ | PMM_ALLOC_FLAG_PREFER_ZEROED,
+                                         &page_list);
     if (status != ZX_OK) {
+        pmm_free(&runs);
         return status;
     }
 
     // unmap all of the pages in this range on all the mapping regions
     RangeChangeUpdateLocked(offset, end - offset);
 
-    // add them to the appropriate range of the object
-    for (uint64_t o = offset; o < end; o += PAGE_SIZE) {
-        // Don't commit if we already have this page
-        vm_page_t* p = page_list_.GetPage(o);
-        if (p) {
-            continue;
+    if (!parent_) {
+        // Every page is going to be zero filled, so zero them all up front,
+        // spread over several cpus if there are enough of them.
+        ZeroPageList(&runs, run_count * LARGE_PAGE_COUNT);
+        ZeroPageList(&page_list, single_count);
+
+        auto commit_page = [this, &committed](list_node* pages, uint64_t o) {
+            vm_page_t* p = list_remove_head_type(pages, vm_page_t, queue_node);
+            DEBUG_ASSERT(p);
+            InitializeVmPage(p);
+
+// if ARM and not fully cached, clean/invalidate the page after zeroing it
+#if ARCH_ARM64
+            if (cache_policy_ != ARCH_MMU_FLAG_CACHED) {
+                arch_clean_invalidate_cache_range((addr_t)paddr_to_physmap(p->paddr()), PAGE_SIZE);
+            }
+#endif
+
+            zx_status_t status = page_list_.AddPage(p, o);
+            DEBUG_ASSERT(status == ZX_OK);
+            if (committed) {
+                *committed += PAGE_SIZE;
+            }
+        };
+
+        // The runs were allocated for the first run_count empty large runs,
+        // and nothing in the range has changed since, so walking the range
+        // in the same order hands each run to the right offset.
+        size_t runs_left = run_count;
+        for (uint64_t o = offset; o < end;) {
+            if (runs_left > 0 && is_empty_large_run(o)) {
+                for (uint64_t run_end = o + LARGE_PAGE_SIZE; o < run_end; o += PAGE_SIZE) {
+                    commit_page(&runs, o);
+                }
+                runs_left--;
+                kcounter_add(vm_commit_large_run, 1);
+                continue;
+            }
+            if (!page_list_.GetPage(o)) {
+                commit_page(&page_list, o);
+            }
+            o += PAGE_SIZE;
         }
+        DEBUG_ASSERT(runs_left == 0);
+    } else {
+        // add them to the appropriate range of the object
+        for (uint64_t o = offset; o < end; o += PAGE_SIZE) {
+            // Don't commit if we already have this page
+            vm_page_t* p = page_list_.GetPage(o);
+            if (p) {
+                continue;
+            }
 
-        // Check if our parent has the page
-        paddr_t pa;
-        const uint flags = VMM_PF_FLAG_SW_FAULT | VMM_PF_FLAG_WRITE;
-        // Should not be able to fail, since we're providing it memory and the
-        // range should be valid.
-        zx_status_t status = GetPageLocked(o, flags, &page_list, &p, &pa);
-        ASSERT(status == ZX_OK);
+            // Check if our parent has the page
+            paddr_t pa;
+            const uint flags = VMM_PF_FLAG_SW_FAULT | VMM_PF_FLAG_WRITE;
+            // Should not be able to fail, since we're providing it memory and the
+            // range should be valid.
+            zx_status_t status = GetPageLocked(o, flags, &page_list, nullptr, &p, &pa);
+            ASSERT(status == ZX_OK);
 
-        if (committed) {
-            *committed += PAGE_SIZE;
+            if (committed) {
+                *committed += PAGE_SIZE;
+            }
         }
     }
 
+    DEBUG_ASSERT(list_is_empty(&runs));
     DEBUG_ASSERT(list_is_empty(&page_list));
 
     // for now we only support committing as much as we were asked for
@@ -620,6 +1149,57 @@ zx_status_t VmObjectPaged::CommitRange(uint64_t offset, uint64_t len, uint64_t*
     return ZX_OK;
 }
 
+// Pages that come from a page source have to be waited for one request at a
+// time, with the lock dropped, so they are committed page by page.
+zx_status_t VmObjectPaged::CommitRangeFromSource(uint64_t offset, uint64_t len,
+                                                 uint64_t* committed) {
+    PageRequest page_request;
+    bool waited = false;
+    Guard<fbl::Mutex> guard{&lock_};
+
+    for (uint64_t o = ROUNDDOWN(offset, PAGE_SIZE);;) {
+        // trim the size again after every wait, in case we were resized meanwhile
+        uint64_t new_len;
+        if (!TrimRange(offset, len, size_, &new_len)) {
+            return ZX_ERR_OUT_OF_RANGE;
+        }
+        if (o >= ROUNDUP_PAGE_SIZE(offset + new_len)) {
+            return ZX_OK;
+        }
+
+        // Don't commit if we already have this page, unless it was just supplied for us
+        if (page_list_.GetPage(o)) {
+            if (waited && committed) {
+                *committed += PAGE_SIZE;
+            }
+            waited = false;
+            o += PAGE_SIZE;
+            continue;
+        }
+
+        zx_status_t status = GetPageLocked(o, VMM_PF_FLAG_SW_FAULT | VMM_PF_FLAG_WRITE, nullptr,
+                                           &page_request, nullptr, nullptr);
+        if (status == ZX_ERR_SHOULD_WAIT) {
+            guard.CallUnlocked([&page_request, &status]() { status = page_request.Wait(); });
+            if (status != ZX_OK) {
+                return status;
+            }
+            // the supplied page is now ours, or our parent's for a clone to copy
+            waited = true;
+            continue;
+        }
+        if (status != ZX_OK) {
+            return status;
+        }
+
+        if (committed) {
+            *committed += PAGE_SIZE;
+        }
+        waited = false;
+        o += PAGE_SIZE;
+    }
+}
+
 zx_status_t VmObjectPaged::DecommitRange(uint64_t offset, uint64_t len, uint64_t* decommitted) {
     canary_.Assert();
     LTRACEF("offset %#" PRIx64 ", len %#" PRIx64 "\n", offset, len);
@@ -665,16 +1245,259 @@ zx_status_t VmObjectPaged::DecommitRange(uint64_t offset, uint64_t len, uint64_t
     // unmap all of the pages in this range on all the mapping regions
     RangeChangeUpdateLocked(start, page_aligned_len);
 
-    // iterate through the pages, freeing them
-    // TODO: use page_list iterator, move pages to list, free at once
-    while (start < end) {
-        auto status = page_list_.FreePage(start);
-        if (status == ZX_OK && decommitted) {
-            *decommitted += PAGE_SIZE;
+    // free the pages of the range at once, only visiting the parts of it that have any
+    const size_t freed = page_list_.FreePages(start, end);
+    if (decommitted) {
+        *decommitted += freed * PAGE_SIZE;
+    }
+
+    return ZX_OK;
+}
+
+void VmObjectPaged::AgePages() {
+    canary_.Assert();
+
+    Guard<fbl::Mutex> guard{&lock_};
+    page_list_.ForEveryPage(
+        [](const auto p, uint64_t off) {
+            if (p->state != VM_PAGE_STATE_OBJECT) {
+                return ZX_ERR_NEXT;
+            }
+            if (__atomic_exchange_n(&p->object.accessed, 0, __ATOMIC_RELAXED)) {
+                p->object.age = 0;
+            } else if (p->object.age < VM_PAGE_OBJECT_MAX_AGE) {
+                p->object.age++;
+            }
+            return ZX_ERR_NEXT;
+        });
+}
+
+size_t VmObjectPaged::ActivePages() const {
+    canary_.Assert();
+
+    Guard<fbl::Mutex> guard{&lock_};
+    size_t count = 0;
+    page_list_.ForEveryPage(
+        [&count](const auto p, uint64_t off) {
+            if (p->object.age < VM_PAGE_OBJECT_INACTIVE_AGE ||
+                __atomic_load_n(&p->object.accessed, __ATOMIC_RELAXED)) {
+                count++;
+            }
+            return ZX_ERR_NEXT;
+        });
+    return count;
+}
+
+// The only pages that can be rebuilt without their contents are the ones
+// holding nothing but zeroes: once freed, reads see the zero page and writes
+// fault in a fresh zeroed page, just as if the page had never been committed.
+size_t VmObjectPaged::ReclaimPages(size_t max_pages, uint8_t min_age) {
+    canary_.Assert();
+
+    if (options_ & kContiguous) {
+        return 0;
+    }
+
+    Guard<fbl::Mutex> guard{&lock_};
+
+    // a clone would show its parent's page in place of the freed one, a page
+    // source would supply its original contents again, and the kernel expects
+    // its mappings to stay backed
+    if (parent_ || page_source_ || cache_policy_ != ARCH_MMU_FLAG_CACHED) {
+        return 0;
+    }
+    for (const auto& m : mapping_list_) {
+        if (!m.aspace()->is_user()) {
+            return 0;
+        }
+    }
+
+    constexpr size_t kBatch = 32;
+    uint64_t candidates[kBatch];
+    size_t freed = 0;
+    uint64_t start = 0;
+    bool more = true;
+    while (more && freed < max_pages) {
+        const size_t limit = MIN(kBatch, max_pages - freed);
+        size_t count = 0;
+        more = false;
+        page_list_.ForEveryPageInRange(
+            [&](const auto p, uint64_t off) {
+                if (count == limit) {
+                    start = off;
+                    more = true;
+                    return ZX_ERR_STOP;
+                }
+                if (p->state == VM_PAGE_STATE_OBJECT && p->object.pin_count == 0 &&
+                    p->object.age >= min_age && IsZeroPage(p)) {
+                    candidates[count++] = off;
+                }
+                return ZX_ERR_NEXT;
+            },
+            start, size_);
+
+        for (size_t i = 0; i < count; i++) {
+            // until it is unmapped the page can still be written through user
+            // mappings, so only trust its contents afterwards
+            RangeChangeUpdateLocked(candidates[i], PAGE_SIZE);
+            if (IsZeroPage(page_list_.GetPage(candidates[i]))) {
+                page_list_.FreePage(candidates[i]);
+                freed++;
+            }
+        }
+    }
+
+    kcounter_add(vm_reclaim_zero_page, freed);
+    return freed;
+}
+
+zx_status_t VmObjectPaged::TakePages(uint64_t offset, uint64_t len, list_node* pages) {
+    canary_.Assert();
+
+    if (!IS_PAGE_ALIGNED(offset) || !IS_PAGE_ALIGNED(len)) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+
+    // fill in the holes first, copying a clone's pages out of its parent
+    zx_status_t status = CommitRange(offset, len, nullptr);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    Guard<fbl::Mutex> guard{&lock_};
+
+    if (!InRange(offset, len, size_)) {
+        return ZX_ERR_OUT_OF_RANGE;
+    }
+
+    // the pages of a contiguous vmo or pinned pages have to stay where they
+    // are, and children would see our pages vanish from under them
+    if (is_contiguous() || !children_list_.is_empty() || AnyPagesPinnedLocked(offset, len)) {
+        return ZX_ERR_BAD_STATE;
+    }
+
+    // the range may have been decommitted again while we were unlocked
+    const uint64_t end = offset + len;
+    for (uint64_t o = offset; o < end; o += PAGE_SIZE) {
+        if (!page_list_.GetPage(o)) {
+            return ZX_ERR_BAD_STATE;
+        }
+    }
+
+    // unmap all of the pages in this range on all the mapping regions
+    RangeChangeUpdateLocked(offset, len);
+
+    for (uint64_t o = offset; o < end; o += PAGE_SIZE) {
+        vm_page_t* p;
+        status = page_list_.RemovePage(o, &p);
+        DEBUG_ASSERT(status == ZX_OK);
+        list_add_tail(pages, &p->queue_node);
+    }
+
+    return ZX_OK;
+}
+
+zx_status_t VmObjectPaged::ReplacePages(uint64_t offset, uint64_t len, list_node* pages) {
+    canary_.Assert();
+
+    if (!IS_PAGE_ALIGNED(offset) || !IS_PAGE_ALIGNED(len)) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+    if (list_length(pages) != len / PAGE_SIZE) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+
+    Guard<fbl::Mutex> guard{&lock_};
+
+    if (!InRange(offset, len, size_)) {
+        return ZX_ERR_OUT_OF_RANGE;
+    }
+
+    // the pages of a contiguous vmo or pinned pages have to stay where they
+    // are, a page source expects to be the one supplying our pages, and pages
+    // coming from a cached mapping may have dirty lines for an uncached one
+    if (is_contiguous() || page_source_ || cache_policy_ != ARCH_MMU_FLAG_CACHED ||
+        AnyPagesPinnedLocked(offset, len)) {
+        return ZX_ERR_BAD_STATE;
+    }
+
+    // unmap everything in the range, be it our pages or our parent's
+    RangeChangeUpdateLocked(offset, len);
+
+    list_node displaced;
+    list_initialize(&displaced);
+
+    const uint64_t end = offset + len;
+    zx_status_t status = ZX_OK;
+    for (uint64_t o = offset; o < end; o += PAGE_SIZE) {
+        vm_page_t* old;
+        if (page_list_.RemovePage(o, &old) == ZX_OK) {
+            list_add_tail(&displaced, &old->queue_node);
         }
-        start += PAGE_SIZE;
+
+        vm_page_t* p = list_peek_head_type(pages, vm_page_t, queue_node);
+        DEBUG_ASSERT(p->state == VM_PAGE_STATE_OBJECT && p->object.pin_count == 0);
+        status = page_list_.AddPage(p, o);
+        if (status != ZX_OK) {
+            break;
+        }
+        list_delete(&p->queue_node);
+        p->object.accessed = 0;
+        p->object.age = 0;
     }
 
+    pmm_free(&displaced);
+    return status;
+}
+
+zx_status_t VmObjectPaged::SupplyPages(uint64_t offset, uint64_t len, list_node* pages) {
+    canary_.Assert();
+
+    // any pages we don't end up keeping go back to the pmm
+    auto free_pages = fbl::MakeAutoCall([pages]() { pmm_free(pages); });
+
+    if (!page_source_) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+    if (!IS_PAGE_ALIGNED(offset) || !IS_PAGE_ALIGNED(len)) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+
+    Guard<fbl::Mutex> guard{&lock_};
+
+    if (!InRange(offset, len, size_)) {
+        return ZX_ERR_OUT_OF_RANGE;
+    }
+
+    list_node duplicates;
+    list_initialize(&duplicates);
+
+    const uint64_t end = offset + len;
+    for (uint64_t o = offset; o < end; o += PAGE_SIZE) {
+        vm_page_t* p = list_remove_head_type(pages, vm_page_t, queue_node);
+        if (!p) {
+            return ZX_ERR_INVALID_ARGS;
+        }
+
+        // keep the page we already have, which may be mapped or written to by now
+        if (page_list_.GetPage(o)) {
+            list_add_tail(&duplicates, &p->queue_node);
+            continue;
+        }
+
+        DEBUG_ASSERT(p->state == VM_PAGE_STATE_OBJECT && p->object.pin_count == 0);
+        p->object.accessed = 0;
+        p->object.age = 0;
+
+        // nothing can be mapped at an offset we had no page for, so there is
+        // nothing to unmap
+        zx_status_t status = page_list_.AddPage(p, o);
+        DEBUG_ASSERT(status == ZX_OK);
+    }
+    list_splice_after(&duplicates, pages);
+
+    page_source_->OnPagesSupplied(offset, len);
+
     return ZX_OK;
 }
 
@@ -826,12 +1649,8 @@ zx_status_t VmObjectPaged::ResizeLocked(uint64_t s) {
         // unmap all of the pages in this range on all the mapping regions
         RangeChangeUpdateLocked(start, len);
 
-        // iterate through the pages, freeing them
-        // TODO: use page_list iterator, move pages to list, free at once
-        while (start < end) {
-            page_list_.FreePage(start);
-            start += PAGE_SIZE;
-        }
+        // free the pages past the new end at once
+        page_list_.FreePages(start, end);
     } else if (s > size_) {
         // expanding
         // figure the starting and ending page offset that is affected
@@ -896,6 +1715,7 @@ zx_status_t VmObjectPaged::ReadWriteInternal(uint64_t offset, size_t len, bool w
     }
 
     // walk the list of pages and do the write
+    PageRequest page_request;
     uint64_t src_offset = offset;
     size_t dest_offset = 0;
     while (len > 0) {
@@ -906,7 +1726,19 @@ zx_status_t VmObjectPaged::ReadWriteInternal(uint64_t offset, size_t len, bool w
         paddr_t pa;
         auto status = GetPageLocked(src_offset,
                                     VMM_PF_FLAG_SW_FAULT | (write ? VMM_PF_FLAG_WRITE : 0),
-                                    nullptr, nullptr, &pa);
+                                    nullptr, &page_request, nullptr, &pa);
+        if (status == ZX_ERR_SHOULD_WAIT) {
+            // wait for the page source without the lock, then check the range again
+            // since we may have been resized meanwhile
+            guard.CallUnlocked([&page_request, &status]() { status = page_request.Wait(); });
+            if (status != ZX_OK) {
+                return status;
+            }
+            if (src_offset + len > size_) {
+                return ZX_ERR_OUT_OF_RANGE;
+            }
+            continue;
+        }
         if (status != ZX_OK) {
             return status;
         }
@@ -993,7 +1825,7 @@ zx_status_t VmObjectPaged::Lookup(uint64_t offset, uint64_t len, uint pf_flags,
 
                 paddr_t pa;
                 zx_status_t status = this->GetPageLocked(missing_off, pf_flags, nullptr,
-                                                         nullptr, &pa);
+                                                         nullptr, nullptr, &pa);
                 if (status != ZX_OK) {
                     return ZX_ERR_NO_MEMORY;
                 }
@@ -1028,7 +1860,7 @@ zx_status_t VmObjectPaged::Lookup(uint64_t offset, uint64_t len, uint pf_flags,
     // If expected_next_off isn't at the end, there's a gap to process
     for (uint64_t off = expected_next_off; off < end_page_offset; off += PAGE_SIZE) {
         paddr_t pa;
-        zx_status_t status = GetPageLocked(off, pf_flags, nullptr, nullptr, &pa);
+        zx_status_t status = GetPageLocked(off, pf_flags, nullptr, nullptr, nullptr, &pa);
         if (status != ZX_OK) {
             return ZX_ERR_NO_MEMORY;
         }
@@ -1115,49 +1947,89 @@ zx_status_t VmObjectPaged::CacheOp(const uint64_t start_offset, const uint64_t l
     }
 
     const size_t end_offset = static_cast<size_t>(start_offset + len);
-    size_t op_start_offset = static_cast<size_t>(start_offset);
-
-    while (op_start_offset != end_offset) {
-        // Offset at the end of the current page.
-        const size_t page_end_offset = ROUNDUP(op_start_offset + 1, PAGE_SIZE);
-
-        // This cache op will either terminate at the end of the current page or
-        // at the end of the whole op range -- whichever comes first.
-        const size_t op_end_offset = MIN(page_end_offset, end_offset);
 
-        const size_t cache_op_len = op_end_offset - op_start_offset;
+    // Syncing a large range line by line invalidates far more icache lines
+    // than the icache holds, so clean the dcache by line and drop the whole
+    // icache once instead.  The dcache ops stay by line whatever the size:
+    // set/way ops only reach the local cpu's caches and lose data another
+    // cpu may dirty meanwhile.
+    const bool sync_all = type == CacheOpType::Sync && len >= kCacheOpSyncAllThreshold;
+
+    // The physically contiguous run of pages being built up, as a physmap
+    // range.
+    addr_t run_addr = 0;
+    size_t run_len = 0;
+    auto flush_run = [type, sync_all, &run_addr, &run_len]() {
+        if (run_len == 0) {
+            return;
+        }
+        LTRACEF("addr %#" PRIxPTR " len %#zx op %d\n", run_addr, run_len, (int)type);
+
+        switch (type) {
+        case CacheOpType::Invalidate:
+            arch_invalidate_cache_range(run_addr, run_len);
+            break;
+        case CacheOpType::Clean:
+            arch_clean_cache_range(run_addr, run_len);
+            break;
+        case CacheOpType::CleanInvalidate:
+            arch_clean_invalidate_cache_range(run_addr, run_len);
+            break;
+        case CacheOpType::Sync:
+            if (sync_all) {
+                arch_clean_cache_range_pou(run_addr, run_len);
+            } else {
+                arch_sync_cache_range(run_addr, run_len);
+            }
+            break;
+        }
+        kcounter_add(vm_cache_op_run, 1);
+        run_len = 0;
+    };
 
-        const size_t page_offset = op_start_offset % PAGE_SIZE;
+    // Adds the part of the page at |page_offset| with physical address |pa|
+    // which lies within the op range.
+    auto add_page = [start_offset, end_offset, &run_addr, &run_len, &flush_run](
+                        uint64_t page_offset, paddr_t pa) {
+        const size_t op_start = MAX(static_cast<size_t>(page_offset),
+                                    static_cast<size_t>(start_offset));
+        const size_t op_end = MIN(static_cast<size_t>(page_offset + PAGE_SIZE), end_offset);
+        const addr_t addr =
+            reinterpret_cast<addr_t>(paddr_to_physmap(pa)) + (op_start - page_offset);
+
+        if (run_len == 0 || run_addr + run_len != addr) {
+            flush_run();
+            run_addr = addr;
+        }
+        run_len += op_end - op_start;
+    };
 
-        // lookup the physical address of the page, careful not to fault in a new one
-        paddr_t pa;
-        auto status = GetPageLocked(op_start_offset, 0, nullptr, nullptr, &pa);
-
-        if (likely(status == ZX_OK)) {
-            // Convert the page address to a Kernel virtual address.
-            const void* ptr = paddr_to_physmap(pa);
-            const addr_t cache_op_addr = reinterpret_cast<addr_t>(ptr) + page_offset;
-
-            LTRACEF("ptr %p op %d\n", ptr, (int)type);
-
-            // Perform the necessary cache op against this page.
-            switch (type) {
-            case CacheOpType::Invalidate:
-                arch_invalidate_cache_range(cache_op_addr, cache_op_len);
-                break;
-            case CacheOpType::Clean:
-                arch_clean_cache_range(cache_op_addr, cache_op_len);
-                break;
-            case CacheOpType::CleanInvalidate:
-                arch_clean_invalidate_cache_range(cache_op_addr, cache_op_len);
-                break;
-            case CacheOpType::Sync:
-                arch_sync_cache_range(cache_op_addr, cache_op_len);
-                break;
+    const uint64_t page_start = ROUNDDOWN(start_offset, PAGE_SIZE);
+    const uint64_t page_end = ROUNDUP(end_offset, PAGE_SIZE);
+    if (parent_ == nullptr) {
+        // Every page is in our own list, so walk just the committed ones.
+        page_list_.ForEveryPageInRange(
+            [&add_page](const auto p, uint64_t off) {
+                add_page(off, p->paddr());
+                return ZX_ERR_NEXT;
+            },
+            page_start, page_end);
+    } else {
+        // Pages may come from the parent chain, so look each up in turn,
+        // careful not to fault in new ones.
+        for (uint64_t off = page_start; off != page_end; off += PAGE_SIZE) {
+            paddr_t pa;
+            zx_status_t status = GetPageLocked(off, 0, nullptr, nullptr, nullptr, &pa);
+            if (status == ZX_OK) {
+                add_page(off, pa);
             }
         }
+    }
+    flush_run();
 
-        op_start_offset += cache_op_len;
+    if (sync_all) {
+        arch_invalidate_icache_all();
+        kcounter_add(vm_cache_op_icache_all, 1);
     }
 
     return ZX_OK;
@@ -71,6 +71,28 @@ VmPageList::~VmPageList() {
     DEBUG_ASSERT(list_.is_empty());
 }
 
+VmPageListNode* VmPageList::FindNode(uint64_t node_offset) {
+    if (last_node_ && last_node_->offset() == node_offset) {
+        return last_node_;
+    }
+
+    auto pln = list_.find(node_offset);
+    if (!pln.IsValid()) {
+        return nullptr;
+    }
+    last_node_ = &*pln;
+    return last_node_;
+}
+
+void VmPageList::EraseNode(VmPageListNode* node) {
+    LTRACEF_LEVEL(2, "%p freeing the list node\n", this);
+
+    if (last_node_ == node) {
+        last_node_ = nullptr;
+    }
+    list_.erase(*node);
+}
+
 zx_status_t VmPageList::AddPage(vm_page* p, uint64_t offset) {
     uint64_t node_offset = ROUNDDOWN(offset, PAGE_SIZE * VmPageListNode::kPageFanOut);
     size_t index = (offset >> PAGE_SIZE_SHIFT) % VmPageListNode::kPageFanOut;
@@ -79,8 +101,8 @@ zx_status_t VmPageList::AddPage(vm_page* p, uint64_t offset) {
                   node_offset, index);
 
     // lookup the tree node that holds this page
-    auto pln = list_.find(node_offset);
-    if (!pln.IsValid()) {
+    auto pln = FindNode(node_offset);
+    if (!pln) {
         fbl::AllocChecker ac;
         fbl::unique_ptr<VmPageListNode> pl =
             fbl::unique_ptr<VmPageListNode>(new (&ac) VmPageListNode(node_offset));
@@ -92,6 +114,7 @@ zx_status_t VmPageList::AddPage(vm_page* p, uint64_t offset) {
         __UNUSED auto status = pl->AddPage(p, index);
         DEBUG_ASSERT(status == ZX_OK);
 
+        last_node_ = pl.get();
         list_.insert(fbl::move(pl));
     } else {
         pln->AddPage(p, index);
@@ -108,14 +131,42 @@ vm_page* VmPageList::GetPage(uint64_t offset) {
                   index);
 
     // lookup the tree node that holds this page
-    auto pln = list_.find(node_offset);
-    if (!pln.IsValid()) {
+    auto pln = FindNode(node_offset);
+    if (!pln) {
         return nullptr;
     }
 
     return pln->GetPage(index);
 }
 
+zx_status_t VmPageList::RemovePage(uint64_t offset, vm_page** page_out) {
+    uint64_t node_offset = ROUNDDOWN(offset, PAGE_SIZE * VmPageListNode::kPageFanOut);
+    size_t index = (offset >> PAGE_SIZE_SHIFT) % VmPageListNode::kPageFanOut;
+
+    LTRACEF_LEVEL(2, "%p offset %#" PRIx64 " node_offset %#" PRIx64 " index %zu\n", this, offset, node_offset,
+                  index);
+
+    // lookup the tree node that holds this page
+    auto pln = FindNode(node_offset);
+    if (!pln) {
+        return ZX_ERR_NOT_FOUND;
+    }
+
+    // remove this page
+    auto page = pln->RemovePage(index);
+    if (!page) {
+        return ZX_ERR_NOT_FOUND;
+    }
+
+    // if it was the last page in the node, remove the node from the tree
+    if (pln->IsEmpty()) {
+        EraseNode(pln);
+    }
+
+    *page_out = page;
+    return ZX_OK;
+}
+
 zx_status_t VmPageList::FreePage(uint64_t offset) {
     uint64_t node_offset = ROUNDDOWN(offset, PAGE_SIZE * VmPageListNode::kPageFanOut);
     size_t index = (offset >> PAGE_SIZE_SHIFT) % VmPageListNode::kPageFanOut;
@@ -124,8 +175,8 @@ zx_status_t VmPageList::FreePage(uint64_t offset) {
                   index);
 
     // lookup the tree node that holds this page
-    auto pln = list_.find(node_offset);
-    if (!pln.IsValid()) {
+    auto pln = FindNode(node_offset);
+    if (!pln) {
         return ZX_ERR_NOT_FOUND;
     }
 
@@ -134,8 +185,7 @@ zx_status_t VmPageList::FreePage(uint64_t offset) {
     if (page) {
         // if it was the last page in the node, remove the node from the tree
         if (pln->IsEmpty()) {
-            LTRACEF_LEVEL(2, "%p freeing the list node\n", this);
-            list_.erase(*pln);
+            EraseNode(pln);
         }
 
         pmm_free_page(page);
@@ -144,6 +194,52 @@ zx_status_t VmPageList::FreePage(uint64_t offset) {
     return ZX_OK;
 }
 
+size_t VmPageList::RemovePages(uint64_t start_offset, uint64_t end_offset, list_node* removed) {
+    DEBUG_ASSERT(IS_PAGE_ALIGNED(start_offset) && IS_PAGE_ALIGNED(end_offset));
+    LTRACEF("%p start %#" PRIx64 " end %#" PRIx64 "\n", this, start_offset, end_offset);
+
+    if (start_offset >= end_offset) {
+        return 0;
+    }
+
+    size_t count = 0;
+    auto per_page_func = [&](vm_page*& p, uint64_t offset) {
+        list_add_tail(removed, &p->queue_node);
+        p = nullptr;
+        count++;
+        return ZX_ERR_NEXT;
+    };
+
+    // the node holding start_offset, if any, is the one before the first node
+    // that starts after it
+    auto itr = --list_.upper_bound(start_offset);
+    if (!itr.IsValid()) {
+        itr = list_.begin();
+    }
+    while (itr.IsValid() && itr->offset() < end_offset) {
+        auto& pl = *itr;
+        ++itr;
+        pl.ForEveryPage(per_page_func, start_offset, end_offset);
+        if (pl.IsEmpty()) {
+            EraseNode(&pl);
+        }
+    }
+
+    return count;
+}
+
+size_t VmPageList::FreePages(uint64_t start_offset, uint64_t end_offset) {
+    list_node list;
+    list_initialize(&list);
+
+    size_t count = RemovePages(start_offset, end_offset, &list);
+
+    // return all the pages to the pmm at once
+    pmm_free(&list);
+
+    return count;
+}
+
 size_t VmPageList::FreeAllPages() {
     LTRACEF("%p\n", this);
 
@@ -169,6 +265,7 @@ size_t VmPageList::FreeAllPages() {
     pmm_free(&list);
 
     // empty the tree
+    last_node_ = nullptr;
     list_.clear();
 
     return count;
@@ -8,7 +8,12 @@
 #include <err.h>
 #include <fbl/alloc_checker.h>
 #include <fbl/array.h>
+#include <fbl/unique_ptr.h>
 #include <lib/unittest/unittest.h>
+#include <platform.h>
+#include <vm/fault.h>
+#include <vm/kstack.h>
+#include <vm/page_source.h>
 #include <vm/physmap.h>
 #include <vm/vm.h>
 #include <vm/vm_address_region.h>
@@ -16,6 +21,7 @@
 #include <vm/vm_object.h>
 #include <vm/vm_object_paged.h>
 #include <vm/vm_object_physical.h>
+#include <zircon/time.h>
 #include <zircon/types.h>
 
 static const uint kArchRwFlags = ARCH_MMU_FLAG_PERM_READ | ARCH_MMU_FLAG_PERM_WRITE;
@@ -84,6 +90,60 @@ static bool pmm_alloc_contiguous_one_test() {
     END_TEST;
 }
 
+// Cycles more single pages than a per-cpu cache holds through the pmm so
+// that refill, drain and flush all get exercised.
+static bool pmm_page_cache_test() {
+    BEGIN_TEST;
+    static const size_t alloc_count = 256;
+    vm_page_t* pages[alloc_count];
+
+    for (size_t i = 0; i < alloc_count; i++) {
+        ASSERT_EQ(ZX_OK, pmm_alloc_page(0, &pages[i]), "pmm_alloc_page");
+        EXPECT_EQ(VM_PAGE_STATE_ALLOC, pages[i]->state, "page not in alloc state");
+    }
+    for (size_t i = 0; i < alloc_count; i++) {
+        pmm_free_page(pages[i]);
+    }
+
+    pmm_flush_page_caches();
+
+    // a contiguous allocation must still be possible after pages went through the caches
+    list_node list = LIST_INITIAL_VALUE(list);
+    paddr_t pa;
+    ASSERT_EQ(ZX_OK, pmm_alloc_contiguous(4, 0, PAGE_SIZE_SHIFT, &pa, &list), "");
+    EXPECT_EQ(4u, list_length(&list), "");
+    pmm_free(&list);
+    END_TEST;
+}
+
+// pages handed out as already zeroed must really be zero, and pages that went
+// through a free must not claim to be
+static bool pmm_zeroed_alloc_test() {
+    BEGIN_TEST;
+    static const size_t alloc_count = 64;
+    vm_page_t* pages[alloc_count];
+
+    for (size_t i = 0; i < alloc_count; i++) {
+        ASSERT_EQ(ZX_OK, pmm_alloc_page(PMM_ALLOC_FLAG_PREFER_ZEROED, &pages[i]),
+                  "pmm_alloc_page");
+        if (pages[i]->zeroed) {
+            const uint8_t* ptr = static_cast<uint8_t*>(paddr_to_physmap(pages[i]->paddr()));
+            bool zero = true;
+            for (size_t j = 0; j < PAGE_SIZE; j++) {
+                zero &= (ptr[j] == 0);
+            }
+            EXPECT_TRUE(zero, "zeroed page has contents\n");
+        }
+    }
+    for (size_t i = 0; i < alloc_count; i++) {
+        pmm_free_page(pages[i]);
+        EXPECT_FALSE(pages[i]->zeroed, "freed page still marked zeroed\n");
+    }
+
+    EXPECT_LE(pmm_count_zeroed_pages(), pmm_count_free_pages(), "");
+    END_TEST;
+}
+
 static uint32_t test_rand(uint32_t seed) {
     return (seed = seed * 1664525 + 1013904223);
 }
@@ -363,6 +423,93 @@ static bool vmo_commit_test() {
     END_TEST;
 }
 
+// Commits a range big enough to be zeroed in parallel and to hold large
+// runs, around a few pages that were committed and written beforehand.
+static bool vmo_commit_large_test() {
+    BEGIN_TEST;
+    static const size_t alloc_size = 32 * LARGE_PAGE_SIZE + 3 * PAGE_SIZE;
+    fbl::RefPtr<VmObject> vmo;
+    zx_status_t status = VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, 0u, alloc_size, &vmo);
+    ASSERT_EQ(status, ZX_OK, "vmobject creation\n");
+    ASSERT_TRUE(vmo, "vmobject creation\n");
+
+    const uint64_t marked[] = {PAGE_SIZE, LARGE_PAGE_SIZE + 5 * PAGE_SIZE, alloc_size - PAGE_SIZE};
+    const uint64_t marker = 0x1234567890abcdefUL;
+    for (uint64_t offset : marked) {
+        status = vmo->Write(&marker, offset, sizeof(marker));
+        ASSERT_EQ(ZX_OK, status, "writing marker\n");
+    }
+
+    uint64_t committed;
+    status = vmo->CommitRange(0, alloc_size, &committed);
+    ASSERT_EQ(ZX_OK, status, "committing vm object\n");
+    EXPECT_EQ(alloc_size - countof(marked) * PAGE_SIZE, committed,
+              "committing vm object\n");
+
+    // the pages written before keep their contents, and every other page
+    // reads back as zero
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<uint64_t[]> page(new (&ac) uint64_t[PAGE_SIZE / sizeof(uint64_t)]);
+    ASSERT_TRUE(ac.check(), "");
+    bool contents_ok = true;
+    for (uint64_t offset = 0; offset < alloc_size && contents_ok; offset += PAGE_SIZE) {
+        status = vmo->Read(page.get(), offset, PAGE_SIZE);
+        ASSERT_EQ(ZX_OK, status, "reading page\n");
+        bool is_marked = false;
+        for (uint64_t m : marked) {
+            is_marked = is_marked || m == offset;
+        }
+        for (size_t i = 0; i < PAGE_SIZE / sizeof(uint64_t); i++) {
+            uint64_t expected = (is_marked && i == 0) ? marker : 0;
+            if (page[i] != expected) {
+                contents_ok = false;
+            }
+        }
+    }
+    EXPECT_TRUE(contents_ok, "page contents after commit\n");
+    END_TEST;
+}
+
+// Ages the pages of a committed VMO until they are inactive and checks that
+// reclaim frees exactly the ones holding only zeroes.
+static bool vmo_reclaim_test() {
+    BEGIN_TEST;
+    static const size_t alloc_size = 4 * PAGE_SIZE;
+    fbl::RefPtr<VmObject> vmo;
+    zx_status_t status = VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, 0u, alloc_size, &vmo);
+    ASSERT_EQ(status, ZX_OK, "vmobject creation\n");
+    ASSERT_TRUE(vmo, "vmobject creation\n");
+
+    const uint64_t marker = 0x1234567890abcdefUL;
+    status = vmo->Write(&marker, PAGE_SIZE, sizeof(marker));
+    ASSERT_EQ(ZX_OK, status, "writing marker\n");
+    uint64_t committed;
+    status = vmo->CommitRange(0, alloc_size, &committed);
+    ASSERT_EQ(ZX_OK, status, "committing vm object\n");
+    EXPECT_EQ(alloc_size / PAGE_SIZE, vmo->ActivePages(), "fresh pages are active\n");
+
+    EXPECT_EQ(0u, vmo->ReclaimPages(SIZE_MAX, VM_PAGE_OBJECT_INACTIVE_AGE),
+              "reclaiming active pages\n");
+    for (int i = 0; i < VM_PAGE_OBJECT_INACTIVE_AGE; i++) {
+        vmo->AgePages();
+    }
+    EXPECT_EQ(0u, vmo->ActivePages(), "aged pages are inactive\n");
+
+    EXPECT_EQ(alloc_size / PAGE_SIZE - 1,
+              vmo->ReclaimPages(SIZE_MAX, VM_PAGE_OBJECT_INACTIVE_AGE),
+              "reclaiming inactive pages\n");
+    EXPECT_EQ(1u, vmo->AllocatedPages(), "only the marked page is left\n");
+
+    uint64_t val = 0;
+    status = vmo->Read(&val, PAGE_SIZE, sizeof(val));
+    ASSERT_EQ(ZX_OK, status, "reading marker\n");
+    EXPECT_EQ(marker, val, "marked page kept its contents\n");
+    status = vmo->Read(&val, 0, sizeof(val));
+    ASSERT_EQ(ZX_OK, status, "reading reclaimed page\n");
+    EXPECT_EQ(0u, val, "reclaimed page reads back as zero\n");
+    END_TEST;
+}
+
 // Creates a paged VMO, pins it, and tries operations that should unpin it.
 static bool vmo_pin_test() {
     BEGIN_TEST;
@@ -964,6 +1111,421 @@ static bool vmo_lookup_test() {
     END_TEST;
 }
 
+namespace {
+
+// Records the requests it gets instead of passing them on to a pager.
+class TestPageSource final : public PageSource {
+public:
+    int requests = 0;
+    uint64_t last_offset = 0;
+    uint64_t last_len = 0;
+
+private:
+    zx_status_t SendRequest(uint64_t offset, uint64_t len) final {
+        requests++;
+        last_offset = offset;
+        last_len = len;
+        return ZX_OK;
+    }
+};
+
+} // namespace
+
+static bool vmo_page_source_test() {
+    BEGIN_TEST;
+
+    static const size_t alloc_size = PAGE_SIZE * 4;
+    fbl::AllocChecker ac;
+    auto src = fbl::AdoptRef(new (&ac) TestPageSource());
+    ASSERT_TRUE(ac.check(), "page source creation\n");
+    fbl::RefPtr<VmObject> vmo;
+    zx_status_t status = VmObjectPaged::CreateExternal(src, alloc_size, &vmo);
+    ASSERT_EQ(ZX_OK, status, "vmobject creation\n");
+    EXPECT_TRUE(vmo->is_pager_backed(), "vmo has a page source\n");
+
+    // pages to supply are taken out of another vmo
+    fbl::RefPtr<VmObject> aux;
+    status = VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, 0u, alloc_size, &aux);
+    ASSERT_EQ(ZX_OK, status, "aux vmobject creation\n");
+    list_node pages = LIST_INITIAL_VALUE(pages);
+    status = aux->TakePages(0, PAGE_SIZE, &pages);
+    ASSERT_EQ(ZX_OK, status, "taking pages\n");
+    EXPECT_EQ(0u, aux->AllocatedPages(), "pages left the aux vmo\n");
+
+    PageRequest request;
+    paddr_t pa;
+    {
+        Guard<fbl::Mutex> guard{vmo->lock()};
+
+        // without a request there is nothing to wait on
+        status = vmo->GetPageLocked(PAGE_SIZE, VMM_PF_FLAG_SW_FAULT, nullptr, nullptr,
+                                    nullptr, &pa);
+        EXPECT_EQ(ZX_ERR_NOT_FOUND, status, "lookup without a request\n");
+        EXPECT_EQ(0, src->requests, "no request sent\n");
+
+        status = vmo->GetPageLocked(PAGE_SIZE, VMM_PF_FLAG_SW_FAULT, nullptr, &request,
+                                    nullptr, &pa);
+        EXPECT_EQ(ZX_ERR_SHOULD_WAIT, status, "missing page is requested\n");
+        EXPECT_EQ(1, src->requests, "request sent\n");
+        EXPECT_EQ(PAGE_SIZE, src->last_offset, "requested offset\n");
+        EXPECT_EQ(alloc_size - PAGE_SIZE, src->last_len, "readahead covers the missing pages\n");
+    }
+
+    status = vmo->SupplyPages(PAGE_SIZE, PAGE_SIZE, &pages);
+    EXPECT_EQ(ZX_OK, status, "supplying pages\n");
+    EXPECT_TRUE(list_is_empty(&pages), "supplied pages were consumed\n");
+    EXPECT_EQ(ZX_OK, request.Wait(), "request was satisfied\n");
+
+    {
+        Guard<fbl::Mutex> guard{vmo->lock()};
+        status = vmo->GetPageLocked(PAGE_SIZE, VMM_PF_FLAG_SW_FAULT, nullptr, &request,
+                                    nullptr, &pa);
+        EXPECT_EQ(ZX_OK, status, "supplied page is present\n");
+        EXPECT_EQ(1, src->requests, "no more requests\n");
+    }
+
+    // once the source goes away the missing pages can't be had
+    src->Detach();
+    {
+        Guard<fbl::Mutex> guard{vmo->lock()};
+        status = vmo->GetPageLocked(0, VMM_PF_FLAG_SW_FAULT, nullptr, &request, nullptr, &pa);
+        EXPECT_EQ(ZX_ERR_BAD_STATE, status, "detached source\n");
+    }
+
+    END_TEST;
+}
+
+// Requests riding on another request's readahead are sent on their own once
+// that request is gone without their page having been supplied.
+static bool page_source_readahead_test() {
+    BEGIN_TEST;
+
+    fbl::AllocChecker ac;
+    auto src = fbl::AdoptRef(new (&ac) TestPageSource());
+    ASSERT_TRUE(ac.check(), "page source creation\n");
+
+    PageRequest first;
+    PageRequest second;
+    EXPECT_EQ(ZX_ERR_SHOULD_WAIT, src->GetPages(0, PAGE_SIZE * 4, &first), "first request\n");
+    EXPECT_EQ(ZX_ERR_SHOULD_WAIT, src->GetPages(PAGE_SIZE * 2, PAGE_SIZE * 2, &second),
+              "second request\n");
+    EXPECT_EQ(1, src->requests, "covered request not sent\n");
+
+    // only the first page of the readahead range is supplied
+    src->OnPagesSupplied(0, PAGE_SIZE);
+    EXPECT_EQ(ZX_OK, first.Wait(), "first request satisfied\n");
+    EXPECT_EQ(2, src->requests, "orphaned request sent\n");
+    EXPECT_EQ(PAGE_SIZE * 2, src->last_offset, "orphaned request offset\n");
+    EXPECT_EQ(PAGE_SIZE, src->last_len, "orphaned request length\n");
+
+    src->OnPagesSupplied(PAGE_SIZE * 2, PAGE_SIZE);
+    EXPECT_EQ(ZX_OK, second.Wait(), "second request satisfied\n");
+    EXPECT_EQ(2, src->requests, "no more requests\n");
+
+    // a sender that stops waiting hands its range over the same way
+    {
+        PageRequest sender;
+        EXPECT_EQ(ZX_ERR_SHOULD_WAIT, src->GetPages(0, PAGE_SIZE * 4, &sender), "sender\n");
+        EXPECT_EQ(ZX_ERR_SHOULD_WAIT, src->GetPages(PAGE_SIZE, PAGE_SIZE * 3, &second),
+                  "rider\n");
+        EXPECT_EQ(3, src->requests, "rider not sent\n");
+    }
+    EXPECT_EQ(4, src->requests, "rider sent after the sender went away\n");
+    EXPECT_EQ(PAGE_SIZE, src->last_offset, "rider offset\n");
+
+    src->Detach();
+    EXPECT_EQ(ZX_ERR_BAD_STATE, second.Wait(), "detached source\n");
+
+    END_TEST;
+}
+
+static bool vmo_replace_pages_test() {
+    BEGIN_TEST;
+
+    static const size_t alloc_size = PAGE_SIZE * 2;
+    fbl::RefPtr<VmObject> src;
+    zx_status_t status = VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, 0u, alloc_size, &src);
+    ASSERT_EQ(ZX_OK, status, "src vmobject creation\n");
+    fbl::RefPtr<VmObject> dst;
+    status = VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, 0u, alloc_size, &dst);
+    ASSERT_EQ(ZX_OK, status, "dst vmobject creation\n");
+
+    uint8_t byte = 0x5a;
+    EXPECT_EQ(ZX_OK, src->Write(&byte, 0, 1), "writing src\n");
+    EXPECT_EQ(ZX_OK, dst->CommitRange(0, alloc_size, nullptr), "committing dst\n");
+
+    list_node pages = LIST_INITIAL_VALUE(pages);
+    status = src->TakePages(0, PAGE_SIZE, &pages);
+    ASSERT_EQ(ZX_OK, status, "taking pages\n");
+    vm_page_t* taken = list_peek_head_type(&pages, vm_page_t, queue_node);
+
+    // the page replaces the committed one, which is freed
+    status = dst->ReplacePages(PAGE_SIZE, PAGE_SIZE, &pages);
+    EXPECT_EQ(ZX_OK, status, "replacing pages\n");
+    EXPECT_TRUE(list_is_empty(&pages), "replaced pages were consumed\n");
+    EXPECT_EQ(alloc_size / PAGE_SIZE, dst->AllocatedPages(), "old page was freed\n");
+    uint8_t read = 0;
+    EXPECT_EQ(ZX_OK, dst->Read(&read, PAGE_SIZE, 1), "reading dst\n");
+    EXPECT_EQ(0x5a, read, "moved page has the data\n");
+
+    // pinned pages stay put, and the pages are handed back
+    status = src->TakePages(PAGE_SIZE, PAGE_SIZE, &pages);
+    ASSERT_EQ(ZX_OK, status, "taking pages\n");
+    EXPECT_EQ(ZX_OK, dst->Pin(PAGE_SIZE, PAGE_SIZE), "pinning dst\n");
+    status = dst->ReplacePages(PAGE_SIZE, PAGE_SIZE, &pages);
+    EXPECT_EQ(ZX_ERR_BAD_STATE, status, "replacing pinned pages\n");
+    EXPECT_EQ(1u, list_length(&pages), "pages were handed back\n");
+    dst->Unpin(PAGE_SIZE, PAGE_SIZE);
+    pmm_free(&pages);
+
+    // the moved page is the one dst reads from now
+    paddr_t pa = 0;
+    auto lookup_fn = [](void* context, size_t offset, size_t index, paddr_t pa) {
+        *static_cast<paddr_t*>(context) = pa;
+        return ZX_OK;
+    };
+    EXPECT_EQ(ZX_OK, dst->Lookup(PAGE_SIZE, PAGE_SIZE, 0, lookup_fn, &pa), "lookup\n");
+    EXPECT_EQ(taken->paddr(), pa, "page was moved, not copied\n");
+
+    END_TEST;
+}
+
+// Once the last reference to a parent goes, its clones end up with the pages
+// they can see and the parent leaves the chain.
+static bool vmo_hidden_parent_test() {
+    BEGIN_TEST;
+
+    static const size_t alloc_size = PAGE_SIZE * 4;
+    fbl::RefPtr<VmObject> vmo;
+    zx_status_t status = VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, 0u, alloc_size, &vmo);
+    ASSERT_EQ(ZX_OK, status, "vmobject creation\n");
+
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<uint8_t[]> buf(new (&ac) uint8_t[alloc_size]);
+    ASSERT_TRUE(ac.check(), "can't allocate buffer\n");
+    memset(buf.get(), 'a', alloc_size);
+    status = vmo->Write(buf.get(), 0, alloc_size);
+    ASSERT_EQ(ZX_OK, status, "writing to parent\n");
+
+    fbl::RefPtr<VmObject> clone1;
+    status = vmo->CloneCOW(false, 0, alloc_size, false, &clone1);
+    ASSERT_EQ(ZX_OK, status, "first clone\n");
+    fbl::RefPtr<VmObject> clone2;
+    status = vmo->CloneCOW(false, 0, PAGE_SIZE * 2, false, &clone2);
+    ASSERT_EQ(ZX_OK, status, "second clone\n");
+
+    uint8_t b = 'b';
+    status = clone1->Write(&b, 0, 1);
+    ASSERT_EQ(ZX_OK, status, "writing to first clone\n");
+    EXPECT_EQ(1u, clone1->AllocatedPages(), "first clone copied one page\n");
+
+    // the clones keep seeing the parent's pages
+    vmo.reset();
+    uint8_t c;
+    status = clone2->Read(&c, 0, 1);
+    ASSERT_EQ(ZX_OK, status, "reading second clone\n");
+    EXPECT_EQ('a', c, "second clone reads the hidden parent\n");
+    EXPECT_EQ(0u, clone2->AllocatedPages(), "second clone has no pages\n");
+
+    // with one clone left it gets all the pages it still reads from the parent
+    clone2.reset();
+    EXPECT_EQ(alloc_size / PAGE_SIZE, clone1->AllocatedPages(), "parent merged into clone\n");
+    status = clone1->Read(buf.get(), 0, alloc_size);
+    ASSERT_EQ(ZX_OK, status, "reading first clone\n");
+    EXPECT_EQ('b', buf[0], "modified page is kept\n");
+    for (size_t i = 1; i < alloc_size; i++) {
+        if (buf[i] != 'a') {
+            UNITTEST_FAIL_TRACEF("clone has the wrong contents at %zu\n", i);
+            break;
+        }
+    }
+
+    END_TEST;
+}
+
+// Commits and decommits scattered pages of a huge, mostly empty VMO, which
+// should only cost as much as the pages that are there.
+static bool vmo_sparse_range_test() {
+    BEGIN_TEST;
+
+    static const uint64_t alloc_size = 64ull * 1024 * 1024 * 1024;
+    static const uint64_t stride = alloc_size / 64;
+    fbl::RefPtr<VmObject> vmo;
+    zx_status_t status = VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, 0u, alloc_size, &vmo);
+    ASSERT_EQ(ZX_OK, status, "vmobject creation\n");
+
+    zx_time_t start = current_time();
+    size_t pages = 0;
+    for (uint64_t o = 0; o < alloc_size; o += stride) {
+        uint64_t committed;
+        status = vmo->CommitRange(o, PAGE_SIZE * 4, &committed);
+        ASSERT_EQ(ZX_OK, status, "committing a run\n");
+        EXPECT_EQ(PAGE_SIZE * 4, committed, "whole run committed\n");
+        pages += 4;
+    }
+    const zx_duration_t commit_time = zx_time_sub_time(current_time(), start);
+    EXPECT_EQ(pages, vmo->AllocatedPages(), "allocated pages\n");
+    EXPECT_EQ(4u, vmo->AllocatedPagesInRange(stride - PAGE_SIZE, PAGE_SIZE * 6),
+              "allocated pages of a range\n");
+
+    start = current_time();
+    uint64_t decommitted;
+    status = vmo->DecommitRange(0, alloc_size, &decommitted);
+    const zx_duration_t decommit_time = zx_time_sub_time(current_time(), start);
+    ASSERT_EQ(ZX_OK, status, "decommitting everything\n");
+    EXPECT_EQ(pages * PAGE_SIZE, decommitted, "only pages that were there count\n");
+    EXPECT_EQ(0u, vmo->AllocatedPages(), "no pages left\n");
+
+    unittest_printf("committed %zu pages in %" PRIi64 " ns, decommitted %#" PRIx64
+                    " bytes in %" PRIi64 " ns\n",
+                    pages, commit_time, alloc_size, decommit_time);
+
+    END_TEST;
+}
+
+// Allocates and frees stacks repeatedly, so that freed stacks get reused,
+// and checks that each one is fully mapped.
+static bool kstack_reuse_test() {
+    BEGIN_TEST;
+
+    static constexpr size_t kStacks = 16;
+    kstack_t stacks[kStacks] = {};
+    for (int round = 0; round < 3; round++) {
+        for (kstack_t& stack : stacks) {
+            ASSERT_EQ(ZX_OK, vm_allocate_kstack(&stack), "allocating a stack\n");
+            ASSERT_NE(0u, stack.base, "");
+            EXPECT_EQ(stack.base + DEFAULT_STACK_SIZE, stack.top, "");
+            memset(reinterpret_cast<void*>(stack.base), round, DEFAULT_STACK_SIZE);
+#if __has_feature(safe_stack)
+            ASSERT_NE(0u, stack.unsafe_base, "");
+            memset(reinterpret_cast<void*>(stack.unsafe_base), round, DEFAULT_STACK_SIZE);
+#endif
+        }
+        for (kstack_t& stack : stacks) {
+            EXPECT_EQ(ZX_OK, vm_free_kstack(&stack), "freeing a stack\n");
+            EXPECT_EQ(0u, stack.base, "");
+            EXPECT_EQ(nullptr, stack.vmar, "");
+        }
+    }
+
+    END_TEST;
+}
+
+static bool vmo_large_page_test() {
+    BEGIN_TEST;
+
+    static const size_t alloc_size = LARGE_PAGE_SIZE * 2;
+    fbl::RefPtr<VmObject> vmo;
+    zx_status_t status = VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, 0u, alloc_size, &vmo);
+    ASSERT_EQ(status, ZX_OK, "vmobject creation\n");
+    ASSERT_TRUE(vmo, "vmobject creation\n");
+
+    Guard<fbl::Mutex> guard{vmo->lock()};
+
+    paddr_t pa;
+    status = vmo->GetLargePageLocked(PAGE_SIZE, VMM_PF_FLAG_WRITE | VMM_PF_FLAG_SW_FAULT, &pa);
+    EXPECT_EQ(ZX_ERR_INVALID_ARGS, status, "unaligned offset\n");
+    status = vmo->GetLargePageLocked(alloc_size, VMM_PF_FLAG_WRITE | VMM_PF_FLAG_SW_FAULT, &pa);
+    EXPECT_EQ(ZX_ERR_OUT_OF_RANGE, status, "offset past the end\n");
+
+    // read faults never commit a whole run
+    status = vmo->GetLargePageLocked(0, VMM_PF_FLAG_SW_FAULT, &pa);
+    EXPECT_EQ(ZX_ERR_NOT_FOUND, status, "read fault on uncommitted range\n");
+
+    // a partially committed range cannot be backed by a large page
+    status = vmo->GetPageLocked(LARGE_PAGE_SIZE, VMM_PF_FLAG_WRITE | VMM_PF_FLAG_SW_FAULT,
+                                nullptr, nullptr, nullptr, &pa);
+    EXPECT_EQ(ZX_OK, status, "committing single page\n");
+    status = vmo->GetLargePageLocked(LARGE_PAGE_SIZE, VMM_PF_FLAG_WRITE | VMM_PF_FLAG_SW_FAULT,
+                                     &pa);
+    EXPECT_EQ(ZX_ERR_NOT_FOUND, status, "partially committed range\n");
+
+    // the pmm may legitimately be too fragmented to hand out an aligned run
+    status = vmo->GetLargePageLocked(0, VMM_PF_FLAG_WRITE | VMM_PF_FLAG_SW_FAULT, &pa);
+    if (status == ZX_ERR_NO_MEMORY) {
+        unittest_printf("no aligned contiguous run available, skipping\n");
+        END_TEST;
+    }
+    EXPECT_EQ(ZX_OK, status, "faulting in large page\n");
+    EXPECT_TRUE(IS_LARGE_PAGE_ALIGNED(pa), "large page alignment\n");
+
+    for (size_t i = 0; i < LARGE_PAGE_COUNT; i++) {
+        paddr_t page_pa;
+        status = vmo->GetPageLocked(i * PAGE_SIZE, 0, nullptr, nullptr, nullptr, &page_pa);
+        EXPECT_EQ(ZX_OK, status, "page committed\n");
+        EXPECT_EQ(pa + i * PAGE_SIZE, page_pa, "page contiguous\n");
+    }
+
+    // a second lookup finds the same run without allocating
+    paddr_t pa2;
+    status = vmo->GetLargePageLocked(0, 0, &pa2);
+    EXPECT_EQ(ZX_OK, status, "looking up committed large page\n");
+    EXPECT_EQ(pa, pa2, "same large page\n");
+
+    END_TEST;
+}
+
+// Protects and unmaps a range spanning several adjacent mappings in one call,
+// which batches the TLB invalidations for all of them, and checks the page
+// tables reflect the operation for every mapping.
+static bool vmar_multiple_mapping_unmap_protect_test() {
+    BEGIN_TEST;
+
+    static const size_t kNumMappings = 4;
+    static const size_t kMappingSize = PAGE_SIZE * 4;
+    static const size_t kVmarSize = kNumMappings * kMappingSize;
+
+    fbl::RefPtr<VmAspace> aspace = VmAspace::Create(0, "test aspace");
+    ASSERT_NE(nullptr, aspace, "VmAspace::Create pointer");
+
+    fbl::RefPtr<VmObject> vmo;
+    zx_status_t status = VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, 0u, kVmarSize, &vmo);
+    ASSERT_EQ(ZX_OK, status, "vmobject creation\n");
+    uint64_t committed;
+    status = vmo->CommitRange(0, kVmarSize, &committed);
+    ASSERT_EQ(ZX_OK, status, "committing vm object\n");
+
+    fbl::RefPtr<VmAddressRegion> vmar;
+    status = aspace->RootVmar()->CreateSubVmar(
+        0, kVmarSize, 0, VMAR_FLAG_CAN_MAP_SPECIFIC | VMAR_CAN_RWX_FLAGS, "test vmar", &vmar);
+    ASSERT_EQ(ZX_OK, status, "creating vmar\n");
+
+    for (size_t i = 0; i < kNumMappings; i++) {
+        fbl::RefPtr<VmMapping> mapping;
+        status = vmar->CreateVmMapping(i * kMappingSize, kMappingSize, 0, VMAR_FLAG_SPECIFIC,
+                                       vmo, i * kMappingSize, kArchRwFlags, "test mapping",
+                                       &mapping);
+        ASSERT_EQ(ZX_OK, status, "creating mapping\n");
+        status = mapping->MapRange(0, kMappingSize, false);
+        EXPECT_EQ(ZX_OK, status, "mapping range\n");
+    }
+
+    const vaddr_t base = vmar->base();
+    status = vmar->Protect(base, kVmarSize, ARCH_MMU_FLAG_PERM_READ);
+    EXPECT_EQ(ZX_OK, status, "protecting all mappings\n");
+    for (size_t o = 0; o < kVmarSize; o += PAGE_SIZE) {
+        paddr_t pa;
+        uint flags;
+        status = aspace->arch_aspace().Query(base + o, &pa, &flags);
+        EXPECT_EQ(ZX_OK, status, "page still mapped\n");
+        EXPECT_EQ(ARCH_MMU_FLAG_PERM_READ, flags & ARCH_MMU_FLAG_PERM_RWX_MASK,
+                  "page read only\n");
+    }
+
+    status = vmar->Unmap(base, kVmarSize);
+    EXPECT_EQ(ZX_OK, status, "unmapping all mappings\n");
+    for (size_t o = 0; o < kVmarSize; o += PAGE_SIZE) {
+        paddr_t pa;
+        uint flags;
+        status = aspace->arch_aspace().Query(base + o, &pa, &flags);
+        EXPECT_NE(ZX_OK, status, "page unmapped\n");
+    }
+
+    status = aspace->Destroy();
+    EXPECT_EQ(ZX_OK, status, "VmAspace::Destroy");
+    END_TEST;
+}
+
 // TODO(ZX-1431): The ARM code's error codes are always ZX_ERR_INTERNAL, so
 // special case that.
 #if ARCH_ARM64
@@ -1049,6 +1611,8 @@ VM_UNITTEST(pmm_smoke_test)
 //VM_UNITTEST(pmm_large_alloc_test)
 //VM_UNITTEST(pmm_oversized_alloc_test)
 VM_UNITTEST(pmm_alloc_contiguous_one_test)
+VM_UNITTEST(pmm_page_cache_test)
+VM_UNITTEST(pmm_zeroed_alloc_test)
 VM_UNITTEST(vmm_alloc_smoke_test)
 VM_UNITTEST(vmm_alloc_contiguous_smoke_test)
 VM_UNITTEST(multiple_regions_test)
@@ -1062,6 +1626,8 @@ VM_UNITTEST(vmo_create_test)
 VM_UNITTEST(vmo_pin_test)
 VM_UNITTEST(vmo_multiple_pin_test)
 VM_UNITTEST(vmo_commit_test)
+VM_UNITTEST(vmo_commit_large_test)
+VM_UNITTEST(vmo_reclaim_test)
 VM_UNITTEST(vmo_odd_size_commit_test)
 VM_UNITTEST(vmo_create_physical_test)
 VM_UNITTEST(vmo_create_contiguous_test)
@@ -1074,7 +1640,15 @@ VM_UNITTEST(vmo_double_remap_test)
 VM_UNITTEST(vmo_read_write_smoke_test)
 VM_UNITTEST(vmo_cache_test)
 VM_UNITTEST(vmo_lookup_test)
+VM_UNITTEST(vmo_large_page_test)
+VM_UNITTEST(vmo_page_source_test)
+VM_UNITTEST(page_source_readahead_test)
+VM_UNITTEST(vmo_replace_pages_test)
+VM_UNITTEST(vmo_hidden_parent_test)
+VM_UNITTEST(vmo_sparse_range_test)
+VM_UNITTEST(vmar_multiple_mapping_unmap_protect_test)
 VM_UNITTEST(arch_noncontiguous_map)
+VM_UNITTEST(kstack_reuse_test)
 // Uncomment for debugging
 // VM_UNITTEST(dump_all_aspaces)  // Run last
 UNITTEST_END_TESTCASE(vm_tests, "vmtests", "Virtual memory tests");
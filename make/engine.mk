@@ -27,6 +27,7 @@ ENABLE_INSTALL_SAMPLES ?= false
 ENABLE_NEW_BOOTDATA := true
 ENABLE_LOCK_DEP ?= false
 ENABLE_LOCK_DEP_TESTS ?= $(ENABLE_LOCK_DEP)
+ENABLE_LOCK_DEP_PROFILING ?= false
 DISABLE_UTEST ?= false
 ENABLE_ULIB_ONLY ?= false
 USE_ASAN ?= false
@@ -419,6 +420,12 @@ endif
 ifeq ($(call TOBOOL,$(ENABLE_LOCK_DEP)),true)
 KERNEL_DEFINES += WITH_LOCK_DEP=1
 KERNEL_DEFINES += LOCK_DEP_ENABLE_VALIDATION=1
+
+# Kernel lock contention profiling. Builds on lock dependency tracking, so it
+# has no effect unless that is enabled too.
+ifeq ($(call TOBOOL,$(ENABLE_LOCK_DEP_PROFILING)),true)
+KERNEL_DEFINES += LOCK_DEP_ENABLE_PROFILING=1
+endif
 endif
 
 # Kernel lock dependency tracking tests. By default this is enabled when
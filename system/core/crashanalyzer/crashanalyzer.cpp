@@ -405,7 +405,7 @@ static void handle_ready(async_dispatcher_t* dispatcher,
         goto done;
 
     if (signal->observed & ZX_CHANNEL_READABLE) {
-        fidl::MessageBuffer buffer;
+        fidl::MessageBuffer buffer(fidl::MessageBufferPool::Default());
         for (uint64_t i = 0; i < signal->count; i++) {
             status = handle_message(wait->object(), &buffer);
             if (status == ZX_ERR_SHOULD_WAIT)
@@ -7,9 +7,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <threads.h>
 
 #include <fbl/algorithm.h>
+#include <fbl/alloc_checker.h>
+#include <fbl/auto_lock.h>
+#include <fbl/mutex.h>
 #include <fbl/unique_fd.h>
+#include <fbl/unique_ptr.h>
 #include <fs-management/mount.h>
 #include <gpt/gpt.h>
 #include <lib/fdio/util.h>
@@ -20,16 +25,24 @@
 #include <loader-service/loader-service.h>
 #include <zircon/device/block.h>
 #include <zircon/device/device.h>
+#include <zircon/device/ktrace.h>
 #include <zircon/processargs.h>
 #include <zircon/status.h>
 #include <zircon/syscalls.h>
 
+#include "boot-trace.h"
 #include "devmgr.h"
 #include "fshost.h"
 
 namespace devmgr {
 namespace {
 
+// Each block device is dealt with on a thread of its own, so that a slow
+// fsck, mount or driver bind (such as zxcrypt unsealing) on one device does
+// not hold up the devices which appear after it. Devices which depend on
+// one another need no further ordering: the partitions of an FVM or GPT,
+// and the inner device of a zxcrypt volume, only appear once the driver
+// bound to their parent has published them.
 class BlockWatcher {
 public:
     BlockWatcher(fbl::unique_ptr<FsManager> fshost, zx::unowned_job job, bool netboot)
@@ -43,6 +56,16 @@ public:
         return fshost_->IsSystemMounted();
     }
 
+    // Returns a handle for recording boot timeline spans, or
+    // ZX_HANDLE_INVALID if the ktrace device has not appeared yet.
+    zx_handle_t KtraceHandle();
+
+    // Returns the index to use for the next FAT volume mounted.
+    int NextFatVolume() {
+        fbl::AutoLock lock(&lock_);
+        return fat_counter_++;
+    }
+
     zx_status_t InstallFs(const char* path, zx::channel h) {
         return fshost_->InstallFs(path, fbl::move(h));
     }
@@ -59,26 +82,41 @@ public:
     // if "zircon.system.filesystem-check" is set.
     zx_status_t CheckFilesystem(const char* device_path, disk_format_t df) const;
 
+    // Attempts to mount a block device backed by |fd| to "/system".
+    // Fails if already mounted, or being mounted by another device.
+    zx_status_t MountSystem(fbl::unique_fd fd, mount_options_t* options);
+
     // Attempts to mount a block device backed by |fd| to "/data".
-    // Fails if already mounted.
+    // Fails if already mounted, or being mounted by another device.
     zx_status_t MountData(fbl::unique_fd fd, mount_options_t* options);
 
     // Attempts to mount a block device backed by |fd| to "/install".
-    // Fails if already mounted.
+    // Fails if already mounted, or being mounted by another device.
     zx_status_t MountInstall(fbl::unique_fd fd, mount_options_t* options);
 
     // Attempts to mount a block device backed by |fd| to "/blob".
-    // Fails if already mounted.
+    // Fails if already mounted, or being mounted by another device.
     zx_status_t MountBlob(fbl::unique_fd fd, mount_options_t* options);
 
 
 private:
+    // Mounts |fd| at |path| unless |*mounted| is already set. |*mounted| is
+    // set while the mount is in progress, so that only one device at a time
+    // can try a mount point, and cleared again if the mount fails.
+    zx_status_t MountOnce(bool* mounted, fbl::unique_fd fd, const char* path,
+                          disk_format_t df, mount_options_t* options, LaunchCallback cb);
+
     fbl::unique_ptr<FsManager> fshost_;
     zx::unowned_job job_;
     bool netboot_ = false;
-    bool data_mounted_ = false;
-    bool install_mounted_ = false;
-    bool blob_mounted_ = false;
+
+    fbl::Mutex lock_;
+    bool system_mounted_ __TA_GUARDED(lock_) = false;
+    bool data_mounted_ __TA_GUARDED(lock_) = false;
+    bool install_mounted_ __TA_GUARDED(lock_) = false;
+    bool blob_mounted_ __TA_GUARDED(lock_) = false;
+    int fat_counter_ __TA_GUARDED(lock_) = 0;
+    zx_handle_t ktrace_ __TA_GUARDED(lock_) = ZX_HANDLE_INVALID;
 };
 
 // TODO(smklein): When launching filesystems can pass a cookie representing a unique
@@ -336,49 +374,60 @@ zx_status_t launch_fat(int argc, const char** argv, zx_handle_t* hnd,
                          hnd, ids, len, nullptr, FS_FOR_FSPROC);
 }
 
-zx_status_t BlockWatcher::MountData(fbl::unique_fd fd, mount_options_t* options) {
-    if (data_mounted_) {
-        return ZX_ERR_ALREADY_BOUND;
+zx_handle_t BlockWatcher::KtraceHandle() {
+    fbl::AutoLock lock(&lock_);
+    if (ktrace_ == ZX_HANDLE_INVALID) {
+        fbl::unique_fd fd(open("/dev/misc/ktrace", O_RDWR));
+        if (fd && ioctl_ktrace_get_handle(fd.get(), &ktrace_) < 0) {
+            ktrace_ = ZX_HANDLE_INVALID;
+        }
     }
-    options->wait_until_ready = true;
+    return ktrace_;
+}
 
-    zx_status_t status = mount(fd.release(), "/fs" PATH_DATA, DISK_FORMAT_MINFS,
-                               options, launch_minfs);
+zx_status_t BlockWatcher::MountOnce(bool* mounted, fbl::unique_fd fd, const char* path,
+                                     disk_format_t df, mount_options_t* options,
+                                     LaunchCallback cb) {
+    {
+        fbl::AutoLock lock(&lock_);
+        if (*mounted) {
+            return ZX_ERR_ALREADY_BOUND;
+        }
+        *mounted = true;
+    }
+
+    char mountpath[PATH_MAX];
+    snprintf(mountpath, sizeof(mountpath), "/fs%s", path);
+    zx_status_t status = mount(fd.release(), mountpath, df, options, cb);
     if (status != ZX_OK) {
-        printf("devmgr: failed to mount %s: %s.\n", PATH_DATA, zx_status_get_string(status));
-    } else {
-        data_mounted_ = true;
+        printf("devmgr: failed to mount %s: %s.\n", path, zx_status_get_string(status));
+        fbl::AutoLock lock(&lock_);
+        *mounted = false;
     }
     return status;
 }
 
+zx_status_t BlockWatcher::MountSystem(fbl::unique_fd fd, mount_options_t* options) {
+    options->wait_until_ready = true;
+    return MountOnce(&system_mounted_, fbl::move(fd), PATH_SYSTEM, DISK_FORMAT_MINFS,
+                     options, launch_minfs);
+}
+
+zx_status_t BlockWatcher::MountData(fbl::unique_fd fd, mount_options_t* options) {
+    options->wait_until_ready = true;
+    return MountOnce(&data_mounted_, fbl::move(fd), PATH_DATA, DISK_FORMAT_MINFS,
+                     options, launch_minfs);
+}
+
 zx_status_t BlockWatcher::MountInstall(fbl::unique_fd fd, mount_options_t* options) {
-    if (install_mounted_) {
-        return ZX_ERR_ALREADY_BOUND;
-    }
     options->readonly = true;
-    zx_status_t status = mount(fd.release(), "/fs" PATH_INSTALL, DISK_FORMAT_MINFS,
-                               options, launch_minfs);
-    if (status != ZX_OK) {
-        printf("devmgr: failed to mount %s: %s.\n", PATH_INSTALL, zx_status_get_string(status));
-    } else {
-        install_mounted_ = true;
-    }
-    return status;
+    return MountOnce(&install_mounted_, fbl::move(fd), PATH_INSTALL, DISK_FORMAT_MINFS,
+                     options, launch_minfs);
 }
 
 zx_status_t BlockWatcher::MountBlob(fbl::unique_fd fd, mount_options_t* options) {
-    if (blob_mounted_) {
-        return ZX_ERR_ALREADY_BOUND;
-    }
-    zx_status_t status = mount(fd.release(), "/fs" PATH_BLOB, DISK_FORMAT_BLOBFS,
-                               options, launch_blobfs);
-    if (status != ZX_OK) {
-        printf("devmgr: failed to mount %s: %s.\n", PATH_BLOB, zx_status_get_string(status));
-    } else {
-        blob_mounted_ = true;
-    }
-    return status;
+    return MountOnce(&blob_mounted_, fbl::move(fd), PATH_BLOB, DISK_FORMAT_BLOBFS,
+                     options, launch_blobfs);
 }
 
 zx_status_t BlockWatcher::CheckFilesystem(const char* device_path, disk_format_t df) const {
@@ -479,16 +528,11 @@ zx_status_t mount_minfs(BlockWatcher* watcher, fbl::unique_fd fd, mount_options_
 
         // TODO(ZX-1008): replace getenv with cmdline_bool("zircon.system.writable", false);
         options->readonly = getenv("zircon.system.writable") == nullptr;
-        options->wait_until_ready = true;
 
-        zx_status_t st = mount(fd.release(), "/fs" PATH_SYSTEM, DISK_FORMAT_MINFS,
-                               options, launch_minfs);
-        if (st != ZX_OK) {
-            printf("devmgr: failed to mount %s: %s.\n", PATH_SYSTEM, zx_status_get_string(st));
-        } else {
+        zx_status_t st = watcher->MountSystem(fbl::move(fd), options);
+        if (st == ZX_OK) {
             watcher->FuchsiaStart();
         }
-
         return st;
     } else if (gpt_is_data_guid(type_guid, read_sz)) {
         return watcher->MountData(fbl::move(fd), options);
@@ -506,47 +550,82 @@ zx_status_t mount_minfs(BlockWatcher* watcher, fbl::unique_fd fd, mount_options_
 #define ZXCRYPT_DRIVER_LIB "/boot/driver/zxcrypt.so"
 #define STRLEN(s) sizeof(s) / sizeof((s)[0])
 
-zx_status_t block_device_added(int dirfd, int event, const char* name, void* cookie) {
-    auto watcher = static_cast<BlockWatcher*>(cookie);
+// A block device waiting to be probed and mounted.
+struct BlockDevice {
+    BlockWatcher* watcher;
+    fbl::unique_fd fd;
+    char name[NAME_MAX + 1];
+    // When the device appeared in PATH_DEV_BLOCK.
+    zx::time added;
+};
 
-    if (event != WATCH_EVENT_ADD_FILE) {
-        return ZX_OK;
-    }
+// Logs how long it took to mount |df| from |device_path|, from the device
+// appearing, through probing it and checking the filesystem (if enabled),
+// to the filesystem being ready.
+void report_mount_timeline(const char* device_path, disk_format_t df, const BlockDevice& device,
+                           zx::time probed, zx::duration fsck, zx_status_t status,
+                           BootSpan* span) {
+    span->set_result(status);
+    zx::time done = zx::clock::get_monotonic();
+    printf("fshost: %s: %s %s after %" PRId64 "ms (probe %" PRId64 "ms, fsck %" PRId64
+           "ms, mount %" PRId64 "ms)\n",
+           device_path, disk_format_string_[df], status == ZX_OK ? "mounted" : "not mounted",
+           (done - device.added).to_msecs(), (probed - device.added).to_msecs(),
+           fsck.to_msecs(), (done - probed - fsck).to_msecs());
+}
+
+zx_status_t check_filesystem(BlockWatcher* watcher, const BlockDevice& device,
+                             const char* device_path, disk_format_t df, zx::duration* elapsed) {
+    char step[ZX_MAX_NAME_LEN];
+    snprintf(step, sizeof(step), "fsck-%s", device.name);
+    BootSpan span(watcher->KtraceHandle(), "fshost", step);
+
+    zx::time start = zx::clock::get_monotonic();
+    zx_status_t status = watcher->CheckFilesystem(device_path, df);
+    *elapsed = zx::clock::get_monotonic() - start;
+    span.set_result(status);
+    return status;
+}
+
+void block_device_probe(BlockDevice* device) {
+    BlockWatcher* watcher = device->watcher;
+    fbl::unique_fd fd = fbl::move(device->fd);
 
     char device_path[PATH_MAX];
-    sprintf(device_path, "%s/%s", PATH_DEV_BLOCK, name);
+    snprintf(device_path, sizeof(device_path), "%s/%s", PATH_DEV_BLOCK, device->name);
 
-    fbl::unique_fd fd(openat(dirfd, name, O_RDWR));
-    if (!fd) {
-        return ZX_OK;
-    }
+    char step[ZX_MAX_NAME_LEN];
+    snprintf(step, sizeof(step), "block-%s", device->name);
+    BootSpan span(watcher->KtraceHandle(), "fshost", step);
 
     block_info_t info;
     if (ioctl_block_get_info(fd.get(), &info) >= 0 && info.flags & BLOCK_FLAG_BOOTPART) {
         ioctl_device_bind(fd.get(), BOOTPART_DRIVER_LIB, STRLEN(BOOTPART_DRIVER_LIB));
-        return ZX_OK;
+        return;
     }
 
     disk_format_t df = detect_disk_format(fd.get());
+    zx::time probed = zx::clock::get_monotonic();
+    zx::duration fsck;
 
     switch (df) {
     case DISK_FORMAT_GPT: {
         printf("devmgr: %s: GPT?\n", device_path);
         // probe for partition table
         ioctl_device_bind(fd.get(), GPT_DRIVER_LIB, STRLEN(GPT_DRIVER_LIB));
-        return ZX_OK;
+        return;
     }
     case DISK_FORMAT_FVM: {
-        printf("devmgr: /dev/class/block/%s: FVM?\n", name);
+        printf("devmgr: %s: FVM?\n", device_path);
         // probe for partition table
         ioctl_device_bind(fd.get(), FVM_DRIVER_LIB, STRLEN(FVM_DRIVER_LIB));
-        return ZX_OK;
+        return;
     }
     case DISK_FORMAT_MBR: {
         printf("devmgr: %s: MBR?\n", device_path);
         // probe for partition table
         ioctl_device_bind(fd.get(), MBR_DRIVER_LIB, STRLEN(MBR_DRIVER_LIB));
-        return ZX_OK;
+        return;
     }
     case DISK_FORMAT_ZXCRYPT: {
         if (!watcher->Netbooting()) {
@@ -555,7 +634,7 @@ zx_status_t block_device_added(int dirfd, int event, const char* name, void* coo
             // Where does the key come from?  We need to determine if this is unattended.
             ioctl_device_bind(fd.get(), ZXCRYPT_DRIVER_LIB, STRLEN(ZXCRYPT_DRIVER_LIB));
         }
-        return ZX_OK;
+        return;
     }
     default:
         break;
@@ -571,11 +650,12 @@ zx_status_t block_device_added(int dirfd, int event, const char* name, void* coo
         if (memcmp(guid, expected_guid, sizeof(guid)) == 0) {
             printf("devmgr: mounting install partition\n");
             mount_options_t options = default_mount_options;
-            mount_minfs(watcher, fbl::move(fd), &options);
-            return ZX_OK;
+            zx_status_t status = mount_minfs(watcher, fbl::move(fd), &options);
+            report_mount_timeline(device_path, df, *device, probed, fsck, status, &span);
+            return;
         }
 
-        return ZX_OK;
+        return;
     }
 
     switch (df) {
@@ -583,31 +663,33 @@ zx_status_t block_device_added(int dirfd, int event, const char* name, void* coo
         const uint8_t expected_guid[GPT_GUID_LEN] = GUID_BLOB_VALUE;
 
         if (memcmp(guid, expected_guid, sizeof(guid))) {
-            return ZX_OK;
+            return;
         }
-        if (watcher->CheckFilesystem(device_path, DISK_FORMAT_BLOBFS) != ZX_OK) {
-            return ZX_OK;
+        if (check_filesystem(watcher, *device, device_path, DISK_FORMAT_BLOBFS, &fsck) != ZX_OK) {
+            return;
         }
 
         mount_options_t options = default_mount_options;
         options.enable_journal = true;
         zx_status_t status = watcher->MountBlob(fbl::move(fd), &options);
+        report_mount_timeline(device_path, df, *device, probed, fsck, status, &span);
         if (status != ZX_OK) {
             printf("devmgr: Failed to mount blobfs partition %s at %s: %s.\n",
                    device_path, PATH_BLOB, zx_status_get_string(status));
         } else {
             launch_blob_init(watcher);
         }
-        return ZX_OK;
+        return;
     }
     case DISK_FORMAT_MINFS: {
         printf("devmgr: mounting minfs\n");
-        if (watcher->CheckFilesystem(device_path, DISK_FORMAT_MINFS) != ZX_OK) {
-            return ZX_OK;
+        if (check_filesystem(watcher, *device, device_path, DISK_FORMAT_MINFS, &fsck) != ZX_OK) {
+            return;
         }
         mount_options_t options = default_mount_options;
-        mount_minfs(watcher, fbl::move(fd), &options);
-        return ZX_OK;
+        zx_status_t status = mount_minfs(watcher, fbl::move(fd), &options);
+        report_mount_timeline(device_path, df, *device, probed, fsck, status, &span);
+        return;
     }
     case DISK_FORMAT_FAT: {
         // Use the GUID to avoid auto-mounting the EFI partition
@@ -616,21 +698,62 @@ zx_status_t block_device_added(int dirfd, int event, const char* name, void* coo
         bool efi = gpt_is_efi_guid(guid, r);
         if (efi) {
             printf("devmgr: not automounting efi\n");
-            return ZX_OK;
+            return;
         }
         mount_options_t options = default_mount_options;
         options.create_mountpoint = true;
-        static int fat_counter = 0;
         char mountpath[FDIO_MAX_FILENAME + 64];
-        snprintf(mountpath, sizeof(mountpath), "%s/fat-%d", "/fs" PATH_VOLUME, fat_counter++);
+        snprintf(mountpath, sizeof(mountpath), "%s/fat-%d", "/fs" PATH_VOLUME,
+                 watcher->NextFatVolume());
         options.wait_until_ready = false;
         printf("devmgr: mounting fatfs\n");
-        mount(fd.release(), mountpath, df, &options, launch_fat);
-        return ZX_OK;
+        zx_status_t status = mount(fd.release(), mountpath, df, &options, launch_fat);
+        report_mount_timeline(device_path, df, *device, probed, fsck, status, &span);
+        return;
     }
     default:
+        return;
+    }
+}
+
+int block_device_thread(void* arg) {
+    fbl::unique_ptr<BlockDevice> device(static_cast<BlockDevice*>(arg));
+    block_device_probe(device.get());
+    return 0;
+}
+
+zx_status_t block_device_added(int dirfd, int event, const char* name, void* cookie) {
+    auto watcher = static_cast<BlockWatcher*>(cookie);
+
+    if (event != WATCH_EVENT_ADD_FILE) {
+        return ZX_OK;
+    }
+
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<BlockDevice> device(new (&ac) BlockDevice);
+    if (!ac.check()) {
+        return ZX_OK;
+    }
+    device->watcher = watcher;
+    device->added = zx::clock::get_monotonic();
+    device->fd.reset(openat(dirfd, name, O_RDWR));
+    if (!device->fd) {
+        return ZX_OK;
+    }
+    strlcpy(device->name, name, sizeof(device->name));
+
+    char thread_name[ZX_MAX_NAME_LEN];
+    snprintf(thread_name, sizeof(thread_name), "block-%s", name);
+    thrd_t t;
+    if (thrd_create_with_name(&t, block_device_thread, device.get(), thread_name) !=
+        thrd_success) {
+        printf("fshost: cannot start thread for %s, probing it in place\n", name);
+        block_device_probe(device.get());
         return ZX_OK;
     }
+    device.release();
+    thrd_detach(t);
+    return ZX_OK;
 }
 
 } // namespace
@@ -0,0 +1,60 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <stdio.h>
+
+#include <fbl/macros.h>
+#include <lib/zircon-internal/ktrace.h>
+#include <zircon/syscalls.h>
+#include <zircon/types.h>
+
+namespace devmgr {
+
+// Records a step of booting on the ktrace boot timeline, from construction to
+// destruction, as the probe "boot:|component|:|step|". |ktrace| must be the
+// root resource or a handle from ioctl_ktrace_get_handle(); if it is invalid
+// nothing is recorded. Long names are truncated to fit a probe name.
+//
+// The host tool boot-timeline pairs the start and end of each span by probe
+// and thread, so a span must end on the thread it started on.
+class BootSpan {
+public:
+    BootSpan(zx_handle_t ktrace, const char* component, const char* step, uint32_t arg = 0)
+        : ktrace_(ktrace) {
+        if (ktrace_ == ZX_HANDLE_INVALID) {
+            return;
+        }
+        // The kernel reads a whole ZX_MAX_NAME_LEN buffer.
+        char name[ZX_MAX_NAME_LEN] = {};
+        snprintf(name, sizeof(name), KTRACE_BOOT_PREFIX "%s:%s", component, step);
+        zx_status_t id = zx_ktrace_control(ktrace_, KTRACE_ACTION_NEW_PROBE, 0, name);
+        if (id > 0) {
+            id_ = id;
+            zx_ktrace_write(ktrace_, id_, KTRACE_BOOT_BEGIN, arg);
+        }
+    }
+
+    ~BootSpan() {
+        if (id_ != 0) {
+            zx_ktrace_write(ktrace_, id_, KTRACE_BOOT_END, result_);
+        }
+    }
+
+    // Sets the argument recorded with the end of the span, such as a status
+    // or a koid.
+    void set_result(uint32_t result) {
+        result_ = result;
+    }
+
+    DISALLOW_COPY_ASSIGN_AND_MOVE(BootSpan);
+
+private:
+    zx_handle_t ktrace_;
+    uint32_t id_ = 0;
+    uint32_t result_ = 0;
+};
+
+} // namespace devmgr
@@ -7,6 +7,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <bootdata/decompress.h>
 #include <zircon/boot/bootdata.h>
 #include <zircon/process.h>
 #include <zircon/syscalls.h>
@@ -75,17 +76,29 @@ static zx_status_t CloneVmo(const char* name, size_t name_len, const bootfs_entr
                             const zx::vmo& original_vmo, zx::vmo* vmo_out, uint32_t* size_out) {
     zx::vmo vmo;
     zx_status_t r;
+    uint64_t size = e.data_len;
+
+    if (e.data_off & BOOTFS_ENTRY_COMPRESSED) {
+        const char* errmsg;
+        if ((r = decompress_bootfs_file(zx_vmar_root_self(), original_vmo.get(),
+                                        BOOTFS_ENTRY_DATA_OFF(&e), e.data_len, name,
+                                        vmo.reset_and_get_address(), &size,
+                                        &errmsg)) != ZX_OK) {
+            printf("bootfs_open: cannot decompress '%s': %s\n", name, errmsg);
+            return r;
+        }
+    } else {
+        // Clone a private copy of the file's subset of the bootfs VMO.
+        // TODO(mcgrathr): Create a plain read-only clone when the feature
+        // is implemented in the VM.
+        if ((r = original_vmo.clone(ZX_VMO_CLONE_COPY_ON_WRITE,
+                                    e.data_off, e.data_len, &vmo)) != ZX_OK) {
+            return r;
+        }
 
-    // Clone a private copy of the file's subset of the bootfs VMO.
-    // TODO(mcgrathr): Create a plain read-only clone when the feature
-    // is implemented in the VM.
-    if ((r = original_vmo.clone(ZX_VMO_CLONE_COPY_ON_WRITE,
-                                e.data_off, e.data_len, &vmo)) != ZX_OK) {
-        return r;
+        vmo.set_property(ZX_PROP_NAME, name, name_len - 1);
     }
 
-    vmo.set_property(ZX_PROP_NAME, name, name_len - 1);
-
     // Drop unnecessary ZX_RIGHT_WRITE rights.
     // TODO(mcgrathr): Should be superfluous with read-only zx_vmo_clone.
     if ((r = vmo.replace(ZX_RIGHTS_BASIC | ZX_RIGHT_READ |
@@ -101,7 +114,7 @@ static zx_status_t CloneVmo(const char* name, size_t name_len, const bootfs_entr
 
     *vmo_out = fbl::move(vmo);
     if (size_out) {
-        *size_out = e.data_len;
+        *size_out = static_cast<uint32_t>(size);
     }
     return ZX_OK;
 }
@@ -60,6 +60,9 @@ struct Pending {
         kBind = 1,
         kSuspend = 2,
     } op;
+
+    // when the request was sent, for reporting how long it took
+    zx_time_t started;
 };
 
 struct Metadata {
@@ -292,6 +295,17 @@ struct Driver {
     // TODO: Change it to number of entries
     uint32_t binding_size = 0;
     uint32_t flags = 0;
+
+    // Property values a device must have for the binding to match, taken
+    // from the abort-if-not-equal instructions it starts with, so that most
+    // drivers can be ruled out without running their binding.
+    struct BindRequirement {
+        uint32_t id;
+        uint32_t value;
+    };
+    static constexpr size_t kMaxBindRequirements = 4;
+    BindRequirement bind_requirements[kMaxBindRequirements] = {};
+    uint32_t bind_requirement_count = 0;
     zx::vmo dso_vmo;
 
     fbl::DoublyLinkedListNodeState<Driver*> node;
@@ -320,6 +334,8 @@ void load_driver(const char* path,
 void find_loadable_drivers(const char* path,
                            void (*func)(Driver* drv, const char* version));
 
+// Fills in the bind requirements of |drv| from its binding.
+void dc_compile_binding(Driver* drv);
 bool dc_is_bindable(const Driver* drv, uint32_t protocol_id,
                     zx_device_prop_t* props, size_t prop_count,
                     bool autobind);
@@ -551,6 +551,30 @@ static zx_status_t fidl_file_getvmo(void* ctx, uint32_t flags, fidl_txn_t* txn)
     return fuchsia_io_FileGetVmo_reply(txn, ZX_ERR_NOT_SUPPORTED, ZX_HANDLE_INVALID);
 }
 
+static zx_status_t fidl_file_readvmo(void* ctx, uint64_t count, zx_handle_t vmo,
+                                     uint64_t vmo_offset, fidl_txn_t* txn) {
+    zx_handle_close(vmo);
+    return fuchsia_io_FileReadVmo_reply(txn, ZX_ERR_NOT_SUPPORTED, 0);
+}
+
+static zx_status_t fidl_file_readvmoat(void* ctx, uint64_t count, uint64_t offset,
+                                       zx_handle_t vmo, uint64_t vmo_offset, fidl_txn_t* txn) {
+    zx_handle_close(vmo);
+    return fuchsia_io_FileReadVmoAt_reply(txn, ZX_ERR_NOT_SUPPORTED, 0);
+}
+
+static zx_status_t fidl_file_writevmo(void* ctx, uint64_t count, zx_handle_t vmo,
+                                      uint64_t vmo_offset, fidl_txn_t* txn) {
+    zx_handle_close(vmo);
+    return fuchsia_io_FileWriteVmo_reply(txn, ZX_ERR_NOT_SUPPORTED, 0);
+}
+
+static zx_status_t fidl_file_writevmoat(void* ctx, uint64_t count, uint64_t offset,
+                                        zx_handle_t vmo, uint64_t vmo_offset, fidl_txn_t* txn) {
+    zx_handle_close(vmo);
+    return fuchsia_io_FileWriteVmoAt_reply(txn, ZX_ERR_NOT_SUPPORTED, 0);
+}
+
 static const fuchsia_io_File_ops_t kFileOps = []() {
     fuchsia_io_File_ops_t ops;
     ops.Read = fidl_file_read;
@@ -562,6 +586,10 @@ static const fuchsia_io_File_ops_t kFileOps = []() {
     ops.GetFlags = fidl_file_getflags;
     ops.SetFlags = fidl_file_setflags;
     ops.GetVmo = fidl_file_getvmo;
+    ops.ReadVmo = fidl_file_readvmo;
+    ops.ReadVmoAt = fidl_file_readvmoat;
+    ops.WriteVmo = fidl_file_writevmo;
+    ops.WriteVmoAt = fidl_file_writevmoat;
     return ops;
 }();
 
@@ -646,7 +674,7 @@ zx_status_t devhost_fidl_handler(fidl_msg_t* msg, fidl_txn_t* txn, void* cookie)
         hdr->ordinal <= fuchsia_io_NodeIoctlOrdinal) {
         return fuchsia_io_Node_dispatch(cookie, txn, msg, &kNodeOps);
     } else if (hdr->ordinal >= fuchsia_io_FileReadOrdinal &&
-               hdr->ordinal <= fuchsia_io_FileGetVmoOrdinal) {
+               hdr->ordinal <= fuchsia_io_FileWriteVmoAtOrdinal) {
         return fuchsia_io_File_dispatch(cookie, txn, msg, &kFileOps);
     } else if (hdr->ordinal >= fuchsia_io_DirectoryOpenOrdinal &&
                hdr->ordinal <= fuchsia_io_DirectoryWatchOrdinal) {
@@ -22,6 +22,8 @@ zx_status_t dc_msg_pack(Message* msg, uint32_t* len_out,
     size_t max = DC_MAX_DATA;
     uint8_t* ptr = msg->data;
 
+    msg->flags = 0;
+
     if (data) {
         if (datalen > max) {
             return ZX_ERR_BUFFER_TOO_SMALL;
@@ -137,4 +139,10 @@ zx_status_t dc_msg_rpc(zx_handle_t h, Message* msg, size_t msglen,
     return rsp->status;
 }
 
+zx_status_t dc_msg_send(zx_handle_t h, Message* msg, size_t msglen) {
+    msg->txid = 0;
+    msg->flags |= Message::kFlagNoReply;
+    return zx_channel_write(h, 0, msg, static_cast<uint32_t>(msglen), nullptr, 0);
+}
+
 } // namespace devmgr
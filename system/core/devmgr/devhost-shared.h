@@ -21,6 +21,12 @@ struct Message {
 
     uint32_t flags;
 
+    // |flags| bits
+    // The sender isn't waiting for the status of the request, so none is
+    // sent back. Such messages queue up behind each other, and behind the
+    // next request that does wait, to be handled all at once.
+    static constexpr uint32_t kFlagNoReply = 1u << 0;
+
     enum struct Op : uint32_t {
         // This bit differentiates DC OPs from RIO OPs
         kIdBit = 0x10000000,
@@ -80,5 +86,7 @@ zx_status_t dc_msg_rpc(zx_handle_t h, Message* msg, size_t msglen,
                        zx_handle_t* handles, size_t hcount,
                        Status* rsp, size_t rsp_len, size_t* resp_actual,
                        zx_handle_t* outhandle);
+// Send a message without waiting for, or getting, a reply.
+zx_status_t dc_msg_send(zx_handle_t h, Message* msg, size_t msglen);
 
 } // namespace devmgr
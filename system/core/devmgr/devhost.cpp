@@ -14,6 +14,7 @@
 #include <ddk/device.h>
 #include <ddk/driver.h>
 #include <ddk/binding.h>
+#include <ddk/trace/event.h>
 
 #include <zircon/dlfcn.h>
 #include <zircon/process.h>
@@ -30,6 +31,7 @@
 #include <lib/zx/vmo.h>
 #include <zxcpp/new.h>
 
+#include "boot-trace.h"
 #include "devhost.h"
 #include "devhost-main.h"
 #include "devhost-shared.h"
@@ -421,7 +423,19 @@ static zx_status_t dh_handle_rpc_read(zx_handle_t h, DevhostIostate* ios) {
                     .rpc = ZX_HANDLE_INVALID,
                 };
                 devhost_set_creation_context(&ctx);
-                r = drv->BindOp(ios->dev);
+                {
+                    TRACE_DURATION("driver", "bind", "driver", TA_STRING(name));
+                    // Name the span after the driver's file, less its
+                    // directory and ".so", to fit in a probe name.
+                    const char* base = strrchr(name, '/');
+                    base = base ? base + 1 : name;
+                    char step[ZX_MAX_NAME_LEN];
+                    snprintf(step, sizeof(step), "bind-%.*s",
+                             (int)strcspn(base, "."), base);
+                    BootSpan span(::get_root_resource(), "devhost", step);
+                    r = drv->BindOp(ios->dev);
+                    span.set_result(r);
+                }
                 devhost_set_creation_context(nullptr);
 
                 if ((r == ZX_OK) && (ctx.child == nullptr)) {
@@ -723,6 +737,7 @@ static void devhost_io_init() {
 // parent device.  Called under devhost api lock.
 zx_status_t devhost_add(zx_device_t* parent, zx_device_t* child, const char* proxy_args,
                         const zx_device_prop_t* props, uint32_t prop_count) {
+    TRACE_DURATION("driver", "rpc", "op", TA_STRING("add-device"));
     char buffer[512];
     const char* path = mkdevpath(parent, buffer, sizeof(buffer));
     log(RPC_OUT, "devhost[%s] add '%s'\n", path, child->name);
@@ -780,6 +795,7 @@ static zx_status_t devhost_rpc_etc(zx_device_t* dev, Message::Op op,
                                    uint32_t value, const void* data, size_t datalen,
                                    Status* rsp, size_t rsp_len, size_t* actual,
                                    zx_handle_t* outhandle) {
+    TRACE_DURATION("driver", "rpc", "op", TA_STRING(opname));
     char buffer[512];
     const char* path = mkdevpath(dev, buffer, sizeof(buffer));
     log(RPC_OUT, "devhost[%s] %s args='%s'\n", path, opname, args ? args : "");
@@ -807,10 +823,29 @@ static zx_status_t devhost_rpc(zx_device_t* dev, Message::Op op,
     return devhost_rpc_etc(dev, op, args, opname, 0, nullptr, 0, rsp, rsp_len, nullptr, outhandle);
 }
 
+// Send a message the devcoordinator doesn't reply to. It is handled before
+// the next one sent for |dev|, along with it if that one is already queued.
+static void devhost_send(zx_device_t* dev, Message::Op op, const char* opname) {
+    TRACE_DURATION("driver", "send", "op", TA_STRING(opname));
+    char buffer[512];
+    const char* path = mkdevpath(dev, buffer, sizeof(buffer));
+    log(RPC_OUT, "devhost[%s] %s\n", path, opname);
+    Message msg;
+    uint32_t msglen;
+    zx_status_t r;
+    if ((r = dc_msg_pack(&msg, &msglen, nullptr, 0, nullptr, nullptr)) < 0) {
+        return;
+    }
+    msg.op = op;
+    msg.value = 0;
+    if ((r = dc_msg_send(dev->rpc.get(), &msg, msglen)) < 0) {
+        log(ERROR, "devhost: send:%s failed: %d\n", opname, r);
+    }
+}
+
 void devhost_make_visible(zx_device_t* dev) {
-    Status rsp;
-    devhost_rpc(dev, Message::Op::kMakeVisible, nullptr, "make-visible", &rsp,
-                sizeof(rsp), nullptr);
+    // Nothing waits on this, so it needn't cost a round trip.
+    devhost_send(dev, Message::Op::kMakeVisible, "make-visible");
 }
 
 // Send message to devcoordinator informing it that this device
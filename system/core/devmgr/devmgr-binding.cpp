@@ -140,6 +140,41 @@ next_instruction:
     return false;
 }
 
+void dc_compile_binding(Driver* drv) {
+    const zx_bind_inst_t* ip = drv->binding.get();
+    const zx_bind_inst_t* end = ip + (drv->binding_size / sizeof(zx_bind_inst_t));
+
+    // Until the first thing that can match or jump, every instruction is
+    // run in order for every device, so an abort-if-not-equal there is a
+    // value the device must have.  Labels up to that point can only be
+    // reached by falling through, and the flags set and cleared only matter
+    // to BIND_FLAGS conditions, which aren't recorded.
+    drv->bind_requirement_count = 0;
+    for (; ip < end; ip++) {
+        uint32_t inst = ip->op;
+        switch (BINDINST_OP(inst)) {
+        case OP_ABORT:
+            if (BINDINST_CC(inst) == COND_AL) {
+                return;
+            }
+            if ((BINDINST_CC(inst) == COND_NE) && (BINDINST_PB(inst) != BIND_FLAGS) &&
+                (drv->bind_requirement_count < Driver::kMaxBindRequirements)) {
+                Driver::BindRequirement* req =
+                    &drv->bind_requirements[drv->bind_requirement_count++];
+                req->id = BINDINST_PB(inst);
+                req->value = ip->arg;
+            }
+            break;
+        case OP_SET:
+        case OP_CLEAR:
+        case OP_LABEL:
+            break;
+        default:
+            return;
+        }
+    }
+}
+
 bool dc_is_bindable(const Driver* drv, uint32_t protocol_id,
                     zx_device_prop_t* props, size_t prop_count,
                     bool autobind) {
@@ -154,6 +189,13 @@ bool dc_is_bindable(const Driver* drv, uint32_t protocol_id,
     ctx.binding_size = drv->binding_size;
     ctx.name = drv->name.c_str();
     ctx.autobind = autobind ? 1 : 0;
+
+    for (uint32_t i = 0; i < drv->bind_requirement_count; i++) {
+        const Driver::BindRequirement& req = drv->bind_requirements[i];
+        if (dev_get_prop(&ctx, req.id) != req.value) {
+            return false;
+        }
+    }
     return is_bindable(&ctx);
 }
 
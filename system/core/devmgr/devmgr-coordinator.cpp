@@ -5,6 +5,7 @@
 #include <ctype.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <inttypes.h>
 #include <limits.h>
 #include <stdarg.h>
 #include <stdio.h>
@@ -14,6 +15,7 @@
 #include <ddk/driver.h>
 #include <driver-info/driver-info.h>
 #include <launchpad/launchpad.h>
+#include <launchpad/vmo.h>
 #include <fbl/unique_ptr.h>
 #include <zircon/assert.h>
 #include <zircon/processargs.h>
@@ -27,6 +29,7 @@
 #include <lib/zx/job.h>
 #include <lib/zx/socket.h>
 
+#include "boot-trace.h"
 #include "devcoordinator.h"
 #include "devhost.h"
 #include "devhost-shared.h"
@@ -43,6 +46,9 @@ static void dc_driver_added_init(Driver* drv, const char* version);
 #define BOOT_FIRMWARE_DIR "/boot/lib/firmware"
 #define SYSTEM_FIRMWARE_DIR "/system/lib/firmware"
 
+// binds that take at least this long are logged even without LOG_TRACE
+static constexpr zx_duration_t kSlowBindThreshold = ZX_MSEC(500);
+
 extern zx_handle_t virtcon_open;
 
 uint32_t log_flags = LOG_ERROR | LOG_INFO;
@@ -311,8 +317,8 @@ static fbl::DoublyLinkedList<Device*, Device::AllDevicesNode> list_devices;
 // All DevHosts
 static fbl::DoublyLinkedList<Devhost*, Devhost::AllDevhostsNode> list_devhosts;
 
-static const Driver* libname_to_driver(const char* libname) {
-    for (const auto& drv : list_drivers) {
+static Driver* libname_to_driver(const char* libname) {
+    for (auto& drv : list_drivers) {
         if (!strcmp(libname, drv.libname.c_str())) {
             return &drv;
         }
@@ -344,25 +350,29 @@ static zx_status_t load_vmo(const char* libname, zx::vmo* out_vmo) {
 }
 
 static zx_status_t libname_to_vmo(const char* libname, zx::vmo* out_vmo) {
-    const Driver* drv = libname_to_driver(libname);
+    Driver* drv = libname_to_driver(libname);
     if (drv == nullptr) {
         log(ERROR, "devcoord: cannot find driver '%s'\n", libname);
         return ZX_ERR_NOT_FOUND;
     }
 
-    // Check for cached DSO
-    if (drv->dso_vmo != ZX_HANDLE_INVALID) {
-        zx_status_t r = drv->dso_vmo.duplicate(ZX_RIGHTS_BASIC | ZX_RIGHTS_PROPERTY |
-                                               ZX_RIGHT_READ | ZX_RIGHT_EXECUTE | ZX_RIGHT_MAP,
-                                               out_vmo);
+    // Drivers are found by their notes alone; the DSO is only loaded the
+    // first time one of them binds, and cached for its later binds.
+    if (drv->dso_vmo == ZX_HANDLE_INVALID) {
+        zx_status_t r = load_vmo(libname, &drv->dso_vmo);
         if (r != ZX_OK) {
-            log(ERROR, "devcoord: cannot duplicate cached dso for '%s' '%s'\n", drv->name.c_str(),
-                libname);
+            drv->dso_vmo.reset();
+            return r;
         }
-        return r;
-    } else {
-        return load_vmo(libname, out_vmo);
     }
+    zx_status_t r = drv->dso_vmo.duplicate(ZX_RIGHTS_BASIC | ZX_RIGHTS_PROPERTY |
+                                           ZX_RIGHT_READ | ZX_RIGHT_EXECUTE | ZX_RIGHT_MAP,
+                                           out_vmo);
+    if (r != ZX_OK) {
+        log(ERROR, "devcoord: cannot duplicate cached dso for '%s' '%s'\n", drv->name.c_str(),
+            libname);
+    }
+    return r;
 }
 
 void devmgr_set_bootdata(const zx::unowned_vmo vmo) {
@@ -633,13 +643,44 @@ static void dc_watch(zx_handle_t h) {
     }
 }
 
+// The devhost binary as parsed for the last devhost launched, so that
+// launching another one only has to map it.
+static launchpad_template_t* devhost_template;
+static const char* devhost_template_bin;
+
+static void dc_load_devhost(launchpad_t* lp, const char* devhost_bin) {
+    if (devhost_template_bin != devhost_bin) {
+        if (devhost_template != nullptr) {
+            launchpad_template_destroy(devhost_template);
+            devhost_template = nullptr;
+        }
+        devhost_template_bin = devhost_bin;
+
+        zx_handle_t vmo;
+        zx_status_t r;
+        if ((r = launchpad_vmo_from_file(devhost_bin, &vmo)) == ZX_OK) {
+            r = launchpad_template_create(vmo, &devhost_template);
+        }
+        if (r != ZX_OK) {
+            log(ERROR, "devcoord: cannot cache devhost '%s': %d\n", devhost_bin, r);
+        }
+    }
+
+    if (devhost_template != nullptr) {
+        launchpad_load_from_template(lp, devhost_template);
+    } else {
+        launchpad_load_from_file(lp, devhost_bin);
+    }
+}
+
 static zx_status_t dc_launch_devhost(Devhost* host,
                                      const char* name, zx_handle_t hrpc) {
     const char* devhost_bin = get_devhost_bin();
+    BootSpan span(get_root_resource(), "devmgr", "launch-devhost");
 
     launchpad_t* lp;
     launchpad_create_with_jobs(devhost_job.get(), 0, name, &lp);
-    launchpad_load_from_file(lp, devhost_bin);
+    dc_load_devhost(lp, devhost_bin);
     launchpad_set_args(lp, 1, &devhost_bin);
 
     launchpad_add_handle(lp, hrpc, PA_HND(PA_USER0, 0));
@@ -680,6 +721,7 @@ static zx_status_t dc_launch_devhost(Devhost* host,
     zx_info_handle_basic_t info;
     if (host->proc.get_info(ZX_INFO_HANDLE_BASIC, &info, sizeof(info), nullptr, nullptr) == ZX_OK) {
         host->koid = info.koid;
+        span.set_result(static_cast<uint32_t>(host->koid));
     }
     log(INFO, "devcoord: launch devhost '%s': pid=%zu\n",
         name, host->koid);
@@ -1402,7 +1444,16 @@ static zx_status_t dc_handle_device_read(Device* dev) {
             return ZX_OK;
         }
         switch (pending->op) {
-        case Pending::Op::kBind:
+        case Pending::Op::kBind: {
+            auto libname = static_cast<const char*>(pending->ctx);
+            zx_duration_t elapsed = zx_clock_get_monotonic() - pending->started;
+            if (elapsed >= kSlowBindThreshold) {
+                log(INFO, "devcoord: bind-driver '%s' to '%s' took %" PRId64 "ms\n",
+                    libname, dev->name, elapsed / ZX_MSEC(1));
+            } else {
+                log(TRACE, "devcoord: bind-driver '%s' to '%s' took %" PRId64 "us\n",
+                    libname, dev->name, elapsed / ZX_USEC(1));
+            }
             if (msg.status != ZX_OK) {
                 log(ERROR, "devcoord: rpc: bind-driver '%s' status %d\n",
                     dev->name, msg.status);
@@ -1411,6 +1462,7 @@ static zx_status_t dc_handle_device_read(Device* dev) {
             }
             //TODO: try next driver, clear BOUND flag
             break;
+        }
         case Pending::Op::kSuspend: {
             if (msg.status != ZX_OK) {
                 log(ERROR, "devcoord: rpc: suspend '%s' status %d\n",
@@ -1461,6 +1513,13 @@ static zx_status_t dc_handle_device_read(Device* dev) {
     }
 
 done:
+    if (msg.flags & Message::kFlagNoReply) {
+        if (r != ZX_OK) {
+            log(ERROR, "devcoord: rpc: op %08x to '%s' failed: %d\n",
+                static_cast<uint32_t>(msg.op), dev->name, r);
+        }
+        return ZX_OK;
+    }
     dcs.status = r;
     if ((r = zx_channel_write(dev->hrpc, 0, &dcs, sizeof(dcs), nullptr, 0)) < 0) {
         return r;
@@ -1468,8 +1527,10 @@ done:
     return ZX_OK;
 
 disconnect:
-    dcs.status = ZX_OK;
-    zx_channel_write(dev->hrpc, 0, &dcs, sizeof(dcs), nullptr, 0);
+    if (!(msg.flags & Message::kFlagNoReply)) {
+        dcs.status = ZX_OK;
+        zx_channel_write(dev->hrpc, 0, &dcs, sizeof(dcs), nullptr, 0);
+    }
     return ZX_ERR_STOP;
 
 fail_wrong_hcount:
@@ -1483,19 +1544,29 @@ fail_close_handles:
 
 #define dev_from_ph(ph) containerof(ph, Device, ph)
 
+// how many messages to handle from one device before giving others a turn
+static constexpr uint32_t kMaxReadsPerWakeup = 16;
+
 // handle inbound RPCs from devhost to devices
 static zx_status_t dc_handle_device(port_handler_t* ph, zx_signals_t signals, uint32_t evt) {
     Device* dev = dev_from_ph(ph);
 
     if (signals & ZX_CHANNEL_READABLE) {
-        zx_status_t r;
-        if ((r = dc_handle_device_read(dev)) < 0) {
-            if (r != ZX_ERR_STOP) {
-                log(ERROR, "devcoord: device %p name='%s' rpc status: %d\n",
-                    dev, dev->name, r);
+        // Handle whatever has queued up, such as messages that need no
+        // reply and the request that follows them, in one wakeup.
+        for (uint32_t n = 0; n < kMaxReadsPerWakeup; n++) {
+            zx_status_t r;
+            if ((r = dc_handle_device_read(dev)) < 0) {
+                if (r == ZX_ERR_SHOULD_WAIT) {
+                    break;
+                }
+                if (r != ZX_ERR_STOP) {
+                    log(ERROR, "devcoord: device %p name='%s' rpc status: %d\n",
+                        dev, dev->name, r);
+                }
+                dc_remove_device(dev, true);
+                return ZX_ERR_STOP;
             }
-            dc_remove_device(dev, true);
-            return ZX_ERR_STOP;
         }
         return ZX_OK;
     }
@@ -1662,7 +1733,9 @@ static zx_status_t dh_bind_driver(Device* dev, const char* libname) {
 
     dev->flags |= DEV_CTX_BOUND;
     pending->op = Pending::Op::kBind;
-    pending->ctx = nullptr;
+    // drivers are never unloaded, so their name outlives the request
+    pending->ctx = const_cast<char*>(libname);
+    pending->started = zx_clock_get_monotonic();
     dev->pending.push_back(pending.release());
     return ZX_OK;
 }
@@ -1835,6 +1908,7 @@ static zx_status_t dc_suspend_devhost(Devhost* dh, SuspendContext* ctx) {
     dh->flags |= DEV_HOST_SUSPEND;
     pending->op = Pending::Op::kSuspend;
     pending->ctx = ctx;
+    pending->started = zx_clock_get_monotonic();
     dev->pending.push_back(pending.release());
 
     ctx->count += 1;
@@ -2219,10 +2293,6 @@ static port_handler_t control_handler = []() {
 static void dc_driver_added_sys(Driver* drv, const char* version) {
     log(INFO, "devmgr: adding system driver '%s' '%s'\n", drv->name.c_str(), drv->libname.c_str());
 
-    if (load_vmo(drv->libname.c_str(), &drv->dso_vmo)) {
-        log(ERROR, "devmgr: system driver '%s' '%s' could not cache DSO\n", drv->name.c_str(),
-            drv->libname.c_str());
-    }
     if (version[0] == '*') {
         // de-prioritize drivers that are "fallback"
         list_drivers_system.push_back(drv);
@@ -30,6 +30,7 @@
 #include <lib/zx/port.h>
 #include <lib/zx/resource.h>
 
+#include "boot-trace.h"
 #include "bootfs.h"
 #include "devhost.h"
 #include "devmgr.h"
@@ -703,6 +704,8 @@ void bootfs_create_from_startup_handle() {
 }
 
 void fshost_start() {
+    BootSpan span(get_root_resource(), "devmgr", "launch-fshost");
+
     // assemble handles to pass down to fshost
     zx_handle_t handles[MAXHND];
     uint32_t types[MAXHND];
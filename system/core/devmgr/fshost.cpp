@@ -9,6 +9,7 @@
 
 #include <fbl/function.h>
 #include <fbl/intrusive_single_list.h>
+#include <fbl/string.h>
 #include <fbl/unique_fd.h>
 #include <fs-management/ramdisk.h>
 #include <launchpad/launchpad.h>
@@ -72,17 +73,52 @@ const FsManager* g_fshost = nullptr;
 
 using AddFileFn = fbl::Function<zx_status_t(const char* path, zx_handle_t vmo,
                                             zx_off_t off, size_t len)>;
+using AddLazyFileFn = fbl::Function<zx_status_t(const char* path, size_t len,
+                                                memfs::VmoMaker maker)>;
 
 struct callback_data {
     zx_handle_t vmo;
     unsigned int file_count;
     AddFileFn add_file;
+    AddLazyFileFn add_lazy_file;
 };
 
+// Adds a file stored compressed, decompressing it only once it is used.
+zx_status_t AddCompressedFile(callback_data* cd, const bootfs_entry_t* entry) {
+    const char* errmsg;
+    uint64_t size;
+    zx_off_t off = BOOTFS_ENTRY_DATA_OFF(entry);
+    zx_status_t status = bootfs_file_size(cd->vmo, off, entry->data_len, &size, &errmsg);
+    if (status != ZX_OK) {
+        printf("devmgr: bootfs: bad compressed file '%s': %s\n", entry->name, errmsg);
+        return status;
+    }
+    zx_handle_t vmo = cd->vmo;
+    size_t len = entry->data_len;
+    fbl::String name(entry->name);
+    return cd->add_lazy_file(entry->name, size, [vmo, off, len, name](zx_handle_t* out) {
+        const char* errmsg;
+        uint64_t size;
+        zx_handle_t file_vmo;
+        zx_status_t status = decompress_bootfs_file(zx_vmar_root_self(), vmo, off, len,
+                                                    name.c_str(), &file_vmo, &size, &errmsg);
+        if (status != ZX_OK) {
+            printf("devmgr: bootfs: cannot decompress '%s': %s\n", name.c_str(), errmsg);
+            return status;
+        }
+        // Like the rest of bootfs, the file may be executed.
+        return zx_vmo_replace_as_executable(file_vmo, ZX_HANDLE_INVALID, out);
+    });
+}
+
 zx_status_t callback(void* arg, const bootfs_entry_t* entry) {
     auto cd = static_cast<callback_data*>(arg);
     //printf("bootfs: %s @%zd (%zd bytes)\n", path, off, len);
-    cd->add_file(entry->name, cd->vmo, entry->data_off, entry->data_len);
+    if (entry->data_off & BOOTFS_ENTRY_COMPRESSED) {
+        AddCompressedFile(cd, entry);
+    } else {
+        cd->add_file(entry->name, cd->vmo, entry->data_off, entry->data_len);
+    }
     ++cd->file_count;
     return ZX_OK;
 }
@@ -110,6 +146,9 @@ zx_status_t SetupBootfsVmo(const fbl::unique_ptr<FsManager>& root, uint32_t n,
         .add_file = (type == BOOTDATA_BOOTFS_SYSTEM) ?
                 fbl::BindMember(root.get(), &FsManager::SystemfsAddFile) :
                 fbl::BindMember(root.get(), &FsManager::BootfsAddFile),
+        .add_lazy_file = (type == BOOTDATA_BOOTFS_SYSTEM) ?
+                fbl::BindMember(root.get(), &FsManager::SystemfsAddLazyFile) :
+                fbl::BindMember(root.get(), &FsManager::BootfsAddLazyFile),
     };
     if ((type == BOOTDATA_BOOTFS_SYSTEM) && !root->IsSystemMounted()) {
         status = root->MountSystem();
@@ -238,9 +277,10 @@ void SetupBootfs(const fbl::unique_ptr<FsManager>& root,
             case BOOTDATA_BOOTFS_SYSTEM: {
                 const char* errmsg;
                 zx_handle_t bootfs_vmo;
-                status = decompress_bootdata(zx_vmar_root_self(), vmo.get(),
-                                             off, bootdata.length + sizeof(bootdata_t),
-                                             &bootfs_vmo, &errmsg);
+                status = decompress_bootdata_parallel(
+                    zx_vmar_root_self(), vmo.get(),
+                    off, bootdata.length + sizeof(bootdata_t),
+                    zx_system_get_num_cpus(), &bootfs_vmo, &errmsg);
                 if (status < 0) {
                     printf("devmgr: failed to decompress bootdata: %s\n", errmsg);
                 } else {
@@ -251,10 +291,10 @@ void SetupBootfs(const fbl::unique_ptr<FsManager>& root,
             case BOOTDATA_RAMDISK: {
                 const char* errmsg;
                 zx_handle_t ramdisk_vmo;
-                status = decompress_bootdata(
+                status = decompress_bootdata_parallel(
                     zx_vmar_root_self(), vmo.get(),
                     off, bootdata.length + sizeof(bootdata_t),
-                    &ramdisk_vmo, &errmsg);
+                    zx_system_get_num_cpus(), &ramdisk_vmo, &errmsg);
                 if (status != ZX_OK) {
                     printf("fshost: failed to decompress bootdata: %s\n",
                            errmsg);
@@ -60,6 +60,12 @@ public:
     zx_status_t BootfsAddFile(const char* path, zx_handle_t vmo, zx_off_t off, size_t len);
     // Created a named VmoFile in "/system". Ownership of |vmo| assumed global.
     zx_status_t SystemfsAddFile(const char* path, zx_handle_t vmo, zx_off_t off, size_t len);
+    // Created a named file of |len| bytes in "/boot", whose VMO is made by
+    // |maker| when it is first used.
+    zx_status_t BootfsAddLazyFile(const char* path, size_t len, memfs::VmoMaker maker);
+    // Created a named file of |len| bytes in "/system", whose VMO is made by
+    // |maker| when it is first used.
+    zx_status_t SystemfsAddLazyFile(const char* path, size_t len, memfs::VmoMaker maker);
 
     // Signal that both "/boot" and "/system" have been mounted.
     void FuchsiaStart() const {
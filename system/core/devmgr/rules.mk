@@ -110,6 +110,9 @@ MODULE_LIBS := \
 MODULE_FIDL_LIBS := \
     system/fidl/fuchsia-io \
 
+MODULE_HEADER_DEPS := \
+    system/ulib/zircon-internal
+
 include make/module.mk
 
 
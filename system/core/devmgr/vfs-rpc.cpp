@@ -33,8 +33,10 @@
 namespace devmgr {
 namespace {
 
+// Adds the file at |path| under |vnb|, as the range of |vmo| given by |off| and
+// |len| or, if there is a |maker|, as the |len| bytes of the VMO it makes.
 zx_status_t AddVmofile(fbl::RefPtr<memfs::VnodeDir> vnb, const char* path, zx_handle_t vmo,
-                       zx_off_t off, size_t len) {
+                       zx_off_t off, size_t len, memfs::VmoMaker maker = nullptr) {
     zx_status_t r;
     if ((path[0] == '/') || (path[0] == 0))
         return ZX_ERR_INVALID_ARGS;
@@ -44,6 +46,11 @@ zx_status_t AddVmofile(fbl::RefPtr<memfs::VnodeDir> vnb, const char* path, zx_ha
             if (path[0] == 0) {
                 return ZX_ERR_INVALID_ARGS;
             }
+            if (maker) {
+                return vnb->vfs()->CreateFromVmoMaker(vnb.get(),
+                                                      fbl::StringPiece(path, strlen(path)),
+                                                      len, fbl::move(maker));
+            }
             return vnb->vfs()->CreateFromVmo(vnb.get(), fbl::StringPiece(path, strlen(path)),
                                              vmo, off, len);
         } else {
@@ -108,6 +115,15 @@ zx_status_t FsManager::SystemfsAddFile(const char* path, zx_handle_t vmo, zx_off
     return AddVmofile(systemfs_root_, path, vmo, off, len);
 }
 
+zx_status_t FsManager::BootfsAddLazyFile(const char* path, size_t len, memfs::VmoMaker maker) {
+    return AddVmofile(bootfs_root_, path, ZX_HANDLE_INVALID, 0, len, fbl::move(maker));
+}
+
+zx_status_t FsManager::SystemfsAddLazyFile(const char* path, size_t len,
+                                           memfs::VmoMaker maker) {
+    return AddVmofile(systemfs_root_, path, ZX_HANDLE_INVALID, 0, len, fbl::move(maker));
+}
+
 zx_status_t FsManager::MountSystem() {
     ZX_ASSERT(systemfs_root_ == nullptr);
     zx_status_t status = CreateFilesystem("system", &system_vfs_, &systemfs_root_);
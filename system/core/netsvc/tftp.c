@@ -27,6 +27,10 @@
 
 #define TFTP_TIMEOUT_SECS 1
 
+// The most memory used to stage an image on its way to the paver. Blocks which arrive while
+// it's full are dropped, and retransmitted by the host once the paver has caught up.
+#define PAVER_BUFFER_SZ (32 * 1024 * 1024)
+
 #define NB_IMAGE_PREFIX_LEN (strlen(NB_IMAGE_PREFIX))
 #define NB_FILENAME_PREFIX_LEN (strlen(NB_FILENAME_PREFIX))
 
@@ -48,11 +52,14 @@ typedef struct {
             size_t size;                // Total size of file
             zx_handle_t process;
 
-            // Buffer used for stashing data from tftp until it can be written out to the paver
+            // Ring buffer used for stashing data from tftp until it can be written out to the
+            // paver. File offset N is stored at buffer[N % buffer_size].
             zx_handle_t buffer_handle;
             uint8_t* buffer;
+            size_t buffer_size;
             atomic_uint buf_refcount;
-            atomic_size_t offset;       // Buffer write offset (read offset is stored locally)
+            atomic_size_t offset;       // File offset written up to by netsvc
+            atomic_size_t read_offset;  // File offset written out to the paver
             thrd_t buf_copy_thrd;
             sync_completion_t data_ready;    // Allows read thread to block on buffer writes
         } paver;
@@ -95,6 +102,9 @@ static ssize_t file_open_read(const char* filename, void* cookie) {
 
 static zx_status_t alloc_paver_buffer(file_info_t* file_info, size_t size) {
     zx_status_t status;
+    if (size > PAVER_BUFFER_SZ) {
+        size = PAVER_BUFFER_SZ;
+    }
     status = zx_vmo_create(size, 0, &file_info->paver.buffer_handle);
     if (status != ZX_OK) {
         printf("netsvc: unable to allocate buffer VMO\n");
@@ -110,12 +120,13 @@ static zx_status_t alloc_paver_buffer(file_info_t* file_info, size_t size) {
         return status;
     }
     file_info->paver.buffer = (uint8_t*)buffer;
+    file_info->paver.buffer_size = size;
     return ZX_OK;
 }
 
 static zx_status_t dealloc_paver_buffer(file_info_t* file_info) {
     zx_status_t status = zx_vmar_unmap(zx_vmar_root_self(), (uintptr_t)file_info->paver.buffer,
-                                       file_info->paver.size);
+                                       file_info->paver.buffer_size);
     if (status != ZX_OK) {
         printf("netsvc: failed to unmap paver buffer: %s\n", zx_status_get_string(status));
         goto done;
@@ -148,6 +159,8 @@ static int drain_pipe(void* arg) {
 
 // Pushes all data from the paver buffer (filled by netsvc) into the paver input pipe. When
 // there's no data to copy, blocks on data_ready until more data is written into the buffer.
+// Netsvc reuses the space as soon as read_offset moves past it, so disk writes overlap the
+// rest of the transfer.
 static int paver_copy_buffer(void* arg) {
     file_info_t* file_info = arg;
     size_t read_ndx = 0;
@@ -168,14 +181,20 @@ static int paver_copy_buffer(void* arg) {
             goto done;
         }
         while(read_ndx < write_ndx) {
-            int r = write(file_info->paver.fd, &file_info->paver.buffer[read_ndx],
-                          write_ndx - read_ndx);
+            // Write up to the end of the ring at most
+            size_t buf_ndx = read_ndx % file_info->paver.buffer_size;
+            size_t len = write_ndx - read_ndx;
+            if (len > file_info->paver.buffer_size - buf_ndx) {
+                len = file_info->paver.buffer_size - buf_ndx;
+            }
+            int r = write(file_info->paver.fd, &file_info->paver.buffer[buf_ndx], len);
             if (r <= 0) {
                 printf("netsvc: couldn't write to paver fd: %d\n", r);
                 result = TFTP_ERR_IO;
                 goto done;
             }
             read_ndx += r;
+            atomic_store(&file_info->paver.read_offset, read_ndx);
             zx_time_t curr_time = zx_clock_get_monotonic();
             if (zx_time_sub_time(curr_time, last_reported) >= ZX_SEC(1)) {
                 float complete = ((float)read_ndx / (float)file_info->paver.size) * 100.0;
@@ -288,6 +307,7 @@ static tftp_status paver_open_write(const char* filename, size_t size, file_info
     // may be done with it first so we use a refcount to decide when to deallocate it
     atomic_store(&file_info->paver.buf_refcount, 2);
     atomic_store(&file_info->paver.offset, 0);
+    atomic_store(&file_info->paver.read_offset, 0);
     atomic_store(&paving_in_progress, true);
 
     if ((thrd_create(&file_info->paver.buf_copy_thrd, paver_copy_buffer, (void*)file_info))
@@ -375,11 +395,23 @@ static tftp_status file_write(const void* data, size_t* length, off_t offset, vo
         }
 
         if (((size_t)offset > file_info->paver.size)
-            || (offset + *length) > file_info->paver.size) {
+            || (offset + *length) > file_info->paver.size
+            || (size_t)offset < atomic_load(&file_info->paver.read_offset)) {
             return TFTP_ERR_INVALID_ARGS;
         }
-        memcpy(&file_info->paver.buffer[offset], data, *length);
         size_t new_offset = offset + *length;
+        if (new_offset - atomic_load(&file_info->paver.read_offset) >
+            file_info->paver.buffer_size) {
+            // Let the paver catch up; the host will send this block again.
+            return TFTP_ERR_SHOULD_WAIT;
+        }
+        size_t buf_ndx = offset % file_info->paver.buffer_size;
+        size_t len = *length;
+        if (len > file_info->paver.buffer_size - buf_ndx) {
+            len = file_info->paver.buffer_size - buf_ndx;
+        }
+        memcpy(&file_info->paver.buffer[buf_ndx], data, len);
+        memcpy(file_info->paver.buffer, (const uint8_t*)data + len, *length - len);
         atomic_store(&file_info->paver.offset, new_offset);
         // Wake the paver thread, if it is waiting for data
         sync_completion_signal(&file_info->paver.data_ready);
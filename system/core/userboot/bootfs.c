@@ -7,6 +7,7 @@
 
 #pragma GCC visibility push(hidden)
 
+#include <bootdata/decompress.h>
 #include <zircon/boot/bootdata.h>
 #include <zircon/syscalls.h>
 #include <string.h>
@@ -20,6 +21,7 @@ void bootfs_mount(zx_handle_t vmar, zx_handle_t log, zx_handle_t vmo, struct boo
     uintptr_t addr = 0;
     status = zx_vmar_map(vmar, ZX_VM_PERM_READ, 0, vmo, 0, size, &addr);
     check(log, status, "zx_vmar_map failed on bootfs vmo\n");
+    fs->vmar = vmar;
     fs->contents = (const void*)addr;
     fs->len = size;
     status = zx_handle_duplicate(
@@ -82,21 +84,33 @@ zx_handle_t bootfs_open(zx_handle_t log, const char* purpose,
         printl(log, "file not found");
         return ZX_HANDLE_INVALID;
     }
-    if (e->data_off > fs->len)
+    uint32_t data_off = BOOTFS_ENTRY_DATA_OFF(e);
+    if (data_off > fs->len)
         fail(log, "bogus offset in bootfs header!");
-    if (fs->len - e->data_off < e->data_len)
+    if (fs->len - data_off < e->data_len)
         fail(log, "bogus size in bootfs header!");
 
-    // Clone a private copy of the file's subset of the bootfs VMO.
-    // TODO(mcgrathr): Create a plain read-only clone when the feature
-    // is implemented in the VM.
     zx_handle_t vmo;
-    zx_status_t status = zx_vmo_clone(fs->vmo, ZX_VMO_CLONE_COPY_ON_WRITE,
-                                      e->data_off, e->data_len, &vmo);
-    if (status != ZX_OK)
-        fail(log, "zx_vmo_clone failed: %d", status);
-
-    zx_object_set_property(vmo, ZX_PROP_NAME, filename, strlen(filename));
+    zx_status_t status;
+    if (e->data_off & BOOTFS_ENTRY_COMPRESSED) {
+        // Only the files actually used get decompressed.
+        const char* errmsg;
+        uint64_t size;
+        status = decompress_bootfs_file(fs->vmar, fs->vmo, data_off, e->data_len,
+                                        filename, &vmo, &size, &errmsg);
+        if (status != ZX_OK)
+            fail(log, "decompressing '%s' failed: %d: %s", filename, status, errmsg);
+    } else {
+        // Clone a private copy of the file's subset of the bootfs VMO.
+        // TODO(mcgrathr): Create a plain read-only clone when the feature
+        // is implemented in the VM.
+        status = zx_vmo_clone(fs->vmo, ZX_VMO_CLONE_COPY_ON_WRITE,
+                              data_off, e->data_len, &vmo);
+        if (status != ZX_OK)
+            fail(log, "zx_vmo_clone failed: %d", status);
+
+        zx_object_set_property(vmo, ZX_PROP_NAME, filename, strlen(filename));
+    }
 
     // Drop unnecessary ZX_RIGHT_WRITE rights.
     // TODO(mcgrathr): Should be superfluous with read-only zx_vmo_clone.
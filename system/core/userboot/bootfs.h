@@ -11,6 +11,7 @@
 #include <stdint.h>
 
 struct bootfs {
+    zx_handle_t vmar;
     zx_handle_t vmo;
     const void* contents;
     size_t len;
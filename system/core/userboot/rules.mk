@@ -72,6 +72,8 @@ MODULE_COMPILEFLAGS += -Ithird_party/ulib/lz4/include/lz4 -DWITH_LZ4_NOALLOC
 MODULE_HEADER_DEPS += system/ulib/ldmsg
 MODULE_SRCS += system/ulib/ldmsg/ldmsg.c
 
+MODULE_HEADER_DEPS += system/ulib/zircon-internal
+
 # This generated header lists all the ABI symbols in the vDSO with their
 # addresses.  It's used to generate vdso-syms.ld, below.
 $(BUILDDIR)/$(LOCAL_DIR)/vdso-syms.h: $(BUILDDIR)/system/ulib/zircon/libzircon.so
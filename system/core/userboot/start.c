@@ -11,6 +11,7 @@
 
 #pragma GCC visibility push(hidden)
 
+#include <lib/zircon-internal/ktrace.h>
 #include <zircon/stack.h>
 #include <zircon/syscalls.h>
 #include <zircon/syscalls/log.h>
@@ -210,6 +211,7 @@ static noreturn void bootstrap(zx_handle_t log, zx_handle_t bootstrap_pipe) {
     // Locate the first bootfs bootdata section and decompress it.
     // We need it to load devmgr and libc from.
     // Later bootfs sections will be processed by devmgr.
+    boot_span(root_resource_handle, "bootfs", KTRACE_BOOT_BEGIN);
     zx_handle_t bootfs_vmo = bootdata_get_bootfs(log, vmar_self, bootdata_vmo);
 
     // TODO(mdempsky): Push further down the stack? Seems unnecessary to
@@ -224,6 +226,7 @@ static noreturn void bootstrap(zx_handle_t log, zx_handle_t bootstrap_pipe) {
     // Map in the bootfs so we can look for files in it.
     struct bootfs bootfs;
     bootfs_mount(vmar_self, log, bootfs_vmo, &bootfs);
+    boot_span(root_resource_handle, "bootfs", KTRACE_BOOT_END);
 
     // Make the channel for the bootstrap message.
     zx_handle_t to_child;
@@ -231,6 +234,7 @@ static noreturn void bootstrap(zx_handle_t log, zx_handle_t bootstrap_pipe) {
     status = zx_channel_create(0, &to_child, &child_start_handle);
     check(log, status, "zx_channel_create failed");
 
+    boot_span(root_resource_handle, "launch", KTRACE_BOOT_BEGIN);
     const char* filename = o.value[OPTION_FILENAME];
     zx_handle_t proc;
     zx_handle_t vmar;
@@ -315,6 +319,7 @@ static noreturn void bootstrap(zx_handle_t log, zx_handle_t bootstrap_pipe) {
     check(log, status, "zx_process_start failed");
     status = zx_handle_close(thread);
     check(log, status, "zx_handle_close failed on thread handle");
+    boot_span(root_resource_handle, "launch", KTRACE_BOOT_END);
 
     printl(log, "process %s started.", o.value[OPTION_FILENAME]);
 
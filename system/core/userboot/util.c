@@ -7,6 +7,7 @@
 #pragma GCC visibility push(hidden)
 
 #include <assert.h>
+#include <lib/zircon-internal/ktrace.h>
 #include <zircon/syscalls.h>
 #include <zircon/syscalls/log.h>
 #include <stdarg.h>
@@ -169,3 +170,19 @@ void fail(zx_handle_t log, const char* fmt, ...) {
     va_end(ap);
     zx_process_exit(-1);
 }
+
+void boot_span(zx_handle_t rroot, const char* step, uint32_t phase) {
+    static const char prefix[] = KTRACE_BOOT_PREFIX "userboot:";
+
+    // The kernel reads a whole ZX_MAX_NAME_LEN buffer.
+    char name[ZX_MAX_NAME_LEN] = {0};
+    size_t len = strlen(step);
+    if (len > sizeof(name) - sizeof(prefix))
+        len = sizeof(name) - sizeof(prefix);
+    memcpy(name, prefix, sizeof(prefix) - 1);
+    memcpy(name + sizeof(prefix) - 1, step, len);
+
+    zx_status_t id = zx_ktrace_control(rroot, KTRACE_ACTION_NEW_PROBE, 0, name);
+    if (id > 0)
+        zx_ktrace_write(rroot, id, phase, 0);
+}
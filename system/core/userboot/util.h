@@ -18,6 +18,10 @@ void vprintl(zx_handle_t log, const char* fmt, va_list ap);
 // fail() combines printl() with process exit
 _Noreturn void __PRINTFLIKE(2, 3) fail(zx_handle_t log, const char* fmt, ...);
 
+// boot_span() records the start (KTRACE_BOOT_BEGIN) or end (KTRACE_BOOT_END)
+// of |step| on the boot timeline, as the ktrace probe "boot:userboot:|step|".
+void boot_span(zx_handle_t rroot, const char* step, uint32_t phase);
+
 #define check(log, status, fmt, ...)                                    \
     do {                                                                \
         if (status != ZX_OK)                                            \
@@ -448,7 +448,7 @@ int GaussPdmInputStream::IrqThread() {
 
         vmo_helper_.printoffsetinvmo(offset);
 
-        audio_proto::RingBufPositionNotify resp;
+        audio_proto::RingBufPositionNotify resp = {};
         resp.ring_buffer_pos = offset;
         resp.hdr.cmd = AUDIO_RB_POSITION_NOTIFY;
         resp.hdr.transaction_id = AUDIO_INVALID_TRANSACTION_ID;
@@ -284,6 +284,55 @@ zx_status_t IntelHDAController::SetupPCIInterrupts() {
     return ZX_OK;
 }
 
+zx_status_t IntelHDAController::SetupDMAPositionBuffer() {
+    // Allocate a page for the DMA position buffer and map it into our address
+    // space.  One entry per stream descriptor easily fits within a single page.
+    zx::vmo dma_pos_vmo;
+    zx_status_t res;
+    constexpr uint32_t CPU_MAP_FLAGS = ZX_VM_PERM_READ | ZX_VM_PERM_WRITE;
+    static_assert(PAGE_SIZE >= (sizeof(IntelHDADMAPosEntry) * MAX_STREAMS_PER_CONTROLLER),
+                  "PAGE_SIZE to small to hold the DMA position buffer!");
+    res = dma_pos_cpu_mem_.CreateAndMap(PAGE_SIZE,
+                                        CPU_MAP_FLAGS,
+                                        DriverVmars::registers(),
+                                        &dma_pos_vmo,
+                                        ZX_RIGHT_SAME_RIGHTS,
+                                        ZX_CACHE_POLICY_UNCACHED_DEVICE);
+    if (res != ZX_OK) {
+        LOG(ERROR, "Failed to create and map %u bytes for DMA position buffer! (res %d)\n",
+            PAGE_SIZE, res);
+        return res;
+    }
+
+    // Pin this VMO and grant the controller access to it.  The controller
+    // only ever writes stream positions into this buffer.
+    constexpr uint32_t HDA_MAP_FLAGS = ZX_BTI_PERM_READ | ZX_BTI_PERM_WRITE;
+    res = dma_pos_hda_mem_.Pin(dma_pos_vmo, pci_bti_->initiator(), HDA_MAP_FLAGS);
+    if (res != ZX_OK) {
+        LOG(ERROR, "Failed to pin pages for DMA position buffer! (res %d)\n", res);
+        return res;
+    }
+
+    const auto& region = dma_pos_hda_mem_.region(0);
+    uint64_t dma_pos_paddr64 = static_cast<uint64_t>(region.phys_addr);
+
+    bool gcap_64bit_ok = HDA_REG_GCAP_64OK(REG_RD(&regs()->gcap));
+    if ((dma_pos_paddr64 >> 32) && !gcap_64bit_ok) {
+        LOG(ERROR, "Intel HDA controller does not support 64-bit physical addressing!\n");
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+
+    // The DMA position buffer base address must be 128 byte aligned, which
+    // leaves the low bits of DPLBASE for the enable flag.
+    ZX_DEBUG_ASSERT(!(dma_pos_paddr64 & 0x7F));
+    REG_WR(&regs()->dpibubase, ((uint32_t)(dma_pos_paddr64 >> 32)));
+    REG_WR(&regs()->dpiblbase, ((uint32_t)(dma_pos_paddr64 & 0xFFFFFFFF)) |
+                               HDA_REG_DPLBASE_ENABLE);
+    hw_wmb();
+
+    return ZX_OK;
+}
+
 zx_status_t IntelHDAController::SetupStreamDescriptors() {
     fbl::AutoLock stream_pool_lock(&stream_pool_lock_);
 
@@ -305,7 +354,10 @@ zx_status_t IntelHDAController::SetupStreamDescriptors() {
         return ZX_ERR_INTERNAL;
     }
 
-    // Allocate our stream descriptors and populate our free lists.
+    // Allocate our stream descriptors and populate our free lists.  Each
+    // stream reports its position through its own DMA position buffer entry.
+    auto dma_pos = reinterpret_cast<const IntelHDADMAPosEntry*>(dma_pos_cpu_mem_.start());
+    ZX_DEBUG_ASSERT(dma_pos != nullptr);
     for (uint32_t i = 0; i < total_stream_cnt; ++i) {
         uint16_t stream_id = static_cast<uint16_t>(i + 1);
         auto type = (i < input_stream_cnt)
@@ -314,7 +366,8 @@ zx_status_t IntelHDAController::SetupStreamDescriptors() {
                   ? IntelHDAStream::Type::OUTPUT
                   : IntelHDAStream::Type::BIDIR);
 
-        auto stream = IntelHDAStream::Create(type, stream_id, &regs()->stream_desc[i], pci_bti_);
+        auto stream = IntelHDAStream::Create(type, stream_id, &regs()->stream_desc[i],
+                                             dma_pos + i, pci_bti_);
         if (stream == nullptr) {
             LOG(ERROR, "Failed to create HDA stream context %u/%u\n", i, total_stream_cnt);
             return ZX_ERR_NO_MEMORY;
@@ -603,6 +656,12 @@ zx_status_t IntelHDAController::InitInternal(zx_device_t* pci_dev) {
     if (res != ZX_OK)
         return res;
 
+    // Allocate and enable the DMA position buffer which our streams use to
+    // report their positions.
+    res = SetupDMAPositionBuffer();
+    if (res != ZX_OK)
+        return res;
+
     // Allocate and set up our stream descriptors.
     res = SetupStreamDescriptors();
     if (res != ZX_OK)
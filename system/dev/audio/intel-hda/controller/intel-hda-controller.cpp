@@ -89,6 +89,10 @@ IntelHDAController::~IntelHDAController() {
     cmd_buf_cpu_mem_.Unmap();
     cmd_buf_hda_mem_.Unpin();
 
+    // Same for the DMA position buffer.
+    dma_pos_cpu_mem_.Unmap();
+    dma_pos_hda_mem_.Unpin();
+
     if (pci_.ops != nullptr) {
         // TODO(johngro) : unclaim the PCI device.  Right now, there is no way
         // to do this aside from closing the device handle (which would
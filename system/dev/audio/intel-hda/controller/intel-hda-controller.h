@@ -106,6 +106,7 @@ private:
     zx_status_t ResetControllerHW();
     zx_status_t SetupPCIDevice(zx_device_t* pci_dev);
     zx_status_t SetupPCIInterrupts();
+    zx_status_t SetupDMAPositionBuffer();
     zx_status_t SetupStreamDescriptors() TA_EXCL(stream_pool_lock_);
     zx_status_t SetupCommandBufferSize(uint8_t* size_reg, unsigned int* entry_count);
     zx_status_t SetupCommandBuffer() TA_EXCL(corb_lock_, rirb_lock_);
@@ -164,6 +165,11 @@ private:
     fzl::VmoMapper cmd_buf_cpu_mem_ TA_GUARDED(corb_lock_);
     fzl::PinnedVmo cmd_buf_hda_mem_ TA_GUARDED(corb_lock_);
 
+    // Physical memory allocated for the DMA position buffer, which the
+    // controller keeps updated with the position of every stream.
+    fzl::VmoMapper dma_pos_cpu_mem_;
+    fzl::PinnedVmo dma_pos_hda_mem_;
+
     // Stream state
     fbl::Mutex           stream_pool_lock_;
     IntelHDAStream::Tree free_input_streams_  TA_GUARDED(stream_pool_lock_);
@@ -34,9 +34,10 @@ fbl::RefPtr<IntelHDAStream> IntelHDAStream::Create(
         Type type,
         uint16_t id,
         hda_stream_desc_regs_t* regs,
+        const IntelHDADMAPosEntry* dma_pos,
         const fbl::RefPtr<RefCountedBti>& pci_bti) {
     fbl::AllocChecker ac;
-    auto ret = fbl::AdoptRef(new (&ac) IntelHDAStream(type, id, regs, pci_bti));
+    auto ret = fbl::AdoptRef(new (&ac) IntelHDAStream(type, id, regs, dma_pos, pci_bti));
     if (!ac.check()) {
         return nullptr;
     }
@@ -54,10 +55,12 @@ fbl::RefPtr<IntelHDAStream> IntelHDAStream::Create(
 IntelHDAStream::IntelHDAStream(Type type,
                                uint16_t id,
                                hda_stream_desc_regs_t* regs,
+                               const IntelHDADMAPosEntry* dma_pos,
                                const fbl::RefPtr<RefCountedBti>& pci_bti)
     : type_(type),
       id_(id),
       regs_(regs),
+      dma_pos_(dma_pos),
       pci_bti_(pci_bti) {
   snprintf(log_prefix_, sizeof(log_prefix_), "IHDA_SD #%u", id_);
 }
@@ -351,7 +354,8 @@ void IntelHDAStream::ProcessStreamIRQ() {
         audio_proto::RingBufPositionNotify msg;
         msg.hdr.cmd = AUDIO_RB_POSITION_NOTIFY;
         msg.hdr.transaction_id = AUDIO_INVALID_TRANSACTION_ID;
-        msg.ring_buffer_pos = REG_RD(&regs_->lpib);
+        msg.ring_buffer_pos = REG_RD(&dma_pos_->position);
+        msg.monotonic_time = zx_clock_get_monotonic();
         irq_channel_->Write(&msg, sizeof(msg));
     }
 }
@@ -42,6 +42,7 @@ public:
         Type type,
         uint16_t id,
         hda_stream_desc_regs_t* regs,
+        const IntelHDADMAPosEntry* dma_pos,
         const fbl::RefPtr<RefCountedBti>& pci_bti);
 
     const char* log_prefix()      const { return log_prefix_; }
@@ -69,6 +70,7 @@ private:
     IntelHDAStream(Type type,
                    uint16_t id,
                    hda_stream_desc_regs_t* regs,
+                   const IntelHDADMAPosEntry* dma_pos,
                    const fbl::RefPtr<RefCountedBti>& pci_bti);
     ~IntelHDAStream();
 
@@ -118,6 +120,11 @@ private:
     const uint16_t                id_   = 0;
     hda_stream_desc_regs_t* const regs_ = nullptr;
 
+    // Our entry in the controller's DMA position buffer.  The controller keeps
+    // this updated with our position in the ring buffer as it moves data, which
+    // is both cheaper to read and more current than the LPIB register.
+    const IntelHDADMAPosEntry* const dma_pos_ = nullptr;
+
     // Parameters determined at allocation time.
     Type    configured_type_;
     uint8_t tag_;
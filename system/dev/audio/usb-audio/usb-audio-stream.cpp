@@ -977,6 +977,7 @@ void UsbAudioStream::RequestComplete(usb_request_t* req) {
                     when_finished = Action::NOTIFY_POSITION;
                     notification_acc_ = (notification_acc_ % bytes_per_notification_);
                     resp.notify_pos.ring_buffer_pos = ring_buffer_pos_;
+                    resp.notify_pos.monotonic_time = complete_time;
                 }
             }
         }
@@ -65,8 +65,8 @@ typedef struct ahci_port {
     list_node_t txn_list;
     io_buffer_t buffer;
 
+    uint32_t slot_mask; // bitmask of command slots the device may use
     uint32_t running;   // bitmask of running commands
-    uint32_t completed; // bitmask of completed commands
     sata_txn_t* commands[AHCI_MAX_COMMANDS]; // commands in flight
     sata_txn_t* sync;   // FLUSH command in flight
 } ahci_port_t;
@@ -192,8 +192,7 @@ static void ahci_port_reset(ahci_port_t* port) {
 static bool ahci_port_cmd_busy(ahci_port_t* port, int slot) {
     // a command slot is busy if a transaction is in flight or pending to be completed
     return ((ahci_read(&port->regs->sact) | ahci_read(&port->regs->ci)) & (1 << slot)) ||
-           (port->commands[slot] != NULL) ||
-           (port->running & (1 << slot)) || (port->completed & (1 << slot));
+           (port->commands[slot] != NULL) || (port->running & (1 << slot));
 }
 
 static bool cmd_is_read(uint8_t cmd) {
@@ -220,22 +219,69 @@ static bool cmd_is_queued(uint8_t cmd) {
     return (cmd == SATA_CMD_READ_FPDMA_QUEUED) || (cmd == SATA_CMD_WRITE_FPDMA_QUEUED);
 }
 
-static void ahci_port_complete_txn(ahci_device_t* dev, ahci_port_t* port, zx_status_t status) {
-    mtx_lock(&port->lock);
-    uint32_t sact = ahci_read(&port->regs->sact);
-    uint32_t running = port->running;
-    uint32_t done = sact ^ running;
-    // assert if a command slot without an outstanding transaction is active
-    ZX_DEBUG_ASSERT(!(done & sact));
-    port->completed |= done;
+// Completes the txns in the command slots of |done| with |status|, and resumes the port if it
+// was paused for a FLUSH which they were the last commands ahead of. Called with the port lock
+// held, which is dropped while the txns are completed.
+static void ahci_port_complete_locked(ahci_port_t* port, uint32_t done, zx_status_t status) {
+    sata_txn_t* txns[AHCI_MAX_COMMANDS];
+    size_t count = 0;
+    while (done) {
+        unsigned slot = __builtin_ctz(done);
+        done &= ~(1u << slot);
+        sata_txn_t* txn = port->commands[slot];
+        port->running &= ~(1u << slot);
+        port->commands[slot] = NULL;
+        if (txn == NULL) {
+            zxlogf(ERROR, "ahci.%d: illegal state, completing slot %u but txn == NULL\n",
+                    port->nr, slot);
+            continue;
+        }
+        txns[count++] = txn;
+    }
+
+    // resume the port if paused for sync and no outstanding transactions
+    sata_txn_t* sop = NULL;
+    if ((port->flags & AHCI_PORT_FLAG_SYNC_PAUSED) && !port->running) {
+        port->flags &= ~AHCI_PORT_FLAG_SYNC_PAUSED;
+        sop = port->sync;
+        port->sync = NULL;
+    }
+
+    if (count == 0 && sop == NULL) {
+        return;
+    }
     mtx_unlock(&port->lock);
-    // hit the worker thread to complete commands
-    sync_completion_signal(&dev->worker_completion);
+    for (size_t i = 0; i < count; i++) {
+        if (txns[i]->pmt != ZX_HANDLE_INVALID) {
+            zx_pmt_unpin(txns[i]->pmt);
+        }
+        zxlogf(SPEW, "ahci.%d: complete txn %p status %d\n", port->nr, txns[i], status);
+        block_complete(txns[i], status);
+    }
+    if (sop) {
+        block_complete(sop, ZX_OK);
+    }
+    mtx_lock(&port->lock);
+}
+
+// Recovers |port| from an error or a timeout, completing the commands which finished before it
+// and failing those still in flight with |status|. With NCQ the device aborts its whole queue on
+// an error, so none of the commands in flight can be assumed to have completed.
+static void ahci_port_recover_locked(ahci_port_t* port, zx_status_t status) {
+    uint32_t active = ahci_read(&port->regs->sact) | ahci_read(&port->regs->ci);
+    uint32_t done = port->running & ~active;
+    uint32_t failed = port->running & active;
+
+    // restarting the port clears sact and ci, freeing the slots of the failed commands
+    ahci_port_reset(port);
+
+    ahci_port_complete_locked(port, done, ZX_OK);
+    ahci_port_complete_locked(port, failed, status);
 }
 
 static zx_status_t ahci_do_txn(ahci_device_t* dev, ahci_port_t* port, int slot, sata_txn_t* txn) {
-    assert(slot < AHCI_MAX_COMMANDS);
-    assert(!ahci_port_cmd_busy(port, slot));
+    ZX_DEBUG_ASSERT(slot < AHCI_MAX_COMMANDS);
+    ZX_DEBUG_ASSERT(!ahci_port_cmd_busy(port, slot));
 
     uint64_t offset_vmo = txn->bop.rw.offset_vmo * port->devinfo.block_size;
     uint64_t bytes = txn->bop.rw.length * port->devinfo.block_size;
@@ -274,7 +320,7 @@ static zx_status_t ahci_do_txn(ahci_device_t* dev, ahci_port_t* port, int slot,
     uint64_t count = txn->bop.rw.length;
 
     // use queued command if available
-    if (dev->cap & AHCI_CAP_NCQ) {
+    if ((dev->cap & AHCI_CAP_NCQ) && port->devinfo.ncq) {
         if (cmd == SATA_CMD_READ_DMA_EXT) {
             cmd = SATA_CMD_READ_FPDMA_QUEUED;
         } else if (cmd == SATA_CMD_WRITE_DMA_EXT) {
@@ -474,7 +520,12 @@ static void ahci_hba_reset(ahci_device_t* dev) {
 void ahci_set_devinfo(ahci_device_t* device, int portnr, sata_devinfo_t* devinfo) {
     ZX_DEBUG_ASSERT(ahci_port_valid(device, portnr));
     ahci_port_t* port = &device->ports[portnr];
+    // max_cmd and the number of command slots of the controller are both 0-based
+    int max = MIN(devinfo->max_cmd, (int)((device->cap >> 8) & 0x1f));
+    mtx_lock(&port->lock);
     memcpy(&port->devinfo, devinfo, sizeof(port->devinfo));
+    port->slot_mask = (max >= 31) ? UINT32_MAX : ((1u << (max + 1)) - 1);
+    mtx_unlock(&port->lock);
 }
 
 void ahci_queue(ahci_device_t* device, int portnr, sata_txn_t* txn) {
@@ -506,104 +557,66 @@ static void ahci_release(void* ctx) {
     free(device);
 }
 
+// Issues the queued txns of |port| for as long as it has free command slots. Called with the
+// port lock held.
+static void ahci_port_process_locked(ahci_device_t* dev, ahci_port_t* port) {
+    sata_txn_t* txn;
+    while (!(port->flags & AHCI_PORT_FLAG_SYNC_PAUSED)) {
+        txn = list_peek_head_type(&port->txn_list, sata_txn_t, node);
+        if (!txn) {
+            break;
+        }
+
+        // find a free command tag
+        uint32_t free_slots = port->slot_mask & ~port->running;
+        if (!free_slots) {
+            break;
+        }
+        int slot = __builtin_ctz(free_slots);
+
+        list_delete(&txn->node);
+
+        if (BLOCK_OP(txn->bop.command) == BLOCK_OP_FLUSH) {
+            if (port->running) {
+                ZX_DEBUG_ASSERT(port->sync == NULL);
+                // pause the port if FLUSH command
+                port->flags |= AHCI_PORT_FLAG_SYNC_PAUSED;
+                port->sync = txn;
+            } else {
+                // complete immediately if nothing in flight
+                mtx_unlock(&port->lock);
+                block_complete(txn, ZX_OK);
+                mtx_lock(&port->lock);
+            }
+        } else {
+            // run the transaction
+            zx_status_t st = ahci_do_txn(dev, port, slot, txn);
+            // complete the transaction with if it failed during processing
+            if (st != ZX_OK) {
+                mtx_unlock(&port->lock);
+                block_complete(txn, st);
+                mtx_lock(&port->lock);
+            }
+        }
+    }
+}
+
 // worker thread
 
 static int ahci_worker_thread(void* arg) {
     ahci_device_t* dev = (ahci_device_t*)arg;
-    ahci_port_t* port;
-    sata_txn_t* txn;
     for (;;) {
-        // iterate all the ports and run or complete commands
+        // iterate all the ports and run queued commands; commands are completed, and the slots
+        // they free refilled, by the irq thread
         for (int i = 0; i < AHCI_MAX_PORTS; i++) {
-            port = &dev->ports[i];
+            ahci_port_t* port = &dev->ports[i];
             mtx_lock(&port->lock);
-            if (!ahci_port_valid(dev, i)) {
-                goto next;
-            }
-
-            // complete commands first
-            while (port->completed) {
-                unsigned slot = 32 - __builtin_clz(port->completed) - 1;
-                txn = port->commands[slot];
-                if (txn == NULL) {
-                    zxlogf(ERROR, "ahci.%d: illegal state, completing slot %d but txn == NULL\n",
-                            port->nr, slot);
-                } else {
-                    mtx_unlock(&port->lock);
-                    if (txn->pmt != ZX_HANDLE_INVALID) {
-                        zx_pmt_unpin(txn->pmt);
-                    }
-                    zxlogf(SPEW, "ahci.%d: complete txn %p\n", port->nr, txn);
-                    block_complete(txn, ZX_OK);
-                    mtx_lock(&port->lock);
-                }
-                port->completed &= ~(1 << slot);
-                port->running &= ~(1 << slot);
-                port->commands[slot] = NULL;
-                // resume the port if paused for sync and no outstanding transactions
-                if ((port->flags & AHCI_PORT_FLAG_SYNC_PAUSED) && !port->running) {
-                    port->flags &= ~AHCI_PORT_FLAG_SYNC_PAUSED;
-                    if (port->sync) {
-                        sata_txn_t* sop = port->sync;
-                        port->sync = NULL;
-                        mtx_unlock(&port->lock);
-                        block_complete(sop, ZX_OK);
-                        mtx_lock(&port->lock);
-                    }
-                }
-            }
-
-            if (port->flags & AHCI_PORT_FLAG_SYNC_PAUSED) {
-                goto next;
-            }
-
-            // process queued txns
-            for (;;) {
-                txn = list_peek_head_type(&port->txn_list, sata_txn_t, node);
-                if (!txn) {
-                    break;
-                }
-
-                // find a free command tag
-                int max = MIN(port->devinfo.max_cmd, (int)((dev->cap >> 8) & 0x1f));
-                int i = 0;
-                for (i = 0; i <= max; i++) {
-                    if (!ahci_port_cmd_busy(port, i)) break;
-                }
-                if (i > max) {
-                    break;
-                }
-
-                list_delete(&txn->node);
-
-                if (BLOCK_OP(txn->bop.command) == BLOCK_OP_FLUSH) {
-                    if (port->running) {
-                        ZX_DEBUG_ASSERT(port->sync == NULL);
-                        // pause the port if FLUSH command
-                        port->flags |= AHCI_PORT_FLAG_SYNC_PAUSED;
-                        port->sync = txn;
-                    } else {
-                        // complete immediately if nothing in flight
-                        mtx_unlock(&port->lock);
-                        block_complete(txn, ZX_OK);
-                        mtx_lock(&port->lock);
-                    }
-                } else {
-                    // run the transaction
-                    zx_status_t st = ahci_do_txn(dev, port, i, txn);
-                    // complete the transaction with if it failed during processing
-                    if (st != ZX_OK) {
-                        mtx_unlock(&port->lock);
-                        block_complete(txn, st);
-                        mtx_lock(&port->lock);
-                        continue;
-                    }
-                }
+            if (ahci_port_valid(dev, i)) {
+                ahci_port_process_locked(dev, port);
             }
-next:
             mtx_unlock(&port->lock);
         }
-        // wait here until more commands are queued, or a port becomes idle
+        // wait here until more commands are queued
         sync_completion_wait(&dev->worker_completion, ZX_TIME_INFINITE);
         sync_completion_reset(&dev->worker_completion);
     }
@@ -622,7 +635,7 @@ static int ahci_watchdog_thread(void* arg) {
             }
 
             mtx_lock(&port->lock);
-            uint32_t pending = port->running & ~port->completed;
+            uint32_t pending = port->running;
             while (pending) {
                 idle = false;
                 unsigned slot = 32 - __builtin_clz(pending) - 1;
@@ -631,13 +644,11 @@ static int ahci_watchdog_thread(void* arg) {
                     zxlogf(ERROR, "ahci: command %u pending but txn is NULL\n", slot);
                 } else {
                     if (txn->timeout < now) {
-                        // time out
+                        // time out, taking the rest of the queue with it
                         zxlogf(ERROR, "ahci: txn time out on port %d txn %p\n", port->nr, txn);
-                        port->running &= ~(1 << slot);
-                        port->commands[slot] = NULL;
-                        mtx_unlock(&port->lock);
-                        block_complete(txn, ZX_ERR_TIMED_OUT);
-                        mtx_lock(&port->lock);
+                        ahci_port_recover_locked(port, ZX_ERR_TIMED_OUT);
+                        ahci_port_process_locked(dev, port);
+                        break;
                     }
                 }
                 pending &= ~(1 << slot);
@@ -656,6 +667,10 @@ static int ahci_watchdog_thread(void* arg) {
 
 static void ahci_port_irq(ahci_device_t* dev, int nr) {
     ahci_port_t* port = &dev->ports[nr];
+    if (!(port->flags & AHCI_PORT_FLAG_IMPLEMENTED)) {
+        return;
+    }
+
     // clear interrupt
     uint32_t is = ahci_read(&port->regs->is);
     ahci_write(&port->regs->is, is);
@@ -664,12 +679,21 @@ static void ahci_port_irq(ahci_device_t* dev, int nr) {
         uint32_t serr = ahci_read(&port->regs->serr);
         ahci_write(&port->regs->serr, serr & ~0x1);
     }
+
+    mtx_lock(&port->lock);
     if (is & AHCI_PORT_INT_ERROR) { // error
         zxlogf(ERROR, "ahci.%d: error is=0x%08x\n", nr, is);
-        ahci_port_complete_txn(dev, port, ZX_ERR_INTERNAL);
+        ahci_port_recover_locked(port, ZX_ERR_IO);
     } else if (is) {
-        ahci_port_complete_txn(dev, port, ZX_OK);
+        // queued commands are done once cleared from sact, and others once cleared from ci
+        uint32_t active = ahci_read(&port->regs->sact) | ahci_read(&port->regs->ci);
+        ahci_port_complete_locked(port, port->running & ~active, ZX_OK);
     }
+    // refill the freed command slots without waiting for the worker thread
+    if (ahci_port_valid(dev, nr)) {
+        ahci_port_process_locked(dev, port);
+    }
+    mtx_unlock(&port->lock);
 }
 
 static int ahci_irq_thread(void* arg) {
@@ -685,14 +709,15 @@ static int ahci_irq_thread(void* arg) {
         uint32_t ghc = ahci_read(&dev->regs->ghc);
         ahci_write(&dev->regs->ghc, ghc & ~AHCI_GHC_IE);
 
-        // handle interrupt for each port
-        uint32_t is = ahci_read(&dev->regs->is);
-        ahci_write(&dev->regs->is, is);
-        for (int i = 0; is && i < AHCI_MAX_PORTS; i++) {
-            if (is & 0x1) {
-                ahci_port_irq(dev, i);
+        // handle interrupt for each port, until none are pending, so that completions which
+        // arrive meanwhile are handled without taking another interrupt
+        uint32_t is;
+        while ((is = ahci_read(&dev->regs->is)) != 0) {
+            for (uint32_t pending = is; pending; pending &= pending - 1) {
+                ahci_port_irq(dev, __builtin_ctz(pending));
             }
-            is >>= 1;
+            // the hba status reflects the port status, so it is cleared after it
+            ahci_write(&dev->regs->is, is);
         }
 
         // unmask hba interrupts
@@ -141,7 +141,14 @@ static zx_status_t sata_device_identify(sata_device_t* dev, ahci_device_t* contr
     } else {
         zxlogf(INFO, " PIO");
     }
-    dev->max_cmd = *(devinfo + SATA_DEVINFO_QUEUE_DEPTH);
+    // only queued commands may be outstanding together
+    bool ncq = *(devinfo + SATA_DEVINFO_SATA_CAP) & SATA_CAP_NCQ;
+    if (ncq) {
+        zxlogf(INFO, " NCQ");
+        dev->max_cmd = *(devinfo + SATA_DEVINFO_QUEUE_DEPTH) & SATA_QUEUE_DEPTH_MASK;
+    } else {
+        dev->max_cmd = 0;
+    }
     zxlogf(INFO, " %d commands\n", dev->max_cmd + 1);
 
     uint32_t block_size = 512; // default
@@ -177,6 +184,7 @@ static zx_status_t sata_device_identify(sata_device_t* dev, ahci_device_t* contr
     // set devinfo on controller
     di.block_size = block_size,
     di.max_cmd = dev->max_cmd,
+    di.ncq = ncq,
 
     ahci_set_devinfo(controller, dev->port, &di);
 
@@ -29,6 +29,12 @@
 #define SATA_DEVINFO_SECTOR_SIZE         106
 #define SATA_DEVINFO_LOGICAL_SECTOR_SIZE 117
 
+// SATA_DEVINFO_SATA_CAP
+#define SATA_CAP_NCQ (1 << 8)
+
+// SATA_DEVINFO_QUEUE_DEPTH
+#define SATA_QUEUE_DEPTH_MASK 0x1f
+
 #define SATA_DEVINFO_SERIAL_LEN   20
 #define SATA_DEVINFO_FW_REV_LEN   8
 #define SATA_DEVINFO_MODEL_ID_LEN 40
@@ -56,7 +62,8 @@ typedef struct ahci_device ahci_device_t;
 
 typedef struct sata_devinfo {
     uint32_t block_size;
-    int max_cmd;
+    int max_cmd; // inclusive
+    bool ncq;    // device supports native command queuing
 } sata_devinfo_t;
 
 zx_status_t sata_bind(ahci_device_t* controller, zx_device_t* parent, int port);
@@ -10,6 +10,7 @@
 #include <assert.h>
 #include <inttypes.h>
 #include <limits.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -22,12 +23,21 @@
 #include <zircon/process.h>
 #include <zircon/types.h>
 
+#include "proxy.h"
 #include "server.h"
 
 #define max(a, b) ((a) < (b) ? (b) : (a))
 #define min(a, b) ((a) < (b) ? (a) : (b))
 
-typedef struct blkdev {
+typedef struct blkdev blkdev_t;
+
+// A block server added with IOCTL_BLOCK_ADD_FIFO.
+typedef struct {
+    blkdev_t* bdev;
+    BlockServer* bs;
+} blkdev_session_t;
+
+struct blkdev {
     zx_device_t* zxdev;
     zx_device_t* parent;
 
@@ -48,6 +58,14 @@ typedef struct blkdev {
     BlockServer* bs;
     bool dead; // Release has been called; we should free memory and leave.
 
+    // Further block servers sharing the VMOs attached to |bs|.
+    blkdev_session_t sessions[BLOCK_FIFO_MAX_SESSIONS - 1];
+    sync_completion_t session_signal;
+
+    // The block server of our proxy, when our children are isolated.
+    BlockServer* proxy_bs;
+    sync_completion_t proxy_signal;
+
     // true if we have metadata for a ZBI partition map
     bool has_bootpart;
 
@@ -59,25 +77,50 @@ typedef struct blkdev {
 
     bool enable_stats;
     block_stats_t stats;
-} blkdev_t;
+};
+
+static bool getenv_bool(const char* name, bool default_value) {
+    const char* value = getenv(name);
+    if (value == NULL) {
+        return default_value;
+    } else if (!strcmp(value, "0") || !strcmp(value, "false") || !strcmp(value, "off")) {
+        return false;
+    } else {
+        return true;
+    }
+}
+
+// Unless block.coalesce is turned off, the block servers merge contiguous
+// requests within a transaction group.
+static bool coalesce_requests(void) {
+    return getenv_bool("block.coalesce", true);
+}
+
+// With block.isolate set, the drivers that bind to block devices run in
+// devhosts of their own, behind block.proxy.so.
+static bool isolate_children(void) {
+    return getenv_bool("block.isolate", false);
+}
 
-static int blockserver_thread_serve(blkdev_t* bdev) {
+// Serves the block server in |*slot| until it shuts down, then frees it.
+static int blockserver_thread_serve(blkdev_t* bdev, BlockServer** slot,
+                                    sync_completion_t* started) {
     mtx_lock(&bdev->lock);
     // Signal when the blockserver_thread has successfully acquired the lock.
-    sync_completion_signal(&bdev->lock_signal);
+    sync_completion_signal(started);
 
-    BlockServer* bs = bdev->bs;
+    BlockServer* bs = *slot;
     if (!bdev->dead && (bs != NULL)) {
         mtx_unlock(&bdev->lock);
         blockserver_serve(bs);
         mtx_lock(&bdev->lock);
     }
 
-    if (bdev->bs == bs) {
+    if (*slot == bs) {
         // Only nullify 'bs' if no one has replaced it yet. This is the
         // case when the blockserver shuts itself down because the fifo
         // has closed.
-        bdev->bs = NULL;
+        *slot = NULL;
     }
     bdev->threadcount--;
     bool cleanup = bdev->dead && (bdev->threadcount == 0);
@@ -95,7 +138,19 @@ static int blockserver_thread_serve(blkdev_t* bdev) {
 }
 
 static int blockserver_thread(void* arg) {
-    return blockserver_thread_serve((blkdev_t*)arg);
+    blkdev_t* bdev = arg;
+    return blockserver_thread_serve(bdev, &bdev->bs, &bdev->lock_signal);
+}
+
+static int session_server_thread(void* arg) {
+    blkdev_session_t* session = arg;
+    blkdev_t* bdev = session->bdev;
+    return blockserver_thread_serve(bdev, &session->bs, &bdev->session_signal);
+}
+
+static int proxy_server_thread(void* arg) {
+    blkdev_t* bdev = arg;
+    return blockserver_thread_serve(bdev, &bdev->proxy_bs, &bdev->proxy_signal);
 }
 
 static zx_status_t blkdev_get_fifos(blkdev_t* bdev, void* out_buf, size_t out_len,
@@ -111,7 +166,8 @@ static zx_status_t blkdev_get_fifos(blkdev_t* bdev, void* out_buf, size_t out_le
     }
 
     BlockServer* bs;
-    if ((status = blockserver_create(&bdev->self_protocol, out_buf, &bs)) != ZX_OK) {
+    if ((status = blockserver_create(&bdev->self_protocol, coalesce_requests(), out_buf,
+                                     &bs)) != ZX_OK) {
         goto unlock_exit;
     }
     bdev->bs = bs;
@@ -170,7 +226,85 @@ done:
     return status;
 }
 
+static zx_status_t blkdev_attach_completion_ring(blkdev_t* bdev, const void* in_buf,
+                                                size_t in_len) {
+    if (in_len < sizeof(zx_handle_t)) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+
+    zx_status_t status;
+    zx_handle_t h = *(zx_handle_t*)in_buf;
+    mtx_lock(&bdev->lock);
+    if (bdev->bs == NULL) {
+        zx_handle_close(h);
+        status = ZX_ERR_BAD_STATE;
+    } else {
+        status = blockserver_attach_completion_ring(bdev->bs, h);
+    }
+    mtx_unlock(&bdev->lock);
+    return status;
+}
+
+static zx_status_t blkdev_add_fifo(blkdev_t* bdev, void* out_buf, size_t out_len,
+                                   size_t* out_actual) {
+    if (out_len < sizeof(zx_handle_t)) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+    mtx_lock(&bdev->lock);
+    if (bdev->bs == NULL) {
+        mtx_unlock(&bdev->lock);
+        return ZX_ERR_BAD_STATE;
+    }
+    blkdev_session_t* session = NULL;
+    for (size_t i = 0; i < countof(bdev->sessions); i++) {
+        if (bdev->sessions[i].bs == NULL) {
+            session = &bdev->sessions[i];
+            break;
+        }
+    }
+    if (session == NULL) {
+        mtx_unlock(&bdev->lock);
+        return ZX_ERR_NO_RESOURCES;
+    }
+
+    BlockServer* bs;
+    zx_status_t status;
+    if ((status = blockserver_create_session(bdev->bs, out_buf, &bs)) != ZX_OK) {
+        mtx_unlock(&bdev->lock);
+        return status;
+    }
+    session->bdev = bdev;
+    session->bs = bs;
+    bdev->threadcount++;
+    mtx_unlock(&bdev->lock);
+
+    sync_completion_reset(&bdev->session_signal);
+
+    thrd_t thread;
+    if (thrd_create(&thread, session_server_thread, session) == thrd_success) {
+        thrd_detach(thread);
+        sync_completion_wait(&bdev->session_signal, ZX_TIME_INFINITE);
+        *out_actual = sizeof(zx_handle_t);
+        return ZX_OK;
+    }
+
+    mtx_lock(&bdev->lock);
+    bdev->threadcount--;
+    session->bs = NULL;
+    mtx_unlock(&bdev->lock);
+
+    blockserver_free(bs);
+    zx_handle_close(*(zx_handle_t*)out_buf);
+    return ZX_ERR_NO_MEMORY;
+}
+
 static zx_status_t blkdev_fifo_close_locked(blkdev_t* bdev) {
+    for (size_t i = 0; i < countof(bdev->sessions); i++) {
+        if (bdev->sessions[i].bs != NULL) {
+            blockserver_shutdown(bdev->sessions[i].bs);
+            bdev->sessions[i].bs = NULL;
+        }
+    }
     if (bdev->bs != NULL) {
         blockserver_shutdown(bdev->bs);
         // Ensure that the next thread to call "get_fifos" will
@@ -180,6 +314,44 @@ static zx_status_t blkdev_fifo_close_locked(blkdev_t* bdev) {
     return ZX_OK;
 }
 
+// Start the block server for our proxy, replacing any earlier one.
+static zx_status_t proxy_get_fifo(blkdev_t* bdev, zx_handle_t* fifo_out) {
+    mtx_lock(&bdev->lock);
+    if (bdev->proxy_bs != NULL) {
+        blockserver_shutdown(bdev->proxy_bs);
+        bdev->proxy_bs = NULL;
+    }
+
+    BlockServer* bs;
+    zx_status_t status;
+    if ((status = blockserver_create(&bdev->self_protocol, coalesce_requests(), fifo_out,
+                                     &bs)) != ZX_OK) {
+        mtx_unlock(&bdev->lock);
+        return status;
+    }
+    bdev->proxy_bs = bs;
+    bdev->threadcount++;
+    mtx_unlock(&bdev->lock);
+
+    sync_completion_reset(&bdev->proxy_signal);
+
+    thrd_t thread;
+    if (thrd_create(&thread, proxy_server_thread, bdev) == thrd_success) {
+        thrd_detach(thread);
+        sync_completion_wait(&bdev->proxy_signal, ZX_TIME_INFINITE);
+        return ZX_OK;
+    }
+
+    mtx_lock(&bdev->lock);
+    bdev->threadcount--;
+    bdev->proxy_bs = NULL;
+    mtx_unlock(&bdev->lock);
+
+    blockserver_free(bs);
+    zx_handle_close(*fifo_out);
+    return ZX_ERR_NO_MEMORY;
+}
+
 static zx_status_t blkdev_rebind(blkdev_t* bdev) {
     // remove our existing children, ask to bind new children
     return device_rebind(bdev->zxdev);
@@ -193,6 +365,10 @@ static zx_status_t blkdev_ioctl(void* ctx, uint32_t op, const void* cmd,
         return blkdev_get_fifos(blkdev, reply, max, out_actual);
     case IOCTL_BLOCK_ATTACH_VMO:
         return blkdev_attach_vmo(blkdev, cmd, cmdlen, reply, max, out_actual);
+    case IOCTL_BLOCK_ADD_FIFO:
+        return blkdev_add_fifo(blkdev, reply, max, out_actual);
+    case IOCTL_BLOCK_ATTACH_COMPLETION_RING:
+        return blkdev_attach_completion_ring(blkdev, cmd, cmdlen);
     case IOCTL_BLOCK_FIFO_CLOSE: {
         mtx_lock(&blkdev->lock);
         zx_status_t status = blkdev_fifo_close_locked(blkdev);
@@ -229,6 +405,97 @@ static zx_status_t blkdev_ioctl(void* ctx, uint32_t op, const void* cmd,
     }
 }
 
+// Serve requests from block.proxy.so, when our children are isolated.
+static zx_status_t blkdev_rxrpc(void* ctx, zx_handle_t ch) {
+    if (ch == ZX_HANDLE_INVALID) {
+        // new proxy connection
+        return ZX_OK;
+    }
+
+    blkdev_t* bdev = ctx;
+    block_proxy_req_t req;
+    zx_handle_t handle = ZX_HANDLE_INVALID;
+    uint32_t actual_bytes, actual_handles;
+    zx_status_t status = zx_channel_read(ch, 0, &req, &handle, sizeof(req), 1,
+                                         &actual_bytes, &actual_handles);
+    if (status != ZX_OK) {
+        printf("block: device '%s': error reading proxy request: %d\n",
+               device_get_name(bdev->zxdev), status);
+        return status;
+    }
+    if ((actual_bytes < offsetof(block_proxy_req_t, data)) ||
+        (req.datalen > actual_bytes - offsetof(block_proxy_req_t, data))) {
+        zx_handle_close(handle);
+        return ZX_ERR_INTERNAL;
+    }
+
+    block_proxy_rsp_t rsp;
+    memset(&rsp, 0, offsetof(block_proxy_rsp_t, data));
+    rsp.txid = req.txid;
+    zx_handle_t out_handle = ZX_HANDLE_INVALID;
+
+    switch (req.op) {
+    case BLOCK_PROXY_OP_QUERY:
+        rsp.info = bdev->info;
+        if (bdev->has_bootpart) {
+            rsp.info.flags |= BLOCK_FLAG_BOOTPART;
+        } else {
+            rsp.info.flags &= ~BLOCK_FLAG_BOOTPART;
+        }
+        rsp.status = ZX_OK;
+        break;
+    case BLOCK_PROXY_OP_GET_FIFO:
+        rsp.status = proxy_get_fifo(bdev, &out_handle);
+        break;
+    case BLOCK_PROXY_OP_ATTACH_VMO:
+        if (handle == ZX_HANDLE_INVALID) {
+            rsp.status = ZX_ERR_INVALID_ARGS;
+            break;
+        }
+        mtx_lock(&bdev->lock);
+        if (bdev->proxy_bs == NULL) {
+            rsp.status = ZX_ERR_BAD_STATE;
+        } else {
+            // This takes the handle, even if it fails.
+            rsp.status = blockserver_attach_vmo(bdev->proxy_bs, handle, &rsp.vmoid);
+            handle = ZX_HANDLE_INVALID;
+        }
+        mtx_unlock(&bdev->lock);
+        break;
+    case BLOCK_PROXY_OP_DETACH_VMO:
+        mtx_lock(&bdev->lock);
+        if (bdev->proxy_bs == NULL) {
+            rsp.status = ZX_ERR_BAD_STATE;
+        } else {
+            rsp.status = blockserver_detach_vmo(bdev->proxy_bs, req.vmoid);
+        }
+        mtx_unlock(&bdev->lock);
+        break;
+    case BLOCK_PROXY_OP_IOCTL: {
+        // Only ioctls that pass no handles make it through.
+        if ((IOCTL_KIND(req.ioctl) != IOCTL_KIND_DEFAULT) ||
+            (req.reply_size > sizeof(rsp.data))) {
+            rsp.status = ZX_ERR_NOT_SUPPORTED;
+            break;
+        }
+        size_t actual = 0;
+        rsp.status = blkdev_ioctl(bdev, req.ioctl, req.data, req.datalen,
+                                  rsp.data, req.reply_size, &actual);
+        if (rsp.status == ZX_OK) {
+            rsp.datalen = (uint32_t)actual;
+        }
+        break;
+    }
+    default:
+        rsp.status = ZX_ERR_NOT_SUPPORTED;
+        break;
+    }
+    zx_handle_close(handle);
+
+    return zx_channel_write(ch, 0, &rsp, offsetof(block_proxy_rsp_t, data) + rsp.datalen,
+                            &out_handle, out_handle == ZX_HANDLE_INVALID ? 0 : 1);
+}
+
 static void block_completion_cb(void* cookie, zx_status_t status, block_op_t* bop) {
     blkdev_t* bdev = cookie;
     bdev->iostatus = status;
@@ -342,6 +609,10 @@ static void blkdev_release(void* ctx) {
     mtx_lock(&blkdev->lock);
     bool bg_thread_running = (blkdev->threadcount != 0);
     blkdev_fifo_close_locked(blkdev);
+    if (blkdev->proxy_bs != NULL) {
+        blockserver_shutdown(blkdev->proxy_bs);
+        blkdev->proxy_bs = NULL;
+    }
     blkdev->dead = true;
     mtx_unlock(&blkdev->lock);
 
@@ -428,8 +699,10 @@ static zx_protocol_device_t blkdev_ops = {
     .get_size = blkdev_get_size,
     .unbind = blkdev_unbind,
     .release = blkdev_release,
+    .rxrpc = blkdev_rxrpc,
 };
 
+
 static zx_status_t block_driver_bind(void* ctx, zx_device_t* dev) {
     blkdev_t* bdev;
     if ((bdev = calloc(1, sizeof(blkdev_t))) == NULL) {
@@ -490,6 +763,10 @@ static zx_status_t block_driver_bind(void* ctx, zx_device_t* dev) {
         .proto_id = ZX_PROTOCOL_BLOCK,
         .proto_ops = &block_ops,
     };
+    if (isolate_children()) {
+        args.flags = DEVICE_ADD_MUST_ISOLATE;
+        args.proxy_args = "block,";
+    }
 
     status = device_add(dev, &args, &bdev->zxdev);
     if (status != ZX_OK) {
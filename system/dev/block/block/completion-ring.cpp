@@ -0,0 +1,60 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <fbl/auto_lock.h>
+#include <zircon/syscalls.h>
+
+#include "completion-ring.h"
+
+CompletionRing::CompletionRing() :
+    fifo_(ZX_HANDLE_INVALID), ring_(nullptr), head_(0) {}
+
+CompletionRing::~CompletionRing() {}
+
+void CompletionRing::Initialize(zx_handle_t fifo) {
+    ZX_DEBUG_ASSERT(fifo_ == ZX_HANDLE_INVALID);
+    fifo_ = fifo;
+}
+
+zx_status_t CompletionRing::Attach(zx::vmo vmo) {
+    fbl::AutoLock lock(&lock_);
+    if (ring_ != nullptr) {
+        return ZX_ERR_ALREADY_BOUND;
+    }
+    uint64_t size;
+    zx_status_t status;
+    if ((status = vmo.get_size(&size)) != ZX_OK) {
+        return status;
+    } else if (size < sizeof(block_completion_ring_t)) {
+        return ZX_ERR_BUFFER_TOO_SMALL;
+    }
+    // TODO(ZX-1586): As with IoBuffer::ValidateVmoHack, nothing keeps the
+    // client from shrinking the VMO underneath the mapping.
+    if ((status = mapping_.Map(vmo, 0, sizeof(block_completion_ring_t),
+                               ZX_VM_PERM_READ | ZX_VM_PERM_WRITE)) != ZX_OK) {
+        return status;
+    }
+    ring_ = static_cast<block_completion_ring_t*>(mapping_.start());
+    head_ = __atomic_load_n(&ring_->head, __ATOMIC_ACQUIRE);
+    return ZX_OK;
+}
+
+bool CompletionRing::Post(const block_fifo_response_t& response) {
+    fbl::AutoLock lock(&lock_);
+    if (ring_ == nullptr) {
+        return false;
+    }
+    uint64_t tail = __atomic_load_n(&ring_->tail, __ATOMIC_ACQUIRE);
+    if (head_ - tail >= BLOCK_COMPLETION_RING_SIZE) {
+        // Full, or the client has lost track of the ring.
+        return false;
+    }
+    ring_->responses[head_ % BLOCK_COMPLETION_RING_SIZE] = response;
+    head_++;
+    __atomic_store_n(&ring_->head, head_, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&ring_->waiting, __ATOMIC_SEQ_CST)) {
+        zx_object_signal_peer(fifo_, 0, BLOCK_COMPLETION_RING_SIGNAL);
+    }
+    return true;
+}
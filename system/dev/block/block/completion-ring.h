@@ -0,0 +1,46 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <zircon/device/block.h>
+#include <zircon/thread_annotations.h>
+#include <zircon/types.h>
+
+#include <fbl/macros.h>
+#include <fbl/mutex.h>
+#include <lib/fzl/vmo-mapper.h>
+#include <lib/zx/vmo.h>
+
+// The server side of a block_completion_ring_t, shared by the transaction
+// groups of a BlockServer.
+class CompletionRing {
+public:
+    CompletionRing();
+    ~CompletionRing();
+
+    // Initialize must be called before utilizing other functions in
+    // CompletionRing. Initialize should only be called once.
+    void Initialize(zx_handle_t fifo) TA_NO_THREAD_SAFETY_ANALYSIS;
+
+    // Maps the ring the client shares with us. Only one ring may be
+    // attached.
+    zx_status_t Attach(zx::vmo vmo) TA_EXCL(lock_);
+
+    // Posts |response| to the ring, waking the client if it waits for one.
+    // Returns false if the response should go on the fifo instead.
+    bool Post(const block_fifo_response_t& response) TA_EXCL(lock_);
+
+private:
+    DISALLOW_COPY_ASSIGN_AND_MOVE(CompletionRing);
+
+    // Should only be set once.
+    zx_handle_t fifo_;
+
+    fbl::Mutex lock_;
+    fzl::VmoMapper mapping_ TA_GUARDED(lock_);
+    block_completion_ring_t* ring_ TA_GUARDED(lock_);
+    // Our own copy of ring_->head, which the client may scribble over.
+    uint64_t head_ TA_GUARDED(lock_);
+};
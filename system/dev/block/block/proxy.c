@@ -0,0 +1,508 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <ddk/binding.h>
+#include <ddk/debug.h>
+#include <ddk/device.h>
+#include <ddk/driver.h>
+#include <ddk/protocol/block.h>
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+
+#include <zircon/compiler.h>
+#include <zircon/device/block.h>
+#include <zircon/listnode.h>
+#include <zircon/syscalls.h>
+#include <zircon/syscalls/object.h>
+#include <zircon/types.h>
+
+#include "proxy.h"
+
+// The block device as seen from an isolated devhost. Block ops are carried to
+// the block device's devhost over a block FIFO, with the VMOs they name
+// attached to the block server at the other end the first time they are seen.
+
+// How many VMOs are kept attached at once.
+#define VMO_CACHE_SIZE 32
+
+// Raised on our end of the FIFO to stop the response thread.
+#define SIGNAL_SHUTDOWN ZX_USER_SIGNAL_0
+
+typedef struct {
+    zx_koid_t koid;
+    vmoid_t vmoid;
+    // for picking the least recently used entry
+    uint64_t last_use;
+} cached_vmo_t;
+
+typedef struct {
+    block_op_t op;
+    list_node_t node;
+    block_impl_queue_callback completion_cb;
+    void* cookie;
+    vmoid_t vmoid;
+} proxy_txn_t;
+
+typedef struct {
+    zx_device_t* zxdev;
+    zx_handle_t rpcch;
+    zx_handle_t fifo;
+    block_info_t info;
+
+    thrd_t thread;
+    bool thread_started;
+
+    mtx_t lock;
+    // ops waiting for a free request slot
+    list_node_t pending;
+    // ops in flight, by reqid
+    proxy_txn_t* inflight[BLOCK_FIFO_MAX_DEPTH];
+    size_t inflight_count;
+    bool dead;
+
+    // Guards the VMO cache. Attaching a VMO is a round trip to the other end,
+    // so this is held over RPCs, which |lock| never is, lest completions wait
+    // behind them. Taken before |lock|.
+    mtx_t vmo_lock;
+    cached_vmo_t vmos[VMO_CACHE_SIZE];
+    uint64_t vmo_clock;
+
+    zx_txid_t next_txid;
+} block_proxy_t;
+
+static zx_status_t block_rpc(block_proxy_t* proxy, block_proxy_req_t* req, size_t reqlen,
+                             zx_handle_t handle, block_proxy_rsp_t* rsp,
+                             zx_handle_t* handle_out) {
+    uint32_t handle_cnt = 0;
+    if (handle_out) {
+        *handle_out = ZX_HANDLE_INVALID;
+        handle_cnt = 1;
+    }
+
+    req->txid = __atomic_add_fetch(&proxy->next_txid, 1, __ATOMIC_RELAXED);
+    zx_channel_call_args_t cc_args = {
+        .wr_bytes = req,
+        .wr_handles = &handle,
+        .rd_bytes = rsp,
+        .rd_handles = handle_out,
+        .wr_num_bytes = (uint32_t)reqlen,
+        .wr_num_handles = handle == ZX_HANDLE_INVALID ? 0 : 1,
+        .rd_num_bytes = sizeof(*rsp),
+        .rd_num_handles = handle_cnt,
+    };
+
+    uint32_t actual_bytes;
+    uint32_t actual_handles;
+    zx_status_t status = zx_channel_call(proxy->rpcch, 0, ZX_TIME_INFINITE,
+                                         &cc_args, &actual_bytes, &actual_handles);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    if ((actual_bytes < offsetof(block_proxy_rsp_t, data)) ||
+        (rsp->datalen > actual_bytes - offsetof(block_proxy_rsp_t, data))) {
+        if (handle_out) {
+            zx_handle_close(*handle_out);
+            *handle_out = ZX_HANDLE_INVALID;
+        }
+        return ZX_ERR_INTERNAL;
+    }
+    return rsp->status;
+}
+
+// Find the vmoid of |vmo| at the other end, attaching it if need be. Called
+// with |vmo_lock| held.
+static zx_status_t proxy_get_vmoid_locked(block_proxy_t* proxy, zx_handle_t vmo,
+                                          vmoid_t* vmoid_out) {
+    zx_info_handle_basic_t info;
+    zx_status_t status = zx_object_get_info(vmo, ZX_INFO_HANDLE_BASIC, &info, sizeof(info),
+                                            NULL, NULL);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    cached_vmo_t* victim = &proxy->vmos[0];
+    for (size_t i = 0; i < VMO_CACHE_SIZE; i++) {
+        cached_vmo_t* entry = &proxy->vmos[i];
+        if (entry->vmoid != VMOID_INVALID && entry->koid == info.koid) {
+            entry->last_use = ++proxy->vmo_clock;
+            *vmoid_out = entry->vmoid;
+            return ZX_OK;
+        }
+        if (victim->vmoid != VMOID_INVALID &&
+            (entry->vmoid == VMOID_INVALID || entry->last_use < victim->last_use)) {
+            victim = entry;
+        }
+    }
+
+    block_proxy_req_t req;
+    block_proxy_rsp_t rsp;
+    if (victim->vmoid != VMOID_INVALID) {
+        // Ops still in flight on the evicted VMO keep it alive at the other end.
+        req.op = BLOCK_PROXY_OP_DETACH_VMO;
+        req.vmoid = victim->vmoid;
+        req.datalen = 0;
+        victim->vmoid = VMOID_INVALID;
+        block_rpc(proxy, &req, offsetof(block_proxy_req_t, data), ZX_HANDLE_INVALID,
+                  &rsp, NULL);
+    }
+
+    zx_handle_t dup;
+    if ((status = zx_handle_duplicate(vmo, ZX_RIGHT_SAME_RIGHTS, &dup)) != ZX_OK) {
+        return status;
+    }
+    req.op = BLOCK_PROXY_OP_ATTACH_VMO;
+    req.datalen = 0;
+    status = block_rpc(proxy, &req, offsetof(block_proxy_req_t, data), dup, &rsp, NULL);
+    if (status != ZX_OK) {
+        return status;
+    }
+    victim->koid = info.koid;
+    victim->vmoid = rsp.vmoid;
+    victim->last_use = ++proxy->vmo_clock;
+    *vmoid_out = rsp.vmoid;
+    return ZX_OK;
+}
+
+// Send |txn| over the FIFO, or fail it. Returns false if there's no room.
+static bool proxy_submit_locked(block_proxy_t* proxy, proxy_txn_t* txn, zx_status_t* status) {
+    if (proxy->inflight_count == BLOCK_FIFO_MAX_DEPTH) {
+        return false;
+    }
+    reqid_t reqid = 0;
+    while (proxy->inflight[reqid] != NULL) {
+        reqid++;
+    }
+
+    block_fifo_request_t request;
+    memset(&request, 0, sizeof(request));
+    request.reqid = reqid;
+    uint32_t command = txn->op.command & BLOCK_OP_MASK;
+    request.opcode = txn->op.command & (BLOCKIO_BARRIER_BEFORE | BLOCKIO_BARRIER_AFTER);
+    if (command == BLOCK_OP_FLUSH) {
+        request.opcode |= BLOCKIO_FLUSH;
+    } else {
+        request.opcode |= (command == BLOCK_OP_READ) ? BLOCKIO_READ : BLOCKIO_WRITE;
+        request.vmoid = txn->vmoid;
+        request.length = txn->op.rw.length;
+        request.vmo_offset = txn->op.rw.offset_vmo;
+        request.dev_offset = txn->op.rw.offset_dev;
+    }
+
+    // There are never more requests in flight than the FIFO holds.
+    *status = zx_fifo_write(proxy->fifo, sizeof(request), &request, 1, NULL);
+    if (*status == ZX_OK) {
+        proxy->inflight[reqid] = txn;
+        proxy->inflight_count++;
+    }
+    return true;
+}
+
+static int proxy_response_thread(void* arg) {
+    block_proxy_t* proxy = arg;
+    block_fifo_response_t responses[BLOCK_FIFO_MAX_DEPTH];
+
+    for (;;) {
+        zx_signals_t pending;
+        zx_status_t status = zx_object_wait_one(proxy->fifo,
+                                                ZX_FIFO_READABLE | ZX_FIFO_PEER_CLOSED |
+                                                SIGNAL_SHUTDOWN,
+                                                ZX_TIME_INFINITE, &pending);
+        if (status != ZX_OK || (pending & SIGNAL_SHUTDOWN)) {
+            break;
+        }
+
+        size_t count = 0;
+        if (pending & ZX_FIFO_READABLE) {
+            status = zx_fifo_read(proxy->fifo, sizeof(responses[0]), responses,
+                                  countof(responses), &count);
+            if (status != ZX_OK && status != ZX_ERR_SHOULD_WAIT) {
+                break;
+            }
+        } else {
+            break;
+        }
+
+        list_node_t done = LIST_INITIAL_VALUE(done);
+        mtx_lock(&proxy->lock);
+        for (size_t i = 0; i < count; i++) {
+            reqid_t reqid = responses[i].reqid;
+            if (reqid >= BLOCK_FIFO_MAX_DEPTH || proxy->inflight[reqid] == NULL) {
+                zxlogf(ERROR, "block-proxy: response for unknown request %u\n", reqid);
+                continue;
+            }
+            proxy_txn_t* txn = proxy->inflight[reqid];
+            proxy->inflight[reqid] = NULL;
+            proxy->inflight_count--;
+            // Reuse |extra| to carry the status to the callback below.
+            txn->op.rw.extra = (uint32_t)responses[i].status;
+            list_add_tail(&done, &txn->node);
+        }
+        proxy_txn_t* txn;
+        while ((txn = list_peek_head_type(&proxy->pending, proxy_txn_t, node)) != NULL) {
+            zx_status_t submit_status;
+            if (!proxy_submit_locked(proxy, txn, &submit_status)) {
+                break;
+            }
+            list_delete(&txn->node);
+            if (submit_status != ZX_OK) {
+                txn->op.rw.extra = (uint32_t)submit_status;
+                list_add_tail(&done, &txn->node);
+            }
+        }
+        mtx_unlock(&proxy->lock);
+
+        while ((txn = list_remove_head_type(&done, proxy_txn_t, node)) != NULL) {
+            txn->completion_cb(txn->cookie, (zx_status_t)txn->op.rw.extra, &txn->op);
+        }
+    }
+
+    // The block device went away, or we did; fail everything still waiting.
+    list_node_t done = LIST_INITIAL_VALUE(done);
+    mtx_lock(&proxy->lock);
+    proxy->dead = true;
+    for (size_t i = 0; i < BLOCK_FIFO_MAX_DEPTH; i++) {
+        if (proxy->inflight[i] != NULL) {
+            list_add_tail(&done, &proxy->inflight[i]->node);
+            proxy->inflight[i] = NULL;
+        }
+    }
+    proxy->inflight_count = 0;
+    list_splice_after(&proxy->pending, &done);
+    mtx_unlock(&proxy->lock);
+
+    proxy_txn_t* txn;
+    while ((txn = list_remove_head_type(&done, proxy_txn_t, node)) != NULL) {
+        txn->completion_cb(txn->cookie, ZX_ERR_IO, &txn->op);
+    }
+    return 0;
+}
+
+static void proxy_query(void* ctx, block_info_t* info_out, size_t* block_op_size_out) {
+    block_proxy_t* proxy = ctx;
+    memcpy(info_out, &proxy->info, sizeof(*info_out));
+    *block_op_size_out = sizeof(proxy_txn_t);
+}
+
+static void proxy_queue(void* ctx, block_op_t* bop, block_impl_queue_callback completion_cb,
+                        void* cookie) {
+    block_proxy_t* proxy = ctx;
+    proxy_txn_t* txn = containerof(bop, proxy_txn_t, op);
+    txn->completion_cb = completion_cb;
+    txn->cookie = cookie;
+    txn->vmoid = VMOID_INVALID;
+
+    zx_status_t status;
+    switch (bop->command & BLOCK_OP_MASK) {
+    case BLOCK_OP_READ:
+    case BLOCK_OP_WRITE:
+    case BLOCK_OP_FLUSH:
+        break;
+    default:
+        completion_cb(cookie, ZX_ERR_NOT_SUPPORTED, bop);
+        return;
+    }
+
+    // The vmoid is looked up before taking |lock|. |vmo_lock| stays held
+    // until the op is queued, so that its vmoid isn't evicted before then.
+    bool has_vmo = (bop->command & BLOCK_OP_MASK) != BLOCK_OP_FLUSH;
+    if (has_vmo) {
+        mtx_lock(&proxy->vmo_lock);
+        if ((status = proxy_get_vmoid_locked(proxy, bop->rw.vmo, &txn->vmoid)) != ZX_OK) {
+            mtx_unlock(&proxy->vmo_lock);
+            completion_cb(cookie, status, bop);
+            return;
+        }
+    }
+
+    mtx_lock(&proxy->lock);
+    if (proxy->dead) {
+        status = ZX_ERR_IO;
+    } else if (!list_is_empty(&proxy->pending) ||
+               !proxy_submit_locked(proxy, txn, &status)) {
+        // Keep ops in order behind any that are already waiting.
+        list_add_tail(&proxy->pending, &txn->node);
+        status = ZX_OK;
+    }
+    mtx_unlock(&proxy->lock);
+    if (has_vmo) {
+        mtx_unlock(&proxy->vmo_lock);
+    }
+
+    if (status != ZX_OK) {
+        completion_cb(cookie, status, bop);
+    }
+}
+
+static zx_status_t proxy_ioctl_forward(block_proxy_t* proxy, uint32_t op, const void* cmd,
+                                       size_t cmdlen, void* reply, size_t max,
+                                       size_t* out_actual) {
+    // Only ioctls that pass no handles can be carried.
+    if (IOCTL_KIND(op) != IOCTL_KIND_DEFAULT) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+    if (cmdlen > BLOCK_PROXY_MAX_DATA) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+    if (max > BLOCK_PROXY_MAX_DATA) {
+        max = BLOCK_PROXY_MAX_DATA;
+    }
+
+    block_proxy_req_t req;
+    block_proxy_rsp_t rsp;
+    req.op = BLOCK_PROXY_OP_IOCTL;
+    req.ioctl = op;
+    req.reply_size = (uint32_t)max;
+    req.datalen = (uint32_t)cmdlen;
+    if (cmdlen > 0) {
+        memcpy(req.data, cmd, cmdlen);
+    }
+    zx_status_t status = block_rpc(proxy, &req, offsetof(block_proxy_req_t, data) + cmdlen,
+                                   ZX_HANDLE_INVALID, &rsp, NULL);
+    if (status != ZX_OK) {
+        return status;
+    }
+    if (rsp.datalen > max) {
+        return ZX_ERR_INTERNAL;
+    }
+    memcpy(reply, rsp.data, rsp.datalen);
+    if (out_actual) {
+        *out_actual = rsp.datalen;
+    }
+    return ZX_OK;
+}
+
+static zx_status_t proxy_get_stats(void* ctx, const void* cmd, size_t cmdlen,
+                                   void* reply, size_t max, size_t* out_actual) {
+    return proxy_ioctl_forward(ctx, IOCTL_BLOCK_GET_STATS, cmd, cmdlen, reply, max,
+                               out_actual);
+}
+
+static block_impl_protocol_ops_t block_ops = {
+    .query = proxy_query,
+    .queue = proxy_queue,
+    .get_stats = proxy_get_stats,
+};
+
+static zx_status_t proxy_ioctl(void* ctx, uint32_t op, const void* cmd, size_t cmdlen,
+                               void* reply, size_t max, size_t* out_actual) {
+    return proxy_ioctl_forward(ctx, op, cmd, cmdlen, reply, max, out_actual);
+}
+
+static zx_off_t proxy_get_size(void* ctx) {
+    block_proxy_t* proxy = ctx;
+    return proxy->info.block_count * proxy->info.block_size;
+}
+
+static void proxy_unbind(void* ctx) {
+    block_proxy_t* proxy = ctx;
+    device_remove(proxy->zxdev);
+}
+
+static void proxy_stop(block_proxy_t* proxy) {
+    if (proxy->thread_started) {
+        zx_object_signal(proxy->fifo, 0, SIGNAL_SHUTDOWN);
+        thrd_join(proxy->thread, NULL);
+    }
+    // Closing the FIFO ends the block server at the other end.
+    zx_handle_close(proxy->fifo);
+}
+
+static void proxy_release(void* ctx) {
+    block_proxy_t* proxy = ctx;
+    proxy_stop(proxy);
+    zx_handle_close(proxy->rpcch);
+    free(proxy);
+}
+
+static zx_protocol_device_t device_ops = {
+    .version = DEVICE_OPS_VERSION,
+    .ioctl = proxy_ioctl,
+    .get_size = proxy_get_size,
+    .unbind = proxy_unbind,
+    .release = proxy_release,
+};
+
+static zx_status_t block_proxy_create(void* ctx, zx_device_t* parent,
+                                      const char* name, const char* args,
+                                      zx_handle_t rpcch) {
+    if (!parent) {
+        return ZX_ERR_BAD_STATE;
+    }
+
+    block_proxy_t* proxy = calloc(1, sizeof(block_proxy_t));
+    if (!proxy) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    mtx_init(&proxy->lock, mtx_plain);
+    mtx_init(&proxy->vmo_lock, mtx_plain);
+    list_initialize(&proxy->pending);
+    proxy->rpcch = rpcch;
+    proxy->fifo = ZX_HANDLE_INVALID;
+
+    block_proxy_req_t req;
+    block_proxy_rsp_t rsp;
+    req.op = BLOCK_PROXY_OP_QUERY;
+    req.datalen = 0;
+    zx_status_t status = block_rpc(proxy, &req, offsetof(block_proxy_req_t, data),
+                                   ZX_HANDLE_INVALID, &rsp, NULL);
+    if (status != ZX_OK) {
+        goto fail;
+    }
+    proxy->info = rsp.info;
+
+    req.op = BLOCK_PROXY_OP_GET_FIFO;
+    status = block_rpc(proxy, &req, offsetof(block_proxy_req_t, data),
+                       ZX_HANDLE_INVALID, &rsp, &proxy->fifo);
+    if (status != ZX_OK) {
+        goto fail;
+    }
+    if (proxy->fifo == ZX_HANDLE_INVALID) {
+        status = ZX_ERR_INTERNAL;
+        goto fail;
+    }
+
+    if (thrd_create_with_name(&proxy->thread, proxy_response_thread, proxy,
+                              "block-proxy") != thrd_success) {
+        status = ZX_ERR_NO_MEMORY;
+        goto fail;
+    }
+    proxy->thread_started = true;
+
+    device_add_args_t device_args = {
+        .version = DEVICE_ADD_ARGS_VERSION,
+        .name = "block",
+        .ctx = proxy,
+        .ops = &device_ops,
+        .proto_id = ZX_PROTOCOL_BLOCK,
+        .proto_ops = &block_ops,
+    };
+
+    status = device_add(parent, &device_args, &proxy->zxdev);
+    if (status != ZX_OK) {
+        goto fail;
+    }
+    return ZX_OK;
+
+fail:
+    proxy_stop(proxy);
+    free(proxy);
+    return status;
+}
+
+static zx_driver_ops_t block_proxy_driver_ops = {
+    .version = DRIVER_OPS_VERSION,
+    .create = block_proxy_create,
+};
+
+// clang-format off
+ZIRCON_DRIVER_BEGIN(block_proxy, block_proxy_driver_ops, "zircon", "0.1", 1)
+    BI_ABORT_IF_AUTOBIND,
+ZIRCON_DRIVER_END(block_proxy)
+// clang-format on
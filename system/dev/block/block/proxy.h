@@ -0,0 +1,45 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <zircon/compiler.h>
+#include <zircon/device/block.h>
+#include <zircon/types.h>
+
+// When the block device is added with DEVICE_ADD_MUST_ISOLATE, the drivers
+// bound to it run in a devhost of their own, on top of block.proxy.so. The
+// proxy carries block ops over a block FIFO, served in the block device's
+// devhost by a block server of its own, against VMOs attached to that
+// server. The proxy rpc channel only carries these setup requests.
+
+#define BLOCK_PROXY_OP_QUERY      1  // -> info
+#define BLOCK_PROXY_OP_GET_FIFO   2  // -> fifo handle
+#define BLOCK_PROXY_OP_ATTACH_VMO 3  // vmo handle -> vmoid
+#define BLOCK_PROXY_OP_DETACH_VMO 4  // vmoid
+#define BLOCK_PROXY_OP_IOCTL      5  // ioctl, data -> data
+
+#define BLOCK_PROXY_MAX_DATA 1024
+
+typedef struct {
+    zx_txid_t txid;
+    uint32_t op;
+    vmoid_t vmoid;
+    uint32_t ioctl;
+    // size of the reply wanted for BLOCK_PROXY_OP_IOCTL
+    uint32_t reply_size;
+    uint32_t datalen;
+    uint8_t data[BLOCK_PROXY_MAX_DATA];
+} block_proxy_req_t;
+
+typedef struct {
+    zx_txid_t txid;
+    zx_status_t status;
+    vmoid_t vmoid;
+    block_info_t info;
+    uint32_t datalen;
+    uint8_t data[BLOCK_PROXY_MAX_DATA];
+} block_proxy_rsp_t;
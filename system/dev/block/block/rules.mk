@@ -10,6 +10,7 @@ MODULE_TYPE := driver
 
 MODULE_SRCS := \
     $(LOCAL_DIR)/block.c \
+    $(LOCAL_DIR)/completion-ring.cpp \
     $(LOCAL_DIR)/server.cpp \
     $(LOCAL_DIR)/txn-group.cpp \
 
@@ -24,3 +25,18 @@ MODULE_STATIC_LIBS := \
 MODULE_LIBS := system/ulib/c system/ulib/driver system/ulib/zircon
 
 include make/module.mk
+
+MODULE := $(LOCAL_DIR).proxy
+
+MODULE_TYPE := driver
+
+MODULE_NAME := block.proxy
+
+MODULE_SRCS := \
+    $(LOCAL_DIR)/proxy.c \
+
+MODULE_STATIC_LIBS := system/ulib/ddk
+
+MODULE_LIBS := system/ulib/c system/ulib/driver system/ulib/zircon
+
+include make/module.mk
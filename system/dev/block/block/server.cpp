@@ -59,7 +59,7 @@ void BlockComplete(BlockMsg* msg, zx_status_t status) {
     // Since iobuf is a RefPtr, it lives at least as long as the txn,
     // and is not discarded underneath the block device driver.
     extra->iobuf = nullptr;
-    extra->server->TxnComplete(status, extra->reqid, extra->group);
+    extra->server->TxnComplete(status, extra->reqid, extra->group, 1 + extra->merged);
     extra->server->TxnEnd();
 }
 
@@ -131,12 +131,14 @@ void BlockServer::TerminateQueue() {
         }
     }
 }
-void BlockServer::TxnComplete(zx_status_t status, reqid_t reqid, groupid_t group) {
+void BlockServer::TxnComplete(zx_status_t status, reqid_t reqid, groupid_t group,
+                              uint32_t count) {
     if (group == kNoGroup) {
+        ZX_DEBUG_ASSERT(count == 1);
         OutOfBandRespond(fifo_, status, reqid, group);
     } else {
         ZX_DEBUG_ASSERT(group < MAX_TXN_GROUP_COUNT);
-        groups_[group].Complete(status);
+        groups_[group].Complete(status, count);
     }
 }
 
@@ -181,17 +183,17 @@ zx_status_t BlockServer::Read(block_fifo_request_t* requests, size_t* count) {
 }
 
 zx_status_t BlockServer::FindVmoIDLocked(vmoid_t* out) {
-    for (vmoid_t i = last_id_; i < fbl::numeric_limits<vmoid_t>::max(); i++) {
-        if (!tree_.find(i).IsValid()) {
+    for (vmoid_t i = buffers_->last_id; i < fbl::numeric_limits<vmoid_t>::max(); i++) {
+        if (!buffers_->tree.find(i).IsValid()) {
             *out = i;
-            last_id_ = static_cast<vmoid_t>(i + 1);
+            buffers_->last_id = static_cast<vmoid_t>(i + 1);
             return ZX_OK;
         }
     }
-    for (vmoid_t i = VMOID_INVALID + 1; i < last_id_; i++) {
-        if (!tree_.find(i).IsValid()) {
+    for (vmoid_t i = VMOID_INVALID + 1; i < buffers_->last_id; i++) {
+        if (!buffers_->tree.find(i).IsValid()) {
             *out = i;
-            last_id_ = static_cast<vmoid_t>(i + 1);
+            buffers_->last_id = static_cast<vmoid_t>(i + 1);
             return ZX_OK;
         }
     }
@@ -201,7 +203,7 @@ zx_status_t BlockServer::FindVmoIDLocked(vmoid_t* out) {
 zx_status_t BlockServer::AttachVmo(zx::vmo vmo, vmoid_t* out) {
     zx_status_t status;
     vmoid_t id;
-    fbl::AutoLock server_lock(&server_lock_);
+    fbl::AutoLock server_lock(&buffers_->lock);
     if ((status = FindVmoIDLocked(&id)) != ZX_OK) {
         return status;
     }
@@ -211,11 +213,26 @@ zx_status_t BlockServer::AttachVmo(zx::vmo vmo, vmoid_t* out) {
     if (!ac.check()) {
         return ZX_ERR_NO_MEMORY;
     }
-    tree_.insert(fbl::move(ibuf));
+    buffers_->tree.insert(fbl::move(ibuf));
     *out = id;
     return ZX_OK;
 }
 
+zx_status_t BlockServer::DetachVmo(vmoid_t vmoid) {
+    fbl::AutoLock server_lock(&buffers_->lock);
+    auto iobuf = buffers_->tree.find(vmoid);
+    if (!iobuf.IsValid()) {
+        return ZX_ERR_NOT_FOUND;
+    }
+    // Transactions still using it hold their own reference.
+    buffers_->tree.erase(*iobuf);
+    return ZX_OK;
+}
+
+zx_status_t BlockServer::AttachCompletionRing(zx::vmo vmo) {
+    return ring_.Attach(fbl::move(vmo));
+}
+
 void BlockServer::TxnEnd() {
     size_t old_count = pending_count_.fetch_sub(1);
     ZX_ASSERT(old_count > 0);
@@ -263,13 +280,32 @@ void BlockServer::InQueueDrainer() {
     }
 }
 
-zx_status_t BlockServer::Create(block_impl_protocol_t* bp, fzl::fifo<block_fifo_request_t,
-                                block_fifo_response_t>* fifo_out, BlockServer** out) {
+zx_status_t BlockServer::Create(block_impl_protocol_t* bp, bool coalesce,
+                                fzl::fifo<block_fifo_request_t, block_fifo_response_t>* fifo_out,
+                                BlockServer** out) {
+    fbl::AllocChecker ac;
+    fbl::RefPtr<IoBufferTable> buffers = fbl::AdoptRef(new (&ac) IoBufferTable());
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    return Create(bp, coalesce, fbl::move(buffers), fifo_out, out);
+}
+
+zx_status_t BlockServer::CreateSession(fzl::fifo<block_fifo_request_t,
+                                       block_fifo_response_t>* fifo_out, BlockServer** out) {
+    return Create(bp_, coalesce_, buffers_, fifo_out, out);
+}
+
+zx_status_t BlockServer::Create(block_impl_protocol_t* bp, bool coalesce,
+                                fbl::RefPtr<IoBufferTable> buffers,
+                                fzl::fifo<block_fifo_request_t, block_fifo_response_t>* fifo_out,
+                                BlockServer** out) {
     fbl::AllocChecker ac;
-    BlockServer* bs = new (&ac) BlockServer(bp);
+    BlockServer* bs = new (&ac) BlockServer(bp, fbl::move(buffers));
     if (!ac.check()) {
         return ZX_ERR_NO_MEMORY;
     }
+    bs->coalesce_ = coalesce;
 
     zx_status_t status;
     if ((status = fzl::create_fifo(BLOCK_FIFO_MAX_DEPTH, 0, fifo_out, &bs->fifo_)) != ZX_OK) {
@@ -277,8 +313,9 @@ zx_status_t BlockServer::Create(block_impl_protocol_t* bp, fzl::fifo<block_fifo_
         return status;
     }
 
+    bs->ring_.Initialize(bs->fifo_.get_handle());
     for (size_t i = 0; i < fbl::count_of(bs->groups_); i++) {
-        bs->groups_[i].Initialize(bs->fifo_.get_handle(), static_cast<groupid_t>(i));
+        bs->groups_[i].Initialize(bs->fifo_.get_handle(), static_cast<groupid_t>(i), &bs->ring_);
     }
 
     // Notably, drop ZX_RIGHT_SIGNAL_PEER, since we use bs->fifo for thread
@@ -298,6 +335,39 @@ zx_status_t BlockServer::Create(block_impl_protocol_t* bp, fzl::fifo<block_fifo_
     return ZX_OK;
 }
 
+bool BlockServer::MergeRequest(const block_fifo_request_t* request, zx_handle_t vmo,
+                               groupid_t group) {
+    // Requests outside of groups each need a response of their own.
+    if ((group == kNoGroup) || in_queue_.is_empty()) {
+        return false;
+    }
+    block_msg_t& last = in_queue_.back();
+    block_op_t* bop = &last.op;
+    uint32_t command = OpcodeToCommand(request->opcode);
+    if ((last.extra.group != group) || (bop->rw.vmo != vmo) ||
+        ((bop->command & BLOCK_OP_MASK) != (command & BLOCK_OP_MASK))) {
+        return false;
+    }
+    if ((bop->command & BLOCK_FL_BARRIER_AFTER) || (command & BLOCK_FL_BARRIER_BEFORE)) {
+        return false;
+    }
+    if ((bop->rw.offset_dev + bop->rw.length != request->dev_offset) ||
+        (bop->rw.offset_vmo + bop->rw.length != request->vmo_offset)) {
+        return false;
+    }
+    uint64_t length = static_cast<uint64_t>(bop->rw.length) + request->length;
+    const uint32_t max_xfer = info_.max_transfer_size / info_.block_size;
+    if ((length > fbl::numeric_limits<uint32_t>::max()) ||
+        (max_xfer != 0 && length > max_xfer)) {
+        return false;
+    }
+
+    bop->rw.length = static_cast<uint32_t>(length);
+    bop->command |= command & BLOCK_FL_BARRIER_AFTER;
+    last.extra.merged++;
+    return true;
+}
+
 void BlockServer::ProcessRequest(block_fifo_request_t* request) {
     reqid_t reqid = request->reqid;
     groupid_t group = request->group;
@@ -308,9 +378,9 @@ void BlockServer::ProcessRequest(block_fifo_request_t* request) {
     case BLOCKIO_WRITE: {
         // TODO(ZX-1586): Reduce the usage of this lock (only used to protect
         // IoBuffers).
-        fbl::AutoLock server_lock(&server_lock_);
+        fbl::AutoLock server_lock(&buffers_->lock);
 
-        auto iobuf = tree_.find(vmoid);
+        auto iobuf = buffers_->tree.find(vmoid);
         if (!iobuf.IsValid()) {
             // Operation which is not accessing a valid vmo
             TxnComplete(ZX_ERR_IO, reqid, group);
@@ -335,6 +405,10 @@ void BlockServer::ProcessRequest(block_fifo_request_t* request) {
             return;
         }
 
+        if (coalesce_ && MergeRequest(request, iobuf->vmo(), group)) {
+            break;
+        }
+
         BlockMsg msg;
         if ((status = BlockMsg::Create(block_op_size_, &msg)) != ZX_OK) {
             TxnComplete(status, reqid, group);
@@ -345,6 +419,7 @@ void BlockServer::ProcessRequest(block_fifo_request_t* request) {
         extra->server = this;
         extra->reqid = reqid;
         extra->group = group;
+        extra->merged = 0;
         msg.op()->command = OpcodeToCommand(request->opcode);
 
         const uint32_t max_xfer = info_.max_transfer_size / bsz;
@@ -373,6 +448,7 @@ void BlockServer::ProcessRequest(block_fifo_request_t* request) {
                     extra->server = this;
                     extra->reqid = reqid;
                     extra->group = group;
+                    extra->merged = 0;
                     msg.op()->command = OpcodeToCommand(request->opcode);
                 }
 
@@ -403,9 +479,9 @@ void BlockServer::ProcessRequest(block_fifo_request_t* request) {
         break;
     }
     case BLOCKIO_CLOSE_VMO: {
-        fbl::AutoLock server_lock(&server_lock_);
+        fbl::AutoLock server_lock(&buffers_->lock);
 
-        auto iobuf = tree_.find(vmoid);
+        auto iobuf = buffers_->tree.find(vmoid);
         if (!iobuf.IsValid()) {
             // Operation which is not accessing a valid vmo
             TxnComplete(ZX_ERR_IO, reqid, group);
@@ -414,7 +490,7 @@ void BlockServer::ProcessRequest(block_fifo_request_t* request) {
 
         // TODO(smklein): Ensure that "iobuf" is not being used by
         // any in-flight txns.
-        tree_.erase(*iobuf);
+        buffers_->tree.erase(*iobuf);
         TxnComplete(ZX_OK, reqid, group);
         break;
     }
@@ -430,6 +506,7 @@ void BlockServer::ProcessRequest(block_fifo_request_t* request) {
         extra->server = this;
         extra->reqid = reqid;
         extra->group = group;
+        extra->merged = 0;
         msg.op()->command = OpcodeToCommand(request->opcode);
         InQueueAdd(ZX_HANDLE_INVALID, 0, 0, 0, msg.release(), &in_queue_);
         break;
@@ -486,9 +563,9 @@ zx_status_t BlockServer::Serve() {
     }
 }
 
-BlockServer::BlockServer(block_impl_protocol_t* bp) :
-    bp_(bp), block_op_size_(0), pending_count_(0), barrier_in_progress_(false),
-    last_id_(VMOID_INVALID + 1) {
+BlockServer::BlockServer(block_impl_protocol_t* bp, fbl::RefPtr<IoBufferTable> buffers) :
+    bp_(bp), block_op_size_(0), coalesce_(false), pending_count_(0), barrier_in_progress_(false),
+    buffers_(fbl::move(buffers)) {
     size_t block_op_size;
     bp->ops->query(bp->ctx, &info_, &block_op_size);
 }
@@ -508,10 +585,17 @@ void BlockServer::ShutDown() {
 }
 
 // C declarations
-zx_status_t blockserver_create(block_impl_protocol_t* bp, zx_handle_t* fifo_out,
+zx_status_t blockserver_create(block_impl_protocol_t* bp, bool coalesce, zx_handle_t* fifo_out,
                                BlockServer** out) {
     fzl::fifo<block_fifo_request_t, block_fifo_response_t> fifo;
-    zx_status_t status = BlockServer::Create(bp, &fifo, out);
+    zx_status_t status = BlockServer::Create(bp, coalesce, &fifo, out);
+    *fifo_out = fifo.release();
+    return status;
+}
+zx_status_t blockserver_create_session(BlockServer* bs, zx_handle_t* fifo_out,
+                                       BlockServer** out) {
+    fzl::fifo<block_fifo_request_t, block_fifo_response_t> fifo;
+    zx_status_t status = bs->CreateSession(&fifo, out);
     *fifo_out = fifo.release();
     return status;
 }
@@ -528,3 +612,10 @@ zx_status_t blockserver_attach_vmo(BlockServer* bs, zx_handle_t raw_vmo, vmoid_t
     zx::vmo vmo(raw_vmo);
     return bs->AttachVmo(fbl::move(vmo), out);
 }
+zx_status_t blockserver_attach_completion_ring(BlockServer* bs, zx_handle_t raw_vmo) {
+    zx::vmo vmo(raw_vmo);
+    return bs->AttachCompletionRing(fbl::move(vmo));
+}
+zx_status_t blockserver_detach_vmo(BlockServer* bs, vmoid_t vmoid) {
+    return bs->DetachVmo(vmoid);
+}
@@ -53,6 +53,20 @@ private:
     const vmoid_t vmoid_;
 };
 
+// The VMOs attached to a block server, shared with the sessions opened
+// from it, so that a vmoid means the same VMO on each of their FIFOs.
+class IoBufferTable : public fbl::RefCounted<IoBufferTable> {
+public:
+    IoBufferTable() : last_id(VMOID_INVALID + 1) {}
+
+    fbl::Mutex lock;
+    fbl::WAVLTree<vmoid_t, fbl::RefPtr<IoBuffer>> tree TA_GUARDED(lock);
+    vmoid_t last_id TA_GUARDED(lock);
+
+private:
+    DISALLOW_COPY_ASSIGN_AND_MOVE(IoBufferTable);
+};
+
 class BlockServer;
 
 typedef struct block_msg_extra block_msg_extra_t;
@@ -66,6 +80,8 @@ struct block_msg_extra {
     BlockServer* server;
     reqid_t reqid;
     groupid_t group;
+    // How many further requests of the group were merged into this one.
+    uint32_t merged;
 };
 
 // A single unit of work transmitted to the underlying block layer.
@@ -144,14 +160,24 @@ private:
 
 class BlockServer {
 public:
-    // Creates a new BlockServer.
+    // Creates a new BlockServer. With |coalesce|, requests in a group that
+    // continue the one queued just before them are merged into it.
     static zx_status_t Create(
-        block_impl_protocol_t* bp, fzl::fifo<block_fifo_request_t,
+        block_impl_protocol_t* bp, bool coalesce, fzl::fifo<block_fifo_request_t,
+                              block_fifo_response_t>* fifo_out, BlockServer** out);
+
+    // Creates another BlockServer for the same device, with a FIFO of its
+    // own, which shares the VMOs attached to this one. Each of them has
+    // its own transaction groups, and is served by a thread of its own.
+    zx_status_t CreateSession(fzl::fifo<block_fifo_request_t,
                               block_fifo_response_t>* fifo_out, BlockServer** out);
 
     // Starts the BlockServer using the current thread
-    zx_status_t Serve() TA_EXCL(server_lock_);
-    zx_status_t AttachVmo(zx::vmo vmo, vmoid_t* out) TA_EXCL(server_lock_);
+    zx_status_t Serve() TA_EXCL(buffers_->lock);
+    zx_status_t AttachVmo(zx::vmo vmo, vmoid_t* out) TA_EXCL(buffers_->lock);
+    zx_status_t DetachVmo(vmoid_t vmoid) TA_EXCL(buffers_->lock);
+    // Posts group responses to the completion ring in |vmo| from now on.
+    zx_status_t AttachCompletionRing(zx::vmo vmo);
 
     // Updates the total number of pending txns, possibly signals
     // the queue-draining thread to wake up if they are waiting
@@ -165,17 +191,30 @@ public:
     // both both one-shot and group-based transactions.
     //
     // (If appropriate) tells the client that their operation is done.
-    void TxnComplete(zx_status_t status, reqid_t reqid, groupid_t group);
+    // |count| is the number of requests the operation stands for.
+    void TxnComplete(zx_status_t status, reqid_t reqid, groupid_t group,
+                     uint32_t count = 1);
 
     void ShutDown();
     ~BlockServer();
 private:
     DISALLOW_COPY_ASSIGN_AND_MOVE(BlockServer);
-    BlockServer(block_impl_protocol_t* bp);
+    BlockServer(block_impl_protocol_t* bp, fbl::RefPtr<IoBufferTable> buffers);
+
+    static zx_status_t Create(block_impl_protocol_t* bp, bool coalesce,
+                              fbl::RefPtr<IoBufferTable> buffers,
+                              fzl::fifo<block_fifo_request_t, block_fifo_response_t>* fifo_out,
+                              BlockServer** out);
 
     // Helper for processing a single message read from the FIFO.
     void ProcessRequest(block_fifo_request_t* request);
 
+    // Extends the operation at the back of |in_queue_| to cover |request|
+    // as well, if it is a read or write of the same group and VMO which
+    // picks up where that operation leaves off, and no barrier stands
+    // between them. Returns false if it can't.
+    bool MergeRequest(const block_fifo_request_t* request, zx_handle_t vmo, groupid_t group);
+
     // Helper for the server to react to a signal that a barrier
     // operation has completed. Unsets the local "waiting for barrier"
     // signal, and enqueues any further operations that might be
@@ -192,12 +231,13 @@ private:
     // operations are in-flight.
     void InQueueDrainer();
 
-    zx_status_t FindVmoIDLocked(vmoid_t* out) TA_REQ(server_lock_);
+    zx_status_t FindVmoIDLocked(vmoid_t* out) TA_REQ(buffers_->lock);
 
     fzl::fifo<block_fifo_response_t, block_fifo_request_t> fifo_;
     block_info_t info_;
     block_impl_protocol_t* bp_;
     size_t block_op_size_;
+    bool coalesce_;
 
     // BARRIER_AFTER is implemented by sticking "BARRIER_BEFORE" on the
     // next operation that arrives.
@@ -205,11 +245,10 @@ private:
     BlockMsgQueue in_queue_;
     fbl::atomic<size_t> pending_count_;
     fbl::atomic<bool> barrier_in_progress_;
+    CompletionRing ring_;
     TransactionGroup groups_[MAX_TXN_GROUP_COUNT];
 
-    fbl::Mutex server_lock_;
-    fbl::WAVLTree<vmoid_t, fbl::RefPtr<IoBuffer>> tree_ TA_GUARDED(server_lock_);
-    vmoid_t last_id_ TA_GUARDED(server_lock_);
+    const fbl::RefPtr<IoBufferTable> buffers_;
 };
 
 #else
@@ -222,7 +261,14 @@ typedef struct BlockServer BlockServer;
 __BEGIN_CDECLS
 
 // Allocate a new blockserver + FIFO combo
-zx_status_t blockserver_create(block_impl_protocol_t* bp, zx_handle_t* fifo_out, BlockServer** out);
+// With |coalesce| set, contiguous requests within a group may be merged.
+zx_status_t blockserver_create(block_impl_protocol_t* bp, bool coalesce, zx_handle_t* fifo_out,
+                               BlockServer** out);
+
+// Allocate another blockserver + FIFO combo for the device of |bs|, sharing
+// the VMOs attached to |bs|.
+zx_status_t blockserver_create_session(BlockServer* bs, zx_handle_t* fifo_out,
+                                       BlockServer** out);
 
 // Shut down the blockserver. It will stop serving requests.
 void blockserver_shutdown(BlockServer* bs);
@@ -236,4 +282,10 @@ zx_status_t blockserver_serve(BlockServer* bs);
 // Attach an IO buffer to the Block Server
 zx_status_t blockserver_attach_vmo(BlockServer* bs, zx_handle_t vmo, vmoid_t* out);
 
+// Attach a completion ring to the Block Server, as IOCTL_BLOCK_ATTACH_COMPLETION_RING does
+zx_status_t blockserver_attach_completion_ring(BlockServer* bs, zx_handle_t vmo);
+
+// Detach an IO buffer from the Block Server, as BLOCKIO_CLOSE_VMO does
+zx_status_t blockserver_detach_vmo(BlockServer* bs, vmoid_t vmoid);
+
 __END_CDECLS
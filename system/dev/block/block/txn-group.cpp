@@ -24,15 +24,16 @@
 #include "server.h"
 
 TransactionGroup::TransactionGroup() :
-    fifo_(ZX_HANDLE_INVALID), flags_(0), ctr_(0) {
+    fifo_(ZX_HANDLE_INVALID), ring_(nullptr), flags_(0), ctr_(0) {
     memset(&response_, 0, sizeof(response_));
 }
 
 TransactionGroup::~TransactionGroup() {}
 
-void TransactionGroup::Initialize(zx_handle_t fifo, groupid_t group) {
+void TransactionGroup::Initialize(zx_handle_t fifo, groupid_t group, CompletionRing* ring) {
     ZX_DEBUG_ASSERT(fifo_ == ZX_HANDLE_INVALID);
     fifo_ = fifo;
+    ring_ = ring;
     response_.group = group;
 }
 
@@ -60,20 +61,22 @@ void TransactionGroup::CtrAdd(uint32_t n) {
     ctr_ += n;
 }
 
-void TransactionGroup::Complete(zx_status_t status) {
+void TransactionGroup::Complete(zx_status_t status, uint32_t count) {
     fbl::AutoLock lock(&lock_);
     if ((status != ZX_OK) && (response_.status == ZX_OK)) {
         response_.status = status;
     }
 
-    response_.count++;
+    response_.count += count;
     ZX_DEBUG_ASSERT(ctr_ != 0);
     ZX_DEBUG_ASSERT(response_.count <= ctr_);
 
     if ((flags_ & kTxnFlagRespond) && (response_.count == ctr_)) {
-        status = zx_fifo_write(fifo_, sizeof(response_), &response_, 1, nullptr);
-        if (status != ZX_OK) {
-            fprintf(stderr, "Block Server I/O error: Could not write response\n");
+        if (!ring_->Post(response_)) {
+            status = zx_fifo_write(fifo_, sizeof(response_), &response_, 1, nullptr);
+            if (status != ZX_OK) {
+                fprintf(stderr, "Block Server I/O error: Could not write response\n");
+            }
         }
         response_.count = 0;
         response_.status = ZX_OK;
@@ -24,6 +24,8 @@
 #include <lib/zx/vmo.h>
 #include <lib/sync/completion.h>
 
+#include "completion-ring.h"
+
 // Should a response be sent when we hit ctr?
 constexpr uint32_t kTxnFlagRespond = 0x00000001;
 
@@ -34,7 +36,9 @@ public:
     ~TransactionGroup();
     // Initialize must be called before utilizing other functions in
     // TransactionGroup. Initialize should only be called once.
-    void Initialize(zx_handle_t fifo, groupid_t group) TA_NO_THREAD_SAFETY_ANALYSIS;
+    // Responses go to |ring| when the client has attached one.
+    void Initialize(zx_handle_t fifo, groupid_t group,
+                    CompletionRing* ring) TA_NO_THREAD_SAFETY_ANALYSIS;
 
     // Verifies that the incoming txn does not break the Block IO fifo protocol.
     // If it is successful, sets up the response_ with the registered cookie,
@@ -46,14 +50,16 @@ public:
     // responding to this txn.
     void CtrAdd(uint32_t n) TA_EXCL(lock_);
 
-    // Called once the transaction has completed successfully.
+    // Called once the transaction has completed successfully, with the
+    // number of enqueued requests that it completes.
     // This function may respond on the fifo, resetting |response_|.
-    void Complete(zx_status_t status) TA_EXCL(lock_);
+    void Complete(zx_status_t status, uint32_t count = 1) TA_EXCL(lock_);
 private:
     DISALLOW_COPY_ASSIGN_AND_MOVE(TransactionGroup);
 
     // Should only be set once.
     zx_handle_t fifo_;
+    CompletionRing* ring_;
 
     fbl::Mutex lock_;
     block_fifo_response_t response_ TA_GUARDED(lock_); // The response to be sent back to the client
@@ -16,9 +16,14 @@
 
 #ifdef __cplusplus
 
+#include <bitmap/raw-bitmap.h>
+#include <bitmap/storage.h>
 #include <ddktl/device.h>
 #include <ddktl/protocol/block.h>
 #include <fbl/algorithm.h>
+#include <fbl/array.h>
+#include <fbl/atomic.h>
+#include <fbl/intrusive_single_list.h>
 #include <fbl/intrusive_wavl_tree.h>
 #include <fbl/mutex.h>
 #include <fbl/unique_ptr.h>
@@ -77,6 +82,32 @@ private:
     const size_t vslice_start_;
 };
 
+class VPartition;
+
+// A block op which a VPartition has split into one op per physical slice.
+// The split ops are kept in |ops|, and the original op completes once all of
+// them have.
+struct SplitTxn : public fbl::SinglyLinkedListable<fbl::unique_ptr<SplitTxn>> {
+    // Number of split ops a SplitTxn from a VPartition's pool has room for.
+    static constexpr size_t kPooledOps = 8;
+
+    block_op_t* op(size_t i, size_t op_size) {
+        return reinterpret_cast<block_op_t*>(ops.get() + i * op_size);
+    }
+
+    VPartition* vp;
+    bool pooled;
+    fbl::Array<uint8_t> ops;
+
+    fbl::Mutex lock;
+    size_t txns_completed TA_GUARDED(lock);
+    size_t txns_total;
+    zx_status_t status TA_GUARDED(lock);
+    block_op_t* original;
+    block_impl_queue_callback completion_cb;
+    void* cookie;
+};
+
 class VPartitionManager;
 using ManagerDeviceType = ddk::Device<VPartitionManager, ddk::Ioctlable, ddk::Unbindable>;
 
@@ -150,8 +181,13 @@ private:
 
     // Update, hash, and write back the current copy of the FVM metadata.
     // Automatically handles alternating writes to primary / backup copy of FVM.
+    // Only the metadata blocks which differ between the two copies are written.
     zx_status_t WriteFvmLocked() TA_REQ(lock_);
 
+    // Marks the metadata blocks holding |len| bytes at |ptr| as modified, so
+    // they are written by the next |WriteFvmLocked|.
+    void MarkDirtyLocked(const void* ptr, size_t len) TA_REQ(lock_);
+
     zx_status_t AllocateSlicesLocked(VPartition* vp, size_t vslice_start,
                                      size_t count) TA_REQ(lock_);
 
@@ -193,7 +229,21 @@ private:
         return metadata_size_;
     }
 
-    zx_status_t DoIoLocked(zx_handle_t vmo, size_t off, size_t len, uint32_t command);
+    // A range of bytes at |off| in a VMO, and at the same offset from the base
+    // of the device region being read or written.
+    struct IoRange {
+        size_t off;
+        size_t len;
+    };
+
+    // Reads or writes each of the |count| |ranges| of |vmo| at |dev_off| +
+    // |range.off| on the device. Writes are followed by a single flush.
+    zx_status_t DoIoLocked(zx_handle_t vmo, size_t dev_off, const IoRange* ranges, size_t count,
+                           uint32_t command);
+    zx_status_t DoIoLocked(zx_handle_t vmo, size_t off, size_t len, uint32_t command) {
+        IoRange range = {0, len};
+        return DoIoLocked(vmo, off, &range, 1, command);
+    }
 
     thrd_t initialization_thread_;
     block_info_t info_; // Cached info from parent device
@@ -201,6 +251,13 @@ private:
     fbl::Mutex lock_;
     fzl::OwnedVmoMapper metadata_ TA_GUARDED(lock_);
     bool first_metadata_is_primary_ TA_GUARDED(lock_);
+    // Metadata blocks, in units of FVM_BLOCK_SIZE, modified since the last
+    // |WriteFvmLocked|.
+    bitmap::RawBitmapGeneric<bitmap::DefaultStorage> dirty_ TA_GUARDED(lock_);
+    // Metadata blocks which the backup copy on disk lacks from earlier
+    // updates, i.e. those modified before the last |WriteFvmLocked|. Since
+    // the two copies are written in turn, these also go into the next write.
+    bitmap::RawBitmapGeneric<bitmap::DefaultStorage> stale_ TA_GUARDED(lock_);
     size_t metadata_size_;
     size_t slice_size_;
     // Number of allocatable slices.
@@ -238,7 +295,16 @@ public:
 
     // Given a virtual slice, return the physical slice allocated
     // to it. If no slice is allocated, return PSLICE_UNALLOCATED.
-    uint32_t SliceGetLocked(size_t vslice) const TA_REQ(lock_);
+    uint32_t SliceGetLocked(size_t vslice) const TA_REQ(lock_) {
+        if (vslice < kSliceTableMax) {
+            size_t leaf = vslice / kSliceTableLeaf;
+            if (leaf >= slice_table_.size() || slice_table_[leaf] == nullptr) {
+                return PSLICE_UNALLOCATED;
+            }
+            return slice_table_[leaf][vslice % kSliceTableLeaf];
+        }
+        return ExtentGetLocked(vslice);
+    }
 
     // Check slices starting from |vslice_start|.
     // Sets |*count| to the number of contiguous allocated or unallocated slices found.
@@ -271,6 +337,12 @@ public:
 
     size_t GetEntryIndex() const { return entry_index_; }
 
+    // Returns a SplitTxn with room for |count| split ops, from the pool if
+    // possible; returns nullptr if memory allocation fails.
+    fbl::unique_ptr<SplitTxn> GetSplitTxn(size_t count);
+    // Returns |txn| to the pool if it came from there; frees it otherwise.
+    void PutSplitTxn(fbl::unique_ptr<SplitTxn> txn);
+
     void KillLocked() TA_REQ(lock_) { entry_index_ = 0; }
     bool IsKilledLocked() TA_REQ(lock_) { return entry_index_ == 0; }
 
@@ -283,14 +355,41 @@ private:
 
     zx_device_t* GetParent() const { return mgr_->parent(); }
 
+    // Virtual slices below |kSliceTableMax| are also kept in |slice_table_|, a
+    // two level table with leaves of |kSliceTableLeaf| physical slices each,
+    // so that I/O to them translates without searching |slice_map_|.
+    static constexpr size_t kSliceTableLeaf = 1024;
+    static constexpr size_t kSliceTableMax = 1 << 20;
+
+    // Looks up |vslice| in |slice_map_|.
+    uint32_t ExtentGetLocked(size_t vslice) const TA_REQ(lock_);
+
+    // Records |pslice| for |vslice| in |slice_table_|, allocating the leaf if
+    // need be. Fails only if that allocation does.
+    bool SliceTableSetLocked(size_t vslice, uint32_t pslice) TA_REQ(lock_);
+
     VPartitionManager* mgr_;
     size_t entry_index_;
 
+    // Number of SplitTxns preallocated, so splitting a block op across
+    // noncontiguous slices doesn't allocate.
+    static constexpr size_t kSplitPoolSize = 16;
+
+    fbl::Mutex split_lock_;
+    fbl::SinglyLinkedList<fbl::unique_ptr<SplitTxn>> split_pool_ TA_GUARDED(split_lock_);
+
+    // Reported by IOCTL_BLOCK_FVM_GET_SPLIT_STATS.
+    fbl::atomic_uint64_t total_ops_;
+    fbl::atomic_uint64_t split_ops_;
+    fbl::atomic_uint64_t split_txns_;
+    fbl::atomic_uint64_t pool_misses_;
+
     // Mapping of virtual slice number (index) to physical slice number (value).
     // Physical slice zero is reserved to mean "unmapped", so a zeroed slice_map
     // indicates that the vpartition is completely unmapped, and uses no
     // physical slices.
     fbl::WAVLTree<size_t, fbl::unique_ptr<SliceExtent>> slice_map_ TA_GUARDED(lock_);
+    fbl::Vector<fbl::unique_ptr<uint32_t[]>> slice_table_ TA_GUARDED(lock_);
     block_info_t info_ TA_GUARDED(lock_);
 };
 
@@ -146,14 +146,15 @@ static void IoCallback(void* cookie, zx_status_t status, block_op_t* op) {
     }
 }
 
-zx_status_t VPartitionManager::DoIoLocked(zx_handle_t vmo, size_t off,
-                                          size_t len, uint32_t command) {
+zx_status_t VPartitionManager::DoIoLocked(zx_handle_t vmo, size_t dev_off,
+                                          const IoRange* ranges, size_t count,
+                                          uint32_t command) {
     const size_t block_size = info_.block_size;
     const size_t max_transfer = info_.max_transfer_size / block_size;
-    size_t len_remaining = len / block_size;
-    size_t vmo_offset = 0;
-    size_t dev_offset = off / block_size;
-    const size_t num_data_txns = fbl::round_up(len_remaining, max_transfer) / max_transfer;
+    size_t num_data_txns = 0;
+    for (size_t r = 0; r < count; r++) {
+        num_data_txns += fbl::round_up(ranges[r].len / block_size, max_transfer) / max_transfer;
+    }
 
     // Add a "FLUSH" operation to write requests.
     const bool flushing = command == BLOCK_OP_WRITE;
@@ -172,24 +173,32 @@ zx_status_t VPartitionManager::DoIoLocked(zx_handle_t vmo, size_t off,
     cookie.status.store(ZX_OK);
     sync_completion_reset(&cookie.signal);
 
-    for (size_t i = 0; i < num_data_txns; i++) {
-        size_t length = fbl::min(len_remaining, max_transfer);
-        len_remaining -= length;
-
-        block_op_t* bop = reinterpret_cast<block_op_t*>(buffer.get() + (block_op_size_ * i));
-
-        bop->command = command;
-        bop->rw.vmo = vmo;
-        bop->rw.length = static_cast<uint32_t>(length);
-        bop->rw.offset_dev = dev_offset;
-        bop->rw.offset_vmo = vmo_offset;
-        memset(buffer.get() + (block_op_size_ * i) + sizeof(block_op_t), 0,
-               block_op_size_ - sizeof(block_op_t));
-        vmo_offset += length;
-        dev_offset += length;
-
-        Queue(bop, IoCallback, &cookie);
+    size_t i = 0;
+    for (size_t r = 0; r < count; r++) {
+        size_t len_remaining = ranges[r].len / block_size;
+        size_t vmo_offset = ranges[r].off / block_size;
+        size_t dev_offset = (dev_off + ranges[r].off) / block_size;
+        while (len_remaining > 0) {
+            size_t length = fbl::min(len_remaining, max_transfer);
+            len_remaining -= length;
+
+            block_op_t* bop = reinterpret_cast<block_op_t*>(buffer.get() + (block_op_size_ * i));
+
+            bop->command = command;
+            bop->rw.vmo = vmo;
+            bop->rw.length = static_cast<uint32_t>(length);
+            bop->rw.offset_dev = dev_offset;
+            bop->rw.offset_vmo = vmo_offset;
+            memset(buffer.get() + (block_op_size_ * i) + sizeof(block_op_t), 0,
+                   block_op_size_ - sizeof(block_op_t));
+            vmo_offset += length;
+            dev_offset += length;
+            i++;
+
+            Queue(bop, IoCallback, &cookie);
+        }
     }
+    ZX_DEBUG_ASSERT(i == num_data_txns);
 
     if (flushing) {
         block_op_t* bop = reinterpret_cast<block_op_t*>(buffer.get() +
@@ -199,7 +208,6 @@ zx_status_t VPartitionManager::DoIoLocked(zx_handle_t vmo, size_t off,
         Queue(bop, IoCallback, &cookie);
     }
 
-    ZX_DEBUG_ASSERT(len_remaining == 0);
     sync_completion_wait(&cookie.signal, ZX_TIME_INFINITE);
     return static_cast<zx_status_t>(cookie.status.load());
 }
@@ -308,6 +316,16 @@ zx_status_t VPartitionManager::Load() {
         metadata_ = fbl::move(mapper_backup);
     }
 
+    // Nothing is known about how the backup differs from the primary, so the
+    // first update rewrites it whole.
+    const size_t metadata_blocks = MetadataSize() / FVM_BLOCK_SIZE;
+    if ((status = dirty_.Reset(metadata_blocks)) != ZX_OK ||
+        (status = stale_.Reset(metadata_blocks)) != ZX_OK ||
+        (status = stale_.Set(0, metadata_blocks)) != ZX_OK) {
+        fprintf(stderr, "fvm: Failed to allocate metadata bitmaps: %d\n", status);
+        return status;
+    }
+
     // Begin initializing the underlying partitions
     DdkMakeVisible();
     auto_detach.cancel();
@@ -369,20 +387,58 @@ zx_status_t VPartitionManager::WriteFvmLocked() {
     GetFvmLocked()->generation++;
     fvm_update_hash(GetFvmLocked(), MetadataSize());
 
+    // The header changes on every update. Beyond it, the backup needs the
+    // blocks modified since either copy was last written.
+    const size_t metadata_blocks = dirty_.size();
+    dirty_.Set(0, 1);
+    fbl::Vector<IoRange> ranges;
+    fbl::AllocChecker ac;
+    for (size_t blk = 0; blk < metadata_blocks;) {
+        if (!dirty_.GetOne(blk) && !stale_.GetOne(blk)) {
+            blk++;
+            continue;
+        }
+        size_t end = blk + 1;
+        while (end < metadata_blocks && (dirty_.GetOne(end) || stale_.GetOne(end))) {
+            end++;
+        }
+        ranges.push_back({blk * FVM_BLOCK_SIZE, (end - blk) * FVM_BLOCK_SIZE}, &ac);
+        if (!ac.check()) {
+            return ZX_ERR_NO_MEMORY;
+        }
+        blk = end;
+    }
+
     // If we were reading from the primary, write to the backup.
-    status = DoIoLocked(metadata_.vmo().get(), BackupOffsetLocked(),
-                        MetadataSize(), BLOCK_OP_WRITE);
+    status = DoIoLocked(metadata_.vmo().get(), BackupOffsetLocked(), ranges.get(),
+                        ranges.size(), BLOCK_OP_WRITE);
     if (status != ZX_OK) {
         fprintf(stderr, "FVM: Failed to write metadata\n");
+        // The backup may now hold anything; rewrite it whole next time.
+        stale_.Set(0, metadata_blocks);
         return status;
     }
 
     // We only allow the switch of "write to the other copy of metadata"
-    // once a valid version has been written entirely.
+    // once a valid version has been written entirely. The new backup lacks
+    // just what was modified for this update.
     first_metadata_is_primary_ = !first_metadata_is_primary_;
+    stale_.ClearAll();
+    for (size_t blk = 0; blk < metadata_blocks; blk++) {
+        if (dirty_.GetOne(blk)) {
+            stale_.SetOne(blk);
+        }
+    }
+    dirty_.ClearAll();
     return ZX_OK;
 }
 
+void VPartitionManager::MarkDirtyLocked(const void* ptr, size_t len) {
+    size_t off = reinterpret_cast<uintptr_t>(ptr) - reinterpret_cast<uintptr_t>(GetFvmLocked());
+    ZX_DEBUG_ASSERT(off + len <= MetadataSize());
+    dirty_.Set(off / FVM_BLOCK_SIZE, fbl::round_up(off + len, FVM_BLOCK_SIZE) / FVM_BLOCK_SIZE);
+}
+
 zx_status_t VPartitionManager::FindFreeVPartEntryLocked(size_t* out) const {
     for (size_t i = 1; i < FVM_MAX_ENTRIES; i++) {
         const vpart_entry_t* entry = GetVPartEntryLocked(i);
@@ -495,8 +551,10 @@ zx_status_t VPartitionManager::Upgrade(const uint8_t* old_guid, const uint8_t* n
 
     if (old_index) {
         GetVPartEntryLocked(old_index)->flags |= kVPartFlagInactive;
+        MarkDirtyLocked(GetVPartEntryLocked(old_index), sizeof(vpart_entry_t));
     }
     GetVPartEntryLocked(new_index)->flags &= ~kVPartFlagInactive;
+    MarkDirtyLocked(GetVPartEntryLocked(new_index), sizeof(vpart_entry_t));
 
     return WriteFvmLocked();
 }
@@ -541,6 +599,7 @@ zx_status_t VPartitionManager::FreeSlicesLocked(VPartition* vp, size_t vslice_st
             vp->DdkRemove();
             auto entry = GetVPartEntryLocked(vp->GetEntryIndex());
             entry->clear();
+            MarkDirtyLocked(entry, sizeof(*entry));
             vp->KillLocked();
             freed_something = true;
         } else {
@@ -585,7 +644,10 @@ void VPartitionManager::FreePhysicalSlice(VPartition* vp, size_t pslice) {
     auto entry = GetSliceEntryLocked(pslice);
     ZX_DEBUG_ASSERT_MSG(entry->Vpart() != FVM_SLICE_ENTRY_FREE, "Freeing already-free slice");
     entry->SetVpart(FVM_SLICE_ENTRY_FREE);
-    GetVPartEntryLocked(vp->GetEntryIndex())->slices--;
+    MarkDirtyLocked(entry, sizeof(*entry));
+    auto vpart_entry = GetVPartEntryLocked(vp->GetEntryIndex());
+    vpart_entry->slices--;
+    MarkDirtyLocked(vpart_entry, sizeof(*vpart_entry));
     pslice_allocated_count_--;
 }
 
@@ -598,7 +660,10 @@ void VPartitionManager::AllocatePhysicalSlice(VPartition* vp, size_t pslice, uin
                         "Allocating previously allocated slice");
     entry->SetVpart(vpart);
     entry->SetVslice(vslice);
-    GetVPartEntryLocked(vpart)->slices++;
+    MarkDirtyLocked(entry, sizeof(*entry));
+    auto vpart_entry = GetVPartEntryLocked(vpart);
+    vpart_entry->slices++;
+    MarkDirtyLocked(vpart_entry, sizeof(*vpart_entry));
     pslice_allocated_count_++;
 }
 
@@ -655,6 +720,7 @@ zx_status_t VPartitionManager::DdkIoctl(uint32_t op, const void* cmd,
             auto entry = GetVPartEntryLocked(vpart_entry);
             entry->init(request->type, request->guid, 0,
                         request->name, request->flags & kVPartAllocateMask);
+            MarkDirtyLocked(entry, sizeof(*entry));
 
             if ((status = AllocateSlicesLocked(vpart.get(), 0,
                                                request->slice_count)) != ZX_OK) {
@@ -700,7 +766,8 @@ void VPartitionManager::DdkRelease() {
 }
 
 VPartition::VPartition(VPartitionManager* vpm, size_t entry_index, size_t block_op_size)
-    : PartitionDeviceType(vpm->zxdev()), mgr_(vpm), entry_index_(entry_index) {
+    : PartitionDeviceType(vpm->zxdev()), mgr_(vpm), entry_index_(entry_index), total_ops_(0),
+      split_ops_(0), split_txns_(0), pool_misses_(0) {
 
     memcpy(&info_, &mgr_->Info(), sizeof(block_info_t));
     info_.block_count = 0;
@@ -718,11 +785,58 @@ zx_status_t VPartition::Create(VPartitionManager* vpm, size_t entry_index,
         return ZX_ERR_NO_MEMORY;
     }
 
+    for (size_t i = 0; i < kSplitPoolSize; i++) {
+        auto txn = fbl::make_unique_checked<SplitTxn>(&ac);
+        if (!ac.check()) {
+            return ZX_ERR_NO_MEMORY;
+        }
+        size_t len = SplitTxn::kPooledOps * vpm->BlockOpSize();
+        txn->ops.reset(new (&ac) uint8_t[len], len);
+        if (!ac.check()) {
+            return ZX_ERR_NO_MEMORY;
+        }
+        txn->vp = vp.get();
+        txn->pooled = true;
+        fbl::AutoLock lock(&vp->split_lock_);
+        vp->split_pool_.push_front(fbl::move(txn));
+    }
+
     *out = fbl::move(vp);
     return ZX_OK;
 }
 
-uint32_t VPartition::SliceGetLocked(size_t vslice) const {
+fbl::unique_ptr<SplitTxn> VPartition::GetSplitTxn(size_t count) {
+    if (count <= SplitTxn::kPooledOps) {
+        fbl::AutoLock lock(&split_lock_);
+        if (!split_pool_.is_empty()) {
+            return split_pool_.pop_front();
+        }
+    }
+    pool_misses_.fetch_add(1);
+
+    fbl::AllocChecker ac;
+    auto txn = fbl::make_unique_checked<SplitTxn>(&ac);
+    if (!ac.check()) {
+        return nullptr;
+    }
+    size_t len = count * mgr_->BlockOpSize();
+    txn->ops.reset(new (&ac) uint8_t[len], len);
+    if (!ac.check()) {
+        return nullptr;
+    }
+    txn->vp = this;
+    txn->pooled = false;
+    return txn;
+}
+
+void VPartition::PutSplitTxn(fbl::unique_ptr<SplitTxn> txn) {
+    if (txn->pooled) {
+        fbl::AutoLock lock(&split_lock_);
+        split_pool_.push_front(fbl::move(txn));
+    }
+}
+
+uint32_t VPartition::ExtentGetLocked(size_t vslice) const {
     ZX_DEBUG_ASSERT(vslice < mgr_->VSliceMax());
     auto extent = --slice_map_.upper_bound(vslice);
     if (!extent.IsValid()) {
@@ -768,13 +882,47 @@ zx_status_t VPartition::CheckSlices(size_t vslice_start, size_t* count, bool* al
     return ZX_OK;
 }
 
+bool VPartition::SliceTableSetLocked(size_t vslice, uint32_t pslice) {
+    if (vslice >= kSliceTableMax) {
+        return true;
+    }
+    size_t leaf = vslice / kSliceTableLeaf;
+    if (pslice == PSLICE_UNALLOCATED) {
+        if (leaf < slice_table_.size() && slice_table_[leaf] != nullptr) {
+            slice_table_[leaf][vslice % kSliceTableLeaf] = PSLICE_UNALLOCATED;
+        }
+        return true;
+    }
+    fbl::AllocChecker ac;
+    while (slice_table_.size() <= leaf) {
+        slice_table_.push_back(nullptr, &ac);
+        if (!ac.check()) {
+            return false;
+        }
+    }
+    if (slice_table_[leaf] == nullptr) {
+        slice_table_[leaf].reset(new (&ac) uint32_t[kSliceTableLeaf]());
+        if (!ac.check()) {
+            return false;
+        }
+    }
+    slice_table_[leaf][vslice % kSliceTableLeaf] = pslice;
+    return true;
+}
+
 zx_status_t VPartition::SliceSetLocked(size_t vslice, uint32_t pslice) {
     ZX_DEBUG_ASSERT(vslice < mgr_->VSliceMax());
     auto extent = --slice_map_.upper_bound(vslice);
     ZX_DEBUG_ASSERT(!extent.IsValid() || extent->get(vslice) == PSLICE_UNALLOCATED);
+    // Fill in the table first; clearing the entry again can't fail if the
+    // extent can't be updated.
+    if (!SliceTableSetLocked(vslice, pslice)) {
+        return ZX_ERR_NO_MEMORY;
+    }
     if (extent.IsValid() && (vslice == extent->end())) {
         // Easy case: append to existing slice
         if (!extent->push_back(pslice)) {
+            SliceTableSetLocked(vslice, PSLICE_UNALLOCATED);
             return ZX_ERR_NO_MEMORY;
         }
     } else {
@@ -782,9 +930,8 @@ zx_status_t VPartition::SliceSetLocked(size_t vslice, uint32_t pslice) {
         // one.
         fbl::AllocChecker ac;
         fbl::unique_ptr<SliceExtent> new_extent(new (&ac) SliceExtent(vslice));
-        if (!ac.check()) {
-            return ZX_ERR_NO_MEMORY;
-        } else if (!new_extent->push_back(pslice)) {
+        if (!ac.check() || !new_extent->push_back(pslice)) {
+            SliceTableSetLocked(vslice, PSLICE_UNALLOCATED);
             return ZX_ERR_NO_MEMORY;
         }
         ZX_DEBUG_ASSERT(new_extent->GetKey() == vslice);
@@ -825,6 +972,7 @@ bool VPartition::SliceFreeLocked(size_t vslice) {
     if (extent->is_empty()) {
         slice_map_.erase(*extent);
     }
+    SliceTableSetLocked(vslice, PSLICE_UNALLOCATED);
 
     AddBlocksLocked(-(mgr_->SliceSize() / info_.block_size));
     return true;
@@ -835,6 +983,9 @@ void VPartition::ExtentDestroyLocked(size_t vslice) TA_REQ(lock_) {
     ZX_DEBUG_ASSERT(SliceCanFree(vslice));
     auto extent = --slice_map_.upper_bound(vslice);
     size_t length = extent->size();
+    for (size_t vs = extent->start(); vs < extent->end() && vs < kSliceTableMax; vs++) {
+        SliceTableSetLocked(vs, PSLICE_UNALLOCATED);
+    }
     slice_map_.erase(*extent);
     AddBlocksLocked(-((length * mgr_->SliceSize()) / info_.block_size));
 }
@@ -971,44 +1122,42 @@ zx_status_t VPartition::DdkIoctl(uint32_t op, const void* cmd, size_t cmdlen,
     case IOCTL_BLOCK_FVM_DESTROY_PARTITION: {
         return mgr_->FreeSlices(this, 0, mgr_->VSliceMax());
     }
+    case IOCTL_BLOCK_FVM_GET_SPLIT_STATS: {
+        if (max < sizeof(fvm_split_stats_t)) {
+            return ZX_ERR_BUFFER_TOO_SMALL;
+        }
+        fvm_split_stats_t* stats = static_cast<fvm_split_stats_t*>(reply);
+        stats->total_ops = total_ops_.load();
+        stats->split_ops = split_ops_.load();
+        stats->split_txns = split_txns_.load();
+        stats->pool_misses = pool_misses_.load();
+        *out_actual = sizeof(fvm_split_stats_t);
+        return ZX_OK;
+    }
     default:
         return ZX_ERR_NOT_SUPPORTED;
     }
 }
 
-typedef struct multi_txn_state {
-    multi_txn_state(size_t total, block_op_t* txn, block_impl_queue_callback cb, void* cookie)
-        : txns_completed(0), txns_total(total), status(ZX_OK), original(txn), completion_cb(cb),
-          cookie(cookie) {}
-
-    fbl::Mutex lock;
-    size_t txns_completed TA_GUARDED(lock);
-    size_t txns_total TA_GUARDED(lock);
-    zx_status_t status TA_GUARDED(lock);
-    block_op_t* original TA_GUARDED(lock);
-    block_impl_queue_callback completion_cb TA_GUARDED(lock);
-    void* cookie TA_GUARDED(lock);
-} multi_txn_state_t;
-
 static void multi_txn_completion(void* cookie, zx_status_t status, block_op_t* txn) {
-    multi_txn_state_t* state = static_cast<multi_txn_state_t*>(cookie);
-    bool last_txn = false;
+    SplitTxn* state = static_cast<SplitTxn*>(cookie);
     {
         fbl::AutoLock lock(&state->lock);
         state->txns_completed++;
         if (state->status == ZX_OK && status != ZX_OK) {
             state->status = status;
         }
-        if (state->txns_completed == state->txns_total) {
-            last_txn = true;
-            state->completion_cb(state->cookie, state->status, state->original);
+        if (state->txns_completed != state->txns_total) {
+            return;
         }
+        status = state->status;
     }
 
-    if (last_txn) {
-        delete state;
-    }
-    delete[] txn;
+    block_impl_queue_callback completion_cb = state->completion_cb;
+    void* original_cookie = state->cookie;
+    block_op_t* original = state->original;
+    state->vp->PutSplitTxn(fbl::unique_ptr<SplitTxn>(state));
+    completion_cb(original_cookie, status, original);
 }
 
 void VPartition::BlockImplQueue(block_op_t* txn, block_impl_queue_callback completion_cb,
@@ -1027,6 +1176,7 @@ void VPartition::BlockImplQueue(block_op_t* txn, block_impl_queue_callback compl
         completion_cb(cookie, ZX_ERR_NOT_SUPPORTED, txn);
         return;
     }
+    total_ops_.fetch_add(1, fbl::memory_order_relaxed);
 
     const uint64_t device_capacity = DdkGetSize() / BlockSize();
     if (txn->rw.length == 0) {
@@ -1085,16 +1235,23 @@ void VPartition::BlockImplQueue(block_op_t* txn, block_impl_queue_callback compl
 
     // Harder case: Noncontiguous slices
     const size_t txn_count = vslice_end - vslice_start + 1;
-    fbl::Vector<block_op_t*> txns;
-    txns.reserve(txn_count);
-
-    fbl::AllocChecker ac;
-    fbl::unique_ptr<multi_txn_state_t> state(
-        new (&ac) multi_txn_state_t(txn_count, txn, completion_cb, cookie));
-    if (!ac.check()) {
+    const size_t op_size = mgr_->BlockOpSize();
+    fbl::unique_ptr<SplitTxn> state = GetSplitTxn(txn_count);
+    if (state == nullptr) {
         completion_cb(cookie, ZX_ERR_NO_MEMORY, txn);
         return;
     }
+    {
+        fbl::AutoLock state_lock(&state->lock);
+        state->txns_completed = 0;
+        state->status = ZX_OK;
+    }
+    state->txns_total = txn_count;
+    state->original = txn;
+    state->completion_cb = completion_cb;
+    state->cookie = cookie;
+    split_ops_.fetch_add(1, fbl::memory_order_relaxed);
+    split_txns_.fetch_add(txn_count, fbl::memory_order_relaxed);
 
     uint32_t length_remaining = txn->rw.length;
     for (size_t i = 0; i < txn_count; i++) {
@@ -1110,35 +1267,28 @@ void VPartition::BlockImplQueue(block_op_t* txn, block_impl_queue_callback compl
             offset_vmo += txn->rw.length - length_remaining;
         } else {
             length = blocks_per_slice;
-            offset_vmo += txns[0]->rw.length + blocks_per_slice * (i - 1);
+            offset_vmo += state->op(0, op_size)->rw.length + blocks_per_slice * (i - 1);
         }
         ZX_DEBUG_ASSERT(length <= blocks_per_slice);
         ZX_DEBUG_ASSERT(length <= length_remaining);
 
-        txns.push_back(reinterpret_cast<block_op_t*>(new uint8_t[mgr_->BlockOpSize()]));
-        if (txns[i] == nullptr) {
-            while (i-- > 0) {
-                delete[] txns[i];
-            }
-            completion_cb(cookie, ZX_ERR_NO_MEMORY, txn);
-            return;
-        }
-        memcpy(txns[i], txn, sizeof(*txn));
-        txns[i]->rw.offset_vmo = offset_vmo;
-        txns[i]->rw.length = static_cast<uint32_t>(length);
-        txns[i]->rw.offset_dev = SliceStart(disk_size, slice_size, pslice) / BlockSize();
+        block_op_t* split = state->op(i, op_size);
+        memcpy(split, txn, sizeof(*txn));
+        split->rw.offset_vmo = offset_vmo;
+        split->rw.length = static_cast<uint32_t>(length);
+        split->rw.offset_dev = SliceStart(disk_size, slice_size, pslice) / BlockSize();
         if (vslice == vslice_start) {
-            txns[i]->rw.offset_dev += (txn->rw.offset_dev % blocks_per_slice);
+            split->rw.offset_dev += (txn->rw.offset_dev % blocks_per_slice);
         }
-        length_remaining -= txns[i]->rw.length;
+        length_remaining -= split->rw.length;
     }
     ZX_DEBUG_ASSERT(length_remaining == 0);
 
+    // The SplitTxn is owned by its split ops until the last of them completes.
+    SplitTxn* split_txn = state.release();
     for (size_t i = 0; i < txn_count; i++) {
-        mgr_->Queue(txns[i], multi_txn_completion, state.get());
+        mgr_->Queue(split_txn->op(i, op_size), multi_txn_completion, split_txn);
     }
-    // TODO(johngro): ask smklein why it is OK to release this managed pointer.
-    __UNUSED auto ptr = state.release();
 }
 
 zx_off_t VPartition::DdkGetSize() {
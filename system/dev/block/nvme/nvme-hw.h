@@ -79,6 +79,20 @@ static_assert(sizeof(nvme_cpl_t) == (1 << NVME_CPL_SHIFT), "");
 #define NVME_CPL_STATUS_CODE(n) (((n) >> 1) & 0x7FF)
 
 
+// Scatter Gather List Descriptor
+typedef struct {
+    uint64_t address;
+    uint32_t length;
+    uint8_t reserved[3];
+    uint8_t type;
+} nvme_sgl_desc_t;
+
+static_assert(sizeof(nvme_sgl_desc_t) == 16, "");
+
+#define NVME_SGL_TYPE_DATA_BLOCK   (0 << 4)
+#define NVME_SGL_TYPE_SEGMENT      (2 << 4)
+#define NVME_SGL_TYPE_LAST_SEGMENT (3 << 4)
+
 // Submission Queue Entry
 typedef struct {
     uint32_t cmd;
@@ -87,6 +101,7 @@ typedef struct {
     uint64_t mptr;
     union {
         uint64_t prp[2];
+        nvme_sgl_desc_t sgl;
     } dptr;
     union {
         uint32_t raw[6];
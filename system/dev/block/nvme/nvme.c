@@ -4,6 +4,7 @@
 
 #include <assert.h>
 #include <limits.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -25,6 +26,7 @@
 #include <lib/sync/completion.h>
 
 #include <zircon/device/block.h>
+#include <zircon/device/nvme.h>
 #include <zircon/syscalls.h>
 #include <zircon/types.h>
 #include <zircon/listnode.h>
@@ -39,6 +41,8 @@ typedef struct {
     block_impl_queue_callback completion_cb;
     void* cookie;
     uint16_t pending_utxns;
+    // how many commands have been issued for this txn
+    uint16_t commands;
     uint8_t opcode;
     uint8_t flags;
 } nvme_txn_t;
@@ -49,7 +53,7 @@ typedef struct {
     zx_handle_t pmt;    // pinned memory
     nvme_txn_t* txn;    // related txn
     uint16_t id;
-    uint16_t reserved0;
+    uint16_t prp_pool;  // bitmask of PRP list pages taken from the pool
     uint32_t reserved1;
 } nvme_utxn_t;
 
@@ -61,27 +65,62 @@ static_assert(PAGE_SIZE == (1ULL << PAGE_SHIFT), "");
 
 #define PAGE_MASK (PAGE_SIZE - 1ULL)
 
-// Limit maximum transfer size to 1MB which fits comfortably
-// within our single scatter gather page per utxn setup
-#define MAX_XFER (1024*1024)
+// Limit maximum transfer size to 4MB. A utxn's own page holds the PRP
+// list for up to 2MB; longer lists chain on through pages from the pool.
+#define MAX_XFER (4*1024*1024)
+#define MAX_XFER_PAGES (MAX_XFER / PAGE_SIZE + 1)
+
+// PRP list pages per io queue, shared by its utxns for transfers that
+// don't fit in one list page.
+#define PRP_POOL_PAGES 16
+#define PRP_PER_PAGE (PAGE_SIZE / sizeof(uint64_t))
+
+// SGL descriptors that fit in a utxn's page.
+#define SGL_PER_PAGE (PAGE_SIZE / sizeof(nvme_sgl_desc_t))
+
+// dedicated pages from the admin page pool
+#define IDX_ADMIN_SQ   0
+#define IDX_ADMIN_CQ   1
+#define IDX_SCRATCH    2
+
+#define ADMIN_PAGE_COUNT 3
+
+// dedicated pages from the page pool of each io queue
+#define IDX_IO_SQ      0
+#define IDX_IO_CQ      1
+#define IDX_PRP_POOL   2
+#define IDX_UTXN_POOL  (IDX_PRP_POOL + PRP_POOL_PAGES) // this must always be last
+
+#define IO_PAGE_COUNT  (IDX_UTXN_POOL + UTXN_COUNT)
 
 // Maximum submission and completion queue item counts, for
 // queues that are a single page in size.
 #define SQMAX (PAGE_SIZE / sizeof(nvme_cmd_t))
 #define CQMAX (PAGE_SIZE / sizeof(nvme_cpl_t))
 
+// Upper bound on the number of io queue pairs.
+#define MAX_IO_QUEUES 32
+
 // global driver state bits
-#define FLAG_IRQ_THREAD_STARTED  0x0001
-#define FLAG_IO_THREAD_STARTED   0x0002
 #define FLAG_SHUTDOWN            0x0004
 
 #define FLAG_HAS_VWC             0x0100
+#define FLAG_HAS_SGL             0x0200
+
+// io queue state bits
+#define FLAG_IRQ_THREAD_STARTED  0x0001
+#define FLAG_IO_THREAD_STARTED   0x0002
 
+typedef struct nvme_device nvme_device_t;
+
+// An io submission queue and the completion queue it completes to, each
+// with its own interrupt vector, threads, utxns and lock.
 typedef struct {
-    mmio_buffer_t mmio;
+    nvme_device_t* nvme;
     zx_handle_t irqh;
-    zx_handle_t bti;
     uint32_t flags;
+    // queue id used with the controller (the admin queue is 0)
+    uint16_t id;
     mtx_t lock;
 
     // io queue doorbell registers
@@ -90,13 +129,13 @@ typedef struct {
 
     nvme_cpl_t* io_cq;
     nvme_cmd_t* io_sq;
-    uint32_t io_nsid;
     uint16_t io_cq_head;
     uint16_t io_cq_toggle;
     uint16_t io_sq_tail;
     uint16_t io_sq_head;
 
     uint64_t utxn_avail;   // bitmask of available utxns
+    uint16_t prp_pool_avail; // bitmask of available PRP list pages
 
     // The pending list is txns that have been received
     // via nvme_queue() and are waiting for io to start.
@@ -114,6 +153,34 @@ typedef struct {
     // it has work to do.
     sync_completion_t io_signal;
 
+    // pages for the queues and the utxn scatter lists
+    io_buffer_t iob;
+
+    thrd_t irqthread;
+    thrd_t iothread;
+
+    // pool of utxns
+    nvme_utxn_t utxn[UTXN_COUNT];
+
+    // the pages of the transfer being set up by the io thread
+    zx_paddr_t pages[MAX_XFER_PAGES];
+
+    // counters; txns is kept under the lock, the rest by the io thread
+    nvme_stats_t stats;
+} nvme_queue_t;
+
+struct nvme_device {
+    mmio_buffer_t mmio;
+    zx_handle_t bti;
+    uint32_t flags;
+
+    // io queues, with queue i using interrupt vector i; the interrupts for
+    // the admin queue arrive on vector 0 as well
+    nvme_queue_t* queues;
+    uint32_t queue_count;
+    // how many of them the controller gave us, which io is spread over
+    uint32_t active_queues;
+
     uint32_t max_xfer;
     block_info_t info;
 
@@ -140,15 +207,9 @@ typedef struct {
 
     size_t iosz;
 
-    // source of physical pages for queues and admin commands
+    // source of physical pages for admin queues and commands
     io_buffer_t iob;
-
-    thrd_t irqthread;
-    thrd_t iothread;
-
-    // pool of utxns
-    nvme_utxn_t utxn[UTXN_COUNT];
-} nvme_device_t;
+};
 
 
 // We break IO transactions down into one or more "micro transactions" (utxn)
@@ -157,26 +218,28 @@ typedef struct {
 // queued to the NVME device.  This id is the same as its index into the
 // pool of utxns and the bitmask of free txns, to simplify management.
 //
-// We maintain a pool of 63 of these, which is the number of commands
+// Each io queue has a pool of 63 of these, which is the number of commands
 // that can be submitted to NVME via a single page submit queue.
 //
 // The utxns are not protected by locks.  Instead, after initialization,
-// they may only be touched by the io thread, which is responsible for
-// queueing commands and dequeuing completion messages.
+// they may only be touched by the io thread of their queue, which is
+// responsible for queueing commands and dequeuing completion messages.
 
-static nvme_utxn_t* utxn_get(nvme_device_t* nvme) {
-    uint64_t n = __builtin_ffsll(nvme->utxn_avail);
+static nvme_utxn_t* utxn_get(nvme_queue_t* q) {
+    uint64_t n = __builtin_ffsll(q->utxn_avail);
     if (n == 0) {
         return NULL;
     }
     n--;
-    nvme->utxn_avail &= ~(1ULL << n);
-    return nvme->utxn + n;
+    q->utxn_avail &= ~(1ULL << n);
+    return q->utxn + n;
 }
 
-static void utxn_put(nvme_device_t* nvme, nvme_utxn_t* utxn) {
+static void utxn_put(nvme_queue_t* q, nvme_utxn_t* utxn) {
     uint64_t n = utxn->id;
-    nvme->utxn_avail |= (1ULL << n);
+    q->utxn_avail |= (1ULL << n);
+    q->prp_pool_avail |= utxn->prp_pool;
+    utxn->prp_pool = 0;
 }
 
 static zx_status_t nvme_admin_cq_get(nvme_device_t* nvme, nvme_cpl_t* cpl) {
@@ -215,60 +278,62 @@ static zx_status_t nvme_admin_sq_put(nvme_device_t* nvme, nvme_cmd_t* cmd) {
     return ZX_OK;
 }
 
-static zx_status_t nvme_io_cq_get(nvme_device_t* nvme, nvme_cpl_t* cpl) {
-    if ((readw(&nvme->io_cq[nvme->io_cq_head].status) & 1) != nvme->io_cq_toggle) {
+static zx_status_t nvme_io_cq_get(nvme_queue_t* q, nvme_cpl_t* cpl) {
+    if ((readw(&q->io_cq[q->io_cq_head].status) & 1) != q->io_cq_toggle) {
         return ZX_ERR_SHOULD_WAIT;
     }
-    *cpl = nvme->io_cq[nvme->io_cq_head];
+    *cpl = q->io_cq[q->io_cq_head];
 
     // advance the head pointer, wrapping and inverting toggle at max
-    uint16_t next = (nvme->io_cq_head + 1) & (CQMAX - 1);
-    if ((nvme->io_cq_head = next) == 0) {
-        nvme->io_cq_toggle ^= 1;
+    uint16_t next = (q->io_cq_head + 1) & (CQMAX - 1);
+    if ((q->io_cq_head = next) == 0) {
+        q->io_cq_toggle ^= 1;
     }
 
     // note the new sq head reported by hw
-    nvme->io_sq_head = cpl->sq_head;
+    q->io_sq_head = cpl->sq_head;
     return ZX_OK;
 }
 
-static void nvme_io_cq_ack(nvme_device_t* nvme) {
+static void nvme_io_cq_ack(nvme_queue_t* q) {
     // ring the doorbell
-    writel(nvme->io_cq_head, nvme->io_cq_head_db);
+    writel(q->io_cq_head, q->io_cq_head_db);
 }
 
-static zx_status_t nvme_io_sq_put(nvme_device_t* nvme, nvme_cmd_t* cmd) {
-    uint16_t next = (nvme->io_sq_tail + 1) & (SQMAX - 1);
+static zx_status_t nvme_io_sq_put(nvme_queue_t* q, nvme_cmd_t* cmd) {
+    uint16_t next = (q->io_sq_tail + 1) & (SQMAX - 1);
 
     // if head+1 == tail: queue is full
-    if (next == nvme->io_sq_head) {
+    if (next == q->io_sq_head) {
         return ZX_ERR_SHOULD_WAIT;
     }
 
-    nvme->io_sq[nvme->io_sq_tail] = *cmd;
-    nvme->io_sq_tail = next;
+    q->io_sq[q->io_sq_tail] = *cmd;
+    q->io_sq_tail = next;
 
     // ring the doorbell
-    writel(next, nvme->io_sq_tail_db);
+    writel(next, q->io_sq_tail_db);
     return ZX_OK;
 }
 
 static int irq_thread(void* arg) {
-    nvme_device_t* nvme = arg;
+    nvme_queue_t* q = arg;
+    nvme_device_t* nvme = q->nvme;
     for (;;) {
         zx_status_t r;
-        if ((r = zx_interrupt_wait(nvme->irqh, NULL)) != ZX_OK) {
+        if ((r = zx_interrupt_wait(q->irqh, NULL)) != ZX_OK) {
             zxlogf(ERROR, "nvme: irq wait failed: %d\n", r);
             break;
         }
 
+        // the admin queue shares the first vector
         nvme_cpl_t cpl;
-        if (nvme_admin_cq_get(nvme, &cpl) == ZX_OK) {
+        if ((q == nvme->queues) && (nvme_admin_cq_get(nvme, &cpl) == ZX_OK)) {
             nvme->admin_result = cpl;
             sync_completion_signal(&nvme->admin_signal);
         }
 
-        sync_completion_signal(&nvme->io_signal);
+        sync_completion_signal(&q->io_signal);
     }
     return 0;
 }
@@ -302,10 +367,105 @@ static inline void txn_complete(nvme_txn_t* txn, zx_status_t status) {
     txn->completion_cb(txn->cookie, status, &txn->op);
 }
 
+// Describe the data of |cmd| with an SGL, with one data block descriptor
+// for each physically contiguous run of |pages|. The list goes in the
+// utxn's page, unless there's only one run, which fits in the command.
+// Returns false if there are too many runs to fit.
+static bool io_build_sgl(nvme_utxn_t* utxn, nvme_cmd_t* cmd, const zx_paddr_t* pages,
+                         size_t pagecount, size_t byteoffset, size_t bytes) {
+    nvme_sgl_desc_t* list = utxn->virt;
+    size_t n = 0;
+
+    zx_paddr_t addr = pages[0] + byteoffset;
+    size_t len = PAGE_SIZE - byteoffset;
+    if (len > bytes) {
+        len = bytes;
+    }
+    size_t remaining = bytes - len;
+    for (size_t i = 1; i < pagecount; i++) {
+        size_t chunk = (remaining > PAGE_SIZE) ? PAGE_SIZE : remaining;
+        if (pages[i] == addr + len) {
+            len += chunk;
+        } else {
+            if (n == SGL_PER_PAGE - 1) {
+                return false;
+            }
+            list[n++] = (nvme_sgl_desc_t) {
+                .address = addr, .length = len, .type = NVME_SGL_TYPE_DATA_BLOCK,
+            };
+            addr = pages[i];
+            len = chunk;
+        }
+        remaining -= chunk;
+    }
+
+    nvme_sgl_desc_t last = {
+        .address = addr, .length = len, .type = NVME_SGL_TYPE_DATA_BLOCK,
+    };
+    if (n == 0) {
+        cmd->dptr.sgl = last;
+    } else {
+        list[n++] = last;
+        cmd->dptr.sgl = (nvme_sgl_desc_t) {
+            .address = utxn->phys,
+            .length = n * sizeof(nvme_sgl_desc_t),
+            .type = NVME_SGL_TYPE_LAST_SEGMENT,
+        };
+    }
+    cmd->cmd |= NVME_CMD_SGL;
+    return true;
+}
+
+// Describe the data of |cmd| with PRPs.
+// The NVME command has room for two data pointers inline.
+// The first is always the pointer to the first page where data is.
+// The second is the second page if pagecount is 2.
+// The second is the address of a list of pages 2..n if pagecount > 2,
+// which starts in the utxn's page and goes on through pages from the
+// pool, each linked to from the last entry of the page before it.
+// Returns false if the pool doesn't have enough pages right now.
+static bool io_build_prp(nvme_queue_t* q, nvme_utxn_t* utxn, nvme_cmd_t* cmd,
+                         const zx_paddr_t* pages, size_t pagecount, size_t byteoffset) {
+    cmd->dptr.prp[0] = pages[0] | byteoffset;
+    if (pagecount == 1) {
+        return true;
+    }
+    if (pagecount == 2) {
+        cmd->dptr.prp[1] = pages[1];
+        return true;
+    }
+
+    size_t entries = pagecount - 1;
+    size_t extra = (entries - 2) / (PRP_PER_PAGE - 1);
+    if ((size_t)__builtin_popcount(q->prp_pool_avail) < extra) {
+        q->stats.prp_pool_waits++;
+        return false;
+    }
+
+    uint64_t* list = utxn->virt;
+    cmd->dptr.prp[1] = utxn->phys;
+    pages++;
+    while (entries > PRP_PER_PAGE) {
+        unsigned n = __builtin_ctz(q->prp_pool_avail);
+        q->prp_pool_avail &= ~(1u << n);
+        utxn->prp_pool |= (1u << n);
+        q->stats.prp_pool_pages++;
+
+        memcpy(list, pages, (PRP_PER_PAGE - 1) * sizeof(uint64_t));
+        list[PRP_PER_PAGE - 1] = q->iob.phys_list[IDX_PRP_POOL + n];
+        list = q->iob.virt + (IDX_PRP_POOL + n) * PAGE_SIZE;
+        pages += PRP_PER_PAGE - 1;
+        entries -= PRP_PER_PAGE - 1;
+    }
+    memcpy(list, pages, entries * sizeof(uint64_t));
+    return true;
+}
+
 // Attempt to generate utxns and queue nvme commands for a txn
 // Returns true if this could not be completed due to temporary
 // lack of resources or false if either it succeeded or errored out.
-static bool io_process_txn(nvme_device_t* nvme, nvme_txn_t* txn) {
+static bool io_process_txn(nvme_queue_t* q, nvme_txn_t* txn) {
+    nvme_device_t* nvme = q->nvme;
     zx_handle_t vmo = txn->op.rw.vmo;
     nvme_utxn_t* utxn;
     zx_paddr_t* pages;
@@ -314,7 +474,7 @@ static bool io_process_txn(nvme_device_t* nvme, nvme_txn_t* txn) {
     for (;;) {
         // If there are no available utxns, we can't proceed
         // and we tell the caller to retain the txn (true)
-        if ((utxn = utxn_get(nvme)) == NULL) {
+        if ((utxn = utxn_get(q)) == NULL) {
             return true;
         }
 
@@ -339,7 +499,7 @@ static bool io_process_txn(nvme_device_t* nvme, nvme_txn_t* txn) {
         // write memory (PERM_READ) -> disk (OP_WRITE)
         uint32_t opt = (txn->opcode == NVME_OP_READ) ? ZX_BTI_PERM_WRITE : ZX_BTI_PERM_READ;
 
-        pages = utxn->virt;
+        pages = q->pages;
 
         if ((r = zx_bti_pin(nvme->bti, opt, vmo, pageoffset, pagecount << PAGE_SHIFT,
                             pages, pagecount, &utxn->pmt)) != ZX_OK) {
@@ -349,19 +509,20 @@ static bool io_process_txn(nvme_device_t* nvme, nvme_txn_t* txn) {
 
         nvme_cmd_t cmd;
         memset(&cmd, 0, sizeof(cmd));
-        cmd.cmd = NVME_CMD_CID(utxn->id) | NVME_CMD_PRP | NVME_CMD_NORMAL | NVME_CMD_OPC(txn->opcode);
+        cmd.cmd = NVME_CMD_CID(utxn->id) | NVME_CMD_NORMAL | NVME_CMD_OPC(txn->opcode);
         cmd.nsid = 1;
         cmd.u.rw.start_lba = txn->op.rw.offset_dev;
         cmd.u.rw.block_count = blocks - 1;
-        // The NVME command has room for two data pointers inline.
-        // The first is always the pointer to the first page where data is.
-        // The second is the second page if pagecount is 2.
-        // The second is the address of an array of page 2..n if pagecount > 2
-        cmd.dptr.prp[0] = pages[0] | byteoffset;
-        if (pagecount == 2) {
-            cmd.dptr.prp[1] = pages[1];
-        } else if (pagecount > 2) {
-            cmd.dptr.prp[1] = utxn->phys + sizeof(uint64_t);
+        if ((nvme->flags & FLAG_HAS_SGL) &&
+            io_build_sgl(utxn, &cmd, pages, pagecount, byteoffset, bytes)) {
+            q->stats.sgl_commands++;
+        } else if (!io_build_prp(q, utxn, &cmd, pages, pagecount, byteoffset)) {
+            // try again once earlier commands give their list pages back
+            if ((r = zx_pmt_unpin(utxn->pmt)) != ZX_OK) {
+                zxlogf(ERROR, "nvme: cannot unpin io buffer: %d\n", r);
+            }
+            utxn_put(q, utxn);
+            return true;
         }
 
         zxlogf(TRACE, "nvme: txn=%p utxn id=%u pages=%zu op=%s\n", txn, utxn->id, pagecount,
@@ -370,12 +531,16 @@ static bool io_process_txn(nvme_device_t* nvme, nvme_txn_t* txn) {
         zxlogf(SPEW, "nvme: pages[] = { %016zx, %016zx, %016zx, %016zx, ... }\n",
                pages[0], pages[1], pages[2], pages[3]);
 
-        if ((r = nvme_io_sq_put(nvme, &cmd)) != ZX_OK) {
+        if ((r = nvme_io_sq_put(q, &cmd)) != ZX_OK) {
             zxlogf(ERROR, "nvme: could not submit cmd (txn=%p id=%u)\n", txn, utxn->id);
             break;
         }
 
         utxn->txn = txn;
+        q->stats.commands++;
+        if (++txn->commands == 2) {
+            q->stats.split_txns++;
+        }
 
         // keep track of where we are
         txn->op.rw.offset_dev += blocks;
@@ -387,9 +552,9 @@ static bool io_process_txn(nvme_device_t* nvme, nvme_txn_t* txn) {
         // move this txn to the active list and tell the
         // caller not to retain the txn (false)
         if (txn->op.rw.length == 0) {
-            mtx_lock(&nvme->lock);
-            list_add_tail(&nvme->active_txns, &txn->node);
-            mtx_unlock(&nvme->lock);
+            mtx_lock(&q->lock);
+            list_add_tail(&q->active_txns, &txn->node);
+            mtx_unlock(&q->lock);
             return false;
         }
     }
@@ -398,17 +563,17 @@ static bool io_process_txn(nvme_device_t* nvme, nvme_txn_t* txn) {
     if ((r = zx_pmt_unpin(utxn->pmt)) != ZX_OK) {
         zxlogf(ERROR, "nvme: cannot unpin io buffer: %d\n", r);
     }
-    utxn_put(nvme, utxn);
+    utxn_put(q, utxn);
 
-    mtx_lock(&nvme->lock);
+    mtx_lock(&q->lock);
     txn->flags |= TXN_FLAG_FAILED;
     if (txn->pending_utxns) {
         // if there are earlier uncompleted IOs we become active now
         // and will finish erroring out when they complete
-        list_add_tail(&nvme->active_txns, &txn->node);
+        list_add_tail(&q->active_txns, &txn->node);
         txn = NULL;
     }
-    mtx_unlock(&nvme->lock);
+    mtx_unlock(&q->lock);
 
     if (txn != NULL) {
         txn_complete(txn, ZX_ERR_INTERNAL);
@@ -418,40 +583,40 @@ static bool io_process_txn(nvme_device_t* nvme, nvme_txn_t* txn) {
     return false;
 }
 
-static void io_process_txns(nvme_device_t* nvme) {
+static void io_process_txns(nvme_queue_t* q) {
     nvme_txn_t* txn;
 
     for (;;) {
-        mtx_lock(&nvme->lock);
-        txn = list_remove_head_type(&nvme->pending_txns, nvme_txn_t, node);
-        mtx_unlock(&nvme->lock);
+        mtx_lock(&q->lock);
+        txn = list_remove_head_type(&q->pending_txns, nvme_txn_t, node);
+        mtx_unlock(&q->lock);
 
         if (txn == NULL) {
             return;
         }
 
-        if (io_process_txn(nvme, txn)) {
+        if (io_process_txn(q, txn)) {
             // put txn back at front of queue for further processing later
-            mtx_lock(&nvme->lock);
-            list_add_head(&nvme->pending_txns, &txn->node);
-            mtx_unlock(&nvme->lock);
+            mtx_lock(&q->lock);
+            list_add_head(&q->pending_txns, &txn->node);
+            mtx_unlock(&q->lock);
             return;
         }
     }
 }
 
-static void io_process_cpls(nvme_device_t* nvme) {
+static void io_process_cpls(nvme_queue_t* q) {
     bool ring_doorbell = false;
     nvme_cpl_t cpl;
 
-    while (nvme_io_cq_get(nvme, &cpl) == ZX_OK) {
+    while (nvme_io_cq_get(q, &cpl) == ZX_OK) {
         ring_doorbell = true;
 
         if (cpl.cmd_id >= UTXN_COUNT) {
             zxlogf(ERROR, "nvme: unexpected cmd id %u\n", cpl.cmd_id);
             continue;
         }
-        nvme_utxn_t* utxn = nvme->utxn + cpl.cmd_id;
+        nvme_utxn_t* utxn = q->utxn + cpl.cmd_id;
         nvme_txn_t* txn = utxn->txn;
 
         if (txn == NULL) {
@@ -478,48 +643,63 @@ static void io_process_cpls(nvme_device_t* nvme) {
 
         // release the microtransaction
         utxn->txn = NULL;
-        utxn_put(nvme, utxn);
+        utxn_put(q, utxn);
 
         txn->pending_utxns--;
         if ((txn->pending_utxns == 0) && (txn->op.rw.length == 0)) {
             // remove from either pending or active list
-            mtx_lock(&nvme->lock);
+            mtx_lock(&q->lock);
             list_delete(&txn->node);
-            mtx_unlock(&nvme->lock);
+            mtx_unlock(&q->lock);
             zxlogf(TRACE, "nvme: txn %p %s\n", txn, txn->flags & TXN_FLAG_FAILED ? "error" : "okay");
             txn_complete(txn, txn->flags & TXN_FLAG_FAILED ? ZX_ERR_IO : ZX_OK);
         }
     }
 
     if (ring_doorbell) {
-        nvme_io_cq_ack(nvme);
+        nvme_io_cq_ack(q);
     }
 }
 
 static int io_thread(void* arg) {
-    nvme_device_t* nvme = arg;
+    nvme_queue_t* q = arg;
     for (;;) {
-        if (sync_completion_wait(&nvme->io_signal, ZX_TIME_INFINITE)) {
+        if (sync_completion_wait(&q->io_signal, ZX_TIME_INFINITE)) {
             break;
         }
-        if (nvme->flags & FLAG_SHUTDOWN) {
+        if (q->nvme->flags & FLAG_SHUTDOWN) {
             //TODO: cancel out pending IO
             zxlogf(INFO, "nvme: io thread exiting\n");
             break;
         }
 
-        sync_completion_reset(&nvme->io_signal);
+        sync_completion_reset(&q->io_signal);
 
         // process completion messages
-        io_process_cpls(nvme);
+        io_process_cpls(q);
 
         // process work queue
-        io_process_txns(nvme);
+        io_process_txns(q);
 
     }
     return 0;
 }
 
+// Each submitting thread sticks to one io queue, handed out in turn.
+// There's no way to ask which CPU we're on, but a thread mostly keeps to
+// one, and this keeps its ops in order on a queue of their own.
+static atomic_uint next_thread_queue;
+static _Thread_local uint32_t thread_queue;
+static _Thread_local bool thread_queue_assigned;
+
+static nvme_queue_t* nvme_pick_queue(nvme_device_t* nvme) {
+    if (!thread_queue_assigned) {
+        thread_queue = atomic_fetch_add(&next_thread_queue, 1);
+        thread_queue_assigned = true;
+    }
+    return nvme->queues + (thread_queue % nvme->active_queues);
+}
+
 static void nvme_queue(void* ctx, block_op_t* op, block_impl_queue_callback completion_cb,
                        void* cookie) {
     nvme_device_t* nvme = ctx;
@@ -558,17 +738,20 @@ static void nvme_queue(void* ctx, block_op_t* op, block_impl_queue_callback comp
     txn->op.rw.offset_vmo *= nvme->info.block_size;
 
     txn->pending_utxns = 0;
+    txn->commands = 0;
     txn->flags = 0;
 
     zxlogf(SPEW, "nvme: io: %s: %ublks @ blk#%zu\n",
            txn->opcode == NVME_OP_WRITE ? "wr" : "rd",
            txn->op.rw.length + 1U, txn->op.rw.offset_dev);
 
-    mtx_lock(&nvme->lock);
-    list_add_tail(&nvme->pending_txns, &txn->node);
-    mtx_unlock(&nvme->lock);
+    nvme_queue_t* q = nvme_pick_queue(nvme);
+    mtx_lock(&q->lock);
+    q->stats.txns++;
+    list_add_tail(&q->pending_txns, &txn->node);
+    mtx_unlock(&q->lock);
 
-    sync_completion_signal(&nvme->io_signal);
+    sync_completion_signal(&q->io_signal);
 }
 
 static void nvme_query(void* ctx, block_info_t* info_out, size_t* block_op_size_out) {
@@ -593,6 +776,24 @@ static zx_status_t nvme_ioctl(void* ctx, uint32_t op, const void* cmd, size_t cm
     case IOCTL_DEVICE_SYNC: {
         return ZX_OK;
     }
+    case IOCTL_NVME_GET_STATS: {
+        if (max < sizeof(nvme_stats_t)) {
+            return ZX_ERR_BUFFER_TOO_SMALL;
+        }
+        nvme_stats_t* stats = reply;
+        memset(stats, 0, sizeof(*stats));
+        for (uint32_t i = 0; i < nvme->active_queues; i++) {
+            const nvme_stats_t* qs = &nvme->queues[i].stats;
+            stats->txns += qs->txns;
+            stats->commands += qs->commands;
+            stats->split_txns += qs->split_txns;
+            stats->sgl_commands += qs->sgl_commands;
+            stats->prp_pool_pages += qs->prp_pool_pages;
+            stats->prp_pool_waits += qs->prp_pool_waits;
+        }
+        *out_actual = sizeof(nvme_stats_t);
+        return ZX_OK;
+    }
     default:
         return ZX_ERR_NOT_SUPPORTED;
     }
@@ -623,28 +824,36 @@ static void nvme_release(void* ctx) {
         mmio_buffer_release(&nvme->mmio);
         // TODO: risks a handle use-after-close, will be resolved by IRQ api
         // changes coming soon
-        zx_handle_close(nvme->irqh);
-    }
-    if (nvme->flags & FLAG_IRQ_THREAD_STARTED) {
-        thrd_join(nvme->irqthread, &r);
-    }
-    if (nvme->flags & FLAG_IO_THREAD_STARTED) {
-        sync_completion_signal(&nvme->io_signal);
-        thrd_join(nvme->iothread, &r);
+        for (uint32_t i = 0; i < nvme->queue_count; i++) {
+            zx_handle_close(nvme->queues[i].irqh);
+        }
     }
+    for (uint32_t i = 0; i < nvme->queue_count; i++) {
+        nvme_queue_t* q = nvme->queues + i;
+        if (q->flags & FLAG_IRQ_THREAD_STARTED) {
+            thrd_join(q->irqthread, &r);
+        }
+        if (q->flags & FLAG_IO_THREAD_STARTED) {
+            sync_completion_signal(&q->io_signal);
+            thrd_join(q->iothread, &r);
+        }
 
-    // error out any pending txns
-    mtx_lock(&nvme->lock);
-    nvme_txn_t* txn;
-    while ((txn = list_remove_head_type(&nvme->active_txns, nvme_txn_t, node)) != NULL) {
-        txn_complete(txn, ZX_ERR_PEER_CLOSED);
-    }
-    while ((txn = list_remove_head_type(&nvme->pending_txns, nvme_txn_t, node)) != NULL) {
-        txn_complete(txn, ZX_ERR_PEER_CLOSED);
+        // error out any pending txns
+        mtx_lock(&q->lock);
+        nvme_txn_t* txn;
+        while ((txn = list_remove_head_type(&q->active_txns, nvme_txn_t, node)) != NULL) {
+            txn_complete(txn, ZX_ERR_PEER_CLOSED);
+        }
+        while ((txn = list_remove_head_type(&q->pending_txns, nvme_txn_t, node)) != NULL) {
+            txn_complete(txn, ZX_ERR_PEER_CLOSED);
+        }
+        mtx_unlock(&q->lock);
+
+        io_buffer_release(&q->iob);
     }
-    mtx_unlock(&nvme->lock);
 
     io_buffer_release(&nvme->iob);
+    free(nvme->queues);
     free(nvme);
 }
 
@@ -690,16 +899,6 @@ static void infostring(const char* prefix, uint8_t* str, size_t len) {
 #define wr32(v,r) writel(v, nvme->mmio.vaddr + NVME_REG_##r)
 #define wr64(v,r) writell(v, nvme->mmio.vaddr + NVME_REG_##r)
 
-// dedicated pages from the page pool
-#define IDX_ADMIN_SQ   0
-#define IDX_ADMIN_CQ   1
-#define IDX_IO_SQ      2
-#define IDX_IO_CQ      3
-#define IDX_SCRATCH    4
-#define IDX_UTXN_POOL  5 // this must always be last
-
-#define IO_PAGE_COUNT  (IDX_UTXN_POOL + UTXN_COUNT)
-
 static inline uint64_t U64(uint8_t* x) {
     return *((uint64_t*) (void*) x);
 }
@@ -712,6 +911,70 @@ static inline uint32_t U16(uint8_t* x) {
 
 #define WAIT_MS 5000
 
+// Create io queue pair |q| with the controller, and start its io thread.
+static zx_status_t nvme_init_queue(nvme_device_t* nvme, nvme_queue_t* q, uint64_t cap) {
+    if (io_buffer_init(&q->iob, nvme->bti, PAGE_SIZE * IO_PAGE_COUNT, IO_BUFFER_RW) ||
+        io_buffer_physmap(&q->iob)) {
+        zxlogf(ERROR, "nvme: could not allocate io buffers\n");
+        return ZX_ERR_NO_MEMORY;
+    }
+
+    // initialize the microtransaction and PRP list pools
+    q->utxn_avail = 0x7FFFFFFFFFFFFFFFULL;
+    q->prp_pool_avail = (1u << PRP_POOL_PAGES) - 1;
+    for (unsigned n = 0; n < UTXN_COUNT; n++) {
+        q->utxn[n].id = n;
+        q->utxn[n].phys = q->iob.phys_list[IDX_UTXN_POOL + n];
+        q->utxn[n].virt = q->iob.virt + (IDX_UTXN_POOL + n) * PAGE_SIZE;
+    }
+
+    // registers and buffers for IO queues
+    q->io_sq_tail_db = nvme->mmio.vaddr + NVME_REG_SQnTDBL(q->id, cap);
+    q->io_cq_head_db = nvme->mmio.vaddr + NVME_REG_CQnHDBL(q->id, cap);
+
+    q->io_sq = q->iob.virt + PAGE_SIZE * IDX_IO_SQ;
+    q->io_sq_head = 0;
+    q->io_sq_tail = 0;
+
+    q->io_cq = q->iob.virt + PAGE_SIZE * IDX_IO_CQ;
+    q->io_cq_head = 0;
+    q->io_cq_toggle = 1;
+
+    uint32_t vector = q->id - 1;
+
+    // create the IO completion queue
+    nvme_cmd_t cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.cmd = NVME_CMD_CID(0) | NVME_CMD_PRP | NVME_CMD_NORMAL | NVME_CMD_OPC(NVME_ADMIN_OP_CREATE_IOCQ);
+    cmd.dptr.prp[0] = q->iob.phys_list[IDX_IO_CQ];
+    cmd.u.raw[0] = ((CQMAX - 1) << 16) | q->id; // queue size, queue id
+    cmd.u.raw[1] = (vector << 16) | 2 | 1; // irq vector, irq enable, phys contig
+
+    if (nvme_admin_txn(nvme, &cmd, NULL) != ZX_OK) {
+        zxlogf(ERROR, "nvme: completion queue creation op failed\n");
+        return ZX_ERR_INTERNAL;
+    }
+
+    // create the IO submit queue
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.cmd = NVME_CMD_CID(0) | NVME_CMD_PRP | NVME_CMD_NORMAL | NVME_CMD_OPC(NVME_ADMIN_OP_CREATE_IOSQ);
+    cmd.dptr.prp[0] = q->iob.phys_list[IDX_IO_SQ];
+    cmd.u.raw[0] = ((SQMAX - 1) << 16) | q->id; // queue size, queue id
+    cmd.u.raw[1] = (q->id << 16) | 0 | 1; // cqid, qprio, phys contig
+
+    if (nvme_admin_txn(nvme, &cmd, NULL) != ZX_OK) {
+        zxlogf(ERROR, "nvme: submit queue creation op failed\n");
+        return ZX_ERR_INTERNAL;
+    }
+
+    if (thrd_create_with_name(&q->iothread, io_thread, q, "nvme-io-thread")) {
+        zxlogf(ERROR, "nvme; cannot create io thread\n");
+        return ZX_ERR_INTERNAL;
+    }
+    q->flags |= FLAG_IO_THREAD_STARTED;
+    return ZX_OK;
+}
+
 static zx_status_t nvme_init(nvme_device_t* nvme) {
     uint32_t n = rd32(VS);
     uint64_t cap = rd64(CAP);
@@ -734,22 +997,15 @@ static zx_status_t nvme_init(nvme_device_t* nvme) {
         zxlogf(ERROR, "nvme: minimum page size larger than platform page size\n");
         return ZX_ERR_NOT_SUPPORTED;
     }
-    // allocate pages for various queues and the utxn scatter lists
+    // allocate pages for the admin queues; the io queues get theirs once
+    // we know how many of them there are
     // TODO: these should all be RO to hardware apart from the scratch io page(s)
-    if (io_buffer_init(&nvme->iob, nvme->bti, PAGE_SIZE * IO_PAGE_COUNT, IO_BUFFER_RW) ||
+    if (io_buffer_init(&nvme->iob, nvme->bti, PAGE_SIZE * ADMIN_PAGE_COUNT, IO_BUFFER_RW) ||
         io_buffer_physmap(&nvme->iob)) {
         zxlogf(ERROR, "nvme: could not allocate io buffers\n");
         return ZX_ERR_NO_MEMORY;
     }
 
-    // initialize the microtransaction pool
-    nvme->utxn_avail = 0x7FFFFFFFFFFFFFFFULL;
-    for (unsigned n = 0; n < UTXN_COUNT; n++) {
-        nvme->utxn[n].id = n;
-        nvme->utxn[n].phys = nvme->iob.phys_list[IDX_UTXN_POOL + n];
-        nvme->utxn[n].virt = nvme->iob.virt + (IDX_UTXN_POOL + n) * PAGE_SIZE;
-    }
-
     if (rd32(CSTS) & NVME_CSTS_RDY) {
         zxlogf(INFO, "nvme: controller is active. resetting...\n");
         wr32(rd32(CC) & ~NVME_CC_EN, CC); // disable
@@ -799,32 +1055,17 @@ static zx_status_t nvme_init(nvme_device_t* nvme) {
     nvme->admin_cq_head = 0;
     nvme->admin_cq_toggle = 1;
 
-    // registers and buffers for IO queues
-    nvme->io_sq_tail_db = nvme->mmio.vaddr + NVME_REG_SQnTDBL(1, cap);
-    nvme->io_cq_head_db = nvme->mmio.vaddr + NVME_REG_CQnHDBL(1, cap);
-
-    nvme->io_sq = nvme->iob.virt + PAGE_SIZE * IDX_IO_SQ;
-    nvme->io_sq_head = 0;
-    nvme->io_sq_tail = 0;
-
-    nvme->io_cq = nvme->iob.virt + PAGE_SIZE * IDX_IO_CQ;
-    nvme->io_cq_head = 0;
-    nvme->io_cq_toggle = 1;
-
     // scratch page for admin ops
     void* scratch = nvme->iob.virt + PAGE_SIZE * IDX_SCRATCH;
 
-    if (thrd_create_with_name(&nvme->irqthread, irq_thread, nvme, "nvme-irq-thread")) {
-        zxlogf(ERROR, "nvme; cannot create irq thread\n");
-        return ZX_ERR_INTERNAL;
-    }
-    nvme->flags |= FLAG_IRQ_THREAD_STARTED;
-
-    if (thrd_create_with_name(&nvme->iothread, io_thread, nvme, "nvme-io-thread")) {
-        zxlogf(ERROR, "nvme; cannot create io thread\n");
-        return ZX_ERR_INTERNAL;
+    for (uint32_t i = 0; i < nvme->queue_count; i++) {
+        nvme_queue_t* q = nvme->queues + i;
+        if (thrd_create_with_name(&q->irqthread, irq_thread, q, "nvme-irq-thread")) {
+            zxlogf(ERROR, "nvme; cannot create irq thread\n");
+            return ZX_ERR_INTERNAL;
+        }
+        q->flags |= FLAG_IRQ_THREAD_STARTED;
     }
-    nvme->flags |= FLAG_IO_THREAD_STARTED;
 
     nvme_cmd_t cmd;
 
@@ -861,6 +1102,9 @@ static zx_status_t nvme_init(nvme_device_t* nvme) {
     zxlogf(INFO, "nvme: max namespaces: %u\n", nscount);
     zxlogf(INFO, "nvme: scatter gather lists (SGL): %c %08x\n",
            (ci->SGLS & 3) ? 'Y' : 'N', ci->SGLS);
+    if (ci->SGLS & 3) {
+        nvme->flags |= FLAG_HAS_SGL;
+    }
 
     // Maximum transfer is in units of 2^n * PAGESIZE, n == 0 means "infinite"
     nvme->max_xfer = 0xFFFFFFFF;
@@ -902,11 +1146,11 @@ static zx_status_t nvme_init(nvme_device_t* nvme) {
     FEATURE(ONCS, WRITE_UNCORRECTABLE);
     FEATURE(ONCS, COMPARE);
 
-    // set feature (number of queues) to 1 iosq and 1 iocq
+    // set feature (number of queues) to one iosq and iocq per io queue
     memset(&cmd, 0, sizeof(cmd));
     cmd.cmd = NVME_CMD_CID(0) | NVME_CMD_PRP | NVME_CMD_NORMAL | NVME_CMD_OPC(NVME_ADMIN_OP_SET_FEATURE);
     cmd.u.raw[0] = NVME_FEATURE_NUMBER_OF_QUEUES;
-    cmd.u.raw[1] = 0;
+    cmd.u.raw[1] = ((nvme->queue_count - 1) << 16) | (nvme->queue_count - 1);
 
     nvme_cpl_t cpl;
     if (nvme_admin_txn(nvme, &cmd, &cpl) != ZX_OK) {
@@ -915,29 +1159,27 @@ static zx_status_t nvme_init(nvme_device_t* nvme) {
     }
     zxlogf(INFO,"cpl.cmd %08x\n", cpl.cmd);
 
-    // create the IO completion queue
-    memset(&cmd, 0, sizeof(cmd));
-    cmd.cmd = NVME_CMD_CID(0) | NVME_CMD_PRP | NVME_CMD_NORMAL | NVME_CMD_OPC(NVME_ADMIN_OP_CREATE_IOCQ);
-    cmd.dptr.prp[0] = nvme->iob.phys_list[IDX_IO_CQ];
-    cmd.u.raw[0] = ((CQMAX - 1) << 16) | 1; // queue size, queue id
-    cmd.u.raw[1] = (0 << 16) | 2 | 1; // irq vector, irq enable, phys contig
-
-    if (nvme_admin_txn(nvme, &cmd, NULL) != ZX_OK) {
-        zxlogf(ERROR, "nvme: completion queue creation op failed\n");
-        return ZX_ERR_INTERNAL;
+    // the controller may grant fewer queues than we asked for
+    uint32_t nsqa = (cpl.cmd & 0xFFFF) + 1;
+    uint32_t ncqa = (cpl.cmd >> 16) + 1;
+    uint32_t active = nvme->queue_count;
+    if (active > nsqa) {
+        active = nsqa;
     }
+    if (active > ncqa) {
+        active = ncqa;
+    }
+    zxlogf(INFO, "nvme: io queues: %u (sq/cq allocated: %u/%u)\n", active, nsqa, ncqa);
 
-    // create the IO submit queue
-    memset(&cmd, 0, sizeof(cmd));
-    cmd.cmd = NVME_CMD_CID(0) | NVME_CMD_PRP | NVME_CMD_NORMAL | NVME_CMD_OPC(NVME_ADMIN_OP_CREATE_IOSQ);
-    cmd.dptr.prp[0] = nvme->iob.phys_list[IDX_IO_SQ];
-    cmd.u.raw[0] = ((SQMAX - 1) << 16) | 1; // queue size, queue id
-    cmd.u.raw[1] = (1 << 16) | 0 | 1; // cqid, qprio, phys contig
-
-    if (nvme_admin_txn(nvme, &cmd, NULL) != ZX_OK) {
-        zxlogf(ERROR, "nvme: submit queue creation op failed\n");
-        return ZX_ERR_INTERNAL;
+    for (uint32_t i = 0; i < active; i++) {
+        zx_status_t r;
+        if ((r = nvme_init_queue(nvme, nvme->queues + i, cap)) != ZX_OK) {
+            return r;
+        }
     }
+    // The rest keep their irq threads, which never see an interrupt, but
+    // aren't handed any io.
+    nvme->active_queues = active;
 
     // identify namespace 1
     memset(&cmd, 0, sizeof(cmd));
@@ -1015,14 +1257,26 @@ block_impl_protocol_ops_t block_ops = {
     .queue = nvme_queue,
 };
 
+// How many io queue pairs to ask for: nvme.queues if set, or one per CPU.
+static uint32_t nvme_wanted_queues(void) {
+    uint32_t n = zx_system_get_num_cpus();
+    const char* value = getenv("nvme.queues");
+    if (value != NULL) {
+        n = strtoul(value, NULL, 10);
+    }
+    if (n < 1) {
+        n = 1;
+    } else if (n > MAX_IO_QUEUES) {
+        n = MAX_IO_QUEUES;
+    }
+    return n;
+}
+
 static zx_status_t nvme_bind(void* ctx, zx_device_t* dev) {
     nvme_device_t* nvme;
     if ((nvme = calloc(1, sizeof(nvme_device_t))) == NULL) {
         return ZX_ERR_NO_MEMORY;
     }
-    list_initialize(&nvme->pending_txns);
-    list_initialize(&nvme->active_txns);
-    mtx_init(&nvme->lock, mtx_plain);
     mtx_init(&nvme->admin_lock, mtx_plain);
 
     if (device_get_protocol(dev, ZX_PROTOCOL_PCI, &nvme->pci)) {
@@ -1034,13 +1288,30 @@ static zx_status_t nvme_bind(void* ctx, zx_device_t* dev) {
         goto fail;
     }
 
+    // With MSI-X, each io queue gets a vector of its own. Otherwise
+    // there's a single io queue.
     uint32_t modes[3] = {
         ZX_PCIE_IRQ_MODE_MSI_X, ZX_PCIE_IRQ_MODE_MSI, ZX_PCIE_IRQ_MODE_LEGACY,
     };
     uint32_t nirq = 0;
+    uint32_t nvec = 0;
     for (unsigned n = 0; n < countof(modes); n++) {
-        if ((pci_query_irq_mode(&nvme->pci, modes[n], &nirq) == ZX_OK) &&
-            (pci_set_irq_mode(&nvme->pci, modes[n], 1) == ZX_OK)) {
+        if (pci_query_irq_mode(&nvme->pci, modes[n], &nirq) != ZX_OK) {
+            continue;
+        }
+        nvec = 1;
+        if (modes[n] == ZX_PCIE_IRQ_MODE_MSI_X) {
+            nvec = nvme_wanted_queues();
+            if (nvec > nirq) {
+                nvec = nirq;
+            }
+        }
+        if ((nvec > 1) && (pci_set_irq_mode(&nvme->pci, modes[n], nvec) == ZX_OK)) {
+            zxlogf(INFO, "nvme: irq mode %u, irq count %u/%u (#%u)\n", modes[n], nvec, nirq, n);
+            goto irq_configured;
+        }
+        nvec = 1;
+        if (pci_set_irq_mode(&nvme->pci, modes[n], 1) == ZX_OK) {
             zxlogf(INFO, "nvme: irq mode %u, irq count %u (#%u)\n", modes[n], nirq, n);
             goto irq_configured;
         }
@@ -1049,10 +1320,22 @@ static zx_status_t nvme_bind(void* ctx, zx_device_t* dev) {
     goto fail;
 
 irq_configured:
-    if (pci_map_interrupt(&nvme->pci, 0, &nvme->irqh) != ZX_OK) {
-        zxlogf(ERROR, "nvme: could not map irq\n");
+    if ((nvme->queues = calloc(nvec, sizeof(nvme_queue_t))) == NULL) {
         goto fail;
     }
+    for (uint32_t i = 0; i < nvec; i++) {
+        nvme_queue_t* q = nvme->queues + i;
+        q->nvme = nvme;
+        q->id = i + 1;
+        mtx_init(&q->lock, mtx_plain);
+        list_initialize(&q->pending_txns);
+        list_initialize(&q->active_txns);
+        nvme->queue_count++;
+        if (pci_map_interrupt(&nvme->pci, i, &q->irqh) != ZX_OK) {
+            zxlogf(ERROR, "nvme: could not map irq\n");
+            goto fail;
+        }
+    }
     if (pci_enable_bus_master(&nvme->pci, true)) {
         zxlogf(ERROR, "nvme: cannot enable bus mastering\n");
         goto fail;
@@ -31,6 +31,15 @@ typedef struct {
     zx_device_t* zxdev;
 } ramctl_device_t;
 
+struct ramdisk_device;
+
+// A worker beyond the first, which only serves plain reads and writes.
+typedef struct {
+    struct ramdisk_device* dev;
+    uint32_t index;
+    thrd_t thread;
+} ramdisk_worker_t;
+
 typedef struct ramdisk_device {
     zx_device_t* zxdev;
     uintptr_t mapped_addr;
@@ -52,6 +61,17 @@ typedef struct ramdisk_device {
     ramdisk_blk_counts_t blk_counts; // current block counts
 
     thrd_t worker;
+
+    // Set with IOCTL_RAMDISK_SET_PERF. Workers with an index of |threads| or
+    // above sit idle; the first |num_workers| extra workers have started.
+    uint32_t threads;
+    cnd_t work;
+    ramdisk_worker_t workers[RAMDISK_MAX_THREADS - 1];
+    uint32_t num_workers;
+    uint64_t latency_ns;
+    uint64_t iops_interval; // nanoseconds between completions, 0 for no limit
+    zx_time_t next_slot;
+
     char name[NAME_MAX];
 } ramdisk_device_t;
 
@@ -62,6 +82,72 @@ typedef struct {
     void* cookie;
 } ramdisk_txn_t;
 
+// Holds a request back for as long as IOCTL_RAMDISK_SET_PERF asked for.
+static void ramdisk_throttle(ramdisk_device_t* dev) {
+    mtx_lock(&dev->lock);
+    zx_time_t now = zx_clock_get_monotonic();
+    zx_time_t deadline = now + dev->latency_ns;
+    if (dev->iops_interval != 0) {
+        zx_time_t slot = MAX(now, dev->next_slot);
+        dev->next_slot = slot + dev->iops_interval;
+        deadline = MAX(deadline, slot);
+    }
+    mtx_unlock(&dev->lock);
+    if (deadline > now) {
+        zx_nanosleep(deadline);
+    }
+}
+
+// Extra workers only run while the ramdisk can't sleep, so none of the
+// sleep-after bookkeeping of worker_thread applies to them.
+static int extra_worker_thread(void* arg) {
+    ramdisk_worker_t* worker = arg;
+    ramdisk_device_t* dev = worker->dev;
+
+    for (;;) {
+        ramdisk_txn_t* txn = NULL;
+        mtx_lock(&dev->lock);
+        while (!dev->dead) {
+            if (worker->index < dev->threads && !dev->asleep && dev->sa_blk_count == 0 &&
+                (txn = list_remove_head_type(&dev->txn_list, ramdisk_txn_t, node)) != NULL) {
+                break;
+            }
+            cnd_wait(&dev->work, &dev->lock);
+        }
+        mtx_unlock(&dev->lock);
+        if (txn == NULL) {
+            // worker_thread fails whatever is left once the device is dead.
+            return 0;
+        }
+
+        size_t length = txn->op.rw.length * dev->blk_size;
+        size_t dev_offset = txn->op.rw.offset_dev * dev->blk_size;
+        size_t vmo_offset = txn->op.rw.offset_vmo * dev->blk_size;
+        void* addr = (void*) dev->mapped_addr + dev_offset;
+
+        zx_status_t status;
+        if (length > MAX_TRANSFER_SIZE) {
+            status = ZX_ERR_OUT_OF_RANGE;
+        } else if (txn->op.command == BLOCK_OP_READ) {
+            status = zx_vmo_write(txn->op.rw.vmo, addr, vmo_offset, length);
+        } else {
+            status = zx_vmo_read(txn->op.rw.vmo, addr, vmo_offset, length);
+            mtx_lock(&dev->lock);
+            if (status == ZX_OK) {
+                dev->blk_counts.successful += txn->op.rw.length;
+            } else {
+                dev->blk_counts.failed += txn->op.rw.length;
+            }
+            mtx_unlock(&dev->lock);
+        }
+
+        ramdisk_throttle(dev);
+        if (txn->completion_cb) {
+            txn->completion_cb(txn->cookie, status, &txn->op);
+        }
+    }
+}
+
 // The worker thread processes messages from iotxns in the background
 static int worker_thread(void* arg) {
     zx_status_t status = ZX_OK;
@@ -181,6 +267,7 @@ static int worker_thread(void* arg) {
             }
         }
 
+        ramdisk_throttle(dev);
         if (txn->completion_cb) {
             txn->completion_cb(txn->cookie, status, &txn->op);
         }
@@ -220,11 +307,56 @@ static void ramdisk_unbind(void* ctx) {
     ramdisk_device_t* ramdev = ctx;
     mtx_lock(&ramdev->lock);
     ramdev->dead = true;
+    cnd_broadcast(&ramdev->work);
     mtx_unlock(&ramdev->lock);
     sync_completion_signal(&ramdev->signal);
     device_remove(ramdev->zxdev);
 }
 
+static zx_status_t ramdisk_set_perf(ramdisk_device_t* ramdev, const ramdisk_perf_t* perf) {
+    uint32_t threads = MAX(perf->threads, 1);
+    if (threads > RAMDISK_MAX_THREADS) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+
+    if (perf->flags & RAMDISK_PERF_FLAG_COMMIT) {
+        zx_status_t status = zx_vmo_op_range(ramdev->vmo, ZX_VMO_OP_COMMIT, 0,
+                                             sizebytes(ramdev), NULL, 0);
+        if (status != ZX_OK) {
+            return status;
+        }
+        // Committing doesn't map the pages in; touching them does.
+        for (uint64_t off = 0; off < sizebytes(ramdev); off += PAGE_SIZE) {
+            (void)*(volatile uint8_t*)(ramdev->mapped_addr + off);
+        }
+    }
+
+    mtx_lock(&ramdev->lock);
+    if (threads > 1 && (ramdev->asleep || ramdev->sa_blk_count != 0)) {
+        mtx_unlock(&ramdev->lock);
+        return ZX_ERR_BAD_STATE;
+    }
+    zx_status_t status = ZX_OK;
+    while (ramdev->num_workers < threads - 1) {
+        ramdisk_worker_t* worker = &ramdev->workers[ramdev->num_workers];
+        worker->dev = ramdev;
+        worker->index = ramdev->num_workers + 1;
+        if (thrd_create(&worker->thread, extra_worker_thread, worker) != thrd_success) {
+            status = ZX_ERR_NO_RESOURCES;
+            break;
+        }
+        ramdev->num_workers++;
+    }
+    if (status == ZX_OK) {
+        ramdev->threads = threads;
+        ramdev->latency_ns = perf->latency_ns;
+        ramdev->iops_interval = perf->max_iops ? ZX_SEC(1) / perf->max_iops : 0;
+        cnd_broadcast(&ramdev->work);
+    }
+    mtx_unlock(&ramdev->lock);
+    return status;
+}
+
 static zx_status_t ramdisk_ioctl(void* ctx, uint32_t op, const void* cmd, size_t cmd_len,
                                  void* reply, size_t max, size_t* out_actual) {
     ramdisk_device_t* ramdev = ctx;
@@ -251,6 +383,7 @@ static zx_status_t ramdisk_ioctl(void* ctx, uint32_t op, const void* cmd, size_t
         ramdev->asleep = false;
         memset(&ramdev->blk_counts, 0, sizeof(ramdev->blk_counts));
         ramdev->sa_blk_count = 0;
+        cnd_broadcast(&ramdev->work);
         mtx_unlock(&ramdev->lock);
         sync_completion_signal(&ramdev->signal);
         return ZX_OK;
@@ -261,6 +394,10 @@ static zx_status_t ramdisk_ioctl(void* ctx, uint32_t op, const void* cmd, size_t
         }
         uint64_t* blk_count = (uint64_t*)cmd;
         mtx_lock(&ramdev->lock);
+        if (ramdev->threads > 1) {
+            mtx_unlock(&ramdev->lock);
+            return ZX_ERR_BAD_STATE;
+        }
         ramdev->asleep = false;
         memset(&ramdev->blk_counts, 0, sizeof(ramdev->blk_counts));
         ramdev->sa_blk_count = *blk_count;
@@ -281,6 +418,12 @@ static zx_status_t ramdisk_ioctl(void* ctx, uint32_t op, const void* cmd, size_t
         *out_actual = sizeof(ramdisk_blk_counts_t);
         return ZX_OK;
     }
+    case IOCTL_RAMDISK_SET_PERF: {
+        if (cmd_len < sizeof(ramdisk_perf_t)) {
+            return ZX_ERR_INVALID_ARGS;
+        }
+        return ramdisk_set_perf(ramdev, cmd);
+    }
     // Block Protocol
     case IOCTL_BLOCK_GET_NAME: {
         char* name = reply;
@@ -339,6 +482,7 @@ static void ramdisk_queue(void* ctx, block_op_t* bop, block_impl_queue_callback
             txn->completion_cb = completion_cb;
             txn->cookie = cookie;
             list_add_tail(&ramdev->txn_list, &txn->node);
+            cnd_signal(&ramdev->work);
         }
         mtx_unlock(&ramdev->lock);
         if (dead) {
@@ -371,15 +515,20 @@ static void ramdisk_release(void* ctx) {
     // Wake up the worker thread, in case it is sleeping
     mtx_lock(&ramdev->lock);
     ramdev->dead = true;
+    cnd_broadcast(&ramdev->work);
     mtx_unlock(&ramdev->lock);
     sync_completion_signal(&ramdev->signal);
 
     int r;
+    for (uint32_t i = 0; i < ramdev->num_workers; i++) {
+        thrd_join(ramdev->workers[i].thread, &r);
+    }
     thrd_join(ramdev->worker, &r);
     if (ramdev->vmo != ZX_HANDLE_INVALID) {
         zx_vmar_unmap(zx_vmar_root_self(), ramdev->mapped_addr, sizebytes(ramdev));
         zx_handle_close(ramdev->vmo);
     }
+    cnd_destroy(&ramdev->work);
     free(ramdev);
 }
 
@@ -418,6 +567,11 @@ static zx_status_t ramctl_config(ramctl_device_t* ramctl, zx_handle_t vmo,
     if (mtx_init(&ramdev->lock, mtx_plain) != thrd_success) {
         goto fail_free;
     }
+    if (cnd_init(&ramdev->work) != thrd_success) {
+        mtx_destroy(&ramdev->lock);
+        goto fail_free;
+    }
+    ramdev->threads = 1;
     ramdev->vmo = vmo;
     ramdev->blk_size = blk_size;
     ramdev->blk_count = blk_count;
@@ -460,6 +614,7 @@ static zx_status_t ramctl_config(ramctl_device_t* ramctl, zx_handle_t vmo,
 fail_unmap:
     zx_vmar_unmap(zx_vmar_root_self(), ramdev->mapped_addr, sizebytes(ramdev));
 fail_mtx:
+    cnd_destroy(&ramdev->work);
     mtx_destroy(&ramdev->lock);
 fail_free:
     free(ramdev);
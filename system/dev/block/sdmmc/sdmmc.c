@@ -232,7 +232,49 @@ static zx_status_t sdmmc_wait_for_tran(sdmmc_device_t* dev) {
     }
 }
 
-static void sdmmc_do_txn(sdmmc_device_t* dev, sdmmc_txn_t* txn) {
+// Moves the txns queued right behind |txn| which continue it, both on the device and in its vmo,
+// onto |packed|, so that all of them are transferred with a single multiple block command.
+// Returns the number of blocks of |txn| and the txns packed with it. Called with the lock held.
+static uint32_t sdmmc_pack_txns_locked(sdmmc_device_t* dev, sdmmc_txn_t* txn,
+                                       list_node_t* packed) {
+    uint32_t blocks = txn->bop.rw.length;
+    if (BLOCK_OP(txn->bop.command) != BLOCK_OP_READ &&
+        BLOCK_OP(txn->bop.command) != BLOCK_OP_WRITE) {
+        return blocks;
+    }
+
+    // a single command transfers at most max_transfer_size bytes, in up to 65535 blocks
+    uint64_t max_blocks = MIN(dev->block_info.max_transfer_size / dev->block_info.block_size,
+                              UINT16_MAX);
+    sdmmc_txn_t* next;
+    while ((next = list_peek_head_type(&dev->txn_list, sdmmc_txn_t, node)) != NULL) {
+        if (next->bop.command != txn->bop.command ||
+            next->bop.rw.vmo != txn->bop.rw.vmo ||
+            next->bop.rw.offset_dev != txn->bop.rw.offset_dev + blocks ||
+            next->bop.rw.offset_vmo != txn->bop.rw.offset_vmo + blocks ||
+            blocks + next->bop.rw.length > max_blocks) {
+            break;
+        }
+        list_delete(&next->node);
+        list_add_tail(packed, &next->node);
+        blocks += next->bop.rw.length;
+    }
+    return blocks;
+}
+
+// Completes |txn| and the txns packed with it.
+static void sdmmc_complete_packed(sdmmc_device_t* dev, sdmmc_txn_t* txn, list_node_t* packed,
+                                  zx_status_t status) {
+    block_complete(txn, status, dev);
+    sdmmc_txn_t* next;
+    while ((next = list_remove_head_type(packed, sdmmc_txn_t, node)) != NULL) {
+        block_complete(next, status, dev);
+    }
+}
+
+// Transfers |blocks| blocks starting at |txn|, which the txns on |packed| continue.
+static void sdmmc_do_txn(sdmmc_device_t* dev, sdmmc_txn_t* txn, list_node_t* packed,
+                         uint32_t blocks) {
     // The TRACE_*() event macros are empty if driver tracing isn't enabled.
     // But that doesn't work for our call to trace_state().
     if (TRACE_ENABLED()) {
@@ -251,7 +293,7 @@ static void sdmmc_do_txn(sdmmc_device_t* dev, sdmmc_txn_t* txn) {
     // Figure out which SD command we need to issue.
     switch (BLOCK_OP(txn->bop.command)) {
     case BLOCK_OP_READ:
-        if (txn->bop.rw.length > 1) {
+        if (blocks > 1) {
             cmd_idx = SDMMC_READ_MULTIPLE_BLOCK;
             cmd_flags = SDMMC_READ_MULTIPLE_BLOCK_FLAGS;
         } else {
@@ -260,7 +302,7 @@ static void sdmmc_do_txn(sdmmc_device_t* dev, sdmmc_txn_t* txn) {
         }
         break;
     case BLOCK_OP_WRITE:
-        if (txn->bop.rw.length > 1) {
+        if (blocks > 1) {
             cmd_idx = SDMMC_WRITE_MULTIPLE_BLOCK;
             cmd_flags = SDMMC_WRITE_MULTIPLE_BLOCK_FLAGS;
         } else {
@@ -280,21 +322,22 @@ static void sdmmc_do_txn(sdmmc_device_t* dev, sdmmc_txn_t* txn) {
     }
 
     zxlogf(TRACE, "sdmmc: do_txn blockop 0x%x offset_vmo 0x%" PRIx64 " length 0x%x blocksize 0x%x"
-                  " max_transfer_size 0x%x\n",
-           txn->bop.command, txn->bop.rw.offset_vmo, txn->bop.rw.length,
-           dev->block_info.block_size, dev->block_info.max_transfer_size);
+                  " max_transfer_size 0x%x packed %zu\n",
+           txn->bop.command, txn->bop.rw.offset_vmo, blocks,
+           dev->block_info.block_size, dev->block_info.max_transfer_size,
+           list_length(packed));
 
     sdmmc_req_t* req = &dev->req;
     memset(req, 0, sizeof(*req));
     req->cmd_idx = cmd_idx;
     req->cmd_flags = cmd_flags;
     req->arg = txn->bop.rw.offset_dev;
-    req->blockcount = txn->bop.rw.length;
+    req->blockcount = blocks;
     req->blocksize = dev->block_info.block_size;
 
     // convert offset_vmo and length to bytes
-    txn->bop.rw.offset_vmo *= dev->block_info.block_size;
-    txn->bop.rw.length *= dev->block_info.block_size;
+    uint64_t offset_vmo = txn->bop.rw.offset_vmo * dev->block_info.block_size;
+    uint64_t length = (uint64_t)blocks * dev->block_info.block_size;
 
     zx_status_t st = ZX_OK;
     if (sdmmc_use_dma(dev)) {
@@ -302,18 +345,18 @@ static void sdmmc_do_txn(sdmmc_device_t* dev, sdmmc_txn_t* txn) {
         req->virt_buffer = NULL;
         req->pmt = ZX_HANDLE_INVALID;
         req->dma_vmo =  txn->bop.rw.vmo;
-        req->buf_offset = txn->bop.rw.offset_vmo;
+        req->buf_offset = offset_vmo;
     } else {
         req->use_dma = false;
         st = zx_vmar_map(zx_vmar_root_self(), ZX_VM_PERM_READ | ZX_VM_PERM_WRITE,
-                         0, txn->bop.rw.vmo, txn->bop.rw.offset_vmo, txn->bop.rw.length,
+                         0, txn->bop.rw.vmo, offset_vmo, length,
                          (uintptr_t*)&req->virt_buffer);
         if (st != ZX_OK) {
             zxlogf(TRACE, "sdmmc: do_txn vmo map error %d\n", st);
-            block_complete(txn, st, dev);
+            sdmmc_complete_packed(dev, txn, packed, st);
             return;
         }
-        req->virt_size = txn->bop.rw.length;
+        req->virt_size = length;
     }
 
     st = sdmmc_request(&dev->host, req);
@@ -334,7 +377,7 @@ exit:
     if (!req->use_dma) {
         zx_vmar_unmap(zx_vmar_root_self(), (uintptr_t)req->virt_buffer, req->virt_size);
     }
-    block_complete(txn, st, dev);
+    sdmmc_complete_packed(dev, txn, packed, st);
     zxlogf(TRACE, "sdmmc: do_txn complete\n");
 }
 
@@ -434,9 +477,11 @@ static int sdmmc_worker_thread(void* arg) {
             SDMMC_LOCK(dev);
             sdmmc_txn_t* txn = list_remove_head_type(&dev->txn_list, sdmmc_txn_t, node);
             if (txn) {
+                list_node_t packed = LIST_INITIAL_VALUE(packed);
+                uint32_t blocks = sdmmc_pack_txns_locked(dev, txn, &packed);
                 // Unlock if we execute the transaction
                 SDMMC_UNLOCK(dev);
-                sdmmc_do_txn(dev, txn);
+                sdmmc_do_txn(dev, txn, &packed, blocks);
             } else {
                 // Stay locked if we're clearing the "RECEIVED" flag.
                 zx_object_signal(dev->worker_event, SDMMC_TXN_RECEIVED, 0);
@@ -10,6 +10,7 @@ MODULE_TYPE := driver
 
 MODULE_SRCS := \
     $(LOCAL_DIR)/block.c \
+    $(LOCAL_DIR)/uas.c \
     $(LOCAL_DIR)/usb-mass-storage.c \
 
 MODULE_STATIC_LIBS := system/ulib/ddk system/dev/lib/usb system/ulib/sync
@@ -0,0 +1,983 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <ddk/debug.h>
+#include <ddk/driver.h>
+#include <ddk/protocol/usb.h>
+#include <ddk/usb/usb.h>
+#include <usb/usb-request.h>
+#include <zircon/assert.h>
+#include <zircon/hw/usb.h>
+#include <zircon/hw/usb-mass-storage.h>
+#include <zircon/syscalls.h>
+
+#include <endian.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+
+#include "uas.h"
+
+// USB Attached SCSI. See "Universal Serial Bus Mass Storage Class - USB Attached SCSI Protocol"
+//
+// Commands are sent as Command IUs on the command pipe, each with a tag of its own, and up to
+// num_cmds of them are kept outstanding. Their data is transferred on the data-in or data-out
+// pipe, and their status returned in a Sense IU on the status pipe. With streams, the status and
+// data of a command are transferred on the streams of its tag; otherwise the device sends a
+// READ READY or WRITE READY IU on the status pipe when it is ready for the data of a command.
+//
+// All requests complete onto completed_reqs, and are processed by the worker thread, which is
+// the only one to touch the commands.
+
+// largest status IU we expect: a Sense IU with all of its sense data
+#define UAS_STATUS_LENGTH 512
+
+static inline void txn_complete(uas_txn_t* txn, zx_status_t status) {
+    zxlogf(TRACE, "UAS DONE %d (%p)\n", status, &txn->op);
+    txn->completion_cb(txn->cookie, status, &txn->op);
+}
+
+static void uas_req_complete(usb_request_t* req, void* cookie) {
+    uas_t* uas = cookie;
+    mtx_lock(&uas->lock);
+    list_add_tail(&uas->completed_reqs, &req->node);
+    mtx_unlock(&uas->lock);
+    sync_completion_signal(&uas->worker_completion);
+}
+
+static void uas_queue(uas_t* uas, uas_cmd_t* cmd, usb_request_t* req) {
+    req->complete_cb = uas_req_complete;
+    req->cookie = uas;
+    if (cmd) {
+        cmd->reqs_pending++;
+    }
+    usb_request_queue(&uas->usb, req);
+}
+
+static void uas_queue_status(uas_t* uas) {
+    if (!uas->status_queued) {
+        uas->status_queued = true;
+        uas_queue(uas, NULL, uas->status_req);
+    }
+}
+
+// Sends a command for |lun|, with its direction, length and data_req set up by the caller.
+static zx_status_t uas_start_cmd(uas_t* uas, uas_cmd_t* cmd, uint8_t lun, const void* cdb,
+                                 size_t cdb_length) {
+    uas_command_iu_t* iu;
+    zx_status_t status = usb_request_mmap(cmd->cmd_req, (void **)&iu);
+    if (status != ZX_OK) {
+        zxlogf(ERROR, "uas: usb request mmap failed: %d\n", status);
+        return status;
+    }
+
+    memset(iu, 0, sizeof(*iu));
+    iu->iu_id = UAS_IU_COMMAND;
+    iu->tag = htobe16(cmd->tag);
+    iu->task_attribute = UAS_TASK_ATTRIBUTE_SIMPLE;
+    // single level LUN, peripheral device addressing
+    iu->lun = htobe64((uint64_t)lun << 48);
+    memcpy(iu->cdb, cdb, cdb_length);
+
+    cmd->active = true;
+    cmd->done = false;
+    cmd->status = ZX_OK;
+    cmd->reqs_pending = 0;
+    uas->cmds_active++;
+
+    if (uas->use_streams) {
+        cmd->status_req->header.stream_id = cmd->tag;
+        uas_queue(uas, cmd, cmd->status_req);
+        if (cmd->length > 0) {
+            cmd->data_req.header.stream_id = cmd->tag;
+            uas_queue(uas, cmd, &cmd->data_req);
+        }
+    } else {
+        uas_queue_status(uas);
+    }
+    uas_queue(uas, cmd, cmd->cmd_req);
+    return ZX_OK;
+}
+
+static uas_cmd_t* uas_get_free_cmd(uas_t* uas) {
+    for (uint16_t i = 0; i < uas->num_cmds; i++) {
+        if (!uas->cmds[i].active) {
+            return &uas->cmds[i];
+        }
+    }
+    return NULL;
+}
+
+static void uas_finish_cmd(uas_t* uas, uas_cmd_t* cmd) {
+    if (cmd->length > 0) {
+        usb_request_release(&cmd->data_req);
+    }
+    cmd->active = false;
+    uas->cmds_active--;
+
+    uas_txn_t* txn = cmd->txn;
+    if (!txn) {
+        return;
+    }
+    cmd->txn = NULL;
+
+    if (cmd->status == ZX_OK) {
+        txn->blocks_done += cmd->txn_blocks;
+        if (txn->blocks_done < txn->op.rw.length) {
+            // send the next command for the rest of the op
+            mtx_lock(&uas->lock);
+            list_add_head(&uas->queued_txns, &txn->node);
+            mtx_unlock(&uas->lock);
+            return;
+        }
+    } else {
+        zxlogf(ERROR, "uas: %s of %u @ %zu failed: %d\n",
+               (txn->op.command & BLOCK_OP_MASK) == BLOCK_OP_READ ? "read" : "write",
+               txn->op.rw.length, txn->op.rw.offset_dev, cmd->status);
+    }
+    txn_complete(txn, cmd->status);
+}
+
+static void uas_check_cmd_done(uas_t* uas, uas_cmd_t* cmd) {
+    if (cmd->active && cmd->done && cmd->reqs_pending == 0) {
+        uas_finish_cmd(uas, cmd);
+    }
+}
+
+static void uas_set_cmd_status(uas_cmd_t* cmd, zx_status_t status) {
+    if (cmd->status == ZX_OK) {
+        cmd->status = status;
+    }
+}
+
+// Handles a status IU received for |cmd|, or for whichever command it is tagged with if
+// |cmd| is NULL.
+static zx_status_t uas_handle_iu(uas_t* uas, uas_cmd_t* cmd, usb_request_t* req) {
+    uas_sense_iu_t iu;
+    memset(&iu, 0, sizeof(iu));
+    ssize_t length = usb_request_copy_from(req, &iu, MIN(req->response.actual, sizeof(iu)), 0);
+    if (length < (ssize_t)sizeof(uas_ready_iu_t)) {
+        zxlogf(ERROR, "uas: short status IU of %zd bytes\n", length);
+        return ZX_ERR_IO;
+    }
+
+    uint16_t tag = betoh16(iu.tag);
+    if (!cmd) {
+        if (tag < 1 || tag > uas->num_cmds || !uas->cmds[tag - 1].active) {
+            zxlogf(ERROR, "uas: status IU %u for unknown tag %u\n", iu.iu_id, tag);
+            return ZX_ERR_IO;
+        }
+        cmd = &uas->cmds[tag - 1];
+    } else if (tag != cmd->tag) {
+        zxlogf(ERROR, "uas: status IU for tag %u on stream %u\n", tag, cmd->tag);
+        uas_set_cmd_status(cmd, ZX_ERR_IO);
+        cmd->done = true;
+        return ZX_ERR_IO;
+    }
+
+    switch (iu.iu_id) {
+    case UAS_IU_SENSE:
+        cmd->done = true;
+        if (iu.status == SCSI_STATUS_CHECK_CONDITION) {
+            uas_set_cmd_status(cmd, ZX_ERR_BAD_STATE);
+        } else if (iu.status != SCSI_STATUS_GOOD) {
+            zxlogf(ERROR, "uas: tag %u failed with SCSI status 0x%02x\n", tag, iu.status);
+            uas_set_cmd_status(cmd, ZX_ERR_IO);
+        }
+        return ZX_OK;
+    case UAS_IU_RESPONSE: {
+        uas_response_iu_t* response = (uas_response_iu_t *)&iu;
+        zxlogf(ERROR, "uas: tag %u failed with response code 0x%02x\n", tag,
+               response->response_code);
+        cmd->done = true;
+        uas_set_cmd_status(cmd, ZX_ERR_IO);
+        return ZX_OK;
+    }
+    case UAS_IU_READ_READY:
+    case UAS_IU_WRITE_READY: {
+        uint8_t direction = (iu.iu_id == UAS_IU_READ_READY ? USB_DIR_IN : USB_DIR_OUT);
+        if (uas->use_streams || cmd->length == 0 || cmd->direction != direction) {
+            zxlogf(ERROR, "uas: unexpected ready IU %u for tag %u\n", iu.iu_id, tag);
+            uas_set_cmd_status(cmd, ZX_ERR_IO);
+            return ZX_ERR_IO;
+        }
+        uas_queue(uas, cmd, &cmd->data_req);
+        return ZX_OK;
+    }
+    default:
+        zxlogf(ERROR, "uas: unknown status IU %u for tag %u\n", iu.iu_id, tag);
+        uas_set_cmd_status(cmd, ZX_ERR_IO);
+        return ZX_ERR_IO;
+    }
+}
+
+// Returns whether the pipes need to be reset.
+static bool uas_handle_req(uas_t* uas, usb_request_t* req) {
+    if (req == uas->status_req) {
+        uas->status_queued = false;
+        zx_status_t status = req->response.status;
+        if (status == ZX_OK) {
+            status = uas_handle_iu(uas, NULL, req);
+        }
+        for (uint16_t i = 0; i < uas->num_cmds; i++) {
+            uas_check_cmd_done(uas, &uas->cmds[i]);
+        }
+        if (status == ZX_OK && uas->cmds_active > 0) {
+            uas_queue_status(uas);
+        }
+        return status != ZX_OK;
+    }
+
+    uas_cmd_t* cmd = NULL;
+    for (uint16_t i = 0; i < uas->num_cmds; i++) {
+        uas_cmd_t* test = &uas->cmds[i];
+        if (test->active && (req == test->cmd_req || req == test->status_req ||
+                             req == &test->data_req)) {
+            cmd = test;
+            break;
+        }
+    }
+    if (!cmd) {
+        zxlogf(ERROR, "uas: completion of unknown request %p\n", req);
+        return false;
+    }
+    cmd->reqs_pending--;
+
+    zx_status_t status = req->response.status;
+    if (status == ZX_OK) {
+        if (req == cmd->status_req) {
+            status = uas_handle_iu(uas, cmd, req);
+        } else if (req == &cmd->data_req && cmd->txn && req->response.actual != cmd->length) {
+            // only block ops need all of their data
+            uas_set_cmd_status(cmd, ZX_ERR_IO);
+        }
+    } else {
+        uas_set_cmd_status(cmd, status);
+    }
+
+    uas_check_cmd_done(uas, cmd);
+    return status != ZX_OK;
+}
+
+// Processes the requests which have completed, returning whether the pipes need to be reset.
+static bool uas_process_reqs(uas_t* uas) {
+    list_node_t reqs = LIST_INITIAL_VALUE(reqs);
+    mtx_lock(&uas->lock);
+    list_move(&uas->completed_reqs, &reqs);
+    mtx_unlock(&uas->lock);
+
+    bool failed = false;
+    usb_request_t* req;
+    while ((req = list_remove_head_type(&reqs, usb_request_t, node)) != NULL) {
+        if (uas_handle_req(uas, req)) {
+            failed = true;
+        }
+    }
+    return failed;
+}
+
+static bool uas_reqs_pending(uas_t* uas) {
+    if (uas->status_queued) {
+        return true;
+    }
+    for (uint16_t i = 0; i < uas->num_cmds; i++) {
+        if (uas->cmds[i].active && uas->cmds[i].reqs_pending > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Cancels all outstanding requests and fails the commands in flight with |status|.
+static void uas_abort(uas_t* uas, zx_status_t status) {
+    const uint8_t pipes[] = {
+        uas->command_addr, uas->status_addr, uas->data_in_addr, uas->data_out_addr,
+    };
+
+    // Halted endpoints are reset before cancelling, since their requests stay queued until then.
+    for (size_t i = 0; i < countof(pipes); i++) {
+        usb_reset_endpoint(&uas->usb, pipes[i]);
+    }
+    for (size_t i = 0; i < countof(pipes); i++) {
+        usb_cancel_all(&uas->usb, pipes[i]);
+    }
+
+    while (uas_reqs_pending(uas)) {
+        sync_completion_wait(&uas->worker_completion, ZX_TIME_INFINITE);
+        sync_completion_reset(&uas->worker_completion);
+        uas_process_reqs(uas);
+    }
+
+    for (uint16_t i = 0; i < uas->num_cmds; i++) {
+        uas_cmd_t* cmd = &uas->cmds[i];
+        if (cmd->active) {
+            uas_set_cmd_status(cmd, status);
+            uas_finish_cmd(uas, cmd);
+        }
+    }
+}
+
+// Synchronously executes a command of our own, which no other commands may be in flight for,
+// reading up to |length| bytes of data into |out_data|.
+static zx_status_t uas_exec(uas_t* uas, uint8_t lun, const void* cdb, size_t cdb_length,
+                            size_t length, void* out_data) {
+    ZX_DEBUG_ASSERT(uas->cmds_active == 0);
+    uas_cmd_t* cmd = &uas->cmds[0];
+
+    cmd->txn = NULL;
+    cmd->direction = USB_DIR_IN;
+    cmd->length = length;
+    if (length > 0) {
+        zx_status_t status = usb_request_init(&cmd->data_req, uas->buffer_vmo, 0, length,
+                                              uas->data_in_addr);
+        if (status != ZX_OK) {
+            return status;
+        }
+    }
+
+    zx_status_t status = uas_start_cmd(uas, cmd, lun, cdb, cdb_length);
+    if (status != ZX_OK) {
+        if (length > 0) {
+            usb_request_release(&cmd->data_req);
+        }
+        return status;
+    }
+
+    while (cmd->active) {
+        sync_completion_wait(&uas->worker_completion, ZX_TIME_INFINITE);
+        sync_completion_reset(&uas->worker_completion);
+        if (uas_process_reqs(uas)) {
+            uas_abort(uas, ZX_ERR_IO);
+        }
+    }
+
+    if (cmd->status == ZX_OK && length > 0) {
+        status = zx_vmo_read(uas->buffer_vmo, out_data, 0, length);
+        if (status != ZX_OK) {
+            return status;
+        }
+    }
+    return cmd->status;
+}
+
+static zx_status_t uas_inquiry(uas_t* uas, uint8_t lun, uint8_t* out_data) {
+    scsi_command6_t command;
+    memset(&command, 0, sizeof(command));
+    command.opcode = UMS_INQUIRY;
+    command.length = UMS_INQUIRY_TRANSFER_LENGTH;
+    return uas_exec(uas, lun, &command, sizeof(command), UMS_INQUIRY_TRANSFER_LENGTH, out_data);
+}
+
+static zx_status_t uas_test_unit_ready(uas_t* uas, uint8_t lun) {
+    scsi_command6_t command;
+    memset(&command, 0, sizeof(command));
+    command.opcode = UMS_TEST_UNIT_READY;
+    return uas_exec(uas, lun, &command, sizeof(command), 0, NULL);
+}
+
+static zx_status_t uas_read_capacity10(uas_t* uas, uint8_t lun,
+                                       scsi_read_capacity_10_t* out_data) {
+    scsi_command10_t command;
+    memset(&command, 0, sizeof(command));
+    command.opcode = UMS_READ_CAPACITY10;
+    return uas_exec(uas, lun, &command, sizeof(command), sizeof(*out_data), out_data);
+}
+
+static zx_status_t uas_read_capacity16(uas_t* uas, uint8_t lun,
+                                       scsi_read_capacity_16_t* out_data) {
+    scsi_command16_t command;
+    memset(&command, 0, sizeof(command));
+    command.opcode = UMS_READ_CAPACITY16;
+    // service action READ CAPACITY (16)
+    command.misc = 0x10;
+    command.length = htobe32(sizeof(*out_data));
+    return uas_exec(uas, lun, &command, sizeof(command), sizeof(*out_data), out_data);
+}
+
+static zx_status_t uas_mode_sense6(uas_t* uas, uint8_t lun, scsi_mode_sense_6_data_t* out_data) {
+    scsi_mode_sense_6_command_t command;
+    memset(&command, 0, sizeof(command));
+    command.opcode = UMS_MODE_SENSE6;
+    command.page = 0x3F;   // all pages, current values
+    command.allocation_length = sizeof(*out_data);
+    return uas_exec(uas, lun, &command, sizeof(command), sizeof(*out_data), out_data);
+}
+
+// Finds the logical units of the device, with REPORT LUNS. Devices which don't support it
+// have only LUN 0.
+static void uas_report_luns(uas_t* uas) {
+    uint8_t data[8 + 8 * UAS_MAX_LUNS];
+    memset(data, 0, sizeof(data));
+
+    uint8_t command[12];
+    memset(command, 0, sizeof(command));
+    command[0] = UMS_REPORT_LUNS;
+    uint32_t allocation_length = htobe32(sizeof(data));
+    memcpy(&command[6], &allocation_length, sizeof(allocation_length));
+
+    uas->num_luns = 0;
+    if (uas_exec(uas, 0, command, sizeof(command), sizeof(data), data) == ZX_OK) {
+        uint32_t list_length;
+        memcpy(&list_length, data, sizeof(list_length));
+        size_t count = MIN(betoh32(list_length) / 8, UAS_MAX_LUNS);
+        for (size_t i = 0; i < count; i++) {
+            const uint8_t* lun = &data[8 + 8 * i];
+            // only single level LUNs with peripheral device addressing
+            if (lun[0] == 0) {
+                uas->block_devs[uas->num_luns++].lun = lun[1];
+            }
+        }
+    }
+    if (uas->num_luns == 0) {
+        uas->block_devs[0].lun = 0;
+        uas->num_luns = 1;
+    }
+}
+
+// Builds the READ or WRITE command for a block op, returning its length.
+static size_t uas_rw_command(uas_block_t* dev, bool write, uint64_t block_offset,
+                             uint32_t blocks, uint8_t* out_command) {
+    // Need to use READ16/WRITE16 if block addresses are greater than 32 bit
+    if (dev->total_blocks > UINT32_MAX) {
+        scsi_command16_t command;
+        memset(&command, 0, sizeof(command));
+        command.opcode = write ? UMS_WRITE16 : UMS_READ16;
+        command.lba = htobe64(block_offset);
+        command.length = htobe32(blocks);
+        memcpy(out_command, &command, sizeof(command));
+        return sizeof(command);
+    } else if (blocks <= UINT16_MAX) {
+        scsi_command10_t command;
+        memset(&command, 0, sizeof(command));
+        command.opcode = write ? UMS_WRITE10 : UMS_READ10;
+        command.lba = htobe32(block_offset);
+        command.length_hi = blocks >> 8;
+        command.length_lo = blocks & 0xFF;
+        memcpy(out_command, &command, sizeof(command));
+        return sizeof(command);
+    } else {
+        scsi_command12_t command;
+        memset(&command, 0, sizeof(command));
+        command.opcode = write ? UMS_WRITE12 : UMS_READ12;
+        command.lba = htobe32(block_offset);
+        command.length = htobe32(blocks);
+        memcpy(out_command, &command, sizeof(command));
+        return sizeof(command);
+    }
+}
+
+// Sends the command for the next part of a read or write.
+static void uas_start_txn(uas_t* uas, uas_cmd_t* cmd, uas_txn_t* txn) {
+    uas_block_t* dev = txn->dev;
+    bool write = (txn->op.command & BLOCK_OP_MASK) == BLOCK_OP_WRITE;
+
+    uint64_t block_offset = txn->op.rw.offset_dev + txn->blocks_done;
+    uint32_t blocks = txn->op.rw.length - txn->blocks_done;
+    uint32_t max_blocks = uas->max_transfer / dev->block_size;
+    if (blocks > max_blocks) {
+        blocks = max_blocks;
+    }
+    size_t length = (size_t)blocks * dev->block_size;
+    zx_off_t vmo_offset = (txn->op.rw.offset_vmo + txn->blocks_done) * dev->block_size;
+
+    zx_status_t status = usb_request_init(&cmd->data_req, txn->op.rw.vmo, vmo_offset, length,
+                                          write ? uas->data_out_addr : uas->data_in_addr);
+    if (status != ZX_OK) {
+        txn_complete(txn, status);
+        return;
+    }
+    cmd->txn = txn;
+    cmd->txn_blocks = blocks;
+    cmd->direction = write ? USB_DIR_OUT : USB_DIR_IN;
+    cmd->length = length;
+
+    uint8_t command[16];
+    size_t command_length = uas_rw_command(dev, write, block_offset, blocks, command);
+    status = uas_start_cmd(uas, cmd, dev->lun, command, command_length);
+    if (status != ZX_OK) {
+        cmd->txn = NULL;
+        usb_request_release(&cmd->data_req);
+        txn_complete(txn, status);
+    }
+}
+
+// Starts as many of the queued txns as there are free commands for.
+static void uas_start_txns(uas_t* uas) {
+    uas_cmd_t* cmd;
+    while ((cmd = uas_get_free_cmd(uas)) != NULL) {
+        mtx_lock(&uas->lock);
+        uas_txn_t* txn = list_peek_head_type(&uas->queued_txns, uas_txn_t, node);
+        if (txn == NULL) {
+            mtx_unlock(&uas->lock);
+            return;
+        }
+        bool flush = (txn->op.command & BLOCK_OP_MASK) == BLOCK_OP_FLUSH;
+        if (flush && uas->cmds_active > 0) {
+            // a flush completes once the commands before it have, and holds back those after it
+            mtx_unlock(&uas->lock);
+            return;
+        }
+        list_delete(&txn->node);
+        mtx_unlock(&uas->lock);
+
+        zxlogf(TRACE, "UAS PROCESS (%p)\n", &txn->op);
+        if (flush) {
+            txn_complete(txn, ZX_OK);
+        } else {
+            uas_start_txn(uas, cmd, txn);
+        }
+    }
+}
+
+static void uas_block_queue(void* ctx, block_op_t* op, block_impl_queue_callback completion_cb,
+                            void* cookie) {
+    uas_block_t* dev = ctx;
+    uas_txn_t* txn = block_op_to_uas_txn(op);
+    txn->completion_cb = completion_cb;
+    txn->cookie = cookie;
+    txn->blocks_done = 0;
+
+    switch (op->command & BLOCK_OP_MASK) {
+    case BLOCK_OP_READ:
+    case BLOCK_OP_WRITE:
+        zxlogf(TRACE, "UAS QUEUE %s %u @%zu (%p)\n",
+               (op->command & BLOCK_OP_MASK) == BLOCK_OP_READ ? "RD" : "WR",
+               op->rw.length, op->rw.offset_dev, op);
+        if ((op->rw.offset_dev >= dev->total_blocks) ||
+            ((dev->total_blocks - op->rw.offset_dev) < op->rw.length)) {
+            completion_cb(cookie, ZX_ERR_OUT_OF_RANGE, op);
+            return;
+        }
+        if (op->rw.length == 0) {
+            completion_cb(cookie, ZX_OK, op);
+            return;
+        }
+        break;
+    case BLOCK_OP_FLUSH:
+        zxlogf(TRACE, "UAS QUEUE FLUSH (%p)\n", op);
+        break;
+    default:
+        zxlogf(ERROR, "uas_block_queue: unsupported command %u\n", op->command);
+        completion_cb(cookie, ZX_ERR_NOT_SUPPORTED, op);
+        return;
+    }
+
+    uas_t* uas = dev->uas;
+    txn->dev = dev;
+
+    mtx_lock(&uas->lock);
+    list_add_tail(&uas->queued_txns, &txn->node);
+    mtx_unlock(&uas->lock);
+    sync_completion_signal(&uas->worker_completion);
+}
+
+static void uas_get_info(uas_block_t* dev, block_info_t* info) {
+    memset(info, 0, sizeof(*info));
+    info->block_size = dev->block_size;
+    info->block_count = dev->total_blocks;
+    info->max_transfer_size = dev->uas->max_transfer;
+    info->flags = dev->flags;
+}
+
+static void uas_block_query(void* ctx, block_info_t* info_out, size_t* block_op_size_out) {
+    uas_get_info(ctx, info_out);
+    *block_op_size_out = sizeof(uas_txn_t);
+}
+
+static block_impl_protocol_ops_t uas_block_ops = {
+    .query = uas_block_query,
+    .queue = uas_block_queue,
+};
+
+static zx_status_t uas_block_ioctl(void* ctx, uint32_t op, const void* cmd, size_t cmdlen,
+                                   void* reply, size_t max, size_t* out_actual) {
+    uas_block_t* dev = ctx;
+
+    switch (op) {
+    case IOCTL_BLOCK_GET_INFO: {
+        block_info_t* info = reply;
+        if (max < sizeof(*info))
+            return ZX_ERR_BUFFER_TOO_SMALL;
+        uas_get_info(dev, info);
+        *out_actual = sizeof(*info);
+        return ZX_OK;
+    }
+    case IOCTL_DEVICE_SYNC: {
+        return ZX_OK;
+    }
+    default:
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+}
+
+static zx_off_t uas_block_get_size(void* ctx) {
+    uas_block_t* dev = ctx;
+    return dev->block_size * dev->total_blocks;
+}
+
+static zx_protocol_device_t uas_block_proto = {
+    .version = DEVICE_OPS_VERSION,
+    .ioctl = uas_block_ioctl,
+    .get_size = uas_block_get_size,
+};
+
+static zx_status_t uas_add_block_device(uas_block_t* dev) {
+    uas_t* uas = dev->uas;
+    uint8_t lun = dev->lun;
+
+    scsi_read_capacity_10_t data;
+    zx_status_t status = uas_read_capacity10(uas, lun, &data);
+    if (status != ZX_OK) {
+        zxlogf(ERROR, "uas: read_capacity10 failed: %d\n", status);
+        return status;
+    }
+
+    dev->total_blocks = betoh32(data.lba);
+    dev->block_size = betoh32(data.block_length);
+
+    if (dev->total_blocks == 0xFFFFFFFF) {
+        scsi_read_capacity_16_t data;
+        status = uas_read_capacity16(uas, lun, &data);
+        if (status != ZX_OK) {
+            zxlogf(ERROR, "uas: read_capacity16 failed: %d\n", status);
+            return status;
+        }
+
+        dev->total_blocks = betoh64(data.lba);
+        dev->block_size = betoh32(data.block_length);
+    }
+    if (dev->block_size == 0) {
+        zxlogf(ERROR, "uas: zero block size\n");
+        return ZX_ERR_INVALID_ARGS;
+    }
+
+    // +1 because this returns the address of the final block, and blocks are zero indexed
+    dev->total_blocks++;
+
+    // determine if LUN is read-only
+    scsi_mode_sense_6_data_t ms_data;
+    status = uas_mode_sense6(uas, lun, &ms_data);
+    if (status != ZX_OK) {
+        zxlogf(ERROR, "uas: mode_sense6 failed: %d\n", status);
+        return status;
+    }
+
+    if (ms_data.device_specific_param & MODE_SENSE_DSP_RO) {
+        dev->flags |= BLOCK_FLAG_READONLY;
+    } else {
+        dev->flags &= ~BLOCK_FLAG_READONLY;
+    }
+
+    zxlogf(TRACE, "uas: lun %u has %" PRIu64 " blocks of %u bytes\n", lun, dev->total_blocks,
+           dev->block_size);
+
+    char name[16];
+    snprintf(name, sizeof(name), "lun-%03d", lun);
+
+    device_add_args_t args = {
+        .version = DEVICE_ADD_ARGS_VERSION,
+        .name = name,
+        .ctx = dev,
+        .ops = &uas_block_proto,
+        .proto_id = ZX_PROTOCOL_BLOCK_IMPL,
+        .proto_ops = &uas_block_ops,
+    };
+
+    return device_add(uas->zxdev, &args, &dev->zxdev);
+}
+
+static void uas_check_luns_ready(uas_t* uas) {
+    for (uint8_t i = 0; i < uas->num_luns; i++) {
+        uas_block_t* dev = &uas->block_devs[i];
+
+        // a unit which isn't ready returns CHECK CONDITION, with its sense data in the Sense IU
+        zx_status_t status = uas_test_unit_ready(uas, dev->lun);
+        if (status != ZX_OK && status != ZX_ERR_BAD_STATE) {
+            zxlogf(ERROR, "uas: test unit ready of lun %u failed: %d\n", dev->lun, status);
+            continue;
+        }
+        bool ready = (status == ZX_OK);
+
+        if (ready && !dev->device_added) {
+            status = uas_add_block_device(dev);
+            if (status == ZX_OK) {
+                dev->device_added = true;
+            } else {
+                zxlogf(ERROR, "uas: device_add for block device failed %d\n", status);
+            }
+        } else if (!ready && dev->device_added) {
+            device_remove(dev->zxdev);
+            dev->device_added = false;
+        }
+    }
+}
+
+static int uas_worker_thread(void* arg) {
+    uas_t* uas = arg;
+
+    uas_report_luns(uas);
+    for (uint8_t i = 0; i < uas->num_luns; i++) {
+        uas_block_t* dev = &uas->block_devs[i];
+        uint8_t inquiry_data[UMS_INQUIRY_TRANSFER_LENGTH];
+        zx_status_t status = uas_inquiry(uas, dev->lun, inquiry_data);
+        if (status != ZX_OK) {
+            zxlogf(ERROR, "uas: inquiry failed for lun %u status: %d\n", dev->lun, status);
+            device_remove(uas->zxdev);
+            return status;
+        }
+        uint8_t rmb = inquiry_data[1] & 0x80;   // Removable Media Bit
+        if (rmb) {
+            dev->flags |= BLOCK_FLAG_REMOVABLE;
+        }
+    }
+
+    device_make_visible(uas->zxdev);
+
+    while (1) {
+        if (uas_process_reqs(uas)) {
+            uas_abort(uas, ZX_ERR_IO);
+        }
+
+        mtx_lock(&uas->lock);
+        bool dead = uas->dead;
+        bool idle = list_is_empty(&uas->queued_txns);
+        mtx_unlock(&uas->lock);
+        if (dead) {
+            break;
+        }
+
+        uas_start_txns(uas);
+
+        zx_status_t status = sync_completion_wait(&uas->worker_completion, ZX_SEC(1));
+        if (status == ZX_ERR_TIMED_OUT) {
+            if (idle && uas->cmds_active == 0) {
+                uas_check_luns_ready(uas);
+            }
+            continue;
+        }
+        sync_completion_reset(&uas->worker_completion);
+    }
+
+    // complete any commands in flight and pending txns
+    uas_abort(uas, ZX_ERR_IO_NOT_PRESENT);
+
+    list_node_t txns = LIST_INITIAL_VALUE(txns);
+    mtx_lock(&uas->lock);
+    list_move(&uas->queued_txns, &txns);
+    mtx_unlock(&uas->lock);
+
+    uas_txn_t* txn;
+    while ((txn = list_remove_head_type(&txns, uas_txn_t, node)) != NULL) {
+        txn_complete(txn, ZX_ERR_IO_NOT_PRESENT);
+    }
+
+    return ZX_OK;
+}
+
+static void uas_unbind(void* ctx) {
+    uas_t* uas = ctx;
+
+    // terminate our worker thread
+    mtx_lock(&uas->lock);
+    uas->dead = true;
+    mtx_unlock(&uas->lock);
+    sync_completion_signal(&uas->worker_completion);
+
+    // wait for worker thread to finish before removing devices
+    thrd_join(uas->worker_thread, NULL);
+
+    for (uint8_t i = 0; i < uas->num_luns; i++) {
+        uas_block_t* dev = &uas->block_devs[i];
+
+        if (dev->device_added) {
+            device_remove(dev->zxdev);
+        }
+    }
+
+    // remove our root device
+    device_remove(uas->zxdev);
+}
+
+static void uas_release(void* ctx) {
+    uas_t* uas = ctx;
+
+    for (uint16_t i = 0; i < UAS_MAX_TAGS; i++) {
+        uas_cmd_t* cmd = &uas->cmds[i];
+        if (cmd->cmd_req) {
+            usb_request_release(cmd->cmd_req);
+        }
+        if (cmd->status_req) {
+            usb_request_release(cmd->status_req);
+        }
+    }
+    if (uas->status_req) {
+        usb_request_release(uas->status_req);
+    }
+    zx_handle_close(uas->buffer_vmo);
+
+    free(uas);
+}
+
+static zx_protocol_device_t uas_device_proto = {
+    .version = DEVICE_OPS_VERSION,
+    .unbind = uas_unbind,
+    .release = uas_release,
+};
+
+zx_status_t uas_bind(zx_device_t* device, usb_protocol_t* usb, uint8_t interface_number,
+                     uint8_t alt_setting) {
+    // find the pipes of the alternate setting, each named by the Pipe Usage descriptor following
+    // its endpoint descriptor
+    usb_desc_iter_t iter;
+    zx_status_t status = usb_desc_iter_init(usb, &iter);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    uint8_t pipes[UAS_PIPE_DATA_OUT + 1] = {};
+    bool in_setting = false;
+    uint8_t ep_address = 0;
+    usb_descriptor_header_t* header;
+    while ((header = usb_desc_iter_next(&iter)) != NULL) {
+        if (header->bDescriptorType == USB_DT_INTERFACE) {
+            usb_interface_descriptor_t* intf = (usb_interface_descriptor_t *)header;
+            in_setting = (intf->bInterfaceNumber == interface_number &&
+                          intf->bAlternateSetting == alt_setting);
+            ep_address = 0;
+        } else if (in_setting && header->bDescriptorType == USB_DT_ENDPOINT) {
+            ep_address = ((usb_endpoint_descriptor_t *)header)->bEndpointAddress;
+        } else if (in_setting && header->bDescriptorType == UAS_DT_PIPE_USAGE &&
+                   header->bLength >= sizeof(uas_pipe_usage_descriptor_t) && ep_address) {
+            uint8_t pipe_id = ((uas_pipe_usage_descriptor_t *)header)->bPipeID;
+            if (pipe_id >= UAS_PIPE_COMMAND && pipe_id <= UAS_PIPE_DATA_OUT) {
+                pipes[pipe_id] = ep_address;
+            }
+        }
+    }
+    usb_desc_iter_release(&iter);
+
+    for (uint8_t pipe_id = UAS_PIPE_COMMAND; pipe_id <= UAS_PIPE_DATA_OUT; pipe_id++) {
+        if (!pipes[pipe_id]) {
+            zxlogf(ERROR, "uas: pipe %u not found\n", pipe_id);
+            return ZX_ERR_NOT_SUPPORTED;
+        }
+    }
+
+    if (alt_setting != 0) {
+        status = usb_set_interface(usb, interface_number, alt_setting);
+        if (status != ZX_OK) {
+            zxlogf(ERROR, "uas: usb_set_interface failed: %d\n", status);
+            return ZX_ERR_NOT_SUPPORTED;
+        }
+    }
+
+    // SuperSpeed devices transfer the status and data of each command on the streams of its tag
+    bool use_streams = (usb_get_speed(usb) == USB_SPEED_SUPER);
+    uint16_t num_cmds = UAS_MAX_TAGS;
+    if (use_streams) {
+        const uint8_t stream_pipes[] = {
+            pipes[UAS_PIPE_STATUS], pipes[UAS_PIPE_DATA_IN], pipes[UAS_PIPE_DATA_OUT],
+        };
+        for (size_t i = 0; i < countof(stream_pipes); i++) {
+            num_cmds = MIN(num_cmds, usb_get_stream_count(usb, stream_pipes[i]));
+        }
+        if (num_cmds == 0) {
+            zxlogf(INFO, "uas: bulk streams not available\n");
+            if (alt_setting != 0) {
+                usb_set_interface(usb, interface_number, 0);
+            }
+            return ZX_ERR_NOT_SUPPORTED;
+        }
+    }
+
+    uas_t* uas = calloc(1, sizeof(uas_t));
+    if (!uas) {
+        return ZX_ERR_NO_MEMORY;
+    }
+
+    list_initialize(&uas->completed_reqs);
+    list_initialize(&uas->queued_txns);
+    sync_completion_reset(&uas->worker_completion);
+    mtx_init(&uas->lock, mtx_plain);
+
+    uas->usb_zxdev = device;
+    memcpy(&uas->usb, usb, sizeof(uas->usb));
+    uas->interface_number = interface_number;
+    uas->alt_setting = alt_setting;
+    uas->command_addr = pipes[UAS_PIPE_COMMAND];
+    uas->status_addr = pipes[UAS_PIPE_STATUS];
+    uas->data_in_addr = pipes[UAS_PIPE_DATA_IN];
+    uas->data_out_addr = pipes[UAS_PIPE_DATA_OUT];
+    uas->use_streams = use_streams;
+    uas->num_cmds = num_cmds;
+    uas->buffer_vmo = ZX_HANDLE_INVALID;
+
+    size_t max_in = usb_get_max_transfer_size(usb, uas->data_in_addr);
+    size_t max_out = usb_get_max_transfer_size(usb, uas->data_out_addr);
+    uas->max_transfer = (max_in < max_out ? max_in : max_out);
+
+    for (uint8_t i = 0; i < UAS_MAX_LUNS; i++) {
+        uas->block_devs[i].uas = uas;
+    }
+
+    for (uint16_t i = 0; i < num_cmds; i++) {
+        uas_cmd_t* cmd = &uas->cmds[i];
+        // tag 0 is not used, since stream 0 is reserved
+        cmd->tag = i + 1;
+        status = usb_request_alloc(&cmd->cmd_req, sizeof(uas_command_iu_t), uas->command_addr,
+                                   sizeof(usb_request_t));
+        if (status != ZX_OK) {
+            goto fail;
+        }
+        if (use_streams) {
+            status = usb_request_alloc(&cmd->status_req, UAS_STATUS_LENGTH, uas->status_addr,
+                                       sizeof(usb_request_t));
+            if (status != ZX_OK) {
+                goto fail;
+            }
+        }
+    }
+    if (!use_streams) {
+        status = usb_request_alloc(&uas->status_req, UAS_STATUS_LENGTH, uas->status_addr,
+                                   sizeof(usb_request_t));
+        if (status != ZX_OK) {
+            goto fail;
+        }
+    }
+    status = zx_vmo_create(PAGE_SIZE, 0, &uas->buffer_vmo);
+    if (status != ZX_OK) {
+        goto fail;
+    }
+
+    zxlogf(INFO, "uas: %u commands in flight%s\n", num_cmds, use_streams ? " on streams" : "");
+
+    // Add root device, which will contain block devices for logical units
+    device_add_args_t args = {
+        .version = DEVICE_ADD_ARGS_VERSION,
+        .name = "uas",
+        .ctx = uas,
+        .ops = &uas_device_proto,
+        .flags = DEVICE_ADD_NON_BINDABLE | DEVICE_ADD_INVISIBLE,
+    };
+
+    status = device_add(uas->usb_zxdev, &args, &uas->zxdev);
+    if (status != ZX_OK) {
+        goto fail;
+    }
+
+    int ret = thrd_create_with_name(&uas->worker_thread, uas_worker_thread, uas,
+                                    "uas_worker_thread");
+    if (ret != thrd_success) {
+        device_remove(uas->zxdev);
+        return ZX_ERR_NO_MEMORY;
+    }
+
+    return ZX_OK;
+
+fail:
+    zxlogf(ERROR, "uas_bind failed: %d\n", status);
+    uas_release(uas);
+    return status;
+}
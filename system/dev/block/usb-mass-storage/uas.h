@@ -0,0 +1,117 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <inttypes.h>
+#include <ddk/device.h>
+#include <ddk/protocol/block.h>
+#include <ddk/protocol/usb.h>
+#include <lib/sync/completion.h>
+#include <zircon/device/block.h>
+#include <zircon/listnode.h>
+
+#include <threads.h>
+
+// most commands we keep outstanding at once, each with a tag of its own
+#define UAS_MAX_TAGS 16
+// most logical units we publish block devices for
+#define UAS_MAX_LUNS 8
+
+typedef struct uas uas_t;
+typedef struct uas_txn uas_txn_t;
+
+// struct representing a block device for a logical unit
+typedef struct {
+    zx_device_t* zxdev;         // block device we publish
+    uas_t* uas;
+
+    uint64_t total_blocks;
+    uint32_t block_size;
+
+    uint8_t lun;                // our logical unit number
+    uint32_t flags;             // flags for block_info_t
+    bool device_added;
+} uas_block_t;
+
+// a command in flight, and the requests carrying its information units and data
+typedef struct {
+    uint16_t tag;               // also the stream of its status and data, if streams are used
+    bool active;
+
+    usb_request_t* cmd_req;     // Command IU
+    usb_request_t* status_req;  // Sense or Response IU, if streams are used
+    usb_request_t data_req;     // data phase, on the VMO of the command
+    uint32_t reqs_pending;      // requests of the command still queued
+    bool done;                  // whether the Sense or Response IU has been received
+    zx_status_t status;
+
+    uint8_t direction;          // USB_DIR_IN or USB_DIR_OUT
+    size_t length;              // bytes of data, or zero if the command has no data phase
+
+    // the block op this command carries part of, or NULL for a command of our own
+    uas_txn_t* txn;
+    uint32_t txn_blocks;        // blocks of the block op this command transfers
+} uas_cmd_t;
+
+// main struct for the UAS driver
+struct uas {
+    zx_device_t* zxdev;         // root device we publish
+    zx_device_t* usb_zxdev;     // USB device we are bound to
+    usb_protocol_t usb;
+
+    uint8_t interface_number;
+    uint8_t alt_setting;
+    uint8_t command_addr;
+    uint8_t status_addr;
+    uint8_t data_in_addr;
+    uint8_t data_out_addr;
+    size_t max_transfer;        // maximum transfer size of the data pipes
+
+    // With streams (SuperSpeed), each command's status and data are transferred on the streams
+    // of its tag. Otherwise the device asks for each data phase with a READ READY or WRITE READY
+    // IU on the status pipe, which status_req is kept queued on to receive.
+    bool use_streams;
+    usb_request_t* status_req;
+    bool status_queued;
+
+    uint16_t num_cmds;          // tags in use, 1 to num_cmds
+    uint16_t cmds_active;
+    uas_cmd_t cmds[UAS_MAX_TAGS];
+
+    // buffer for the data of our own commands
+    zx_handle_t buffer_vmo;
+
+    thrd_t worker_thread;
+    bool dead;
+
+    // requests completed by the USB stack, for the worker thread to process
+    list_node_t completed_reqs;
+    // list of queued transactions
+    list_node_t queued_txns;
+
+    sync_completion_t worker_completion;    // signals uas_worker_thread when new txns or
+                                            // completed requests are available, and when the
+                                            // device is dead
+    mtx_t lock;                 // protects completed_reqs, queued_txns, worker_completion and dead
+
+    uint8_t num_luns;
+    uas_block_t block_devs[UAS_MAX_LUNS];
+};
+
+struct uas_txn {
+    block_op_t op;
+    block_impl_queue_callback completion_cb;
+    void* cookie;
+    list_node_t node;
+    uas_block_t* dev;
+    uint32_t blocks_done;
+};
+#define block_op_to_uas_txn(op) containerof(op, uas_txn_t, op)
+
+// Binds to the UAS alternate setting |alt_setting| of interface |interface_number| of |device|.
+// Returns ZX_ERR_NOT_SUPPORTED, with the interface left on alternate setting 0, if the interface
+// can't be used with UAS.
+zx_status_t uas_bind(zx_device_t* device, usb_protocol_t* usb, uint8_t interface_number,
+                     uint8_t alt_setting);
@@ -16,6 +16,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "uas.h"
 #include "usb-mass-storage.h"
 
 // comment the next line if you don't want debug messages
@@ -655,12 +656,44 @@ static int ums_worker_thread(void* arg) {
     return ZX_OK;
 }
 
+// Finds the alternate setting of our interface which speaks USB Attached SCSI, if any.
+static bool ums_find_uas(usb_protocol_t* usb, uint8_t* out_interface, uint8_t* out_alt) {
+    usb_desc_iter_t iter;
+    if (usb_desc_iter_init(usb, &iter) != ZX_OK) {
+        return false;
+    }
+
+    bool found = false;
+    usb_interface_descriptor_t* intf;
+    while ((intf = usb_desc_iter_next_interface(&iter, false)) != NULL) {
+        if (intf->bInterfaceClass == USB_CLASS_MSC &&
+            intf->bInterfaceSubClass == USB_SUBCLASS_MSC_SCSI &&
+            intf->bInterfaceProtocol == USB_PROTOCOL_MSC_UAS) {
+            *out_interface = intf->bInterfaceNumber;
+            *out_alt = intf->bAlternateSetting;
+            found = true;
+            break;
+        }
+    }
+    usb_desc_iter_release(&iter);
+    return found;
+}
+
 static zx_status_t ums_bind(void* ctx, zx_device_t* device) {
     usb_protocol_t usb;
     if (device_get_protocol(device, ZX_PROTOCOL_USB, &usb)) {
         return 0;
     }
 
+    // prefer UAS, falling back to bulk-only transport on its alternate setting 0
+    uint8_t uas_interface, uas_alt;
+    if (ums_find_uas(&usb, &uas_interface, &uas_alt)) {
+        zx_status_t status = uas_bind(device, &usb, uas_interface, uas_alt);
+        if (status != ZX_ERR_NOT_SUPPORTED) {
+            return status;
+        }
+    }
+
     // find our endpoints
     usb_desc_iter_t iter;
     zx_status_t result = usb_desc_iter_init(&usb, &iter);
@@ -671,6 +704,11 @@ static zx_status_t ums_bind(void* ctx, zx_device_t* device) {
         usb_desc_iter_release(&iter);
         return ZX_ERR_NOT_SUPPORTED;
     }
+    if (intf->bInterfaceProtocol != USB_PROTOCOL_MSC_BULK_ONLY) {
+        DEBUG_PRINT(("UMS:ums_bind no bulk-only transport\n"));
+        usb_desc_iter_release(&iter);
+        return ZX_ERR_NOT_SUPPORTED;
+    }
     if (intf->bNumEndpoints < 2) {
         DEBUG_PRINT(("UMS:ums_bind wrong number of endpoints: %d\n", intf->bNumEndpoints));
         usb_desc_iter_release(&iter);
@@ -809,9 +847,10 @@ static zx_driver_ops_t usb_mass_storage_driver_ops = {
     .bind = ums_bind,
 };
 
-ZIRCON_DRIVER_BEGIN(usb_mass_storage, usb_mass_storage_driver_ops, "zircon", "0.1", 4)
+ZIRCON_DRIVER_BEGIN(usb_mass_storage, usb_mass_storage_driver_ops, "zircon", "0.1", 5)
     BI_ABORT_IF(NE, BIND_PROTOCOL, ZX_PROTOCOL_USB),
     BI_ABORT_IF(NE, BIND_USB_CLASS, USB_CLASS_MSC),
     BI_ABORT_IF(NE, BIND_USB_SUBCLASS, USB_SUBCLASS_MSC_SCSI),
     BI_MATCH_IF(EQ, BIND_USB_PROTOCOL, USB_PROTOCOL_MSC_BULK_ONLY),
+    BI_MATCH_IF(EQ, BIND_USB_PROTOCOL, USB_PROTOCOL_MSC_UAS),
 ZIRCON_DRIVER_END(usb_mass_storage)
@@ -3,6 +3,7 @@
 // found in the LICENSE file.
 
 #include <inttypes.h>
+#include <limits.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <string.h>
@@ -159,12 +160,12 @@ zx_status_t Device::Init() {
     }
 
     // Start workers
-    // TODO(aarongreen): Investigate performance implications of adding more workers.
     if ((rc = zx::port::create(0, &port_)) != ZX_OK) {
         zxlogf(ERROR, "zx::port::create failed: %s\n", zx_status_get_string(rc));
         return rc;
     }
-    for (size_t i = 0; i < kNumWorkers; ++i) {
+    size_t num_workers = fbl::clamp<size_t>(zx_system_get_num_cpus(), 1, kMaxWorkers);
+    for (size_t i = 0; i < num_workers; ++i) {
         zx::port port;
         port_.duplicate(ZX_RIGHT_SAME_RIGHTS, &port);
         if ((rc = workers_[i].Start(this, *volume, fbl::move(port))) != ZX_OK) {
@@ -482,13 +483,62 @@ void Device::SendToWorker(block_op_t* block) {
     LOG_ENTRY_ARGS("block=%p", block);
     zx_status_t rc;
 
+    // Split the request into pieces of at least |kMinWorkerChunk| bytes, one per worker.  Pieces
+    // are a whole number of pages long.
+    uint32_t length = block->rw.length;
+    uint32_t granularity = fbl::max(1u, static_cast<uint32_t>(PAGE_SIZE) / info_->block_size);
+    uint32_t chunk = fbl::max(fbl::round_up(kMinWorkerChunk / info_->block_size, granularity),
+                              granularity);
+    if (info_->num_workers > 1) {
+        uint32_t share = (length + info_->num_workers - 1) / info_->num_workers;
+        chunk = fbl::max(chunk, fbl::round_up(share, granularity));
+    }
+    uint32_t num_chunks = fbl::max(1u, (length + chunk - 1) / chunk);
+
+    extra_op_t* extra = BlockToExtra(block, info_->op_size);
+    extra->status.store(ZX_OK);
+    extra->pending.store(num_chunks);
+
     zx_port_packet_t packet;
-    Worker::MakeRequest(&packet, Worker::kBlockRequest, block);
-    if ((rc = port_.queue(&packet)) != ZX_OK) {
-        zxlogf(ERROR, "zx::port::queue failed: %s\n", zx_status_get_string(rc));
-        BlockComplete(block, rc);
+    for (uint32_t i = 0; i < num_chunks; ++i) {
+        uint32_t off = i * chunk;
+        uint32_t len = fbl::min(chunk, length - off);
+        Worker::MakeRequest(&packet, Worker::kBlockRequest, block, off, len);
+        if ((rc = port_.queue(&packet)) != ZX_OK) {
+            zxlogf(ERROR, "zx::port::queue failed: %s\n", zx_status_get_string(rc));
+            // Account for the pieces that won't reach a worker.
+            for (; i < num_chunks; ++i) {
+                WorkerComplete(block, rc);
+            }
+            return;
+        }
+    }
+}
+
+void Device::WorkerComplete(block_op_t* block, zx_status_t status) {
+    LOG_ENTRY_ARGS("block=%p, status=%s", block, zx_status_get_string(status));
+
+    extra_op_t* extra = BlockToExtra(block, info_->op_size);
+    if (status != ZX_OK) {
+        zx_status_t expected = ZX_OK;
+        extra->status.compare_exchange_strong(&expected, status, fbl::memory_order_seq_cst,
+                                              fbl::memory_order_seq_cst);
+    }
+    if (extra->pending.fetch_sub(1) != 1) {
         return;
     }
+
+    status = extra->status.load();
+    switch (block->command & BLOCK_OP_MASK) {
+    case BLOCK_OP_WRITE:
+        BlockForward(block, status);
+        break;
+    case BLOCK_OP_READ:
+        BlockComplete(block, status);
+        break;
+    default:
+        BlockComplete(block, ZX_ERR_NOT_SUPPORTED);
+    }
 }
 
 void Device::BlockCallback(void* cookie, zx_status_t status, block_op_t* block) {
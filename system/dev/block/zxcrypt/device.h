@@ -81,18 +81,27 @@ public:
     // Returns a completed |block| request to the caller of |BlockQueue|.
     void BlockComplete(block_op_t* block, zx_status_t status) __TA_EXCLUDES(mtx_);
 
+    // Called by a worker when it has finished its piece of |block|.  Once every piece is done, the
+    // request goes on to |BlockForward| if it is a write, or |BlockComplete| if it is a read, with
+    // the first error any piece ran into.
+    void WorkerComplete(block_op_t* block, zx_status_t status) __TA_EXCLUDES(mtx_);
+
 private:
     DISALLOW_COPY_ASSIGN_AND_MOVE(Device);
 
-    // TODO(aarongreen): Investigate performance impact of changing this.
-    // Number of encrypting/decrypting workers
-    static const size_t kNumWorkers = 2;
+    // Most encrypting/decrypting workers to start; one is started per CPU, up to this many.
+    static const size_t kMaxWorkers = 16;
+
+    // Smallest piece of a request given to a single worker, in bytes.  Requests larger than this
+    // are split so that several workers transform them at once.
+    static const uint32_t kMinWorkerChunk = 32 * 1024;
 
     // Adds |block| to the write queue if not null, and sends to the workers as many write requests
     // as fit in the space available in the write buffer.
     void EnqueueWrite(block_op_t* block = nullptr) __TA_EXCLUDES(mtx_);
 
-    // Sends a block I/O request to a worker to be encrypted or decrypted.
+    // Sends a block I/O request to the workers to be encrypted or decrypted, split into as many
+    // pieces as there are workers to share it.
     void SendToWorker(block_op_t* block) __TA_EXCLUDES(mtx_);
 
     // Callback used for block ops sent to the parent device.  Restores the fields saved by
@@ -142,7 +151,7 @@ private:
     thrd_t init_;
 
     // Threads that performs encryption/decryption.
-    Worker workers_[kNumWorkers];
+    Worker workers_[kMaxWorkers];
 
     // Port used to send write/read operations to be encrypted/decrypted.
     zx::port port_;
@@ -26,6 +26,8 @@ zx_status_t extra_op_t::Init(block_op_t* block, block_impl_queue_callback cb, vo
     data = nullptr;
     completion_cb = cb;
     cookie = _cookie;
+    pending.store(0);
+    status.store(ZX_OK);
 
     switch (block->command & BLOCK_OP_MASK) {
     case BLOCK_OP_READ:
@@ -8,6 +8,7 @@
 #include <stdint.h>
 
 #include <ddk/protocol/block.h>
+#include <fbl/atomic.h>
 #include <zircon/listnode.h>
 #include <zircon/types.h>
 
@@ -36,6 +37,11 @@ struct extra_op_t {
     block_impl_queue_callback completion_cb;
     void* cookie;
 
+    // The number of pieces of this request still with the workers, and the first error any of
+    // them ran into.
+    fbl::atomic_uint32_t pending;
+    fbl::atomic<zx_status_t> status;
+
     // Resets this structure to an initial state.
     zx_status_t Init(block_op_t* block, block_impl_queue_callback completion_cb, void* cookie,
                      size_t reserved_blocks);
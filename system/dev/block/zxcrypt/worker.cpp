@@ -3,12 +3,14 @@
 // found in the LICENSE file.
 
 #include <inttypes.h>
+#include <limits.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <threads.h>
 
 #include <crypto/cipher.h>
 #include <ddk/debug.h>
+#include <fbl/algorithm.h>
 #include <fbl/auto_call.h>
 #include <lib/zx/port.h>
 #include <zircon/listnode.h>
@@ -32,7 +34,8 @@ Worker::~Worker() {
     LOG_ENTRY();
 }
 
-void Worker::MakeRequest(zx_port_packet_t* packet, uint64_t op, void* arg) {
+void Worker::MakeRequest(zx_port_packet_t* packet, uint64_t op, void* arg, uint32_t off,
+                         uint32_t len) {
     static_assert(sizeof(uintptr_t) <= sizeof(uint64_t), "cannot store pointer as uint64_t");
     ZX_DEBUG_ASSERT(packet);
     packet->key = 0;
@@ -40,6 +43,8 @@ void Worker::MakeRequest(zx_port_packet_t* packet, uint64_t op, void* arg) {
     packet->status = ZX_OK;
     packet->user.u64[0] = op;
     packet->user.u64[1] = reinterpret_cast<uint64_t>(arg);
+    packet->user.u64[2] = off;
+    packet->user.u64[3] = len;
 }
 
 zx_status_t Worker::Start(Device* device, const Volume& volume, zx::port&& port) {
@@ -98,32 +103,38 @@ zx_status_t Worker::Run() {
 
         // Dispatch block request
         block_op_t* block = reinterpret_cast<block_op_t*>(packet.user.u64[1]);
+        uint32_t off = static_cast<uint32_t>(packet.user.u64[2]);
+        uint32_t len = static_cast<uint32_t>(packet.user.u64[3]);
+        if (len == 0) {
+            len = block->rw.length - off;
+        }
         switch (block->command & BLOCK_OP_MASK) {
         case BLOCK_OP_WRITE:
-            device_->BlockForward(block, EncryptWrite(block));
+            device_->WorkerComplete(block, EncryptWrite(block, off, len));
             break;
 
         case BLOCK_OP_READ:
-            device_->BlockComplete(block, DecryptRead(block));
+            device_->WorkerComplete(block, DecryptRead(block, off, len));
             break;
 
         default:
-            device_->BlockComplete(block, ZX_ERR_NOT_SUPPORTED);
+            device_->WorkerComplete(block, ZX_ERR_NOT_SUPPORTED);
         }
     }
 }
 
-zx_status_t Worker::EncryptWrite(block_op_t* block) {
-    LOG_ENTRY_ARGS("block=%p", block);
+zx_status_t Worker::EncryptWrite(block_op_t* block, uint32_t off, uint32_t len) {
+    LOG_ENTRY_ARGS("block=%p, off=%" PRIu32 ", len=%" PRIu32, block, off, len);
     zx_status_t rc;
 
     // Convert blocks to bytes
     extra_op_t* extra = BlockToExtra(block, device_->op_size());
-    uint32_t length;
+    uint32_t length, skip;
     uint64_t offset_dev, offset_vmo;
-    if (mul_overflow(block->rw.length, device_->block_size(), &length) ||
-        mul_overflow(block->rw.offset_dev, device_->block_size(), &offset_dev) ||
-        mul_overflow(extra->offset_vmo, device_->block_size(), &offset_vmo)) {
+    if (mul_overflow(len, device_->block_size(), &length) ||
+        mul_overflow(off, device_->block_size(), &skip) ||
+        mul_overflow(block->rw.offset_dev + off, device_->block_size(), &offset_dev) ||
+        mul_overflow(extra->offset_vmo + off, device_->block_size(), &offset_vmo)) {
         zxlogf(ERROR,
                "overflow; length=%" PRIu32 "; offset_dev=%" PRIu64 "; offset_vmo=%" PRIu64 "\n",
                block->rw.length, block->rw.offset_dev, extra->offset_vmo);
@@ -131,11 +142,12 @@ zx_status_t Worker::EncryptWrite(block_op_t* block) {
     }
 
     // Copy and encrypt the plaintext
-    if ((rc = zx_vmo_read(extra->vmo, extra->data, offset_vmo, length)) != ZX_OK) {
+    uint8_t* data = extra->data + skip;
+    if ((rc = zx_vmo_read(extra->vmo, data, offset_vmo, length)) != ZX_OK) {
         zxlogf(ERROR, "zx_vmo_read() failed: %s\n", zx_status_get_string(rc));
         return rc;
     }
-    if ((rc = encrypt_.Encrypt(extra->data, offset_dev, length, extra->data) != ZX_OK)) {
+    if ((rc = encrypt_.Encrypt(data, offset_dev, length, data) != ZX_OK)) {
         zxlogf(ERROR, "failed to encrypt: %s\n", zx_status_get_string(rc));
         return rc;
     }
@@ -143,35 +155,38 @@ zx_status_t Worker::EncryptWrite(block_op_t* block) {
     return ZX_OK;
 }
 
-zx_status_t Worker::DecryptRead(block_op_t* block) {
-    LOG_ENTRY_ARGS("block=%p", block);
+zx_status_t Worker::DecryptRead(block_op_t* block, uint32_t off, uint32_t len) {
+    LOG_ENTRY_ARGS("block=%p, off=%" PRIu32 ", len=%" PRIu32, block, off, len);
     zx_status_t rc;
 
     // Convert blocks to bytes
     uint32_t length;
     uint64_t offset_dev, offset_vmo;
-    if (mul_overflow(block->rw.length, device_->block_size(), &length) ||
-        mul_overflow(block->rw.offset_dev, device_->block_size(), &offset_dev) ||
-        mul_overflow(block->rw.offset_vmo, device_->block_size(), &offset_vmo)) {
+    if (mul_overflow(len, device_->block_size(), &length) ||
+        mul_overflow(block->rw.offset_dev + off, device_->block_size(), &offset_dev) ||
+        mul_overflow(block->rw.offset_vmo + off, device_->block_size(), &offset_vmo)) {
         zxlogf(ERROR,
                "overflow; length=%" PRIu32 "; offset_dev=%" PRIu64 "; offset_vmo=%" PRIu64 "\n",
                block->rw.length, block->rw.offset_dev, block->rw.offset_vmo);
         return ZX_ERR_OUT_OF_RANGE;
     }
 
-    // Map the ciphertext
+    // Map the ciphertext where the parent device left it in the caller's VMO.  The request need
+    // not start or end on a page boundary, so map the whole pages around it.
+    uint64_t map_off = fbl::round_down(offset_vmo, static_cast<uint64_t>(PAGE_SIZE));
+    size_t map_len = fbl::round_up(offset_vmo + length, static_cast<uint64_t>(PAGE_SIZE)) - map_off;
     zx_handle_t root = zx_vmar_root_self();
     uintptr_t address;
     constexpr uint32_t flags = ZX_VM_PERM_READ | ZX_VM_PERM_WRITE;
-    if ((rc = zx_vmar_map(root, flags, 0, block->rw.vmo, offset_vmo, length, &address)) != ZX_OK) {
+    if ((rc = zx_vmar_map(root, flags, 0, block->rw.vmo, map_off, map_len, &address)) != ZX_OK) {
         zxlogf(ERROR, "zx::vmar::root_self()->map() failed: %s\n", zx_status_get_string(rc));
         return rc;
     }
     auto cleanup =
-        fbl::MakeAutoCall([root, address, length]() { zx_vmar_unmap(root, address, length); });
+        fbl::MakeAutoCall([root, address, map_len]() { zx_vmar_unmap(root, address, map_len); });
 
     // Decrypt in place
-    uint8_t* data = reinterpret_cast<uint8_t*>(address);
+    uint8_t* data = reinterpret_cast<uint8_t*>(address) + (offset_vmo - map_off);
     if ((rc = decrypt_.Decrypt(data, offset_dev, length, data)) != ZX_OK) {
         zxlogf(ERROR, "failed to decrypt: %s\n", zx_status_get_string(rc));
         return rc;
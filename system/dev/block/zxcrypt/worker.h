@@ -32,8 +32,11 @@ public:
     static constexpr uint64_t kBlockRequest = 0x1;
     static constexpr uint64_t kStopRequest = 0x2;
 
-    // Configure the given |packet| to be an |op| request, with an optional |arg|.
-    static void MakeRequest(zx_port_packet_t* packet, uint64_t op, void* arg = nullptr);
+    // Configure the given |packet| to be an |op| request, with an optional |arg|.  A block request
+    // may cover only part of the block op given as |arg|: |len| blocks starting |off| blocks into
+    // it.  A |len| of zero covers the whole op.
+    static void MakeRequest(zx_port_packet_t* packet, uint64_t op, void* arg = nullptr,
+                            uint32_t off = 0, uint32_t len = 0);
 
     // Starts the worker, which will service requests sent from the given |device| on the given
     // |port|.  Cryptographic operations will use the key material from the given |volume|.
@@ -51,12 +54,13 @@ private:
     static int WorkerRun(void* arg) { return static_cast<Worker*>(arg)->Run(); }
     zx_status_t Run();
 
-    // Copies the plaintext data to be written to the write buffer location given in |block|'s extra
-    // information, and encrypts it before sending it to the parent device.
-    zx_status_t EncryptWrite(block_op_t* block);
+    // Copies |len| blocks of the plaintext data to be written, starting |off| blocks into |block|,
+    // to the write buffer location given in |block|'s extra information, and encrypts them.
+    zx_status_t EncryptWrite(block_op_t* block, uint32_t off, uint32_t len);
 
-    // Maps the ciphertext data in |block|, and decrypts it in place before completing the block op.
-    zx_status_t DecryptRead(block_op_t* block);
+    // Maps |len| blocks of the ciphertext data in |block|, starting |off| blocks in, and decrypts
+    // them in place in the caller's VMO.  Reads never pass through the device's write buffer.
+    zx_status_t DecryptRead(block_op_t* block, uint32_t off, uint32_t len);
 
     // The cipher objects used to perform cryptographic.  See notes on "random access" in
     // crypto/cipher.h.
@@ -6,6 +6,7 @@
 
 #include <ddk/debug.h>
 #include <fbl/algorithm.h>
+#include <fbl/alloc_checker.h>
 #include <fbl/auto_lock.h>
 #include <inttypes.h>
 #include <pretty/hexdump.h>
@@ -57,6 +58,10 @@ void BlockDevice::GetInfo(block_info_t* info) {
     if (info->max_transfer_size > MAX_MAX_XFER) {
         info->max_transfer_size = MAX_MAX_XFER;
     }
+
+    if (discard_) {
+        info->flags |= BLOCK_FLAG_TRIM_SUPPORT;
+    }
 }
 
 void BlockDevice::virtio_block_query(void* ctx, block_info_t* info, size_t* bopsz) {
@@ -85,6 +90,9 @@ void BlockDevice::virtio_block_queue(void* ctx, block_op_t* bop,
         //      any later IO begins
         bd->txn_complete(txn, ZX_OK);
         break;
+    case BLOCK_OP_TRIM:
+        bd->QueueTrimTxn(txn);
+        break;
     default:
         bd->txn_complete(txn, ZX_ERR_NOT_SUPPORTED);
     }
@@ -114,7 +122,7 @@ zx_status_t BlockDevice::virtio_block_ioctl(void* ctx, uint32_t op, const void*
 }
 
 BlockDevice::BlockDevice(zx_device_t* bus_device, zx::bti bti, fbl::unique_ptr<Backend> backend)
-    : Device(bus_device, fbl::move(bti), fbl::move(backend)) {
+    : Device(bus_device, fbl::move(bti), fbl::move(backend)), next_queue_(0) {
     sync_completion_reset(&txn_signal_);
 
     memset(&blk_req_buf_, 0, sizeof(blk_req_buf_));
@@ -148,20 +156,49 @@ zx_status_t BlockDevice::Init() {
     // ack and set the driver status bit
     DriverStatusAck();
 
-    // XXX check features bits and ack/nak them
+    // Requests are spread over the device's queues, and trims passed to it, if
+    // it supports them.
+    NegotiateEventIdx();
+    uint16_t num_queues = 1;
+    if (DeviceFeatureSupported(FeatureBit(VIRTIO_BLK_F_MQ))) {
+        DriverFeatureAck(FeatureBit(VIRTIO_BLK_F_MQ));
+        num_queues = fbl::max<uint16_t>(config_.num_queues, 1);
+    }
+    num_queues_ = fbl::min(num_queues, kMaxQueues);
+    if (DeviceFeatureSupported(FeatureBit(VIRTIO_BLK_F_DISCARD)) &&
+        config_.max_discard_sectors > 0 && config_.max_discard_seg > 0) {
+        DriverFeatureAck(FeatureBit(VIRTIO_BLK_F_DISCARD));
+        discard_ = true;
+        max_discard_sectors_ = config_.max_discard_sectors;
+    }
+    LTRACEF("num_queues %u, max_discard_sectors %#x\n", num_queues_, max_discard_sectors_);
 
-    // allocate the main vring
-    auto err = vring_.Init(0, ring_size);
-    if (err < 0) {
-        zxlogf(ERROR, "failed to allocate vring\n");
-        return err;
+    zx_status_t status = DeviceStatusFeaturesOk();
+    if (status) {
+        zxlogf(ERROR, "%s: Feature negotiation failed (%d)\n", tag(), status);
+        return status;
     }
 
-    // allocate a queue of block requests
-    size_t size = sizeof(virtio_blk_req_t) * blk_req_count + sizeof(uint8_t) * blk_req_count;
+    // allocate the vrings
+    for (uint16_t i = 0; i < num_queues_; i++) {
+        fbl::AllocChecker ac;
+        queues_[i].reset(new (&ac) Queue(this));
+        if (!ac.check()) {
+            zxlogf(ERROR, "cannot alloc vring\n");
+            return ZX_ERR_NO_MEMORY;
+        }
+        auto err = queues_[i]->ring.Init(i, ring_size);
+        if (err < 0) {
+            zxlogf(ERROR, "failed to allocate vring\n");
+            return err;
+        }
+    }
+
+    // allocate a queue of block requests, each with room for a discard segment
+    size_t size = (sizeof(virtio_blk_req_t) + sizeof(virtio_blk_discard_write_zeroes_t) +
+                   sizeof(uint8_t)) * blk_req_count;
 
-    zx_status_t status = io_buffer_init(&blk_req_buf_, bti_.get(), size,
-                                        IO_BUFFER_RW | IO_BUFFER_CONTIG);
+    status = io_buffer_init(&blk_req_buf_, bti_.get(), size, IO_BUFFER_RW | IO_BUFFER_CONTIG);
     if (status != ZX_OK) {
         zxlogf(ERROR, "cannot alloc blk_req buffers %d\n", status);
         return status;
@@ -171,9 +208,13 @@ zx_status_t BlockDevice::Init() {
     LTRACEF("allocated blk request at %p, physical address %#" PRIxPTR "\n", blk_req_,
             io_buffer_phys(&blk_req_buf_));
 
+    // discard segments follow the requests
+    blk_seg_pa_ = io_buffer_phys(&blk_req_buf_) + sizeof(virtio_blk_req_t) * blk_req_count;
+    blk_seg_ = (virtio_blk_discard_write_zeroes_t*)(blk_req_ + blk_req_count);
+
     // responses are 32 words at the end of the allocated block
-    blk_res_pa_ = io_buffer_phys(&blk_req_buf_) + sizeof(virtio_blk_req_t) * blk_req_count;
-    blk_res_ = (uint8_t*)((uintptr_t)blk_req_ + sizeof(virtio_blk_req_t) * blk_req_count);
+    blk_res_pa_ = blk_seg_pa_ + sizeof(virtio_blk_discard_write_zeroes_t) * blk_req_count;
+    blk_res_ = (uint8_t*)(blk_seg_ + blk_req_count);
 
     LTRACEF("allocated blk responses at %p, physical address %#" PRIxPTR "\n", blk_res_, blk_res_pa_);
 
@@ -212,12 +253,12 @@ void BlockDevice::IrqRingUpdate() {
     LTRACE_ENTRY;
 
     // parse our descriptor chain, add back to the free queue
-    auto free_chain = [this](vring_used_elem* used_elem) {
+    auto free_chain = [this](Queue* queue, vring_used_elem* used_elem) {
         uint32_t i = (uint16_t)used_elem->id;
-        struct vring_desc* desc = vring_.DescFromIndex((uint16_t)i);
+        struct vring_desc* desc = queue->ring.DescFromIndex((uint16_t)i);
         auto head_desc = desc; // save the first element
         {
-            fbl::AutoLock lock(&ring_lock_);
+            fbl::AutoLock lock(&queue->lock);
             for (;;) {
                 int next;
                 LTRACE_DO(virtio_dump_desc(desc));
@@ -228,12 +269,12 @@ void BlockDevice::IrqRingUpdate() {
                     next = -1;
                 }
 
-                vring_.FreeDesc((uint16_t)i);
+                queue->ring.FreeDesc((uint16_t)i);
 
                 if (next < 0)
                     break;
                 i = next;
-                desc = vring_.DescFromIndex((uint16_t)i);
+                desc = queue->ring.DescFromIndex((uint16_t)i);
             }
         }
 
@@ -272,16 +313,23 @@ void BlockDevice::IrqRingUpdate() {
         }
     };
 
-    // tell the ring to find free chains and hand it back to our lambda
-    vring_.IrqRingUpdate(free_chain);
+    // tell each ring to find free chains and hand them back to our lambda; the
+    // queues share the interrupt
+    for (uint16_t q = 0; q < num_queues_; q++) {
+        Queue* queue = queues_[q].get();
+        queue->ring.IrqRingUpdate([queue, &free_chain](vring_used_elem* used_elem) {
+            free_chain(queue, used_elem);
+        });
+    }
 }
 
 void BlockDevice::IrqConfigChange() {
     LTRACE_ENTRY;
 }
 
-zx_status_t BlockDevice::QueueTxn(block_txn_t* txn, bool write, size_t bytes,
-                                  uint64_t* pages, size_t pagecount, uint16_t* idx) {
+zx_status_t BlockDevice::QueueTxn(block_txn_t* txn, uint32_t type, size_t bytes,
+                                  uint64_t* pages, size_t pagecount, Queue** queue,
+                                  uint16_t* idx) {
 
     size_t index;
     {
@@ -293,10 +341,21 @@ zx_status_t BlockDevice::QueueTxn(block_txn_t* txn, bool write, size_t bytes,
         }
     }
 
+    bool discard = type == VIRTIO_BLK_T_DISCARD;
     auto req = &blk_req_[index];
-    req->type = write ? VIRTIO_BLK_T_OUT : VIRTIO_BLK_T_IN;
+    req->type = type;
     req->ioprio = 0;
-    req->sector = txn->op.rw.offset_dev;
+    if (discard) {
+        // the range to discard is in the request's segment
+        req->sector = 0;
+        auto seg = &blk_seg_[index];
+        seg->sector = txn->op.trim.offset_dev;
+        seg->num_sectors = (uint32_t)(bytes / VIRTIO_BLK_SECTOR_SIZE);
+        seg->flags = 0;
+        LTRACEF("discard sector %" PRIu64 " num_sectors %u\n", seg->sector, seg->num_sectors);
+    } else {
+        req->sector = txn->op.rw.offset_dev;
+    }
     LTRACEF("blk_req type %u ioprio %u sector %" PRIu64 "\n",
             req->type, req->ioprio, req->sector);
 
@@ -311,21 +370,25 @@ zx_status_t BlockDevice::QueueTxn(block_txn_t* txn, bool write, size_t bytes,
 #endif
 
     LTRACEF("page count %lu\n", pagecount);
-    assert(pagecount > 0);
+    assert(discard || pagecount > 0);
+    size_t desc_count = 2u + (discard ? 1u : pagecount);
 
-    /* put together a transfer */
+    /* put together a transfer, on the next queue with room for one */
     uint16_t i;
-    vring_desc *desc;
-    {
-        fbl::AutoLock lock(&ring_lock_);
-        desc = vring_.AllocDescChain((uint16_t)(2u + pagecount), &i);
+    vring_desc *desc = nullptr;
+    uint32_t first = next_queue_.fetch_add(1);
+    for (uint16_t n = 0; n < num_queues_ && !desc; n++) {
+        *queue = queues_[(first + n) % num_queues_].get();
+        fbl::AutoLock lock(&(*queue)->lock);
+        desc = (*queue)->ring.AllocDescChain((uint16_t)desc_count, &i);
     }
     if (!desc) {
-        LTRACEF("failed to allocate descriptor chain of length %zu\n", 2u + pagecount);
+        LTRACEF("failed to allocate descriptor chain of length %zu\n", desc_count);
         fbl::AutoLock lock(&txn_lock_);
         free_blk_req(index);
         return ZX_ERR_NO_RESOURCES;
     }
+    Ring* ring = &(*queue)->ring;
 
     LTRACEF("after alloc chain desc %p, i %u\n", desc, i);
 
@@ -338,8 +401,17 @@ zx_status_t BlockDevice::QueueTxn(block_txn_t* txn, bool write, size_t bytes,
     desc->flags = VRING_DESC_F_NEXT;
     LTRACE_DO(virtio_dump_desc(desc));
 
+    if (discard) {
+        /* set up the descriptor pointing to the segment */
+        desc = ring->DescFromIndex(desc->next);
+        desc->addr = blk_seg_pa_ + index * sizeof(virtio_blk_discard_write_zeroes_t);
+        desc->len = sizeof(virtio_blk_discard_write_zeroes_t);
+        desc->flags = VRING_DESC_F_NEXT;
+        bytes = 0;
+    }
+
     for (size_t n = 0; n < pagecount; n++) {
-        desc = vring_.DescFromIndex(desc->next);
+        desc = ring->DescFromIndex(desc->next);
         desc->addr = pages[n];
         desc->len = (uint32_t) ((bytes > PAGE_SIZE) ? PAGE_SIZE : bytes);
         if (n == 0) {
@@ -358,7 +430,7 @@ zx_status_t BlockDevice::QueueTxn(block_txn_t* txn, bool write, size_t bytes,
         desc->flags = VRING_DESC_F_NEXT;
         LTRACEF("pa %#lx, len %#x\n", desc->addr, desc->len);
 
-        if (!write)
+        if (type == VIRTIO_BLK_T_IN)
             desc->flags |= VRING_DESC_F_WRITE; /* mark buffer as write-only if its a block read */
 
         bytes -= desc->len;
@@ -367,7 +439,7 @@ zx_status_t BlockDevice::QueueTxn(block_txn_t* txn, bool write, size_t bytes,
     assert(bytes == 0);
 
     /* set up the descriptor pointing to the response */
-    desc = vring_.DescFromIndex(desc->next);
+    desc = ring->DescFromIndex(desc->next);
     desc->addr = blk_res_pa_ + index;
     desc->len = 1;
     desc->flags = VRING_DESC_F_WRITE;
@@ -377,6 +449,58 @@ zx_status_t BlockDevice::QueueTxn(block_txn_t* txn, bool write, size_t bytes,
     return ZX_OK;
 }
 
+void BlockDevice::SubmitTxn(block_txn_t* txn, uint32_t type, size_t bytes, uint64_t* pages,
+                            size_t pagecount) {
+    bool cannot_fail = false;
+
+    for (;;) {
+        Queue* queue;
+        uint16_t idx;
+
+        // attempt to setup hw txn
+        zx_status_t status = QueueTxn(txn, type, bytes, pages, pagecount, &queue, &idx);
+        if (status == ZX_OK) {
+            {
+                fbl::AutoLock lock(&txn_lock_);
+
+                // save the txn in a list
+                list_add_tail(&txn_list_, &txn->node);
+            }
+
+            fbl::AutoLock lock(&queue->lock);
+
+            /* submit the transfer */
+            queue->ring.SubmitChain(idx);
+
+            /* kick it off, unless the device is still working through the ring */
+            queue->ring.Kick();
+
+            return;
+        } else {
+            if (cannot_fail) {
+                printf("virtio-block: failed to queue txn to hw: %d\n", status);
+                txn_complete(txn, status);
+                return;
+            }
+
+            fbl::AutoLock lock(&txn_lock_);
+
+            if (list_is_empty(&txn_list_)) {
+                // we hold the queue lock and the list is empty
+                // if we fail this time around, no point in trying again
+                cannot_fail = true;
+                continue;
+            } else {
+                // let the completer know we need to wake up
+                txn_wait_ = true;
+            }
+        }
+
+        sync_completion_wait(&txn_signal_, ZX_TIME_INFINITE);
+        sync_completion_reset(&txn_signal_);
+    }
+}
+
 void BlockDevice::QueueReadWriteTxn(block_txn_t* txn, bool write) {
     LTRACEF("txn %p, command %#x\n", txn, txn->op.command);
 
@@ -421,49 +545,40 @@ void BlockDevice::QueueReadWriteTxn(block_txn_t* txn, bool write) {
 
     pages[0] += suboffset;
 
-    bool cannot_fail = false;
-
-    for (;;) {
-        uint16_t idx;
-
-        // attempt to setup hw txn
-        zx_status_t status = QueueTxn(txn, write, bytes, pages, num_pages, &idx);
-        if (status == ZX_OK) {
-            fbl::AutoLock lock(&txn_lock_);
-
-            // save the txn in a list
-            list_add_tail(&txn_list_, &txn->node);
+    SubmitTxn(txn, write ? VIRTIO_BLK_T_OUT : VIRTIO_BLK_T_IN, bytes, pages, num_pages);
+}
 
-            /* submit the transfer */
-            vring_.SubmitChain(idx);
+void BlockDevice::QueueTrimTxn(block_txn_t* txn) {
+    LTRACEF("txn %p, command %#x\n", txn, txn->op.command);
 
-            /* kick it off */
-            vring_.Kick();
+    if (!discard_) {
+        txn_complete(txn, ZX_ERR_NOT_SUPPORTED);
+        return;
+    }
 
-            return;
-        } else {
-            if (cannot_fail) {
-                printf("virtio-block: failed to queue txn to hw: %d\n", status);
-                txn_complete(txn, status);
-                return;
-            }
+    fbl::AutoLock lock(&lock_);
 
-            fbl::AutoLock lock(&txn_lock_);
+    // trim must fit within device
+    if ((txn->op.trim.offset_dev >= config_.capacity) ||
+        (config_.capacity - txn->op.trim.offset_dev < txn->op.trim.length)) {
+        LTRACEF("request beyond the end of the device!\n");
+        txn_complete(txn, ZX_ERR_OUT_OF_RANGE);
+        return;
+    }
 
-            if (list_is_empty(&txn_list_)) {
-                // we hold the queue lock and the list is empty
-                // if we fail this time around, no point in trying again
-                cannot_fail = true;
-                continue;
-            } else {
-                // let the completer know we need to wake up
-                txn_wait_ = true;
-            }
-        }
+    if (txn->op.trim.length == 0) {
+        txn_complete(txn, ZX_OK);
+        return;
+    }
 
-        sync_completion_wait(&txn_signal_, ZX_TIME_INFINITE);
-        sync_completion_reset(&txn_signal_);
+    // a trim is only a hint, so what's past the most the device discards in
+    // one request is left in place
+    uint64_t sectors = (uint64_t)txn->op.trim.length * config_.blk_size / VIRTIO_BLK_SECTOR_SIZE;
+    if (sectors > max_discard_sectors_) {
+        sectors = max_discard_sectors_;
     }
+
+    SubmitTxn(txn, VIRTIO_BLK_T_DISCARD, sectors * VIRTIO_BLK_SECTOR_SIZE, nullptr, 0);
 }
 
 } // namespace virtio
@@ -10,6 +10,8 @@
 #include <zircon/compiler.h>
 
 #include "backends/backend.h"
+#include <fbl/atomic.h>
+#include <fbl/unique_ptr.h>
 #include <virtio/block.h>
 #include <zircon/device/block.h>
 #include <ddk/protocol/block.h>
@@ -57,22 +59,46 @@ private:
 
     void GetInfo(block_info_t* info);
 
-    zx_status_t QueueTxn(block_txn_t* txn, bool write, size_t bytes,
-                         uint64_t* pages, size_t pagecount, uint16_t* idx);
+    struct Queue {
+        explicit Queue(Device* device)
+            : ring(device) {}
+
+        Ring ring;
+
+        // lock to be used around Ring::AllocDescChain, FreeDesc and SubmitChain
+        // TODO: move this into Ring class once it's certain that other
+        // users of the class are okay with it.
+        fbl::Mutex lock;
+    };
+
+    // Sets up a request of |type| for |txn| on one of the queues, with |pages|
+    // holding its |bytes| of data, returning the queue in |queue| and the head
+    // of its descriptor chain in |idx|.
+    zx_status_t QueueTxn(block_txn_t* txn, uint32_t type, size_t bytes,
+                         uint64_t* pages, size_t pagecount, Queue** queue, uint16_t* idx);
+    // Sends a request to the device as QueueTxn() sets up, waiting for
+    // resources if there are none.
+    void SubmitTxn(block_txn_t* txn, uint32_t type, size_t bytes, uint64_t* pages,
+                   size_t pagecount);
     void QueueReadWriteTxn(block_txn_t* txn, bool write);
+    void QueueTrimTxn(block_txn_t* txn);
 
     void txn_complete(block_txn_t* txn, zx_status_t status);
 
-    // the main virtio ring
-    Ring vring_ = {this};
-
-    // lock to be used around Ring::AllocDescChain and FreeDesc
-    // TODO: move this into Ring class once it's certain that other
-    // users of the class are okay with it.
-    fbl::Mutex ring_lock_;
+    // the virtio rings; requests are spread over them in turn, so the host
+    // may serve them in parallel (VIRTIO_BLK_F_MQ)
+    static const uint16_t kMaxQueues = 8;
+    fbl::unique_ptr<Queue> queues_[kMaxQueues];
+    uint16_t num_queues_ = 1;
+    fbl::atomic<uint32_t> next_queue_;
 
     static const uint16_t ring_size = 128; // 128 matches legacy pci
 
+    // whether trims are passed to the device (VIRTIO_BLK_F_DISCARD), and the
+    // most sectors one may cover
+    bool discard_ = false;
+    uint32_t max_discard_sectors_ = 0;
+
     // saved block device configuration out of the pci config BAR
     virtio_blk_config_t config_ = {};
 
@@ -85,6 +111,10 @@ private:
     zx_paddr_t blk_res_pa_ = 0;
     uint8_t* blk_res_ = nullptr;
 
+    // the data of each discard request, which follows the requests
+    zx_paddr_t blk_seg_pa_ = 0;
+    virtio_blk_discard_write_zeroes_t* blk_seg_ = nullptr;
+
     uint32_t blk_req_bitmap_ = 0;
     static_assert(blk_req_count <= sizeof(blk_req_bitmap_) * CHAR_BIT, "");
 
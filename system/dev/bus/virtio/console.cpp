@@ -132,6 +132,7 @@ zx_status_t ConsoleDevice::Init() TA_NO_THREAD_SAFETY_ANALYSIS {
         return ZX_ERR_NOT_SUPPORTED;
     }
     DriverFeatureAck(VIRTIO_F_VERSION_1);
+    NegotiateEventIdx();
 
     zx_status_t status = DeviceStatusFeaturesOk();
     if (status) {
@@ -85,6 +85,13 @@ void Device::StartIrqThread() {
     thrd_detach(irq_thread_);
 }
 
+void Device::NegotiateEventIdx() {
+    if (DeviceFeatureSupported(VIRTIO_F_RING_EVENT_IDX)) {
+        DriverFeatureAck(VIRTIO_F_RING_EVENT_IDX);
+        event_idx_ = true;
+    }
+}
+
 zx_status_t Device::CopyDeviceConfig(void* _buf, size_t len) const {
     assert(_buf);
 
@@ -58,10 +58,22 @@ public:
 
     // Accessor for bti so that Rings can map IO buffers
     const zx::bti& bti() { return bti_; }
+
+    // Whether VIRTIO_F_RING_EVENT_IDX was negotiated, in which case Rings
+    // suppress notifications and interrupts with the event indices.
+    bool event_idx() const { return event_idx_; }
 protected:
     // Methods for checking / acknowledging features
     bool DeviceFeatureSupported(uint32_t feature) { return backend_->ReadFeature(feature); }
     void DriverFeatureAck(uint32_t feature) { backend_->SetFeature(feature); }
+    // The device-specific features of the virtio headers are masks within the
+    // first feature word, while the methods above take feature bit numbers.
+    static constexpr uint32_t FeatureBit(uint32_t mask) {
+        return static_cast<uint32_t>(__builtin_ctz(mask));
+    }
+    // Acks VIRTIO_F_RING_EVENT_IDX if the device offers it. Must be called
+    // before the Rings are initialized.
+    void NegotiateEventIdx();
     bool DeviceStatusFeaturesOk() { return backend_->ConfirmFeatures(); }
 
     // Devie lifecycle methods
@@ -91,6 +103,7 @@ protected:
     // Bus device is the parent device on the bus, device is this driver's device node.
     zx_device_t* bus_device_ = nullptr;
     zx_device_t* device_ = nullptr;
+    bool event_idx_ = false;
 
     // DDK device
     // TODO: It might make sense for the base device class to be the one
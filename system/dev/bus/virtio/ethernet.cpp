@@ -23,6 +23,7 @@
 #include <virtio/virtio.h>
 #include <zircon/assert.h>
 #include <zircon/status.h>
+#include <zircon/syscalls.h>
 #include <zircon/types.h>
 
 #include "ring.h"
@@ -45,13 +46,27 @@ const size_t kVirtioMtu = 1500;
 const size_t kL1EthHdrLen = 26;
 
 // Other constants determined by the values above and the memory architecture.
-// The goal here is to allocate single-page I/O buffers.
+// The goal here is to allocate single-page I/O buffers, the same number for each
+// virtqueue.
 const size_t kFrameSize = sizeof(virtio_net_hdr_t) + kL1EthHdrLen + kVirtioMtu;
 const size_t kFramesInBuf = PAGE_SIZE / kFrameSize;
-const size_t kNumIoBufs = fbl::round_up(kBacklog * 2, kFramesInBuf) / kFramesInBuf;
+const size_t kIoBufsPerRing = fbl::round_up(kBacklog, kFramesInBuf) / kFramesInBuf;
 
-const uint16_t kRxId = 0u;
-const uint16_t kTxId = 1u;
+// With VIRTIO_NET_F_MRG_RXBUF, the receive pages are split into smaller
+// buffers, which a full-sized frame spans two of. The same memory then holds
+// twice as many small frames, and none of it is left over in each page.
+const size_t kMrgBufSize = PAGE_SIZE / 4;
+
+// How many milliseconds the device is given to answer a control command.
+const int kCtrlTimeoutMs = 100;
+
+uint16_t RxId(uint16_t pair) {
+    return static_cast<uint16_t>(2 * pair);
+}
+
+uint16_t TxId(uint16_t pair) {
+    return static_cast<uint16_t>(2 * pair + 1);
+}
 
 // Strictly for convenience...
 typedef struct vring_desc desc_t;
@@ -106,8 +121,15 @@ zx_status_t virtio_net_queue_tx(void* ctx, uint32_t options, ethmac_netbuf_t* ne
     return eth->QueueTx(options, netbuf);
 }
 
+void virtio_net_queue_tx_batch(void* ctx, uint32_t options, ethmac_netbuf_t** netbufs,
+                               size_t count, zx_status_t* statuses) {
+    virtio::EthernetDevice* eth = static_cast<virtio::EthernetDevice*>(ctx);
+    eth->QueueTxBatch(options, netbufs, count, statuses);
+}
+
 static zx_status_t virtio_set_param(void* ctx, uint32_t param, int32_t value, void* data) {
-    return ZX_ERR_NOT_SUPPORTED;
+    virtio::EthernetDevice* eth = static_cast<virtio::EthernetDevice*>(ctx);
+    return eth->SetParam(param, value, data);
 }
 
 ethmac_protocol_ops_t kProtoOps = {
@@ -117,21 +139,21 @@ ethmac_protocol_ops_t kProtoOps = {
     virtio_net_queue_tx,
     virtio_set_param,
     NULL, // get_bti not implemented because we don't have FEATURE_DMA
+    virtio_net_queue_tx_batch,
 };
 
 // I/O buffer helpers
-zx_status_t InitBuffers(const zx::bti& bti, fbl::unique_ptr<io_buffer_t[]>* out) {
+zx_status_t InitBuffers(const zx::bti& bti, size_t count, fbl::unique_ptr<io_buffer_t[]>* out) {
     zx_status_t rc;
     fbl::AllocChecker ac;
-    fbl::unique_ptr<io_buffer_t[]> bufs(new (&ac) io_buffer_t[kNumIoBufs]);
+    fbl::unique_ptr<io_buffer_t[]> bufs(new (&ac) io_buffer_t[count]);
     if (!ac.check()) {
         zxlogf(ERROR, "out of memory!\n");
         return ZX_ERR_NO_MEMORY;
     }
-    memset(bufs.get(), 0, sizeof(io_buffer_t) * kNumIoBufs);
-    size_t buf_size = kFrameSize * kFramesInBuf;
-    for (uint16_t id = 0; id < kNumIoBufs; ++id) {
-        if ((rc = io_buffer_init(&bufs[id], bti.get(), buf_size,
+    memset(bufs.get(), 0, sizeof(io_buffer_t) * count);
+    for (size_t id = 0; id < count; ++id) {
+        if ((rc = io_buffer_init(&bufs[id], bti.get(), PAGE_SIZE,
                                  IO_BUFFER_RW | IO_BUFFER_CONTIG)) != ZX_OK) {
             zxlogf(ERROR, "failed to allocate I/O buffers: %s\n", zx_status_get_string(rc));
             return rc;
@@ -141,49 +163,53 @@ zx_status_t InitBuffers(const zx::bti& bti, fbl::unique_ptr<io_buffer_t[]>* out)
     return ZX_OK;
 }
 
-void ReleaseBuffers(fbl::unique_ptr<io_buffer_t[]> bufs) {
+void ReleaseBuffers(fbl::unique_ptr<io_buffer_t[]> bufs, size_t count) {
     if (!bufs) {
         return;
     }
-    for (size_t i = 0; i < kNumIoBufs; ++i) {
+    for (size_t i = 0; i < count; ++i) {
         if (io_buffer_is_valid(&bufs[i])) {
             io_buffer_release(&bufs[i]);
         }
     }
 }
 
-// Frame access helpers
-zx_off_t GetFrame(io_buffer_t** bufs, uint16_t ring_id, uint16_t desc_id) {
-    uint16_t i = static_cast<uint16_t>(desc_id + ring_id * kBacklog);
-    *bufs = &((*bufs)[i / kFramesInBuf]);
-    return (i % kFramesInBuf) * kFrameSize;
+// Frame access helpers; the buffers of each virtqueue are |frame_size| bytes.
+zx_off_t GetFrame(io_buffer_t** bufs, uint16_t ring_id, uint16_t desc_id, size_t frame_size) {
+    size_t frames_in_buf = PAGE_SIZE / frame_size;
+    *bufs = &((*bufs)[ring_id * kIoBufsPerRing + desc_id / frames_in_buf]);
+    return (desc_id % frames_in_buf) * frame_size;
 }
 
-void* GetFrameVirt(io_buffer_t* bufs, uint16_t ring_id, uint16_t desc_id) {
-    zx_off_t offset = GetFrame(&bufs, ring_id, desc_id);
+void* GetFrameVirt(io_buffer_t* bufs, uint16_t ring_id, uint16_t desc_id, size_t frame_size) {
+    zx_off_t offset = GetFrame(&bufs, ring_id, desc_id, frame_size);
     uintptr_t vaddr = reinterpret_cast<uintptr_t>(io_buffer_virt(bufs));
     return reinterpret_cast<void*>(vaddr + offset);
 }
 
-zx_paddr_t GetFramePhys(io_buffer_t* bufs, uint16_t ring_id, uint16_t desc_id) {
-    zx_off_t offset = GetFrame(&bufs, ring_id, desc_id);
+zx_paddr_t GetFramePhys(io_buffer_t* bufs, uint16_t ring_id, uint16_t desc_id, size_t frame_size) {
+    zx_off_t offset = GetFrame(&bufs, ring_id, desc_id, frame_size);
     return io_buffer_phys(bufs) + offset;
 }
 
-virtio_net_hdr_t* GetFrameHdr(io_buffer_t* bufs, uint16_t ring_id, uint16_t desc_id) {
-    return reinterpret_cast<virtio_net_hdr_t*>(GetFrameVirt(bufs, ring_id, desc_id));
+virtio_net_hdr_t* GetFrameHdr(io_buffer_t* bufs, uint16_t ring_id, uint16_t desc_id,
+                              size_t frame_size) {
+    return reinterpret_cast<virtio_net_hdr_t*>(GetFrameVirt(bufs, ring_id, desc_id, frame_size));
 }
 
-uint8_t* GetFrameData(io_buffer_t* bufs, uint16_t ring_id, uint16_t desc_id, size_t hdr_size) {
-    uintptr_t vaddr = reinterpret_cast<uintptr_t>(GetFrameHdr(bufs, ring_id, desc_id));
+uint8_t* GetFrameData(io_buffer_t* bufs, uint16_t ring_id, uint16_t desc_id, size_t frame_size,
+                      size_t hdr_size) {
+    uintptr_t vaddr = reinterpret_cast<uintptr_t>(GetFrameHdr(bufs, ring_id, desc_id, frame_size));
     return reinterpret_cast<uint8_t*>(vaddr + hdr_size);
 }
 
 } // namespace
 
 EthernetDevice::EthernetDevice(zx_device_t* bus_device, zx::bti bti, fbl::unique_ptr<Backend> backend)
-    : Device(bus_device, fbl::move(bti), fbl::move(backend)), rx_(this), tx_(this), bufs_(nullptr),
-      unkicked_(0), ifc_(nullptr), cookie_(nullptr) {
+    : Device(bus_device, fbl::move(bti), fbl::move(backend)), num_queues_(1), ctrl_(this),
+      bufs_(nullptr), num_bufs_(0), rx_buf_size_(kFrameSize), mrg_rxbuf_(false), tx_csum_(false),
+      rx_csum_(false), ifc_(nullptr), cookie_(nullptr) {
+    memset(&ctrl_buf_, 0, sizeof(ctrl_buf_));
 }
 
 EthernetDevice::~EthernetDevice() {
@@ -192,9 +218,9 @@ EthernetDevice::~EthernetDevice() {
 
 zx_status_t EthernetDevice::Init() {
     LTRACE_ENTRY;
+    static_assert(kMaxFrameLen == kL1EthHdrLen + kVirtioMtu, "");
     zx_status_t rc;
-    if (mtx_init(&state_lock_, mtx_plain) != thrd_success ||
-        mtx_init(&tx_lock_, mtx_plain) != thrd_success) {
+    if (mtx_init(&state_lock_, mtx_plain) != thrd_success) {
         return ZX_ERR_NO_RESOURCES;
     }
     fbl::AutoLock lock(&state_lock_);
@@ -210,10 +236,17 @@ zx_status_t EthernetDevice::Init() {
     // Ack and set the driver status bit
     DriverStatusAck();
 
+    // Frames may be received into several buffers, which the header of the
+    // first counts in num_buffers.
+    mrg_rxbuf_ = DeviceFeatureSupported(FeatureBit(VIRTIO_NET_F_MRG_RXBUF));
+    if (mrg_rxbuf_) {
+        DriverFeatureAck(FeatureBit(VIRTIO_NET_F_MRG_RXBUF));
+    }
+
     virtio_hdr_len_ = sizeof(virtio_net_hdr_t);
     if (DeviceFeatureSupported(VIRTIO_F_VERSION_1)) {
       DriverFeatureAck(VIRTIO_F_VERSION_1);
-    } else {
+    } else if (!mrg_rxbuf_) {
       // 5.1.6.1 Legacy Interface: Device Operation
       //
       // The legacy driver only presented num_buffers in the struct
@@ -222,6 +255,35 @@ zx_status_t EthernetDevice::Init() {
       virtio_hdr_len_ -= 2;
     }
 
+    // Checksum offloads are passed through to the ethernet core; see
+    // ETHMAC_FEATURE_TX_CSUM and ETHMAC_FEATURE_RX_CSUM.
+    tx_csum_ = DeviceFeatureSupported(FeatureBit(VIRTIO_NET_F_CSUM));
+    if (tx_csum_) {
+        DriverFeatureAck(FeatureBit(VIRTIO_NET_F_CSUM));
+    }
+    rx_csum_ = DeviceFeatureSupported(FeatureBit(VIRTIO_NET_F_GUEST_CSUM));
+    if (rx_csum_) {
+        DriverFeatureAck(FeatureBit(VIRTIO_NET_F_GUEST_CSUM));
+    }
+
+    // Notifications and interrupts are only sent once the other side has
+    // caught up.
+    NegotiateEventIdx();
+
+    // Queue pairs past the first are enabled with a command on the control
+    // virtqueue, which follows the last pair the device has. There's little
+    // to gain from more pairs than there are CPUs to drive them.
+    uint16_t max_pairs = 1;
+    if (DeviceFeatureSupported(FeatureBit(VIRTIO_NET_F_MQ)) &&
+        DeviceFeatureSupported(FeatureBit(VIRTIO_NET_F_CTRL_VQ))) {
+        DriverFeatureAck(FeatureBit(VIRTIO_NET_F_MQ));
+        DriverFeatureAck(FeatureBit(VIRTIO_NET_F_CTRL_VQ));
+        max_pairs = fbl::max<uint16_t>(config_.max_virtqueue_pairs, 1);
+    }
+    num_queues_ = fbl::min<uint16_t>(max_pairs, kMaxQueuePairs);
+    num_queues_ = static_cast<uint16_t>(fbl::min<uint32_t>(num_queues_,
+                                                           zx_system_get_num_cpus()));
+
     // TODO(aarongreen): Check additional features bits and ack/nak them
     rc = DeviceStatusFeaturesOk();
     if (rc != ZX_OK) {
@@ -233,39 +295,81 @@ zx_status_t EthernetDevice::Init() {
     auto cleanup = fbl::MakeAutoCall([this]() { Release(); });
 
     // Allocate I/O buffers and virtqueues.
-    uint16_t num_descs = static_cast<uint16_t>(kBacklog & 0xffff);
-    if ((rc = InitBuffers(bti_, &bufs_)) != ZX_OK || (rc = rx_.Init(kRxId, num_descs)) != ZX_OK ||
-        (rc = tx_.Init(kTxId, num_descs)) != ZX_OK) {
-        zxlogf(ERROR, "failed to allocate virtqueue: %s\n", zx_status_get_string(rc));
+    uint16_t tx_descs = static_cast<uint16_t>(kBacklog & 0xffff);
+    rx_buf_size_ = mrg_rxbuf_ ? kMrgBufSize : kFrameSize;
+    uint16_t rx_descs = static_cast<uint16_t>(kIoBufsPerRing * (PAGE_SIZE / rx_buf_size_));
+    while (rx_descs > tx_descs && rx_descs > GetRingSize(RxId(0))) {
+        rx_descs = static_cast<uint16_t>(rx_descs / 2);
+    }
+    num_bufs_ = kIoBufsPerRing * 2 * num_queues_;
+    if ((rc = InitBuffers(bti_, num_bufs_, &bufs_)) != ZX_OK) {
         return rc;
     }
+    fbl::AllocChecker ac;
+    for (uint16_t i = 0; i < num_queues_; ++i) {
+        queues_[i].reset(new (&ac) QueuePair(this, i));
+        if (!ac.check()) {
+            zxlogf(ERROR, "out of memory!\n");
+            return ZX_ERR_NO_MEMORY;
+        }
+        QueuePair* q = queues_[i].get();
+        if (mtx_init(&q->tx_lock, mtx_plain) != thrd_success) {
+            return ZX_ERR_NO_RESOURCES;
+        }
+        if ((rc = q->rx.Init(RxId(i), rx_descs)) != ZX_OK ||
+            (rc = q->tx.Init(TxId(i), tx_descs)) != ZX_OK) {
+            zxlogf(ERROR, "failed to allocate virtqueue: %s\n", zx_status_get_string(rc));
+            return rc;
+        }
 
-    // Associate the I/O buffers with the virtqueue descriptors
-    desc_t* desc = nullptr;
-    uint16_t id;
-
-    // For rx buffers, we queue a bunch of "reads" from the network that
-    // complete when packets arrive.
-    for (uint16_t i = 0; i < num_descs; ++i) {
-        desc = rx_.AllocDescChain(1, &id);
-        desc->addr = GetFramePhys(bufs_.get(), kRxId, id);
-        desc->len = kFrameSize;
-        desc->flags |= VRING_DESC_F_WRITE;
-        LTRACE_DO(virtio_dump_desc(desc));
-        rx_.SubmitChain(id);
+        // Associate the I/O buffers with the virtqueue descriptors
+        desc_t* desc = nullptr;
+        uint16_t id;
+
+        // For rx buffers, we queue a bunch of "reads" from the network that
+        // complete when packets arrive.
+        for (uint16_t j = 0; j < rx_descs; ++j) {
+            desc = q->rx.AllocDescChain(1, &id);
+            desc->addr = GetFramePhys(bufs_.get(), RxId(i), id, rx_buf_size_);
+            desc->len = static_cast<uint32_t>(rx_buf_size_);
+            desc->flags |= VRING_DESC_F_WRITE;
+            LTRACE_DO(virtio_dump_desc(desc));
+            q->rx.AddChain(id);
+        }
+        q->rx.PublishChains();
+
+        // For tx buffers, we hold onto them until we need to send a packet.
+        for (uint16_t id = 0; id < tx_descs; ++id) {
+            desc = q->tx.DescFromIndex(id);
+            desc->addr = GetFramePhys(bufs_.get(), TxId(i), id, kFrameSize);
+            desc->len = 0;
+            desc->flags &= static_cast<uint16_t>(~VRING_DESC_F_WRITE);
+            LTRACE_DO(virtio_dump_desc(desc));
+        }
     }
-
-    // For tx buffers, we hold onto them until we need to send a packet.
-    for (uint16_t id = 0; id < num_descs; ++id) {
-        desc = tx_.DescFromIndex(id);
-        desc->addr = GetFramePhys(bufs_.get(), kTxId, id);
-        desc->len = 0;
-        desc->flags &= static_cast<uint16_t>(~VRING_DESC_F_WRITE);
-        LTRACE_DO(virtio_dump_desc(desc));
+    if (num_queues_ > 1) {
+        if ((rc = ctrl_.Init(RxId(max_pairs), 2)) != ZX_OK ||
+            (rc = io_buffer_init(&ctrl_buf_, bti_.get(), PAGE_SIZE,
+                                 IO_BUFFER_RW | IO_BUFFER_CONTIG)) != ZX_OK) {
+            zxlogf(ERROR, "failed to allocate control virtqueue: %s\n", zx_status_get_string(rc));
+            return rc;
+        }
     }
 
-    // Start the interrupt thread and set the driver OK status
+    // Start the interrupt thread and set the driver OK status, after which the
+    // device takes commands.
     StartIrqThread();
+    DriverStatusOk();
+    if (num_queues_ > 1 && (rc = SetQueuePairs()) != ZX_OK) {
+        zxlogf(ERROR, "%s: failed to enable %u queue pairs, using one: %s\n", tag(), num_queues_,
+               zx_status_get_string(rc));
+        num_queues_ = 1;
+    }
+
+    // Give the rx buffers to the host
+    for (uint16_t i = 0; i < num_queues_; ++i) {
+        queues_[i]->rx.Kick();
+    }
 
     // Initialize the zx_device and publish us
     device_add_args_t args;
@@ -280,15 +384,58 @@ zx_status_t EthernetDevice::Init() {
         zxlogf(ERROR, "failed to add device: %s\n", zx_status_get_string(rc));
         return rc;
     }
-    // Give the rx buffers to the host
-    rx_.Kick();
 
     // Woohoo! Driver should be ready.
     cleanup.cancel();
-    DriverStatusOk();
     return ZX_OK;
 }
 
+zx_status_t EthernetDevice::SetQueuePairs() {
+    // 5.1.6.5.5 Automatic receive steering in multiqueue mode
+    //
+    // The command is read from one descriptor and acknowledged in another.
+    uint16_t id;
+    desc_t* desc = ctrl_.AllocDescChain(2, &id);
+    if (!desc) {
+        return ZX_ERR_NO_RESOURCES;
+    }
+    auto hdr = static_cast<virtio_net_ctrl_hdr_t*>(io_buffer_virt(&ctrl_buf_));
+    auto mq = reinterpret_cast<virtio_net_ctrl_mq_t*>(hdr + 1);
+    auto ack = reinterpret_cast<volatile uint8_t*>(mq + 1);
+    hdr->ctrl_class = VIRTIO_NET_CTRL_MQ;
+    hdr->cmd = VIRTIO_NET_CTRL_MQ_VQ_PAIRS_SET;
+    mq->virtqueue_pairs = num_queues_;
+    *ack = VIRTIO_NET_ERR;
+
+    desc->addr = io_buffer_phys(&ctrl_buf_);
+    desc->len = sizeof(*hdr) + sizeof(*mq);
+    desc->flags &= static_cast<uint16_t>(~VRING_DESC_F_WRITE);
+    desc_t* status = ctrl_.DescFromIndex(desc->next);
+    status->addr = desc->addr + desc->len;
+    status->len = sizeof(*ack);
+    status->flags |= VRING_DESC_F_WRITE;
+    ctrl_.SubmitChain(id);
+    ctrl_.Kick();
+
+    // The device answers right away, so it's polled for rather than waited on.
+    size_t done = 0;
+    for (int i = 0; i < kCtrlTimeoutMs && !done; ++i) {
+        done = ctrl_.IrqRingUpdate([this](vring_used_elem* used_elem) {
+            uint16_t id = static_cast<uint16_t>(used_elem->id & 0xffff);
+            uint16_t next = ctrl_.DescFromIndex(id)->next;
+            ctrl_.FreeDesc(id);
+            ctrl_.FreeDesc(next);
+        });
+        if (!done) {
+            zx_nanosleep(zx_deadline_after(ZX_MSEC(1)));
+        }
+    }
+    if (!done) {
+        return ZX_ERR_TIMED_OUT;
+    }
+    return *ack == VIRTIO_NET_OK ? ZX_OK : ZX_ERR_NOT_SUPPORTED;
+}
+
 void EthernetDevice::Release() {
     LTRACE_ENTRY;
     fbl::AutoLock lock(&state_lock_);
@@ -297,55 +444,126 @@ void EthernetDevice::Release() {
 
 void EthernetDevice::ReleaseLocked() {
     ifc_ = nullptr;
-    ReleaseBuffers(fbl::move(bufs_));
+    ReleaseBuffers(fbl::move(bufs_), num_bufs_);
+    if (io_buffer_is_valid(&ctrl_buf_)) {
+        io_buffer_release(&ctrl_buf_);
+    }
     Device::Release();
 }
 
 void EthernetDevice::IrqRingUpdate() {
     LTRACE_ENTRY;
+    // All queues share the interrupt, so each is checked in turn.
+    uint16_t num_queues;
+
     // Lock to prevent changes to ifc_.
     {
         fbl::AutoLock lock(&state_lock_);
         if (!ifc_) {
             return;
         }
-        // Ring::IrqRingUpdate will call this lambda on each rx buffer filled by
-        // the underlying device since the last IRQ.
-        // Thread safety analysis is explicitly disabled as clang isn't able to determine that the
-        // state_lock_ is  held when the lambda invoked.
-        rx_.IrqRingUpdate([this](vring_used_elem* used_elem) TA_NO_THREAD_SAFETY_ANALYSIS {
-            uint16_t id = static_cast<uint16_t>(used_elem->id & 0xffff);
-            desc_t* desc = rx_.DescFromIndex(id);
-
-            // Transitional driver does not merge rx buffers.
-            assert(used_elem->len < desc->len);
-            uint8_t* data = GetFrameData(bufs_.get(), kRxId, id, virtio_hdr_len_);
-            size_t len = used_elem->len - virtio_hdr_len_;
-            LTRACEF("Receiving %zu bytes:\n", len);
-            LTRACE_DO(hexdump8_ex(data, len, 0));
-
-            // Pass the data up the stack to the generic Ethernet driver
-            ifc_->recv(cookie_, data, len, 0);
-            assert((desc->flags & VRING_DESC_F_NEXT) == 0);
-            LTRACE_DO(virtio_dump_desc(desc));
-            rx_.FreeDesc(id);
-        });
+        num_queues = num_queues_;
+        for (uint16_t i = 0; i < num_queues; ++i) {
+            QueuePair* q = queues_[i].get();
+            // Ring::IrqRingUpdate will call this lambda on each rx buffer filled by
+            // the underlying device since the last IRQ.
+            // Thread safety analysis is explicitly disabled as clang isn't able to determine that the
+            // state_lock_ is  held when the lambda invoked.
+            q->rx.IrqRingUpdate([this, q](vring_used_elem* used_elem) TA_NO_THREAD_SAFETY_ANALYSIS {
+                RxBufferLocked(q, used_elem);
+            });
+        }
+    }
+
+    // Now recycle the rx buffers.
+    for (uint16_t i = 0; i < num_queues; ++i) {
+        RxRefill(queues_[i].get());
+    }
+}
+
+void EthernetDevice::RxBufferLocked(QueuePair* q, vring_used_elem* used_elem) {
+    uint16_t id = static_cast<uint16_t>(used_elem->id & 0xffff);
+    desc_t* desc = q->rx.DescFromIndex(id);
+    assert((desc->flags & VRING_DESC_F_NEXT) == 0);
+    LTRACE_DO(virtio_dump_desc(desc));
+    auto free_desc = fbl::MakeAutoCall([q, id]() { q->rx.FreeDesc(id); });
+
+    uint8_t* data = static_cast<uint8_t*>(GetFrameVirt(bufs_.get(), RxId(q->index), id,
+                                                       rx_buf_size_));
+    size_t len = fbl::min<size_t>(used_elem->len, desc->len);
+
+    // The first buffer of each frame starts with its header.
+    if (q->rx_pending == 0) {
+        if (len < virtio_hdr_len_) {
+            LTRACEF("dropping packet; short buffer\n");
+            return;
+        }
+        virtio_net_hdr_t* rx_hdr = reinterpret_cast<virtio_net_hdr_t*>(data);
+        data += virtio_hdr_len_;
+        len -= virtio_hdr_len_;
+
+        // The device validated the packet's checksum, or left it to be
+        // filled in as the packet never crossed a wire (NEEDS_CSUM).
+        uint32_t flags = 0;
+        if (rx_csum_ &&
+            (rx_hdr->flags & (VIRTIO_NET_HDR_F_DATA_VALID | VIRTIO_NET_HDR_F_NEEDS_CSUM))) {
+            flags |= ETHMAC_RX_CSUM_VALID;
+        }
+
+        // Frames which fit in a single buffer are passed up from it directly.
+        uint16_t num_buffers = mrg_rxbuf_ ? rx_hdr->num_buffers : 1;
+        if (num_buffers <= 1) {
+            RecvLocked(q, data, len, flags);
+            return;
+        }
+        q->rx_pending = num_buffers;
+        q->rx_len = 0;
+        q->rx_flags = flags;
+    }
+
+    // Otherwise the frame is gathered from its buffers, and dropped if they add
+    // up to more than it can be.
+    if (q->rx_len + len <= sizeof(q->rx_frame)) {
+        memcpy(q->rx_frame + q->rx_len, data, len);
+    }
+    q->rx_len += len;
+    if (--q->rx_pending == 0) {
+        if (q->rx_len > sizeof(q->rx_frame)) {
+            LTRACEF("dropping packet; %zu bytes is too long\n", q->rx_len);
+            return;
+        }
+        RecvLocked(q, q->rx_frame, q->rx_len, q->rx_flags);
+    }
+}
+
+void EthernetDevice::RecvLocked(QueuePair* q, void* data, size_t len, uint32_t flags) {
+    LTRACEF("Receiving %zu bytes on queue %u:\n", len, q->index);
+    LTRACE_DO(hexdump8_ex(data, len, 0));
+
+    // Pass the data up the stack to the generic Ethernet driver
+    if (ifc_->recv_queue) {
+        ifc_->recv_queue(cookie_, q->index, data, len, flags);
+    } else {
+        ifc_->recv(cookie_, data, len, flags);
     }
+}
 
-    // Now recycle the rx buffers.  As in Init(), this means queuing a bunch of
-    // "reads" from the network that will complete when packets arrive.
+void EthernetDevice::RxRefill(QueuePair* q) {
+    // As in Init(), this means queuing a bunch of "reads" from the network that
+    // will complete when packets arrive.
     desc_t* desc = nullptr;
     uint16_t id;
     bool need_kick = false;
-    while ((desc = rx_.AllocDescChain(1, &id))) {
-        desc->len = kFrameSize;
-        rx_.SubmitChain(id);
+    while ((desc = q->rx.AllocDescChain(1, &id))) {
+        desc->len = static_cast<uint32_t>(rx_buf_size_);
+        q->rx.AddChain(id);
         need_kick = true;
     }
 
     // If we have re-queued any rx buffers, poke the virtqueue to pick them up.
     if (need_kick) {
-        rx_.Kick();
+        q->rx.PublishChains();
+        q->rx.Kick();
     }
 }
 
@@ -368,7 +586,17 @@ zx_status_t EthernetDevice::Query(uint32_t options, ethmac_info_t* info) {
     }
     fbl::AutoLock lock(&state_lock_);
     if (info) {
-        // TODO(aarongreen): Add info->features = GetFeatures();
+        info->features = 0;
+        if (tx_csum_) {
+            info->features |= ETHMAC_FEATURE_TX_CSUM;
+        }
+        if (rx_csum_) {
+            info->features |= ETHMAC_FEATURE_RX_CSUM;
+        }
+        if (num_queues_ > 1) {
+            info->features |= ETHMAC_FEATURE_MULTIQUEUE;
+            info->num_queues = num_queues_;
+        }
         info->mtu = kVirtioMtu;
         memcpy(info->mac, config_.mac, sizeof(info->mac));
     }
@@ -397,7 +625,50 @@ zx_status_t EthernetDevice::Start(ethmac_ifc_t* ifc, void* cookie) {
 }
 
 zx_status_t EthernetDevice::QueueTx(uint32_t options, ethmac_netbuf_t* netbuf) {
+    zx_status_t status;
+    QueueTxBatch(options, &netbuf, 1, &status);
+    return status;
+}
+
+void EthernetDevice::QueueTxBatch(uint32_t options, ethmac_netbuf_t** netbufs, size_t count,
+                                  zx_status_t* statuses) {
     LTRACE_ENTRY;
+    size_t i = 0;
+    while (i < count) {
+        uint16_t queue = netbufs[i]->queue;
+        if (queue >= num_queues_) {
+            statuses[i++] = ZX_ERR_INVALID_ARGS;
+            continue;
+        }
+
+        // Each run of netbufs for the same queue is sent under its lock.
+        QueuePair* q = queues_[queue].get();
+        fbl::AutoLock lock(&q->tx_lock);
+        for (; i < count && netbufs[i]->queue == queue; i++) {
+            statuses[i] = QueueTxLocked(q, netbufs[i]);
+            // Kick the back-end once for the whole run, unless too many
+            // descriptors would be left unannounced.
+            if (q->unkicked > kBacklog / 2) {
+                KickTxLocked(q);
+            }
+        }
+        if (i < count || (options & ETHMAC_TX_OPT_MORE) == 0) {
+            KickTxLocked(q);
+        }
+    }
+}
+
+void EthernetDevice::KickTxLocked(QueuePair* q) {
+    if (q->unkicked == 0) {
+        return;
+    }
+    q->tx.PublishChains();
+    q->tx.Kick();
+    q->tx_kicks++;
+    q->unkicked = 0;
+}
+
+zx_status_t EthernetDevice::QueueTxLocked(QueuePair* q, ethmac_netbuf_t* netbuf) {
     void* data = netbuf->data;
     size_t length = netbuf->len;
     // First, validate the packet
@@ -406,24 +677,22 @@ zx_status_t EthernetDevice::QueueTx(uint32_t options, ethmac_netbuf_t* netbuf) {
         return ZX_ERR_INVALID_ARGS;
     }
 
-    fbl::AutoLock lock(&tx_lock_);
-
     // Flush outstanding descriptors.  Ring::IrqRingUpdate will call this lambda
     // on each sent tx_buffer, allowing us to reclaim them.
-    auto flush = [this](vring_used_elem* used_elem) {
+    auto flush = [q](vring_used_elem* used_elem) {
         uint16_t id = static_cast<uint16_t>(used_elem->id & 0xffff);
-        desc_t* desc = tx_.DescFromIndex(id);
+        desc_t* desc = q->tx.DescFromIndex(id);
         assert((desc->flags & VRING_DESC_F_NEXT) == 0);
         LTRACE_DO(virtio_dump_desc(desc));
-        tx_.FreeDesc(id);
+        q->tx.FreeDesc(id);
     };
 
     // Grab a free descriptor
     uint16_t id;
-    desc_t* desc = tx_.AllocDescChain(1, &id);
+    desc_t* desc = q->tx.AllocDescChain(1, &id);
     if (!desc) {
-        tx_.IrqRingUpdate(flush);
-        desc = tx_.AllocDescChain(1, &id);
+        q->tx.IrqRingUpdate(flush);
+        desc = q->tx.AllocDescChain(1, &id);
     }
     if (!desc) {
         LTRACEF("dropping packet; out of descriptors\n");
@@ -431,7 +700,7 @@ zx_status_t EthernetDevice::QueueTx(uint32_t options, ethmac_netbuf_t* netbuf) {
     }
 
     // Add the data to be sent
-    virtio_net_hdr_t* tx_hdr = GetFrameHdr(bufs_.get(), kTxId, id);
+    virtio_net_hdr_t* tx_hdr = GetFrameHdr(bufs_.get(), TxId(q->index), id, kFrameSize);
     memset(tx_hdr, 0, virtio_hdr_len_);
 
     // 5.1.6.2.1 Driver Requirements: Packet Transmission
@@ -448,26 +717,43 @@ zx_status_t EthernetDevice::QueueTx(uint32_t options, ethmac_netbuf_t* netbuf) {
     // If VIRTIO_NET_F_CSUM is not negotiated, the driver MUST set flags to
     // zero and SHOULD supply a fully checksummed packet to the device.
     tx_hdr->flags = 0;
+    if (tx_csum_ && (netbuf->flags & ETHMAC_NETBUF_NEEDS_CSUM)) {
+        tx_hdr->flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+        tx_hdr->csum_start = netbuf->csum_start;
+        tx_hdr->csum_offset = netbuf->csum_offset;
+    }
 
     // If none of the VIRTIO_NET_F_HOST_TSO4, TSO6 or UFO options have been
     // negotiated, the driver MUST set gso_type to VIRTIO_NET_HDR_GSO_NONE.
     tx_hdr->gso_type = VIRTIO_NET_HDR_GSO_NONE;
 
-    void* tx_buf = GetFrameData(bufs_.get(), kTxId, id, virtio_hdr_len_);
+    void* tx_buf = GetFrameData(bufs_.get(), TxId(q->index), id, kFrameSize, virtio_hdr_len_);
     memcpy(tx_buf, data, length);
     desc->len = static_cast<uint32_t>(virtio_hdr_len_ + length);
 
-    // Submit the descriptor and notify the back-end.
+    // Submit the descriptor; it's published when the back-end is kicked.
     LTRACE_DO(virtio_dump_desc(desc));
-    LTRACEF("Sending %zu bytes:\n", length);
+    LTRACEF("Sending %zu bytes on queue %u:\n", length, q->index);
     LTRACE_DO(hexdump8_ex(tx_buf, length, 0));
-    tx_.SubmitChain(id);
-    ++unkicked_;
-    if ((options & ETHMAC_TX_OPT_MORE) == 0 || unkicked_ > kBacklog / 2) {
-        tx_.Kick();
-        unkicked_ = 0;
-    }
+    q->tx.AddChain(id);
+    ++q->unkicked;
+    ++q->tx_frames;
     return ZX_OK;
 }
 
+zx_status_t EthernetDevice::SetParam(uint32_t param, int32_t value, void* data) {
+    switch (param) {
+    case ETHMAC_SETPARAM_DUMP_REGS:
+        for (uint16_t i = 0; i < num_queues_; ++i) {
+            QueuePair* q = queues_[i].get();
+            fbl::AutoLock lock(&q->tx_lock);
+            zxlogf(INFO, "%s: queue %u: %zu tx frames in %zu kicks\n", tag(), i, q->tx_frames,
+                   q->tx_kicks);
+        }
+        return ZX_OK;
+    default:
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+}
+
 } // namespace virtio
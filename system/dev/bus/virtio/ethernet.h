@@ -38,32 +38,95 @@ public:
     zx_status_t Query(uint32_t options, ethmac_info_t* info) TA_EXCL(state_lock_);
     void Stop() TA_EXCL(state_lock_);
     zx_status_t Start(ethmac_ifc_t* ifc, void* cookie) TA_EXCL(state_lock_);
-    zx_status_t QueueTx(uint32_t options, ethmac_netbuf_t* netbuf) TA_EXCL(state_lock_);
+    zx_status_t QueueTx(uint32_t options, ethmac_netbuf_t* netbuf);
+    void QueueTxBatch(uint32_t options, ethmac_netbuf_t** netbufs, size_t count,
+                      zx_status_t* statuses);
+    zx_status_t SetParam(uint32_t param, int32_t value, void* data);
 
     const char* tag() const override { return "virtio-net"; }
 
 private:
     DISALLOW_COPY_ASSIGN_AND_MOVE(EthernetDevice);
 
+    // The most queue pairs the driver uses, which is as many as the ethernet
+    // core does.
+    static constexpr uint16_t kMaxQueuePairs = 16;
+    // The most bytes of a frame, past its virtio header, the device may
+    // receive or be asked to send.
+    static constexpr size_t kMaxFrameLen = 26 + 1500;
+
+    // Virtqueues; see section 5.1.2 of the spec
+    // Each pair's receive queue is virtqueue 2N and its transmit queue 2N+1.
+    // Automatic steering isn't used; the device picks the receive queue of
+    // each flow, and the ethernet core the transmit queue.
+    struct QueuePair {
+        explicit QueuePair(Device* device, uint16_t index)
+            : index(index), rx(device), tx(device) {}
+
+        const uint16_t index;
+        Ring rx;
+        Ring tx;
+
+        // A frame merged from several receive buffers (VIRTIO_NET_F_MRG_RXBUF),
+        // of which |rx_pending| are still to come. Only touched by the irq
+        // thread.
+        uint16_t rx_pending = 0;
+        size_t rx_len = 0;
+        uint32_t rx_flags = 0;
+        uint8_t rx_frame[kMaxFrameLen];
+
+        mtx_t tx_lock;
+        size_t unkicked TA_GUARDED(tx_lock) = 0;
+        // Tx statistics, reported by ETHMAC_SETPARAM_DUMP_REGS
+        size_t tx_frames TA_GUARDED(tx_lock) = 0;
+        size_t tx_kicks TA_GUARDED(tx_lock) = 0;
+    };
+
     // DDK device hooks; see ddk/device.h
     void ReleaseLocked() TA_REQ(state_lock_);
 
-    // Mutexes to control concurrent access
+    // Asks the device to spread traffic over |num_queues_| queue pairs, over
+    // the control virtqueue.
+    zx_status_t SetQueuePairs();
+
+    // Handles the receive buffer of |used_elem| on |q|, passing each frame up
+    // once its last buffer has been received.
+    void RxBufferLocked(QueuePair* q, vring_used_elem* used_elem) TA_REQ(state_lock_);
+    // Passes a frame received on |q| up the stack.
+    void RecvLocked(QueuePair* q, void* data, size_t len, uint32_t flags) TA_REQ(state_lock_);
+    // Passes each free receive buffer of |q| to the device.
+    void RxRefill(QueuePair* q);
+
+    // Submits a tx descriptor for |netbuf| on |q| without kicking the back-end.
+    zx_status_t QueueTxLocked(QueuePair* q, ethmac_netbuf_t* netbuf) TA_REQ(q->tx_lock);
+    // Publishes the tx descriptors submitted on |q| and kicks the back-end.
+    void KickTxLocked(QueuePair* q) TA_REQ(q->tx_lock);
+
+    // Mutex to control concurrent access
     mtx_t state_lock_;
-    mtx_t tx_lock_;
 
-    // Virtqueues; see section 5.1.2 of the spec
-    // This driver doesn't currently support multi-queueing, automatic
-    // steering, or the control virtqueue, so only a single queue is needed in
-    // each direction.
-    Ring rx_;
-    Ring tx_;
+    fbl::unique_ptr<QueuePair> queues_[kMaxQueuePairs];
+    uint16_t num_queues_;
+    // Used to send commands when more than one queue pair is used
+    // (VIRTIO_NET_F_CTRL_VQ).
+    Ring ctrl_;
+    io_buffer_t ctrl_buf_;
+
+    // Frame buffers; each virtqueue gets the same number of pages.
     fbl::unique_ptr<io_buffer_t[]> bufs_;
-    size_t unkicked_ TA_GUARDED(tx_lock_);
+    size_t num_bufs_;
+    // The size of each receive buffer, which is smaller than a frame when
+    // frames may be merged from several (VIRTIO_NET_F_MRG_RXBUF).
+    size_t rx_buf_size_;
 
     // Saved net device configuration out of the pci config BAR
     virtio_net_config_t config_ TA_GUARDED(state_lock_);
     size_t virtio_hdr_len_;
+    bool mrg_rxbuf_;
+    // Whether the device checksums the packets we send (VIRTIO_NET_F_CSUM), and
+    // validates those it receives (VIRTIO_NET_F_GUEST_CSUM).
+    bool tx_csum_;
+    bool rx_csum_;
 
     // Ethmac callback interface; see ddk/protocol/ethernet.h
     ethmac_ifc_t* ifc_ TA_GUARDED(state_lock_);
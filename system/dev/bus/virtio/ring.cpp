@@ -70,6 +70,9 @@ zx_status_t Ring::Init(uint16_t index, uint16_t count) {
     vring_init(&ring_, count, io_buffer_virt(&ring_buf_), PAGE_SIZE);
     ring_.free_list = 0xffff;
     ring_.free_count = 0;
+    avail_idx_ = 0;
+    kicked_idx_ = 0;
+    event_idx_ = device_->event_idx();
 
     /* add all the descriptors to the free list */
     for (uint16_t i = 0; i < count; i++) {
@@ -128,20 +131,48 @@ struct vring_desc* Ring::AllocDescChain(uint16_t count, uint16_t* start_index) {
 }
 
 void Ring::SubmitChain(uint16_t desc_index) {
+    AddChain(desc_index);
+    PublishChains();
+}
+
+void Ring::AddChain(uint16_t desc_index) {
     LTRACEF("desc %u\n", desc_index);
 
-    /* add the chain to the available list */
+    /* add the chain to the available list, past the index the device sees */
+    ring_.avail->ring[avail_idx_ & ring_.num_mask] = desc_index;
+    avail_idx_++;
+}
+
+void Ring::PublishChains() {
     struct vring_avail* avail = ring_.avail;
+    if (avail->idx == avail_idx_) {
+        return;
+    }
 
-    avail->ring[avail->idx & ring_.num_mask] = desc_index;
-    //mb();
-    avail->idx++;
+    /* the device must see the descriptors and ring entries before the index */
+    hw_wmb();
+    avail->idx = avail_idx_;
 }
 
 void Ring::Kick() {
     LTRACE_ENTRY;
 
-    device_->RingKick(index_);
+    /* the device must see the published index before we read its event index or flags */
+    hw_mb();
+    uint16_t idx = ring_.avail->idx;
+    bool notify;
+    if (event_idx_) {
+        uint16_t event = *reinterpret_cast<volatile uint16_t*>(&vring_avail_event(&ring_));
+        notify = vring_need_event(event, idx, kicked_idx_);
+    } else {
+        notify = !(*reinterpret_cast<volatile uint16_t*>(&ring_.used->flags) &
+                   VRING_USED_F_NO_NOTIFY);
+    }
+    kicked_idx_ = idx;
+
+    if (notify) {
+        device_->RingKick(index_);
+    }
 }
 
 } // namespace virtio
@@ -4,6 +4,7 @@
 #pragma once
 
 #include <ddk/io-buffer.h>
+#include <hw/arch_ops.h>
 #include <virtio/virtio_ring.h>
 #include <zircon/types.h>
 
@@ -23,44 +24,81 @@ public:
     void FreeDesc(uint16_t desc_index);
     struct vring_desc* AllocDescChain(uint16_t count, uint16_t* start_index);
     void SubmitChain(uint16_t desc_index);
+    // Notifies the device of the chains published since the last call, unless
+    // it has asked not to be (VIRTIO_F_RING_EVENT_IDX or NO_NOTIFY).
     void Kick();
 
+    // Batched submission: AddChain() places a chain in the available ring
+    // without the device seeing it, and PublishChains() then hands every chain
+    // added since the last call to the device with a single index update.
+    // SubmitChain() is AddChain() followed by PublishChains().
+    void AddChain(uint16_t desc_index);
+    void PublishChains();
+
     struct vring_desc* DescFromIndex(uint16_t index) {
         return &ring_.desc[index];
     }
 
+    // Passes each chain the device has returned to |free_chain|, and returns
+    // how many there were. Chains the device returns while they are being
+    // processed are handled in the same call. With VIRTIO_F_RING_EVENT_IDX,
+    // the device is then asked to interrupt again only once it returns
+    // another.
     template <typename T>
-    void IrqRingUpdate(T free_chain);
+    size_t IrqRingUpdate(T free_chain);
 
 private:
+    uint16_t UsedIdx() const {
+        return *reinterpret_cast<volatile const uint16_t*>(&ring_.used->idx);
+    }
+
     Device* device_ = nullptr;
 
     io_buffer_t ring_buf_;
 
     uint16_t index_ = 0;
+    // The available ring index after the chains added but not yet published.
+    uint16_t avail_idx_ = 0;
+    // The available ring index as of the last Kick().
+    uint16_t kicked_idx_ = 0;
+    bool event_idx_ = false;
 
     vring ring_ = {};
 };
 
 // perform the main loop of finding free descriptor chains and passing it to a passed in function
 template <typename T>
-inline void Ring::IrqRingUpdate(T free_chain) {
+inline size_t Ring::IrqRingUpdate(T free_chain) {
     // TRACEF("used flags %#x idx %#x last_used %u\n",
     //         ring_.used->flags, ring_.used->idx, ring_.last_used);
 
-    // find a new free chain of descriptors
-    uint16_t cur_idx = ring_.used->idx;
+    // find new free chains of descriptors, until the device has stopped
+    // returning them
+    size_t count = 0;
     uint16_t i = ring_.last_used;
-    for (; i != cur_idx; ++i) {
-        // TRACEF("looking at idx %u\n", i);
-
-        struct vring_used_elem* used_elem = &ring_.used->ring[i & ring_.num_mask];
-        // TRACEF("used chain id %u, len %u\n", used_elem->id, used_elem->len);
-
-        // free the chain
-        free_chain(used_elem);
+    for (uint16_t cur_idx = UsedIdx(); i != cur_idx; cur_idx = UsedIdx()) {
+        // read the used elements only after the index which covers them
+        hw_rmb();
+        for (; i != cur_idx; ++i) {
+            // TRACEF("looking at idx %u\n", i);
+
+            struct vring_used_elem* used_elem = &ring_.used->ring[i & ring_.num_mask];
+            // TRACEF("used chain id %u, len %u\n", used_elem->id, used_elem->len);
+
+            // free the chain
+            free_chain(used_elem);
+            count++;
+        }
+        ring_.last_used = i;
+
+        // ask for an interrupt when the next chain is returned, then check for
+        // any the device returned before it could see that
+        if (event_idx_) {
+            vring_used_event(&ring_) = i;
+            hw_mb();
+        }
     }
-    ring_.last_used = i;
+    return count;
 }
 
 void virtio_dump_desc(const struct vring_desc* desc);
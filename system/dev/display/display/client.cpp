@@ -735,17 +735,15 @@ void Client::HandleApplyConfig(const fuchsia_display_ControllerApplyConfigReques
             }
 
             if (layer->pending_image_) {
-                auto wait_fence = GetFence(layer->pending_wait_event_id_);
-                if (wait_fence && wait_fence->InContainer()) {
-                    zxlogf(ERROR, "Tried to wait with a busy event\n");
-                    TearDown();
-                    return;
-                }
+                // An event which is already being waited on queues this image behind the
+                // earlier ones, so the client can have several frames in flight.
+                auto wait_fence = GetWaitFence(layer->pending_wait_event_id_);
                 layer_node.layer->pending_image_->PrepareFences(
                         fbl::move(wait_fence),
                         GetFence(layer->pending_signal_event_id_));
                 {
                     fbl::AutoLock lock(controller_->mtx());
+                    layer->pending_image_->set_queue_time(zx_clock_get_monotonic());
                     list_add_tail(&layer->waiting_images_, &layer->pending_image_->node.link);
                     layer->pending_image_->node.self = fbl::move(layer->pending_image_);
                 }
@@ -1349,6 +1347,15 @@ fbl::RefPtr<FenceReference> Client::GetFence(uint64_t id) {
     return fence.IsValid() ? fence->GetReference() : nullptr;
 }
 
+fbl::RefPtr<FenceReference> Client::GetWaitFence(uint64_t id) {
+    if (id == INVALID_ID) {
+        return nullptr;
+    }
+    fbl::AutoLock lock(&fence_mtx_);
+    auto fence = fences_.find(id);
+    return fence.IsValid() ? fence->GetWaitReference() : nullptr;
+}
+
 void Client::OnFenceFired(FenceReference* fence) {
     for (auto& layer: layers_) {
         image_node_t* waiting;
@@ -237,6 +237,8 @@ private:
     bool CheckConfig(fidl::Builder* resp_builder);
 
     fbl::RefPtr<FenceReference> GetFence(uint64_t id);
+    // Gets a fence reference to wait on, which may be queued behind other waits on the event.
+    fbl::RefPtr<FenceReference> GetWaitFence(uint64_t id);
 };
 
 // ClientProxy manages interactions between its Client instance and the ddk and the
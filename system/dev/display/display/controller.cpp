@@ -526,6 +526,13 @@ void Controller::OnDisplayVsync(uint64_t display_id, zx_time_t timestamp,
             for (unsigned i = 0; i < handle_count; i++) {
                 if (handles[i] == cur->self->info().handle) {
                     images[i] = cur->self->id;
+
+                    zx_time_t queue_time = cur->self->TakeQueueTime();
+                    if (queue_time != 0) {
+                        TRACE_INSTANT("gfx", "Image Presented", TRACE_SCOPE_THREAD,
+                                      "image_id", cur->self->id,
+                                      "latency_us", (timestamp - queue_time) / ZX_USEC(1));
+                    }
                     break;
                 }
             }
@@ -25,6 +25,20 @@ fbl::RefPtr<FenceReference> Fence::GetReference() {
     return cur_ref_;
 }
 
+fbl::RefPtr<FenceReference> Fence::GetWaitReference() {
+    if (cur_ref_ == nullptr || !cur_ref_->InContainer()) {
+        return cur_ref_;
+    }
+
+    fbl::AllocChecker ac;
+    auto ref = fbl::AdoptRef(new (&ac) FenceReference(fbl::RefPtr<Fence>(this)));
+    if (!ac.check()) {
+        return nullptr;
+    }
+    ref_count_++;
+    return ref;
+}
+
 void Fence::Signal() {
     event_.signal(0, ZX_EVENT_SIGNALED);
 }
@@ -43,6 +43,11 @@ public:
     // Gets the fence reference for the current import. An individual fence reference cannot
     // be used for multiple things simultaniously.
     fbl::RefPtr<FenceReference> GetReference();
+    // Gets a fence reference to wait on for the current import. If the current import's
+    // reference is already being waited on, a new reference is created and armed behind it,
+    // so that several frames can be queued on one event. Each signal of the event then
+    // readies one waiter, in the order they started waiting.
+    fbl::RefPtr<FenceReference> GetWaitReference();
 private:
     void Signal();
     void OnRefDied();
@@ -74,6 +74,17 @@ public:
     void set_z_index(uint32_t z_index) { z_index_ = z_index; }
     uint32_t z_index() const { return z_index_; }
 
+    // Records when the client queued the image to be displayed. Set and read under the
+    // controller mutex.
+    void set_queue_time(zx_time_t queue_time) { queue_time_ = queue_time; }
+    // Returns the time the image was queued at the first time it's called after the image is
+    // queued, and 0 afterwards. Used to trace the latency of the vsync which first displays it.
+    zx_time_t TakeQueueTime() {
+        zx_time_t queue_time = queue_time_;
+        queue_time_ = 0;
+        return queue_time;
+    }
+
     // The node alternates between a client's waiting image list and the controller's
     // presented image list. The presented image list is protected with the controller mutex,
     // and the waiting list is only accessed on the loop and thus is not generally
@@ -89,6 +100,7 @@ private:
 
     // z_index is set/read by controller.cpp under its lock
     uint32_t z_index_;
+    zx_time_t queue_time_ = 0;
 
     // Only ever accessed on loop thread, so no synchronization
     fbl::RefPtr<FenceReference> wait_fence_ = nullptr;
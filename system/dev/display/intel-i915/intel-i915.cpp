@@ -49,8 +49,8 @@
 #define FLAGS_BACKLIGHT 1
 
 namespace {
-static const zx_pixel_format_t supported_formats[2] = {
-    ZX_PIXEL_FORMAT_ARGB_8888, ZX_PIXEL_FORMAT_RGB_x888
+static const zx_pixel_format_t supported_formats[3] = {
+    ZX_PIXEL_FORMAT_ARGB_8888, ZX_PIXEL_FORMAT_RGB_x888, ZX_PIXEL_FORMAT_NV12
 };
 
 static const cursor_info_t cursor_infos[3] = {
@@ -810,9 +810,18 @@ zx_status_t Controller::ImportVmoImage(image_t* image, const zx::vmo& vmo, size_
         return ZX_ERR_NO_MEMORY;
     }
 
-    uint32_t length = width_in_tiles(image->type, image->width, image->pixel_format) *
-            height_in_tiles(image->type, image->height, image->pixel_format) *
-            get_tile_byte_size(image->type);
+    uint32_t length;
+    if (image->pixel_format == ZX_PIXEL_FORMAT_NV12) {
+        if (image->width % 2 != 0 || image->height % 2 != 0) {
+            return ZX_ERR_INVALID_ARGS;
+        }
+        length = get_uv_plane_offset(image->type, image->width, image->height) +
+                get_uv_plane_size(image->type, image->width, image->height);
+    } else {
+        length = width_in_tiles(image->type, image->width, image->pixel_format) *
+                height_in_tiles(image->type, image->height, image->pixel_format) *
+                get_tile_byte_size(image->type);
+    }
 
     uint32_t align;
     if (image->type == IMAGE_TYPE_SIMPLE) {
@@ -937,7 +946,10 @@ bool Controller::CalculateMinimumAllocations(const display_config_t** display_co
             ZX_ASSERT(layer->type == LAYER_PRIMARY);
             const primary_layer_t* primary = &layer->cfg.primary;
 
-            if (primary->image.type == IMAGE_TYPE_SIMPLE
+            if (primary->image.pixel_format == ZX_PIXEL_FORMAT_NV12) {
+                // The Y and UV planes each need their own minimum allocation.
+                min_allocs[pipe_num][plane_num] = 16;
+            } else if (primary->image.type == IMAGE_TYPE_SIMPLE
                     || primary->image.type == IMAGE_TYPE_X_TILED) {
                 min_allocs[pipe_num][plane_num] = 8;
             } else {
@@ -975,7 +987,9 @@ bool Controller::CalculateMinimumAllocations(const display_config_t** display_co
 void Controller::UpdateAllocations(const uint16_t min_allocs[registers::kPipeCount]
                                                             [registers::kImagePlaneCount],
                                    const uint64_t data_rate[registers::kPipeCount]
-                                                           [registers::kImagePlaneCount]) {
+                                                           [registers::kImagePlaneCount],
+                                   const bool planar[registers::kPipeCount]
+                                                    [registers::kImagePlaneCount]) {
     uint16_t allocs[registers::kPipeCount][registers::kImagePlaneCount];
 
     for (unsigned pipe_num = 0; pipe_num < registers::kPipeCount; pipe_num++) {
@@ -1042,10 +1056,30 @@ void Controller::UpdateAllocations(const uint16_t min_allocs[registers::kPipeCou
 
             // These are latched on the surface address register, so we don't yet need to
             // worry about overlaps when updating planes during a pipe allocation.
-            auto buf_cfg = pipe_regs.PlaneBufCfg(plane_num + 1).FromValue(0);
-            buf_cfg.set_buffer_start(cur->start);
-            buf_cfg.set_buffer_end(cur->end - 1);
-            buf_cfg.WriteTo(mmio_space());
+            if (plane_num < registers::kPlanarImagePlaneCount) {
+                // The Y plane of an NV12 image has twice the bytes of its UV plane, so it gets
+                // the first two thirds of the allocation.
+                uint16_t y_end = cur->start;
+                if (planar[pipe_num][plane_num]) {
+                    y_end = static_cast<uint16_t>(cur->start + (cur->end - cur->start) * 2 / 3);
+                }
+                auto nv12_buf_cfg = pipe_regs.PlaneNv12BufCfg(plane_num + 1).FromValue(0);
+                if (y_end != cur->start) {
+                    nv12_buf_cfg.set_buffer_start(cur->start);
+                    nv12_buf_cfg.set_buffer_end(y_end - 1);
+                }
+                nv12_buf_cfg.WriteTo(mmio_space());
+
+                auto buf_cfg = pipe_regs.PlaneBufCfg(plane_num + 1).FromValue(0);
+                buf_cfg.set_buffer_start(y_end);
+                buf_cfg.set_buffer_end(cur->end - 1);
+                buf_cfg.WriteTo(mmio_space());
+            } else {
+                auto buf_cfg = pipe_regs.PlaneBufCfg(plane_num + 1).FromValue(0);
+                buf_cfg.set_buffer_start(cur->start);
+                buf_cfg.set_buffer_end(cur->end - 1);
+                buf_cfg.WriteTo(mmio_space());
+            }
 
             // TODO(stevensd): Real watermark programming
             auto wm0 = pipe_regs.PlaneWatermark(plane_num + 1, 0).FromValue(0);
@@ -1085,6 +1119,7 @@ void Controller::ReallocatePlaneBuffers(const display_config_t** display_configs
 
     // Calculate the data rates and store the minimum allocations
     uint64_t data_rate[registers::kPipeCount][registers::kImagePlaneCount];
+    bool planar[registers::kPipeCount][registers::kImagePlaneCount] = {};
     for (unsigned pipe_num = 0; pipe_num < registers::kPipeCount; pipe_num++) {
         registers::Pipe pipe = registers::kPipes[pipe_num];
         for (unsigned plane_num = 0; plane_num < registers::kImagePlaneCount; plane_num++) {
@@ -1100,6 +1135,11 @@ void Controller::ReallocatePlaneBuffers(const display_config_t** display_configs
                         / primary->dest_frame.height;
                 data_rate[pipe_num][plane_num] = scaled_width * scaled_height *
                         ZX_PIXEL_FORMAT_BYTES(primary->image.pixel_format);
+                if (primary->image.pixel_format == ZX_PIXEL_FORMAT_NV12) {
+                    // Add the UV plane, which is subsampled by 2 in each direction
+                    data_rate[pipe_num][plane_num] += data_rate[pipe_num][plane_num] / 2;
+                    planar[pipe_num][plane_num] = true;
+                }
             } else if (layer->type == LAYER_CURSOR) {
                 // Use a tiny data rate so the cursor gets the minimum number of buffers
                 data_rate[pipe_num][plane_num] = 1;
@@ -1139,7 +1179,7 @@ void Controller::ReallocatePlaneBuffers(const display_config_t** display_configs
     }
 
     // It's not necessary to flush the buffer changes since the pipe allocs didn't change
-    UpdateAllocations(min_allocs, data_rate);
+    UpdateAllocations(min_allocs, data_rate, planar);
 
     if (reallocate_pipes) {
         DoPipeBufferReallocation(active_allocation);
@@ -1365,11 +1405,28 @@ void Controller::CheckConfiguration(const display_config_t** display_config,
             switch (config->layers[j]->type) {
             case LAYER_PRIMARY: {
                 primary_layer_t* primary = &config->layers[j]->cfg.primary;
+                bool planar = primary->image.pixel_format == ZX_PIXEL_FORMAT_NV12;
+                if (planar) {
+                    // Only the first planes can scan out NV12, and the source frame has
+                    // to line up with the subsampled UV plane. There's no way to ask the
+                    // client for a different pixel format, so NV12 layers which can't be
+                    // scanned out get merged.
+                    bool has_color_layer = config->layers[0]->type == LAYER_COLOR;
+                    if (config->layers[j]->z_index - has_color_layer
+                            >= registers::kPlanarImagePlaneCount) {
+                        merge_all = true;
+                    }
+                    if (primary->src_frame.x_pos % 2 || primary->src_frame.y_pos % 2
+                            || primary->src_frame.width % 2 || primary->src_frame.height % 2) {
+                        layer_cfg_result[i][j] |= CLIENT_SRC_FRAME;
+                    }
+                }
                 if (primary->transform_mode == FRAME_TRANSFORM_ROT_90
                         || primary->transform_mode == FRAME_TRANSFORM_ROT_270) {
-                    // Linear and x tiled images don't support 90/270 rotation
+                    // Linear and x tiled images don't support 90/270 rotation, and the
+                    // rotated view of NV12 images doesn't cover their UV plane.
                     if (primary->image.type == IMAGE_TYPE_SIMPLE
-                            || primary->image.type == IMAGE_TYPE_X_TILED) {
+                            || primary->image.type == IMAGE_TYPE_X_TILED || planar) {
                         layer_cfg_result[i][j] |= CLIENT_TRANSFORM;
                     }
                 } else if (primary->transform_mode != FRAME_TRANSFORM_IDENTITY
@@ -1394,8 +1451,9 @@ void Controller::CheckConfiguration(const display_config_t** display_config,
                     merge_all = true;
                 }
 
+                // NV12 planes always need a scaler, to upsample the UV plane.
                 if (primary->dest_frame.width != src_width
-                        || primary->dest_frame.height != src_height) {
+                        || primary->dest_frame.height != src_height || planar) {
                     float ratio = registers::PipeScalerCtrl::k7x5MaxRatio;
                     uint32_t max_width =
                             static_cast<uint32_t>(static_cast<float>(src_width) * ratio);
@@ -1425,7 +1483,11 @@ void Controller::CheckConfiguration(const display_config_t** display_config,
                             || src_height < registers::PipeScalerCtrl::kMinSrcSizePx
                             || max_width < primary->dest_frame.width
                             || max_height < primary->dest_frame.height) {
-                        layer_cfg_result[i][j] |= CLIENT_FRAME_SCALE;
+                        if (planar) {
+                            merge_all = true;
+                        } else {
+                            layer_cfg_result[i][j] |= CLIENT_FRAME_SCALE;
+                        }
                     } else {
                         total_scalers_needed += scalers_needed;
                     }
@@ -156,11 +156,14 @@ private:
                                      uint16_t min_allocs[registers::kPipeCount]
                                                         [registers::kImagePlaneCount])
                                      __TA_REQUIRES(display_lock_);
-    // Updates plane_buffers_ based pipe_buffers_ and the given parameters
+    // Updates plane_buffers_ based pipe_buffers_ and the given parameters. |planar| gives the
+    // planes scanning out NV12 images, whose allocations are split between the Y and UV planes.
     void UpdateAllocations(const uint16_t min_allocs[registers::kPipeCount]
                                                     [registers::kImagePlaneCount],
                            const uint64_t display_rate[registers::kPipeCount]
-                                                      [registers::kImagePlaneCount])
+                                                      [registers::kImagePlaneCount],
+                           const bool planar[registers::kPipeCount]
+                                            [registers::kImagePlaneCount])
                            __TA_REQUIRES(display_lock_);
     // Reallocates the pipe buffers when a pipe comes online/goes offline. This is a
     // long-running operation, as shifting allocations between pipes requires waiting
@@ -281,6 +281,7 @@ void Pipe::ConfigurePrimaryPlane(uint32_t plane_num, const primary_layer_t* prim
     }
 
     const image_t* image = &primary->image;
+    bool planar = image->pixel_format == ZX_PIXEL_FORMAT_NV12;
 
     const fbl::unique_ptr<GttRegion>& region = controller_->GetGttRegion(image->handle);
     region->SetRotation(primary->transform_mode, *image);
@@ -309,8 +310,9 @@ void Pipe::ConfigurePrimaryPlane(uint32_t plane_num, const primary_layer_t* prim
         y_offset = primary->src_frame.x_pos;
     }
 
+    // NV12 planes need a scaler even when they aren't scaled, to upsample the UV plane.
     if (plane_width == primary->dest_frame.width
-            && plane_height == primary->dest_frame.height) {
+            && plane_height == primary->dest_frame.height && !planar) {
         auto plane_pos = pipe_regs.PlanePosition(plane_num).FromValue(0);
         plane_pos.set_x_pos(primary->dest_frame.x_pos);
         plane_pos.set_y_pos(primary->dest_frame.y_pos);
@@ -329,8 +331,8 @@ void Pipe::ConfigurePrimaryPlane(uint32_t plane_num, const primary_layer_t* prim
         pipe_regs.PlanePosition(plane_num).FromValue(0).WriteTo(mmio_space());
 
         auto ps_ctrl = pipe_regs.PipeScalerCtrl(*scaler_1_claimed).ReadFrom(mmio_space());
-        ps_ctrl.set_mode(ps_ctrl.kDynamic);
-        if (primary->src_frame.width > 2048) {
+        ps_ctrl.set_mode(planar ? ps_ctrl.kNv12 : ps_ctrl.kDynamic);
+        if (primary->src_frame.width > 2048 && !planar) {
             float max_dynamic_height = static_cast<float>(plane_height)
                     * registers::PipeScalerCtrl::kDynamicMaxVerticalRatio2049;
             if (static_cast<uint32_t>(max_dynamic_height) < primary->dest_frame.height) {
@@ -370,6 +372,18 @@ void Pipe::ConfigurePrimaryPlane(uint32_t plane_num, const primary_layer_t* prim
     stride_reg.set_stride(stride);
     stride_reg.WriteTo(controller_->mmio_space());
 
+    auto aux_dist = pipe_regs.PlaneAuxDist(plane_num).FromValue(0);
+    auto aux_offset = pipe_regs.PlaneAuxOffset(plane_num).FromValue(0);
+    if (planar) {
+        aux_dist.set_aux_distance(get_uv_plane_offset(image->type, image->width, image->height)
+                                  >> registers::PlaneSurface::kPageShift);
+        aux_dist.set_aux_stride(stride);
+        aux_offset.set_start_x(x_offset / 2);
+        aux_offset.set_start_y(y_offset / 2);
+    }
+    aux_dist.WriteTo(mmio_space());
+    aux_offset.WriteTo(mmio_space());
+
     auto plane_key_mask = pipe_regs.PlaneKeyMask(plane_num).FromValue(0);
     if (primary->alpha_mode != ALPHA_DISABLE && !isnan(primary->alpha_layer_val)) {
         plane_key_mask.set_plane_alpha_enable(1);
@@ -382,7 +396,7 @@ void Pipe::ConfigurePrimaryPlane(uint32_t plane_num, const primary_layer_t* prim
     }
     plane_key_mask.WriteTo(mmio_space());
     if (primary->alpha_mode == ALPHA_DISABLE
-            || primary->image.pixel_format == ZX_PIXEL_FORMAT_RGB_x888) {
+            || primary->image.pixel_format == ZX_PIXEL_FORMAT_RGB_x888 || planar) {
         plane_ctrl.set_alpha_mode(plane_ctrl.kAlphaDisable);
     } else if (primary->alpha_mode == ALPHA_PREMULTIPLIED) {
         plane_ctrl.set_alpha_mode(plane_ctrl.kAlphaPreMultiply);
@@ -393,7 +407,14 @@ void Pipe::ConfigurePrimaryPlane(uint32_t plane_num, const primary_layer_t* prim
 
     plane_ctrl.set_plane_enable(1);
     plane_ctrl.set_pipe_csc_enable(enable_csc);
-    plane_ctrl.set_source_pixel_format(plane_ctrl.kFormatRgb8888);
+    if (planar) {
+        plane_ctrl.set_source_pixel_format(plane_ctrl.kFormatNv12);
+        // Assume HD video is BT.709 and SD video is BT.601.
+        plane_ctrl.set_plane_yuv_to_rgb_csc_format(
+                image->height >= 720 ? plane_ctrl.kCscBt709 : plane_ctrl.kCscBt601);
+    } else {
+        plane_ctrl.set_source_pixel_format(plane_ctrl.kFormatRgb8888);
+    }
     if (primary->image.type == IMAGE_TYPE_SIMPLE) {
         plane_ctrl.set_tiled_surface(plane_ctrl.kLinear);
     } else if (primary->image.type == IMAGE_TYPE_X_TILED) {
@@ -23,6 +23,8 @@ static const Pipe kPipes[kPipeCount] = {
 
 static constexpr uint32_t kImagePlaneCount = 3;
 static constexpr uint32_t kCursorPlane = 2;
+// Only the first planes can scan out planar (NV12) images.
+static constexpr uint32_t kPlanarImagePlaneCount = 2;
 
 // PIPE_SRCSZ
 class PipeSourceSize : public hwreg::RegisterBase<PipeSourceSize, uint32_t> {
@@ -102,6 +104,7 @@ public:
     DEF_BIT(28, yuv_range_correction_disable);
 
     DEF_FIELD(27, 24, source_pixel_format);
+    static constexpr uint32_t kFormatNv12 = 1;
     static constexpr uint32_t kFormatRgb8888 = 4;
 
     DEF_BIT(23, pipe_csc_enable);
@@ -109,6 +112,8 @@ public:
     DEF_BIT(20, rgb_color_order);
     DEF_BIT(19, plane_yuv_to_rgb_csc_dis);
     DEF_BIT(18, plane_yuv_to_rgb_csc_format);
+    static constexpr uint32_t kCscBt601 = 0;
+    static constexpr uint32_t kCscBt709 = 1;
     DEF_FIELD(17, 16, yuv_422_byte_order);
     DEF_BIT(15, render_decompression);
     DEF_BIT(14, trickle_feed_enable);
@@ -140,12 +145,33 @@ public:
 class PlaneBufCfg : public hwreg::RegisterBase<PlaneBufCfg, uint32_t> {
 public:
     static constexpr uint32_t kBaseAddr = 0x7017c;
+    static constexpr uint32_t kNv12BaseAddr = 0x70178;
     static constexpr uint32_t kBufferCount = 892;
 
     DEF_FIELD(25, 16, buffer_end);
     DEF_FIELD(9, 0, buffer_start);
 };
 
+// PLANE_AUX_DIST
+class PlaneAuxDist : public hwreg::RegisterBase<PlaneAuxDist, uint32_t> {
+public:
+    static constexpr uint32_t kBaseAddr = 0x701c0;
+
+    // The distance from the surface to the UV plane of an NV12 image, in 4k pages
+    DEF_FIELD(31, 12, aux_distance);
+    // The stride of the UV plane, in the same units as PLANE_STRIDE
+    DEF_FIELD(9, 0, aux_stride);
+};
+
+// PLANE_AUX_OFFSET
+class PlaneAuxOffset : public hwreg::RegisterBase<PlaneAuxOffset, uint32_t> {
+public:
+    static constexpr uint32_t kBaseAddr = 0x701c4;
+
+    DEF_FIELD(28, 16, start_y);
+    DEF_FIELD(12, 0, start_x);
+};
+
 // PLANE_WM
 class PlaneWm : public hwreg::RegisterBase<PlaneWm, uint32_t> {
 public:
@@ -199,6 +225,7 @@ public:
     DEF_FIELD(29, 28, mode);
     static constexpr uint32_t kDynamic = 0;
     static constexpr uint32_t k7x5 = 1;
+    static constexpr uint32_t kNv12 = 2;
 
     DEF_FIELD(27, 25, binding);
     static constexpr uint32_t kPipeScaler = 0;
@@ -367,12 +394,25 @@ public:
     hwreg::RegisterAddr<registers::PlanePosition> PlanePosition(int32_t plane_num) {
         return GetPlaneReg<registers::PlanePosition>(plane_num);
     }
+    hwreg::RegisterAddr<registers::PlaneAuxDist> PlaneAuxDist(int32_t plane_num) {
+        return GetPlaneReg<registers::PlaneAuxDist>(plane_num);
+    }
+    hwreg::RegisterAddr<registers::PlaneAuxOffset> PlaneAuxOffset(int32_t plane_num) {
+        return GetPlaneReg<registers::PlaneAuxOffset>(plane_num);
+    }
     // 0 == cursor, 1-3 are regular planes
     hwreg::RegisterAddr<registers::PlaneBufCfg> PlaneBufCfg(int plane) {
         return hwreg::RegisterAddr<registers::PlaneBufCfg>(
                 PlaneBufCfg::kBaseAddr + 0x1000 * pipe_ + 0x100 * plane);
     }
 
+    // The buffers of the Y plane of an NV12 image, with PlaneBufCfg holding the buffers of
+    // its UV plane. 1-2 are the planes which support NV12.
+    hwreg::RegisterAddr<registers::PlaneBufCfg> PlaneNv12BufCfg(int plane) {
+        return hwreg::RegisterAddr<registers::PlaneBufCfg>(
+                PlaneBufCfg::kNv12BaseAddr + 0x1000 * pipe_ + 0x100 * plane);
+    }
+
     hwreg::RegisterAddr<registers::PlaneWm>PlaneWatermark(int plane, int wm_num) {
         return hwreg::RegisterAddr<PlaneWm>(
                 PlaneWm::kBaseAddr + 0x1000 * pipe_ + 0x100 * plane + 4 * wm_num);
@@ -45,4 +45,17 @@ static inline uint32_t height_in_tiles(uint32_t tiling, uint32_t height,
     return (height + tile_height - 1) / tile_height;
 }
 
+// The Y plane of an NV12 image is followed by its interleaved UV plane, which starts on the
+// first page after the Y plane and has the same stride.
+static inline uint32_t get_uv_plane_offset(uint32_t tiling, uint32_t width, uint32_t height) {
+    uint32_t y_size = width_in_tiles(tiling, width, ZX_PIXEL_FORMAT_NV12) *
+            height_in_tiles(tiling, height, ZX_PIXEL_FORMAT_NV12) * get_tile_byte_size(tiling);
+    return fbl::round_up(y_size, static_cast<uint32_t>(PAGE_SIZE));
+}
+
+static inline uint32_t get_uv_plane_size(uint32_t tiling, uint32_t width, uint32_t height) {
+    return width_in_tiles(tiling, width, ZX_PIXEL_FORMAT_NV12) *
+            height_in_tiles(tiling, height / 2, ZX_PIXEL_FORMAT_NV12) * get_tile_byte_size(tiling);
+}
+
 } // namespace i915
@@ -17,6 +17,7 @@
 #include <zircon/thread_annotations.h>
 #include <zircon/types.h>
 
+#include <inttypes.h>
 #include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -31,6 +32,10 @@
 // This is used for signaling that eth_tx_thread() should exit.
 static const zx_signals_t kSignalFifoTerminate = ZX_USER_SIGNAL_0;
 
+// This is used for signaling that eth_tx_thread() should post rx buffers, or
+// stop doing so; see eth_update_rx_direct_locked().
+static const zx_signals_t kSignalRxDirect = ZX_USER_SIGNAL_1;
+
 // ensure that we will not exceed fifo capacity
 static_assert((FIFO_DEPTH * FIFO_ESIZE) <= 4096, "");
 
@@ -51,18 +56,32 @@ typedef struct ethdev0 {
     int32_t multicast_promisc_requesters;
 
     ethmac_info_t info;
+    // queue pairs of the ethmac, up to zircon_ethernet_MAX_QUEUES
+    uint32_t num_queues;
     uint32_t status;
     zx_device_t* zxdev;
+
+    // the instance the ethmac receives directly into, if any
+    struct ethdev* rx_direct;
 } ethdev0_t;
 
 typedef struct tx_info {
     struct ethdev* edev;
+    struct eth_queue* queue;
+    // the fifo entry, which spans any TxOffload ahead of the netbuf's data
+    uint32_t fifo_offset;
+    uint16_t fifo_length;
     uint64_t fifo_cookie;
     ethmac_netbuf_t netbuf;
 } tx_info_t;
 
-// transmit thread has been created
-#define ETHDEV_TX_THREAD (1u)
+// An rx fifo entry posted to the ethmac, while it receives directly into the
+// io buffer of the instance.
+typedef struct rx_info {
+    struct ethdev* edev;
+    zircon_ethernet_FifoEntry entry;
+    ethmac_netbuf_t netbuf;
+} rx_info_t;
 
 // connected to the ethmac and handling traffic
 #define ETHDEV_RUNNING (2u)
@@ -82,6 +101,9 @@ typedef struct tx_info {
 // This client has requested multicast promisc mode
 #define ETHDEV_MULTICAST_PROMISC (0x40u)
 
+// The ethmac receives directly into this client's io buffer
+#define ETHDEV_RX_DIRECT (0x80u)
+
 // indicates the device is busy although its lock is released
 #define ETHDEV0_BUSY (1u)
 
@@ -94,14 +116,11 @@ typedef struct tx_info {
 //   zircon/system/utest/ethernet/ethernet.cpp
 #define MULTICAST_LIST_LIMIT (32)
 
-// ethernet instance device
-typedef struct ethdev {
-    list_node_t node;
-
-    ethdev0_t* edev0;
-
-    uint32_t state;
-    char name[zircon_ethernet_MAX_CLIENT_NAME_LEN+1];
+// A transmit and receive queue pair of an instance, which uses the ethmac's
+// queue of the same index. Queue 0 is the one GetFifos() opens.
+typedef struct eth_queue {
+    struct ethdev* edev;
+    uint32_t index;
 
     // fifos are named from the perspective
     // of the packet from from the client
@@ -113,6 +132,30 @@ typedef struct ethdev {
     zircon_ethernet_FifoEntry rx_entries[FIFO_BATCH_SZ];
     size_t rx_entry_count;
 
+    // fifo thread, if tx_thread_created
+    thrd_t tx_thr;
+    bool tx_thread_created;
+
+    uint32_t fail_rx_read;
+    uint32_t fail_rx_write;
+
+    // queue_tx_batch() calls made by the tx thread, and the frames they sent
+    uint64_t tx_batches;
+    uint64_t tx_batch_frames;
+    uint32_t tx_batch_max;
+} eth_queue_t;
+
+// ethernet instance device
+typedef struct ethdev {
+    list_node_t node;
+
+    ethdev0_t* edev0;
+
+    uint32_t state;
+    char name[zircon_ethernet_MAX_CLIENT_NAME_LEN+1];
+
+    eth_queue_t queues[zircon_ethernet_MAX_QUEUES];
+
     // io buffer
     zx_handle_t io_vmo;
     void* io_buf;
@@ -121,20 +164,19 @@ typedef struct ethdev {
     zx_handle_t pmt;
 
     tx_info_t all_tx_bufs[FIFO_DEPTH];
-    mtx_t lock;               // Protects free_tx_bufs
+    mtx_t lock;               // Protects free_tx_bufs, free_rx_bufs and rx_blocked
     list_node_t free_tx_bufs; // tx_info_t elements
 
-    // fifo thread
-    thrd_t tx_thr;
+    rx_info_t all_rx_bufs[FIFO_DEPTH];
+    list_node_t free_rx_bufs;    // rx_info_t elements
+    list_node_t pending_rx_bufs; // read from the rx fifo, not yet queued; under edev0->lock
+    // set when rx buffers can't be posted until one is returned to free_rx_bufs
+    bool rx_blocked;
 
     zx_device_t* zxdev;
 
     uint8_t multicast[MULTICAST_LIST_LIMIT][ETH_MAC_SIZE];
     uint32_t n_multicast;
-
-    uint32_t fail_rx_read;
-    uint32_t fail_rx_write;
-    uint32_t fail_tx_write;
 } ethdev_t;
 
 #define FAIL_REPORT_RATE 50
@@ -255,18 +297,42 @@ static ssize_t eth_test_clear_multicast_promisc_locked(ethdev_t* edev) {
     return status;
 }
 
-static void eth_handle_rx(ethdev_t* edev, const void* data, size_t len, uint32_t extra) {
+// Returns |e| to the client through the rx fifo of |q|.
+static void eth_rx_fifo_write(eth_queue_t* q, zircon_ethernet_FifoEntry* e) {
+    zx_status_t status;
+    if ((status = zx_fifo_write(q->rx_fifo, sizeof(*e), e, 1, NULL)) < 0) {
+        if (status == ZX_ERR_SHOULD_WAIT) {
+            if ((q->fail_rx_write++ % FAIL_REPORT_RATE) == 0) {
+                zxlogf(ERROR, "eth [%s]: no rx_fifo space available on queue %u (%u times)\n",
+                       q->edev->name, q->index, q->fail_rx_write);
+            }
+        } else {
+            // Fatal, should force teardown
+            zxlogf(ERROR, "eth [%s]: rx_fifo write failed %d\n", q->edev->name, status);
+        }
+    }
+}
+
+// Delivers a frame the ethmac received on |queue| to the rx fifo of the same
+// queue, or to that of queue 0 if the client hasn't opened it.
+static void eth_handle_rx(ethdev_t* edev, uint32_t queue, const void* data, size_t len,
+                          uint32_t extra) {
     zx_status_t status;
     size_t count;
 
-    if (edev->rx_entry_count == 0) {
-        status = zx_fifo_read(edev->rx_fifo, sizeof(edev->rx_entries[0]), edev->rx_entries,
-                              countof(edev->rx_entries), &count);
+    eth_queue_t* q = &edev->queues[0];
+    if (queue < countof(edev->queues) && edev->queues[queue].rx_fifo != ZX_HANDLE_INVALID) {
+        q = &edev->queues[queue];
+    }
+
+    if (q->rx_entry_count == 0) {
+        status = zx_fifo_read(q->rx_fifo, sizeof(q->rx_entries[0]), q->rx_entries,
+                              countof(q->rx_entries), &count);
         if (status != ZX_OK) {
             if (status == ZX_ERR_SHOULD_WAIT) {
-                if ((edev->fail_rx_read++ % FAIL_REPORT_RATE) == 0) {
-                    zxlogf(ERROR, "eth [%s]: no rx buffers available (%u times)\n",
-                           edev->name, edev->fail_rx_read);
+                if ((q->fail_rx_read++ % FAIL_REPORT_RATE) == 0) {
+                    zxlogf(ERROR, "eth [%s]: no rx buffers available on queue %u (%u times)\n",
+                           edev->name, q->index, q->fail_rx_read);
                 }
             } else {
                 // Fatal, should force teardown
@@ -274,10 +340,10 @@ static void eth_handle_rx(ethdev_t* edev, const void* data, size_t len, uint32_t
             }
             return;
         }
-        edev->rx_entry_count = count;
+        q->rx_entry_count = count;
     }
 
-    zircon_ethernet_FifoEntry* e = &edev->rx_entries[--edev->rx_entry_count];
+    zircon_ethernet_FifoEntry* e = &q->rx_entries[--q->rx_entry_count];
     if ((e->offset >= edev->io_size) || ((e->length > (edev->io_size - e->offset)))) {
         // invalid offset/length. report error. drop packet
         e->length = 0;
@@ -292,18 +358,7 @@ static void eth_handle_rx(ethdev_t* edev, const void* data, size_t len, uint32_t
         e->flags = zircon_ethernet_FIFO_RX_OK | extra;
     }
 
-    if ((status = zx_fifo_write(edev->rx_fifo, sizeof(*e), e, 1, NULL)) < 0) {
-        if (status == ZX_ERR_SHOULD_WAIT) {
-            if ((edev->fail_rx_write++ % FAIL_REPORT_RATE) == 0) {
-                zxlogf(ERROR, "eth [%s]: no rx_fifo space available (%u times)\n",
-                       edev->name, edev->fail_rx_write);
-            }
-        } else {
-            // Fatal, should force teardown
-            zxlogf(ERROR, "eth [%s]: rx_fifo write failed %d\n", edev->name, status);
-        }
-        return;
-    }
+    eth_rx_fifo_write(q, e);
 }
 
 static void eth0_status(void* cookie, uint32_t status) {
@@ -318,22 +373,23 @@ static void eth0_status(void* cookie, uint32_t status) {
     static_assert(zircon_ethernet_SIGNAL_STATUS == ZX_USER_SIGNAL_0, "");
     ethdev_t* edev;
     list_for_every_entry(&edev0->list_active, edev, ethdev_t, node) {
-        zx_object_signal_peer(edev->rx_fifo, 0, zircon_ethernet_SIGNAL_STATUS);
+        zx_object_signal_peer(edev->queues[0].rx_fifo, 0, zircon_ethernet_SIGNAL_STATUS);
     }
     mtx_unlock(&edev0->lock);
 }
 
-static int tx_fifo_write(ethdev_t* edev, zircon_ethernet_FifoEntry* entries, size_t count) {
+static int tx_fifo_write(eth_queue_t* q, zircon_ethernet_FifoEntry* entries, size_t count) {
     zx_status_t status;
     size_t actual;
     // Writing should never fail, or fail to write all entries
-    status = zx_fifo_write(edev->tx_fifo, sizeof(zircon_ethernet_FifoEntry), entries, count, &actual);
+    status = zx_fifo_write(q->tx_fifo, sizeof(zircon_ethernet_FifoEntry), entries, count, &actual);
     if (status < 0) {
-        zxlogf(ERROR, "eth [%s]: tx_fifo write failed %d\n", edev->name, status);
+        zxlogf(ERROR, "eth [%s]: tx_fifo write failed %d\n", q->edev->name, status);
         return -1;
     }
     if (actual != count) {
-        zxlogf(ERROR, "eth [%s]: tx_fifo: only wrote %zu of %zu!\n", edev->name, actual, count);
+        zxlogf(ERROR, "eth [%s]: tx_fifo: only wrote %zu of %zu!\n",
+               q->edev->name, actual, count);
         return -1;
     }
     return 0;
@@ -341,17 +397,27 @@ static int tx_fifo_write(ethdev_t* edev, zircon_ethernet_FifoEntry* entries, siz
 
 // TODO: I think if this arrives at the wrong time during teardown we
 // can deadlock with the ethermac device
-static void eth0_recv(void* cookie, void* data, size_t len, uint32_t flags) {
+static void eth0_recv_queue(void* cookie, uint32_t queue, void* data, size_t len,
+                            uint32_t flags) {
     ethdev0_t* edev0 = cookie;
 
     ethdev_t* edev;
     mtx_lock(&edev0->lock);
     list_for_every_entry(&edev0->list_active, edev, ethdev_t, node) {
-        eth_handle_rx(edev, data, len, 0);
+        // Its rx entries belong to the ethmac; see eth_update_rx_direct_locked().
+        if (edev->state & ETHDEV_RX_DIRECT) {
+            continue;
+        }
+        eth_handle_rx(edev, queue, data, len,
+                      (flags & ETHMAC_RX_CSUM_VALID) ? zircon_ethernet_FIFO_RX_CSUM_OK : 0);
     }
     mtx_unlock(&edev0->lock);
 }
 
+static void eth0_recv(void* cookie, void* data, size_t len, uint32_t flags) {
+    eth0_recv_queue(cookie, 0, data, len, flags);
+}
+
 // Borrows a TX buffer from the pool. Logs and returns NULL if none is available
 static tx_info_t* eth_get_tx_info(ethdev_t* edev) {
     mtx_lock(&edev->lock);
@@ -370,11 +436,36 @@ static void eth_put_tx_info(ethdev_t* edev, tx_info_t* tx_info) {
     mtx_unlock(&edev->lock);
 }
 
+// Borrows |count| TX buffers from the pool at once. Logs and returns false, borrowing none, if
+// the pool doesn't hold that many.
+static bool eth_get_tx_infos(ethdev_t* edev, tx_info_t** tx_infos, size_t count) {
+    mtx_lock(&edev->lock);
+    size_t i;
+    for (i = 0; i < count; i++) {
+        tx_infos[i] = list_remove_head_type(&edev->free_tx_bufs, tx_info_t, netbuf.node);
+        if (tx_infos[i] == NULL) {
+            break;
+        }
+    }
+    if (i < count) {
+        while (i > 0) {
+            list_add_head(&edev->free_tx_bufs, &tx_infos[--i]->netbuf.node);
+        }
+    }
+    mtx_unlock(&edev->lock);
+    if (i < count) {
+        zxlogf(ERROR, "eth [%s]: tx_info pool empty\n", edev->name);
+        return false;
+    }
+    return true;
+}
+
 static void eth0_complete_tx(void* cookie, ethmac_netbuf_t* netbuf, zx_status_t status) {
     tx_info_t* tx_info = containerof(netbuf, tx_info_t, netbuf);
     ethdev_t* edev = tx_info->edev;
-    zircon_ethernet_FifoEntry entry = {.offset = netbuf->data - edev->io_buf,
-                              .length = netbuf->len,
+    eth_queue_t* q = tx_info->queue;
+    zircon_ethernet_FifoEntry entry = {.offset = tx_info->fifo_offset,
+                              .length = tx_info->fifo_length,
                               .flags = status == ZX_OK ? zircon_ethernet_FIFO_TX_OK : 0,
                               .cookie = tx_info->fifo_cookie};
 
@@ -383,13 +474,67 @@ static void eth0_complete_tx(void* cookie, ethmac_netbuf_t* netbuf, zx_status_t
     eth_put_tx_info(edev, tx_info);
 
     // Send the entry back to the client
-    tx_fifo_write(edev, &entry, 1);
+    tx_fifo_write(q, &entry, 1);
+}
+
+// Borrows up to |count| RX buffers from the pool, returning how many it got. If it got none,
+// eth_put_rx_info() will signal kSignalRxDirect once one is returned.
+static size_t eth_get_rx_infos(ethdev_t* edev, rx_info_t** rx_infos, size_t count) {
+    mtx_lock(&edev->lock);
+    size_t i;
+    for (i = 0; i < count; i++) {
+        rx_infos[i] = list_remove_head_type(&edev->free_rx_bufs, rx_info_t, netbuf.node);
+        if (rx_infos[i] == NULL) {
+            break;
+        }
+    }
+    if (i == 0) {
+        edev->rx_blocked = true;
+    }
+    mtx_unlock(&edev->lock);
+    return i;
+}
+
+// Returns an RX buffer to the pool, waking the fifo thread if it is waiting for one.
+static void eth_put_rx_info(ethdev_t* edev, rx_info_t* rx_info) {
+    mtx_lock(&edev->lock);
+    list_add_head(&edev->free_rx_bufs, &rx_info->netbuf.node);
+    bool blocked = edev->rx_blocked;
+    edev->rx_blocked = false;
+    mtx_unlock(&edev->lock);
+    if (blocked) {
+        zx_object_signal(edev->queues[0].tx_fifo, 0, kSignalRxDirect);
+    }
+}
+
+static void eth0_complete_rx(void* cookie, ethmac_netbuf_t* netbuf, size_t length,
+                             uint32_t flags) {
+    rx_info_t* rx_info = containerof(netbuf, rx_info_t, netbuf);
+    ethdev_t* edev = rx_info->edev;
+    zircon_ethernet_FifoEntry entry = rx_info->entry;
+    if (length == 0) {
+        // returned unused
+        entry.length = 0;
+        entry.flags = 0;
+    } else if (length > entry.length) {
+        entry.length = 0;
+        entry.flags = zircon_ethernet_FIFO_INVALID;
+    } else {
+        entry.length = length;
+        entry.flags = zircon_ethernet_FIFO_RX_OK |
+                      ((flags & ETHMAC_RX_CSUM_VALID) ? zircon_ethernet_FIFO_RX_CSUM_OK : 0);
+    }
+
+    eth_put_rx_info(edev, rx_info);
+    eth_rx_fifo_write(&edev->queues[0], &entry);
 }
 
 static ethmac_ifc_t ethmac_ifc = {
     .status = eth0_status,
     .recv = eth0_recv,
     .complete_tx = eth0_complete_tx,
+    .recv_queue = eth0_recv_queue,
+    .complete_rx = eth0_complete_rx,
 };
 
 static void eth_tx_echo(ethdev0_t* edev0, const void* data, size_t len) {
@@ -397,10 +542,163 @@ static void eth_tx_echo(ethdev0_t* edev0, const void* data, size_t len) {
     mtx_lock(&edev0->lock);
     list_for_every_entry(&edev0->list_active, edev, ethdev_t, node) {
         if (edev->state & ETHDEV_TX_LISTEN) {
-            eth_handle_rx(edev, data, len, zircon_ethernet_FIFO_RX_TX);
+            eth_handle_rx(edev, 0, data, len, zircon_ethernet_FIFO_RX_TX);
+        }
+    }
+    mtx_unlock(&edev0->lock);
+}
+
+// Fills in the netbuf of |rx_info| from its entry. Returns false if the entry isn't within the
+// io buffer, or isn't physically contiguous.
+static bool eth_fill_rx_netbuf(ethdev_t* edev, rx_info_t* rx_info) {
+    const zircon_ethernet_FifoEntry* e = &rx_info->entry;
+    if ((e->length == 0) || (e->offset >= edev->io_size) ||
+        (e->length > (edev->io_size - e->offset))) {
+        return false;
+    }
+    size_t first = e->offset / PAGE_SIZE;
+    size_t last = (e->offset + e->length - 1) / PAGE_SIZE;
+    for (size_t i = first; i < last; i++) {
+        if (edev->paddr_map[i + 1] != edev->paddr_map[i] + PAGE_SIZE) {
+            return false;
+        }
+    }
+
+    ethmac_netbuf_t* netbuf = &rx_info->netbuf;
+    memset(netbuf, 0, sizeof(*netbuf));
+    netbuf->data = edev->io_buf + e->offset;
+    netbuf->phys = edev->paddr_map[first] + (e->offset & PAGE_MASK);
+    netbuf->len = e->length;
+    return true;
+}
+
+// Queues the rx buffers in |pending_rx_bufs| to the ethmac. Returns false if it ran out of room
+// for them, in which case eth_put_rx_info() will signal kSignalRxDirect once it has more.
+static bool eth_queue_pending_rx_locked(ethdev_t* edev) {
+    ethdev0_t* edev0 = edev->edev0;
+    rx_info_t* rx_info;
+    while ((rx_info = list_remove_head_type(&edev->pending_rx_bufs, rx_info_t, netbuf.node))) {
+        zx_status_t status = ZX_ERR_INVALID_ARGS;
+        if (eth_fill_rx_netbuf(edev, rx_info)) {
+            status = edev0->mac.ops->queue_rx(edev0->mac.ctx, 0, &rx_info->netbuf);
+            if (status == ZX_ERR_SHOULD_WAIT) {
+                // Ask to be woken by the next completion, then try again in case it came
+                // before we asked.
+                mtx_lock(&edev->lock);
+                edev->rx_blocked = true;
+                mtx_unlock(&edev->lock);
+                status = edev0->mac.ops->queue_rx(edev0->mac.ctx, 0, &rx_info->netbuf);
+            }
+            if (status == ZX_ERR_SHOULD_WAIT) {
+                list_add_head(&edev->pending_rx_bufs, &rx_info->netbuf.node);
+                return false;
+            }
+        }
+        if (status != ZX_OK) {
+            rx_info->entry.length = 0;
+            rx_info->entry.flags = zircon_ethernet_FIFO_INVALID;
+            eth_rx_fifo_write(&edev->queues[0], &rx_info->entry);
+            eth_put_rx_info(edev, rx_info);
+        }
+    }
+    return true;
+}
+
+// Posts the entries the client has queued on its rx fifo to the ethmac, which receives directly
+// into them. Called by the fifo thread of queue 0. Returns whether it should wait for more to
+// be queued: not if the instance no longer receives directly, nor while the ethmac or the pool
+// of rx_info_t is full.
+static bool eth_post_rx_buffers(ethdev_t* edev) TA_NO_THREAD_SAFETY_ANALYSIS {
+    ethdev0_t* edev0 = edev->edev0;
+    eth_queue_t* q = &edev->queues[0];
+    bool wait_rx = false;
+
+    mtx_lock(&edev0->lock);
+    while ((edev->state & ETHDEV_RX_DIRECT) && eth_queue_pending_rx_locked(edev)) {
+        rx_info_t* rx_infos[FIFO_BATCH_SZ];
+        size_t n = eth_get_rx_infos(edev, rx_infos, countof(rx_infos));
+        if (n == 0) {
+            break;
+        }
+        zircon_ethernet_FifoEntry entries[FIFO_BATCH_SZ];
+        size_t count = 0;
+        zx_status_t status = zx_fifo_read(q->rx_fifo, sizeof(entries[0]), entries, n, &count);
+        for (size_t i = 0; i < n; i++) {
+            if (i < count) {
+                rx_infos[i]->entry = entries[i];
+                list_add_tail(&edev->pending_rx_bufs, &rx_infos[i]->netbuf.node);
+            } else {
+                eth_put_rx_info(edev, rx_infos[i]);
+            }
+        }
+        if (status != ZX_OK) {
+            if (status == ZX_ERR_SHOULD_WAIT) {
+                wait_rx = true;
+            } else {
+                zxlogf(ERROR, "eth [%s]: rx fifo read failed %d\n", edev->name, status);
+            }
+            break;
         }
     }
     mtx_unlock(&edev0->lock);
+    return wait_rx;
+}
+
+// Has the ethmac receive directly into the io buffer of the only client, sparing a copy of each
+// frame, while there is just one, which neither sees transmitted frames nor is promiscuous.
+// Otherwise each client is given a copy of each frame by eth_handle_rx().
+static void eth_update_rx_direct_locked(ethdev0_t* edev0) TA_NO_THREAD_SAFETY_ANALYSIS {
+    ethdev_t* edev = NULL;
+    if ((edev0->info.features & ETHMAC_FEATURE_RX_BUFFERS) && (edev0->num_queues == 1) &&
+        (list_length(&edev0->list_active) == 1)) {
+        edev = list_peek_head_type(&edev0->list_active, ethdev_t, node);
+        if (edev->state & (ETHDEV_DEAD | ETHDEV_TX_LOOPBACK | ETHDEV_TX_LISTEN | ETHDEV_PROMISC)) {
+            edev = NULL;
+        }
+    }
+    if (edev == edev0->rx_direct) {
+        return;
+    }
+
+    ethdev_t* old = edev0->rx_direct;
+    if (old != NULL) {
+        // The ethmac returns the buffers it holds through complete_rx() before this returns.
+        old->state &= ~ETHDEV_RX_DIRECT;
+        edev0->rx_direct = NULL;
+        edev0->mac.ops->set_param(edev0->mac.ctx, ETHMAC_SETPARAM_RX_BUFFERS, false, NULL);
+        rx_info_t* rx_info;
+        while ((rx_info = list_remove_head_type(&old->pending_rx_bufs, rx_info_t, netbuf.node))) {
+            rx_info->entry.length = 0;
+            rx_info->entry.flags = 0;
+            eth_rx_fifo_write(&old->queues[0], &rx_info->entry);
+            eth_put_rx_info(old, rx_info);
+        }
+        zx_object_signal(old->queues[0].tx_fifo, 0, kSignalRxDirect);
+    }
+
+    if (edev != NULL) {
+        zx_status_t status = edev0->mac.ops->set_param(edev0->mac.ctx,
+                                                       ETHMAC_SETPARAM_RX_BUFFERS, true, NULL);
+        if (status != ZX_OK) {
+            zxlogf(ERROR, "eth [%s]: cannot receive into io buffer: %d\n", edev->name, status);
+            return;
+        }
+        edev->state |= ETHDEV_RX_DIRECT;
+        edev0->rx_direct = edev;
+
+        // The whole pool is free, so the entries already read for eth_handle_rx() are posted
+        // first.
+        eth_queue_t* q = &edev->queues[0];
+        rx_info_t* rx_infos[FIFO_BATCH_SZ];
+        size_t n = eth_get_rx_infos(edev, rx_infos, q->rx_entry_count);
+        ZX_DEBUG_ASSERT(n == q->rx_entry_count);
+        for (size_t i = 0; i < n; i++) {
+            rx_infos[i]->entry = q->rx_entries[i];
+            list_add_tail(&edev->pending_rx_bufs, &rx_infos[i]->netbuf.node);
+        }
+        q->rx_entry_count = 0;
+        zx_object_signal(q->tx_fifo, 0, kSignalRxDirect);
+    }
 }
 
 static zx_status_t eth_tx_listen_locked(ethdev_t* edev, bool yes) {
@@ -430,13 +728,169 @@ static zx_status_t eth_tx_listen_locked(ethdev_t* edev, bool yes) {
         }
     }
 
+    eth_update_rx_direct_locked(edev0);
     return ZX_OK;
 }
 
+// Checks that |offload| only asks for offloads the ethmac has, within the
+// |len| bytes of the packet it precedes.
+static bool eth_offload_valid(ethdev0_t* edev0, const zircon_ethernet_TxOffload* offload,
+                              size_t len) {
+    const uint16_t kTso = zircon_ethernet_TX_OFFLOAD_TSO_V4 | zircon_ethernet_TX_OFFLOAD_TSO_V6;
+    if (offload->flags & ~(zircon_ethernet_TX_OFFLOAD_CSUM | kTso)) {
+        return false;
+    }
+    if (offload->flags & zircon_ethernet_TX_OFFLOAD_CSUM) {
+        if (!(edev0->info.features & ETHMAC_FEATURE_TX_CSUM) ||
+            (size_t)offload->csum_start + offload->csum_offset + sizeof(uint16_t) > len) {
+            return false;
+        }
+    }
+    if (offload->flags & kTso) {
+        if (!(edev0->info.features & ETHMAC_FEATURE_TSO) || (offload->flags & kTso) == kTso ||
+            !(offload->flags & zircon_ethernet_TX_OFFLOAD_CSUM) || offload->gso_size == 0 ||
+            offload->hdr_len > len || len > edev0->info.tso_max_size) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Sets up the netbuf of |tx_info| to transmit the packet |e| describes.
+// Returns false if it isn't within the io buffer, or if it asks for offloads
+// which aren't valid.
+static bool eth_fill_netbuf(eth_queue_t* q, tx_info_t* tx_info,
+                            const zircon_ethernet_FifoEntry* e) {
+    ethdev_t* edev = q->edev;
+    ethdev0_t* edev0 = edev->edev0;
+    if ((e->offset > edev->io_size) || ((e->length > (edev->io_size - e->offset)))) {
+        return false;
+    }
+
+    uint32_t offset = e->offset;
+    uint16_t length = e->length;
+    ethmac_netbuf_t* netbuf = &tx_info->netbuf;
+    netbuf->flags = 0;
+    netbuf->csum_start = 0;
+    netbuf->csum_offset = 0;
+    netbuf->gso_size = 0;
+    netbuf->hdr_len = 0;
+    if (e->flags & zircon_ethernet_FIFO_TX_OFFLOAD) {
+        // The client may keep writing to the io buffer, so the offloads are
+        // only read once.
+        zircon_ethernet_TxOffload offload;
+        if (length < sizeof(offload)) {
+            return false;
+        }
+        memcpy(&offload, edev->io_buf + offset, sizeof(offload));
+        offset += sizeof(offload);
+        length -= sizeof(offload);
+        if (!eth_offload_valid(edev0, &offload, length)) {
+            return false;
+        }
+
+        static_assert(ETHMAC_NETBUF_NEEDS_CSUM == zircon_ethernet_TX_OFFLOAD_CSUM, "");
+        static_assert(ETHMAC_NETBUF_GSO_TCPV4 == zircon_ethernet_TX_OFFLOAD_TSO_V4, "");
+        static_assert(ETHMAC_NETBUF_GSO_TCPV6 == zircon_ethernet_TX_OFFLOAD_TSO_V6, "");
+        netbuf->flags = offload.flags;
+        netbuf->csum_start = offload.csum_start;
+        netbuf->csum_offset = offload.csum_offset;
+        if (offload.flags & (ETHMAC_NETBUF_GSO_TCPV4 | ETHMAC_NETBUF_GSO_TCPV6)) {
+            netbuf->gso_size = offload.gso_size;
+            netbuf->hdr_len = offload.hdr_len;
+        }
+    }
+
+    netbuf->data = edev->io_buf + offset;
+    if (edev0->info.features & ETHMAC_FEATURE_DMA) {
+        netbuf->phys = edev->paddr_map[offset / PAGE_SIZE] + (offset & PAGE_MASK);
+    }
+    netbuf->len = length;
+    netbuf->queue = q->index;
+    tx_info->queue = q;
+    tx_info->fifo_offset = e->offset;
+    tx_info->fifo_length = e->length;
+    tx_info->fifo_cookie = e->cookie;
+    return true;
+}
+
+// Like eth_send(), but hands every valid entry to the ethmac in a single
+// queue_tx_batch() call. The array of entries is invalidated after the call
+static int eth_send_batch(eth_queue_t* q, zircon_ethernet_FifoEntry* entries, uint32_t count) {
+    ethdev_t* edev = q->edev;
+    ethdev0_t* edev0 = edev->edev0;
+    tx_info_t* tx_infos[FIFO_DEPTH / 2];
+    ethmac_netbuf_t* netbufs[FIFO_DEPTH / 2];
+    zx_status_t statuses[FIFO_DEPTH / 2];
+    ZX_DEBUG_ASSERT(count <= countof(netbufs));
+
+    if (!eth_get_tx_infos(edev, tx_infos, count)) {
+        return -1;
+    }
+
+    // Invalid entries are sent back right away, filtered out in-place as in
+    // eth_send(). The valid ones are moved to the TX buffers, where their
+    // completions are rebuilt from once the batch has been queued.
+    uint32_t to_write = 0;
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        zircon_ethernet_FifoEntry* e = &entries[i];
+        if (!eth_fill_netbuf(q, tx_infos[n], e)) {
+            e->flags = zircon_ethernet_FIFO_INVALID;
+            entries[to_write++] = *e;
+        } else {
+            netbufs[n] = &tx_infos[n]->netbuf;
+            n++;
+        }
+    }
+    for (uint32_t i = n; i < count; i++) {
+        eth_put_tx_info(edev, tx_infos[i]);
+    }
+
+    // Packets the ethmac is still enqueueing may be completed as soon as the
+    // batch has been handed to it, so they are echoed beforehand.
+    if (edev->state & ETHDEV_TX_LOOPBACK) {
+        for (uint32_t i = 0; i < n; i++) {
+            eth_tx_echo(edev0, netbufs[i]->data, netbufs[i]->len);
+        }
+    }
+
+    if (n > 0) {
+        edev0->mac.ops->queue_tx_batch(edev0->mac.ctx, 0, netbufs, n, statuses);
+        q->tx_batches++;
+        q->tx_batch_frames += n;
+        if (n > q->tx_batch_max) {
+            q->tx_batch_max = n;
+        }
+    }
+
+    for (uint32_t i = 0; i < n; i++) {
+        tx_info_t* tx_info = tx_infos[i];
+        // The ownership of the TX buffers of packets still being enqueued is
+        // transferred to the ethmac, which returns them through complete_tx().
+        if (statuses[i] != ZX_ERR_SHOULD_WAIT) {
+            zircon_ethernet_FifoEntry* e = &entries[to_write++];
+            e->offset = tx_info->fifo_offset;
+            e->length = tx_info->fifo_length;
+            e->flags = statuses[i] == ZX_OK ? zircon_ethernet_FIFO_TX_OK : 0;
+            e->cookie = tx_info->fifo_cookie;
+            eth_put_tx_info(edev, tx_info);
+        }
+    }
+    if (to_write) {
+        tx_fifo_write(q, entries, to_write);
+    }
+    return 0;
+}
+
 // The array of entries is invalidated after the call
-static int eth_send(ethdev_t* edev, zircon_ethernet_FifoEntry* entries, uint32_t count) {
+static int eth_send(eth_queue_t* q, zircon_ethernet_FifoEntry* entries, uint32_t count) {
     tx_info_t* tx_info = NULL;
+    ethdev_t* edev = q->edev;
     ethdev0_t* edev0 = edev->edev0;
+    if (edev0->mac.ops->queue_tx_batch != NULL) {
+        return eth_send_batch(q, entries, count);
+    }
     // The entries that we can't send back to the fifo immediately are filtered
     // out in-place using a classic algorithm a-la "std::remove_if".
     // Once the loop finishes, the first 'to_write' entries in the array
@@ -444,31 +898,26 @@ static int eth_send(ethdev_t* edev, zircon_ethernet_FifoEntry* entries, uint32_t
     // the eth0_complete_tx callback.
     uint32_t to_write = 0;
     for (zircon_ethernet_FifoEntry* e = entries; count > 0; e++) {
-        if ((e->offset > edev->io_size) || ((e->length > (edev->io_size - e->offset)))) {
+        if (tx_info == NULL) {
+            tx_info = eth_get_tx_info(edev);
+            if (tx_info == NULL) {
+                return -1;
+            }
+        }
+        if (!eth_fill_netbuf(q, tx_info, e)) {
             e->flags = zircon_ethernet_FIFO_INVALID;
             entries[to_write++] = *e;
         } else {
             zx_status_t status;
-            if (tx_info == NULL) {
-                tx_info = eth_get_tx_info(edev);
-                if (tx_info == NULL) {
-                    return -1;
-                }
-            }
             uint32_t opts = count > 1 ? ETHMAC_TX_OPT_MORE : 0u;
             if (opts) {
                 zxlogf(SPEW, "setting OPT_MORE (%u packets to go)\n", count);
             }
-            tx_info->netbuf.data = edev->io_buf + e->offset;
-            if (edev0->info.features & ETHMAC_FEATURE_DMA) {
-                tx_info->netbuf.phys = edev->paddr_map[e->offset / PAGE_SIZE] +
-                                       (e->offset & PAGE_MASK);
-            }
-            tx_info->netbuf.len = e->length;
-            tx_info->fifo_cookie = e->cookie;
+            void* data = tx_info->netbuf.data;
+            size_t len = tx_info->netbuf.len;
             status = edev0->mac.ops->queue_tx(edev0->mac.ctx, opts, &tx_info->netbuf);
             if (edev->state & ETHDEV_TX_LOOPBACK) {
-                eth_tx_echo(edev0, edev->io_buf + e->offset, e->length);
+                eth_tx_echo(edev0, data, len);
             }
             if (status != ZX_ERR_SHOULD_WAIT) {
                 // Transmission completed. To avoid extra mutex locking/unlocking,
@@ -488,70 +937,167 @@ static int eth_send(ethdev_t* edev, zircon_ethernet_FifoEntry* entries, uint32_t
         eth_put_tx_info(edev, tx_info);
     }
     if (to_write) {
-        tx_fifo_write(edev, entries, to_write);
+        tx_fifo_write(q, entries, to_write);
     }
     return 0;
 }
 
+// Also posts rx buffers to the ethmac for queue 0, while it receives directly
+// into the io buffer.
 static int eth_tx_thread(void* arg) {
-    ethdev_t* edev = (ethdev_t*)arg;
+    eth_queue_t* q = (eth_queue_t*)arg;
+    ethdev_t* edev = q->edev;
     zircon_ethernet_FifoEntry entries[FIFO_DEPTH / 2];
     zx_status_t status;
     size_t count;
+    bool wait_rx = false;
 
     for (;;) {
-        if ((status = zx_fifo_read(edev->tx_fifo, sizeof(entries[0]), entries,
+        if ((status = zx_fifo_read(q->tx_fifo, sizeof(entries[0]), entries,
                                    countof(entries), &count)) < 0) {
             if (status == ZX_ERR_SHOULD_WAIT) {
-                zx_signals_t observed;
-                if ((status = zx_object_wait_one(edev->tx_fifo,
-                                                 ZX_FIFO_READABLE |
-                                                 ZX_FIFO_PEER_CLOSED |
-                                                 kSignalFifoTerminate,
-                                                 ZX_TIME_INFINITE,
-                                                 &observed)) < 0) {
+                zx_wait_item_t items[] = {
+                    {.handle = q->tx_fifo,
+                     .waitfor = ZX_FIFO_READABLE | ZX_FIFO_PEER_CLOSED | kSignalFifoTerminate |
+                                kSignalRxDirect},
+                    {.handle = q->rx_fifo, .waitfor = ZX_FIFO_READABLE},
+                };
+                if ((status = zx_object_wait_many(items, wait_rx ? 2 : 1,
+                                                  ZX_TIME_INFINITE)) < 0) {
+                    // Direct rx may have stopped as the rx fifo was closed.
+                    if (wait_rx && !(wait_rx = eth_post_rx_buffers(edev))) {
+                        continue;
+                    }
                     zxlogf(ERROR, "eth [%s]: tx_fifo: error waiting: %d\n", edev->name, status);
                     break;
                 }
-                if (observed & kSignalFifoTerminate)
+                if (items[0].pending & kSignalFifoTerminate)
                     break;
+                if ((items[0].pending & kSignalRxDirect) ||
+                    (wait_rx && (items[1].pending & ZX_FIFO_READABLE))) {
+                    zx_object_signal(q->tx_fifo, kSignalRxDirect, 0);
+                    wait_rx = eth_post_rx_buffers(edev);
+                }
                 continue;
             } else {
                 zxlogf(ERROR, "eth [%s]: tx_fifo: cannot read: %d\n", edev->name, status);
                 break;
             }
         }
-        if (eth_send(edev, entries, count)) {
+        if (eth_send(q, entries, count)) {
             break;
         }
     }
 
-    zxlogf(INFO, "eth [%s]: tx_thread: exit: %d\n", edev->name, status);
+    zxlogf(INFO, "eth [%s]: tx_thread %u: exit: %d\n", edev->name, q->index, status);
     return 0;
 }
 
-static zx_status_t eth_get_fifos_locked(ethdev_t* edev, struct zircon_ethernet_Fifos* fifos) {
+static zx_status_t eth_start_tx_thread_locked(eth_queue_t* q) {
+    if (q->tx_thread_created) {
+        return ZX_OK;
+    }
+    int r = thrd_create_with_name(&q->tx_thr, eth_tx_thread, q, "eth-tx-thread");
+    if (r != thrd_success) {
+        zxlogf(ERROR, "eth [%s]: failed to start tx thread %u: %d\n", q->edev->name, q->index, r);
+        return ZX_ERR_INTERNAL;
+    }
+    q->tx_thread_created = true;
+    return ZX_OK;
+}
+
+static zx_status_t eth_get_fifos_locked(ethdev_t* edev, uint32_t queue,
+                                        struct zircon_ethernet_Fifos* fifos) {
+    if (queue >= edev->edev0->num_queues) {
+        return ZX_ERR_OUT_OF_RANGE;
+    }
+    eth_queue_t* q = &edev->queues[queue];
+    if (q->tx_fifo != ZX_HANDLE_INVALID) {
+        return ZX_ERR_ALREADY_BOUND;
+    }
+
     zx_status_t status;
-    if ((status = zx_fifo_create(FIFO_DEPTH, FIFO_ESIZE, 0, &fifos->tx, &edev->tx_fifo)) < 0) {
+    if ((status = zx_fifo_create(FIFO_DEPTH, FIFO_ESIZE, 0, &fifos->tx, &q->tx_fifo)) < 0) {
         zxlogf(ERROR, "eth_create  [%s]: failed to create tx fifo: %d\n", edev->name, status);
         return status;
     }
-    if ((status = zx_fifo_create(FIFO_DEPTH, FIFO_ESIZE, 0, &fifos->rx, &edev->rx_fifo)) < 0) {
+    if ((status = zx_fifo_create(FIFO_DEPTH, FIFO_ESIZE, 0, &fifos->rx, &q->rx_fifo)) < 0) {
         zxlogf(ERROR, "eth_create  [%s]: failed to create rx fifo: %d\n", edev->name, status);
         zx_handle_close(fifos->tx);
-        zx_handle_close(edev->tx_fifo);
-        edev->tx_fifo = ZX_HANDLE_INVALID;
+        zx_handle_close(q->tx_fifo);
+        q->tx_fifo = ZX_HANDLE_INVALID;
         return status;
     }
 
-    edev->tx_depth = FIFO_DEPTH;
-    edev->rx_depth = FIFO_DEPTH;
+    // Queues opened once the instance is running are served right away; the
+    // others when it starts.
+    if ((edev->state & ETHDEV_RUNNING) && (status = eth_start_tx_thread_locked(q)) != ZX_OK) {
+        zx_handle_close(fifos->tx);
+        zx_handle_close(fifos->rx);
+        zx_handle_close(q->tx_fifo);
+        zx_handle_close(q->rx_fifo);
+        q->tx_fifo = ZX_HANDLE_INVALID;
+        q->rx_fifo = ZX_HANDLE_INVALID;
+        return status;
+    }
+
+    q->tx_depth = FIFO_DEPTH;
+    q->rx_depth = FIFO_DEPTH;
     fifos->tx_depth = FIFO_DEPTH;
     fifos->rx_depth = FIFO_DEPTH;
 
     return ZX_OK;
 }
 
+static zx_status_t eth_get_queue_fifos_locked(ethdev_t* edev, uint32_t queue, uint32_t cpu,
+                                              struct zircon_ethernet_Fifos* fifos) {
+    if (queue >= edev->edev0->num_queues) {
+        return ZX_ERR_OUT_OF_RANGE;
+    }
+    if (cpu != zircon_ethernet_QUEUE_CPU_ANY) {
+        ethdev0_t* edev0 = edev->edev0;
+        zx_status_t status = edev0->mac.ops->set_param(edev0->mac.ctx, ETHMAC_SETPARAM_QUEUE_CPU,
+                                                       (int32_t)queue, &cpu);
+        if (status != ZX_OK) {
+            return status;
+        }
+    }
+    return eth_get_fifos_locked(edev, queue, fifos);
+}
+
+static zx_status_t eth_set_rss_locked(ethdev_t* edev, const zircon_ethernet_RssConfig* config) {
+    ethdev0_t* edev0 = edev->edev0;
+    if (!(edev0->info.features & ETHMAC_FEATURE_MULTIQUEUE)) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+
+    static_assert(ETHMAC_RSS_HASH_IPV4 == zircon_ethernet_RSS_HASH_IPV4, "");
+    static_assert(ETHMAC_RSS_HASH_TCP_IPV4 == zircon_ethernet_RSS_HASH_TCP_IPV4, "");
+    static_assert(ETHMAC_RSS_HASH_UDP_IPV4 == zircon_ethernet_RSS_HASH_UDP_IPV4, "");
+    static_assert(ETHMAC_RSS_HASH_IPV6 == zircon_ethernet_RSS_HASH_IPV6, "");
+    static_assert(ETHMAC_RSS_HASH_TCP_IPV6 == zircon_ethernet_RSS_HASH_TCP_IPV6, "");
+    static_assert(ETHMAC_RSS_HASH_UDP_IPV6 == zircon_ethernet_RSS_HASH_UDP_IPV6, "");
+    const uint32_t kHashTypes = ETHMAC_RSS_HASH_IPV4 | ETHMAC_RSS_HASH_TCP_IPV4 |
+                                ETHMAC_RSS_HASH_UDP_IPV4 | ETHMAC_RSS_HASH_IPV6 |
+                                ETHMAC_RSS_HASH_TCP_IPV6 | ETHMAC_RSS_HASH_UDP_IPV6;
+    if (config->hash_types & ~kHashTypes) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+
+    ethmac_rss_config_t rss;
+    static_assert(sizeof(rss.key) == sizeof(config->key), "");
+    static_assert(sizeof(rss.indirection) == sizeof(config->indirection), "");
+    rss.hash_types = config->hash_types;
+    memcpy(rss.key, config->key, sizeof(rss.key));
+    for (size_t i = 0; i < countof(rss.indirection); i++) {
+        if (config->indirection[i] >= edev0->num_queues) {
+            return ZX_ERR_OUT_OF_RANGE;
+        }
+        rss.indirection[i] = config->indirection[i];
+    }
+    return edev0->mac.ops->set_param(edev0->mac.ctx, ETHMAC_SETPARAM_RSS, 0, &rss);
+}
+
 static ssize_t eth_set_iobuf_locked(ethdev_t* edev, zx_handle_t vmo) {
     if (edev->io_vmo != ZX_HANDLE_INVALID || edev->io_buf != NULL) {
         return ZX_ERR_ALREADY_BOUND;
@@ -575,7 +1121,7 @@ static ssize_t eth_set_iobuf_locked(ethdev_t* edev, zx_handle_t vmo) {
 
     // If the driver indicates that it will be doing DMA to/from the vmo,
     // we pin the memory and cache the physical address list
-    if (edev->edev0->info.features & ETHMAC_FEATURE_DMA) {
+    if (edev->edev0->info.features & (ETHMAC_FEATURE_DMA | ETHMAC_FEATURE_RX_BUFFERS)) {
         size_t pages = ROUNDUP(size, PAGE_SIZE) / PAGE_SIZE;
         edev->paddr_map = malloc(pages * sizeof(zx_paddr_t));
         if (!edev->paddr_map) {
@@ -619,8 +1165,8 @@ static zx_status_t eth_start_locked(ethdev_t* edev) TA_NO_THREAD_SAFETY_ANALYSIS
 
     // Cannot start unless tx/rx rings are configured
     if ((edev->io_vmo == ZX_HANDLE_INVALID) ||
-        (edev->tx_fifo == ZX_HANDLE_INVALID) ||
-        (edev->rx_fifo == ZX_HANDLE_INVALID)) {
+        (edev->queues[0].tx_fifo == ZX_HANDLE_INVALID) ||
+        (edev->queues[0].rx_fifo == ZX_HANDLE_INVALID)) {
         return ZX_ERR_BAD_STATE;
     }
 
@@ -628,17 +1174,14 @@ static zx_status_t eth_start_locked(ethdev_t* edev) TA_NO_THREAD_SAFETY_ANALYSIS
         return ZX_OK;
     }
 
-    if (!(edev->state & ETHDEV_TX_THREAD)) {
-        int r = thrd_create_with_name(&edev->tx_thr, eth_tx_thread,
-                                      edev, "eth-tx-thread");
-        if (r != thrd_success) {
-            zxlogf(ERROR, "eth [%s]: failed to start tx thread: %d\n", edev->name, r);
-            return ZX_ERR_INTERNAL;
+    zx_status_t status;
+    for (size_t i = 0; i < countof(edev->queues); i++) {
+        if (edev->queues[i].tx_fifo != ZX_HANDLE_INVALID &&
+            (status = eth_start_tx_thread_locked(&edev->queues[i])) != ZX_OK) {
+            return status;
         }
-        edev->state |= ETHDEV_TX_THREAD;
     }
 
-    zx_status_t status;
     if (list_is_empty(&edev0->list_active)) {
         // Release the lock to allow other device operations in callback routine.
         // Re-acquire lock afterwards. Set busy to prevent problems with other ioctls.
@@ -657,6 +1200,7 @@ static zx_status_t eth_start_locked(ethdev_t* edev) TA_NO_THREAD_SAFETY_ANALYSIS
         list_add_tail(&edev0->list_active, &edev->node);
         // TODO - After we get IGMP, don't automatically set multicast promisc true
         eth_set_multicast_promisc_locked(edev, true);
+        eth_update_rx_direct_locked(edev0);
     } else {
         zxlogf(ERROR, "eth [%s]: failed to start mac: %d\n", edev->name, status);
     }
@@ -679,6 +1223,7 @@ static zx_status_t eth_stop_locked(ethdev_t* edev) TA_NO_THREAD_SAFETY_ANALYSIS
         eth_set_promisc_locked(edev, false);
         eth_set_multicast_promisc_locked(edev, false);
         eth_rebuild_multicast_filter_locked(edev);
+        eth_update_rx_direct_locked(edev0);
         if (list_is_empty(&edev0->list_active)) {
             if (!(edev->state & ETHDEV_DEAD)) {
                 // Release the lock to allow other device operations in callback routine.
@@ -709,10 +1254,10 @@ static zx_status_t eth_get_status_locked(ethdev_t* edev, void* out_buf, size_t o
     if (out_len < sizeof(uint32_t)) {
         return ZX_ERR_INVALID_ARGS;
     }
-    if (edev->rx_fifo == ZX_HANDLE_INVALID) {
+    if (edev->queues[0].rx_fifo == ZX_HANDLE_INVALID) {
         return ZX_ERR_BAD_STATE;
     }
-    if (zx_object_signal_peer(edev->rx_fifo, zircon_ethernet_SIGNAL_STATUS, 0) != ZX_OK) {
+    if (zx_object_signal_peer(edev->queues[0].rx_fifo, zircon_ethernet_SIGNAL_STATUS, 0) != ZX_OK) {
         return ZX_ERR_INTERNAL;
     }
 
@@ -735,6 +1280,15 @@ static zx_status_t fidl_GetInfo_locked(void* ctx, fidl_txn_t* txn) {
     if (edev->edev0->info.features & ETHMAC_FEATURE_SYNTH) {
         info.features |= zircon_ethernet_INFO_FEATURE_SYNTH;
     }
+    if (edev->edev0->info.features & ETHMAC_FEATURE_TX_CSUM) {
+        info.features |= zircon_ethernet_INFO_FEATURE_TX_CSUM;
+    }
+    if (edev->edev0->info.features & ETHMAC_FEATURE_RX_CSUM) {
+        info.features |= zircon_ethernet_INFO_FEATURE_RX_CSUM;
+    }
+    if (edev->edev0->info.features & ETHMAC_FEATURE_TSO) {
+        info.features |= zircon_ethernet_INFO_FEATURE_TSO;
+    }
     info.mtu = edev->edev0->info.mtu;
     return REPLY(GetInfo)(txn, &info);
 }
@@ -742,7 +1296,7 @@ static zx_status_t fidl_GetInfo_locked(void* ctx, fidl_txn_t* txn) {
 static zx_status_t fidl_GetFifos_locked(void* ctx, fidl_txn_t* txn) {
     ethdev_t* edev = ctx;
     zircon_ethernet_Fifos fifos;
-    return REPLY(GetFifos)(txn, eth_get_fifos_locked(edev, &fifos), &fifos);
+    return REPLY(GetFifos)(txn, eth_get_fifos_locked(edev, 0, &fifos), &fifos);
 }
 
 static zx_status_t fidl_SetIOBuffer_locked(void* ctx, zx_handle_t h, fidl_txn_t* txn) {
@@ -780,7 +1334,7 @@ static zx_status_t fidl_SetClientName_locked(void* ctx, const char* buf, size_t
 
 static zx_status_t fidl_GetStatus_locked(void* ctx, fidl_txn_t* txn) {
     ethdev_t* edev = ctx;
-    if (zx_object_signal_peer(edev->rx_fifo, zircon_ethernet_SIGNAL_STATUS, 0) != ZX_OK) {
+    if (zx_object_signal_peer(edev->queues[0].rx_fifo, zircon_ethernet_SIGNAL_STATUS, 0) != ZX_OK) {
         return ZX_ERR_INTERNAL;
     }
     return REPLY(GetStatus)(txn, edev->edev0->status);
@@ -788,7 +1342,9 @@ static zx_status_t fidl_GetStatus_locked(void* ctx, fidl_txn_t* txn) {
 
 static zx_status_t fidl_SetPromisc_locked(void* ctx, bool enabled, fidl_txn_t* txn) {
     ethdev_t* edev = ctx;
-    return REPLY(SetPromiscuousMode)(txn, eth_set_promisc_locked(edev, enabled));
+    ssize_t status = eth_set_promisc_locked(edev, enabled);
+    eth_update_rx_direct_locked(edev->edev0);
+    return REPLY(SetPromiscuousMode)(txn, status);
 }
 
 static zx_status_t fidl_ConfigMulticastAddMac_locked(void* ctx,
@@ -824,11 +1380,72 @@ static zx_status_t fidl_ConfigMulticastTestFilter_locked(void* ctx, fidl_txn_t*
 
 static zx_status_t fidl_DumpRegisters_locked(void* ctx, fidl_txn_t* txn) {
     ethdev_t* edev = ctx;
+    for (size_t i = 0; i < countof(edev->queues); i++) {
+        eth_queue_t* q = &edev->queues[i];
+        if (q->tx_batches > 0) {
+            zxlogf(INFO, "eth [%s]: queue %u: %" PRIu64 " tx batches, %" PRIu64
+                   " frames, at most %u per batch\n", edev->name, q->index, q->tx_batches,
+                   q->tx_batch_frames, q->tx_batch_max);
+        }
+    }
     zx_status_t status = edev->edev0->mac.ops->set_param(edev->edev0->mac.ctx,
                                                          ETHMAC_SETPARAM_DUMP_REGS, 0, NULL);
     return REPLY(DumpRegisters)(txn, status);
 }
 
+static zx_status_t fidl_GetQueueCount_locked(void* ctx, fidl_txn_t* txn) {
+    ethdev_t* edev = ctx;
+    return REPLY(GetQueueCount)(txn, edev->edev0->num_queues);
+}
+
+static zx_status_t fidl_GetQueueFifos_locked(void* ctx, uint32_t queue, uint32_t cpu,
+                                             fidl_txn_t* txn) {
+    ethdev_t* edev = ctx;
+    zircon_ethernet_Fifos fifos;
+    zx_status_t status = eth_get_queue_fifos_locked(edev, queue, cpu, &fifos);
+    return REPLY(GetQueueFifos)(txn, status, &fifos);
+}
+
+static zx_status_t fidl_SetRss_locked(void* ctx, const zircon_ethernet_RssConfig* config,
+                                      fidl_txn_t* txn) {
+    ethdev_t* edev = ctx;
+    return REPLY(SetRss)(txn, eth_set_rss_locked(edev, config));
+}
+
+static zx_status_t fidl_SetInterruptModeration_locked(
+        void* ctx, const zircon_ethernet_InterruptModeration* moderation, fidl_txn_t* txn) {
+    ethdev_t* edev = ctx;
+    ethdev0_t* edev0 = edev->edev0;
+    if (moderation->min_interval_us > moderation->max_interval_us) {
+        return REPLY(SetInterruptModeration)(txn, ZX_ERR_INVALID_ARGS);
+    }
+    ethmac_intr_moderation_t config = {
+        .min_interval_us = moderation->min_interval_us,
+        .max_interval_us = moderation->max_interval_us,
+    };
+    zx_status_t status = edev0->mac.ops->set_param(edev0->mac.ctx,
+                                                   ETHMAC_SETPARAM_INTR_MODERATION, 0, &config);
+    return REPLY(SetInterruptModeration)(txn, status);
+}
+
+static zx_status_t fidl_GetQueueStats_locked(void* ctx, uint32_t queue, fidl_txn_t* txn) {
+    ethdev_t* edev = ctx;
+    ethdev0_t* edev0 = edev->edev0;
+    zircon_ethernet_QueueStats stats = {};
+    zx_status_t status = ZX_ERR_NOT_SUPPORTED;
+    if (queue >= edev0->num_queues) {
+        status = ZX_ERR_OUT_OF_RANGE;
+    } else if (edev0->mac.ops->get_queue_stats != NULL) {
+        ethmac_queue_stats_t mac_stats = {};
+        status = edev0->mac.ops->get_queue_stats(edev0->mac.ctx, queue, &mac_stats);
+        stats.interrupts = mac_stats.interrupts;
+        stats.rx_packets = mac_stats.rx_packets;
+        stats.tx_packets = mac_stats.tx_packets;
+        stats.interval_us = mac_stats.interval_us;
+    }
+    return REPLY(GetQueueStats)(txn, status, &stats);
+}
+
 #undef REPLY
 
 zircon_ethernet_Device_ops_t fidl_ops = {
@@ -847,6 +1464,11 @@ zircon_ethernet_Device_ops_t fidl_ops = {
     .ConfigMulticastSetPromiscuousMode = fidl_ConfigMulticastSetPromiscuousMode_locked,
     .ConfigMulticastTestFilter = fidl_ConfigMulticastTestFilter_locked,
     .DumpRegisters = fidl_DumpRegisters_locked,
+    .GetQueueCount = fidl_GetQueueCount_locked,
+    .GetQueueFifos = fidl_GetQueueFifos_locked,
+    .SetRss = fidl_SetRss_locked,
+    .SetInterruptModeration = fidl_SetInterruptModeration_locked,
+    .GetQueueStats = fidl_GetQueueStats_locked,
 };
 
 static zx_status_t eth_message(void* ctx, fidl_msg_t* msg, fidl_txn_t* txn) {
@@ -865,37 +1487,42 @@ static void eth_kill_locked(ethdev_t* edev) {
         return;
     }
 
-    zxlogf(TRACE, "eth [%s]: kill: tearing down%s\n",
-           edev->name, (edev->state & ETHDEV_TX_THREAD) ? " tx thread" : "");
+    zxlogf(TRACE, "eth [%s]: kill: tearing down\n", edev->name);
     eth_set_promisc_locked(edev, false);
 
     // make sure any future ioctls or other ops will fail
     edev->state |= ETHDEV_DEAD;
+    eth_update_rx_direct_locked(edev->edev0);
 
     // try to convince clients to close us
-    if (edev->rx_fifo) {
-        zx_handle_close(edev->rx_fifo);
-        edev->rx_fifo = ZX_HANDLE_INVALID;
-    }
-    if (edev->tx_fifo) {
-        // Ask the TX thread to exit.
-        zx_object_signal(edev->tx_fifo, 0, kSignalFifoTerminate);
+    for (size_t i = 0; i < countof(edev->queues); i++) {
+        eth_queue_t* q = &edev->queues[i];
+        if (q->rx_fifo) {
+            zx_handle_close(q->rx_fifo);
+            q->rx_fifo = ZX_HANDLE_INVALID;
+        }
+        if (q->tx_fifo) {
+            // Ask the TX thread to exit.
+            zx_object_signal(q->tx_fifo, 0, kSignalFifoTerminate);
+        }
     }
     if (edev->io_vmo) {
         zx_handle_close(edev->io_vmo);
         edev->io_vmo = ZX_HANDLE_INVALID;
     }
 
-    if (edev->state & ETHDEV_TX_THREAD) {
-        edev->state &= (~ETHDEV_TX_THREAD);
-        int ret;
-        thrd_join(edev->tx_thr, &ret);
-        zxlogf(TRACE, "eth [%s]: kill: tx thread exited\n", edev->name);
-    }
-
-    if (edev->tx_fifo) {
-        zx_handle_close(edev->tx_fifo);
-        edev->tx_fifo = ZX_HANDLE_INVALID;
+    for (size_t i = 0; i < countof(edev->queues); i++) {
+        eth_queue_t* q = &edev->queues[i];
+        if (q->tx_thread_created) {
+            q->tx_thread_created = false;
+            int ret;
+            thrd_join(q->tx_thr, &ret);
+            zxlogf(TRACE, "eth [%s]: kill: tx thread %u exited\n", edev->name, q->index);
+        }
+        if (q->tx_fifo) {
+            zx_handle_close(q->tx_fifo);
+            q->tx_fifo = ZX_HANDLE_INVALID;
+        }
     }
 
     if (edev->io_buf) {
@@ -951,11 +1578,22 @@ static zx_status_t eth0_open(void* ctx, zx_device_t** out, uint32_t flags) {
     }
     edev->edev0 = edev0;
 
+    for (uint32_t i = 0; i < countof(edev->queues); i++) {
+        edev->queues[i].edev = edev;
+        edev->queues[i].index = i;
+    }
+
     list_initialize(&edev->free_tx_bufs);
     for (size_t ndx = 0; ndx < FIFO_DEPTH; ndx++) {
         edev->all_tx_bufs[ndx].edev = edev;
         list_add_tail(&edev->free_tx_bufs, &edev->all_tx_bufs[ndx].netbuf.node);
     }
+    list_initialize(&edev->free_rx_bufs);
+    list_initialize(&edev->pending_rx_bufs);
+    for (size_t ndx = 0; ndx < FIFO_DEPTH; ndx++) {
+        edev->all_rx_bufs[ndx].edev = edev;
+        list_add_tail(&edev->free_rx_bufs, &edev->all_rx_bufs[ndx].netbuf.node);
+    }
     mtx_init(&edev->lock, mtx_plain);
 
     device_add_args_t args = {
@@ -1040,7 +1678,7 @@ static zx_status_t eth_bind(void* ctx, zx_device_t* dev) {
         goto fail;
     }
 
-    if ((edev0->info.features & ETHMAC_FEATURE_DMA) &&
+    if ((edev0->info.features & (ETHMAC_FEATURE_DMA | ETHMAC_FEATURE_RX_BUFFERS)) &&
         (ops->get_bti == NULL)) {
         zxlogf(ERROR, "eth: bind: device '%s': does not implement ops->get_bti()\n",
                device_get_name(dev));
@@ -1048,6 +1686,21 @@ static zx_status_t eth_bind(void* ctx, zx_device_t* dev) {
         goto fail;
     }
 
+    if ((edev0->info.features & ETHMAC_FEATURE_RX_BUFFERS) && (ops->queue_rx == NULL)) {
+        zxlogf(ERROR, "eth: bind: device '%s': does not implement ops->queue_rx()\n",
+               device_get_name(dev));
+        status = ZX_ERR_NOT_SUPPORTED;
+        goto fail;
+    }
+
+    edev0->num_queues = 1;
+    if ((edev0->info.features & ETHMAC_FEATURE_MULTIQUEUE) && edev0->info.num_queues > 1) {
+        edev0->num_queues = edev0->info.num_queues;
+        if (edev0->num_queues > zircon_ethernet_MAX_QUEUES) {
+            edev0->num_queues = zircon_ethernet_MAX_QUEUES;
+        }
+    }
+
     mtx_init(&edev0->lock, mtx_plain);
     list_initialize(&edev0->list_active);
     list_initialize(&edev0->list_idle);
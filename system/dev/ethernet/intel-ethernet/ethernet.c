@@ -24,6 +24,13 @@
 typedef zx_status_t status_t;
 #include "ie.h"
 
+// How often adaptive interrupt moderation samples the packet rate, and the
+// rate at which it spaces interrupts the furthest apart.
+#define ETH_MODERATION_PERIOD ZX_MSEC(100)
+#define ETH_MODERATION_BULK_PPS 100000
+// The widest spacing of interrupts every supported device can be set to.
+#define ETH_MAX_IRQ_INTERVAL_US 4095
+
 typedef enum {
     ETH_RUNNING = 0,
     ETH_SUSPENDING,
@@ -46,8 +53,50 @@ typedef struct ethernet_device {
     // callback interface to attached ethernet layer
     ethmac_ifc_t* ifc;
     void* cookie;
+
+    // interrupt moderation, which moves irq_interval_us between the bounds
+    // of |moderation| with the packet rate seen since |moderation_start|
+    ethmac_intr_moderation_t moderation;
+    uint32_t irq_interval_us;
+    zx_time_t moderation_start;
+    uint64_t moderation_packets;
+
+    uint64_t interrupts;
+    uint64_t rx_packets;
 } ethernet_device_t;
 
+static void eth_set_irq_interval_locked(ethernet_device_t* edev, uint32_t interval_us) {
+    if (interval_us != edev->irq_interval_us) {
+        eth_set_irq_interval(&edev->eth, interval_us);
+        edev->irq_interval_us = interval_us;
+    }
+}
+
+// Spaces interrupts further apart the more packets the device has handled
+// over the last ETH_MODERATION_PERIOD.
+static void eth_moderate_irqs_locked(ethernet_device_t* edev) {
+    const ethmac_intr_moderation_t* m = &edev->moderation;
+    if (m->min_interval_us == m->max_interval_us) {
+        return;
+    }
+    zx_time_t now = zx_clock_get_monotonic();
+    zx_duration_t elapsed = now - edev->moderation_start;
+    if (elapsed < ETH_MODERATION_PERIOD) {
+        return;
+    }
+    uint64_t packets = edev->rx_packets + edev->eth.tx_frames;
+    uint64_t pps = (packets - edev->moderation_packets) * ZX_SEC(1) / elapsed;
+    if (pps > ETH_MODERATION_BULK_PPS) {
+        pps = ETH_MODERATION_BULK_PPS;
+    }
+    edev->moderation_start = now;
+    edev->moderation_packets = packets;
+
+    uint32_t range = m->max_interval_us - m->min_interval_us;
+    eth_set_irq_interval_locked(edev, m->min_interval_us +
+                                      (uint32_t)(range * pps / ETH_MODERATION_BULK_PPS));
+}
+
 static int irq_thread(void* arg) {
     ethernet_device_t* edev = arg;
     for (;;) {
@@ -58,14 +107,24 @@ static int irq_thread(void* arg) {
             break;
         }
         mtx_lock(&edev->lock);
+        edev->interrupts++;
         unsigned irq = eth_handle_irq(&edev->eth);
         if (irq & ETH_IRQ_RX) {
             void* data;
             size_t len;
-
-            while (eth_rx(&edev->eth, &data, &len) == ZX_OK) {
+            bool csum_valid;
+
+            while (eth_rx(&edev->eth, &data, &len, &csum_valid) == ZX_OK) {
+                edev->rx_packets++;
+                uint32_t flags = csum_valid ? ETHMAC_RX_CSUM_VALID : 0;
+                if (edev->eth.rx_direct) {
+                    // The netbuf's slot is free once acked, for eth_queue_rx() to reuse.
+                    eth_rx_ack(&edev->eth);
+                    edev->ifc->complete_rx(edev->cookie, data, len, flags);
+                    continue;
+                }
                 if (edev->ifc && (edev->state == ETH_RUNNING)) {
-                    edev->ifc->recv(edev->cookie, data, len, 0);
+                    edev->ifc->recv(edev->cookie, data, len, flags);
                 }
                 eth_rx_ack(&edev->eth);
             }
@@ -81,6 +140,7 @@ static int irq_thread(void* arg) {
                 }
             }
         }
+        eth_moderate_irqs_locked(edev);
         mtx_unlock(&edev->lock);
     }
     return 0;
@@ -95,6 +155,7 @@ static zx_status_t eth_query(void* ctx, uint32_t options, ethmac_info_t* info) {
 
     memset(info, 0, sizeof(*info));
     ZX_DEBUG_ASSERT(ETH_TXBUF_SIZE >= ETH_MTU);
+    info->features = ETHMAC_FEATURE_TX_CSUM | ETHMAC_FEATURE_RX_CSUM | ETHMAC_FEATURE_RX_BUFFERS;
     info->mtu = ETH_MTU;
     memcpy(info->mac, edev->eth.mac, sizeof(edev->eth.mac));
 
@@ -125,13 +186,72 @@ static zx_status_t eth_start(void* ctx, ethmac_ifc_t* ifc, void* cookie) {
     return status;
 }
 
-static zx_status_t eth_queue_tx(void* ctx, uint32_t options, ethmac_netbuf_t* netbuf) {
+static void eth_queue_tx_batch(void* ctx, uint32_t options, ethmac_netbuf_t** netbufs,
+                               size_t count, zx_status_t* statuses) {
     ethernet_device_t* edev = ctx;
     if (edev->state != ETH_RUNNING) {
-        return ZX_ERR_BAD_STATE;
+        for (size_t i = 0; i < count; i++) {
+            statuses[i] = ZX_ERR_BAD_STATE;
+        }
+        return;
+    }
+    // No more frames than the ring holds can be queued at once.
+    eth_tx_frame_t frames[ETH_TXBUF_COUNT];
+    while (count > 0) {
+        size_t n = count < ETH_TXBUF_COUNT ? count : ETH_TXBUF_COUNT;
+        for (size_t i = 0; i < n; i++) {
+            frames[i].data = netbufs[i]->data;
+            frames[i].len = netbufs[i]->len;
+            frames[i].needs_csum = netbufs[i]->flags & ETHMAC_NETBUF_NEEDS_CSUM;
+            frames[i].csum_start = netbufs[i]->csum_start;
+            frames[i].csum_offset = netbufs[i]->csum_offset;
+        }
+        eth_tx_batch(&edev->eth, frames, n, statuses);
+        netbufs += n;
+        statuses += n;
+        count -= n;
     }
+}
+
+static zx_status_t eth_queue_tx(void* ctx, uint32_t options, ethmac_netbuf_t* netbuf) {
     // TODO: Add support for DMA directly from netbuf
-    return eth_tx(&edev->eth, netbuf->data, netbuf->len);
+    zx_status_t status;
+    eth_queue_tx_batch(ctx, options, &netbuf, 1, &status);
+    return status;
+}
+
+static zx_status_t eth_queue_rx(void* ctx, uint32_t options, ethmac_netbuf_t* netbuf) {
+    ethernet_device_t* edev = ctx;
+    // The hw writes up to a whole buffer's worth of any frame.
+    if (netbuf->len < ETH_RXBUF_SIZE) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+    zx_status_t status = ZX_ERR_BAD_STATE;
+    mtx_lock(&edev->lock);
+    if (edev->eth.rx_direct) {
+        status = eth_rx_queue(&edev->eth, netbuf->phys, netbuf);
+    }
+    mtx_unlock(&edev->lock);
+    return status;
+}
+
+static zx_status_t eth_get_queue_stats(void* ctx, uint32_t queue, ethmac_queue_stats_t* stats) {
+    ethernet_device_t* edev = ctx;
+    if (queue != 0) {
+        return ZX_ERR_OUT_OF_RANGE;
+    }
+    mtx_lock(&edev->lock);
+    stats->interrupts = edev->interrupts;
+    stats->rx_packets = edev->rx_packets;
+    stats->tx_packets = edev->eth.tx_frames;
+    stats->interval_us = edev->irq_interval_us;
+    mtx_unlock(&edev->lock);
+    return ZX_OK;
+}
+
+static zx_handle_t eth_get_bti(void* ctx) {
+    ethernet_device_t* edev = ctx;
+    return edev->btih;
 }
 
 static zx_status_t eth_set_param(void *ctx, uint32_t param, int32_t value, void* data) {
@@ -149,6 +269,38 @@ static zx_status_t eth_set_param(void *ctx, uint32_t param, int32_t value, void*
         }
         status = ZX_OK;
         break;
+    case ETHMAC_SETPARAM_DUMP_REGS:
+        eth_dump_regs(&edev->eth);
+        status = ZX_OK;
+        break;
+    case ETHMAC_SETPARAM_INTR_MODERATION: {
+        ethmac_intr_moderation_t* m = data;
+        edev->moderation = *m;
+        if (edev->moderation.max_interval_us > ETH_MAX_IRQ_INTERVAL_US) {
+            edev->moderation.max_interval_us = ETH_MAX_IRQ_INTERVAL_US;
+        }
+        if (edev->moderation.min_interval_us > edev->moderation.max_interval_us) {
+            edev->moderation.min_interval_us = edev->moderation.max_interval_us;
+        }
+        edev->moderation_start = zx_clock_get_monotonic();
+        edev->moderation_packets = edev->rx_packets + edev->eth.tx_frames;
+        eth_set_irq_interval_locked(edev, edev->moderation.min_interval_us);
+        status = ZX_OK;
+        break;
+    }
+    case ETHMAC_SETPARAM_RX_BUFFERS:
+        if ((bool)value) {
+            eth_rx_direct_start(&edev->eth);
+        } else {
+            void* cookies[ETH_RXBUF_COUNT];
+            size_t count;
+            eth_rx_direct_stop(&edev->eth, cookies, &count);
+            for (size_t i = 0; i < count; i++) {
+                edev->ifc->complete_rx(edev->cookie, cookies[i], 0, 0);
+            }
+        }
+        status = ZX_OK;
+        break;
     default:
         status = ZX_ERR_NOT_SUPPORTED;
     }
@@ -163,6 +315,10 @@ static ethmac_protocol_ops_t ethmac_ops = {
     .start = eth_start,
     .queue_tx = eth_queue_tx,
     .set_param = eth_set_param,
+    .get_bti = eth_get_bti,
+    .queue_tx_batch = eth_queue_tx_batch,
+    .queue_rx = eth_queue_rx,
+    .get_queue_stats = eth_get_queue_stats,
 };
 
 static zx_status_t eth_suspend(void* ctx, uint32_t flags) {
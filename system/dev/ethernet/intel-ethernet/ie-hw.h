@@ -19,6 +19,8 @@
 #define IE_ICS       0x00c8 // Interrupt Cause Set
 #define IE_IMS       0x00d0 // Interrupt Mask Set / Read
 #define IE_IMC       0x00d8 // Interrupt Mask Clear
+#define IE_ITR       0x00c4 // Interrupt Throttling Rate
+#define IE_EITR(n)   (0x1680 + ((n) * 4)) // Extended Interrupt Throttle (I211)
 
 #define IE_RCTL      0x0100 // Receive Control
 #define IE_RDBAL     0x2800 // RX Descriptor Base Low
@@ -116,6 +118,12 @@
 #define IE_RCTL_BSEX      (1u << 25) // Buffer Size Extension (x16)
 #define IE_RCTL_SECRC     (1u << 26) // Strip CRC Field
 
+#define IE_ITR_INTERVAL(us)  (((us) * 4) & 0xffff)   // in 256ns units
+#define IE_EITR_INTERVAL(us) (((us) & 0xfff) << 2)   // in 1us units
+
+#define IE_RXCSUM_IPOFL   (1u << 8) // IP Checksum Offload Enable
+#define IE_RXCSUM_TUOFL   (1u << 9) // TCP/UDP Checksum Offload Enable
+
 #define IE_TCTL_RESERVED  ((1u << 2) | (1u << 23) | (0xfu << 25) | (1u << 31))
 #define IE_TCTL_RST       (1u << 0) // TX Reset?
 #define IE_TCTL_EN        (1u << 1) // TX Enable
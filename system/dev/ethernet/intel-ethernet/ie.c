@@ -39,6 +39,7 @@ void eth_dump_regs(ethdev_t* eth) {
            readl(IE_TCTL), readl(IE_TDLEN), readl(IE_TDH), readl(IE_TDT));
     printf("TXDC %08x TIDV %08x TBH %08x TBL %08x\n",
            readl(IE_TXDCTL), readl(IE_TIDV), readl(IE_TDBAH), readl(IE_TDBAL));
+    printf("TX %" PRIu64 " frames in %" PRIu64 " tail writes\n", eth->tx_frames, eth->tx_doorbells);
 }
 
 unsigned eth_handle_irq(ethdev_t* eth) {
@@ -46,11 +47,19 @@ unsigned eth_handle_irq(ethdev_t* eth) {
     return readl(IE_ICR);
 }
 
+void eth_set_irq_interval(ethdev_t* eth, uint32_t interval_us) {
+    if (eth->pci_did == IE_DID_I211_AT) {
+        writel(IE_EITR_INTERVAL(interval_us), IE_EITR(0));
+    } else {
+        writel(IE_ITR_INTERVAL(interval_us), IE_ITR);
+    }
+}
+
 bool eth_status_online(ethdev_t* eth) {
     return readl(IE_STATUS) & IE_STATUS_LU;
 }
 
-status_t eth_rx(ethdev_t* eth, void** data, size_t* len) {
+status_t eth_rx(ethdev_t* eth, void** data, size_t* len, bool* csum_valid) {
     uint32_t n = eth->rx_rd_ptr;
     uint64_t info = eth->rxd[n].info;
 
@@ -61,8 +70,10 @@ status_t eth_rx(ethdev_t* eth, void** data, size_t* len) {
     // copy out packet
     zx_status_t r = IE_RXD_LEN(info);
 
-    *data = eth->rxb + ETH_RXBUF_SIZE * n;
+    *data = eth->rx_direct ? eth->rx_cookies[n] : eth->rxb + ETH_RXBUF_SIZE * n;
     *len = r;
+    *csum_valid = (info & IE_RXD_TCPCS) &&
+                  !(info & (IE_RXD_IXSM | IE_RXD_TCPE | IE_RXD_IPE));
 
     return ZX_OK;
 }
@@ -70,13 +81,69 @@ status_t eth_rx(ethdev_t* eth, void** data, size_t* len) {
 void eth_rx_ack(ethdev_t* eth) {
     uint32_t n = eth->rx_rd_ptr;
 
-    // make buffer available to hw
     eth->rxd[n].info = 0;
-    writel(n, IE_RDT);
+    if (!eth->rx_direct) {
+        // make buffer available to hw
+        writel(n, IE_RDT);
+    }
     n = (n + 1) & (ETH_RXBUF_COUNT - 1);
     eth->rx_rd_ptr = n;
 }
 
+// Rewrites the rx ring with the driver's own buffers, or empty if |direct|,
+// with the receiver disabled.
+static void rx_reset_ring(ethdev_t* eth, bool direct) {
+    uint32_t rctl = readl(IE_RCTL);
+    writel(rctl & ~IE_RCTL_EN, IE_RCTL);
+    // let a frame already being received land before the ring is rewritten
+    usleep(1000);
+
+    memset(eth->rxd, 0, sizeof(ie_rxd_t) * ETH_RXBUF_COUNT);
+    if (!direct) {
+        for (int n = 0; n < ETH_RXBUF_COUNT; n++) {
+            eth->rxd[n].addr = eth->rxb_phys + ETH_RXBUF_SIZE * n;
+        }
+    }
+    eth->rx_direct = direct;
+    eth->rx_rd_ptr = 0;
+    eth->rx_wr_ptr = 0;
+    writel(0, IE_RDH);
+    writel(direct ? 0 : ETH_RXBUF_COUNT - 1, IE_RDT);
+    writel(rctl, IE_RCTL);
+}
+
+void eth_rx_direct_start(ethdev_t* eth) {
+    if (!eth->rx_direct) {
+        rx_reset_ring(eth, true);
+    }
+}
+
+void eth_rx_direct_stop(ethdev_t* eth, void** cookies, size_t* count) {
+    *count = 0;
+    if (!eth->rx_direct) {
+        return;
+    }
+    for (uint32_t n = eth->rx_rd_ptr; n != eth->rx_wr_ptr; n = (n + 1) & (ETH_RXBUF_COUNT - 1)) {
+        cookies[(*count)++] = eth->rx_cookies[n];
+    }
+    rx_reset_ring(eth, false);
+}
+
+status_t eth_rx_queue(ethdev_t* eth, uint64_t phys, void* cookie) {
+    uint32_t n = eth->rx_wr_ptr;
+    uint32_t next = (n + 1) & (ETH_RXBUF_COUNT - 1);
+    // the hw takes a full ring for an empty one
+    if (next == eth->rx_rd_ptr) {
+        return ZX_ERR_SHOULD_WAIT;
+    }
+    eth->rxd[n].addr = phys;
+    eth->rxd[n].info = 0;
+    eth->rx_cookies[n] = cookie;
+    eth->rx_wr_ptr = next;
+    writel(next, IE_RDT);
+    return ZX_OK;
+}
+
 void eth_enable_rx(ethdev_t* eth) {
     uint32_t rctl = readl(IE_RCTL);
     writel(rctl | IE_RCTL_EN, IE_RCTL);
@@ -106,44 +173,99 @@ static void reap_tx_buffers(ethdev_t* eth) {
     eth->tx_rd_ptr = n;
 }
 
-status_t eth_tx(ethdev_t* eth, const void* data, size_t len) {
+// Stores the ones' complement checksum of the |len| bytes of |data| at |csum|,
+// which lies within them and holds the sum of the protocol's pseudo-header.
+static void tx_checksum(uint8_t* data, size_t len, uint8_t* csum) {
+    uint32_t sum = 0;
+    for (size_t i = 0; i + 1 < len; i += 2) {
+        sum += (data[i] << 8) | data[i + 1];
+    }
+    if (len & 1) {
+        sum += data[len - 1] << 8;
+    }
+    while (sum >> 16) {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+    sum = ~sum & 0xffff;
+    csum[0] = sum >> 8;
+    csum[1] = sum & 0xff;
+}
+
+// Copies a frame into a free tx buffer and sets up its descriptor, without
+// informing the hardware of it.
+static status_t tx_enqueue_locked(ethdev_t* eth, const eth_tx_frame_t* tx) {
+    size_t len = tx->len;
     if (len > ETH_TXBUF_DSIZE) {
         printf("intel-eth: unsupported packet length %zu\n", len);
         return ZX_ERR_INVALID_ARGS;
     }
-
-    zx_status_t status = ZX_OK;
-
-    mtx_lock(&eth->send_lock);
-
-    reap_tx_buffers(eth);
+    size_t cso = (size_t)tx->csum_start + tx->csum_offset;
+    if (tx->needs_csum && cso + 2 > len) {
+        return ZX_ERR_INVALID_ARGS;
+    }
 
     // obtain buffer, copy into it, setup descriptor
     framebuf_t *frame = list_remove_head_type(&eth->free_frames, framebuf_t, node);
     if (frame == NULL) {
-        status = ZX_ERR_NO_RESOURCES;
-        goto out;
+        return ZX_ERR_NO_RESOURCES;
     }
 
     uint32_t n = eth->tx_wr_ptr;
-    memcpy(frame->data, data, len);
+    memcpy(frame->data, tx->data, len);
+    uint64_t csum = 0;
+    if (tx->needs_csum) {
+        // The descriptor only has room for offsets within the first 256 bytes.
+        if (cso <= 0xff) {
+            csum = IE_TXD_IC | IE_TXD_CSS(tx->csum_start) | IE_TXD_CSO(cso);
+        } else {
+            uint8_t* bytes = frame->data;
+            tx_checksum(bytes + tx->csum_start, len - tx->csum_start, bytes + cso);
+        }
+    }
     // Pad out short packets.
     if (len < 60) {
       memset(frame->data + len, 0, 60 - len);
       len = 60;
     }
     eth->txd[n].addr = frame->phys;
-    eth->txd[n].info = IE_TXD_LEN(len) | IE_TXD_EOP | IE_TXD_IFCS | IE_TXD_RS;
+    eth->txd[n].info = IE_TXD_LEN(len) | IE_TXD_EOP | IE_TXD_IFCS | IE_TXD_RS | csum;
     list_add_tail(&eth->busy_frames, &frame->node);
 
+    eth->tx_wr_ptr = (n + 1) & (ETH_TXBUF_COUNT - 1);
+    return ZX_OK;
+}
+
+status_t eth_tx(ethdev_t* eth, const void* data, size_t len) {
+    eth_tx_frame_t frame = {
+        .data = data,
+        .len = len,
+    };
+    status_t status;
+    eth_tx_batch(eth, &frame, 1, &status);
+    return status;
+}
+
+void eth_tx_batch(ethdev_t* eth, const eth_tx_frame_t* frames, size_t count, status_t* statuses) {
+    mtx_lock(&eth->send_lock);
+
+    reap_tx_buffers(eth);
+
+    uint32_t queued = 0;
+    for (size_t i = 0; i < count; i++) {
+        statuses[i] = tx_enqueue_locked(eth, &frames[i]);
+        if (statuses[i] == ZX_OK) {
+            queued++;
+        }
+    }
+
     // inform hw of buffer availability
-    n = (n + 1) & (ETH_TXBUF_COUNT - 1);
-    eth->tx_wr_ptr = n;
-    writel(n, IE_TDT);
+    if (queued > 0) {
+        writel(eth->tx_wr_ptr, IE_TDT);
+        eth->tx_doorbells++;
+        eth->tx_frames += queued;
+    }
 
-out:
     mtx_unlock(&eth->send_lock);
-    return status;
 }
 
 // Returns the number of Tx packets in the hw queue
@@ -356,6 +478,7 @@ void eth_init_hw(ethdev_t* eth) {
     }
 
     writel(ETH_RXBUF_COUNT - 1, IE_RDT);
+    writel(readl(IE_RXCSUM) | IE_RXCSUM_IPOFL | IE_RXCSUM_TUOFL, IE_RXCSUM);
     writel(IE_RCTL_BSIZE2048 | IE_RCTL_DPF | IE_RCTL_SECRC |
            IE_RCTL_BAM | IE_RCTL_MPE | IE_RCTL_EN,
            IE_RCTL);
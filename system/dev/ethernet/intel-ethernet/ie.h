@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <stdbool.h>
 #include <threads.h>
 
 #include "ie-hw.h"
@@ -13,6 +14,23 @@
 
 typedef struct framebuf framebuf_t;
 typedef struct ethdev ethdev_t;
+typedef struct eth_tx_frame eth_tx_frame_t;
+
+#define ETH_MTU 1500
+
+#define ETH_RXBUF_SIZE  2048
+#define ETH_RXBUF_COUNT 32
+
+#define ETH_TXBUF_SIZE  2048
+#define ETH_TXBUF_COUNT 32
+#define ETH_TXBUF_HSIZE 128
+#define ETH_TXBUF_DSIZE (ETH_TXBUF_SIZE - ETH_TXBUF_HSIZE)
+
+#define ETH_DRING_SIZE 2048
+
+#define ETH_ALLOC ((ETH_RXBUF_SIZE * ETH_RXBUF_COUNT) + \
+                   (ETH_TXBUF_SIZE * ETH_TXBUF_COUNT) + \
+                   (ETH_DRING_SIZE * 2))
 
 struct framebuf {
     list_node_t node;
@@ -32,6 +50,12 @@ struct ethdev {
     uint32_t tx_rd_ptr;
     uint32_t rx_rd_ptr;
 
+    // While |rx_direct|, the rx ring holds the buffers queued by eth_rx_queue()
+    // up to |rx_wr_ptr|, rather than the driver's own.
+    bool rx_direct;
+    uint32_t rx_wr_ptr;
+    void* rx_cookies[ETH_RXBUF_COUNT];
+
     list_node_t free_frames;
     list_node_t busy_frames;
 
@@ -48,24 +72,22 @@ struct ethdev {
     uint8_t phy_addr;
     mtx_t send_lock;
 
+    // writes of the tx tail register, and the frames they handed to the hw
+    uint64_t tx_doorbells;
+    uint64_t tx_frames;
+
     uint16_t pci_did;
 };
 
-#define ETH_MTU 1500
-
-#define ETH_RXBUF_SIZE  2048
-#define ETH_RXBUF_COUNT 32
-
-#define ETH_TXBUF_SIZE  2048
-#define ETH_TXBUF_COUNT 32
-#define ETH_TXBUF_HSIZE 128
-#define ETH_TXBUF_DSIZE (ETH_TXBUF_SIZE - ETH_TXBUF_HSIZE)
-
-#define ETH_DRING_SIZE 2048
-
-#define ETH_ALLOC ((ETH_RXBUF_SIZE * ETH_RXBUF_COUNT) + \
-                   (ETH_TXBUF_SIZE * ETH_TXBUF_COUNT) + \
-                   (ETH_DRING_SIZE * 2))
+// A frame to transmit. If |needs_csum| is set, the hw stores the checksum of
+// its bytes from |csum_start| on at |csum_start| + |csum_offset|.
+struct eth_tx_frame {
+    const void* data;
+    size_t len;
+    bool needs_csum;
+    uint16_t csum_start;
+    uint16_t csum_offset;
+};
 
 status_t eth_reset_hw(ethdev_t* eth);
 void eth_setup_buffers(ethdev_t* eth, void* iomem, uintptr_t iophys);
@@ -73,12 +95,27 @@ void eth_init_hw(ethdev_t* eth);
 
 void eth_dump_regs(ethdev_t* eth);
 
-status_t eth_rx(ethdev_t* eth, void** data, size_t* len);
+// |csum_valid| is set if the hw verified the frame's TCP or UDP checksum.
+// While rx_direct, |data| is the cookie of the buffer the frame is in instead.
+status_t eth_rx(ethdev_t* eth, void** data, size_t* len, bool* csum_valid);
 void eth_rx_ack(ethdev_t* eth);
+
+// Switches the rx ring to the buffers queued by eth_rx_queue(), dropping any
+// frames received into the driver's own which weren't yet acked.
+void eth_rx_direct_start(ethdev_t* eth);
+// Switches the rx ring back to the driver's own buffers, storing the cookies of
+// the queued buffers still in it in |cookies|, and their number in |count|.
+void eth_rx_direct_stop(ethdev_t* eth, void** cookies, size_t* count);
+// Queues the buffer of at least ETH_RXBUF_SIZE bytes at |phys| to receive a
+// frame into. Returns ZX_ERR_SHOULD_WAIT if the ring is full.
+status_t eth_rx_queue(ethdev_t* eth, uint64_t phys, void* cookie);
 void eth_enable_rx(ethdev_t* eth);
 void eth_disable_rx(ethdev_t* eth);
 
 status_t eth_tx(ethdev_t* eth, const void* data, size_t len);
+// Queues the |count| frames of |frames| with a single write of the tx tail
+// register, storing the status of each in |statuses|.
+void eth_tx_batch(ethdev_t* eth, const eth_tx_frame_t* frames, size_t count, status_t* statuses);
 size_t eth_tx_queued(ethdev_t* eth);
 void eth_enable_tx(ethdev_t* eth);
 void eth_disable_tx(ethdev_t* eth);
@@ -94,3 +131,5 @@ bool eth_status_online(ethdev_t* eth);
 #define ETH_IRQ_RX IE_INT_RXT0
 #define ETH_IRQ_LSC IE_INT_LSC
 unsigned eth_handle_irq(ethdev_t* eth);
+// Has the hw wait at least |interval_us| between interrupts; 0 doesn't.
+void eth_set_irq_interval(ethdev_t* eth, uint32_t interval_us);
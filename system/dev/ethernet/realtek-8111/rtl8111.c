@@ -15,6 +15,7 @@
 
 #include <zircon/types.h>
 
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -32,6 +33,11 @@
 #define HI32(val) (((val) >> 32) & 0xffffffff)
 #define LO32(val) ((val) & 0xffffffff)
 
+// How often adaptive interrupt moderation samples the packet rate, and the rate at which it
+// delays interrupts the longest.
+#define MODERATION_PERIOD ZX_MSEC(100)
+#define MODERATION_BULK_PPS 100000
+
 typedef struct eth_desc {
     uint32_t status1;
     uint32_t status2;
@@ -65,8 +71,64 @@ typedef struct ethernet_device {
 
     ethmac_ifc_t* ifc;
     void* cookie;
+
+    // tx polling requests, and the frames they handed to the hardware
+    uint64_t tx_polls;
+    uint64_t tx_frames;
+
+    // interrupt moderation, which moves irq_interval_us between the bounds of |moderation| with
+    // the packet rate seen since |moderation_start|
+    ethmac_intr_moderation_t moderation;
+    uint32_t irq_interval_us;
+    zx_time_t moderation_start;
+    uint64_t moderation_packets;
+
+    uint64_t interrupts;
+    uint64_t rx_packets;
 } ethernet_device_t;
 
+static void rtl8111_set_irq_interval_locked(ethernet_device_t* edev, uint32_t interval_us) {
+    if (interval_us == edev->irq_interval_us) {
+        return;
+    }
+    uint32_t units = (interval_us + RTL_INTRMITIGATE_UNIT_US - 1) / RTL_INTRMITIGATE_UNIT_US;
+    if (units > 0xf) {
+        units = 0xf;
+    }
+    uint16_t mitigate = 0;
+    if (units > 0) {
+        mitigate = RTL_INTRMITIGATE_TX_TIMER(units) | RTL_INTRMITIGATE_TX_PKTS(0xf) |
+                   RTL_INTRMITIGATE_RX_TIMER(units) | RTL_INTRMITIGATE_RX_PKTS(0xf);
+    }
+    WRITE16(RTL_INTRMITIGATE, mitigate);
+    edev->irq_interval_us = interval_us;
+}
+
+// Delays interrupts the longer the more packets the device has handled over the last
+// MODERATION_PERIOD.
+static void rtl8111_moderate_irqs_locked(ethernet_device_t* edev) {
+    const ethmac_intr_moderation_t* m = &edev->moderation;
+    if (m->min_interval_us == m->max_interval_us) {
+        return;
+    }
+    zx_time_t now = zx_clock_get_monotonic();
+    zx_duration_t elapsed = now - edev->moderation_start;
+    if (elapsed < MODERATION_PERIOD) {
+        return;
+    }
+    uint64_t packets = edev->rx_packets + edev->tx_frames;
+    uint64_t pps = (packets - edev->moderation_packets) * ZX_SEC(1) / elapsed;
+    if (pps > MODERATION_BULK_PPS) {
+        pps = MODERATION_BULK_PPS;
+    }
+    edev->moderation_start = now;
+    edev->moderation_packets = packets;
+
+    uint32_t range = m->max_interval_us - m->min_interval_us;
+    rtl8111_set_irq_interval_locked(edev, m->min_interval_us +
+                                          (uint32_t)(range * pps / MODERATION_BULK_PPS));
+}
+
 static void rtl8111_init_buffers(ethernet_device_t* edev) {
     zxlogf(TRACE, "rtl8111: Initializing buffers\n");
     edev->txd_ring = io_buffer_virt(&edev->buffer);
@@ -164,6 +226,7 @@ static int irq_thread(void* arg) {
         }
 
         mtx_lock(&edev->lock);
+        edev->interrupts++;
 
         uint16_t isr = READ16(RTL_ISR);
         if (isr & RTL_INT_LINKCHG) {
@@ -183,6 +246,7 @@ static int irq_thread(void* arg) {
         if (isr & RTL_INT_ROK) {
             eth_desc_t* rxd;
             while (!((rxd = edev->rxd_ring + edev->rxd_idx)->status1 & RX_DESC_OWN)) {
+                edev->rx_packets++;
                 if (edev->ifc) {
                     size_t len = rxd->status1 & RX_DESC_LEN_MASK;
                     edev->ifc->recv(
@@ -199,6 +263,7 @@ static int irq_thread(void* arg) {
         }
 
         WRITE16(RTL_ISR, 0xffff);
+        rtl8111_moderate_irqs_locked(edev);
 
         mtx_unlock(&edev->lock);
     }
@@ -243,17 +308,24 @@ static zx_status_t rtl8111_start(void* ctx, ethmac_ifc_t* ifc, void* cookie) {
     return status;
 }
 
-static zx_status_t rtl8111_queue_tx(void* ctx, uint32_t options, ethmac_netbuf_t* netbuf) {
+// Copies a frame into the next tx descriptor, waiting for the hardware to give
+// it back if need be. Frames already queued by the caller are announced to the
+// hardware before waiting, so that it doesn't wait on them.
+static zx_status_t rtl8111_tx_locked(ethernet_device_t* edev, ethmac_netbuf_t* netbuf,
+                                     bool* pending) {
     size_t length = netbuf->len;
     if (length > ETH_BUF_SIZE) {
         zxlogf(ERROR, "rtl8111: Unsupported packet length %zu\n", length);
         return ZX_ERR_INVALID_ARGS;
     }
-    ethernet_device_t* edev = ctx;
-
-    mtx_lock(&edev->tx_lock);
 
     if (edev->txd_ring[edev->txd_idx].status1 & TX_DESC_OWN) {
+        if (*pending) {
+            WRITE8(RTL_TPPOLL, READ8(RTL_TPPOLL) | RTL_TPPOLL_NPQ);
+            edev->tx_polls++;
+            *pending = false;
+        }
+
         mtx_lock(&edev->lock);
         WRITE16(RTL_IMR, READ16(RTL_IMR) | RTL_INT_TOK);
         WRITE16(RTL_ISR, RTL_INT_TOK);
@@ -273,12 +345,34 @@ static zx_status_t rtl8111_queue_tx(void* ctx, uint32_t options, ethmac_netbuf_t
     edev->txd_ring[edev->txd_idx].status1 =
         (is_end ? TX_DESC_EOR : 0) | length | TX_DESC_OWN | TX_DESC_FS | TX_DESC_LS;
 
-    WRITE8(RTL_TPPOLL, READ8(RTL_TPPOLL) | RTL_TPPOLL_NPQ);
-
     edev->txd_idx = (edev->txd_idx + 1) % ETH_BUF_COUNT;
+    edev->tx_frames++;
+    *pending = true;
+    return ZX_OK;
+}
+
+static void rtl8111_queue_tx_batch(void* ctx, uint32_t options, ethmac_netbuf_t** netbufs,
+                                   size_t count, zx_status_t* statuses) {
+    ethernet_device_t* edev = ctx;
+    bool pending = false;
+
+    mtx_lock(&edev->tx_lock);
+
+    for (size_t i = 0; i < count; i++) {
+        statuses[i] = rtl8111_tx_locked(edev, netbufs[i], &pending);
+    }
+    if (pending) {
+        WRITE8(RTL_TPPOLL, READ8(RTL_TPPOLL) | RTL_TPPOLL_NPQ);
+        edev->tx_polls++;
+    }
 
     mtx_unlock(&edev->tx_lock);
-    return ZX_OK;
+}
+
+static zx_status_t rtl8111_queue_tx(void* ctx, uint32_t options, ethmac_netbuf_t* netbuf) {
+    zx_status_t status;
+    rtl8111_queue_tx_batch(ctx, options, &netbuf, 1, &status);
+    return status;
 }
 
 static zx_status_t rtl8111_set_promisc(ethernet_device_t* edev, bool on) {
@@ -301,6 +395,23 @@ static zx_status_t rtl8111_set_param(void *ctx, uint32_t param, int32_t value, v
     case ETHMAC_SETPARAM_PROMISC:
         status = rtl8111_set_promisc(edev, (bool)value);
         break;
+    case ETHMAC_SETPARAM_DUMP_REGS:
+        zxlogf(INFO, "rtl8111: %" PRIu64 " tx frames in %" PRIu64 " polling requests\n",
+               edev->tx_frames, edev->tx_polls);
+        status = ZX_OK;
+        break;
+    case ETHMAC_SETPARAM_INTR_MODERATION: {
+        ethmac_intr_moderation_t* m = data;
+        edev->moderation = *m;
+        if (edev->moderation.min_interval_us > edev->moderation.max_interval_us) {
+            edev->moderation.min_interval_us = edev->moderation.max_interval_us;
+        }
+        edev->moderation_start = zx_clock_get_monotonic();
+        edev->moderation_packets = edev->rx_packets + edev->tx_frames;
+        rtl8111_set_irq_interval_locked(edev, edev->moderation.min_interval_us);
+        status = ZX_OK;
+        break;
+    }
     default:
         status = ZX_ERR_NOT_SUPPORTED;
     }
@@ -309,12 +420,29 @@ static zx_status_t rtl8111_set_param(void *ctx, uint32_t param, int32_t value, v
     return status;
 }
 
+static zx_status_t rtl8111_get_queue_stats(void* ctx, uint32_t queue,
+                                           ethmac_queue_stats_t* stats) {
+    ethernet_device_t* edev = ctx;
+    if (queue != 0) {
+        return ZX_ERR_OUT_OF_RANGE;
+    }
+    mtx_lock(&edev->lock);
+    stats->interrupts = edev->interrupts;
+    stats->rx_packets = edev->rx_packets;
+    stats->tx_packets = edev->tx_frames;
+    stats->interval_us = edev->irq_interval_us;
+    mtx_unlock(&edev->lock);
+    return ZX_OK;
+}
+
 static ethmac_protocol_ops_t ethmac_ops = {
     .query = rtl8111_query,
     .stop = rtl8111_stop,
     .start = rtl8111_start,
     .queue_tx = rtl8111_queue_tx,
     .set_param = rtl8111_set_param,
+    .queue_tx_batch = rtl8111_queue_tx_batch,
+    .get_queue_stats = rtl8111_get_queue_stats,
 };
 
 static void rtl8111_release(void* ctx) {
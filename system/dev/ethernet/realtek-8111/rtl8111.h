@@ -39,6 +39,7 @@
 #define RTL_9436CR 0x0050
 #define RTL_PHYSTATUS 0x006c
 #define RTL_RMS 0x00da
+#define RTL_INTRMITIGATE 0x00e2
 #define RTL_CPLUSCR 0x00e0
 #define RTL_RDSAR_LOW 0x00e4
 #define RTL_RDSAR_HIGH 0x00e8
@@ -81,6 +82,14 @@
 
 #define RTL_MTPS_MTPS_MASK 0x1f
 
+// The tx and rx interrupts are delayed until |pkts| packets were handled or |timer| units of
+// roughly 5us (at 1000Mbps) have passed since the first.
+#define RTL_INTRMITIGATE_TX_TIMER(t) (((t) & 0xf) << 12)
+#define RTL_INTRMITIGATE_TX_PKTS(n) (((n) & 0xf) << 8)
+#define RTL_INTRMITIGATE_RX_TIMER(t) (((t) & 0xf) << 4)
+#define RTL_INTRMITIGATE_RX_PKTS(n) ((n) & 0xf)
+#define RTL_INTRMITIGATE_UNIT_US 5
+
 #define TX_DESC_OWN (1 << 31)
 #define TX_DESC_EOR (1 << 30)
 #define TX_DESC_FS (1 << 29)
@@ -58,7 +58,9 @@ zx_status_t usb_request_cache_flush(usb_request_t* req, zx_off_t offset, size_t
 // in the request's buffer
 zx_status_t usb_request_cache_flush_invalidate(usb_request_t* req, zx_off_t offset, size_t length);
 
-// Looks up the physical pages backing this request's vm object.
+// Looks up the physical pages backing this request's vm object. Requests set up with
+// usb_request_init() only pin the pages of their current transfer; others pin their
+// whole buffer, so they can be reused for transfers of any length.
 zx_status_t usb_request_physmap(usb_request_t* req, zx_handle_t bti_handle);
 
 // usb_request_release() frees the message data -- should be called only by the entity that allocated it
@@ -236,9 +236,21 @@ zx_status_t usb_request_physmap(usb_request_t* req, zx_handle_t bti_handle) {
     // zx_bti_pin returns whole pages, so take into account unaligned vmo
     // offset and length when calculating the amount of pages returned
     uint64_t page_offset = ROUNDDOWN(req->offset, PAGE_SIZE);
-    // The buffer size is the vmo size from offset 0.
-    uint64_t page_length = req->size - page_offset;
+    uint64_t page_length;
+    if (req->release_cb == usb_request_release_static) {
+        // A request initialized on a caller's vmo is set up afresh for each transfer, so pin
+        // only the pages of this transfer, rather than committing the rest of the vmo.
+        page_length = req->offset + req->header.length - page_offset;
+    } else {
+        // The buffer size is the vmo size from offset 0.
+        page_length = req->size - page_offset;
+    }
     uint64_t pages = ROUNDUP(page_length, PAGE_SIZE) / PAGE_SIZE;
+    if (pages == 0) {
+        // A zero length transfer at a page aligned offset touches no pages,
+        // and zx_bti_pin() refuses an empty range.
+        return ZX_OK;
+    }
 
     zx_paddr_t* paddrs = malloc(pages * sizeof(zx_paddr_t));
     if (paddrs == NULL) {
@@ -528,6 +528,16 @@ static zx_status_t ipm_stage_fixed_config(const cpuperf_config_t* icfg,
         ocfg->fixed_flags[ss->num_fixed] |= IPM_CONFIG_FLAG_LBR;
         ocfg->debug_ctrl |= IA32_DEBUGCTL_LBR_MASK;
     }
+    if (icfg->flags[ii] & CPUPERF_CONFIG_FLAG_CALLSTACK) {
+        if (icfg->rate[ii] == 0 ||
+                ((icfg->flags[ii] & CPUPERF_CONFIG_FLAG_TIMEBASE0) &&
+                 ii != 0)) {
+            zxlogf(ERROR, "%s: Call stack requires own timebase, event [%u]\n"
+                   , __func__, ii);
+            return ZX_ERR_INVALID_ARGS;
+        }
+        ocfg->fixed_flags[ss->num_fixed] |= IPM_CONFIG_FLAG_CALLSTACK;
+    }
 
     ++ss->num_fixed;
     return ZX_OK;
@@ -626,6 +636,16 @@ static zx_status_t ipm_stage_programmable_config(const cpuperf_config_t* icfg,
         ocfg->programmable_flags[ss->num_programmable] |= IPM_CONFIG_FLAG_LBR;
         ocfg->debug_ctrl |= IA32_DEBUGCTL_LBR_MASK;
     }
+    if (icfg->flags[ii] & CPUPERF_CONFIG_FLAG_CALLSTACK) {
+        if (icfg->rate[ii] == 0 ||
+                ((icfg->flags[ii] & CPUPERF_CONFIG_FLAG_TIMEBASE0) &&
+                 ii != 0)) {
+            zxlogf(ERROR, "%s: Call stack requires own timebase, event [%u]\n"
+                   , __func__, ii);
+            return ZX_ERR_INVALID_ARGS;
+        }
+        ocfg->programmable_flags[ss->num_programmable] |= IPM_CONFIG_FLAG_CALLSTACK;
+    }
 
     ++ss->num_programmable;
     return ZX_OK;
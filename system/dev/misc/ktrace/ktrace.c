@@ -17,19 +17,185 @@
 #include <string.h>
 #include <threads.h>
 
+// The kernel keeps a trace buffer per cpu and reads them back one after the
+// other, each behind a CPU_BUFFER record, after the metadata. Readers of this
+// device get a single stream instead: a snapshot with the metadata first and
+// the records of all cpus merged in timestamp order.
+#define MAX_CPUS 32
+
+static mtx_t snapshot_lock = MTX_INIT;
+static uint8_t* snapshot;
+static size_t snapshot_size;
+// Whether records may still be added to the kernel buffers since the snapshot.
+static bool snapshot_live = true;
+
+typedef struct cpu_cursor {
+    const uint8_t* pos;
+    const uint8_t* end;
+} cpu_cursor_t;
+
+// Skips padding and returns the next record of |c|, or NULL at the end or at
+// a record that was still being written.
+static const ktrace_header_t* cursor_peek(cpu_cursor_t* c) {
+    while (c->end - c->pos >= (ptrdiff_t)sizeof(uint32_t)) {
+        uint32_t tag;
+        memcpy(&tag, c->pos, sizeof(tag));
+        size_t len = KTRACE_LEN(tag);
+        if (len == 0 || len > (size_t)(c->end - c->pos)) {
+            break;
+        }
+        if (KTRACE_GROUP(tag) != 0) {
+            if (len < KTRACE_HDRSIZE) {
+                break;
+            }
+            return (const ktrace_header_t*)c->pos;
+        }
+        c->pos += len;
+    }
+    c->pos = c->end;
+    return NULL;
+}
+
+static void snapshot_free_locked(void) {
+    free(snapshot);
+    snapshot = NULL;
+    snapshot_size = 0;
+}
+
+static zx_status_t snapshot_take_locked(void) {
+    snapshot_free_locked();
+
+    size_t raw_size;
+    zx_status_t status = zx_ktrace_read(get_root_resource(), NULL, 0, 0, &raw_size);
+    if (status != ZX_OK) {
+        return status;
+    }
+    uint8_t* raw = malloc(raw_size);
+    uint8_t* out = malloc(raw_size);
+    if (raw == NULL || out == NULL) {
+        free(raw);
+        free(out);
+        return ZX_ERR_NO_MEMORY;
+    }
+
+    size_t raw_len = 0;
+    while (raw_len < raw_size) {
+        size_t n;
+        status = zx_ktrace_read(get_root_resource(), raw + raw_len, raw_len,
+                                raw_size - raw_len, &n);
+        if (status != ZX_OK) {
+            free(raw);
+            free(out);
+            return status;
+        }
+        if (n == 0) {
+            break;
+        }
+        raw_len += n;
+    }
+
+    // Split the raw trace into the metadata and the cpu buffers.
+    cpu_cursor_t cpus[MAX_CPUS];
+    size_t cpu_count = 0;
+    size_t meta_len = raw_len;
+    const uint8_t* p = raw;
+    const uint8_t* end = raw + raw_len;
+    while (end - p >= (ptrdiff_t)sizeof(ktrace_rec_32b_t)) {
+        const ktrace_rec_32b_t* rec = (const ktrace_rec_32b_t*)p;
+        if (rec->tag != TAG_CPU_BUFFER) {
+            size_t len = KTRACE_LEN(rec->tag);
+            if (len == 0) {
+                break;
+            }
+            p += len;
+            continue;
+        }
+        if (cpu_count == 0) {
+            meta_len = p - raw;
+        }
+        uint64_t len = rec->b | ((uint64_t)rec->c << 32);
+        p += sizeof(*rec);
+        if (len > (uint64_t)(end - p)) {
+            len = end - p;
+        }
+        if (cpu_count < countof(cpus)) {
+            cpus[cpu_count].pos = p;
+            cpus[cpu_count].end = p + len;
+            cpu_count++;
+        }
+        p += len;
+    }
+
+    memcpy(out, raw, meta_len);
+    size_t out_len = meta_len;
+
+    // Repeatedly take the earliest record at the head of any cpu buffer.
+    for (;;) {
+        cpu_cursor_t* next = NULL;
+        const ktrace_header_t* next_hdr = NULL;
+        for (size_t i = 0; i < cpu_count; i++) {
+            const ktrace_header_t* hdr = cursor_peek(&cpus[i]);
+            if (hdr != NULL && (next_hdr == NULL || hdr->ts < next_hdr->ts)) {
+                next = &cpus[i];
+                next_hdr = hdr;
+            }
+        }
+        if (next == NULL) {
+            break;
+        }
+        size_t len = KTRACE_LEN(next_hdr->tag);
+        memcpy(out + out_len, next_hdr, len);
+        out_len += len;
+        next->pos += len;
+    }
+
+    free(raw);
+    snapshot = out;
+    snapshot_size = out_len;
+    return ZX_OK;
+}
+
 static zx_status_t ktrace_read(void* ctx, void* buf, size_t count, zx_off_t off, size_t* actual) {
-    size_t length;
-    zx_status_t status = zx_ktrace_read(get_root_resource(), buf, off, count, &length);
+    mtx_lock(&snapshot_lock);
+
+    // While tracing, a read from the start picks up whatever was traced since
+    // the last one. Once stopped, the snapshot taken at stop time is kept.
+    zx_status_t status = ZX_OK;
+    if (snapshot == NULL || (off == 0 && snapshot_live)) {
+        status = snapshot_take_locked();
+    }
     if (status == ZX_OK) {
-        *actual = length;
+        size_t n = 0;
+        if (off < snapshot_size) {
+            n = snapshot_size - off;
+            if (n > count) {
+                n = count;
+            }
+            memcpy(buf, snapshot + off, n);
+        }
+        *actual = n;
     }
+
+    mtx_unlock(&snapshot_lock);
     return status;
 }
 
 static zx_off_t ktrace_get_size(void* ctx) {
-    size_t size;
-    zx_status_t status = zx_ktrace_read(get_root_resource(), NULL, 0, 0, &size);
-    return status != ZX_OK ? (zx_off_t)status : (zx_off_t)size;
+    mtx_lock(&snapshot_lock);
+    zx_status_t status = ZX_OK;
+    if (snapshot == NULL) {
+        status = snapshot_take_locked();
+    }
+    zx_off_t size = status != ZX_OK ? (zx_off_t)status : (zx_off_t)snapshot_size;
+    mtx_unlock(&snapshot_lock);
+    return size;
+}
+
+static void ktrace_drop_snapshot(void) {
+    mtx_lock(&snapshot_lock);
+    snapshot_free_locked();
+    snapshot_live = true;
+    mtx_unlock(&snapshot_lock);
 }
 
 static zx_status_t ktrace_ioctl(void* ctx, uint32_t op,
@@ -70,10 +236,25 @@ static zx_status_t ktrace_ioctl(void* ctx, uint32_t op,
             return ZX_ERR_INVALID_ARGS;
         }
         uint32_t group_mask = *(uint32_t *)cmd;
+        ktrace_drop_snapshot();
         return zx_ktrace_control(get_root_resource(), KTRACE_ACTION_START, group_mask, NULL);
     }
+    case IOCTL_KTRACE_START_CIRCULAR: {
+        if (cmdlen != sizeof(uint32_t)) {
+            return ZX_ERR_INVALID_ARGS;
+        }
+        uint32_t group_mask = *(uint32_t *)cmd;
+        ktrace_drop_snapshot();
+        return zx_ktrace_control(get_root_resource(), KTRACE_ACTION_START_CIRCULAR, group_mask,
+                                 NULL);
+    }
     case IOCTL_KTRACE_STOP: {
         zx_ktrace_control(get_root_resource(), KTRACE_ACTION_STOP, 0, NULL);
+        // Take the snapshot before rewinding so that a circular trace can be
+        // read back after it is stopped.
+        mtx_lock(&snapshot_lock);
+        snapshot_live = (snapshot_take_locked() != ZX_OK);
+        mtx_unlock(&snapshot_lock);
         zx_ktrace_control(get_root_resource(), KTRACE_ACTION_REWIND, 0, NULL);
         return ZX_OK;
     }
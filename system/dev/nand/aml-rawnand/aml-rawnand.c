@@ -14,6 +14,8 @@
 #include <ddk/protocol/platform-device-lib.h>
 #include <ddk/protocol/rawnand.h>
 
+#include <zircon/syscalls.h>
+
 #define MAX(A, B) ((A > B) ? A : B)
 
 static const uint32_t chipsel[2] = {NAND_CE0, NAND_CE1};
@@ -472,38 +474,19 @@ static bool is_page0_nand_page(uint32_t nand_page) {
             ((nand_page % AML_PAGE0_STEP) == 0));
 }
 
-static zx_status_t aml_read_page_hwecc(void* ctx,
-                                       uint32_t nand_page,
-                                       void* data,
-                                       size_t data_size,
-                                       size_t* data_actual,
-                                       void* oob,
-                                       size_t oob_size,
-                                       size_t* oob_actual,
-                                       uint32_t* ecc_correct) {
-    aml_raw_nand_t* raw_nand = (aml_raw_nand_t*)ctx;
+/*
+ * Queues the DMA of a page into data_buf/info_buf, once READ0 has been sent
+ * for it and the chip has had chip_delay to load it into its page register.
+ */
+static void aml_queue_read_dma(aml_raw_nand_t* raw_nand, uint32_t nand_page,
+                               bool page0, uint32_t ecc_pages,
+                               uint32_t ecc_pagesize) {
     uint32_t cmd;
-    zx_status_t status;
     uint64_t daddr = raw_nand->data_buf_paddr;
     uint64_t iaddr = raw_nand->info_buf_paddr;
     volatile uint8_t* reg = (volatile uint8_t*)
         raw_nand->mmio[NANDREG_WINDOW].vaddr;
-    uint32_t ecc_pagesize = 0; /* initialize to silence compiler */
-    uint32_t ecc_pages;
-    bool page0 = is_page0_nand_page(nand_page);
 
-    if (!page0) {
-        ecc_pagesize = aml_get_ecc_pagesize(raw_nand,
-                                            raw_nand->controller_params.bch_mode);
-        ecc_pages = raw_nand->writesize / ecc_pagesize;
-        if (is_page0_nand_page(nand_page))
-            return ZX_ERR_IO;
-    } else
-        ecc_pages = 1;
-    /* Send the page address into the controller */
-    onfi_command(&raw_nand->onfi, NAND_CMD_READ0, 0x00,
-                 nand_page, raw_nand->chipsize, raw_nand->chip_delay,
-                 (raw_nand->controller_params.options & NAND_BUSWIDTH_16));
     cmd = GENCMDDADDRL(AML_CMD_ADL, daddr);
     writel(cmd, reg + P_NAND_CMD);
     cmd = GENCMDDADDRH(AML_CMD_ADH, daddr);
@@ -523,6 +506,15 @@ static zx_status_t aml_read_page_hwecc(void* ctx,
         aml_cmd_n2m(raw_nand, ecc_pages, ecc_pagesize);
     else
         aml_cmd_n2m_page0(raw_nand);
+}
+
+/*
+ * Waits for the DMA queued by aml_queue_read_dma() to complete.
+ */
+static zx_status_t aml_wait_read_dma(aml_raw_nand_t* raw_nand,
+                                     uint32_t ecc_pages) {
+    zx_status_t status;
+
     status = aml_wait_dma_finish(raw_nand);
     if (status != ZX_OK) {
         zxlogf(ERROR, "%s: aml_wait_dma_finish failed %d\n",
@@ -540,9 +532,19 @@ static zx_status_t aml_read_page_hwecc(void* ctx,
                __func__, status);
         return status;
     }
-    /*
-     * Finally copy out the data and oob as needed
-     */
+    return ZX_OK;
+}
+
+/*
+ * Copies a page read by DMA out of data_buf/info_buf, and checks its ECC.
+ * data_buf and info_buf are free again once this returns.
+ */
+static zx_status_t aml_copy_read_page(aml_raw_nand_t* raw_nand,
+                                      uint32_t nand_page, bool page0,
+                                      uint32_t ecc_pages, void* data,
+                                      void* oob, uint32_t* ecc_correct) {
+    zx_status_t status;
+
     if (data != NULL) {
         if (!page0)
             memcpy(data, raw_nand->data_buf, raw_nand->writesize);
@@ -560,42 +562,146 @@ static zx_status_t aml_read_page_hwecc(void* ctx,
     return status;
 }
 
+static uint32_t aml_ecc_pages(aml_raw_nand_t* raw_nand, bool page0,
+                              uint32_t* ecc_pagesize) {
+    if (page0) {
+        *ecc_pagesize = 0;
+        return 1;
+    }
+    *ecc_pagesize = aml_get_ecc_pagesize(raw_nand,
+                                         raw_nand->controller_params.bch_mode);
+    return raw_nand->writesize / *ecc_pagesize;
+}
+
+static zx_status_t aml_read_page_hwecc(void* ctx,
+                                       uint32_t nand_page,
+                                       void* data,
+                                       size_t data_size,
+                                       size_t* data_actual,
+                                       void* oob,
+                                       size_t oob_size,
+                                       size_t* oob_actual,
+                                       uint32_t* ecc_correct) {
+    aml_raw_nand_t* raw_nand = (aml_raw_nand_t*)ctx;
+    zx_status_t status;
+    uint32_t ecc_pagesize;
+    bool page0 = is_page0_nand_page(nand_page);
+    uint32_t ecc_pages = aml_ecc_pages(raw_nand, page0, &ecc_pagesize);
+
+    /* Send the page address into the controller */
+    onfi_command(&raw_nand->onfi, NAND_CMD_READ0, 0x00,
+                 nand_page, raw_nand->chipsize, raw_nand->chip_delay,
+                 (raw_nand->controller_params.options & NAND_BUSWIDTH_16));
+    aml_queue_read_dma(raw_nand, nand_page, page0, ecc_pages, ecc_pagesize);
+    status = aml_wait_read_dma(raw_nand, ecc_pages);
+    if (status != ZX_OK)
+        return status;
+    /*
+     * Finally copy out the data and oob as needed
+     */
+    return aml_copy_read_page(raw_nand, nand_page, page0, ecc_pages, data, oob,
+                              ecc_correct);
+}
+
 /*
- * TODO : Right now, the driver uses a buffer for DMA, which
- * is not needed. We should initiate DMA to/from pages passed in.
+ * Reads consecutive pages. Once a page is in data_buf, the READ0 of the next
+ * page is sent before the page is copied out and its ECC checked, so that both
+ * overlap with the chip loading the next page (chip_delay).
  */
-static zx_status_t aml_write_page_hwecc(void* ctx,
-                                        const void* data,
+static zx_status_t aml_read_pages_hwecc(void* ctx,
+                                        uint32_t nand_page,
+                                        uint32_t num_pages,
+                                        void* data,
                                         size_t data_size,
-                                        const void* oob,
+                                        void* oob,
                                         size_t oob_size,
-                                        uint32_t nand_page)
-{
-    aml_raw_nand_t *raw_nand = (aml_raw_nand_t*)ctx;
-    uint32_t cmd;
-    uint64_t daddr = raw_nand->data_buf_paddr;
-    uint64_t iaddr = raw_nand->info_buf_paddr;
-    zx_status_t status;
-    volatile uint8_t* reg = (volatile uint8_t*)
-        raw_nand->mmio[NANDREG_WINDOW].vaddr;
-    uint32_t ecc_pagesize = 0; /* initialize to silence compiler */
-    uint32_t ecc_pages;
-    bool page0 = is_page0_nand_page(nand_page);
+                                        uint32_t* ecc_correct) {
+    aml_raw_nand_t* raw_nand = (aml_raw_nand_t*)ctx;
+    zx_status_t status = ZX_OK;
+    uint32_t oob_page_size;
+    uint32_t ecc_pagesize;
+    uint32_t max_ecc_correct = 0;
+    bool loading = false; /* READ0 sent for the page, at load_start */
+    zx_time_t load_start = 0;
+    int buswidth_16 = raw_nand->controller_params.options & NAND_BUSWIDTH_16;
+
+    oob_page_size = aml_ecc_pages(raw_nand, false, &ecc_pagesize) * 2;
+    if ((data != NULL && data_size < (size_t)num_pages * raw_nand->writesize) ||
+        (oob != NULL && oob_size < (size_t)num_pages * oob_page_size))
+        return ZX_ERR_BUFFER_TOO_SMALL;
+
+    for (uint32_t i = 0; i < num_pages; i++) {
+        uint32_t page = nand_page + i;
+        bool page0 = is_page0_nand_page(page);
+        uint32_t ecc_pages = aml_ecc_pages(raw_nand, page0, &ecc_pagesize);
+        uint32_t page_ecc_correct = 0;
+
+        if (!loading) {
+            onfi_command(&raw_nand->onfi, NAND_CMD_READ0, 0x00, page,
+                         raw_nand->chipsize, raw_nand->chip_delay,
+                         buswidth_16);
+        }
+        aml_queue_read_dma(raw_nand, page, page0, ecc_pages, ecc_pagesize);
+        status = aml_wait_read_dma(raw_nand, ecc_pages);
+        if (status != ZX_OK)
+            break;
 
-    if (!page0) {
-        ecc_pagesize = aml_get_ecc_pagesize(raw_nand,
-                                            raw_nand->controller_params.bch_mode);
-        ecc_pages = raw_nand->writesize / ecc_pagesize;
-        if (is_page0_nand_page(nand_page))
-            return ZX_ERR_IO;
-    } else
-        ecc_pages = 1;
+        /* start loading the next page, unless it is a page0 page */
+        loading = (i + 1 < num_pages) && !is_page0_nand_page(page + 1);
+        if (loading) {
+            onfi_command(&raw_nand->onfi, NAND_CMD_READ0, 0x00, page + 1,
+                         raw_nand->chipsize, 0, buswidth_16);
+            load_start = zx_clock_get_monotonic();
+        }
+
+        status = aml_copy_read_page(raw_nand, page, page0, ecc_pages,
+                                    data, oob, &page_ecc_correct);
+        max_ecc_correct = MAX(max_ecc_correct, page_ecc_correct);
+
+        if (loading) {
+            zx_nanosleep(load_start + ZX_USEC(raw_nand->chip_delay));
+        }
+        if (status != ZX_OK)
+            break;
+
+        if (data != NULL)
+            data = (uint8_t*)data + raw_nand->writesize;
+        if (oob != NULL)
+            oob = (uint8_t*)oob + oob_page_size;
+    }
+    *ecc_correct = max_ecc_correct;
+    return status;
+}
+
+/*
+ * Fills data_buf/info_buf with a page to be written.
+ */
+static void aml_fill_write_page(aml_raw_nand_t* raw_nand,
+                                const void* data, const void* oob,
+                                uint32_t ecc_pages) {
     if (data != NULL) {
         memcpy(raw_nand->data_buf, data, raw_nand->writesize);
     }
     if (oob != NULL) {
         aml_set_oob_byte(raw_nand, oob, ecc_pages);
     }
+}
+
+/*
+ * Transfers the page in data_buf/info_buf to the chip, and starts programming
+ * it. data_buf and info_buf are free again once this returns; onfi_wait()
+ * waits for the program to complete.
+ */
+static zx_status_t aml_program_page(aml_raw_nand_t* raw_nand,
+                                    uint32_t nand_page, bool page0,
+                                    uint32_t ecc_pages,
+                                    uint32_t ecc_pagesize) {
+    uint32_t cmd;
+    uint64_t daddr = raw_nand->data_buf_paddr;
+    uint64_t iaddr = raw_nand->info_buf_paddr;
+    zx_status_t status;
+    volatile uint8_t* reg = (volatile uint8_t*)
+        raw_nand->mmio[NANDREG_WINDOW].vaddr;
 
     onfi_command(&raw_nand->onfi, NAND_CMD_SEQIN, 0x00, nand_page,
                  raw_nand->chipsize, raw_nand->chip_delay,
@@ -628,11 +734,89 @@ static zx_status_t aml_write_page_hwecc(void* ctx,
     onfi_command(&raw_nand->onfi, NAND_CMD_PAGEPROG, -1, -1,
                  raw_nand->chipsize, raw_nand->chip_delay,
                  (raw_nand->controller_params.options & NAND_BUSWIDTH_16));
+    return ZX_OK;
+}
+
+/*
+ * TODO : Right now, the driver uses a buffer for DMA, which
+ * is not needed. We should initiate DMA to/from pages passed in.
+ */
+static zx_status_t aml_write_page_hwecc(void* ctx,
+                                        const void* data,
+                                        size_t data_size,
+                                        const void* oob,
+                                        size_t oob_size,
+                                        uint32_t nand_page)
+{
+    aml_raw_nand_t *raw_nand = (aml_raw_nand_t*)ctx;
+    zx_status_t status;
+    uint32_t ecc_pagesize;
+    bool page0 = is_page0_nand_page(nand_page);
+    uint32_t ecc_pages = aml_ecc_pages(raw_nand, page0, &ecc_pagesize);
+
+    aml_fill_write_page(raw_nand, data, oob, ecc_pages);
+    status = aml_program_page(raw_nand, nand_page, page0, ecc_pages, ecc_pagesize);
+    if (status != ZX_OK)
+        return status;
     status = onfi_wait(&raw_nand->onfi, AML_WRITE_PAGE_TIMEOUT);
 
     return status;
 }
 
+/*
+ * Writes consecutive pages. The next page is copied into data_buf/info_buf
+ * while the chip programs the one before.
+ */
+static zx_status_t aml_write_pages_hwecc(void* ctx,
+                                         const void* data,
+                                         size_t data_size,
+                                         const void* oob,
+                                         size_t oob_size,
+                                         uint32_t nand_page,
+                                         uint32_t num_pages) {
+    aml_raw_nand_t* raw_nand = (aml_raw_nand_t*)ctx;
+    zx_status_t status = ZX_OK;
+    uint32_t oob_page_size;
+    uint32_t ecc_pagesize;
+
+    oob_page_size = aml_ecc_pages(raw_nand, false, &ecc_pagesize) * 2;
+    if ((data != NULL && data_size < (size_t)num_pages * raw_nand->writesize) ||
+        (oob != NULL && oob_size < (size_t)num_pages * oob_page_size))
+        return ZX_ERR_BUFFER_TOO_SMALL;
+    if (num_pages == 0)
+        return ZX_OK;
+
+    const uint8_t* next_data = data;
+    const uint8_t* next_oob = oob;
+    bool page0 = is_page0_nand_page(nand_page);
+    uint32_t ecc_pages = aml_ecc_pages(raw_nand, page0, &ecc_pagesize);
+    aml_fill_write_page(raw_nand, next_data, next_oob, ecc_pages);
+
+    for (uint32_t i = 0; i < num_pages; i++) {
+        uint32_t page = nand_page + i;
+
+        status = aml_program_page(raw_nand, page, page0, ecc_pages, ecc_pagesize);
+        if (status != ZX_OK)
+            break;
+
+        /* stage the next page while this one is programmed */
+        if (i + 1 < num_pages) {
+            if (next_data != NULL)
+                next_data += raw_nand->writesize;
+            if (next_oob != NULL)
+                next_oob += oob_page_size;
+            page0 = is_page0_nand_page(page + 1);
+            ecc_pages = aml_ecc_pages(raw_nand, page0, &ecc_pagesize);
+            aml_fill_write_page(raw_nand, next_data, next_oob, ecc_pages);
+        }
+
+        status = onfi_wait(&raw_nand->onfi, AML_WRITE_PAGE_TIMEOUT);
+        if (status != ZX_OK)
+            break;
+    }
+    return status;
+}
+
 /*
  * Erase entry point into the Amlogic driver.
  * nandblock : NAND erase block address.
@@ -802,6 +986,8 @@ static raw_nand_protocol_ops_t aml_raw_nand_ops = {
     .write_page_hwecc = aml_write_page_hwecc,
     .erase_block = aml_erase_block,
     .get_nand_info = aml_get_nand_info,
+    .read_pages_hwecc = aml_read_pages_hwecc,
+    .write_pages_hwecc = aml_write_pages_hwecc,
 };
 
 static void aml_raw_nand_release(void* ctx) {
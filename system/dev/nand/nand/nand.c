@@ -70,6 +70,46 @@ zx_status_t nand_write_page(nand_device_t* dev, void* data, void* oob, uint32_t
                                      dev->nand_info.oob_size, nand_page);
 }
 
+// Calls controller specific read function for consecutive pages, if it has one.
+// data, oob: pointers to user oob/data buffers, holding num_pages pages each.
+// nand_page : NAND page address of the first page to read.
+// corrected_bits : Most ecc corrected bitflips of any of the pages.
+// Returns ZX_ERR_NOT_SUPPORTED if the controller can only read a page at a time.
+static zx_status_t nand_read_pages(nand_device_t* dev, void* data, void* oob, uint32_t nand_page,
+                                   uint32_t num_pages, uint32_t* corrected_bits) {
+    if (dev->host.ops->read_pages_hwecc == NULL) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+    return raw_nand_read_pages_hwecc(&dev->host, nand_page, num_pages, data,
+                                     (size_t)num_pages * dev->nand_info.page_size, oob,
+                                     (size_t)num_pages * dev->nand_info.oob_size, corrected_bits);
+}
+
+// Calls controller specific write function for consecutive pages, if it has one,
+// and nand_write_page() for each page otherwise.
+static zx_status_t nand_write_pages(nand_device_t* dev, uint8_t* data, uint8_t* oob,
+                                    uint32_t nand_page, uint32_t num_pages) {
+    if (dev->host.ops->write_pages_hwecc != NULL) {
+        return raw_nand_write_pages_hwecc(&dev->host, data,
+                                          (size_t)num_pages * dev->nand_info.page_size, oob,
+                                          (size_t)num_pages * dev->nand_info.oob_size, nand_page,
+                                          num_pages);
+    }
+    for (uint32_t i = 0; i < num_pages; i++) {
+        zx_status_t status = nand_write_page(dev, data, oob, nand_page + i);
+        if (status != ZX_OK) {
+            return status;
+        }
+        if (data) {
+            data += dev->nand_info.page_size;
+        }
+        if (oob) {
+            oob += dev->nand_info.oob_size;
+        }
+    }
+    return ZX_OK;
+}
+
 // Calls controller specific erase function.
 // nand_page: NAND erase block address.
 zx_status_t nand_erase_block(nand_device_t* dev, uint32_t nand_page) {
@@ -137,23 +177,30 @@ static zx_status_t nand_read_op(nand_device_t* dev, nand_op_t* nand_op) {
     }
 
     uint32_t max_corrected_bits = 0;
-    for (uint32_t i = 0; i < nand_op->rw.length; i++) {
-        uint32_t ecc_correct = 0;
-        status = nand_read_page(dev, vaddr_data, vaddr_oob, nand_op->rw.offset_nand + i,
-                                &ecc_correct, NAND_READ_RETRIES);
-        if (status != ZX_OK) {
-            zxlogf(ERROR, "nand: Read data error %d at page offset %u\n",
-                   status, nand_op->rw.offset_nand);
-            break;
-        } else {
-            max_corrected_bits = MAX(max_corrected_bits, ecc_correct);
-        }
+    // Read the whole op at once, so the controller can overlap the pages. If that fails, read
+    // it again a page at a time, retrying each page.
+    status = nand_read_pages(dev, vaddr_data, vaddr_oob, nand_op->rw.offset_nand,
+                             nand_op->rw.length, &max_corrected_bits);
+    if (status != ZX_OK) {
+        max_corrected_bits = 0;
+        for (uint32_t i = 0; i < nand_op->rw.length; i++) {
+            uint32_t ecc_correct = 0;
+            status = nand_read_page(dev, vaddr_data, vaddr_oob, nand_op->rw.offset_nand + i,
+                                    &ecc_correct, NAND_READ_RETRIES);
+            if (status != ZX_OK) {
+                zxlogf(ERROR, "nand: Read data error %d at page offset %u\n",
+                       status, nand_op->rw.offset_nand);
+                break;
+            } else {
+                max_corrected_bits = MAX(max_corrected_bits, ecc_correct);
+            }
 
-        if (vaddr_data) {
-            vaddr_data += dev->nand_info.page_size;
-        }
-        if (vaddr_oob) {
-            vaddr_oob += dev->nand_info.oob_size;
+            if (vaddr_data) {
+                vaddr_data += dev->nand_info.page_size;
+            }
+            if (vaddr_oob) {
+                vaddr_oob += dev->nand_info.oob_size;
+            }
         }
     }
     nand_op->rw.corrected_bit_flips = max_corrected_bits;
@@ -224,20 +271,11 @@ static zx_status_t nand_write_op(nand_device_t* dev, nand_op_t* nand_op) {
         vaddr_oob = aligned_vaddr_oob + page_offset_bytes_oob;
     }
 
-    for (uint32_t i = 0; i < nand_op->rw.length; i++) {
-        status = nand_write_page(dev, vaddr_data, vaddr_oob, nand_op->rw.offset_nand + i);
-        if (status != ZX_OK) {
-            zxlogf(ERROR, "nand: Write data error %d at page offset %u\n", status,
-                   nand_op->rw.offset_nand);
-            break;
-        }
-
-        if (vaddr_data) {
-            vaddr_data += dev->nand_info.page_size;
-        }
-        if (vaddr_oob) {
-            vaddr_oob += dev->nand_info.oob_size;
-        }
+    status = nand_write_pages(dev, vaddr_data, vaddr_oob, nand_op->rw.offset_nand,
+                              nand_op->rw.length);
+    if (status != ZX_OK) {
+        zxlogf(ERROR, "nand: Write data error %d at page offset %u\n", status,
+               nand_op->rw.offset_nand);
     }
 
     if (aligned_vaddr_data != NULL) {
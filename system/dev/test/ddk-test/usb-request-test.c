@@ -72,6 +72,32 @@ static bool test_alloc_vmo(void) {
     END_TEST;
 }
 
+static bool test_init_physmap(void) {
+    BEGIN_TEST;
+    zx_handle_t iommu_handle;
+    zx_handle_t bti_handle;
+    zx_iommu_desc_dummy_t desc;
+    ASSERT_EQ(zx_iommu_create(get_root_resource(), ZX_IOMMU_TYPE_DUMMY, &desc, sizeof(desc),
+                              &iommu_handle), ZX_OK, "");
+    ASSERT_EQ(zx_bti_create(iommu_handle, 0, 0, &bti_handle), ZX_OK, "");
+    zx_handle_t vmo;
+    ASSERT_EQ(zx_vmo_create(PAGE_SIZE * 16, 0, &vmo), ZX_OK, "");
+
+    usb_request_t req = {};
+    req.alloc_size = sizeof(req);
+    ASSERT_EQ(usb_request_init(&req, vmo, PAGE_SIZE, PAGE_SIZE * 2, 1), ZX_OK, "");
+
+    ASSERT_EQ(usb_request_physmap(&req, bti_handle), ZX_OK, "");
+    ASSERT_NONNULL(req.phys_list, "expected phys list to be set");
+    ASSERT_EQ(req.phys_count, 2u, "only the pages of the transfer should be pinned");
+
+    usb_request_release(&req);
+    zx_handle_close(vmo);
+    zx_handle_close(bti_handle);
+    zx_handle_close(iommu_handle);
+    END_TEST;
+}
+
 static bool test_pool(void) {
     BEGIN_TEST;
     zx_handle_t iommu_handle;
@@ -108,6 +134,7 @@ BEGIN_TEST_CASE(usb_request_tests)
 RUN_TEST(test_alloc_zero_size_request)
 RUN_TEST(test_alloc_simple)
 RUN_TEST(test_alloc_vmo)
+RUN_TEST(test_init_physmap)
 RUN_TEST(test_pool)
 END_TEST_CASE(usb_request_tests)
 
@@ -292,6 +292,11 @@ static size_t usb_device_get_max_transfer_size(void* ctx, uint8_t ep_address) {
     return usb_hci_get_max_transfer_size(&dev->hci, dev->device_id, ep_address);
 }
 
+static uint16_t usb_device_get_stream_count(void* ctx, uint8_t ep_address) {
+    usb_device_t* dev = ctx;
+    return usb_hci_get_stream_count(&dev->hci, dev->device_id, ep_address);
+}
+
 static uint32_t _usb_device_get_device_id(void* ctx) {
     usb_device_t* dev = ctx;
     return dev->device_id;
@@ -384,6 +389,7 @@ static usb_protocol_ops_t _usb_protocol = {
     .cancel_all = usb_device_cancel_all,
     .get_current_frame = usb_device_get_current_frame,
     .get_request_size = usb_device_get_request_size,
+    .get_stream_count = usb_device_get_stream_count,
 };
 
 static zx_status_t fidl_GetDeviceSpeed(void* ctx, fidl_txn_t* txn) {
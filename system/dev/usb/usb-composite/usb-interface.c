@@ -171,6 +171,11 @@ static size_t usb_interface_get_max_transfer_size(void* ctx, uint8_t ep_address)
     return usb_get_max_transfer_size(&intf->comp->usb, ep_address);
 }
 
+static uint16_t usb_interface_get_stream_count(void* ctx, uint8_t ep_address) {
+    usb_interface_t* intf = ctx;
+    return usb_get_stream_count(&intf->comp->usb, ep_address);
+}
+
 static uint32_t usb_interface_get_device_id(void* ctx) {
     usb_interface_t* intf = ctx;
     return usb_get_device_id(&intf->comp->usb);
@@ -311,6 +316,7 @@ usb_protocol_ops_t usb_device_protocol = {
     .cancel_all = usb_interface_cancel_all,
     .get_current_frame = usb_interface_get_current_frame,
     .get_request_size = usb_interface_get_request_size,
+    .get_stream_count = usb_interface_get_stream_count,
 };
 
 usb_composite_protocol_ops_t usb_composite_device_protocol = {
@@ -128,6 +128,18 @@ static size_t xhci_get_max_transfer_size(void* ctx, uint32_t device_id, uint8_t
     return PAGE_SIZE * (TRANSFER_RING_SIZE - 2);
 }
 
+static uint16_t xhci_get_stream_count(void* ctx, uint32_t device_id, uint8_t ep_address) {
+    auto* xhci = static_cast<xhci_t*>(ctx);
+    if (xhci_is_root_hub(xhci, device_id) || device_id < 1 || device_id > xhci->max_slots) {
+        return 0;
+    }
+    xhci_endpoint_t* ep = &xhci->slots[device_id].eps[xhci_endpoint_index(ep_address)];
+    mtx_lock(&ep->lock);
+    uint16_t num_streams = ep->num_streams;
+    mtx_unlock(&ep->lock);
+    return num_streams;
+}
+
 static zx_status_t xhci_cancel_all(void* ctx, uint32_t device_id, uint8_t ep_address) {
     auto* xhci = static_cast<xhci_t*>(ctx);
     return xhci_cancel_transfers(xhci, device_id, xhci_endpoint_index(ep_address));
@@ -158,6 +170,7 @@ usb_hci_protocol_ops_t xhci_hci_protocol = {
     .cancel_all = xhci_cancel_all,
     .get_bti = xhci_get_bti,
     .get_request_size = xhci_get_request_size,
+    .get_stream_count = xhci_get_stream_count,
 };
 
 void xhci_request_queue(xhci_t* xhci, usb_request_t* req) {
@@ -363,9 +376,17 @@ static zx_status_t usb_xhci_bind_pci(zx_device_t* parent, pci_protocol_t* pci) {
         goto error_return;
     }
 
+    // Prefer MSI-X, which gives each interrupter a vector of its own even on
+    // systems where MSI allows only one.
     uint32_t irq_cnt;
+    uint32_t irq_mode;
     irq_cnt = 0;
-    status = pci_query_irq_mode(pci, ZX_PCIE_IRQ_MODE_MSI, &irq_cnt);
+    irq_mode = ZX_PCIE_IRQ_MODE_MSI_X;
+    status = pci_query_irq_mode(pci, irq_mode, &irq_cnt);
+    if (status != ZX_OK) {
+        irq_mode = ZX_PCIE_IRQ_MODE_MSI;
+        status = pci_query_irq_mode(pci, irq_mode, &irq_cnt);
+    }
     if (status != ZX_OK) {
         zxlogf(ERROR, "pci_query_irq_mode failed %d\n", status);
         goto error_return;
@@ -379,7 +400,7 @@ static zx_status_t usb_xhci_bind_pci(zx_device_t* parent, pci_protocol_t* pci) {
     // select our IRQ mode
     xhci_mode_t mode;
     mode = XHCI_PCI_MSI;
-    status = pci_set_irq_mode(pci, ZX_PCIE_IRQ_MODE_MSI, irq_cnt);
+    status = pci_set_irq_mode(pci, irq_mode, irq_cnt);
     if (status < 0) {
         zxlogf(ERROR, "MSI interrupts not available, irq_cnt: %d, err: %d\n",
                irq_cnt, status);
@@ -395,6 +416,8 @@ static zx_status_t usb_xhci_bind_pci(zx_device_t* parent, pci_protocol_t* pci) {
         mode = XHCI_PCI_LEGACY;
         irq_cnt = 1;
     }
+    zxlogf(INFO, "xhci: using %u interrupters (irq mode %u)\n", irq_cnt,
+           mode == XHCI_PCI_LEGACY ? ZX_PCIE_IRQ_MODE_LEGACY : irq_mode);
 
     for (uint32_t i = 0; i < irq_cnt; i++) {
         // register for interrupts
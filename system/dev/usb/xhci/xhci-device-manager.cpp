@@ -3,6 +3,7 @@
 // found in the LICENSE file.
 
 #include <ddk/debug.h>
+#include <fbl/algorithm.h>
 #include <zircon/hw/usb.h>
 #include <zircon/hw/usb-hub.h>
 #include <endian.h>
@@ -93,6 +94,7 @@ static zx_status_t xhci_address_device(xhci_t* xhci, uint32_t slot_id, uint32_t
     }
     xhci_transfer_ring_t* transfer_ring = &ep->transfer_ring;
     ep->ep_type = USB_ENDPOINT_CONTROL;
+    ep->interrupter = xhci_assign_interrupter(xhci, ep->ep_type);
 
     mtx_lock(&xhci->input_context_lock);
     auto* icc = reinterpret_cast<xhci_input_control_context_t*>(xhci->input_context);
@@ -275,6 +277,54 @@ static int compute_interval(usb_endpoint_descriptor_t* ep, usb_speed_t speed) {
     }
 }
 
+// Allocates a transfer ring for each of the num_streams streams of ep, and a primary stream
+// context array of array_size entries pointing at them.
+static zx_status_t xhci_init_streams(xhci_t* xhci, xhci_endpoint_t* ep, uint16_t num_streams,
+                                     size_t array_size) {
+    ep->stream_rings = static_cast<xhci_transfer_ring_t*>(
+                                calloc(num_streams + 1, sizeof(xhci_transfer_ring_t)));
+    if (!ep->stream_rings) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    ep->num_streams = num_streams;
+
+    zx_status_t status = io_buffer_init(&ep->stream_ctx_buffer, xhci->bti_handle,
+                                        array_size * sizeof(xhci_stream_context_t),
+                                        IO_BUFFER_RW | IO_BUFFER_CONTIG | XHCI_IO_BUFFER_UNCACHED);
+    if (status != ZX_OK) {
+        return status;
+    }
+    auto* contexts = static_cast<xhci_stream_context_t*>(io_buffer_virt(&ep->stream_ctx_buffer));
+    memset(contexts, 0, array_size * sizeof(xhci_stream_context_t));
+
+    // stream ID 0 is reserved, and its context left zeroed
+    for (uint16_t i = 1; i <= num_streams; i++) {
+        xhci_transfer_ring_t* ring = &ep->stream_rings[i];
+        status = xhci_transfer_ring_init(ring, xhci->bti_handle, TRANSFER_RING_SIZE);
+        if (status != ZX_OK) {
+            return status;
+        }
+        zx_paddr_t tr_dequeue = xhci_transfer_ring_start_phys(ring);
+        XHCI_WRITE32(&contexts[i].sc0, ((uint32_t)tr_dequeue & STREAM_CTX_TR_DEQUEUE_LO_MASK) |
+                                       (STREAM_CTX_SCT_PRIMARY_TR << STREAM_CTX_SCT_START) |
+                                       STREAM_CTX_DCS);
+        XHCI_WRITE32(&contexts[i].sc1, (uint32_t)(tr_dequeue >> 32));
+    }
+    return ZX_OK;
+}
+
+static void xhci_free_streams(xhci_endpoint_t* ep) {
+    if (ep->stream_rings) {
+        for (uint16_t i = 1; i <= ep->num_streams; i++) {
+            xhci_transfer_ring_free(&ep->stream_rings[i]);
+        }
+        free(ep->stream_rings);
+        ep->stream_rings = nullptr;
+    }
+    io_buffer_release(&ep->stream_ctx_buffer);
+    ep->num_streams = 0;
+}
+
 static void xhci_disable_slot(xhci_t* xhci, uint32_t slot_id) {
     xhci_send_command(xhci, TRB_CMD_DISABLE_SLOT, 0, (slot_id << TRB_SLOT_ID_START));
 
@@ -283,6 +333,7 @@ static void xhci_disable_slot(xhci_t* xhci, uint32_t slot_id) {
     for (int i = 0; i < XHCI_NUM_EPS; i++) {
         xhci_endpoint_t* ep = &slot->eps[i];
         xhci_transfer_ring_free(&ep->transfer_ring);
+        xhci_free_streams(ep);
         free(ep->transfer_state);
         ep->transfer_state = nullptr;
         ep->state = EP_STATE_DISABLED;
@@ -424,6 +475,7 @@ static zx_status_t xhci_stop_endpoint(xhci_t* xhci, uint32_t slot_id, int ep_ind
     free(ep->transfer_state);
     ep->transfer_state = nullptr;
     xhci_transfer_ring_free(transfer_ring);
+    xhci_free_streams(ep);
 
     // complete any remaining requests
     usb_request_t* req;
@@ -628,6 +680,7 @@ zx_status_t xhci_enable_endpoint(xhci_t* xhci, uint32_t slot_id, usb_endpoint_de
 
     if (enable) {
         memset(sc, 0, xhci->context_size);
+        ep->interrupter = xhci_assign_interrupter(xhci, ep->ep_type);
 
         uint32_t ep_type = ep_desc->bmAttributes & USB_ENDPOINT_TYPE_MASK;
         uint32_t ep_index = ep_type;
@@ -660,16 +713,41 @@ zx_status_t xhci_enable_endpoint(xhci_t* xhci, uint32_t slot_id, usb_endpoint_de
         auto* epc = reinterpret_cast<xhci_endpoint_context_t*>(
                                         &xhci->input_context[(index + 2) * xhci->context_size]);
         memset(epc, 0, xhci->context_size);
-        // allocate a transfer ring for the endpoint
-        zx_status_t status = xhci_transfer_ring_init(&ep->transfer_ring, xhci->bti_handle, TRANSFER_RING_SIZE);
+
+        // Enable the streams a SuperSpeed bulk endpoint declares, up to what the controller
+        // supports. The primary stream array has 2^(max_p_streams + 1) entries, the first of
+        // which is reserved.
+        uint32_t max_p_streams = 0;
+        uint16_t num_streams = 0;
+        if (ep_type == USB_ENDPOINT_BULK && speed == USB_SPEED_SUPER && ss_comp_desc != nullptr &&
+            usb_ss_ep_comp_bulk_max_streams(ss_comp_desc) > 0 && xhci->max_psa_size > 0) {
+            uint32_t device_streams = usb_ss_ep_comp_bulk_max_streams(ss_comp_desc);
+            max_p_streams = fbl::min(fbl::min(xhci->max_psa_size, device_streams),
+                                     static_cast<uint32_t>(XHCI_MAX_P_STREAMS));
+            num_streams = static_cast<uint16_t>(fbl::min((1u << (max_p_streams + 1)) - 1,
+                                                         1u << device_streams));
+        }
+
+        // allocate a transfer ring for the endpoint, or for each of its streams
+        zx_status_t status;
+        zx_paddr_t tr_dequeue;
+        if (num_streams > 0) {
+            status = xhci_init_streams(xhci, ep, num_streams, 1u << (max_p_streams + 1));
+            if (status != ZX_OK) {
+                xhci_free_streams(ep);
+            }
+            tr_dequeue = io_buffer_phys(&ep->stream_ctx_buffer);
+        } else {
+            status = xhci_transfer_ring_init(&ep->transfer_ring, xhci->bti_handle,
+                                             TRANSFER_RING_SIZE);
+            tr_dequeue = xhci_transfer_ring_start_phys(&ep->transfer_ring);
+        }
         if (status < 0) {
             mtx_unlock(&xhci->input_context_lock);
             mtx_unlock(&ep->lock);
             return status;
         }
 
-        zx_paddr_t tr_dequeue = xhci_transfer_ring_start_phys(&slot->eps[index].transfer_ring);
-
         XHCI_SET_BITS32(&epc->epc0, EP_CTX_INTERVAL_START, EP_CTX_INTERVAL_BITS,
                         compute_interval(ep_desc, speed));
         XHCI_SET_BITS32(&epc->epc0, EP_CTX_MAX_ESIT_PAYLOAD_HI_START,
@@ -682,7 +760,16 @@ zx_status_t xhci_enable_endpoint(xhci_t* xhci, uint32_t slot_id, usb_endpoint_de
         XHCI_SET_BITS32(&epc->epc1, EP_CTX_MAX_BURST_SIZE_START, EP_CTX_MAX_BURST_SIZE_BITS,
                         max_burst);
 
-        XHCI_WRITE32(&epc->epc2, ((uint32_t)tr_dequeue & EP_CTX_TR_DEQUEUE_LO_MASK) | EP_CTX_DCS);
+        if (num_streams > 0) {
+            // the dequeue pointer is that of a linear stream context array, and has no DCS
+            XHCI_SET_BITS32(&epc->epc0, EP_CTX_MAX_P_STREAMS_START, EP_CTX_MAX_P_STREAMS_BITS,
+                            max_p_streams);
+            XHCI_WRITE32(&epc->epc0, XHCI_READ32(&epc->epc0) | EP_CTX_LSA);
+            XHCI_WRITE32(&epc->epc2, (uint32_t)tr_dequeue & EP_CTX_TR_DEQUEUE_LO_MASK);
+        } else {
+            XHCI_WRITE32(&epc->epc2,
+                         ((uint32_t)tr_dequeue & EP_CTX_TR_DEQUEUE_LO_MASK) | EP_CTX_DCS);
+        }
         XHCI_WRITE32(&epc->tr_dequeue_hi, (uint32_t)(tr_dequeue >> 32));
         XHCI_SET_BITS32(&epc->epc4, EP_CTX_AVG_TRB_LENGTH_START, EP_CTX_AVG_TRB_LENGTH_BITS,
                         avg_trb_length);
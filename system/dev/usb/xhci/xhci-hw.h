@@ -465,6 +465,14 @@ typedef struct {
 #define TRB_ENDPOINT_ID_START       16
 #define TRB_ENDPOINT_ID_BITS        5
 #define TRB_ADDRESS_DEVICE_BSR      (1 << 9)
+#define TRB_STREAM_ID_START         16  // in the status field of Set TR Dequeue Pointer TRBs
+#define TRB_STREAM_ID_BITS          16
+
+// Doorbell register bits
+#define DB_TARGET_START             0
+#define DB_TARGET_BITS              8
+#define DB_STREAM_ID_START          16
+#define DB_STREAM_ID_BITS           16
 
 // Slot context bits (sc0)
 #define SLOT_CTX_ROUTE_STRING_START         0
@@ -551,6 +559,15 @@ typedef struct {
 #define EP_CTX_MAX_ESIT_PAYLOAD_LO_START    16
 #define EP_CTX_MAX_ESIT_PAYLOAD_LO_BITS     16
 
+// Stream context bits (sc0)
+#define STREAM_CTX_DCS                      (1 << 0)
+#define STREAM_CTX_SCT_START                1
+#define STREAM_CTX_SCT_BITS                 3
+#define STREAM_CTX_TR_DEQUEUE_LO_MASK       0xFFFFFFF0
+
+// STREAM_CTX_SCT values
+#define STREAM_CTX_SCT_PRIMARY_TR           1
+
 // for input control context add and drop context flags
 #define XHCI_ICC_SLOT_FLAG          (1 << 0)
 #define XHCI_ICC_EP_FLAG(ep)        (1 << ((ep) + 1))
@@ -17,22 +17,24 @@
 // reads a range of bits from an integer
 #define READ_FIELD(i, start, bits) (((i) >> (start)) & ((1 << (bits)) - 1))
 
-// This resets the transfer ring's dequeue pointer just past the last completed transfer.
+// This resets a transfer ring's dequeue pointer just past its last completed transfer.
 // This can only be called when the endpoint is stopped and we are locked on ep->lock.
-static zx_status_t xhci_reset_dequeue_ptr_locked(xhci_t* xhci, uint32_t slot_id,
-                                                 uint32_t ep_index) {
-    xhci_slot_t* slot = &xhci->slots[slot_id];
-    xhci_endpoint_t* ep = &slot->eps[ep_index];
-    xhci_transfer_ring_t* transfer_ring = &ep->transfer_ring;
-
+static zx_status_t xhci_reset_ring_dequeue_ptr_locked(xhci_t* xhci, uint32_t slot_id,
+                                                      uint32_t ep_index,
+                                                      xhci_transfer_ring_t* transfer_ring,
+                                                      uint16_t stream_id) {
     xhci_sync_command_t command;
     xhci_sync_command_init(&command);
     uint64_t ptr = xhci_transfer_ring_current_phys(transfer_ring);
     ptr |= transfer_ring->pcs;
+    if (stream_id != 0) {
+        ptr |= (STREAM_CTX_SCT_PRIMARY_TR << STREAM_CTX_SCT_START);
+    }
     // command expects device context index, so increment ep_index by 1
     uint32_t control = (slot_id << TRB_SLOT_ID_START) |
                         ((ep_index + 1) << TRB_ENDPOINT_ID_START);
-    xhci_post_command(xhci, TRB_CMD_SET_TR_DEQUEUE, ptr, control, &command.context);
+    xhci_post_command_with_status(xhci, TRB_CMD_SET_TR_DEQUEUE, ptr,
+                                  stream_id << TRB_STREAM_ID_START, control, &command.context);
     int cc = xhci_sync_command_wait(&command);
     if (cc != TRB_CC_SUCCESS) {
         zxlogf(ERROR, "TRB_CMD_SET_TR_DEQUEUE failed cc: %d\n", cc);
@@ -43,6 +45,26 @@ static zx_status_t xhci_reset_dequeue_ptr_locked(xhci_t* xhci, uint32_t slot_id,
     return ZX_OK;
 }
 
+// This resets the dequeue pointer of the endpoint's transfer ring, or of each of its streams.
+static zx_status_t xhci_reset_dequeue_ptr_locked(xhci_t* xhci, uint32_t slot_id,
+                                                 uint32_t ep_index) {
+    xhci_slot_t* slot = &xhci->slots[slot_id];
+    xhci_endpoint_t* ep = &slot->eps[ep_index];
+
+    if (ep->num_streams == 0) {
+        return xhci_reset_ring_dequeue_ptr_locked(xhci, slot_id, ep_index, &ep->transfer_ring, 0);
+    }
+    for (uint16_t stream_id = 1; stream_id <= ep->num_streams; stream_id++) {
+        zx_status_t status = xhci_reset_ring_dequeue_ptr_locked(xhci, slot_id, ep_index,
+                                                                &ep->stream_rings[stream_id],
+                                                                stream_id);
+        if (status != ZX_OK) {
+            return status;
+        }
+    }
+    return ZX_OK;
+}
+
 static void xhci_process_transactions_locked(xhci_t* xhci, xhci_slot_t* slot, uint8_t ep_index,
                                              list_node_t* completed_reqs);
 
@@ -164,7 +186,7 @@ zx_status_t xhci_reset_endpoint(xhci_t* xhci, uint32_t slot_id, uint8_t ep_addre
 static zx_status_t xhci_start_transfer_locked(xhci_t* xhci, xhci_slot_t* slot, uint32_t ep_index,
                                               usb_request_t* req) {
     xhci_endpoint_t* ep = &slot->eps[ep_index];
-    xhci_transfer_ring_t* ring = &ep->transfer_ring;
+    xhci_transfer_ring_t* ring = xhci_endpoint_ring(ep, req);
     if (ep->state != EP_STATE_RUNNING) {
         zxlogf(ERROR, "xhci_start_transfer_locked bad ep->state %d\n", ep->state);
         return ZX_ERR_BAD_STATE;
@@ -185,7 +207,7 @@ static zx_status_t xhci_start_transfer_locked(xhci_t* xhci, xhci_slot_t* slot, u
         return ZX_ERR_BUFFER_TOO_SMALL;
     }
     auto length = static_cast<uint32_t>(req->header.length);
-    uint32_t interrupter_target = 0;
+    uint32_t interrupter_target = ep->interrupter;
 
     usb_setup_t* setup = (req->header.ep_address == 0 ? &req->setup : nullptr);
     if (setup) {
@@ -221,23 +243,20 @@ static zx_status_t xhci_start_transfer_locked(xhci_t* xhci, xhci_slot_t* slot, u
 static zx_status_t xhci_continue_transfer_locked(xhci_t* xhci, xhci_slot_t* slot,
                                                  uint32_t ep_index, usb_request_t* req) {
     xhci_endpoint_t* ep = &slot->eps[ep_index];
-    xhci_transfer_ring_t* ring = &ep->transfer_ring;
+    xhci_transfer_ring_t* ring = xhci_endpoint_ring(ep, req);
 
     usb_header_t* header = &req->header;
     xhci_transfer_state_t* state = ep->transfer_state;
     size_t length = header->length;
-    size_t free_trbs = xhci_transfer_ring_free_trbs(&ep->transfer_ring);
+    size_t free_trbs = xhci_transfer_ring_free_trbs(ring);
     uint8_t direction = state->direction;
     bool isochronous = (ep->ep_type == USB_ENDPOINT_ISOCHRONOUS);
     uint64_t frame = header->frame;
 
-    uint32_t interrupter_target = 0;
+    uint32_t interrupter_target = ep->interrupter;
 
     if (isochronous) {
         if (length == 0) return ZX_ERR_INVALID_ARGS;
-        if (xhci->num_interrupts > 1) {
-            interrupter_target = ISOCH_INTERRUPTER;
-        }
     }
 
     if (frame != 0) {
@@ -296,11 +315,12 @@ static zx_status_t xhci_continue_transfer_locked(xhci_t* xhci, xhci_slot_t* slot
     // update dequeue_ptr to TRB following this transaction
     req->context = (void *)ring->current;
 
-    XHCI_WRITE32(&xhci->doorbells[header->device_id], ep_index + 1);
+    uint32_t doorbell = (ep_index + 1) | (header->stream_id << DB_STREAM_ID_START);
+    XHCI_WRITE32(&xhci->doorbells[header->device_id], doorbell);
     // it seems we need to ring the doorbell a second time when transitioning from STOPPED
     while (xhci_get_ep_ctx_state(slot, ep) == EP_CTX_STATE_STOPPED) {
         zx_nanosleep(zx_deadline_after(ZX_MSEC(1)));
-        XHCI_WRITE32(&xhci->doorbells[header->device_id], ep_index + 1);
+        XHCI_WRITE32(&xhci->doorbells[header->device_id], doorbell);
     }
 
     return ZX_OK;
@@ -312,7 +332,8 @@ static void xhci_process_transactions_locked(xhci_t* xhci, xhci_slot_t* slot, ui
 
     // loop until we fill our transfer ring or run out of requests to process
     while (1) {
-        if (xhci_transfer_ring_free_trbs(&ep->transfer_ring) == 0) {
+        // each stream has a ring of its own, checked as its requests are continued
+        if (ep->num_streams == 0 && xhci_transfer_ring_free_trbs(&ep->transfer_ring) == 0) {
             // no available TRBs - need to wait for some complete
             return;
         }
@@ -409,6 +430,14 @@ zx_status_t xhci_queue_transfer(xhci_t* xhci, usb_request_t* req) {
         break;
     }
 
+    if (status == ZX_OK) {
+        uint16_t stream_id = req->header.stream_id;
+        if (ep->num_streams ? (stream_id == 0 || stream_id > ep->num_streams) : stream_id != 0) {
+            zxlogf(ERROR, "xhci_queue_transfer: bad stream ID %u for endpoint with %u streams\n",
+                   stream_id, ep->num_streams);
+            status = ZX_ERR_INVALID_ARGS;
+        }
+    }
     if (status != ZX_OK) {
         mtx_unlock(&ep->lock);
         return status;
@@ -587,6 +616,19 @@ zx_status_t xhci_get_descriptor(xhci_t* xhci, uint32_t slot_id, uint8_t type, ui
                                 USB_REQ_GET_DESCRIPTOR, value, index, data, length, out_actual);
 }
 
+// returns the ring of the stream whose TRBs include the one at physical address ptr,
+// or nullptr if there is none
+static xhci_transfer_ring_t* xhci_stream_ring_for_trb(xhci_endpoint_t* ep, zx_paddr_t ptr) {
+    for (uint16_t stream_id = 1; stream_id <= ep->num_streams; stream_id++) {
+        xhci_transfer_ring_t* ring = &ep->stream_rings[stream_id];
+        zx_paddr_t start = io_buffer_phys(&ring->buffer);
+        if (ptr >= start && ptr < start + io_buffer_size(&ring->buffer, 0)) {
+            return ring;
+        }
+    }
+    return nullptr;
+}
+
 void xhci_handle_transfer_event(xhci_t* xhci, xhci_trb_t* trb) {
     zxlogf(LTRACE, "xhci_handle_transfer_event: %08X %08X %08X %08X\n",
             ((uint32_t*)trb)[0], ((uint32_t*)trb)[1], ((uint32_t*)trb)[2], ((uint32_t*)trb)[3]);
@@ -714,8 +756,12 @@ void xhci_handle_transfer_event(xhci_t* xhci, xhci_trb_t* trb) {
                 return;
             }
         } else {
-            trb = xhci_read_trb_ptr(ring, trb);
-            if (trb_get_type(trb) == TRB_TRANSFER_STATUS && slot->current_ctrl_req) {
+            if (ep->num_streams > 0) {
+                // transfer events don't say which stream they are for
+                ring = xhci_stream_ring_for_trb(ep, trb->ptr);
+            }
+            trb = (ring ? xhci_read_trb_ptr(ring, trb) : nullptr);
+            if (trb && trb_get_type(trb) == TRB_TRANSFER_STATUS && slot->current_ctrl_req) {
                 // complete current control request
                 req = slot->current_ctrl_req;
                 slot->current_ctrl_req = nullptr;
@@ -770,7 +816,7 @@ void xhci_handle_transfer_event(xhci_t* xhci, xhci_trb_t* trb) {
     }
 
     // update dequeue_ptr to TRB following this transaction
-    xhci_set_dequeue_ptr(ring, static_cast<xhci_trb_t*>(req->context));
+    xhci_set_dequeue_ptr(xhci_endpoint_ring(ep, req), static_cast<xhci_trb_t*>(req->context));
 
     // remove request from pending_reqs
     list_delete(&req->node);
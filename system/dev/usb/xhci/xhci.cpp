@@ -173,6 +173,8 @@ zx_status_t xhci_init(xhci_t* xhci, xhci_mode_t mode, uint32_t num_interrupts) {
                                          HCSPARAMS1_MAX_PORTS_BITS);
     xhci->context_size = (XHCI_READ32(hccparams1) & HCCPARAMS1_CSZ ? 64 : 32);
     xhci->large_esit = !!(XHCI_READ32(hccparams2) & HCCPARAMS2_LEC);
+    xhci->max_psa_size = XHCI_GET_BITS32(hccparams1, HCCPARAMS1_MAX_PSA_SIZE_START,
+                                         HCCPARAMS1_MAX_PSA_SIZE_BITS);
 
     uint32_t scratch_pad_bufs = XHCI_GET_BITS32(hcsparams2, HCSPARAMS2_MAX_SBBUF_HI_START,
                                                 HCSPARAMS2_MAX_SBBUF_HI_BITS);
@@ -357,6 +359,21 @@ uint32_t xhci_get_max_interrupters(xhci_t* xhci) {
                            HCSPARAMS1_MAX_INTRS_BITS);
 }
 
+uint32_t xhci_assign_interrupter(xhci_t* xhci, uint8_t ep_type) {
+    switch (ep_type) {
+    case USB_ENDPOINT_CONTROL:
+        return 0;
+    case USB_ENDPOINT_ISOCHRONOUS:
+        return (xhci->num_interrupts > ISOCH_INTERRUPTER ? ISOCH_INTERRUPTER : 0);
+    default:
+        if (xhci->num_interrupts <= FIRST_BULK_INTERRUPTER) {
+            return 0;
+        }
+        return FIRST_BULK_INTERRUPTER + (xhci->next_bulk_interrupter.fetch_add(1) %
+                                         (xhci->num_interrupts - FIRST_BULK_INTERRUPTER));
+    }
+}
+
 int xhci_get_slot_ctx_state(xhci_slot_t* slot) {
     return XHCI_GET_BITS32(&slot->sc->sc3, SLOT_CTX_SLOT_STATE_START,
                            SLOT_CTX_CONTEXT_ENTRIES_BITS);
@@ -546,6 +563,11 @@ void xhci_free(xhci_t* xhci) {
 
 void xhci_post_command(xhci_t* xhci, uint32_t command, uint64_t ptr, uint32_t control_bits,
                        xhci_command_context_t* context) {
+    xhci_post_command_with_status(xhci, command, ptr, 0, control_bits, context);
+}
+
+void xhci_post_command_with_status(xhci_t* xhci, uint32_t command, uint64_t ptr, uint32_t status,
+                                   uint32_t control_bits, xhci_command_context_t* context) {
     // FIXME - check that command ring is not full?
 
     mtx_lock(&xhci->command_ring_lock);
@@ -556,7 +578,7 @@ void xhci_post_command(xhci_t* xhci, uint32_t command, uint64_t ptr, uint32_t co
     xhci->command_contexts[index] = context;
 
     XHCI_WRITE64(&trb->ptr, ptr);
-    XHCI_WRITE32(&trb->status, 0);
+    XHCI_WRITE32(&trb->status, status);
     trb_set_control(trb, command, control_bits);
 
     xhci_increment_ring(cr);
@@ -32,13 +32,20 @@
 #define COMMAND_RING_SIZE (PAGE_SIZE / sizeof(xhci_trb_t))
 #define TRANSFER_RING_SIZE (PAGE_SIZE / sizeof(xhci_trb_t))
 #define EVENT_RING_SIZE (PAGE_SIZE / sizeof(xhci_trb_t))
+// Largest MaxPStreams used for bulk endpoints with streams, for a primary stream context array
+// of 2^(XHCI_MAX_P_STREAMS + 1) entries. Stream ID 0 is reserved, so this allows up to 15 streams.
+#define XHCI_MAX_P_STREAMS 3
 #define ERST_ARRAY_SIZE 1
 
 #define XHCI_RH_USB_2 0 // index of USB 2.0 virtual root hub device
 #define XHCI_RH_USB_3 1 // index of USB 2.0 virtual root hub device
 #define XHCI_RH_COUNT 2 // number of virtual root hub devices
 
+// Interrupter 0 receives command completion and port status change events, and completes
+// control transfers. Isochronous transfers get an interrupter of their own, serviced by a high
+// priority thread, and bulk and interrupt endpoints are spread over any others.
 #define ISOCH_INTERRUPTER 1
+#define FIRST_BULK_INTERRUPTER 2
 
 #if __x86_64__
 // cache is coherent on x86, so we always use cached buffers
@@ -67,8 +74,21 @@ typedef struct {
     xhci_ep_state_t state;
     uint16_t max_packet_size;
     uint8_t ep_type;
+    // interrupter whose event ring receives this endpoint's transfer events
+    uint32_t interrupter;
+    // Bulk streams; see section 4.12 of the XHCI spec. Requests on an endpoint with streams
+    // enabled are queued on stream_rings[header.stream_id], for stream IDs 1 through
+    // num_streams, and transfer_ring is unused.
+    uint16_t num_streams;
+    xhci_transfer_ring_t* stream_rings;
+    io_buffer_t stream_ctx_buffer;  // primary stream context array
 } xhci_endpoint_t;
 
+// returns the transfer ring req is queued on
+static inline xhci_transfer_ring_t* xhci_endpoint_ring(xhci_endpoint_t* ep, usb_request_t* req) {
+    return ep->num_streams ? &ep->stream_rings[req->header.stream_id] : &ep->transfer_ring;
+}
+
 typedef struct xhci_slot {
     // buffer for our device context
     io_buffer_t buffer;
@@ -120,11 +140,13 @@ struct xhci {
     // Desired number of interrupters. This may be greater than what is
     // supported by hardware. The actual number of interrupts configured
     // will not exceed this, and is stored in num_interrupts.
-#define INTERRUPTER_COUNT 2
+#define INTERRUPTER_COUNT 8
     thrd_t completer_threads[INTERRUPTER_COUNT];
     zx_handle_t irq_handles[INTERRUPTER_COUNT];
     // actual number of interrupts we are using
     uint32_t num_interrupts;
+    // for assigning bulk and interrupt endpoints to interrupters round-robin
+    fbl::atomic<uint32_t> next_bulk_interrupter;
 
     mmio_buffer_t mmio;
 
@@ -160,6 +182,9 @@ struct xhci {
     size_t context_size;
     // true if controller supports large ESIT payloads
     bool large_esit;
+    // MaxPSASize from HCCPARAMS1: the controller supports primary stream arrays of up to
+    // 2^(max_psa_size + 1) entries, or no streams if it is zero
+    uint32_t max_psa_size;
 
     // total number of ports for the root hub
     uint8_t rh_num_ports;
@@ -217,6 +242,8 @@ zx_status_t xhci_init(xhci_t* xhci, xhci_mode_t mode, uint32_t num_interrupts);
 // Returns the max number of interrupters supported by the xhci.
 // This is different to xhci->num_interrupts.
 uint32_t xhci_get_max_interrupters(xhci_t* xhci);
+// Returns the interrupter to use for the transfer events of a new endpoint of type |ep_type|.
+uint32_t xhci_assign_interrupter(xhci_t* xhci, uint8_t ep_type);
 int xhci_get_slot_ctx_state(xhci_slot_t* slot);
 int xhci_get_ep_ctx_state(xhci_slot_t* slot, xhci_endpoint_t* ep);
 void xhci_set_dbcaa(xhci_t* xhci, uint32_t slot_id, zx_paddr_t paddr);
@@ -224,6 +251,9 @@ zx_status_t xhci_start(xhci_t* xhci);
 void xhci_handle_interrupt(xhci_t* xhci, uint32_t interrupter);
 void xhci_post_command(xhci_t* xhci, uint32_t command, uint64_t ptr, uint32_t control_bits,
                        xhci_command_context_t* context);
+// Like xhci_post_command(), for commands which take parameters in the status field of their TRB.
+void xhci_post_command_with_status(xhci_t* xhci, uint32_t command, uint64_t ptr, uint32_t status,
+                                   uint32_t control_bits, xhci_command_context_t* context);
 void xhci_wait_bits(volatile uint32_t* ptr, uint32_t bits, uint32_t expected);
 void xhci_wait_bits64(volatile uint64_t* ptr, uint64_t bits, uint64_t expected);
 
@@ -0,0 +1,243 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <digest/digest.h>
+#include <digest/merkle-tree.h>
+#include <fbl/unique_fd.h>
+
+#include "blob-cache.h"
+
+namespace {
+
+// "blobcach".
+constexpr uint64_t kEntryMagic = 0x68636163626f6c62ull;
+constexpr uint32_t kEntryVersion = 1;
+
+// A blob entry is this header, followed by the Merkle tree, followed by
+// the compressed data (if any).
+struct BlobEntryHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t compressed;
+    uint64_t length;
+    uint64_t merkle_length;
+    uint64_t compressed_length;
+};
+
+const char* CompressionSuffix(bool compress, blobfs::CompressionAlgorithm algorithm) {
+    if (!compress) {
+        return "raw";
+    }
+    switch (algorithm) {
+    case blobfs::CompressionAlgorithm::kLz4:
+        return "lz4";
+    case blobfs::CompressionAlgorithm::kLz4Hc:
+        return "lz4hc";
+    }
+    return "unknown";
+}
+
+bool ReadAll(int fd, void* data, size_t length) {
+    uint8_t* buf = static_cast<uint8_t*>(data);
+    while (length > 0) {
+        ssize_t r = read(fd, buf, length);
+        if (r < 0 && errno == EINTR) {
+            continue;
+        } else if (r <= 0) {
+            return false;
+        }
+        buf += r;
+        length -= r;
+    }
+    return true;
+}
+
+bool WriteAll(int fd, const void* data, size_t length) {
+    const uint8_t* buf = static_cast<const uint8_t*>(data);
+    while (length > 0) {
+        ssize_t r = write(fd, buf, length);
+        if (r < 0 && errno == EINTR) {
+            continue;
+        } else if (r <= 0) {
+            return false;
+        }
+        buf += r;
+        length -= r;
+    }
+    return true;
+}
+
+} // namespace
+
+zx_status_t BlobCache::IndexPath(const char* path, int fd, fbl::String* out) const {
+    struct stat s;
+    if (fstat(fd, &s) < 0) {
+        return ZX_ERR_IO;
+    }
+#ifdef __APPLE__
+    const struct timespec& mtime = s.st_mtimespec;
+#else
+    const struct timespec& mtime = s.st_mtim;
+#endif
+    char key[PATH_MAX + 96];
+    int len = snprintf(key, sizeof(key), "%s\n%" PRIu64 "\n%" PRIu64 "\n%" PRIu64 ".%09ld\n",
+                       path, static_cast<uint64_t>(s.st_size), static_cast<uint64_t>(s.st_ino),
+                       static_cast<uint64_t>(mtime.tv_sec), static_cast<long>(mtime.tv_nsec));
+    if (len < 0 || static_cast<size_t>(len) >= sizeof(key)) {
+        return ZX_ERR_BUFFER_TOO_SMALL;
+    }
+
+    digest::Digest key_digest;
+    key_digest.Hash(key, len);
+    char hex[digest::Digest::kLength * 2 + 1];
+    zx_status_t status = key_digest.ToString(hex, sizeof(hex));
+    if (status != ZX_OK) {
+        return status;
+    }
+    *out = fbl::String::Concat({dir_, "/index-", hex});
+    return ZX_OK;
+}
+
+zx_status_t BlobCache::BlobPath(const digest::Digest& digest, bool compress,
+                                blobfs::CompressionAlgorithm algorithm, fbl::String* out) const {
+    char hex[digest::Digest::kLength * 2 + 1];
+    zx_status_t status = digest.ToString(hex, sizeof(hex));
+    if (status != ZX_OK) {
+        return status;
+    }
+    *out = fbl::String::Concat({dir_, "/blob-", hex, ".", CompressionSuffix(compress, algorithm)});
+    return ZX_OK;
+}
+
+zx_status_t BlobCache::WriteEntry(const fbl::String& path, const void* const* data,
+                                  const size_t* lengths, size_t count) const {
+    fbl::String tmp = fbl::String::Concat({dir_, "/tmp-XXXXXX"});
+    char tmp_path[PATH_MAX];
+    if (tmp.length() >= sizeof(tmp_path)) {
+        return ZX_ERR_BUFFER_TOO_SMALL;
+    }
+    memcpy(tmp_path, tmp.c_str(), tmp.length() + 1);
+
+    fbl::unique_fd fd(mkstemp(tmp_path));
+    if (!fd) {
+        return ZX_ERR_IO;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (!WriteAll(fd.get(), data[i], lengths[i])) {
+            unlink(tmp_path);
+            return ZX_ERR_IO;
+        }
+    }
+    fd.reset();
+    if (rename(tmp_path, path.c_str()) < 0) {
+        unlink(tmp_path);
+        return ZX_ERR_IO;
+    }
+    return ZX_OK;
+}
+
+bool BlobCache::Lookup(const char* path, int fd, bool compress,
+                       blobfs::CompressionAlgorithm algorithm, blobfs::MerkleInfo* out) const {
+    fbl::String index_path;
+    if (IndexPath(path, fd, &index_path) != ZX_OK) {
+        return false;
+    }
+    uint8_t root[digest::Digest::kLength];
+    {
+        fbl::unique_fd index_fd(open(index_path.c_str(), O_RDONLY));
+        if (!index_fd || !ReadAll(index_fd.get(), root, sizeof(root))) {
+            return false;
+        }
+    }
+
+    fbl::String blob_path;
+    if (BlobPath(digest::Digest(root), compress, algorithm, &blob_path) != ZX_OK) {
+        return false;
+    }
+    fbl::unique_fd blob_fd(open(blob_path.c_str(), O_RDONLY));
+    BlobEntryHeader header;
+    if (!blob_fd || !ReadAll(blob_fd.get(), &header, sizeof(header))) {
+        return false;
+    }
+
+    struct stat s;
+    if (fstat(fd, &s) < 0) {
+        return false;
+    }
+    if (header.magic != kEntryMagic || header.version != kEntryVersion ||
+        header.length != static_cast<uint64_t>(s.st_size) ||
+        header.merkle_length != digest::MerkleTree::GetTreeLength(header.length) ||
+        (header.compressed && header.compressed_length >= header.length)) {
+        return false;
+    }
+
+    fbl::unique_ptr<uint8_t[]> merkle(new uint8_t[header.merkle_length]);
+    if (!ReadAll(blob_fd.get(), merkle.get(), header.merkle_length)) {
+        return false;
+    }
+    if (header.compressed) {
+        // Blobs are written out a whole block at a time.
+        size_t buffer_length = fbl::round_up(header.compressed_length, blobfs::kBlobfsBlockSize);
+        out->compressed_data.reset(new uint8_t[buffer_length]);
+        memset(out->compressed_data.get(), 0, buffer_length);
+        if (!ReadAll(blob_fd.get(), out->compressed_data.get(), header.compressed_length)) {
+            out->compressed_data.reset();
+            return false;
+        }
+        out->compressed_length = header.compressed_length;
+        out->compression = algorithm;
+    }
+    out->compressed = header.compressed != 0;
+    out->digest = root;
+    out->merkle.reset(merkle.release(), header.merkle_length);
+    out->length = header.length;
+    return true;
+}
+
+void BlobCache::Store(const char* path, int fd, bool compress,
+                      blobfs::CompressionAlgorithm algorithm,
+                      const blobfs::MerkleInfo& info) const {
+    fbl::String index_path;
+    fbl::String blob_path;
+    uint8_t root[digest::Digest::kLength];
+    zx_status_t status;
+    if ((status = IndexPath(path, fd, &index_path)) != ZX_OK ||
+        (status = BlobPath(info.digest, compress, algorithm, &blob_path)) != ZX_OK ||
+        (status = info.digest.CopyTo(root, sizeof(root))) != ZX_OK) {
+        fprintf(stderr, "blobfs: cannot cache '%s': %d\n", path, status);
+        return;
+    }
+
+    // Identical files share a blob entry, which only needs writing once.
+    if (access(blob_path.c_str(), F_OK) != 0) {
+        BlobEntryHeader header = {};
+        header.magic = kEntryMagic;
+        header.version = kEntryVersion;
+        header.compressed = info.compressed;
+        header.length = info.length;
+        header.merkle_length = info.merkle.size();
+        header.compressed_length = info.compressed ? info.compressed_length : 0;
+        const void* data[] = {&header, info.merkle.get(), info.compressed_data.get()};
+        const size_t lengths[] = {sizeof(header), header.merkle_length, header.compressed_length};
+        if ((status = WriteEntry(blob_path, data, lengths, header.compressed ? 3 : 2)) != ZX_OK) {
+            fprintf(stderr, "blobfs: cannot cache '%s': %d\n", path, status);
+            return;
+        }
+    }
+
+    const void* data[] = {root};
+    const size_t lengths[] = {sizeof(root)};
+    if ((status = WriteEntry(index_path, data, lengths, 1)) != ZX_OK) {
+        fprintf(stderr, "blobfs: cannot cache '%s': %d\n", path, status);
+    }
+}
@@ -0,0 +1,55 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <blobfs/host.h>
+#include <fbl/macros.h>
+#include <fbl/string.h>
+
+// A cache of blob Merkle trees and compressed contents, kept in a directory
+// so that later builds of an image can skip hashing and compressing blobs
+// which have not changed.
+//
+// The cache is content addressed: each blob is stored once, under its
+// Merkle root and the compression it was prepared with. A small index entry,
+// keyed by the source file's path, size, inode and modification time, maps
+// the source file to its Merkle root, so an unchanged file is found without
+// reading it. A file which changes without its size or modification time
+// changing is not noticed.
+//
+// Lookup and Store may be called from several threads at once. Entries are
+// written to a temporary file and renamed into place, so concurrent builds
+// sharing a cache directory never see partial entries.
+class BlobCache {
+public:
+    DISALLOW_COPY_ASSIGN_AND_MOVE(BlobCache);
+
+    explicit BlobCache(const char* dir)
+        : dir_(dir) {}
+
+    // Fills in |out| for the file open at |fd| if it is cached, prepared
+    // with the same |compress| and |algorithm|. Returns false on a miss.
+    bool Lookup(const char* path, int fd, bool compress, blobfs::CompressionAlgorithm algorithm,
+                blobfs::MerkleInfo* out) const;
+
+    // Records |info|, computed for the file open at |fd|. Failures are
+    // reported but otherwise ignored: the cache only saves time.
+    void Store(const char* path, int fd, bool compress, blobfs::CompressionAlgorithm algorithm,
+               const blobfs::MerkleInfo& info) const;
+
+private:
+    // Returns the path of the index entry for the file open at |fd|.
+    zx_status_t IndexPath(const char* path, int fd, fbl::String* out) const;
+
+    // Returns the path of the entry for the blob with |digest|.
+    zx_status_t BlobPath(const digest::Digest& digest, bool compress,
+                         blobfs::CompressionAlgorithm algorithm, fbl::String* out) const;
+
+    // Atomically replaces |path| with the |count| buffers in |data|.
+    zx_status_t WriteEntry(const fbl::String& path, const void* const* data,
+                           const size_t* lengths, size_t count) const;
+
+    fbl::String dir_;
+};
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <string.h>
 #include <vector>
 
 #include <blobfs/host.h>
@@ -50,17 +51,21 @@ private:
                 rhs.digest.ReleaseBytes();
             });
 
-            for (size_t i = 0; i < digest::Digest::kLength; i++) {
-                if (lhs_bytes[i] < rhs_bytes[i]) {
-                    return true;
-                }
-            }
-            return false;
+            // A strict ordering, so that sorting groups duplicates and the
+            // order blobs are added in is the same on every run.
+            return memcmp(lhs_bytes, rhs_bytes, digest::Digest::kLength) < 0;
         }
     };
 
+    // A blob to be copied into blobfs, and how to compress it if
+    // compression is enabled.
+    struct BlobEntry {
+        fbl::String path;
+        blobfs::CompressionAlgorithm compression;
+    };
+
     // List of all blobs to be copied into blobfs.
-    fbl::Vector<fbl::String> blob_list_;
+    fbl::Vector<BlobEntry> blob_list_;
 
     // A list of Merkle Information for blobs in |blob_list_|.
     std::vector<blobfs::MerkleInfo> merkle_list_;
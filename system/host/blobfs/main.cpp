@@ -10,6 +10,7 @@
 #include <fbl/auto_call.h>
 #include <sys/stat.h>
 
+#include "blob-cache.h"
 #include "blobfs.h"
 
 namespace {
@@ -40,6 +41,8 @@ zx_status_t BlobfsCreator::Usage() {
     fprintf(stderr, "\t'dst/path=src/path'\n");
     fprintf(stderr, "\t'dst/path'\n");
     fprintf(stderr, "with one dst/src pair or single dst per line.\n");
+    fprintf(stderr, "\nBlobs added with --blob-hc are compressed with LZ4HC, which takes longer\n");
+    fprintf(stderr, "to compress them into fewer blocks.\n");
     return status;
 }
 
@@ -60,6 +63,7 @@ bool BlobfsCreator::IsOptionValid(Option option) {
     case Option::kDepfile:
     case Option::kReadonly:
     case Option::kCompress:
+    case Option::kBlobCache:
     case Option::kHelp:
         return true;
     default:
@@ -71,6 +75,7 @@ bool BlobfsCreator::IsArgumentValid(Argument argument) {
     switch (argument) {
     case Argument::kManifest:
     case Argument::kBlob:
+    case Argument::kBlobHighCompression:
         return true;
     default:
         return false;
@@ -93,21 +98,27 @@ zx_status_t BlobfsCreator::ProcessManifestLine(FILE* manifest, const char* dir_p
         return ZX_ERR_INVALID_ARGS;
     }
 
-    blob_list_.push_back(src);
+    blob_list_.push_back({src, blobfs::CompressionAlgorithm::kLz4});
     return ZX_OK;
 }
 
 zx_status_t BlobfsCreator::ProcessCustom(int argc, char** argv, uint8_t* processed) {
     constexpr uint8_t required_args = 2;
-    if (strcmp(argv[0], "--blob")) {
+    blobfs::CompressionAlgorithm compression;
+    if (!strcmp(argv[0], "--blob")) {
+        compression = blobfs::CompressionAlgorithm::kLz4;
+    } else if (!strcmp(argv[0], "--blob-hc")) {
+        compression = blobfs::CompressionAlgorithm::kLz4Hc;
+    } else {
         fprintf(stderr, "Argument not found: %s\n", argv[0]);
         return ZX_ERR_INVALID_ARGS;
-    } else if (argc < required_args) {
+    }
+    if (argc < required_args) {
         fprintf(stderr, "Not enough arguments for %s\n", argv[0]);
         return ZX_ERR_INVALID_ARGS;
     }
 
-    blob_list_.push_back(argv[1]);
+    blob_list_.push_back({argv[1], compression});
     *processed = required_args;
     return ZX_OK;
 }
@@ -119,6 +130,10 @@ zx_status_t BlobfsCreator::CalculateRequiredSize(off_t* out) {
     if (!n_threads) {
         n_threads = 4;
     }
+    fbl::unique_ptr<BlobCache> cache;
+    if (GetBlobCache() != nullptr) {
+        cache.reset(new BlobCache(GetBlobCache()));
+    }
     zx_status_t status = ZX_OK;
     std::mutex mtx;
     for (unsigned j = n_threads; j > 0; j--) {
@@ -135,7 +150,8 @@ zx_status_t BlobfsCreator::CalculateRequiredSize(off_t* out) {
                 if (i >= blob_list_.size()) {
                     return;
                 }
-                const char* path = blob_list_[i].c_str();
+                const char* path = blob_list_[i].path.c_str();
+                const blobfs::CompressionAlgorithm compression = blob_list_[i].compression;
                 zx_status_t res;
                 if ((res = AppendDepfile(path)) != ZX_OK) {
                     mtx.lock();
@@ -147,11 +163,21 @@ zx_status_t BlobfsCreator::CalculateRequiredSize(off_t* out) {
                 blobfs::MerkleInfo info;
                 fbl::unique_fd data_fd(open(path, O_RDONLY, 0644));
 
-                if ((res = blobfs::blobfs_preprocess(data_fd.get(), ShouldCompress(), &info))
-                    != ZX_OK) {
-                    status = res;
-                    mtx.unlock();
-                    return;
+                // Blobs added with --blob-hc are compressed even without --compress.
+                bool compress = ShouldCompress() ||
+                                compression == blobfs::CompressionAlgorithm::kLz4Hc;
+                if (cache == nullptr || !data_fd ||
+                    !cache->Lookup(path, data_fd.get(), compress, compression, &info)) {
+                    if ((res = blobfs::blobfs_preprocess(data_fd.get(), compress, &info,
+                                                         compression)) != ZX_OK) {
+                        mtx.lock();
+                        status = res;
+                        mtx.unlock();
+                        return;
+                    }
+                    if (cache != nullptr) {
+                        cache->Store(path, data_fd.get(), compress, compression, info);
+                    }
                 }
 
                 info.path = path;
@@ -236,42 +262,17 @@ zx_status_t BlobfsCreator::Add() {
         return status;
     }
 
-    std::vector<std::thread> threads;
-    std::mutex mtx;
-
-    unsigned n_threads = std::thread::hardware_concurrency();
-    if (!n_threads) {
-        n_threads = 4;
-    }
-    unsigned blob_index = 0;
-    for (unsigned j = n_threads; j > 0; j--) {
-        threads.push_back(std::thread([&] {
-            unsigned i = 0;
-            while (true) {
-                mtx.lock();
-                i = blob_index++;
-                if (i >= merkle_list_.size()) {
-                    mtx.unlock();
-                    return;
-                }
-                mtx.unlock();
-
-                zx_status_t res;
-                if ((res = AddBlob(blobfs.get(), merkle_list_[i])) < 0) {
-                    mtx.lock();
-                    status = res;
-                    mtx.unlock();
-                    return;
-                }
-            }
-        }));
-    }
-
-    for (unsigned i = 0; i < threads.size(); i++) {
-        threads[i].join();
+    // Hashing and compression already ran in parallel in
+    // CalculateRequiredSize, and adding a blob is serialized on the image
+    // anyway. Adding them in digest order lays the image out the same way
+    // every time it is built from the same blobs.
+    for (const auto& info : merkle_list_) {
+        if ((status = AddBlob(blobfs.get(), info)) < 0) {
+            return status;
+        }
     }
 
-    return status;
+    return ZX_OK;
 }
 
 int main(int argc, char** argv) {
@@ -11,6 +11,7 @@ MODULE_NAME := blobfs
 MODULE_TYPE := hostapp
 
 MODULE_SRCS := \
+    $(LOCAL_DIR)/blob-cache.cpp \
     $(LOCAL_DIR)/main.cpp \
     system/ulib/bitmap/raw-bitmap.cpp \
 
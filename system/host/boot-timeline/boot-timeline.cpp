@@ -0,0 +1,265 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// boot-timeline prints the boot timeline spans in a ktrace capture, as
+// recorded by the kernel's init hooks, userboot, devmgr, devhosts and fshost,
+// and marks the critical path through them.
+//
+//    zircon> dm ktraceoff
+//    host> netcp :/dev/misc/ktrace boot.trace
+//    host> boot-timeline boot.trace
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <lib/zircon-internal/ktrace.h>
+
+namespace {
+
+constexpr size_t kBarWidth = 50;
+
+struct Span {
+    std::string name;
+    uint32_t tid;
+    uint64_t start;
+    uint64_t end;
+    // Nesting depth within the spans of its thread.
+    size_t depth;
+    uint32_t arg;
+    uint32_t result;
+    bool ended;
+    bool critical;
+};
+
+struct ProbeEvent {
+    uint32_t num;
+    uint32_t tid;
+    uint64_t ts;
+    uint32_t phase;
+    uint32_t arg;
+};
+
+bool ReadFile(const char* path, std::vector<uint8_t>* out) {
+    FILE* f = fopen(path, "rb");
+    if (f == nullptr) {
+        fprintf(stderr, "boot-timeline: cannot open '%s'\n", path);
+        return false;
+    }
+    uint8_t buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        out->insert(out->end(), buf, buf + n);
+    }
+    bool ok = !ferror(f);
+    fclose(f);
+    if (!ok) {
+        fprintf(stderr, "boot-timeline: cannot read '%s'\n", path);
+    }
+    return ok;
+}
+
+// Walks the records of a trace, whether it was read from /dev/misc/ktrace
+// (metadata then merged records) or straight from the kernel (metadata then
+// a CPU_BUFFER record before the records of each cpu).
+void ParseTrace(const std::vector<uint8_t>& trace, uint64_t* ticks_per_ms,
+                std::map<uint32_t, std::string>* probe_names,
+                std::vector<ProbeEvent>* events) {
+    size_t off = 0;
+    while (trace.size() - off >= sizeof(uint32_t)) {
+        uint32_t tag;
+        memcpy(&tag, &trace[off], sizeof(tag));
+        size_t len = KTRACE_LEN(tag);
+        if (len == 0 || len > trace.size() - off) {
+            break;
+        }
+        const uint8_t* rec = &trace[off];
+        off += len;
+
+        if (tag == TAG_TICKS_PER_MS && len >= sizeof(ktrace_rec_32b_t)) {
+            ktrace_rec_32b_t r;
+            memcpy(&r, rec, sizeof(r));
+            *ticks_per_ms = r.a | (static_cast<uint64_t>(r.b) << 32);
+        } else if (KTRACE_EVENT(tag) == KTRACE_EVENT(TAG_PROBE_NAME) &&
+                   KTRACE_GROUP(tag) == KTRACE_GROUP(TAG_PROBE_NAME) &&
+                   len > KTRACE_NAMESIZE) {
+            uint32_t id;
+            memcpy(&id, rec + sizeof(uint32_t), sizeof(id));
+            const char* name = reinterpret_cast<const char*>(rec + KTRACE_NAMESIZE);
+            (*probe_names)[id] = std::string(name, strnlen(name, len - KTRACE_NAMESIZE));
+        } else if ((KTRACE_GROUP(tag) & KTRACE_GRP_PROBE) && (KTRACE_EVENT(tag) & 0x800) &&
+                   len >= KTRACE_HDRSIZE + 2 * sizeof(uint32_t)) {
+            ktrace_header_t hdr;
+            memcpy(&hdr, rec, sizeof(hdr));
+            uint32_t args[2];
+            memcpy(args, rec + KTRACE_HDRSIZE, sizeof(args));
+            events->push_back({KTRACE_EVENT(tag) & 0x7FF, hdr.tid, hdr.ts, args[0], args[1]});
+        }
+    }
+}
+
+// Pairs the start and end of each boot span, by probe and thread.
+std::vector<Span> BuildSpans(const std::map<uint32_t, std::string>& probe_names,
+                             std::vector<ProbeEvent> events) {
+    std::stable_sort(events.begin(), events.end(),
+                     [](const ProbeEvent& a, const ProbeEvent& b) { return a.ts < b.ts; });
+
+    std::vector<Span> spans;
+    // The open spans of each thread, innermost last.
+    std::map<uint32_t, std::vector<size_t>> open;
+    for (const ProbeEvent& ev : events) {
+        auto name = probe_names.find(ev.num);
+        if (name == probe_names.end() ||
+            name->second.compare(0, strlen(KTRACE_BOOT_PREFIX), KTRACE_BOOT_PREFIX) != 0) {
+            continue;
+        }
+        std::vector<size_t>& stack = open[ev.tid];
+        if (ev.phase == KTRACE_BOOT_BEGIN) {
+            spans.push_back({name->second.substr(strlen(KTRACE_BOOT_PREFIX)), ev.tid, ev.ts,
+                             ev.ts, stack.size(), ev.arg, 0, false, false});
+            stack.push_back(spans.size() - 1);
+        } else if (ev.phase == KTRACE_BOOT_END) {
+            // Close the innermost open span with this name; any inside it
+            // were never ended.
+            for (size_t n = stack.size(); n-- > 0;) {
+                Span& span = spans[stack[n]];
+                if (span.name.compare(name->second.substr(strlen(KTRACE_BOOT_PREFIX))) == 0) {
+                    span.end = ev.ts;
+                    span.result = ev.arg;
+                    span.ended = true;
+                    stack.resize(n);
+                    break;
+                }
+            }
+        }
+    }
+    return spans;
+}
+
+// Marks the critical path: starting from the span which ended last, each
+// step back is to the span which ended last before it started, since that
+// is the latest thing it could have been waiting for.
+void MarkCriticalPath(std::vector<Span>* spans) {
+    const Span* last = nullptr;
+    for (const Span& span : *spans) {
+        if (span.ended && span.depth == 0 && (last == nullptr || span.end > last->end)) {
+            last = &span;
+        }
+    }
+    while (last != nullptr) {
+        const_cast<Span*>(last)->critical = true;
+        const Span* prev = nullptr;
+        for (const Span& span : *spans) {
+            if (span.ended && span.depth == 0 && span.end <= last->start &&
+                (prev == nullptr || span.end > prev->end)) {
+                prev = &span;
+            }
+        }
+        last = prev;
+    }
+}
+
+void PrintTimeline(const std::vector<Span>& spans, uint64_t ticks_per_ms, bool critical_only) {
+    uint64_t first = UINT64_MAX;
+    uint64_t last = 0;
+    for (const Span& span : spans) {
+        first = std::min(first, span.start);
+        last = std::max(last, span.end);
+    }
+    if (spans.empty()) {
+        printf("no boot spans in trace\n");
+        return;
+    }
+    double span_ticks = static_cast<double>(std::max<uint64_t>(last - first, 1));
+    auto ms = [ticks_per_ms](uint64_t ticks) {
+        return static_cast<double>(ticks) / static_cast<double>(ticks_per_ms);
+    };
+
+    printf("%10s %10s   %-40s %s\n", "start ms", "length ms", "span", "timeline");
+    for (const Span& span : spans) {
+        if (critical_only && !span.critical) {
+            continue;
+        }
+        char bar[kBarWidth + 1];
+        size_t from = static_cast<size_t>((span.start - first) / span_ticks * kBarWidth);
+        size_t to = static_cast<size_t>((span.end - first) / span_ticks * kBarWidth);
+        from = std::min(from, kBarWidth - 1);
+        to = std::max(std::min(to, kBarWidth), from + 1);
+        for (size_t n = 0; n < kBarWidth; n++) {
+            bar[n] = (n >= from && n < to) ? (span.critical ? '#' : '=') : ' ';
+        }
+        bar[kBarWidth] = 0;
+
+        std::string label = std::string(span.depth * 2, ' ') + span.name;
+        if (span.ended) {
+            printf("%10.3f %10.3f %c %-40s |%s| %u -> %d\n", ms(span.start),
+                   ms(span.end - span.start), span.critical ? '*' : ' ', label.c_str(), bar,
+                   span.arg, static_cast<int32_t>(span.result));
+        } else {
+            printf("%10.3f %10s %c %-40s |%s| %u (never ended)\n", ms(span.start), "?",
+                   ' ', label.c_str(), bar, span.arg);
+        }
+    }
+    printf("\n%zu spans over %.3f ms; * marks the critical path\n", spans.size(),
+           ms(last - first));
+}
+
+void Usage() {
+    fprintf(stderr,
+            "usage: boot-timeline [--critical] <trace file>\n"
+            "\n"
+            "Prints the boot timeline spans in a ktrace capture in start order,\n"
+            "indented by nesting, with their length and a bar showing where they\n"
+            "fall, and marks the critical path.\n"
+            "\n"
+            "  --critical   print only the spans on the critical path\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bool critical_only = false;
+    const char* path = nullptr;
+    for (int n = 1; n < argc; n++) {
+        if (!strcmp(argv[n], "--critical")) {
+            critical_only = true;
+        } else if (path == nullptr && argv[n][0] != '-') {
+            path = argv[n];
+        } else {
+            Usage();
+            return 1;
+        }
+    }
+    if (path == nullptr) {
+        Usage();
+        return 1;
+    }
+
+    std::vector<uint8_t> trace;
+    if (!ReadFile(path, &trace)) {
+        return 1;
+    }
+
+    uint64_t ticks_per_ms = 0;
+    std::map<uint32_t, std::string> probe_names;
+    std::vector<ProbeEvent> events;
+    ParseTrace(trace, &ticks_per_ms, &probe_names, &events);
+    if (ticks_per_ms == 0) {
+        fprintf(stderr, "boot-timeline: '%s' has no tick rate record\n", path);
+        return 1;
+    }
+
+    std::vector<Span> spans = BuildSpans(probe_names, std::move(events));
+    MarkCriticalPath(&spans);
+    PrintTimeline(spans, ticks_per_ms, critical_only);
+    return 0;
+}
@@ -4,8 +4,14 @@
 
 #include <inttypes.h>
 
+#include <lz4/lz4.h>
+
 #include "fvm/container.h"
 
+// xxhash is built into lz4, under its namespace.
+#define XXH_NAMESPACE LZ4_
+#include <lz4/xxhash.h>
+
 constexpr size_t kLz4HeaderSize = 15;
 
 static LZ4F_preferences_t lz4_prefs = {
@@ -105,7 +111,7 @@ SparseContainer::SparseContainer(const char* path, uint64_t slice_size, uint32_t
             return;
         }
 
-        if (image_.flags & fvm::kSparseFlagLz4) {
+        if (image_.flags & (fvm::kSparseFlagLz4 | fvm::kSparseFlagChunked)) {
             return;
         }
 
@@ -140,7 +146,8 @@ SparseContainer::~SparseContainer() = default;
 
 zx_status_t SparseContainer::Init() {
     image_.magic = fvm::kSparseFormatMagic;
-    image_.version = fvm::kSparseFormatVersion;
+    image_.version = (flags_ & fvm::kSparseFlagChunked) ? fvm::kSparseFormatVersionChunked
+                                                          : fvm::kSparseFormatVersion;
     image_.slice_size = slice_size_;
     image_.partition_count = 0;
     image_.header_length = sizeof(fvm::sparse_image_t);
@@ -227,8 +234,19 @@ zx_status_t SparseContainer::Commit() {
         return ZX_ERR_IO;
     }
 
+    // A chunked image's header continues with its chunk index.
+    zx_status_t status;
+    fvm::sparse_image_t image = image_;
+    if ((flags_ & fvm::kSparseFlagChunked) != 0) {
+        if ((status = BuildChunkIndex()) != ZX_OK) {
+            return status;
+        }
+        image.header_length += sizeof(fvm::sparse_chunk_index_t) +
+                               chunks_.size() * sizeof(fvm::sparse_chunk_t);
+    }
+
     header_length += sizeof(fvm::sparse_image_t);
-    if (write(fd_.get(), &image_, sizeof(fvm::sparse_image_t)) != sizeof(fvm::sparse_image_t)) {
+    if (write(fd_.get(), &image, sizeof(fvm::sparse_image_t)) != sizeof(fvm::sparse_image_t)) {
         fprintf(stderr, "Write sparse image header failed\n");
         return ZX_ERR_IO;
     }
@@ -259,7 +277,23 @@ zx_status_t SparseContainer::Commit() {
         return ZX_ERR_INTERNAL;
     }
 
-    zx_status_t status;
+    if ((flags_ & fvm::kSparseFlagChunked) != 0) {
+        // The index is written again once the chunks have been compressed.
+        fvm::sparse_chunk_index_t index;
+        index.magic = fvm::kChunkIndexMagic;
+        index.chunk_size = fvm::kSparseChunkSize;
+        index.chunk_count = chunks_.size();
+        chunk_index_offset_ = header_length;
+        chunk_image_offset_ = image.header_length;
+        size_t chunks_length = chunks_.size() * sizeof(fvm::sparse_chunk_t);
+        if (write(fd_.get(), &index, sizeof(index)) != sizeof(index) ||
+            write(fd_.get(), chunks_.get(), chunks_length) !=
+                static_cast<ssize_t>(chunks_length)) {
+            fprintf(stderr, "Write chunk index failed\n");
+            return ZX_ERR_IO;
+        }
+    }
+
     if ((status = PrepareWrite(extent_size_)) != ZX_OK) {
         return status;
     }
@@ -396,7 +430,75 @@ zx_status_t SparseContainer::AllocateExtent(uint32_t part_index, uint64_t slice_
     return ZX_OK;
 }
 
+zx_status_t SparseContainer::BuildChunkIndex() {
+    chunks_.reset();
+    for (uint32_t i = 0; i < image_.partition_count; i++) {
+        for (uint32_t j = 0; j < partitions_[i].descriptor.extent_count; j++) {
+            uint64_t extent_length = partitions_[i].extents[j].extent_length;
+            for (uint64_t offset = 0; offset < extent_length; offset += fvm::kSparseChunkSize) {
+                fvm::sparse_chunk_t chunk = {};
+                chunk.extent_offset = offset;
+                chunk.partition = i;
+                chunk.extent = j;
+                chunk.length = static_cast<uint32_t>(fbl::min(extent_length - offset,
+                                                              fvm::kSparseChunkSize));
+                fbl::AllocChecker ac;
+                chunks_.push_back(chunk, &ac);
+                if (!ac.check()) {
+                    return ZX_ERR_NO_MEMORY;
+                }
+            }
+        }
+    }
+    return ZX_OK;
+}
+
+zx_status_t SparseContainer::FlushChunk() {
+    fvm::sparse_chunk_t* chunk = &chunks_[chunk_next_++];
+    ZX_DEBUG_ASSERT(chunk_fill_ == chunk->length);
+    chunk_fill_ = 0;
+
+    // Chunks which do not shrink are stored as they are.
+    const uint8_t* stored = chunk_data_.get();
+    int r = LZ4_compress_default(reinterpret_cast<const char*>(chunk_data_.get()),
+                                 reinterpret_cast<char*>(chunk_stored_.get()),
+                                 static_cast<int>(chunk->length),
+                                 LZ4_COMPRESSBOUND(fvm::kSparseChunkSize));
+    if (r > 0 && static_cast<uint32_t>(r) < chunk->length) {
+        stored = chunk_stored_.get();
+        chunk->stored_length = r;
+        chunk->flags = fvm::kChunkFlagLz4;
+    } else {
+        chunk->stored_length = chunk->length;
+        chunk->flags = 0;
+    }
+    chunk->image_offset = chunk_image_offset_;
+    chunk->checksum = XXH32(chunk_data_.get(), chunk->length, 0);
+
+    if (write(fd_.get(), stored, chunk->stored_length) !=
+        static_cast<ssize_t>(chunk->stored_length)) {
+        return ZX_ERR_IO;
+    }
+    chunk_image_offset_ += chunk->stored_length;
+    return ZX_OK;
+}
+
 zx_status_t SparseContainer::PrepareWrite(size_t max_len) {
+    if ((flags_ & fvm::kSparseFlagChunked) != 0) {
+        fbl::AllocChecker ac;
+        chunk_data_.reset(new (&ac) uint8_t[fvm::kSparseChunkSize]);
+        if (!ac.check()) {
+            return ZX_ERR_NO_MEMORY;
+        }
+        chunk_stored_.reset(new (&ac) uint8_t[LZ4_COMPRESSBOUND(fvm::kSparseChunkSize)]);
+        if (!ac.check()) {
+            return ZX_ERR_NO_MEMORY;
+        }
+        chunk_next_ = 0;
+        chunk_fill_ = 0;
+        return ZX_OK;
+    }
+
     if ((flags_ & fvm::kSparseFlagLz4) == 0) {
         return ZX_OK;
     }
@@ -405,7 +507,26 @@ zx_status_t SparseContainer::PrepareWrite(size_t max_len) {
 }
 
 zx_status_t SparseContainer::WriteData(const void* data, size_t length) {
-    if ((flags_ & fvm::kSparseFlagLz4) != 0) {
+    if ((flags_ & fvm::kSparseFlagChunked) != 0) {
+        const uint8_t* buf = static_cast<const uint8_t*>(data);
+        while (length > 0) {
+            if (chunk_next_ == chunks_.size()) {
+                fprintf(stderr, "Data overruns the chunk index\n");
+                return ZX_ERR_INTERNAL;
+            }
+            size_t cp = fbl::min(length, chunks_[chunk_next_].length - chunk_fill_);
+            memcpy(chunk_data_.get() + chunk_fill_, buf, cp);
+            chunk_fill_ += cp;
+            buf += cp;
+            length -= cp;
+
+            zx_status_t status;
+            if (chunk_fill_ == chunks_[chunk_next_].length && (status = FlushChunk()) != ZX_OK) {
+                return status;
+            }
+        }
+        return ZX_OK;
+    } else if ((flags_ & fvm::kSparseFlagLz4) != 0) {
         return compression_.Compress(data, length);
     } else if (write(fd_.get(), data, length) != length) {
         return ZX_ERR_IO;
@@ -415,6 +536,24 @@ zx_status_t SparseContainer::WriteData(const void* data, size_t length) {
 }
 
 zx_status_t SparseContainer::CompleteWrite() {
+    if ((flags_ & fvm::kSparseFlagChunked) != 0) {
+        chunk_data_.reset();
+        chunk_stored_.reset();
+        if (chunk_next_ != chunks_.size()) {
+            fprintf(stderr, "Data does not fill the chunk index\n");
+            return ZX_ERR_INTERNAL;
+        }
+
+        // Now that the chunks are stored, fill in where they went.
+        size_t chunks_length = chunks_.size() * sizeof(fvm::sparse_chunk_t);
+        if (pwrite(fd_.get(), chunks_.get(), chunks_length,
+                   chunk_index_offset_ + sizeof(fvm::sparse_chunk_index_t)) !=
+            static_cast<ssize_t>(chunks_length)) {
+            return ZX_ERR_IO;
+        }
+        return ZX_OK;
+    }
+
     if ((flags_ & fvm::kSparseFlagLz4) == 0) {
         return ZX_OK;
     }
@@ -3,6 +3,7 @@
 // found in the LICENSE file.
 
 #include <fvm/fvm-sparse.h>
+#include <minfs/journal.h>
 
 #include "fvm/format.h"
 
@@ -88,6 +89,10 @@ zx_status_t MinfsFormat::MakeFvmReady(size_t slice_size, uint32_t vpart_index) {
     fvm_info_.block_count = static_cast<uint32_t>(fvm_info_.dat_slices * fvm_info_.slice_size /
                                                   minfs::kMinfsBlockSize);
 
+    // The journal shares the superblock's slice, which starts out zeroed.
+    fvm_info_.jnl_block_count = minfs::JournalBlocksFor(
+        static_cast<uint32_t>(kBlocksPerSlice - minfs::kMinfsJournalStart));
+    fvm_info_.jnl_block = (fvm_info_.jnl_block_count != 0) ? minfs::kMinfsJournalStart : 0;
     fvm_info_.ibm_block = minfs::kFVMBlockInodeBmStart;
     fvm_info_.abm_block = minfs::kFVMBlockDataBmStart;
     fvm_info_.ino_block = minfs::kFVMBlockInodeStart;
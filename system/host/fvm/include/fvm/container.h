@@ -178,10 +178,24 @@ private:
     fbl::Vector<partition_info_t> partitions_;
     CompressionContext compression_;
 
+    // State for images with kSparseFlagChunked: the index, and the chunk being filled.
+    fbl::Vector<fvm::sparse_chunk_t> chunks_;
+    size_t chunk_index_offset_ = 0;
+    size_t chunk_next_ = 0;
+    size_t chunk_fill_ = 0;
+    uint64_t chunk_image_offset_ = 0;
+    fbl::unique_ptr<uint8_t[]> chunk_data_;
+    fbl::unique_ptr<uint8_t[]> chunk_stored_;
+
     zx_status_t AllocatePartition(fbl::unique_ptr<Format> format);
     zx_status_t AllocateExtent(uint32_t part_index, uint64_t slice_start, uint64_t slice_count,
                                uint64_t extent_length);
 
+    // Lay out the chunks of each extent, ahead of writing the header.
+    zx_status_t BuildChunkIndex();
+    // Compress and write out the chunk in |chunk_data_|.
+    zx_status_t FlushChunk();
+
     zx_status_t PrepareWrite(size_t max_len);
     zx_status_t WriteData(const void* data, size_t length);
     zx_status_t CompleteWrite();
@@ -31,6 +31,8 @@ int usage(void) {
     fprintf(stderr, " --offset [bytes] - offset at which container begins (fvm only)\n");
     fprintf(stderr, " --length [bytes] - length of container within file (fvm only)\n");
     fprintf(stderr, " --compress - specify that file should be compressed (sparse only)\n");
+    fprintf(stderr, " --chunked - compress in chunks which can be decompressed in parallel"
+                    " (sparse only)\n");
     fprintf(stderr, "Input options:\n");
     fprintf(stderr, " --blob [path] - Add path as blob type (must be blobfs)\n");
     fprintf(stderr, " --data [path] - Add path as encrypted data type (must be minfs)\n");
@@ -147,6 +149,8 @@ int main(int argc, char** argv) {
                 fprintf(stderr, "Invalid compression type\n");
                 return -1;
             }
+        } else if (!strcmp(argv[i], "--chunked")) {
+            flags |= fvm::kSparseFlagChunked;
         } else {
             break;
         }
@@ -154,6 +158,11 @@ int main(int argc, char** argv) {
         ++i;
     }
 
+    if ((flags & fvm::kSparseFlagChunked) && (flags & fvm::kSparseFlagLz4)) {
+        fprintf(stderr, "Chunked images are compressed per chunk; --compress does not apply\n");
+        return -1;
+    }
+
     if (!strcmp(command, "create") && should_unlink) {
         unlink(path);
     }
@@ -44,6 +44,7 @@ MODULE_HOST_LIBS := \
     system/ulib/fs.hostlib \
     system/ulib/digest.hostlib \
     system/ulib/minfs.hostlib \
+    third_party/ulib/cksum.hostlib \
 
 MODULE_PACKAGE := bin
 
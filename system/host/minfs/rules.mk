@@ -31,6 +31,7 @@ MODULE_HOST_LIBS := \
     system/ulib/fs.hostlib \
     system/ulib/minfs.hostlib \
     system/ulib/fs-host.hostlib \
+    third_party/ulib/cksum.hostlib \
 
 MODULE_PACKAGE := bin
 
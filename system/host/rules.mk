@@ -7,6 +7,7 @@ LOCAL_DIR := $(GET_LOCAL_DIR)
 HOSTAPPS := \
     $(LOCAL_DIR)/abigen/rules.mk \
     $(LOCAL_DIR)/blobfs/rules.mk \
+    $(LOCAL_DIR)/boot-timeline/rules.mk \
     $(LOCAL_DIR)/bootserver/rules.mk \
     $(LOCAL_DIR)/banjo/compiler/rules.mk \
     $(LOCAL_DIR)/banjo/formatter/rules.mk \
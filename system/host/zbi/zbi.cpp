@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
 #include <cerrno>
 #include <climits>
@@ -26,6 +27,7 @@
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/uio.h>
+#include <thread>
 #include <unistd.h>
 #include <utility>
 #include <vector>
@@ -33,7 +35,9 @@
 #include <fbl/macros.h>
 #include <fbl/unique_fd.h>
 #include <lib/cksum.h>
+#include <lz4/lz4.h>
 #include <lz4/lz4frame.h>
+#include <lz4/lz4hc.h>
 #include <zircon/boot/image.h>
 
 namespace {
@@ -408,9 +412,6 @@ private:
     uint32_t crc_ = 0;
 };
 
-// This tells LZ4f_compressUpdate it can keep a pointer to data.
-constexpr const LZ4F_compressOptions_t kCompressOpt = {1, {}};
-
 class Compressor {
 public:
     DISALLOW_COPY_AND_ASSIGN_ALLOW_MOVE(Compressor);
@@ -439,11 +440,7 @@ public:
 
         prefs_.frameInfo.blockSizeID = LZ4F_max64KB;
         prefs_.frameInfo.blockMode = LZ4F_blockIndependent;
-
-        // LZ4 compression levels 1-3 are for "fast" compression, and 4-16
-        // are for higher compression. The additional compression going from
-        // 4 to 16 is not worth the extra time needed during compression.
-        prefs_.compressionLevel = 4;
+        prefs_.compressionLevel = kCompressionLevel;
 
         LZ4F_CALL(LZ4F_createCompressionContext, &ctx_, LZ4F_VERSION);
 
@@ -452,8 +449,8 @@ public:
         header_.extra = header_.length;
         header_.length = 0;
 
-        // This might start writing compression format headers before it
-        // receives any data.
+        // Only the frame header comes from the LZ4F library.  The blocks
+        // are independent, so Finish compresses them on their own.
         auto buffer = GetBuffer(kLZ4FMaxHeaderFrameSize);
         size_t size = LZ4F_CALL(LZ4F_compressBegin, ctx_,
                                 buffer.data.get(), buffer.size, &prefs_);
@@ -467,22 +464,32 @@ public:
 
     // NOTE: Input buffer may be referenced for the life of the Compressor!
     void Write(OutputStream* out, const iovec& input) {
-        auto buffer = GetBuffer(LZ4F_compressBound(input.iov_len, &prefs_));
-        size_t actual_size = LZ4F_CALL(LZ4F_compressUpdate,
-                                       ctx_, buffer.data.get(), buffer.size,
-                                       input.iov_base, input.iov_len,
-                                       &kCompressOpt);
-        WriteBuffer(out, std::move(buffer), actual_size);
+        if (input.iov_len > 0) {
+            input_.push_back(input);
+        }
     }
 
     uint32_t Finish(OutputStream* out) {
-        // Write the closing chunk from the compressor.
-        auto buffer = GetBuffer(LZ4F_compressBound(0, &prefs_));
-        size_t actual_size = LZ4F_CALL(LZ4F_compressEnd,
-                                       ctx_, buffer.data.get(), buffer.size,
-                                       &kCompressOpt);
+        // Compress a batch of blocks at a time on all CPUs, so the
+        // compressed data waiting to be written stays bounded.
+        std::vector<Block> blocks;
+        do {
+            blocks.clear();
+            Block block;
+            while (blocks.size() < kBatchBlocks && NextBlock(&block)) {
+                blocks.push_back(std::move(block));
+            }
+            CompressBlocks(&blocks);
+            for (auto& block : blocks) {
+                WriteBuffer(out, std::move(block.output), block.output_size);
+            }
+        } while (!input_.empty());
 
-        WriteBuffer(out, std::move(buffer), actual_size);
+        // Write the end mark closing the frame.  There is no content
+        // checksum to follow it.
+        auto buffer = GetBuffer(sizeof(uint32_t));
+        memset(buffer.data.get(), 0, sizeof(uint32_t));
+        WriteBuffer(out, std::move(buffer), sizeof(uint32_t));
 
         // Complete the checksum.
         crc_.FinalizeHeader(&header_);
@@ -511,14 +518,39 @@ private:
         std::unique_ptr<std::byte[]> data;
         size_t size = 0;
     } unused_buffer_;
+
+    // One LZ4 frame block: up to kBlockSize bytes of input, compressed on
+    // its own into its size word and data.
+    struct Block {
+        const std::byte* input = nullptr;
+        size_t input_size = 0;
+        // Holds the input of a block that spans several input buffers.
+        std::unique_ptr<std::byte[]> staging;
+        Buffer output;
+        size_t output_size = 0;
+    };
+
     zbi_header_t header_;
     Checksummer crc_;
     LZ4F_compressionContext_t ctx_;
     LZ4F_preferences_t prefs_{};
     uint32_t header_pos_ = 0;
+    std::deque<iovec> input_;
     // IOV_MAX buffers might be live at once.
     static constexpr const size_t kMinBufferSize = (128 << 20) / IOV_MAX;
 
+    // This matches LZ4F_max64KB.
+    static constexpr const size_t kBlockSize = 64 << 10;
+    static constexpr const size_t kBatchBlocks = 1024;
+
+    // The high bit of a block's size word marks it as stored uncompressed.
+    static constexpr const uint32_t kUncompressedBlock = 1u << 31;
+
+    // LZ4 compression levels 1-3 are for "fast" compression, and 4-16
+    // are for higher compression. The additional compression going from
+    // 4 to 16 is not worth the extra time needed during compression.
+    static constexpr const int kCompressionLevel = 4;
+
     Buffer GetBuffer(size_t max_size) {
         if (unused_buffer_.size >= max_size) {
             // We have an old buffer that will do fine.
@@ -543,15 +575,101 @@ private:
             unused_buffer_ = std::move(buffer);
         }
     }
+
+    // Takes the input for the next block, returning false if there is none
+    // left.  Every block but the last one is full, as LZ4F would make it.
+    bool NextBlock(Block* block) {
+        if (input_.empty()) {
+            return false;
+        }
+        *block = {};
+        auto& first = input_.front();
+        if (first.iov_len >= kBlockSize || input_.size() == 1) {
+            // The block lies within one input buffer: use it in place.
+            block->input = static_cast<const std::byte*>(first.iov_base);
+            block->input_size = std::min(first.iov_len, kBlockSize);
+            Consume(block->input_size);
+            return true;
+        }
+        block->staging = std::make_unique<std::byte[]>(kBlockSize);
+        while (block->input_size < kBlockSize && !input_.empty()) {
+            auto& iov = input_.front();
+            size_t chunk = std::min(iov.iov_len, kBlockSize - block->input_size);
+            memcpy(&block->staging[block->input_size], iov.iov_base, chunk);
+            block->input_size += chunk;
+            Consume(chunk);
+        }
+        block->input = block->staging.get();
+        return true;
+    }
+
+    void Consume(size_t size) {
+        auto& iov = input_.front();
+        iov.iov_base = static_cast<std::byte*>(iov.iov_base) + size;
+        iov.iov_len -= size;
+        if (iov.iov_len == 0) {
+            input_.pop_front();
+        }
+    }
+
+    static void CompressBlock(Block* block) {
+        auto size = LZ4_COMPRESSBOUND(block->input_size);
+        block->output = {std::make_unique<std::byte[]>(sizeof(uint32_t) + size),
+                         sizeof(uint32_t) + size};
+        auto dst = block->output.data.get() + sizeof(uint32_t);
+        // Anything that doesn't get smaller is stored uncompressed.
+        uint32_t compressed = LZ4_compress_HC(
+            reinterpret_cast<const char*>(block->input),
+            reinterpret_cast<char*>(dst),
+            static_cast<int>(block->input_size),
+            static_cast<int>(block->input_size - 1), kCompressionLevel);
+        uint32_t word = compressed;
+        if (compressed == 0) {
+            memcpy(dst, block->input, block->input_size);
+            compressed = static_cast<uint32_t>(block->input_size);
+            word = compressed | kUncompressedBlock;
+        }
+        memcpy(block->output.data.get(), &word, sizeof(word));
+        block->output_size = sizeof(uint32_t) + compressed;
+        block->staging.reset();
+    }
+
+    static void CompressBlocks(std::vector<Block>* blocks) {
+        size_t n_threads = std::thread::hardware_concurrency();
+        if (!n_threads) {
+            n_threads = 4;
+        }
+        if (n_threads > blocks->size()) {
+            n_threads = blocks->size();
+        }
+        std::atomic<size_t> next_block(0);
+        auto worker = [&] {
+            size_t i;
+            while ((i = next_block++) < blocks->size()) {
+                CompressBlock(&(*blocks)[i]);
+            }
+        };
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < n_threads; ++i) {
+            threads.push_back(std::thread(worker));
+        }
+        worker();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
 };
 
 const size_t Compressor::kMinBufferSize;
 
 constexpr const LZ4F_decompressOptions_t kDecompressOpt{};
 
+// The buffer returned is zero-filled past the data up to |buffer_length|.
 std::unique_ptr<std::byte[]> Decompress(const std::list<const iovec>& payload,
-                                        uint32_t decompressed_length) {
-    auto buffer = std::make_unique<std::byte[]>(decompressed_length);
+                                        uint32_t decompressed_length,
+                                        size_t buffer_length = 0) {
+    auto buffer = std::make_unique<std::byte[]>(
+        std::max<size_t>(decompressed_length, buffer_length));
 
     LZ4F_decompressionContext_t ctx;
     LZ4F_CALL(LZ4F_createDecompressionContext, &ctx, LZ4F_VERSION);
@@ -592,6 +710,35 @@ std::unique_ptr<std::byte[]> Decompress(const std::list<const iovec>& payload,
     return buffer;
 }
 
+// Compress one BOOTFS file as a single frame with the same settings as
+// Compressor, which is what the target's decompressor handles.  The
+// buffer returned is zero-filled to a whole number of pages.
+std::unique_ptr<std::byte[]> CompressFile(const iovec& file,
+                                          size_t* compressed_size) {
+    LZ4F_preferences_t prefs{};
+    prefs.frameInfo.contentSize = file.iov_len;
+    prefs.frameInfo.blockSizeID = LZ4F_max64KB;
+    prefs.frameInfo.blockMode = LZ4F_blockIndependent;
+    prefs.compressionLevel = 4;
+
+    size_t bound = LZ4F_compressFrameBound(file.iov_len, &prefs);
+    auto buffer = std::make_unique<std::byte[]>(ZBI_BOOTFS_PAGE_ALIGN(bound));
+    *compressed_size = LZ4F_CALL(LZ4F_compressFrame, buffer.get(), bound,
+                                 file.iov_base, file.iov_len, &prefs);
+    return buffer;
+}
+
+// Get the size of the BOOTFS file compressed by CompressFile.
+size_t CompressedFileSize(const iovec& compressed) {
+    LZ4F_decompressionContext_t ctx;
+    LZ4F_CALL(LZ4F_createDecompressionContext, &ctx, LZ4F_VERSION);
+    LZ4F_frameInfo_t info;
+    size_t nread = compressed.iov_len;
+    LZ4F_CALL(LZ4F_getFrameInfo, ctx, &info, compressed.iov_base, &nread);
+    LZ4F_CALL(LZ4F_freeDecompressionContext, ctx);
+    return info.contentSize;
+}
+
 #undef LZ4F_CALL
 
 class FileContents {
@@ -610,6 +757,15 @@ public:
           owned_(false) {
     }
 
+    // Get unowned file contents from a buffer that is zero-filled
+    // to a whole number of pages.
+    FileContents(const std::byte* buffer, size_t size)
+        : mapped_(const_cast<std::byte*>(buffer)),
+          mapped_size_(ZBI_BOOTFS_PAGE_ALIGN(size)),
+          exact_size_(size),
+          owned_(false) {
+    }
+
     // Get unowned file contents from a string.
     // This object won't support PageRoundedView.
     FileContents(const char* buffer, bool null_terminate)
@@ -1218,13 +1374,15 @@ Extracted items use the file names shown below:\n\
                                 const Filter& include_file,
                                 bool sort,
                                 const std::string& prefix,
-                                bool compress) {
+                                bool compress,
+                                bool compress_files) {
         auto item = MakeItem(NewHeader(ZBI_TYPE_STORAGE_BOOTFS, 0), compress);
 
         // Collect the names and exact sizes here and the contents in payload_.
         struct Entry {
             std::string name;
             uint32_t data_len = 0;
+            bool compressed = false;
         };
         std::deque<Entry> entries;
         size_t dirsize = 0, bodysize = 0;
@@ -1245,6 +1403,25 @@ Extracted items use the file names shown below:\n\
                     exit(1);
                 }
                 uint32_t size = ZBI_BOOTFS_PAGE_ALIGN(entry.data_len);
+                if (compress_files && entry.data_len > 0) {
+                    // Keep the compressed file only if it saves a page.
+                    size_t compressed_size;
+                    auto compressed = CompressFile(
+                        next.file.View(0, entry.data_len), &compressed_size);
+                    uint32_t compressed_pages =
+                        ZBI_BOOTFS_PAGE_ALIGN(compressed_size);
+                    if (compressed_pages < size) {
+                        entry.data_len = static_cast<uint32_t>(compressed_size);
+                        entry.compressed = true;
+                        size = compressed_pages;
+                        bodysize += size;
+                        item->payload_.emplace_back(
+                            Iovec(compressed.get(), size));
+                        item->OwnBuffer(std::move(compressed));
+                        entries.push_back(std::move(entry));
+                        continue;
+                    }
+                }
                 bodysize += size;
                 item->payload_.emplace_back(
                     next.file.PageRoundedView(0, size));
@@ -1283,7 +1460,8 @@ Extracted items use the file names shown below:\n\
             const zbi_bootfs_dirent_t entry_hdr = {
                 static_cast<uint32_t>(entry.name.size() + 1), // name_len
                 entry.data_len,                               // data_len
-                data_off,                                     // data_off
+                data_off | (entry.compressed ?                // data_off
+                            ZBI_BOOTFS_DIRENT_COMPRESSED : 0),
             };
             data_off += static_cast<uint32_t>(file.iov_len);
             buffer.Append(&entry_hdr);
@@ -1589,18 +1767,22 @@ private:
 
     bool CheckBootFSDirent(const zbi_bootfs_dirent_t& entry,
                            bool always_print) const {
+        const uint32_t data_off = ZBI_BOOTFS_DIRENT_DATA_OFF(entry.data_off);
+        const bool compressed = entry.data_off & ZBI_BOOTFS_DIRENT_COMPRESSED;
         const char* align_check =
-            entry.data_off % ZBI_BOOTFS_PAGE_SIZE == 0 ? "" : "[ERROR: misaligned offset] ";
+            (entry.data_off & ~ZBI_BOOTFS_DIRENT_COMPRESSED) % ZBI_BOOTFS_PAGE_SIZE == 0
+                ? "" : "[ERROR: misaligned offset] ";
         const char* size_check =
-            (entry.data_off < header_.length &&
-             header_.length - entry.data_off >= entry.data_len)
+            (data_off < header_.length &&
+             header_.length - data_off >= entry.data_len)
                 ? ""
                 : "[ERROR: offset+size too large] ";
         bool ok = align_check[0] == '\0' && size_check[0] == '\0';
         if (always_print || !ok) {
             fprintf(always_print ? stdout : stderr,
-                    "        : %08x %08x %s%s%.*s\n",
-                    entry.data_off, entry.data_len,
+                    "        : %08x %08x %s%s%s%.*s\n",
+                    data_off, entry.data_len,
+                    compressed ? "[compressed] " : "",
                     align_check, size_check,
                     static_cast<int>(entry.name_len), entry.name);
         }
@@ -1644,7 +1826,24 @@ private:
                 exit(1);
             }
             value->target = dir_->name;
-            value->file = FileContents(*dir_, item_->payload_data());
+            if (dir_->data_off & ZBI_BOOTFS_DIRENT_COMPRESSED) {
+                // The generated FileContents point into the Item's storage,
+                // so the decompressed file is kept there too.
+                const iovec compressed = Iovec(
+                    item_->payload_data() +
+                        ZBI_BOOTFS_DIRENT_DATA_OFF(dir_->data_off),
+                    dir_->data_len);
+                size_t size = CompressedFileSize(compressed);
+                std::list<const iovec> payload;
+                payload.emplace_back(compressed);
+                auto buffer = Decompress(payload,
+                                         static_cast<uint32_t>(size),
+                                         ZBI_BOOTFS_PAGE_ALIGN(size));
+                value->file = FileContents(buffer.get(), size);
+                item_->OwnBuffer(std::move(buffer));
+            } else {
+                value->file = FileContents(*dir_, item_->payload_data());
+            }
             ++dir_;
             return true;
         }
@@ -1716,10 +1915,11 @@ const char* IncompleteImage(const ItemList& items, const uint32_t image_arch) {
     return nullptr;
 }
 
-constexpr const char kOptString[] = "-B:cd:e:FxXRg:hto:p:sT:uv";
+constexpr const char kOptString[] = "-B:cCd:e:FxXRg:hto:p:sT:uv";
 constexpr const option kLongOpts[] = {
     {"complete", required_argument, nullptr, 'B'},
     {"compressed", no_argument, nullptr, 'c'},
+    {"compress-files", no_argument, nullptr, 'C'},
     {"depfile", required_argument, nullptr, 'd'},
     {"entry", required_argument, nullptr, 'e'},
     {"files", no_argument, nullptr, 'F'},
@@ -1786,6 +1986,8 @@ Format control switches (last switch affects all output):\n\
     --complete=ARCH, -B ARCH       verify result is a complete boot image\n\
     --compressed, -c               compress BOOTFS images (default)\n\
     --uncompressed, -u             do not compress BOOTFS images\n\
+    --compress-files, -C           compress each BOOTFS file on its own,\n\
+                                   instead of the whole BOOTFS image\n\
     --sort, -s                     sort BOOTFS entries by name\n\
 \n\
 In all cases there is only a single BOOTFS item (if any) written out.\n\
@@ -1827,6 +2029,7 @@ int main(int argc, char** argv) {
     bool input_manifest = true;
     uint32_t input_type = ZBI_TYPE_DISCARD;
     bool compressed = true;
+    bool compress_files = false;
     bool extract = false;
     bool extract_items = false;
     bool extract_raw = false;
@@ -1939,6 +2142,10 @@ int main(int argc, char** argv) {
             compressed = false;
             continue;
 
+        case 'C':
+            compress_files = true;
+            continue;
+
         case 's':
             sort = true;
             continue;
@@ -2114,7 +2321,8 @@ int main(int argc, char** argv) {
             Item::CreateBootFS(&opener, bootfs_input, [&](const char* name) {
                 return extract_items || name_matcher.Matches(name);
             },
-                               sort, prefix, compressed));
+                               sort, prefix, compressed && !compress_files,
+                               compress_files));
     }
 
     if (items.empty()) {
@@ -274,7 +274,8 @@ __END_CDECLS;
 //   data offset (32bit le)
 //   namedata   (namelength bytes, includes \0)
 //
-// - data offsets must be page aligned (multiple of 4096)
+// - data offsets must be page aligned (multiple of 4096), apart from
+//   the BOOTFS_ENTRY_COMPRESSED flag
 // - entries start on uint32 boundaries
 
 //lsw of sha256("bootfs")
@@ -310,6 +311,11 @@ typedef struct bootfs_entry {
 #define BOOTFS_RECSIZE(entry) \
     (sizeof(bootfs_entry_t) + BOOTFS_ALIGN(entry->name_len))
 
+// set in data_off when the file is stored as an LZ4 frame of data_len
+// bytes, whose header holds the size of the file
+#define BOOTFS_ENTRY_COMPRESSED (1u)
+#define BOOTFS_ENTRY_DATA_OFF(entry) ((entry)->data_off & -BOOTFS_PAGE_SIZE)
+
 static inline bool bootdata_is_metadata(uint32_t type) {
     return ((type & BOOTDATA_KIND_MASK) == BOOTDATA_KIND_METADATA);
 }
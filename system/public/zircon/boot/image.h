@@ -317,7 +317,8 @@ typedef struct {
     uint32_t data_len;
 
     // Offset from the beginning of the payload (zbi_bootfs_header_t) to
-    // the file's data.  This must be a multiple of ZBI_BOOTFS_PAGE_SIZE.
+    // the file's data.  This must be a multiple of ZBI_BOOTFS_PAGE_SIZE,
+    // apart from the ZBI_BOOTFS_DIRENT_COMPRESSED flag.
     uint32_t data_off;
 
     // Pathname of the file, a UTF-8 string.  This must include a NUL
@@ -335,6 +336,17 @@ typedef struct {
 // zbi_bootfs_dirent_t.name_len must be > 1 and <= ZBI_BOOTFS_MAX_NAME_LEN.
 #define ZBI_BOOTFS_MAX_NAME_LEN         (256)
 
+// Set in zbi_bootfs_dirent_t.data_off when the file is stored compressed,
+// as a single LZ4 frame in the format of a ZBI_FLAG_STORAGE_COMPRESSED
+// payload.  data_len is then the size of the frame, and the size of the
+// file is the content size in the frame's header.  Readers that don't
+// know the flag see a misaligned offset and reject the entry.
+#define ZBI_BOOTFS_DIRENT_COMPRESSED    (1u)
+
+// The offset of the file's data in zbi_bootfs_dirent_t.data_off.
+#define ZBI_BOOTFS_DIRENT_DATA_OFF(data_off) \
+    ((data_off) & -ZBI_BOOTFS_PAGE_SIZE)
+
 
 // The remaining types are used to communicate information from the boot
 // loader to the kernel.  Usually these are synthesized in memory by the
@@ -404,6 +404,12 @@ typedef struct audio_rb_position_notify {
     // The current position (in bytes) of the driver/hardware's read (output) or
     // write (input) pointer in the ring buffer.
     uint32_t ring_buffer_pos;
+
+    // The time (on the monotonic clock) at which the pointer was observed at
+    // ring_buffer_pos, or 0 if the driver does not report one.  Pairs of these
+    // let clients recover the rate of the audio clock relative to the monotonic
+    // clock without waiting for the pointer to move through the whole ring.
+    zx_time_t monotonic_time;
 } audio_rb_position_notify_t;
 
 __END_CDECLS
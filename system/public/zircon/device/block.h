@@ -77,6 +77,19 @@
 // clears the counters
 #define IOCTL_BLOCK_GET_STATS   \
     IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_BLOCK, 18)
+// Set up another FIFO to the running FIFO server, served by a thread of its
+// own. VMOs attached to the server may be used on any of its FIFOs, and each
+// FIFO has transaction groups of its own. Shut down with the server.
+#define IOCTL_BLOCK_ADD_FIFO \
+    IOCTL(IOCTL_KIND_GET_HANDLE, IOCTL_FAMILY_BLOCK, 19)
+// Give the running FIFO server a VMO holding a block_completion_ring_t,
+// to post transaction group responses to instead of its FIFO.
+#define IOCTL_BLOCK_ATTACH_COMPLETION_RING \
+    IOCTL(IOCTL_KIND_SET_HANDLE, IOCTL_FAMILY_BLOCK, 20)
+// Get counters of how often block ops sent to an FVM partition had to be
+// split across noncontiguous physical slices.
+#define IOCTL_BLOCK_FVM_GET_SPLIT_STATS \
+    IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_BLOCK, 21)
 
 // Block Impl ioctls (specific to each block device):
 
@@ -84,6 +97,7 @@
 #define BLOCK_FLAG_REMOVABLE 0x00000002
 #define BLOCK_FLAG_BOOTPART 0x00000004  // block device has bootdata partition map
                                         // provided by device metadata
+#define BLOCK_FLAG_TRIM_SUPPORT 0x00000008  // block device supports BLOCK_OP_TRIM
 
 #define BLOCK_MAX_TRANSFER_UNBOUNDED 0xFFFFFFFF
 
@@ -139,6 +153,13 @@ IOCTL_WRAPPER_INOUT(ioctl_block_attach_vmo, IOCTL_BLOCK_ATTACH_VMO, zx_handle_t,
 // ssize_t ioctl_block_fifo_close(int fd);
 IOCTL_WRAPPER(ioctl_block_fifo_close, IOCTL_BLOCK_FIFO_CLOSE);
 
+// ssize_t ioctl_block_add_fifo(int fd, zx_handle_t* fifo_out);
+IOCTL_WRAPPER_OUT(ioctl_block_add_fifo, IOCTL_BLOCK_ADD_FIFO, zx_handle_t);
+
+// ssize_t ioctl_block_attach_completion_ring(int fd, zx_handle_t* ring_vmo);
+IOCTL_WRAPPER_IN(ioctl_block_attach_completion_ring, IOCTL_BLOCK_ATTACH_COMPLETION_RING,
+                 zx_handle_t);
+
 #define GUID_LEN 16
 #define NAME_LEN 24
 #define MAX_FVM_VSLICE_REQUESTS 16
@@ -207,6 +228,17 @@ typedef struct {
 // ssize_t ioctl_block_fvm_upgrade(int fd, const upgrade_req_t* req);
 IOCTL_WRAPPER_IN(ioctl_block_fvm_upgrade, IOCTL_BLOCK_FVM_UPGRADE, upgrade_req_t);
 
+typedef struct {
+    uint64_t total_ops;   // Read and write ops received.
+    uint64_t split_ops;   // Ops split into one op per physical slice.
+    uint64_t split_txns;  // Ops sent to the parent device for split ops.
+    uint64_t pool_misses; // Split ops which allocated, rather than using the pool.
+} fvm_split_stats_t;
+
+// ssize_t ioctl_block_fvm_get_split_stats(int fd, fvm_split_stats_t* out);
+IOCTL_WRAPPER_OUT(ioctl_block_fvm_get_split_stats, IOCTL_BLOCK_FVM_GET_SPLIT_STATS,
+                  fvm_split_stats_t);
+
 // ssize_t ioctl_block_get_stats(int fd, bool clear, block_stats_t* out)
 IOCTL_WRAPPER_INOUT(ioctl_block_get_stats, IOCTL_BLOCK_GET_STATS, bool, block_stats_t);
 
@@ -320,3 +352,31 @@ static_assert(sizeof(block_fifo_request_t) == sizeof(block_fifo_response_t),
 
 #define BLOCK_FIFO_ESIZE (sizeof(block_fifo_request_t))
 #define BLOCK_FIFO_MAX_DEPTH (4096 / BLOCK_FIFO_ESIZE)
+
+// Once a completion ring is attached with IOCTL_BLOCK_ATTACH_COMPLETION_RING,
+// the responses to transaction groups are posted to it rather than written
+// to the FIFO, so that a client may poll for them without sleeping. Responses
+// to requests outside of groups still arrive on the FIFO, as do group
+// responses which find the ring full.
+//
+// The server posts responses[head % BLOCK_COMPLETION_RING_SIZE], then
+// advances |head|; the client consumes responses up to |head|, then advances
+// |tail|. Both are only accessed atomically. A client about to sleep sets
+// |waiting| and then checks |head| again: the server raises
+// BLOCK_COMPLETION_RING_SIGNAL on the client's end of the FIFO after posting
+// a response while |waiting| is set.
+#define BLOCK_COMPLETION_RING_SIZE 64
+#define BLOCK_COMPLETION_RING_SIGNAL ZX_USER_SIGNAL_0
+
+typedef struct {
+    uint64_t head;
+    uint64_t reserved0[7];
+    uint64_t tail;
+    uint32_t waiting;
+    uint32_t reserved1[13];
+    block_fifo_response_t responses[BLOCK_COMPLETION_RING_SIZE];
+} block_completion_ring_t;
+
+// The FIFO server and the FIFOs added to it with IOCTL_BLOCK_ADD_FIFO
+// number at most BLOCK_FIFO_MAX_SESSIONS.
+#define BLOCK_FIFO_MAX_SESSIONS 8
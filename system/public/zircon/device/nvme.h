@@ -0,0 +1,32 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <zircon/device/ioctl-wrapper.h>
+#include <zircon/device/ioctl.h>
+
+typedef struct {
+    // read and write ops received
+    uint64_t txns;
+    // the NVMe commands they were broken into
+    uint64_t commands;
+    // ops that took more than one command
+    uint64_t split_txns;
+    // commands that described their data with an SGL instead of PRPs
+    uint64_t sgl_commands;
+    // PRP list pages beyond the first taken from the pool
+    uint64_t prp_pool_pages;
+    // times a command had to wait for PRP list pages to come back to the pool
+    uint64_t prp_pool_waits;
+} nvme_stats_t;
+
+// Get the counters of the controller's io queues, summed.
+#define IOCTL_NVME_GET_STATS \
+    IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_NVME, 1)
+
+// ssize_t ioctl_nvme_get_stats(int fd, nvme_stats_t* stats);
+IOCTL_WRAPPER_OUT(ioctl_nvme_get_stats, IOCTL_NVME_GET_STATS, nvme_stats_t);
@@ -24,6 +24,8 @@
     IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_RAMDISK, 5)
 #define IOCTL_RAMDISK_GET_BLK_COUNTS \
     IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_RAMDISK, 6)
+#define IOCTL_RAMDISK_SET_PERF \
+    IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_RAMDISK, 7)
 
 // Ramdisk-specific flags
 #define RAMDISK_FLAG_RESUME_ON_WAKE 0xFF000001
@@ -44,6 +46,23 @@ typedef struct ramdisk_blk_counts {
     uint64_t failed;
 } ramdisk_blk_counts_t;
 
+// Most requests a ramdisk serves at once.
+#define RAMDISK_MAX_THREADS 16
+
+// Commit and map in all of the ramdisk's memory up front, so that no request
+// pays for a page fault.
+#define RAMDISK_PERF_FLAG_COMMIT 0x1
+
+typedef struct ramdisk_perf {
+    // Number of requests served at once; 0 and 1 both mean one at a time.
+    uint32_t threads;
+    uint32_t flags;
+    // Time added to every read and write, 0 for none.
+    uint64_t latency_ns;
+    // Most reads and writes completed per second, 0 for no limit.
+    uint64_t max_iops;
+} ramdisk_perf_t;
+
 // ssize_t ioctl_ramdisk_config(int fd, const ramdisk_ioctl_config_t* in,
 //                              ramdisk_ioctl_config_response_t* out);
 IOCTL_WRAPPER_INOUT(ioctl_ramdisk_config, IOCTL_RAMDISK_CONFIG, ramdisk_ioctl_config_t,
@@ -81,3 +100,10 @@ IOCTL_WRAPPER_IN(ioctl_ramdisk_sleep_after, IOCTL_RAMDISK_SLEEP_AFTER, uint64_t)
 // Retrieve the number of received, successful, and failed block writes since the last call to
 // sleep/wake.
 IOCTL_WRAPPER_OUT(ioctl_ramdisk_get_blk_counts, IOCTL_RAMDISK_GET_BLK_COUNTS, ramdisk_blk_counts_t);
+
+// ssize_t ioctl_ramdisk_set_perf(int fd, const ramdisk_perf_t* in);
+// Shape the ramdisk to look like a faster or slower device, for benchmarks.
+// Serving requests on more than one thread can't be combined with
+// |ioctl_ramdisk_sleep_after|; either fails with ZX_ERR_BAD_STATE while the
+// other is in effect.
+IOCTL_WRAPPER_IN(ioctl_ramdisk_set_perf, IOCTL_RAMDISK_SET_PERF, ramdisk_perf_t);
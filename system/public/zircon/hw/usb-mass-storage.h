@@ -24,6 +24,7 @@
 #define UMS_READ16                   0x88
 #define UMS_WRITE16                  0x8A
 #define UMS_READ_CAPACITY16          0x9E
+#define UMS_REPORT_LUNS              0xA0
 #define UMS_READ12                   0xA8
 #define UMS_WRITE12                  0xAA
 
@@ -154,3 +155,83 @@ typedef struct {
     uint8_t     bmCSWStatus;
 } __PACKED ums_csw_t;
 static_assert(sizeof(ums_csw_t) == 13, "");
+
+// USB Attached SCSI (UAS)
+
+// Pipe Usage descriptor, following each endpoint descriptor of a UAS interface
+#define UAS_DT_PIPE_USAGE           0x24
+typedef struct {
+    uint8_t     bLength;
+    uint8_t     bDescriptorType;    // UAS_DT_PIPE_USAGE
+    uint8_t     bPipeID;
+    uint8_t     reserved;
+} __PACKED uas_pipe_usage_descriptor_t;
+static_assert(sizeof(uas_pipe_usage_descriptor_t) == 4, "");
+
+// bPipeID values
+#define UAS_PIPE_COMMAND            1
+#define UAS_PIPE_STATUS             2
+#define UAS_PIPE_DATA_IN            3
+#define UAS_PIPE_DATA_OUT           4
+
+// Information Unit IDs
+#define UAS_IU_COMMAND              0x01
+#define UAS_IU_SENSE                0x03
+#define UAS_IU_RESPONSE             0x04
+#define UAS_IU_TASK_MANAGEMENT      0x05
+#define UAS_IU_READ_READY           0x06
+#define UAS_IU_WRITE_READY          0x07
+
+// Command IU
+// This is big endian
+typedef struct {
+    uint8_t     iu_id;              // UAS_IU_COMMAND
+    uint8_t     reserved;
+    uint16_t    tag;
+    uint8_t     task_attribute;     // bits 0-2: task attribute, bits 3-6: priority
+    uint8_t     reserved2;
+    uint8_t     additional_cdb_length;
+    uint8_t     reserved3;
+    uint64_t    lun;
+    uint8_t     cdb[16];
+} __PACKED uas_command_iu_t;
+static_assert(sizeof(uas_command_iu_t) == 32, "");
+#define UAS_TASK_ATTRIBUTE_SIMPLE   0
+
+// Sense IU
+// This is big endian
+typedef struct {
+    uint8_t     iu_id;              // UAS_IU_SENSE
+    uint8_t     reserved;
+    uint16_t    tag;
+    uint16_t    status_qualifier;
+    uint8_t     status;             // SCSI status
+    uint8_t     reserved2[7];
+    uint16_t    sense_length;
+    uint8_t     sense_data[18];
+} __PACKED uas_sense_iu_t;
+static_assert(sizeof(uas_sense_iu_t) == 34, "");
+
+// Response IU
+// This is big endian
+typedef struct {
+    uint8_t     iu_id;              // UAS_IU_RESPONSE
+    uint8_t     reserved;
+    uint16_t    tag;
+    uint8_t     additional_response_info[3];
+    uint8_t     response_code;
+} __PACKED uas_response_iu_t;
+static_assert(sizeof(uas_response_iu_t) == 8, "");
+
+// READ READY and WRITE READY IUs
+// This is big endian
+typedef struct {
+    uint8_t     iu_id;              // UAS_IU_READ_READY or UAS_IU_WRITE_READY
+    uint8_t     reserved;
+    uint16_t    tag;
+} __PACKED uas_ready_iu_t;
+static_assert(sizeof(uas_ready_iu_t) == 4, "");
+
+// SCSI status values
+#define SCSI_STATUS_GOOD            0x00
+#define SCSI_STATUS_CHECK_CONDITION 0x02
@@ -63,6 +63,7 @@ __BEGIN_CDECLS;
 
 #define USB_SUBCLASS_MSC_SCSI               0x06
 #define USB_PROTOCOL_MSC_BULK_ONLY          0x50
+#define USB_PROTOCOL_MSC_UAS                0x62
 
 /* Descriptor Types */
 #define USB_DT_DEVICE                      0x01
@@ -213,6 +214,8 @@ typedef struct {
 } __attribute__ ((packed)) usb_ss_ep_comp_descriptor_t;
 #define usb_ss_ep_comp_isoc_mult(ep) ((ep)->bmAttributes & 0x3)
 #define usb_ss_ep_comp_isoc_comp(ep) (!!((ep)->bmAttributes & 0x80))
+// log2 of the number of streams a bulk endpoint supports, or 0 if it has none
+#define usb_ss_ep_comp_bulk_max_streams(ep) ((ep)->bmAttributes & 0x1F)
 
 typedef struct {
     uint8_t bLength;
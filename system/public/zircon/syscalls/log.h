@@ -52,4 +52,13 @@ typedef struct zx_log_record {
 
 #define ZX_LOG_FLAG_READABLE  0x40000000
 
+// zx_debuglog_read() options
+
+// Read as many whole records as fit in the buffer rather than one.  Each
+// record starts on an 8 byte boundary, so the one after a record of n bytes
+// is ZX_LOG_RECORD_ALIGN(n) bytes further on.
+#define ZX_LOG_READ_BATCH     0x00000001
+
+#define ZX_LOG_RECORD_ALIGN(n) (((n) + 7) & ~((size_t)7))
+
 __END_CDECLS
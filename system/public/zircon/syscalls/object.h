@@ -36,6 +36,18 @@ typedef uint32_t zx_object_info_topic_t;
 #define ZX_INFO_PROCESS_HANDLE_STATS    ((zx_object_info_topic_t) 21u) // zx_info_process_handle_stats_t[1]
 #define ZX_INFO_SOCKET                  ((zx_object_info_topic_t) 22u) // zx_info_socket_t[1]
 #define ZX_INFO_VMO                     ((zx_object_info_topic_t) 23u) // zx_info_vmo_t[1]
+#define ZX_INFO_KMEM_OBJECT_CACHES      ((zx_object_info_topic_t) 24u) // zx_info_kmem_object_cache_t[n]
+#define ZX_INFO_SYSCALL_STATS           ((zx_object_info_topic_t) 25u) // zx_info_syscall_stats_t[n]
+#define ZX_INFO_TASK_SCHED_STATS        ((zx_object_info_topic_t) 26u) // zx_info_task_sched_stats_t[1]
+#define ZX_INFO_CPU_SCHED_STATS         ((zx_object_info_topic_t) 27u) // zx_info_cpu_sched_stats_t[n]
+#define ZX_INFO_VMO_WORKING_SET         ((zx_object_info_topic_t) 28u) // zx_info_vmo_working_set_t[1]
+#define ZX_INFO_KMEM_NUMA_STATS         ((zx_object_info_topic_t) 29u) // zx_info_kmem_numa_node_t[n]
+#define ZX_INFO_CHANNEL_STATS           ((zx_object_info_topic_t) 30u) // zx_info_channel_stats_t[1]
+
+// Cursors for zx_object_get_info_paged.  Any other value is opaque, and only
+// good for passing back to the call which returned it.
+#define ZX_INFO_CURSOR_START            ((uint64_t) 0u)
+#define ZX_INFO_CURSOR_END              ((uint64_t) -1)
 
 typedef uint32_t zx_obj_props_t;
 #define ZX_OBJ_PROP_NONE                ((zx_obj_props_t)0u)
@@ -105,11 +117,38 @@ typedef struct zx_info_thread {
     uint32_t wait_exception_port_type;
 } zx_info_thread_t;
 
+// Number of buckets in a run queue wait histogram. Bucket 0 counts waits
+// shorter than 1024ns, bucket i counts waits in [2^(9+i), 2^(10+i)) ns, and
+// the last bucket also counts everything longer.
+#define ZX_INFO_RUN_QUEUE_WAIT_BUCKETS 16u
+
 typedef struct zx_info_thread_stats {
     // Total accumulated running time of the thread.
     zx_duration_t total_runtime;
 } zx_info_thread_stats_t;
 
+// Scheduler statistics for a thread. For a process or a job, the sum over
+// all of the threads it contains or ever contained.
+typedef struct zx_info_task_sched_stats {
+    // Total accumulated running time.
+    zx_duration_t total_runtime;
+
+    // Total and longest time the thread was ready to run but waiting in a
+    // run queue for a cpu.
+    zx_duration_t total_run_queue_wait;
+    zx_duration_t max_run_queue_wait;
+
+    // Number of times the thread was switched onto a cpu.
+    uint64_t context_switches;
+
+    // Number of times the thread was switched off a cpu while still
+    // runnable, because it was preempted or yielded.
+    uint64_t preemptions;
+
+    // Run queue waits, bucketed by length.
+    uint64_t run_queue_wait_histogram[ZX_INFO_RUN_QUEUE_WAIT_BUCKETS];
+} zx_info_task_sched_stats_t;
+
 // Statistics about resources (e.g., memory) used by a task. Can be relatively
 // expensive to gather.
 typedef struct zx_info_task_stats {
@@ -178,6 +217,23 @@ typedef struct zx_info_socket {
     size_t tx_buf_size;
 } zx_info_socket_t;
 
+// Transfer statistics of one channel endpoint, since it was created.
+typedef struct zx_info_channel_stats {
+    // The number of messages written and read through this endpoint. Reads
+    // include the replies to zx_channel_call().
+    uint64_t messages_sent;
+    uint64_t messages_received;
+
+    // Payload bytes the kernel copied in from writers and out to readers of
+    // this endpoint.
+    uint64_t bytes_copied_in;
+    uint64_t bytes_copied_out;
+
+    // The total size of the VMOs whose handles were written through this
+    // endpoint. Their contents change owner without being copied.
+    uint64_t vmo_bytes_moved;
+} zx_info_channel_stats_t;
+
 // Types and values used by ZX_INFO_PROCESS_MAPS.
 
 // Describes a VM mapping.
@@ -305,6 +361,17 @@ typedef struct zx_info_vmo {
     uint32_t cache_policy;
 } zx_info_vmo_t;
 
+// Describes how much of a VMO's memory is in use.
+typedef struct zx_info_vmo_working_set {
+    // The amount of memory currently allocated to the VMO, as in the
+    // |committed_bytes| of |zx_info_vmo_t|.
+    uint64_t committed_bytes;
+
+    // The part of |committed_bytes| that was accessed recently, an estimate
+    // of the VMO's working set.
+    uint64_t working_set_bytes;
+} zx_info_vmo_working_set_t;
+
 // kernel statistics per cpu
 // TODO(cpu), expose the deprecated stats via a new syscall.
 typedef struct zx_info_cpu_stats {
@@ -333,6 +400,18 @@ typedef struct zx_info_cpu_stats {
     uint64_t generic_ipis;
 } zx_info_cpu_stats_t;
 
+// scheduler statistics per cpu
+typedef struct zx_info_cpu_sched_stats {
+    uint32_t cpu_number;
+    uint32_t flags;         // ZX_INFO_CPU_STATS_FLAG_* values, as for zx_info_cpu_stats_t
+
+    // time threads spent waiting in this cpu's run queue before running on
+    // it, bucketed as for zx_info_task_sched_stats_t
+    zx_duration_t total_run_queue_wait;
+    zx_duration_t max_run_queue_wait;
+    uint64_t run_queue_wait_histogram[ZX_INFO_RUN_QUEUE_WAIT_BUCKETS];
+} zx_info_cpu_sched_stats_t;
+
 // Information about kernel memory usage.
 // Can be expensive to gather.
 typedef struct zx_info_kmem_stats {
@@ -373,6 +452,65 @@ typedef struct zx_info_kmem_stats {
     uint64_t other_bytes;
 } zx_info_kmem_stats_t;
 
+// Information about the memory of one NUMA node.
+typedef struct zx_info_kmem_numa_node {
+    // The number of the node, from 0.
+    uint32_t node;
+    uint32_t padding1;
+
+    // The portion of the |free_bytes| of |zx_info_kmem_stats_t| local to
+    // the node.
+    uint64_t free_bytes;
+} zx_info_kmem_numa_node_t;
+
+// Information about one of the caches kernel objects are allocated from.
+typedef struct zx_info_kmem_object_cache {
+    // The type of object the cache holds, e.g. "channel".
+    char name[ZX_MAX_NAME_LEN];
+
+    // The size in bytes of each object in the cache.
+    uint64_t object_size;
+
+    // The number of objects currently allocated from the cache.
+    uint64_t live_objects;
+
+    // The number of objects that can be allocated from slabs the cache
+    // already holds.
+    uint64_t free_objects;
+
+    // The number of slabs the cache holds, and the most it may ever hold.
+    uint64_t slab_count;
+    uint64_t max_slab_count;
+
+    // The size in bytes of each slab.
+    uint64_t slab_size;
+} zx_info_kmem_object_cache_t;
+
+// Number of buckets in a syscall latency histogram. Bucket 0 counts calls
+// shorter than 128ns, bucket i counts calls in [2^(6+i), 2^(7+i)) ns, and
+// the last bucket also counts everything longer.
+#define ZX_INFO_SYSCALL_LATENCY_BUCKETS 20u
+
+// Statistics for one syscall, summed over all cpus, since they were last
+// reset. Only recorded while enabled with the "syscalls" kernel console
+// command or the kernel.syscall-stats boot option.
+typedef struct zx_info_syscall_stats {
+    // The syscall number, one of the ZX_SYS_* values.
+    uint32_t syscall_num;
+    uint32_t padding1;
+
+    // Number of times the syscall was made.
+    uint64_t calls;
+
+    // Total and longest time spent in the syscall, including any time
+    // spent blocked.
+    zx_duration_t total_time;
+    zx_duration_t max_time;
+
+    // Calls, bucketed by how long they took.
+    uint64_t latency_histogram[ZX_INFO_SYSCALL_LATENCY_BUCKETS];
+} zx_info_syscall_stats_t;
+
 typedef struct zx_info_resource {
     // The resource kind; resource object kinds are detailed in the resource.md
     uint32_t kind;
@@ -423,6 +561,14 @@ typedef struct zx_info_resource {
 // Terminate this job if the system is low on memory.
 #define ZX_PROP_JOB_KILL_ON_OOM             15u
 
+// Argument is a zx_duration_t, describing how late the timeouts of a
+// thread's waits may fire.
+#define ZX_PROP_THREAD_TIMER_SLACK          16u
+
+// Argument is a size_t, counted in fifo elements.
+#define ZX_PROP_FIFO_RX_THRESHOLD           17u
+#define ZX_PROP_FIFO_TX_THRESHOLD           18u
+
 // Basic thread states, in zx_info_thread_t.state.
 #define ZX_THREAD_STATE_NEW                 ((zx_thread_state_t) 0x0000u)
 #define ZX_THREAD_STATE_RUNNING             ((zx_thread_state_t) 0x0001u)
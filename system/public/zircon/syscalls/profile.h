@@ -12,6 +12,7 @@ __BEGIN_CDECLS
 // clang-format off
 
 #define ZX_PROFILE_INFO_SCHEDULER   1
+#define ZX_PROFILE_INFO_DEADLINE    2
 
 typedef struct zx_profile_scheduler {
     int32_t priority;
@@ -26,10 +27,20 @@ typedef struct zx_profile_scheduler {
 #define ZX_PRIORITY_HIGH                24
 #define ZX_PRIORITY_HIGHEST             31
 
+// A thread with a deadline profile is guaranteed |capacity| of cpu time in
+// every |period|, delivered within |relative_deadline| of the start of the
+// period. It must hold that 0 < capacity <= relative_deadline <= period.
+typedef struct zx_profile_deadline {
+    zx_duration_t capacity;
+    zx_duration_t relative_deadline;
+    zx_duration_t period;
+} zx_profile_deadline_t;
+
 typedef struct zx_profile_info {
     uint32_t type;                  // one of ZX_PROFILE_INFO_
     union {
         zx_profile_scheduler_t scheduler;
+        zx_profile_deadline_t deadline;
     };
 } zx_profile_info_t;
 
@@ -143,6 +143,8 @@ typedef uint32_t zx_signals_t;
 #define ZX_FIFO_READABLE            __ZX_OBJECT_READABLE
 #define ZX_FIFO_WRITABLE            __ZX_OBJECT_WRITABLE
 #define ZX_FIFO_PEER_CLOSED         __ZX_OBJECT_PEER_CLOSED
+#define ZX_FIFO_READ_THRESHOLD      __ZX_OBJECT_SIGNAL_4
+#define ZX_FIFO_WRITE_THRESHOLD     __ZX_OBJECT_SIGNAL_5
 
 // Task signals (process, thread, job)
 #define ZX_TASK_TERMINATED          __ZX_OBJECT_SIGNALED
@@ -188,6 +190,17 @@ typedef struct zx_channel_call_args {
     uint32_t rd_num_handles;
 } zx_channel_call_args_t;
 
+// Structure for zx_socket_writev() and zx_socket_readv(), describing one
+// buffer of a scatter-gather transfer.
+typedef struct zx_iovec {
+    void* buffer;
+    size_t capacity;
+} zx_iovec_t;
+
+// Maximum number of buffers allowed in one zx_socket_writev() or
+// zx_socket_readv() call.
+#define ZX_SOCKET_IOV_MAX ((size_t)16)
+
 // Maximum number of wait items allowed for zx_object_wait_many()
 // TODO(ZX-1349) Re-lower this.
 #define ZX_WAIT_MANY_MAX_ITEMS ((size_t)16)
@@ -199,6 +212,20 @@ typedef struct zx_wait_item {
     zx_signals_t pending;
 } zx_wait_item_t;
 
+#define ZX_SIGNAL_MANY_MAX_ITEMS ((size_t)64)
+
+// Structure for zx_object_signal_many():
+typedef struct zx_signal_item {
+    zx_handle_t handle;
+    uint32_t options;
+    zx_signals_t clear_mask;
+    zx_signals_t set_mask;
+} zx_signal_item_t;
+
+// zx_signal_item_t options:
+// Signal the object's peer, as zx_object_signal_peer() does.
+#define ZX_SIGNAL_ITEM_PEER ((uint32_t)1u)
+
 typedef uint32_t zx_rights_t;
 #define ZX_RIGHT_NONE             ((zx_rights_t)0u)
 #define ZX_RIGHT_DUPLICATE        ((zx_rights_t)1u << 0)
@@ -239,6 +266,12 @@ typedef uint32_t zx_rights_t;
 
 // VM Object creation options
 #define ZX_VMO_NON_RESIZABLE             ((uint32_t)1u)
+// Prefer physical memory from the NUMA node encoded with ZX_VMO_NUMA_NODE().
+#define ZX_VMO_PREFER_NUMA_NODE          ((uint32_t)1u << 1)
+#define ZX_VMO_NUMA_NODE_SHIFT           (8u)
+#define ZX_VMO_NUMA_NODE_MASK            ((uint32_t)0xffu << ZX_VMO_NUMA_NODE_SHIFT)
+#define ZX_VMO_NUMA_NODE(n)              (ZX_VMO_PREFER_NUMA_NODE | \
+    (((uint32_t)(n) << ZX_VMO_NUMA_NODE_SHIFT) & ZX_VMO_NUMA_NODE_MASK))
 
 // VM Object opcodes
 #define ZX_VMO_OP_COMMIT                 ((uint32_t)1u)
@@ -255,6 +288,9 @@ typedef uint32_t zx_rights_t;
 #define ZX_VMO_CLONE_COPY_ON_WRITE        ((uint32_t)1u << 0)
 #define ZX_VMO_CLONE_NON_RESIZEABLE       ((uint32_t)1u << 1)
 
+// VM Object transfer flags
+#define ZX_VMO_TRANSFER_MOVE              ((uint32_t)1u << 0)
+
 typedef uint32_t zx_vm_option_t;
 // Mapping flags to vmar routines
 #define ZX_VM_PERM_READ             ((zx_vm_option_t)(1u << 0))
@@ -269,6 +305,7 @@ typedef uint32_t zx_vm_option_t;
 #define ZX_VM_CAN_MAP_EXECUTE       ((zx_vm_option_t)(1u << 9))
 #define ZX_VM_MAP_RANGE             ((zx_vm_option_t)(1u << 10))
 #define ZX_VM_REQUIRE_NON_RESIZABLE ((zx_vm_option_t)(1u << 11))
+#define ZX_VM_COMMIT                ((zx_vm_option_t)(1u << 12))
 
 
 // virtual address
@@ -302,6 +339,9 @@ typedef uint64_t zx_off_t;
 #define ZX_INTERRUPT_MODE_MASK       ((uint32_t)0xe)
 #define ZX_INTERRUPT_VIRTUAL         ((uint32_t)0x10)
 
+// zx_interrupt_bind() options
+#define ZX_INTERRUPT_BIND_POLL       ((uint32_t)0x1u)
+
 // Preallocated virtual interrupt slot, typically used for signaling interrupt threads to exit.
 #define ZX_INTERRUPT_SLOT_USER              ((uint32_t)62u)
 // interrupt wait slots must be in the range 0 - 62 inclusive
@@ -382,7 +422,8 @@ typedef uint32_t zx_obj_type_t;
 #define ZX_OBJ_TYPE_PROFILE         ((zx_obj_type_t)25u)
 #define ZX_OBJ_TYPE_PMT             ((zx_obj_type_t)26u)
 #define ZX_OBJ_TYPE_SUSPEND_TOKEN   ((zx_obj_type_t)27u)
-#define ZX_OBJ_TYPE_LAST            ((zx_obj_type_t)28u)
+#define ZX_OBJ_TYPE_PAGER           ((zx_obj_type_t)28u)
+#define ZX_OBJ_TYPE_LAST            ((zx_obj_type_t)29u)
 
 typedef struct zx_handle_info {
     zx_handle_t handle;
@@ -405,6 +446,7 @@ typedef struct zx_handle_info {
 #define ZX_VM_FLAG_CAN_MAP_EXECUTE        ((uint32_t)1u << 9)
 #define ZX_VM_FLAG_MAP_RANGE              ((uint32_t)1u << 10)
 #define ZX_VM_FLAG_REQUIRE_NON_RESIZABLE  ((uint32_t)1u << 11)
+#define ZX_VM_FLAG_COMMIT                 ((uint32_t)1u << 12)
 
 #ifdef __cplusplus
 // We cannot use <stdatomic.h> with C++ code as _Atomic qualifier defined by
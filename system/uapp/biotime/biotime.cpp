@@ -4,42 +4,28 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <threads.h>
 #include <unistd.h>
 
 #include <fbl/atomic.h>
+#include <fbl/string_printf.h>
+#include <fbl/unique_ptr.h>
+#include <fbl/vector.h>
 #include <lib/sync/completion.h>
 #include <lib/zircon-internal/xorshiftrand.h>
+#include <perftest/histogram.h>
 #include <perftest/results.h>
 #include <zircon/device/block.h>
 #include <zircon/syscalls.h>
 #include <zircon/time.h>
 #include <zircon/types.h>
 
-static uint64_t number(const char* str) {
-    char* end;
-    uint64_t n = strtoull(str, &end, 10);
-
-    uint64_t m = 1;
-    switch (*end) {
-    case 'G':
-    case 'g':
-        m = 1024*1024*1024;
-        break;
-    case 'M':
-    case 'm':
-        m = 1024*1024;
-        break;
-    case 'K':
-    case 'k':
-        m = 1024;
-        break;
-    }
-    return m * n;
-}
+#include "job.h"
 
 static void bytes_per_second(uint64_t bytes, uint64_t nanos) {
     double s = ((double)nanos) / ((double)1000000000);
@@ -118,6 +104,10 @@ fail:
     return ZX_ERR_INTERNAL;
 }
 
+// Far more than the queue depth, so that a slot is only reused long after
+// its request completed.
+static constexpr size_t kIssueSlots = 65536;
+
 typedef struct {
     blkdev_t* blk;
     size_t count;
@@ -129,10 +119,18 @@ typedef struct {
 
     fbl::atomic<int> pending;
     sync_completion_t signal;
+
+    // When each request in flight was issued, indexed by issue_slot().
+    zx_time_t issue_times[kIssueSlots];
+    perftest::LatencyHistogram latencies;
 } bio_random_args_t;
 
 static fbl::atomic<reqid_t> next_reqid(0);
 
+static size_t issue_slot(reqid_t reqid) {
+    return reqid % kIssueSlots;
+}
+
 static int bio_random_thread(void* arg) {
     auto* a = reinterpret_cast<bio_random_args_t*>(arg);
 
@@ -180,6 +178,7 @@ static int bio_random_thread(void* arg) {
         fprintf(stderr, "IO tid=%u vid=%u op=%x len=%zu vof=%zu dof=%zu\n",
                 req.reqid, req.vmoid, req.opcode, req.length, req.vmo_offset, req.dev_offset);
 #endif
+        a->issue_times[issue_slot(req.reqid)] = zx_clock_get_monotonic();
         zx_status_t r = zx_fifo_write(fifo, sizeof(req), &req, 1, NULL);
         if (r == ZX_ERR_SHOULD_WAIT) {
             r = zx_object_wait_one(fifo, ZX_FIFO_WRITABLE | ZX_FIFO_PEER_CLOSED,
@@ -234,6 +233,8 @@ static zx_status_t bio_random(bio_random_args_t* a, uint64_t* _total, zx_duratio
                     resp.status, count);
             goto fail;
         }
+        a->latencies.Add(zx_time_sub_time(zx_clock_get_monotonic(),
+                                          a->issue_times[issue_slot(resp.reqid)]));
         count--;
         if (a->pending.fetch_sub(1) == a->max_pending) {
             sync_completion_signal(&a->signal);
@@ -256,8 +257,212 @@ fail:
     return ZX_ERR_IO;
 }
 
+
+typedef struct {
+    uint64_t total;
+    uint64_t count;
+    zx_duration_t duration;
+    perftest::LatencyHistogram latencies;
+} job_result_t;
+
+// Drives a block device through its FIFO, keeping up to |queue_depth|
+// requests in flight.
+static zx_status_t run_block_job(const Job& job, job_result_t* result) {
+    int fd;
+    if ((fd = open(job.target.c_str(), O_RDONLY)) < 0) {
+        fprintf(stderr, "error: cannot open '%s'\n", job.target.c_str());
+        return ZX_ERR_NOT_FOUND;
+    }
+    blkdev_t blk;
+    if (blkdev_open(fd, job.target.c_str(), 8*1024*1024, &blk) != ZX_OK) {
+        return ZX_ERR_IO;
+    }
+
+    // Too big for the stack.
+    fbl::unique_ptr<bio_random_args_t> a(new bio_random_args_t());
+    a->blk = &blk;
+    a->xfer = job.block_size;
+    a->seed = job.seed;
+    a->max_pending = job.queue_depth;
+    a->write = job.write;
+    a->linear = job.linear;
+
+    size_t total = job.total;
+    size_t devtotal = blk.info.block_count * blk.info.block_size;
+
+    // default to entire device
+    if ((total == 0) || (total > devtotal)) {
+        total = devtotal;
+    }
+    a->count = total / a->xfer;
+
+    zx_status_t status = bio_random(a.get(), &result->total, &result->duration);
+    blkdev_close(&blk);
+    if (status != ZX_OK) {
+        return status;
+    }
+    result->count = a->count;
+    result->latencies = a->latencies;
+    return ZX_OK;
+}
+
+typedef struct {
+    const Job* job;
+    int fd;
+    // This thread's share of the file: |count| operations within
+    // [|base|, |base| + |span|).
+    size_t base;
+    size_t span;
+    size_t count;
+    uint64_t seed;
+    zx_status_t status;
+    perftest::LatencyHistogram latencies;
+} file_thread_args_t;
+
+static int file_thread(void* arg) {
+    auto* a = reinterpret_cast<file_thread_args_t*>(arg);
+    const size_t xfer = a->job->block_size;
+    const size_t blkcount = a->span / xfer;
+    fbl::unique_ptr<uint8_t[]> buffer(new uint8_t[xfer]());
+    rand64_t r64 = RAND63SEED(a->seed);
+
+    for (size_t i = 0; i < a->count; i++) {
+        off_t off = static_cast<off_t>(
+            a->base + (a->job->linear ? i % blkcount : rand64(&r64) % blkcount) * xfer);
+        zx_time_t t0 = zx_clock_get_monotonic();
+        ssize_t actual = a->job->write ? pwrite(a->fd, buffer.get(), xfer, off)
+                                       : pread(a->fd, buffer.get(), xfer, off);
+        a->latencies.Add(zx_time_sub_time(zx_clock_get_monotonic(), t0));
+        if (actual != static_cast<ssize_t>(xfer)) {
+            fprintf(stderr, "error: %s of %zu bytes at %jd failed: %s\n",
+                    a->job->write ? "write" : "read", xfer, static_cast<intmax_t>(off),
+                    actual < 0 ? strerror(errno) : "short transfer");
+            a->status = ZX_ERR_IO;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Reads or writes a file through the filesystem, with |queue_depth|
+// threads each doing one operation at a time on its own part of the file.
+static zx_status_t run_file_job(const Job& job, job_result_t* result) {
+    int flags = job.write ? (O_RDWR | O_CREAT) : O_RDONLY;
+    int fd = open(job.target.c_str(), flags, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "error: cannot open '%s': %s\n", job.target.c_str(), strerror(errno));
+        return ZX_ERR_NOT_FOUND;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        fprintf(stderr, "error: cannot stat '%s'\n", job.target.c_str());
+        close(fd);
+        return ZX_ERR_IO;
+    }
+    size_t file_size = static_cast<size_t>(st.st_size);
+    size_t total = job.total;
+    if (total == 0 || (!job.write && total > file_size)) {
+        total = file_size;
+    }
+    if (total < job.block_size * job.queue_depth) {
+        fprintf(stderr, "error: '%s' is too small for %d threads of %zu byte transfers; "
+                        "set the job's size\n",
+                job.target.c_str(), job.queue_depth, job.block_size);
+        close(fd);
+        return ZX_ERR_INVALID_ARGS;
+    }
+    if (job.write && total > file_size && ftruncate(fd, static_cast<off_t>(total)) < 0) {
+        fprintf(stderr, "error: cannot grow '%s' to %zu bytes\n", job.target.c_str(), total);
+        close(fd);
+        return ZX_ERR_NO_SPACE;
+    }
+
+    const size_t threads = static_cast<size_t>(job.queue_depth);
+    size_t count = total / job.block_size;
+    size_t span = (total / threads) / job.block_size * job.block_size;
+    fbl::unique_ptr<file_thread_args_t[]> args(new file_thread_args_t[threads]());
+    fbl::unique_ptr<thrd_t[]> thread_ids(new thrd_t[threads]);
+
+    zx_time_t t0 = zx_clock_get_monotonic();
+    size_t started = 0;
+    for (size_t i = 0; i < threads; i++) {
+        file_thread_args_t* a = &args[i];
+        a->job = &job;
+        a->fd = fd;
+        a->base = i * span;
+        a->span = span;
+        a->count = count / threads + (i < count % threads ? 1 : 0);
+        a->seed = job.seed + i;
+        a->status = ZX_OK;
+        if (thrd_create(&thread_ids[i], file_thread, a) != thrd_success) {
+            fprintf(stderr, "error: cannot create thread\n");
+            break;
+        }
+        started++;
+    }
+    zx_status_t status = started == threads ? ZX_OK : ZX_ERR_NO_RESOURCES;
+    for (size_t i = 0; i < started; i++) {
+        thrd_join(thread_ids[i], nullptr);
+        if (args[i].status != ZX_OK) {
+            status = args[i].status;
+        }
+        result->latencies.Merge(args[i].latencies);
+    }
+    zx_time_t t1 = zx_clock_get_monotonic();
+    close(fd);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    result->count = count;
+    result->total = count * job.block_size;
+    result->duration = zx_time_sub_time(t1, t0);
+    return ZX_OK;
+}
+
+static const struct {
+    const char* name;
+    double fraction;
+} kPercentiles[] = {
+    {"P50", 0.50},
+    {"P90", 0.90},
+    {"P99", 0.99},
+    {"P999", 0.999},
+};
+
+// Prints |result| and adds it to |results|, under labels starting with
+// |prefix|.
+static void report(const char* prefix, const job_result_t& result,
+                   perftest::ResultsSet* results) {
+    fprintf(stderr, "%zu bytes in %zu ns: ", result.total, result.duration);
+    bytes_per_second(result.total, result.duration);
+    fprintf(stderr, "%zu ops in %zu ns: ", result.count, result.duration);
+    ops_per_second(result.count, result.duration);
+    fprintf(stderr, "latency: min %" PRIu64 " ns, mean %" PRIu64 " ns", result.latencies.min(),
+            result.latencies.mean());
+    for (const auto& p : kPercentiles) {
+        fprintf(stderr, ", %s %" PRIu64 " ns", p.name, result.latencies.Percentile(p.fraction));
+    }
+    fprintf(stderr, ", max %" PRIu64 " ns\n", result.latencies.max());
+
+    auto* test_case = results->AddTestCase(
+        "fuchsia.zircon", fbl::StringPrintf("%sThroughput", prefix), "bytes/second");
+    double time_in_seconds = static_cast<double>(result.duration) / 1e9;
+    test_case->AppendValue(static_cast<double>(result.total) / time_in_seconds);
+    for (const auto& p : kPercentiles) {
+        test_case = results->AddTestCase(
+            "fuchsia.zircon", fbl::StringPrintf("%sLatency/%s", prefix, p.name), "nanoseconds");
+        test_case->AppendValue(static_cast<double>(result.latencies.Percentile(p.fraction)));
+    }
+    test_case = results->AddTestCase(
+        "fuchsia.zircon", fbl::StringPrintf("%sLatency/Max", prefix), "nanoseconds");
+    test_case->AppendValue(static_cast<double>(result.latencies.max()));
+}
+
 void usage(void) {
     fprintf(stderr, "usage: biotime <option>* <device>\n"
+                    "       biotime <option>* -job <job file>\n"
                     "\n"
                     "args:  -bs <num>     transfer block size (multiple of 4K)\n"
                     "       -tt <num>     total bytes to transfer\n"
@@ -267,6 +472,8 @@ void usage(void) {
                     "       -live-dangerously  required if using \"-write\"\n"
                     "       -linear       transfers in linear order (default)\n"
                     "       -random       random transfers across total range\n"
+                    "       -job <file>   run the jobs in an fio-style job file, which\n"
+                    "                     can also target fvm, zxcrypt, minfs and blobfs\n"
                     "       -output-file <filename>  destination file for "
                     "writing results in JSON format\n"
                     );
@@ -282,20 +489,11 @@ void usage(void) {
 #define error(x...) do { fprintf(stderr, x); usage(); return -1; } while (0)
 
 int main(int argc, char** argv) {
-    blkdev_t blk;
-
     bool live_dangerously = false;
-    bio_random_args_t a = {};
-    a.blk = &blk;
-    a.xfer = 32768;
-    a.seed = 7891263897612ULL;
-    a.max_pending = 128;
-    a.write = false;
-    a.linear = true;
+    Job job;
+    const char* job_file = nullptr;
     const char* output_file = nullptr;
 
-    size_t total = 0;
-
     nextarg();
     while (argc > 0) {
         if (argv[0][0] != '-') {
@@ -303,30 +501,33 @@ int main(int argc, char** argv) {
         }
         if (!strcmp(argv[0], "-bs")) {
             needparam();
-            a.xfer = number(argv[0]);
-            if ((a.xfer == 0) || (a.xfer % 4096)) {
+            job.block_size = ParseNumber(argv[0]);
+            if ((job.block_size == 0) || (job.block_size % 4096)) {
                 error("error: block size must be multiple of 4K\n");
             }
         } else if (!strcmp(argv[0], "-tt")) {
             needparam();
-            total = number(argv[0]);
+            job.total = ParseNumber(argv[0]);
         } else if (!strcmp(argv[0], "-mo")) {
             needparam();
-            size_t n = number(argv[0]);
+            size_t n = ParseNumber(argv[0]);
             if ((n < 1) || (n > 128)) {
                 error("error: max pending must be between 1 and 128\n");
             }
-            a.max_pending = static_cast<int>(n);
+            job.queue_depth = static_cast<int>(n);
         } else if (!strcmp(argv[0], "-read")) {
-            a.write = false;
+            job.write = false;
         } else if (!strcmp(argv[0], "-write")) {
-            a.write = true;
+            job.write = true;
         } else if (!strcmp(argv[0], "-live-dangerously")) {
             live_dangerously = true;
         } else if (!strcmp(argv[0], "-linear")) {
-            a.linear = true;
+            job.linear = true;
         } else if (!strcmp(argv[0], "-random")) {
-            a.linear = false;
+            job.linear = false;
+        } else if (!strcmp(argv[0], "-job")) {
+            needparam();
+            job_file = argv[0];
         } else if (!strcmp(argv[0], "-output-file")) {
             needparam();
             output_file = argv[0];
@@ -338,52 +539,61 @@ int main(int argc, char** argv) {
         }
         nextarg();
     }
-    if (argc == 0) {
-        error("error: no device specified\n");
-    }
-    if (argc > 1) {
-        error("error: unexpected arguments\n");
-    }
-    if (a.write && !live_dangerously) {
-        error("error: the option \"-live-dangerously\" is required when using"
-              " \"-write\"\n");
-    }
-    const char* device_filename = argv[0];
 
-    int fd;
-    if ((fd = open(device_filename, O_RDONLY)) < 0) {
-        fprintf(stderr, "error: cannot open '%s'\n", device_filename);
-        return -1;
+    fbl::Vector<Job> jobs;
+    if (job_file) {
+        if (argc > 0) {
+            error("error: unexpected arguments\n");
+        }
+        if (!ParseJobFile(job_file, &jobs)) {
+            return -1;
+        }
+    } else {
+        if (argc == 0) {
+            error("error: no device specified\n");
+        }
+        if (argc > 1) {
+            error("error: unexpected arguments\n");
+        }
+        job.target = argv[0];
+        jobs.push_back(fbl::move(job));
     }
-    if (blkdev_open(fd, device_filename, 8*1024*1024, &blk) != ZX_OK) {
-        return -1;
+
+    for (const Job& j : jobs) {
+        if (!ValidateJob(j)) {
+            return -1;
+        }
+        if (j.write && !live_dangerously) {
+            error("error: the option \"-live-dangerously\" is required when using"
+                  " \"-write\" or write jobs\n");
+        }
     }
 
-    size_t devtotal = blk.info.block_count * blk.info.block_size;
+    perftest::ResultsSet results;
+    for (const Job& j : jobs) {
+        if (job_file) {
+            fprintf(stderr, "job %s: %s %s of %s\n", j.name.c_str(),
+                    j.linear ? "linear" : "random", j.write ? "writes" : "reads",
+                    j.target.c_str());
+        }
 
-    // default to entire device
-    if ((total == 0) || (total > devtotal)) {
-        total = devtotal;
-    }
-    a.count = total / a.xfer;
+        // Too big for the stack.
+        fbl::unique_ptr<job_result_t> result(new job_result_t());
+        zx_status_t status = j.uses_block_fifo() ? run_block_job(j, result.get())
+                                                 : run_file_job(j, result.get());
+        if (status != ZX_OK) {
+            return -1;
+        }
 
-    zx_duration_t res = 0;
-    total = 0;
-    if (bio_random(&a, &total, &res) != ZX_OK) {
-        return -1;
+        // A lone job from the command line keeps the test case names from
+        // before job files.
+        fbl::String prefix = job_file
+            ? fbl::StringPrintf("Storage/%s/%s/", LayerName(j.layer), j.name.c_str())
+            : fbl::String("BlockDevice");
+        report(prefix.c_str(), *result, &results);
     }
 
-    fprintf(stderr, "%zu bytes in %zu ns: ", total, res);
-    bytes_per_second(total, res);
-    fprintf(stderr, "%zu ops in %zu ns: ", a.count, res);
-    ops_per_second(a.count, res);
-
     if (output_file) {
-        perftest::ResultsSet results;
-        auto* test_case = results.AddTestCase(
-            "fuchsia.zircon", "BlockDeviceThroughput", "bytes/second");
-        double time_in_seconds = static_cast<double>(res) / 1e9;
-        test_case->AppendValue(static_cast<double>(total) / time_in_seconds);
         if (!results.WriteJSONFile(output_file)) {
             return 1;
         }
@@ -0,0 +1,193 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "job.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fbl/unique_ptr.h>
+
+uint64_t ParseNumber(const char* str) {
+    char* end;
+    uint64_t n = strtoull(str, &end, 10);
+
+    uint64_t m = 1;
+    switch (*end) {
+    case 'G':
+    case 'g':
+        m = 1024*1024*1024;
+        break;
+    case 'M':
+    case 'm':
+        m = 1024*1024;
+        break;
+    case 'K':
+    case 'k':
+        m = 1024;
+        break;
+    }
+    return m * n;
+}
+
+const char* LayerName(Layer layer) {
+    switch (layer) {
+    case Layer::kBlock:
+        return "block";
+    case Layer::kFvm:
+        return "fvm";
+    case Layer::kZxcrypt:
+        return "zxcrypt";
+    case Layer::kMinfs:
+        return "minfs";
+    case Layer::kBlobfs:
+        return "blobfs";
+    }
+    return "unknown";
+}
+
+namespace {
+
+// Strips leading and trailing whitespace in place.
+char* Trim(char* str) {
+    while (isspace(static_cast<unsigned char>(*str))) {
+        str++;
+    }
+    char* end = str + strlen(str);
+    while (end > str && isspace(static_cast<unsigned char>(end[-1]))) {
+        *--end = '\0';
+    }
+    return str;
+}
+
+bool SetKey(Job* job, const char* key, const char* value) {
+    if (!strcmp(key, "target")) {
+        job->target = value;
+    } else if (!strcmp(key, "layer")) {
+        static const Layer kLayers[] = {
+            Layer::kBlock, Layer::kFvm, Layer::kZxcrypt, Layer::kMinfs, Layer::kBlobfs,
+        };
+        for (Layer layer : kLayers) {
+            if (!strcmp(value, LayerName(layer))) {
+                job->layer = layer;
+                return true;
+            }
+        }
+        return false;
+    } else if (!strcmp(key, "rw")) {
+        if (!strcmp(value, "read")) {
+            job->write = false;
+            job->linear = true;
+        } else if (!strcmp(value, "write")) {
+            job->write = true;
+            job->linear = true;
+        } else if (!strcmp(value, "randread")) {
+            job->write = false;
+            job->linear = false;
+        } else if (!strcmp(value, "randwrite")) {
+            job->write = true;
+            job->linear = false;
+        } else {
+            return false;
+        }
+    } else if (!strcmp(key, "bs")) {
+        job->block_size = ParseNumber(value);
+    } else if (!strcmp(key, "size")) {
+        job->total = ParseNumber(value);
+    } else if (!strcmp(key, "iodepth") || !strcmp(key, "numjobs")) {
+        job->queue_depth = static_cast<int>(ParseNumber(value));
+    } else if (!strcmp(key, "seed")) {
+        job->seed = strtoull(value, nullptr, 0);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+bool ParseJobFile(const char* path, fbl::Vector<Job>* jobs) {
+    FILE* file = fopen(path, "r");
+    if (file == nullptr) {
+        fprintf(stderr, "error: cannot open job file '%s'\n", path);
+        return false;
+    }
+
+    Job global;
+    Job* current = &global;
+    char line[256];
+    bool ok = true;
+    for (int line_number = 1; fgets(line, sizeof(line), file) != nullptr; line_number++) {
+        char* text = Trim(line);
+        if (*text == '\0' || *text == '#' || *text == ';') {
+            continue;
+        }
+        if (*text == '[') {
+            char* end = strchr(text, ']');
+            if (end == nullptr) {
+                fprintf(stderr, "%s:%d: error: unterminated section name\n", path, line_number);
+                ok = false;
+                break;
+            }
+            *end = '\0';
+            const char* name = Trim(text + 1);
+            if (!strcmp(name, "global")) {
+                current = &global;
+                continue;
+            }
+            Job job = global;
+            job.name = name;
+            jobs->push_back(fbl::move(job));
+            current = &(*jobs)[jobs->size() - 1];
+            continue;
+        }
+
+        char* equals = strchr(text, '=');
+        if (equals == nullptr) {
+            fprintf(stderr, "%s:%d: error: expected key=value\n", path, line_number);
+            ok = false;
+            break;
+        }
+        *equals = '\0';
+        const char* key = Trim(text);
+        const char* value = Trim(equals + 1);
+        if (!SetKey(current, key, value)) {
+            fprintf(stderr, "%s:%d: error: bad setting '%s=%s'\n",
+                    path, line_number, key, value);
+            ok = false;
+            break;
+        }
+    }
+    fclose(file);
+
+    if (ok && jobs->is_empty()) {
+        fprintf(stderr, "error: job file '%s' has no jobs\n", path);
+        ok = false;
+    }
+    return ok;
+}
+
+bool ValidateJob(const Job& job) {
+    const char* name = job.name.c_str();
+    if (job.target.empty()) {
+        fprintf(stderr, "error: job '%s' has no target\n", name);
+        return false;
+    }
+    if ((job.block_size == 0) || (job.block_size % 4096)) {
+        fprintf(stderr, "error: job '%s': block size must be a multiple of 4K\n", name);
+        return false;
+    }
+    if ((job.queue_depth < 1) || (job.queue_depth > 128)) {
+        fprintf(stderr, "error: job '%s': queue depth must be between 1 and 128\n", name);
+        return false;
+    }
+    if (job.layer == Layer::kBlobfs && job.write) {
+        fprintf(stderr, "error: job '%s': blobs can't be rewritten, so blobfs jobs "
+                        "can only read\n", name);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,79 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <fbl/string.h>
+#include <fbl/vector.h>
+
+// The storage layer a job measures.  This picks how the job does its I/O:
+// block layers are driven through the block FIFO of their device, and
+// filesystems through POSIX reads and writes of a file.
+enum class Layer {
+    kBlock,    // A raw block device.
+    kFvm,      // An FVM partition.
+    kZxcrypt,  // A zxcrypt volume.
+    kMinfs,    // A file on minfs.
+    kBlobfs,   // A blob on blobfs, which can only be read.
+};
+
+struct Job {
+    fbl::String name;
+    fbl::String target;
+    Layer layer = Layer::kBlock;
+    bool write = false;
+    bool linear = true;
+    // Bytes per operation; a multiple of 4K.
+    size_t block_size = 32768;
+    // Total bytes to transfer; zero for the whole target.
+    size_t total = 0;
+    // Operations in flight at once.  For filesystem layers, where each
+    // thread does one operation at a time, this is the number of threads.
+    int queue_depth = 128;
+    uint64_t seed = 7891263897612ULL;
+
+    bool uses_block_fifo() const {
+        return layer == Layer::kBlock || layer == Layer::kFvm || layer == Layer::kZxcrypt;
+    }
+};
+
+const char* LayerName(Layer layer);
+
+// Parses a size with an optional K, M or G suffix.
+uint64_t ParseNumber(const char* str);
+
+// Reads jobs from an fio-style job file:
+//
+//     # Comments start with '#' or ';'.
+//     [global]
+//     bs=4k
+//     iodepth=32
+//
+//     [fvm-randread]
+//     target=/dev/class/block/003
+//     layer=fvm
+//     rw=randread
+//     size=64m
+//
+// Each section other than [global] is a job named after the section, and
+// starts from the settings in [global] before it.  The keys are:
+//
+//     target   path of the block device or file
+//     layer    block, fvm, zxcrypt, minfs or blobfs (default: block)
+//     rw       read, write, randread or randwrite (default: read)
+//     bs       bytes per operation (default: 32k)
+//     size     total bytes to transfer (default: all of the target)
+//     iodepth  operations in flight (default: 128 for block layers)
+//     numjobs  threads, for filesystem layers; the same as iodepth
+//     seed     seed for random offsets
+//
+// Returns false and prints an error if the file can't be read or is
+// malformed.
+bool ParseJobFile(const char* path, fbl::Vector<Job>* jobs);
+
+// Checks that |job| is runnable, printing an error if it is not.
+bool ValidateJob(const Job& job);
@@ -9,7 +9,9 @@ MODULE := $(LOCAL_DIR)
 MODULE_TYPE := userapp
 MODULE_GROUP := misc
 
-MODULE_SRCS += $(LOCAL_DIR)/biotime.cpp
+MODULE_SRCS += \
+    $(LOCAL_DIR)/biotime.cpp \
+    $(LOCAL_DIR)/job.cpp \
 
 MODULE_STATIC_LIBS := \
     system/ulib/fbl \
@@ -77,6 +77,15 @@ int Fsck(fbl::unique_fd fd, blobfs::MountOptions* options) {
     return blobfs::Fsck(fbl::move(blobfs));
 }
 
+int FsckMetadata(fbl::unique_fd fd, blobfs::MountOptions* options) {
+    fbl::unique_ptr<blobfs::Blobfs> blobfs;
+    if (blobfs::Initialize(fbl::move(fd), *options, &blobfs) != ZX_OK) {
+        return -1;
+    }
+
+    return blobfs::Fsck(fbl::move(blobfs), /* metadata_only */ true);
+}
+
 typedef int (*CommandFunction)(fbl::unique_fd fd, blobfs::MountOptions* options);
 
 const struct {
@@ -88,6 +97,7 @@ const struct {
     {"mkfs", Mkfs, "initialize filesystem"},
     {"check", Fsck, "check filesystem integrity"},
     {"fsck", Fsck, "check filesystem integrity"},
+    {"fsck-metadata", FsckMetadata, "check filesystem metadata, not blob contents"},
     {"mount", Mount, "mount filesystem"},
 };
 
@@ -97,6 +107,8 @@ int usage() {
             "\n"
             "options: -r|--readonly  Mount filesystem read-only\n"
             "         -m|--metrics   Collect filesystem metrics\n"
+            "         -c|--cache <MB>  Keep up to <MB> of closed blobs in memory\n"
+            "         -z|--lz4hc     Compress blobs written with LZ4HC\n"
             "         -h|--help      Display this message\n"
             "\n"
             "On Fuchsia, blobfs takes the block device argument by handle.\n"
@@ -118,11 +130,13 @@ int ProcessArgs(int argc, char** argv, CommandFunction* func, blobfs::MountOptio
             {"readonly", no_argument, nullptr, 'r'},
             {"metrics", no_argument, nullptr, 'm'},
             {"journal", no_argument, nullptr, 'j'},
+            {"cache", required_argument, nullptr, 'c'},
+            {"lz4hc", no_argument, nullptr, 'z'},
             {"help", no_argument, nullptr, 'h'},
             {nullptr, 0, nullptr, 0},
         };
         int opt_index;
-        int c = getopt_long(argc, argv, "rmjh", opts, &opt_index);
+        int c = getopt_long(argc, argv, "rmjc:zh", opts, &opt_index);
         if (c < 0) {
             break;
         }
@@ -136,6 +150,13 @@ int ProcessArgs(int argc, char** argv, CommandFunction* func, blobfs::MountOptio
         case 'j':
             options->journal = true;
             break;
+        case 'c':
+            options->cache_policy = blobfs::CachePolicy::EvictLeastRecentlyUsed;
+            options->cache_budget = strtoull(optarg, nullptr, 0) << 20;
+            break;
+        case 'z':
+            options->compression = blobfs::CompressionAlgorithm::kLz4Hc;
+            break;
         case 'h':
         default:
             return usage();
@@ -0,0 +1,432 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Samples the cpus with the performance monitor and writes the samples out
+// in the Fuchsia trace format, see docs/tracing/trace_format.md.
+//
+// Each sample becomes an instant event in the "cpu:perf" category, named
+// after the event that triggered it, on the thread that was running. When
+// call stacks are collected (the default) each event is followed by a blob
+// record of type TRACE_BLOB_TYPE_CALLSTACK holding the call stack.
+
+#include <fcntl.h>
+#include <getopt.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <fbl/algorithm.h>
+#include <lib/zircon-internal/device/cpu-trace/cpu-perf.h>
+#include <lib/zircon-internal/device/cpu-trace/intel-pm.h>
+#include <trace-engine/fields.h>
+#include <trace-engine/types.h>
+#include <zircon/syscalls.h>
+#include <zircon/types.h>
+
+namespace {
+
+constexpr char kDefaultDevice[] = "/dev/sys/cpu-trace/cpuperf";
+constexpr char kCategory[] = "cpu:perf";
+constexpr char kCallstackBlobName[] = "callstack";
+
+struct EventInfo {
+    const char* name;
+    cpuperf_event_id_t id;
+};
+
+// The events that can trigger a sample. The fixed counters come first so that
+// an event that is both fixed and architectural uses a fixed counter.
+const EventInfo kEvents[] = {
+#define DEF_FIXED_EVENT(symbol, event_name, id, regnum, flags, readable_name, description) \
+    {#event_name, CPUPERF_MAKE_EVENT_ID(CPUPERF_GROUP_FIXED, id)},
+#define DEF_ARCH_EVENT(symbol, event_name, id, ebx_bit, event, umask, flags, readable_name, description) \
+    {#event_name, CPUPERF_MAKE_EVENT_ID(CPUPERF_GROUP_ARCH, id)},
+#include <lib/zircon-internal/device/cpu-trace/intel-pm-events.inc>
+};
+
+const EventInfo* LookupEvent(const char* name) {
+    for (const auto& event : kEvents) {
+        if (strcmp(event.name, name) == 0)
+            return &event;
+    }
+    return nullptr;
+}
+
+// Writes trace records to a file. Strings and threads are always inlined,
+// which keeps the writer stateless at the cost of some space.
+class TraceWriter {
+public:
+    explicit TraceWriter(FILE* out)
+        : out_(out) {}
+
+    bool ok() const { return ok_; }
+
+    void WriteInitialization(zx_ticks_t ticks_per_second) {
+        WriteWord(trace::RecordFields::Type::Make(
+                      trace::ToUnderlyingType(trace::RecordType::kInitialization)) |
+                  trace::RecordFields::RecordSize::Make(2));
+        WriteWord(ticks_per_second);
+    }
+
+    void WriteSample(zx_ticks_t time, zx_koid_t pid, zx_koid_t tid, const char* name,
+                     uint32_t cpu, uint64_t pc) {
+        const size_t category_len = strlen(kCategory);
+        const size_t name_len = strlen(name);
+        // Header, timestamp, pid, tid, category, name, scope and two
+        // arguments with inline names.
+        const size_t words = 4 + trace::BytesToWords(category_len) +
+                             trace::BytesToWords(name_len) + 1 +
+                             ArgumentWords("cpu", false) + ArgumentWords("pc", true);
+        WriteWord(trace::RecordFields::Type::Make(
+                      trace::ToUnderlyingType(trace::RecordType::kEvent)) |
+                  trace::RecordFields::RecordSize::Make(words) |
+                  trace::EventRecordFields::EventType::Make(
+                      trace::ToUnderlyingType(trace::EventType::kInstant)) |
+                  trace::EventRecordFields::ArgumentCount::Make(2) |
+                  trace::EventRecordFields::ThreadRef::Make(TRACE_ENCODED_THREAD_REF_INLINE) |
+                  trace::EventRecordFields::CategoryStringRef::Make(InlineRef(category_len)) |
+                  trace::EventRecordFields::NameStringRef::Make(InlineRef(name_len)));
+        WriteWord(time);
+        WriteWord(pid);
+        WriteWord(tid);
+        WriteString(kCategory, category_len);
+        WriteString(name, name_len);
+        WriteArgumentHeader(trace::ArgumentType::kUint32, "cpu",
+                            trace::Uint32ArgumentFields::Value::Make(cpu));
+        WriteArgumentHeader(trace::ArgumentType::kPointer, "pc", 0);
+        WriteWord(pc);
+        WriteWord(TRACE_SCOPE_THREAD);
+    }
+
+    void WriteBlob(trace_blob_type_t type, const char* name, const void* blob, size_t size) {
+        const size_t name_len = strlen(name);
+        const size_t words = 1 + trace::BytesToWords(name_len) + trace::BytesToWords(size);
+        WriteWord(trace::RecordFields::Type::Make(
+                      trace::ToUnderlyingType(trace::RecordType::kBlob)) |
+                  trace::RecordFields::RecordSize::Make(words) |
+                  trace::BlobRecordFields::NameStringRef::Make(InlineRef(name_len)) |
+                  trace::BlobRecordFields::BlobSize::Make(size) |
+                  trace::BlobRecordFields::BlobType::Make(type));
+        WriteString(name, name_len);
+        WriteString(static_cast<const char*>(blob), size);
+    }
+
+private:
+    static trace_encoded_string_ref_t InlineRef(size_t len) {
+        return static_cast<trace_encoded_string_ref_t>(TRACE_ENCODED_STRING_REF_INLINE_FLAG | len);
+    }
+
+    // The header and name, plus a word for values that don't fit in the
+    // header.
+    static size_t ArgumentWords(const char* name, bool value_word) {
+        return 1 + trace::BytesToWords(strlen(name)) + (value_word ? 1 : 0);
+    }
+
+    // Writes the header and name of an argument. 32-bit values go in
+    // |value_bits|, anything larger is written by the caller right after.
+    void WriteArgumentHeader(trace::ArgumentType type, const char* name, uint64_t value_bits) {
+        const size_t name_len = strlen(name);
+        const bool value_word = type != trace::ArgumentType::kInt32 &&
+                                type != trace::ArgumentType::kUint32;
+        WriteWord(trace::ArgumentFields::Type::Make(trace::ToUnderlyingType(type)) |
+                  trace::ArgumentFields::ArgumentSize::Make(ArgumentWords(name, value_word)) |
+                  trace::ArgumentFields::NameRef::Make(InlineRef(name_len)) |
+                  value_bits);
+        WriteString(name, name_len);
+    }
+
+    void WriteWord(uint64_t word) {
+        if (ok_ && fwrite(&word, sizeof(word), 1, out_) != 1)
+            ok_ = false;
+    }
+
+    // Writes |len| bytes padded out to a whole number of words.
+    void WriteString(const char* data, size_t len) {
+        static const char kZeros[sizeof(uint64_t)] = {};
+        if (ok_ && (fwrite(data, 1, len, out_) != len ||
+                    fwrite(kZeros, 1, trace::Pad(len) - len, out_) != trace::Pad(len) - len))
+            ok_ = false;
+    }
+
+    FILE* const out_;
+    bool ok_ = true;
+};
+
+// Returns the size of the record at |hdr|, or zero if it is not valid or
+// doesn't fit in the |avail| bytes of the buffer.
+size_t RecordSize(const cpuperf_record_header_t* hdr, size_t avail) {
+    size_t size;
+    switch (hdr->type) {
+    case CPUPERF_RECORD_TIME:
+        size = sizeof(cpuperf_time_record_t);
+        break;
+    case CPUPERF_RECORD_TICK:
+        size = sizeof(cpuperf_tick_record_t);
+        break;
+    case CPUPERF_RECORD_COUNT:
+        size = sizeof(cpuperf_count_record_t);
+        break;
+    case CPUPERF_RECORD_VALUE:
+        size = sizeof(cpuperf_value_record_t);
+        break;
+    case CPUPERF_RECORD_PC:
+        size = sizeof(cpuperf_pc_record_t);
+        break;
+    case CPUPERF_RECORD_LAST_BRANCH: {
+        auto rec = reinterpret_cast<const cpuperf_last_branch_record_t*>(hdr);
+        if (avail < offsetof(cpuperf_last_branch_record_t, branches) ||
+            rec->num_branches > CPUPERF_MAX_NUM_LAST_BRANCH)
+            return 0;
+        size = CPUPERF_LAST_BRANCH_RECORD_SIZE(rec);
+        break;
+    }
+    case CPUPERF_RECORD_CALLSTACK: {
+        auto rec = reinterpret_cast<const cpuperf_callstack_record_t*>(hdr);
+        if (avail < offsetof(cpuperf_callstack_record_t, frames) ||
+            rec->num_frames > CPUPERF_MAX_NUM_CALLSTACK_FRAMES)
+            return 0;
+        size = CPUPERF_CALLSTACK_RECORD_SIZE(rec);
+        break;
+    }
+    default:
+        return 0;
+    }
+    return size <= avail ? size : 0;
+}
+
+// Converts the records of one cpu's buffer. Returns the number of samples.
+size_t ConvertBuffer(TraceWriter* writer, uint32_t cpu, const char* event_name,
+                     const uint8_t* buffer, size_t size) {
+    auto header = reinterpret_cast<const cpuperf_buffer_header_t*>(buffer);
+    if (header->flags & CPUPERF_BUFFER_FLAG_FULL)
+        fprintf(stderr, "cpu %u: buffer filled, samples were dropped\n", cpu);
+    size_t end = fbl::min(static_cast<size_t>(header->capture_end), size);
+
+    // The pc record of a sample comes first and its call stack, if any, last
+    // among the records written for the interrupt, so hold on to the pc until
+    // we know which it is.
+    zx_ticks_t time = 0;
+    const cpuperf_pc_record_t* pending = nullptr;
+    size_t samples = 0;
+    auto flush = [&](const cpuperf_callstack_record_t* stack) {
+        if (pending == nullptr)
+            return;
+        writer->WriteSample(time, stack ? stack->pid : 0, stack ? stack->tid : 0,
+                            event_name, cpu, pending->pc);
+        if (stack) {
+            writer->WriteBlob(TRACE_BLOB_TYPE_CALLSTACK, kCallstackBlobName,
+                              stack, CPUPERF_CALLSTACK_RECORD_SIZE(stack));
+        }
+        pending = nullptr;
+        ++samples;
+    };
+
+    size_t offset = sizeof(*header);
+    while (offset + sizeof(cpuperf_record_header_t) <= end) {
+        auto hdr = reinterpret_cast<const cpuperf_record_header_t*>(buffer + offset);
+        size_t rec_size = RecordSize(hdr, end - offset);
+        if (rec_size == 0) {
+            fprintf(stderr, "cpu %u: bad record at offset %zu\n", cpu, offset);
+            break;
+        }
+        switch (hdr->type) {
+        case CPUPERF_RECORD_TIME:
+            flush(nullptr);
+            time = reinterpret_cast<const cpuperf_time_record_t*>(hdr)->time;
+            break;
+        case CPUPERF_RECORD_PC:
+            flush(nullptr);
+            pending = reinterpret_cast<const cpuperf_pc_record_t*>(hdr);
+            break;
+        case CPUPERF_RECORD_CALLSTACK:
+            flush(reinterpret_cast<const cpuperf_callstack_record_t*>(hdr));
+            break;
+        default:
+            break;
+        }
+        offset += rec_size;
+    }
+    flush(nullptr);
+    return samples;
+}
+
+void Usage() {
+    fprintf(stderr,
+            "Usage: cpuperf-sample [options] <output file>\n"
+            "Samples all cpus and writes the samples out in the trace format.\n"
+            "Options:\n"
+            "  --device <path>    cpuperf device (default %s)\n"
+            "  --event <name>     event to sample on (default unhalted_core_cycles)\n"
+            "  --rate <n>         take a sample every n events (default 100000)\n"
+            "  --duration <sec>   how long to sample for (default 1)\n"
+            "  --buffer-size <mb> per-cpu buffer size (default 16)\n"
+            "  --no-callstack     only record the pc of each sample\n"
+            "  --no-kernel        only sample userspace\n"
+            "  --no-user          only sample the kernel\n",
+            kDefaultDevice);
+    fprintf(stderr, "Events:");
+    for (const auto& event : kEvents) {
+        // Events that are both fixed and architectural are listed once.
+        if (LookupEvent(event.name) == &event)
+            fprintf(stderr, " %s", event.name);
+    }
+    fprintf(stderr, "\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const char* device = kDefaultDevice;
+    const EventInfo* event = LookupEvent("unhalted_core_cycles");
+    uint32_t rate = 100000;
+    uint32_t duration_sec = 1;
+    uint32_t buffer_size_mb = 16;
+    uint32_t flags = CPUPERF_CONFIG_FLAG_OS | CPUPERF_CONFIG_FLAG_USER |
+                     CPUPERF_CONFIG_FLAG_PC | CPUPERF_CONFIG_FLAG_CALLSTACK;
+
+    static const struct option opts[] = {
+        {"device", required_argument, nullptr, 'd'},
+        {"event", required_argument, nullptr, 'e'},
+        {"rate", required_argument, nullptr, 'r'},
+        {"duration", required_argument, nullptr, 't'},
+        {"buffer-size", required_argument, nullptr, 'b'},
+        {"no-callstack", no_argument, nullptr, 'C'},
+        {"no-kernel", no_argument, nullptr, 'K'},
+        {"no-user", no_argument, nullptr, 'U'},
+        {"help", no_argument, nullptr, 'h'},
+        {},
+    };
+    int c;
+    while ((c = getopt_long(argc, argv, "", opts, nullptr)) != -1) {
+        switch (c) {
+        case 'd':
+            device = optarg;
+            break;
+        case 'e':
+            event = LookupEvent(optarg);
+            if (event == nullptr) {
+                fprintf(stderr, "Unknown event: %s\n", optarg);
+                Usage();
+                return 1;
+            }
+            break;
+        case 'r':
+            rate = static_cast<uint32_t>(strtoul(optarg, nullptr, 0));
+            break;
+        case 't':
+            duration_sec = static_cast<uint32_t>(strtoul(optarg, nullptr, 0));
+            break;
+        case 'b':
+            buffer_size_mb = static_cast<uint32_t>(strtoul(optarg, nullptr, 0));
+            break;
+        case 'C':
+            flags &= ~CPUPERF_CONFIG_FLAG_CALLSTACK;
+            break;
+        case 'K':
+            flags &= ~CPUPERF_CONFIG_FLAG_OS;
+            break;
+        case 'U':
+            flags &= ~CPUPERF_CONFIG_FLAG_USER;
+            break;
+        default:
+            Usage();
+            return 1;
+        }
+    }
+    if (optind + 1 != argc || rate == 0 || buffer_size_mb == 0 ||
+        (flags & (CPUPERF_CONFIG_FLAG_OS | CPUPERF_CONFIG_FLAG_USER)) == 0) {
+        Usage();
+        return 1;
+    }
+    const char* output_path = argv[optind];
+
+    int fd = open(device, O_RDWR);
+    if (fd < 0) {
+        fprintf(stderr, "Cannot open %s\n", device);
+        return 1;
+    }
+
+    uint32_t num_cpus = zx_system_get_num_cpus();
+    ioctl_cpuperf_alloc_t alloc = {};
+    alloc.num_buffers = num_cpus;
+    alloc.buffer_size = buffer_size_mb * 1024 * 1024;
+    ssize_t ret = ioctl_cpuperf_alloc_trace(fd, &alloc);
+    if (ret < 0) {
+        fprintf(stderr, "Cannot allocate trace buffers: %zd\n", ret);
+        close(fd);
+        return 1;
+    }
+
+    cpuperf_config_t config = {};
+    config.events[0] = event->id;
+    config.rate[0] = rate;
+    config.flags[0] = flags;
+    int status = 0;
+    if ((ret = ioctl_cpuperf_stage_config(fd, &config)) < 0) {
+        fprintf(stderr, "Cannot stage config: %zd\n", ret);
+        status = 1;
+    } else if ((ret = ioctl_cpuperf_start(fd)) < 0) {
+        fprintf(stderr, "Cannot start sampling: %zd\n", ret);
+        status = 1;
+    } else {
+        zx_nanosleep(zx_deadline_after(ZX_SEC(duration_sec)));
+        ioctl_cpuperf_stop(fd);
+    }
+
+    FILE* out = status == 0 ? fopen(output_path, "wb") : nullptr;
+    if (status == 0 && out == nullptr) {
+        fprintf(stderr, "Cannot create %s\n", output_path);
+        status = 1;
+    }
+
+    size_t total_samples = 0;
+    if (status == 0) {
+        TraceWriter writer(out);
+        bool wrote_init = false;
+        for (uint32_t cpu = 0; cpu < num_cpus && status == 0; ++cpu) {
+            ioctl_cpuperf_buffer_handle_req_t req = {cpu};
+            zx_handle_t vmo;
+            if ((ret = ioctl_cpuperf_get_buffer_handle(fd, &req, &vmo)) < 0) {
+                fprintf(stderr, "Cannot get buffer of cpu %u: %zd\n", cpu, ret);
+                status = 1;
+                break;
+            }
+            uintptr_t addr;
+            zx_status_t zs = zx_vmar_map(zx_vmar_root_self(), ZX_VM_PERM_READ, 0, vmo, 0,
+                                         alloc.buffer_size, &addr);
+            zx_handle_close(vmo);
+            if (zs != ZX_OK) {
+                fprintf(stderr, "Cannot map buffer of cpu %u: %d\n", cpu, zs);
+                status = 1;
+                break;
+            }
+            auto buffer = reinterpret_cast<const uint8_t*>(addr);
+            if (!wrote_init) {
+                auto header = reinterpret_cast<const cpuperf_buffer_header_t*>(buffer);
+                writer.WriteInitialization(header->ticks_per_second);
+                wrote_init = true;
+            }
+            total_samples += ConvertBuffer(&writer, cpu, event->name, buffer,
+                                           alloc.buffer_size);
+            zx_vmar_unmap(zx_vmar_root_self(), addr, alloc.buffer_size);
+            if (!writer.ok()) {
+                fprintf(stderr, "Error writing %s\n", output_path);
+                status = 1;
+            }
+        }
+    }
+    if (out != nullptr && fclose(out) != 0 && status == 0) {
+        fprintf(stderr, "Error writing %s\n", output_path);
+        status = 1;
+    }
+
+    ioctl_cpuperf_free_trace(fd);
+    close(fd);
+
+    if (status == 0)
+        printf("%zu samples written to %s\n", total_samples, output_path);
+    return status;
+}
@@ -0,0 +1,31 @@
+# Copyright 2018 The Fuchsia Authors. All rights reserved.
+# Use of this source code is governed by a BSD-style license that can be
+# found in the LICENSE file.
+
+ifeq ($(ARCH),x86)
+
+LOCAL_DIR := $(GET_LOCAL_DIR)
+
+MODULE := $(LOCAL_DIR)
+
+MODULE_TYPE := userapp
+MODULE_GROUP := misc
+
+MODULE_SRCS += $(LOCAL_DIR)/main.cpp
+
+MODULE_HEADER_DEPS := \
+    system/ulib/trace-engine \
+
+MODULE_STATIC_LIBS := \
+    system/ulib/fbl \
+    system/ulib/zircon-internal \
+    system/ulib/zxcpp \
+
+MODULE_LIBS := \
+    system/ulib/fdio \
+    system/ulib/zircon \
+    system/ulib/c
+
+include make/module.mk
+
+endif
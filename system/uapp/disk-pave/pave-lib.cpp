@@ -8,6 +8,7 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <string.h>
+#include <threads.h>
 
 #include <block-client/cpp/client.h>
 #include <crypto/bytes.h>
@@ -25,6 +26,7 @@
 #include <lib/fzl/fdio.h>
 #include <lib/fzl/resizeable-vmo-mapper.h>
 #include <lib/fzl/vmo-mapper.h>
+#include <lib/sync/completion.h>
 #include <lib/zx/fifo.h>
 #include <lib/zx/vmo.h>
 #include <zircon/boot/image.h>
@@ -126,6 +128,36 @@ zx_status_t RegisterFastBlockIo(const fbl::unique_fd& fd, const zx::vmo& vmo,
     return block_client::Client::Create(fbl::move(fifo), client_out);
 }
 
+// Write |bytes_left| zeroes to disk at byte |offset|, a VMO's worth at a time.
+zx_status_t WriteZeroes(size_t offset, size_t bytes_left, const fzl::VmoMapper& mapper,
+                        const block_client::Client& client, size_t block_size,
+                        block_fifo_request_t* request) {
+    const size_t vmo_cap = mapper.size();
+    if (bytes_left > 0) {
+        memset(mapper.start(), 0, vmo_cap);
+    }
+    while (bytes_left > 0) {
+        uint64_t length = fbl::min(bytes_left, vmo_cap) / block_size;
+        if (length > UINT32_MAX) {
+            ERROR("Error writing trailing zeroes: Too large\n");
+            return ZX_ERR_OUT_OF_RANGE;
+        }
+        request->length = static_cast<uint32_t>(length);
+        request->vmo_offset = 0;
+        request->dev_offset = offset / block_size;
+
+        zx_status_t status;
+        if ((status = client.Transaction(request, 1)) != ZX_OK) {
+            ERROR("Error writing trailing zeroes\n");
+            return status;
+        }
+
+        offset += request->length * block_size;
+        bytes_left -= request->length * block_size;
+    }
+    return ZX_OK;
+}
+
 // Stream an FVM partition to disk.
 zx_status_t StreamFvmPartition(fvm::SparseReader* reader, PartitionInfo* part,
                                const fzl::VmoMapper& mapper, const block_client::Client& client,
@@ -182,26 +214,172 @@ zx_status_t StreamFvmPartition(fvm::SparseReader* reader, PartitionInfo* part,
         bytes_left = (ext->slice_count * slice_size) - ext->extent_length;
         if (bytes_left > 0) {
             LOG("%zu bytes written, %zu zeroes left\n", ext->extent_length, bytes_left);
-            memset(mapper.start(), 0, vmo_cap);
         }
-        while (bytes_left > 0) {
-            uint64_t length = fbl::min(bytes_left, vmo_cap) / block_size;
-            if (length > UINT32_MAX) {
-                ERROR("Error writing trailing zeroes: Too large\n");
-                return ZX_ERR_OUT_OF_RANGE;
-            }
-            request->length = static_cast<uint32_t>(length);
-            request->vmo_offset = 0;
-            request->dev_offset = offset / block_size;
+        zx_status_t status;
+        if ((status = WriteZeroes(offset, bytes_left, mapper, client, block_size,
+                                  request)) != ZX_OK) {
+            return status;
+        }
+    }
+    return ZX_OK;
+}
 
-            zx_status_t status;
-            if ((status = client.Transaction(request, 1)) != ZX_OK) {
-                ERROR("Error writing trailing zeroes\n");
-                return status;
+// Chunked images are written by up to this many workers at once, each with
+// its own transaction group and slice of the stream VMO.
+constexpr size_t kMaxChunkWorkers = MAX_TXN_GROUP_COUNT;
+
+// The space each worker has in the stream VMO.
+size_t ChunkStride(fvm::SparseReader* reader) {
+    return fbl::round_up(static_cast<size_t>(reader->ChunkIndex()->chunk_size),
+                         static_cast<size_t>(ZX_PAGE_SIZE));
+}
+
+struct ChunkWorker {
+    thrd_t thread;
+    const block_client::Client* client;
+    block_fifo_request_t request;
+    size_t block_size;
+    fbl::unique_ptr<uint8_t[]> stored;
+    uint8_t* out;
+
+    // The chunk to write next, and where to write it.
+    const fvm::sparse_chunk_t* chunk;
+    uint64_t dev_offset;
+    bool exit;
+    // The result of writing the last chunk.
+    zx_status_t status;
+
+    // Signalled once |chunk| has been read in, and once it has been written out.
+    sync_completion_t ready;
+    sync_completion_t done;
+};
+
+int ChunkWorkerThread(void* arg) {
+    ChunkWorker* worker = static_cast<ChunkWorker*>(arg);
+    for (;;) {
+        sync_completion_wait(&worker->ready, ZX_TIME_INFINITE);
+        sync_completion_reset(&worker->ready);
+        if (worker->exit) {
+            return 0;
+        }
+
+        const fvm::sparse_chunk_t* chunk = worker->chunk;
+        zx_status_t status = fvm::SparseReader::DecompressChunk(chunk, worker->stored.get(),
+                                                                worker->out);
+        if (status == ZX_OK) {
+            worker->request.length = static_cast<uint32_t>(chunk->length / worker->block_size);
+            worker->request.dev_offset = worker->dev_offset;
+            if ((status = worker->client->Transaction(&worker->request, 1)) != ZX_OK) {
+                ERROR("Error writing partition data\n");
             }
+        }
+        worker->status = status;
+        sync_completion_signal(&worker->done);
+    }
+}
+
+// Stream the chunks of FVM partition |index| to disk. The chunks are read in
+// order, but decompressed and written by several workers at once, so several
+// writes are outstanding at a time. |*next_chunk| is the partition's first
+// chunk, and is moved past its last.
+zx_status_t StreamFvmChunks(fvm::SparseReader* reader, uint32_t index, PartitionInfo* part,
+                            const fzl::VmoMapper& mapper, const block_client::Client& client,
+                            size_t block_size, block_fifo_request_t* request,
+                            size_t* next_chunk) {
+    const size_t slice_size = reader->Image()->slice_size;
+    const size_t chunk_count = reader->ChunkIndex()->chunk_count;
+    const size_t stride = ChunkStride(reader);
+    const size_t worker_count = fbl::min(client.GroupCount(), mapper.size() / stride);
+    if (worker_count == 0 || stride % block_size != 0) {
+        ERROR("Cannot write chunks of %zu bytes to blocks of %zu\n", stride, block_size);
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+
+    fbl::AllocChecker ac;
+    fbl::Array<ChunkWorker> workers(new (&ac) ChunkWorker[worker_count](), worker_count);
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+
+    zx_status_t status = ZX_OK;
+    size_t started = 0;
+    for (; started < worker_count; started++) {
+        ChunkWorker* worker = &workers[started];
+        worker->stored.reset(new (&ac) uint8_t[reader->MaxStoredLength()]);
+        if (!ac.check()) {
+            status = ZX_ERR_NO_MEMORY;
+            break;
+        }
+        worker->client = &client;
+        worker->request = *request;
+        worker->request.group = static_cast<groupid_t>(started);
+        worker->request.vmo_offset = started * stride / block_size;
+        worker->block_size = block_size;
+        worker->out = static_cast<uint8_t*>(mapper.start()) + started * stride;
+        worker->status = ZX_OK;
+        sync_completion_signal(&worker->done);
+        if (thrd_create_with_name(&worker->thread, ChunkWorkerThread, worker,
+                                  "pave-chunk") != thrd_success) {
+            status = ZX_ERR_NO_RESOURCES;
+            break;
+        }
+    }
+
+    // Hand each chunk to the next worker in turn, once it has written its last.
+    LOG("Writing chunks with %zu workers\n", worker_count);
+    for (size_t w = 0; status == ZX_OK && *next_chunk < chunk_count; (*next_chunk)++) {
+        const fvm::sparse_chunk_t* chunk = reader->Chunk(*next_chunk);
+        if (chunk->partition != index) {
+            break;
+        }
+        size_t offset = GetExtent(part->pd, chunk->extent)->slice_start * slice_size +
+                        chunk->extent_offset;
+        if (offset % block_size != 0 || chunk->length % block_size != 0) {
+            ERROR("Cannot write non-block size multiple: %u\n", chunk->length);
+            status = ZX_ERR_IO;
+            break;
+        }
+
+        ChunkWorker* worker = &workers[w];
+        w = (w + 1) % worker_count;
+        sync_completion_wait(&worker->done, ZX_TIME_INFINITE);
+        if ((status = worker->status) != ZX_OK) {
+            break;
+        }
+        if ((status = reader->ReadChunk(*next_chunk, worker->stored.get())) != ZX_OK) {
+            ERROR("Error reading partition data\n");
+            break;
+        }
+        sync_completion_reset(&worker->done);
+        worker->chunk = chunk;
+        worker->dev_offset = offset / block_size;
+        sync_completion_signal(&worker->ready);
+    }
+
+    // Wait for the last writes, and stop the workers.
+    for (size_t w = 0; w < started; w++) {
+        ChunkWorker* worker = &workers[w];
+        sync_completion_wait(&worker->done, ZX_TIME_INFINITE);
+        if (status == ZX_OK) {
+            status = worker->status;
+        }
+        worker->exit = true;
+        sync_completion_signal(&worker->ready);
+        thrd_join(worker->thread, nullptr);
+    }
+    if (status != ZX_OK) {
+        return status;
+    }
 
-            offset += request->length * block_size;
-            bytes_left -= request->length * block_size;
+    // Write trailing zeroes (which are implied, but were omitted from
+    // transfer).
+    for (size_t e = 0; e < part->pd->extent_count; e++) {
+        fvm::extent_descriptor_t* ext = GetExtent(part->pd, e);
+        size_t offset = ext->slice_start * slice_size + ext->extent_length;
+        size_t bytes_left = (ext->slice_count * slice_size) - ext->extent_length;
+        if ((status = WriteZeroes(offset, bytes_left, mapper, client, block_size,
+                                  request)) != ZX_OK) {
+            return status;
         }
     }
     return ZX_OK;
@@ -761,7 +939,9 @@ zx_status_t FvmStreamPartitions(fbl::unique_fd partition_fd, fbl::unique_fd src_
 
     LOG("Partition space pre-allocated successfully.\n");
 
-    constexpr size_t vmo_size = 1 << 20;
+    // Chunked images give each chunk worker its own slice of the VMO.
+    const size_t vmo_size = reader->IsChunked() ? kMaxChunkWorkers * ChunkStride(reader.get())
+                                                : (1 << 20);
 
     fzl::VmoMapper mapping;
     zx::vmo vmo;
@@ -772,6 +952,7 @@ zx_status_t FvmStreamPartitions(fbl::unique_fd partition_fd, fbl::unique_fd src_
     }
 
     // Now that all partitions are preallocated, begin streaming data to them.
+    size_t next_chunk = 0;
     for (size_t p = 0; p < parts.size(); p++) {
         vmoid_t vmoid;
         block_client::Client client;
@@ -794,8 +975,13 @@ zx_status_t FvmStreamPartitions(fbl::unique_fd partition_fd, fbl::unique_fd src_
         request.opcode = BLOCKIO_WRITE;
 
         LOG("Streaming partition %zu\n", p);
-        status = StreamFvmPartition(reader.get(), &parts[p], mapping, client, block_size,
-                                    &request);
+        if (reader->IsChunked()) {
+            status = StreamFvmChunks(reader.get(), static_cast<uint32_t>(p), &parts[p], mapping,
+                                     client, block_size, &request, &next_chunk);
+        } else {
+            status = StreamFvmPartition(reader.get(), &parts[p], mapping, client, block_size,
+                                        &request);
+        }
         LOG("Done streaming partition %zu\n", p);
         if (status != ZX_OK) {
             ERROR("Failed to stream partition\n");
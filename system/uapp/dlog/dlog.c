@@ -64,30 +64,36 @@ int main(int argc, char** argv) {
         return -1;
     }
 
-    char buf[ZX_LOG_RECORD_MAX];
-    zx_log_record_t* rec = (zx_log_record_t*)buf;
+    // Read many records per call; each starts on an 8 byte boundary.
+    char buf[ZX_LOG_RECORD_MAX * 16] __ALIGNED(8);
     for (;;) {
         zx_status_t status;
-        if ((status = zx_debuglog_read(h, 0, rec, ZX_LOG_RECORD_MAX)) < 0) {
+        if ((status = zx_debuglog_read(h, ZX_LOG_READ_BATCH, buf, sizeof(buf))) < 0) {
             if ((status == ZX_ERR_SHOULD_WAIT) && tail) {
                 zx_object_wait_one(h, ZX_LOG_READABLE, ZX_TIME_INFINITE, NULL);
                 continue;
             }
             break;
         }
-        if (filter_pid && (pid != rec->pid)) {
-            continue;
-        }
-        if (!plain) {
-            char tmp[32];
-            size_t len = snprintf(tmp, sizeof(tmp), "[%05d.%03d] ",
-                                  (int)(rec->timestamp / 1000000000ULL),
-                                  (int)((rec->timestamp / 1000000ULL) % 1000ULL));
-            write(1, tmp, (len > sizeof(tmp) ? sizeof(tmp) : len));
-        }
-        write(1, rec->data, rec->datalen);
-        if ((rec->datalen == 0) || (rec->data[rec->datalen - 1] != '\n')) {
-            write(1, "\n", 1);
+        size_t actual = status;
+        size_t off = 0;
+        while (off < actual) {
+            zx_log_record_t* rec = (zx_log_record_t*)(buf + off);
+            off += ZX_LOG_RECORD_ALIGN(sizeof(zx_log_record_t) + rec->datalen);
+            if (filter_pid && (pid != rec->pid)) {
+                continue;
+            }
+            if (!plain) {
+                char tmp[32];
+                size_t len = snprintf(tmp, sizeof(tmp), "[%05d.%03d] ",
+                                      (int)(rec->timestamp / 1000000000ULL),
+                                      (int)((rec->timestamp / 1000000ULL) % 1000ULL));
+                write(1, tmp, (len > sizeof(tmp) ? sizeof(tmp) : len));
+            }
+            write(1, rec->data, rec->datalen);
+            if ((rec->datalen == 0) || (rec->data[rec->datalen - 1] != '\n')) {
+                write(1, "\n", 1);
+            }
         }
     }
     return 0;
@@ -12,6 +12,7 @@
 
 #include <arpa/inet.h>
 #include <fcntl.h>
+#include <inttypes.h>
 #include <limits.h>
 #include <netinet/if_ether.h>
 #include <netinet/ip.h>
@@ -33,6 +34,9 @@ typedef struct {
     bool dump_regs;
     char* filter_macs;
     int n_filter_macs;
+    bool setting_moderation;
+    zircon_ethernet_InterruptModeration moderation;
+    bool show_stats;
 } ethtool_options_t;
 
 int usage(void) {
@@ -44,6 +48,9 @@ int usage(void) {
     fprintf(stderr, "  promisc off    : Promiscuous mode off\n");
     fprintf(stderr, "  filter n.n.n.n.n.n n.n.n.n.n.n ...    : multicast filter these addresses\n");
     fprintf(stderr, "  dump           : Dump regs of chip\n");
+    fprintf(stderr, "  moderation <min-us> <max-us> : Space interrupts from min-us apart when\n");
+    fprintf(stderr, "                   idle to max-us under load (equal: fixed, 0 0: off)\n");
+    fprintf(stderr, "  stats          : Show interrupt and packet counters of each queue\n");
     fprintf(stderr, "    (empty list is valid)\n");
     fprintf(stderr, "  --help  : Show this help message\n");
     return -1;
@@ -111,6 +118,30 @@ int parse_args(int argc, const char** argv, ethtool_options_t* options) {
             return usage();
         }
         options->dump_regs = true;
+    } else if (!strcmp(argv[0], "moderation")) {
+        argc--;
+        argv++;
+        if (argc != 2) {
+            return usage();
+        }
+        long min = strtol(argv[0], &remainder, 10);
+        if (min < 0 || remainder[0] != 0) {
+            return usage();
+        }
+        long max = strtol(argv[1], &remainder, 10);
+        if (max < min || remainder[0] != 0) {
+            return usage();
+        }
+        options->setting_moderation = true;
+        options->moderation.min_interval_us = (uint32_t)min;
+        options->moderation.max_interval_us = (uint32_t)max;
+    } else if (!strcmp(argv[0], "stats")) {
+        argc--;
+        argv++;
+        if (argc != 0) {
+            return usage();
+        }
+        options->show_stats = true;
     } else if (!strcmp(argv[0], "filter")) {
         argc--;
         argv++;
@@ -236,6 +267,37 @@ int main(int argc, const char** argv) {
             return -1;
         }
     }
+    if (options.setting_moderation) {
+        status = zircon_ethernet_DeviceSetInterruptModeration(svc, &options.moderation,
+                                                              &call_status);
+        if (status != ZX_OK || call_status != ZX_OK) {
+            fprintf(stderr, "ethtool: failed to set interrupt moderation: %d, %d\n",
+                    status, call_status);
+            return -1;
+        }
+        fprintf(stderr, "ethtool: set %s interrupt spacing to %u-%u us\n", options.device,
+                options.moderation.min_interval_us, options.moderation.max_interval_us);
+    }
+    if (options.show_stats) {
+        uint32_t queues;
+        status = zircon_ethernet_DeviceGetQueueCount(svc, &queues);
+        if (status != ZX_OK) {
+            fprintf(stderr, "ethtool: failed to get queue count: %d\n", status);
+            return -1;
+        }
+        for (uint32_t i = 0; i < queues; i++) {
+            zircon_ethernet_QueueStats stats;
+            status = zircon_ethernet_DeviceGetQueueStats(svc, i, &call_status, &stats);
+            if (status != ZX_OK || call_status != ZX_OK) {
+                fprintf(stderr, "ethtool: failed to get stats of queue %u: %d, %d\n",
+                        i, status, call_status);
+                return -1;
+            }
+            printf("queue %u: %" PRIu64 " interrupts, %" PRIu64 " rx packets, %" PRIu64
+                   " tx packets, %u us between interrupts\n", i, stats.interrupts,
+                   stats.rx_packets, stats.tx_packets, stats.interval_us);
+        }
+    }
     zx_nanosleep(zx_deadline_after(ZX_SEC(options.pause_secs)));
     return 0;
 }
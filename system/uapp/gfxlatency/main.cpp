@@ -118,6 +118,7 @@ typedef struct buffer {
     zx_handle_t wait_event;
     uint64_t wait_event_id;
     rect_t damage;
+    zx_time_t scheduled_time;
 } buffer_t;
 
 static zx_handle_t dc_handle = ZX_HANDLE_INVALID;
@@ -1006,6 +1007,8 @@ int main(int argc, char* argv[]) {
                           "image", buffers[0].image_id);
         TRACE_ASYNC_BEGIN("app", "Sprite Scheduled", (uintptr_t)&sprites[0],
                           "image", sprites[0].image_id);
+        buffers[0].scheduled_time = zx_clock_get_monotonic();
+        sprites[0].scheduled_time = buffers[0].scheduled_time;
     }
 
     // Set initial image for root layer.
@@ -1199,6 +1202,10 @@ int main(int argc, char* argv[]) {
                                            image_ids[1] == buffer.image_id)) {
                 TRACE_ASYNC_END("app", "Buffer Scheduled", (uintptr_t)&buffer,
                                 "image", buffer.image_id);
+                // Time from scheduling the frame to the vsync it was first
+                // scanned out at.
+                TRACE_COUNTER("app", "Buffer Latency", 0, "latency_us",
+                              (vsync_time - buffer.scheduled_time) / ZX_USEC(1));
                 if (buffer_frame > 0) {
                     auto& last_buffer =
                         buffers[(buffer_frame - 1) % buffers.size()];
@@ -1215,6 +1222,10 @@ int main(int argc, char* argv[]) {
                                            image_ids[1] == sprite.image_id)) {
                 TRACE_ASYNC_END("app", "Sprite Scheduled", (uintptr_t)&sprite,
                                 "image", sprite.image_id);
+                // Time from scheduling the frame to the vsync it was first
+                // scanned out at.
+                TRACE_COUNTER("app", "Sprite Latency", 0, "latency_us",
+                              (vsync_time - sprite.scheduled_time) / ZX_USEC(1));
                 if (sprite_frame > 0) {
                     auto& last_sprite =
                         sprites[(sprite_frame - 1) % sprites.size()];
@@ -1697,6 +1708,7 @@ int main(int argc, char* argv[]) {
                     TRACE_ASYNC_BEGIN("app", "Buffer Scheduled",
                                       (uintptr_t)&buffer, "image",
                                       buffer.image_id);
+                    buffer.scheduled_time = zx_clock_get_monotonic();
                 }
             }
         }
@@ -1720,6 +1732,7 @@ int main(int argc, char* argv[]) {
                     TRACE_ASYNC_BEGIN("app", "Sprite Scheduled",
                                       (uintptr_t)&sprite, "image",
                                       sprite.image_id);
+                    sprite.scheduled_time = zx_clock_get_monotonic();
                 }
             }
         }
@@ -16,7 +16,90 @@
 #include <gfx/gfx.h>
 #include <lib/framebuffer/framebuffer.h>
 
+#define BENCH_WIDTH 1920
+#define BENCH_HEIGHT 1080
+#define BENCH_ITERATIONS 100
+
+typedef void (*bench_fn)(gfx_surface* dst, gfx_surface* src);
+
+static void bench_fill(gfx_surface* dst, gfx_surface* src) {
+    gfx_fillrect(dst, 0, 0, dst->width, dst->height, 0xff336699);
+}
+
+static void bench_fill_inset(gfx_surface* dst, gfx_surface* src) {
+    gfx_fillrect(dst, 1, 1, dst->width - 2, dst->height - 2, 0xff996633);
+}
+
+// As virtcon and gfxconsole do, one 16 pixel high line at a time.
+static void bench_scroll(gfx_surface* dst, gfx_surface* src) {
+    gfx_copyrect(dst, 0, 16, dst->width, dst->height - 16, 0, 0);
+}
+
+// A copy between surfaces without alpha, or a blend with it.
+static void bench_blend(gfx_surface* dst, gfx_surface* src) {
+    gfx_blend(dst, src, 0, 0, src->width, src->height, 0, 0);
+}
+
+// Prints the rate at which |fn| draws, in millions of pixels a second.
+static void bench_run(const char* name, bench_fn fn, gfx_surface* dst, gfx_surface* src) {
+    fn(dst, src);
+    zx_time_t start = zx_clock_get_monotonic();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        fn(dst, src);
+    }
+    zx_duration_t elapsed = zx_clock_get_monotonic() - start;
+    double pixels = (double)dst->width * dst->height * BENCH_ITERATIONS;
+    printf("%-12s %8.1f Mpixels/s\n", name, pixels * 1000.0 / (double)(elapsed ? elapsed : 1));
+}
+
+// Times the surface operations on off-screen surfaces, so that changes to
+// the pixel loops can be compared without a display.
+static int bench(void) {
+    gfx_surface* dst = gfx_create_surface(NULL, BENCH_WIDTH, BENCH_HEIGHT, BENCH_WIDTH,
+                                          ZX_PIXEL_FORMAT_ARGB_8888, 0);
+    gfx_surface* src = gfx_create_surface(NULL, BENCH_WIDTH, BENCH_HEIGHT, BENCH_WIDTH,
+                                          ZX_PIXEL_FORMAT_ARGB_8888, 0);
+    gfx_surface* dst565 = gfx_create_surface(NULL, BENCH_WIDTH, BENCH_HEIGHT, BENCH_WIDTH,
+                                             ZX_PIXEL_FORMAT_RGB_565, 0);
+    gfx_surface* opaque = gfx_create_surface(NULL, BENCH_WIDTH, BENCH_HEIGHT, BENCH_WIDTH,
+                                             ZX_PIXEL_FORMAT_RGB_x888, 0);
+    gfx_surface* opaque_dst = gfx_create_surface(NULL, BENCH_WIDTH, BENCH_HEIGHT, BENCH_WIDTH,
+                                                 ZX_PIXEL_FORMAT_RGB_x888, 0);
+    if (!dst || !src || !dst565 || !opaque || !opaque_dst) {
+        printf("failed to create gfx surfaces\n");
+        return -1;
+    }
+
+    // A source with every alpha value, so that the blend takes neither of
+    // its shortcuts for long.
+    uint32_t* pixels = src->ptr;
+    for (unsigned i = 0; i < src->width * src->height; i++) {
+        pixels[i] = (i << 24) | (i * 0x010203u & 0xffffff);
+    }
+    gfx_fillrect(opaque, 0, 0, opaque->width, opaque->height, 0xff808080);
+
+    printf("%ux%u pixels, %d iterations, %s\n", BENCH_WIDTH, BENCH_HEIGHT, BENCH_ITERATIONS,
+           gfx_simd_name());
+    bench_run("fill", bench_fill, dst, src);
+    bench_run("fill-inset", bench_fill_inset, dst, src);
+    bench_run("fill-565", bench_fill, dst565, src);
+    bench_run("scroll", bench_scroll, dst, src);
+    bench_run("blit", bench_blend, opaque_dst, opaque);
+    bench_run("blend", bench_blend, dst, src);
+
+    gfx_surface_destroy(dst);
+    gfx_surface_destroy(src);
+    gfx_surface_destroy(dst565);
+    gfx_surface_destroy(opaque);
+    gfx_surface_destroy(opaque_dst);
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
+    if (argc > 1 && !strcmp(argv[1], "bench")) {
+        return bench();
+    }
+
     const char* err;
     zx_status_t status = fb_bind(true, &err);
     if (status != ZX_OK) {
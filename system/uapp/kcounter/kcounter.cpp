@@ -0,0 +1,275 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Reads the kernel counters published under /boot/kernel/counters, either
+// once or at intervals, keeping the recent history of each counter as a
+// time series of per-interval deltas.
+
+#include <fcntl.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <fbl/algorithm.h>
+#include <fbl/alloc_checker.h>
+#include <fbl/array.h>
+#include <fbl/unique_fd.h>
+#include <fbl/vector.h>
+#include <lib/fdio/io.h>
+#include <lib/fzl/vmo-mapper.h>
+#include <lib/zircon-internal/kcounters.h>
+#include <lib/zx/time.h>
+#include <lib/zx/vmo.h>
+#include <zircon/status.h>
+
+namespace {
+
+constexpr char kDescPath[] = "/boot/kernel/" KCOUNTERS_DESC_VMO_NAME;
+constexpr char kArenaPath[] = "/boot/kernel/" KCOUNTERS_ARENA_VMO_NAME;
+
+// The mapped counter VMOs.
+class Counters {
+public:
+    zx_status_t Open() {
+        zx_status_t status = Map(kDescPath, &desc_);
+        if (status != ZX_OK) {
+            return status;
+        }
+        if (desc_.size() < sizeof(kcounters_desc_header_t)) {
+            return ZX_ERR_IO_DATA_INTEGRITY;
+        }
+        header_ = static_cast<const kcounters_desc_header_t*>(desc_.start());
+        if (header_->magic != KCOUNTERS_MAGIC) {
+            return ZX_ERR_IO_DATA_INTEGRITY;
+        }
+        if (header_->version != KCOUNTERS_VERSION ||
+            header_->entry_size != sizeof(kcounters_desc_entry_t)) {
+            return ZX_ERR_NOT_SUPPORTED;
+        }
+        if (sizeof(*header_) + header_->num_counters * sizeof(kcounters_desc_entry_t) >
+            desc_.size()) {
+            return ZX_ERR_IO_DATA_INTEGRITY;
+        }
+
+        status = Map(kArenaPath, &arena_);
+        if (status != ZX_OK) {
+            return status;
+        }
+        if (static_cast<uint64_t>(header_->max_cpus) * header_->num_counters *
+                sizeof(int64_t) > arena_.size()) {
+            return ZX_ERR_IO_DATA_INTEGRITY;
+        }
+        return ZX_OK;
+    }
+
+    size_t size() const { return header_->num_counters; }
+
+    const char* name(size_t index) const {
+        auto entries = reinterpret_cast<const kcounters_desc_entry_t*>(header_ + 1);
+        return entries[index].name;
+    }
+
+    // The kernel updates the slots without synchronization, so load each
+    // one exactly once.
+    int64_t value(size_t index) const {
+        auto slots = static_cast<const int64_t*>(arena_.start());
+        int64_t sum = 0;
+        for (size_t cpu = 0; cpu < header_->max_cpus; cpu++) {
+            sum += __atomic_load_n(&slots[cpu * header_->num_counters + index],
+                                   __ATOMIC_RELAXED);
+        }
+        return sum;
+    }
+
+private:
+    static zx_status_t Map(const char* path, fzl::VmoMapper* mapper) {
+        fbl::unique_fd fd(open(path, O_RDONLY));
+        if (!fd) {
+            return ZX_ERR_NOT_FOUND;
+        }
+        // Takes the VMO itself rather than a copy-on-write clone, so that
+        // the arena stays live.
+        zx::vmo vmo;
+        zx_status_t status = fdio_get_vmo_exact(fd.get(), vmo.reset_and_get_address());
+        if (status != ZX_OK) {
+            return status;
+        }
+        uint64_t size;
+        status = vmo.get_size(&size);
+        if (status != ZX_OK) {
+            return status;
+        }
+        return mapper->Map(vmo, 0u, size, ZX_VM_PERM_READ);
+    }
+
+    fzl::VmoMapper desc_;
+    fzl::VmoMapper arena_;
+    const kcounters_desc_header_t* header_ = nullptr;
+};
+
+// The last |capacity| deltas of one counter, oldest first.
+class TimeSeries {
+public:
+    bool Init(size_t capacity) {
+        fbl::AllocChecker ac;
+        values_.reset(new (&ac) int64_t[capacity], capacity);
+        return ac.check();
+    }
+
+    void Add(int64_t value) {
+        values_[(first_ + size_) % values_.size()] = value;
+        if (size_ < values_.size()) {
+            size_++;
+        } else {
+            first_ = (first_ + 1) % values_.size();
+        }
+    }
+
+    size_t size() const { return size_; }
+    int64_t operator[](size_t i) const { return values_[(first_ + i) % values_.size()]; }
+
+private:
+    fbl::Array<int64_t> values_;
+    size_t first_ = 0;
+    size_t size_ = 0;
+};
+
+struct Watched {
+    size_t index;
+    int64_t last;
+    TimeSeries series;
+};
+
+void Usage(const char* argv0) {
+    fprintf(stderr,
+            "usage: %s [options] [prefix...]\n"
+            "\n"
+            "Prints the kernel counters whose names start with any |prefix|,\n"
+            "or all of them.\n"
+            "\n"
+            "options:\n"
+            "  -i <ms>     sample every <ms> milliseconds and print the changes\n"
+            "  -n <count>  stop after <count> samples and print a summary of the\n"
+            "              recent history (default: run until killed)\n"
+            "  -H <count>  samples of history to keep per counter (default: 60)\n",
+            argv0);
+}
+
+bool Matches(const char* name, int num_prefixes, char** prefixes) {
+    if (num_prefixes == 0) {
+        return true;
+    }
+    for (int i = 0; i < num_prefixes; i++) {
+        if (strncmp(name, prefixes[i], strlen(prefixes[i])) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void PrintSummary(const Counters& counters, const fbl::Vector<Watched>& watched,
+                  zx::duration interval) {
+    printf("per-interval change over the last samples (%" PRId64 "ms each):\n",
+           interval.to_msecs());
+    for (const Watched& w : watched) {
+        const TimeSeries& series = w.series;
+        if (series.size() == 0) {
+            continue;
+        }
+        int64_t min = series[0], max = series[0], sum = 0;
+        for (size_t i = 0; i < series.size(); i++) {
+            min = fbl::min(min, series[i]);
+            max = fbl::max(max, series[i]);
+            sum += series[i];
+        }
+        if (max == 0 && min == 0) {
+            continue;
+        }
+        printf("%-48s min %" PRId64 " avg %" PRId64 " max %" PRId64 "\n",
+               counters.name(w.index), min,
+               sum / static_cast<int64_t>(series.size()), max);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    zx::duration interval;
+    long samples = 0;
+    long history = 60;
+    int opt;
+    while ((opt = getopt(argc, argv, "i:n:H:h")) != -1) {
+        switch (opt) {
+        case 'i':
+            interval = zx::msec(atol(optarg));
+            break;
+        case 'n':
+            samples = atol(optarg);
+            break;
+        case 'H':
+            history = atol(optarg);
+            break;
+        default:
+            Usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (interval < zx::duration() || samples < 0 || history <= 0) {
+        Usage(argv[0]);
+        return 1;
+    }
+    int num_prefixes = argc - optind;
+    char** prefixes = argv + optind;
+
+    Counters counters;
+    zx_status_t status = counters.Open();
+    if (status != ZX_OK) {
+        fprintf(stderr, "kcounter: cannot read counters: %d(%s)\n",
+                status, zx_status_get_string(status));
+        return 1;
+    }
+
+    fbl::Vector<Watched> watched;
+    for (size_t i = 0; i < counters.size(); i++) {
+        if (!Matches(counters.name(i), num_prefixes, prefixes)) {
+            continue;
+        }
+        Watched w{i, counters.value(i), TimeSeries()};
+        if (!w.series.Init(static_cast<size_t>(history))) {
+            fprintf(stderr, "kcounter: out of memory\n");
+            return 1;
+        }
+        watched.push_back(fbl::move(w));
+    }
+
+    if (interval == zx::duration()) {
+        for (const Watched& w : watched) {
+            printf("%-48s %" PRId64 "\n", counters.name(w.index), w.last);
+        }
+        return 0;
+    }
+
+    zx::time deadline = zx::clock::get_monotonic();
+    for (long n = 0; samples == 0 || n < samples; n++) {
+        deadline += interval;
+        zx::nanosleep(deadline);
+        printf("--- %" PRId64 "ms\n", (n + 1) * interval.to_msecs());
+        for (Watched& w : watched) {
+            int64_t value = counters.value(w.index);
+            int64_t delta = value - w.last;
+            w.last = value;
+            w.series.Add(delta);
+            if (delta != 0) {
+                printf("%-48s %" PRId64 " (+%" PRId64 ")\n",
+                       counters.name(w.index), value, delta);
+            }
+        }
+    }
+
+    PrintSummary(counters, watched, interval);
+    return 0;
+}
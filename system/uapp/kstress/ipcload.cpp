@@ -0,0 +1,289 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <fbl/algorithm.h>
+#include <fbl/alloc_checker.h>
+#include <fbl/unique_ptr.h>
+#include <lib/zx/channel.h>
+#include <lib/zx/port.h>
+#include <lib/zx/time.h>
+#include <zircon/syscalls.h>
+#include <zircon/syscalls/port.h>
+#include <zircon/time.h>
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "load_profile.h"
+
+namespace {
+
+// Channel ping-pong
+//
+// The workers are paired up over a channel each; the even worker of a pair
+// makes zx_channel_call()s with a seeded random message size and the odd one
+// echoes the messages back. With a pair per two cpus the scheduler has to
+// keep waking threads on other cpus. Each operation is one round trip.
+class ChannelPingPongLoad : public LoadProfile {
+public:
+    zx_status_t Run(const LoadParams& params, LoadResult* result) override;
+
+    const char* name() const override { return "channel-pingpong"; }
+    const char* label() const override { return "ChannelPingPong"; }
+    const char* description() const override {
+        return "channel call round trips between pairs of threads";
+    }
+
+private:
+    static constexpr uint32_t kMaxMessageSize = 512;
+    static constexpr uint64_t kDefaultIterations = 20000;
+};
+
+zx_status_t ChannelPingPongLoad::Run(const LoadParams& params, LoadResult* result) {
+    const uint32_t pairs = fbl::max(params.threads / 2, 1u);
+
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<zx::channel[]> channels(new (&ac) zx::channel[pairs * 2]);
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    for (uint32_t i = 0; i < pairs; i++) {
+        zx_status_t status = zx::channel::create(0, &channels[i * 2], &channels[i * 2 + 1]);
+        if (status != ZX_OK) {
+            return status;
+        }
+    }
+
+    const uint64_t iterations = Iterations(params, kDefaultIterations);
+    auto worker = [&](uint32_t index, rand32_t* rand, perftest::LatencyHistogram* latencies) {
+        zx::channel& channel = channels[index];
+        uint8_t msg[kMaxMessageSize] = {};
+        uint8_t reply[kMaxMessageSize];
+        uint32_t actual_bytes;
+        uint32_t actual_handles;
+
+        // echo until the caller closes its end
+        auto echo = [&]() -> zx_status_t {
+            for (;;) {
+                zx_status_t status = channel.read(0, msg, sizeof(msg), &actual_bytes, nullptr, 0,
+                                                  &actual_handles);
+                if (status == ZX_ERR_SHOULD_WAIT) {
+                    status = channel.wait_one(ZX_CHANNEL_READABLE | ZX_CHANNEL_PEER_CLOSED,
+                                              zx::time::infinite(), nullptr);
+                    if (status != ZX_OK) {
+                        return status;
+                    }
+                    continue;
+                }
+                if (status == ZX_ERR_PEER_CLOSED) {
+                    return ZX_OK;
+                }
+                if (status != ZX_OK) {
+                    return status;
+                }
+                status = channel.write(0, msg, actual_bytes, nullptr, 0);
+                if (status != ZX_OK) {
+                    return status;
+                }
+            }
+        };
+        if (index % 2) {
+            // closing this end on failure stops the caller too
+            zx_status_t status = echo();
+            channel.reset();
+            return status;
+        }
+
+        for (uint64_t done = 0; done < iterations; done++) {
+            constexpr uint32_t kMinSize = sizeof(zx_txid_t);
+            uint32_t size = kMinSize + rand32(rand) % (kMaxMessageSize - kMinSize + 1);
+            zx_channel_call_args_t args = {
+                .wr_bytes = msg,
+                .wr_handles = nullptr,
+                .rd_bytes = reply,
+                .rd_handles = nullptr,
+                .wr_num_bytes = size,
+                .wr_num_handles = 0,
+                .rd_num_bytes = sizeof(reply),
+                .rd_num_handles = 0,
+            };
+            zx_time_t t0 = zx_clock_get_monotonic();
+            zx_status_t status = channel.call(0, zx::time::infinite(), &args, &actual_bytes,
+                                              &actual_handles);
+            latencies->Add(zx_time_sub_time(zx_clock_get_monotonic(), t0));
+            if (status != ZX_OK) {
+                channel.reset();
+                return status;
+            }
+        }
+        channel.reset();
+        return ZX_OK;
+    };
+
+    return RunWorkers(params, pairs * 2, worker, result);
+}
+
+// Port fan-in
+//
+// Every worker but the first queues user packets stamped with the time onto
+// one port, with a seeded random amount of work in between, and the first
+// worker drains them. Each operation is one packet, timed from being queued
+// to being dequeued.
+class PortFanInLoad : public LoadProfile {
+public:
+    zx_status_t Run(const LoadParams& params, LoadResult* result) override;
+
+    const char* name() const override { return "port-fanin"; }
+    const char* label() const override { return "PortFanIn"; }
+    const char* description() const override {
+        return "many threads queueing packets to one port";
+    }
+
+private:
+    static constexpr uint32_t kMaxSpin = 2000;
+    static constexpr uint64_t kDefaultIterations = 20000;
+    static constexpr zx::duration kTimeout = zx::sec(10);
+};
+
+zx_status_t PortFanInLoad::Run(const LoadParams& params, LoadResult* result) {
+    const uint32_t producers = fbl::max(params.threads, 2u) - 1;
+
+    zx::port port;
+    zx_status_t status = zx::port::create(0, &port);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    const uint64_t iterations = Iterations(params, kDefaultIterations);
+    auto worker = [&](uint32_t index, rand32_t* rand, perftest::LatencyHistogram* latencies) {
+        zx_port_packet_t packet = {};
+        if (index == 0) {
+            for (uint64_t left = producers * iterations; left > 0; left--) {
+                // a producer which failed never sends its packets
+                zx_status_t status = port.wait(zx::deadline_after(kTimeout), &packet);
+                if (status != ZX_OK) {
+                    return status;
+                }
+                latencies->Add(zx_time_sub_time(zx_clock_get_monotonic(),
+                                                static_cast<zx_time_t>(packet.user.u64[0])));
+            }
+            return ZX_OK;
+        }
+
+        packet.key = index;
+        packet.type = ZX_PKT_TYPE_USER;
+        for (uint64_t done = 0; done < iterations; done++) {
+            Spin(rand32(rand) % kMaxSpin);
+            packet.user.u64[0] = zx_clock_get_monotonic();
+            zx_status_t status;
+            while ((status = port.queue(&packet)) == ZX_ERR_SHOULD_WAIT) {
+                // the port is full; give the consumer a moment
+                zx::nanosleep(zx::deadline_after(zx::usec(10)));
+                packet.user.u64[0] = zx_clock_get_monotonic();
+            }
+            if (status != ZX_OK) {
+                return status;
+            }
+        }
+        return ZX_OK;
+    };
+
+    return RunWorkers(params, producers + 1, worker, result);
+}
+
+// Futex contention
+//
+// All the workers take and release one futex based lock, holding it for a
+// seeded random amount of work and doing some more outside it. Each
+// operation is one acquisition, timed until the lock is held, and the count
+// kept under the lock is checked at the end.
+class FutexContentionLoad : public LoadProfile {
+public:
+    zx_status_t Run(const LoadParams& params, LoadResult* result) override;
+
+    const char* name() const override { return "futex-contention"; }
+    const char* label() const override { return "FutexContention"; }
+    const char* description() const override {
+        return "many threads contending for one futex lock";
+    }
+
+private:
+    // lock states: unlocked, locked, and locked with waiters
+    enum : zx_futex_t {
+        kUnlocked = 0,
+        kLocked = 1,
+        kContended = 2,
+    };
+
+    static constexpr uint32_t kMaxHoldSpin = 200;
+    static constexpr uint32_t kMaxIdleSpin = 2000;
+    static constexpr uint64_t kDefaultIterations = 20000;
+
+    void Lock();
+    void Unlock();
+
+    zx_futex_t futex_ = kUnlocked;
+    uint64_t count_ = 0;
+};
+
+void FutexContentionLoad::Lock() {
+    zx_futex_t value = kUnlocked;
+    if (__atomic_compare_exchange_n(&futex_, &value, kLocked, false, __ATOMIC_ACQUIRE,
+                                    __ATOMIC_RELAXED)) {
+        return;
+    }
+    if (value != kContended) {
+        value = __atomic_exchange_n(&futex_, kContended, __ATOMIC_ACQUIRE);
+    }
+    while (value != kUnlocked) {
+        zx_futex_wait(&futex_, kContended, ZX_TIME_INFINITE);
+        value = __atomic_exchange_n(&futex_, kContended, __ATOMIC_ACQUIRE);
+    }
+}
+
+void FutexContentionLoad::Unlock() {
+    if (__atomic_exchange_n(&futex_, kUnlocked, __ATOMIC_RELEASE) == kContended) {
+        zx_futex_wake(&futex_, 1);
+    }
+}
+
+zx_status_t FutexContentionLoad::Run(const LoadParams& params, LoadResult* result) {
+    futex_ = kUnlocked;
+    count_ = 0;
+
+    const uint64_t iterations = Iterations(params, kDefaultIterations);
+    auto worker = [&](uint32_t index, rand32_t* rand, perftest::LatencyHistogram* latencies) {
+        for (uint64_t done = 0; done < iterations; done++) {
+            uint32_t hold = rand32(rand) % kMaxHoldSpin;
+            uint32_t idle = rand32(rand) % kMaxIdleSpin;
+
+            zx_time_t t0 = zx_clock_get_monotonic();
+            Lock();
+            latencies->Add(zx_time_sub_time(zx_clock_get_monotonic(), t0));
+            count_++;
+            Spin(hold);
+            Unlock();
+
+            Spin(idle);
+        }
+        return ZX_OK;
+    };
+
+    zx_status_t status = RunWorkers(params, params.threads, worker, result);
+    if (status == ZX_OK && count_ != params.threads * iterations) {
+        fprintf(stderr, "futex lock lost updates: counted %" PRIu64 " of %" PRIu64 "\n",
+                count_, params.threads * iterations);
+        return ZX_ERR_INTERNAL;
+    }
+    return status;
+}
+
+// our singletons
+ChannelPingPongLoad channel_pingpong;
+PortFanInLoad port_fanin;
+FutexContentionLoad futex_contention;
+
+} // namespace
@@ -0,0 +1,183 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <fbl/alloc_checker.h>
+#include <fbl/string_printf.h>
+#include <fbl/unique_ptr.h>
+#include <lib/sync/completion.h>
+#include <lib/zircon-internal/fnv1hash.h>
+#include <zircon/status.h>
+#include <zircon/syscalls.h>
+#include <zircon/time.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <threads.h>
+
+#include "load_profile.h"
+
+fbl::Vector<LoadProfile*> LoadProfile::profiles_;
+
+namespace {
+
+struct Worker {
+    const fbl::Function<zx_status_t(uint32_t, rand32_t*, perftest::LatencyHistogram*)>* fn;
+    sync_completion_t* start;
+    const bool* cancel;
+    uint32_t index;
+    rand32_t rand;
+    zx_status_t status;
+    perftest::LatencyHistogram latencies;
+    thrd_t thread;
+};
+
+// Seeds each worker differently, but the same way on every run.
+uint32_t WorkerSeed(uint32_t seed, uint32_t index) {
+    uint32_t words[2] = {seed, index};
+    uint32_t n = fnv1a32(words, sizeof(words));
+    // xorshift never leaves zero
+    return n ? n : 1;
+}
+
+const struct {
+    const char* name;
+    double fraction;
+} kPercentiles[] = {
+    {"P50", 0.50},
+    {"P90", 0.90},
+    {"P99", 0.99},
+    {"P999", 0.999},
+};
+
+// Prints |result| and adds it to |results|, under labels starting with
+// |label|.
+void Report(const char* label, const LoadResult& result, perftest::ResultsSet* results) {
+    const auto& lat = result.latencies;
+    double seconds = static_cast<double>(result.duration) / 1e9;
+    double ops_per_second = seconds > 0 ? static_cast<double>(lat.count()) / seconds : 0;
+    printf("%" PRIu64 " ops in %" PRIi64 " ns: %.1f ops/s\n", lat.count(), result.duration,
+           ops_per_second);
+    printf("latency: min %" PRIu64 " ns, mean %" PRIu64 " ns", lat.min(), lat.mean());
+    for (const auto& p : kPercentiles) {
+        printf(", %s %" PRIu64 " ns", p.name, lat.Percentile(p.fraction));
+    }
+    printf(", max %" PRIu64 " ns\n", lat.max());
+
+    auto* test_case = results->AddTestCase(
+        "fuchsia.zircon", fbl::StringPrintf("KStress/%s/Throughput", label), "ops/second");
+    test_case->AppendValue(ops_per_second);
+    for (const auto& p : kPercentiles) {
+        test_case = results->AddTestCase(
+            "fuchsia.zircon", fbl::StringPrintf("KStress/%s/Latency/%s", label, p.name),
+            "nanoseconds");
+        test_case->AppendValue(static_cast<double>(lat.Percentile(p.fraction)));
+    }
+    test_case = results->AddTestCase(
+        "fuchsia.zircon", fbl::StringPrintf("KStress/%s/Latency/Max", label), "nanoseconds");
+    test_case->AppendValue(static_cast<double>(lat.max()));
+}
+
+} // namespace
+
+zx_status_t LoadProfile::RunWorkers(const LoadParams& params, uint32_t count, WorkerFn fn,
+                                    LoadResult* result) {
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<Worker[]> workers(new (&ac) Worker[count]);
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+
+    sync_completion_t start;
+    bool cancel = false;
+    auto worker_thread = [](void* arg) -> int {
+        Worker* w = static_cast<Worker*>(arg);
+        sync_completion_wait(w->start, ZX_TIME_INFINITE);
+        if (!*w->cancel) {
+            w->status = (*w->fn)(w->index, &w->rand, &w->latencies);
+        }
+        return 0;
+    };
+
+    uint32_t started = 0;
+    zx_status_t status = ZX_OK;
+    for (; started < count; started++) {
+        Worker* w = &workers[started];
+        w->fn = &fn;
+        w->start = &start;
+        w->cancel = &cancel;
+        w->index = started;
+        w->rand.n = WorkerSeed(params.seed, started);
+        w->status = ZX_OK;
+        if (thrd_create_with_name(&w->thread, worker_thread, w, "kstress_load") !=
+            thrd_success) {
+            status = ZX_ERR_NO_RESOURCES;
+            break;
+        }
+    }
+
+    // workers may depend on each other, so if any failed to start, let the
+    // rest go without running anything
+    cancel = status != ZX_OK;
+    zx_time_t start_time = zx_clock_get_monotonic();
+    sync_completion_signal(&start);
+    for (uint32_t i = 0; i < started; i++) {
+        thrd_join(workers[i].thread, nullptr);
+    }
+    result->duration = zx_time_sub_time(zx_clock_get_monotonic(), start_time);
+
+    for (uint32_t i = 0; i < started; i++) {
+        if (status == ZX_OK) {
+            status = workers[i].status;
+        }
+        result->latencies.Merge(workers[i].latencies);
+    }
+    return status;
+}
+
+zx_status_t RunLoadProfiles(const fbl::Vector<const char*>& names, const LoadParams& params,
+                            perftest::ResultsSet* results) {
+    bool all = names.size() == 1 && !strcmp(names[0], "all");
+    for (const char* name : names) {
+        if (all) {
+            break;
+        }
+        bool found = false;
+        for (auto& profile : LoadProfile::profiles()) {
+            found = found || !strcmp(profile->name(), name);
+        }
+        if (!found) {
+            fprintf(stderr, "unknown load profile '%s'\n", name);
+            return ZX_ERR_NOT_FOUND;
+        }
+    }
+
+    for (auto& profile : LoadProfile::profiles()) {
+        bool selected = all;
+        for (const char* name : names) {
+            selected = selected || !strcmp(profile->name(), name);
+        }
+        if (!selected) {
+            continue;
+        }
+
+        printf("Running %s load, seed %u, %u threads\n", profile->name(), params.seed,
+               params.threads);
+        LoadResult result;
+        zx_status_t status = profile->Run(params, &result);
+        if (status != ZX_OK) {
+            fprintf(stderr, "%s load failed: %d (%s)\n", profile->name(), status,
+                    zx_status_get_string(status));
+            return status;
+        }
+        Report(profile->label(), result, results);
+    }
+    return ZX_OK;
+}
+
+void PrintLoadProfiles(FILE* f) {
+    for (auto& profile : LoadProfile::profiles()) {
+        fprintf(f, "\t  %-20s %s\n", profile->name(), profile->description());
+    }
+}
@@ -0,0 +1,96 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <stdio.h>
+
+#include <fbl/function.h>
+#include <fbl/macros.h>
+#include <fbl/vector.h>
+#include <lib/zircon-internal/xorshiftrand.h>
+#include <perftest/histogram.h>
+#include <perftest/results.h>
+#include <zircon/syscalls.h>
+#include <zircon/types.h>
+
+// A load profile runs a fixed, seeded workload against one part of the
+// kernel as hard as it can and measures it, unlike the stress tests, which
+// run random operations until they are stopped and only look for failures.
+// Given the same seed, thread count and iteration count a profile issues the
+// same sequence of operations from each thread on every run, so that
+// results can be compared across kernel changes.
+struct LoadParams {
+    uint32_t seed;
+    // number of worker threads; profiles which pair up threads round down
+    uint32_t threads;
+    // operations per worker thread, or 0 for the profile's default
+    uint64_t iterations;
+};
+
+struct LoadResult {
+    // wall time from starting the workers until the last one finished
+    zx_duration_t duration = 0;
+    // the latency of every operation counted towards the throughput
+    perftest::LatencyHistogram latencies;
+};
+
+class LoadProfile {
+public:
+    LoadProfile() {
+        profiles_.push_back(this);
+    }
+
+    virtual ~LoadProfile() = default;
+
+    DISALLOW_COPY_ASSIGN_AND_MOVE(LoadProfile);
+
+    // Runs the workload once and fills in |result|.
+    virtual zx_status_t Run(const LoadParams& params, LoadResult* result) = 0;
+
+    // Short name used to select the profile on the command line.
+    virtual const char* name() const = 0;
+
+    // Name used for the profile's perftest results, in CamelCase.
+    virtual const char* label() const = 0;
+
+    virtual const char* description() const = 0;
+
+    // get a ref to the list of all the profiles
+    static fbl::Vector<LoadProfile*>& profiles() { return profiles_; }
+
+protected:
+    // The body of a worker thread. |index| is the worker's number, from 0,
+    // and |rand| is seeded from it and the run's seed. Each operation to be
+    // measured should be timed into |latencies|.
+    using WorkerFn = fbl::Function<zx_status_t(uint32_t index, rand32_t* rand,
+                                               perftest::LatencyHistogram* latencies)>;
+
+    // Starts |count| workers running |fn| together, waits for all of them
+    // and merges their latencies into |result|. Returns the first error
+    // returned by a worker.
+    static zx_status_t RunWorkers(const LoadParams& params, uint32_t count, WorkerFn fn,
+                                  LoadResult* result);
+
+    // Burns roughly |n| loop iterations of cpu time.
+    static void Spin(uint32_t n) {
+        for (volatile uint32_t i = 0; i < n; i++) {
+        }
+    }
+
+    static uint64_t Iterations(const LoadParams& params, uint64_t default_iterations) {
+        return params.iterations ? params.iterations : default_iterations;
+    }
+
+private:
+    // global list of all the load profiles, registered at app start
+    static fbl::Vector<LoadProfile*> profiles_;
+};
+
+// Runs the profiles named in |names|, or all of them if it holds "all",
+// prints a summary of each and adds the results to |results|.
+zx_status_t RunLoadProfiles(const fbl::Vector<const char*>& names, const LoadParams& params,
+                            perftest::ResultsSet* results);
+
+void PrintLoadProfiles(FILE* f);
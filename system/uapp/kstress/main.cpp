@@ -8,6 +8,7 @@
 #include <lib/fdio/util.h>
 #include <lib/zx/channel.h>
 #include <lib/zx/resource.h>
+#include <perftest/results.h>
 #include <zircon/status.h>
 #include <zircon/syscalls.h>
 
@@ -23,10 +24,13 @@
 #include <threads.h>
 #include <unistd.h>
 
+#include "load_profile.h"
 #include "stress_test.h"
 
 namespace {
 
+constexpr uint32_t kDefaultSeed = 1;
+
 zx_status_t get_root_resource(zx::resource* root_resource) {
     int fd = open("/dev/misc/sysinfo", O_RDWR);
     if (fd < 0) {
@@ -86,6 +90,27 @@ void print_help(char** argv, FILE* f) {
     fprintf(f, "\t-h:                   This help\n");
     fprintf(f, "\t-t [time in seconds]: stop all tests after the time has elapsed\n");
     fprintf(f, "\t-v:                   verbose, status output\n");
+    fprintf(f, "\n");
+    fprintf(f, "\t-b [profile]:         run a load profile instead of the stress tests and\n");
+    fprintf(f, "\t                      report its throughput and latency; may be repeated,\n");
+    fprintf(f, "\t                      or \"all\" runs every profile:\n");
+    PrintLoadProfiles(f);
+    fprintf(f, "\t-s [seed]:            seed for the load profiles (default %u)\n", kDefaultSeed);
+    fprintf(f, "\t-j [threads]:         worker threads for the load profiles (default: cpus)\n");
+    fprintf(f, "\t-n [iterations]:      operations per worker thread (default: per profile)\n");
+    fprintf(f, "\t-o [file]:            write the load profile results as perftest JSON\n");
+}
+
+int run_load_profiles(const fbl::Vector<const char*>& profiles, const LoadParams& params,
+                      const char* output_file) {
+    perftest::ResultsSet results;
+    if (RunLoadProfiles(profiles, params, &results) != ZX_OK) {
+        return 1;
+    }
+    if (output_file != nullptr && !results.WriteJSONFile(output_file)) {
+        return 1;
+    }
+    return 0;
 }
 
 } // namespace
@@ -96,9 +121,46 @@ int main(int argc, char** argv) {
     bool verbose = false;
     zx::duration run_duration = zx::duration::infinite();
 
+    fbl::Vector<const char*> profiles;
+    LoadParams params = {
+        .seed = kDefaultSeed,
+        .threads = zx_system_get_num_cpus(),
+        .iterations = 0,
+    };
+    const char* output_file = nullptr;
+
     int c;
-    while ((c = getopt(argc, argv, "ht:v")) > 0) {
+    while ((c = getopt(argc, argv, "b:hj:n:o:s:t:v")) > 0) {
         switch (c) {
+        case 'b':
+            profiles.push_back(optarg);
+            break;
+        case 'j': {
+            long j = atol(optarg);
+            if (j <= 0 || j > UINT32_MAX) {
+                fprintf(stderr, "bad thread count\n");
+                print_help(argv, stderr);
+                return 1;
+            }
+            params.threads = static_cast<uint32_t>(j);
+            break;
+        }
+        case 'n': {
+            long long n = atoll(optarg);
+            if (n <= 0) {
+                fprintf(stderr, "bad iteration count\n");
+                print_help(argv, stderr);
+                return 1;
+            }
+            params.iterations = static_cast<uint64_t>(n);
+            break;
+        }
+        case 'o':
+            output_file = optarg;
+            break;
+        case 's':
+            params.seed = static_cast<uint32_t>(strtoul(optarg, nullptr, 0));
+            break;
         case 'h':
             print_help(argv, stdout);
             return 0;
@@ -122,6 +184,10 @@ int main(int argc, char** argv) {
         }
     }
 
+    if (!profiles.is_empty()) {
+        return run_load_profiles(profiles, params, output_file);
+    }
+
     // read some system stats for each test to use
     zx_info_kmem_stats_t kmem_stats;
     status = get_kmem_stats(&kmem_stats);
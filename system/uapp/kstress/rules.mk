@@ -10,8 +10,11 @@ MODULE_TYPE := userapp
 MODULE_GROUP := misc
 
 MODULE_SRCS += \
+    $(LOCAL_DIR)/ipcload.cpp \
+    $(LOCAL_DIR)/load_profile.cpp \
     $(LOCAL_DIR)/main.cpp \
     $(LOCAL_DIR)/stress_test.cpp \
+    $(LOCAL_DIR)/vmload.cpp \
     $(LOCAL_DIR)/vmstress.cpp
 
 MODULE_LIBS := \
@@ -21,6 +24,9 @@ MODULE_LIBS := \
 
 MODULE_STATIC_LIBS := \
     system/ulib/fbl \
+    system/ulib/perftest \
+    system/ulib/sync \
+    system/ulib/zircon-internal \
     system/ulib/zx \
     system/ulib/zxcpp \
 
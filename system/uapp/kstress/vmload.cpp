@@ -0,0 +1,164 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <lib/zx/vmar.h>
+#include <lib/zx/vmo.h>
+#include <zircon/syscalls.h>
+#include <zircon/time.h>
+
+#include <limits.h>
+#include <stdint.h>
+
+#include "load_profile.h"
+
+namespace {
+
+// Fault storm
+//
+// Every worker faults in the pages of its own region of one shared VMO in a
+// seeded random order, then decommits the region and starts again, so the
+// page fault path, the VMO's lock and the PMM are all hit from every cpu at
+// once. Each operation is one write fault.
+class FaultStormLoad : public LoadProfile {
+public:
+    zx_status_t Run(const LoadParams& params, LoadResult* result) override;
+
+    const char* name() const override { return "fault-storm"; }
+    const char* label() const override { return "FaultStorm"; }
+    const char* description() const override {
+        return "write faults on a shared vmo, decommitted between rounds";
+    }
+
+private:
+    static constexpr uint32_t kRegionPages = 256;
+    static constexpr uint64_t kDefaultIterations = 64 * kRegionPages;
+};
+
+zx_status_t FaultStormLoad::Run(const LoadParams& params, LoadResult* result) {
+    const uint64_t region_size = kRegionPages * PAGE_SIZE;
+    const uint64_t vmo_size = region_size * params.threads;
+
+    zx::vmo vmo;
+    zx_status_t status = zx::vmo::create(vmo_size, 0, &vmo);
+    if (status != ZX_OK) {
+        return status;
+    }
+    uintptr_t base;
+    status = zx::vmar::root_self()->map(0, vmo, 0, vmo_size,
+                                        ZX_VM_PERM_READ | ZX_VM_PERM_WRITE, &base);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    const uint64_t iterations = Iterations(params, kDefaultIterations);
+    auto worker = [&](uint32_t index, rand32_t* rand, perftest::LatencyHistogram* latencies) {
+        uint64_t offset = index * region_size;
+        volatile uint8_t* region = reinterpret_cast<volatile uint8_t*>(base + offset);
+        uint32_t order[kRegionPages];
+        for (uint32_t i = 0; i < kRegionPages; i++) {
+            order[i] = i;
+        }
+
+        uint64_t done = 0;
+        while (done < iterations) {
+            // shuffle the order the pages are faulted in
+            for (uint32_t i = kRegionPages - 1; i > 0; i--) {
+                uint32_t j = rand32(rand) % (i + 1);
+                uint32_t t = order[i];
+                order[i] = order[j];
+                order[j] = t;
+            }
+            for (uint32_t i = 0; i < kRegionPages && done < iterations; i++, done++) {
+                zx_time_t t0 = zx_clock_get_monotonic();
+                region[order[i] * PAGE_SIZE] = static_cast<uint8_t>(done);
+                latencies->Add(zx_time_sub_time(zx_clock_get_monotonic(), t0));
+            }
+            zx_status_t status = vmo.op_range(ZX_VMO_OP_DECOMMIT, offset, region_size,
+                                              nullptr, 0);
+            if (status != ZX_OK) {
+                return status;
+            }
+        }
+        return ZX_OK;
+    };
+
+    status = RunWorkers(params, params.threads, worker, result);
+    zx::vmar::root_self()->unmap(base, vmo_size);
+    return status;
+}
+
+// Clone chain fan-out
+//
+// All the workers clone one shared, committed parent VMO, build a short chain
+// of copy-on-write clones under their clone, write to one random page of the
+// last clone of the chain and tear the chain down again. Each operation is
+// one whole chain, so it measures clone creation, the copy-on-write fault
+// through the chain and the clean up, with every cpu adding clones to and
+// removing them from the same parent.
+class CloneFanoutLoad : public LoadProfile {
+public:
+    zx_status_t Run(const LoadParams& params, LoadResult* result) override;
+
+    const char* name() const override { return "clone-fanout"; }
+    const char* label() const override { return "CloneFanout"; }
+    const char* description() const override {
+        return "copy-on-write clone chains of one shared vmo";
+    }
+
+private:
+    static constexpr uint32_t kParentPages = 64;
+    static constexpr uint32_t kChainDepth = 4;
+    static constexpr uint64_t kDefaultIterations = 2000;
+};
+
+zx_status_t CloneFanoutLoad::Run(const LoadParams& params, LoadResult* result) {
+    const uint64_t size = kParentPages * PAGE_SIZE;
+
+    zx::vmo parent;
+    zx_status_t status = zx::vmo::create(size, 0, &parent);
+    if (status != ZX_OK) {
+        return status;
+    }
+    status = parent.op_range(ZX_VMO_OP_COMMIT, 0, size, nullptr, 0);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    const uint64_t iterations = Iterations(params, kDefaultIterations);
+    auto worker = [&](uint32_t index, rand32_t* rand, perftest::LatencyHistogram* latencies) {
+        for (uint64_t done = 0; done < iterations; done++) {
+            uint64_t page = rand32(rand) % kParentPages;
+            uint8_t value = static_cast<uint8_t>(index);
+
+            zx_time_t t0 = zx_clock_get_monotonic();
+            zx::vmo chain[kChainDepth];
+            const zx::vmo* from = &parent;
+            for (auto& clone : chain) {
+                zx_status_t status = from->clone(ZX_VMO_CLONE_COPY_ON_WRITE, 0, size, &clone);
+                if (status != ZX_OK) {
+                    return status;
+                }
+                from = &clone;
+            }
+            zx_status_t status = from->write(&value, page * PAGE_SIZE, sizeof(value));
+            if (status != ZX_OK) {
+                return status;
+            }
+            // close the chain from its end
+            for (uint32_t i = kChainDepth; i-- > 0;) {
+                chain[i].reset();
+            }
+            latencies->Add(zx_time_sub_time(zx_clock_get_monotonic(), t0));
+        }
+        return ZX_OK;
+    };
+
+    return RunWorkers(params, params.threads, worker, result);
+}
+
+// our singletons
+FaultStormLoad fault_storm;
+CloneFanoutLoad clone_fanout;
+
+} // namespace
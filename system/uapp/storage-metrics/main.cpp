@@ -86,6 +86,11 @@ void PrintFsStats(MinfsMetrics metrics) {
     printf("lookup calls:                       %lu\n", metrics.lookup_calls);
     printf("successful lookup calls:            %lu\n", metrics.lookup_calls_success);
     printf("lookup nanoseconds:                 %lu\n", metrics.lookup_ticks);
+    printf("\n");
+
+    printf("Path walk name cache metrics\n");
+    printf("name cache hits:                    %lu\n", metrics.name_cache_hits);
+    printf("name cache misses:                  %lu\n", metrics.name_cache_misses);
 }
 
 zx_status_t EnableFsStats(const char* path, bool enable) {
@@ -10,6 +10,7 @@
 #include <assert.h>
 #include <stdatomic.h>
 #include <stdlib.h>
+#include <threads.h>
 
 #include <zircon/assert.h>
 #include <zircon/listnode.h>
@@ -26,6 +27,16 @@
 // The port wait key associated with the dispatcher's control messages.
 #define KEY_CONTROL (0u)
 
+// Maximum number of packets dequeued from the port by a single wait.
+#define MAX_PACKETS_PER_WAIT (16u)
+
+// The loop whose port packets the current thread is dispatching, if any, and
+// whether a handler it ran posted a task which is already due.  Such tasks are
+// dispatched by the same thread once it finishes its batch of packets instead
+// of arming the timer and waking whichever thread takes the timer packet.
+static thread_local async_loop_t* t_handler_loop;
+static thread_local bool t_due_task_posted;
+
 static zx_time_t async_loop_now(async_dispatcher_t* dispatcher);
 static zx_status_t async_loop_begin_wait(async_dispatcher_t* dispatcher, async_wait_t* wait);
 static zx_status_t async_loop_cancel_wait(async_dispatcher_t* dispatcher, async_wait_t* wait);
@@ -86,16 +97,20 @@ typedef struct async_loop {
     mtx_t lock; // guards the lists and the dispatching tasks flag
     bool dispatching_tasks; // true while the loop is busy dispatching tasks
     list_node_t wait_list; // most recently added first
-    list_node_t task_list; // pending tasks, earliest deadline first
+    list_node_t task_list; // pending tasks not yet due when posted, earliest deadline first
+    list_node_t immediate_list; // pending tasks already due when posted, earliest deadline first
     list_node_t due_list; // due tasks, earliest deadline first
     list_node_t thread_list; // earliest created thread first
     list_node_t exception_list; // most recently added first
 } async_loop_t;
 
-static zx_status_t async_loop_run_once(async_loop_t* loop, zx_time_t deadline);
+static zx_status_t async_loop_run_once(async_loop_t* loop, zx_time_t deadline, bool once);
+static zx_status_t async_loop_dispatch_port_packet(async_loop_t* loop,
+                                                   const zx_port_packet_t* packet);
 static zx_status_t async_loop_dispatch_wait(async_loop_t* loop, async_wait_t* wait,
                                             zx_status_t status, const zx_packet_signal_t* signal);
 static zx_status_t async_loop_dispatch_tasks(async_loop_t* loop);
+static void async_loop_dispatch_deferred_tasks(async_loop_t* loop);
 static void async_loop_dispatch_task(async_loop_t* loop, async_task_t* task,
                                      zx_status_t status);
 static zx_status_t async_loop_dispatch_packet(async_loop_t* loop, async_receiver_t* receiver,
@@ -109,7 +124,9 @@ static zx_status_t async_loop_dispatch_exception(async_loop_t* loop,
                                                  zx_status_t status,
                                                  const zx_port_packet_t* report);
 static void async_loop_wake_threads(async_loop_t* loop);
-static void async_loop_insert_task_locked(async_loop_t* loop, async_task_t* task);
+static void async_loop_insert_task_locked(async_loop_t* loop, list_node_t* list,
+                                          async_task_t* task);
+static zx_time_t async_loop_next_deadline_locked(async_loop_t* loop);
 static void async_loop_restart_timer_locked(async_loop_t* loop);
 static void async_loop_invoke_prologue(async_loop_t* loop);
 static void async_loop_invoke_epilogue(async_loop_t* loop);
@@ -159,6 +176,7 @@ zx_status_t async_loop_create(const async_loop_config_t* config, async_loop_t**
     mtx_init(&loop->lock, mtx_plain);
     list_initialize(&loop->wait_list);
     list_initialize(&loop->task_list);
+    list_initialize(&loop->immediate_list);
     list_initialize(&loop->due_list);
     list_initialize(&loop->thread_list);
     list_initialize(&loop->exception_list);
@@ -216,6 +234,10 @@ void async_loop_shutdown(async_loop_t* loop) {
         async_task_t* task = node_to_task(node);
         async_loop_dispatch_task(loop, task, ZX_ERR_CANCELED);
     }
+    while ((node = list_remove_head(&loop->immediate_list))) {
+        async_task_t* task = node_to_task(node);
+        async_loop_dispatch_task(loop, task, ZX_ERR_CANCELED);
+    }
     while ((node = list_remove_head(&loop->task_list))) {
         async_task_t* task = node_to_task(node);
         async_loop_dispatch_task(loop, task, ZX_ERR_CANCELED);
@@ -237,7 +259,7 @@ zx_status_t async_loop_run(async_loop_t* loop, zx_time_t deadline, bool once) {
     zx_status_t status;
     atomic_fetch_add_explicit(&loop->active_threads, 1u, memory_order_acq_rel);
     do {
-        status = async_loop_run_once(loop, deadline);
+        status = async_loop_run_once(loop, deadline, once);
     } while (status == ZX_OK && !once);
     atomic_fetch_sub_explicit(&loop->active_threads, 1u, memory_order_acq_rel);
     return status;
@@ -251,56 +273,93 @@ zx_status_t async_loop_run_until_idle(async_loop_t* loop) {
     return status;
 }
 
-static zx_status_t async_loop_run_once(async_loop_t* loop, zx_time_t deadline) {
+static zx_status_t async_loop_run_once(async_loop_t* loop, zx_time_t deadline, bool once) {
     async_loop_state_t state = atomic_load_explicit(&loop->state, memory_order_acquire);
     if (state == ASYNC_LOOP_SHUTDOWN)
         return ZX_ERR_BAD_STATE;
     if (state != ASYNC_LOOP_RUNNABLE)
         return ZX_ERR_CANCELED;
 
-    zx_port_packet_t packet;
-    zx_status_t status = zx_port_wait(loop->port, deadline, &packet);
+    zx_port_packet_t packets[MAX_PACKETS_PER_WAIT];
+    size_t count = 0u;
+    zx_status_t status = zx_port_wait_many(loop->port, deadline, packets,
+                                           once ? 1u : MAX_PACKETS_PER_WAIT, &count);
     if (status != ZX_OK)
         return status;
 
-    if (packet.key == KEY_CONTROL) {
+    // The packets have already been removed from the port, so all of them
+    // are dispatched even if the loop is quitted part way through the batch.
+    async_loop_t* prior_handler_loop = t_handler_loop;
+    bool prior_due_task_posted = t_due_task_posted;
+    t_handler_loop = once ? NULL : loop;
+    t_due_task_posted = false;
+    for (size_t i = 0; i < count; i++) {
+        status = async_loop_dispatch_port_packet(loop, &packets[i]);
+        if (status != ZX_OK)
+            break;
+    }
+    t_handler_loop = prior_handler_loop;
+    if (t_due_task_posted)
+        async_loop_dispatch_deferred_tasks(loop);
+    t_due_task_posted = prior_due_task_posted;
+    return status;
+}
+
+static void async_loop_dispatch_deferred_tasks(async_loop_t* loop) {
+    // Run the tasks our handlers posted now, unless the loop stopped running
+    // in the meantime, in which case they wait for the timer as usual.
+    async_loop_state_t state = atomic_load_explicit(&loop->state, memory_order_acquire);
+    if (state == ASYNC_LOOP_RUNNABLE) {
+        async_loop_dispatch_tasks(loop);
+        return;
+    }
+
+    mtx_lock(&loop->lock);
+    if (!loop->dispatching_tasks)
+        async_loop_restart_timer_locked(loop);
+    mtx_unlock(&loop->lock);
+}
+
+static zx_status_t async_loop_dispatch_port_packet(async_loop_t* loop,
+                                                   const zx_port_packet_t* packet) {
+    if (packet->key == KEY_CONTROL) {
         // Handle wake-up packets.
-        if (packet.type == ZX_PKT_TYPE_USER)
+        if (packet->type == ZX_PKT_TYPE_USER)
             return ZX_OK;
 
         // Handle task timer expirations.
-        if (packet.type == ZX_PKT_TYPE_SIGNAL_REP &&
-            packet.signal.observed & ZX_TIMER_SIGNALED) {
+        if (packet->type == ZX_PKT_TYPE_SIGNAL_REP &&
+            packet->signal.observed & ZX_TIMER_SIGNALED) {
             return async_loop_dispatch_tasks(loop);
         }
     } else {
         // Handle wait completion packets.
-        if (packet.type == ZX_PKT_TYPE_SIGNAL_ONE) {
-            async_wait_t* wait = (void*)(uintptr_t)packet.key;
+        if (packet->type == ZX_PKT_TYPE_SIGNAL_ONE) {
+            async_wait_t* wait = (void*)(uintptr_t)packet->key;
             mtx_lock(&loop->lock);
             list_delete(wait_to_node(wait));
             mtx_unlock(&loop->lock);
-            return async_loop_dispatch_wait(loop, wait, packet.status, &packet.signal);
+            return async_loop_dispatch_wait(loop, wait, packet->status, &packet->signal);
         }
 
         // Handle queued user packets.
-        if (packet.type == ZX_PKT_TYPE_USER) {
-            async_receiver_t* receiver = (void*)(uintptr_t)packet.key;
-            return async_loop_dispatch_packet(loop, receiver, packet.status, &packet.user);
+        if (packet->type == ZX_PKT_TYPE_USER) {
+            async_receiver_t* receiver = (void*)(uintptr_t)packet->key;
+            return async_loop_dispatch_packet(loop, receiver, packet->status, &packet->user);
         }
 
         // Handle guest bell trap packets.
-        if (packet.type == ZX_PKT_TYPE_GUEST_BELL) {
-            async_guest_bell_trap_t* trap = (void*)(uintptr_t)packet.key;
+        if (packet->type == ZX_PKT_TYPE_GUEST_BELL) {
+            async_guest_bell_trap_t* trap = (void*)(uintptr_t)packet->key;
             return async_loop_dispatch_guest_bell_trap(
-                loop, trap, packet.status, &packet.guest_bell);
+                loop, trap, packet->status, &packet->guest_bell);
         }
 
         // Handle exception packets.
-        if (ZX_PKT_IS_EXCEPTION(packet.type)) {
-            async_exception_t* exception = (void*)(uintptr_t)packet.key;
-            return async_loop_dispatch_exception(loop, exception, packet.status,
-                                                 &packet);
+        if (ZX_PKT_IS_EXCEPTION(packet->type)) {
+            async_exception_t* exception = (void*)(uintptr_t)packet->key;
+            return async_loop_dispatch_exception(loop, exception, packet->status,
+                                                 packet);
         }
     }
 
@@ -346,24 +405,25 @@ static zx_status_t async_loop_dispatch_tasks(async_loop_t* loop) {
 
         // Extract all of the tasks that are due into |due_list| for dispatch
         // unless we already have some waiting from a previous iteration which
-        // we would like to process in order.
+        // we would like to process in order.  Every task in |immediate_list|
+        // is due; merge them with the due tasks from |task_list| so that they
+        // are still dispatched earliest deadline first.
         list_node_t* node;
         if (list_is_empty(&loop->due_list)) {
             zx_time_t due_time = async_loop_now((async_dispatcher_t*)loop);
-            list_node_t* tail = NULL;
-            list_for_every(&loop->task_list, node) {
-                if (node_to_task(node)->deadline > due_time)
+            for (;;) {
+                list_node_t* immediate = list_peek_head(&loop->immediate_list);
+                list_node_t* timed = list_peek_head(&loop->task_list);
+                if (timed && node_to_task(timed)->deadline > due_time)
+                    timed = NULL;
+                if (!immediate && !timed)
                     break;
-                tail = node;
-            }
-            if (tail) {
-                list_node_t* head = loop->task_list.next;
-                loop->task_list.next = tail->next;
-                tail->next->prev = &loop->task_list;
-                loop->due_list.next = head;
-                head->prev = &loop->due_list;
-                loop->due_list.prev = tail;
-                tail->next = &loop->due_list;
+                node = (immediate && (!timed || node_to_task(immediate)->deadline <
+                                                    node_to_task(timed)->deadline))
+                           ? immediate
+                           : timed;
+                list_delete(node);
+                list_add_tail(&loop->due_list, node);
             }
         }
 
@@ -547,13 +607,24 @@ static zx_status_t async_loop_post_task(async_dispatcher_t* async, async_task_t*
     if (atomic_load_explicit(&loop->state, memory_order_acquire) == ASYNC_LOOP_SHUTDOWN)
         return ZX_ERR_BAD_STATE;
 
+    // Tasks which are already due (such as those posted with async::PostTask)
+    // are kept apart from those with deadlines in the future, so that posting
+    // one does not have to walk past every delayed task to find its place.
+    bool immediate = task->deadline <= async_loop_now(async);
+
     mtx_lock(&loop->lock);
 
-    async_loop_insert_task_locked(loop, task);
-    if (!loop->dispatching_tasks &&
-        task_to_node(task)->prev == &loop->task_list) {
-        // Task inserted at head.  Earliest deadline changed.
-        async_loop_restart_timer_locked(loop);
+    zx_time_t prior_deadline = async_loop_next_deadline_locked(loop);
+    async_loop_insert_task_locked(loop, immediate ? &loop->immediate_list : &loop->task_list,
+                                  task);
+    if (!loop->dispatching_tasks && task->deadline < prior_deadline) {
+        // Earliest deadline changed.  If we are posting from one of the loop's
+        // own handlers, this thread will dispatch the task itself right after.
+        if (immediate && t_handler_loop == loop) {
+            t_due_task_posted = true;
+        } else {
+            async_loop_restart_timer_locked(loop);
+        }
     }
 
     mtx_unlock(&loop->lock);
@@ -569,8 +640,8 @@ static zx_status_t async_loop_cancel_task(async_dispatcher_t* async, async_task_
     // destroyed in case the client is counting on the handler not being
     // invoked again past this point.  Also, the task we're removing here
     // might be present in the dispatcher's |due_list| if it is pending
-    // dispatch instead of in the loop's |task_list| as usual.  The same
-    // logic works in both cases.
+    // dispatch instead of in the loop's |task_list| or |immediate_list| as
+    // usual.  The same logic works in all cases.
 
     mtx_lock(&loop->lock);
     list_node_t* node = task_to_node(task);
@@ -579,14 +650,13 @@ static zx_status_t async_loop_cancel_task(async_dispatcher_t* async, async_task_
         return ZX_ERR_NOT_FOUND;
     }
 
-    // Determine whether the head task was canceled and following task has
-    // a later deadline.  If so, we will bump the timer along to that deadline.
-    bool must_restart = !loop->dispatching_tasks &&
-                        node->prev == &loop->task_list &&
-                        node->next != &loop->task_list &&
-                        node_to_task(node->next)->deadline > task->deadline;
+    // Determine whether the earliest deadline became later by canceling the
+    // task.  If so, we will bump the timer along to the new earliest deadline.
+    zx_time_t prior_deadline = async_loop_next_deadline_locked(loop);
     list_delete(node);
-    if (must_restart)
+    zx_time_t next_deadline = async_loop_next_deadline_locked(loop);
+    if (!loop->dispatching_tasks &&
+        next_deadline > prior_deadline && next_deadline != ZX_TIME_INFINITE)
         async_loop_restart_timer_locked(loop);
 
     mtx_unlock(&loop->lock);
@@ -701,27 +771,35 @@ static zx_status_t async_loop_resume_from_exception(async_dispatcher_t* async,
     return zx_task_resume_from_exception(task, loop->port, options);
 }
 
-static void async_loop_insert_task_locked(async_loop_t* loop, async_task_t* task) {
+static void async_loop_insert_task_locked(async_loop_t* loop, list_node_t* list,
+                                          async_task_t* task) {
     // TODO(ZX-976): We assume that tasks are inserted in quasi-monotonic order and
     // that insertion into the task queue will typically take no more than a few steps.
     // If this assumption proves false and the cost of insertion becomes a problem, we
     // should consider using a more efficient representation for maintaining order.
     list_node_t* node;
-    for (node = loop->task_list.prev; node != &loop->task_list; node = node->prev) {
+    for (node = list->prev; node != list; node = node->prev) {
         if (task->deadline >= node_to_task(node)->deadline)
             break;
     }
     list_add_after(node, task_to_node(task));
 }
 
+static zx_time_t async_loop_next_deadline_locked(async_loop_t* loop) {
+    zx_time_t deadline = ZX_TIME_INFINITE;
+    list_node_t* head = list_peek_head(&loop->immediate_list);
+    if (head)
+        deadline = node_to_task(head)->deadline;
+    head = list_peek_head(&loop->task_list);
+    if (head && node_to_task(head)->deadline < deadline)
+        deadline = node_to_task(head)->deadline;
+    return deadline;
+}
+
 static void async_loop_restart_timer_locked(async_loop_t* loop) {
     zx_time_t deadline;
     if (list_is_empty(&loop->due_list)) {
-        list_node_t* head = list_peek_head(&loop->task_list);
-        if (!head)
-            return;
-        async_task_t* task = node_to_task(head);
-        deadline = task->deadline;
+        deadline = async_loop_next_deadline_locked(loop);
         if (deadline == ZX_TIME_INFINITE)
             return;
     } else {
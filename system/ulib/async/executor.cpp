@@ -0,0 +1,306 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <lib/async/cpp/executor.h>
+
+#include <fbl/auto_lock.h>
+#include <fbl/intrusive_double_list.h>
+#include <fbl/mutex.h>
+#include <lib/async/task.h>
+#include <lib/async/time.h>
+#include <zircon/assert.h>
+
+namespace async {
+
+// Tracks the tasks of an executor.
+//
+// Every task is in exactly one of these states: queued on |runnable_|,
+// running, or parked on |suspended_| while it waits to be resumed (or, once
+// it has completed or been abandoned, while tickets for it are still
+// outstanding).  Tickets are the addresses of the tasks they refer to.
+//
+// The implementation is deleted once the executor has been destroyed and
+// no more tasks remain: suspended tasks may be resumed or released from
+// other threads after the executor is gone.
+class Executor::DispatcherImpl final : public fit::suspended_task::resolver {
+public:
+    DispatcherImpl(async_dispatcher_t* dispatcher, Executor* executor);
+
+    void ScheduleTask(fit::pending_task pending);
+
+    // Abandons all remaining tasks.  Deletes the implementation once no
+    // suspended tasks hold tickets for it.
+    void Shutdown();
+
+    fit::suspended_task::ticket duplicate_ticket(
+        fit::suspended_task::ticket ticket) override;
+    void resolve_ticket(fit::suspended_task::ticket ticket,
+                        bool resume_task) override;
+
+private:
+    enum class TaskState {
+        kQueued,
+        kRunning,
+        kSuspended,
+        // Held by |Shutdown()| until it abandons the task.
+        kAbandoning,
+    };
+
+    struct Task : public fbl::DoublyLinkedListable<Task*> {
+        explicit Task(fit::pending_task pending)
+            : pending(static_cast<fit::pending_task&&>(pending)) {}
+
+        fit::pending_task pending;
+        TaskState state = TaskState::kQueued;
+        uint64_t ticket_count = 0;
+        // Set when the task is resumed while it is running.
+        bool resume_requested = false;
+    };
+
+    class Context final : public fit::context {
+    public:
+        Context(DispatcherImpl* impl, Task* task)
+            : impl_(impl), task_(task) {}
+
+        fit::executor* executor() const override { return impl_->executor_; }
+        fit::suspended_task suspend_task() override;
+
+    private:
+        DispatcherImpl* const impl_;
+        Task* const task_;
+    };
+
+    struct DispatchTask : public async_task_t {
+        DispatcherImpl* impl;
+    };
+
+    ~DispatcherImpl() override;
+
+    static void HandleDispatch(async_dispatcher_t* dispatcher, async_task_t* task,
+                               zx_status_t status);
+    void RunTasks();
+
+    // Queues |task| and posts |dispatch_task_| if needed.
+    void EnqueueLocked(Task* task);
+
+    // Parks a task which is not queued or running, or deletes it if no
+    // tickets refer to it.  Returns its promise if it was abandoned before
+    // completing; the caller destroys it after releasing the lock since
+    // its destructor may release other tickets.
+    fit::pending_task ParkOrDeleteLocked(Task* task);
+
+    // Deletes the implementation if the executor is gone and nothing
+    // refers to it any more.
+    void MaybeDelete();
+
+    async_dispatcher_t* const dispatcher_;
+    Executor* const executor_;
+    DispatchTask dispatch_task_;
+
+    fbl::Mutex mutex_;
+    fbl::DoublyLinkedList<Task*> runnable_;
+    fbl::DoublyLinkedList<Task*> suspended_;
+    size_t task_count_ = 0;
+    bool dispatch_posted_ = false;
+    bool shutdown_ = false;
+    bool deleting_ = false;
+};
+
+Executor::DispatcherImpl::DispatcherImpl(async_dispatcher_t* dispatcher, Executor* executor)
+    : dispatcher_(dispatcher), executor_(executor),
+      dispatch_task_{{{ASYNC_STATE_INIT}, &DispatcherImpl::HandleDispatch, ZX_TIME_INFINITE},
+                     this} {}
+
+Executor::DispatcherImpl::~DispatcherImpl() {
+    ZX_DEBUG_ASSERT(task_count_ == 0);
+    ZX_DEBUG_ASSERT(!dispatch_posted_);
+}
+
+void Executor::DispatcherImpl::ScheduleTask(fit::pending_task pending) {
+    if (!pending)
+        return;
+
+    auto* task = new Task(static_cast<fit::pending_task&&>(pending));
+    fbl::AutoLock lock(&mutex_);
+    ZX_DEBUG_ASSERT(!shutdown_);
+    task_count_++;
+    EnqueueLocked(task);
+}
+
+void Executor::DispatcherImpl::Shutdown() {
+    fbl::DoublyLinkedList<Task*> runnable;
+    fbl::DoublyLinkedList<Task*> suspended;
+    {
+        fbl::AutoLock lock(&mutex_);
+        ZX_DEBUG_ASSERT(!shutdown_);
+        shutdown_ = true;
+        if (dispatch_posted_ && async_cancel_task(dispatcher_, &dispatch_task_) == ZX_OK)
+            dispatch_posted_ = false;
+        runnable.swap(runnable_);
+        suspended.swap(suspended_);
+        for (auto& task : runnable)
+            task.state = TaskState::kAbandoning;
+        for (auto& task : suspended)
+            task.state = TaskState::kAbandoning;
+    }
+
+    // Abandon the tasks one at a time since destroying their promises may
+    // release tickets for other tasks.
+    for (;;) {
+        fit::pending_task abandoned;
+        {
+            fbl::AutoLock lock(&mutex_);
+            Task* task = !runnable.is_empty() ? runnable.pop_front() : suspended.pop_front();
+            if (!task)
+                break;
+            abandoned = static_cast<fit::pending_task&&>(task->pending);
+            ParkOrDeleteLocked(task);
+        }
+    }
+
+    MaybeDelete();
+}
+
+fit::suspended_task::ticket Executor::DispatcherImpl::duplicate_ticket(
+    fit::suspended_task::ticket ticket) {
+    fbl::AutoLock lock(&mutex_);
+    auto* task = reinterpret_cast<Task*>(ticket);
+    ZX_DEBUG_ASSERT(task->ticket_count > 0);
+    task->ticket_count++;
+    return ticket;
+}
+
+void Executor::DispatcherImpl::resolve_ticket(fit::suspended_task::ticket ticket,
+                                              bool resume_task) {
+    fit::pending_task abandoned;
+    {
+        fbl::AutoLock lock(&mutex_);
+        auto* task = reinterpret_cast<Task*>(ticket);
+        ZX_DEBUG_ASSERT(task->ticket_count > 0);
+        task->ticket_count--;
+
+        if (task->state == TaskState::kRunning) {
+            if (resume_task)
+                task->resume_requested = true;
+        } else if (task->state == TaskState::kSuspended) {
+            if (resume_task && task->pending) {
+                suspended_.erase(*task);
+                EnqueueLocked(task);
+            } else if (task->ticket_count == 0) {
+                suspended_.erase(*task);
+                abandoned = ParkOrDeleteLocked(task);
+            }
+        }
+    }
+
+    // Destroy the abandoned task before the implementation can be deleted.
+    abandoned = fit::pending_task();
+    MaybeDelete();
+}
+
+fit::suspended_task Executor::DispatcherImpl::Context::suspend_task() {
+    fbl::AutoLock lock(&impl_->mutex_);
+    task_->ticket_count++;
+    return fit::suspended_task(impl_, reinterpret_cast<fit::suspended_task::ticket>(task_));
+}
+
+void Executor::DispatcherImpl::HandleDispatch(async_dispatcher_t* dispatcher,
+                                              async_task_t* task, zx_status_t status) {
+    auto* impl = static_cast<DispatchTask*>(task)->impl;
+    if (status == ZX_OK) {
+        impl->RunTasks();
+    } else {
+        // The dispatcher is shutting down so the tasks can no longer run.
+        // They are abandoned when the executor is destroyed.
+        fbl::AutoLock lock(&impl->mutex_);
+        impl->dispatch_posted_ = false;
+    }
+
+    // The executor may have been destroyed without being able to cancel
+    // the dispatch.
+    impl->MaybeDelete();
+}
+
+void Executor::DispatcherImpl::RunTasks() {
+    // Only run the tasks which were runnable when the dispatch began so
+    // that tasks which keep resuming themselves cannot starve other work
+    // on the dispatcher: tasks queued from here on post a new dispatch.
+    fbl::DoublyLinkedList<Task*> batch;
+    {
+        fbl::AutoLock lock(&mutex_);
+        dispatch_posted_ = false;
+        batch.swap(runnable_);
+    }
+
+    for (;;) {
+        Task* task;
+        {
+            fbl::AutoLock lock(&mutex_);
+            task = batch.pop_front();
+            if (!task)
+                break;
+            task->state = TaskState::kRunning;
+        }
+
+        Context context(this, task);
+        bool finished = task->pending(context);
+
+        fit::pending_task abandoned;
+        {
+            fbl::AutoLock lock(&mutex_);
+            if (!finished && task->resume_requested) {
+                task->resume_requested = false;
+                EnqueueLocked(task);
+            } else {
+                abandoned = ParkOrDeleteLocked(task);
+            }
+        }
+    }
+}
+
+void Executor::DispatcherImpl::EnqueueLocked(Task* task) {
+    task->state = TaskState::kQueued;
+    runnable_.push_back(task);
+    if (!dispatch_posted_ && !shutdown_) {
+        dispatch_task_.deadline = async_now(dispatcher_);
+        if (async_post_task(dispatcher_, &dispatch_task_) == ZX_OK)
+            dispatch_posted_ = true;
+    }
+}
+
+fit::pending_task Executor::DispatcherImpl::ParkOrDeleteLocked(Task* task) {
+    if (task->ticket_count > 0) {
+        task->state = TaskState::kSuspended;
+        suspended_.push_back(task);
+        return fit::pending_task();
+    }
+
+    fit::pending_task abandoned(static_cast<fit::pending_task&&>(task->pending));
+    delete task;
+    task_count_--;
+    return abandoned;
+}
+
+void Executor::DispatcherImpl::MaybeDelete() {
+    {
+        fbl::AutoLock lock(&mutex_);
+        if (!shutdown_ || task_count_ > 0 || dispatch_posted_ || deleting_)
+            return;
+        deleting_ = true;
+    }
+    delete this;
+}
+
+Executor::Executor(async_dispatcher_t* dispatcher)
+    : dispatcher_(dispatcher), impl_(new DispatcherImpl(dispatcher, this)) {}
+
+Executor::~Executor() {
+    impl_->Shutdown();
+}
+
+void Executor::schedule_task(fit::pending_task task) {
+    impl_->ScheduleTask(static_cast<fit::pending_task&&>(task));
+}
+
+} // namespace async
@@ -0,0 +1,55 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <lib/async/dispatcher.h>
+#include <lib/fit/promise.h>
+
+namespace async {
+
+// Runs |fit::promise| based tasks on an asynchronous dispatcher.
+//
+// Scheduled tasks are evaluated on the dispatcher's thread until they
+// complete.  A task which returns |fit::pending()| is put aside until it is
+// resumed through the |fit::suspended_task| it obtained from its context
+// (from any thread); a suspended task which nothing can resume any more is
+// abandoned and destroyed.
+//
+// Runnable tasks are queued and evaluated in a batch by a single async task
+// which the executor posts to the dispatcher whenever the queue becomes
+// non-empty, so running a task costs one indirect call and no heap
+// allocation beyond the one made when it is scheduled.
+//
+// Tasks may be scheduled and resumed from any thread but the executor
+// must be destroyed on the dispatcher's thread.  Destroying the executor
+// abandons all of its remaining tasks.  The dispatcher must outlive the
+// executor.
+class Executor final : public fit::executor {
+public:
+    explicit Executor(async_dispatcher_t* dispatcher);
+    ~Executor() override;
+
+    Executor(const Executor&) = delete;
+    Executor(Executor&&) = delete;
+    Executor& operator=(const Executor&) = delete;
+    Executor& operator=(Executor&&) = delete;
+
+    // Gets the executor's dispatcher.
+    async_dispatcher_t* dispatcher() const { return dispatcher_; }
+
+    // Schedules a task to be run on the dispatcher's thread.
+    // The executor takes ownership of the task.
+    void schedule_task(fit::pending_task task) override;
+
+private:
+    class DispatcherImpl;
+
+    async_dispatcher_t* const dispatcher_;
+
+    // Outlives the executor while suspended tasks still hold tickets for it.
+    DispatcherImpl* impl_;
+};
+
+} // namespace async
@@ -75,6 +75,39 @@ MODULE_PACKAGE := src
 
 include make/module.mk
 
+#
+# libasync-executor.a: the executor for fit::promise based tasks
+#
+
+# Disabled for now because libstdc++ isn't available for Zircon targets yet.
+ifeq (0,1)
+MODULE := $(LOCAL_DIR).executor
+MODULE_NAME := async-executor
+
+MODULE_TYPE := userlib
+MODULE_COMPILEFLAGS += -fvisibility=hidden
+
+MODULE_SRCS = \
+    $(LOCAL_DIR)/executor.cpp
+
+MODULE_PACKAGE_SRCS := $(MODULE_SRCS)
+MODULE_PACKAGE_INCS := \
+    $(LOCAL_INC)/cpp/executor.h
+
+MODULE_STATIC_LIBS := \
+    system/ulib/async \
+    system/ulib/fbl \
+    system/ulib/fit
+
+MODULE_LIBS := \
+    system/ulib/c \
+    system/ulib/zircon
+
+MODULE_PACKAGE := src
+
+include make/module.mk
+endif
+
 #
 # libasync-default.so: the default dispatcher state library
 #
@@ -110,64 +110,63 @@ zx_status_t CheckFvmConsistency(const Superblock* info, int block_fd) {
     return ZX_OK;
 }
 
-// A wrapper around "Enqueue" for content which risks being larger
-// than the writeback buffer.
-//
-// For content which is smaller than 3/4 the size of the writeback buffer: the
-// content is enqueued to |work| without flushing.
-//
-// For content which is larger than 3/4 the size of the writeback buffer: flush
-// the data by enqueueing it to the writeback thread in chunks until the
-// remainder is small enough to comfortably fit within the writeback buffer.
-zx_status_t EnqueuePaginated(fbl::unique_ptr<WritebackWork>* work, Blobfs* blobfs, VnodeBlob* vn,
-                             zx_handle_t vmo, uint64_t relative_block, uint64_t absolute_block,
-                             uint64_t nblocks) {
-    const size_t kMaxChunkBlocks = (3 * blobfs->WritebackCapacity()) / 4;
-    uint64_t delta_blocks = fbl::min(nblocks, kMaxChunkBlocks);
-    while (nblocks > 0) {
-        (*work)->Enqueue(vmo, relative_block, absolute_block, delta_blocks);
-        relative_block += delta_blocks;
-        absolute_block += delta_blocks;
-        nblocks -= delta_blocks;
-        delta_blocks = fbl::min(nblocks, kMaxChunkBlocks);
-        if (nblocks) {
-            fbl::unique_ptr<WritebackWork> tmp;
-            zx_status_t status = blobfs->CreateWork(&tmp, vn);
-            if (status != ZX_OK) {
-                return status;
-            }
-            if ((status = blobfs->EnqueueWork(fbl::move(*work), EnqueueType::kData)) != ZX_OK) {
-                return status;
-            }
-            *work = fbl::move(tmp);
-        }
-    }
-    return ZX_OK;
-}
-
 }  // namespace
 
 Inode* Blobfs::GetNode(size_t index) const {
     return &reinterpret_cast<Inode*>(node_map_.start())[index];
 }
 
-zx_status_t VnodeBlob::Verify() const {
-    TRACE_DURATION("blobfs", "Blobfs::Verify");
-    fs::Ticker ticker(blobfs_->CollectingMetrics());
+zx_status_t VnodeBlob::Verify() {
+    return VerifyRange(0, inode_.blob_size);
+}
 
+zx_status_t VnodeBlob::VerifyRange(uint64_t offset, uint64_t length) {
+    TRACE_DURATION("blobfs", "Blobfs::VerifyRange", "offset", offset, "length", length);
     const void* data = inode_.blob_size ? GetData() : nullptr;
     const void* tree = inode_.blob_size ? GetMerkle() : nullptr;
     const uint64_t data_size = inode_.blob_size;
     const uint64_t merkle_size = MerkleTree::GetTreeLength(data_size);
-    // TODO(smklein): We could lazily verify more of the VMO if
-    // we could fault in pages on-demand.
-    //
-    // For now, we aggressively verify the entire VMO up front.
+    const uint64_t num_nodes = fbl::round_up(data_size, MerkleTree::kNodeSize) /
+                               MerkleTree::kNodeSize;
+
+    zx_status_t status;
+    if (verified_.size() != num_nodes && (status = verified_.Reset(num_nodes)) != ZX_OK) {
+        return status;
+    }
+
+    // Each run of nodes that hasn't been verified yet is checked, along with
+    // the path from it to the root, with a single call. The null blob has no
+    // nodes, but still has a root digest to check.
     Digest digest;
     digest = reinterpret_cast<const uint8_t*>(&digest_[0]);
-    zx_status_t status = MerkleTree::Verify(data, data_size, tree,
-                                            merkle_size, 0, data_size, digest);
-    blobfs_->UpdateMerkleVerifyMetrics(data_size, merkle_size, ticker.End());
+    uint64_t node = offset / MerkleTree::kNodeSize;
+    const uint64_t end = fbl::min(fbl::round_up(offset + length, MerkleTree::kNodeSize) /
+                                  MerkleTree::kNodeSize, num_nodes);
+    status = ZX_OK;
+    bool check_root = (num_nodes == 0);
+    while (status == ZX_OK && (check_root || node < end)) {
+        size_t run_start = node;
+        size_t run_end = end;
+        if (!check_root) {
+            if (verified_.Get(node, end, &run_start)) {
+                break;
+            }
+            verified_.Scan(run_start, end, false, &run_end);
+        }
+        check_root = false;
+
+        fs::Ticker ticker(blobfs_->CollectingMetrics());
+        const uint64_t run_offset = run_start * MerkleTree::kNodeSize;
+        const uint64_t run_length = fbl::min(run_end * MerkleTree::kNodeSize, data_size) -
+                                    run_offset;
+        status = MerkleTree::VerifyParallel(data, data_size, tree, merkle_size, run_offset,
+                                            run_length, digest, zx_system_get_num_cpus());
+        blobfs_->UpdateMerkleVerifyMetrics(run_length, merkle_size, ticker.End());
+        if (status == ZX_OK) {
+            verified_.Set(run_start, run_end);
+        }
+        node = run_end;
+    }
 
     if (status != ZX_OK) {
         char name[Digest::kLength * 2 + 1];
@@ -203,7 +202,19 @@ zx_status_t VnodeBlob::InitVmos() {
         return ZX_ERR_OUT_OF_RANGE;
     }
 
-    zx_status_t status = mapping_.CreateAndMap(vmo_size, "blob");
+    // Blobs which are only being verified (and are hence not readable) are
+    // read in full, since every page of them is about to be checked anyway.
+    zx_status_t status;
+    if (blobfs_->pager_ && (inode_.flags & kBlobFlagLZ4Compressed) == 0 &&
+        GetState() == kBlobStateReadable) {
+        if ((status = InitPaged()) != ZX_OK) {
+            return status;
+        }
+        cleanup.cancel();
+        return ZX_OK;
+    }
+
+    status = mapping_.CreateAndMap(vmo_size, "blob");
     if (status != ZX_OK) {
         FS_TRACE_ERROR("Failed to initialize vmo; error: %d\n", status);
         return status;
@@ -213,7 +224,7 @@ zx_status_t VnodeBlob::InitVmos() {
         return status;
     }
 
-    if ((inode_.flags & kBlobFlagLZ4Compressed) != 0) {
+    if ((inode_.flags & kBlobFlagMaskCompressed) != 0) {
         if ((status = InitCompressed()) != ZX_OK) {
             return status;
         }
@@ -222,7 +233,8 @@ zx_status_t VnodeBlob::InitVmos() {
             return status;
         }
     }
-    if ((status = Verify()) != ZX_OK) {
+    // Readable blobs are verified as they are read.
+    if (GetState() != kBlobStateReadable && (status = Verify()) != ZX_OK) {
         return status;
     }
 
@@ -276,8 +288,18 @@ zx_status_t VnodeBlob::InitCompressed() {
 
     // Decompress the compressed data into the target buffer.
     size_t target_size = inode_.blob_size;
-    status = Decompressor::Decompress(GetData(), &target_size,
-                                      compressed_mapper.start(), &compressed_size);
+    if (inode_.flags & kBlobFlagChunkCompressed) {
+        ChunkedDecompressor decompressor;
+        status = decompressor.Init(compressed_mapper.start(), compressed_size, compressed_size,
+                                   inode_.blob_size);
+        if (status == ZX_OK) {
+            status = decompressor.DecompressAll(compressed_mapper.start(), GetData(),
+                                                zx_system_get_num_cpus());
+        }
+    } else {
+        status = Decompressor::Decompress(GetData(), &target_size,
+                                          compressed_mapper.start(), &compressed_size);
+    }
     if (status != ZX_OK) {
         FS_TRACE_ERROR("Failed to decompress data: %d\n", status);
         return status;
@@ -307,6 +329,24 @@ zx_status_t VnodeBlob::InitUncompressed() {
     return status;
 }
 
+zx_status_t VnodeBlob::InitPaged() {
+    TRACE_DURATION("blobfs", "Blobfs::InitPaged", "size", inode_.blob_size,
+                   "blocks", inode_.num_blocks);
+    zx::vmo vmo;
+    zx_status_t status = blobfs_->pager_->CreateBlob(inode_, digest_, &paged_, &vmo);
+    if (status != ZX_OK) {
+        FS_TRACE_ERROR("Failed to create paged vmo; error: %d\n", status);
+        return status;
+    }
+    // Readable blobs are never written, and pages written through a writable
+    // mapping would have to be paged in first anyway.
+    if ((status = mapping_.Map(fbl::move(vmo), 0, ZX_VM_PERM_READ)) != ZX_OK) {
+        FS_TRACE_ERROR("Failed to map paged vmo; error: %d\n", status);
+        return status;
+    }
+    return ZX_OK;
+}
+
 void VnodeBlob::PopulateInode(size_t node_index) {
     ZX_DEBUG_ASSERT(map_index_ == 0);
     ZX_DEBUG_ASSERT(inode_.start_block < kStartBlockMinimum);
@@ -336,6 +376,11 @@ VnodeBlob::VnodeBlob(Blobfs* bs)
 
 void VnodeBlob::BlobCloseHandles() {
     mapping_.Reset();
+    verified_.Reset(0);
+    if (paged_) {
+        paged_->Detach();
+        paged_.reset();
+    }
     readable_event_.reset();
 }
 
@@ -389,6 +434,10 @@ zx_status_t VnodeBlob::SpaceAllocate(uint64_t size_data) {
     }
 
     write_info_ = fbl::make_unique<WritebackInfo>();
+    if ((status = write_info_->merkle.CreateInit(
+             inode_.blob_size, MerkleTree::GetTreeLength(inode_.blob_size))) != ZX_OK) {
+        return status;
+    }
     if (inode_.blob_size >= kCompressionMinBytesSaved) {
         size_t max = write_info_->compressor.BufferMax(inode_.blob_size);
         status = write_info_->compressed_blob.CreateAndMap(max, "compressed-blob");
@@ -396,7 +445,8 @@ zx_status_t VnodeBlob::SpaceAllocate(uint64_t size_data) {
             return status;
         }
         status = write_info_->compressor.Initialize(write_info_->compressed_blob.start(),
-                                                    write_info_->compressed_blob.size());
+                                                    write_info_->compressed_blob.size(),
+                                                    inode_.blob_size, blobfs_->compression_);
         if (status != ZX_OK) {
             fprintf(stderr, "blobfs: Failed to initialize compressor: %d\n", status);
             return status;
@@ -483,6 +533,17 @@ zx_status_t VnodeBlob::WriteInternal(const void* data, size_t len, size_t* actua
         *actual = to_write;
         write_info_->bytes_written += to_write;
 
+        // Hash the data as it arrives, so the Merkle tree is complete once the
+        // last write lands instead of being built from scratch afterwards.
+        {
+            fs::Ticker ticker(blobfs_->CollectingMetrics());
+            if ((status = write_info_->merkle.CreateUpdate(data, to_write,
+                                                           GetMerkle())) != ZX_OK) {
+                return status;
+            }
+            write_info_->merkle_duration += ticker.End();
+        }
+
         if (write_info_->compressor.Compressing()) {
             if ((status = write_info_->compressor.Update(data, to_write)) != ZX_OK) {
                 return status;
@@ -512,6 +573,19 @@ zx_status_t VnodeBlob::WriteInternal(const void* data, size_t len, size_t* actua
             SetState(kBlobStateError);
         });
 
+        size_t merkle_size = MerkleTree::GetTreeLength(inode_.blob_size);
+        {
+            Digest digest;
+            fs::Ticker ticker(blobfs_->CollectingMetrics());
+            if ((status = write_info_->merkle.CreateFinal(GetMerkle(), &digest)) != ZX_OK) {
+                return status;
+            } else if (digest != digest_) {
+                // Downloaded blob did not match provided digest.
+                return ZX_ERR_IO_DATA_INTEGRITY;
+            }
+            write_info_->merkle_duration += ticker.End();
+        }
+
         if (write_info_->compressor.Compressing()) {
             if ((status = write_info_->compressor.End()) != ZX_OK) {
                 return status;
@@ -519,62 +593,55 @@ zx_status_t VnodeBlob::WriteInternal(const void* data, size_t len, size_t* actua
             ConsiderCompressionAbort();
         }
 
-        uint64_t dev_offset = DataStartBlock(blobfs_->info_) + inode_.start_block + merkle_blocks;
+        // The blob's VMO is attached to the block device, and |wb| holds a
+        // reference to the blob until it completes, so the Merkle tree and data
+        // are written straight from it. Skipping the shared writeback buffer
+        // means that large blobs neither wait for room in it, nor hold up the
+        // blobs written after them while they are copied into it piece by piece.
+        const uint64_t start_block = DataStartBlock(blobfs_->info_) + inode_.start_block;
+        if (merkle_blocks > 0) {
+            wb->Enqueue(mapping_.vmo().get(), 0, start_block, merkle_blocks);
+        }
         if (write_info_->compressor.Compressing()) {
             uint64_t blocks = fbl::round_up(write_info_->compressor.Size(),
                                             kBlobfsBlockSize) / kBlobfsBlockSize;
-            if ((status = EnqueuePaginated(&wb, blobfs_, this,
-                                           write_info_->compressed_blob.vmo().get(),
-                                           0, dev_offset, blocks)) != ZX_OK) {
+            vmoid_t compressed_vmoid;
+            if ((status = blobfs_->AttachVmo(write_info_->compressed_blob.vmo().get(),
+                                             &compressed_vmoid)) != ZX_OK) {
                 return status;
             }
-            blocks += MerkleTreeBlocks(inode_);
+            fbl::unique_ptr<WritebackWork> data_wb;
+            if ((status = blobfs_->CreateWork(&data_wb, this)) != ZX_OK) {
+                blobfs_->DetachVmo(compressed_vmoid);
+                return status;
+            }
+            data_wb->Enqueue(write_info_->compressed_blob.vmo().get(), 0,
+                             start_block + merkle_blocks, blocks);
+            data_wb->SetBuffer(compressed_vmoid);
+            data_wb->AdoptSource(fbl::move(write_info_->compressed_blob), compressed_vmoid);
+            if ((status = blobfs_->EnqueueWork(fbl::move(data_wb), EnqueueType::kData)) != ZX_OK) {
+                return status;
+            }
+            blocks += merkle_blocks;
             ZX_DEBUG_ASSERT(inode_.num_blocks > blocks);
             blobfs_->UnreserveBlocks(inode_.num_blocks - blocks,
                                      inode_.start_block + blocks);
             inode_.num_blocks = blocks;
-            inode_.flags |= kBlobFlagLZ4Compressed;
+            inode_.flags |= ChunkedInodeFlags(write_info_->compressor.Algorithm());
         } else {
             uint64_t blocks = fbl::round_up(inode_.blob_size, kBlobfsBlockSize) / kBlobfsBlockSize;
-            if ((status = EnqueuePaginated(&wb, blobfs_, this, mapping_.vmo().get(),
-                                           merkle_blocks, dev_offset, blocks)) != ZX_OK) {
-                return status;
-            }
+            wb->Enqueue(mapping_.vmo().get(), merkle_blocks, start_block + merkle_blocks, blocks);
         }
 
-        // TODO(smklein): As an optimization, use the CreateInit/Update/Final
-        // methods to create the merkle tree as we write data, rather than
-        // waiting until the data is fully downloaded to create the tree.
-        size_t merkle_size = MerkleTree::GetTreeLength(inode_.blob_size);
-        fs::Duration generation_time;
-        if (merkle_size > 0) {
-            Digest digest;
-            void* merkle_data = GetMerkle();
-            const void* blob_data = GetData();
-            fs::Ticker ticker(blobfs_->CollectingMetrics()); // Tracking generation time.
-
-            if ((status = MerkleTree::Create(blob_data, inode_.blob_size, merkle_data,
-                                             merkle_size, &digest)) != ZX_OK) {
+        // Enqueue the blob's final data work. Metadata must be enqueued separately.
+        if (wb->BlkCount() > 0) {
+            wb->SetBuffer(vmoid_);
+            if ((status = blobfs_->EnqueueWork(fbl::move(wb), EnqueueType::kData)) != ZX_OK) {
                 return status;
-            } else if (digest != digest_) {
-                // Downloaded blob did not match provided digest.
-                return ZX_ERR_IO_DATA_INTEGRITY;
             }
-
-            uint64_t dev_offset = DataStartBlock(blobfs_->info_) + inode_.start_block;
-            wb->Enqueue(mapping_.vmo().get(), 0, dev_offset, merkle_blocks);
-            generation_time = ticker.End();
-        } else if ((status = Verify()) != ZX_OK) {
-            // Small blobs may not have associated Merkle Trees, and will
-            // require validation, since we are not regenerating and checking
-            // the digest.
-            return status;
-        }
-
-        // Enqueue the blob's final data work. Metadata must be enqueued separately.
-        if ((status = blobfs_->EnqueueWork(fbl::move(wb), EnqueueType::kData)) != ZX_OK) {
-            return status;
         }
+        wb.reset();
+        fs::Duration generation_time = write_info_->merkle_duration;
 
         // No more data to write. Flush to disk.
         fs::Ticker ticker(blobfs_->CollectingMetrics()); // Tracking enqueue time.
@@ -631,8 +698,13 @@ zx_status_t VnodeBlob::CloneVmo(zx_rights_t rights, zx_handle_t* out) {
         return status;
     }
 
+    // Clients access the clone directly, so unless the blob is paged in, all
+    // of it has to be verified first.
     // TODO(smklein): Only clone / verify the part of the vmo that
     // was requested.
+    if (!paged_ && (status = Verify()) != ZX_OK) {
+        return status;
+    }
     const size_t merkle_bytes = MerkleTreeBlocks(inode_) * kBlobfsBlockSize;
     zx::vmo clone;
     if ((status = mapping_.vmo().clone(ZX_VMO_CLONE_COPY_ON_WRITE, merkle_bytes, inode_.blob_size,
@@ -692,9 +764,6 @@ zx_status_t VnodeBlob::ReadInternal(void* data, size_t len, size_t off, size_t*
         return status;
     }
 
-    Digest d;
-    d = reinterpret_cast<const uint8_t*>(&digest_[0]);
-
     if (off >= inode_.blob_size) {
         *actual = 0;
         return ZX_OK;
@@ -702,6 +771,10 @@ zx_status_t VnodeBlob::ReadInternal(void* data, size_t len, size_t off, size_t*
     if (len > (inode_.blob_size - off)) {
         len = inode_.blob_size - off;
     }
+    // Paged blobs are verified as they are paged in.
+    if (!paged_ && (status = VerifyRange(off, len)) != ZX_OK) {
+        return status;
+    }
 
     const size_t merkle_bytes = MerkleTreeBlocks(inode_) * kBlobfsBlockSize;
     status = mapping_.vmo().read(data, merkle_bytes + off, len);
@@ -734,7 +807,8 @@ zx_status_t VnodeBlob::VerifyBlob(Blobfs* bs, size_t node_index) {
     vn->SetState(kBlobStatePurged);
 
     // If we are unable to read in the blob from disk, this should also be a VerifyBlob error.
-    // Since InitVmos calls Verify as its final step, we can just return its result here.
+    // Since InitVmos calls Verify as its final step for blobs which aren't
+    // readable, we can just return its result here.
     return vn->InitVmos();
 }
 
@@ -742,54 +816,24 @@ zx_status_t Blobfs::VerifyBlob(size_t node_index) {
     return VnodeBlob::VerifyBlob(this, node_index);
 }
 
-zx_status_t Blobfs::FindBlocks(size_t start, size_t num_blocks, size_t* blkno_out) {
-    while (true) {
-        // Search for a range of nblocks in block_map_.
-        size_t block_num;
-        zx_status_t status = block_map_.Find(false, start, block_map_.size(), num_blocks,
-                                             &block_num);
-
-        if (status != ZX_OK) {
-            return status;
-        }
-
-        // Find out how large the unallocated range is starting from |block_num| so we can search
-        // the reserved_blocks_ map for this entire range in one call.
-        size_t upper_limit = block_map_.size();
-        block_map_.Scan(block_num, block_map_.size(), false, &upper_limit);
-        size_t max_len = upper_limit - block_num;
-
-        // Check the reserved map to see if there are |nblocks| free blocks from |block_num| to
-        // |block_num + max_len|.
-        size_t out;
-        status = reserved_blocks_.Find(false, block_num, block_num + max_len, num_blocks, &out);
-
-        // If we found a valid range, return; otherwise start searching from block_num + max_len.
-        if (status == ZX_OK && out < block_num + max_len) {
-            *blkno_out = out;
-            break;
-        }
-
-        start = out;
-    }
-    return ZX_OK;
-}
-
 zx_status_t Blobfs::ReserveBlocks(size_t num_blocks, size_t* block_index_out) {
     zx_status_t status;
-    if ((status = FindBlocks(0, num_blocks, block_index_out) != ZX_OK)) {
+    uint64_t start;
+    if ((status = free_extents_.Find(num_blocks, &start)) != ZX_OK) {
         // If we have run out of blocks, attempt to add block slices via FVM.
-        // The new 'hint' is the first location we could try to find blocks
-        // after merely extending the allocation maps.
-        size_t hint = block_map_.size() - fbl::min(num_blocks, block_map_.size());
-
+        // The added blocks are indexed as a free extent of their own, or
+        // merged into the one which ended the partition.
         if ((status = AddBlocks(num_blocks) != ZX_OK) ||
-            (status = FindBlocks(hint, num_blocks, block_index_out)) != ZX_OK) {
+            (status = free_extents_.Find(num_blocks, &start)) != ZX_OK) {
             LogAllocationFailure(num_blocks);
             return ZX_ERR_NO_SPACE;
         }
     }
 
+    if ((status = free_extents_.Remove(start, num_blocks)) != ZX_OK) {
+        return status;
+    }
+    *block_index_out = start;
     status = reserved_blocks_.Set(*block_index_out, *block_index_out + num_blocks);
     ZX_DEBUG_ASSERT(status == ZX_OK);
     return ZX_OK;
@@ -812,6 +856,8 @@ void Blobfs::LogAllocationFailure(size_t num_blocks) const {
     fprintf(stderr, "    Used data bytes   : %" PRIu64 "\n", persisted_used_bytes);
     fprintf(stderr, "    Preallocated bytes: %" PRIu64 "\n", pending_used_bytes);
     fprintf(stderr, "    Free data bytes   : %" PRIu64 "\n", free_bytes);
+    fprintf(stderr, "    Free extents      : %zu, the largest %" PRIu64 " bytes\n",
+            free_extents_.ExtentCount(), free_extents_.LargestExtent() * info_.block_size);
     fprintf(stderr, "    This allocation failure is the result of %s.\n",
             requested_bytes <= free_bytes ? "fragmentation" : "over-allocation");
 }
@@ -825,6 +871,7 @@ void Blobfs::UnreserveBlocks(size_t num_blocks, size_t block_index) {
 
     zx_status_t status = reserved_blocks_.Clear(block_index, block_index + num_blocks);
     ZX_DEBUG_ASSERT(status == ZX_OK);
+    ReleaseExtent(num_blocks, block_index);
 }
 
 void Blobfs::PersistBlocks(WritebackWork* wb, size_t num_blocks, size_t block_index) {
@@ -869,6 +916,44 @@ void Blobfs::FreeBlocks(WritebackWork* wb, size_t num_blocks, size_t block_index
 
     zx_status_t status = reserved_blocks_.Clear(block_index, block_index + num_blocks);
     ZX_DEBUG_ASSERT(status == ZX_OK);
+    ReleaseExtent(num_blocks, block_index);
+}
+
+void Blobfs::ReleaseExtent(size_t num_blocks, size_t block_index) {
+    if (free_extents_.Insert(block_index, num_blocks) != ZX_OK) {
+        // The blocks are free on disk regardless; they are just not found by
+        // allocations again until the index is next rebuilt.
+        fprintf(stderr, "blobfs: Failed to index %zu free blocks at %zu\n", num_blocks,
+                block_index);
+    }
+}
+
+zx_status_t Blobfs::LoadExtentIndex() {
+    TRACE_DURATION("blobfs", "Blobfs::LoadExtentIndex");
+    free_extents_.Reset();
+    zx_status_t status;
+    const size_t size = block_map_.size();
+    size_t start = 0;
+    while (start < size) {
+        // Skip to the next free block, then find where the free run ends.
+        if (block_map_.Scan(start, size, true, &start)) {
+            break;
+        }
+        size_t end = size;
+        block_map_.Scan(start, size, false, &end);
+        if ((status = free_extents_.Insert(start, end - start)) != ZX_OK) {
+            return status;
+        }
+        start = end;
+    }
+
+    // Reservations are made out of the free extents.
+    for (const auto& range : reserved_blocks_) {
+        if ((status = free_extents_.Remove(range.bitoff, range.bitlen)) != ZX_OK) {
+            return status;
+        }
+    }
+    return ZX_OK;
 }
 
 zx_status_t Blobfs::FindNode(size_t* node_index_out) {
@@ -1117,7 +1202,15 @@ zx_status_t Blobfs::PurgeBlob(VnodeBlob* vn) {
         FreeNode(wb.get(), node_index);
         FreeBlocks(wb.get(), nblocks, start_block);
         VnodeReleaseHard(vn);
-        return EnqueueWork(fbl::move(wb), EnqueueType::kJournal);
+        if ((status = EnqueueWork(fbl::move(wb), EnqueueType::kJournal)) != ZX_OK) {
+            return status;
+        }
+        if (journal_ != nullptr) {
+            // The freed blocks may be reused by the next blob written, whose data must not
+            // reach the writeback queue before the entry which frees them.
+            return journal_->CommitGroup();
+        }
+        return ZX_OK;
     }
     default: {
         assert(false);
@@ -1361,6 +1454,12 @@ zx_status_t Blobfs::AddBlocks(size_t nblocks) {
         wb.get()->Enqueue(block_map_.StorageUnsafe()->GetVmo(), vmo_offset, dev_offset, length);
     }
 
+    if ((status = free_extents_.Insert(info_.data_block_count,
+                                       blocks - info_.data_block_count)) != ZX_OK) {
+        wb->Reset(status);
+        return status;
+    }
+
     info_.vslice_count += request.length;
     info_.dat_slices += static_cast<uint32_t>(request.length);
     info_.data_block_count = blocks;
@@ -1397,6 +1496,16 @@ void Blobfs::UpdateLookupMetrics(uint64_t size) {
     }
 }
 
+void Blobfs::UpdateCacheMetrics(bool hit) {
+    if (CollectingMetrics()) {
+        if (hit) {
+            metrics_.blob_cache_hits++;
+        } else {
+            metrics_.blob_cache_misses++;
+        }
+    }
+}
+
 void Blobfs::UpdateClientWriteMetrics(uint64_t data_size, uint64_t merkle_size,
                                       const fs::Duration& enqueue_duration,
                                       const fs::Duration& generate_duration) {
@@ -1415,6 +1524,13 @@ void Blobfs::UpdateWritebackMetrics(uint64_t size, const fs::Duration& duration)
     }
 }
 
+void Blobfs::UpdateJournalMetrics(uint64_t entries) {
+    if (CollectingMetrics()) {
+        metrics_.journal_entries_written += entries;
+        metrics_.journal_groups_written++;
+    }
+}
+
 void Blobfs::UpdateMerkleDiskReadMetrics(uint64_t size, const fs::Duration& duration) {
     if (CollectingMetrics()) {
         metrics_.total_read_from_disk_time_ticks += duration;
@@ -1454,8 +1570,10 @@ Blobfs::~Blobfs() {
     // to enqueue more transactions for writeback.
     journal_.reset();
     writeback_.reset();
+    pager_.reset();
 
     ZX_ASSERT(open_hash_.is_empty());
+    lru_.clear();
     closed_hash_.clear();
 
     if (blockfd_) {
@@ -1475,7 +1593,8 @@ zx_status_t Blobfs::Create(fbl::unique_fd fd, const MountOptions& options,
     fbl::AllocChecker ac;
     auto fs = fbl::unique_ptr<Blobfs>(new Blobfs(fbl::move(fd), info));
     fs->SetReadonly(options.readonly);
-    fs->SetCachePolicy(options.cache_policy);
+    fs->SetCachePolicy(options.cache_policy, options.cache_budget);
+    fs->SetCompression(options.compression);
     if (options.metrics) {
         fs->CollectMetrics();
     }
@@ -1540,12 +1659,19 @@ zx_status_t Blobfs::Create(fbl::unique_fd fd, const MountOptions& options,
         return status;
     }
 
+    // Without a pager blobs are still served, they are just read up front.
+    if ((status = BlobPager::Create(fs.get(), &fs->pager_)) != ZX_OK) {
+        fprintf(stderr, "blobfs: Failed to create pager, not paging blobs: %d\n", status);
+    }
+
     *out = fbl::move(fs);
     return ZX_OK;
 }
 
 zx_status_t Blobfs::InitializeVnodes() {
     fbl::AutoLock lock(&hash_lock_);
+    lru_.clear();
+    lru_size_ = 0;
     closed_hash_.clear();
     for (size_t i = 0; i < info_.inode_count; ++i) {
         const Inode* inode = GetNode(i);
@@ -1670,6 +1796,13 @@ zx_status_t Blobfs::VnodeInsertClosedLocked(fbl::RefPtr<VnodeBlob> vn) {
         break;
     case CachePolicy::NeverEvict:
         break;
+    case CachePolicy::EvictLeastRecentlyUsed:
+        if (vn->CachedSize() != 0) {
+            lru_size_ += vn->CachedSize();
+            lru_.push_back(vn.get());
+            EvictCacheLocked(cache_budget_);
+        }
+        break;
     default:
         ZX_ASSERT_MSG(false, "Unexpected cache policy");
     }
@@ -1684,12 +1817,28 @@ fbl::RefPtr<VnodeBlob> Blobfs::VnodeUpgradeLocked(const uint8_t* key) {
     if (raw_vn == nullptr) {
         return nullptr;
     }
+    if (VnodeBlob::TypeLruTraits::node_state(*raw_vn).InContainer()) {
+        lru_.erase(*raw_vn);
+        lru_size_ -= raw_vn->CachedSize();
+    }
+    UpdateCacheMetrics(raw_vn->CachedSize() != 0);
     open_hash_.insert(raw_vn);
     // To have existed in the closed_hash_, this RefPtr must have
     // been leaked.
     return fbl::internal::MakeRefPtrNoAdopt(raw_vn);
 }
 
+void Blobfs::EvictCacheLocked(uint64_t budget) {
+    while (lru_size_ > budget) {
+        VnodeBlob* vn = lru_.pop_front();
+        lru_size_ -= vn->CachedSize();
+        vn->TearDown();
+        if (CollectingMetrics()) {
+            metrics_.blob_cache_evictions++;
+        }
+    }
+}
+
 zx_status_t Blobfs::OpenRootNode(fbl::RefPtr<VnodeBlob>* out) {
     fbl::AllocChecker ac;
     fbl::RefPtr<VnodeBlob> vn =
@@ -1714,7 +1863,11 @@ zx_status_t Blobfs::LoadBitmaps() {
     fs::ReadTxn txn(this);
     txn.Enqueue(block_map_vmoid_, 0, BlockMapStartBlock(info_), BlockMapBlocks(info_));
     txn.Enqueue(node_map_vmoid_, 0, NodeMapStartBlock(info_), NodeMapBlocks(info_));
-    return txn.Transact();
+    zx_status_t status;
+    if ((status = txn.Transact()) != ZX_OK) {
+        return status;
+    }
+    return LoadExtentIndex();
 }
 
 zx_status_t Initialize(fbl::unique_fd blockfd, const MountOptions& options,
@@ -0,0 +1,342 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <inttypes.h>
+#include <lz4/lz4.h>
+#include <lz4/lz4hc.h>
+#include <pthread.h>
+#include <string.h>
+
+#include <fbl/algorithm.h>
+#include <fbl/alloc_checker.h>
+#include <fs/trace.h>
+#include <zircon/types.h>
+
+#include <blobfs/chunked.h>
+
+namespace blobfs {
+namespace {
+
+// The fewest chunks worth handing to a thread of their own.
+constexpr uint64_t kMinChunksPerThread = 8;
+
+// The most threads a blob is decompressed on.
+constexpr size_t kMaxThreads = 16;
+
+// The highest LZ4HC level the library recommends.
+constexpr int kLz4HcLevel = 9;
+
+// A run of chunks decompressed by one thread.
+struct ChunkRun {
+    const ChunkedDecompressor* decompressor;
+    const void* src;
+    uint8_t* target;
+    uint64_t first;
+    uint64_t count;
+    zx_status_t status;
+    pthread_t thread;
+};
+
+zx_status_t DecompressRun(const ChunkRun* run) {
+    for (uint64_t i = run->first; i < run->first + run->count; i++) {
+        zx_status_t status = run->decompressor->DecompressChunk(i, run->src, 0,
+                                                                run->target + i * kChunkSize);
+        if (status != ZX_OK) {
+            return status;
+        }
+    }
+    return ZX_OK;
+}
+
+void* DecompressRunThread(void* arg) {
+    ChunkRun* run = static_cast<ChunkRun*>(arg);
+    run->status = DecompressRun(run);
+    return nullptr;
+}
+
+} // namespace
+
+ChunkedCompressor::ChunkedCompressor()
+    : algorithm_(CompressionAlgorithm::kLz4), buf_(nullptr) {}
+
+ChunkedCompressor::~ChunkedCompressor() {
+    Reset();
+}
+
+void ChunkedCompressor::Reset() {
+    buf_ = nullptr;
+    pending_.reset();
+    hc_state_.reset();
+}
+
+size_t ChunkedCompressor::BufferMax(size_t blob_size) {
+    // Chunks which don't shrink are stored as is.
+    return ChunkedMetadataSize(blob_size) + blob_size;
+}
+
+zx_status_t ChunkedCompressor::Initialize(void* buf, size_t buf_max, size_t blob_size,
+                                          CompressionAlgorithm algorithm) {
+    ZX_DEBUG_ASSERT(!Compressing());
+    const uint64_t metadata_size = ChunkedMetadataSize(blob_size);
+    if (buf_max < metadata_size) {
+        return ZX_ERR_BUFFER_TOO_SMALL;
+    }
+
+    fbl::AllocChecker ac;
+    pending_.reset(new (&ac) uint8_t[kChunkSize]);
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    if (algorithm == CompressionAlgorithm::kLz4Hc) {
+        hc_state_.reset(new (&ac) uint8_t[LZ4_sizeofStateHC()]);
+        if (!ac.check()) {
+            pending_.reset();
+            return ZX_ERR_NO_MEMORY;
+        }
+    }
+    algorithm_ = algorithm;
+
+    buf_ = static_cast<uint8_t*>(buf);
+    buf_max_ = buf_max;
+    buf_used_ = metadata_size;
+    blob_size_ = blob_size;
+    bytes_in_ = 0;
+    pending_size_ = 0;
+    next_chunk_ = 0;
+
+    ChunkedHeader header;
+    header.magic = kChunkedMagic;
+    header.version = kChunkedVersion;
+    header.chunk_size = kChunkSize;
+    header.blob_size = blob_size;
+    header.chunk_count = ChunkCount(blob_size);
+    memcpy(buf_, &header, sizeof(header));
+    return ZX_OK;
+}
+
+zx_status_t ChunkedCompressor::CompressChunk(const uint8_t* data, size_t length) {
+    ZX_DEBUG_ASSERT(next_chunk_ < ChunkCount(blob_size_));
+    SeekEntry entry;
+    entry.compressed_offset = buf_used_;
+    entry.flags = 0;
+
+    // Only compressed forms smaller than the chunk itself are kept.
+    const size_t room = fbl::min(buf_max_ - buf_used_, length - 1);
+    const char* src = reinterpret_cast<const char*>(data);
+    char* dst = reinterpret_cast<char*>(buf_ + buf_used_);
+    int r;
+    if (algorithm_ == CompressionAlgorithm::kLz4Hc) {
+        r = LZ4_compress_HC_extStateHC(hc_state_.get(), src, dst, static_cast<int>(length),
+                                       static_cast<int>(room), kLz4HcLevel);
+    } else {
+        r = LZ4_compress_default(src, dst, static_cast<int>(length), static_cast<int>(room));
+    }
+    if (r > 0) {
+        entry.compressed_size = static_cast<uint32_t>(r);
+    } else if (buf_max_ - buf_used_ >= length) {
+        memcpy(buf_ + buf_used_, data, length);
+        entry.compressed_size = static_cast<uint32_t>(length);
+        entry.flags = kChunkFlagUncompressed;
+    } else {
+        return ZX_ERR_BUFFER_TOO_SMALL;
+    }
+
+    buf_used_ += entry.compressed_size;
+    memcpy(buf_ + sizeof(ChunkedHeader) + next_chunk_ * sizeof(SeekEntry), &entry,
+           sizeof(entry));
+    next_chunk_++;
+    return ZX_OK;
+}
+
+zx_status_t ChunkedCompressor::Update(const void* data_, size_t length) {
+    const uint8_t* data = static_cast<const uint8_t*>(data_);
+    if (length > blob_size_ - bytes_in_) {
+        return ZX_ERR_OUT_OF_RANGE;
+    }
+    bytes_in_ += length;
+
+    zx_status_t status;
+    // Finish the chunk started by earlier updates.
+    if (pending_size_ > 0) {
+        size_t n = fbl::min(length, kChunkSize - pending_size_);
+        memcpy(pending_.get() + pending_size_, data, n);
+        pending_size_ += n;
+        data += n;
+        length -= n;
+        if (pending_size_ < kChunkSize) {
+            return ZX_OK;
+        }
+        if ((status = CompressChunk(pending_.get(), kChunkSize)) != ZX_OK) {
+            return status;
+        }
+        pending_size_ = 0;
+    }
+
+    // Whole chunks are compressed straight from the caller's data.
+    while (length >= kChunkSize) {
+        if ((status = CompressChunk(data, kChunkSize)) != ZX_OK) {
+            return status;
+        }
+        data += kChunkSize;
+        length -= kChunkSize;
+    }
+
+    memcpy(pending_.get(), data, length);
+    pending_size_ = length;
+    return ZX_OK;
+}
+
+zx_status_t ChunkedCompressor::End() {
+    if (bytes_in_ != blob_size_) {
+        return ZX_ERR_BAD_STATE;
+    }
+    if (pending_size_ > 0) {
+        zx_status_t status = CompressChunk(pending_.get(), pending_size_);
+        if (status != ZX_OK) {
+            return status;
+        }
+        pending_size_ = 0;
+    }
+    ZX_DEBUG_ASSERT(next_chunk_ == ChunkCount(blob_size_));
+    return ZX_OK;
+}
+
+size_t ChunkedCompressor::Size() const {
+    ZX_DEBUG_ASSERT(Compressing());
+    return buf_used_;
+}
+
+zx_status_t ChunkedDecompressor::Init(const void* metadata, size_t metadata_size,
+                                      uint64_t compressed_size, uint64_t blob_size) {
+    const uint64_t table_end = ChunkedMetadataSize(blob_size);
+    if (metadata_size < table_end || compressed_size < table_end) {
+        FS_TRACE_ERROR("blobfs: Compressed blob too small for its seek table\n");
+        return ZX_ERR_IO_DATA_INTEGRITY;
+    }
+
+    ChunkedHeader header;
+    memcpy(&header, metadata, sizeof(header));
+    if (header.magic != kChunkedMagic || header.version != kChunkedVersion ||
+        header.chunk_size != kChunkSize || header.blob_size != blob_size ||
+        header.chunk_count != blobfs::ChunkCount(blob_size)) {
+        FS_TRACE_ERROR("blobfs: Bad compressed blob header\n");
+        return ZX_ERR_IO_DATA_INTEGRITY;
+    }
+
+    fbl::AllocChecker ac;
+    table_.reset(new (&ac) SeekEntry[header.chunk_count]);
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    memcpy(table_.get(), static_cast<const uint8_t*>(metadata) + sizeof(header),
+           header.chunk_count * sizeof(SeekEntry));
+    chunk_count_ = header.chunk_count;
+    blob_size_ = blob_size;
+
+    uint64_t next = table_end;
+    for (uint64_t i = 0; i < chunk_count_; i++) {
+        const SeekEntry& entry = table_[i];
+        const size_t length = ChunkLength(i);
+        bool valid = entry.compressed_offset >= next &&
+                     entry.compressed_size <= compressed_size &&
+                     entry.compressed_offset <= compressed_size - entry.compressed_size;
+        if (entry.flags == kChunkFlagUncompressed) {
+            valid = valid && entry.compressed_size == length;
+        } else {
+            valid = valid && entry.flags == 0 && entry.compressed_size > 0 &&
+                    entry.compressed_size <= static_cast<uint64_t>(LZ4_compressBound(
+                                                 static_cast<int>(length)));
+        }
+        if (!valid) {
+            FS_TRACE_ERROR("blobfs: Bad seek table entry for chunk %" PRIu64 "\n", i);
+            table_.reset();
+            chunk_count_ = 0;
+            return ZX_ERR_IO_DATA_INTEGRITY;
+        }
+        next = entry.compressed_offset + entry.compressed_size;
+    }
+    return ZX_OK;
+}
+
+void ChunkedDecompressor::ChunksFor(uint64_t offset, uint64_t length, uint64_t* first,
+                                    uint64_t* last) const {
+    ZX_DEBUG_ASSERT(length > 0);
+    *first = offset / kChunkSize;
+    *last = fbl::min((offset + length - 1) / kChunkSize, chunk_count_ - 1);
+}
+
+void ChunkedDecompressor::CompressedRange(uint64_t first, uint64_t last, uint64_t* offset,
+                                          uint64_t* length) const {
+    ZX_DEBUG_ASSERT(first <= last && last < chunk_count_);
+    *offset = table_[first].compressed_offset;
+    *length = table_[last].compressed_offset + table_[last].compressed_size - *offset;
+}
+
+size_t ChunkedDecompressor::ChunkLength(uint64_t index) const {
+    return fbl::min(blob_size_ - index * kChunkSize, static_cast<uint64_t>(kChunkSize));
+}
+
+zx_status_t ChunkedDecompressor::DecompressChunk(uint64_t index, const void* src,
+                                                 uint64_t src_offset, void* target) const {
+    ZX_DEBUG_ASSERT(index < chunk_count_);
+    const SeekEntry& entry = table_[index];
+    ZX_DEBUG_ASSERT(entry.compressed_offset >= src_offset);
+    const char* chunk = static_cast<const char*>(src) + entry.compressed_offset - src_offset;
+    const size_t length = ChunkLength(index);
+
+    if (entry.flags & kChunkFlagUncompressed) {
+        memcpy(target, chunk, length);
+        return ZX_OK;
+    }
+    int r = LZ4_decompress_safe(chunk, static_cast<char*>(target),
+                                static_cast<int>(entry.compressed_size),
+                                static_cast<int>(length));
+    if (r < 0 || static_cast<size_t>(r) != length) {
+        FS_TRACE_ERROR("blobfs: Failed to decompress chunk %" PRIu64 "\n", index);
+        return ZX_ERR_IO_DATA_INTEGRITY;
+    }
+    return ZX_OK;
+}
+
+zx_status_t ChunkedDecompressor::DecompressAll(const void* src, void* target,
+                                               size_t threads) const {
+    threads = fbl::min(fbl::min(threads, kMaxThreads),
+                       static_cast<size_t>(chunk_count_ / kMinChunksPerThread));
+    uint8_t* out = static_cast<uint8_t*>(target);
+    if (threads < 2) {
+        ChunkRun run = {this, src, out, 0, chunk_count_, ZX_OK, {}};
+        return DecompressRun(&run);
+    }
+
+    ChunkRun runs[kMaxThreads];
+    uint64_t per_thread = (chunk_count_ + threads - 1) / threads;
+    for (size_t i = 0; i < threads; i++) {
+        uint64_t first = fbl::min(i * per_thread, chunk_count_);
+        runs[i] = {this, src, out, first, fbl::min(per_thread, chunk_count_ - first),
+                   ZX_OK, {}};
+    }
+    // The calling thread takes the first run, and any that couldn't be
+    // handed to a thread of their own.
+    size_t started = 1;
+    while (started < threads &&
+           pthread_create(&runs[started].thread, nullptr, DecompressRunThread,
+                          &runs[started]) == 0) {
+        started++;
+    }
+    runs[0].status = DecompressRun(&runs[0]);
+    for (size_t i = started; i < threads; i++) {
+        runs[i].status = DecompressRun(&runs[i]);
+    }
+    for (size_t i = 1; i < started; i++) {
+        pthread_join(runs[i].thread, nullptr);
+    }
+    for (size_t i = 0; i < threads; i++) {
+        if (runs[i].status != ZX_OK) {
+            return runs[i].status;
+        }
+    }
+    return ZX_OK;
+}
+
+} // namespace blobfs
@@ -0,0 +1,141 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <fbl/alloc_checker.h>
+#include <zircon/assert.h>
+
+#include <blobfs/extent-index.h>
+
+namespace blobfs {
+
+ExtentIndex::~ExtentIndex() {
+    Reset();
+}
+
+void ExtentIndex::Reset() {
+    // |by_length_| holds unowned pointers to the extents in |by_start_|.
+    by_length_.clear();
+    by_start_.clear();
+    free_blocks_ = 0;
+}
+
+zx_status_t ExtentIndex::Add(uint64_t start, uint64_t length) {
+    ZX_DEBUG_ASSERT(start <= UINT32_MAX && length <= UINT32_MAX);
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<FreeExtent> extent(new (&ac) FreeExtent());
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    extent->start = start;
+    extent->length = length;
+    by_length_.insert(extent.get());
+    by_start_.insert(fbl::move(extent));
+    return ZX_OK;
+}
+
+void ExtentIndex::Resize(FreeExtent* extent, uint64_t start, uint64_t length) {
+    ZX_DEBUG_ASSERT(start <= UINT32_MAX && length <= UINT32_MAX);
+    // Only the length index needs rebalancing when the start moves: an extent
+    // never moves past either of its neighbours.
+    by_length_.erase(*extent);
+    extent->start = start;
+    extent->length = length;
+    by_length_.insert(extent);
+}
+
+zx_status_t ExtentIndex::Insert(uint64_t start, uint64_t length) {
+    if (length == 0) {
+        return ZX_OK;
+    }
+    const uint64_t end = start + length;
+
+    auto next = by_start_.lower_bound(start);
+    FreeExtent* after = next.IsValid() ? &*next : nullptr;
+    FreeExtent* before = nullptr;
+    if (!by_start_.is_empty()) {
+        auto prev = next;
+        --prev;
+        before = prev.IsValid() ? &*prev : nullptr;
+    }
+    ZX_DEBUG_ASSERT_MSG(after == nullptr || after->start >= end, "Blocks are already free");
+    ZX_DEBUG_ASSERT_MSG(before == nullptr || before->start + before->length <= start,
+                        "Blocks are already free");
+
+    bool joins_before = before != nullptr && before->start + before->length == start;
+    bool joins_after = after != nullptr && after->start == end;
+    if (joins_before && joins_after) {
+        uint64_t merged = before->length + length + after->length;
+        by_length_.erase(*after);
+        by_start_.erase(*after);
+        Resize(before, before->start, merged);
+    } else if (joins_before) {
+        Resize(before, before->start, before->length + length);
+    } else if (joins_after) {
+        Resize(after, start, after->length + length);
+    } else {
+        zx_status_t status = Add(start, length);
+        if (status != ZX_OK) {
+            return status;
+        }
+    }
+    free_blocks_ += length;
+    return ZX_OK;
+}
+
+zx_status_t ExtentIndex::Remove(uint64_t start, uint64_t length) {
+    if (length == 0) {
+        return ZX_OK;
+    }
+    const uint64_t end = start + length;
+
+    // Find the extent which starts at or before |start|.
+    auto iter = by_start_.upper_bound(start);
+    if (by_start_.is_empty()) {
+        return ZX_ERR_NOT_FOUND;
+    }
+    --iter;
+    if (!iter.IsValid() || iter->start + iter->length < end) {
+        return ZX_ERR_NOT_FOUND;
+    }
+
+    FreeExtent* extent = &*iter;
+    const uint64_t extent_end = extent->start + extent->length;
+    if (extent->start == start && extent_end == end) {
+        by_length_.erase(*extent);
+        by_start_.erase(*extent);
+    } else if (extent->start == start) {
+        Resize(extent, end, extent_end - end);
+    } else if (extent_end == end) {
+        Resize(extent, extent->start, start - extent->start);
+    } else {
+        // Splitting the extent: put the tail in place before shrinking the
+        // head, so that running out of memory leaves the index untouched.
+        zx_status_t status = Add(end, extent_end - end);
+        if (status != ZX_OK) {
+            return status;
+        }
+        Resize(extent, extent->start, start - extent->start);
+    }
+    free_blocks_ -= length;
+    return ZX_OK;
+}
+
+zx_status_t ExtentIndex::Find(uint64_t length, uint64_t* start_out) const {
+    ZX_DEBUG_ASSERT(length > 0);
+    if (length > UINT32_MAX) {
+        return ZX_ERR_NO_SPACE;
+    }
+    auto iter = by_length_.lower_bound(LengthKey(length, 0));
+    if (!iter.IsValid()) {
+        return ZX_ERR_NO_SPACE;
+    }
+    *start_out = iter->start;
+    return ZX_OK;
+}
+
+uint64_t ExtentIndex::LargestExtent() const {
+    return by_length_.is_empty() ? 0 : by_length_.back().length;
+}
+
+} // namespace blobfs
@@ -3,11 +3,15 @@
 // found in the LICENSE file.
 
 #include <blobfs/fsck.h>
+#include <fbl/algorithm.h>
 #include <fs/trace.h>
 #include <inttypes.h>
+#include <string.h>
 
 #ifdef __Fuchsia__
 #include <blobfs/blobfs.h>
+#include <threads.h>
+#include <zircon/syscalls.h>
 #else
 #include <blobfs/host.h>
 #endif
@@ -16,12 +20,22 @@
 // TODO(planders): Potentially check the state of the journal.
 namespace blobfs {
 
-void BlobfsChecker::TraverseInodeBitmap() {
-    for (unsigned n = 0; n < blobfs_->info_.inode_count; n++) {
+namespace {
+
+// Verifying a blob reads it from disk and hashes all of it, so the inode
+// table is checked by several threads at once.  The Merkle tree of each
+// blob is verified in parallel too, so more threads than this mostly queue
+// up behind the block device.
+constexpr uint32_t kMaxCheckThreads = 8;
+
+} // namespace
+
+void BlobfsChecker::CheckInodeRange(uint32_t start, uint32_t end, InodeCounts* counts) {
+    for (uint32_t n = start; n < end; n++) {
         Inode* inode = blobfs_->GetNode(n);
         if (inode->start_block >= kStartBlockMinimum) {
-            alloc_inodes_++;
-            inode_blocks_ += static_cast<uint32_t>(inode->num_blocks);
+            counts->alloc_inodes++;
+            counts->inode_blocks += static_cast<uint32_t>(inode->num_blocks);
 
             size_t start_block = inode->start_block;
             size_t end_block = inode->start_block + inode->num_blocks;
@@ -35,22 +49,111 @@ void BlobfsChecker::TraverseInodeBitmap() {
                 valid = false;
             }
 
-            if (blobfs_->VerifyBlob(n) != ZX_OK) {
+            if ((inode->flags & kBlobFlagMaskCompressed) == kBlobFlagMaskCompressed) {
+                FS_TRACE_ERROR("check: ino %u is marked with more than one compression format\n",
+                               n);
+                valid = false;
+            } else if ((inode->flags & kBlobFlagLZ4HC) &&
+                       !(inode->flags & kBlobFlagChunkCompressed)) {
+                FS_TRACE_ERROR("check: ino %u is marked LZ4HC, but not compressed in chunks\n",
+                               n);
+                valid = false;
+            } else if ((inode->flags & kBlobFlagMaskCompressed) != 0 &&
+                       inode->num_blocks >= MerkleTreeBlocks(*inode) + BlobDataBlocks(*inode)) {
+                FS_TRACE_ERROR("check: ino %u is compressed, but no smaller than its data\n", n);
+                valid = false;
+            } else if (!metadata_only_ && blobfs_->VerifyBlob(n) != ZX_OK) {
                 FS_TRACE_ERROR("check: detected inode %u with bad state\n", n);
                 valid = false;
             }
             if (!valid) {
-                error_blobs_++;
+                counts->error_blobs++;
             }
         }
     }
 }
 
+void BlobfsChecker::TraverseInodeBitmap() {
+    uint32_t inode_count = static_cast<uint32_t>(blobfs_->info_.inode_count);
+    uint32_t threads = 1;
+#ifdef __Fuchsia__
+    // Without verification there is too little work per inode to be worth
+    // splitting up.  The host Blobfs reads inodes through a single block
+    // cache, so it is always checked by one thread.
+    if (!metadata_only_) {
+        threads = fbl::min(zx_system_get_num_cpus(), kMaxCheckThreads);
+        threads = fbl::max(fbl::min(threads, inode_count), 1u);
+    }
+    if (threads > 1) {
+        // The metrics are not updated atomically.
+        blobfs_->DisableMetrics();
+    }
+#endif
+
+    InodeCounts counts[kMaxCheckThreads];
+    memset(counts, 0, sizeof(counts));
+    uint32_t per_thread = inode_count / threads;
+    struct Range {
+        BlobfsChecker* checker;
+        uint32_t start;
+        uint32_t end;
+        InodeCounts* counts;
+    } ranges[kMaxCheckThreads];
+    for (uint32_t i = 0; i < threads; i++) {
+        ranges[i] = {this, i * per_thread,
+                     i == threads - 1 ? inode_count : (i + 1) * per_thread, &counts[i]};
+    }
+
+#ifdef __Fuchsia__
+    // The first range is checked on this thread, the rest on workers.  The
+    // Blobfs block client hands each thread its own transaction group, so
+    // their reads are issued concurrently.
+    auto worker = [](void* arg) -> int {
+        Range* range = static_cast<Range*>(arg);
+        range->checker->CheckInodeRange(range->start, range->end, range->counts);
+        return 0;
+    };
+    thrd_t workers[kMaxCheckThreads];
+    uint32_t started = 1;
+    for (; started < threads; started++) {
+        if (thrd_create_with_name(&workers[started], worker, &ranges[started],
+                                  "blobfs-fsck") != thrd_success) {
+            break;
+        }
+    }
+    // Ranges which did not get a thread are checked here.
+    CheckInodeRange(ranges[0].start, ranges[0].end, ranges[0].counts);
+    for (uint32_t i = started; i < threads; i++) {
+        CheckInodeRange(ranges[i].start, ranges[i].end, ranges[i].counts);
+    }
+    for (uint32_t i = 1; i < started; i++) {
+        thrd_join(workers[i], nullptr);
+    }
+#else
+    CheckInodeRange(ranges[0].start, ranges[0].end, ranges[0].counts);
+#endif
+
+    for (uint32_t i = 0; i < threads; i++) {
+        alloc_inodes_ += counts[i].alloc_inodes;
+        inode_blocks_ += counts[i].inode_blocks;
+        error_blobs_ += counts[i].error_blobs;
+    }
+}
+
 void BlobfsChecker::TraverseBlockBitmap() {
-    for (uint64_t n = 0; n < blobfs_->info_.data_block_count; n++) {
-        if (blobfs_->block_map_.Get(n, n + 1)) {
-            alloc_blocks_++;
+    // Counts whole runs at a time, rather than bit by bit.
+    const RawBitmap& map = blobfs_->block_map_;
+    size_t max = blobfs_->info_.data_block_count;
+    size_t n = 0;
+    while (n < max) {
+        size_t run_end = max;
+        map.Scan(n, max, true, &run_end);
+        alloc_blocks_ += static_cast<uint32_t>(run_end - n);
+        if (run_end >= max) {
+            break;
         }
+        n = max;
+        map.Scan(run_end, max, false, &n);
     }
 }
 
@@ -90,15 +193,17 @@ zx_status_t BlobfsChecker::CheckAllocatedCounts() const {
 }
 
 BlobfsChecker::BlobfsChecker()
-    : blobfs_(nullptr), alloc_inodes_(0), alloc_blocks_(0), error_blobs_(0), inode_blocks_(0) {};
+    : blobfs_(nullptr), metadata_only_(false), alloc_inodes_(0), alloc_blocks_(0),
+      error_blobs_(0), inode_blocks_(0) {};
 
-void BlobfsChecker::Init(fbl::unique_ptr<Blobfs> blob) {
+void BlobfsChecker::Init(fbl::unique_ptr<Blobfs> blob, bool metadata_only) {
     blobfs_ = fbl::move(blob);
+    metadata_only_ = metadata_only;
 }
 
-zx_status_t Fsck(fbl::unique_ptr<Blobfs> blob) {
+zx_status_t Fsck(fbl::unique_ptr<Blobfs> blob, bool metadata_only) {
     BlobfsChecker chk;
-    chk.Init(fbl::move(blob));
+    chk.Init(fbl::move(blob), metadata_only);
     chk.TraverseInodeBitmap();
     chk.TraverseBlockBitmap();
     return chk.CheckAllocatedCounts();
@@ -23,6 +23,7 @@
 
 #define ZXDEBUG 0
 
+#include <blobfs/chunked.h>
 #include <blobfs/format.h>
 #include <blobfs/fsck.h>
 #include <blobfs/host.h>
@@ -79,9 +80,10 @@ zx_status_t buffer_create_merkle(const FileMapping& mapping, MerkleInfo* out_inf
     return ZX_OK;
 }
 
-zx_status_t buffer_compress(const FileMapping& mapping, MerkleInfo* out_info) {
-    Compressor compressor;
-    size_t max = compressor.BufferMax(mapping.length());
+zx_status_t buffer_compress(const FileMapping& mapping, CompressionAlgorithm algorithm,
+                            MerkleInfo* out_info) {
+    ChunkedCompressor compressor;
+    size_t max = ChunkedCompressor::BufferMax(mapping.length());
     out_info->compressed_data.reset(new uint8_t[max]);
     out_info->compressed = false;
 
@@ -90,7 +92,8 @@ zx_status_t buffer_compress(const FileMapping& mapping, MerkleInfo* out_info) {
     }
 
     zx_status_t status;
-    if ((status = compressor.Initialize(out_info->compressed_data.get(), max)) != ZX_OK) {
+    if ((status = compressor.Initialize(out_info->compressed_data.get(), max,
+                                        mapping.length(), algorithm)) != ZX_OK) {
         fprintf(stderr, "Failed to initialize blobfs compressor: %d\n", status);
         return status;
     }
@@ -108,6 +111,7 @@ zx_status_t buffer_compress(const FileMapping& mapping, MerkleInfo* out_info) {
     if (mapping.length() > compressor.Size() + kCompressionMinBytesSaved) {
         out_info->compressed_length = compressor.Size();
         out_info->compressed = true;
+        out_info->compression = algorithm;
     }
 
     return ZX_OK;
@@ -143,7 +147,7 @@ zx_status_t blobfs_add_mapped_blob_with_merkle(Blobfs* bs, const FileMapping& ma
     Inode* inode = inode_block->GetInode();
     inode->blob_size = mapping.length();
     inode->num_blocks = MerkleTreeBlocks(*inode) + info.GetDataBlocks();
-    inode->flags |= (info.compressed ? kBlobFlagLZ4Compressed : 0);
+    inode->flags |= (info.compressed ? ChunkedInodeFlags(info.compression) : 0);
 
     if ((status = bs->AllocateBlocks(inode->num_blocks,
                                      reinterpret_cast<size_t*>(&inode->start_block))) != ZX_OK) {
@@ -251,7 +255,8 @@ zx_status_t blobfs_create_sparse(fbl::unique_ptr<Blobfs>* out, fbl::unique_fd fd
     return ZX_OK;
 }
 
-zx_status_t blobfs_preprocess(int data_fd, bool compress, MerkleInfo* out_info) {
+zx_status_t blobfs_preprocess(int data_fd, bool compress, MerkleInfo* out_info,
+                              CompressionAlgorithm algorithm) {
     FileMapping mapping;
     zx_status_t status = mapping.Map(data_fd);
     if (status != ZX_OK) {
@@ -263,7 +268,7 @@ zx_status_t blobfs_preprocess(int data_fd, bool compress, MerkleInfo* out_info)
     }
 
     if (compress) {
-        status = buffer_compress(mapping, out_info);
+        status = buffer_compress(mapping, algorithm, out_info);
     }
 
     return status;
@@ -567,7 +572,7 @@ zx_status_t Blobfs::VerifyBlob(size_t node_index) {
 
     // Create data buffer.
     fbl::unique_ptr<uint8_t[]> data(new uint8_t[target_size]);
-    if (inode.flags & kBlobFlagLZ4Compressed) {
+    if (inode.flags & kBlobFlagMaskCompressed) {
         // Read in uncompressed merkle blocks.
         for (unsigned i = 0; i < merkle_blocks; i++) {
             ReadBlock(data_start_block_ + inode.start_block + i);
@@ -595,8 +600,17 @@ zx_status_t Blobfs::VerifyBlob(size_t node_index) {
         zx_status_t status;
         target_size = inode.blob_size;
         uint8_t* data_ptr = data.get() + (merkle_blocks * kBlobfsBlockSize);
-        if ((status = Decompressor::Decompress(data_ptr, &target_size, compressed_data.get(),
-                                               &compressed_size)) != ZX_OK) {
+        if (inode.flags & kBlobFlagChunkCompressed) {
+            ChunkedDecompressor decompressor;
+            if ((status = decompressor.Init(compressed_data.get(), compressed_size,
+                                            compressed_size, inode.blob_size)) != ZX_OK ||
+                (status = decompressor.DecompressAll(compressed_data.get(), data_ptr,
+                                                     1)) != ZX_OK) {
+                return status;
+            }
+        } else if ((status = Decompressor::Decompress(data_ptr, &target_size,
+                                                      compressed_data.get(),
+                                                      &compressed_size)) != ZX_OK) {
             return status;
         }
         if (target_size != inode.blob_size) {
@@ -17,6 +17,7 @@
 #include <bitmap/rle-bitmap.h>
 #include <block-client/cpp/client.h>
 #include <digest/digest.h>
+#include <digest/merkle-tree.h>
 #include <fbl/algorithm.h>
 #include <fbl/intrusive_double_list.h>
 #include <fbl/intrusive_wavl_tree.h>
@@ -39,17 +40,20 @@
 #include <lib/zx/vmo.h>
 #include <trace/event.h>
 
+#include <blobfs/chunked.h>
 #include <blobfs/common.h>
+#include <blobfs/extent-index.h>
 #include <blobfs/format.h>
 #include <blobfs/lz4.h>
 #include <blobfs/metrics.h>
 #include <blobfs/journal.h>
+#include <blobfs/pager.h>
 #include <blobfs/writeback.h>
 
 namespace blobfs {
 
 class Blobfs;
-class Compressor;
+class ChunkedCompressor;
 class Journal;
 class VnodeBlob;
 class WritebackQueue;
@@ -92,6 +96,10 @@ public:
     struct TypeWavlTraits {
         static WAVLTreeNodeState& node_state(VnodeBlob& b) { return b.type_wavl_state_; }
     };
+    using LruNodeState = fbl::DoublyLinkedListNodeState<VnodeBlob*>;
+    struct TypeLruTraits {
+        static LruNodeState& node_state(VnodeBlob& b) { return b.lru_state_; }
+    };
     const uint8_t* GetKey() const {
         return &digest_[0];
     };
@@ -126,6 +134,12 @@ public:
         return inode_;
     }
 
+    // Returns the number of bytes of memory held for the blob's data and
+    // Merkle tree, or zero if they haven't been read in.
+    uint64_t CachedSize() const {
+        return mapping_.vmo() ? mapping_.size() : 0;
+    }
+
     // Constructs the "directory" blob
     VnodeBlob(Blobfs* bs);
     // Constructs actual blobs
@@ -157,6 +171,7 @@ public:
 
 private:
     friend struct TypeWavlTraits;
+    friend struct TypeLruTraits;
 
     DISALLOW_COPY_ASSIGN_AND_MOVE(VnodeBlob);
 
@@ -234,12 +249,15 @@ private:
 
     // Read both VMOs into memory, if we haven't already.
     //
-    // TODO(ZX-1481): When we have can register the Blob Store as a pager
-    // service, and it can properly handle pages faults on a vnode's contents,
-    // then we can avoid reading the entire blob up-front. Until then, read
-    // the contents of a VMO into memory when it is opened.
+    // Uncompressed blobs and blobs compressed in chunks are demand paged when
+    // blobfs has a pager: only their Merkle tree is read here, and their data is read and verified as it is
+    // accessed. Other blobs are read in full; readable blobs are verified by
+    // VerifyRange() as they are read, and any others are verified here.
     zx_status_t InitVmos();
 
+    // Initialize a blob which is paged in by |blobfs_->pager_|.
+    zx_status_t InitPaged();
+
     // Initialize a compressed blob by reading it from disk and decompressing
     // it.
     // Does not verify the blob.
@@ -251,7 +269,11 @@ private:
 
     // Verify the integrity of the in-memory Blob.
     // InitVmos() must have already been called for this blob.
-    zx_status_t Verify() const;
+    zx_status_t Verify();
+
+    // Verify the integrity of the in-memory blob between |offset| and
+    // |offset + length|, skipping any Merkle tree nodes already verified.
+    zx_status_t VerifyRange(uint64_t offset, uint64_t length);
 
     // Called by the Vnode once the last write has completed, updating the
     // on-disk metadata.
@@ -262,6 +284,7 @@ private:
     void* GetMerkle() const;
 
     WAVLTreeNodeState type_wavl_state_ = {};
+    LruNodeState lru_state_ = {};
 
     Blobfs* const blobfs_;
     BlobFlags flags_ = {};
@@ -272,6 +295,12 @@ private:
     // 2) The Blob itself, aligned to the nearest kBlobfsBlockSize
     fzl::OwnedVmoMapper mapping_;
     vmoid_t vmoid_ = {};
+    // Set when the contents of |mapping_| are paged in instead of read
+    // through |vmoid_|.
+    fbl::RefPtr<PagedBlob> paged_ = {};
+    // Merkle tree nodes of data in |mapping_| which have been verified, for
+    // blobs which aren't paged in.
+    bitmap::RawBitmap verified_;
 
     // Watches any clones of "vmo_" provided to clients.
     // Observes the ZX_VMO_ZERO_CHILDREN signal.
@@ -293,8 +322,11 @@ private:
     // Data used exclusively during writeback.
     struct WritebackInfo {
         uint64_t bytes_written = {};
-        Compressor compressor;
+        ChunkedCompressor compressor;
         fzl::OwnedVmoMapper compressed_blob;
+        // Built up as data arrives, rather than once the whole blob is buffered.
+        digest::MerkleTree merkle;
+        fs::Duration merkle_duration = {};
     };
 
     fbl::unique_ptr<WritebackInfo> write_info_ = {};
@@ -330,14 +362,31 @@ enum class CachePolicy {
     // This option costs a significant amount of memory, but it results in high
     // performance.
     NeverEvict,
+
+    // Closed blobs keep their verified data in memory until the data of all
+    // closed blobs exceeds |MountOptions::cache_budget|, at which point the
+    // least recently used are evicted.
+    //
+    // This option bounds the memory used, while repeatedly opening the
+    // same blobs is served from memory.
+    EvictLeastRecentlyUsed,
 };
 
+// The default |MountOptions::cache_budget|.
+constexpr uint64_t kDefaultCacheBudget = 64 << 20;
+
 // Toggles that may be set on blobfs during initialization.
 struct MountOptions {
     bool readonly = false;
     bool metrics = false;
     bool journal = false;
     CachePolicy cache_policy = CachePolicy::EvictImmediately;
+    // Bytes of closed blobs kept in memory under
+    // CachePolicy::EvictLeastRecentlyUsed.
+    uint64_t cache_budget = kDefaultCacheBudget;
+    // How blobs written while mounted are compressed. The choice is recorded
+    // in each blob's Inode, so blobs written with either can be read back.
+    CompressionAlgorithm compression = CompressionAlgorithm::kLz4;
 };
 
 class Blobfs : public fs::ManagedVfs, public fbl::RefCounted<Blobfs>,
@@ -364,7 +413,8 @@ public:
 
     groupid_t BlockGroupID() final {
         thread_local groupid_t group_ = next_group_.fetch_add(1);
-        ZX_ASSERT_MSG(group_ < MAX_TXN_GROUP_COUNT, "Too many threads accessing block device");
+        ZX_ASSERT_MSG(group_ < fifo_client_.GroupCount(),
+                      "Too many threads accessing block device");
         return group_;
     }
 
@@ -379,7 +429,11 @@ public:
     static zx_status_t Create(fbl::unique_fd blockfd, const MountOptions& options,
                               const Superblock* info, fbl::unique_ptr<Blobfs>* out);
 
-    void SetCachePolicy(CachePolicy policy) { cache_policy_ = policy; }
+    void SetCachePolicy(CachePolicy policy, uint64_t budget) {
+        cache_policy_ = policy;
+        cache_budget_ = budget;
+    }
+    void SetCompression(CompressionAlgorithm algorithm) { compression_ = algorithm; }
     void CollectMetrics() { collecting_metrics_ = true; }
     bool CollectingMetrics() const { return collecting_metrics_; }
     void DisableMetrics() { collecting_metrics_ = false; }
@@ -470,6 +524,14 @@ public:
     // to the underlying storage driver.
     void UpdateWritebackMetrics(uint64_t size, const fs::Duration& duration);
 
+    // Updates aggregate information about journal entries being written out
+    // together, with |entries| entries written by one work.
+    void UpdateJournalMetrics(uint64_t entries);
+
+    // Updates aggregate information about closed blobs being reopened
+    // since mounting, and whether their data was still in memory.
+    void UpdateCacheMetrics(bool hit);
+
     // Updates aggregate information about reading blobs from storage
     // since mounting.
     void UpdateMerkleDiskReadMetrics(uint64_t size, const fs::Duration& duration);
@@ -543,8 +605,9 @@ private:
     // Precondition: The Vnode must not exist in |open_hash_|.
     fbl::RefPtr<VnodeBlob> VnodeUpgradeLocked(const uint8_t* key) __TA_REQUIRES(hash_lock_);
 
-    // Searches for |nblocks| free blocks between the block_map_ and reserved_blocks_ bitmaps.
-    zx_status_t FindBlocks(size_t start, size_t nblocks, size_t* blkno_out);
+    // Tears down the least recently used closed blobs until the data of those
+    // left in |lru_| fits in |budget| bytes.
+    void EvictCacheLocked(uint64_t budget) __TA_REQUIRES(hash_lock_);
 
     // Reserves space for a block in memory. Does not update disk.
     zx_status_t ReserveBlocks(size_t nblocks, size_t* blkno_out);
@@ -561,6 +624,12 @@ private:
     // Frees blocks from the reserved/allocated maps and updates disk if necessary.
     void FreeBlocks(WritebackWork* wb, size_t nblocks, size_t blkno);
 
+    // Returns blocks which are neither reserved nor allocated any more to |free_extents_|.
+    void ReleaseExtent(size_t nblocks, size_t blkno);
+
+    // Rebuilds |free_extents_| from the block_map_ and reserved_blocks_ bitmaps.
+    zx_status_t LoadExtentIndex();
+
     // Finds an unallocated node. If it exists, sets |*node_index_out| to the
     // first available value.
     zx_status_t FindNode(size_t* node_index_out);
@@ -609,11 +678,19 @@ private:
                                            VnodeBlob::TypeWavlTraits>;
     fbl::unique_ptr<WritebackQueue> writeback_;
     fbl::unique_ptr<Journal> journal_;
+    // Pages in uncompressed blobs. Null if the kernel can't page VMOs from
+    // user mode, in which case all blobs are read up front.
+    fbl::unique_ptr<BlobPager> pager_;
     Superblock info_;
 
     fbl::Mutex hash_lock_;
     WAVLTreeByMerkle open_hash_ __TA_GUARDED(hash_lock_){};   // All 'in use' blobs.
     WAVLTreeByMerkle closed_hash_ __TA_GUARDED(hash_lock_){}; // All 'closed' blobs.
+    // Closed blobs which still hold their data under
+    // CachePolicy::EvictLeastRecentlyUsed, least recently used first, and the
+    // memory they hold.
+    fbl::DoublyLinkedList<VnodeBlob*, VnodeBlob::TypeLruTraits> lru_ __TA_GUARDED(hash_lock_){};
+    uint64_t lru_size_ __TA_GUARDED(hash_lock_) = 0;
 
     fbl::unique_fd blockfd_;
     block_info_t block_info_ = {};
@@ -631,6 +708,9 @@ private:
     // At a steady state they will be empty.
     bitmap::RleBitmap reserved_blocks_ = {};
     bitmap::RleBitmap reserved_nodes_ = {};
+    // Every run of blocks which is neither allocated nor reserved, so that
+    // blocks are reserved without scanning the bitmaps.
+    ExtentIndex free_extents_;
     uint64_t fs_id_ = 0;
 
     // free_node_lower_bound_ is lower bound on free nodes, meaning we are sure that
@@ -643,6 +723,8 @@ private:
     BlobfsMetrics metrics_ = {};
 
     CachePolicy cache_policy_;
+    uint64_t cache_budget_ = kDefaultCacheBudget;
+    CompressionAlgorithm compression_ = CompressionAlgorithm::kLz4;
     fbl::Closure on_unmount_ = {};
 };
 
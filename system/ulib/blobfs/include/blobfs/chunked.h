@@ -0,0 +1,148 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <fbl/macros.h>
+#include <fbl/unique_ptr.h>
+#include <zircon/types.h>
+
+#include <blobfs/format.h>
+
+namespace blobfs {
+
+// The algorithms chunks can be compressed with.
+enum class CompressionAlgorithm {
+    // Fast compression, with modest ratios.
+    kLz4,
+    // Compression several times slower than kLz4, which stores the same
+    // data in fewer blocks. Decompression is just as fast.
+    kLz4Hc,
+};
+
+// Returns the Inode flags which record that a blob was compressed in chunks
+// with |algorithm|.
+constexpr uint32_t ChunkedInodeFlags(CompressionAlgorithm algorithm) {
+    return kBlobFlagChunkCompressed |
+           (algorithm == CompressionAlgorithm::kLz4Hc ? kBlobFlagLZ4HC : 0);
+}
+
+// A ChunkedCompressor compresses a blob in chunks, which can later be
+// decompressed independently of each other, before it is written back to
+// disk.
+//
+// The output is laid out as described by |ChunkedHeader| in format.h.
+class ChunkedCompressor {
+public:
+    ChunkedCompressor();
+
+    ~ChunkedCompressor();
+
+    // Identifies if compression is underway.
+    bool Compressing() const {
+        return buf_ != nullptr;
+    }
+
+    // Resets the compression process.
+    void Reset();
+
+    // Returns the compressed size of the blob so far, including the
+    // header and seek table.
+    size_t Size() const;
+
+    // Initializes the compression object for a blob of |blob_size| bytes,
+    // to be compressed with |algorithm| into a provided buffer of a
+    // specified size.
+    //
+    // Although ChunkedCompressor uses this buffer, it does not own the buffer,
+    // assuming that a parent object is responsible for the lifetime.
+    zx_status_t Initialize(void* buf, size_t buf_max, size_t blob_size,
+                           CompressionAlgorithm algorithm = CompressionAlgorithm::kLz4);
+
+    CompressionAlgorithm Algorithm() const { return algorithm_; }
+
+    // Returns the maximum possible size a buffer would need to be
+    // in order to compress a blob of size |blob_size|.
+    //
+    // Typically used in conjunction with |Initialize()|.
+    static size_t BufferMax(size_t blob_size);
+
+    // Continues the compression after initialization.
+    zx_status_t Update(const void* data, size_t length);
+
+    // Finishes the compression process. Must be called
+    // before compression is considered complete.
+    zx_status_t End();
+
+private:
+    DISALLOW_COPY_ASSIGN_AND_MOVE(ChunkedCompressor);
+
+    // Appends the next chunk, |length| bytes at |data|, to the buffer.
+    zx_status_t CompressChunk(const uint8_t* data, size_t length);
+
+    CompressionAlgorithm algorithm_;
+    // Working memory for LZ4HC, which is too large for the stack.
+    fbl::unique_ptr<uint8_t[]> hc_state_;
+
+    uint8_t* buf_;
+    size_t buf_max_;
+    size_t buf_used_;
+    size_t blob_size_;
+    size_t bytes_in_;
+
+    // Holds the start of a chunk until the rest of it arrives.
+    fbl::unique_ptr<uint8_t[]> pending_;
+    size_t pending_size_;
+    uint64_t next_chunk_;
+};
+
+// A ChunkedDecompressor decompresses all or part of a blob compressed by
+// ChunkedCompressor, as described by a validated copy of its seek table.
+class ChunkedDecompressor {
+public:
+    ChunkedDecompressor() = default;
+
+    // Reads the header and seek table at the start of |metadata|, of
+    // |metadata_size| bytes, of a blob of |blob_size| bytes whose compressed
+    // form takes |compressed_size| bytes.
+    //
+    // Fails unless every chunk is stored within |compressed_size| bytes, in
+    // order, without overlapping the seek table or each other.
+    zx_status_t Init(const void* metadata, size_t metadata_size, uint64_t compressed_size,
+                     uint64_t blob_size);
+
+    uint64_t ChunkCount() const { return chunk_count_; }
+
+    // Identifies the chunks [*first, *last] which hold the bytes
+    // [offset, offset + length) of the blob. |length| must not be zero.
+    void ChunksFor(uint64_t offset, uint64_t length, uint64_t* first, uint64_t* last) const;
+
+    // Returns where the chunks [first, last] are stored, relative to the
+    // start of the compressed blob.
+    void CompressedRange(uint64_t first, uint64_t last, uint64_t* offset,
+                         uint64_t* length) const;
+
+    // Returns the number of bytes of the blob held by chunk |index|.
+    size_t ChunkLength(uint64_t index) const;
+
+    // Decompresses chunk |index| into the ChunkLength(index) bytes at |target|.
+    //
+    // |src| holds the compressed blob starting at |src_offset|, so that the
+    // chunk is found at |src| + compressed_offset - |src_offset|.
+    zx_status_t DecompressChunk(uint64_t index, const void* src, uint64_t src_offset,
+                                void* target) const;
+
+    // Decompresses the whole compressed blob at |src| into the blob size bytes
+    // at |target|, splitting the chunks across up to |threads| threads.
+    zx_status_t DecompressAll(const void* src, void* target, size_t threads) const;
+
+private:
+    DISALLOW_COPY_ASSIGN_AND_MOVE(ChunkedDecompressor);
+
+    fbl::unique_ptr<SeekEntry[]> table_;
+    uint64_t chunk_count_ = 0;
+    uint64_t blob_size_ = 0;
+};
+
+} // namespace blobfs
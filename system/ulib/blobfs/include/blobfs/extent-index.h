@@ -0,0 +1,102 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <fbl/intrusive_wavl_tree.h>
+#include <fbl/macros.h>
+#include <fbl/unique_ptr.h>
+#include <zircon/types.h>
+
+namespace blobfs {
+
+// An ExtentIndex tracks the runs of free blocks within blobfs, so that a run
+// long enough for a blob can be found without scanning the block bitmap.
+//
+// Every free extent is indexed both by its first block, to merge it with its
+// neighbours when blocks are released, and by its length, so that the
+// shortest extent which fits a request is found in O(log n).
+//
+// This class is thread-compatible.
+class ExtentIndex {
+public:
+    ExtentIndex() = default;
+    ~ExtentIndex();
+
+    // Forgets every free extent.
+    void Reset();
+
+    // Records that the blocks [start, start + length) are free, merging them
+    // with any free extents they border. None of the blocks may already be
+    // free.
+    zx_status_t Insert(uint64_t start, uint64_t length);
+
+    // Records that the blocks [start, start + length), which must all lie
+    // within a single free extent, are no longer free.
+    zx_status_t Remove(uint64_t start, uint64_t length);
+
+    // Sets |*start_out| to the first block of the shortest free extent of at
+    // least |length| blocks, choosing the lowest of several equally short
+    // ones. Returns ZX_ERR_NO_SPACE if no free extent is long enough.
+    zx_status_t Find(uint64_t length, uint64_t* start_out) const;
+
+    // Returns the length of the longest free extent, or zero if there is none.
+    uint64_t LargestExtent() const;
+
+    uint64_t FreeBlocks() const { return free_blocks_; }
+    size_t ExtentCount() const { return by_start_.size(); }
+
+private:
+    DISALLOW_COPY_ASSIGN_AND_MOVE(ExtentIndex);
+
+    struct FreeExtent {
+        uint64_t start;
+        uint64_t length;
+        fbl::WAVLTreeNodeState<fbl::unique_ptr<FreeExtent>> start_state;
+        fbl::WAVLTreeNodeState<FreeExtent*> length_state;
+    };
+
+    // Orders extents by length, then by their first block. Both fit within
+    // 32 bits, since block numbers within blobfs do.
+    static uint64_t LengthKey(uint64_t length, uint64_t start) {
+        return (length << 32) | start;
+    }
+
+    struct StartTraits {
+        static uint64_t GetKey(const FreeExtent& e) { return e.start; }
+        static bool LessThan(uint64_t k1, uint64_t k2) { return k1 < k2; }
+        static bool EqualTo(uint64_t k1, uint64_t k2) { return k1 == k2; }
+        static fbl::WAVLTreeNodeState<fbl::unique_ptr<FreeExtent>>& node_state(FreeExtent& e) {
+            return e.start_state;
+        }
+    };
+
+    struct LengthTraits {
+        static uint64_t GetKey(const FreeExtent& e) { return LengthKey(e.length, e.start); }
+        static bool LessThan(uint64_t k1, uint64_t k2) { return k1 < k2; }
+        static bool EqualTo(uint64_t k1, uint64_t k2) { return k1 == k2; }
+        static fbl::WAVLTreeNodeState<FreeExtent*>& node_state(FreeExtent& e) {
+            return e.length_state;
+        }
+    };
+
+    using StartTree = fbl::WAVLTree<uint64_t, fbl::unique_ptr<FreeExtent>, StartTraits,
+                                    StartTraits>;
+    using LengthTree = fbl::WAVLTree<uint64_t, FreeExtent*, LengthTraits, LengthTraits>;
+
+    // Adds a new free extent to both indices.
+    zx_status_t Add(uint64_t start, uint64_t length);
+
+    // Changes the bounds of |extent|, which is kept in both indices.
+    void Resize(FreeExtent* extent, uint64_t start, uint64_t length);
+
+    // Owns the extents.
+    StartTree by_start_;
+    LengthTree by_length_;
+    uint64_t free_blocks_ = 0;
+};
+
+} // namespace blobfs
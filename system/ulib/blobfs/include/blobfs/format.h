@@ -197,6 +197,60 @@ constexpr uint64_t kStartBlockMinimum  = 1; // Smallest 'data' block possible.
 
 // Identifies that the on-disk storage of the blob is LZ4 compressed.
 constexpr uint32_t kBlobFlagLZ4Compressed = 0x00000001;
+// Identifies that the on-disk storage of the blob is LZ4 compressed in
+// chunks which can be decompressed independently.
+constexpr uint32_t kBlobFlagChunkCompressed = 0x00000002;
+// Identifies that the chunks of a blob compressed in chunks were compressed
+// with LZ4HC. They decompress like any other LZ4 chunks.
+constexpr uint32_t kBlobFlagLZ4HC = 0x00000004;
+constexpr uint32_t kBlobFlagMaskCompressed = kBlobFlagLZ4Compressed | kBlobFlagChunkCompressed;
+
+// The data of a blob compressed in chunks starts with a ChunkedHeader,
+// followed by a SeekEntry for each chunk and then the chunks themselves:
+//
+//   ChunkedHeader | SeekEntry[chunk_count] | chunk 0 | chunk 1 | ...
+//
+// Every chunk but the last holds |chunk_size| bytes of the blob. The seek
+// table lists the chunks in the order they are stored, which is also the
+// order of the data they hold, so the chunks covering any range of the blob
+// can be read and decompressed on their own.
+constexpr uint64_t kChunkedMagic   = (0x6b6e7568633462ULL); // "b4chunk"
+constexpr uint32_t kChunkedVersion = 1;
+// A multiple of the block size, so that chunks cover whole blocks of the
+// decompressed blob.
+constexpr uint32_t kChunkSize      = 4 * kBlobfsBlockSize;
+
+// Identifies a chunk stored as is, because it did not compress.
+constexpr uint32_t kChunkFlagUncompressed = 0x00000001;
+
+struct ChunkedHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t chunk_size;
+    uint64_t blob_size;
+    uint64_t chunk_count;
+};
+
+struct SeekEntry {
+    // Relative to the start of the ChunkedHeader.
+    uint64_t compressed_offset;
+    uint32_t compressed_size;
+    uint32_t flags;
+};
+
+static_assert(sizeof(ChunkedHeader) == 32, "Blobfs ChunkedHeader size is wrong");
+static_assert(sizeof(SeekEntry) == 16, "Blobfs SeekEntry size is wrong");
+static_assert(kChunkSize % kBlobfsBlockSize == 0,
+              "Blobfs chunks should cover whole blocks");
+
+constexpr uint64_t ChunkCount(uint64_t blob_size) {
+    return fbl::round_up(blob_size, kChunkSize) / kChunkSize;
+}
+
+// Size of the header and seek table of a blob compressed in chunks.
+constexpr uint64_t ChunkedMetadataSize(uint64_t blob_size) {
+    return sizeof(ChunkedHeader) + ChunkCount(blob_size) * sizeof(SeekEntry);
+}
 
 using digest::Digest;
 
@@ -18,20 +18,36 @@ namespace blobfs {
 class BlobfsChecker {
 public:
     BlobfsChecker();
-    void Init(fbl::unique_ptr<Blobfs> vnode);
+    // If |metadata_only| is set, blob contents are not read back and
+    // verified against their Merkle trees.
+    void Init(fbl::unique_ptr<Blobfs> vnode, bool metadata_only = false);
     void TraverseInodeBitmap();
     void TraverseBlockBitmap();
     zx_status_t CheckAllocatedCounts() const;
 
 private:
     DISALLOW_COPY_ASSIGN_AND_MOVE(BlobfsChecker);
+
+    struct InodeCounts {
+        uint32_t alloc_inodes;
+        uint32_t inode_blocks;
+        uint32_t error_blobs;
+    };
+
+    // Checks inodes [start, end) into |counts|.  This may run on several
+    // threads at once, each with its own range and counts.
+    void CheckInodeRange(uint32_t start, uint32_t end, InodeCounts* counts);
+
     fbl::unique_ptr<Blobfs> blobfs_;
+    bool metadata_only_;
     uint32_t alloc_inodes_;
     uint32_t alloc_blocks_;
     uint32_t error_blobs_;
     uint32_t inode_blocks_;
 };
 
-zx_status_t Fsck(fbl::unique_ptr<Blobfs> vnode);
+// Checks the consistency of |vnode|.  If |metadata_only| is set, only the
+// inodes and the block bitmap are checked, without reading any blob.
+zx_status_t Fsck(fbl::unique_ptr<Blobfs> vnode, bool metadata_only = false);
 
 } // namespace blobfs
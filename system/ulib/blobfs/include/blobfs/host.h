@@ -32,6 +32,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include <blobfs/chunked.h>
 #include <blobfs/common.h>
 #include <blobfs/format.h>
 
@@ -51,6 +52,7 @@ struct MerkleInfo {
     fbl::unique_ptr<uint8_t[]> compressed_data;
     uint64_t compressed_length = 0;
     bool compressed = false;
+    CompressionAlgorithm compression = CompressionAlgorithm::kLz4;
 
     uint64_t GetDataBlocks() const {
         uint64_t blob_size = compressed ? compressed_length : length;
@@ -212,7 +214,8 @@ zx_status_t blobfs_create(fbl::unique_ptr<Blobfs>* out, fbl::unique_fd blockfd);
 // Pre-process a blob by creating a merkle tree and digest from the supplied file.
 // Also return the length of the file. If |compress| is true and we decide to compress the file,
 // the compressed length and data are returned.
-zx_status_t blobfs_preprocess(int data_fd, bool compress, MerkleInfo* out_info);
+zx_status_t blobfs_preprocess(int data_fd, bool compress, MerkleInfo* out_info,
+                              CompressionAlgorithm algorithm = CompressionAlgorithm::kLz4);
 
 // blobfs_add_blob may be called by multiple threads to gain concurrent
 // merkle tree generation. No other methods are thread safe.
@@ -81,6 +81,9 @@ public:
     // after the writeback thread attempts persistence.
     SyncCallback CreateSyncCallback();
 
+    // Updates the state of the entry with the |status| of an attempt to persist it.
+    void UpdateStatus(zx_status_t status);
+
     // Returns the current status.
     // When the status is "kWaiting", we are waiting on another thread to change the state of the
     // entry. Once the state is changed from kWaiting, we are guaranteed that it will not be
@@ -109,6 +112,10 @@ public:
     const HeaderBlock& GetHeaderBlock() const { return header_block_; }
     const CommitBlock& GetCommitBlock() const { return commit_block_; }
 
+    // Returns the entry written to the journal after this one as part of the same group, if any.
+    JournalEntry* GetGroupNext() const { return group_next_; }
+    void SetGroupNext(JournalEntry* entry) { group_next_ = entry; }
+
 private:
     Journal* journal_; // Pointer to the journal containing this entry.
     fbl::atomic<uint32_t> status_; // Current EntryStatus. Accessed by multiple threads.
@@ -124,6 +131,9 @@ private:
 
     // WritebackWork for the data contained in this entry.
     fbl::unique_ptr<WritebackWork> work_;
+
+    // The next entry of the group this entry was written to the journal with.
+    JournalEntry* group_next_ = nullptr;
 };
 
 using EntryQueue = fs::Queue<fbl::unique_ptr<JournalEntry>>;
@@ -139,14 +149,18 @@ using EntryQueue = fs::Queue<fbl::unique_ptr<JournalEntry>>;
 //    containing sync callbacks will go through the same queues as regular entries from here on
 //    out, but nothing will be done with them until step 7.
 //
-// 2. The JournalThread will write the transaction data to its buffer, and send work to the
-//    WritebackBuffer queue with transactions intended to write the journal entry out to disk.
+// 2. The transaction data is written to the journal buffer, and the entry joins the group of
+//    entries which are written out to the journal together. The group is sent to the
+//    WritebackBuffer queue as a single work once it has been open for kGroupCommitWindow, once it
+//    fills half of the journal buffer, or as soon as something else must reach the writeback queue
+//    after its entries (a sync request, or blob data which may reuse blocks the group frees).
 //    However, the header and commit blocks will not yet be written out to the buffer, so the work
-//    will block the writeback queue (not allowing any more writes to go through) until it is ready.
+//    will block the writeback queue (not allowing any more writes to go through) until every
+//    entry of the group is ready.
 //
-// 3. In the JournalThread, the entry whose work has been processed and sent to the
-//    writeback queue will have its header and commit blocks written to the buffer, and will then
-//    present its work as "ready" to the writeback queue.
+// 3. In the JournalThread, each entry will have its header and commit blocks written to the
+//    buffer. Once the last entry of a group is prepared, the group's work is "ready" for the
+//    writeback queue.
 //
 // 4. Once a journal entry has been written out to disk, the journal will receive a callback to let
 //    it know that the entry has been processed. At this point we know it is safe to write the data
@@ -192,6 +206,13 @@ public:
     // An error will be returned if the journal is currently in read only mode.
     zx_status_t Enqueue(fbl::unique_ptr<WritebackWork> work);
 
+    // Sends the group of entries which have not yet been written out to the journal to the
+    // writeback queue, so that any work enqueued afterwards is written out after them.
+    zx_status_t CommitGroup() {
+        fbl::AutoLock lock(&lock_);
+        return CommitGroupLocked();
+    }
+
     // Signals the journal thread to process waiting entries.
     void SendSignal(zx_status_t status) {
         fbl::AutoLock lock(&lock_);
@@ -210,6 +231,9 @@ private:
 
     friend class JournalProcessor;
 
+    // How long a group of entries waits for more entries to join it before it is written out.
+    static constexpr zx_duration_t kGroupCommitWindow = ZX_MSEC(2);
+
     Journal(Blobfs* blobfs, fbl::unique_ptr<Buffer> info, fbl::unique_ptr<Buffer> entries,
             uint64_t start_block)
         : blobfs_(blobfs), start_block_(start_block),
@@ -224,10 +248,17 @@ private:
     // and potentially update the readonly state of the journal.
     void SendSignalLocked(zx_status_t status) __TA_REQUIRES(lock_);
 
-    // Prepares |work| with transactions to write the data for |entry| stored in the journal buffer
-    // into the actual journal. This will consist of at most 2 transactions (if we wrap around the
-    // end of the circular buffer). The entry in the buffer itself may not be ready at this point.
-    void PrepareWork(JournalEntry* entry, fbl::unique_ptr<WritebackWork>* work);
+    // Adds |entry| to the group of entries to be written out to the journal together, with
+    // transactions to write the data for |entry| stored in the journal buffer into the actual
+    // journal. The entry in the buffer itself may not be ready at this point.
+    void AddToGroupLocked(JournalEntry* entry) __TA_REQUIRES(lock_);
+
+    // Sends the work which writes out the current group of entries (if any) to the writeback
+    // queue. The work is ready once the last entry of the group has been prepared.
+    zx_status_t CommitGroupLocked() __TA_REQUIRES(lock_);
+
+    // Returns the largest group of entries, in blocks, which may be written out together.
+    size_t MaxGroupBlocks() const { return entries_->capacity() / 2; }
 
     // Writes out the header and commit blocks belonging to |entry| to the buffer.
     // All data from |entry| should already be written to the buffer.
@@ -344,6 +375,16 @@ private:
     // Ensures that if multiple producers are waiting for space to write their
     // entries into the entry buffer, they can each write in-order.
     ProducerQueue producer_queue_ __TA_GUARDED(lock_);
+
+    // The work which writes the current group of entries out to the journal, if one is open.
+    // The entries of the group are linked from group_first_ to group_last_.
+    fbl::unique_ptr<WritebackWork> group_work_ __TA_GUARDED(lock_);
+    JournalEntry* group_first_ __TA_GUARDED(lock_) = nullptr;
+    JournalEntry* group_last_ __TA_GUARDED(lock_) = nullptr;
+    size_t group_entries_ __TA_GUARDED(lock_) = 0;
+    size_t group_blocks_ __TA_GUARDED(lock_) = 0;
+    // The time after which the current group is written out, even if it has room for more.
+    zx_time_t group_deadline_ __TA_GUARDED(lock_) = 0;
 };
 
 // Result returned from a JournalProcessor's Process methods.
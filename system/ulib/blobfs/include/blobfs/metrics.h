@@ -41,6 +41,9 @@ struct BlobfsMetrics {
     // the client time because of asynchronous writeback buffers.
     zx::ticks total_writeback_time_ticks = {};
     uint64_t total_writeback_bytes_written = 0;
+    // Journal entries, and the grouped writes which wrote them out to the journal.
+    uint64_t journal_entries_written = 0;
+    uint64_t journal_groups_written = 0;
 
     // LOOKUP STATS
 
@@ -56,6 +59,11 @@ struct BlobfsMetrics {
     // Opened via "LookupBlob".
     uint64_t blobs_opened = 0;
     uint64_t blobs_opened_total_size = 0;
+    // Closed blobs reopened with their data still in memory, and without.
+    uint64_t blob_cache_hits = 0;
+    uint64_t blob_cache_misses = 0;
+    // Closed blobs whose data was dropped to stay within the cache budget.
+    uint64_t blob_cache_evictions = 0;
     // Verified blob data (includes both blobs read and written).
     uint64_t blobs_verified = 0;
     uint64_t blobs_verified_total_size_data = 0;
@@ -0,0 +1,143 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#ifndef __Fuchsia__
+#error Fuchsia-only Header
+#endif
+
+#include <threads.h>
+
+#include <digest/digest.h>
+#include <fbl/macros.h>
+#include <fbl/mutex.h>
+#include <fbl/ref_counted.h>
+#include <fbl/ref_ptr.h>
+#include <fbl/unique_ptr.h>
+#include <fs/readahead.h>
+#include <lib/fzl/owned-vmo-mapper.h>
+#include <lib/zx/pager.h>
+#include <lib/zx/port.h>
+#include <lib/zx/vmo.h>
+#include <zircon/device/block.h>
+
+#include <blobfs/chunked.h>
+#include <blobfs/format.h>
+
+namespace blobfs {
+
+class Blobfs;
+
+// The state needed to page in the contents of one blob, which is either
+// uncompressed or compressed in chunks.
+//
+// The blob's VMO holds the Merkle tree followed by the data, like the VMO of
+// a blob which is read eagerly. The Merkle tree is supplied when the VMO is
+// created; data is read from disk (decompressing the chunks which hold it)
+// and verified as it is first accessed.
+//
+// Each blob has a pager object of its own, so that when its data fails
+// verification the pager can be closed, failing every access to the missing
+// pages instead of leaving them blocked forever.
+class PagedBlob : public fbl::RefCounted<PagedBlob> {
+public:
+    DISALLOW_COPY_ASSIGN_AND_MOVE(PagedBlob);
+
+    // Stops supplying pages to the blob.
+    //
+    // Called when the blob's Vnode lets go of the VMO. Any access still
+    // waiting for a page fails.
+    void Detach();
+
+private:
+    friend class BlobPager;
+
+    PagedBlob(uint64_t start_block, const Inode& inode, const uint8_t* digest);
+
+    fbl::Mutex lock_;
+    zx::pager pager_ __TA_GUARDED(lock_);
+    // The VMO the pages are supplied to. Reset once the blob is detached.
+    zx::vmo vmo_ __TA_GUARDED(lock_);
+
+    // The device block at which the blob's Merkle tree starts. The data
+    // follows it, as it does in the VMO.
+    const uint64_t start_block_;
+    const uint64_t merkle_blocks_;
+    const uint64_t data_blocks_;
+    const uint64_t blob_size_;
+    // The blocks the data takes on disk, fewer than |data_blocks_| when the
+    // blob is compressed.
+    const uint64_t stored_blocks_;
+    const bool chunked_;
+    uint8_t digest_[digest::Digest::kLength];
+
+    // A copy of the Merkle tree, verified piecewise along with the data.
+    fbl::unique_ptr<uint8_t[]> merkle_;
+    size_t merkle_size_ = 0;
+
+    // The seek table of a blob compressed in chunks, read along with the
+    // Merkle tree.
+    ChunkedDecompressor chunks_;
+
+    // Decides how much more than each page request to supply, in bytes.
+    fs::Readahead readahead_ __TA_GUARDED(lock_);
+};
+
+// Demand pages uncompressed blobs and blobs compressed in chunks.
+//
+// A single thread reads the pages blobs are missing from disk, decompresses
+// them if need be, verifies them against the blob's Merkle tree and supplies
+// them to the blob's VMO.
+class BlobPager {
+public:
+    DISALLOW_COPY_ASSIGN_AND_MOVE(BlobPager);
+
+    static zx_status_t Create(Blobfs* blobfs, fbl::unique_ptr<BlobPager>* out);
+    ~BlobPager();
+
+    // Creates the VMO of the blob described by |inode| and |digest|, which
+    // must either be uncompressed or compressed in chunks. Its Merkle tree,
+    // and seek table if it has one, are read before this returns.
+    zx_status_t CreateBlob(const Inode& inode, const uint8_t* digest,
+                           fbl::RefPtr<PagedBlob>* out_blob, zx::vmo* out_vmo);
+
+private:
+    explicit BlobPager(Blobfs* blobfs);
+
+    // Reads the Merkle tree of |blob| into its copy of it, then supplies it
+    // to the VMO. Also reads the seek table of a blob compressed in chunks.
+    zx_status_t ReadMerkle(PagedBlob* blob) __TA_REQUIRES(blob->lock_);
+
+    // Reads, verifies and supplies the node aligned range of data which
+    // covers [offset, offset + length) of the VMO of |blob|.
+    zx_status_t SupplyData(PagedBlob* blob, uint64_t offset, uint64_t length)
+        __TA_REQUIRES(blob->lock_);
+
+    // Reads, decompresses, verifies and supplies the chunks of |blob| which
+    // cover the block aligned range [start, end) of its data.
+    zx_status_t SupplyChunks(PagedBlob* blob, uint64_t start, uint64_t end)
+        __TA_REQUIRES(blob->lock_);
+
+    // Serves page requests until the pager is destroyed.
+    static int PagerThread(void* arg);
+    void ServeRequests();
+
+    Blobfs* const blobfs_;
+    zx::port port_;
+    thrd_t thread_;
+    bool running_ = false;
+
+    // Holds the data being read on the pager thread. Its pages are moved into
+    // the blobs' VMOs.
+    fzl::OwnedVmoMapper buffer_;
+    vmoid_t buffer_vmoid_ = {};
+
+    // Holds the compressed chunks being read on the pager thread, which are
+    // decompressed into |buffer_|.
+    fzl::OwnedVmoMapper compressed_;
+    vmoid_t compressed_vmoid_ = {};
+};
+
+} // namespace blobfs
@@ -97,8 +97,9 @@ protected:
     // Activates the transaction.
     zx_status_t Flush();
 
-private:
     Blobfs* bs_;
+
+private:
     vmoid_t vmoid_;
     fbl::Vector<WriteRequest> requests_;
     size_t block_count_;
@@ -120,7 +121,7 @@ public:
     // Create a WritebackWork given a vnode (which may be null)
     // Vnode is stored for duration of txn so that it isn't destroyed during the write process
     WritebackWork(Blobfs* bs, fbl::RefPtr<VnodeBlob> vnode);
-    ~WritebackWork() = default;
+    ~WritebackWork();
 
     // Returns the WritebackWork to the default state that it was in
     // after being created. Takes in the |reason| it is being reset.
@@ -147,6 +148,12 @@ public:
     // Tells work to remove sync flag once the txn has successfully completed.
     void SetSyncComplete();
 
+    // Takes ownership of |source|, a VMO attached to the block device as |vmoid|,
+    // from which all requests of this work are written out directly rather than
+    // being copied into the writeback buffer. The VMO is detached and released
+    // once the work has been completed or reset.
+    void AdoptSource(fzl::OwnedVmoMapper source, vmoid_t vmoid);
+
     // Persists the enqueued work to disk,
     // and resets the WritebackWork to its initial state.
     zx_status_t Complete();
@@ -164,6 +171,10 @@ private:
 
     bool sync_;
     fbl::RefPtr<VnodeBlob> vn_;
+
+    // Optional VMO owned by the work, set by |AdoptSource|.
+    fzl::OwnedVmoMapper source_;
+    vmoid_t source_vmoid_ = VMOID_INVALID;
 };
 
 // In-memory data buffer.
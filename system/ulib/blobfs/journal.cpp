@@ -4,8 +4,13 @@
 
 #include <blobfs/journal.h>
 
+#include <threads.h>
+#include <time.h>
+
 #include <fbl/unique_ptr.h>
 #include <lib/cksum.h>
+#include <zircon/syscalls.h>
+#include <zircon/time.h>
 #include <zircon/types.h>
 
 namespace blobfs {
@@ -19,6 +24,22 @@ static int JournalThread(void* arg) {
     return 0;
 }
 
+// Waits on |cvar| until it is signalled, or until |deadline| has passed.
+static void WaitUntil(cnd_t* cvar, mtx_t* mutex, zx_time_t deadline) {
+    zx_duration_t timeout = zx_time_sub_time(deadline, zx_clock_get_monotonic());
+    if (timeout <= 0) {
+        return;
+    }
+
+    // The condition variable measures its deadline against the realtime clock.
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    uint64_t nsec = ts.tv_nsec + timeout;
+    ts.tv_sec += nsec / ZX_SEC(1);
+    ts.tv_nsec = nsec % ZX_SEC(1);
+    cnd_timedwait(cvar, mutex, &ts);
+}
+
 JournalEntry::JournalEntry(Journal* journal, EntryStatus status, size_t header_index,
                            size_t commit_index, fbl::unique_ptr<WritebackWork> work)
         : journal_(journal), status_(static_cast<uint32_t>(status)), block_count_(0),
@@ -77,20 +98,23 @@ ReadyCallback JournalEntry::CreateReadyCallback() {
 
 SyncCallback JournalEntry::CreateSyncCallback() {
     return [this] (zx_status_t status) {
-        EntryStatus last_status;
-        // The callback sets the state of the JournalEntry based on the status of writeback.
-        if (status == ZX_OK) {
-            last_status = SetStatus(EntryStatus::kPersisted);
-            ZX_DEBUG_ASSERT(last_status == EntryStatus::kWaiting);
-        } else {
-            SetStatus(EntryStatus::kError);
-        }
+        UpdateStatus(status);
 
         // Signal the journal that an entry is complete and ready for processing.
         journal_->SendSignal(status);
     };
 }
 
+void JournalEntry::UpdateStatus(zx_status_t status) {
+    // The callback sets the state of the JournalEntry based on the status of writeback.
+    if (status == ZX_OK) {
+        EntryStatus last_status = SetStatus(EntryStatus::kPersisted);
+        ZX_DEBUG_ASSERT(last_status == EntryStatus::kWaiting);
+    } else {
+        SetStatus(EntryStatus::kError);
+    }
+}
+
 void JournalEntry::SetChecksum(uint32_t checksum) {
     commit_block_.checksum = checksum;
 }
@@ -148,6 +172,7 @@ Journal::~Journal() {
     // Ensure that work and producer queues are currently empty.
     ZX_DEBUG_ASSERT(work_queue_.is_empty());
     ZX_DEBUG_ASSERT(producer_queue_.is_empty());
+    ZX_DEBUG_ASSERT(group_work_ == nullptr);
 }
 
 zx_status_t Journal::Load() {
@@ -279,6 +304,15 @@ zx_status_t Journal::Enqueue(fbl::unique_ptr<WritebackWork> work) {
 
     fbl::AutoLock lock(&lock_);
 
+    if (blocks == 0 ||
+        group_blocks_ + blocks + kEntryMetadataBlocks > MaxGroupBlocks() ||
+        !entries_->IsSpaceAvailable(blocks + kEntryMetadataBlocks)) {
+        // A sync request is only completed once every entry enqueued before it has been written
+        // out, and entries only leave the buffer once they have been written out, so neither
+        // should be left waiting for the current group to fill up.
+        CommitGroupLocked();
+    }
+
     zx_status_t status = ZX_OK;
     if (IsReadOnly()) {
         // If we are in "read only" mode, set an error status.
@@ -288,7 +322,7 @@ zx_status_t Journal::Enqueue(fbl::unique_ptr<WritebackWork> work) {
         // without enqueueing any data to the buffer.
 
         // Add 2 blocks to the block count for the journal entry's header/commit blocks.
-        blocks += 2;
+        blocks += kEntryMetadataBlocks;
 
         // Ensure we have enough space to write the current entry to the buffer.
         // If not, wait until space becomes available.
@@ -325,12 +359,10 @@ zx_status_t Journal::Enqueue(fbl::unique_ptr<WritebackWork> work) {
     if (entry->GetStatus() == EntryStatus::kInit) {
         // If we have a non-sync work, there is some extra preparation we need to do.
         if (status == ZX_OK) {
-            // Prepare a WritebackWork to write out the entry to disk. Note that this does not
-            // fully prepare the buffer for writeback, so a ready callback is added to the work as
-            // part of this step.
-            PrepareWork(entry.get(), &work);
-            ZX_DEBUG_ASSERT(work != nullptr);
-            status = EnqueueEntryWork(fbl::move(work));
+            // Add the entry to the group of entries which will be written out to disk together.
+            // This does not prepare the buffer for writeback, so the group's work is given a
+            // ready callback once the group is complete.
+            AddToGroupLocked(entry.get());
         } else {
             // If the status is not okay (i.e. we are in a readonly state), do no additional
             // processing but set the entry state to error.
@@ -352,6 +384,10 @@ void Journal::SendSignalLocked(zx_status_t status) {
         ZX_ASSERT(state_ != WritebackState::kReadOnly);
     } else {
         state_ = WritebackState::kReadOnly;
+
+        // Send the open group along to be failed by the writeback queue, rather than leaving its
+        // entries waiting for the group to fill up.
+        CommitGroupLocked();
     }
     consumer_signalled_ = true;
     cnd_signal(&consumer_cvar_);
@@ -375,28 +411,63 @@ fbl::unique_ptr<JournalEntry> Journal::CreateEntry(uint64_t header_index, uint64
                                           fbl::move(work));
 }
 
-void Journal::PrepareWork(JournalEntry* entry, fbl::unique_ptr<WritebackWork>* out) {
-    size_t header_index = entry->GetHeaderIndex();
-    size_t commit_index = entry->GetCommitIndex();
+void Journal::AddToGroupLocked(JournalEntry* entry) {
     size_t block_count = entry->BlockCount();
+    // Sync entries don't write anything to the journal.
+    ZX_DEBUG_ASSERT(block_count > 0);
 
-    if (block_count == 0) {
-        // If journal entry has size 0, it is an empty sync entry, and we don't need to write
-        // anything to the journal.
-        ZX_DEBUG_ASSERT(header_index == entries_->capacity());
-        ZX_DEBUG_ASSERT(commit_index == entries_->capacity());
-        return;
+    if (group_work_ == nullptr) {
+        group_work_ = CreateWork();
+        group_first_ = entry;
+        group_deadline_ = zx_deadline_after(kGroupCommitWindow);
+    } else {
+        group_last_->SetGroupNext(entry);
     }
+    group_last_ = entry;
+    group_entries_++;
+    group_blocks_ += block_count;
 
-    fbl::unique_ptr<WritebackWork> work = CreateWork();
+    // Entries are reserved one after another within the buffer, so the transactions of the
+    // group are merged into as few as possible.
+    AddEntryTransaction(entry->GetHeaderIndex(), block_count, group_work_.get());
+}
+
+zx_status_t Journal::CommitGroupLocked() {
+    if (group_work_ == nullptr) {
+        return ZX_OK;
+    }
 
-    // Update work with transactions for the current entry.
-    AddEntryTransaction(header_index, block_count, work.get());
+    fbl::unique_ptr<WritebackWork> work = fbl::move(group_work_);
+    JournalEntry* first = group_first_;
+
+    // Entries are prepared in order, so the group is ready once its last entry is ready.
+    work->SetReadyCallback(group_last_->CreateReadyCallback());
+    work->SetSyncCallback([this, first](zx_status_t status) {
+        // Once the first entry of the group has been updated it (and the entries after it) may
+        // be processed and released by the journal thread, so it is updated last.
+        JournalEntry* entry = first->GetGroupNext();
+        while (entry != nullptr) {
+            JournalEntry* next = entry->GetGroupNext();
+            entry->UpdateStatus(status);
+            entry = next;
+        }
+        first->UpdateStatus(status);
+
+        // Signal the journal that the group is complete and ready for processing.
+        SendSignal(status);
+    });
 
-    // Make sure the work is prepared for the writeback queue.
-    work->SetReadyCallback(entry->CreateReadyCallback());
-    work->SetSyncCallback(entry->CreateSyncCallback());
-    *out = fbl::move(work);
+    blobfs_->UpdateJournalMetrics(group_entries_);
+    group_first_ = nullptr;
+    group_last_ = nullptr;
+    group_entries_ = 0;
+    group_blocks_ = 0;
+
+    zx_status_t status = EnqueueEntryWork(fbl::move(work));
+    if (status != ZX_OK) {
+        SendSignalLocked(status);
+    }
+    return status;
 }
 
 void Journal::PrepareBuffer(JournalEntry* entry) {
@@ -784,9 +855,15 @@ void Journal::ProcessLoop() {
         // Signal the producer queue that space in the journal has (possibly) been freed up.
         cnd_signal(&producer_cvar_);
 
+        if (group_work_ != nullptr &&
+            (unmounting_ || zx_clock_get_monotonic() >= group_deadline_)) {
+            // No more entries are expected to join the open group before it is written out.
+            CommitGroupLocked();
+        }
+
         // Before waiting, we should check if we're unmounting.
         if (unmounting_ && work_queue_.is_empty() && processor.IsEmpty() &&
-            producer_queue_.is_empty()) {
+            producer_queue_.is_empty() && group_work_ == nullptr) {
             // Only return if we are unmounting AND all entries in all queues have been
             // processed. This includes producers which are currently waiting to be enqueued.
             break;
@@ -795,7 +872,12 @@ void Journal::ProcessLoop() {
         // If we received a signal while we were processing other queues,
         // immediately start processing again.
         if (!consumer_signalled_) {
-            cnd_wait(&consumer_cvar_, lock_.GetInternal());
+            if (group_work_ != nullptr) {
+                // Wake up to write out the open group once its window has passed.
+                WaitUntil(&consumer_cvar_, lock_.GetInternal(), group_deadline_);
+            } else {
+                cnd_wait(&consumer_cvar_, lock_.GetInternal());
+            }
         }
 
         consumer_signalled_ = false;
@@ -35,9 +35,13 @@ void BlobfsMetrics::Dump() const {
     printf("  (Writeback Thread) Wrote %zu MB of data in %zu ms\n",
            total_writeback_bytes_written / mb,
            TicksToMs(total_writeback_time_ticks));
+    printf("  (Journal Thread) Wrote %zu journal entries in %zu writes\n",
+           journal_entries_written, journal_groups_written);
     printf("Lookup Info:\n");
     printf("  Opened %zu blobs (%zu MB)\n", blobs_opened,
            blobs_opened_total_size / mb);
+    printf("  Reopened %zu closed blobs from memory, %zu from disk, evicted %zu\n",
+           blob_cache_hits, blob_cache_misses, blob_cache_evictions);
     printf("  Verified %zu blobs (%zu MB data, %zu MB merkle)\n",
            blobs_verified, blobs_verified_total_size_data / mb,
            blobs_verified_total_size_merkle / mb);
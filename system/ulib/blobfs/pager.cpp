@@ -0,0 +1,383 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string.h>
+
+#include <digest/digest.h>
+#include <digest/merkle-tree.h>
+#include <fbl/algorithm.h>
+#include <fbl/alloc_checker.h>
+#include <fbl/auto_lock.h>
+#include <fs/block-txn.h>
+#include <fs/trace.h>
+#include <trace/event.h>
+#include <zircon/status.h>
+#include <zircon/syscalls/port.h>
+
+#include <blobfs/blobfs.h>
+#include <blobfs/pager.h>
+
+using digest::Digest;
+using digest::MerkleTree;
+
+namespace blobfs {
+namespace {
+
+// The most data read for a single request at once.
+constexpr uint64_t kBufferBlocks = 32;
+constexpr uint64_t kBufferSize = kBufferBlocks * kBlobfsBlockSize;
+
+// The most chunks decompressed for a single request at once. They are
+// stored in no more than the space they decompress to, plus the blocks their
+// ends share with neighbouring chunks.
+constexpr uint64_t kBufferChunks = kBufferSize / kChunkSize;
+constexpr uint64_t kCompressedBufferBlocks = kBufferBlocks + 1;
+
+// How far ahead of page requests which follow one another pages are supplied.
+// The window grows from a few blocks up to a whole buffer, so that a blob
+// which is read from start to end is read in buffer sized requests without
+// holding up the pager thread for long at a time.
+constexpr uint64_t kMinReadaheadBytes = 4 * kBlobfsBlockSize;
+constexpr uint64_t kMaxReadaheadBytes = kBufferSize;
+
+// Reading whole blocks also verifies whole nodes of the Merkle tree.
+static_assert(kBlobfsBlockSize % MerkleTree::kNodeSize == 0,
+              "Blocks must hold whole Merkle tree nodes");
+static_assert(kBlobfsBlockSize % PAGE_SIZE == 0, "Blocks must hold whole pages");
+static_assert(kBufferSize % kChunkSize == 0, "The buffer must hold whole chunks");
+
+} // namespace
+
+PagedBlob::PagedBlob(uint64_t start_block, const Inode& inode, const uint8_t* digest)
+    : start_block_(start_block), merkle_blocks_(MerkleTreeBlocks(inode)),
+      data_blocks_(BlobDataBlocks(inode)), blob_size_(inode.blob_size),
+      stored_blocks_(inode.num_blocks - merkle_blocks_),
+      chunked_((inode.flags & kBlobFlagChunkCompressed) != 0),
+      readahead_(kMinReadaheadBytes, kMaxReadaheadBytes, merkle_blocks_ * kBlobfsBlockSize) {
+    memcpy(digest_, digest, sizeof(digest_));
+}
+
+void PagedBlob::Detach() {
+    fbl::AutoLock lock(&lock_);
+    // Closing the VMO lets the kernel destroy it once it has no other users,
+    // and closing the pager fails anyone that is still waiting for a page.
+    vmo_.reset();
+    pager_.reset();
+}
+
+BlobPager::BlobPager(Blobfs* blobfs) : blobfs_(blobfs) {}
+
+BlobPager::~BlobPager() {
+    if (running_) {
+        zx_port_packet_t packet = {};
+        packet.type = ZX_PKT_TYPE_USER;
+        zx_status_t status = port_.queue(&packet);
+        ZX_ASSERT(status == ZX_OK);
+        thrd_join(thread_, nullptr);
+    }
+    if (buffer_vmoid_ != VMOID_INVALID) {
+        blobfs_->DetachVmo(buffer_vmoid_);
+    }
+    if (compressed_vmoid_ != VMOID_INVALID) {
+        blobfs_->DetachVmo(compressed_vmoid_);
+    }
+}
+
+zx_status_t BlobPager::Create(Blobfs* blobfs, fbl::unique_ptr<BlobPager>* out) {
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<BlobPager> pager(new (&ac) BlobPager(blobfs));
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+
+    zx_status_t status;
+    if ((status = zx::port::create(0, &pager->port_)) != ZX_OK) {
+        return status;
+    } else if ((status = pager->buffer_.CreateAndMap(kBufferSize, "blobfs-pager")) != ZX_OK) {
+        return status;
+    } else if ((status = blobfs->AttachVmo(pager->buffer_.vmo().get(),
+                                           &pager->buffer_vmoid_)) != ZX_OK) {
+        return status;
+    } else if ((status = pager->compressed_.CreateAndMap(
+                    kCompressedBufferBlocks * kBlobfsBlockSize, "blobfs-pager-compressed")) !=
+               ZX_OK) {
+        return status;
+    } else if ((status = blobfs->AttachVmo(pager->compressed_.vmo().get(),
+                                           &pager->compressed_vmoid_)) != ZX_OK) {
+        return status;
+    }
+
+    if (thrd_create_with_name(&pager->thread_, BlobPager::PagerThread, pager.get(),
+                              "blobfs-pager") != thrd_success) {
+        return ZX_ERR_NO_RESOURCES;
+    }
+    pager->running_ = true;
+
+    *out = fbl::move(pager);
+    return ZX_OK;
+}
+
+zx_status_t BlobPager::CreateBlob(const Inode& inode, const uint8_t* digest,
+                                  fbl::RefPtr<PagedBlob>* out_blob, zx::vmo* out_vmo) {
+    TRACE_DURATION("blobfs", "BlobPager::CreateBlob", "size", inode.blob_size);
+    ZX_DEBUG_ASSERT((inode.flags & kBlobFlagLZ4Compressed) == 0);
+
+    fbl::AllocChecker ac;
+    uint64_t start_block = inode.start_block + DataStartBlock(blobfs_->Info());
+    fbl::RefPtr<PagedBlob> blob = fbl::AdoptRef(new (&ac) PagedBlob(start_block, inode, digest));
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    const uint64_t vmo_size = (blob->merkle_blocks_ + blob->data_blocks_) * kBlobfsBlockSize;
+
+    fbl::AutoLock lock(&blob->lock_);
+    zx::vmo vmo;
+    zx_status_t status;
+    if ((status = zx::pager::create(0, &blob->pager_)) != ZX_OK) {
+        return status;
+    } else if ((status = blob->pager_.create_vmo(port_, reinterpret_cast<uintptr_t>(blob.get()),
+                                                 vmo_size, 0, &vmo)) != ZX_OK) {
+        return status;
+    }
+
+    // Requests for the VMO identify the blob by address, so the port keeps a
+    // reference to it until the ZX_PAGER_VMO_COMPLETE packet arrives.
+    blob->AddRef();
+
+    if ((status = vmo.duplicate(ZX_RIGHT_SAME_RIGHTS, &blob->vmo_)) != ZX_OK ||
+        (status = ReadMerkle(blob.get())) != ZX_OK) {
+        blob->vmo_.reset();
+        blob->pager_.reset();
+        return status;
+    }
+
+    *out_blob = fbl::move(blob);
+    *out_vmo = fbl::move(vmo);
+    return ZX_OK;
+}
+
+zx_status_t BlobPager::ReadMerkle(PagedBlob* blob) {
+    // The seek table follows the Merkle tree.
+    const uint64_t table_blocks = blob->chunked_ ?
+        fbl::min(fbl::round_up(ChunkedMetadataSize(blob->blob_size_),
+                               kBlobfsBlockSize) / kBlobfsBlockSize, blob->stored_blocks_) : 0;
+    if (blob->merkle_blocks_ + table_blocks == 0) {
+        // Blobs which fit in a single node are verified against the root digest alone.
+        return ZX_OK;
+    }
+
+    const uint64_t merkle_bytes = blob->merkle_blocks_ * kBlobfsBlockSize;
+    fzl::OwnedVmoMapper mapper;
+    zx_status_t status = mapper.CreateAndMap(merkle_bytes + table_blocks * kBlobfsBlockSize,
+                                             "blob-merkle");
+    if (status != ZX_OK) {
+        return status;
+    }
+    vmoid_t vmoid;
+    if ((status = blobfs_->AttachVmo(mapper.vmo().get(), &vmoid)) != ZX_OK) {
+        return status;
+    }
+
+    fs::ReadTxn txn(blobfs_);
+    txn.Enqueue(vmoid, 0, blob->start_block_, blob->merkle_blocks_ + table_blocks);
+    status = txn.Transact();
+    blobfs_->DetachVmo(vmoid);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    if (blob->chunked_) {
+        status = blob->chunks_.Init(static_cast<const uint8_t*>(mapper.start()) + merkle_bytes,
+                                    table_blocks * kBlobfsBlockSize,
+                                    blob->stored_blocks_ * kBlobfsBlockSize, blob->blob_size_);
+        if (status != ZX_OK) {
+            return status;
+        }
+    }
+    if (blob->merkle_blocks_ == 0) {
+        return ZX_OK;
+    }
+
+    // The tree is verified piecewise, along with the data it covers.
+    blob->merkle_size_ = MerkleTree::GetTreeLength(blob->blob_size_);
+    fbl::AllocChecker ac;
+    blob->merkle_.reset(new (&ac) uint8_t[blob->merkle_size_]);
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    memcpy(blob->merkle_.get(), mapper.start(), blob->merkle_size_);
+
+    return blob->pager_.supply_pages(blob->vmo_, 0, merkle_bytes, mapper.vmo(), 0);
+}
+
+zx_status_t BlobPager::SupplyData(PagedBlob* blob, uint64_t offset, uint64_t length) {
+    TRACE_DURATION("blobfs", "BlobPager::SupplyData", "offset", offset, "length", length);
+
+    // The Merkle tree was supplied along with the VMO, so only the data that
+    // follows it is ever requested.
+    const uint64_t data_vmo_offset = blob->merkle_blocks_ * kBlobfsBlockSize;
+    const uint64_t data_bytes = blob->data_blocks_ * kBlobfsBlockSize;
+    if (offset < data_vmo_offset || offset - data_vmo_offset >= data_bytes) {
+        return ZX_ERR_OUT_OF_RANGE;
+    }
+    uint64_t start = fbl::round_down(offset - data_vmo_offset, kBlobfsBlockSize);
+    const uint64_t end = fbl::min(fbl::round_up(offset - data_vmo_offset + length,
+                                                kBlobfsBlockSize), data_bytes);
+    if (blob->chunked_) {
+        return SupplyChunks(blob, start, end);
+    }
+
+    Digest digest(blob->digest_);
+    while (start < end) {
+        const uint64_t chunk = fbl::min(end - start, kBufferSize);
+
+        fs::ReadTxn txn(blobfs_);
+        txn.Enqueue(buffer_vmoid_, 0,
+                    blob->start_block_ + blob->merkle_blocks_ + start / kBlobfsBlockSize,
+                    chunk / kBlobfsBlockSize);
+        zx_status_t status = txn.Transact();
+        if (status != ZX_OK) {
+            return status;
+        }
+
+        // The tail of the last block isn't part of the blob, so there is
+        // nothing to verify it against.
+        if (start < blob->blob_size_) {
+            // Verify() indexes |data| with offsets into the blob, but only
+            // reads the nodes it is asked to verify, which is what the buffer
+            // holds.
+            const uint8_t* data = static_cast<const uint8_t*>(buffer_.start()) - start;
+            status = MerkleTree::Verify(data, blob->blob_size_, blob->merkle_.get(),
+                                        blob->merkle_size_, start,
+                                        fbl::min(chunk, blob->blob_size_ - start), digest);
+            if (status != ZX_OK) {
+                return status;
+            }
+        }
+
+        status = blob->pager_.supply_pages(blob->vmo_, data_vmo_offset + start, chunk,
+                                           buffer_.vmo(), 0);
+        if (status != ZX_OK) {
+            return status;
+        }
+        start += chunk;
+    }
+    return ZX_OK;
+}
+
+zx_status_t BlobPager::SupplyChunks(PagedBlob* blob, uint64_t start, uint64_t end) {
+    TRACE_DURATION("blobfs", "BlobPager::SupplyChunks", "start", start, "end", end);
+    const uint64_t data_vmo_offset = blob->merkle_blocks_ * kBlobfsBlockSize;
+    const uint64_t compressed_start_block = blob->start_block_ + blob->merkle_blocks_;
+    uint8_t* buffer = static_cast<uint8_t*>(buffer_.start());
+
+    uint64_t first, last;
+    blob->chunks_.ChunksFor(start, end - start, &first, &last);
+    Digest digest(blob->digest_);
+    while (first <= last) {
+        const uint64_t group_last = fbl::min(last, first + kBufferChunks - 1);
+
+        // Read the blocks holding the compressed chunks.
+        uint64_t compressed_offset, compressed_length;
+        blob->chunks_.CompressedRange(first, group_last, &compressed_offset, &compressed_length);
+        const uint64_t block = compressed_offset / kBlobfsBlockSize;
+        const uint64_t blocks = fbl::round_up(compressed_offset + compressed_length,
+                                              kBlobfsBlockSize) / kBlobfsBlockSize - block;
+        ZX_DEBUG_ASSERT(blocks <= kCompressedBufferBlocks);
+        fs::ReadTxn txn(blobfs_);
+        txn.Enqueue(compressed_vmoid_, 0, compressed_start_block + block, blocks);
+        zx_status_t status = txn.Transact();
+        if (status != ZX_OK) {
+            return status;
+        }
+
+        for (uint64_t i = first; i <= group_last; i++) {
+            status = blob->chunks_.DecompressChunk(i, compressed_.start(),
+                                                   block * kBlobfsBlockSize,
+                                                   buffer + (i - first) * kChunkSize);
+            if (status != ZX_OK) {
+                return status;
+            }
+        }
+
+        // The last chunk ends with the blob, and the rest of its last block
+        // is supplied as zeroes.
+        const uint64_t data_start = first * kChunkSize;
+        const uint64_t data_end = fbl::min((group_last + 1) * kChunkSize, blob->blob_size_);
+        const uint64_t supply_length = fbl::round_up(data_end, kBlobfsBlockSize) - data_start;
+        memset(buffer + data_end - data_start, 0, supply_length - (data_end - data_start));
+
+        const uint8_t* data = buffer - data_start;
+        status = MerkleTree::Verify(data, blob->blob_size_, blob->merkle_.get(),
+                                    blob->merkle_size_, data_start, data_end - data_start,
+                                    digest);
+        if (status != ZX_OK) {
+            return status;
+        }
+
+        status = blob->pager_.supply_pages(blob->vmo_, data_vmo_offset + data_start,
+                                           supply_length, buffer_.vmo(), 0);
+        if (status != ZX_OK) {
+            return status;
+        }
+        first = group_last + 1;
+    }
+    return ZX_OK;
+}
+
+int BlobPager::PagerThread(void* arg) {
+    static_cast<BlobPager*>(arg)->ServeRequests();
+    return 0;
+}
+
+void BlobPager::ServeRequests() {
+    for (;;) {
+        zx_port_packet_t packet;
+        zx_status_t status = port_.wait(zx::time::infinite(), &packet);
+        if (status != ZX_OK) {
+            FS_TRACE_ERROR("blobfs: Failed to wait for page requests: %d\n", status);
+            return;
+        }
+        if (packet.type == ZX_PKT_TYPE_USER) {
+            // Queued by the destructor.
+            return;
+        }
+        if (packet.type != ZX_PKT_TYPE_PAGE_REQUEST) {
+            continue;
+        }
+
+        PagedBlob* blob = reinterpret_cast<PagedBlob*>(packet.key);
+        switch (packet.page_request.command) {
+        case ZX_PAGER_VMO_READ: {
+            fbl::AutoLock lock(&blob->lock_);
+            if (!blob->vmo_) {
+                // The request raced with the blob being detached.
+                break;
+            }
+            // SupplyData() stops the readahead at the end of the blob.
+            const uint64_t offset = packet.page_request.offset;
+            const uint64_t length = blob->readahead_.Advance(offset,
+                                                             packet.page_request.length);
+            status = SupplyData(blob, offset, length);
+            if (status != ZX_OK) {
+                FS_TRACE_ERROR("blobfs: Failed to page in blob: %s\n",
+                               zx_status_get_string(status));
+                // Nothing else will supply the missing pages, so fail every
+                // access to them rather than letting it wait forever.
+                blob->vmo_.reset();
+                blob->pager_.reset();
+            }
+            break;
+        }
+        case ZX_PAGER_VMO_COMPLETE:
+            // Drops the reference CreateBlob() handed to the port.
+            if (blob->Release()) {
+                delete blob;
+            }
+            break;
+        }
+    }
+}
+
+} // namespace blobfs
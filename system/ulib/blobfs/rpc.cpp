@@ -32,6 +32,10 @@ zx_status_t VnodeBlob::GetHandles(uint32_t flags, zx_handle_t* hnd, uint32_t* ty
     if (r < 0) {
         return r;
     }
+    if (GetState() == kBlobStateReadable && !(flags & ZX_FS_RIGHT_WRITABLE)) {
+        // Readable blobs never change, so clients may read them from the VMO.
+        extra->file.flags = fuchsia_io_FILE_FLAG_IMMUTABLE;
+    }
 
     return ZX_OK;
 }
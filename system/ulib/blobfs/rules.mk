@@ -13,6 +13,7 @@ MODULE_NAME := blobfs
 MODULE_COMPILEFLAGS += -fvisibility=hidden
 
 COMMON_SRCS := \
+    $(LOCAL_DIR)/chunked.cpp \
     $(LOCAL_DIR)/common.cpp \
     $(LOCAL_DIR)/fsck.cpp \
     $(LOCAL_DIR)/lz4.cpp \
@@ -21,8 +22,10 @@ COMMON_SRCS := \
 MODULE_SRCS := \
     $(COMMON_SRCS) \
     $(LOCAL_DIR)/blobfs.cpp \
+    $(LOCAL_DIR)/extent-index.cpp \
     $(LOCAL_DIR)/journal.cpp \
     $(LOCAL_DIR)/metrics.cpp \
+    $(LOCAL_DIR)/pager.cpp \
     $(LOCAL_DIR)/rpc.cpp \
     $(LOCAL_DIR)/vnode.cpp \
     $(LOCAL_DIR)/writeback.cpp \
@@ -42,10 +42,15 @@ void VnodeBlob::fbl_recycle() {
 
 void VnodeBlob::TearDown() {
     ZX_ASSERT(clone_watcher_.object() == ZX_HANDLE_INVALID);
-    if (mapping_.vmo()) {
+    if (paged_) {
+        paged_->Detach();
+        paged_.reset();
+    } else if (mapping_.vmo()) {
         blobfs_->DetachVmo(vmoid_);
     }
     mapping_.Reset();
+    // The data is read and verified again if the blob is reopened.
+    verified_.Reset(0);
 }
 
 VnodeBlob::~VnodeBlob() {
@@ -133,6 +133,13 @@ void WritebackWork::SetSyncComplete() {
     sync_ = true;
 }
 
+void WritebackWork::AdoptSource(fzl::OwnedVmoMapper source, vmoid_t vmoid) {
+    ZX_DEBUG_ASSERT(source_vmoid_ == VMOID_INVALID);
+    ZX_DEBUG_ASSERT(vmoid != VMOID_INVALID);
+    source_ = fbl::move(source);
+    source_vmoid_ = vmoid;
+}
+
 // Returns the number of blocks of the writeback buffer that have been consumed
 zx_status_t WritebackWork::Complete() {
     zx_status_t status = Flush();
@@ -149,6 +156,10 @@ zx_status_t WritebackWork::Complete() {
 WritebackWork::WritebackWork(Blobfs* bs, fbl::RefPtr<VnodeBlob> vn) :
     WriteTxn(bs), ready_cb_(nullptr), sync_cb_(nullptr), sync_(false), vn_(fbl::move(vn)) {}
 
+WritebackWork::~WritebackWork() {
+    ResetInternal();
+}
+
 void WritebackWork::InvokeSyncCallback(zx_status_t status) {
     if (sync_cb_) {
         sync_cb_(status);
@@ -159,6 +170,11 @@ void WritebackWork::ResetInternal() {
     sync_cb_ = nullptr;
     ready_cb_ = nullptr;
     vn_ = nullptr;
+    if (source_vmoid_ != VMOID_INVALID) {
+        bs_->DetachVmo(source_vmoid_);
+        source_vmoid_ = VMOID_INVALID;
+        source_.Reset();
+    }
 }
 
 Buffer::~Buffer() {
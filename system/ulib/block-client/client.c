@@ -3,14 +3,23 @@
 // found in the LICENSE file.
 
 #include <assert.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <threads.h>
 #include <unistd.h>
 
 #include <block-client/client.h>
 #include <zircon/compiler.h>
 #include <zircon/device/block.h>
+#include <zircon/process.h>
 #include <zircon/syscalls.h>
 #include <lib/sync/completion.h>
 
+// Raised on our own end of the first fifo to stop the polling thread.
+#define SIGNAL_POLL_SHUTDOWN ZX_USER_SIGNAL_1
+
+static_assert(sizeof(block_completion_ring_t) <= PAGE_SIZE, "");
+
 // Writes on a FIFO, repeating the write later if the FIFO is full.
 static zx_status_t do_write(zx_handle_t fifo, block_fifo_request_t* request, size_t count) {
     zx_status_t status;
@@ -61,12 +70,24 @@ static zx_status_t do_read(zx_handle_t fifo, block_fifo_response_t* response) {
 
 typedef struct block_completion {
     sync_completion_t completion;
+    // Set along with |completion|, for waiters that spin before they sleep.
+    atomic_bool done;
     zx_status_t status;
 } block_sync_completion_t;
 
 typedef struct fifo_client {
-    zx_handle_t fifo;
-    block_sync_completion_t groups[MAX_TXN_GROUP_COUNT];
+    // One fifo from IOCTL_BLOCK_GET_FIFOS, then those from IOCTL_BLOCK_ADD_FIFO.
+    zx_handle_t fifos[BLOCK_FIFO_MAX_SESSIONS];
+    size_t fifo_count;
+    // Group |g| is group |g % MAX_TXN_GROUP_COUNT| of fifo |g / MAX_TXN_GROUP_COUNT|.
+    block_sync_completion_t groups[BLOCK_FIFO_MAX_SESSIONS * MAX_TXN_GROUP_COUNT];
+
+    // With polling enabled, the completion ring of the first fifo, which
+    // the polling thread consumes, and how long to spin before sleeping.
+    block_completion_ring_t* ring;
+    uint64_t ring_tail;
+    zx_duration_t spin;
+    thrd_t poller;
 } fifo_client_t;
 
 zx_status_t block_fifo_create_client(zx_handle_t fifo, fifo_client_t** out) {
@@ -75,17 +96,159 @@ zx_status_t block_fifo_create_client(zx_handle_t fifo, fifo_client_t** out) {
         zx_handle_close(fifo);
         return ZX_ERR_NO_MEMORY;
     }
-    client->fifo = fifo;
+    client->fifos[0] = fifo;
+    client->fifo_count = 1;
     *out = client;
     return ZX_OK;
 }
 
+zx_status_t block_fifo_add_fifo(fifo_client_t* client, zx_handle_t fifo) {
+    if (client->fifo_count == BLOCK_FIFO_MAX_SESSIONS) {
+        zx_handle_close(fifo);
+        return ZX_ERR_NO_RESOURCES;
+    }
+    client->fifos[client->fifo_count++] = fifo;
+    return ZX_OK;
+}
+
+size_t block_fifo_group_count(const fifo_client_t* client) {
+    return client->fifo_count * MAX_TXN_GROUP_COUNT;
+}
+
+static void complete_group(fifo_client_t* client, size_t group, zx_status_t status) {
+    if (group >= MAX_TXN_GROUP_COUNT) {
+        // Only the first fifo is polled.
+        return;
+    }
+    client->groups[group].status = status;
+    atomic_store(&client->groups[group].done, true);
+    sync_completion_signal(&client->groups[group].completion);
+}
+
+// Completes the groups whose responses have been posted to the ring.
+// Returns false if there were none.
+static bool ring_consume(fifo_client_t* client) {
+    block_completion_ring_t* ring = client->ring;
+    uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    uint64_t tail = client->ring_tail;
+    if (head == tail) {
+        return false;
+    }
+    for (; tail != head; tail++) {
+        const block_fifo_response_t* response =
+                &ring->responses[tail % BLOCK_COMPLETION_RING_SIZE];
+        complete_group(client, response->group, response->status);
+    }
+    client->ring_tail = tail;
+    __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+    return true;
+}
+
+static int poll_thread(void* arg) {
+    fifo_client_t* client = arg;
+    zx_handle_t fifo = client->fifos[0];
+    block_completion_ring_t* ring = client->ring;
+
+    while (true) {
+        zx_time_t deadline = zx_deadline_after(client->spin);
+        while (zx_clock_get_monotonic() < deadline) {
+            if (ring_consume(client)) {
+                deadline = zx_deadline_after(client->spin);
+            }
+        }
+
+        // Nothing for a while: sleep until the server wakes us, or until a
+        // response shows up on the fifo instead.
+        zx_object_signal(fifo, BLOCK_COMPLETION_RING_SIGNAL, 0);
+        __atomic_store_n(&ring->waiting, 1, __ATOMIC_SEQ_CST);
+        zx_signals_t seen = 0;
+        zx_status_t status = ZX_OK;
+        if (!ring_consume(client)) {
+            status = zx_object_wait_one(fifo, BLOCK_COMPLETION_RING_SIGNAL | ZX_FIFO_READABLE |
+                                        ZX_FIFO_PEER_CLOSED | SIGNAL_POLL_SHUTDOWN,
+                                        ZX_TIME_INFINITE, &seen);
+        }
+        __atomic_store_n(&ring->waiting, 0, __ATOMIC_RELAXED);
+
+        if (seen & SIGNAL_POLL_SHUTDOWN) {
+            return 0;
+        }
+        block_fifo_response_t response;
+        while (zx_fifo_read(fifo, sizeof(response), &response, 1, NULL) == ZX_OK) {
+            complete_group(client, response.group, response.status);
+        }
+        if ((status != ZX_OK) || (seen & ZX_FIFO_PEER_CLOSED)) {
+            ring_consume(client);
+            for (size_t i = 0; i < MAX_TXN_GROUP_COUNT; i++) {
+                complete_group(client, i, ZX_ERR_PEER_CLOSED);
+            }
+            return 0;
+        }
+    }
+}
+
+zx_status_t block_fifo_enable_polling(fifo_client_t* client, int fd, zx_duration_t spin) {
+    if (client->ring != NULL) {
+        return ZX_ERR_ALREADY_BOUND;
+    }
+
+    zx_handle_t vmo;
+    zx_status_t status;
+    if ((status = zx_vmo_create(PAGE_SIZE, ZX_VMO_NON_RESIZABLE, &vmo)) != ZX_OK) {
+        return status;
+    }
+    uintptr_t addr;
+    if ((status = zx_vmar_map(zx_vmar_root_self(), ZX_VM_PERM_READ | ZX_VM_PERM_WRITE,
+                              0, vmo, 0, PAGE_SIZE, &addr)) != ZX_OK) {
+        zx_handle_close(vmo);
+        return status;
+    }
+    client->ring = (block_completion_ring_t*)addr;
+    client->ring_tail = 0;
+    client->spin = spin;
+
+    // The thread must be there, polling, before the server posts to the ring.
+    if (thrd_create(&client->poller, poll_thread, client) != thrd_success) {
+        status = ZX_ERR_NO_MEMORY;
+        goto fail;
+    }
+
+    zx_handle_t dup;
+    if ((status = zx_handle_duplicate(vmo, ZX_RIGHT_SAME_RIGHTS, &dup)) != ZX_OK) {
+        goto fail_thread;
+    }
+    ssize_t r = ioctl_block_attach_completion_ring(fd, &dup);
+    if (r < 0) {
+        status = (zx_status_t)r;
+        goto fail_thread;
+    }
+    zx_handle_close(vmo);
+    return ZX_OK;
+
+fail_thread:
+    zx_object_signal(client->fifos[0], 0, SIGNAL_POLL_SHUTDOWN);
+    thrd_join(client->poller, NULL);
+    zx_object_signal(client->fifos[0], SIGNAL_POLL_SHUTDOWN, 0);
+fail:
+    zx_vmar_unmap(zx_vmar_root_self(), addr, PAGE_SIZE);
+    zx_handle_close(vmo);
+    client->ring = NULL;
+    return status;
+}
+
 void block_fifo_release_client(fifo_client_t* client) {
     if (client == NULL) {
         return;
     }
 
-    zx_handle_close(client->fifo);
+    if (client->ring != NULL) {
+        zx_object_signal(client->fifos[0], 0, SIGNAL_POLL_SHUTDOWN);
+        thrd_join(client->poller, NULL);
+        zx_vmar_unmap(zx_vmar_root_self(), (uintptr_t)client->ring, PAGE_SIZE);
+    }
+    for (size_t i = 0; i < client->fifo_count; i++) {
+        zx_handle_close(client->fifos[i]);
+    }
     free(client);
 }
 
@@ -95,32 +258,52 @@ zx_status_t block_fifo_txn(fifo_client_t* client, block_fifo_request_t* requests
     }
 
     groupid_t group = requests[0].group;
-    assert(group < MAX_TXN_GROUP_COUNT);
+    assert(group < block_fifo_group_count(client));
     sync_completion_reset(&client->groups[group].completion);
+    atomic_store(&client->groups[group].done, false);
     client->groups[group].status = ZX_ERR_IO;
 
+    size_t session = group / MAX_TXN_GROUP_COUNT;
+    zx_handle_t fifo = client->fifos[session];
+    bool polled = (session == 0) && (client->ring != NULL);
     zx_status_t status;
     for (size_t i = 0; i < count; i++) {
         assert(requests[i].group == group);
+        requests[i].group = group % MAX_TXN_GROUP_COUNT;
         requests[i].opcode = (requests[i].opcode & BLOCKIO_OP_MASK) | BLOCKIO_GROUP_ITEM;
     }
 
     requests[0].opcode |= BLOCKIO_BARRIER_BEFORE;
     requests[count - 1].opcode |= BLOCKIO_GROUP_LAST | BLOCKIO_BARRIER_AFTER;
 
-    if ((status = do_write(client->fifo, &requests[0], count)) != ZX_OK) {
+    status = do_write(fifo, &requests[0], count);
+    for (size_t i = 0; i < count; i++) {
+        requests[i].group = group;
+    }
+    if (status != ZX_OK) {
         return status;
     }
 
+    if (polled) {
+        // The polling thread reads the responses; spin for ours for a while
+        // before going to sleep.
+        zx_time_t deadline = zx_deadline_after(client->spin);
+        while (!atomic_load(&client->groups[group].done) &&
+               (zx_clock_get_monotonic() < deadline)) {
+        }
+        sync_completion_wait(&client->groups[group].completion, ZX_TIME_INFINITE);
+        return client->groups[group].status;
+    }
+
     // As expected by the protocol, when we send one "BLOCKIO_GROUP_LAST" message, we
     // must read a reply message.
     block_fifo_response_t response;
-    if ((status = do_read(client->fifo, &response)) != ZX_OK) {
+    if ((status = do_read(fifo, &response)) != ZX_OK) {
         return status;
     }
 
     // Wake up someone who is waiting (it might be ourselves)
-    groupid_t response_group = response.group;
+    size_t response_group = session * MAX_TXN_GROUP_COUNT + response.group;
     client->groups[response_group].status = response.status;
     sync_completion_signal(&client->groups[response_group].completion);
 
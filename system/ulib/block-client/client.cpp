@@ -38,6 +38,21 @@ zx_status_t Client::Create(zx::fifo fifo, Client* out) {
     return ZX_OK;
 }
 
+zx_status_t Client::AddFifo(zx::fifo fifo) {
+    ZX_DEBUG_ASSERT(client_ != nullptr);
+    return block_fifo_add_fifo(client_, fifo.release());
+}
+
+zx_status_t Client::EnablePolling(int fd, zx::duration spin) {
+    ZX_DEBUG_ASSERT(client_ != nullptr);
+    return block_fifo_enable_polling(client_, fd, spin.get());
+}
+
+size_t Client::GroupCount() const {
+    ZX_DEBUG_ASSERT(client_ != nullptr);
+    return block_fifo_group_count(client_);
+}
+
 zx_status_t Client::Transaction(block_fifo_request_t* requests, size_t count) const {
     ZX_DEBUG_ASSERT(client_ != nullptr);
     return block_fifo_txn(client_, requests, count);
@@ -21,6 +21,25 @@ typedef struct fifo_client fifo_client_t;
 // Valid groups are in the range [0, MAX_TXN_GROUP_COUNT).
 zx_status_t block_fifo_create_client(zx_handle_t fifo, fifo_client_t** out);
 
+// Adds a fifo from IOCTL_BLOCK_ADD_FIFO to a block fifo client, which
+// takes ownership of |fifo|. Each fifo brings MAX_TXN_GROUP_COUNT more
+// groups, whose transactions are served on the device side by a thread
+// of their own. Must not be called concurrently with transactions.
+zx_status_t block_fifo_add_fifo(fifo_client_t* client, zx_handle_t fifo);
+
+// Has the server behind |fd| post the responses to transactions on the
+// client's first fifo to a completion ring in shared memory, and starts a
+// thread which collects them, spinning on the ring for up to |spin| before
+// it sleeps on the fifo. Transactions on the first fifo also spin for up to
+// |spin| for their response before they sleep. This trades a core per
+// client for lower latency on small transactions.
+// Must not be called concurrently with transactions.
+zx_status_t block_fifo_enable_polling(fifo_client_t* client, int fd, zx_duration_t spin);
+
+// The groups a block fifo client may use are in the range
+// [0, block_fifo_group_count(client)), MAX_TXN_GROUP_COUNT per fifo.
+size_t block_fifo_group_count(const fifo_client_t* client);
+
 // Frees a block fifo client.
 void block_fifo_release_client(fifo_client_t* client);
 
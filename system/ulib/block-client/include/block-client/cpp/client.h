@@ -14,6 +14,7 @@
 #include <fbl/macros.h>
 #include <fbl/type_support.h>
 #include <lib/zx/fifo.h>
+#include <lib/zx/time.h>
 #include <zircon/types.h>
 
 namespace block_client {
@@ -39,6 +40,18 @@ public:
     // will make |out| a valid Client.
     static zx_status_t Create(zx::fifo fifo, Client* out);
 
+    // Adds a fifo from IOCTL_BLOCK_ADD_FIFO, and the groups that come
+    // with it. Must not be called concurrently with transactions.
+    zx_status_t AddFifo(zx::fifo fifo);
+
+    // Collects the responses on the first fifo from a completion ring
+    // shared with the device behind |fd|, polling it for up to |spin|
+    // before sleeping. Must not be called concurrently with transactions.
+    zx_status_t EnablePolling(int fd, zx::duration spin);
+
+    // Groups the client may use are in the range [0, GroupCount()).
+    size_t GroupCount() const;
+
     // BLOCK CLIENT OPERATIONS.
 
     // Issues a group of block requests over the underlying fifo,
@@ -0,0 +1,185 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <bootdata/decompress.h>
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+
+#include <lz4/lz4.h>
+
+#include "decompress-priv.h"
+
+// The blocks of a frame are independent, and every block but the last one
+// holds a full 64kB, so each block can be decompressed straight to its place
+// in the output. A frame which doesn't look like that is decompressed one
+// block at a time instead.
+#define LZ4_BLOCK_SIZE (64 << 10)
+#define LZ4_BLOCK_UNCOMPRESSED (1u << 31)
+
+#define MAX_THREADS 16
+
+typedef struct {
+    const uint8_t* data;
+    uint32_t size;
+} lz4_block;
+
+typedef struct {
+    const lz4_block* blocks;
+    size_t count;
+    uint8_t* dst;
+    size_t outsize;
+
+    atomic_size_t next;
+    // Set when a block doesn't decompress to where it should go.
+    atomic_bool failed;
+    // How much the last block decompressed to.
+    size_t last_size;
+} parallel_decompress;
+
+static bool decompress_block(parallel_decompress* pd, size_t idx) {
+    const lz4_block* block = &pd->blocks[idx];
+    size_t offset = idx * LZ4_BLOCK_SIZE;
+    if (offset >= pd->outsize) {
+        return false;
+    }
+    size_t room = pd->outsize - offset;
+    if (room > LZ4_BLOCK_SIZE) {
+        room = LZ4_BLOCK_SIZE;
+    }
+
+    size_t size;
+    if (block->size & LZ4_BLOCK_UNCOMPRESSED) {
+        size = block->size & ~LZ4_BLOCK_UNCOMPRESSED;
+        if (size > room) {
+            return false;
+        }
+        memcpy(pd->dst + offset, block->data, size);
+    } else {
+        int dcmp = LZ4_decompress_safe((const char*)block->data,
+                                       (char*)(pd->dst + offset),
+                                       block->size, room);
+        if (dcmp < 0) {
+            return false;
+        }
+        size = dcmp;
+    }
+
+    if (idx == pd->count - 1) {
+        pd->last_size = size;
+        return true;
+    }
+    return size == LZ4_BLOCK_SIZE;
+}
+
+static int decompress_thread(void* arg) {
+    parallel_decompress* pd = arg;
+    size_t idx;
+    while ((idx = atomic_fetch_add(&pd->next, 1)) < pd->count &&
+           !atomic_load(&pd->failed)) {
+        if (!decompress_block(pd, idx)) {
+            atomic_store(&pd->failed, true);
+        }
+    }
+    return 0;
+}
+
+static zx_status_t decompress_lz4_blocks_parallel(const uint8_t* data, const uint8_t* end,
+                                                  uint8_t* dst, size_t outsize, void* arg,
+                                                  size_t* remaining_out, const char** err) {
+    uint32_t threads = *(const uint32_t*)arg;
+    if (threads > MAX_THREADS) {
+        threads = MAX_THREADS;
+    }
+    size_t max_blocks = outsize / LZ4_BLOCK_SIZE + 1;
+    if (threads < 2 || max_blocks < 2) {
+        return decompress_lz4_blocks(data, end, dst, outsize, NULL, remaining_out, err);
+    }
+
+    lz4_block* blocks = malloc(max_blocks * sizeof(lz4_block));
+    if (blocks == NULL) {
+        return decompress_lz4_blocks(data, end, dst, outsize, NULL, remaining_out, err);
+    }
+
+    // Find where each block starts. A frame that doesn't fit is left to
+    // decompress_lz4_blocks to diagnose.
+    const uint8_t* start = data;
+    size_t count = 0;
+    bool usable = true;
+    for (;;) {
+        if ((size_t)(end - data) < sizeof(uint32_t)) {
+            usable = false;
+            break;
+        }
+        uint32_t blocksize = *(const uint32_t*)data;
+        data += sizeof(uint32_t);
+        if (blocksize == 0) {
+            break;
+        }
+        uint32_t actual = blocksize & ~LZ4_BLOCK_UNCOMPRESSED;
+        if (count == max_blocks || actual > LZ4_BLOCK_SIZE ||
+            (size_t)(end - data) < actual) {
+            usable = false;
+            break;
+        }
+        blocks[count].data = data;
+        blocks[count].size = blocksize;
+        ++count;
+        data += actual;
+    }
+
+    parallel_decompress pd = {
+        .blocks = blocks,
+        .count = count,
+        .dst = dst,
+        .outsize = outsize,
+    };
+    atomic_init(&pd.next, 0);
+    atomic_init(&pd.failed, false);
+
+    if (usable && count > 1) {
+        if (threads > count) {
+            threads = count;
+        }
+        thrd_t workers[MAX_THREADS - 1];
+        uint32_t started = 0;
+        while (started < threads - 1 &&
+               thrd_create(&workers[started], decompress_thread, &pd) == thrd_success) {
+            ++started;
+        }
+        decompress_thread(&pd);
+        for (uint32_t i = 0; i < started; ++i) {
+            thrd_join(workers[i], NULL);
+        }
+    } else {
+        usable = false;
+    }
+    free(blocks);
+
+    if (!usable || atomic_load(&pd.failed)) {
+        // Start over one block at a time, clearing anything a block that
+        // landed in the wrong place left past the end.
+        zx_status_t status = decompress_lz4_blocks(start, end, dst, outsize, NULL,
+                                                   remaining_out, err);
+        if (status == ZX_OK) {
+            memset(dst + outsize - *remaining_out, 0, *remaining_out);
+        }
+        return status;
+    }
+
+    *remaining_out = outsize - ((count - 1) * LZ4_BLOCK_SIZE + pd.last_size);
+    return ZX_OK;
+}
+
+zx_status_t decompress_bootdata_parallel(zx_handle_t vmar, zx_handle_t vmo,
+                                         size_t offset, size_t length,
+                                         uint32_t threads, zx_handle_t* out,
+                                         const char** err) {
+    return decompress_bootdata_with(vmar, vmo, offset, length,
+                                    decompress_lz4_blocks_parallel, &threads,
+                                    out, err);
+}
@@ -0,0 +1,32 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <zircon/compiler.h>
+#include <zircon/types.h>
+
+__BEGIN_CDECLS
+
+// Decompress the LZ4 frame blocks from data, which follow the frame header
+// and end before end, into dst of size outsize. On success, remaining_out
+// is how much of dst was not filled in.
+typedef zx_status_t (*lz4_blocks_fn)(const uint8_t* data, const uint8_t* end,
+                                     uint8_t* dst, size_t outsize, void* arg,
+                                     size_t* remaining_out, const char** err);
+
+// Decompress the blocks one at a time. arg is unused.
+zx_status_t decompress_lz4_blocks(const uint8_t* data, const uint8_t* end,
+                                  uint8_t* dst, size_t outsize, void* arg,
+                                  size_t* remaining_out, const char** err);
+
+// Like decompress_bootdata, decompressing the blocks with blocks_fn(arg).
+zx_status_t decompress_bootdata_with(zx_handle_t vmar, zx_handle_t vmo,
+                                     size_t offset, size_t length,
+                                     lz4_blocks_fn blocks_fn, void* arg,
+                                     zx_handle_t* out, const char** err);
+
+__END_CDECLS
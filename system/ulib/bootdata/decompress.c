@@ -13,6 +13,8 @@
 
 #include <lz4/lz4.h>
 
+#include "decompress-priv.h"
+
 // The LZ4 Frame format is used to compress a bootfs image, but we cannot use
 // the LZ4 library's decompression functions in userboot. The following
 // definitions are used in the reimplementation of LZ4 Frame decompression, with
@@ -85,45 +87,10 @@ static zx_status_t check_lz4_frame(const lz4_frame_desc* fd,
     return ZX_OK;
 }
 
-static zx_status_t decompress_bootfs_vmo(zx_handle_t vmar, const uint8_t* data,
-                                         size_t _outsize, zx_handle_t* out,
-                                         const char** err) {
-    if (*(const uint32_t*)data != ZX_LZ4_MAGIC) {
-        *err = "bad magic number for compressed bootfs";
-        return ZX_ERR_INVALID_ARGS;
-    }
-    data += sizeof(uint32_t);
-
-    zx_status_t status = check_lz4_frame((const lz4_frame_desc*)data, _outsize, err);
-    if (status < 0)
-        return status;
-    data += sizeof(lz4_frame_desc);
-
-    size_t outsize = (_outsize + 4095) & ~4095;
-    if (outsize < _outsize) {
-        // newsize wrapped, which means the outsize was too large
-        *err = "lz4 output size too large";
-        return ZX_ERR_NO_MEMORY;
-    }
-    zx_handle_t dst_vmo;
-    status = zx_vmo_create((uint64_t)outsize, 0, &dst_vmo);
-    if (status < 0) {
-        *err = "zx_vmo_create failed for decompressing bootfs";
-        return status;
-    }
-    zx_object_set_property(dst_vmo, ZX_PROP_NAME, "bootfs", 6);
-
-    uintptr_t dst_addr = 0;
-    status = zx_vmar_map(vmar,
-            ZX_VM_PERM_READ|ZX_VM_PERM_WRITE,
-            0, dst_vmo, 0, outsize, &dst_addr);
-    if (status < 0) {
-        *err = "zx_vmar_map failed on bootfs vmo during decompression";
-        return status;
-    }
-
+zx_status_t decompress_lz4_blocks(const uint8_t* data, const uint8_t* end,
+                                  uint8_t* dst, size_t outsize, void* arg,
+                                  size_t* remaining_out, const char** err) {
     size_t remaining = outsize;
-    uint8_t* dst = (uint8_t*)dst_addr;
 
     // Read each LZ4 block and decompress it. Block sizes are 32 bits.
     uint32_t blocksize = *(const uint32_t*)data;
@@ -161,6 +128,55 @@ static zx_status_t decompress_bootfs_vmo(zx_handle_t vmar, const uint8_t* data,
         data += sizeof(uint32_t);
     }
 
+    *remaining_out = remaining;
+    return ZX_OK;
+}
+
+static zx_status_t decompress_bootfs_vmo(zx_handle_t vmar, const uint8_t* data,
+                                         const uint8_t* end, size_t _outsize,
+                                         const char* name,
+                                         lz4_blocks_fn blocks_fn, void* arg,
+                                         zx_handle_t* out, const char** err) {
+    if (*(const uint32_t*)data != ZX_LZ4_MAGIC) {
+        *err = "bad magic number for compressed bootfs";
+        return ZX_ERR_INVALID_ARGS;
+    }
+    data += sizeof(uint32_t);
+
+    zx_status_t status = check_lz4_frame((const lz4_frame_desc*)data, _outsize, err);
+    if (status < 0)
+        return status;
+    data += sizeof(lz4_frame_desc);
+
+    size_t outsize = (_outsize + 4095) & ~4095;
+    if (outsize < _outsize) {
+        // newsize wrapped, which means the outsize was too large
+        *err = "lz4 output size too large";
+        return ZX_ERR_NO_MEMORY;
+    }
+    zx_handle_t dst_vmo;
+    status = zx_vmo_create((uint64_t)outsize, 0, &dst_vmo);
+    if (status < 0) {
+        *err = "zx_vmo_create failed for decompressing bootfs";
+        return status;
+    }
+    zx_object_set_property(dst_vmo, ZX_PROP_NAME, name, strlen(name));
+
+    uintptr_t dst_addr = 0;
+    status = zx_vmar_map(vmar,
+            ZX_VM_PERM_READ|ZX_VM_PERM_WRITE,
+            0, dst_vmo, 0, outsize, &dst_addr);
+    if (status < 0) {
+        *err = "zx_vmar_map failed on bootfs vmo during decompression";
+        return status;
+    }
+
+    size_t remaining;
+    status = blocks_fn(data, end, (uint8_t*)dst_addr, outsize, arg, &remaining, err);
+    if (status < 0) {
+        return status;
+    }
+
     // Sanity check: verify that we didn't have more than one page leftover.
     // The bootdata header should have specified the exact outsize needed, which
     // we rounded up to the next full page.
@@ -178,9 +194,10 @@ static zx_status_t decompress_bootfs_vmo(zx_handle_t vmar, const uint8_t* data,
     return ZX_OK;
 }
 
-zx_status_t decompress_bootdata(zx_handle_t vmar, zx_handle_t vmo,
-                                size_t offset, size_t length,
-                                zx_handle_t* out, const char** err) {
+zx_status_t decompress_bootdata_with(zx_handle_t vmar, zx_handle_t vmo,
+                                     size_t offset, size_t length,
+                                     lz4_blocks_fn blocks_fn, void* arg,
+                                     zx_handle_t* out, const char** err) {
     *err = "none";
 
     if (length > SIZE_MAX) {
@@ -207,7 +224,9 @@ zx_status_t decompress_bootdata(zx_handle_t vmar, zx_handle_t vmo,
     case BOOTDATA_BOOTFS_SYSTEM:
     case BOOTDATA_RAMDISK:
         if (hdr->flags & BOOTDATA_BOOTFS_FLAG_COMPRESSED) {
-            status = decompress_bootfs_vmo(vmar, (const uint8_t*)bootdata_addr, hdr->extra, out, err);
+            status = decompress_bootfs_vmo(vmar, (const uint8_t*)bootdata_addr,
+                                           (const uint8_t*)(addr + length), hdr->extra,
+                                           "bootfs", blocks_fn, arg, out, err);
         }
         break;
     default:
@@ -224,3 +243,78 @@ zx_status_t decompress_bootdata(zx_handle_t vmar, zx_handle_t vmo,
 
     return status;
 }
+
+zx_status_t decompress_bootdata(zx_handle_t vmar, zx_handle_t vmo,
+                                size_t offset, size_t length,
+                                zx_handle_t* out, const char** err) {
+    return decompress_bootdata_with(vmar, vmo, offset, length,
+                                    decompress_lz4_blocks, NULL, out, err);
+}
+
+zx_status_t bootfs_file_size(zx_handle_t vmo, size_t offset, size_t length,
+                             uint64_t* size_out, const char** err) {
+    *err = "none";
+
+    struct {
+        uint32_t magic;
+        lz4_frame_desc fd;
+    } __PACKED hdr;
+    if (length < sizeof(hdr)) {
+        *err = "compressed bootfs file too short";
+        return ZX_ERR_IO;
+    }
+    zx_status_t status = zx_vmo_read(vmo, &hdr, offset, sizeof(hdr));
+    if (status < 0) {
+        *err = "zx_vmo_read failed on bootfs vmo";
+        return status;
+    }
+    if (hdr.magic != ZX_LZ4_MAGIC) {
+        *err = "bad magic number for compressed bootfs file";
+        return ZX_ERR_IO;
+    }
+    if ((status = check_lz4_frame(&hdr.fd, hdr.fd.content_size, err)) < 0) {
+        return status;
+    }
+    *size_out = hdr.fd.content_size;
+    return ZX_OK;
+}
+
+zx_status_t decompress_bootfs_file(zx_handle_t vmar, zx_handle_t vmo,
+                                   size_t offset, size_t length, const char* name,
+                                   zx_handle_t* out, uint64_t* size_out,
+                                   const char** err) {
+    uint64_t size;
+    zx_status_t status = bootfs_file_size(vmo, offset, length, &size, err);
+    if (status < 0) {
+        return status;
+    }
+    if (size > SIZE_MAX) {
+        *err = "compressed bootfs file too large";
+        return ZX_ERR_NO_MEMORY;
+    }
+
+    uintptr_t addr = 0;
+    size_t aligned_offset = offset & ~(PAGE_SIZE - 1);
+    size_t align_shift = offset - aligned_offset;
+    length += align_shift;
+    status = zx_vmar_map(vmar, ZX_VM_PERM_READ, 0, vmo, aligned_offset, length, &addr);
+    if (status < 0) {
+        *err = "zx_vmar_map failed on bootfs vmo";
+        return status;
+    }
+
+    status = decompress_bootfs_vmo(vmar, (const uint8_t*)(addr + align_shift),
+                                   (const uint8_t*)(addr + length), size,
+                                   name, decompress_lz4_blocks, NULL, out, err);
+
+    zx_status_t s = zx_vmar_unmap(vmar, addr, length);
+    if (status == ZX_OK && s < 0) {
+        zx_handle_close(*out);
+        *err = "zx_vmar_unmap failed on bootfs vmo";
+        return s;
+    }
+    if (status == ZX_OK) {
+        *size_out = size;
+    }
+    return status;
+}
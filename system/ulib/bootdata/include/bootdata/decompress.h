@@ -18,6 +18,27 @@ zx_status_t decompress_bootdata(zx_handle_t vmar, zx_handle_t vmo,
                                 size_t offset, size_t length,
                                 zx_handle_t* out, const char** errmsg);
 
+// Like decompress_bootdata, but decompress the LZ4 blocks on up to threads
+// threads at once. This starts threads of its own, so it is not available
+// to userboot.
+zx_status_t decompress_bootdata_parallel(zx_handle_t vmar, zx_handle_t vmo,
+                                         size_t offset, size_t length,
+                                         uint32_t threads, zx_handle_t* out,
+                                         const char** errmsg);
+
+// Get the size of the BOOTFS file stored compressed at offset of total
+// size length in vmo (see BOOTFS_ENTRY_COMPRESSED).
+zx_status_t bootfs_file_size(zx_handle_t vmo, size_t offset, size_t length,
+                             uint64_t* size_out, const char** errmsg);
+
+// Decompress the BOOTFS file stored compressed at offset of total size
+// length in vmo into a new VMO called name, returning it and the size of
+// the file.
+zx_status_t decompress_bootfs_file(zx_handle_t vmar, zx_handle_t vmo,
+                                   size_t offset, size_t length, const char* name,
+                                   zx_handle_t* out, uint64_t* size_out,
+                                   const char** errmsg);
+
 __END_CDECLS
 
 #pragma GCC visibility pop
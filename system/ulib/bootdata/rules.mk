@@ -10,7 +10,9 @@ MODULE_TYPE := userlib
 
 MODULE_COMPILEFLAGS += -fvisibility=hidden
 
-MODULE_SRCS += $(LOCAL_DIR)/decompress.c
+MODULE_SRCS += \
+    $(LOCAL_DIR)/decompress.c \
+    $(LOCAL_DIR)/decompress-parallel.c
 
 MODULE_LIBS := \
     third_party/ulib/lz4 \
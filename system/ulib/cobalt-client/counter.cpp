@@ -10,8 +10,23 @@
 
 namespace cobalt_client {
 namespace internal {
+namespace {
 
-BaseCounter::BaseCounter(BaseCounter&& other) : counter_(other.Exchange(0)) {}
+// Shard to hand out next; threads are spread round robin.
+fbl::atomic<size_t> next_shard_index(0);
+
+} // namespace
+
+thread_local size_t tls_shard_index = kUnassignedShard;
+
+size_t AssignShardIndex() {
+    tls_shard_index = next_shard_index.fetch_add(1, fbl::memory_order_relaxed) % kShards;
+    return tls_shard_index;
+}
+
+BaseCounter::BaseCounter(BaseCounter&& other) : BaseCounter() {
+    shards_[0].value.store(other.Exchange(0), kMemoryOrder);
+}
 
 RemoteCounter::RemoteCounter(const RemoteMetricInfo& metric_info, EventBuffer buffer)
     : BaseCounter(), buffer_(fbl::move(buffer)), metric_info_(metric_info) {
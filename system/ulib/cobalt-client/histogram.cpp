@@ -10,6 +10,7 @@
 
 #include <cobalt-client/cpp/histogram-internal.h>
 #include <cobalt-client/cpp/metric-options.h>
+#include <fbl/algorithm.h>
 #include <fbl/limits.h>
 #include <fuchsia/cobalt/c/fidl.h>
 
@@ -87,10 +88,16 @@ void LoadLinear(HistogramOptions* options) {
 
 } // namespace
 
-BaseHistogram::BaseHistogram(uint32_t num_buckets) {
-    buckets_.reserve(num_buckets);
-    for (uint32_t i = 0; i < num_buckets; ++i) {
-        buckets_.push_back(BaseCounter());
+BaseHistogram::BaseHistogram(uint32_t num_buckets)
+    : num_buckets_(num_buckets),
+      lines_per_shard_(fbl::round_up(static_cast<size_t>(num_buckets), kCountsPerLine) /
+                       kCountsPerLine) {
+    size_t num_lines = lines_per_shard_ * kShards;
+    lines_.reset(new CountLine[num_lines], num_lines);
+    for (auto& line : lines_) {
+        for (auto& count : line.counts) {
+            count.store(0, BaseCounter::kMemoryOrder);
+        }
     }
 }
 
@@ -123,7 +130,7 @@ bool RemoteHistogram::Flush(const RemoteHistogram::FlushFn& flush_handler) {
     // Sets every bucket back to 0, not all buckets will be at the same instant, but
     // eventual consistency in the backend is good enough.
     for (uint32_t bucket_index = 0; bucket_index < bucket_buffer_.size(); ++bucket_index) {
-        bucket_buffer_[bucket_index].count = buckets_[bucket_index].Exchange();
+        bucket_buffer_[bucket_index].count = ExchangeCount(bucket_index);
     }
 
     flush_handler(metric_info_, buffer_, fbl::BindMember(&buffer_, &EventBuffer::CompleteFlush));
@@ -13,17 +13,44 @@
 #include <fbl/function.h>
 #include <fbl/string.h>
 #include <fbl/vector.h>
+#include <zircon/compiler.h>
 
 namespace cobalt_client {
 namespace internal {
 // Note: Everything on this namespace is internal, no external users should rely
 // on the behaviour of any of these classes.
 
+// Metrics are sharded, so that threads updating the same metric mostly touch different
+// cache lines. Each thread is assigned one of |kShards| shards the first time it updates a
+// metric, and always updates its own shard. Reads and flushes merge the shards.
+constexpr size_t kShards = 8;
+
+// Size of a cache line, shards never share one.
+constexpr size_t kCacheLineSize = 64;
+
+// Value of |tls_shard_index| before the thread is assigned a shard.
+constexpr size_t kUnassignedShard = kShards;
+
+// Shard of the calling thread, or |kUnassignedShard|.
+extern thread_local size_t tls_shard_index;
+
+// Assigns the calling thread a shard and returns it.
+size_t AssignShardIndex();
+
+// Returns the shard the calling thread should update.
+inline size_t GetShardIndex() {
+    size_t index = tls_shard_index;
+    if (unlikely(index == kUnassignedShard)) {
+        index = AssignShardIndex();
+    }
+    return index;
+}
+
 // BaseCounter and RemoteCounter differ in that the first is simply a thin wrapper over
-// an atomic while the second provides Cobalt Fidl specific API and holds more metric related
-// data for a full fledged metric.
+// a set of atomics while the second provides Cobalt Fidl specific API and holds more metric
+// related data for a full fledged metric.
 //
-// Thin wrapper on top of an atomic, which provides a fixed memory ordering for all calls.
+// Thin wrapper on top of a sharded atomic, which provides a fixed memory ordering for all calls.
 // Calls are inlined to reduce overhead.
 class BaseCounter {
 public:
@@ -32,24 +59,49 @@ public:
     // All atomic operations use this memory order.
     static constexpr fbl::memory_order kMemoryOrder = fbl::memory_order::memory_order_relaxed;
 
-    BaseCounter() : counter_(0) {}
+    BaseCounter() {
+        for (auto& shard : shards_) {
+            shard.value.store(0, kMemoryOrder);
+        }
+    }
     BaseCounter(const BaseCounter&) = delete;
     BaseCounter(BaseCounter&&);
     BaseCounter& operator=(const BaseCounter&) = delete;
     BaseCounter& operator=(BaseCounter&&) = delete;
     ~BaseCounter() = default;
 
-    // Increments |counter_| by |val|.
-    void Increment(Type val = 1) { counter_.fetch_add(val, kMemoryOrder); }
-
-    // Returns the current value of|counter_| and resets it to |val|.
-    Type Exchange(Type val = 0) { return counter_.exchange(val, kMemoryOrder); }
-
-    // Returns the current value of |counter_|.
-    Type Load() const { return counter_.load(kMemoryOrder); }
+    // Increments the counter by |val|.
+    void Increment(Type val = 1) { shards_[GetShardIndex()].value.fetch_add(val, kMemoryOrder); }
+
+    // Returns the current value of the counter and resets it to |val|. Every increment is
+    // returned by exactly one call, though increments racing with this one may be left for
+    // the next.
+    Type Exchange(Type val = 0) {
+        Type total = 0;
+        for (auto& shard : shards_) {
+            total += shard.value.exchange(0, kMemoryOrder);
+        }
+        if (val != 0) {
+            Increment(val);
+        }
+        return total;
+    }
+
+    // Returns the current value of the counter.
+    Type Load() const {
+        Type total = 0;
+        for (const auto& shard : shards_) {
+            total += shard.value.load(kMemoryOrder);
+        }
+        return total;
+    }
 
 protected:
-    fbl::atomic<Type> counter_;
+    struct alignas(kCacheLineSize) Shard {
+        fbl::atomic<Type> value;
+    };
+
+    Shard shards_[kShards];
 };
 
 // Counter which represents a standalone cobalt metric. Provides API for converting
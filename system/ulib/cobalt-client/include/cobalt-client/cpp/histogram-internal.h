@@ -9,6 +9,7 @@
 
 #include <cobalt-client/cpp/counter-internal.h>
 #include <cobalt-client/cpp/types-internal.h>
+#include <fbl/array.h>
 #include <fbl/atomic.h>
 #include <fbl/function.h>
 #include <fbl/string.h>
@@ -24,6 +25,9 @@ namespace internal {
 // that represent a histogram. Once constructed, unless moved, the class is thread-safe.
 // All allocations happen when constructed.
 //
+// Buckets are sharded like BaseCounter, but each shard holds the whole set of buckets
+// contiguously, so a histogram takes |kShards| times its buckets rounded up to a cache line.
+//
 // This class is moveable but not copyable or assignable.
 // This class is thread-compatible.
 class BaseHistogram {
@@ -41,21 +45,49 @@ public:
 
     // Increases the count of the |bucket| bucket by 1.
     void IncrementCount(uint32_t bucket, Count val = 1) {
-        ZX_DEBUG_ASSERT_MSG(bucket < buckets_.size(),
-                            "IncrementCount bucket(%u) out of range(%lu).", bucket,
-                            buckets_.size());
-        buckets_[bucket].Increment(val);
+        ZX_DEBUG_ASSERT_MSG(bucket < num_buckets_,
+                            "IncrementCount bucket(%u) out of range(%u).", bucket,
+                            num_buckets_);
+        GetShardCount(GetShardIndex(), bucket)->fetch_add(val, BaseCounter::kMemoryOrder);
     }
 
     // Returns the count of the |bucket| bucket.
     Count GetCount(uint32_t bucket) const {
-        ZX_DEBUG_ASSERT_MSG(bucket < buckets_.size(), "GetCount bucket out of range.");
-        return buckets_[bucket].Load();
+        ZX_DEBUG_ASSERT_MSG(bucket < num_buckets_, "GetCount bucket out of range.");
+        Count total = 0;
+        for (size_t shard = 0; shard < kShards; ++shard) {
+            total += GetShardCount(shard, bucket)->load(BaseCounter::kMemoryOrder);
+        }
+        return total;
+    }
+
+    // Returns the count of the |bucket| bucket and resets it to 0.
+    Count ExchangeCount(uint32_t bucket) {
+        ZX_DEBUG_ASSERT_MSG(bucket < num_buckets_, "ExchangeCount bucket out of range.");
+        Count total = 0;
+        for (size_t shard = 0; shard < kShards; ++shard) {
+            total += GetShardCount(shard, bucket)->exchange(0, BaseCounter::kMemoryOrder);
+        }
+        return total;
     }
 
 protected:
-    // Counter for the abs frequency of every histogram bucket.
-    fbl::Vector<BaseCounter> buckets_;
+    static constexpr size_t kCountsPerLine = kCacheLineSize / sizeof(fbl::atomic<Count>);
+
+    struct alignas(kCacheLineSize) CountLine {
+        fbl::atomic<Count> counts[kCountsPerLine];
+    };
+
+    fbl::atomic<Count>* GetShardCount(size_t shard, uint32_t bucket) const {
+        CountLine* line = &lines_[shard * lines_per_shard_ + bucket / kCountsPerLine];
+        return &line->counts[bucket % kCountsPerLine];
+    }
+
+    uint32_t num_buckets_;
+    size_t lines_per_shard_;
+
+    // The buckets of every shard, shard after shard.
+    fbl::Array<CountLine> lines_;
 };
 
 // This class provides a histogram which represents a full fledged cobalt metric. The histogram
@@ -20,25 +20,79 @@
 
 // See note in //zircon/third_party/ulib/uboringssl/rules.mk
 #define BORINGSSL_NO_CXX
+#include <openssl/aes.h>
 #include <openssl/cipher.h>
+#include <openssl/cpu.h>
 
 #include "error.h"
 
 #define ZXDEBUG 0
 
+#if defined(__x86_64__)
+// The AES-NI XTS routines in uboringssl's aesni-x86_64.S, which keep six blocks in flight at a
+// time.  BoringSSL's own XTS (in decrepit/) works one block at a time, through AES_encrypt.
+extern "C" {
+void aes_hw_xts_encrypt(const uint8_t* in, uint8_t* out, size_t length, const AES_KEY* key1,
+                        const AES_KEY* key2, const uint8_t iv[16]);
+void aes_hw_xts_decrypt(const uint8_t* in, uint8_t* out, size_t length, const AES_KEY* key1,
+                        const AES_KEY* key2, const uint8_t iv[16]);
+}
+#endif
+
 namespace crypto {
 
 // The previously opaque crypto implementation context.  Guaranteed to clean up on destruction.
 struct Cipher::Context {
-    Context() { EVP_CIPHER_CTX_init(&impl); }
+    Context() : hw_xts(false) { EVP_CIPHER_CTX_init(&impl); }
 
-    ~Context() { EVP_CIPHER_CTX_cleanup(&impl); }
+    ~Context() {
+        EVP_CIPHER_CTX_cleanup(&impl);
+        mandatory_memset(&key1, 0, sizeof(key1));
+        mandatory_memset(&key2, 0, sizeof(key2));
+    }
 
     EVP_CIPHER_CTX impl;
+
+    // Set if AES-XTS data units are transformed with |aes_hw_xts_*| and these key schedules
+    // instead of |impl|.
+    bool hw_xts;
+    AES_KEY key1;
+    AES_KEY key2;
 };
 
 namespace {
 
+// Returns true if |AES_set_encrypt_key| and |AES_set_decrypt_key| produce the key schedules the
+// AES-NI routines expect, as they do whenever those are used; see |hwaes_capable| in uboringssl's
+// crypto/fipsmodule/aes/internal.h.
+bool HwXtsCapable() {
+#if defined(__x86_64__) && !defined(OPENSSL_NO_ASM)
+    return (OPENSSL_ia32cap_get()[1] & (1u << (57 - 32))) != 0;
+#else
+    return false;
+#endif
+}
+
+// Transforms one AES-XTS data unit of |length| bytes using the AES-NI routines.
+zx_status_t HwXtsTransform(const Cipher::Direction direction, const AES_KEY* key1,
+                           const AES_KEY* key2, const uint8_t* iv, const uint8_t* in,
+                           size_t length, uint8_t* out) {
+#if defined(__x86_64__) && !defined(OPENSSL_NO_ASM)
+    if (length < AES_BLOCK_SIZE) {
+        xprintf("data unit too short: %zu\n", length);
+        return ZX_ERR_INVALID_ARGS;
+    }
+    if (direction == Cipher::kEncrypt) {
+        aes_hw_xts_encrypt(in, out, length, key1, key2, iv);
+    } else {
+        aes_hw_xts_decrypt(in, out, length, key1, key2, iv);
+    }
+    return ZX_OK;
+#else
+    return ZX_ERR_NOT_SUPPORTED;
+#endif
+}
+
 // Get the cipher for the given |version|.
 zx_status_t GetCipher(Cipher::Algorithm cipher, const EVP_CIPHER** out) {
     switch (cipher) {
@@ -172,6 +226,21 @@ zx_status_t Cipher::Init(Algorithm algo, Direction direction, const Secret& key,
     direction_ = direction;
     block_size_ = cipher->block_size;
 
+    // Random access AES-XTS transforms one data unit per call; give those to the AES-NI routines
+    // when they're available.  The XTS key is the data key followed by the tweak key.
+    if (algo == kAES256_XTS && alignment != 0 && HwXtsCapable()) {
+        const uint8_t* key1 = key.get();
+        const uint8_t* key2 = key1 + key.len() / 2;
+        unsigned bits = static_cast<unsigned>(key.len() / 2) * 8;
+        int rc1 = direction == kEncrypt ? AES_set_encrypt_key(key1, bits, &ctx_->key1)
+                                        : AES_set_decrypt_key(key1, bits, &ctx_->key1);
+        if (rc1 != 0 || AES_set_encrypt_key(key2, bits, &ctx_->key2) != 0) {
+            xprintf("failed to set AES-XTS keys\n");
+            return ZX_ERR_INTERNAL;
+        }
+        ctx_->hw_xts = true;
+    }
+
     cleanup.cancel();
     return ZX_OK;
 }
@@ -207,8 +276,13 @@ zx_status_t Cipher::Transform(const uint8_t* in, zx_off_t offset, size_t length,
         uint8_t* iv8 = reinterpret_cast<uint8_t*>(iv_.get());
         while (length > 0) {
             size_t chunk_len = length < alignment_ ? length : alignment_;
-            if (EVP_CipherInit_ex(&ctx_->impl, nullptr, nullptr, nullptr, iv8, -1) < 0 ||
-                EVP_Cipher(&ctx_->impl, out, in, chunk_len) <= 0) {
+            if (ctx_->hw_xts) {
+                if ((rc = HwXtsTransform(direction, &ctx_->key1, &ctx_->key2, iv8, in, chunk_len,
+                                         out)) != ZX_OK) {
+                    return rc;
+                }
+            } else if (EVP_CipherInit_ex(&ctx_->impl, nullptr, nullptr, nullptr, iv8, -1) < 0 ||
+                       EVP_Cipher(&ctx_->impl, out, in, chunk_len) <= 0) {
                 xprintf_crypto_errors(&rc);
                 return rc;
             }
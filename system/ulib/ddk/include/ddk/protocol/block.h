@@ -73,9 +73,17 @@ struct block_read_write {
 
 #define BLOCK_OP_MASK UINT32_C(0x000000FF)
 
+// Trim ops use trim for parameters.
+// They tell the device that the blocks are no longer in use, and their
+// contents may be discarded. Only devices with BLOCK_FLAG_TRIM_SUPPORT
+// support them.
 struct block_trim {
     // Command and flags.
     uint32_t command;
+    // Length in blocks (0 is invalid).
+    uint32_t length;
+    // Device offset in blocks.
+    uint64_t offset_dev;
 };
 
 union block_op {
@@ -28,10 +28,32 @@ __BEGIN_CDECLS;
 //
 // The FEATURE_DMA flag indicates that the device can copy the buffer data using DMA and will ensure
 // that physical addresses are provided in netbufs.
+//
+// The FEATURE_MULTIQUEUE flag indicates a device with info.num_queues transmit and receive queue
+// pairs. Each netbuf is transmitted on the queue its |queue| names, and frames received on each
+// queue are delivered through ifc->recv_queue(). Devices without the flag have a single queue, 0.
+//
+// The FEATURE_TX_CSUM flag indicates that the device completes the checksum of netbufs with
+// ETHMAC_NETBUF_NEEDS_CSUM set, as described by their |csum_start| and |csum_offset|.
+//
+// The FEATURE_RX_CSUM flag indicates that the device verifies the TCP and UDP checksums of the
+// packets it receives, and passes ETHMAC_RX_CSUM_VALID to recv() for those which were correct.
+//
+// The FEATURE_TSO flag indicates that the device segments TCP netbufs of up to
+// info.tso_max_size bytes with ETHMAC_NETBUF_GSO_TCPV4 or ETHMAC_NETBUF_GSO_TCPV6 set.
+//
+// The FEATURE_RX_BUFFERS flag indicates that the device can receive directly into buffers the
+// generic ethernet driver queues with queue_rx(), while ETHMAC_SETPARAM_RX_BUFFERS is enabled.
+// Their physical addresses are provided as for FEATURE_DMA.
 
-#define ETHMAC_FEATURE_WLAN     (1u)
-#define ETHMAC_FEATURE_SYNTH    (2u)
-#define ETHMAC_FEATURE_DMA      (4u)
+#define ETHMAC_FEATURE_WLAN       (1u)
+#define ETHMAC_FEATURE_SYNTH      (2u)
+#define ETHMAC_FEATURE_DMA        (4u)
+#define ETHMAC_FEATURE_MULTIQUEUE (8u)
+#define ETHMAC_FEATURE_TX_CSUM    (0x10u)
+#define ETHMAC_FEATURE_RX_CSUM    (0x20u)
+#define ETHMAC_FEATURE_TSO        (0x40u)
+#define ETHMAC_FEATURE_RX_BUFFERS (0x80u)
 
 #define ETHMAC_STATUS_ONLINE    (1u)
 
@@ -40,16 +62,34 @@ typedef struct ethmac_info {
     uint32_t mtu;
     uint8_t mac[ETH_MAC_SIZE];
     uint8_t reserved0[2];
-    uint32_t reserved1[4];
+    uint32_t num_queues;    // Only used if ETHMAC_FEATURE_MULTIQUEUE is available
+    uint32_t tso_max_size;  // Only used if ETHMAC_FEATURE_TSO is available
+    uint32_t reserved1[2];
 } ethmac_info_t;
 
+// The device must checksum the packet's bytes from |csum_start| to its end, and store the result
+// |csum_offset| bytes past |csum_start|, where the sender has placed the pseudo-header's sum. This
+// is the model of virtio-net's VIRTIO_NET_HDR_F_NEEDS_CSUM.
+#define ETHMAC_NETBUF_NEEDS_CSUM (1u)
+
+// The device must split the packet, whose first |hdr_len| bytes are its headers, into TCP
+// segments of at most |gso_size| bytes of payload each. Always set with NEEDS_CSUM.
+#define ETHMAC_NETBUF_GSO_TCPV4  (2u)
+#define ETHMAC_NETBUF_GSO_TCPV6  (4u)
+
 typedef struct ethmac_netbuf {
     // Provided by the generic ethernet driver
     void* data;
     zx_paddr_t phys;  // Only used if ETHMAC_FEATURE_DMA is available
     uint16_t len;
-    uint16_t reserved;
-    uint32_t flags;
+    uint16_t queue;   // Below info.num_queues; always 0 without ETHMAC_FEATURE_MULTIQUEUE
+    uint32_t flags;   // ETHMAC_NETBUF_* flags, only set if the device has the matching feature
+
+    // Offload parameters described by the ETHMAC_NETBUF_* flags
+    uint16_t csum_start;
+    uint16_t csum_offset;
+    uint16_t gso_size;
+    uint16_t hdr_len;
 
     // Shared between the generic ethernet and ethmac drivers
     list_node_t node;
@@ -61,6 +101,10 @@ typedef struct ethmac_netbuf {
     };
 } ethmac_netbuf_t;
 
+// Passed in the |flags| of recv() and recv_queue() by devices with ETHMAC_FEATURE_RX_CSUM for
+// packets whose TCP or UDP checksum they verified.
+#define ETHMAC_RX_CSUM_VALID (1u)
+
 typedef struct ethmac_ifc_virt {
     // Value with bits set from the ETHMAC_STATUS_* flags
     void (*status)(void* cookie, uint32_t status);
@@ -74,6 +118,17 @@ typedef struct ethmac_ifc_virt {
     // Upon a return of ZX_OK, the packet has been enqueued, but no information is returned as to
     // the completion state of the transmission itself.
     void (*complete_tx)(void* cookie, ethmac_netbuf_t* netbuf, zx_status_t status);
+
+    // Delivers a frame received on |queue|, like recv(). Devices with ETHMAC_FEATURE_MULTIQUEUE
+    // may call it from a thread per queue simultaneously. recv() is equivalent to recv_queue()
+    // on queue 0. May be NULL, in which case every frame must be delivered through recv().
+    void (*recv_queue)(void* cookie, uint32_t queue, void* data, size_t length, uint32_t flags);
+
+    // Returns a netbuf queued with queue_rx() once the device has received a frame of |length|
+    // bytes into it, with |flags| as for recv(). A |length| of zero returns a netbuf unused, as
+    // when ETHMAC_SETPARAM_RX_BUFFERS is disabled. The device must be ready to take another netbuf
+    // from queue_rx() by the time it calls complete_rx().
+    void (*complete_rx)(void* cookie, ethmac_netbuf_t* netbuf, size_t length, uint32_t flags);
 } ethmac_ifc_t;
 
 typedef struct eth_dev_metadata {
@@ -105,6 +160,58 @@ typedef struct eth_dev_metadata {
 
 #define ETHMAC_SETPARAM_DUMP_REGS (4u)
 
+// Receive-side scaling spreads received frames across the queues of an ETHMAC_FEATURE_MULTIQUEUE
+// device by a Toeplitz hash of the header fields selected by |hash_types|, keyed by |key|. The
+// low bits of the hash index |indirection|, which names the queue each frame is received on.
+#define ETHMAC_RSS_HASH_IPV4     (1u)
+#define ETHMAC_RSS_HASH_TCP_IPV4 (2u)
+#define ETHMAC_RSS_HASH_UDP_IPV4 (4u)
+#define ETHMAC_RSS_HASH_IPV6     (8u)
+#define ETHMAC_RSS_HASH_TCP_IPV6 (0x10u)
+#define ETHMAC_RSS_HASH_UDP_IPV6 (0x20u)
+
+#define ETHMAC_RSS_KEY_SIZE   (40)
+#define ETHMAC_RSS_TABLE_SIZE (128)
+
+typedef struct ethmac_rss_config {
+    uint32_t hash_types;   // ETHMAC_RSS_HASH_* flags; 0 receives every frame on queue 0
+    uint8_t key[ETHMAC_RSS_KEY_SIZE];
+    uint16_t indirection[ETHMAC_RSS_TABLE_SIZE];
+} ethmac_rss_config_t;
+
+// |value| is unused. |data| is an ethmac_rss_config_t. Caller retains ownership.
+#define ETHMAC_SETPARAM_RSS (5u)
+
+// |value| is a queue. |data| is a uint32_t naming the CPU which should take the interrupts of
+// that queue, and so run its recv_queue() calls. Caller retains ownership.
+#define ETHMAC_SETPARAM_QUEUE_CPU (6u)
+
+// |value| is bool. |data| is unused. While enabled, an ETHMAC_FEATURE_RX_BUFFERS device receives
+// only into the netbufs queued with queue_rx(), and delivers frames through complete_rx() rather
+// than recv(). Disabling it returns each netbuf still queued through complete_rx(), with a length
+// of zero, before set_param() returns; none are returned after.
+#define ETHMAC_SETPARAM_RX_BUFFERS (7u)
+
+// Interrupt moderation has a device wait between interrupts, to take fewer of them under load at
+// some cost in latency. The device waits from |min_interval_us| when idle up to |max_interval_us|
+// under heavy load, adapting to the rate of packets it sees. Equal intervals fix the delay, and
+// zero for both turns moderation off.
+typedef struct ethmac_intr_moderation {
+    uint32_t min_interval_us;
+    uint32_t max_interval_us;
+} ethmac_intr_moderation_t;
+
+// |value| is unused. |data| is an ethmac_intr_moderation_t. Caller retains ownership.
+#define ETHMAC_SETPARAM_INTR_MODERATION (8u)
+
+typedef struct ethmac_queue_stats {
+    uint64_t interrupts;
+    uint64_t rx_packets;
+    uint64_t tx_packets;
+    uint32_t interval_us;  // the current wait between interrupts
+    uint32_t reserved;
+} ethmac_queue_stats_t;
+
 // The ethernet midlayer will never call ethermac_protocol
 // methods from multiple threads simultaneously, but it
 // can call send() methods at the same time as non-send
@@ -148,10 +255,36 @@ typedef struct ethmac_protocol_ops {
     zx_status_t (*set_param)(void* ctx, uint32_t param, int32_t value, void* data);
 
     // Get the BTI handle (needed to pin DMA memory) for this device.
-    // This method is only valid on devices that advertise ETHMAC_FEATURE_DMA
+    // This method is only valid on devices that advertise ETHMAC_FEATURE_DMA or
+    // ETHMAC_FEATURE_RX_BUFFERS.
     // The caller does *not* take ownership of the BTI handle and must never close
     // the handle.
     zx_handle_t (*get_bti)(void* ctx);
+
+    // Request transmission of the |count| packets in |netbufs| at once, so that the driver can
+    // take its locks and notify the hardware once for all of them. The status of each packet is
+    // stored in |statuses|, with the same meaning as the return value of queue_tx(). |options|
+    // applies to the last packet; the others are sent as if with ETHMAC_TX_OPT_MORE.
+    //
+    // Optional. The generic ethernet driver calls queue_tx() for each packet of drivers which
+    // don't implement it.
+    void (*queue_tx_batch)(void* ctx, uint32_t options, ethmac_netbuf_t** netbufs, size_t count,
+                           zx_status_t* statuses);
+
+    // Queue the |len| bytes at |phys| of |netbuf| to receive a frame into, while
+    // ETHMAC_SETPARAM_RX_BUFFERS is enabled. Return status:
+    //   ZX_OK: The driver owns the netbuf until it returns it through complete_rx().
+    //   ZX_ERR_SHOULD_WAIT: The device has no room for another buffer until it completes one.
+    //   Other: The netbuf can't be used, such as because it is too small for a frame.
+    //
+    // Only valid on devices that advertise ETHMAC_FEATURE_RX_BUFFERS.
+    zx_status_t (*queue_rx)(void* ctx, uint32_t options, ethmac_netbuf_t* netbuf);
+
+    // Fill in |stats| with the counters of |queue|, which is below info.num_queues, or 0 on
+    // devices without ETHMAC_FEATURE_MULTIQUEUE.
+    //
+    // Optional.
+    zx_status_t (*get_queue_stats)(void* ctx, uint32_t queue, ethmac_queue_stats_t* stats);
 } ethmac_protocol_ops_t;
 
 typedef struct ethmac_protocol {
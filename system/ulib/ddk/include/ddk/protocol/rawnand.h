@@ -28,6 +28,12 @@ typedef struct raw_nand_protocol_ops {
                                     const void* oob_buffer, size_t oob_size, uint32_t nandpage);
     zx_status_t (*erase_block)(void* ctx, uint32_t nandpage);
     zx_status_t (*get_nand_info)(void* ctx, nand_info_t* out_info);
+    zx_status_t (*read_pages_hwecc)(void* ctx, uint32_t nandpage, uint32_t num_pages,
+                                    void* out_data_buffer, size_t data_size, void* out_oob_buffer,
+                                    size_t oob_size, uint32_t* out_ecc_correct);
+    zx_status_t (*write_pages_hwecc)(void* ctx, const void* data_buffer, size_t data_size,
+                                     const void* oob_buffer, size_t oob_size, uint32_t nandpage,
+                                     uint32_t num_pages);
 } raw_nand_protocol_ops_t;
 
 struct raw_nand_protocol {
@@ -61,5 +67,23 @@ static inline zx_status_t raw_nand_get_nand_info(const raw_nand_protocol_t* prot
                                                  nand_info_t* out_info) {
     return proto->ops->get_nand_info(proto->ctx, out_info);
 }
+// Read |num_pages| consecutive nand pages with hwecc. The data and oob of each page follow those
+// of the one before in the buffers. |out_ecc_correct| is the most bitflips corrected in any page.
+static inline zx_status_t raw_nand_read_pages_hwecc(const raw_nand_protocol_t* proto,
+                                                    uint32_t nandpage, uint32_t num_pages,
+                                                    void* out_data_buffer, size_t data_size,
+                                                    void* out_oob_buffer, size_t oob_size,
+                                                    uint32_t* out_ecc_correct) {
+    return proto->ops->read_pages_hwecc(proto->ctx, nandpage, num_pages, out_data_buffer,
+                                        data_size, out_oob_buffer, oob_size, out_ecc_correct);
+}
+// Write |num_pages| consecutive nand pages with hwecc.
+static inline zx_status_t raw_nand_write_pages_hwecc(const raw_nand_protocol_t* proto,
+                                                     const void* data_buffer, size_t data_size,
+                                                     const void* oob_buffer, size_t oob_size,
+                                                     uint32_t nandpage, uint32_t num_pages) {
+    return proto->ops->write_pages_hwecc(proto->ctx, data_buffer, data_size, oob_buffer, oob_size,
+                                         nandpage, num_pages);
+}
 
 __END_CDECLS;
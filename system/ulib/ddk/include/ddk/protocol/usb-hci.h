@@ -38,6 +38,7 @@ typedef struct usb_hci_protocol_ops {
     zx_status_t (*cancel_all)(void* ctx, uint32_t device_id, uint8_t ep_address);
     zx_status_t (*get_bti)(void* ctx, zx_handle_t* out_handle);
     size_t (*get_request_size)(void* ctx);
+    uint16_t (*get_stream_count)(void* ctx, uint32_t device_id, uint8_t ep_address);
 } usb_hci_protocol_ops_t;
 
 typedef struct usb_hci_protocol {
@@ -112,4 +113,10 @@ static inline size_t usb_hci_get_request_size(usb_hci_protocol_t* hci) {
     return hci->ops->get_request_size(hci->ctx);
 }
 
+// returns the number of bulk streams enabled on an endpoint, or zero if it doesn't use streams
+static inline uint16_t usb_hci_get_stream_count(usb_hci_protocol_t* hci, uint32_t device_id,
+                                                uint8_t ep_address) {
+    return hci->ops->get_stream_count(hci->ctx, device_id, ep_address);
+}
+
 __END_CDECLS;
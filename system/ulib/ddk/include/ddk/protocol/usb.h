@@ -35,6 +35,9 @@ typedef struct usb_header {
     zx_off_t length;
     // send zero length packet if length is multiple of max packet size
     bool send_zlp;
+    // bulk stream to transfer on, from 1 to usb_get_stream_count() for endpoints
+    // with streams enabled, and 0 otherwise
+    uint16_t stream_id;
 } usb_header_t;
 
 // response data
@@ -140,6 +143,7 @@ typedef struct {
     zx_status_t (*cancel_all)(void* ctx, uint8_t ep_address);
     uint64_t (*get_current_frame)(void* ctx);
     size_t (*get_request_size)(void* ctx);
+    uint16_t (*get_stream_count)(void* ctx, uint8_t ep_address);
 } usb_protocol_ops_t;
 
 typedef struct usb_protocol {
@@ -222,6 +226,14 @@ static inline size_t usb_get_max_transfer_size(const usb_protocol_t* usb, uint8_
     return usb->ops->get_max_transfer_size(usb->ctx, ep_address);
 }
 
+// Returns the number of bulk streams enabled on an endpoint, or zero if it doesn't use streams.
+// Endpoints are enabled with streams when their SuperSpeed endpoint companion descriptor
+// declares them and the host controller supports them, and requests queued on them must set
+// header.stream_id.
+static inline uint16_t usb_get_stream_count(const usb_protocol_t* usb, uint8_t ep_address) {
+    return usb->ops->get_stream_count(usb->ctx, ep_address);
+}
+
 // Returns the device ID for the device.
 // This ID is generated by and used internally by the USB HCI controller driver.
 static inline uint32_t usb_get_device_id(const usb_protocol_t* usb) {
@@ -162,10 +162,22 @@ public:
         ifc_->recv(cookie_, data, length, flags);
     }
 
+    void RecvQueue(uint32_t queue, void* data, size_t length, uint32_t flags) {
+        if (ifc_->recv_queue == nullptr) {
+            ifc_->recv(cookie_, data, length, flags);
+        } else {
+            ifc_->recv_queue(cookie_, queue, data, length, flags);
+        }
+    }
+
     void CompleteTx(ethmac_netbuf_t* netbuf, zx_status_t status) {
         ifc_->complete_tx(cookie_, netbuf, status);
     }
 
+    void CompleteRx(ethmac_netbuf_t* netbuf, size_t length, uint32_t flags) {
+        ifc_->complete_rx(cookie_, netbuf, length, flags);
+    }
+
 private:
     ethmac_ifc_t* ifc_;
     void* cookie_;
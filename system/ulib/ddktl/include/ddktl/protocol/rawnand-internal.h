@@ -27,6 +27,16 @@ DECLARE_HAS_MEMBER_FN_WITH_SIGNATURE(has_raw_nand_protocol_erase_block, RawNandE
                                      zx_status_t (C::*)(uint32_t nandpage));
 DECLARE_HAS_MEMBER_FN_WITH_SIGNATURE(has_raw_nand_protocol_get_nand_info, RawNandGetNandInfo,
                                      zx_status_t (C::*)(nand_info_t* out_info));
+DECLARE_HAS_MEMBER_FN_WITH_SIGNATURE(has_raw_nand_protocol_read_pages_hwecc, RawNandReadPagesHwecc,
+                                     zx_status_t (C::*)(uint32_t nandpage, uint32_t num_pages,
+                                                        void* out_data_buffer, size_t data_size,
+                                                        void* out_oob_buffer, size_t oob_size,
+                                                        uint32_t* out_ecc_correct));
+DECLARE_HAS_MEMBER_FN_WITH_SIGNATURE(has_raw_nand_protocol_write_pages_hwecc,
+                                     RawNandWritePagesHwecc,
+                                     zx_status_t (C::*)(const void* data_buffer, size_t data_size,
+                                                        const void* oob_buffer, size_t oob_size,
+                                                        uint32_t nandpage, uint32_t num_pages));
 
 template <typename D>
 constexpr void CheckRawNandProtocolSubclass() {
@@ -45,6 +55,16 @@ constexpr void CheckRawNandProtocolSubclass() {
     static_assert(internal::has_raw_nand_protocol_get_nand_info<D>::value,
                   "RawNandProtocol subclasses must implement "
                   "zx_status_t RawNandGetNandInfo(nand_info_t* out_info");
+    static_assert(internal::has_raw_nand_protocol_read_pages_hwecc<D>::value,
+                  "RawNandProtocol subclasses must implement "
+                  "zx_status_t RawNandReadPagesHwecc(uint32_t nandpage, uint32_t num_pages, "
+                  "void* out_data_buffer, size_t data_size, void* out_oob_buffer, size_t "
+                  "oob_size, uint32_t* out_ecc_correct");
+    static_assert(internal::has_raw_nand_protocol_write_pages_hwecc<D>::value,
+                  "RawNandProtocol subclasses must implement "
+                  "zx_status_t RawNandWritePagesHwecc(const void* data_buffer, size_t data_size, "
+                  "const void* oob_buffer, size_t oob_size, uint32_t nandpage, uint32_t "
+                  "num_pages");
 }
 
 } // namespace internal
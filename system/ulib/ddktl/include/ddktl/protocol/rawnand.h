@@ -51,6 +51,13 @@
 //
 //     zx_status_t RawNandGetNandInfo(nand_info_t* out_info);
 //
+//     zx_status_t RawNandReadPagesHwecc(uint32_t nandpage, uint32_t num_pages, void*
+//     out_data_buffer, size_t data_size, void* out_oob_buffer, size_t oob_size, uint32_t*
+//     out_ecc_correct);
+//
+//     zx_status_t RawNandWritePagesHwecc(const void* data_buffer, size_t data_size, const void*
+//     oob_buffer, size_t oob_size, uint32_t nandpage, uint32_t num_pages);
+//
 //     ...
 // };
 
@@ -65,6 +72,8 @@ public:
         raw_nand_protocol_ops_.write_page_hwecc = RawNandWritePageHwecc;
         raw_nand_protocol_ops_.erase_block = RawNandEraseBlock;
         raw_nand_protocol_ops_.get_nand_info = RawNandGetNandInfo;
+        raw_nand_protocol_ops_.read_pages_hwecc = RawNandReadPagesHwecc;
+        raw_nand_protocol_ops_.write_pages_hwecc = RawNandWritePagesHwecc;
     }
 
 protected:
@@ -94,6 +103,23 @@ private:
     static zx_status_t RawNandGetNandInfo(void* ctx, nand_info_t* out_info) {
         return static_cast<D*>(ctx)->RawNandGetNandInfo(out_info);
     }
+    // Read consecutive nand pages with hwecc.
+    static zx_status_t RawNandReadPagesHwecc(void* ctx, uint32_t nandpage, uint32_t num_pages,
+                                             void* out_data_buffer, size_t data_size,
+                                             void* out_oob_buffer, size_t oob_size,
+                                             uint32_t* out_ecc_correct) {
+        return static_cast<D*>(ctx)->RawNandReadPagesHwecc(nandpage, num_pages, out_data_buffer,
+                                                           data_size, out_oob_buffer, oob_size,
+                                                           out_ecc_correct);
+    }
+    // Write consecutive nand pages with hwecc.
+    static zx_status_t RawNandWritePagesHwecc(void* ctx, const void* data_buffer,
+                                              size_t data_size, const void* oob_buffer,
+                                              size_t oob_size, uint32_t nandpage,
+                                              uint32_t num_pages) {
+        return static_cast<D*>(ctx)->RawNandWritePagesHwecc(data_buffer, data_size, oob_buffer,
+                                                            oob_size, nandpage, num_pages);
+    }
 };
 
 class RawNandProtocolProxy {
@@ -125,6 +151,20 @@ public:
     // Erase nand block.
     zx_status_t EraseBlock(uint32_t nandpage) { return ops_->erase_block(ctx_, nandpage); }
     zx_status_t GetNandInfo(nand_info_t* out_info) { return ops_->get_nand_info(ctx_, out_info); }
+    // Read consecutive nand pages with hwecc.
+    zx_status_t ReadPagesHwecc(uint32_t nandpage, uint32_t num_pages, void* out_data_buffer,
+                               size_t data_size, void* out_oob_buffer, size_t oob_size,
+                               uint32_t* out_ecc_correct) {
+        return ops_->read_pages_hwecc(ctx_, nandpage, num_pages, out_data_buffer, data_size,
+                                      out_oob_buffer, oob_size, out_ecc_correct);
+    }
+    // Write consecutive nand pages with hwecc.
+    zx_status_t WritePagesHwecc(const void* data_buffer, size_t data_size,
+                                const void* oob_buffer, size_t oob_size, uint32_t nandpage,
+                                uint32_t num_pages) {
+        return ops_->write_pages_hwecc(ctx_, data_buffer, data_size, oob_buffer, oob_size,
+                                       nandpage, num_pages);
+    }
 
 private:
     raw_nand_protocol_ops_t* ops_;
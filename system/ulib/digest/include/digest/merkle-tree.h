@@ -67,6 +67,18 @@ public:
                               const void* tree, size_t tree_len, size_t offset,
                               size_t length, const Digest& digest);
 
+    // These are the same as |Create| and |Verify|, except that the nodes of
+    // each level of the tree are split between up to |threads| threads.
+    // Levels with too few nodes to be worth splitting are hashed on the
+    // calling thread.
+    static zx_status_t CreateParallel(const void* data, size_t data_len,
+                                      void* tree, size_t tree_len,
+                                      Digest* digest, size_t threads);
+    static zx_status_t VerifyParallel(const void* data, size_t data_len,
+                                      const void* tree, size_t tree_len,
+                                      size_t offset, size_t length,
+                                      const Digest& digest, size_t threads);
+
     // The stateful instance methods below are only needed when creating a
     // Merkle tree using the Init/Update/Final methods.
     MerkleTree();
@@ -102,10 +114,12 @@ private:
     // offset and length.  It checks integrity using next level up of the given
     // Merkle tree. |tree_len| must be at least as much as returned by
     // |GetTreeLength(data_len)|.  |offset| and |length| must describe a range
-    // wholly within |data_len|.
+    // wholly within |data_len|.  The nodes are split between up to |threads|
+    // threads.
     static zx_status_t VerifyLevel(const void* data, size_t data_len,
                                    const void* tree, size_t offset,
-                                   size_t length, uint64_t level);
+                                   size_t length, uint64_t level,
+                                   size_t threads);
 
     // See CreateFinal.  This implements that method, with an extra parameter to
     // allow levels other than the bottommost to be padded.
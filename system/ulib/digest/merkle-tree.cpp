@@ -4,6 +4,7 @@
 
 #include <digest/merkle-tree.h>
 
+#include <pthread.h>
 #include <stdint.h>
 #include <string.h>
 
@@ -94,6 +95,102 @@ size_t NextAligned(size_t length) {
     return fbl::round_up(NextLength(length), MerkleTree::kNodeSize);
 }
 
+////////
+// Helper functions for hashing a level of the tree on several threads.
+
+// The fewest nodes worth handing to a thread of their own.
+const size_t kMinNodesPerThread = 32;
+
+// The most threads a level is split between.
+const size_t kMaxThreads = 16;
+
+// A run of nodes in one level of the tree.  The digest of each node is either
+// written to |out| or checked against |expected|, whichever isn't null.
+struct NodeRun {
+    const uint8_t* data;
+    size_t data_len;
+    uint64_t level;
+    size_t offset;
+    size_t length;
+    uint8_t* out;
+    const uint8_t* expected;
+    zx_status_t rc;
+    pthread_t thread;
+};
+
+zx_status_t HashRun(const NodeRun* run) {
+    zx_status_t rc;
+    Digest actual;
+    size_t offset = run->offset;
+    const size_t end = run->offset + run->length;
+    size_t digest_off = 0;
+    while (offset < end) {
+        if ((rc = DigestInit(&actual, offset | run->level, run->data_len - offset)) != ZX_OK) {
+            return rc;
+        }
+        offset += DigestUpdate(&actual, run->data + offset, offset, end - offset);
+        DigestFinal(&actual, offset);
+        if (run->out) {
+            actual.CopyTo(run->out + digest_off, Digest::kLength);
+        } else if (actual != run->expected + digest_off) {
+            return ZX_ERR_IO_DATA_INTEGRITY;
+        }
+        digest_off += Digest::kLength;
+    }
+    return ZX_OK;
+}
+
+void* HashRunThread(void* arg) {
+    NodeRun* run = static_cast<NodeRun*>(arg);
+    run->rc = HashRun(run);
+    return nullptr;
+}
+
+// Hashes the nodes of a level between the node-aligned |offset| and |offset +
+// length|, splitting them between up to |threads| threads.  |out| and
+// |expected| are as in NodeRun, and start with the node at |offset|.
+zx_status_t HashNodes(const uint8_t* data, size_t data_len, uint64_t level, size_t offset,
+                      size_t length, uint8_t* out, const uint8_t* expected, size_t threads) {
+    size_t nodes = fbl::round_up(length, MerkleTree::kNodeSize) / MerkleTree::kNodeSize;
+    threads = fbl::min(fbl::min(threads, kMaxThreads), nodes / kMinNodesPerThread);
+    if (threads < 2) {
+        NodeRun run = {data, data_len, level, offset, length, out, expected, ZX_OK, {}};
+        return HashRun(&run);
+    }
+
+    NodeRun runs[kMaxThreads];
+    size_t per_thread = (nodes + threads - 1) / threads;
+    for (size_t i = 0; i < threads; ++i) {
+        size_t first = i * per_thread;
+        size_t run_off = first * MerkleTree::kNodeSize;
+        runs[i] = {data, data_len, level, offset + run_off,
+                   fbl::min(per_thread * MerkleTree::kNodeSize, length - run_off),
+                   out ? out + first * Digest::kLength : nullptr,
+                   expected ? expected + first * Digest::kLength : nullptr,
+                   ZX_OK, {}};
+    }
+    // The calling thread takes the first run, and any that couldn't be
+    // handed to a thread of their own.
+    size_t started = 1;
+    while (started < threads &&
+           pthread_create(&runs[started].thread, nullptr, HashRunThread, &runs[started]) == 0) {
+        ++started;
+    }
+    runs[0].rc = HashRun(&runs[0]);
+    for (size_t i = started; i < threads; ++i) {
+        runs[i].rc = HashRun(&runs[i]);
+    }
+    for (size_t i = 1; i < started; ++i) {
+        pthread_join(runs[i].thread, nullptr);
+    }
+    for (size_t i = 0; i < threads; ++i) {
+        if (runs[i].rc != ZX_OK) {
+            return runs[i].rc;
+        }
+    }
+    return ZX_OK;
+}
+
 } // namespace
 
 ////////
@@ -116,6 +213,47 @@ zx_status_t MerkleTree::Create(const void* data, size_t data_len, void* tree, si
     return ZX_OK;
 }
 
+zx_status_t MerkleTree::CreateParallel(const void* data, size_t data_len, void* tree,
+                                       size_t tree_len, Digest* digest, size_t threads) {
+    zx_status_t rc;
+    // Must have data to read, a tree to fill if expecting more than one
+    // digest, and a root to write.
+    if ((!data && data_len != 0) || (!tree && data_len > kNodeSize) || !digest) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+    if (tree_len < GetTreeLength(data_len)) {
+        return ZX_ERR_BUFFER_TOO_SMALL;
+    }
+    // Hash each level into the next one up, padding the digests out to a
+    // whole node.
+    const uint8_t* in = static_cast<const uint8_t*>(data);
+    uint8_t* out = static_cast<uint8_t*>(tree);
+    uint64_t level = 0;
+    while (data_len > kNodeSize) {
+        if ((rc = HashNodes(in, data_len, level, 0, data_len, out, nullptr, threads)) != ZX_OK) {
+            return rc;
+        }
+        size_t next_len = NextLength(data_len);
+        data_len = NextAligned(data_len);
+        memset(out + next_len, 0, data_len - next_len);
+        in = out;
+        out += data_len;
+        ++level;
+    }
+    // Hash the top level into the root.
+    Digest actual;
+    if ((rc = DigestInit(&actual, level, data_len)) != ZX_OK) {
+        return rc;
+    }
+    if (data_len != 0) {
+        DigestUpdate(&actual, in, 0, data_len);
+    }
+    DigestFinal(&actual, data_len);
+    *digest = actual.AcquireBytes();
+    actual.ReleaseBytes();
+    return ZX_OK;
+}
+
 MerkleTree::MerkleTree() : initialized_(false), next_(nullptr), level_(0), offset_(0), length_(0) {}
 
 MerkleTree::~MerkleTree() {}
@@ -246,12 +384,18 @@ zx_status_t MerkleTree::CreateFinalInternal(const void* data, void* tree, Digest
 
 zx_status_t MerkleTree::Verify(const void* data, size_t data_len, const void* tree, size_t tree_len,
                                size_t offset, size_t length, const Digest& root) {
+    return VerifyParallel(data, data_len, tree, tree_len, offset, length, root, 1);
+}
+
+zx_status_t MerkleTree::VerifyParallel(const void* data, size_t data_len, const void* tree,
+                                       size_t tree_len, size_t offset, size_t length,
+                                       const Digest& root, size_t threads) {
     uint64_t level = 0;
     size_t root_len = data_len;
     while (data_len > kNodeSize) {
         zx_status_t rc;
         // Verify the data in this level.
-        if ((rc = VerifyLevel(data, data_len, tree, offset, length, level)) != ZX_OK) {
+        if ((rc = VerifyLevel(data, data_len, tree, offset, length, level, threads)) != ZX_OK) {
             return rc;
         }
         // Ascend to the next level up.
@@ -289,8 +433,8 @@ zx_status_t MerkleTree::VerifyRoot(const void* data, size_t root_len, uint64_t l
 }
 
 zx_status_t MerkleTree::VerifyLevel(const void* data, size_t data_len, const void* tree,
-                                    size_t offset, size_t length, uint64_t level) {
-    zx_status_t rc;
+                                    size_t offset, size_t length, uint64_t level,
+                                    size_t threads) {
     ZX_DEBUG_ASSERT(offset + length >= offset);
     // Must have more than one node of data and digests to check against.
     if (!data || data_len <= kNodeSize || !tree) {
@@ -304,26 +448,11 @@ zx_status_t MerkleTree::VerifyLevel(const void* data, size_t data_len, const voi
     offset -= offset % kNodeSize;
     size_t finish = fbl::round_up(offset + length, kNodeSize);
     length = fbl::min(finish, data_len) - offset;
-    const uint8_t* in = static_cast<const uint8_t*>(data) + offset;
     // The digests are in the next level up.
-    Digest actual;
     const uint8_t* expected = static_cast<const uint8_t*>(tree) + (offset / kDigestsPerNode);
     // Check the data of this level against the digests.
-    while (length > 0) {
-        if ((rc = DigestInit(&actual, offset | level, data_len - offset)) != ZX_OK) {
-            return rc;
-        }
-        size_t chunk = DigestUpdate(&actual, in, offset, length);
-        in += chunk;
-        offset += chunk;
-        length -= chunk;
-        DigestFinal(&actual, offset);
-        if (actual != expected) {
-            return ZX_ERR_IO_DATA_INTEGRITY;
-        }
-        expected += Digest::kLength;
-    }
-    return ZX_OK;
+    return HashNodes(static_cast<const uint8_t*>(data), data_len, level, offset, length,
+                     nullptr, expected, threads);
 }
 
 } // namespace digest
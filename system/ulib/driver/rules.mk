@@ -31,6 +31,13 @@ MODULE_HEADER_DEPS := \
     system/ulib/trace-provider
 endif
 
+# devhost.cpp records a trace event for each driver bind, which compiles
+# away when tracing is disabled.
+MODULE_HEADER_DEPS += system/ulib/trace system/ulib/trace-engine
+
+# and a boot timeline span, written straight to ktrace.
+MODULE_HEADER_DEPS += system/ulib/zircon-internal
+
 MODULE_FIDL_LIBS := \
     system/fidl/fuchsia-io \
 
@@ -0,0 +1,193 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <fbl/alloc_checker.h>
+#include <fbl/macros.h>
+#include <fbl/new.h>
+#include <fbl/type_support.h>
+#include <zircon/assert.h>
+
+namespace fbl {
+
+// Arena is a monotonic allocator for objects which all die at the same
+// time, such as the temporaries used while handling a single request.
+//
+// Allocate() carves memory out of large chunks by bumping a pointer, and
+// individual allocations are never freed.  Reset() frees every allocation
+// at once, in O(1): the chunks are kept and reused by later allocations, so
+// an arena which is reset after each request stops touching the heap once
+// it has grown to fit the largest request.  Allocations bigger than a
+// quarter of a chunk get a block of their own, which Reset() returns to the
+// heap.
+//
+// Destructors are not run for objects allocated in an arena, so they should
+// either be trivially destructible or be destroyed by hand before Reset().
+//
+// Arena is not thread-safe.
+//
+// Use it like this:
+//
+//     fbl::Arena arena;
+//     for (;;) {
+//         Request* request = arena.New<Request>();
+//         if (request == nullptr) {
+//             // handle allocation failure
+//         }
+//         ...
+//         arena.Reset();
+//     }
+class Arena {
+public:
+    static constexpr size_t kDefaultChunkSize = 16 * 1024;
+
+    explicit Arena(size_t chunk_size = kDefaultChunkSize)
+        : chunk_size_(chunk_size) {}
+
+    ~Arena() {
+        Reset();
+        FreeBlocks(free_chunks_);
+    }
+
+    // Returns |size| bytes aligned to |alignment|, or nullptr if out of
+    // memory.  |alignment| must be a power of two no greater than
+    // alignof(max_align_t).
+    void* Allocate(size_t size, size_t alignment = alignof(max_align_t)) {
+        ZX_DEBUG_ASSERT((alignment & (alignment - 1)) == 0);
+        ZX_DEBUG_ASSERT(alignment <= alignof(max_align_t));
+        uintptr_t start = (cur_ + alignment - 1) & ~(alignment - 1);
+        if (cur_ != 0 && start <= end_ && size <= end_ - start) {
+            cur_ = start + size;
+            return reinterpret_cast<void*>(start);
+        }
+        return AllocateSlow(size);
+    }
+
+    // Constructs a T in the arena, or returns nullptr if out of memory.
+    template <typename T, typename... Args>
+    T* New(Args&&... args) {
+        void* object = Allocate(sizeof(T), alignof(T));
+        return object != nullptr ? new (object) T(fbl::forward<Args>(args)...) : nullptr;
+    }
+
+    // Frees everything allocated in the arena.
+    void Reset() {
+        if (chunks_ != nullptr) {
+            oldest_chunk_->next = free_chunks_;
+            free_chunks_ = chunks_;
+            chunks_ = nullptr;
+            oldest_chunk_ = nullptr;
+        }
+        FreeBlocks(large_blocks_);
+        large_blocks_ = nullptr;
+        cur_ = 0;
+        end_ = 0;
+    }
+
+private:
+    // The header of a chunk or of the block for a large allocation.  Its
+    // alignment keeps the memory after it maximally aligned.
+    struct alignas(max_align_t) Block {
+        Block* next;
+
+        void* data() { return this + 1; }
+    };
+
+    static Block* NewBlock(size_t size) {
+        if (size > SIZE_MAX - sizeof(Block)) {
+            return nullptr;
+        }
+        AllocChecker ac;
+        char* memory = new (&ac) char[sizeof(Block) + size];
+        if (!ac.check()) {
+            return nullptr;
+        }
+        return new (memory) Block{nullptr};
+    }
+
+    static void FreeBlocks(Block* block) {
+        while (block != nullptr) {
+            Block* next = block->next;
+            delete[] reinterpret_cast<char*>(block);
+            block = next;
+        }
+    }
+
+    void* AllocateSlow(size_t size) {
+        if (size > chunk_size_ / 4) {
+            Block* block = NewBlock(size);
+            if (block == nullptr) {
+                return nullptr;
+            }
+            block->next = large_blocks_;
+            large_blocks_ = block;
+            return block->data();
+        }
+
+        Block* chunk = free_chunks_;
+        if (chunk != nullptr) {
+            free_chunks_ = chunk->next;
+        } else {
+            chunk = NewBlock(chunk_size_);
+            if (chunk == nullptr) {
+                return nullptr;
+            }
+        }
+        chunk->next = chunks_;
+        if (chunks_ == nullptr) {
+            oldest_chunk_ = chunk;
+        }
+        chunks_ = chunk;
+
+        // The start of a chunk is suitably aligned for anything.
+        void* object = chunk->data();
+        cur_ = reinterpret_cast<uintptr_t>(object) + size;
+        end_ = reinterpret_cast<uintptr_t>(object) + chunk_size_;
+        return object;
+    }
+
+    DISALLOW_COPY_ASSIGN_AND_MOVE(Arena);
+
+    const size_t chunk_size_;
+
+    // The free space in the current chunk, or zero if there is none.
+    uintptr_t cur_ = 0;
+    uintptr_t end_ = 0;
+
+    // The chunks in use, newest (and current) first.
+    Block* chunks_ = nullptr;
+    Block* oldest_chunk_ = nullptr;
+    // Chunks freed by Reset(), for reuse.
+    Block* free_chunks_ = nullptr;
+    // Allocations too big for a chunk.
+    Block* large_blocks_ = nullptr;
+};
+
+// Allocator traits for fbl::Vector which allocate from an Arena.
+//
+// The vector's storage is freed with the arena, including the buffers it
+// outgrows, so reserve() the expected size up front where possible.
+//
+//     fbl::Vector<Entry, fbl::ArenaAllocatorTraits> entries(
+//         fbl::ArenaAllocatorTraits(&arena));
+class ArenaAllocatorTraits {
+public:
+    explicit ArenaAllocatorTraits(Arena* arena)
+        : arena_(arena) {}
+
+    void* Allocate(size_t size) {
+        return arena_->Allocate(size);
+    }
+
+    void Deallocate(void* object) {}
+
+private:
+    Arena* arena_;
+};
+
+} // namespace fbl
@@ -0,0 +1,438 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <fbl/alloc_checker.h>
+#include <fbl/macros.h>
+#include <fbl/new.h>
+#include <fbl/type_support.h>
+#include <fbl/vector.h>
+#include <zircon/assert.h>
+
+namespace fbl {
+
+// DefaultFlatHashTraits define how FlatHashMap hashes and compares keys.
+//
+// A class or struct used as the hash traits of a FlatHashMap must define...
+//
+// GetHash : A static method which takes a constant reference to a key and
+//           returns a size_t.  All of its bits are used, so it should be
+//           well mixed: the map does not mod by a prime.
+// EqualTo : A static method which takes constant references to two keys and
+//           returns true if they are equal.
+//
+// The default traits work for integer and pointer keys, and mix them with
+// the MurmurHash3 finalizer.
+template <typename KeyType>
+struct DefaultFlatHashTraits {
+    static size_t GetHash(const KeyType& key) {
+        static_assert(is_integral<KeyType>::value || is_pointer<KeyType>::value,
+                      "Keys other than integers and pointers need their own hash traits");
+        uint64_t h = (uint64_t)key;
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ull;
+        h ^= h >> 33;
+        return static_cast<size_t>(h);
+    }
+    static bool EqualTo(const KeyType& key1, const KeyType& key2) { return key1 == key2; }
+};
+
+// FlatHashMap is a hash map which stores its entries inline in a single
+// array, using open addressing, rather than one node per entry.  Lookups
+// usually touch one cache line of metadata and one entry, with no pointer
+// chasing, and inserting does not allocate except to grow the table.
+//
+// The table is split into groups of eight slots.  A control byte for each
+// slot holds either 7 bits of the hash of its key, or a marker for an empty
+// or deleted slot.  A lookup loads the eight control bytes of a group as one
+// 64-bit word and compares them all against the key's hash bits at once, so
+// it only compares keys for slots which probably match.  Groups are probed
+// in a triangular sequence until one with an empty slot is reached.
+//
+// Like fbl::Vector, FlatHashMap reports allocation failures through an
+// AllocChecker rather than aborting, and AllocatorTraits controls where its
+// storage comes from.
+//
+// Pointers to values are invalidated by inserting (which may grow the table)
+// and by erasing that key.
+template <typename KeyType,
+          typename ValueType,
+          typename HashTraits = DefaultFlatHashTraits<KeyType>,
+          typename AllocatorTraits = DefaultAllocatorTraits>
+class FlatHashMap : private AllocatorTraits {
+private:
+    template <typename MapType, typename EntryType>
+    class iterator_impl;
+
+public:
+    struct Entry {
+        KeyType key;
+        ValueType value;
+    };
+
+    using iterator = iterator_impl<FlatHashMap, Entry>;
+    using const_iterator = iterator_impl<const FlatHashMap, const Entry>;
+
+    DISALLOW_COPY_AND_ASSIGN_ALLOW_MOVE(FlatHashMap);
+
+    constexpr FlatHashMap() {}
+
+    explicit FlatHashMap(const AllocatorTraits& allocator)
+        : AllocatorTraits(allocator) {}
+
+    FlatHashMap(FlatHashMap&& other)
+        : AllocatorTraits(other.allocator()) {
+        TakeFrom(&other);
+    }
+
+    FlatHashMap& operator=(FlatHashMap&& other) {
+        if (this != &other) {
+            reset();
+            allocator() = other.allocator();
+            TakeFrom(&other);
+        }
+        return *this;
+    }
+
+    ~FlatHashMap() { reset(); }
+
+    size_t size() const { return size_; }
+    bool is_empty() const { return size_ == 0; }
+    size_t capacity() const { return capacity_; }
+
+    iterator begin() { return iterator(this, NextFull(0)); }
+    iterator end() { return iterator(this, capacity_); }
+    const_iterator begin() const { return const_iterator(this, NextFull(0)); }
+    const_iterator end() const { return const_iterator(this, capacity_); }
+
+    // Returns the value for |key|, or nullptr if there is none.
+    ValueType* find(const KeyType& key) {
+        size_t index = FindIndex(key, HashTraits::GetHash(key));
+        return index != kNotFound ? &slots_[index].value : nullptr;
+    }
+
+    const ValueType* find(const KeyType& key) const {
+        return const_cast<FlatHashMap*>(this)->find(key);
+    }
+
+    // If |key| is already in the map, returns its value and discards |value|.
+    // Otherwise inserts |value| for |key| and returns it.  Returns nullptr
+    // if the table needed to grow and couldn't.
+    // |ac| must not be null.
+    ValueType* insert_or_find(KeyType key, ValueType value, AllocChecker* ac) {
+        bool inserted;
+        size_t index = FindOrPrepareInsert(key, &inserted, ac);
+        if (index == kNotFound) {
+            return nullptr;
+        }
+        if (inserted) {
+            new (&slots_[index]) Entry{fbl::move(key), fbl::move(value)};
+        }
+        return &slots_[index].value;
+    }
+
+    // Sets the value for |key| to |value|, whether or not it was already in
+    // the map.  Returns nullptr if the table needed to grow and couldn't.
+    // |ac| must not be null.
+    ValueType* insert_or_replace(KeyType key, ValueType value, AllocChecker* ac) {
+        bool inserted;
+        size_t index = FindOrPrepareInsert(key, &inserted, ac);
+        if (index == kNotFound) {
+            return nullptr;
+        }
+        if (inserted) {
+            new (&slots_[index]) Entry{fbl::move(key), fbl::move(value)};
+        } else {
+            slots_[index].value = fbl::move(value);
+        }
+        return &slots_[index].value;
+    }
+
+    // Removes |key| from the map.  Returns false if it wasn't there.
+    bool erase(const KeyType& key) {
+        size_t index = FindIndex(key, HashTraits::GetHash(key));
+        if (index == kNotFound) {
+            return false;
+        }
+        slots_[index].~Entry();
+        --size_;
+        // A probe only moves on from a group which has no empty slots, so
+        // if this group already has one, nothing can have probed past this
+        // slot and it can just become empty.  Otherwise it must stay a
+        // tombstone to keep later entries in the probe sequence reachable.
+        size_t group = index & ~(kGroupWidth - 1);
+        if (MatchEmpty(LoadGroup(group)) != 0) {
+            ctrl_[index] = kEmpty;
+        } else {
+            ctrl_[index] = kDeleted;
+            ++tombstones_;
+        }
+        return true;
+    }
+
+    // Removes every entry, keeping the table's storage.
+    void clear() {
+        DestroyEntries();
+        if (ctrl_ != nullptr) {
+            memset(ctrl_, kEmpty, capacity_);
+        }
+        size_ = 0;
+        tombstones_ = 0;
+    }
+
+    // Removes every entry and frees the table's storage.
+    void reset() {
+        DestroyEntries();
+        AllocatorTraits::Deallocate(ctrl_);
+        ctrl_ = nullptr;
+        slots_ = nullptr;
+        capacity_ = 0;
+        size_ = 0;
+        tombstones_ = 0;
+    }
+
+    // Grows the table so that it holds at least |count| entries without
+    // growing again.
+    // |ac| must not be null.
+    void reserve(size_t count, AllocChecker* ac) {
+        if (count <= MaxLoad(capacity_)) {
+            ac->arm(0u, true);
+            return;
+        }
+        Rehash(CapacityFor(count), ac);
+    }
+
+private:
+    static constexpr size_t kGroupWidth = 8;
+    static constexpr size_t kNotFound = SIZE_MAX;
+
+    // Control bytes.  A full slot holds the low 7 bits of its key's hash.
+    static constexpr uint8_t kEmpty = 0x80;
+    static constexpr uint8_t kDeleted = 0xfe;
+
+    static constexpr uint64_t kLsbs = 0x0101010101010101ull;
+    static constexpr uint64_t kMsbs = 0x8080808080808080ull;
+
+    static_assert(alignof(Entry) <= alignof(max_align_t),
+                  "FlatHashMap entries can't be overaligned");
+
+    template <typename MapType, typename EntryType>
+    class iterator_impl {
+    public:
+        iterator_impl() {}
+
+        bool operator==(const iterator_impl& other) const { return index_ == other.index_; }
+        bool operator!=(const iterator_impl& other) const { return index_ != other.index_; }
+
+        iterator_impl& operator++() {
+            index_ = map_->NextFull(index_ + 1);
+            return *this;
+        }
+
+        EntryType& operator*() const { return map_->slots_[index_]; }
+        EntryType* operator->() const { return &map_->slots_[index_]; }
+
+    private:
+        friend class FlatHashMap;
+
+        iterator_impl(MapType* map, size_t index)
+            : map_(map), index_(index) {}
+
+        MapType* map_ = nullptr;
+        size_t index_ = 0;
+    };
+
+    AllocatorTraits& allocator() { return *this; }
+
+    static size_t H1(size_t hash) { return hash >> 7; }
+    static uint8_t H2(size_t hash) { return static_cast<uint8_t>(hash & 0x7f); }
+
+    // The table is kept at most 7/8 full, counting tombstones.
+    static size_t MaxLoad(size_t capacity) { return capacity - capacity / 8; }
+
+    static size_t CapacityFor(size_t count) {
+        size_t capacity = kGroupWidth;
+        while (MaxLoad(capacity) < count) {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+
+    static size_t SlotsOffset(size_t capacity) {
+        return (capacity + alignof(Entry) - 1) & ~(alignof(Entry) - 1);
+    }
+
+    uint64_t LoadGroup(size_t group) const {
+        uint64_t word;
+        memcpy(&word, &ctrl_[group], sizeof(word));
+        return word;
+    }
+
+    // Each of these returns a word with the top bit of each matching byte
+    // set.  MatchHash() may also report a byte just above a real match
+    // (when the subtraction borrows), which only costs a key comparison.
+    static uint64_t MatchHash(uint64_t word, uint8_t h2) {
+        uint64_t x = word ^ (kLsbs * h2);
+        return (x - kLsbs) & ~x & kMsbs;
+    }
+    static uint64_t MatchEmpty(uint64_t word) {
+        // kEmpty is the only control byte with bit 7 set and bit 1 clear.
+        return word & ~(word << 6) & kMsbs;
+    }
+    static uint64_t MatchEmptyOrDeleted(uint64_t word) { return word & kMsbs; }
+
+    static size_t LowestMatch(uint64_t mask) {
+        return static_cast<size_t>(__builtin_ctzll(mask)) / 8;
+    }
+
+    size_t NextFull(size_t index) const {
+        while (index < capacity_ && (ctrl_[index] & 0x80) != 0) {
+            ++index;
+        }
+        return index;
+    }
+
+    size_t FindIndex(const KeyType& key, size_t hash) const {
+        if (capacity_ == 0) {
+            return kNotFound;
+        }
+        size_t group_mask = capacity_ / kGroupWidth - 1;
+        size_t group = H1(hash) & group_mask;
+        for (size_t step = 1;; ++step) {
+            uint64_t word = LoadGroup(group * kGroupWidth);
+            for (uint64_t match = MatchHash(word, H2(hash)); match != 0; match &= match - 1) {
+                size_t index = group * kGroupWidth + LowestMatch(match);
+                if (HashTraits::EqualTo(slots_[index].key, key)) {
+                    return index;
+                }
+            }
+            if (MatchEmpty(word) != 0) {
+                return kNotFound;
+            }
+            group = (group + step) & group_mask;
+        }
+    }
+
+    // Returns the first empty or deleted slot in |hash|'s probe sequence,
+    // which must exist.
+    size_t FindInsertIndex(size_t hash) const {
+        size_t group_mask = capacity_ / kGroupWidth - 1;
+        size_t group = H1(hash) & group_mask;
+        for (size_t step = 1;; ++step) {
+            uint64_t match = MatchEmptyOrDeleted(LoadGroup(group * kGroupWidth));
+            if (match != 0) {
+                return group * kGroupWidth + LowestMatch(match);
+            }
+            group = (group + step) & group_mask;
+        }
+    }
+
+    // Returns the slot holding |key|, or claims and returns a slot for it,
+    // setting |*inserted|.  The caller constructs the entry in a claimed
+    // slot.  Returns kNotFound if the table couldn't grow.
+    size_t FindOrPrepareInsert(const KeyType& key, bool* inserted, AllocChecker* ac) {
+        size_t hash = HashTraits::GetHash(key);
+        size_t index = FindIndex(key, hash);
+        if (index != kNotFound) {
+            *inserted = false;
+            ac->arm(0u, true);
+            return index;
+        }
+
+        if (size_ + tombstones_ >= MaxLoad(capacity_)) {
+            // If tombstones make up much of the load, rehashing at the
+            // same capacity is enough to clear them out.
+            size_t capacity = size_ < MaxLoad(capacity_) / 2 ? capacity_
+                                                              : CapacityFor(size_ + 1);
+            if (!Rehash(capacity, ac)) {
+                return kNotFound;
+            }
+        } else {
+            ac->arm(0u, true);
+        }
+
+        index = FindInsertIndex(hash);
+        if (ctrl_[index] == kDeleted) {
+            --tombstones_;
+        }
+        ctrl_[index] = H2(hash);
+        ++size_;
+        *inserted = true;
+        return index;
+    }
+
+    bool Rehash(size_t capacity, AllocChecker* ac) {
+        ZX_DEBUG_ASSERT(capacity >= kGroupWidth);
+        ZX_DEBUG_ASSERT((capacity & (capacity - 1)) == 0);
+        ZX_DEBUG_ASSERT(MaxLoad(capacity) >= size_);
+
+        void* memory = AllocatorTraits::Allocate(SlotsOffset(capacity) +
+                                                 capacity * sizeof(Entry));
+        if (memory == nullptr) {
+            ac->arm(1u, false);
+            return false;
+        }
+
+        uint8_t* old_ctrl = ctrl_;
+        Entry* old_slots = slots_;
+        size_t old_capacity = capacity_;
+
+        ctrl_ = static_cast<uint8_t*>(memory);
+        slots_ = reinterpret_cast<Entry*>(ctrl_ + SlotsOffset(capacity));
+        capacity_ = capacity;
+        tombstones_ = 0;
+        memset(ctrl_, kEmpty, capacity);
+
+        for (size_t i = 0; i < old_capacity; ++i) {
+            if ((old_ctrl[i] & 0x80) == 0) {
+                size_t hash = HashTraits::GetHash(old_slots[i].key);
+                size_t index = FindInsertIndex(hash);
+                ctrl_[index] = H2(hash);
+                new (&slots_[index]) Entry(fbl::move(old_slots[i]));
+                old_slots[i].~Entry();
+            }
+        }
+
+        AllocatorTraits::Deallocate(old_ctrl);
+        ac->arm(0u, true);
+        return true;
+    }
+
+    void DestroyEntries() {
+        for (size_t i = 0; i < capacity_; ++i) {
+            if ((ctrl_[i] & 0x80) == 0) {
+                slots_[i].~Entry();
+            }
+        }
+    }
+
+    void TakeFrom(FlatHashMap* other) {
+        ctrl_ = other->ctrl_;
+        slots_ = other->slots_;
+        capacity_ = other->capacity_;
+        size_ = other->size_;
+        tombstones_ = other->tombstones_;
+        other->ctrl_ = nullptr;
+        other->slots_ = nullptr;
+        other->capacity_ = 0;
+        other->size_ = 0;
+        other->tombstones_ = 0;
+    }
+
+    // One allocation holds |capacity_| control bytes followed by the slots.
+    uint8_t* ctrl_ = nullptr;
+    Entry* slots_ = nullptr;
+    size_t capacity_ = 0;
+    size_t size_ = 0;
+    size_t tombstones_ = 0;
+};
+
+} // namespace fbl
@@ -0,0 +1,417 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include <fbl/alloc_checker.h>
+#include <fbl/macros.h>
+#include <fbl/new.h>
+#include <fbl/type_support.h>
+#include <fbl/vector.h>
+#include <zircon/assert.h>
+
+namespace fbl {
+
+// InlineVector<> is a Vector<> with room for N elements inside the object
+// itself.  It only allocates once it grows past N elements, and gives the
+// heap storage back when it shrinks below N again, so a vector which
+// usually holds a handful of elements never touches the heap.
+//
+// It has the same interface as Vector<>, including its AllocChecker
+// variants.  Unlike Vector<>, moving an InlineVector<> whose elements are
+// stored inline moves each element, and pointers to the elements do not
+// survive the move.
+template <typename T, size_t N, typename AllocatorTraits = DefaultAllocatorTraits>
+class InlineVector : private AllocatorTraits {
+public:
+    static_assert(N > 0, "InlineVector needs an inline capacity; use Vector instead");
+
+    // move semantics only
+    DISALLOW_COPY_AND_ASSIGN_ALLOW_MOVE(InlineVector);
+
+    InlineVector()
+        : ptr_(inline_ptr()), size_(0U), capacity_(N) {}
+
+    explicit InlineVector(const AllocatorTraits& allocator)
+        : AllocatorTraits(allocator), ptr_(inline_ptr()), size_(0U), capacity_(N) {}
+
+    InlineVector(InlineVector&& other)
+        : AllocatorTraits(other.allocator()), ptr_(inline_ptr()), size_(0U), capacity_(N) {
+        take(other);
+    }
+
+    InlineVector& operator=(InlineVector&& other) {
+        if (this != &other) {
+            // The old storage is freed with the old allocator.
+            reset();
+            allocator() = other.allocator();
+            take(other);
+        }
+        return *this;
+    }
+
+    ~InlineVector() {
+        reset();
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    size_t capacity() const {
+        return capacity_;
+    }
+
+    static constexpr size_t inline_capacity() {
+        return N;
+    }
+
+    // Returns true if the elements are stored inside the vector rather
+    // than on the heap.
+    bool is_inline() const {
+        return ptr_ == inline_ptr();
+    }
+
+    // Reserve enough size to hold at least capacity elements.
+    void reserve(size_t capacity, AllocChecker* ac) {
+        if (capacity <= capacity_) {
+            ac->arm(0u, true);
+            return;
+        }
+        reallocate(capacity, ac);
+    }
+
+#ifndef _KERNEL
+    void reserve(size_t capacity) {
+        if (capacity <= capacity_) {
+            return;
+        }
+        reallocate(capacity);
+    }
+#endif // _KERNEL
+
+    // Destroys the elements and frees any heap storage.
+    void reset() {
+        while (size_ > 0) {
+            ptr_[--size_].~T();
+        }
+        if (!is_inline()) {
+            AllocatorTraits::Deallocate(ptr_);
+            ptr_ = inline_ptr();
+            capacity_ = N;
+        }
+    }
+
+    void push_back(T&& value, AllocChecker* ac) {
+        push_back_internal(fbl::move(value), ac);
+    }
+
+    void push_back(const T& value, AllocChecker* ac) {
+        push_back_internal(value, ac);
+    }
+
+#ifndef _KERNEL
+    void push_back(T&& value) {
+        push_back_internal(fbl::move(value));
+    }
+
+    void push_back(const T& value) {
+        push_back_internal(value);
+    }
+#endif // _KERNEL
+
+    void insert(size_t index, T&& value, AllocChecker* ac) {
+        insert_internal(index, fbl::move(value), ac);
+    }
+
+    void insert(size_t index, const T& value, AllocChecker* ac) {
+        insert_internal(index, value, ac);
+    }
+
+#ifndef _KERNEL
+    void insert(size_t index, T&& value) {
+        insert_internal(index, fbl::move(value));
+    }
+
+    void insert(size_t index, const T& value) {
+        insert_internal(index, value);
+    }
+#endif // _KERNEL
+
+    // Remove an element from the |index| position in the vector, shifting
+    // all subsequent elements one position to fill in the gap.
+    // Returns the removed element.
+    //
+    // Index must be less than the size of the vector.
+    T erase(size_t index) {
+        ZX_DEBUG_ASSERT(index < size_);
+        auto val = fbl::move(ptr_[index]);
+        shift_forward(index);
+        consider_shrinking();
+        return fbl::move(val);
+    }
+
+    void pop_back() {
+        ZX_DEBUG_ASSERT(size_ > 0);
+        ptr_[--size_].~T();
+        consider_shrinking();
+    }
+
+    const T* get() const {
+        return ptr_;
+    }
+
+    T* get() {
+        return ptr_;
+    }
+
+    bool is_empty() const {
+        return size_ == 0;
+    }
+
+    T& operator[](size_t i) const {
+        ZX_DEBUG_ASSERT(i < size_);
+        return ptr_[i];
+    }
+
+    T* begin() const {
+        return ptr_;
+    }
+
+    T* end() const {
+        return &ptr_[size_];
+    }
+
+private:
+    AllocatorTraits& allocator() {
+        return *this;
+    }
+
+    T* inline_ptr() {
+        return reinterpret_cast<T*>(inline_storage_);
+    }
+
+    const T* inline_ptr() const {
+        return reinterpret_cast<const T*>(inline_storage_);
+    }
+
+    // Takes the elements of |other|, which is left empty.  This vector must
+    // be empty and inline.
+    void take(InlineVector& other) {
+        ZX_DEBUG_ASSERT(size_ == 0 && is_inline());
+        if (other.is_inline()) {
+            other.transfer_to(ptr_, other.size_);
+            size_ = other.size_;
+            other.size_ = 0;
+        } else {
+            ptr_ = other.ptr_;
+            size_ = other.size_;
+            capacity_ = other.capacity_;
+            other.ptr_ = other.inline_ptr();
+            other.size_ = 0;
+            other.capacity_ = N;
+        }
+    }
+
+    template <typename U,
+              typename = typename enable_if<is_same<internal::remove_cv_ref<U>, T>::value>::type>
+    void push_back_internal(U&& value, AllocChecker* ac) {
+        if (!grow_for_new_element(ac)) {
+            return;
+        }
+        new (&ptr_[size_++]) T(fbl::forward<U>(value));
+    }
+
+    template <typename U,
+              typename = typename enable_if<is_same<internal::remove_cv_ref<U>, T>::value>::type>
+    void push_back_internal(U&& value) {
+        grow_for_new_element();
+        new (&ptr_[size_++]) T(fbl::forward<U>(value));
+    }
+
+    // Insert an element into the |index| position in the vector, shifting
+    // all subsequent elements back one position.
+    //
+    // Index must be less than or equal to the size of the vector.
+    template <typename U,
+              typename = typename enable_if<is_same<internal::remove_cv_ref<U>, T>::value>::type>
+    void insert_internal(size_t index, U&& value, AllocChecker* ac) {
+        ZX_DEBUG_ASSERT(index <= size_);
+        if (!grow_for_new_element(ac)) {
+            return;
+        }
+        insert_complete(index, fbl::forward<U>(value));
+    }
+
+    template <typename U,
+              typename = typename enable_if<is_same<internal::remove_cv_ref<U>, T>::value>::type>
+    void insert_internal(size_t index, U&& value) {
+        ZX_DEBUG_ASSERT(index <= size_);
+        grow_for_new_element();
+        insert_complete(index, fbl::forward<U>(value));
+    }
+
+    // The second half of 'insert', which asumes that there is enough
+    // room for a new element.
+    template <typename U,
+              typename = typename enable_if<is_same<internal::remove_cv_ref<U>, T>::value>::type>
+    void insert_complete(size_t index, U&& value) {
+        if (index == size_) {
+            size_++;
+            new (&ptr_[index]) T(fbl::forward<U>(value));
+        } else {
+            shift_back(index);
+            ptr_[index] = fbl::forward<U>(value);
+        }
+    }
+
+    // Moves all objects in the storage (at & after index) back by one,
+    // leaving an 'empty' object at index.
+    // Increases the size of the vector by one.
+    template <typename U = T>
+    typename enable_if<is_pod<U>::value, void>::type
+    shift_back(size_t index) {
+        ZX_DEBUG_ASSERT(size_ < capacity_);
+        ZX_DEBUG_ASSERT(size_ > 0);
+        size_++;
+        memmove(&ptr_[index + 1], &ptr_[index], sizeof(T) * (size_ - (index + 1)));
+    }
+
+    template <typename U = T>
+    typename enable_if<!is_pod<U>::value, void>::type
+    shift_back(size_t index) {
+        ZX_DEBUG_ASSERT(size_ < capacity_);
+        ZX_DEBUG_ASSERT(size_ > 0);
+        size_++;
+        new (&ptr_[size_ - 1]) T(fbl::move(ptr_[size_ - 2]));
+        for (size_t i = size_ - 2; i > index; i--) {
+            ptr_[i] = fbl::move(ptr_[i - 1]);
+        }
+    }
+
+    // Moves all objects in the storage (after index) forward by one.
+    // Decreases the size of the vector by one.
+    template <typename U = T>
+    typename enable_if<is_pod<U>::value, void>::type
+    shift_forward(size_t index) {
+        ZX_DEBUG_ASSERT(size_ > 0);
+        memmove(&ptr_[index], &ptr_[index + 1], sizeof(T) * (size_ - (index + 1)));
+        size_--;
+    }
+
+    template <typename U = T>
+    typename enable_if<!is_pod<U>::value, void>::type
+    shift_forward(size_t index) {
+        ZX_DEBUG_ASSERT(size_ > 0);
+        for (size_t i = index; (i + 1) < size_; i++) {
+            ptr_[i] = fbl::move(ptr_[i + 1]);
+        }
+        ptr_[--size_].~T();
+    }
+
+    template <typename U = T>
+    typename enable_if<is_pod<U>::value, void>::type
+    transfer_to(T* newPtr, size_t elements) {
+        if (elements > 0) {
+            memcpy(newPtr, ptr_, elements * sizeof(T));
+        }
+    }
+
+    template <typename U = T>
+    typename enable_if<!is_pod<U>::value, void>::type
+    transfer_to(T* newPtr, size_t elements) {
+        for (size_t i = 0; i < elements; i++) {
+            new (&newPtr[i]) T(fbl::move(ptr_[i]));
+            ptr_[i].~T();
+        }
+    }
+
+    // Grows the vector's capacity to accommodate one more element.
+    // Returns true on success, false on failure.
+    bool grow_for_new_element(AllocChecker* ac) {
+        ZX_DEBUG_ASSERT(size_ <= capacity_);
+        if (size_ == capacity_) {
+            return reallocate(capacity_ * kCapacityGrowthFactor, ac);
+        }
+        ac->arm(0u, true);
+        return true;
+    }
+
+    void grow_for_new_element() {
+        ZX_DEBUG_ASSERT(size_ <= capacity_);
+        if (size_ == capacity_) {
+            reallocate(capacity_ * kCapacityGrowthFactor);
+        }
+    }
+
+    // Shrink the heap storage to fit a smaller number of elements, if we
+    // reach under the shrink factor, moving back inline if they fit.
+    void consider_shrinking() {
+        if (is_inline() || size_ * kCapacityShrinkFactor >= capacity_) {
+            return;
+        }
+        size_t newCapacity = capacity_ / kCapacityShrinkFactor;
+        if (newCapacity <= N) {
+            T* oldPtr = ptr_;
+            transfer_to(inline_ptr(), size_);
+            AllocatorTraits::Deallocate(oldPtr);
+            ptr_ = inline_ptr();
+            capacity_ = N;
+            return;
+        }
+
+        // If the vector cannot be reallocated to a smaller size (reallocate
+        // fails) it will continue to use a larger capacity.
+        AllocChecker ac;
+        reallocate(newCapacity, &ac);
+        ac.check();
+    }
+
+    // Moves the elements to heap storage for newCapacity elements.
+    // Returns true on success, false on failure.
+    // If reallocate fails, the old storage is unmodified.
+    bool reallocate(size_t newCapacity, AllocChecker* ac) {
+        ZX_DEBUG_ASSERT(newCapacity > N);
+        ZX_DEBUG_ASSERT(newCapacity >= size_);
+        auto newPtr = reinterpret_cast<T*>(AllocatorTraits::Allocate(newCapacity * sizeof(T)));
+        if (newPtr == nullptr) {
+            ac->arm(1u, false);
+            return false;
+        }
+        replace_storage(newPtr, newCapacity);
+        ac->arm(0u, true);
+        return true;
+    }
+
+#ifndef _KERNEL
+    void reallocate(size_t newCapacity) {
+        ZX_DEBUG_ASSERT(newCapacity > N);
+        ZX_DEBUG_ASSERT(newCapacity >= size_);
+        auto newPtr = reinterpret_cast<T*>(AllocatorTraits::Allocate(newCapacity * sizeof(T)));
+        replace_storage(newPtr, newCapacity);
+    }
+#endif
+
+    void replace_storage(T* newPtr, size_t newCapacity) {
+        transfer_to(newPtr, size_);
+        if (!is_inline()) {
+            AllocatorTraits::Deallocate(ptr_);
+        }
+        capacity_ = newCapacity;
+        ptr_ = newPtr;
+    }
+
+    T* ptr_;
+    size_t size_;
+    size_t capacity_;
+    alignas(T) uint8_t inline_storage_[N * sizeof(T)];
+
+    static constexpr size_t kCapacityGrowthFactor = 2;
+    static constexpr size_t kCapacityShrinkFactor = 4;
+};
+
+} // namespace fbl
@@ -12,6 +12,8 @@
 #include <zircon/compiler.h>
 
 namespace fbl {
+class Arena;
+
 namespace tests {
 struct StringTestHelper;
 } // namespace tests
@@ -23,9 +25,13 @@ struct StringTestHelper;
 // strings does not incur any allocation cost.
 //
 // Empty string objects do not incur any allocation.  Non-empty strings are
-// stored on the heap.  Note that fbl::String does not have a null state
+// stored on the heap, or in an fbl::Arena if one is passed when creating them.  Note that fbl::String does not have a null state
 // distinct from the empty state.
 //
+// Strings which are assembled and thrown away without being shared need
+// not touch the heap at all: fbl::StringBuffer<N> keeps up to N characters
+// inline.
+//
 // The content of a fbl::String object is always stored with a null terminator
 // so that |c_str()| is fast.  However, be aware that the string may also contain
 // embedded null characters (this is not checked by the implementation).
@@ -102,6 +108,22 @@ public:
     String(const StringPiece& piece, AllocChecker* ac)
         : String(piece.data(), piece.length(), ac) {}
 
+    // Creates a string from the contents of a character array of given length,
+    // allocated from |arena| instead of the heap.  The contents are freed
+    // when the arena is reset, so neither this string nor copies of it may
+    // be used after that.
+    // Allocates only if |length| is non-zero.
+    // |data|, |arena| and |ac| must not be null.
+    String(const char* data, size_t length, Arena* arena, AllocChecker* ac) {
+        Init(data, length, arena, ac);
+    }
+
+    // Creates a string from the contents of a string piece, allocated from
+    // |arena| instead of the heap.  See above.
+    // |arena| and |ac| must not be null.
+    String(const StringPiece& piece, Arena* arena, AllocChecker* ac)
+        : String(piece.data(), piece.length(), arena, ac) {}
+
     // Creates a string from a string-like object.
     // Allocates heap memory only if the length of |value| is non-zero.
     //
@@ -295,6 +317,7 @@ private:
     void Init(const char* data, size_t length, AllocChecker* ac);
     void Init(size_t count, char ch);
     void Init(size_t count, char ch, AllocChecker* ac);
+    void Init(const char* data, size_t length, Arena* arena, AllocChecker* ac);
     void InitWithEmpty();
 
     static char* AllocData(size_t length);
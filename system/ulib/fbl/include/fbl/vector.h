@@ -58,8 +58,12 @@ struct DefaultAllocatorTraits {
 // This Vector supports O(1) indexing and O(1) (amortized) insertion and
 // deletion at the end (due to possible reallocations during push_back
 // and pop_back).
+//
+// AllocatorTraits may have state, such as the arena to allocate from (see
+// fbl::ArenaAllocatorTraits).  A vector keeps a copy of its allocator,
+// which moves along with its storage.
 template <typename T, typename AllocatorTraits = DefaultAllocatorTraits>
-class Vector {
+class Vector : private AllocatorTraits {
 public:
     // move semantics only
     DISALLOW_COPY_AND_ASSIGN_ALLOW_MOVE(Vector);
@@ -67,8 +71,12 @@ public:
     constexpr Vector()
         : ptr_(nullptr), size_(0U), capacity_(0U) {}
 
+    explicit Vector(const AllocatorTraits& allocator)
+        : AllocatorTraits(allocator), ptr_(nullptr), size_(0U), capacity_(0U) {}
+
     Vector(Vector&& other)
-        : ptr_(nullptr), size_(other.size_), capacity_(other.capacity_) {
+        : AllocatorTraits(other.allocator()), ptr_(nullptr), size_(other.size_),
+          capacity_(other.capacity_) {
         ptr_ = other.release();
     }
 
@@ -89,7 +97,9 @@ public:
     Vector& operator=(Vector&& o) {
         auto size = o.size_;
         auto capacity = o.capacity_;
+        // The old storage is freed with the old allocator.
         reset(o.release(), size, capacity);
+        allocator() = o.allocator();
         return *this;
     }
 
@@ -139,6 +149,10 @@ public:
 
         other.size_ = size;
         other.capacity_ = capacity;
+
+        AllocatorTraits allocator = this->allocator();
+        this->allocator() = other.allocator();
+        other.allocator() = allocator;
     }
 
     void push_back(T&& value, AllocChecker* ac) {
@@ -222,6 +236,10 @@ public:
     }
 
 private:
+    AllocatorTraits& allocator() {
+        return *this;
+    }
+
     // TODO(smklein): In the future, if we want to be able to push back
     // function pointers and arrays with impunity without requiring exact
     // types, this 'remove_cv_ref' call should probably be replaced with a
@@ -9,6 +9,7 @@
 #include <zircon/assert.h>
 
 #include <fbl/algorithm.h>
+#include <fbl/arena.h>
 #include <fbl/atomic.h>
 #include <fbl/new.h>
 
@@ -181,6 +182,27 @@ void String::Init(size_t count, char ch, AllocChecker* ac) {
     data_[count] = 0u;
 }
 
+void String::Init(const char* data, size_t length, Arena* arena, AllocChecker* ac) {
+    if (length == 0u) {
+        ac->arm(0u, true);
+        InitWithEmpty();
+        return;
+    }
+
+    void* buffer = arena->Allocate(buffer_size(length), alignof(size_t));
+    ac->arm(buffer_size(length), buffer != nullptr);
+    if (!buffer) {
+        InitWithEmpty();
+        return;
+    }
+    data_ = InitData(buffer, length);
+    // Like gEmpty, the buffer holds a reference which is never released,
+    // so ReleaseRef() never tries to free it.
+    AcquireRef(data_);
+    memcpy(data_, data, length);
+    data_[length] = 0u;
+}
+
 void String::InitWithEmpty() {
     gEmpty.ref_count.fetch_add(1u, memory_order_relaxed);
     data_ = &gEmpty.nul;
@@ -0,0 +1,390 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <errno.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <threads.h>
+
+#include <zircon/syscalls.h>
+#include <zircon/syscalls/port.h>
+#include <lib/fdio/io.h>
+
+#include "private.h"
+#include "unistd.h"
+
+// An epoll instance is a port plus the interest list registered on it. Each
+// entry holds a reference to the fdio_t it watches and an async wait on that
+// object's handle, keyed so that packets can be mapped back to the entry.
+//
+// By default the waits are ZX_WAIT_ASYNC_LEVEL, so the kernel keeps a ready
+// entry's packet on the port until its signals deassert, which gives epoll's
+// level-triggered semantics without re-arming anything per call.
+
+// Packets dequeued from the port per zx_port_wait_many() call.
+#define EPOLL_BATCH 16
+
+typedef struct epoll_entry {
+    int fd;
+    fdio_t* io;
+    zx_handle_t handle;
+    uint32_t events;
+    epoll_data_t data;
+    uint64_t key;
+} epoll_entry_t;
+
+typedef struct mxepio mxepio_t;
+struct mxepio {
+    // base fdio io object
+    fdio_t io;
+
+    zx_handle_t port;
+
+    mtx_t lock;
+
+    // Sorted by key. Keys are handed out in increasing order, so new entries
+    // are appended.
+    epoll_entry_t* entries;
+    size_t count;
+    size_t capacity;
+    uint64_t next_key;
+};
+
+static zx_status_t mxepio_close(fdio_t* io) {
+    mxepio_t* ep = (mxepio_t*)io;
+    mtx_lock(&ep->lock);
+    // Closing the port cancels every wait registered on it.
+    zx_handle_close(ep->port);
+    ep->port = ZX_HANDLE_INVALID;
+    for (size_t i = 0; i < ep->count; i++) {
+        fdio_release(ep->entries[i].io);
+    }
+    free(ep->entries);
+    ep->entries = NULL;
+    ep->count = 0;
+    ep->capacity = 0;
+    mtx_unlock(&ep->lock);
+    return ZX_OK;
+}
+
+static void mxepio_wait_begin(fdio_t* io, uint32_t events, zx_handle_t* handle,
+                              zx_signals_t* _signals) {
+    // Waiting on an epoll instance from poll() or another epoll instance is
+    // not supported.
+    *handle = ZX_HANDLE_INVALID;
+    *_signals = 0;
+}
+
+static void mxepio_wait_end(fdio_t* io, zx_signals_t signals, uint32_t* _events) {
+    *_events = 0;
+}
+
+static fdio_ops_t fdio_epoll_ops = {
+    .read = fdio_default_read,
+    .read_at = fdio_default_read_at,
+    .write = fdio_default_write,
+    .write_at = fdio_default_write_at,
+    .seek = fdio_default_seek,
+    .misc = fdio_default_misc,
+    .close = mxepio_close,
+    .open = fdio_default_open,
+    .clone = fdio_default_clone,
+    .ioctl = fdio_default_ioctl,
+    .unwrap = fdio_default_unwrap,
+    .wait_begin = mxepio_wait_begin,
+    .wait_end = mxepio_wait_end,
+    .posix_ioctl = fdio_default_posix_ioctl,
+    .get_token = fdio_default_get_token,
+    .get_attr = fdio_default_get_attr,
+    .set_attr = fdio_default_set_attr,
+    .sync = fdio_default_sync,
+    .readdir = fdio_default_readdir,
+    .rewind = fdio_default_rewind,
+    .unlink = fdio_default_unlink,
+    .truncate = fdio_default_truncate,
+    .rename = fdio_default_rename,
+    .link = fdio_default_link,
+    .get_flags = fdio_default_get_flags,
+    .set_flags = fdio_default_set_flags,
+    .recvfrom = fdio_default_recvfrom,
+    .sendto = fdio_default_sendto,
+    .recvmsg = fdio_default_recvmsg,
+    .sendmsg = fdio_default_sendmsg,
+    .shutdown = fdio_default_shutdown,
+};
+
+static mxepio_t* fd_to_epoll(int fd) {
+    fdio_t* io = fd_to_io(fd);
+    if (io == NULL) {
+        return NULL;
+    }
+    if (!(io->ioflag & IOFLAG_EPOLL)) {
+        fdio_release(io);
+        return NULL;
+    }
+    return (mxepio_t*)io;
+}
+
+static epoll_entry_t* epoll_find_fd(mxepio_t* ep, int fd) {
+    for (size_t i = 0; i < ep->count; i++) {
+        if (ep->entries[i].fd == fd) {
+            return &ep->entries[i];
+        }
+    }
+    return NULL;
+}
+
+static epoll_entry_t* epoll_find_key(mxepio_t* ep, uint64_t key) {
+    size_t lo = 0;
+    size_t hi = ep->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (ep->entries[mid].key < key) {
+            lo = mid + 1;
+        } else if (ep->entries[mid].key > key) {
+            hi = mid;
+        } else {
+            return &ep->entries[mid];
+        }
+    }
+    return NULL;
+}
+
+// Registers an async wait for |entry| under a fresh key. The caller keeps the
+// entries array sorted by moving |entry| to the end afterwards.
+static zx_status_t epoll_arm(mxepio_t* ep, epoll_entry_t* entry) {
+    zx_signals_t signals;
+    entry->io->ops->wait_begin(entry->io, entry->events, &entry->handle, &signals);
+    if (entry->handle == ZX_HANDLE_INVALID) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+    uint32_t options = ZX_WAIT_ASYNC_LEVEL;
+    if (entry->events & EPOLLONESHOT) {
+        options = ZX_WAIT_ASYNC_ONCE;
+    } else if (entry->events & EPOLLET) {
+        options = ZX_WAIT_ASYNC_REPEATING;
+    }
+    entry->key = ep->next_key++;
+    return zx_object_wait_async(entry->handle, ep->port, entry->key, signals, options);
+}
+
+// Moves the entry at |index| to the end of the array, which keeps it sorted
+// after the entry was given the largest key.
+static void epoll_move_to_end(mxepio_t* ep, size_t index) {
+    epoll_entry_t entry = ep->entries[index];
+    memmove(&ep->entries[index], &ep->entries[index + 1],
+            (ep->count - index - 1) * sizeof(epoll_entry_t));
+    ep->entries[ep->count - 1] = entry;
+}
+
+static void epoll_remove(mxepio_t* ep, size_t index) {
+    memmove(&ep->entries[index], &ep->entries[index + 1],
+            (ep->count - index - 1) * sizeof(epoll_entry_t));
+    ep->count--;
+}
+
+__EXPORT
+int epoll_create1(int flags) {
+    if (flags & ~EPOLL_CLOEXEC) {
+        return ERRNO(EINVAL);
+    }
+    mxepio_t* ep = fdio_alloc(sizeof(*ep));
+    if (ep == NULL) {
+        return ERRNO(ENOMEM);
+    }
+    zx_status_t status = zx_port_create(0, &ep->port);
+    if (status != ZX_OK) {
+        fdio_free(&ep->io);
+        return ERROR(status);
+    }
+    mtx_init(&ep->lock, mtx_plain);
+    ep->io.ops = &fdio_epoll_ops;
+    ep->io.magic = FDIO_MAGIC;
+    ep->io.refcount = 1;
+    ep->io.ioflag |= IOFLAG_EPOLL;
+    if (flags & EPOLL_CLOEXEC) {
+        ep->io.ioflag |= IOFLAG_CLOEXEC;
+    }
+    ep->next_key = 1;
+
+    int fd = fdio_bind_to_fd(&ep->io, -1, 0);
+    if (fd < 0) {
+        fdio_close(&ep->io);
+        fdio_release(&ep->io);
+        return ERRNO(EMFILE);
+    }
+    return fd;
+}
+
+__EXPORT
+int epoll_create(int size) {
+    if (size <= 0) {
+        return ERRNO(EINVAL);
+    }
+    return epoll_create1(0);
+}
+
+__EXPORT
+int epoll_ctl(int epfd, int op, int fd, struct epoll_event* ev) {
+    if (op != EPOLL_CTL_DEL && ev == NULL) {
+        return ERRNO(EFAULT);
+    }
+    fdio_t* io = fd_to_io(fd);
+    if (io == NULL) {
+        return ERRNO(EBADF);
+    }
+    fdio_t* epio = fd_to_io(epfd);
+    if (epio == NULL) {
+        fdio_release(io);
+        return ERRNO(EBADF);
+    }
+    if (!(epio->ioflag & IOFLAG_EPOLL) || epio == io) {
+        fdio_release(io);
+        fdio_release(epio);
+        return ERRNO(EINVAL);
+    }
+    mxepio_t* ep = (mxepio_t*)epio;
+
+    int r = 0;
+    mtx_lock(&ep->lock);
+    epoll_entry_t* entry = epoll_find_fd(ep, fd);
+    switch (op) {
+    case EPOLL_CTL_ADD: {
+        if (entry != NULL) {
+            r = ERRNO(EEXIST);
+            break;
+        }
+        if (ep->count == ep->capacity) {
+            size_t capacity = ep->capacity ? ep->capacity * 2 : 8;
+            epoll_entry_t* entries = realloc(ep->entries, capacity * sizeof(epoll_entry_t));
+            if (entries == NULL) {
+                r = ERRNO(ENOMEM);
+                break;
+            }
+            ep->entries = entries;
+            ep->capacity = capacity;
+        }
+        entry = &ep->entries[ep->count];
+        entry->fd = fd;
+        entry->io = io;
+        entry->events = ev->events;
+        entry->data = ev->data;
+        zx_status_t status = epoll_arm(ep, entry);
+        if (status != ZX_OK) {
+            r = (status == ZX_ERR_NOT_SUPPORTED) ? ERRNO(EPERM) : ERROR(status);
+            break;
+        }
+        ep->count++;
+        // The entry now owns the reference on |io|.
+        io = NULL;
+        break;
+    }
+    case EPOLL_CTL_MOD: {
+        if (entry == NULL) {
+            r = ERRNO(ENOENT);
+            break;
+        }
+        zx_port_cancel(ep->port, entry->handle, entry->key);
+        entry->events = ev->events;
+        entry->data = ev->data;
+        zx_status_t status = epoll_arm(ep, entry);
+        size_t index = entry - ep->entries;
+        if (status != ZX_OK) {
+            fdio_release(entry->io);
+            epoll_remove(ep, index);
+            r = ERROR(status);
+            break;
+        }
+        epoll_move_to_end(ep, index);
+        break;
+    }
+    case EPOLL_CTL_DEL:
+        if (entry == NULL) {
+            r = ERRNO(ENOENT);
+            break;
+        }
+        zx_port_cancel(ep->port, entry->handle, entry->key);
+        fdio_release(entry->io);
+        epoll_remove(ep, entry - ep->entries);
+        break;
+    default:
+        r = ERRNO(EINVAL);
+        break;
+    }
+    mtx_unlock(&ep->lock);
+
+    if (io != NULL) {
+        fdio_release(io);
+    }
+    fdio_release(&ep->io);
+    return r;
+}
+
+__EXPORT
+int epoll_pwait(int epfd, struct epoll_event* events, int maxevents, int timeout,
+                const sigset_t* sigmask) {
+    if (sigmask) {
+        return ERRNO(ENOSYS);
+    }
+    if (maxevents <= 0) {
+        return ERRNO(EINVAL);
+    }
+    mxepio_t* ep = fd_to_epoll(epfd);
+    if (ep == NULL) {
+        return ERRNO(EBADF);
+    }
+
+    zx_time_t deadline = (timeout < 0) ? ZX_TIME_INFINITE : zx_deadline_after(ZX_MSEC(timeout));
+    size_t count = (maxevents < EPOLL_BATCH) ? (size_t)maxevents : EPOLL_BATCH;
+    zx_port_packet_t packets[EPOLL_BATCH];
+
+    int n = 0;
+    for (;;) {
+        size_t actual = 0;
+        zx_status_t status = zx_port_wait_many(ep->port, deadline, packets, count, &actual);
+        if (status == ZX_ERR_TIMED_OUT) {
+            break;
+        }
+        if (status != ZX_OK) {
+            n = ERROR(status);
+            break;
+        }
+
+        mtx_lock(&ep->lock);
+        for (size_t i = 0; i < actual; i++) {
+            // A packet whose entry was removed or modified since it was
+            // queued carries a stale key and is dropped.
+            epoll_entry_t* entry = epoll_find_key(ep, packets[i].key);
+            if (entry == NULL) {
+                continue;
+            }
+            uint32_t revents = 0;
+            entry->io->ops->wait_end(entry->io, packets[i].signal.observed, &revents);
+            revents &= entry->events | EPOLLHUP | EPOLLERR;
+            if (revents == 0) {
+                continue;
+            }
+            events[n].events = revents;
+            events[n].data = entry->data;
+            n++;
+        }
+        mtx_unlock(&ep->lock);
+
+        // Keep waiting if everything dequeued was filtered out.
+        if (n > 0) {
+            break;
+        }
+    }
+
+    fdio_release(&ep->io);
+    return n;
+}
+
+__EXPORT
+int epoll_wait(int epfd, struct epoll_event* events, int maxevents, int timeout) {
+    return epoll_pwait(epfd, events, maxevents, timeout, NULL);
+}
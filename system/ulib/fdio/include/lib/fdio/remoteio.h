@@ -79,6 +79,7 @@ typedef struct {
         zx_handle_t handle;
         struct {
             zx_handle_t e;
+            uint32_t flags;
         } file;
         struct {
             zx_handle_t s;
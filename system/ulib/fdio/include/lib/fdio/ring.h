@@ -0,0 +1,117 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <zircon/compiler.h>
+#include <zircon/syscalls/port.h>
+#include <zircon/types.h>
+
+__BEGIN_CDECLS
+
+// An fdio ring keeps many file and socket operations in flight at once from
+// a single thread.
+//
+// Operations are submitted to the ring, which starts them and returns without
+// waiting for them to finish. Their completions are then reaped from the ring,
+// in the order they finished, either by waiting on the ring itself or, if the
+// ring was created on a caller's port, by handing it the packets it receives
+// on that port.
+//
+// Reads, writes and fsyncs of remote files, and opens relative to remote
+// directories, are sent to the server without waiting for its reply. Reads and
+// writes of sockets and pipes wait for them to become readable or writable.
+// Operations on any other object are performed synchronously when they are
+// submitted, and complete right away.
+typedef struct fdio_ring fdio_ring_t;
+
+// Reads up to |len| bytes into |buf|, from |offset| in the file, or from the
+// current position of a socket or pipe when |offset| is -1. A read of a
+// remote file transfers at most FDIO_CHUNK_SIZE bytes.
+#define FDIO_RING_OP_READ 1u
+
+// Writes up to |len| bytes from |buf|, like FDIO_RING_OP_READ.
+#define FDIO_RING_OP_WRITE 2u
+
+// Opens |path| relative to the directory |fd| with the open() flags |flags|
+// and |mode|, like openat(). Completes with the new file descriptor.
+#define FDIO_RING_OP_OPEN 3u
+
+// Synchronizes the file |fd| with its storage, like fsync().
+#define FDIO_RING_OP_FSYNC 4u
+
+// An operation to submit. |buf| must stay valid until the operation's
+// completion is reaped; |path| is only used during submission.
+typedef struct fdio_ring_sqe {
+    uint32_t opcode;
+    int fd;
+
+    // FDIO_RING_OP_READ and FDIO_RING_OP_WRITE.
+    void* buf;
+    size_t len;
+    off_t offset;
+
+    // FDIO_RING_OP_OPEN.
+    const char* path;
+    int flags;
+    uint32_t mode;
+
+    // Returned with the operation's completion.
+    uint64_t user_data;
+} fdio_ring_sqe_t;
+
+typedef struct fdio_ring_cqe {
+    uint64_t user_data;
+    zx_status_t status;
+    // If |status| is ZX_OK: the number of bytes read or written, the file
+    // descriptor opened, or zero for an fsync.
+    int64_t result;
+} fdio_ring_cqe_t;
+
+// Creates a ring which holds up to |entries| operations, from when they are
+// submitted until their completion is reaped.
+//
+// If |port| is ZX_HANDLE_INVALID, the ring waits for its operations on a port
+// of its own. Otherwise it waits for them on |port|, with keys in
+// [key_base, key_base + entries), which the caller must pass packets for to
+// fdio_ring_process(). |port| is not consumed.
+zx_status_t fdio_ring_create(uint32_t entries, zx_handle_t port, uint64_t key_base,
+                             fdio_ring_t** out_ring);
+
+// Destroys |ring|. Operations on remote objects which are still in flight are
+// waited for, and those on sockets and pipes are cancelled; none of their
+// completions are reported.
+void fdio_ring_destroy(fdio_ring_t* ring);
+
+// Submits the |count| operations of |sqes|, stopping once the ring is full.
+// Returns the number submitted in |out_submitted|, and ZX_ERR_SHOULD_WAIT if
+// the ring was full before any were.
+//
+// Operations which can't be started, such as those on invalid file
+// descriptors, are submitted all the same and complete with an error.
+//
+// A remote file's operations can only be in flight on one ring at a time.
+// Until those on one ring have all completed, reads, writes and fsyncs of the
+// same file submitted to another ring complete with ZX_ERR_BAD_STATE.
+zx_status_t fdio_ring_submit(fdio_ring_t* ring, const fdio_ring_sqe_t* sqes, size_t count,
+                             size_t* out_submitted);
+
+// Reaps up to |count| completions into |cqes|, returning the number reaped in
+// |out_actual|.
+//
+// A ring with a port of its own waits until |deadline| for at least one
+// operation to complete, returning ZX_ERR_TIMED_OUT if none did. A ring created
+// on a caller's port only returns the completions fdio_ring_process() has
+// already found, and ZX_ERR_SHOULD_WAIT if there are none.
+zx_status_t fdio_ring_reap(fdio_ring_t* ring, fdio_ring_cqe_t* cqes, size_t count,
+                           zx_time_t deadline, size_t* out_actual);
+
+// Hands |ring| a packet with one of its keys received on the port it was
+// created on. Returns ZX_ERR_NOT_FOUND if the packet's key isn't the ring's.
+zx_status_t fdio_ring_process(fdio_ring_t* ring, const zx_port_packet_t* packet);
+
+__END_CDECLS
@@ -19,6 +19,7 @@
 #include <lib/fdio/remoteio.h>
 #include <lib/fdio/util.h>
 #include <lib/fdio/vfs.h>
+#include <lib/sync/rwlock.h>
 
 #include "private.h"
 #include "private-remoteio.h"
@@ -30,9 +31,20 @@
 //
 // They are expected to be relatively small (perhaps 10-50 total
 // local vnodes, acting as roots for the remote filesystems that
-// contain the actual items of interest) and as such have a simple
-// locking model -- one namespace-wide lock that is held while
-// doing the local directory walk part of an OPEN operation.
+// contain the actual items of interest), and lookups vastly
+// outnumber binds.  The tree is a trie keyed by path segment, and
+// each vnode keeps a hash of its name so that the walk only
+// compares names which are likely to match.
+//
+// Vnodes are never removed or changed once they are linked into
+// the tree, other than the root's remote, which may be bound once.
+// fdio_ns_bind() builds any new vnodes off to the side and links
+// them in with a single release store, so the local directory walk
+// part of an OPEN, and READDIR, take no lock at all: they see the
+// tree either before or after a bind, never part of one.  Binds,
+// and changes to the directory reference count, serialize on a
+// namespace-wide lock, which EXPORT also holds for reading so that
+// the tree does not grow between counting and copying its entries.
 //
 // If an OPEN path matches one of the local vnodes exactly, a
 // fdio_directory object is created and returned.  This object
@@ -46,18 +58,21 @@ typedef struct fdio_directory mxdir_t;
 typedef struct fdio_vnode mxvn_t;
 
 struct fdio_vnode {
-    mxvn_t* child;
+    _Atomic(mxvn_t*) child;
     mxvn_t* parent;
+    // immutable once the vnode is linked into the tree
     mxvn_t* next;
-    zx_handle_t remote;
+    _Atomic(zx_handle_t) remote;
+    uint32_t hash;
     uint32_t namelen;
     char name[];
 };
 
 // refcount is incremented when a fdio_dir references any of its vnodes
 // when refcount is nonzero it may not be modified or destroyed
+// refcount is only modified while holding the lock for writing
 struct fdio_namespace {
-    mtx_t lock;
+    sync_rwlock_t lock;
     int32_t refcount;
     mxvn_t root;
 };
@@ -79,17 +94,43 @@ struct fdio_directory {
 
 static fdio_t* fdio_dir_create_locked(fdio_ns_t* fs, mxvn_t* vn);
 
-static mxvn_t* vn_lookup_locked(mxvn_t* dir, const char* name, size_t len) {
-    for (mxvn_t* vn = dir->child; vn; vn = vn->next) {
-        if ((vn->namelen == len) && (!memcmp(vn->name, name, len))) {
+static mxvn_t* vn_first_child(mxvn_t* vn) {
+    return atomic_load_explicit(&vn->child, memory_order_acquire);
+}
+
+static zx_handle_t vn_remote(mxvn_t* vn) {
+    return atomic_load_explicit(&vn->remote, memory_order_acquire);
+}
+
+// FNV-1a
+static uint32_t vn_hash(const char* name, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t n = 0; n < len; n++) {
+        hash = (hash ^ (uint8_t)name[n]) * 16777619u;
+    }
+    return hash;
+}
+
+// Returns the length of the path segment at the start of path,
+// and its hash.
+static size_t ns_segment(const char* path, uint32_t* hash) {
+    size_t len = strcspn(path, "/");
+    *hash = vn_hash(path, len);
+    return len;
+}
+
+static mxvn_t* vn_lookup(mxvn_t* dir, const char* name, size_t len, uint32_t hash) {
+    for (mxvn_t* vn = vn_first_child(dir); vn; vn = vn->next) {
+        if ((vn->hash == hash) && (vn->namelen == len) && (!memcmp(vn->name, name, len))) {
             return vn;
         }
     }
     return NULL;
 }
 
-static zx_status_t vn_create_locked(mxvn_t* dir, const char* name, size_t len,
-                                    zx_handle_t remote, mxvn_t** out) {
+// Allocates a vnode which is not yet linked into its parent.
+static zx_status_t vn_create(mxvn_t* dir, const char* name, size_t len,
+                             zx_handle_t remote, mxvn_t** out) {
     if ((len == 0) || (len > NAME_MAX)) {
         return ZX_ERR_INVALID_ARGS;
     }
@@ -99,79 +140,39 @@ static zx_status_t vn_create_locked(mxvn_t* dir, const char* name, size_t len,
     if ((len == 2) && (name[0] == '.') && (name[1] == '.')) {
         return ZX_ERR_INVALID_ARGS;
     }
-    mxvn_t* vn = vn_lookup_locked(dir, name, len);
-    if (vn != NULL) {
-        // And we do not allow replacing a virtual dir node
-        // with a real directory node:
-        if (remote != ZX_HANDLE_INVALID) {
-            LOG(1, "VN-CREATE FAILED: SHADOWING LOCAL\n");
-            return ZX_ERR_ALREADY_EXISTS;
-        }
-        // if there's already vnode, we do not allow
-        // overlapping a remoted vnode:
-        if (vn->remote != ZX_HANDLE_INVALID) {
-            LOG(1, "VN-CREATE FAILED: SHADOWING REMOTE\n");
-            return ZX_ERR_NOT_SUPPORTED;
-        }
-        *out = vn;
-        return ZX_OK;
-    }
+    mxvn_t* vn;
     if ((vn = calloc(1, sizeof(*vn) + len + 1)) == NULL) {
         return ZX_ERR_NO_MEMORY;
     }
     memcpy(vn->name, name, len);
     vn->name[len] = 0;
+    vn->hash = vn_hash(name, len);
     vn->namelen = len;
     vn->parent = dir;
-    vn->remote = remote;
-    vn->next = dir->child;
-    dir->child = vn;
+    atomic_init(&vn->remote, remote);
     *out = vn;
     return ZX_OK;
 }
 
-// vn_destroy *only* safe to be called on vnodes that have never been
-// wrapped in a directory object, because we don't refcount vnodes
-// (they're expected to live for the duration of the namespace).
-//
-// It's used by fdio_ns_bind() to delete intermediate vnodes that
-// were created while the ns lock is held, to "undo" a partial mkdir
-// operation that failed partway down the pat.  Since the lock is not
-// released until the full operation completes, this is safe.
-static zx_status_t vn_destroy_locked(mxvn_t* child) {
-    // can't destroy a live node
-    if (child->remote != ZX_HANDLE_INVALID) {
-        return ZX_ERR_BAD_STATE;
-    }
-    // can't destroy the root
-    if (child->parent == NULL) {
-        return ZX_ERR_NOT_SUPPORTED;
-    }
-    mxvn_t* dir = child->parent;
-
-    if (dir->child == child) {
-        dir->child = child->next;
-    } else {
-        for (mxvn_t* vn = dir->child; vn; vn = vn->next) {
-            if (vn->next == child) {
-                vn->next = child->next;
-                break;
-            }
-        }
+// Frees a chain of vnodes built by fdio_ns_bind() which was never
+// linked into the tree.  Their remote still belongs to the caller.
+static void vn_destroy_chain(mxvn_t* vn) {
+    while (vn != NULL) {
+        mxvn_t* child = atomic_load_explicit(&vn->child, memory_order_relaxed);
+        free(vn);
+        vn = child;
     }
-    free(child);
-    return ZX_OK;
 }
 
 static void vn_destroy_children_locked(mxvn_t* parent) {
     mxvn_t* next;
-    for (mxvn_t* vn = parent->child; vn; vn = next) {
+    for (mxvn_t* vn = vn_first_child(parent); vn; vn = next) {
         next = vn->next;
-        if (vn->child) {
+        if (vn_first_child(vn)) {
             vn_destroy_children_locked(vn);
         }
-        if (vn->remote != ZX_HANDLE_INVALID) {
-            zx_handle_close(vn->remote);
+        if (vn_remote(vn) != ZX_HANDLE_INVALID) {
+            zx_handle_close(vn_remote(vn));
         }
         free(vn);
     }
@@ -179,9 +180,9 @@ static void vn_destroy_children_locked(mxvn_t* parent) {
 
 static zx_status_t mxdir_close(fdio_t* io) {
     mxdir_t* dir = (mxdir_t*) io;
-    mtx_lock(&dir->ns->lock);
+    sync_rwlock_write_lock(&dir->ns->lock);
     dir->ns->refcount--;
-    mtx_unlock(&dir->ns->lock);
+    sync_rwlock_write_unlock(&dir->ns->lock);
     dir->ns = NULL;
     dir->vn = NULL;
     return ZX_OK;
@@ -191,7 +192,7 @@ static zx_status_t mxdir_clone(fdio_t* io, zx_handle_t* handles, uint32_t* types
     return ZX_ERR_NOT_SUPPORTED;
 }
 
-static zx_status_t ns_walk_locked(mxvn_t** _vn, const char** _path) {
+static zx_status_t ns_walk(mxvn_t** _vn, const char** _path) {
     mxvn_t* vn = *_vn;
     const char* path = *_path;
 
@@ -203,8 +204,9 @@ static zx_status_t ns_walk_locked(mxvn_t** _vn, const char** _path) {
     for (;;) {
         // Find the next path segment.
         const char* name = path;
-        const char* next = strchr(path, '/');
-        size_t len = next ? (size_t)(next - path) : strlen(path);
+        uint32_t hash;
+        size_t len = ns_segment(path, &hash);
+        const char* next = (path[len] == '/') ? path + len : NULL;
 
         // Path segments may not be empty.
         if (len == 0) {
@@ -212,7 +214,7 @@ static zx_status_t ns_walk_locked(mxvn_t** _vn, const char** _path) {
         }
 
         // look for a match
-        mxvn_t* child = vn_lookup_locked(vn, name, len);
+        mxvn_t* child = vn_lookup(vn, name, len, hash);
         if (child != NULL) {
             vn = child;
             if (next) {
@@ -230,7 +232,7 @@ static zx_status_t ns_walk_locked(mxvn_t** _vn, const char** _path) {
 
         // If there's remaining path but this is not a mount point,
         // we're done.
-        if (vn->remote == ZX_HANDLE_INVALID) {
+        if (vn_remote(vn) == ZX_HANDLE_INVALID) {
             return ZX_ERR_NOT_FOUND;
         }
 
@@ -254,24 +256,18 @@ zx_status_t fdio_ns_connect(fdio_ns_t* ns, const char* path,
     }
     path++;
 
-    mtx_lock(&ns->lock);
-
-    if ((r = ns_walk_locked(&vn, &path)) != ZX_OK) {
-        goto fail1;
+    if ((r = ns_walk(&vn, &path)) != ZX_OK) {
+        goto fail0;
     }
 
     // cannot connect via non-mountpoint nodes
-    if (vn->remote == ZX_HANDLE_INVALID) {
+    if (vn_remote(vn) == ZX_HANDLE_INVALID) {
         r = ZX_ERR_NOT_SUPPORTED;
-        goto fail1;
+        goto fail0;
     }
 
-    r = fdio_open_at(vn->remote, path, flags, h);
-    mtx_unlock(&ns->lock);
-    return r;
+    return fdio_open_at(vn_remote(vn), path, flags, h);
 
-fail1:
-    mtx_unlock(&ns->lock);
 fail0:
     zx_handle_close(h);
     return r;
@@ -301,31 +297,29 @@ static zx_status_t mxdir_open(fdio_t* io, const char* path,
     zx_status_t r = ZX_OK;
 
     LOG(6, "OPEN '%s'\n", path);
-    mtx_lock(&dir->ns->lock);
 
-    if ((r = ns_walk_locked(&vn, &path)) == ZX_OK) {
-        if (vn->remote == ZX_HANDLE_INVALID) {
-            if ((*out = fdio_dir_create_locked(dir->ns, vn)) == NULL) {
-                r = ZX_ERR_NO_MEMORY;
-            }
-        } else {
-            mtx_unlock(&dir->ns->lock);
-
-            // If we're trying to mkdir over top of a mount point,
-            // the correct error is EEXIST
-            if ((flags & ZX_FS_FLAG_CREATE) && !strcmp(path, ".")) {
-                return ZX_ERR_ALREADY_EXISTS;
-            }
+    if ((r = ns_walk(&vn, &path)) != ZX_OK) {
+        return r;
+    }
 
-            // Active Namespaces are immutable, so referencing remote here
-            // is safe.  We don't want to do a blocking open under the ns lock.
-            r = zxrio_open_handle(vn->remote, path, flags, mode, out);
-            LOG(6, "OPEN REMOTE '%s': %d\n", path, r);
-            return r;
+    zx_handle_t remote = vn_remote(vn);
+    if (remote == ZX_HANDLE_INVALID) {
+        sync_rwlock_write_lock(&dir->ns->lock);
+        if ((*out = fdio_dir_create_locked(dir->ns, vn)) == NULL) {
+            r = ZX_ERR_NO_MEMORY;
         }
+        sync_rwlock_write_unlock(&dir->ns->lock);
+        return r;
     }
 
-    mtx_unlock(&dir->ns->lock);
+    // If we're trying to mkdir over top of a mount point,
+    // the correct error is EEXIST
+    if ((flags & ZX_FS_FLAG_CREATE) && !strcmp(path, ".")) {
+        return ZX_ERR_ALREADY_EXISTS;
+    }
+
+    r = zxrio_open_handle(remote, path, flags, mode, out);
+    LOG(6, "OPEN REMOTE '%s': %d\n", path, r);
     return r;
 }
 
@@ -343,7 +337,7 @@ static zx_status_t fill_dirent(vdirent_t* de, size_t delen,
     return sz;
 }
 
-static zx_status_t mxdir_readdir_locked(mxdir_t* dir, void* buf, size_t len) {
+static zx_status_t mxdir_readdir_vn(mxdir_t* dir, void* buf, size_t len) {
     void *ptr = buf;
 
     zx_status_t r = fill_dirent(ptr, len, ".", 1, VTYPE_TO_DTYPE(V_TYPE_DIR));
@@ -353,7 +347,7 @@ static zx_status_t mxdir_readdir_locked(mxdir_t* dir, void* buf, size_t len) {
     ptr += r;
     len -= r;
 
-    for (mxvn_t* vn = dir->vn->child; vn; vn = vn->next) {
+    for (mxvn_t* vn = vn_first_child(dir->vn); vn; vn = vn->next) {
         if ((r = fill_dirent(ptr, len, vn->name, vn->namelen, VTYPE_TO_DTYPE(V_TYPE_DIR))) < 0) {
             break;
         }
@@ -378,14 +372,12 @@ static zx_status_t mxdir_rewind(fdio_t* io) {
 
 static zx_status_t mxdir_readdir(fdio_t* io, void* ptr, size_t max, size_t* actual) {
     mxdir_t* dir = (mxdir_t*) io;
-    mtx_lock(&dir->ns->lock);
     int n = atomic_fetch_add(&dir->seq, 1);
     if (n == 0) {
-        *actual = mxdir_readdir_locked(dir, ptr, max);
+        *actual = mxdir_readdir_vn(dir, ptr, max);
     } else {
         *actual = 0;
     }
-    mtx_unlock(&dir->ns->lock);
     return ZX_OK;
 }
 
@@ -438,6 +430,7 @@ static fdio_t* fdio_dir_create_locked(fdio_ns_t* ns, mxvn_t* vn) {
     if (dir == NULL) {
         return NULL;
     }
+    ns->refcount++;
     dir->ns = ns;
     dir->vn = vn;
     dir->io.ops = &dir_ops;
@@ -450,24 +443,25 @@ static fdio_t* fdio_dir_create_locked(fdio_ns_t* ns, mxvn_t* vn) {
 __EXPORT
 zx_status_t fdio_ns_create(fdio_ns_t** out) {
     // +1 is for the "" name
-    fdio_ns_t* ns = fdio_alloc(sizeof(fdio_ns_t) + 1);
+    fdio_ns_t* ns = calloc(1, sizeof(fdio_ns_t) + 1);
     if (ns == NULL) {
         return ZX_ERR_NO_MEMORY;
     }
-    mtx_init(&ns->lock, mtx_plain);
     *out = ns;
     return ZX_OK;
 }
 
+// Lookups don't take the lock, so the caller must make sure that
+// nothing else is still using the namespace.
 __EXPORT
 zx_status_t fdio_ns_destroy(fdio_ns_t* ns) {
-    mtx_lock(&ns->lock);
+    sync_rwlock_write_lock(&ns->lock);
     if (ns->refcount != 0) {
-        mtx_unlock(&ns->lock);
+        sync_rwlock_write_unlock(&ns->lock);
         return ZX_ERR_BAD_STATE;
     } else {
         vn_destroy_children_locked(&ns->root);
-        mtx_unlock(&ns->lock);
+        sync_rwlock_write_unlock(&ns->lock);
         free(ns);
         return ZX_OK;
     }
@@ -488,16 +482,16 @@ zx_status_t fdio_ns_bind(fdio_ns_t* ns, const char* path, zx_handle_t remote) {
 
     zx_status_t r = ZX_OK;
 
-    mtx_lock(&ns->lock);
+    sync_rwlock_write_lock(&ns->lock);
     mxvn_t* vn = &ns->root;
     if (path[0] == 0) {
         // the path was "/" so we're trying to bind to the root vnode
-        if (vn->remote == ZX_HANDLE_INVALID) {
-            if (vn->child) {
+        if (vn_remote(vn) == ZX_HANDLE_INVALID) {
+            if (vn_first_child(vn)) {
                 // overlay remotes are disallowed
                 r = ZX_ERR_NOT_SUPPORTED;
             } else {
-                vn->remote = remote;
+                atomic_store_explicit(&vn->remote, remote, memory_order_release);
             }
         } else {
             r = ZX_ERR_ALREADY_EXISTS;
@@ -505,44 +499,68 @@ zx_status_t fdio_ns_bind(fdio_ns_t* ns, const char* path, zx_handle_t remote) {
         LOG(1, "BIND ROOT: FAILED\n");
         goto done;
     }
-    if (vn->remote != ZX_HANDLE_INVALID) {
+    if (vn_remote(vn) != ZX_HANDLE_INVALID) {
         // if there's something mounted at / we can't shadow it
         r = ZX_ERR_NOT_SUPPORTED;
         LOG(1, "BIND: FAILED (root bound)\n");
         goto done;
     }
+
+    // walk down the intermediate vnodes that already exist
+    size_t len;
     for (;;) {
-        const char* next = strchr(path, '/');
-        if (next) {
-            // not the final segment, create an intermediate vnode
-            r = vn_create_locked(vn, path, next - path, ZX_HANDLE_INVALID, &vn);
-            if (r < 0) {
-                break;
-            }
-            path = next + 1;
-        } else {
-            // final segment. create leaf vnode and stop
-            r = vn_create_locked(vn, path, strlen(path), remote, &vn);
+        uint32_t hash;
+        len = ns_segment(path, &hash);
+        mxvn_t* child = vn_lookup(vn, path, len, hash);
+        if (child == NULL) {
             break;
         }
+        if (path[len] == 0) {
+            // we do not allow replacing a virtual dir node
+            // with a real directory node
+            LOG(1, "BIND FAILED: SHADOWING LOCAL\n");
+            r = ZX_ERR_ALREADY_EXISTS;
+            goto done;
+        }
+        if (vn_remote(child) != ZX_HANDLE_INVALID) {
+            // nor overlapping a remoted vnode
+            LOG(1, "BIND FAILED: SHADOWING REMOTE\n");
+            r = ZX_ERR_NOT_SUPPORTED;
+            goto done;
+        }
+        vn = child;
+        path += len + 1;
     }
 
-    if (r < 0) {
-        // we failed, so unwind, removing any intermediate vnodes
-        // we created.  vn_destroy_locked() will error out on any
-        // vnode that has a remote, or on the root vnode, so we
-        // it will stop us before we remove anything that already
-        // existed.  (we never create leaf vnodes with no remote)
-        for (;;) {
-            mxvn_t* parent = vn->parent;
-            if (vn_destroy_locked(vn) < 0) {
-                break;
-            }
-            vn = parent;
+    // build the rest of the path as a chain of new vnodes, which
+    // lookups cannot see until it is complete and linked into vn
+    mxvn_t* head = NULL;
+    mxvn_t* tail = vn;
+    for (;;) {
+        const char* next = (path[len] == '/') ? path + len : NULL;
+        mxvn_t* child;
+        r = vn_create(tail, path, len, next ? ZX_HANDLE_INVALID : remote, &child);
+        if (r < 0) {
+            vn_destroy_chain(head);
+            goto done;
         }
+        if (head == NULL) {
+            head = child;
+        } else {
+            atomic_store_explicit(&tail->child, child, memory_order_relaxed);
+        }
+        tail = child;
+        if (next == NULL) {
+            break;
+        }
+        path = next + 1;
+        uint32_t hash;
+        len = ns_segment(path, &hash);
     }
+    head->next = atomic_load_explicit(&vn->child, memory_order_relaxed);
+    atomic_store_explicit(&vn->child, head, memory_order_release);
 done:
-    mtx_unlock(&ns->lock);
+    sync_rwlock_write_unlock(&ns->lock);
     return r;
 }
 
@@ -577,18 +595,13 @@ zx_status_t fdio_ns_bind_fd(fdio_ns_t* ns, const char* path, int fd) {
 
 fdio_t* fdio_ns_open_root(fdio_ns_t* ns) {
     fdio_t* io;
-    mtx_lock(&ns->lock);
-    if (ns->root.remote == ZX_HANDLE_INVALID) {
+    zx_handle_t remote = vn_remote(&ns->root);
+    if (remote == ZX_HANDLE_INVALID) {
+        sync_rwlock_write_lock(&ns->lock);
         io = fdio_dir_create_locked(ns, &ns->root);
-        if (io != NULL) {
-            ns->refcount++;
-        }
-        mtx_unlock(&ns->lock);
+        sync_rwlock_write_unlock(&ns->lock);
     } else {
-        mtx_unlock(&ns->lock);
-        // Active namespaces are immutable, so safe to access remote
-        // outside of the lock, avoiding blocking while holding the lock.
-        zx_status_t r = zxrio_open_handle(ns->root.remote, "", O_RDWR, 0, &io);
+        zx_status_t r = zxrio_open_handle(remote, "", O_RDWR, 0, &io);
         if (r != ZX_OK) {
             io = NULL;
         }
@@ -627,7 +640,7 @@ static zx_status_t ns_enum_callback(mxvn_t* vn, void* cookie,
     char path[PATH_MAX];
     char* end = path + sizeof(path) - 1;
     *end = 0;
-    zx_handle_t h = vn->remote;
+    zx_handle_t h = vn_remote(vn);
     for (;;) {
         if ((vn->namelen + 1) > (size_t)(end - path)) {
             return ZX_ERR_BAD_PATH;
@@ -653,11 +666,11 @@ static zx_status_t ns_enumerate(mxvn_t* vn, void* cookie,
                                 zx_status_t (*func)(void* cookie, const char* path,
                                                     size_t len, zx_handle_t h)) {
     while (vn != NULL) {
-        if (vn->remote != ZX_HANDLE_INVALID) {
+        if (vn_remote(vn) != ZX_HANDLE_INVALID) {
             ns_enum_callback(vn, cookie, func);
         }
-        if (vn->child) {
-            ns_enumerate(vn->child, cookie, func);
+        if (vn_first_child(vn)) {
+            ns_enumerate(vn_first_child(vn), cookie, func);
         }
         vn = vn->next;
     }
@@ -705,13 +718,13 @@ zx_status_t fdio_ns_export(fdio_ns_t* ns, fdio_flat_namespace_t** out) {
     es.bytes = sizeof(fdio_flat_namespace_t);
     es.count = 0;
 
-    mtx_lock(&ns->lock);
+    sync_rwlock_read_lock(&ns->lock);
 
     ns_enumerate(&ns->root, &es, ns_export_count);
 
     fdio_flat_namespace_t* flat = malloc(es.bytes);
     if (flat == NULL) {
-        mtx_unlock(&ns->lock);
+        sync_rwlock_read_unlock(&ns->lock);
         return ZX_ERR_NO_MEMORY;
     }
     // We've allocated enough memory for the flat struct
@@ -726,7 +739,7 @@ zx_status_t fdio_ns_export(fdio_ns_t* ns, fdio_flat_namespace_t** out) {
 
     es.count = 0;
     zx_status_t status = ns_enumerate(&ns->root, &es, ns_export_copy);
-    mtx_unlock(&ns->lock);
+    sync_rwlock_read_unlock(&ns->lock);
 
     if (status < 0) {
         for (size_t n = 0; n < es.count; n++) {
@@ -18,13 +18,48 @@
 typedef struct fdio_zxio_remote {
     fdio_t io;
     zxio_remote_t remote;
+
+    // Set if the server described the file as immutable. Its contents are
+    // then read from |vmo|, acquired on first use, and the seek offset is kept
+    // in |seek| rather than by the server.
+    bool immutable;
+    mtx_t lock;
+    bool vmo_acquired;
+    zx_handle_t vmo;
+    uint64_t size;
+    uint64_t seek;
+
+    // Set if |attr| holds attributes fetched along with the open, which are
+    // returned by the next get_attr in place of asking the server again.
+    bool has_attr;
+    vnattr_t attr;
+
+    // The fdio ring with operations in flight on |remote.control|, if any,
+    // and how many it has there. Replies are only read from the channel by
+    // that ring, since a reply read by another would be lost. |ring| is
+    // claimed and released atomically; |ring_ops| is only touched by its
+    // owner, under its lock.
+    struct fdio_ring* ring;
+    uint32_t ring_ops;
 } fdio_zxio_remote_t;
 
 // Create an |fdio_t| for a remote file backed by zxio.
 fdio_t* fdio_zxio_create_remote(zx_handle_t control, zx_handle_t event);
 
+// Create an |fdio_t| for a remote file whose contents never change, which is
+// read locally once its VMO has been acquired.
+fdio_t* fdio_zxio_create_immutable_file(zx_handle_t control, zx_handle_t event);
+
 // open operation directly on remoteio handle
 zx_status_t zxrio_open_handle(zx_handle_t h, const char* path, uint32_t flags,
                               uint32_t mode, fdio_t** out);
 
+// Sends an open of |path| relative to the directory |h|, asking for the
+// server to describe the new connection, without waiting for its reply. Once
+// the connection returned in |out_channel| is readable, it is turned into an
+// fdio_t by zxrio_open_async_finish(), which always consumes it.
+zx_status_t zxrio_open_async_start(zx_handle_t h, const char* path, uint32_t flags,
+                                   uint32_t mode, zx_handle_t* out_channel);
+zx_status_t zxrio_open_async_finish(zx_handle_t channel, fdio_t** out);
+
 extern fdio_ops_t fdio_zxio_remote_ops;
@@ -87,6 +87,13 @@ typedef struct fdio_ops {
 // Static assertions in unistd.c ensure we aren't colliding.
 #define IOFLAG_FD_FLAGS IOFLAG_CLOEXEC
 
+// An open flag known only to fdio, which is never sent to the server.
+// It asks for the attributes of an object opened with
+// ZX_FS_FLAG_VNODE_REF_ONLY to be requested along with the open, rather than
+// once the open has been described, and kept by the object returned as the
+// result of its first get_attr.
+#define FDIO_OPEN_FLAG_GETATTR 0x80000000
+
 typedef struct fdio {
     fdio_ops_t* ops;
     uint32_t magic;
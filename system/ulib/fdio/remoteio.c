@@ -221,6 +221,8 @@ static zx_status_t zxrio_process_open_response(zx_handle_t h, zxrio_describe_t*
                   "RIO Node Info doesn't align with FIDL object info");
     static_assert(__builtin_offsetof(zxrio_node_info_t, file.e) ==
                   __builtin_offsetof(fuchsia_io_NodeInfo, file.event), "Unaligned File");
+    static_assert(__builtin_offsetof(zxrio_node_info_t, file.flags) ==
+                  __builtin_offsetof(fuchsia_io_NodeInfo, file.flags), "Unaligned File");
     static_assert(__builtin_offsetof(zxrio_node_info_t, pipe.s) ==
                   __builtin_offsetof(fuchsia_io_NodeInfo, pipe.socket), "Unaligned Pipe");
     static_assert(__builtin_offsetof(zxrio_node_info_t, vmofile.v) ==
@@ -365,7 +367,10 @@ static zx_status_t fdio_from_handles(zx_handle_t handle, zxrio_node_info_t* info
         *out = io;
         return ZX_OK;
     case fuchsia_io_NodeInfoTag_file:
-        if (info->file.e == ZX_HANDLE_INVALID) {
+        if (info->file.flags & fuchsia_io_FILE_FLAG_IMMUTABLE) {
+            io = fdio_zxio_create_immutable_file(handle, info->file.e);
+            xprintf("rio immutable (%x,%x) -> %p\n", handle, info->file.e, io);
+        } else if (info->file.e == ZX_HANDLE_INVALID) {
             io = fdio_remote_create(handle, 0);
             xprintf("rio (%x,%x) -> %p\n", handle, 0, io);
         } else {
@@ -558,8 +563,113 @@ static zx_status_t zxrio_getobject(zx_handle_t rio_h, uint32_t op, const char* n
     }
 }
 
+// The transaction id of a GetAttr sent behind an Open. Nothing else has been
+// sent on the new connection, so any id will do.
+#define ZXRIO_GETATTR_TXID 1
+
+// Reads the reply to a GetAttr sent as |ZXRIO_GETATTR_TXID| on |h|.
+static zx_status_t zxrio_getattr_response(zx_handle_t h, vnattr_t* out) {
+    zx_status_t r = zx_object_wait_one(h, ZX_CHANNEL_READABLE | ZX_CHANNEL_PEER_CLOSED,
+                                       ZX_TIME_INFINITE, NULL);
+    if (r != ZX_OK) {
+        return r;
+    }
+
+    fuchsia_io_NodeGetAttrResponse response;
+    uint32_t dsize;
+    uint32_t actual_handles;
+    if ((r = zx_channel_read(h, 0, &response, NULL, sizeof(response), 0, &dsize,
+                             &actual_handles)) != ZX_OK) {
+        return r;
+    }
+    if (dsize != sizeof(response) || response.hdr.txid != ZXRIO_GETATTR_TXID ||
+        response.hdr.ordinal != fuchsia_io_NodeGetAttrOrdinal) {
+        return ZX_ERR_IO;
+    }
+    if (response.s != ZX_OK) {
+        return response.s;
+    }
+
+    const fuchsia_io_NodeAttributes* attr = &response.attributes;
+    memset(out, 0, sizeof(*out));
+    out->mode = attr->mode;
+    out->inode = attr->id;
+    out->size = attr->content_size;
+    out->blksize = VNATTR_BLKSIZE;
+    out->blkcount = attr->storage_size / VNATTR_BLKSIZE;
+    out->nlink = attr->link_count;
+    out->create_time = attr->creation_time;
+    out->modify_time = attr->modification_time;
+    return ZX_OK;
+}
+
+// Opens |path| like zxrio_open_handle, but sends GetAttr on the new connection
+// right behind the Open, so that the server answers both in a single round
+// trip. The server serves the messages of the connection in order once it is
+// opened, and drops them along with the connection if the open fails, so the
+// reply is only read after a successful description.
+//
+// Only path-only opens are pipelined this way: every server speaks the node
+// protocol on those, whereas a full open may hand the connection to a
+// service which doesn't.
+static zx_status_t zxrio_open_handle_getattr(zx_handle_t h, const char* path, uint32_t flags,
+                                             uint32_t mode, fdio_t** out) {
+    if (path == NULL) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+    size_t len = strlen(path);
+    if (len >= PATH_MAX) {
+        return ZX_ERR_BAD_PATH;
+    }
+
+    zx_status_t r;
+    zx_handle_t control_channel;
+    zx_handle_t cnxn;
+    if ((r = zx_channel_create(0, &control_channel, &cnxn)) != ZX_OK) {
+        return r;
+    }
+    if ((r = fidl_open_request(h, cnxn, flags, mode, path, len)) != ZX_OK) {
+        zx_handle_close(control_channel);
+        return r;
+    }
+
+    fuchsia_io_NodeGetAttrRequest request;
+    memset(&request, 0, sizeof(request));
+    request.hdr.txid = ZXRIO_GETATTR_TXID;
+    request.hdr.ordinal = fuchsia_io_NodeGetAttrOrdinal;
+    bool pipelined = zx_channel_write(control_channel, 0, &request, sizeof(request),
+                                      NULL, 0) == ZX_OK;
+
+    zxrio_describe_t info;
+    if ((r = zxrio_process_open_response(control_channel, &info)) != ZX_OK) {
+        zx_handle_close(control_channel);
+        return r;
+    }
+
+    // If the attributes can't be read here, the caller's get_attr asks for
+    // them again, and reports whatever went wrong.
+    vnattr_t attr;
+    bool has_attr = pipelined && zxrio_getattr_response(control_channel, &attr) == ZX_OK;
+    if ((r = fdio_from_handles(control_channel, &info.extra, out)) != ZX_OK) {
+        return r;
+    }
+    if (has_attr && (*out)->ops == &fdio_zxio_remote_ops) {
+        fdio_zxio_remote_t* rio = (fdio_zxio_remote_t*)*out;
+        rio->attr = attr;
+        rio->has_attr = true;
+    }
+    return ZX_OK;
+}
+
 zx_status_t zxrio_open_handle(zx_handle_t h, const char* path, uint32_t flags,
                               uint32_t mode, fdio_t** out) {
+    if (flags & FDIO_OPEN_FLAG_GETATTR) {
+        flags &= ~FDIO_OPEN_FLAG_GETATTR;
+        if ((flags & ZX_FS_FLAG_VNODE_REF_ONLY) && (flags & ZX_FS_FLAG_DESCRIBE)) {
+            return zxrio_open_handle_getattr(h, path, flags, mode, out);
+        }
+    }
+
     zx_handle_t control_channel = ZX_HANDLE_INVALID;
     zxrio_describe_t info;
     zx_status_t r = zxrio_getobject(h, fuchsia_io_DirectoryOpenOrdinal, path, flags, mode, &info, &control_channel);
@@ -569,6 +679,37 @@ zx_status_t zxrio_open_handle(zx_handle_t h, const char* path, uint32_t flags,
     return fdio_from_handles(control_channel, &info.extra, out);
 }
 
+zx_status_t zxrio_open_async_start(zx_handle_t h, const char* path, uint32_t flags,
+                                   uint32_t mode, zx_handle_t* out_channel) {
+    size_t len = strlen(path);
+    if (len >= PATH_MAX) {
+        return ZX_ERR_BAD_PATH;
+    }
+
+    zx_status_t r;
+    zx_handle_t control_channel;
+    zx_handle_t cnxn;
+    if ((r = zx_channel_create(0, &control_channel, &cnxn)) != ZX_OK) {
+        return r;
+    }
+    if ((r = fidl_open_request(h, cnxn, flags | ZX_FS_FLAG_DESCRIBE, mode, path, len)) != ZX_OK) {
+        zx_handle_close(control_channel);
+        return r;
+    }
+    *out_channel = control_channel;
+    return ZX_OK;
+}
+
+zx_status_t zxrio_open_async_finish(zx_handle_t channel, fdio_t** out) {
+    zxrio_describe_t info;
+    zx_status_t r = zxrio_process_open_response(channel, &info);
+    if (r != ZX_OK) {
+        zx_handle_close(channel);
+        return r;
+    }
+    return fdio_from_handles(channel, &info.extra, out);
+}
+
 __EXPORT
 fdio_t* fdio_remote_create(zx_handle_t h, zx_handle_t event) {
     return fdio_zxio_create_remote(h, event);
@@ -0,0 +1,671 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+
+#include <fuchsia/io/c/fidl.h>
+#include <lib/fdio/io.h>
+#include <lib/fdio/limits.h>
+#include <lib/fdio/ring.h>
+#include <lib/fdio/util.h>
+#include <zircon/device/vfs.h>
+#include <zircon/syscalls.h>
+#include <zircon/syscalls/port.h>
+
+#include "private-remoteio.h"
+#include "private.h"
+#include "unistd.h"
+
+// A ring is a fixed array of slots, each holding one operation from when it is
+// submitted until its completion is reaped. Slot |i| waits for its operation
+// on the ring's port with the key |key_base + i|.
+//
+// Operations on remote objects are FIDL messages written to the object's
+// channel, with a transaction id unique to the process. Their replies are read
+// from the channel as it becomes readable; since several operations may be in
+// flight on a channel, a reply is matched to its slot by transaction id rather
+// than by the slot whose wait fired. The replies to synchronous calls are
+// handed straight to their callers by zx_channel_call() and never show up
+// here, but a reply read by another ring would be lost to it, so a ring claims
+// the channel while it has operations in flight there, and operations
+// submitted to other rings meanwhile are refused.
+//
+// A packet for a slot is only ever taken as a hint that its operation may be
+// able to make progress, since it may have been queued before the slot was
+// reused. Nothing is done which could block until the slot's handle has been
+// checked for the signals it waits for.
+
+#define SLOT_FREE 0
+#define SLOT_PENDING 1
+#define SLOT_DONE 2
+
+// The reply to a FIDL message the slot sent on |handle|.
+#define WAIT_REPLY 1
+// The description of the connection |handle|, which the slot opened.
+#define WAIT_OPEN 2
+// The signals of a socket or pipe, before reading or writing it.
+#define WAIT_STREAM 3
+
+// Transaction ids with the high bit set are handed out by zx_channel_call().
+#define RING_TXID_MASK 0x7fffffffu
+
+// The largest message the ring sends or receives.
+#define RING_MSG_BYTES (sizeof(fuchsia_io_FileReadAtResponse) + FDIO_CHUNK_SIZE)
+
+typedef struct ring_slot {
+    uint32_t state;
+    uint32_t wait;
+    fdio_ring_sqe_t sqe;
+    fdio_t* io;
+
+    zx_handle_t handle;
+    zx_signals_t signals;
+    // Set while the slot may have a wait registered on the port.
+    bool armed;
+
+    zx_txid_t txid;
+    uint32_t ordinal;
+    // Set while the slot counts towards the ring's claim on |io|'s channel.
+    bool claimed;
+
+    fdio_ring_cqe_t cqe;
+} ring_slot_t;
+
+struct fdio_ring {
+    mtx_t lock;
+    zx_handle_t port;
+    bool own_port;
+    uint64_t key_base;
+
+    uint32_t entries;
+    ring_slot_t* slots;
+
+    // The indices of the free slots, used as a stack.
+    uint32_t* free;
+    uint32_t free_count;
+
+    // The indices of the completed slots, in the order they completed.
+    uint32_t* done;
+    uint32_t done_head;
+    uint32_t done_count;
+
+    // Holds the message being sent or received.
+    uint8_t* msg;
+};
+
+static void ring_disarm(fdio_ring_t* ring, uint32_t index) {
+    ring_slot_t* slot = &ring->slots[index];
+    if (slot->armed) {
+        zx_port_cancel(ring->port, slot->handle, ring->key_base + index);
+        slot->armed = false;
+    }
+}
+
+// Claims the replies on the channel of |rio| for |ring|, for one more
+// operation. Fails if another ring has operations in flight there.
+static bool ring_claim(fdio_ring_t* ring, fdio_zxio_remote_t* rio) {
+    fdio_ring_t* owner = NULL;
+    if (!__atomic_compare_exchange_n(&rio->ring, &owner, ring, false, __ATOMIC_ACQUIRE,
+                                     __ATOMIC_RELAXED) &&
+        owner != ring) {
+        return false;
+    }
+    rio->ring_ops++;
+    return true;
+}
+
+static void ring_unclaim(fdio_zxio_remote_t* rio) {
+    if (--rio->ring_ops == 0) {
+        __atomic_store_n(&rio->ring, NULL, __ATOMIC_RELEASE);
+    }
+}
+
+static void ring_complete(fdio_ring_t* ring, uint32_t index, zx_status_t status,
+                          int64_t result) {
+    ring_slot_t* slot = &ring->slots[index];
+    ring_disarm(ring, index);
+    if (slot->claimed) {
+        ring_unclaim((fdio_zxio_remote_t*)slot->io);
+        slot->claimed = false;
+    }
+    if (slot->wait == WAIT_OPEN && slot->handle != ZX_HANDLE_INVALID) {
+        zx_handle_close(slot->handle);
+    }
+    slot->handle = ZX_HANDLE_INVALID;
+    if (slot->io != NULL) {
+        fdio_release(slot->io);
+        slot->io = NULL;
+    }
+
+    slot->cqe.user_data = slot->sqe.user_data;
+    slot->cqe.status = status;
+    slot->cqe.result = (status == ZX_OK) ? result : 0;
+    slot->state = SLOT_DONE;
+    ring->done[(ring->done_head + ring->done_count) % ring->entries] = index;
+    ring->done_count++;
+}
+
+// Waits for the slot's handle to assert any of its signals, replacing any wait
+// which is already registered.
+static void ring_arm(fdio_ring_t* ring, uint32_t index) {
+    ring_slot_t* slot = &ring->slots[index];
+    ring_disarm(ring, index);
+    zx_status_t status = zx_object_wait_async(slot->handle, ring->port, ring->key_base + index,
+                                              slot->signals, ZX_WAIT_ASYNC_ONCE);
+    if (status != ZX_OK) {
+        ring_complete(ring, index, status, 0);
+        return;
+    }
+    slot->armed = true;
+}
+
+static zx_txid_t ring_next_txid(void) {
+    static atomic_uint_fast32_t next_txid = 1;
+    zx_txid_t txid;
+    do {
+        txid = (zx_txid_t)atomic_fetch_add(&next_txid, 1) & RING_TXID_MASK;
+        // Events are sent with a transaction id of zero.
+    } while (txid == 0);
+    return txid;
+}
+
+// Sends the FIDL message built in |ring->msg| for the slot's operation on the
+// remote object |rio|, then waits for its reply.
+static void ring_send(fdio_ring_t* ring, uint32_t index, fdio_zxio_remote_t* rio,
+                      uint32_t ordinal, uint32_t num_bytes) {
+    ring_slot_t* slot = &ring->slots[index];
+    if (!ring_claim(ring, rio)) {
+        ring_complete(ring, index, ZX_ERR_BAD_STATE, 0);
+        return;
+    }
+    slot->claimed = true;
+
+    fidl_message_header_t* hdr = (fidl_message_header_t*)ring->msg;
+    hdr->txid = ring_next_txid();
+    hdr->ordinal = ordinal;
+
+    zx_status_t status = zx_channel_write(rio->remote.control, 0, ring->msg, num_bytes, NULL, 0);
+    if (status != ZX_OK) {
+        ring_complete(ring, index, status, 0);
+        return;
+    }
+    slot->wait = WAIT_REPLY;
+    slot->handle = rio->remote.control;
+    slot->signals = ZX_CHANNEL_READABLE | ZX_CHANNEL_PEER_CLOSED;
+    slot->txid = hdr->txid;
+    slot->ordinal = ordinal;
+    ring_arm(ring, index);
+}
+
+static bool ring_start_remote(fdio_ring_t* ring, uint32_t index, fdio_zxio_remote_t* rio) {
+    ring_slot_t* slot = &ring->slots[index];
+    const fdio_ring_sqe_t* sqe = &slot->sqe;
+    memset(ring->msg, 0, sizeof(fidl_message_header_t));
+
+    switch (sqe->opcode) {
+    case FDIO_RING_OP_READ: {
+        if (sqe->offset < 0) {
+            return false;
+        }
+        fuchsia_io_FileReadAtRequest* request = (fuchsia_io_FileReadAtRequest*)ring->msg;
+        request->count = (sqe->len > FDIO_CHUNK_SIZE) ? FDIO_CHUNK_SIZE : sqe->len;
+        request->offset = sqe->offset;
+        ring_send(ring, index, rio, fuchsia_io_FileReadAtOrdinal, sizeof(*request));
+        return true;
+    }
+    case FDIO_RING_OP_WRITE: {
+        if (sqe->offset < 0) {
+            return false;
+        }
+        fuchsia_io_FileWriteAtRequest* request = (fuchsia_io_FileWriteAtRequest*)ring->msg;
+        size_t len = (sqe->len > FDIO_CHUNK_SIZE) ? FDIO_CHUNK_SIZE : sqe->len;
+        request->data.count = len;
+        request->data.data = (void*)FIDL_ALLOC_PRESENT;
+        request->offset = sqe->offset;
+        uint8_t* data = ring->msg + sizeof(*request);
+        memcpy(data, sqe->buf, len);
+        memset(data + len, 0, FIDL_ALIGN(len) - len);
+        ring_send(ring, index, rio, fuchsia_io_FileWriteAtOrdinal,
+                  (uint32_t)(sizeof(*request) + FIDL_ALIGN(len)));
+        return true;
+    }
+    case FDIO_RING_OP_FSYNC:
+        ring_send(ring, index, rio, fuchsia_io_NodeSyncOrdinal,
+                  sizeof(fuchsia_io_NodeSyncRequest));
+        return true;
+    }
+    return false;
+}
+
+// Binds the file the slot opened to a file descriptor, as openat() does.
+static void ring_complete_open(fdio_ring_t* ring, uint32_t index, fdio_t* io) {
+    if (ring->slots[index].sqe.flags & O_NONBLOCK) {
+        io->ioflag |= IOFLAG_NONBLOCK;
+    }
+    int fd = fdio_bind_to_fd(io, -1, 0);
+    if (fd < 0) {
+        io->ops->close(io);
+        fdio_release(io);
+        ring_complete(ring, index, ZX_ERR_NO_RESOURCES, 0);
+        return;
+    }
+    ring_complete(ring, index, ZX_OK, fd);
+}
+
+static void ring_start_open(fdio_ring_t* ring, uint32_t index) {
+    ring_slot_t* slot = &ring->slots[index];
+    const fdio_ring_sqe_t* sqe = &slot->sqe;
+    if ((sqe->flags & O_CREAT) && (sqe->flags & O_DIRECTORY)) {
+        ring_complete(ring, index, ZX_ERR_INVALID_ARGS, 0);
+        return;
+    }
+    const uint32_t mode = (sqe->flags & O_CREAT) ? (sqe->mode & 0777) : 0;
+
+    fdio_t* iodir;
+    char clean[PATH_MAX];
+    uint32_t zxflags;
+    zx_status_t status = __fdio_open_at_prepare(sqe->fd, sqe->path, sqe->flags, &iodir, clean,
+                                                &zxflags);
+    if (status != ZX_OK) {
+        ring_complete(ring, index, status, 0);
+        return;
+    }
+
+    if (iodir->ops != &fdio_zxio_remote_ops || !(zxflags & ZX_FS_FLAG_DESCRIBE)) {
+        // Other directories, like the root of the namespace, resolve the path
+        // locally, and an open without a description isn't waited for, so
+        // these are opened right away.
+        fdio_t* io;
+        status = iodir->ops->open(iodir, clean, zxflags, mode, &io);
+        fdio_release(iodir);
+        if (status != ZX_OK) {
+            ring_complete(ring, index, status, 0);
+            return;
+        }
+        ring_complete_open(ring, index, io);
+        return;
+    }
+
+    fdio_zxio_remote_t* rio = (fdio_zxio_remote_t*)iodir;
+    zx_handle_t channel;
+    status = zxrio_open_async_start(rio->remote.control, clean, zxflags, mode, &channel);
+    fdio_release(iodir);
+    if (status != ZX_OK) {
+        ring_complete(ring, index, status, 0);
+        return;
+    }
+    slot->wait = WAIT_OPEN;
+    slot->handle = channel;
+    slot->signals = ZX_CHANNEL_READABLE | ZX_CHANNEL_PEER_CLOSED;
+    ring_arm(ring, index);
+}
+
+// Performs the slot's operation on |slot->io| synchronously.
+static void ring_perform(fdio_ring_t* ring, uint32_t index) {
+    ring_slot_t* slot = &ring->slots[index];
+    const fdio_ring_sqe_t* sqe = &slot->sqe;
+    fdio_t* io = slot->io;
+    ssize_t r;
+    switch (sqe->opcode) {
+    case FDIO_RING_OP_READ:
+        r = (sqe->offset < 0) ? io->ops->read(io, sqe->buf, sqe->len)
+                              : io->ops->read_at(io, sqe->buf, sqe->len, sqe->offset);
+        break;
+    case FDIO_RING_OP_WRITE:
+        r = (sqe->offset < 0) ? io->ops->write(io, sqe->buf, sqe->len)
+                              : io->ops->write_at(io, sqe->buf, sqe->len, sqe->offset);
+        break;
+    case FDIO_RING_OP_FSYNC:
+        r = io->ops->sync(io);
+        break;
+    default:
+        r = ZX_ERR_NOT_SUPPORTED;
+        break;
+    }
+    if (r < 0) {
+        ring_complete(ring, index, (zx_status_t)r, 0);
+    } else {
+        ring_complete(ring, index, ZX_OK, r);
+    }
+}
+
+// Starts the operation copied into the slot.
+static void ring_start(fdio_ring_t* ring, uint32_t index) {
+    ring_slot_t* slot = &ring->slots[index];
+    const fdio_ring_sqe_t* sqe = &slot->sqe;
+
+    if (sqe->opcode == FDIO_RING_OP_OPEN) {
+        ring_start_open(ring, index);
+        return;
+    }
+    if (sqe->opcode != FDIO_RING_OP_READ && sqe->opcode != FDIO_RING_OP_WRITE &&
+        sqe->opcode != FDIO_RING_OP_FSYNC) {
+        ring_complete(ring, index, ZX_ERR_NOT_SUPPORTED, 0);
+        return;
+    }
+    if ((slot->io = fd_to_io(sqe->fd)) == NULL) {
+        ring_complete(ring, index, ZX_ERR_BAD_HANDLE, 0);
+        return;
+    }
+
+    fdio_t* io = slot->io;
+    if (io->ops == &fdio_zxio_remote_ops && !((fdio_zxio_remote_t*)io)->immutable &&
+        ring_start_remote(ring, index, (fdio_zxio_remote_t*)io)) {
+        return;
+    }
+
+    if (sqe->opcode != FDIO_RING_OP_FSYNC && sqe->offset < 0) {
+        uint32_t events = (sqe->opcode == FDIO_RING_OP_READ) ? FDIO_EVT_READABLE
+                                                             : FDIO_EVT_WRITABLE;
+        io->ops->wait_begin(io, events, &slot->handle, &slot->signals);
+        if (slot->handle != ZX_HANDLE_INVALID && slot->signals != 0) {
+            slot->wait = WAIT_STREAM;
+            ring_arm(ring, index);
+            return;
+        }
+        slot->handle = ZX_HANDLE_INVALID;
+    }
+    ring_perform(ring, index);
+}
+
+// Reads a message from |channel|, and completes the operation it replies to.
+// The ring has claimed the channel, so messages which reply to none of its
+// operations, like events, are dropped.
+static zx_status_t ring_read_reply(fdio_ring_t* ring, zx_handle_t channel) {
+    zx_handle_t handles[ZX_CHANNEL_MAX_MSG_HANDLES];
+    uint32_t num_bytes;
+    uint32_t num_handles;
+    zx_status_t status = zx_channel_read(channel, 0, ring->msg, handles, RING_MSG_BYTES,
+                                         ZX_CHANNEL_MAX_MSG_HANDLES, &num_bytes, &num_handles);
+    if (status != ZX_OK) {
+        return status;
+    }
+    zx_handle_close_many(handles, num_handles);
+    if (num_bytes < sizeof(fidl_message_header_t)) {
+        return ZX_OK;
+    }
+
+    const fidl_message_header_t* hdr = (const fidl_message_header_t*)ring->msg;
+    uint32_t index;
+    for (index = 0; index < ring->entries; index++) {
+        ring_slot_t* slot = &ring->slots[index];
+        if (slot->state == SLOT_PENDING && slot->wait == WAIT_REPLY &&
+            slot->handle == channel && slot->txid == hdr->txid) {
+            break;
+        }
+    }
+    if (index == ring->entries) {
+        return ZX_OK;
+    }
+    ring_slot_t* slot = &ring->slots[index];
+    if (hdr->ordinal != slot->ordinal) {
+        ring_complete(ring, index, ZX_ERR_IO, 0);
+        return ZX_OK;
+    }
+
+    switch (slot->ordinal) {
+    case fuchsia_io_FileReadAtOrdinal: {
+        const fuchsia_io_FileReadAtResponse* response =
+            (const fuchsia_io_FileReadAtResponse*)ring->msg;
+        if (num_bytes < sizeof(*response)) {
+            ring_complete(ring, index, ZX_ERR_IO, 0);
+        } else if (response->s != ZX_OK) {
+            ring_complete(ring, index, response->s, 0);
+        } else if (response->data.count > slot->sqe.len ||
+                   response->data.count > num_bytes - sizeof(*response)) {
+            ring_complete(ring, index, ZX_ERR_IO, 0);
+        } else {
+            memcpy(slot->sqe.buf, ring->msg + sizeof(*response), response->data.count);
+            ring_complete(ring, index, ZX_OK, (int64_t)response->data.count);
+        }
+        break;
+    }
+    case fuchsia_io_FileWriteAtOrdinal: {
+        const fuchsia_io_FileWriteAtResponse* response =
+            (const fuchsia_io_FileWriteAtResponse*)ring->msg;
+        if (num_bytes < sizeof(*response) || response->actual > slot->sqe.len) {
+            ring_complete(ring, index, ZX_ERR_IO, 0);
+        } else {
+            ring_complete(ring, index, response->s, (int64_t)response->actual);
+        }
+        break;
+    }
+    case fuchsia_io_NodeSyncOrdinal: {
+        const fuchsia_io_NodeSyncResponse* response =
+            (const fuchsia_io_NodeSyncResponse*)ring->msg;
+        ring_complete(ring, index, (num_bytes < sizeof(*response)) ? ZX_ERR_IO : response->s, 0);
+        break;
+    }
+    }
+    return ZX_OK;
+}
+
+// Makes what progress it can on the slot's operation without blocking.
+static void ring_progress(fdio_ring_t* ring, uint32_t index) {
+    ring_slot_t* slot = &ring->slots[index];
+    if (slot->state != SLOT_PENDING || slot->handle == ZX_HANDLE_INVALID) {
+        return;
+    }
+    zx_signals_t pending = 0;
+    zx_object_wait_one(slot->handle, slot->signals, 0, &pending);
+    if (!(pending & slot->signals)) {
+        ring_arm(ring, index);
+        return;
+    }
+
+    switch (slot->wait) {
+    case WAIT_REPLY: {
+        zx_status_t status = ring_read_reply(ring, slot->handle);
+        if (slot->state != SLOT_PENDING) {
+            break;
+        }
+        if (status == ZX_OK || status == ZX_ERR_SHOULD_WAIT) {
+            // The message read replied to another operation, or another
+            // thread read this one's reply.
+            ring_arm(ring, index);
+        } else {
+            ring_complete(ring, index, status, 0);
+        }
+        break;
+    }
+    case WAIT_OPEN: {
+        ring_disarm(ring, index);
+        zx_handle_t channel = slot->handle;
+        slot->handle = ZX_HANDLE_INVALID;
+        fdio_t* io;
+        zx_status_t status = zxrio_open_async_finish(channel, &io);
+        if (status != ZX_OK) {
+            ring_complete(ring, index, status, 0);
+            break;
+        }
+        ring_complete_open(ring, index, io);
+        break;
+    }
+    case WAIT_STREAM: {
+        fdio_t* io = slot->io;
+        uint32_t events;
+        io->ops->wait_end(io, pending, &events);
+        if (!(events & (FDIO_EVT_READABLE | FDIO_EVT_WRITABLE | FDIO_EVT_ERROR |
+                        FDIO_EVT_PEER_CLOSED))) {
+            ring_arm(ring, index);
+            break;
+        }
+        ssize_t r = (slot->sqe.opcode == FDIO_RING_OP_READ)
+                        ? io->ops->read(io, slot->sqe.buf, slot->sqe.len)
+                        : io->ops->write(io, slot->sqe.buf, slot->sqe.len);
+        if (r == ZX_ERR_SHOULD_WAIT) {
+            // Another reader or writer got there first.
+            ring_arm(ring, index);
+        } else if (r < 0) {
+            ring_complete(ring, index, (zx_status_t)r, 0);
+        } else {
+            ring_complete(ring, index, ZX_OK, r);
+        }
+        break;
+    }
+    }
+}
+
+__EXPORT
+zx_status_t fdio_ring_create(uint32_t entries, zx_handle_t port, uint64_t key_base,
+                             fdio_ring_t** out_ring) {
+    if (entries == 0 || key_base + entries < key_base) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+    fdio_ring_t* ring = calloc(1, sizeof(*ring));
+    if (ring == NULL) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    ring->entries = entries;
+    ring->slots = calloc(entries, sizeof(ring_slot_t));
+    ring->free = calloc(entries, sizeof(uint32_t));
+    ring->done = calloc(entries, sizeof(uint32_t));
+    ring->msg = malloc(RING_MSG_BYTES);
+    if (ring->slots == NULL || ring->free == NULL || ring->done == NULL || ring->msg == NULL) {
+        fdio_ring_destroy(ring);
+        return ZX_ERR_NO_MEMORY;
+    }
+
+    zx_status_t status;
+    if (port == ZX_HANDLE_INVALID) {
+        status = zx_port_create(0, &ring->port);
+        ring->own_port = true;
+    } else {
+        status = zx_handle_duplicate(port, ZX_RIGHT_SAME_RIGHTS, &ring->port);
+    }
+    if (status != ZX_OK) {
+        ring->port = ZX_HANDLE_INVALID;
+        fdio_ring_destroy(ring);
+        return status;
+    }
+
+    mtx_init(&ring->lock, mtx_plain);
+    ring->key_base = key_base;
+    for (uint32_t i = 0; i < entries; i++) {
+        ring->free[i] = entries - 1 - i;
+    }
+    ring->free_count = entries;
+    *out_ring = ring;
+    return ZX_OK;
+}
+
+__EXPORT
+void fdio_ring_destroy(fdio_ring_t* ring) {
+    if (ring->slots != NULL) {
+        for (uint32_t i = 0; i < ring->entries; i++) {
+            ring_slot_t* slot = &ring->slots[i];
+            // The replies to messages already sent are read, so that they
+            // aren't left behind for the next user of the channel.
+            while (slot->state == SLOT_PENDING && slot->wait == WAIT_REPLY) {
+                if (zx_object_wait_one(slot->handle, slot->signals, ZX_TIME_INFINITE,
+                                       NULL) != ZX_OK) {
+                    ring_complete(ring, i, ZX_ERR_CANCELED, 0);
+                    break;
+                }
+                zx_status_t status = ring_read_reply(ring, slot->handle);
+                if (slot->state == SLOT_PENDING && status != ZX_OK &&
+                    status != ZX_ERR_SHOULD_WAIT) {
+                    ring_complete(ring, i, status, 0);
+                }
+            }
+            if (slot->state == SLOT_PENDING) {
+                ring_complete(ring, i, ZX_ERR_CANCELED, 0);
+            }
+        }
+    }
+    if (ring->port != ZX_HANDLE_INVALID) {
+        zx_handle_close(ring->port);
+        mtx_destroy(&ring->lock);
+    }
+    free(ring->slots);
+    free(ring->free);
+    free(ring->done);
+    free(ring->msg);
+    free(ring);
+}
+
+__EXPORT
+zx_status_t fdio_ring_submit(fdio_ring_t* ring, const fdio_ring_sqe_t* sqes, size_t count,
+                             size_t* out_submitted) {
+    mtx_lock(&ring->lock);
+    size_t submitted = 0;
+    while (submitted < count && ring->free_count > 0) {
+        uint32_t index = ring->free[--ring->free_count];
+        ring_slot_t* slot = &ring->slots[index];
+        memset(slot, 0, sizeof(*slot));
+        slot->state = SLOT_PENDING;
+        slot->sqe = sqes[submitted++];
+        ring_start(ring, index);
+    }
+    mtx_unlock(&ring->lock);
+
+    *out_submitted = submitted;
+    return (submitted == 0 && count > 0) ? ZX_ERR_SHOULD_WAIT : ZX_OK;
+}
+
+static size_t ring_take_done(fdio_ring_t* ring, fdio_ring_cqe_t* cqes, size_t count) {
+    size_t taken = 0;
+    while (taken < count && ring->done_count > 0) {
+        uint32_t index = ring->done[ring->done_head];
+        ring->done_head = (ring->done_head + 1) % ring->entries;
+        ring->done_count--;
+        cqes[taken++] = ring->slots[index].cqe;
+        ring->slots[index].state = SLOT_FREE;
+        ring->free[ring->free_count++] = index;
+    }
+    return taken;
+}
+
+__EXPORT
+zx_status_t fdio_ring_reap(fdio_ring_t* ring, fdio_ring_cqe_t* cqes, size_t count,
+                           zx_time_t deadline, size_t* out_actual) {
+    if (count == 0) {
+        *out_actual = 0;
+        return ZX_OK;
+    }
+    mtx_lock(&ring->lock);
+    while (ring->done_count == 0) {
+        if (!ring->own_port) {
+            mtx_unlock(&ring->lock);
+            return ZX_ERR_SHOULD_WAIT;
+        }
+        mtx_unlock(&ring->lock);
+        zx_port_packet_t packet;
+        zx_status_t status = zx_port_wait(ring->port, deadline, &packet);
+        mtx_lock(&ring->lock);
+        if (status != ZX_OK) {
+            if (ring->done_count > 0) {
+                break;
+            }
+            mtx_unlock(&ring->lock);
+            return status;
+        }
+        if (packet.type == ZX_PKT_TYPE_SIGNAL_ONE && packet.key - ring->key_base <
+            ring->entries) {
+            ring_progress(ring, (uint32_t)(packet.key - ring->key_base));
+        }
+    }
+    *out_actual = ring_take_done(ring, cqes, count);
+    mtx_unlock(&ring->lock);
+    return ZX_OK;
+}
+
+__EXPORT
+zx_status_t fdio_ring_process(fdio_ring_t* ring, const zx_port_packet_t* packet) {
+    if (packet->key < ring->key_base || packet->key - ring->key_base >= ring->entries) {
+        return ZX_ERR_NOT_FOUND;
+    }
+    if (packet->type == ZX_PKT_TYPE_SIGNAL_ONE) {
+        mtx_lock(&ring->lock);
+        ring_progress(ring, (uint32_t)(packet->key - ring->key_base));
+        mtx_unlock(&ring->lock);
+    }
+    return ZX_OK;
+}
@@ -15,6 +15,7 @@ MODULE_COMPILEFLAGS += -fvisibility=hidden
 MODULE_SRCS += \
     $(LOCAL_DIR)/bsdsocket.c \
     $(LOCAL_DIR)/debug.c \
+    $(LOCAL_DIR)/epoll.c \
     $(LOCAL_DIR)/get-vmo.c \
     $(LOCAL_DIR)/fidl.c \
     $(LOCAL_DIR)/logger.c \
@@ -23,6 +24,7 @@ MODULE_SRCS += \
     $(LOCAL_DIR)/output.c \
     $(LOCAL_DIR)/pipe.c \
     $(LOCAL_DIR)/remoteio.c \
+    $(LOCAL_DIR)/ring.c \
     $(LOCAL_DIR)/service.c \
     $(LOCAL_DIR)/socket.c \
     $(LOCAL_DIR)/spawn.c \
@@ -46,6 +48,7 @@ MODULE_FIDL_LIBS := \
 
 MODULE_STATIC_LIBS := \
     system/ulib/fidl \
+    system/ulib/sync \
     system/ulib/zxio \
     system/ulib/zxs \
     system/ulib/zx
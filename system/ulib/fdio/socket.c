@@ -115,6 +115,84 @@ static ssize_t zxsio_write_stream(fdio_t* io, const void* data, size_t len) {
     }
 }
 
+// Fills |out| with the first (at most ZX_SOCKET_IOV_MAX) entries of |iov|.
+// Returns the number of entries used and their total length via |len|.
+static size_t zxsio_fill_iovec(zx_iovec_t* out, const struct iovec* iov, int iovlen,
+                               size_t* len) {
+    size_t count = (size_t)iovlen < ZX_SOCKET_IOV_MAX ? (size_t)iovlen : ZX_SOCKET_IOV_MAX;
+    *len = 0;
+    for (size_t i = 0; i < count; i++) {
+        out[i].buffer = iov[i].iov_base;
+        out[i].capacity = iov[i].iov_len;
+        *len += iov[i].iov_len;
+    }
+    return count;
+}
+
+static ssize_t zxsio_readv_stream(fdio_t* io, const zx_iovec_t* iov, size_t count) {
+    zxsio_t* sio = (zxsio_t*)io;
+    int nonblock = sio->io.ioflag & IOFLAG_NONBLOCK;
+
+    for (;;) {
+        ssize_t r;
+        size_t bytes_read;
+        if ((r = zx_socket_readv(sio->s.socket, 0, iov, count, &bytes_read)) == ZX_OK) {
+            return (ssize_t)bytes_read;
+        }
+        if (r == ZX_ERR_PEER_CLOSED || r == ZX_ERR_BAD_STATE) {
+            return 0;
+        } else if (r == ZX_ERR_SHOULD_WAIT && !nonblock) {
+            zx_signals_t pending;
+            r = zx_object_wait_one(sio->s.socket,
+                                   ZX_SOCKET_READABLE | ZX_SOCKET_PEER_CLOSED | ZX_SOCKET_PEER_WRITE_DISABLED,
+                                   ZX_TIME_INFINITE, &pending);
+            if (r < 0) {
+                return r;
+            }
+            if (pending & ZX_SOCKET_READABLE) {
+                continue;
+            }
+            if (pending & (ZX_SOCKET_PEER_CLOSED | ZX_SOCKET_PEER_WRITE_DISABLED)) {
+                return 0;
+            }
+            // impossible
+            return ZX_ERR_INTERNAL;
+        }
+        return r;
+    }
+}
+
+static ssize_t zxsio_writev_stream(fdio_t* io, const zx_iovec_t* iov, size_t count) {
+    zxsio_t* sio = (zxsio_t*)io;
+    int nonblock = sio->io.ioflag & IOFLAG_NONBLOCK;
+
+    for (;;) {
+        ssize_t r;
+        size_t len;
+        if ((r = zx_socket_writev(sio->s.socket, 0, iov, count, &len)) == ZX_OK) {
+            return (ssize_t)len;
+        }
+        if (r == ZX_ERR_SHOULD_WAIT && !nonblock) {
+            zx_signals_t pending;
+            r = zx_object_wait_one(sio->s.socket,
+                                   ZX_SOCKET_WRITABLE | ZX_SOCKET_WRITE_DISABLED | ZX_SOCKET_PEER_CLOSED,
+                                   ZX_TIME_INFINITE, &pending);
+            if (r < 0) {
+                return r;
+            }
+            if (pending & (ZX_SOCKET_WRITE_DISABLED | ZX_SOCKET_PEER_CLOSED)) {
+                return ZX_ERR_PEER_CLOSED;
+            }
+            if (pending & ZX_SOCKET_WRITABLE) {
+                continue;
+            }
+            // impossible
+            return ZX_ERR_INTERNAL;
+        }
+        return r;
+    }
+}
+
 static ssize_t zxsio_sendto(fdio_t* io, const void* data, size_t len, int flags, const struct sockaddr* addr, socklen_t addrlen) {
     struct iovec iov;
     iov.iov_base = (void*)data;
@@ -144,15 +222,22 @@ static ssize_t zxsio_recvmsg_stream(fdio_t* io, struct msghdr* msg, int flags) {
     // (this is a consistent behavior with other OS implementations for TCP protocol)
     ssize_t total = 0;
     ssize_t n = 0;
-    for (int i = 0; i < msg->msg_iovlen; i++) {
-        struct iovec* iov = &msg->msg_iov[i];
-        n = zxsio_read_stream(io, iov->iov_base, iov->iov_len);
+    for (int i = 0; i < msg->msg_iovlen;) {
+        zx_iovec_t iov[ZX_SOCKET_IOV_MAX];
+        size_t len;
+        size_t count = zxsio_fill_iovec(iov, &msg->msg_iov[i], msg->msg_iovlen - i, &len);
+        if (len == 0) {
+            i += count;
+            continue;
+        }
+        n = zxsio_readv_stream(io, iov, count);
         if (n > 0) {
             total += n;
         }
-        if ((size_t)n != iov->iov_len) {
+        if ((size_t)n != len) {
             break;
         }
+        i += count;
     }
     return total > 0 ? total : n;
 }
@@ -172,20 +257,25 @@ static ssize_t zxsio_sendmsg_stream(fdio_t* io, const struct msghdr* msg, int fl
     } else {
         return ZX_ERR_BAD_STATE;
     }
-    ssize_t total = 0;
-    ssize_t n = 0;
     for (int i = 0; i < msg->msg_iovlen; i++) {
-        struct iovec* iov = &msg->msg_iov[i];
-        if (iov->iov_len <= 0) {
+        if (msg->msg_iov[i].iov_len <= 0) {
             return ZX_ERR_INVALID_ARGS;
         }
-        n = zxsio_write_stream(io, iov->iov_base, iov->iov_len);
+    }
+    ssize_t total = 0;
+    ssize_t n = 0;
+    for (int i = 0; i < msg->msg_iovlen;) {
+        zx_iovec_t iov[ZX_SOCKET_IOV_MAX];
+        size_t len;
+        size_t count = zxsio_fill_iovec(iov, &msg->msg_iov[i], msg->msg_iovlen - i, &len);
+        n = zxsio_writev_stream(io, iov, count);
         if (n > 0) {
             total += n;
         }
-        if ((size_t)n != iov->iov_len) {
+        if ((size_t)n != len) {
             break;
         }
+        i += count;
     }
     return total > 0 ? total : n;
 }
@@ -442,6 +532,24 @@ static ssize_t zxsio_sendmsg_dgram(fdio_t* io, const struct msghdr* msg, int fla
     }
     size_t mlen = n + FDIO_SOCKET_MSG_HEADER_SIZE;
 
+    if ((size_t)msg->msg_iovlen < ZX_SOCKET_IOV_MAX) {
+        // Send the header and the caller's buffers as one datagram without
+        // copying them together first.
+        fdio_socket_msg_t hdr;
+        if (msg->msg_name != NULL) {
+            memcpy(&hdr.addr, msg->msg_name, msg->msg_namelen);
+        }
+        hdr.addrlen = msg->msg_namelen;
+        hdr.flags = flags;
+        zx_iovec_t iov[ZX_SOCKET_IOV_MAX];
+        iov[0].buffer = &hdr;
+        iov[0].capacity = FDIO_SOCKET_MSG_HEADER_SIZE;
+        size_t len;
+        size_t count = 1 + zxsio_fill_iovec(&iov[1], msg->msg_iov, msg->msg_iovlen, &len);
+        ssize_t r = zxsio_writev_stream(io, iov, count);
+        return r < 0 ? r : n;
+    }
+
     // TODO: avoid malloc m
     fdio_socket_msg_t* m = malloc(mlen);
     if (msg->msg_name != NULL) {
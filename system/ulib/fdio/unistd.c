@@ -369,7 +369,8 @@ zx_status_t __fdio_cleanpath(const char* in, char* out, size_t* outlen, bool* is
     return ZX_OK;
 }
 
-zx_status_t __fdio_open_at(fdio_t** io, int dirfd, const char* path, int flags, uint32_t mode) {
+zx_status_t __fdio_open_at_prepare(int dirfd, const char* path, int flags, fdio_t** out_dir,
+                                   char* clean, uint32_t* out_flags) {
     if (path == NULL) {
         return ZX_ERR_INVALID_ARGS;
     }
@@ -381,20 +382,40 @@ zx_status_t __fdio_open_at(fdio_t** io, int dirfd, const char* path, int flags,
         return ZX_ERR_BAD_HANDLE;
     }
 
-    char clean[PATH_MAX];
     size_t outlen;
     bool is_dir;
     zx_status_t status = __fdio_cleanpath(path, clean, &outlen, &is_dir);
     if (status != ZX_OK) {
+        fdio_release(iodir);
         return status;
     }
     flags |= (is_dir ? O_DIRECTORY : 0);
 
-    status = iodir->ops->open(iodir, clean, fdio_flags_to_zxio(flags), mode, io);
+    *out_dir = iodir;
+    *out_flags = fdio_flags_to_zxio(flags);
+    return ZX_OK;
+}
+
+// Opens |path| like __fdio_open_at, additionally passing the fdio-only open
+// flags |fdio_flags| to the directory's open op.
+static zx_status_t __fdio_open_at_flags(fdio_t** io, int dirfd, const char* path, int flags,
+                                        uint32_t fdio_flags, uint32_t mode) {
+    fdio_t* iodir;
+    char clean[PATH_MAX];
+    uint32_t zxflags;
+    zx_status_t status = __fdio_open_at_prepare(dirfd, path, flags, &iodir, clean, &zxflags);
+    if (status != ZX_OK) {
+        return status;
+    }
+    status = iodir->ops->open(iodir, clean, zxflags | fdio_flags, mode, io);
     fdio_release(iodir);
     return status;
 }
 
+zx_status_t __fdio_open_at(fdio_t** io, int dirfd, const char* path, int flags, uint32_t mode) {
+    return __fdio_open_at_flags(io, dirfd, path, flags, 0, mode);
+}
+
 zx_status_t __fdio_open(fdio_t** io, const char* path, int flags, uint32_t mode) {
     return __fdio_open_at(io, AT_FDCWD, path, flags, mode);
 }
@@ -1545,7 +1566,9 @@ int fstatat(int dirfd, const char* fn, struct stat* s, int flags) {
     zx_status_t r;
 
     LOG(1,"fdio: fstatat(%d, '%s',...)\n", dirfd, fn);
-    if ((r = __fdio_open_at(&io, dirfd, fn, O_PATH, 0)) < 0) {
+    // The attributes are requested along with the open, so that only the
+    // close waits for a second round trip.
+    if ((r = __fdio_open_at_flags(&io, dirfd, fn, O_PATH, FDIO_OPEN_FLAG_GETATTR, 0)) < 0) {
         return ERROR(r);
     }
     LOG(1,"fdio: fstatat io=%p\n", io);
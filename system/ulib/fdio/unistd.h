@@ -19,6 +19,12 @@
 zx_status_t __fdio_open_at(fdio_t** io, int dirfd, const char* path, int flags, uint32_t mode);
 zx_status_t __fdio_open(fdio_t** io, const char* path, int flags, uint32_t mode);
 
+// Finds the directory |path| is opened from relative to |dirfd|, the cleaned
+// path to send it, which needs PATH_MAX bytes, and the zxio flags to send
+// with it, as __fdio_open_at() does. The caller releases |out_dir|.
+zx_status_t __fdio_open_at_prepare(int dirfd, const char* path, int flags, fdio_t** out_dir,
+                                   char* clean, uint32_t* out_flags);
+
 int fdio_status_to_errno(zx_status_t status);
 
 // set errno to the closest match for error and return -1
@@ -246,6 +246,23 @@ static void fdio_zxio_remote_wait_end(fdio_t* io, zx_signals_t signals, uint32_t
 }
 
 static zx_status_t fdio_zxio_remote_unwrap(fdio_t* io, zx_handle_t* handles, uint32_t* types) {
+    fdio_zxio_remote_t* fv = (fdio_zxio_remote_t*)io;
+    if (fv->vmo != ZX_HANDLE_INVALID) {
+        // Whoever receives the connection reads through the server, which
+        // has to know where the file was read up to.
+        zx_status_t io_status, status;
+        uint64_t result;
+        io_status = fuchsia_io_FileSeek(fv->remote.control, fv->seek,
+                                        fuchsia_io_SeekOrigin_START, &status, &result);
+        if (io_status != ZX_OK) {
+            return io_status;
+        }
+        if (status != ZX_OK) {
+            return status;
+        }
+        zx_handle_close(fv->vmo);
+        fv->vmo = ZX_HANDLE_INVALID;
+    }
     zxio_t* z = fdio_get_zxio(io);
     zx_handle_t handle = ZX_HANDLE_INVALID;
     zx_status_t status = zxio_release(z, &handle);
@@ -333,14 +350,142 @@ static zx_status_t fdio_zxio_remote_link(fdio_t* io, const char* src, size_t src
     return io_status != ZX_OK ? io_status : status;
 }
 
+// Acquires the VMO an immutable file is read from, the first time it is
+// needed. Returns ZX_OK if the file is read locally, and an error if it is
+// read through the server as usual.
+static zx_status_t fdio_zxio_remote_acquire_vmo_locked(fdio_zxio_remote_t* fv) {
+    if (!fv->vmo_acquired) {
+        fv->vmo_acquired = true;
+        zx_handle_t vmo = ZX_HANDLE_INVALID;
+        zx_status_t io_status, status;
+        io_status = fuchsia_io_FileGetVmo(fv->remote.control, FDIO_MMAP_FLAG_READ, &status,
+                                          &vmo);
+        if (io_status != ZX_OK || status != ZX_OK || vmo == ZX_HANDLE_INVALID) {
+            return ZX_ERR_NOT_SUPPORTED;
+        }
+        zxio_node_attr_t attr;
+        if (zxio_attr_get(&fv->remote.io, &attr) != ZX_OK) {
+            zx_handle_close(vmo);
+            return ZX_ERR_NOT_SUPPORTED;
+        }
+        fv->vmo = vmo;
+        fv->size = attr.content_size;
+    }
+    return fv->vmo != ZX_HANDLE_INVALID ? ZX_OK : ZX_ERR_NOT_SUPPORTED;
+}
+
+static ssize_t fdio_zxio_remote_read(fdio_t* io, void* data, size_t len) {
+    fdio_zxio_remote_t* fv = (fdio_zxio_remote_t*)io;
+    if (!fv->immutable) {
+        return fdio_zxio_read(io, data, len);
+    }
+    mtx_lock(&fv->lock);
+    if (fdio_zxio_remote_acquire_vmo_locked(fv) != ZX_OK) {
+        mtx_unlock(&fv->lock);
+        return fdio_zxio_read(io, data, len);
+    }
+    uint64_t at = fv->seek;
+    if (at >= fv->size) {
+        len = 0;
+    } else if (len > fv->size - at) {
+        len = fv->size - at;
+    }
+    fv->seek += len;
+    mtx_unlock(&fv->lock);
+
+    zx_status_t status = zx_vmo_read(fv->vmo, data, at, len);
+    return status != ZX_OK ? status : (ssize_t)len;
+}
+
+static ssize_t fdio_zxio_remote_read_at(fdio_t* io, void* data, size_t len, off_t at) {
+    fdio_zxio_remote_t* fv = (fdio_zxio_remote_t*)io;
+    if (!fv->immutable) {
+        return fdio_zxio_read_at(io, data, len, at);
+    }
+    mtx_lock(&fv->lock);
+    zx_status_t status = fdio_zxio_remote_acquire_vmo_locked(fv);
+    mtx_unlock(&fv->lock);
+    if (status != ZX_OK) {
+        return fdio_zxio_read_at(io, data, len, at);
+    }
+    if (at < 0) {
+        return ZX_ERR_INVALID_ARGS;
+    } else if ((uint64_t)at >= fv->size) {
+        return 0;
+    } else if (len > fv->size - at) {
+        len = fv->size - at;
+    }
+    status = zx_vmo_read(fv->vmo, data, at, len);
+    return status != ZX_OK ? status : (ssize_t)len;
+}
+
+static off_t fdio_zxio_remote_seek(fdio_t* io, off_t offset, int whence) {
+    fdio_zxio_remote_t* fv = (fdio_zxio_remote_t*)io;
+    if (!fv->immutable) {
+        return fdio_zxio_seek(io, offset, whence);
+    }
+    mtx_lock(&fv->lock);
+    if (fdio_zxio_remote_acquire_vmo_locked(fv) != ZX_OK) {
+        mtx_unlock(&fv->lock);
+        return fdio_zxio_seek(io, offset, whence);
+    }
+    // Matches the seek semantics of the server.
+    uint64_t base;
+    switch (whence) {
+    case SEEK_SET:
+        base = 0;
+        break;
+    case SEEK_CUR:
+        base = fv->seek;
+        break;
+    case SEEK_END:
+        base = fv->size;
+        break;
+    default:
+        mtx_unlock(&fv->lock);
+        return ZX_ERR_INVALID_ARGS;
+    }
+    uint64_t n = base + offset;
+    if ((whence == SEEK_SET && offset < 0) || (offset < 0 && n > base) ||
+        (offset >= 0 && n < base) || n > INT64_MAX) {
+        mtx_unlock(&fv->lock);
+        return ZX_ERR_INVALID_ARGS;
+    }
+    fv->seek = n;
+    mtx_unlock(&fv->lock);
+    return (off_t)n;
+}
+
+static zx_status_t fdio_zxio_remote_get_attr(fdio_t* io, vnattr_t* out) {
+    fdio_zxio_remote_t* fv = (fdio_zxio_remote_t*)io;
+    mtx_lock(&fv->lock);
+    if (fv->has_attr) {
+        *out = fv->attr;
+        fv->has_attr = false;
+        mtx_unlock(&fv->lock);
+        return ZX_OK;
+    }
+    mtx_unlock(&fv->lock);
+    return fdio_zxio_get_attr(io, out);
+}
+
+static zx_status_t fdio_zxio_remote_close(fdio_t* io) {
+    fdio_zxio_remote_t* fv = (fdio_zxio_remote_t*)io;
+    if (fv->vmo != ZX_HANDLE_INVALID) {
+        zx_handle_close(fv->vmo);
+        fv->vmo = ZX_HANDLE_INVALID;
+    }
+    return fdio_zxio_close(io);
+}
+
 fdio_ops_t fdio_zxio_remote_ops = {
-    .read = fdio_zxio_read,
-    .read_at = fdio_zxio_read_at,
+    .read = fdio_zxio_remote_read,
+    .read_at = fdio_zxio_remote_read_at,
     .write = fdio_zxio_write,
     .write_at = fdio_zxio_write_at,
-    .seek = fdio_zxio_seek,
+    .seek = fdio_zxio_remote_seek,
     .misc = fdio_default_misc,
-    .close = fdio_zxio_close,
+    .close = fdio_zxio_remote_close,
     .open = fdio_zxio_remote_open,
     .clone = fdio_zxio_remote_clone,
     .ioctl = fdio_zxio_remote_ioctl,
@@ -350,7 +495,7 @@ fdio_ops_t fdio_zxio_remote_ops = {
     .posix_ioctl = fdio_default_posix_ioctl,
     .get_vmo = fdio_zxio_remote_get_vmo,
     .get_token = fdio_zxio_remote_get_token,
-    .get_attr = fdio_zxio_get_attr,
+    .get_attr = fdio_zxio_remote_get_attr,
     .set_attr = fdio_zxio_set_attr,
     .sync = fdio_zxio_sync,
     .readdir = fdio_zxio_remote_readdir,
@@ -378,6 +523,7 @@ fdio_t* fdio_zxio_create_remote(zx_handle_t control, zx_handle_t event) {
     fv->io.ops = &fdio_zxio_remote_ops;
     fv->io.magic = FDIO_MAGIC;
     atomic_init(&fv->io.refcount, 1);
+    mtx_init(&fv->lock, mtx_plain);
     zx_status_t status = zxio_remote_init(&fv->remote, control, event);
     if (status != ZX_OK) {
         return NULL;
@@ -385,6 +531,14 @@ fdio_t* fdio_zxio_create_remote(zx_handle_t control, zx_handle_t event) {
     return &fv->io;
 }
 
+fdio_t* fdio_zxio_create_immutable_file(zx_handle_t control, zx_handle_t event) {
+    fdio_t* io = fdio_zxio_create_remote(control, event);
+    if (io != NULL) {
+        ((fdio_zxio_remote_t*)io)->immutable = true;
+    }
+    return io;
+}
+
 // Pipe ------------------------------------------------------------------------
 
 // Implements the |fdio_t| contract using |zxio_pipe_t|.
@@ -78,6 +78,15 @@ public:
                 return;
             }
             out_of_line_offset_ = static_cast<uint32_t>(fidl::FidlAlign(type_->coded_struct.size));
+            if (type_->coded_struct.field_count == 0u) {
+                // The compiler only emits the fields which hold pointers or
+                // handles, so the message is plain bytes with no out-of-line
+                // data: there is nothing to walk.
+                if (out_of_line_offset_ != num_bytes()) {
+                    SetError("message did not decode all provided bytes");
+                }
+                return;
+            }
             break;
         case fidl::kFidlTypeTable:
             if (num_bytes() < sizeof(fidl_vector_t)) {
@@ -5,7 +5,9 @@
 #ifndef LIB_FIDL_CPP_MESSAGE_BUFFER_H_
 #define LIB_FIDL_CPP_MESSAGE_BUFFER_H_
 
+#include <stddef.h>
 #include <stdint.h>
+#include <threads.h>
 
 #include <lib/fidl/cpp/builder.h>
 #include <lib/fidl/cpp/message.h>
@@ -14,6 +16,48 @@
 
 namespace fidl {
 
+// A pool of buffers for |MessageBuffer|s of the default capacities, which
+// are reused rather than allocated and freed for every batch of messages.
+//
+// The pool holds on to a bounded number of idle buffers; buffers returned
+// while the pool is full are freed.
+//
+// This class is thread-safe.
+class MessageBufferPool {
+public:
+    // The most idle buffers the pool holds on to.
+    static constexpr size_t kMaxIdleBuffers = 4u;
+
+#ifdef MTX_INIT
+    constexpr MessageBufferPool()
+        : mutex_(MTX_INIT), idle_{}, idle_count_(0u) {}
+#else
+    MessageBufferPool();
+#endif
+
+    // Frees the idle buffers.
+    ~MessageBufferPool();
+
+    // Returns the pool shared by the whole process.
+    static MessageBufferPool* Default();
+
+    MessageBufferPool(const MessageBufferPool&) = delete;
+    MessageBufferPool& operator=(const MessageBufferPool&) = delete;
+
+private:
+    friend class MessageBuffer;
+
+    // Returns an idle buffer, or allocates a new one.
+    uint8_t* Acquire();
+
+    // Returns |buffer| to the pool, or frees it if the pool is full.
+    void Release(uint8_t* buffer);
+
+    mtx_t mutex_;
+    uint8_t* idle_[kMaxIdleBuffers];
+    size_t idle_count_;
+};
+
 class MessageBuffer {
 public:
     // Creates a |MessageBuffer| that allocates buffers for message of the
@@ -24,7 +68,31 @@ public:
         uint32_t bytes_capacity = ZX_CHANNEL_MAX_MSG_BYTES,
         uint32_t handles_capacity = ZX_CHANNEL_MAX_MSG_HANDLES);
 
-    // The memory that backs the message is freed by this destructor.
+    // Creates a |MessageBuffer| of the default capacities whose buffers are
+    // taken from |pool| and returned to it when the |MessageBuffer| is
+    // destructed.
+    //
+    // Servers which read each message directly into the buffer and decode it
+    // in place avoid allocating a buffer every time their channel becomes
+    // readable.  The request structures their handlers see through
+    // |Message::GetBytesAs()| are views into the buffer: they remain valid
+    // until the next message is read into it or the |MessageBuffer| is
+    // destructed, whichever comes first.
+    //
+    // Example:
+    //
+    //  if (signal->observed & ZX_CHANNEL_READABLE) {
+    //      fidl::MessageBuffer buffer(fidl::MessageBufferPool::Default());
+    //      for (uint64_t i = 0; i < signal->count; i++) {
+    //          fidl::Message message = buffer.CreateEmptyMessage();
+    //          status = message.Read(channel, 0);
+    //          ...
+    //      }
+    //  }
+    explicit MessageBuffer(MessageBufferPool* pool);
+
+    // The memory that backs the message is freed (or returned to the pool)
+    // by this destructor.
     ~MessageBuffer();
 
     // The memory in which bytes can be stored in this buffer.
@@ -47,7 +115,11 @@ public:
     // Creates a |Builder| that is backed by the memory in this buffer.
     Builder CreateBuilder();
 
+    MessageBuffer(const MessageBuffer&) = delete;
+    MessageBuffer& operator=(const MessageBuffer&) = delete;
+
 private:
+    MessageBufferPool* const pool_;
     uint8_t* const buffer_;
     const uint32_t bytes_capacity_;
     const uint32_t handles_capacity_;
@@ -20,18 +20,69 @@ size_t GetAllocSize(uint32_t bytes_capacity, uint32_t handles_capacity) {
     return AddPadding(bytes_capacity) + sizeof(zx_handle_t) * handles_capacity;
 }
 
+MessageBufferPool g_default_pool;
+
 } // namespace
 
+#ifndef MTX_INIT
+MessageBufferPool::MessageBufferPool()
+    : idle_{}, idle_count_(0u) {
+    mtx_init(&mutex_, mtx_plain);
+}
+#endif
+
+MessageBufferPool::~MessageBufferPool() {
+    for (size_t i = 0; i < idle_count_; ++i)
+        free(idle_[i]);
+}
+
+MessageBufferPool* MessageBufferPool::Default() {
+    return &g_default_pool;
+}
+
+uint8_t* MessageBufferPool::Acquire() {
+    mtx_lock(&mutex_);
+    uint8_t* buffer = idle_count_ > 0u ? idle_[--idle_count_] : nullptr;
+    mtx_unlock(&mutex_);
+    if (buffer)
+        return buffer;
+    return static_cast<uint8_t*>(
+        malloc(GetAllocSize(ZX_CHANNEL_MAX_MSG_BYTES, ZX_CHANNEL_MAX_MSG_HANDLES)));
+}
+
+void MessageBufferPool::Release(uint8_t* buffer) {
+    mtx_lock(&mutex_);
+    if (idle_count_ < kMaxIdleBuffers) {
+        idle_[idle_count_++] = buffer;
+        buffer = nullptr;
+    }
+    mtx_unlock(&mutex_);
+    free(buffer);
+}
+
 MessageBuffer::MessageBuffer(uint32_t bytes_capacity,
                              uint32_t handles_capacity)
-    : buffer_(static_cast<uint8_t*>(malloc(GetAllocSize(bytes_capacity, handles_capacity)))),
+    : pool_(nullptr),
+      buffer_(static_cast<uint8_t*>(malloc(GetAllocSize(bytes_capacity, handles_capacity)))),
       bytes_capacity_(bytes_capacity),
       handles_capacity_(handles_capacity) {
     ZX_ASSERT_MSG(buffer_, "malloc returned NULL in MessageBuffer::MessageBuffer()");
 }
 
+MessageBuffer::MessageBuffer(MessageBufferPool* pool)
+    : pool_(pool),
+      buffer_(pool->Acquire()),
+      bytes_capacity_(ZX_CHANNEL_MAX_MSG_BYTES),
+      handles_capacity_(ZX_CHANNEL_MAX_MSG_HANDLES) {
+    ZX_ASSERT_MSG(buffer_, "malloc returned NULL in MessageBuffer::MessageBuffer()");
+}
+
 MessageBuffer::~MessageBuffer() {
-    free(buffer_);
+    if (pool_) {
+        pool_->Release(buffer_);
+    } else {
+        free(buffer_);
+    }
 }
 
 zx_handle_t* MessageBuffer::handles() const {
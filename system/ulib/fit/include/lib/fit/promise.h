@@ -0,0 +1,546 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef LIB_FIT_PROMISE_H_
+#define LIB_FIT_PROMISE_H_
+
+#include <assert.h>
+#include <stdint.h>
+
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "function.h"
+#include "nullable.h"
+#include "promise_internal.h"
+#include "result.h"
+
+namespace fit {
+
+// A |fit::promise| is a building block for asynchronous control flow that
+// wraps an asynchronous task in the form of a "continuation" that is
+// repeatedly invoked by an executor until it produces a result.
+//
+// Additional asynchronous tasks can be chained onto the promise using
+// a variety of combinators such as |then()|, |and_then()|, and |or_else()|.
+//
+// Call |fit::make_promise()| to create a promise from a handler, or
+// |fit::make_ok_promise()| and |fit::make_error_promise()| to create one
+// which completes immediately.  Use |fit::join_promises()| to wait for
+// several promises to complete.
+//
+// PROMISE AND CONTINUATION TYPES
+//
+// Each combinator produces a |fit::promise_impl<Continuation>| whose
+// continuation type encodes the entire chain of tasks that it performs.
+// These promises are evaluated by calling the continuations they wrap
+// directly: no virtual dispatch and no heap allocation is involved in
+// chaining or running them, however long the chain grows.
+//
+// |fit::promise<V, E>| is the type-erased form of a promise which produces
+// values of type |V| and errors of type |E|, which is convenient to
+// store and return from functions.  It wraps the continuation in a
+// |fit::function|, so erasing a large continuation may allocate once.  Call
+// |box()| to erase the type of a promise after it has been composed.
+//
+// CONTINUATIONS AND HANDLERS
+//
+// A continuation is a callable object with the signature
+// |fit::result<V, E>(fit::context&)|.  It returns |fit::pending()| when it
+// cannot make progress, after calling |fit::context::suspend_task()| to
+// arrange to be resumed later on.  Once it returns an ok or error result,
+// the promise completes and becomes empty.
+//
+// The handlers passed to the combinators may optionally take the
+// |fit::context&| as their first argument.  They may return:
+// - void: the promise completes with |fit::ok()|.
+// - |fit::result<V, E>|: the promise completes with that result.  If the
+//   result is pending, the handler is invoked again when the task resumes.
+// - |fit::ok_result<V>| or |fit::error_result<E>|: the promise completes
+//   with that value or error.
+// - |fit::promise_impl<...>|: the returned promise is evaluated in place
+//   of the handler and its result becomes the promise's result.
+//
+// Handlers must not be generic lambdas or overloaded function objects
+// since their argument list is used to determine whether they take the
+// context.
+//
+// EXAMPLE
+//
+// fit::promise<int, std::string> read_config();
+// fit::promise<> apply_config(int value);
+//
+// fit::promise<> update() {
+//     return read_config()
+//         .and_then([](int& value) { return apply_config(value); })
+//         .or_else([](std::string& error) {
+//             printf("failed to read config: %s\n", error.c_str());
+//             return fit::error();
+//         })
+//         .box();
+// }
+//
+// THREADING
+//
+// Promises are not thread-safe.  A promise is evaluated by one executor
+// at a time, although tasks may be resumed from any thread through their
+// |fit::suspended_task|, as the executor permits.
+template <typename Continuation>
+class promise_impl final {
+    using traits = internal::continuation_traits<Continuation>;
+
+    template <typename>
+    friend class promise_impl;
+
+public:
+    // The type of result produced by the promise.
+    using result_type = typename traits::result_type;
+    using value_type = typename result_type::value_type;
+    using error_type = typename result_type::error_type;
+
+    // Creates an empty promise without a continuation.
+    promise_impl() = default;
+    explicit promise_impl(decltype(nullptr)) {}
+
+    // Creates a promise with a continuation.
+    explicit promise_impl(Continuation continuation)
+        : continuation_(std::move(continuation)) {}
+
+    // Converts from a promise holding a continuation which is assignable
+    // to this promise's continuation type, such as when erasing its type
+    // into a |fit::promise|.
+    template <typename OtherContinuation,
+              typename = std::enable_if_t<
+                  !std::is_same<Continuation, OtherContinuation>::value &&
+                  std::is_constructible<Continuation,
+                                        OtherContinuation&&>::value>>
+    promise_impl(promise_impl<OtherContinuation> other)
+        : continuation_(other.continuation_.has_value()
+                            ? nullable<Continuation>(
+                                  Continuation(std::move(other.continuation_.value())))
+                            : nullable<Continuation>()) {}
+
+    // Moves from another promise, leaving the other one empty.
+    promise_impl(promise_impl&& other)
+        : continuation_(std::move(other.continuation_)) {
+        other.continuation_.reset();
+    }
+
+    // Discards the promise's continuation without running it.
+    ~promise_impl() = default;
+
+    // Returns true if the promise is non-empty, meaning that it has a
+    // continuation which has not yet completed.
+    explicit operator bool() const { return continuation_.has_value(); }
+
+    // Evaluates the promise and returns its result.
+    //
+    // Once the promise produces an ok or error result, it becomes empty.
+    //
+    // This method is normally called by an executor; it should rarely be
+    // called directly by clients.  Asserts that the promise is not empty.
+    result_type operator()(context& context) {
+        assert(continuation_.has_value());
+        result_type result = (continuation_.value())(context);
+        if (!result.is_pending())
+            continuation_.reset();
+        return result;
+    }
+
+    // Takes the promise's continuation, leaving the promise empty.
+    Continuation take_continuation() {
+        assert(continuation_.has_value());
+        Continuation continuation(std::move(continuation_.value()));
+        continuation_.reset();
+        return continuation;
+    }
+
+    // Moves from another promise, leaving the other one empty.
+    promise_impl& operator=(promise_impl&& other) {
+        if (this != &other) {
+            continuation_ = std::move(other.continuation_);
+            other.continuation_.reset();
+        }
+        return *this;
+    }
+
+    // Discards the promise's continuation, leaving it empty.
+    promise_impl& operator=(decltype(nullptr)) {
+        continuation_.reset();
+        return *this;
+    }
+
+    // Swaps the promises' continuations.
+    void swap(promise_impl& other) {
+        continuation_.swap(other.continuation_);
+    }
+
+    // Returns a promise which invokes |handler| with this promise's
+    // result, whether it is ok or an error, once this promise completes.
+    //
+    // |handler| is invoked with |fit::context&| (optionally) and
+    // |result_type&|.
+    //
+    // Consumes this promise, leaving it empty.  Asserts that it was not
+    // empty to begin with.
+    template <typename ResultHandler>
+    promise_impl<internal::then_continuation<promise_impl, ResultHandler>>
+    then(ResultHandler handler) {
+        assert(continuation_.has_value());
+        return make_continued<internal::then_continuation<promise_impl, ResultHandler>>(
+            std::move(handler));
+    }
+
+    // Returns a promise which invokes |handler| with this promise's value
+    // if it completes successfully.  If it fails, the error is passed
+    // through and |handler| is not invoked.
+    //
+    // |handler| is invoked with |fit::context&| (optionally) and
+    // |value_type&| (unless it is void).
+    //
+    // Consumes this promise, leaving it empty.  Asserts that it was not
+    // empty to begin with.
+    template <typename ValueHandler>
+    promise_impl<internal::and_then_continuation<promise_impl, ValueHandler>>
+    and_then(ValueHandler handler) {
+        assert(continuation_.has_value());
+        return make_continued<internal::and_then_continuation<promise_impl, ValueHandler>>(
+            std::move(handler));
+    }
+
+    // Returns a promise which invokes |handler| with this promise's error
+    // if it fails.  If it completes successfully, the value is passed
+    // through and |handler| is not invoked.
+    //
+    // |handler| is invoked with |fit::context&| (optionally) and
+    // |error_type&| (unless it is void).
+    //
+    // Consumes this promise, leaving it empty.  Asserts that it was not
+    // empty to begin with.
+    template <typename ErrorHandler>
+    promise_impl<internal::or_else_continuation<promise_impl, ErrorHandler>>
+    or_else(ErrorHandler handler) {
+        assert(continuation_.has_value());
+        return make_continued<internal::or_else_continuation<promise_impl, ErrorHandler>>(
+            std::move(handler));
+    }
+
+    // Returns a promise which invokes |handler| with this promise's result
+    // once it completes and then produces the same result.  |handler| may
+    // examine or modify the result but must return void.
+    //
+    // |handler| is invoked with |fit::context&| (optionally) and
+    // |result_type&|.
+    //
+    // Consumes this promise, leaving it empty.  Asserts that it was not
+    // empty to begin with.
+    template <typename InspectHandler>
+    promise_impl<internal::inspect_continuation<promise_impl, InspectHandler>>
+    inspect(InspectHandler handler) {
+        static_assert(std::is_void<typename internal::handler_traits<
+                          InspectHandler, result_type>::return_type>::value,
+                      "Inspect handlers must return void.");
+        assert(continuation_.has_value());
+        return make_continued<internal::inspect_continuation<promise_impl, InspectHandler>>(
+            std::move(handler));
+    }
+
+    // Returns a promise which completes with |fit::ok()| once this promise
+    // completes, discarding its result.
+    //
+    // Consumes this promise, leaving it empty.  Asserts that it was not
+    // empty to begin with.
+    promise_impl<internal::discard_result_continuation<promise_impl>>
+    discard_result() {
+        assert(continuation_.has_value());
+        return promise_impl<internal::discard_result_continuation<promise_impl>>(
+            internal::discard_result_continuation<promise_impl>(std::move(*this)));
+    }
+
+    // Erases the type of this promise's continuation, returning a
+    // |fit::promise| with the same result type.
+    //
+    // Consumes this promise, leaving it empty.
+    promise_impl<function<result_type(context&)>> box() {
+        return std::move(*this);
+    }
+
+    promise_impl(const promise_impl& other) = delete;
+    promise_impl& operator=(const promise_impl& other) = delete;
+
+private:
+    template <typename NextContinuation, typename Handler>
+    promise_impl<NextContinuation> make_continued(Handler handler) {
+        return promise_impl<NextContinuation>(
+            NextContinuation(std::move(*this), std::move(handler)));
+    }
+
+    nullable<Continuation> continuation_;
+};
+
+template <typename Continuation>
+void swap(promise_impl<Continuation>& a, promise_impl<Continuation>& b) {
+    a.swap(b);
+}
+
+// A promise with a type-erased continuation which produces values of
+// type |V| and errors of type |E|.
+template <typename V = void, typename E = void>
+using promise = promise_impl<function<result<V, E>(context&)>>;
+
+// Makes a promise from a continuation: a callable object with the
+// signature |fit::result<V, E>(fit::context&)|.
+template <typename Continuation>
+inline promise_impl<Continuation> make_promise_with_continuation(
+    Continuation continuation) {
+    return promise_impl<Continuation>(std::move(continuation));
+}
+
+// Makes a promise which invokes |handler| when it is evaluated.
+//
+// |handler| is invoked with |fit::context&| (optionally), and its return
+// value is interpreted as described for |fit::promise_impl|.
+//
+// EXAMPLE
+//
+// auto p = fit::make_promise([](fit::context& context) -> fit::result<int> {
+//     if (!ready()) {
+//         watch_for_ready(context.suspend_task());
+//         return fit::pending();
+//     }
+//     return fit::ok(read_value());
+// });
+template <typename Handler>
+inline promise_impl<internal::context_handler_invoker<Handler>>
+make_promise(Handler handler) {
+    return make_promise_with_continuation(
+        internal::context_handler_invoker<Handler>(std::move(handler)));
+}
+
+// Makes a promise which completes immediately with |result|.
+template <typename V = void, typename E = void>
+inline promise_impl<internal::result_continuation<result<V, E>>>
+make_result_promise(result<V, E> result) {
+    return make_promise_with_continuation(
+        internal::result_continuation<::fit::result<V, E>>(std::move(result)));
+}
+
+// Makes a promise which completes immediately with the value |value|.
+template <typename V, typename E = void>
+inline promise_impl<internal::result_continuation<result<V, E>>>
+make_ok_promise(V value) {
+    return make_result_promise<V, E>(::fit::ok(std::move(value)));
+}
+template <typename E = void>
+inline promise_impl<internal::result_continuation<result<void, E>>>
+make_ok_promise() {
+    return make_result_promise<void, E>(::fit::ok());
+}
+
+// Makes a promise which completes immediately with the error |error|.
+template <typename V = void, typename E>
+inline promise_impl<internal::result_continuation<result<V, E>>>
+make_error_promise(E error) {
+    return make_result_promise<V, E>(::fit::error(std::move(error)));
+}
+
+// Makes a promise which evaluates all of |promises| each time it is
+// evaluated until they all complete, then produces a tuple of their
+// results.  The joined promise always completes successfully; the results
+// of the individual promises report their successes and failures.
+template <typename... Promises>
+inline promise_impl<internal::join_continuation<Promises...>>
+join_promises(Promises... promises) {
+    return make_promise_with_continuation(
+        internal::join_continuation<Promises...>(std::move(promises)...));
+}
+
+// A task which has been suspended and is awaiting resumption.
+//
+// Obtain a |suspended_task| from |fit::context::suspend_task()| while a
+// task is running, then call |resume_task()| when the task is ready to
+// make progress again.  If the |suspended_task| is destroyed or reset
+// without resuming the task and no other |suspended_task| instances refer
+// to it, the executor abandons the task and destroys it.
+//
+// Instances may be copied, each copy referring to the same task.  Resuming
+// the task through one copy resets that copy only.
+class suspended_task final {
+public:
+    // Identifies a suspended task to its resolver.
+    using ticket = uint64_t;
+
+    // The executor's interface for tracking the tickets of suspended tasks.
+    class resolver {
+    public:
+        // Returns a new ticket for the task referred to by |ticket|, which
+        // must be resolved separately.
+        virtual ticket duplicate_ticket(ticket ticket) = 0;
+
+        // Consumes |ticket|, scheduling the task to run again if
+        // |resume_task| is true.
+        virtual void resolve_ticket(ticket ticket, bool resume_task) = 0;
+
+    protected:
+        virtual ~resolver() = default;
+    };
+
+    suspended_task()
+        : resolver_(nullptr), ticket_(0) {}
+
+    suspended_task(resolver* resolver, ticket ticket)
+        : resolver_(resolver), ticket_(ticket) {}
+
+    suspended_task(const suspended_task& other)
+        : resolver_(other.resolver_),
+          ticket_(resolver_ ? resolver_->duplicate_ticket(other.ticket_) : 0) {}
+
+    suspended_task(suspended_task&& other)
+        : resolver_(other.resolver_), ticket_(other.ticket_) {
+        other.resolver_ = nullptr;
+    }
+
+    // Releases the task without resuming it.
+    ~suspended_task() { reset(); }
+
+    // Returns true if this instance refers to a task.
+    explicit operator bool() const { return resolver_ != nullptr; }
+
+    // Schedules the task to run again, then resets this instance.
+    void resume_task() { resolve(true); }
+
+    // Releases the task without resuming it, then resets this instance.
+    void reset() { resolve(false); }
+
+    suspended_task& operator=(const suspended_task& other) {
+        if (this != &other) {
+            reset();
+            resolver_ = other.resolver_;
+            ticket_ = resolver_ ? resolver_->duplicate_ticket(other.ticket_) : 0;
+        }
+        return *this;
+    }
+
+    suspended_task& operator=(suspended_task&& other) {
+        if (this != &other) {
+            reset();
+            resolver_ = other.resolver_;
+            ticket_ = other.ticket_;
+            other.resolver_ = nullptr;
+        }
+        return *this;
+    }
+
+    void swap(suspended_task& other) {
+        std::swap(resolver_, other.resolver_);
+        std::swap(ticket_, other.ticket_);
+    }
+
+private:
+    void resolve(bool resume_task) {
+        if (resolver_) {
+            // Clear the fields before calling into the resolver in case it
+            // reenters this instance.
+            resolver* resolver = resolver_;
+            resolver_ = nullptr;
+            resolver->resolve_ticket(ticket_, resume_task);
+        }
+    }
+
+    resolver* resolver_;
+    ticket ticket_;
+};
+
+inline void swap(suspended_task& a, suspended_task& b) {
+    a.swap(b);
+}
+
+// The context of a task which is being run by an executor.
+//
+// An executor passes a context to the task's promise each time it is
+// evaluated.  Executors may subclass it to offer additional facilities.
+class context {
+public:
+    // Returns the executor which is running the task.
+    virtual class executor* executor() const = 0;
+
+    // Obtains a handle which can be used to resume the task after it
+    // returns |fit::pending()|.  If the task returns |fit::pending()| and
+    // nothing holds on to a handle for it, the executor abandons the task.
+    virtual suspended_task suspend_task() = 0;
+
+    // Converts this context to a derived context type.
+    template <typename Context,
+              typename = std::enable_if_t<std::is_base_of<context, Context>::value>>
+    Context& as() & {
+        return static_cast<Context&>(*this);
+    }
+
+protected:
+    virtual ~context() = default;
+};
+
+// A task which is ready to be scheduled on an executor: a type-erased
+// promise whose result is discarded.
+class pending_task final {
+public:
+    // Creates an empty task.
+    pending_task() = default;
+
+    // Creates a task from a promise.
+    template <typename Continuation>
+    pending_task(promise_impl<Continuation> promise)
+        : promise_(promise ? promise.discard_result().box() : fit::promise<>()) {}
+
+    pending_task(pending_task&& other) = default;
+    pending_task& operator=(pending_task&& other) = default;
+
+    // Destroys the task's promise without running it.
+    ~pending_task() = default;
+
+    // Returns true if the task has a promise which has not yet completed.
+    explicit operator bool() const { return !!promise_; }
+
+    // Evaluates the task's promise.  Returns true once it has completed
+    // and the task is done, or false if it is still pending.
+    //
+    // This method is called by executors.  Asserts that the task is not
+    // empty.
+    bool operator()(context& context) {
+        return !promise_(context).is_pending();
+    }
+
+    // Takes the task's promise, leaving the task empty.
+    fit::promise<> take_promise() {
+        return std::move(promise_);
+    }
+
+    pending_task(const pending_task& other) = delete;
+    pending_task& operator=(const pending_task& other) = delete;
+
+private:
+    fit::promise<> promise_;
+};
+
+// An executor runs tasks until they complete.
+//
+// Tasks are scheduled with |schedule_task()|; the executor evaluates
+// each task's promise, supplying a |fit::context| for it to suspend
+// itself with, until the promise completes, then destroys the task.
+//
+// FIT only defines the interface: event loops and other dispatchers
+// provide the implementations.
+class executor {
+public:
+    // Schedules a task to be run.  The executor takes ownership of it.
+    virtual void schedule_task(pending_task task) = 0;
+
+protected:
+    virtual ~executor() = default;
+};
+
+} // namespace fit
+
+#endif // LIB_FIT_PROMISE_H_
@@ -0,0 +1,427 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef LIB_FIT_PROMISE_INTERNAL_H_
+#define LIB_FIT_PROMISE_INTERNAL_H_
+
+#include <assert.h>
+
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "result.h"
+#include "traits.h"
+
+namespace fit {
+
+template <typename Continuation>
+class promise_impl;
+
+class context;
+
+namespace internal {
+
+// Determines whether a type is a promise.
+template <typename T>
+struct is_promise : public std::false_type {};
+template <typename Continuation>
+struct is_promise<promise_impl<Continuation>> : public std::true_type {};
+
+// Determines whether a type is a result.
+template <typename T>
+struct is_result : public std::false_type {};
+template <typename V, typename E>
+struct is_result<result<V, E>> : public std::true_type {};
+
+// Deduces a continuation's result.
+// Also ensures that the continuation has a compatible signature.
+template <typename Continuation,
+          typename = std::enable_if_t<is_result<
+              decltype(std::declval<Continuation&>()(
+                  std::declval<fit::context&>()))>::value>>
+struct continuation_traits {
+    using type = Continuation;
+    using result_type = decltype(std::declval<Continuation&>()(std::declval<fit::context&>()));
+};
+
+// Invokes a handler with the given arguments, passing the context as the
+// first argument if the handler accepts one.
+//
+// Handlers must not be overloaded or generic since their argument list is
+// used to determine whether they take the context.
+template <typename Handler, typename... Args>
+struct handler_traits {
+    using traits = callable_traits<Handler>;
+    static constexpr bool takes_context = traits::args::size == sizeof...(Args) + 1;
+    using return_type = typename traits::return_type;
+};
+
+template <typename Handler, typename... Args>
+decltype(auto) invoke_handler(std::true_type, Handler& handler,
+                              fit::context& context, Args&... args) {
+    return handler(context, args...);
+}
+
+template <typename Handler, typename... Args>
+decltype(auto) invoke_handler(std::false_type, Handler& handler,
+                              fit::context& context, Args&... args) {
+    return handler(args...);
+}
+
+template <typename Handler, typename... Args>
+decltype(auto) invoke_handler(Handler& handler, fit::context& context,
+                              Args&... args) {
+    return invoke_handler(
+        std::integral_constant<bool,
+                               handler_traits<Handler, Args...>::takes_context>{},
+        handler, context, args...);
+}
+
+// Adapts the return value of a handler to a result.
+//
+// The handler may return:
+// - void: produces an ok result with value type |void| and error type
+//   |DefaultE|
+// - fit::result<V, E>: produces the handler's result, the handler is invoked
+//   again if the result is pending
+// - fit::ok_result<V>: produces an ok result with error type |DefaultE|
+// - fit::error_result<E>: produces an error result with value type |DefaultV|
+// - fit::promise_impl<...>: produces the result of the promise, which is
+//   evaluated in place of the handler until it completes
+template <typename R, typename DefaultV, typename DefaultE, typename = void>
+class result_adapter;
+
+template <typename DefaultV, typename DefaultE>
+class result_adapter<void, DefaultV, DefaultE> final {
+public:
+    using result_type = ::fit::result<void, DefaultE>;
+
+    template <typename Handler, typename... Args>
+    result_type call(fit::context& context, Handler& handler, Args&... args) {
+        invoke_handler(handler, context, args...);
+        return ::fit::ok();
+    }
+};
+
+template <typename V, typename E, typename DefaultV, typename DefaultE>
+class result_adapter<::fit::result<V, E>, DefaultV, DefaultE> final {
+public:
+    using result_type = ::fit::result<V, E>;
+
+    template <typename Handler, typename... Args>
+    result_type call(fit::context& context, Handler& handler, Args&... args) {
+        return invoke_handler(handler, context, args...);
+    }
+};
+
+template <typename V, typename DefaultV, typename DefaultE>
+class result_adapter<::fit::ok_result<V>, DefaultV, DefaultE> final {
+public:
+    using result_type = ::fit::result<V, DefaultE>;
+
+    template <typename Handler, typename... Args>
+    result_type call(fit::context& context, Handler& handler, Args&... args) {
+        return invoke_handler(handler, context, args...);
+    }
+};
+
+template <typename E, typename DefaultV, typename DefaultE>
+class result_adapter<::fit::error_result<E>, DefaultV, DefaultE> final {
+public:
+    using result_type = ::fit::result<DefaultV, E>;
+
+    template <typename Handler, typename... Args>
+    result_type call(fit::context& context, Handler& handler, Args&... args) {
+        return invoke_handler(handler, context, args...);
+    }
+};
+
+template <typename Promise, typename DefaultV, typename DefaultE>
+class result_adapter<Promise, DefaultV, DefaultE,
+                     std::enable_if_t<is_promise<Promise>::value>>
+    final {
+public:
+    using result_type = typename Promise::result_type;
+
+    template <typename Handler, typename... Args>
+    result_type call(fit::context& context, Handler& handler, Args&... args) {
+        if (!promise_)
+            promise_ = invoke_handler(handler, context, args...);
+        return promise_(context);
+    }
+
+private:
+    Promise promise_;
+};
+
+// Adapts a handler to the result adapter for its return type.
+template <typename Handler, typename DefaultV, typename DefaultE, typename... Args>
+using handler_result_adapter = result_adapter<
+    typename handler_traits<Handler, Args...>::return_type, DefaultV, DefaultE>;
+
+// Continuation for a promise that completes with a fixed result.
+template <typename Result>
+class result_continuation final {
+public:
+    explicit result_continuation(Result result)
+        : result_(std::move(result)) {}
+
+    Result operator()(fit::context& context) {
+        return std::move(result_);
+    }
+
+private:
+    Result result_;
+};
+
+// Continuation for a promise that calls a handler which optionally
+// accepts the context as its only argument.
+template <typename Handler>
+class context_handler_invoker final {
+    using adapter_type = handler_result_adapter<Handler, void, void>;
+
+public:
+    using result_type = typename adapter_type::result_type;
+
+    explicit context_handler_invoker(Handler handler)
+        : handler_(std::move(handler)) {}
+
+    result_type operator()(fit::context& context) {
+        return adapter_.call(context, handler_);
+    }
+
+private:
+    Handler handler_;
+    adapter_type adapter_;
+};
+
+// Continuation for |promise_impl::then()|.
+template <typename PriorPromise, typename ResultHandler>
+class then_continuation final {
+    using prior_result_type = typename PriorPromise::result_type;
+    using adapter_type = handler_result_adapter<
+        ResultHandler, void, void, prior_result_type>;
+
+public:
+    using result_type = typename adapter_type::result_type;
+
+    then_continuation(PriorPromise prior_promise, ResultHandler handler)
+        : prior_promise_(std::move(prior_promise)),
+          handler_(std::move(handler)) {}
+
+    result_type operator()(fit::context& context) {
+        if (prior_promise_) {
+            prior_result_ = prior_promise_(context);
+            if (prior_result_.is_pending())
+                return ::fit::pending();
+        }
+        return adapter_.call(context, handler_, prior_result_);
+    }
+
+private:
+    PriorPromise prior_promise_;
+    prior_result_type prior_result_;
+    ResultHandler handler_;
+    adapter_type adapter_;
+};
+
+// Invokes a value handler with the prior promise's value, if it has one.
+template <typename Adapter, typename Handler, typename Result>
+typename Adapter::result_type call_value_handler(
+    std::true_type, Adapter& adapter, fit::context& context,
+    Handler& handler, Result& result) {
+    return adapter.call(context, handler);
+}
+
+template <typename Adapter, typename Handler, typename Result>
+typename Adapter::result_type call_value_handler(
+    std::false_type, Adapter& adapter, fit::context& context,
+    Handler& handler, Result& result) {
+    return adapter.call(context, handler, result.value());
+}
+
+// Invokes an error handler with the prior promise's error, if it has one.
+template <typename Adapter, typename Handler, typename Result>
+typename Adapter::result_type call_error_handler(
+    std::true_type, Adapter& adapter, fit::context& context,
+    Handler& handler, Result& result) {
+    return adapter.call(context, handler);
+}
+
+template <typename Adapter, typename Handler, typename Result>
+typename Adapter::result_type call_error_handler(
+    std::false_type, Adapter& adapter, fit::context& context,
+    Handler& handler, Result& result) {
+    return adapter.call(context, handler, result.error());
+}
+
+// Adapts a handler which takes the prior promise's value or error as its
+// argument, or no argument if that type is void.
+template <typename ValueHandler, typename DefaultV, typename DefaultE, typename V>
+struct arg_handler_result_adapter {
+    using type = handler_result_adapter<ValueHandler, DefaultV, DefaultE, V>;
+};
+template <typename ValueHandler, typename DefaultV, typename DefaultE>
+struct arg_handler_result_adapter<ValueHandler, DefaultV, DefaultE, void> {
+    using type = handler_result_adapter<ValueHandler, DefaultV, DefaultE>;
+};
+
+// Continuation for |promise_impl::and_then()|.
+template <typename PriorPromise, typename ValueHandler>
+class and_then_continuation final {
+    using prior_result_type = typename PriorPromise::result_type;
+    using prior_value_type = typename PriorPromise::value_type;
+    using prior_error_type = typename PriorPromise::error_type;
+    using adapter_type = typename arg_handler_result_adapter<
+        ValueHandler, void, prior_error_type, prior_value_type>::type;
+
+public:
+    using result_type = typename adapter_type::result_type;
+
+    and_then_continuation(PriorPromise prior_promise, ValueHandler handler)
+        : prior_promise_(std::move(prior_promise)),
+          handler_(std::move(handler)) {}
+
+    result_type operator()(fit::context& context) {
+        if (prior_promise_) {
+            prior_result_ = prior_promise_(context);
+            if (prior_result_.is_pending())
+                return ::fit::pending();
+        }
+        if (prior_result_.is_error())
+            return prior_result_.take_error_result();
+        return call_value_handler(std::is_void<prior_value_type>{},
+                                  adapter_, context, handler_, prior_result_);
+    }
+
+private:
+    PriorPromise prior_promise_;
+    prior_result_type prior_result_;
+    ValueHandler handler_;
+    adapter_type adapter_;
+};
+
+// Continuation for |promise_impl::or_else()|.
+template <typename PriorPromise, typename ErrorHandler>
+class or_else_continuation final {
+    using prior_result_type = typename PriorPromise::result_type;
+    using prior_value_type = typename PriorPromise::value_type;
+    using prior_error_type = typename PriorPromise::error_type;
+    using adapter_type = typename arg_handler_result_adapter<
+        ErrorHandler, prior_value_type, void, prior_error_type>::type;
+
+public:
+    using result_type = typename adapter_type::result_type;
+
+    or_else_continuation(PriorPromise prior_promise, ErrorHandler handler)
+        : prior_promise_(std::move(prior_promise)),
+          handler_(std::move(handler)) {}
+
+    result_type operator()(fit::context& context) {
+        if (prior_promise_) {
+            prior_result_ = prior_promise_(context);
+            if (prior_result_.is_pending())
+                return ::fit::pending();
+        }
+        if (prior_result_.is_ok())
+            return prior_result_.take_ok_result();
+        return call_error_handler(std::is_void<prior_error_type>{},
+                                  adapter_, context, handler_, prior_result_);
+    }
+
+private:
+    PriorPromise prior_promise_;
+    prior_result_type prior_result_;
+    ErrorHandler handler_;
+    adapter_type adapter_;
+};
+
+// Continuation for |promise_impl::inspect()|.
+template <typename PriorPromise, typename InspectHandler>
+class inspect_continuation final {
+public:
+    using result_type = typename PriorPromise::result_type;
+
+    inspect_continuation(PriorPromise prior_promise, InspectHandler handler)
+        : prior_promise_(std::move(prior_promise)),
+          handler_(std::move(handler)) {}
+
+    result_type operator()(fit::context& context) {
+        result_type result = prior_promise_(context);
+        if (!result.is_pending())
+            invoke_handler(handler_, context, result);
+        return result;
+    }
+
+private:
+    PriorPromise prior_promise_;
+    InspectHandler handler_;
+};
+
+// Continuation for |promise_impl::discard_result()|.
+template <typename PriorPromise>
+class discard_result_continuation final {
+public:
+    using result_type = ::fit::result<>;
+
+    explicit discard_result_continuation(PriorPromise prior_promise)
+        : prior_promise_(std::move(prior_promise)) {}
+
+    result_type operator()(fit::context& context) {
+        if (prior_promise_(context).is_pending())
+            return ::fit::pending();
+        return ::fit::ok();
+    }
+
+private:
+    PriorPromise prior_promise_;
+};
+
+// Continuation for |fit::join_promises()|.
+template <typename... Promises>
+class join_continuation final {
+public:
+    using tuple_type = std::tuple<typename Promises::result_type...>;
+    using result_type = ::fit::result<tuple_type>;
+
+    explicit join_continuation(Promises... promises)
+        : promises_(std::move(promises)...) {}
+
+    result_type operator()(fit::context& context) {
+        return evaluate(context, std::index_sequence_for<Promises...>{});
+    }
+
+private:
+    template <size_t... i>
+    result_type evaluate(fit::context& context, std::index_sequence<i...>) {
+        bool done = true;
+        // Evaluating each promise in turn through an initializer list
+        // guarantees left-to-right order.
+        bool unused[] = {true, (done &= evaluate_one<i>(context))...};
+        (void)unused;
+        if (!done)
+            return ::fit::pending();
+        return ::fit::ok(std::move(results_));
+    }
+
+    template <size_t i>
+    bool evaluate_one(fit::context& context) {
+        auto& promise = std::get<i>(promises_);
+        if (promise) {
+            std::get<i>(results_) = promise(context);
+            if (std::get<i>(results_).is_pending())
+                return false;
+        }
+        return true;
+    }
+
+    std::tuple<Promises...> promises_;
+    tuple_type results_;
+};
+
+} // namespace internal
+} // namespace fit
+
+#endif // LIB_FIT_PROMISE_INTERNAL_H_
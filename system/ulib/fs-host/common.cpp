@@ -34,6 +34,8 @@ struct {
         "Length in bytes of minfs partition"},
     {"compress", Option::kCompress, "",        nullptr,
         "Compress files before adding them to blobfs"},
+    {"blob-cache", Option::kBlobCache, "[dir]", nullptr,
+        "Reuse Merkle trees and compressed blobs cached in [dir]"},
     {"help",     Option::kHelp,     "",        nullptr,
         "Display this message"},
 };
@@ -73,6 +75,7 @@ struct {
 } ARGS[] = {
     {"--manifest", Argument::kManifest},
     {"--blob",     Argument::kBlob},
+    {"--blob-hc",  Argument::kBlobHighCompression},
 };
 
 zx_status_t FsCreator::ProcessAndRun(int argc, char** argv) {
@@ -230,7 +233,7 @@ zx_status_t FsCreator::ProcessArgs(int argc, char** argv) {
         opts[index] = {nullptr, 0, nullptr, 0};
 
         int opt_index;
-        int c = getopt_long(argc, argv, "+dro:l:ch", opts, &opt_index);
+        int c = getopt_long(argc, argv, "+dro:l:cb:h", opts, &opt_index);
         if (c < 0) {
             break;
         }
@@ -251,6 +254,9 @@ zx_status_t FsCreator::ProcessArgs(int argc, char** argv) {
         case 'c':
             compress_ = true;
             break;
+        case 'b':
+            blob_cache_ = optarg;
+            break;
         case 'h':
         default:
             return Usage();
@@ -33,12 +33,14 @@ enum class Option {
     kOffset,
     kLength,
     kCompress,
+    kBlobCache,
     kHelp,
 };
 
 enum class Argument {
     kManifest,
     kBlob,
+    kBlobHighCompression,
 };
 
 enum class ArgType {
@@ -117,6 +119,10 @@ protected:
     off_t GetOffset() const { return offset_; }
     off_t GetLength() const { return length_; }
     bool ShouldCompress() const { return compress_; }
+    // Returns the directory blobs may be cached in across runs, or nullptr.
+    const char* GetBlobCache() const {
+        return blob_cache_.empty() ? nullptr : blob_cache_.c_str();
+    }
 
     fbl::unique_fd fd_;
 
@@ -142,6 +148,7 @@ private:
     off_t length_;
     bool read_only_;
     bool compress_;
+    fbl::String blob_cache_;
     std::mutex depfile_lock_;
     fbl::unique_fd depfile_;
 };
@@ -44,6 +44,9 @@ zx_status_t wake_ramdisk(const char* ramdisk_path);
 // Returns the ramdisk's current failed, successful, and total block counts as |counts|.
 zx_status_t get_ramdisk_blocks(const char* ramdisk_path, ramdisk_blk_counts_t* counts);
 
+// Applies |perf| to the ramdisk at |ramdisk_path|; see |ioctl_ramdisk_set_perf|.
+zx_status_t set_ramdisk_perf(const char* ramdisk_path, const ramdisk_perf_t* perf);
+
 // Destroys a ramdisk, given the "ramdisk_path" returned from "create_ramdisk".
 zx_status_t destroy_ramdisk(const char* ramdisk_path);
 
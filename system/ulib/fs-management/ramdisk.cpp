@@ -192,6 +192,21 @@ zx_status_t sleep_ramdisk(const char* ramdisk_path, uint64_t block_count) {
     return ZX_OK;
 }
 
+zx_status_t set_ramdisk_perf(const char* ramdisk_path, const ramdisk_perf_t* perf) {
+    fbl::unique_fd fd(open(ramdisk_path, O_RDWR));
+    if (fd.get() < 0) {
+        fprintf(stderr, "Could not open ramdisk\n");
+        return ZX_ERR_BAD_STATE;
+    }
+
+    ssize_t r = ioctl_ramdisk_set_perf(fd.get(), perf);
+    if (r != ZX_OK) {
+        fprintf(stderr, "Could not set ramdisk perf on path %s: %ld\n", ramdisk_path, r);
+        return static_cast<zx_status_t>(r);
+    }
+    return ZX_OK;
+}
+
 zx_status_t wake_ramdisk(const char* ramdisk_path) {
     fbl::unique_fd fd(open(ramdisk_path, O_RDWR));
     if (fd.get() < 0) {
@@ -11,6 +11,8 @@
 #include <string.h>
 #include <sys/stat.h>
 
+#include <fbl/algorithm.h>
+#include <fbl/alloc_checker.h>
 #include <fs/trace.h>
 #include <fs/vnode.h>
 #include <fuchsia/io/c/fidl.h>
@@ -26,6 +28,10 @@
 namespace fs {
 namespace {
 
+// The most bytes moved between a vnode and a VMO at a time by the VMO-based
+// read and write operations.
+constexpr size_t kVmoTransferChunk = 64 * 1024;
+
 void WriteDescribeError(zx::channel channel, zx_status_t status) {
     zxrio_describe_t msg;
     memset(&msg, 0, sizeof(msg));
@@ -174,6 +180,10 @@ ZXFIDL_OPERATION(FileTruncate)
 ZXFIDL_OPERATION(FileGetFlags)
 ZXFIDL_OPERATION(FileSetFlags)
 ZXFIDL_OPERATION(FileGetVmo)
+ZXFIDL_OPERATION(FileReadVmo)
+ZXFIDL_OPERATION(FileReadVmoAt)
+ZXFIDL_OPERATION(FileWriteVmo)
+ZXFIDL_OPERATION(FileWriteVmoAt)
 
 const fuchsia_io_File_ops kFileOps = {
     .Clone = NodeCloneOp,
@@ -192,6 +202,10 @@ const fuchsia_io_File_ops kFileOps = {
     .GetFlags = FileGetFlagsOp,
     .SetFlags = FileSetFlagsOp,
     .GetVmo = FileGetVmoOp,
+    .ReadVmo = FileReadVmoOp,
+    .ReadVmoAt = FileReadVmoAtOp,
+    .WriteVmo = FileWriteVmoOp,
+    .WriteVmoAt = FileWriteVmoAtOp,
 };
 
 ZXFIDL_OPERATION(DirectoryOpen)
@@ -286,6 +300,7 @@ Connection::~Connection() {
 }
 
 void Connection::AsyncTeardown() {
+    fbl::AutoLock lock(&channel_lock_);
     if (channel_) {
         ZX_ASSERT(channel_.signal(0, kLocalTeardownSignal) == ZX_OK);
     }
@@ -352,7 +367,7 @@ zx_status_t Connection::CallHandler() {
 }
 
 void Connection::CallClose() {
-    channel_.reset();
+    TakeChannel().reset();
     CallHandler();
     set_closed();
 }
@@ -659,6 +674,130 @@ zx_status_t Connection::FileGetVmo(uint32_t flags, fidl_txn_t* txn) {
     return fuchsia_io_FileGetVmo_reply(txn, status, handle);
 }
 
+zx_status_t Connection::ReadIntoVmo(uint64_t count, uint64_t offset, const zx::vmo& vmo,
+                                    uint64_t vmo_offset, size_t* out_actual) {
+    *out_actual = 0;
+    const size_t buffer_size = fbl::min<uint64_t>(count, kVmoTransferChunk);
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<uint8_t[]> buffer(new (&ac) uint8_t[buffer_size]);
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+
+    zx_status_t status = ZX_OK;
+    while (count > 0) {
+        const size_t chunk = fbl::min<uint64_t>(count, buffer_size);
+        size_t actual = 0;
+        if ((status = vnode_->Read(buffer.get(), chunk, offset, &actual)) != ZX_OK) {
+            break;
+        }
+        ZX_DEBUG_ASSERT(actual <= chunk);
+        if ((status = vmo.write(buffer.get(), vmo_offset, actual)) != ZX_OK) {
+            break;
+        }
+        *out_actual += actual;
+        if (actual < chunk) {
+            // The end of the file.
+            break;
+        }
+        count -= actual;
+        offset += actual;
+        vmo_offset += actual;
+    }
+    return (*out_actual > 0) ? ZX_OK : status;
+}
+
+zx_status_t Connection::WriteFromVmo(uint64_t count, uint64_t offset, const zx::vmo& vmo,
+                                     uint64_t vmo_offset, bool append, size_t* out_actual,
+                                     size_t* out_end) {
+    *out_actual = 0;
+    *out_end = offset;
+    const size_t buffer_size = fbl::min<uint64_t>(count, kVmoTransferChunk);
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<uint8_t[]> buffer(new (&ac) uint8_t[buffer_size]);
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+
+    zx_status_t status = ZX_OK;
+    while (count > 0) {
+        const size_t chunk = fbl::min<uint64_t>(count, buffer_size);
+        if ((status = vmo.read(buffer.get(), vmo_offset, chunk)) != ZX_OK) {
+            break;
+        }
+        size_t actual = 0;
+        if (append) {
+            status = vnode_->Append(buffer.get(), chunk, out_end, &actual);
+        } else {
+            status = vnode_->Write(buffer.get(), chunk, *out_end, &actual);
+            *out_end += (status == ZX_OK) ? actual : 0;
+        }
+        if (status != ZX_OK) {
+            break;
+        }
+        ZX_DEBUG_ASSERT(actual <= chunk);
+        *out_actual += actual;
+        if (actual < chunk) {
+            // The vnode is out of space.
+            break;
+        }
+        count -= actual;
+        vmo_offset += actual;
+    }
+    return (*out_actual > 0) ? ZX_OK : status;
+}
+
+zx_status_t Connection::FileReadVmo(uint64_t count, zx_handle_t vmo_handle, uint64_t vmo_offset,
+                                    fidl_txn_t* txn) {
+    zx::vmo vmo(vmo_handle);
+    if (!IsReadable(flags_)) {
+        return fuchsia_io_FileReadVmo_reply(txn, ZX_ERR_BAD_HANDLE, 0);
+    }
+    size_t actual = 0;
+    zx_status_t status = ReadIntoVmo(count, offset_, vmo, vmo_offset, &actual);
+    offset_ += actual;
+    return fuchsia_io_FileReadVmo_reply(txn, status, actual);
+}
+
+zx_status_t Connection::FileReadVmoAt(uint64_t count, uint64_t offset, zx_handle_t vmo_handle,
+                                      uint64_t vmo_offset, fidl_txn_t* txn) {
+    zx::vmo vmo(vmo_handle);
+    if (!IsReadable(flags_)) {
+        return fuchsia_io_FileReadVmoAt_reply(txn, ZX_ERR_BAD_HANDLE, 0);
+    }
+    size_t actual = 0;
+    zx_status_t status = ReadIntoVmo(count, offset, vmo, vmo_offset, &actual);
+    return fuchsia_io_FileReadVmoAt_reply(txn, status, actual);
+}
+
+zx_status_t Connection::FileWriteVmo(uint64_t count, zx_handle_t vmo_handle, uint64_t vmo_offset,
+                                     fidl_txn_t* txn) {
+    zx::vmo vmo(vmo_handle);
+    if (!IsWritable(flags_)) {
+        return fuchsia_io_FileWriteVmo_reply(txn, ZX_ERR_BAD_HANDLE, 0);
+    }
+    size_t actual = 0;
+    size_t end = offset_;
+    zx_status_t status = WriteFromVmo(count, offset_, vmo, vmo_offset,
+                                      flags_ & ZX_FS_FLAG_APPEND, &actual, &end);
+    if (actual > 0) {
+        offset_ = end;
+    }
+    return fuchsia_io_FileWriteVmo_reply(txn, status, actual);
+}
+
+zx_status_t Connection::FileWriteVmoAt(uint64_t count, uint64_t offset, zx_handle_t vmo_handle,
+                                       uint64_t vmo_offset, fidl_txn_t* txn) {
+    zx::vmo vmo(vmo_handle);
+    if (!IsWritable(flags_)) {
+        return fuchsia_io_FileWriteVmoAt_reply(txn, ZX_ERR_BAD_HANDLE, 0);
+    }
+    size_t actual = 0;
+    size_t end;
+    zx_status_t status = WriteFromVmo(count, offset, vmo, vmo_offset, false, &actual, &end);
+    return fuchsia_io_FileWriteVmoAt_reply(txn, status, actual);
+}
+
 zx_status_t Connection::DirectoryOpen(uint32_t flags, uint32_t mode, const char* path_data,
                                       size_t path_size, zx_handle_t object) {
     zx::channel channel(object);
@@ -776,7 +915,7 @@ zx_status_t Connection::DirectoryAdminUnmount(fidl_txn_t* txn) {
     vfs_->UninstallAll(ZX_TIME_INFINITE);
 
     // Unmount is fatal to the requesting connections.
-    Vfs::ShutdownCallback closure([ch = fbl::move(channel_),
+    Vfs::ShutdownCallback closure([ch = TakeChannel(),
                                    ctxn = zxfidl_txn_copy(txn)]
                                   (zx_status_t status) mutable {
         fuchsia_io_DirectoryAdminUnmount_reply(&ctxn.txn, status);
@@ -825,7 +964,7 @@ zx_status_t Connection::HandleMessage(fidl_msg_t* msg, fidl_txn_t* txn) {
         hdr->ordinal <= fuchsia_io_NodeIoctlOrdinal) {
         return fuchsia_io_Node_dispatch(this, txn, msg, &kNodeOps);
     } else if (hdr->ordinal >= fuchsia_io_FileReadOrdinal &&
-               hdr->ordinal <= fuchsia_io_FileGetVmoOrdinal) {
+               hdr->ordinal <= fuchsia_io_FileWriteVmoAtOrdinal) {
         return fuchsia_io_File_dispatch(this, txn, msg, &kFileOps);
     } else if (hdr->ordinal >= fuchsia_io_DirectoryOpenOrdinal &&
                hdr->ordinal <= fuchsia_io_DirectoryWatchOrdinal) {
@@ -10,13 +10,16 @@
 
 #include <stdint.h>
 
+#include <fbl/auto_lock.h>
 #include <fbl/intrusive_double_list.h>
+#include <fbl/mutex.h>
 #include <fbl/unique_ptr.h>
 #include <fs/vfs.h>
 #include <fs/vnode.h>
 #include <fuchsia/io/c/fidl.h>
 #include <lib/async/cpp/wait.h>
 #include <lib/zx/event.h>
+#include <lib/zx/vmo.h>
 #include <zircon/fidl.h>
 
 namespace fs {
@@ -88,6 +91,14 @@ public:
     zx_status_t FileGetFlags(fidl_txn_t* txn);
     zx_status_t FileSetFlags(uint32_t flags, fidl_txn_t* txn);
     zx_status_t FileGetVmo(uint32_t flags, fidl_txn_t* txn);
+    zx_status_t FileReadVmo(uint64_t count, zx_handle_t vmo, uint64_t vmo_offset,
+                            fidl_txn_t* txn);
+    zx_status_t FileReadVmoAt(uint64_t count, uint64_t offset, zx_handle_t vmo,
+                              uint64_t vmo_offset, fidl_txn_t* txn);
+    zx_status_t FileWriteVmo(uint64_t count, zx_handle_t vmo, uint64_t vmo_offset,
+                             fidl_txn_t* txn);
+    zx_status_t FileWriteVmoAt(uint64_t count, uint64_t offset, zx_handle_t vmo,
+                               uint64_t vmo_offset, fidl_txn_t* txn);
 
     // Directory Operations.
     zx_status_t DirectoryOpen(uint32_t flags, uint32_t mode, const char* path_data,
@@ -137,6 +148,19 @@ private:
     // Invoked by |HandleSignals()| or synthesized internally.
     zx_status_t CallHandler();
 
+    // Reads up to |count| bytes of the vnode at |offset| into |vmo| at
+    // |vmo_offset|, stopping early at the end of the file. Bytes moved before
+    // an error are still reported through |out_actual|.
+    zx_status_t ReadIntoVmo(uint64_t count, uint64_t offset, const zx::vmo& vmo,
+                            uint64_t vmo_offset, size_t* out_actual);
+
+    // Writes |count| bytes of |vmo| at |vmo_offset| to the vnode at |offset|,
+    // or at its end if the connection is in append mode. Sets |*out_end| to
+    // the offset following the last byte written.
+    zx_status_t WriteFromVmo(uint64_t count, uint64_t offset, const zx::vmo& vmo,
+                             uint64_t vmo_offset, bool append, size_t* out_actual,
+                             size_t* out_end);
+
     // Sends an explicit close message to the underlying vnode.
     // Only necessary if the handler has not returned ERR_DISPATCHER_DONE
     // and has been opened.
@@ -152,10 +176,20 @@ private:
     bool is_open() const { return wait_.object() != ZX_HANDLE_INVALID; }
     void set_closed() { wait_.set_object(ZX_HANDLE_INVALID); }
 
+    // Removes the channel from the connection.
+    zx::channel TakeChannel() {
+        fbl::AutoLock lock(&channel_lock_);
+        return fbl::move(channel_);
+    }
+
     fs::Vfs* const vfs_;
     fbl::RefPtr<fs::Vnode> vnode_;
 
     // Channel on which the connection is being served.
+    //
+    // The channel is only replaced while holding |channel_lock_|, since
+    // AsyncTeardown may signal it from another dispatcher thread.
+    fbl::Mutex channel_lock_;
     zx::channel channel_;
 
     // Asynchronous wait for incoming messages.
@@ -11,8 +11,10 @@
 #include <lib/async/cpp/task.h>
 #include <fbl/intrusive_double_list.h>
 #include <fbl/function.h>
+#include <fbl/mutex.h>
 #include <fbl/unique_ptr.h>
 #include <fs/connection.h>
+#include <fs/locking.h>
 #include <fs/vfs.h>
 
 namespace fs {
@@ -20,10 +22,13 @@ namespace fs {
 // A specialization of |Vfs| which provides a mechanism to tear down
 // all active connections before it is destroyed.
 //
-// This class is NOT thread-safe and it must be used with a
-// single-threaded asynchronous dispatcher. However, after an operation
-// has been dispatched to a connection, it is safe to defer completion
-// of that operation, returning "ERR_DISPATCHER_ASYNC".
+// This class is thread-safe, and it may be used with an asynchronous
+// dispatcher served by several threads. The messages of a single
+// connection are always handled one at a time, but messages from separate
+// connections may be handled concurrently, so a multi-threaded dispatcher
+// should only be used if the Vnodes served are themselves thread-safe.
+// After an operation has been dispatched to a connection, it is safe to
+// defer completion of that operation, returning "ERR_DISPATCHER_ASYNC".
 //
 // It is unsafe to shutdown the dispatch loop before shutting down the
 // ManagedVfs object.
@@ -49,11 +54,11 @@ public:
 
 private:
     // Posts the task for OnShutdownComplete if it is safe to do so.
-    void CheckForShutdownComplete();
+    void CheckForShutdownCompleteLocked() FS_TA_REQUIRES(lock_);
 
     // Identifies if the filesystem has fully terminated, and is
     // ready for "OnShutdownComplete" to execute.
-    bool IsTerminated() const;
+    bool IsTerminatedLocked() const FS_TA_REQUIRES(lock_);
 
     // Invokes the handler from |Shutdown| once all connections have been
     // released. Additionally, unmounts all sub-mounted filesystems, if any
@@ -64,11 +69,17 @@ private:
     void UnregisterConnection(Connection* connection) final;
     bool IsTerminating() const final;
 
-    fbl::DoublyLinkedList<fbl::unique_ptr<Connection>> connections_;
+    // Guards the set of connections, which are registered and unregistered
+    // from whichever dispatcher thread serves them.
+    mutable fbl::Mutex lock_;
+    fbl::DoublyLinkedList<fbl::unique_ptr<Connection>> connections_ FS_TA_GUARDED(lock_);
+    // Connections which have been unregistered, but are still being destroyed.
+    size_t closing_connections_ FS_TA_GUARDED(lock_) = 0;
 
-    bool is_shutting_down_;
-    async::TaskMethod<ManagedVfs, &ManagedVfs::OnShutdownComplete> shutdown_task_{this};
-    ShutdownCallback shutdown_handler_;
+    bool is_shutting_down_ FS_TA_GUARDED(lock_);
+    async::TaskMethod<ManagedVfs, &ManagedVfs::OnShutdownComplete> shutdown_task_
+        FS_TA_GUARDED(lock_){this};
+    ShutdownCallback shutdown_handler_ FS_TA_GUARDED(lock_);
 };
 
 } // namespace fs
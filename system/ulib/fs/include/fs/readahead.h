@@ -0,0 +1,46 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <stdint.h>
+
+namespace fs {
+
+// Tracks the reads made of a single file to decide how far ahead of them a
+// filesystem should read.
+//
+// A read which starts where the last one (along with what was read ahead of
+// it) ended continues a sequential stream, and doubles the window read ahead
+// of it, from |min_window| up to |max_window|. Any other read ends the stream,
+// and nothing is read ahead of it. The first read of a file continues a stream
+// which starts at |start|, where the file's contents begin.
+//
+// Offsets and lengths are in whatever unit the filesystem chooses, such as
+// bytes or blocks. Not thread-safe; callers hold the lock of the file.
+class Readahead {
+public:
+    Readahead(uint64_t min_window, uint64_t max_window, uint64_t start = 0);
+
+    // Returns the length which should be read from |offset| to serve a read of
+    // |length|. It is never less than |length|, and may run past the end of
+    // the file, which the caller must clamp it to.
+    uint64_t Advance(uint64_t offset, uint64_t length);
+
+    // Forgets the current stream, such as when the file's contents are
+    // dropped and it will next be read from scratch.
+    void Reset();
+
+    uint64_t window() const { return window_; }
+
+private:
+    const uint64_t min_window_;
+    const uint64_t max_window_;
+    const uint64_t start_;
+    // Where a read continuing the current stream would start.
+    uint64_t next_;
+    uint64_t window_ = 0;
+};
+
+} // namespace fs
@@ -27,11 +27,13 @@
 #include <fbl/mutex.h>
 #endif // __Fuchsia__
 
+#include <fbl/array.h>
 #include <fbl/function.h>
 #include <fbl/intrusive_double_list.h>
 #include <fbl/macros.h>
 #include <fbl/ref_counted.h>
 #include <fbl/ref_ptr.h>
+#include <fbl/string.h>
 #include <fbl/string_piece.h>
 #include <fbl/unique_ptr.h>
 
@@ -127,6 +129,29 @@ public:
     // Sets whether this file system is read-only.
     void SetReadonly(bool value) FS_TA_EXCLUDES(vfs_lock_);
 
+    // How many of the directories looked up while walking paths were found in
+    // the name cache, and how many were not.
+    struct NameCacheStats {
+        uint64_t hits;
+        uint64_t misses;
+    };
+
+    // Caches up to |capacity| of the directories looked up while walking
+    // paths, keyed on their parent and name, so that deep paths which are
+    // opened repeatedly aren't looked up one directory at a time. A capacity
+    // of zero, the default, disables the cache.
+    //
+    // Entries are invalidated by the unlinks, renames and links made through
+    // the Vfs, alongside the watcher notifications for them. A filesystem
+    // whose directories may also change some other way (such as a PseudoDir
+    // changed directly by its owner) must not enable the cache.
+    //
+    // The cache holds references to the vnodes in it, so a filesystem which
+    // enables it must disable it again before its vnodes may no longer be
+    // released.
+    zx_status_t SetNameCacheCapacity(size_t capacity) FS_TA_EXCLUDES(vfs_lock_);
+    NameCacheStats GetNameCacheStats() FS_TA_EXCLUDES(vfs_lock_);
+
 #ifdef __Fuchsia__
     // Unmounts the underlying filesystem.
     //
@@ -207,8 +232,29 @@ private:
                            fbl::StringPiece path, fbl::StringPiece* pathout,
                            uint32_t flags, uint32_t mode) FS_TA_REQUIRES(vfs_lock_);
 
+    // Looks up the directory |name| within |vn| through the name cache.
+    zx_status_t LookupCached(fbl::RefPtr<Vnode> vn, fbl::RefPtr<Vnode>* out,
+                             fbl::StringPiece name) FS_TA_REQUIRES(vfs_lock_);
+    // Forgets the cached entry for |name| within |vn|, if there is one.
+    void InvalidateName(Vnode* vn, fbl::StringPiece name) FS_TA_REQUIRES(vfs_lock_);
+
+    struct NameCacheEntry {
+        fbl::RefPtr<Vnode> parent;
+        fbl::String name;
+        fbl::RefPtr<Vnode> vn;
+    };
+
+    // Returns the entry which |name| within |parent| is cached in, if any.
+    NameCacheEntry* NameCacheSlot(const Vnode* parent,
+                                  fbl::StringPiece name) FS_TA_REQUIRES(vfs_lock_);
+
     bool readonly_{};
 
+    // The name cache is direct-mapped: each parent and name may only be
+    // cached in one entry, evicting whichever was there before.
+    fbl::Array<NameCacheEntry> name_cache_ FS_TA_GUARDED(vfs_lock_);
+    NameCacheStats name_cache_stats_ FS_TA_GUARDED(vfs_lock_){};
+
 #ifdef __Fuchsia__
     zx_status_t TokenToVnode(zx::event token, fbl::RefPtr<Vnode>* out) FS_TA_REQUIRES(vfs_lock_);
     zx_status_t InstallRemoteLocked(fbl::RefPtr<Vnode> vn, MountChannel h) FS_TA_REQUIRES(vfs_lock_);
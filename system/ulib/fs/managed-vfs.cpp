@@ -6,6 +6,7 @@
 
 #include <lib/async/cpp/task.h>
 #include <fbl/atomic.h>
+#include <fbl/auto_lock.h>
 #include <fbl/unique_ptr.h>
 #include <lib/sync/completion.h>
 
@@ -17,63 +18,90 @@ ManagedVfs::ManagedVfs(async_dispatcher_t* dispatcher) : Vfs(dispatcher), is_shu
 
 ManagedVfs::~ManagedVfs() {
     ZX_DEBUG_ASSERT(connections_.is_empty());
+    ZX_DEBUG_ASSERT(closing_connections_ == 0);
 }
 
-bool ManagedVfs::IsTerminated() const {
-    return is_shutting_down_ && connections_.is_empty();
+bool ManagedVfs::IsTerminatedLocked() const {
+    return is_shutting_down_ && connections_.is_empty() && closing_connections_ == 0;
 }
 
 // Asynchronously drop all connections.
 void ManagedVfs::Shutdown(ShutdownCallback handler) {
     ZX_DEBUG_ASSERT(handler);
     zx_status_t status = async::PostTask(dispatcher(), [this, closure = fbl::move(handler)]() mutable {
-        ZX_DEBUG_ASSERT(!shutdown_handler_);
-        shutdown_handler_ = fbl::move(closure);
-        is_shutting_down_ = true;
+        {
+            fbl::AutoLock lock(&lock_);
+            ZX_DEBUG_ASSERT(!shutdown_handler_);
+            shutdown_handler_ = fbl::move(closure);
+            is_shutting_down_ = true;
+        }
 
         UninstallAll(ZX_TIME_INFINITE);
 
+        fbl::AutoLock lock(&lock_);
+
         // Signal the teardown on channels in a way that doesn't potentially
         // pull them out from underneath async callbacks.
         for (auto& c : connections_) {
             c.AsyncTeardown();
         }
 
-        CheckForShutdownComplete();
+        CheckForShutdownCompleteLocked();
     });
     ZX_DEBUG_ASSERT(status == ZX_OK);
 }
 
 // Trigger "OnShutdownComplete" if all preconditions have been met.
-void ManagedVfs::CheckForShutdownComplete() {
-    if (IsTerminated()) {
+void ManagedVfs::CheckForShutdownCompleteLocked() {
+    if (IsTerminatedLocked()) {
         shutdown_task_.Post(dispatcher());
     }
 }
 
 void ManagedVfs::OnShutdownComplete(async_dispatcher_t*, async::TaskBase*, zx_status_t status) {
-    ZX_ASSERT_MSG(IsTerminated(),
-                  "Failed to complete VFS shutdown: dispatcher status = %d\n", status);
-    ZX_DEBUG_ASSERT(shutdown_handler_);
+    ShutdownCallback handler;
+    {
+        fbl::AutoLock lock(&lock_);
+        ZX_ASSERT_MSG(IsTerminatedLocked(),
+                      "Failed to complete VFS shutdown: dispatcher status = %d\n", status);
+        ZX_DEBUG_ASSERT(shutdown_handler_);
+        handler = fbl::move(shutdown_handler_);
+    }
 
-    auto handler = fbl::move(shutdown_handler_);
+    // The handler may destroy the ManagedVfs.
     handler(status);
 }
 
 void ManagedVfs::RegisterConnection(fbl::unique_ptr<Connection> connection) {
-    ZX_DEBUG_ASSERT(!is_shutting_down_);
+    fbl::AutoLock lock(&lock_);
     connections_.push_back(fbl::move(connection));
+    if (is_shutting_down_) {
+        // A request on another dispatcher thread may open a connection while
+        // the VFS is being shut down; it is torn down with the rest.
+        connections_.back().AsyncTeardown();
+    }
 }
 
 void ManagedVfs::UnregisterConnection(Connection* connection) {
-    // We drop the result of |erase| on the floor, effectively destroying the
-    // connection when all other references (like async callbacks) have
-    // completed.
-    connections_.erase(*connection);
-    CheckForShutdownComplete();
+    fbl::unique_ptr<Connection> closing;
+    {
+        fbl::AutoLock lock(&lock_);
+        closing = connections_.erase(*connection);
+        closing_connections_++;
+    }
+
+    // Destroy the connection without holding the lock, since it calls into
+    // its Vnode. This happens on the thread running the connection's last
+    // async callback.
+    closing.reset();
+
+    fbl::AutoLock lock(&lock_);
+    closing_connections_--;
+    CheckForShutdownCompleteLocked();
 }
 
 bool ManagedVfs::IsTerminating() const {
+    fbl::AutoLock lock(&lock_);
     return is_shutting_down_;
 }
 
@@ -0,0 +1,35 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <fbl/algorithm.h>
+#include <zircon/assert.h>
+
+#include <fs/readahead.h>
+
+namespace fs {
+
+Readahead::Readahead(uint64_t min_window, uint64_t max_window, uint64_t start)
+    : min_window_(min_window), max_window_(max_window), start_(start), next_(start) {
+    ZX_DEBUG_ASSERT(min_window_ > 0 && min_window_ <= max_window_);
+}
+
+uint64_t Readahead::Advance(uint64_t offset, uint64_t length) {
+    if (offset != next_) {
+        window_ = 0;
+    } else if (window_ == 0) {
+        window_ = min_window_;
+    } else {
+        window_ = fbl::min(window_ * 2, max_window_);
+    }
+    const uint64_t total = length + window_;
+    next_ = offset + total;
+    return total;
+}
+
+void Readahead::Reset() {
+    next_ = start_;
+    window_ = 0;
+}
+
+} // namespace fs
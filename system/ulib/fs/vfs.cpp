@@ -2,6 +2,7 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <fbl/alloc_checker.h>
 #include <fbl/auto_call.h>
 #include <lib/fdio/remoteio.h>
 #include <lib/fdio/watcher.h>
@@ -232,8 +233,8 @@ zx_status_t Vfs::Unlink(fbl::RefPtr<Vnode> vndir, fbl::StringPiece path) {
 #endif
         if (ReadonlyLocked()) {
             r = ZX_ERR_ACCESS_DENIED;
-        } else {
-            r = vndir->Unlink(path, must_be_dir);
+        } else if ((r = vndir->Unlink(path, must_be_dir)) == ZX_OK) {
+            InvalidateName(vndir.get(), path);
         }
     }
     if (r != ZX_OK) {
@@ -342,6 +343,10 @@ zx_status_t Vfs::Rename(zx::event token, fbl::RefPtr<Vnode> oldparent,
 
         r = oldparent->Rename(newparent, oldStr, newStr, old_must_be_dir,
                               new_must_be_dir);
+        if (r == ZX_OK) {
+            InvalidateName(oldparent.get(), oldStr);
+            InvalidateName(newparent.get(), newStr);
+        }
     }
     if (r != ZX_OK) {
         return r;
@@ -397,6 +402,7 @@ zx_status_t Vfs::Link(zx::event token, fbl::RefPtr<Vnode> oldparent,
     if (r != ZX_OK) {
         return r;
     }
+    InvalidateName(newparent.get(), newStr);
     newparent->Notify(newStr, fuchsia_io_WATCH_EVENT_ADDED);
     return ZX_OK;
 }
@@ -404,9 +410,14 @@ zx_status_t Vfs::Link(zx::event token, fbl::RefPtr<Vnode> oldparent,
 zx_status_t Vfs::ServeConnection(fbl::unique_ptr<Connection> connection) {
     ZX_DEBUG_ASSERT(connection);
 
-    zx_status_t status = connection->Serve();
-    if (status == ZX_OK) {
-        RegisterConnection(fbl::move(connection));
+    // The connection is registered before it begins waiting for messages,
+    // since on a multi-threaded dispatcher it may be closed (and unregistered)
+    // by another thread as soon as it is served.
+    Connection* c = connection.get();
+    RegisterConnection(fbl::move(connection));
+    zx_status_t status = c->Serve();
+    if (status != ZX_OK) {
+        UnregisterConnection(c);
     }
     return status;
 }
@@ -445,6 +456,86 @@ void Vfs::SetReadonly(bool value) {
     readonly_ = value;
 }
 
+zx_status_t Vfs::SetNameCacheCapacity(size_t capacity) {
+    fbl::Array<NameCacheEntry> cache;
+    if (capacity > 0) {
+        fbl::AllocChecker ac;
+        cache.reset(new (&ac) NameCacheEntry[capacity], capacity);
+        if (!ac.check()) {
+            return ZX_ERR_NO_MEMORY;
+        }
+    }
+    {
+#ifdef __Fuchsia__
+        fbl::AutoLock lock(&vfs_lock_);
+#endif
+        name_cache_.swap(cache);
+    }
+    // The vnodes which were cached are released without holding the lock.
+    return ZX_OK;
+}
+
+Vfs::NameCacheStats Vfs::GetNameCacheStats() {
+#ifdef __Fuchsia__
+    fbl::AutoLock lock(&vfs_lock_);
+#endif
+    return name_cache_stats_;
+}
+
+Vfs::NameCacheEntry* Vfs::NameCacheSlot(const Vnode* parent, fbl::StringPiece name) {
+    // FNV-1a, over the address of the parent and then the name.
+    uint64_t hash = 14695981039346656037ull;
+    uintptr_t key = reinterpret_cast<uintptr_t>(parent);
+    for (size_t i = 0; i < sizeof(key); i++) {
+        hash = (hash ^ ((key >> (i * 8)) & 0xff)) * 1099511628211ull;
+    }
+    for (size_t i = 0; i < name.length(); i++) {
+        hash = (hash ^ static_cast<uint8_t>(name[i])) * 1099511628211ull;
+    }
+    return &name_cache_[hash % name_cache_.size()];
+}
+
+zx_status_t Vfs::LookupCached(fbl::RefPtr<Vnode> vn, fbl::RefPtr<Vnode>* out,
+                              fbl::StringPiece name) {
+    if (name_cache_.size() == 0 || name == "." || name == "..") {
+        return vfs_lookup(fbl::move(vn), out, name);
+    }
+
+    NameCacheEntry* entry = NameCacheSlot(vn.get(), name);
+    if (entry->parent == vn && entry->name.ToStringPiece() == name) {
+        name_cache_stats_.hits++;
+        *out = entry->vn;
+        return ZX_OK;
+    }
+    name_cache_stats_.misses++;
+
+    zx_status_t r;
+    fbl::RefPtr<Vnode> parent = vn;
+    if ((r = vn->Lookup(out, name)) != ZX_OK) {
+        return r;
+    }
+    // Only directories are cached, since only they are walked through; this
+    // also keeps the cache from holding onto files which are unlinked.
+    if ((*out)->ValidateFlags(ZX_FS_FLAG_DIRECTORY) == ZX_OK) {
+        entry->parent = fbl::move(parent);
+        entry->name = name;
+        entry->vn = *out;
+    }
+    return ZX_OK;
+}
+
+void Vfs::InvalidateName(Vnode* vn, fbl::StringPiece name) {
+    if (name_cache_.size() == 0) {
+        return;
+    }
+    NameCacheEntry* entry = NameCacheSlot(vn, name);
+    if (entry->parent.get() == vn && entry->name.ToStringPiece() == name) {
+        entry->parent.reset();
+        entry->name.clear();
+        entry->vn.reset();
+    }
+}
+
 zx_status_t Vfs::Walk(fbl::RefPtr<Vnode> vn, fbl::RefPtr<Vnode>* out_vn,
                       fbl::StringPiece path, fbl::StringPiece* out_path) {
     zx_status_t r;
@@ -483,7 +574,7 @@ zx_status_t Vfs::Walk(fbl::RefPtr<Vnode> vn, fbl::RefPtr<Vnode>* out_vn,
 
         // Path has at least one additional segment.
         fbl::StringPiece component(path.data(), next_path - path.data());
-        if ((r = vfs_lookup(fbl::move(vn), &vn, component)) != ZX_OK) {
+        if ((r = LookupCached(fbl::move(vn), &vn, component)) != ZX_OK) {
             return r;
         }
         // Traverse to the next segment.
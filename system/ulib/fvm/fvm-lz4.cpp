@@ -2,8 +2,16 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <inttypes.h>
+
+#include <fbl/vector.h>
+
 #include "fvm/fvm-lz4.h"
 
+// xxhash is built into lz4, under its namespace.
+#define XXH_NAMESPACE LZ4_
+#include <lz4/xxhash.h>
+
 namespace fvm {
 zx_status_t SparseReader::Create(fbl::unique_fd fd, fbl::unique_ptr<SparseReader>* out) {
     fbl::AllocChecker ac;
@@ -21,7 +29,9 @@ zx_status_t SparseReader::Create(fbl::unique_fd fd, fbl::unique_ptr<SparseReader
     return ZX_OK;
 }
 
-SparseReader::SparseReader(fbl::unique_fd fd) : compressed_(false), fd_(fbl::move(fd)) {}
+SparseReader::SparseReader(fbl::unique_fd fd)
+    : compressed_(false), chunked_(false), chunk_index_offset_(0), next_chunk_(0),
+      image_offset_(0), fd_(fbl::move(fd)) {}
 
 zx_status_t SparseReader::ReadMetadata() {
     // Read sparse image header.
@@ -32,12 +42,20 @@ zx_status_t SparseReader::ReadMetadata() {
     }
 
     // Verify the header.
+    bool chunked = (image.flags & fvm::kSparseFlagChunked) != 0;
     if (image.magic != fvm::kSparseFormatMagic) {
         fprintf(stderr, "SparseReader: Bad magic\n");
         return ZX_ERR_BAD_STATE;
-    } else if (image.version != fvm::kSparseFormatVersion) {
+    } else if (image.version !=
+               (chunked ? fvm::kSparseFormatVersionChunked : fvm::kSparseFormatVersion)) {
         fprintf(stderr, "SparseReader: Unexpected sparse file version\n");
         return ZX_ERR_BAD_STATE;
+    } else if (chunked && (image.flags & fvm::kSparseFlagLz4)) {
+        fprintf(stderr, "SparseReader: Chunked images are compressed per chunk\n");
+        return ZX_ERR_BAD_STATE;
+    } else if (image.header_length < sizeof(image)) {
+        fprintf(stderr, "SparseReader: Header is too short\n");
+        return ZX_ERR_BAD_STATE;
     }
 
     fbl::AllocChecker ac;
@@ -58,6 +76,24 @@ zx_status_t SparseReader::ReadMetadata() {
         }
         off += r;
     }
+    image_offset_ = image.header_length;
+
+    // If image is chunked, check the index and make room for one chunk at a time.
+    if (chunked) {
+        chunked_ = true;
+        zx_status_t status;
+        if ((status = VerifyChunkIndex()) != ZX_OK) {
+            return status;
+        } else if ((status = InitializeBuffer(fbl::max<size_t>(ChunkIndex()->chunk_size,
+                                                               LZ4_MAX_BLOCK_SIZE),
+                                              &out_buf_)) != ZX_OK) {
+            return status;
+        } else if ((status = InitializeBuffer(fbl::max<size_t>(MaxStoredLength(),
+                                                               LZ4_MAX_BLOCK_SIZE),
+                                              &in_buf_)) != ZX_OK) {
+            return status;
+        }
+    }
 
     // If image is compressed, additional setup is required
     if (image.flags & fvm::kSparseFlagLz4) {
@@ -112,6 +148,96 @@ zx_status_t SparseReader::ReadMetadata() {
     return ZX_OK;
 }
 
+zx_status_t SparseReader::VerifyChunkIndex() {
+    struct ExtentLength {
+        uint32_t partition;
+        uint32_t extent;
+        uint64_t length;
+    };
+
+    // Find the extents, and the index past them.
+    const fvm::sparse_image_t* image = Image();
+    fbl::Vector<ExtentLength> extents;
+    fbl::AllocChecker ac;
+    size_t off = sizeof(fvm::sparse_image_t);
+    for (uint32_t p = 0; p < image->partition_count; p++) {
+        if (image->header_length - off < sizeof(fvm::partition_descriptor_t)) {
+            fprintf(stderr, "SparseReader: Partitions overrun the header\n");
+            return ZX_ERR_BAD_STATE;
+        }
+        const fvm::partition_descriptor_t* partition =
+            reinterpret_cast<const fvm::partition_descriptor_t*>(&metadata_[off]);
+        off += sizeof(fvm::partition_descriptor_t);
+
+        for (uint32_t e = 0; e < partition->extent_count; e++) {
+            if (image->header_length - off < sizeof(fvm::extent_descriptor_t)) {
+                fprintf(stderr, "SparseReader: Extents overrun the header\n");
+                return ZX_ERR_BAD_STATE;
+            }
+            const fvm::extent_descriptor_t* extent =
+                reinterpret_cast<const fvm::extent_descriptor_t*>(&metadata_[off]);
+            off += sizeof(fvm::extent_descriptor_t);
+            extents.push_back({p, e, extent->extent_length}, &ac);
+            if (!ac.check()) {
+                return ZX_ERR_NO_MEMORY;
+            }
+        }
+    }
+
+    if (image->header_length - off < sizeof(fvm::sparse_chunk_index_t)) {
+        fprintf(stderr, "SparseReader: Missing chunk index\n");
+        return ZX_ERR_BAD_STATE;
+    }
+    chunk_index_offset_ = off;
+    const fvm::sparse_chunk_index_t* index = ChunkIndex();
+    off += sizeof(fvm::sparse_chunk_index_t);
+    if (index->magic != fvm::kChunkIndexMagic) {
+        fprintf(stderr, "SparseReader: Bad chunk index magic\n");
+        return ZX_ERR_BAD_STATE;
+    } else if (index->chunk_size == 0 || index->chunk_size > fvm::kSparseChunkSize) {
+        fprintf(stderr, "SparseReader: Bad chunk size %" PRIu64 "\n", index->chunk_size);
+        return ZX_ERR_BAD_STATE;
+    } else if ((image->header_length - off) % sizeof(fvm::sparse_chunk_t) != 0 ||
+               (image->header_length - off) / sizeof(fvm::sparse_chunk_t) != index->chunk_count) {
+        fprintf(stderr, "SparseReader: Chunk index does not match the header length\n");
+        return ZX_ERR_BAD_STATE;
+    }
+
+    // The chunks must tile each extent in turn, and be stored back to back after the header.
+    size_t max_stored = MaxStoredLength();
+    uint64_t image_offset = image->header_length;
+    size_t next = 0;
+    for (const ExtentLength& extent : extents) {
+        uint64_t extent_offset = 0;
+        while (extent_offset < extent.length) {
+            if (next == index->chunk_count) {
+                fprintf(stderr, "SparseReader: Chunks do not cover every extent\n");
+                return ZX_ERR_BAD_STATE;
+            }
+            const fvm::sparse_chunk_t* chunk = Chunk(next);
+            bool lz4 = (chunk->flags & fvm::kChunkFlagLz4) != 0;
+            if (chunk->partition != extent.partition || chunk->extent != extent.extent ||
+                chunk->extent_offset != extent_offset || chunk->image_offset != image_offset ||
+                chunk->length == 0 || chunk->length > index->chunk_size ||
+                chunk->length > extent.length - extent_offset ||
+                (chunk->flags & ~fvm::kChunkFlagLz4) != 0 ||
+                (lz4 ? chunk->stored_length > max_stored : chunk->stored_length != chunk->length)) {
+                fprintf(stderr, "SparseReader: Bad chunk %zu\n", next);
+                return ZX_ERR_BAD_STATE;
+            }
+            extent_offset += chunk->length;
+            image_offset += chunk->stored_length;
+            next++;
+        }
+    }
+
+    if (next != index->chunk_count) {
+        fprintf(stderr, "SparseReader: Chunks past the last extent\n");
+        return ZX_ERR_BAD_STATE;
+    }
+    return ZX_OK;
+}
+
 zx_status_t SparseReader::InitializeBuffer(size_t size, buffer_t* out_buf) {
     if (size < LZ4_MAX_BLOCK_SIZE) {
         fprintf(stderr, "Buffer size must be >= %d\n", LZ4_MAX_BLOCK_SIZE);
@@ -149,12 +275,113 @@ fvm::partition_descriptor_t* SparseReader::Partitions() {
                 sizeof(fvm::sparse_image_t));
 }
 
+const fvm::sparse_chunk_index_t* SparseReader::ChunkIndex() const {
+    ZX_DEBUG_ASSERT(chunked_);
+    return reinterpret_cast<const fvm::sparse_chunk_index_t*>(
+                metadata_.get() + chunk_index_offset_);
+}
+
+const fvm::sparse_chunk_t* SparseReader::Chunk(size_t index) const {
+    ZX_DEBUG_ASSERT(index < ChunkIndex()->chunk_count);
+    return reinterpret_cast<const fvm::sparse_chunk_t*>(
+                metadata_.get() + chunk_index_offset_ + sizeof(fvm::sparse_chunk_index_t)) + index;
+}
+
+size_t SparseReader::MaxStoredLength() const {
+    return LZ4_COMPRESSBOUND(ChunkIndex()->chunk_size);
+}
+
+zx_status_t SparseReader::ReadChunk(size_t index, uint8_t* stored) {
+    const fvm::sparse_chunk_t* chunk = Chunk(index);
+    zx_status_t status;
+    size_t actual;
+    if (chunk->image_offset != image_offset_) {
+        off_t target = static_cast<off_t>(chunk->image_offset);
+        if (lseek(fd_.get(), target, SEEK_SET) == target) {
+            image_offset_ = chunk->image_offset;
+        } else if (chunk->image_offset < image_offset_) {
+            fprintf(stderr, "SparseReader: Cannot go back to chunk %zu\n", index);
+            return ZX_ERR_BAD_STATE;
+        }
+
+        // Not seekable, but the chunk is still ahead: read up to it.
+        while (image_offset_ < chunk->image_offset) {
+            size_t skip = static_cast<size_t>(fbl::min<uint64_t>(
+                chunk->image_offset - image_offset_, MaxStoredLength()));
+            if ((status = ReadRaw(stored, skip, &actual)) != ZX_OK) {
+                return status;
+            } else if (actual != skip) {
+                fprintf(stderr, "SparseReader: Image ends before chunk %zu\n", index);
+                return ZX_ERR_IO;
+            }
+        }
+    }
+
+    if ((status = ReadRaw(stored, chunk->stored_length, &actual)) != ZX_OK) {
+        return status;
+    } else if (actual != chunk->stored_length) {
+        fprintf(stderr, "SparseReader: Image ends within chunk %zu\n", index);
+        return ZX_ERR_IO;
+    }
+    return ZX_OK;
+}
+
+zx_status_t SparseReader::DecompressChunk(const fvm::sparse_chunk_t* chunk, const uint8_t* stored,
+                                          uint8_t* out) {
+    if (chunk->flags & fvm::kChunkFlagLz4) {
+        int r = LZ4_decompress_safe(reinterpret_cast<const char*>(stored),
+                                    reinterpret_cast<char*>(out),
+                                    static_cast<int>(chunk->stored_length),
+                                    static_cast<int>(chunk->length));
+        if (r != static_cast<int>(chunk->length)) {
+            fprintf(stderr, "SparseReader: Could not decompress chunk at %" PRIu64 "\n",
+                    chunk->image_offset);
+            return ZX_ERR_IO_DATA_INTEGRITY;
+        }
+    } else {
+        memcpy(out, stored, chunk->length);
+    }
+
+    if (XXH32(out, chunk->length, 0) != chunk->checksum) {
+        fprintf(stderr, "SparseReader: Bad checksum for chunk at %" PRIu64 "\n",
+                chunk->image_offset);
+        return ZX_ERR_IO_DATA_INTEGRITY;
+    }
+    return ZX_OK;
+}
+
 zx_status_t SparseReader::ReadData(uint8_t* data, size_t length, size_t* actual) {
 #ifdef __Fuchsia__
     zx_ticks_t start = zx_ticks_get();
 #endif
     size_t total_size = 0;
-    if (compressed_) {
+    if (chunked_) {
+        size_t chunk_count = ChunkIndex()->chunk_count;
+        if (out_buf_.is_empty() && next_chunk_ == chunk_count) {
+            // There is no more to read
+            return ZX_ERR_OUT_OF_RANGE;
+        }
+
+        // Read the rest of the last chunk first, then decompress chunks in turn.
+        out_buf_.read(data, length, &total_size);
+        while (total_size < length && next_chunk_ < chunk_count) {
+            ZX_ASSERT(out_buf_.is_empty());
+            const fvm::sparse_chunk_t* chunk = Chunk(next_chunk_);
+            zx_status_t status;
+            if ((status = ReadChunk(next_chunk_, in_buf_.data.get())) != ZX_OK) {
+                return status;
+            } else if ((status = DecompressChunk(chunk, in_buf_.data.get(),
+                                                 out_buf_.data.get())) != ZX_OK) {
+                return status;
+            }
+            next_chunk_++;
+            out_buf_.size = chunk->length;
+
+            size_t cp;
+            out_buf_.read(data + total_size, length - total_size, &cp);
+            total_size += cp;
+        }
+    } else if (compressed_) {
         if (out_buf_.is_empty() && to_read_ == 0) {
             // There is no more to read
             return ZX_ERR_OUT_OF_RANGE;
@@ -246,6 +473,7 @@ zx_status_t SparseReader::ReadRaw(uint8_t* data, size_t length, size_t* actual)
     read_time_ += zx_ticks_get() - start;
 #endif
 
+    image_offset_ += total_size;
     if (r < 0) {
         return static_cast<zx_status_t>(r);
     }
@@ -255,14 +483,19 @@ zx_status_t SparseReader::ReadRaw(uint8_t* data, size_t length, size_t* actual)
 }
 
 zx_status_t SparseReader::WriteDecompressed(fbl::unique_fd outfd) {
-    if (!compressed_) {
+    if (!compressed_ && !chunked_) {
         fprintf(stderr, "BlockReader: File is not compressed\n");
         return ZX_ERR_INVALID_ARGS;
     }
 
-    // Update metadata and write to new file.
+    // Update metadata and write to new file. A chunked image loses its chunk index, which
+    // describes the compressed data, and becomes an ordinary one.
     fvm::sparse_image_t* image = Image();
-    image->flags &= ~fvm::kSparseFlagLz4;
+    image->flags &= ~(fvm::kSparseFlagLz4 | fvm::kSparseFlagChunked);
+    if (chunked_) {
+        image->version = fvm::kSparseFormatVersion;
+        image->header_length = chunk_index_offset_;
+    }
 
     if (write(outfd.get(), metadata_.get(), image->header_length)
         != static_cast<ssize_t>(image->header_length)) {
@@ -292,6 +525,7 @@ zx_status_t SparseReader::WriteDecompressed(fbl::unique_fd outfd) {
 
 void SparseReader::PrintStats() const {
     printf("Reading FVM from compressed file: %s\n", compressed_ ? "true" : "false");
+    printf("Reading FVM from chunked file: %s\n", chunked_ ? "true" : "false");
     printf("Remaining bytes read into compression buffer:    %lu\n", in_buf_.size);
     printf("Remaining bytes written to decompression buffer: %lu\n", out_buf_.size);
 #ifdef __Fuchsia__
@@ -14,6 +14,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <lz4/lz4.h>
 #include <lz4/lz4frame.h>
 #include <fbl/auto_call.h>
 #include <fbl/unique_fd.h>
@@ -39,6 +40,23 @@ public:
     zx_status_t ReadData(uint8_t* data, size_t length, size_t *actual);
     // Write decompressed data into new file
     zx_status_t WriteDecompressed(fbl::unique_fd outfd);
+
+    // True if the image carries a chunk index (kSparseFlagChunked).
+    bool IsChunked() const { return chunked_; }
+    // The chunk index of a chunked image, and its |index|th entry.
+    const fvm::sparse_chunk_index_t* ChunkIndex() const;
+    const fvm::sparse_chunk_t* Chunk(size_t index) const;
+    // The most bytes any chunk of this image is stored in.
+    size_t MaxStoredLength() const;
+    // Read the stored bytes of chunk |index| into |stored|, which must hold at least
+    // MaxStoredLength() bytes. A seekable image may be read in any order; otherwise, chunks
+    // must be read in the order of the index, though some may be skipped.
+    zx_status_t ReadChunk(size_t index, uint8_t* stored);
+    // Decompress the |stored| bytes of |chunk| into |out|, which must hold at least
+    // |chunk->length| bytes, and check them against the chunk's checksum. This does not touch
+    // the reader, so it may be called from several threads at once.
+    static zx_status_t DecompressChunk(const fvm::sparse_chunk_t* chunk, const uint8_t* stored,
+                                       uint8_t* out);
 private:
     typedef struct buffer {
         // Write |length| bytes from |indata| into buffer.
@@ -90,6 +108,8 @@ private:
     zx_status_t ReadMetadata();
     // Initialize buffer with a given |size|
     static zx_status_t InitializeBuffer(size_t size, buffer_t* out_buf);
+    // Check that the chunk index of a chunked image covers each extent, in order.
+    zx_status_t VerifyChunkIndex();
     // Read |length| bytes of raw data from file directly into |data|. Return |actual| bytes read.
     zx_status_t ReadRaw(uint8_t* data, size_t length, size_t* actual);
 
@@ -97,6 +117,14 @@ private:
 
     // True if sparse file is compressed
     bool compressed_;
+    // True if sparse file is split into separately compressed chunks
+    bool chunked_;
+    // Offset of the chunk index within |metadata_|
+    size_t chunk_index_offset_;
+    // The next chunk to be decompressed by ReadData
+    size_t next_chunk_;
+    // Offset of |fd_| from the start of the image
+    uint64_t image_offset_;
 
     fbl::unique_fd fd_;
     fbl::unique_ptr<uint8_t[]> metadata_;
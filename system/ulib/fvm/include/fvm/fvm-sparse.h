@@ -41,15 +41,34 @@ namespace fvm {
 //   P0, Extent 2
 //   P1, Extent 0
 //   P2, Extent 0
+//
+// If kSparseFlagLz4 is set, DATA is a single LZ4 frame, which can only be
+// decompressed from start to end.
+//
+// CHUNKED IMAGES:
+// Images with kSparseFlagChunked set (which must use
+// kSparseFormatVersionChunked, so older readers refuse them) split the data
+// of each extent into chunks of up to |chunk_size| bytes, each compressed on
+// its own. The header continues after the last extent descriptor with...
+//   - sparse_chunk_index_t, followed by |chunk_count| entries of...
+//     - sparse_chunk_t
+// DATA then holds the stored bytes of each chunk, in the order of the index,
+// which is the order of the extents. A chunk never spans two extents.
+//
+// A pipe can still be read from start to end, but the chunks can be
+// decompressed in any order, by several threads at once, and a seekable
+// image can be read from any chunk onwards.
 
 constexpr uint64_t kSparseFormatMagic = (0x53525053204d5646ull); // 'FVM SPRS'
 constexpr uint64_t kSparseFormatVersion = 0x2;
+constexpr uint64_t kSparseFormatVersionChunked = 0x3;
 
 typedef enum sparse_flags {
     kSparseFlagLz4 = 0x1,
     kSparseFlagZxcrypt = 0x2,
+    kSparseFlagChunked = 0x4,
     // The final value is the bitwise-OR of all other flags
-    kSparseFlagAllValid = kSparseFlagLz4 | kSparseFlagZxcrypt,
+    kSparseFlagAllValid = kSparseFlagLz4 | kSparseFlagZxcrypt | kSparseFlagChunked,
 } sparse_flags_t;
 
 typedef struct sparse_image {
@@ -80,4 +99,31 @@ typedef struct extent_descriptor {
     uint64_t extent_length; // Unit: bytes. Must be <= slice_count * slice_size.
 } __attribute__((packed)) extent_descriptor_t;
 
+constexpr uint64_t kChunkIndexMagic = (0x58444e494b4e4843ull); // 'CHNKINDX'
+
+// The default, and largest, decompressed size of a chunk.
+constexpr uint64_t kSparseChunkSize = (1ull << 20);
+
+typedef struct sparse_chunk_index {
+    uint64_t magic;
+    uint64_t chunk_size; // Unit: bytes. Every chunk decompresses to at most this much.
+    uint64_t chunk_count;
+} __attribute__((packed)) sparse_chunk_index_t;
+
+typedef enum sparse_chunk_flags {
+    // The chunk is stored as an LZ4 block, rather than as is.
+    kChunkFlagLz4 = 0x1,
+} sparse_chunk_flags_t;
+
+typedef struct sparse_chunk {
+    uint64_t image_offset;  // Unit: bytes from the start of the image, of the stored data.
+    uint64_t extent_offset; // Unit: bytes from the start of the extent, of the chunk's data.
+    uint32_t partition;     // Index of the partition descriptor.
+    uint32_t extent;        // Index of the extent within the partition.
+    uint32_t stored_length; // Unit: bytes in the image.
+    uint32_t length;        // Unit: bytes, once decompressed.
+    uint32_t flags;
+    uint32_t checksum;      // XXH32 of the decompressed data, with a seed of zero.
+} __attribute__((packed)) sparse_chunk_t;
+
 } // namespace fvm
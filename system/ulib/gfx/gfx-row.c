@@ -0,0 +1,305 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "gfx-row.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include <gfx/gfx.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+static void fill32_c(uint32_t* dst, uint32_t color, size_t count) {
+    while (count--) {
+        *dst++ = color;
+    }
+}
+
+static void blend32_c(uint32_t* dst, const uint32_t* src, size_t count) {
+    while (count--) {
+        *dst = alpha32_add_ignore_destalpha(*dst, *src);
+        dst++;
+        src++;
+    }
+}
+
+#if defined(__x86_64__)
+
+// SSE2 is part of x86-64, so these need no check.
+
+static void fill32_sse2(uint32_t* dst, uint32_t color, size_t count) {
+    while (count > 0 && ((uintptr_t)dst & 15)) {
+        *dst++ = color;
+        count--;
+    }
+    __m128i v = _mm_set1_epi32((int)color);
+    for (; count >= 16; count -= 16, dst += 16) {
+        _mm_store_si128((__m128i*)dst, v);
+        _mm_store_si128((__m128i*)dst + 1, v);
+        _mm_store_si128((__m128i*)dst + 2, v);
+        _mm_store_si128((__m128i*)dst + 3, v);
+    }
+    for (; count >= 4; count -= 4, dst += 4) {
+        _mm_store_si128((__m128i*)dst, v);
+    }
+    fill32_c(dst, color, count);
+}
+
+// Blends four pixels.  Each color byte is widened to 16 bits, so that
+// c * (a + 1) and c * (254 - a) can be computed exactly and shifted down
+// separately, as the scalar code does.
+static inline __m128i blend4_sse2(__m128i d, __m128i s) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i a = _mm_srli_epi32(s, 24);
+    __m128i srca = _mm_add_epi32(a, _mm_set1_epi32(1));
+    // srca in both 16 bit halves of each pixel, then in all four of the
+    // widened channels.
+    __m128i f = _mm_or_si128(srca, _mm_slli_epi32(srca, 16));
+    __m128i finv = _mm_sub_epi16(_mm_set1_epi16(255), f);
+    __m128i f_lo = _mm_unpacklo_epi32(f, f);
+    __m128i f_hi = _mm_unpackhi_epi32(f, f);
+    __m128i finv_lo = _mm_unpacklo_epi32(finv, finv);
+    __m128i finv_hi = _mm_unpackhi_epi32(finv, finv);
+
+    __m128i r_lo = _mm_add_epi16(
+        _mm_srli_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), f_lo), 8),
+        _mm_srli_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), finv_lo), 8));
+    __m128i r_hi = _mm_add_epi16(
+        _mm_srli_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), f_hi), 8),
+        _mm_srli_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), finv_hi), 8));
+    __m128i r = _mm_packus_epi16(r_lo, r_hi);
+    r = _mm_or_si128(_mm_and_si128(r, _mm_set1_epi32(0x00ffffff)), _mm_slli_epi32(srca, 24));
+
+    // Transparent pixels keep the destination and opaque ones take the
+    // source.
+    __m128i clear = _mm_cmpeq_epi32(a, zero);
+    __m128i opaque = _mm_cmpeq_epi32(a, _mm_set1_epi32(255));
+    r = _mm_andnot_si128(_mm_or_si128(clear, opaque), r);
+    r = _mm_or_si128(r, _mm_and_si128(clear, d));
+    return _mm_or_si128(r, _mm_and_si128(opaque, s));
+}
+
+static void blend32_sse2(uint32_t* dst, const uint32_t* src, size_t count) {
+    for (; count >= 4; count -= 4, dst += 4, src += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i*)src);
+        __m128i alpha = _mm_srli_epi32(s, 24);
+        // Runs of fully transparent pixels, such as around glyphs, need
+        // no store at all.
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, _mm_setzero_si128())) == 0xffff) {
+            continue;
+        }
+        __m128i d = _mm_loadu_si128((const __m128i*)dst);
+        _mm_storeu_si128((__m128i*)dst, blend4_sse2(d, s));
+    }
+    blend32_c(dst, src, count);
+}
+
+static const gfx_row_ops row_ops_sse2 = {
+    .name = "sse2",
+    .fill32 = &fill32_sse2,
+    .blend32 = &blend32_sse2,
+};
+
+#define AVX2 __attribute__((target("avx2")))
+
+AVX2 static void fill32_avx2(uint32_t* dst, uint32_t color, size_t count) {
+    while (count > 0 && ((uintptr_t)dst & 31)) {
+        *dst++ = color;
+        count--;
+    }
+    __m256i v = _mm256_set1_epi32((int)color);
+    for (; count >= 32; count -= 32, dst += 32) {
+        _mm256_store_si256((__m256i*)dst, v);
+        _mm256_store_si256((__m256i*)dst + 1, v);
+        _mm256_store_si256((__m256i*)dst + 2, v);
+        _mm256_store_si256((__m256i*)dst + 3, v);
+    }
+    for (; count >= 8; count -= 8, dst += 8) {
+        _mm256_store_si256((__m256i*)dst, v);
+    }
+    fill32_c(dst, color, count);
+}
+
+// As blend4_sse2().  The unpacks and packs work within each 128 bit half,
+// so the pixels come back out in order.
+AVX2 static inline __m256i blend8_avx2(__m256i d, __m256i s) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i a = _mm256_srli_epi32(s, 24);
+    __m256i srca = _mm256_add_epi32(a, _mm256_set1_epi32(1));
+    __m256i f = _mm256_or_si256(srca, _mm256_slli_epi32(srca, 16));
+    __m256i finv = _mm256_sub_epi16(_mm256_set1_epi16(255), f);
+    __m256i f_lo = _mm256_unpacklo_epi32(f, f);
+    __m256i f_hi = _mm256_unpackhi_epi32(f, f);
+    __m256i finv_lo = _mm256_unpacklo_epi32(finv, finv);
+    __m256i finv_hi = _mm256_unpackhi_epi32(finv, finv);
+
+    __m256i r_lo = _mm256_add_epi16(
+        _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(s, zero), f_lo), 8),
+        _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), finv_lo), 8));
+    __m256i r_hi = _mm256_add_epi16(
+        _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(s, zero), f_hi), 8),
+        _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), finv_hi), 8));
+    __m256i r = _mm256_packus_epi16(r_lo, r_hi);
+    r = _mm256_or_si256(_mm256_and_si256(r, _mm256_set1_epi32(0x00ffffff)),
+                        _mm256_slli_epi32(srca, 24));
+
+    __m256i clear = _mm256_cmpeq_epi32(a, zero);
+    __m256i opaque = _mm256_cmpeq_epi32(a, _mm256_set1_epi32(255));
+    r = _mm256_andnot_si256(_mm256_or_si256(clear, opaque), r);
+    r = _mm256_or_si256(r, _mm256_and_si256(clear, d));
+    return _mm256_or_si256(r, _mm256_and_si256(opaque, s));
+}
+
+AVX2 static void blend32_avx2(uint32_t* dst, const uint32_t* src, size_t count) {
+    for (; count >= 8; count -= 8, dst += 8, src += 8) {
+        __m256i s = _mm256_loadu_si256((const __m256i*)src);
+        __m256i alpha = _mm256_srli_epi32(s, 24);
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(alpha, _mm256_setzero_si256())) == -1) {
+            continue;
+        }
+        __m256i d = _mm256_loadu_si256((const __m256i*)dst);
+        _mm256_storeu_si256((__m256i*)dst, blend8_avx2(d, s));
+    }
+    blend32_sse2(dst, src, count);
+}
+
+static const gfx_row_ops row_ops_avx2 = {
+    .name = "avx2",
+    .fill32 = &fill32_avx2,
+    .blend32 = &blend32_avx2,
+};
+
+// CPUID.1:ECX
+#define CPUID_1_ECX_OSXSAVE (1u << 27)
+#define CPUID_1_ECX_AVX (1u << 28)
+// CPUID.(EAX=7,ECX=0):EBX
+#define CPUID_7_EBX_AVX2 (1u << 5)
+// XCR0 bits for the SSE and AVX register state.
+#define XCR0_SSE_AVX (UINT64_C(1) << 1 | UINT64_C(1) << 2)
+
+static void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t* eax,
+                  uint32_t* ebx, uint32_t* ecx, uint32_t* edx) {
+    __asm__("cpuid"
+            : "=a"(*eax), "=b"(*ebx), "=c"(*ecx), "=d"(*edx)
+            : "a"(leaf), "c"(subleaf));
+}
+
+static uint64_t xgetbv(uint32_t reg) {
+    uint32_t lo, hi;
+    __asm__("xgetbv"
+            : "=a"(lo), "=d"(hi)
+            : "c"(reg));
+    return (uint64_t)hi << 32 | lo;
+}
+
+static bool has_avx2(void) {
+    uint32_t max_leaf, eax, ebx, ecx, edx;
+    cpuid(0, 0, &max_leaf, &ebx, &ecx, &edx);
+    if (max_leaf < 7) {
+        return false;
+    }
+    cpuid(1, 0, &eax, &ebx, &ecx, &edx);
+    // AVX2 is only usable if the kernel saves and restores the AVX
+    // register state.
+    if (!(ecx & CPUID_1_ECX_OSXSAVE) || !(ecx & CPUID_1_ECX_AVX) ||
+        (xgetbv(0) & XCR0_SSE_AVX) != XCR0_SSE_AVX) {
+        return false;
+    }
+    cpuid(7, 0, &eax, &ebx, &ecx, &edx);
+    return (ebx & CPUID_7_EBX_AVX2) != 0;
+}
+
+static const gfx_row_ops* select_row_ops(void) {
+    return has_avx2() ? &row_ops_avx2 : &row_ops_sse2;
+}
+
+#elif defined(__aarch64__)
+
+// NEON is part of arm64, so these need no check.
+
+static void fill32_neon(uint32_t* dst, uint32_t color, size_t count) {
+    uint32x4_t v = vdupq_n_u32(color);
+    for (; count >= 16; count -= 16, dst += 16) {
+        vst1q_u32(dst, v);
+        vst1q_u32(dst + 4, v);
+        vst1q_u32(dst + 8, v);
+        vst1q_u32(dst + 12, v);
+    }
+    for (; count >= 4; count -= 4, dst += 4) {
+        vst1q_u32(dst, v);
+    }
+    fill32_c(dst, color, count);
+}
+
+// Blends eight pixels at a time, with the channels split into separate
+// registers by vld4 so that each is widened, scaled and narrowed on its own.
+static void blend32_neon(uint32_t* dst, const uint32_t* src, size_t count) {
+    for (; count >= 8; count -= 8, dst += 8, src += 8) {
+        uint8x8x4_t s = vld4_u8((const uint8_t*)src);
+        uint8x8_t a = s.val[3];
+        uint8x8_t clear = vceq_u8(a, vdup_n_u8(0));
+        if (vget_lane_u64(vreinterpret_u64_u8(clear), 0) == UINT64_MAX) {
+            continue;
+        }
+        uint8x8_t opaque = vceq_u8(a, vdup_n_u8(255));
+        uint8x8x4_t d = vld4_u8((const uint8_t*)dst);
+        uint16x8_t srca = vaddw_u8(vdupq_n_u16(1), a);
+        uint16x8_t srcainv = vsubq_u16(vdupq_n_u16(255), srca);
+
+        uint8x8x4_t r;
+        for (int c = 0; c < 3; c++) {
+            r.val[c] = vadd_u8(vshrn_n_u16(vmulq_u16(vmovl_u8(s.val[c]), srca), 8),
+                               vshrn_n_u16(vmulq_u16(vmovl_u8(d.val[c]), srcainv), 8));
+        }
+        r.val[3] = vadd_u8(a, vdup_n_u8(1));
+        for (int c = 0; c < 4; c++) {
+            r.val[c] = vbsl_u8(clear, d.val[c], vbsl_u8(opaque, s.val[c], r.val[c]));
+        }
+        vst4_u8((uint8_t*)dst, r);
+    }
+    blend32_c(dst, src, count);
+}
+
+static const gfx_row_ops row_ops_neon = {
+    .name = "neon",
+    .fill32 = &fill32_neon,
+    .blend32 = &blend32_neon,
+};
+
+static const gfx_row_ops* select_row_ops(void) {
+    return &row_ops_neon;
+}
+
+#else
+
+static const gfx_row_ops row_ops_c = {
+    .name = "c",
+    .fill32 = &fill32_c,
+    .blend32 = &blend32_c,
+};
+
+static const gfx_row_ops* select_row_ops(void) {
+    return &row_ops_c;
+}
+
+#endif
+
+const gfx_row_ops* gfx_get_row_ops(void) {
+    // Threads racing to select the ops all store the same pointer.
+    static const gfx_row_ops* row_ops;
+    const gfx_row_ops* ops = __atomic_load_n(&row_ops, __ATOMIC_RELAXED);
+    if (ops == NULL) {
+        ops = select_row_ops();
+        __atomic_store_n(&row_ops, ops, __ATOMIC_RELAXED);
+    }
+    return ops;
+}
+
+const char* gfx_simd_name(void) {
+    return gfx_get_row_ops()->name;
+}
@@ -0,0 +1,25 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// The inner loops of fillrect and blend for 32 bit pixels.  There are
+// SSE2 and AVX2 versions on x86-64, chosen by cpuid the first time they
+// are needed, NEON versions on arm64, and plain C for everything else.
+typedef struct gfx_row_ops {
+    const char* name;
+    // Store |color| to |count| pixels at |dst|.
+    void (*fill32)(uint32_t* dst, uint32_t color, size_t count);
+    // Blend |count| ARGB 8888 pixels from |src| over |dst|, ignoring the
+    // destination alpha, with the same results as
+    // alpha32_add_ignore_destalpha().
+    void (*blend32)(uint32_t* dst, const uint32_t* src, size_t count);
+} gfx_row_ops;
+
+const gfx_row_ops* gfx_get_row_ops(void);
+
+uint32_t alpha32_add_ignore_destalpha(uint32_t dest, uint32_t src);
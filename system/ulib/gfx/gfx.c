@@ -22,6 +22,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "gfx-row.h"
+
 #define TRACE 0
 
 #if TRACE
@@ -118,9 +120,10 @@ void gfx_copylines(gfx_surface* dst, gfx_surface* src, unsigned srcy, unsigned d
     if ((dsty >= dst->height) || (dst->height - dsty) < height) {
         return;
     }
-    memcpy(dst->ptr + dsty * dst->stride * dst->pixelsize,
-           src->ptr + srcy * src->stride * src->pixelsize,
-           height * src->stride * src->pixelsize);
+    // dst and src may be the same surface, when scrolling.
+    memmove(dst->ptr + dsty * dst->stride * dst->pixelsize,
+            src->ptr + srcy * src->stride * src->pixelsize,
+            height * src->stride * src->pixelsize);
 }
 
 /**
@@ -215,154 +218,85 @@ void gfx_putchar(gfx_surface* surface, const gfx_font* font, unsigned ch, unsign
     surface->putchar(surface, font, ch, x, y, fg, bg);
 }
 
-static void copyrect8(gfx_surface* surface, unsigned x, unsigned y, unsigned width, unsigned height, unsigned x2, unsigned y2) {
-    // copy
-    const uint8_t* src = &((const uint8_t*)surface->ptr)[x + y * surface->stride];
-    uint8_t* dest = &((uint8_t*)surface->ptr)[x2 + y2 * surface->stride];
-    unsigned stride_diff = surface->stride - width;
-
-    if (dest < src) {
-        unsigned i, j;
-        for (i = 0; i < height; i++) {
-            for (j = 0; j < width; j++) {
-                *dest = *src;
-                dest++;
-                src++;
-            }
-            dest += stride_diff;
-            src += stride_diff;
+// Copies |height| rows of |width| bytes between two places that may
+// overlap, if they are in the same surface.  Each row is a memmove(), which
+// has vector versions in libc; the rows go bottom up if the copy moves down.
+static void copyrows(uint8_t* dest, size_t dest_rowlen, const uint8_t* src, size_t src_rowlen,
+                     size_t width, unsigned height) {
+    if (dest <= src) {
+        for (unsigned i = 0; i < height; i++) {
+            memmove(dest, src, width);
+            dest += dest_rowlen;
+            src += src_rowlen;
         }
     } else {
-        // copy backwards
-        src += (height-1) * surface->stride + (width-1);
-        dest += (height-1) * surface->stride + (width-1);
-
-        unsigned i, j;
-        for (i = 0; i < height; i++) {
-            for (j = 0; j < width; j++) {
-                *dest = *src;
-                dest--;
-                src--;
-            }
-            dest -= stride_diff;
-            src -= stride_diff;
+        dest += (height - 1) * dest_rowlen;
+        src += (height - 1) * src_rowlen;
+        for (unsigned i = 0; i < height; i++) {
+            memmove(dest, src, width);
+            dest -= dest_rowlen;
+            src -= src_rowlen;
         }
     }
 }
 
+static void copyrect(gfx_surface* surface, unsigned x, unsigned y, unsigned width, unsigned height, unsigned x2, unsigned y2) {
+    size_t rowlen = surface->stride * surface->pixelsize;
+    const uint8_t* src = (const uint8_t*)surface->ptr + y * rowlen + x * surface->pixelsize;
+    uint8_t* dest = (uint8_t*)surface->ptr + y2 * rowlen + x2 * surface->pixelsize;
+
+    copyrows(dest, rowlen, src, rowlen, width * surface->pixelsize, height);
+}
+
 static void fillrect8(gfx_surface* surface, unsigned x, unsigned y, unsigned width, unsigned height, unsigned color) {
     uint8_t* dest = &((uint8_t*)surface->ptr)[x + y * surface->stride];
-    unsigned stride_diff = surface->stride - width;
 
     uint8_t color8 = (uint8_t)(surface->translate_color(color));
 
-    unsigned i, j;
-    for (i = 0; i < height; i++) {
-        for (j = 0; j < width; j++) {
-            *dest = color8;
-            dest++;
-        }
-        dest += stride_diff;
+    if (width == surface->stride) {
+        memset(dest, color8, width * height);
+        return;
     }
-}
-
-static void copyrect16(gfx_surface* surface, unsigned x, unsigned y, unsigned width, unsigned height, unsigned x2, unsigned y2) {
-    // copy
-    const uint16_t* src = &((const uint16_t*)surface->ptr)[x + y * surface->stride];
-    uint16_t* dest = &((uint16_t*)surface->ptr)[x2 + y2 * surface->stride];
-    unsigned stride_diff = surface->stride - width;
-
-    if (dest < src) {
-        unsigned i, j;
-        for (i = 0; i < height; i++) {
-            for (j = 0; j < width; j++) {
-                *dest = *src;
-                dest++;
-                src++;
-            }
-            dest += stride_diff;
-            src += stride_diff;
-        }
-    } else {
-        // copy backwards
-        src += (height-1) * surface->stride + (width-1);
-        dest += (height-1) * surface->stride + (width-1);
-
-        unsigned i, j;
-        for (i = 0; i < height; i++) {
-            for (j = 0; j < width; j++) {
-                *dest = *src;
-                dest--;
-                src--;
-            }
-            dest -= stride_diff;
-            src -= stride_diff;
-        }
+    for (unsigned i = 0; i < height; i++) {
+        memset(dest, color8, width);
+        dest += surface->stride;
     }
 }
 
 static void fillrect16(gfx_surface* surface, unsigned x, unsigned y, unsigned width, unsigned height, unsigned color) {
     uint16_t* dest = &((uint16_t*)surface->ptr)[x + y * surface->stride];
-    unsigned stride_diff = surface->stride - width;
 
     uint16_t color16 = (uint16_t)(surface->translate_color(color));
-
-    unsigned i, j;
-    for (i = 0; i < height; i++) {
-        for (j = 0; j < width; j++) {
-            *dest = color16;
-            dest++;
+    uint32_t color32 = color16 | ((uint32_t)color16 << 16);
+    const gfx_row_ops* ops = gfx_get_row_ops();
+
+    // Fill pairs of pixels as 32 bit pixels, from a 32 bit boundary.
+    for (unsigned i = 0; i < height; i++) {
+        uint16_t* row = dest;
+        unsigned count = width;
+        if (((uintptr_t)row & 2) && count > 0) {
+            *row++ = color16;
+            count--;
         }
-        dest += stride_diff;
-    }
-}
-
-static void copyrect32(gfx_surface* surface, unsigned x, unsigned y, unsigned width, unsigned height, unsigned x2, unsigned y2) {
-    // copy
-    const uint32_t* src = &((const uint32_t*)surface->ptr)[x + y * surface->stride];
-    uint32_t* dest = &((uint32_t*)surface->ptr)[x2 + y2 * surface->stride];
-    unsigned stride_diff = surface->stride - width;
-
-    if (dest < src) {
-        unsigned i, j;
-        for (i = 0; i < height; i++) {
-            for (j = 0; j < width; j++) {
-                *dest = *src;
-                dest++;
-                src++;
-            }
-            dest += stride_diff;
-            src += stride_diff;
-        }
-    } else {
-        // copy backwards
-        src += (height-1) * surface->stride + (width-1);
-        dest += (height-1) * surface->stride + (width-1);
-
-        unsigned i, j;
-        for (i = 0; i < height; i++) {
-            for (j = 0; j < width; j++) {
-                *dest = *src;
-                dest--;
-                src--;
-            }
-            dest -= stride_diff;
-            src -= stride_diff;
+        ops->fill32((uint32_t*)row, color32, count / 2);
+        if (count & 1) {
+            row[count - 1] = color16;
         }
+        dest += surface->stride;
     }
 }
 
 static void fillrect32(gfx_surface* surface, unsigned x, unsigned y, unsigned width, unsigned height, unsigned color) {
     uint32_t* dest = &((uint32_t*)surface->ptr)[x + y * surface->stride];
-    unsigned stride_diff = surface->stride - width;
+    const gfx_row_ops* ops = gfx_get_row_ops();
 
-    unsigned i, j;
-    for (i = 0; i < height; i++) {
-        for (j = 0; j < width; j++) {
-            *dest = color;
-            dest++;
-        }
-        dest += stride_diff;
+    if (width == surface->stride) {
+        ops->fill32(dest, color, (size_t)width * height);
+        return;
+    }
+    for (unsigned i = 0; i < height; i++) {
+        ops->fill32(dest, color, width);
+        dest += surface->stride;
     }
 }
 
@@ -491,83 +425,32 @@ void gfx_blend(gfx_surface* target, gfx_surface* source, unsigned srcx, unsigned
         height = source->height - srcy;
 
     // XXX total hack to deal with various blends
-    if (source->format == ZX_PIXEL_FORMAT_RGB_565 && target->format == ZX_PIXEL_FORMAT_RGB_565) {
-        // 16 bit to 16 bit
-        const uint16_t* src = &((const uint16_t*)source->ptr)[srcx + srcy * source->stride];
-        uint16_t* dest = &((uint16_t*)target->ptr)[destx + desty * target->stride];
-        unsigned dest_stride_diff = target->stride - width;
-        unsigned source_stride_diff = source->stride - width;
-
-        xprintf("w %u h %u dstride %u sstride %u\n", width, height, dest_stride_diff, source_stride_diff);
-
-        unsigned i, j;
-        for (i = 0; i < height; i++) {
-            for (j = 0; j < width; j++) {
-                *dest = *src;
-                dest++;
-                src++;
-            }
-            dest += dest_stride_diff;
-            src += source_stride_diff;
-        }
-    } else if (source->format == ZX_PIXEL_FORMAT_ARGB_8888 && target->format == ZX_PIXEL_FORMAT_ARGB_8888) {
+    if (source->format == ZX_PIXEL_FORMAT_ARGB_8888 && target->format == ZX_PIXEL_FORMAT_ARGB_8888) {
         // both are 32 bit modes, both alpha
         const uint32_t* src = &((const uint32_t*)source->ptr)[srcx + srcy * source->stride];
         uint32_t* dest = &((uint32_t*)target->ptr)[destx + desty * target->stride];
-        unsigned dest_stride_diff = target->stride - width;
-        unsigned source_stride_diff = source->stride - width;
-
-        xprintf("w %u h %u dstride %u sstride %u\n", width, height, dest_stride_diff, source_stride_diff);
-
-        unsigned i, j;
-        for (i = 0; i < height; i++) {
-            for (j = 0; j < width; j++) {
-                // XXX ignores destination alpha
-                *dest = alpha32_add_ignore_destalpha(*dest, *src);
-                dest++;
-                src++;
-            }
-            dest += dest_stride_diff;
-            src += source_stride_diff;
-        }
-    } else if (source->format == ZX_PIXEL_FORMAT_RGB_x888 && target->format == ZX_PIXEL_FORMAT_RGB_x888) {
-        // both are 32 bit modes, no alpha
-        const uint32_t* src = &((const uint32_t*)source->ptr)[srcx + srcy * source->stride];
-        uint32_t* dest = &((uint32_t*)target->ptr)[destx + desty * target->stride];
-        unsigned dest_stride_diff = target->stride - width;
-        unsigned source_stride_diff = source->stride - width;
+        const gfx_row_ops* ops = gfx_get_row_ops();
 
-        xprintf("w %u h %u dstride %u sstride %u\n", width, height, dest_stride_diff, source_stride_diff);
+        xprintf("w %u h %u dstride %u sstride %u\n", width, height, target->stride, source->stride);
 
-        unsigned i, j;
-        for (i = 0; i < height; i++) {
-            for (j = 0; j < width; j++) {
-                *dest = *src;
-                dest++;
-                src++;
-            }
-            dest += dest_stride_diff;
-            src += source_stride_diff;
-        }
-    } else if (source->format == ZX_PIXEL_FORMAT_MONO_8 && target->format == ZX_PIXEL_FORMAT_MONO_8) {
-        // both are 8 bit modes, no alpha
-        const uint8_t* src = &((const uint8_t*)source->ptr)[srcx + srcy * source->stride];
-        uint8_t* dest = &((uint8_t*)target->ptr)[destx + desty * target->stride];
-        unsigned dest_stride_diff = target->stride - width;
-        unsigned source_stride_diff = source->stride - width;
-
-        xprintf("w %u h %u dstride %u sstride %u\n", width, height, dest_stride_diff, source_stride_diff);
-
-        unsigned i, j;
-        for (i = 0; i < height; i++) {
-            for (j = 0; j < width; j++) {
-                *dest = *src;
-                dest++;
-                src++;
-            }
-            dest += dest_stride_diff;
-            src += source_stride_diff;
+        for (unsigned i = 0; i < height; i++) {
+            // XXX ignores destination alpha
+            ops->blend32(dest, src, width);
+            dest += target->stride;
+            src += source->stride;
         }
+    } else if ((source->format == ZX_PIXEL_FORMAT_RGB_565 && target->format == ZX_PIXEL_FORMAT_RGB_565) ||
+               (source->format == ZX_PIXEL_FORMAT_RGB_x888 && target->format == ZX_PIXEL_FORMAT_RGB_x888) ||
+               (source->format == ZX_PIXEL_FORMAT_MONO_8 && target->format == ZX_PIXEL_FORMAT_MONO_8)) {
+        // same mode, no alpha
+        size_t pixelsize = source->pixelsize;
+        const uint8_t* src = (const uint8_t*)source->ptr + (srcx + srcy * source->stride) * pixelsize;
+        uint8_t* dest = (uint8_t*)target->ptr + (destx + desty * target->stride) * pixelsize;
+
+        xprintf("w %u h %u dstride %u sstride %u\n", width, height, target->stride, source->stride);
+
+        copyrows(dest, target->stride * pixelsize, src, source->stride * pixelsize,
+                 width * pixelsize, height);
     } else {
         xprintf("gfx_surface_blend: unimplemented colorspace combination (source %d target %d)\n", source->format, target->format);
         assert(0);
@@ -642,7 +525,7 @@ int gfx_init_surface(gfx_surface* surface, void* ptr, unsigned width, unsigned h
     switch (format) {
     case ZX_PIXEL_FORMAT_RGB_565:
         surface->translate_color = &ARGB8888_to_RGB565;
-        surface->copyrect = &copyrect16;
+        surface->copyrect = &copyrect;
         surface->fillrect = &fillrect16;
         surface->putpixel = &putpixel16;
         surface->putchar = &putchar16;
@@ -652,7 +535,7 @@ int gfx_init_surface(gfx_surface* surface, void* ptr, unsigned width, unsigned h
     case ZX_PIXEL_FORMAT_RGB_x888:
     case ZX_PIXEL_FORMAT_ARGB_8888:
         surface->translate_color = NULL;
-        surface->copyrect = &copyrect32;
+        surface->copyrect = &copyrect;
         surface->fillrect = &fillrect32;
         surface->putpixel = &putpixel32;
         surface->putchar = &putchar32;
@@ -661,7 +544,7 @@ int gfx_init_surface(gfx_surface* surface, void* ptr, unsigned width, unsigned h
         break;
     case ZX_PIXEL_FORMAT_MONO_8:
         surface->translate_color = &ARGB8888_to_Luma;
-        surface->copyrect = &copyrect8;
+        surface->copyrect = &copyrect;
         surface->fillrect = &fillrect8;
         surface->putpixel = &putpixel8;
         surface->putchar = &putchar8;
@@ -670,7 +553,7 @@ int gfx_init_surface(gfx_surface* surface, void* ptr, unsigned width, unsigned h
         break;
     case ZX_PIXEL_FORMAT_RGB_332:
         surface->translate_color = &ARGB8888_to_RGB332;
-        surface->copyrect = &copyrect8;
+        surface->copyrect = &copyrect;
         surface->fillrect = &fillrect8;
         surface->putpixel = &putpixel8;
         surface->putchar = &putchar8;
@@ -679,7 +562,7 @@ int gfx_init_surface(gfx_surface* surface, void* ptr, unsigned width, unsigned h
         break;
     case ZX_PIXEL_FORMAT_RGB_2220:
         surface->translate_color = &ARGB8888_to_RGB2220;
-        surface->copyrect = &copyrect8;
+        surface->copyrect = &copyrect;
         surface->fillrect = &fillrect8;
         surface->putpixel = &putpixel8;
         surface->putchar = &putchar8;
@@ -105,6 +105,9 @@ zx_status_t gfx_init_surface(gfx_surface* surface, void* ptr, unsigned width, un
 // optionally frees the buffer if the free bit is set
 void gfx_surface_destroy(struct gfx_surface* surface);
 
+// name of the vector code used to fill and blend 32 bit pixels on this cpu
+const char* gfx_simd_name(void);
+
 // utility routine to fill the display with a little moire pattern
 void gfx_draw_pattern(void);
 
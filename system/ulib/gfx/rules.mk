@@ -18,5 +18,6 @@ MODULE_LIBS := \
 
 MODULE_SRCS += \
     $(LOCAL_DIR)/gfx.c \
+    $(LOCAL_DIR)/gfx-row.c \
 
 include make/module.mk
@@ -0,0 +1,120 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <hid-parser/extract.h>
+
+#include <fbl/alloc_checker.h>
+#include <fbl/new.h>
+
+namespace hid {
+namespace {
+
+bool IsExtracted(const ReportField& field) {
+    return (field.type == kInput) && !(field.flags & kConstant) &&
+           (field.attr.bit_sz > 0) && (field.attr.bit_sz <= 32);
+}
+
+void FillField(const ReportField& field, uint32_t bit_offset, ExtractField* out) {
+    out->bit_offset = bit_offset;
+    out->bit_sz = field.attr.bit_sz;
+    out->is_signed = field.attr.logc_mm.min < 0;
+    out->scale = 1.0f;
+    out->bias = 0.0f;
+    out->field = &field;
+
+    // Per the HID spec a physical range of 0 to 0 means the physical range
+    // is the same as the logical one.
+    const MinMax& logc = field.attr.logc_mm;
+    const MinMax& phys = field.attr.phys_mm;
+    if ((phys.min != 0 || phys.max != 0) && (logc.max != logc.min)) {
+        out->scale = (static_cast<float>(phys.max) - static_cast<float>(phys.min)) /
+                     (static_cast<float>(logc.max) - static_cast<float>(logc.min));
+        out->bias = static_cast<float>(phys.min) - static_cast<float>(logc.min) * out->scale;
+    }
+}
+
+}  // namespace
+
+ParseResult CreateInputExtractors(const DeviceDescriptor* dev_desc,
+                                  InputExtractors** extractors) {
+    // The fields of one report id can be split across several
+    // ReportDescriptor entries, so the layout of each report id is built up
+    // across all of them. The first pass sizes the single allocation: the
+    // InputExtractors with its report array, then all the fields.
+    uint8_t index[256];
+    memset(index, InputExtractors::kNoReport, sizeof(index));
+    size_t rep_count = 0;
+    size_t field_count = 0;
+    bool has_report_id = false;
+
+    for (size_t ix = 0; ix != dev_desc->rep_count; ++ix) {
+        const ReportDescriptor& report = dev_desc->report[ix];
+        if (report.report_id != 0)
+            has_report_id = true;
+        bool has_input = false;
+        for (size_t jx = 0; jx != report.count; ++jx) {
+            if (report.first_field[jx].type == kInput)
+                has_input = true;
+            if (IsExtracted(report.first_field[jx]))
+                ++field_count;
+        }
+        if (has_input && index[report.report_id] == InputExtractors::kNoReport) {
+            // There are at most 255 report ids since zero is reserved.
+            index[report.report_id] = static_cast<uint8_t>(rep_count++);
+        }
+    }
+
+    size_t extractors_sz = sizeof(InputExtractors) + rep_count * sizeof(ReportExtractor);
+    size_t fields_sz = field_count * sizeof(ExtractField);
+
+    fbl::AllocChecker ac;
+    auto mem = new (&ac) char[extractors_sz + fields_sz];
+    if (!ac.check())
+        return kParseNoMemory;
+
+    auto ex = new (mem) InputExtractors;
+    memcpy(ex->index, index, sizeof(index));
+    ex->has_report_id = has_report_id;
+    ex->rep_count = rep_count;
+
+    // Second pass, one report id at a time, so that the fields of each
+    // report id are contiguous.
+    auto fields = reinterpret_cast<ExtractField*>(mem + extractors_sz);
+    for (size_t id = 0; id != 256; ++id) {
+        if (index[id] == InputExtractors::kNoReport)
+            continue;
+
+        ReportExtractor& rpt = ex->report[index[id]];
+        rpt.report_id = static_cast<uint8_t>(id);
+        rpt.fields = fields;
+        rpt.count = 0;
+
+        uint32_t bit_offset = has_report_id ? 8 : 0;
+        for (size_t ix = 0; ix != dev_desc->rep_count; ++ix) {
+            const ReportDescriptor& report = dev_desc->report[ix];
+            if (report.report_id != id)
+                continue;
+            for (size_t jx = 0; jx != report.count; ++jx) {
+                const ReportField& field = report.first_field[jx];
+                if (field.type != kInput)
+                    continue;
+                if (IsExtracted(field))
+                    FillField(field, bit_offset, &fields[rpt.count++]);
+                bit_offset += field.attr.bit_sz;
+            }
+        }
+
+        rpt.byte_sz = (bit_offset + 7) / 8;
+        fields += rpt.count;
+    }
+
+    *extractors = ex;
+    return kParseOk;
+}
+
+void FreeInputExtractors(InputExtractors* extractors) {
+    delete[] reinterpret_cast<char*>(extractors);
+}
+
+}  // namespace hid
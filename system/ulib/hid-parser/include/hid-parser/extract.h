@@ -0,0 +1,131 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <endian.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <hid-parser/parser.h>
+
+namespace hid {
+
+// Walking the ReportField array of a DeviceDescriptor to decode each input
+// report is fine for keyboards and mice, but touch panels and sensors send
+// thousands of reports a second with dozens of fields each.
+//
+// CreateInputExtractors() turns the input fields of a DeviceDescriptor into a
+// flat plan per report id, computed once, so that decoding a report is a
+// table lookup followed by one unaligned load, shift and mask per field:
+//
+//    hid::InputExtractors* ex;
+//    CreateInputExtractors(dev_desc, &ex);
+//    ...
+//    auto rpt = hid::FindInputExtractor(ex, report[0]);
+//    int32_t values[kMaxFields];
+//    if (rpt && rpt->count <= kMaxFields &&
+//        hid::ExtractInputReport(*rpt, report, len, values)) {
+//        // values[i] holds the logical value of rpt->fields[i].field.
+//    }
+//
+// Constant fields (padding) and fields wider than 32 bits are left out of
+// the plan. Each ExtractField points back to its ReportField, so the plan
+// must not outlive the DeviceDescriptor it was created from.
+
+struct ExtractField {
+    // Bit offset of the field from the start of the report, including
+    // the report id byte if there is one.
+    uint32_t bit_offset;
+    uint8_t bit_sz;
+    // True if the logical minimum is negative, in which case the value is
+    // sign extended.
+    bool is_signed;
+    // physical = logical * scale + bias, per the logical and physical
+    // ranges. Fields without a physical range have a scale of 1.
+    float scale;
+    float bias;
+    const ReportField* field;
+};
+
+struct ReportExtractor {
+    uint8_t report_id;
+    // The smallest report which holds every field, in bytes.
+    size_t byte_sz;
+    size_t count;
+    const ExtractField* fields;
+};
+
+struct InputExtractors {
+    // Index into |report| for each report id, or kNoReport.
+    static constexpr uint8_t kNoReport = 0xff;
+    uint8_t index[256];
+    // Set if the reports start with their report id. If not, there is a
+    // single report with id zero.
+    bool has_report_id;
+    size_t rep_count;
+    ReportExtractor report[];
+};
+
+ParseResult CreateInputExtractors(const DeviceDescriptor* dev_desc,
+                                  InputExtractors** extractors);
+
+void FreeInputExtractors(InputExtractors* extractors);
+
+// Returns the plan for a report starting with |first_byte|, or null if
+// there is no input report with that id.
+inline const ReportExtractor* FindInputExtractor(const InputExtractors* extractors,
+                                                 uint8_t first_byte) {
+    uint8_t ix = extractors->index[extractors->has_report_id ? first_byte : 0];
+    return (ix == InputExtractors::kNoReport) ? nullptr : &extractors->report[ix];
+}
+
+// Returns the |bit_sz| bits at |bit_offset| of the little-endian bit stream
+// in |data|, which is |len| bytes long and must hold them.
+inline uint32_t ExtractBits(const uint8_t* data, size_t len,
+                            uint32_t bit_offset, uint8_t bit_sz) {
+    size_t byte = bit_offset / 8;
+    uint64_t raw;
+    if (byte + sizeof(raw) <= len) {
+        memcpy(&raw, data + byte, sizeof(raw));
+        raw = le64toh(raw);
+    } else {
+        // Near the end of the report, assemble the bytes one at a time
+        // rather than read past the end.
+        raw = 0;
+        for (size_t ix = 0; byte + ix < len && ix < sizeof(raw); ++ix) {
+            raw |= static_cast<uint64_t>(data[byte + ix]) << (8 * ix);
+        }
+    }
+    raw >>= bit_offset % 8;
+    return static_cast<uint32_t>(raw & ((1ull << bit_sz) - 1));
+}
+
+inline int32_t ExtractValue(const ExtractField& f, const uint8_t* data, size_t len) {
+    uint32_t v = ExtractBits(data, len, f.bit_offset, f.bit_sz);
+    if (f.is_signed && f.bit_sz < 32) {
+        uint32_t sign = 1u << (f.bit_sz - 1);
+        v = (v ^ sign) - sign;
+    }
+    return static_cast<int32_t>(v);
+}
+
+// Fills |values|, which must have room for |rpt.count| entries, from
+// |report|. Returns false if |report| is too short to hold every field.
+inline bool ExtractInputReport(const ReportExtractor& rpt, const uint8_t* report,
+                               size_t len, int32_t* values) {
+    if (len < rpt.byte_sz)
+        return false;
+    for (size_t ix = 0; ix != rpt.count; ++ix) {
+        values[ix] = ExtractValue(rpt.fields[ix], report, len);
+    }
+    return true;
+}
+
+inline float ToPhysical(const ExtractField& f, int32_t value) {
+    return static_cast<float>(value) * f.scale + f.bias;
+}
+
+}  // namespace hid
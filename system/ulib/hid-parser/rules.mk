@@ -13,6 +13,7 @@ MODULE_PACKAGE := static
 MODULE_COMPILEFLAGS += -fvisibility=hidden
 
 MODULE_SRCS += \
+    $(LOCAL_DIR)/extract.cpp \
     $(LOCAL_DIR)/item.cpp \
     $(LOCAL_DIR)/parser.cpp \
 
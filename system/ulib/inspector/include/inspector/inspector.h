@@ -53,6 +53,18 @@ extern void inspector_print_backtrace(FILE* f,
                                       uintptr_t pc, uintptr_t sp, uintptr_t fp,
                                       bool use_libunwind);
 
+// Unwind the stack of a thread of |process| by following frame pointers,
+// starting from the thread's |pc|, |sp| and |fp| registers, and store up to
+// |max_frames| program counters in |out_pcs|, most recent first.  Returns
+// the number stored.
+// The thread must currently be stopped: either suspended or in an exception.
+// This misses the frames of code built without frame pointers, but it
+// needs neither the DSO list nor debug info and does not print anything,
+// which makes it cheap enough for sampling profilers.
+extern size_t inspector_unwind_frame_pointers(zx_handle_t process,
+                                              uintptr_t pc, uintptr_t sp, uintptr_t fp,
+                                              uintptr_t* out_pcs, size_t max_frames);
+
 // Fetch the list of the DSOs of |process|.
 // |name| is the name of the application binary.
 extern inspector_dsoinfo_t* inspector_dso_fetch_list(zx_handle_t process);
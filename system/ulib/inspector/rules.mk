@@ -14,6 +14,7 @@ MODULE_SRCS += \
     $(LOCAL_DIR)/backtrace.cpp \
     $(LOCAL_DIR)/dso-list.cpp \
     $(LOCAL_DIR)/registers.cpp \
+    $(LOCAL_DIR)/unwind.cpp \
     $(LOCAL_DIR)/utils.cpp \
 
 MODULE_STATIC_LIBS := \
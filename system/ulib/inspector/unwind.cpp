@@ -0,0 +1,44 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// This file has no dependencies beyond libzircon, so that programs can use
+// the unwinder without pulling in libunwind and libbacktrace.
+
+#include <stdint.h>
+
+#include <zircon/syscalls.h>
+
+#include "inspector/inspector.h"
+
+namespace inspector {
+
+extern "C"
+size_t inspector_unwind_frame_pointers(zx_handle_t process,
+                                       uintptr_t pc, uintptr_t sp, uintptr_t fp,
+                                       uintptr_t* out_pcs, size_t max_frames) {
+    if (max_frames == 0)
+        return 0;
+
+    size_t n = 0;
+    out_pcs[n++] = pc;
+
+    // Each frame is at a higher address than the frame it called, so
+    // insisting that |fp| only moves up keeps a corrupt chain from looping.
+    while (n < max_frames && fp >= sp && (fp & (sizeof(uintptr_t) - 1)) == 0) {
+        // On both x86-64 and arm64 the frame pointer points at the saved
+        // frame pointer of the caller, followed by the return address.
+        uintptr_t frame[2];
+        size_t actual;
+        zx_status_t status = zx_process_read_memory(process, fp, frame, sizeof(frame),
+                                                    &actual);
+        if (status != ZX_OK || actual != sizeof(frame) || frame[1] == 0)
+            break;
+        out_pcs[n++] = frame[1];
+        sp = fp + sizeof(frame);
+        fp = frame[0];
+    }
+    return n;
+}
+
+}  // namespace inspector
@@ -245,6 +245,9 @@ constexpr uint8_t HDA_REG_RIRBSIZE_CAP_2ENT   = 0x10u;
 constexpr uint8_t HDA_REG_RIRBSIZE_CAP_16ENT  = 0x20u;
 constexpr uint8_t HDA_REG_RIRBSIZE_CAP_256ENT = 0x40u;
 
+/* DMA Position Lower Base Address (DPLBASE - offset 0x70) */
+constexpr uint32_t HDA_REG_DPLBASE_ENABLE = 0x00000001u;  // DMA Position Buffer Enable
+
 // Stream Descriptor Control Register bits.
 constexpr uint32_t HDA_SD_REG_CTRL_SRST    = (1u << 0); // Stream Reset
 constexpr uint32_t HDA_SD_REG_CTRL_RUN     = (1u << 1); // Stream Run
@@ -350,6 +353,15 @@ struct IntelHDABDLEntry {
     static constexpr uint32_t IOC_FLAG = 0x1u;
 } __PACKED;
 
+// When enabled with DPLBASE, the controller writes the link position of each
+// stream descriptor into an array of these entries (indexed by stream
+// descriptor number) in system memory.  The base of the array must be 128 byte
+// aligned.
+struct IntelHDADMAPosEntry {
+    uint32_t    position;
+    uint32_t    __rsvd;
+} __PACKED;
+
 // TODO(johngro) : Intel specs its controller registers as little endian.
 // Someday, we should update these template/macros to deal with conversion
 // to/from host endian instead of assuming a little endian host.
@@ -185,6 +185,32 @@ zx_status_t launchpad_load_from_fd(launchpad_t* lp, int fd);
 // Load an ELF PIE binary from vmo
 zx_status_t launchpad_load_from_vmo(launchpad_t* lp, zx_handle_t vmo);
 
+// An ELF binary prepared for being loaded into many processes.
+//
+// Making a template reads the binary's ELF headers and, if it has a
+// PT_INTERP, looks up the dynamic linker via this process's loader service
+// and reads its headers too.  Loading from the template then only has to
+// map the segments into each new process.  Writable segments are mapped
+// as copy-on-write clones, as with any other load.
+//
+// A template may be used from several threads at once, each with its own
+// launchpad.
+typedef struct launchpad_template launchpad_template_t;
+
+// Make a template from the ELF PIE binary in |vmo|, which is consumed
+// whether or not this succeeds.  Scripts starting with #! are not
+// supported.
+zx_status_t launchpad_template_create(zx_handle_t vmo,
+                                      launchpad_template_t** out);
+
+// Free a template.  Processes loaded from it are not affected.
+void launchpad_template_destroy(launchpad_template_t* tmpl);
+
+// Load the binary of |tmpl|, and the vDSO, as launchpad_load_from_vmo
+// would load it.
+zx_status_t launchpad_load_from_template(launchpad_t* lp,
+                                         launchpad_template_t* tmpl);
+
 
 // ADDING ARGUMENTS, ENVIRONMENT, AND HANDLES
 // These functions setup arguments, environment, or handles to be
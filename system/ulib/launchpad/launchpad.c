@@ -513,20 +513,12 @@ static zx_status_t reserve_low_address_space(launchpad_t* lp) {
     return ZX_OK;
 }
 
-// Consumes 'vmo' on success, not on failure.
-static zx_status_t handle_interp(launchpad_t* lp, zx_handle_t vmo,
-                                 const char* interp, size_t interp_len) {
-    zx_status_t status = setup_loader_svc(lp);
-    if (status != ZX_OK)
-        return status;
-
-    zx_handle_t interp_vmo;
-    status = loader_svc_rpc(
-        lp->special_handles[HND_LDSVC_LOADER], LDMSG_OP_LOAD_OBJECT,
-        interp, interp_len, &interp_vmo);
-    if (status != ZX_OK)
-        return status;
-
+// Map the dynamic linker described by 'interp_elf' for the executable in
+// 'vmo'.  Consumes 'vmo' on success, not on failure.
+static zx_status_t map_interp(launchpad_t* lp, zx_handle_t vmo,
+                              zx_handle_t interp_vmo,
+                              elf_load_info_t* interp_elf) {
+    zx_status_t status;
     if (lp->fresh_process) {
         // A fresh process using PT_INTERP might be loading a libc.so that
         // supports sanitizers, so in that case (the most common case)
@@ -536,15 +528,9 @@ static zx_status_t handle_interp(launchpad_t* lp, zx_handle_t vmo,
             return status;
     }
 
-    elf_load_info_t* elf;
     zx_handle_t segments_vmar;
-    status = elf_load_start(interp_vmo, NULL, 0, &elf);
-    if (status == ZX_OK) {
-        status = elf_load_finish(lp_vmar(lp), elf, interp_vmo,
-                                 &segments_vmar, &lp->base, &lp->entry);
-        elf_load_destroy(elf);
-    }
-    zx_handle_close(interp_vmo);
+    status = elf_load_finish(lp_vmar(lp), interp_elf, interp_vmo,
+                             &segments_vmar, &lp->base, &lp->entry);
 
     if (status == ZX_OK) {
         if (lp->special_handles[HND_EXEC_VMO] != ZX_HANDLE_INVALID)
@@ -559,6 +545,42 @@ static zx_status_t handle_interp(launchpad_t* lp, zx_handle_t vmo,
     return status;
 }
 
+// Look up the dynamic linker named 'interp' and read its headers.
+static zx_status_t fetch_interp(zx_handle_t loader_svc,
+                                const char* interp, size_t interp_len,
+                                zx_handle_t* interp_vmo,
+                                elf_load_info_t** interp_elf) {
+    zx_status_t status = loader_svc_rpc(loader_svc, LDMSG_OP_LOAD_OBJECT,
+                                        interp, interp_len, interp_vmo);
+    if (status != ZX_OK)
+        return status;
+
+    status = elf_load_start(*interp_vmo, NULL, 0, interp_elf);
+    if (status != ZX_OK)
+        zx_handle_close(*interp_vmo);
+    return status;
+}
+
+// Consumes 'vmo' on success, not on failure.
+static zx_status_t handle_interp(launchpad_t* lp, zx_handle_t vmo,
+                                 const char* interp, size_t interp_len) {
+    zx_status_t status = setup_loader_svc(lp);
+    if (status != ZX_OK)
+        return status;
+
+    zx_handle_t interp_vmo;
+    elf_load_info_t* elf;
+    status = fetch_interp(lp->special_handles[HND_LDSVC_LOADER],
+                          interp, interp_len, &interp_vmo, &elf);
+    if (status != ZX_OK)
+        return status;
+
+    status = map_interp(lp, vmo, interp_vmo, elf);
+    elf_load_destroy(elf);
+    zx_handle_close(interp_vmo);
+    return status;
+}
+
 static zx_status_t launchpad_elf_load_body(launchpad_t* lp, const char* hdr_buf,
                                            size_t buf_sz, zx_handle_t vmo) {
     elf_load_info_t* elf;
@@ -768,6 +790,8 @@ zx_status_t launchpad_elf_load(launchpad_t* lp, zx_handle_t vmo) {
 }
 
 static zx_handle_t vdso_vmo = ZX_HANDLE_INVALID;
+// The headers of vdso_vmo, read the first time it is loaded.
+static elf_load_info_t* vdso_elf = NULL;
 static mtx_t vdso_mutex = MTX_INIT;
 static void vdso_lock(void) __TA_ACQUIRE(&vdso_mutex) {
     mtx_lock(&vdso_mutex);
@@ -793,6 +817,10 @@ zx_handle_t launchpad_set_vdso_vmo(zx_handle_t new_vdso_vmo) {
     vdso_lock();
     zx_handle_t old = vdso_vmo;
     vdso_vmo = new_vdso_vmo;
+    if (vdso_elf != NULL) {
+        elf_load_destroy(vdso_elf);
+        vdso_elf = NULL;
+    }
     vdso_unlock();
     return old;
 }
@@ -811,12 +839,24 @@ zx_status_t launchpad_add_vdso_vmo(launchpad_t* lp) {
 zx_status_t launchpad_load_vdso(launchpad_t* lp, zx_handle_t vmo) {
     if (vmo != ZX_HANDLE_INVALID)
         return launchpad_elf_load_extra(lp, vmo, &lp->vdso_base, NULL);
+    if (lp->error)
+        return lp->error;
     vdso_lock();
     vmo = vdso_get_vmo();
-    zx_status_t status = launchpad_elf_load_extra(lp, vmo,
-                                                  &lp->vdso_base, NULL);
+    zx_status_t status = ZX_OK;
+    if (vdso_elf == NULL) {
+        if (vmo == ZX_HANDLE_INVALID)
+            status = ZX_ERR_INVALID_ARGS;
+        else
+            status = elf_load_start(vmo, NULL, 0, &vdso_elf);
+    }
+    if (status == ZX_OK)
+        status = elf_load_finish(lp_vmar(lp), vdso_elf, vmo, NULL,
+                                 &lp->vdso_base, NULL);
     vdso_unlock();
-    return status;
+    if (status != ZX_OK)
+        return lp_error(lp, status, "load_vdso: failed to load the vDSO");
+    return ZX_OK;
 }
 
 zx_status_t launchpad_get_entry_address(launchpad_t* lp, zx_vaddr_t* entry) {
@@ -1312,3 +1352,108 @@ zx_status_t launchpad_load_from_fd(launchpad_t* lp, int fd) {
 zx_status_t launchpad_load_from_vmo(launchpad_t* lp, zx_handle_t vmo) {
     return launchpad_file_load_with_vdso(lp, vmo);
 }
+
+struct launchpad_template {
+    zx_handle_t vmo;
+    elf_load_info_t* elf;
+    // The dynamic linker, if the binary has a PT_INTERP.
+    zx_handle_t interp_vmo;
+    elf_load_info_t* interp_elf;
+};
+
+zx_status_t launchpad_template_create(zx_handle_t vmo,
+                                      launchpad_template_t** out) {
+    if (vmo == ZX_HANDLE_INVALID)
+        return ZX_ERR_INVALID_ARGS;
+
+    launchpad_template_t* tmpl = calloc(1, sizeof(*tmpl));
+    if (tmpl == NULL) {
+        zx_handle_close(vmo);
+        return ZX_ERR_NO_MEMORY;
+    }
+    tmpl->vmo = vmo;
+    tmpl->interp_vmo = ZX_HANDLE_INVALID;
+
+    zx_status_t status = elf_load_start(vmo, NULL, 0, &tmpl->elf);
+    if (status != ZX_OK)
+        goto fail;
+
+    char* interp;
+    size_t interp_len;
+    status = elf_load_get_interp(tmpl->elf, vmo, &interp, &interp_len);
+    if (status != ZX_OK)
+        goto fail;
+    if (interp != NULL) {
+        zx_handle_t loader_svc;
+        status = dl_clone_loader_service(&loader_svc);
+        if (status == ZX_OK) {
+            status = fetch_interp(loader_svc, interp, interp_len,
+                                  &tmpl->interp_vmo, &tmpl->interp_elf);
+            zx_handle_close(loader_svc);
+        }
+        free(interp);
+        if (status != ZX_OK)
+            goto fail;
+    }
+
+    *out = tmpl;
+    return ZX_OK;
+
+fail:
+    launchpad_template_destroy(tmpl);
+    return status;
+}
+
+void launchpad_template_destroy(launchpad_template_t* tmpl) {
+    if (tmpl == NULL)
+        return;
+    if (tmpl->elf != NULL)
+        elf_load_destroy(tmpl->elf);
+    if (tmpl->interp_elf != NULL)
+        elf_load_destroy(tmpl->interp_elf);
+    zx_handle_close(tmpl->vmo);
+    zx_handle_close(tmpl->interp_vmo);
+    free(tmpl);
+}
+
+static zx_status_t template_load(launchpad_t* lp, launchpad_template_t* tmpl) {
+    if (lp->error)
+        return lp->error;
+
+    zx_status_t status;
+    if (tmpl->interp_vmo == ZX_HANDLE_INVALID) {
+        zx_handle_t segments_vmar;
+        status = elf_load_finish(lp_vmar(lp), tmpl->elf, tmpl->vmo,
+                                 &segments_vmar, &lp->base, &lp->entry);
+        if (status != ZX_OK)
+            return lp_error(lp, status, "template_load: elf_load_finish() failed");
+        check_elf_stack_size(lp, tmpl->elf);
+        lp->loader_message = false;
+        return launchpad_add_handle(lp, segments_vmar, PA_HND(PA_VMAR_LOADED, 0));
+    }
+
+    // The dynamic linker still gets its loader service from the launchpad.
+    status = setup_loader_svc(lp);
+    if (status != ZX_OK)
+        return lp_error(lp, status, "template_load: setup_loader_svc() failed");
+
+    zx_handle_t vmo;
+    status = zx_handle_duplicate(tmpl->vmo, ZX_RIGHT_SAME_RIGHTS, &vmo);
+    if (status != ZX_OK)
+        return lp_error(lp, status, "template_load: zx_handle_duplicate() failed");
+    status = map_interp(lp, vmo, tmpl->interp_vmo, tmpl->interp_elf);
+    if (status != ZX_OK) {
+        zx_handle_close(vmo);
+        return lp_error(lp, status, "template_load: map_interp() failed");
+    }
+    return ZX_OK;
+}
+
+zx_status_t launchpad_load_from_template(launchpad_t* lp,
+                                         launchpad_template_t* tmpl) {
+    if (tmpl == NULL)
+        return lp_error(lp, ZX_ERR_INVALID_ARGS, "load_from_template: no template");
+    template_load(lp, tmpl);
+    launchpad_load_vdso(lp, ZX_HANDLE_INVALID);
+    return launchpad_add_vdso_vmo(lp);
+}
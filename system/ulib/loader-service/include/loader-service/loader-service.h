@@ -29,6 +29,12 @@ typedef struct async_dispatcher async_dispatcher_t; // From <lib/async/dispatche
 
 typedef struct loader_service loader_service_t;
 
+// The file-system and file-descriptor backed loader services below remember
+// the objects they have opened, and answer later requests for the same name
+// with a copy-on-write clone instead of opening the file again. A file that
+// is replaced after it was first loaded is not seen by clients of the same
+// loader service.
+
 // Create a new file-system backed loader service capable of handling
 // any number of clients.
 //
@@ -17,6 +17,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <threads.h>
 #include <unistd.h>
 #include <zircon/compiler.h>
 #include <zircon/device/vfs.h>
@@ -26,6 +27,27 @@
 
 #define PREFIX_MAX 32
 
+// The most requests answered each time a session's channel is readable.
+// Clients such as the dynamic linker send several before waiting for any
+// reply; answering those without going back to the dispatcher in between
+// saves a wakeup per request, and the limit keeps one busy session from
+// holding up the others.
+#define MAX_REQUESTS_PER_WAKEUP 16
+
+// Number of opened objects the default implementation remembers.
+#define CACHE_SIZE 64
+
+// An object the default implementation has already opened. Clones of |vmo|
+// are handed out when the same name is asked for again, which saves opening
+// the file along each of the library paths.
+typedef struct cache_entry {
+    // Object names and absolute paths are kept apart, so the name is
+    // prefixed with 'o' or 'p' respectively.
+    char* key;
+    zx_handle_t vmo;
+    uint64_t size;
+} cache_entry_t;
+
 // State of a loader service instance.
 typedef struct instance_state instance_state_t;
 struct instance_state {
@@ -33,6 +55,11 @@ struct instance_state {
   int data_sink_dir_fd;
   // NULL-terminated list of paths from which objects will loaded.
   const char* const* lib_paths;
+
+  mtx_t cache_lock;
+  cache_entry_t cache[CACHE_SIZE];
+  // The entry to replace once the cache is full.
+  size_t cache_next;
 };
 
 // This represents an instance of the loader service. Each session in an
@@ -92,24 +119,112 @@ static zx_handle_t vmo_from_fd(int fd, const char* fn, zx_handle_t* out) {
     return status;
 }
 
-static zx_status_t fd_load_object(void* ctx, const char* name, zx_handle_t* out) {
-    int root_dir_fd = ((instance_state_t*)ctx)->root_dir_fd;
-    const char* const* lib_paths = ((instance_state_t*)ctx)->lib_paths;
+// Hands out a copy-on-write clone of the cached object |key|, if there is one.
+static bool cache_lookup(instance_state_t* state, const char* key, const char* fn,
+                         zx_handle_t* out) {
+    bool found = false;
+    mtx_lock(&state->cache_lock);
+    for (size_t n = 0; n < CACHE_SIZE; ++n) {
+        cache_entry_t* entry = &state->cache[n];
+        if (entry->key != NULL && strcmp(entry->key, key) == 0) {
+            found = zx_vmo_clone(entry->vmo, ZX_VMO_CLONE_COPY_ON_WRITE, 0, entry->size,
+                                 out) == ZX_OK;
+            break;
+        }
+    }
+    mtx_unlock(&state->cache_lock);
+    if (found) {
+        zx_object_set_property(*out, ZX_PROP_NAME, fn, strlen(fn));
+    }
+    return found;
+}
 
-    int fd = open_from_lib_paths(root_dir_fd, lib_paths, name);
-    if (fd >= 0) {
-        return vmo_from_fd(fd, name, out);
+// Remembers a clone of |vmo| as the object |key|. Failing to is harmless, the
+// object is just opened again the next time.
+static void cache_insert(instance_state_t* state, const char* key, zx_handle_t vmo) {
+    uint64_t size;
+    if (zx_vmo_get_size(vmo, &size) != ZX_OK) {
+        return;
     }
-    return ZX_ERR_NOT_FOUND;
+    zx_handle_t clone;
+    if (zx_vmo_clone(vmo, ZX_VMO_CLONE_COPY_ON_WRITE, 0, size, &clone) != ZX_OK) {
+        return;
+    }
+    char* key_copy = strdup(key);
+    if (key_copy == NULL) {
+        zx_handle_close(clone);
+        return;
+    }
+
+    mtx_lock(&state->cache_lock);
+    for (size_t n = 0; n < CACHE_SIZE; ++n) {
+        if (state->cache[n].key != NULL && strcmp(state->cache[n].key, key) == 0) {
+            // Another session got here first.
+            mtx_unlock(&state->cache_lock);
+            free(key_copy);
+            zx_handle_close(clone);
+            return;
+        }
+    }
+    cache_entry_t* entry = &state->cache[state->cache_next];
+    state->cache_next = (state->cache_next + 1) % CACHE_SIZE;
+    char* old_key = entry->key;
+    zx_handle_t old_vmo = entry->vmo;
+    entry->key = key_copy;
+    entry->vmo = clone;
+    entry->size = size;
+    mtx_unlock(&state->cache_lock);
+
+    free(old_key);
+    zx_handle_close(old_vmo);
 }
 
-static zx_status_t fd_load_abspath(void* ctx, const char* path, zx_handle_t* out) {
-    int root_dir_fd = ((instance_state_t*)ctx)->root_dir_fd;
-    int fd = openat(root_dir_fd, path, O_RDONLY);
-    if (fd >= 0) {
-        return vmo_from_fd(fd, path, out);
+static void cache_destroy(instance_state_t* state) {
+    for (size_t n = 0; n < CACHE_SIZE; ++n) {
+        free(state->cache[n].key);
+        zx_handle_close(state->cache[n].vmo);
+    }
+    mtx_destroy(&state->cache_lock);
+}
+
+// Loads |fn| through the cache, calling |open_fn| on a miss.
+static zx_status_t load_cached(instance_state_t* state, char kind, const char* fn,
+                               int (*open_fn)(instance_state_t* state, const char* fn),
+                               zx_handle_t* out) {
+    size_t len = strlen(fn);
+    char key[len + 2];
+    key[0] = kind;
+    memcpy(key + 1, fn, len + 1);
+
+    if (cache_lookup(state, key, fn, out)) {
+        return ZX_OK;
     }
-    return ZX_ERR_NOT_FOUND;
+
+    int fd = open_fn(state, fn);
+    if (fd < 0) {
+        return ZX_ERR_NOT_FOUND;
+    }
+    zx_status_t status = vmo_from_fd(fd, fn, out);
+    if (status == ZX_OK) {
+        cache_insert(state, key, *out);
+    }
+    return status;
+}
+
+static int open_object(instance_state_t* state, const char* name) {
+    return open_from_lib_paths(state->root_dir_fd, state->lib_paths, name);
+}
+
+static int open_abspath(instance_state_t* state, const char* path) {
+    return openat(state->root_dir_fd, path, O_RDONLY);
+}
+
+static zx_status_t fd_load_object(void* ctx, const char* name, zx_handle_t* out) {
+    return load_cached((instance_state_t*)ctx, 'o', name, open_object, out);
+}
+
+static zx_status_t fd_load_abspath(void* ctx, const char* path, zx_handle_t* out) {
+    return load_cached((instance_state_t*)ctx, 'p', path, open_abspath, out);
 }
 
 zx_status_t fd_publish_data_sink(void* ctx, const char* sink_name, zx_handle_t vmo) {
@@ -123,6 +238,7 @@ void fd_finalizer(void* ctx) {
     int data_sink_dir_fd = instance_state->data_sink_dir_fd;
     close(root_dir_fd);
     close(data_sink_dir_fd);
+    cache_destroy(instance_state);
     free(instance_state);
 }
 
@@ -143,8 +259,9 @@ static zx_status_t loader_service_rpc(zx_handle_t h, session_state_t* session_st
         zx_channel_read(h, 0, &req, &req_handle, req_len, 1, &req_len, &req_handle_len);
     if (status != ZX_OK) {
         // This is the normal error for the other end going away,
-        // which happens when the process dies.
-        if (status != ZX_ERR_PEER_CLOSED)
+        // which happens when the process dies.  The channel being empty
+        // just means all of the queued requests have been answered.
+        if (status != ZX_ERR_PEER_CLOSED && status != ZX_ERR_SHOULD_WAIT)
             fprintf(stderr, "dlsvc: msg read error %d: %s\n", status, zx_status_get_string(status));
         return status;
     }
@@ -307,13 +424,14 @@ zx_status_t loader_service_create_default(async_dispatcher_t* dispatcher,
                                           int data_sink_dir_fd,
                                           const char* const* lib_paths,
                                           loader_service_t** out) {
-    instance_state_t* instance_state = calloc(1, sizeof(loader_service_t));
+    instance_state_t* instance_state = calloc(1, sizeof(instance_state_t));
     if (instance_state == NULL) {
         return ZX_ERR_NO_MEMORY;
     }
     instance_state->root_dir_fd = root_dir_fd;
     instance_state->data_sink_dir_fd = data_sink_dir_fd;
     instance_state->lib_paths = lib_paths? lib_paths : fd_lib_paths;
+    mtx_init(&instance_state->cache_lock, mtx_plain);
 
     loader_service_t* svc;
     zx_status_t status = loader_service_create(dispatcher, &fd_ops, NULL, &svc);
@@ -321,6 +439,7 @@ zx_status_t loader_service_create_default(async_dispatcher_t* dispatcher,
       svc->ctx = instance_state;
       *out = svc;
     } else {
+      mtx_destroy(&instance_state->cache_lock);
       free(instance_state);
     }
     return status;
@@ -358,8 +477,12 @@ static void loader_service_handler(async_dispatcher_t* dispatcher,
     session_state_t* session_state = (session_state_t*)wait;
     if (status != ZX_OK)
         goto stop;
-    status = loader_service_rpc(wait->object, session_state);
-    if (status != ZX_OK)
+    for (int n = 0; n < MAX_REQUESTS_PER_WAKEUP; ++n) {
+        status = loader_service_rpc(wait->object, session_state);
+        if (status != ZX_OK)
+            break;
+    }
+    if (status != ZX_OK && status != ZX_ERR_SHOULD_WAIT)
         goto stop;
     status = async_begin_wait(dispatcher, wait);
     if (status != ZX_OK)
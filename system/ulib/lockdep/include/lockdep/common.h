@@ -31,6 +31,20 @@ namespace lockdep {
 #define LOCK_DEP_ENABLE_VALIDATION 0
 #endif
 
+// Configures whether lock contention profiling is enabled or not. Defaults to
+// disabled. When enabled every lock class counts its acquisitions and the time
+// spent waiting for them. Requires lock validation to be enabled.
+#ifndef LOCK_DEP_ENABLE_PROFILING
+#define LOCK_DEP_ENABLE_PROFILING 0
+#endif
+
+// Configures how long an acquisition must wait, in nanoseconds, to be counted
+// as contended when profiling is enabled. Shorter waits are indistinguishable
+// from the cost of an uncontended acquire.
+#ifndef LOCK_DEP_CONTENTION_THRESHOLD_NS
+#define LOCK_DEP_CONTENTION_THRESHOLD_NS 250
+#endif
+
 // Id type used to identify each lock class.
 using LockClassId = uintptr_t;
 
@@ -82,6 +96,20 @@ using IfLockValidationEnabled = typename fbl::conditional<kLockValidationEnabled
                                                           EnabledType,
                                                           DisabledType>::type;
 
+// Whether or not lock contention profiling is globally enabled.
+constexpr bool kLockProfilingEnabled = static_cast<bool>(LOCK_DEP_ENABLE_PROFILING);
+static_assert(!kLockProfilingEnabled || kLockValidationEnabled,
+              "LOCK_DEP_ENABLE_PROFILING requires LOCK_DEP_ENABLE_VALIDATION!");
+
+constexpr uint64_t kLockContentionThresholdNs = LOCK_DEP_CONTENTION_THRESHOLD_NS;
+
+// Utility template alias to simplify selecting different types based whether
+// lock profiling is enabled or disabled.
+template <typename EnabledType, typename DisabledType>
+using IfLockProfilingEnabled = typename fbl::conditional<kLockProfilingEnabled,
+                                                         EnabledType,
+                                                         DisabledType>::type;
+
 // Result type that represents whether a lock attempt was successful, or if not
 // which check failed.
 enum class LockResult : uint8_t {
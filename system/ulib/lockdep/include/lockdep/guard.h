@@ -179,10 +179,13 @@ private:
     // body.
     void ValidateAndAcquire() __TA_NO_THREAD_SAFETY_ANALYSIS {
         validator_.ValidateAcquire();
+        Profiler profiler;
         if (!LockPolicy<LockType, Option>::Acquire(lock_, &state_)) {
             lock_ = nullptr;
             validator_.ValidateRelease();
+            return;
         }
+        profiler.Acquired(validator_.id(), __GET_CALLER(0));
     }
 
     // Ordered lock constructor used by the nestable lock constructor above and
@@ -207,6 +210,7 @@ private:
         void ValidateRelease() {
             ThreadLockState::Get()->Release(&lock_entry);
         }
+        LockClassId id() const { return lock_entry.id(); }
 
         AcquiredLockEntry lock_entry;
     };
@@ -216,8 +220,32 @@ private:
         DummyValidator(LockClassId, uintptr_t = 0) {}
         void ValidateAcquire() {}
         void ValidateRelease() {}
+        LockClassId id() const { return kInvalidLockClassId; }
     };
 
+    // Profiler type used when lock profiling is enabled. Times the acquire
+    // and charges the wait to the lock class.
+    struct LockProfiler {
+        LockProfiler()
+            : start{SystemGetLockProfileTimestamp()} {}
+
+        void Acquired(LockClassId id, void* caller_address) {
+            const uint64_t now = SystemGetLockProfileTimestamp();
+            LockClassState::Get(id)->RecordAcquire(now > start ? now - start : 0,
+                                                   caller_address);
+        }
+
+        const uint64_t start;
+    };
+
+    // Profiler type used when lock profiling is disabled.
+    struct DummyProfiler {
+        void Acquired(LockClassId, void*) {}
+    };
+
+    // Alias of the configured profiler.
+    using Profiler = IfLockProfilingEnabled<LockProfiler, DummyProfiler>;
+
     // Alias of the configured validator.
     using Validator = IfLockValidationEnabled<LockValidator, DummyValidator>;
 
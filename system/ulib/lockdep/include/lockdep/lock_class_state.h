@@ -149,6 +149,97 @@ public:
         loop_node_.Reset();
     }
 
+    // The number of distinct call sites each lock class tracks contention for.
+    static constexpr size_t kMaxProfileCallSites = 8;
+
+    // Contention statistics for a call site that waited for this lock class.
+    struct ProfileCallSite {
+        fbl::atomic<uintptr_t> address{0};
+        fbl::atomic<uint64_t> contended{0};
+        fbl::atomic<uint64_t> wait_ns{0};
+    };
+
+    // Contention statistics for the lock class. Only updated when lock
+    // profiling is enabled.
+    struct Profile {
+        fbl::atomic<uint64_t> acquisitions{0};
+        fbl::atomic<uint64_t> contended{0};
+        fbl::atomic<uint64_t> wait_ns{0};
+        fbl::atomic<uint64_t> max_wait_ns{0};
+
+        // The first call sites seen waiting for the lock, followed by the
+        // totals of those that did not fit.
+        ProfileCallSite call_sites[kMaxProfileCallSites];
+        fbl::atomic<uint64_t> other_contended{0};
+        fbl::atomic<uint64_t> other_wait_ns{0};
+    };
+
+    // Records an acquisition of this lock class that waited |wait_ns| for the
+    // lock, from |caller_address|. Waits shorter than the contention threshold
+    // only count as acquisitions.
+    void RecordAcquire(uint64_t wait_ns, void* caller_address) {
+        profile_.acquisitions.fetch_add(1, fbl::memory_order_relaxed);
+        if (wait_ns < kLockContentionThresholdNs)
+            return;
+
+        profile_.contended.fetch_add(1, fbl::memory_order_relaxed);
+        profile_.wait_ns.fetch_add(wait_ns, fbl::memory_order_relaxed);
+
+        uint64_t max = profile_.max_wait_ns.load(fbl::memory_order_relaxed);
+        while (wait_ns > max &&
+               !profile_.max_wait_ns.compare_exchange_weak(&max, wait_ns,
+                                                           fbl::memory_order_relaxed,
+                                                           fbl::memory_order_relaxed)) {
+        }
+
+        const uintptr_t address = reinterpret_cast<uintptr_t>(caller_address);
+        ProfileCallSite* site = nullptr;
+        for (ProfileCallSite& entry : profile_.call_sites) {
+            uintptr_t current = entry.address.load(fbl::memory_order_relaxed);
+            if (current == 0) {
+                // Claim the free slot unless another waiter beat us to it.
+                entry.address.compare_exchange_strong(&current, address,
+                                                      fbl::memory_order_relaxed,
+                                                      fbl::memory_order_relaxed);
+                if (current == 0)
+                    current = address;
+            }
+            if (current == address) {
+                site = &entry;
+                break;
+            }
+        }
+
+        if (site != nullptr) {
+            site->contended.fetch_add(1, fbl::memory_order_relaxed);
+            site->wait_ns.fetch_add(wait_ns, fbl::memory_order_relaxed);
+        } else {
+            profile_.other_contended.fetch_add(1, fbl::memory_order_relaxed);
+            profile_.other_wait_ns.fetch_add(wait_ns, fbl::memory_order_relaxed);
+        }
+
+        SystemLockContended(this, wait_ns, caller_address);
+    }
+
+    // Returns the contention statistics for this lock class.
+    const Profile& profile() const { return profile_; }
+
+    // Clears the contention statistics for this lock class. Acquisitions that
+    // race with the reset may be partially counted.
+    void ResetProfile() {
+        profile_.acquisitions.store(0, fbl::memory_order_relaxed);
+        profile_.contended.store(0, fbl::memory_order_relaxed);
+        profile_.wait_ns.store(0, fbl::memory_order_relaxed);
+        profile_.max_wait_ns.store(0, fbl::memory_order_relaxed);
+        for (ProfileCallSite& entry : profile_.call_sites) {
+            entry.address.store(0, fbl::memory_order_relaxed);
+            entry.contended.store(0, fbl::memory_order_relaxed);
+            entry.wait_ns.store(0, fbl::memory_order_relaxed);
+        }
+        profile_.other_contended.store(0, fbl::memory_order_relaxed);
+        profile_.other_wait_ns.store(0, fbl::memory_order_relaxed);
+    }
+
 private:
     // The name of the lock class type.
     const char* const name_;
@@ -231,6 +322,9 @@ private:
     // Loop detector node.
     LoopNode loop_node_;
 
+    // Contention statistics, see RecordAcquire().
+    Profile profile_;
+
     // Loop detection using Tarjan's strongly connected components algorithm to
     // efficiently identify loops and disjoint set structures to store and
     // update the sets of nodes involved in loops.
@@ -54,4 +54,15 @@ extern void SystemInitThreadLockState(ThreadLockState* state);
 // given time interval.
 extern void SystemTriggerLoopDetection();
 
+// System-defined hook that returns a monotonic timestamp in nanoseconds. Only
+// required when lock profiling is enabled.
+extern uint64_t SystemGetLockProfileTimestamp();
+
+// System-defined hook to report a contended acquisition of |lock_class| that
+// waited |wait_ns| nanoseconds, from |caller_address|. Only
+// required when lock profiling is enabled. Must not acquire any instrumented
+// locks.
+extern void SystemLockContended(LockClassState* lock_class, uint64_t wait_ns,
+                                void* caller_address);
+
 } // namespace lockdep
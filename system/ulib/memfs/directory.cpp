@@ -313,6 +313,26 @@ zx_status_t VnodeDir::CreateFromVmo(fbl::StringPiece name,
     return ZX_OK;
 }
 
+zx_status_t VnodeDir::CreateFromVmoMaker(fbl::StringPiece name, zx_off_t len,
+                                         VmoMaker maker) {
+    zx_status_t status;
+    if ((status = CanCreate(name)) != ZX_OK) {
+        return status;
+    }
+
+    fbl::AllocChecker ac;
+    fbl::RefPtr<VnodeMemfs> vn;
+    vn = fbl::AdoptRef(new (&ac) VnodeVmo(vfs(), len, fbl::move(maker)));
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    if ((status = AttachVnode(fbl::move(vn), name, false)) != ZX_OK) {
+        return status;
+    }
+
+    return ZX_OK;
+}
+
 zx_status_t VnodeDir::CanCreate(fbl::StringPiece name) const {
     if (!IsDirectory()) {
         return ZX_ERR_INVALID_ARGS;
@@ -18,6 +18,7 @@
 #include <fs/vfs.h>
 #include <fs/vnode.h>
 #include <fbl/atomic.h>
+#include <fbl/function.h>
 #include <fbl/intrusive_double_list.h>
 #include <fbl/ref_ptr.h>
 #include <fbl/unique_ptr.h>
@@ -32,6 +33,9 @@ constexpr uint64_t kMemfsBlksize = PAGE_SIZE;
 class Dnode;
 class Vfs;
 
+// Makes the VMO holding a file's contents the first time they're needed.
+using VmoMaker = fbl::Function<zx_status_t(zx_handle_t* out_vmo)>;
+
 class VnodeMemfs : public fs::Vnode {
 public:
     virtual zx_status_t Setattr(const vnattr_t* a) final;
@@ -117,6 +121,11 @@ public:
     zx_status_t CreateFromVmo(fbl::StringPiece name, zx_handle_t vmo,
                               zx_off_t off, zx_off_t len);
 
+    // Create a vnode of |len| bytes whose VMO is made by |maker| the first
+    // time the file is read or its VMO handed out.
+    // Fails if the vnode already exists.
+    zx_status_t CreateFromVmoMaker(fbl::StringPiece name, zx_off_t len, VmoMaker maker);
+
     // Mount a subtree as a child of this directory.
     void MountSubtree(fbl::RefPtr<VnodeDir> subtree);
 
@@ -161,6 +170,7 @@ private:
 class VnodeVmo final : public VnodeMemfs {
 public:
     VnodeVmo(Vfs* vfs, zx_handle_t vmo, zx_off_t offset, zx_off_t length);
+    VnodeVmo(Vfs* vfs, zx_off_t length, VmoMaker maker);
     ~VnodeVmo() override;
 
     virtual zx_status_t ValidateFlags(uint32_t flags) override;
@@ -172,10 +182,14 @@ private:
     zx_status_t GetHandles(uint32_t flags, zx_handle_t* hnd, uint32_t* type,
                            zxrio_node_info_t* extra) final;
 
+    // Makes |vmo_| if it was left to |maker_|.
+    zx_status_t MakeVmo();
+
     zx_handle_t vmo_;
     zx_off_t offset_;
     zx_off_t length_;
     bool have_local_clone_;
+    VmoMaker maker_;
 };
 
 class Vfs : public fs::ManagedVfs {
@@ -194,6 +208,13 @@ public:
                               zx_handle_t vmo, zx_off_t off,
                               zx_off_t len);
 
+    // Creates a VnodeVmo under |parent| with |name| of |len| bytes, whose
+    // VMO is made by |maker| once it's first needed.
+    // N.B. As with CreateFromVmo, the VMO is not counted against the
+    // pages limit.
+    zx_status_t CreateFromVmoMaker(VnodeDir* parent, fbl::StringPiece name,
+                                   zx_off_t len, VmoMaker maker);
+
     void MountSubtree(VnodeDir* parent, fbl::RefPtr<VnodeDir> subtree);
 
     size_t PagesLimit() const { return pages_limit_; }
@@ -214,7 +235,8 @@ private:
     // using GrowVMO and WillFreeVMO.
     friend VnodeFile;
 
-    // Increases the size of the |vmo| to at least |request_size| bytes.
+    // Increases the size of the |vmo| to at least |request_size| bytes,
+    // leaving room for the file to grow further where the pages limit allows.
     // If the VMO is invalid, it will try to create it.
     // |current_size| is the current size of the VMO in number of bytes. It should be
     // a multiple of page size. The new size of the VMO is returned via |actual_size|.
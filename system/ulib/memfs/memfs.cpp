@@ -29,6 +29,9 @@ namespace {
 
 constexpr size_t kPageSize = static_cast<size_t>(PAGE_SIZE);
 
+// The most room a VMO is given to grow into beyond the size requested.
+constexpr size_t kMaxVmoGrowth = 8 * 1024 * 1024;
+
 }
 
 namespace memfs {
@@ -40,6 +43,12 @@ zx_status_t Vfs::CreateFromVmo(VnodeDir* parent, fbl::StringPiece name,
     return parent->CreateFromVmo(name, vmo, off, len);
 }
 
+zx_status_t Vfs::CreateFromVmoMaker(VnodeDir* parent, fbl::StringPiece name,
+                                    zx_off_t len, VmoMaker maker) {
+    fbl::AutoLock lock(&vfs_lock_);
+    return parent->CreateFromVmoMaker(name, len, fbl::move(maker));
+}
+
 void Vfs::MountSubtree(VnodeDir* parent, fbl::RefPtr<VnodeDir> subtree) {
     fbl::AutoLock lock(&vfs_lock_);
     parent->MountSubtree(fbl::move(subtree));
@@ -72,6 +81,16 @@ zx_status_t Vfs::GrowVMO(zx::vmo& vmo, size_t current_size,
     }
     size_t aligned_len = fbl::round_up(request_size, kPageSize);
     ZX_DEBUG_ASSERT(current_size % kPageSize == 0);
+
+    // Files which are extended a little at a time, such as by appends, grow
+    // geometrically so that their VMOs aren't resized on every write. The
+    // extra room is only taken when it fits within the pages limit.
+    size_t geometric_len = current_size + fbl::min(current_size, kMaxVmoGrowth);
+    if (geometric_len > aligned_len &&
+        (geometric_len - current_size) / kPageSize + num_allocated_pages_ <= pages_limit_) {
+        aligned_len = geometric_len;
+    }
+
     size_t num_new_pages = (aligned_len - current_size) / kPageSize;
     if (num_new_pages + num_allocated_pages_ > pages_limit_) {
         *actual_size = current_size;
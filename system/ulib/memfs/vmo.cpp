@@ -38,12 +38,30 @@ bool WindowMatchesVMO(zx_handle_t vmo, zx_off_t offset, zx_off_t length) {
 VnodeVmo::VnodeVmo(Vfs* vfs, zx_handle_t vmo, zx_off_t offset, zx_off_t length)
     : VnodeMemfs(vfs), vmo_(vmo), offset_(offset), length_(length), have_local_clone_(false) {}
 
+VnodeVmo::VnodeVmo(Vfs* vfs, zx_off_t length, VmoMaker maker)
+    : VnodeMemfs(vfs), vmo_(ZX_HANDLE_INVALID), offset_(0), length_(length),
+      have_local_clone_(false), maker_(fbl::move(maker)) {}
+
 VnodeVmo::~VnodeVmo() {
     if (have_local_clone_) {
         zx_handle_close(vmo_);
     }
 }
 
+zx_status_t VnodeVmo::MakeVmo() {
+    if (!maker_) {
+        return ZX_OK;
+    }
+    zx_status_t status = maker_(&vmo_);
+    if (status != ZX_OK) {
+        return status;
+    }
+    // The VMO is ours alone, like a local clone.
+    have_local_clone_ = true;
+    maker_ = nullptr;
+    return ZX_OK;
+}
+
 zx_status_t VnodeVmo::ValidateFlags(uint32_t flags) {
     if (flags & ZX_FS_FLAG_DIRECTORY) {
         return ZX_ERR_NOT_DIR;
@@ -62,7 +80,10 @@ zx_status_t VnodeVmo::GetHandles(uint32_t flags, zx_handle_t* hnd, uint32_t* typ
                                  zxrio_node_info_t* extra) {
     zx_off_t* off = &extra->vmofile.offset;
     zx_off_t* len = &extra->vmofile.length;
-    zx_status_t status;
+    zx_status_t status = MakeVmo();
+    if (status != ZX_OK) {
+        return status;
+    }
     if (!have_local_clone_ && !WindowMatchesVMO(vmo_, offset_, length_)) {
         status = zx_vmo_clone(vmo_, ZX_VMO_CLONE_COPY_ON_WRITE, offset_, length_, &vmo_);
         if (status < 0)
@@ -104,7 +125,11 @@ zx_status_t VnodeVmo::Read(void* data, size_t len, size_t off, size_t* out_actua
     if (len > rlen) {
         len = rlen;
     }
-    zx_status_t status = zx_vmo_read(vmo_, data, offset_ + off, len);
+    zx_status_t status = MakeVmo();
+    if (status != ZX_OK) {
+        return status;
+    }
+    status = zx_vmo_read(vmo_, data, offset_ + off, len);
     if (status == ZX_OK) {
         *out_actual = len;
     }
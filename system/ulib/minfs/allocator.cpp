@@ -35,6 +35,12 @@ size_t AllocatorPromise::Allocate(WriteTxn* txn) {
     return allocator_->Allocate(txn);
 }
 
+void AllocatorPromise::Merge(fbl::unique_ptr<AllocatorPromise> other) {
+    ZX_DEBUG_ASSERT(other->allocator_ == allocator_);
+    reserved_ += other->reserved_;
+    other->reserved_ = 0;
+}
+
 AllocatorFvmMetadata::AllocatorFvmMetadata() = default;
 AllocatorFvmMetadata::AllocatorFvmMetadata(uint32_t* data_slices,
                                            uint32_t* metadata_slices,
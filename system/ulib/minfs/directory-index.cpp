@@ -0,0 +1,73 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <fbl/algorithm.h>
+#include <fbl/alloc_checker.h>
+#include <lib/zircon-internal/fnv1hash.h>
+#include <zircon/assert.h>
+
+#include <minfs/directory-index.h>
+
+namespace minfs {
+
+DirectoryIndex::DirectoryIndex() {
+    for (auto& hint : space_hints_) {
+        hint = 0;
+    }
+}
+
+DirectoryIndex::~DirectoryIndex() = default;
+
+uint64_t DirectoryIndex::Hash(fbl::StringPiece name) {
+    return fnv1a64(name.data(), name.length());
+}
+
+zx_status_t DirectoryIndex::Insert(fbl::StringPiece name, size_t off) {
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<Entry> entry(new (&ac) Entry());
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    entry->hash = Hash(name);
+    entry->off = off;
+    if (!entries_.insert_or_find(fbl::move(entry))) {
+        return ZX_ERR_ALREADY_EXISTS;
+    }
+    return ZX_OK;
+}
+
+void DirectoryIndex::Erase(fbl::StringPiece name) {
+    entries_.erase(Hash(name));
+}
+
+bool DirectoryIndex::Find(fbl::StringPiece name, size_t* off) const {
+    auto iter = entries_.find(Hash(name));
+    if (!iter.IsValid()) {
+        return false;
+    }
+    *off = iter->off;
+    return true;
+}
+
+size_t DirectoryIndex::SpaceHint(uint32_t reclen) const {
+    ZX_DEBUG_ASSERT(reclen / 4 < kSpaceHints);
+    return space_hints_[reclen / 4];
+}
+
+void DirectoryIndex::FoundSpace(uint32_t reclen, size_t off) {
+    ZX_DEBUG_ASSERT(off < kMinfsMaxDirectorySize);
+    // Nothing before |off| had room for |reclen| bytes, so it had no room for
+    // any longer record either.
+    for (size_t i = reclen / 4; i < kSpaceHints; i++) {
+        space_hints_[i] = fbl::max(space_hints_[i], static_cast<uint32_t>(off));
+    }
+}
+
+void DirectoryIndex::FreedSpace(size_t off) {
+    for (auto& hint : space_hints_) {
+        hint = fbl::min(hint, static_cast<uint32_t>(off));
+    }
+}
+
+} // namespace minfs
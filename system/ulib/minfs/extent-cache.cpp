@@ -0,0 +1,104 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <fbl/alloc_checker.h>
+#include <zircon/assert.h>
+
+#include <minfs/extent-cache.h>
+
+namespace minfs {
+
+ExtentCache::~ExtentCache() = default;
+
+ExtentCache::ExtentTree::iterator ExtentCache::Preceding(blk_t n) {
+    auto iter = extents_.upper_bound(n);
+    if (!extents_.is_empty()) {
+        --iter;
+    }
+    return iter;
+}
+
+ExtentCache::ExtentTree::const_iterator ExtentCache::Preceding(blk_t n) const {
+    auto iter = extents_.upper_bound(n);
+    if (!extents_.is_empty()) {
+        --iter;
+    }
+    return iter;
+}
+
+void ExtentCache::Insert(blk_t n, blk_t bno) {
+    ZX_DEBUG_ASSERT(bno != 0);
+    auto prev = Preceding(n);
+    Extent* before = prev.IsValid() ? &*prev : nullptr;
+    if (before != nullptr && n < before->start + before->length) {
+        ZX_DEBUG_ASSERT_MSG(before->bno + (n - before->start) == bno, "File block moved");
+        return;
+    }
+
+    auto next = extents_.upper_bound(n);
+    Extent* after = nullptr;
+    if (next.IsValid() && next->start == n + 1 && next->bno == bno + 1) {
+        after = &*next;
+    }
+
+    if (before != nullptr && before->start + before->length == n &&
+        before->bno + before->length == bno) {
+        before->length++;
+        if (after != nullptr) {
+            before->length += after->length;
+            extents_.erase(*after);
+        }
+        return;
+    }
+
+    fbl::unique_ptr<Extent> extent;
+    if (after != nullptr) {
+        // The extent's key moves back by one block, so it is reinserted.
+        extent = extents_.erase(*after);
+        extent->length++;
+    } else {
+        if (extents_.size() >= kMaxExtents) {
+            Reset();
+        }
+        fbl::AllocChecker ac;
+        extent.reset(new (&ac) Extent());
+        if (!ac.check()) {
+            // The cache is only an optimization.
+            return;
+        }
+        extent->length = 1;
+    }
+    extent->start = n;
+    extent->bno = bno;
+    extents_.insert(fbl::move(extent));
+}
+
+bool ExtentCache::Find(blk_t n, blk_t* bno) const {
+    blk_t count;
+    return FindExtent(n, bno, &count);
+}
+
+bool ExtentCache::FindExtent(blk_t n, blk_t* bno, blk_t* count) const {
+    auto iter = Preceding(n);
+    if (!iter.IsValid() || n >= iter->start + iter->length) {
+        return false;
+    }
+    *bno = iter->bno + (n - iter->start);
+    *count = iter->length - (n - iter->start);
+    return true;
+}
+
+void ExtentCache::Truncate(blk_t start) {
+    while (!extents_.is_empty() && extents_.back().start >= start) {
+        extents_.pop_back();
+    }
+    if (!extents_.is_empty()) {
+        Extent& last = extents_.back();
+        if (last.start + last.length > start) {
+            last.length = start - last.start;
+        }
+    }
+}
+
+} // namespace minfs
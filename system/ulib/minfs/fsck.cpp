@@ -7,6 +7,7 @@
 #include <string.h>
 #include <unistd.h>
 
+#include <fbl/algorithm.h>
 #include <minfs/format.h>
 #include <minfs/fsck.h>
 #include "minfs-private.h"
@@ -516,18 +517,36 @@ zx_status_t MinfsChecker::CheckUnlinkedInodes() {
     return ZX_OK;
 }
 
-zx_status_t MinfsChecker::CheckForUnusedBlocks() const {
-    unsigned missing = 0;
-
-    for (unsigned n = 0; n < fs_->Info().block_count; n++) {
-        if (fs_->block_allocator_->map_.Get(n, n + 1)) {
-            if (!checked_blocks_.Get(n, n + 1)) {
-                missing++;
-            }
+namespace {
+
+// Counts the bits in [0, count) which are set in |allocated| but not in
+// |checked|, a word at a time.
+size_t CountUnchecked(const RawBitmap& allocated, const RawBitmap& checked, size_t count) {
+    count = fbl::min(count, fbl::min(allocated.size(), checked.size()));
+    if (count == 0) {
+        return 0;
+    }
+    const size_t* alloc_words = static_cast<const size_t*>(allocated.StorageUnsafe()->GetData());
+    const size_t* checked_words = static_cast<const size_t*>(checked.StorageUnsafe()->GetData());
+    size_t last = bitmap::LastIdx(count);
+    size_t missing = 0;
+    for (size_t i = 0; i <= last; i++) {
+        size_t unchecked = alloc_words[i] & ~checked_words[i];
+        if (i == last && count % bitmap::kBits != 0) {
+            unchecked &= (size_t(1) << (count % bitmap::kBits)) - 1;
         }
+        missing += __builtin_popcountl(unchecked);
     }
+    return missing;
+}
+
+} // namespace
+
+zx_status_t MinfsChecker::CheckForUnusedBlocks() const {
+    size_t missing = CountUnchecked(fs_->block_allocator_->map_, checked_blocks_,
+                                    fs_->Info().block_count);
     if (missing) {
-        FS_TRACE_ERROR("check: %u allocated block%s not in use\n",
+        FS_TRACE_ERROR("check: %zu allocated block%s not in use\n",
               missing, missing > 1 ? "s" : "");
         return ZX_ERR_BAD_STATE;
     }
@@ -535,16 +554,10 @@ zx_status_t MinfsChecker::CheckForUnusedBlocks() const {
 }
 
 zx_status_t MinfsChecker::CheckForUnusedInodes() const {
-    unsigned missing = 0;
-    for (unsigned n = 0; n < fs_->Info().inode_count; n++) {
-        if (fs_->inodes_->inode_allocator_->map_.Get(n, n + 1)) {
-            if (!checked_inodes_.Get(n, n + 1)) {
-                missing++;
-            }
-        }
-    }
+    size_t missing = CountUnchecked(fs_->inodes_->inode_allocator_->map_, checked_inodes_,
+                                    fs_->Info().inode_count);
     if (missing) {
-        FS_TRACE_ERROR("check: %u allocated inode%s not in use\n",
+        FS_TRACE_ERROR("check: %zu allocated inode%s not in use\n",
               missing, missing > 1 ? "s" : "");
         return ZX_ERR_BAD_STATE;
     }
@@ -628,6 +641,16 @@ zx_status_t Fsck(fbl::unique_ptr<Bcache> bc) {
         FS_TRACE_ERROR("Fsck: check_info failure: %d\n", status);
         return status;
     }
+    bool journal_pending;
+    if ((status = CheckJournal(bc.get(), info, &journal_pending)) != ZX_OK) {
+        FS_TRACE_ERROR("Fsck: CheckJournal failure: %d\n", status);
+        return status;
+    }
+    if (journal_pending) {
+        // Mounting the volume replays the journal; until then, the blocks it
+        // holds may not agree with the rest of the volume.
+        FS_TRACE_WARN("Fsck: journal holds an entry which hasn't been replayed\n");
+    }
 
     MinfsChecker chk;
     if ((status = chk.Init(fbl::move(bc), info)) != ZX_OK) {
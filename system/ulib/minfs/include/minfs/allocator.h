@@ -40,6 +40,12 @@ public:
 
     // Allocate a new item in allocator_. Return the index of the newly allocated item.
     size_t Allocate(WriteTxn* txn);
+
+    // Takes over the elements reserved by |other|, which must be a promise from the same
+    // allocator.
+    void Merge(fbl::unique_ptr<AllocatorPromise> other);
+
+    size_t GetReserved() const { return reserved_; }
 private:
     friend class Allocator;
 
@@ -46,7 +46,8 @@ public:
     // over the block I/O FIFO.
     groupid_t BlockGroupID() final {
         thread_local groupid_t group_ = next_group_.fetch_add(1);
-        ZX_ASSERT_MSG(group_ < MAX_TXN_GROUP_COUNT, "Too many threads accessing block device");
+        ZX_ASSERT_MSG(group_ < fifo_client_.GroupCount(),
+                      "Too many threads accessing block device");
         return group_;
     }
 
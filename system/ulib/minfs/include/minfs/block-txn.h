@@ -21,6 +21,8 @@ struct WriteRequest {
     size_t vmo_offset;
     size_t dev_offset;
     size_t length;
+    // Set for file data, which is written in place without being journaled.
+    bool data;
 };
 
 // A transaction consisting of enqueued VMOs to be written
@@ -38,7 +40,16 @@ public:
     }
 
     // Identify that a block should be written to disk at a later point in time.
-    void Enqueue(zx_handle_t vmo, uint64_t vmo_offset, uint64_t dev_offset, uint64_t nblocks);
+    void Enqueue(zx_handle_t vmo, uint64_t vmo_offset, uint64_t dev_offset, uint64_t nblocks) {
+        EnqueueRequest(vmo, vmo_offset, dev_offset, nblocks, false);
+    }
+
+    // Identify that a block of file data should be written to disk at a later
+    // point in time. Unlike metadata, file data is not journaled.
+    void EnqueueData(zx_handle_t vmo, uint64_t vmo_offset, uint64_t dev_offset,
+                     uint64_t nblocks) {
+        EnqueueRequest(vmo, vmo_offset, dev_offset, nblocks, true);
+    }
 
     fbl::Vector<WriteRequest>& Requests() { return requests_; }
 
@@ -51,7 +62,14 @@ protected:
     // transactions should be all reading from a single in-memory buffer.
     zx_status_t Flush(zx_handle_t vmo, vmoid_t vmoid);
 
+    // Writes out only the requests for file data (if |data|) or for metadata,
+    // leaving every request in the transaction.
+    zx_status_t Send(vmoid_t vmoid, bool data);
+
 private:
+    void EnqueueRequest(zx_handle_t vmo, uint64_t vmo_offset, uint64_t dev_offset,
+                        uint64_t nblocks, bool data);
+
     Bcache* bc_;
     fbl::Vector<WriteRequest> requests_;
 };
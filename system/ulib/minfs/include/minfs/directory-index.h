@@ -0,0 +1,94 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// This file describes an in-memory index of the entries of a directory.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <fbl/intrusive_wavl_tree.h>
+#include <fbl/macros.h>
+#include <fbl/string_piece.h>
+#include <fbl/unique_ptr.h>
+#include <zircon/types.h>
+
+#include <minfs/format.h>
+
+namespace minfs {
+
+// DirectoryIndex maps the names within a large directory to the offsets of
+// their dirents, so that a name is found without reading every dirent before
+// it. It also remembers where searches for free space ended, so that new
+// dirents are placed without rereading the full records at the start of the
+// directory.
+//
+// The index is built from the directory's dirents the first time the
+// directory is searched, and lasts as long as the directory's vnode. Nothing
+// about it is stored on disk.
+//
+// Names are indexed by a 64-bit hash. If two names in one directory share a
+// hash, the second can't be indexed, and the directory falls back to being
+// searched linearly.
+//
+// This class is thread-compatible.
+class DirectoryIndex {
+public:
+    // Directories with fewer dirents than this are searched linearly.
+    static constexpr uint32_t kMinDirents = 128;
+
+    DirectoryIndex();
+    ~DirectoryIndex();
+
+    // Records that the dirent for |name| is at offset |off|. Fails with
+    // ZX_ERR_ALREADY_EXISTS if a name with the same hash is already indexed.
+    zx_status_t Insert(fbl::StringPiece name, size_t off);
+
+    // Forgets the dirent for |name|, if it is indexed.
+    void Erase(fbl::StringPiece name);
+
+    // Returns true and sets |*off| to the offset of the only dirent which may
+    // hold |name|. Returns false if the directory doesn't hold |name|.
+    bool Find(fbl::StringPiece name, size_t* off) const;
+
+    // Returns the offset of a dirent, no dirent before which has room for a
+    // new record of |reclen| bytes.
+    size_t SpaceHint(uint32_t reclen) const;
+
+    // Records that the first room for a record of |reclen| bytes was found
+    // in the dirent at |off|.
+    void FoundSpace(uint32_t reclen, size_t off);
+
+    // Records that a free record now starts at |off|.
+    void FreedSpace(size_t off);
+
+private:
+    DISALLOW_COPY_ASSIGN_AND_MOVE(DirectoryIndex);
+
+    struct Entry {
+        uint64_t hash;
+        size_t off;
+        fbl::WAVLTreeNodeState<fbl::unique_ptr<Entry>> node;
+    };
+
+    struct EntryTraits {
+        static uint64_t GetKey(const Entry& e) { return e.hash; }
+        static bool LessThan(uint64_t k1, uint64_t k2) { return k1 < k2; }
+        static bool EqualTo(uint64_t k1, uint64_t k2) { return k1 == k2; }
+        static fbl::WAVLTreeNodeState<fbl::unique_ptr<Entry>>& node_state(Entry& e) {
+            return e.node;
+        }
+    };
+
+    static uint64_t Hash(fbl::StringPiece name);
+
+    // Record lengths are multiples of 4 bytes, so each is tracked by
+    // |reclen| / 4.
+    static constexpr size_t kSpaceHints = kMinfsMaxDirentSize / 4 + 1;
+
+    fbl::WAVLTree<uint64_t, fbl::unique_ptr<Entry>, EntryTraits, EntryTraits> entries_;
+    uint32_t space_hints_[kSpaceHints];
+};
+
+} // namespace minfs
@@ -0,0 +1,87 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// This file describes an in-memory cache of the block mappings of a file.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <fbl/intrusive_wavl_tree.h>
+#include <fbl/macros.h>
+#include <fbl/unique_ptr.h>
+#include <zircon/types.h>
+
+#include <minfs/format.h>
+
+namespace minfs {
+
+// ExtentCache remembers which runs of a file's blocks are stored in runs of
+// consecutive data blocks, so that a file block is mapped to its data block
+// without walking the inode's indirect and doubly indirect blocks.
+//
+// Only allocated blocks are cached; a file block which isn't cached may be
+// unallocated, or may simply not have been looked up yet. The owner must
+// forget the blocks of a file which are freed.
+//
+// This class is thread-compatible.
+class ExtentCache {
+public:
+    // Extents beyond this are not cached; a file which fragmented is mapped
+    // through its inode instead.
+    static constexpr size_t kMaxExtents = 1024;
+
+    ExtentCache() = default;
+    ~ExtentCache();
+
+    // Records that file block |n| is stored in data block |bno|, extending
+    // the extents which border it where possible.
+    void Insert(blk_t n, blk_t bno);
+
+    // Returns true and sets |*bno| to the data block holding file block |n|,
+    // if it is cached.
+    bool Find(blk_t n, blk_t* bno) const;
+
+    // Sets |*count| to the number of file blocks from |n| onward which are
+    // cached as consecutive data blocks starting at |*bno|. Returns false if
+    // |n| isn't cached.
+    bool FindExtent(blk_t n, blk_t* bno, blk_t* count) const;
+
+    // Forgets file blocks |start| onward.
+    void Truncate(blk_t start);
+
+    // Forgets every file block.
+    void Reset() { extents_.clear(); }
+
+    size_t ExtentCount() const { return extents_.size(); }
+
+private:
+    DISALLOW_COPY_ASSIGN_AND_MOVE(ExtentCache);
+
+    struct Extent {
+        blk_t start;
+        blk_t bno;
+        blk_t length;
+        fbl::WAVLTreeNodeState<fbl::unique_ptr<Extent>> node;
+    };
+
+    struct ExtentTraits {
+        static blk_t GetKey(const Extent& e) { return e.start; }
+        static bool LessThan(blk_t k1, blk_t k2) { return k1 < k2; }
+        static bool EqualTo(blk_t k1, blk_t k2) { return k1 == k2; }
+        static fbl::WAVLTreeNodeState<fbl::unique_ptr<Extent>>& node_state(Extent& e) {
+            return e.node;
+        }
+    };
+
+    using ExtentTree = fbl::WAVLTree<blk_t, fbl::unique_ptr<Extent>, ExtentTraits, ExtentTraits>;
+
+    // Returns the extent starting at or before |n|, if there is one.
+    ExtentTree::iterator Preceding(blk_t n);
+    ExtentTree::const_iterator Preceding(blk_t n) const;
+
+    ExtentTree extents_;
+};
+
+} // namespace minfs
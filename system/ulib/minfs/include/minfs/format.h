@@ -33,7 +33,10 @@ typedef uint32_t ino_t;
 
 constexpr uint64_t kMinfsMagic0         = (0x002153466e694d21ULL);
 constexpr uint64_t kMinfsMagic1         = (0x385000d3d3d3d304ULL);
-constexpr uint32_t kMinfsVersion        = 0x00000006;
+constexpr uint32_t kMinfsVersion        = 0x00000007;
+// Volumes made before the journal was added are still mounted, without one;
+// the journal fields of their superblocks are always zero.
+constexpr uint32_t kMinfsVersionNoJournal = 0x00000006;
 
 constexpr ino_t    kMinfsRootIno        = 1;
 constexpr uint32_t kMinfsFlagClean      = 0x00000001; // Currently unused
@@ -79,6 +82,17 @@ constexpr size_t kMinfsMinimumSlices = 5;
 
 constexpr uint64_t kMinfsDefaultInodeCount = 32768;
 
+// The journal follows the superblock. On FVM, it shares the superblock's slice.
+constexpr blk_t    kMinfsJournalStart          = 1;
+constexpr uint32_t kMinfsDefaultJournalBlocks  = 256;
+// Smaller journals are not created; the volume is then written without one.
+constexpr uint32_t kMinfsMinimumJournalBlocks  = 8;
+constexpr uint64_t kMinfsJournalHeaderMagic    = (0x6c6e726a53466e4dULL);
+constexpr uint64_t kMinfsJournalCommitMagic    = (0x74696d6d6f63534dULL);
+// Each journal entry is a header block, followed by the blocks of metadata it
+// holds, followed by a commit block.
+constexpr uint32_t kMinfsJournalEntryOverhead  = 2;
+
 struct Superblock {
     uint64_t magic0;
     uint64_t magic1;
@@ -104,6 +118,9 @@ struct Superblock {
 
     ino_t unlinked_head;    // Index to the first unlinked (but open) inode.
     ino_t unlinked_tail;    // Index to the last unlinked (but open) inode.
+
+    blk_t jnl_block;        // first blockno of the metadata journal
+    uint32_t jnl_block_count; // blocks in the journal, or zero if there is none
 };
 
 static_assert(sizeof(Superblock) <= kMinfsBlockSize,
@@ -121,6 +138,32 @@ static_assert(sizeof(Superblock) <= kMinfsBlockSize,
 //     ino_block + ino / kMinfsInodesPerBlock
 //   at offset: ino % kMinfsInodesPerBlock
 // - inode 0 is never used, should be marked allocated but ignored
+// - the journal holds two entries, each in one half of its blocks; entries
+//   alternate between the halves, and only the newest complete entry is
+//   replayed
+
+constexpr uint32_t kMinfsJournalMaxEntryBlocks = (kMinfsBlockSize - 24) / sizeof(blk_t);
+
+struct JournalHeader {
+    uint64_t magic;         // kMinfsJournalHeaderMagic
+    uint64_t sequence;      // bumped for each entry
+    uint32_t block_count;   // number of metadata blocks in the entry
+    uint32_t reserved;
+    blk_t target[kMinfsJournalMaxEntryBlocks]; // where each block belongs
+};
+
+static_assert(sizeof(JournalHeader) == kMinfsBlockSize,
+              "minfs journal header size is wrong");
+
+struct JournalCommit {
+    uint64_t magic;         // kMinfsJournalCommitMagic
+    uint64_t sequence;      // matches the header
+    uint32_t checksum;      // crc32 of the header and metadata blocks
+    uint32_t reserved;
+};
+
+static_assert(sizeof(JournalCommit) <= kMinfsBlockSize,
+              "minfs journal commit size is wrong");
 
 struct Inode {
     uint32_t magic;
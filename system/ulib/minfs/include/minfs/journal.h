@@ -0,0 +1,86 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// This file describes the journal of MinFS metadata updates.
+
+#pragma once
+
+#ifdef __Fuchsia__
+#include <lib/fzl/owned-vmo-mapper.h>
+#endif
+
+#include <fbl/macros.h>
+#include <fbl/unique_ptr.h>
+#include <fbl/vector.h>
+#include <zircon/types.h>
+
+#include <minfs/bcache.h>
+#include <minfs/block-txn.h>
+#include <minfs/format.h>
+
+namespace minfs {
+
+// Returns the number of blocks to give a new journal when at most |max_blocks|
+// are available, or zero if that is too few to hold one.
+uint32_t JournalBlocksFor(uint32_t max_blocks);
+
+// Writes the newest complete entry of the journal described by |info| over
+// the blocks it belongs to, if they don't already hold it, and then erases
+// the journal. This brings the volume to the state of its last journal commit.
+zx_status_t ReplayJournal(Bcache* bc, const Superblock* info);
+
+// Sets |*pending| if the journal described by |info| holds an entry which
+// hasn't been written in place. Nothing is written.
+zx_status_t CheckJournal(Bcache* bc, const Superblock* info, bool* pending);
+
+#ifdef __Fuchsia__
+
+// Journal writes groups of metadata updates to the journal of a volume before
+// they are written in place, so that a volume which stops part way through
+// writing them can be replayed to the state before or after the group, rather
+// than being left in between.
+//
+// Entries alternate between the two halves of the journal. The device is
+// flushed after each entry is written, which also makes the in-place writes
+// of the previous entry durable, so the half an entry overwrites is never
+// needed again.
+//
+// This class is thread-compatible; it is used by the writeback thread alone.
+class Journal {
+public:
+    DISALLOW_COPY_ASSIGN_AND_MOVE(Journal);
+
+    static zx_status_t Create(Bcache* bc, const Superblock* info, fbl::unique_ptr<Journal>* out);
+    ~Journal();
+
+    // The most blocks of metadata one entry holds.
+    size_t EntryCapacity() const { return half_blocks_ - kMinfsJournalEntryOverhead; }
+
+    // Writes the blocks of |requests|, whose vmo offsets are within |buffer|
+    // (attached to the device as |vmoid|), as one journal entry, and flushes
+    // the device. Once this returns ZX_OK, the blocks may be written in place.
+    //
+    // Requests too large for one entry aren't journaled; the journal is
+    // flushed and erased instead, so that nothing older is replayed over them.
+    zx_status_t Commit(const fbl::Vector<WriteRequest>& requests, const void* buffer,
+                       vmoid_t vmoid);
+
+private:
+    Journal(Bcache* bc, blk_t start, blk_t half_blocks, fzl::OwnedVmoMapper mapper);
+
+    // Flushes the device, and then erases both entries of the journal.
+    zx_status_t Erase();
+
+    Bcache* bc_;
+    const blk_t start_;
+    const blk_t half_blocks_;
+    uint64_t sequence_ = 1;
+    // Holds the header and commit blocks of the entry being written.
+    fzl::OwnedVmoMapper mapper_;
+    vmoid_t vmoid_ = VMOID_INVALID;
+};
+
+#endif // __Fuchsia__
+
+} // namespace minfs
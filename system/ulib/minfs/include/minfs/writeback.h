@@ -25,6 +25,7 @@
 #include <minfs/bcache.h>
 #include <minfs/block-txn.h>
 #include <minfs/format.h>
+#include <minfs/journal.h>
 
 namespace minfs {
 
@@ -53,6 +54,17 @@ public:
     // consumed.
     size_t Complete(zx_handle_t vmo, vmoid_t vmoid);
 
+    // Writes out the enqueued file data (if |data|) or metadata, leaving the
+    // work to be completed by |Finish|.
+    zx_status_t Write(vmoid_t vmoid, bool data) { return Send(vmoid, data); }
+
+    // Signals the closure with |status|, once the enqueued work has been
+    // written by |Write|, and resets the WritebackWork to its initial state.
+    //
+    // Returns the number of blocks of the writeback buffer that have been
+    // consumed.
+    size_t Finish(zx_status_t status);
+
     // Adds a closure to the WritebackWork, such that it will be signalled
     // when the WritebackWork is flushed to disk.
     // If no closure is set, nothing will get signalled.
@@ -115,6 +127,15 @@ public:
         return fbl::move(work_);
     }
 
+    void SetBlockPromise(fbl::unique_ptr<AllocatorPromise> block_promise) {
+        ZX_DEBUG_ASSERT(block_promise_ == nullptr);
+        block_promise_ = fbl::move(block_promise);
+    }
+
+    fbl::unique_ptr<AllocatorPromise> RemoveBlockPromise() {
+        return fbl::move(block_promise_);
+    }
+
 private:
     fbl::unique_ptr<WritebackWork> work_;
     fbl::unique_ptr<AllocatorPromise> inode_promise_;
@@ -125,10 +146,16 @@ private:
 
 // WritebackBuffer which manages a writeback buffer (and background thread,
 // which flushes this buffer out to disk).
+//
+// If the volume has a journal, the metadata of all the work waiting for the
+// background thread is written to the journal together, before any of it is
+// written in place.
 class WritebackBuffer {
 public:
     // Calls constructor, return an error if anything goes wrong.
+    // |journal| may be null, in which case metadata is written in place alone.
     static zx_status_t Create(Bcache* bc, fzl::OwnedVmoMapper mapper,
+                              fbl::unique_ptr<Journal> journal,
                               fbl::unique_ptr<WritebackBuffer>* out);
     ~WritebackBuffer();
 
@@ -143,7 +170,7 @@ public:
     void Enqueue(fbl::unique_ptr<WritebackWork> work) __TA_EXCLUDES(writeback_lock_);
 
 private:
-    WritebackBuffer(Bcache* bc, fzl::OwnedVmoMapper mapper);
+    WritebackBuffer(Bcache* bc, fzl::OwnedVmoMapper mapper, fbl::unique_ptr<Journal> journal);
 
     // Blocks until |blocks| blocks of data are free for the caller.
     // Returns |ZX_OK| with the lock still held in this case.
@@ -164,11 +191,19 @@ private:
 
     static int WritebackThread(void* arg);
 
+    using WorkQueue = fs::Queue<fbl::unique_ptr<WritebackWork>>;
+
+    // Writes out and completes all of |batch|, committing its metadata to
+    // the journal in as few entries as fit.
+    //
+    // Returns the number of blocks of the writeback buffer that have been
+    // consumed.
+    size_t CommitBatch(WorkQueue* batch);
+
     // The waiter struct may be used as a stack-allocated queue for producers.
     // It allows them to take turns putting data into the buffer when it is
     // mostly full.
     struct Waiter : public fbl::SinglyLinkedListable<Waiter*> {};
-    using WorkQueue = fs::Queue<fbl::unique_ptr<WritebackWork>>;
     using ProducerQueue = fs::Queue<Waiter*>;
 
     // Signalled when the writeback buffer can be consumed by the background
@@ -182,6 +217,8 @@ private:
     // writeback buffer.
     thrd_t writeback_thrd_;
     Bcache* bc_;
+    // Only used by the writeback thread.
+    fbl::unique_ptr<Journal> journal_;
     fbl::Mutex writeback_lock_;
 
     // Ensures that if multiple producers are waiting for space to write their
@@ -0,0 +1,291 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <fbl/algorithm.h>
+#include <fbl/alloc_checker.h>
+#include <fbl/unique_ptr.h>
+#include <fs/trace.h>
+#include <lib/cksum.h>
+#include <zircon/assert.h>
+
+#include <minfs/journal.h>
+
+namespace minfs {
+namespace {
+
+// Returns true if the entry whose header is at |start| was written completely.
+// Reads its header into |header|, using |blk| as scratch space.
+bool ReadEntry(Bcache* bc, const Superblock* info, blk_t start, JournalHeader* header,
+               uint8_t* blk) {
+    if (bc->Readblk(start, header) != ZX_OK) {
+        return false;
+    }
+    const blk_t capacity = info->jnl_block_count / 2 - kMinfsJournalEntryOverhead;
+    if (header->magic != kMinfsJournalHeaderMagic || header->block_count > capacity) {
+        return false;
+    }
+    for (uint32_t i = 0; i < header->block_count; i++) {
+        blk_t target = header->target[i];
+        if (target >= info->jnl_block && target < info->jnl_block + info->jnl_block_count) {
+            FS_TRACE_ERROR("minfs: Journal entry %" PRIu64 " targets the journal\n",
+                           header->sequence);
+            return false;
+        }
+    }
+
+    uint32_t checksum = crc32(0, reinterpret_cast<const uint8_t*>(header), kMinfsBlockSize);
+    for (uint32_t i = 0; i < header->block_count; i++) {
+        if (bc->Readblk(start + 1 + i, blk) != ZX_OK) {
+            return false;
+        }
+        checksum = crc32(checksum, blk, kMinfsBlockSize);
+    }
+    if (bc->Readblk(start + 1 + header->block_count, blk) != ZX_OK) {
+        return false;
+    }
+    const JournalCommit* commit = reinterpret_cast<const JournalCommit*>(blk);
+    return commit->magic == kMinfsJournalCommitMagic && commit->sequence == header->sequence &&
+           commit->checksum == checksum;
+}
+
+// Finds the newest complete entry of the journal, and compares its blocks with
+// the blocks they belong to, writing them in place if |replay| is set.
+zx_status_t ScanJournal(Bcache* bc, const Superblock* info, bool replay, bool* pending) {
+    *pending = false;
+    if (info->magic0 != kMinfsMagic0 || info->magic1 != kMinfsMagic1 ||
+        info->version != kMinfsVersion || info->jnl_block_count == 0) {
+        // Volumes without a journal are left for CheckSuperblock to judge.
+        return ZX_OK;
+    }
+#ifndef __Fuchsia__
+    if (bc->extent_lengths_.size() > 0) {
+        // Sparse images don't carry the journal.
+        return ZX_OK;
+    }
+#endif
+    if (info->jnl_block < kMinfsJournalStart ||
+        info->jnl_block_count < kMinfsMinimumJournalBlocks ||
+        static_cast<uint64_t>(info->jnl_block) + info->jnl_block_count > info->ibm_block) {
+        FS_TRACE_ERROR("minfs: Journal collides with inode bitmap\n");
+        return ZX_ERR_INVALID_ARGS;
+    }
+
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<JournalHeader[]> headers(new (&ac) JournalHeader[2]);
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    uint8_t blk[kMinfsBlockSize];
+    uint8_t current[kMinfsBlockSize];
+
+    const blk_t half_blocks = info->jnl_block_count / 2;
+    int newest = -1;
+    for (int half = 0; half < 2; half++) {
+        if (ReadEntry(bc, info, info->jnl_block + half * half_blocks, &headers[half], blk) &&
+            (newest < 0 || headers[half].sequence > headers[newest].sequence)) {
+            newest = half;
+        }
+    }
+    if (newest < 0) {
+        return ZX_OK;
+    }
+
+    const JournalHeader& header = headers[newest];
+    const blk_t start = info->jnl_block + newest * half_blocks;
+    for (uint32_t i = 0; i < header.block_count; i++) {
+        if (bc->Readblk(start + 1 + i, blk) != ZX_OK ||
+            bc->Readblk(header.target[i], current) != ZX_OK) {
+            return ZX_ERR_IO;
+        }
+        if (memcmp(blk, current, kMinfsBlockSize) == 0) {
+            continue;
+        }
+        *pending = true;
+        if (!replay) {
+            return ZX_OK;
+        }
+        if (bc->Writeblk(header.target[i], blk) != ZX_OK) {
+            return ZX_ERR_IO;
+        }
+    }
+    if (!replay) {
+        return ZX_OK;
+    }
+    if (*pending) {
+        FS_TRACE_WARN("minfs: Replayed journal entry %" PRIu64 "\n", header.sequence);
+        if (bc->Sync() != ZX_OK) {
+            return ZX_ERR_IO;
+        }
+    }
+
+    // Erase both entries, so that nothing written without the journal (such
+    // as by host tools) is later replayed over.
+    memset(blk, 0, sizeof(blk));
+    if (bc->Writeblk(info->jnl_block, blk) != ZX_OK ||
+        bc->Writeblk(info->jnl_block + half_blocks, blk) != ZX_OK || bc->Sync() != ZX_OK) {
+        // A volume opened read-only can't be erased, but nothing will be
+        // written to it which the entry could be replayed over either.
+        return *pending ? ZX_ERR_IO : ZX_OK;
+    }
+    return ZX_OK;
+}
+
+#ifdef __Fuchsia__
+void SetWriteRequest(Bcache* bc, vmoid_t vmoid, uint64_t vmo_offset, uint64_t dev_offset,
+                     uint64_t length, block_fifo_request_t* request) {
+    const uint32_t kDiskBlocksPerMinfsBlock = kMinfsBlockSize / bc->DeviceBlockSize();
+    request->group = bc->BlockGroupID();
+    request->vmoid = vmoid;
+    request->opcode = BLOCKIO_WRITE;
+    request->vmo_offset = vmo_offset * kDiskBlocksPerMinfsBlock;
+    request->dev_offset = dev_offset * kDiskBlocksPerMinfsBlock;
+    length *= kDiskBlocksPerMinfsBlock;
+    ZX_ASSERT_MSG(length < UINT32_MAX, "Too many blocks");
+    request->length = static_cast<uint32_t>(length);
+}
+#endif
+
+} // namespace
+
+uint32_t JournalBlocksFor(uint32_t max_blocks) {
+    // Both halves of the journal are the same size.
+    uint32_t blocks = fbl::min(max_blocks, kMinfsDefaultJournalBlocks) & ~1u;
+    return (blocks < kMinfsMinimumJournalBlocks) ? 0 : blocks;
+}
+
+zx_status_t ReplayJournal(Bcache* bc, const Superblock* info) {
+    bool pending;
+    return ScanJournal(bc, info, true, &pending);
+}
+
+zx_status_t CheckJournal(Bcache* bc, const Superblock* info, bool* pending) {
+    return ScanJournal(bc, info, false, pending);
+}
+
+#ifdef __Fuchsia__
+
+Journal::Journal(Bcache* bc, blk_t start, blk_t half_blocks, fzl::OwnedVmoMapper mapper)
+    : bc_(bc), start_(start), half_blocks_(half_blocks), mapper_(fbl::move(mapper)) {}
+
+Journal::~Journal() {
+    if (vmoid_ != VMOID_INVALID) {
+        block_fifo_request_t request;
+        request.group = bc_->BlockGroupID();
+        request.vmoid = vmoid_;
+        request.opcode = BLOCKIO_CLOSE_VMO;
+        bc_->Transaction(&request, 1);
+    }
+}
+
+zx_status_t Journal::Create(Bcache* bc, const Superblock* info, fbl::unique_ptr<Journal>* out) {
+    ZX_DEBUG_ASSERT(info->jnl_block_count >= kMinfsMinimumJournalBlocks);
+    fzl::OwnedVmoMapper mapper;
+    zx_status_t status;
+    if ((status = mapper.CreateAndMap(kMinfsJournalEntryOverhead * kMinfsBlockSize,
+                                      "minfs-journal")) != ZX_OK) {
+        return status;
+    }
+
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<Journal> journal(new (&ac) Journal(bc, info->jnl_block,
+                                                       info->jnl_block_count / 2,
+                                                       fbl::move(mapper)));
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    if ((status = bc->AttachVmo(journal->mapper_.vmo().get(), &journal->vmoid_)) != ZX_OK) {
+        return status;
+    }
+    *out = fbl::move(journal);
+    return ZX_OK;
+}
+
+zx_status_t Journal::Commit(const fbl::Vector<WriteRequest>& requests, const void* buffer,
+                            vmoid_t vmoid) {
+    size_t blocks = 0;
+    for (size_t i = 0; i < requests.size(); i++) {
+        blocks += requests[i].length;
+    }
+    if (blocks == 0) {
+        return ZX_OK;
+    } else if (blocks > EntryCapacity()) {
+        FS_TRACE_WARN("minfs: %zu blocks of metadata are too many to journal\n", blocks);
+        return Erase();
+    }
+
+    const blk_t entry_start = start_ + static_cast<blk_t>(sequence_ % 2) * half_blocks_;
+    auto header = reinterpret_cast<JournalHeader*>(mapper_.start());
+    memset(header, 0, kMinfsBlockSize);
+    header->magic = kMinfsJournalHeaderMagic;
+    header->sequence = sequence_;
+    header->block_count = static_cast<uint32_t>(blocks);
+
+    const size_t request_count = requests.size() + kMinfsJournalEntryOverhead;
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<block_fifo_request_t[]> blk_reqs(new (&ac) block_fifo_request_t[request_count]);
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    blk_t next = entry_start + 1;
+    uint32_t target = 0;
+    for (size_t i = 0; i < requests.size(); i++) {
+        for (size_t j = 0; j < requests[i].length; j++) {
+            header->target[target++] = static_cast<blk_t>(requests[i].dev_offset + j);
+        }
+        SetWriteRequest(bc_, vmoid, requests[i].vmo_offset, next, requests[i].length,
+                        &blk_reqs[i + 1]);
+        next += static_cast<blk_t>(requests[i].length);
+    }
+
+    uint32_t checksum = crc32(0, reinterpret_cast<const uint8_t*>(header), kMinfsBlockSize);
+    for (size_t i = 0; i < requests.size(); i++) {
+        const uint8_t* data = reinterpret_cast<const uint8_t*>(buffer) +
+                              requests[i].vmo_offset * kMinfsBlockSize;
+        checksum = crc32(checksum, data, requests[i].length * kMinfsBlockSize);
+    }
+    auto commit = reinterpret_cast<JournalCommit*>(
+        reinterpret_cast<uintptr_t>(mapper_.start()) + kMinfsBlockSize);
+    memset(commit, 0, kMinfsBlockSize);
+    commit->magic = kMinfsJournalCommitMagic;
+    commit->sequence = sequence_;
+    commit->checksum = checksum;
+
+    SetWriteRequest(bc_, vmoid_, 0, entry_start, 1, &blk_reqs[0]);
+    SetWriteRequest(bc_, vmoid_, 1, next, 1, &blk_reqs[requests.size() + 1]);
+
+    zx_status_t status = bc_->Transaction(blk_reqs.get(), request_count);
+    if (status != ZX_OK) {
+        return status;
+    }
+    if (bc_->Sync() != ZX_OK) {
+        return ZX_ERR_IO;
+    }
+    sequence_++;
+    return ZX_OK;
+}
+
+zx_status_t Journal::Erase() {
+    // Only the in-place writes which followed the last entry may not be
+    // durable yet.
+    if (bc_->Sync() != ZX_OK) {
+        return ZX_ERR_IO;
+    }
+    memset(mapper_.start(), 0, kMinfsBlockSize);
+    block_fifo_request_t blk_reqs[2];
+    SetWriteRequest(bc_, vmoid_, 0, start_, 1, &blk_reqs[0]);
+    SetWriteRequest(bc_, vmoid_, 0, start_ + half_blocks_, 1, &blk_reqs[1]);
+    zx_status_t status = bc_->Transaction(blk_reqs, fbl::count_of(blk_reqs));
+    if (status != ZX_OK) {
+        return status;
+    }
+    return (bc_->Sync() == ZX_OK) ? ZX_OK : ZX_ERR_IO;
+}
+
+#endif // __Fuchsia__
+
+} // namespace minfs
@@ -16,6 +16,7 @@
 #include <fs/watcher.h>
 #include <fuchsia/io/c/fidl.h>
 #include <fuchsia/minfs/c/fidl.h>
+#include <lib/async/cpp/task.h>
 #include <lib/fzl/resizeable-vmo-mapper.h>
 #include <lib/sync/completion.h>
 #include <lib/zx/vmo.h>
@@ -36,8 +37,11 @@
 #include <fs/vnode.h>
 #include <lib/zircon-internal/fnv1hash.h>
 #include <minfs/allocator.h>
+#include <minfs/directory-index.h>
+#include <minfs/extent-cache.h>
 #include <minfs/format.h>
 #include <minfs/inode-manager.h>
+#include <minfs/journal.h>
 #include <minfs/superblock.h>
 #include <minfs/writeback.h>
 
@@ -78,6 +82,9 @@ constexpr uint32_t kMxFsSyncCtime = (1 << 1);
 
 constexpr uint32_t kMinfsBlockCacheSize = 64;
 
+// The number of directories which fs::Vfs caches while walking paths.
+constexpr size_t kMinfsNameCacheCapacity = 256;
+
 // Used by fsck
 class MinfsChecker;
 class VnodeMinfs;
@@ -240,9 +247,12 @@ public:
 
 #ifdef __Fuchsia__
     // Acquire a copy of the collected metrics.
-    zx_status_t GetMetrics(fuchsia_minfs_Metrics* out) const {
+    zx_status_t GetMetrics(fuchsia_minfs_Metrics* out) {
         if (collecting_metrics_) {
             memcpy(out, &metrics_, sizeof(metrics_));
+            NameCacheStats stats = GetNameCacheStats();
+            out->name_cache_hits = stats.hits;
+            out->name_cache_misses = stats.misses;
             return ZX_OK;
         }
         return ZX_ERR_UNAVAILABLE;
@@ -375,6 +385,10 @@ public:
     // Minfs FIDL interface.
     zx_status_t GetMetrics(fidl_txn_t* txn);
     zx_status_t ToggleMetrics(bool enabled, fidl_txn_t* txn);
+
+    // Allocates blocks for the file data held only in |vmo_|, and enqueues it to be
+    // written out.
+    zx_status_t FlushDirty();
 #endif
 
     // TODO(rvargas): Make private.
@@ -417,6 +431,8 @@ private:
     // Internal functions
     zx_status_t ReadInternal(void* data, size_t len, size_t off, size_t* actual);
     zx_status_t ReadExactInternal(void* data, size_t len, size_t off);
+    // On Fuchsia, a null |state| only updates |vmo_|, and the written blocks must be
+    // added to the dirty range.
     zx_status_t WriteInternal(Transaction* state, const void* data, size_t len,
                               size_t off, size_t* actual);
     zx_status_t WriteExactInternal(Transaction* state, const void* data, size_t len,
@@ -431,8 +447,20 @@ private:
 
     using DirentCallback = zx_status_t (*)(fbl::RefPtr<VnodeMinfs>, Dirent*, DirArgs*);
 
-    // Enumerates directories.
-    zx_status_t ForEachDirent(DirArgs* args, const DirentCallback func);
+    // Enumerates directories, starting from the dirent at |start|.
+    zx_status_t ForEachDirent(DirArgs* args, const DirentCallback func, size_t start = 0);
+
+    // Finds the dirent for |args->name|, setting |args->ino| and |args->type|, through the
+    // directory index if the directory is large enough to have one.
+    // Returns ZX_ERR_NOT_FOUND if the directory doesn't hold the name.
+    zx_status_t LookupDirent(DirArgs* args);
+
+    // Finds room for a dirent of |args->reclen| bytes, as |DirentCallbackFindSpace| does,
+    // skipping the dirents which the directory index knows to be full.
+    zx_status_t FindDirentSpace(DirArgs* args);
+
+    // Builds |dir_index_| from the directory's dirents.
+    zx_status_t LoadDirectoryIndex();
 
     // Directory callback functions.
     //
@@ -448,6 +476,7 @@ private:
     static zx_status_t DirentCallbackUpdateInode(fbl::RefPtr<VnodeMinfs>, Dirent*,
                                                  DirArgs*);
     static zx_status_t DirentCallbackFindSpace(fbl::RefPtr<VnodeMinfs>, Dirent*, DirArgs*);
+    static zx_status_t DirentCallbackIndex(fbl::RefPtr<VnodeMinfs>, Dirent*, DirArgs*);
 
     // Appends a new directory at the specified offset within |args|. This requires a prior call to
     // DirentCallbackFindSpace to find an offset where there is space for the direntry. It takes
@@ -608,6 +637,7 @@ private:
 
     // Get the disk block 'bno' corresponding to the 'n' block
     // If 'txn' is non-null, new blocks are allocated for all un-allocated bnos.
+    // Mappings found are kept in |extents_|.
     // This can be extended to retrieve multiple contiguous blocks in one call
     zx_status_t BlockGet(Transaction* state, blk_t n, blk_t* bno);
     // Deletes all blocks (relative to a file) from "start" (inclusive) to the end
@@ -634,6 +664,14 @@ private:
     zx_status_t InitVmo();
     zx_status_t InitIndirectVmo();
 
+    // Writes to |vmo_|, reserving (but not allocating) blocks for the data.
+    zx_status_t WriteDelayed(const void* data, size_t len, size_t off, size_t* out_actual);
+
+    // Forgets the dirty range of a file whose blocks are being freed.
+    void DiscardDirty();
+
+    void FlushDirtyTask();
+
     // Loads indirect blocks up to and including the doubly indirect block at |index|.
     zx_status_t LoadIndirectWithinDoublyIndirect(uint32_t index);
 
@@ -682,6 +720,15 @@ private:
     //                                                              by doubly indirect blocks
     fbl::unique_ptr<fzl::ResizeableVmoMapper> vmo_indirect_;
 
+    // File blocks [dirty_start_, dirty_end_) have been written to |vmo_| but not to disk.
+    // |dirty_promise_| holds enough blocks to store the whole range, which are allocated
+    // together when the range is flushed.
+    blk_t dirty_start_ = 0;
+    blk_t dirty_end_ = 0;
+    fbl::unique_ptr<AllocatorPromise> dirty_promise_;
+    // Flushes the dirty range once it has been left for a while.
+    async::TaskClosureMethod<VnodeMinfs, &VnodeMinfs::FlushDirtyTask> flush_task_{this};
+
     vmoid_t vmoid_{};
     vmoid_t vmoid_indirect_{};
 
@@ -692,6 +739,16 @@ private:
     ino_t ino_{};
     Inode inode_{};
 
+    // Maps file blocks to data blocks without walking |inode_|'s indirect blocks.
+    ExtentCache extents_;
+
+    // Locates the dirents of large directories; null until the directory is first
+    // searched, and for directories which are searched linearly.
+    fbl::unique_ptr<DirectoryIndex> dir_index_;
+    // Set once two names in the directory are found to share a hash, so that the
+    // index isn't rebuilt on every lookup.
+    bool dir_index_failed_ = false;
+
     // This field tracks the current number of file descriptors with
     // an open reference to this Vnode. Notably, this is distinct from the
     // VnodeMinfs's own refcount, since there may still be filesystem
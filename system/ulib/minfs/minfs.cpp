@@ -79,6 +79,7 @@ void DumpInfo(const Superblock* info) {
     xprintf("minfs: inodes:  %10u (size %u)\n", info->inode_count, info->inode_size);
     xprintf("minfs: allocated blocks  @ %10u\n", info->alloc_block_count);
     xprintf("minfs: allocated inodes  @ %10u\n", info->alloc_inode_count);
+    xprintf("minfs: journal      @ %10u (%u blocks)\n", info->jnl_block, info->jnl_block_count);
     xprintf("minfs: inode bitmap @ %10u\n", info->ibm_block);
     xprintf("minfs: alloc bitmap @ %10u\n", info->abm_block);
     xprintf("minfs: inode table  @ %10u\n", info->ino_block);
@@ -101,15 +102,26 @@ zx_status_t CheckSuperblock(const Superblock* info, Bcache* bc) {
         FS_TRACE_ERROR("minfs: bad magic\n");
         return ZX_ERR_INVALID_ARGS;
     }
-    if (info->version != kMinfsVersion) {
+    if (info->version != kMinfsVersion && info->version != kMinfsVersionNoJournal) {
         FS_TRACE_ERROR("minfs: FS Version: %08x. Driver version: %08x\n", info->version,
                        kMinfsVersion);
         return ZX_ERR_INVALID_ARGS;
     }
+    if (info->version == kMinfsVersionNoJournal && info->jnl_block_count != 0) {
+        FS_TRACE_ERROR("minfs: FS Version %08x cannot have a journal\n", info->version);
+        return ZX_ERR_INVALID_ARGS;
+    }
     if ((info->block_size != kMinfsBlockSize) || (info->inode_size != kMinfsInodeSize)) {
         FS_TRACE_ERROR("minfs: bsz/isz %u/%u unsupported\n", info->block_size, info->inode_size);
         return ZX_ERR_INVALID_ARGS;
     }
+    if (info->jnl_block_count != 0 &&
+        (info->jnl_block < kMinfsJournalStart ||
+         info->jnl_block_count < kMinfsMinimumJournalBlocks ||
+         static_cast<uint64_t>(info->jnl_block) + info->jnl_block_count > info->ibm_block)) {
+        FS_TRACE_ERROR("minfs: Journal collides with inode bitmap\n");
+        return ZX_ERR_INVALID_ARGS;
+    }
     if ((info->flags & kMinfsFlagFVM) == 0) {
         if (info->dat_block + info->block_count > max) {
             FS_TRACE_ERROR("minfs: too large for device\n");
@@ -183,6 +195,10 @@ zx_status_t CheckSuperblock(const Superblock* info, Bcache* bc) {
 #endif
         // Verify that the allocated slices are sufficient to hold
         // the allocated data structures of the filesystem.
+        if (info->jnl_block + info->jnl_block_count > kBlocksPerSlice) {
+            FS_TRACE_ERROR("minfs: Journal doesn't fit in the superblock's slice\n");
+            return ZX_ERR_INVALID_ARGS;
+        }
         size_t ibm_blocks_needed = (info->inode_count + kMinfsBlockBits - 1) / kMinfsBlockBits;
         size_t ibm_blocks_allocated = info->ibm_slices * kBlocksPerSlice;
         if (ibm_blocks_needed > ibm_blocks_allocated) {
@@ -302,6 +318,9 @@ Minfs::Minfs(fbl::unique_ptr<Bcache> bc, fbl::unique_ptr<SuperblockManager> sb,
 #endif
 
 Minfs::~Minfs() {
+    // Cached directories are released while the vnode hash and block cache
+    // they refer to still exist.
+    SetNameCacheCapacity(0);
     vnode_hash_.clear();
 }
 
@@ -770,8 +789,16 @@ zx_status_t Minfs::Create(fbl::unique_ptr<Bcache> bc, const Superblock* info,
         return status;
     }
 
+    fbl::unique_ptr<Journal> journal;
+    if (info->jnl_block_count != 0 &&
+        (status = Journal::Create(bc.get(), info, &journal)) != ZX_OK) {
+        FS_TRACE_ERROR("Minfs::Create failed to initialize journal: %d\n", status);
+        return status;
+    }
+
     fbl::unique_ptr<WritebackBuffer> writeback;
-    status = WritebackBuffer::Create(bc.get(), fbl::move(mapper), &writeback);
+    status = WritebackBuffer::Create(bc.get(), fbl::move(mapper), fbl::move(journal),
+                                     &writeback);
     if (status != ZX_OK) {
         return status;
     }
@@ -855,6 +882,17 @@ zx_status_t Mount(fbl::unique_ptr<minfs::Bcache> bc, fbl::RefPtr<VnodeMinfs>* ro
     }
     const Superblock* info = reinterpret_cast<Superblock*>(blk);
 
+    // Bring the volume to the state of its last journal commit, which may
+    // include the superblock.
+    if ((status = ReplayJournal(bc.get(), info)) != ZX_OK) {
+        FS_TRACE_ERROR("minfs: could not replay journal\n");
+        return status;
+    }
+    if ((status = bc->Readblk(0, &blk)) != ZX_OK) {
+        FS_TRACE_ERROR("minfs: could not read info block\n");
+        return status;
+    }
+
     fbl::unique_ptr<Minfs> fs;
     if ((status = Minfs::Create(fbl::move(bc), info, &fs)) != ZX_OK) {
         FS_TRACE_ERROR("minfs: mount failed\n");
@@ -887,6 +925,9 @@ zx_status_t MountAndServe(const MountOptions* options, async_dispatcher_t* dispa
 
     Minfs* vfs = vn->fs_;
     vfs->SetReadonly(options->readonly);
+    if ((status = vfs->SetNameCacheCapacity(kMinfsNameCacheCapacity)) != ZX_OK) {
+        FS_TRACE_WARN("minfs: could not allocate name cache\n");
+    }
     vfs->SetMetrics(options->metrics);
     vfs->SetUnmountCallback(fbl::move(on_unmount));
     vfs->SetDispatcher(dispatcher);
@@ -986,6 +1027,10 @@ zx_status_t Mkfs(const MountOptions& options, fbl::unique_ptr<Bcache> bc) {
 
         inodes = static_cast<uint32_t>(info.ino_slices * info.slice_size / kMinfsInodeSize);
         blocks = static_cast<uint32_t>(info.dat_slices * info.slice_size / kMinfsBlockSize);
+
+        // The journal shares the superblock's slice.
+        info.jnl_block_count =
+            JournalBlocksFor(static_cast<uint32_t>(kBlocksPerSlice - kMinfsJournalStart));
     }
 #endif
     if ((info.flags & kMinfsFlagFVM) == 0) {
@@ -1004,7 +1049,9 @@ zx_status_t Mkfs(const MountOptions& options, fbl::unique_ptr<Bcache> bc) {
     info.alloc_inode_count = 0;
     if ((info.flags & kMinfsFlagFVM) == 0) {
         // Aligning distinct data areas to 8 block groups.
-        uint32_t non_dat_blocks = (8 + fbl::round_up(ibmblks, 8u) + inoblks);
+        info.jnl_block_count = JournalBlocksFor(blocks / 32);
+        uint32_t ibm_start = fbl::round_up(kMinfsJournalStart + info.jnl_block_count, 8u);
+        uint32_t non_dat_blocks = (ibm_start + fbl::round_up(ibmblks, 8u) + inoblks);
         if (non_dat_blocks >= blocks) {
             fprintf(stderr, "mkfs: Partition size (%" PRIu64 " bytes) is too small\n",
                     static_cast<uint64_t>(blocks) * kMinfsBlockSize);
@@ -1014,7 +1061,7 @@ zx_status_t Mkfs(const MountOptions& options, fbl::unique_ptr<Bcache> bc) {
         uint32_t dat_block_count_ = blocks - non_dat_blocks;
         abmblks = (dat_block_count_ + kMinfsBlockBits - 1) / kMinfsBlockBits;
         info.block_count = dat_block_count_ - fbl::round_up(abmblks, 8u);
-        info.ibm_block = 8;
+        info.ibm_block = ibm_start;
         info.abm_block = info.ibm_block + fbl::round_up(ibmblks, 8u);
         info.ino_block = info.abm_block + fbl::round_up(abmblks, 8u);
         info.dat_block = info.ino_block + inoblks;
@@ -1027,6 +1074,10 @@ zx_status_t Mkfs(const MountOptions& options, fbl::unique_ptr<Bcache> bc) {
         info.dat_block = kFVMBlockDataStart;
     }
 
+    if (info.jnl_block_count != 0) {
+        info.jnl_block = kMinfsJournalStart;
+    }
+
     DumpInfo(&info);
 
     RawBitmap abm;
@@ -1092,6 +1143,12 @@ zx_status_t Mkfs(const MountOptions& options, fbl::unique_ptr<Bcache> bc) {
         bc->Writeblk(info.ino_block + n, blk);
     }
 
+    // erase the journal's entries, which may be left from an earlier volume
+    if (info.jnl_block_count != 0) {
+        bc->Writeblk(info.jnl_block, blk);
+        bc->Writeblk(info.jnl_block + info.jnl_block_count / 2, blk);
+    }
+
     // setup root inode
     Inode* ino = reinterpret_cast<Inode*>(&blk[0]);
     ino[kMinfsRootIno].magic = kMinfsMagicDir;
@@ -11,6 +11,7 @@
 #include <sys/stat.h>
 
 #include <fbl/algorithm.h>
+#include <fbl/alloc_checker.h>
 #include <fbl/auto_call.h>
 #include <fbl/string_piece.h>
 #include <fs/block-txn.h>
@@ -20,6 +21,7 @@
 #ifdef __Fuchsia__
 #include <lib/fdio/vfs.h>
 #include <lib/fidl-utils/bind.h>
+#include <lib/zx/time.h>
 #include <fbl/auto_lock.h>
 #include <zircon/syscalls.h>
 #endif
@@ -43,6 +45,13 @@ constexpr zx_status_t kDirIteratorNext = 1;
 // Identify that the direntry record was modified. Stop iterating.
 constexpr zx_status_t kDirIteratorSaveSync = 2;
 
+#ifdef __Fuchsia__
+// Once this many file blocks are dirty, they are flushed by the write which dirtied them.
+constexpr blk_t kMaxDirtyBlocks = 128;
+// Dirty blocks are flushed after waiting this long.
+constexpr zx::duration kDirtyFlushDelay = zx::msec(500);
+#endif
+
 zx_time_t GetTimeUTC() {
     struct timespec ts;
     clock_gettime(CLOCK_REALTIME, &ts);
@@ -148,6 +157,8 @@ void VnodeMinfs::InodeSync(WritebackWork* wb, uint32_t flags) {
 // the file. Does not update mtime/atime.
 zx_status_t VnodeMinfs::BlocksShrink(Transaction* state, blk_t start) {
     ZX_DEBUG_ASSERT(state != nullptr);
+    // Forget the blocks first, so that none is left cached if freeing fails partway.
+    extents_.Truncate(start);
     BlockOpArgs op_args(start, static_cast<blk_t>(kMinfsMaxFileBlock - start), nullptr);
     zx_status_t status;
     if ((status = ApplyOperation(state, BlockOp::kDelete, &op_args)) != ZX_OK) {
@@ -297,6 +308,7 @@ zx_status_t VnodeMinfs::InitVmo() {
             fs_->ValidateBno(bno);
             dnum_count++;
             txn.Enqueue(vmoid_, d, bno + fs_->Info().dat_block, 1);
+            extents_.Insert(d, bno);
         }
     }
 
@@ -321,6 +333,7 @@ zx_status_t VnodeMinfs::InitVmo() {
                     fs_->ValidateBno(bno);
                     uint32_t n = kMinfsDirect + i * kMinfsDirectPerIndirect + j;
                     txn.Enqueue(vmoid_, n, bno + fs_->Info().dat_block, 1);
+                    extents_.Insert(n, bno);
                 }
             }
         }
@@ -363,6 +376,7 @@ zx_status_t VnodeMinfs::InitVmo() {
                             uint32_t n = kMinfsDirect + kMinfsIndirect * kMinfsDirectPerIndirect
                                          + j * kMinfsDirectPerIndirect + k;
                             txn.Enqueue(vmoid_, n, bno + fs_->Info().dat_block, 1);
+                            extents_.Insert(n, bno);
                         }
                     }
                 }
@@ -692,6 +706,12 @@ zx_status_t VnodeMinfs::ApplyOperation(Transaction* state, BlockOp op, BlockOpAr
 }
 
 zx_status_t VnodeMinfs::BlockGet(Transaction* state, blk_t n, blk_t* bno) {
+    // An allocated block keeps its place until it is freed, so a cached
+    // mapping serves writes as well as reads.
+    if (extents_.Find(n, bno)) {
+        return ZX_OK;
+    }
+
 #ifdef __Fuchsia__
     if (n >= kMinfsDirect) {
         zx_status_t status;
@@ -718,7 +738,12 @@ zx_status_t VnodeMinfs::BlockGet(Transaction* state, blk_t n, blk_t* bno) {
 #endif
 
     BlockOpArgs op_args(n, 1, bno);
-    return ApplyOperation(state, state ? BlockOp::kWrite : BlockOp::kRead, &op_args);
+    zx_status_t status = ApplyOperation(state, state ? BlockOp::kWrite : BlockOp::kRead,
+                                        &op_args);
+    if (status == ZX_OK && *bno != 0) {
+        extents_.Insert(n, *bno);
+    }
+    return status;
 }
 
 zx_status_t VnodeMinfs::ReadExactInternal(void* data, size_t len, size_t off) {
@@ -830,6 +855,11 @@ zx_status_t VnodeMinfs::UnlinkChild(Transaction* state,
     if ((status = WriteExactInternal(state, de, MINFS_DIRENT_SIZE, off)) != ZX_OK) {
         return status;
     }
+    if (dir_index_ != nullptr) {
+        // The name is left in place; only the inode and record length change.
+        dir_index_->Erase(fbl::StringPiece(de->name, de->namelen));
+        dir_index_->FreedSpace(off);
+    }
 
     if (de->reclen & kMinfsReclenLast) {
         // Truncating the directory merely removed unused space; if it fails,
@@ -999,6 +1029,84 @@ zx_status_t VnodeMinfs::DirentCallbackFindSpace(fbl::RefPtr<VnodeMinfs> vndir, D
     }
 }
 
+zx_status_t VnodeMinfs::DirentCallbackIndex(fbl::RefPtr<VnodeMinfs> vndir, Dirent* de,
+                                            DirArgs* args) {
+    if (de->ino != 0) {
+        zx_status_t status = vndir->dir_index_->Insert(fbl::StringPiece(de->name, de->namelen),
+                                                       args->offs.off);
+        if (status != ZX_OK) {
+            return status;
+        }
+    }
+    return NextDirent(de, &args->offs);
+}
+
+zx_status_t VnodeMinfs::LoadDirectoryIndex() {
+    TRACE_DURATION("minfs", "VnodeMinfs::LoadDirectoryIndex");
+    fbl::AllocChecker ac;
+    dir_index_.reset(new (&ac) DirectoryIndex());
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    DirArgs args = DirArgs();
+    zx_status_t status = ForEachDirent(&args, DirentCallbackIndex);
+    if (status != ZX_ERR_NOT_FOUND) {
+        // Either the directory couldn't be read, or two of its names share a
+        // hash; either way, it is searched linearly.
+        dir_index_.reset();
+        dir_index_failed_ = (status == ZX_ERR_ALREADY_EXISTS);
+        return (status == ZX_OK) ? ZX_ERR_BAD_STATE : status;
+    }
+    return ZX_OK;
+}
+
+zx_status_t VnodeMinfs::LookupDirent(DirArgs* args) {
+    if (dir_index_ == nullptr && !dir_index_failed_ &&
+        inode_.dirent_count >= DirectoryIndex::kMinDirents) {
+        // Failing to build the index only costs a linear search.
+        LoadDirectoryIndex();
+    }
+    if (dir_index_ == nullptr) {
+        return ForEachDirent(args, DirentCallbackFind);
+    }
+
+    size_t off;
+    if (!dir_index_->Find(args->name, &off)) {
+        return ZX_ERR_NOT_FOUND;
+    }
+    char data[kMinfsMaxDirentSize];
+    Dirent* de = reinterpret_cast<Dirent*>(data);
+    size_t r;
+    zx_status_t status = ReadInternal(data, kMinfsMaxDirentSize, off, &r);
+    if (status != ZX_OK) {
+        return status;
+    } else if ((status = ValidateDirent(de, r, off)) != ZX_OK) {
+        return status;
+    }
+    // The dirent may hold another name with the same hash. In that case,
+    // |args->name| can't be in the directory, or it would have collided with
+    // that name when it was indexed.
+    if (de->ino == 0 || fbl::StringPiece(de->name, de->namelen) != args->name) {
+        return ZX_ERR_NOT_FOUND;
+    }
+    args->ino = de->ino;
+    args->type = de->type;
+    args->offs.off = off;
+    return ZX_OK;
+}
+
+zx_status_t VnodeMinfs::FindDirentSpace(DirArgs* args) {
+    if (dir_index_ == nullptr) {
+        return ForEachDirent(args, DirentCallbackFindSpace);
+    }
+    zx_status_t status = ForEachDirent(args, DirentCallbackFindSpace,
+                                       dir_index_->SpaceHint(args->reclen));
+    if (status == ZX_OK) {
+        dir_index_->FoundSpace(args->reclen, args->offs.off);
+    }
+    return status;
+}
+
 zx_status_t VnodeMinfs::AppendDirent(DirArgs* args) {
     char data[kMinfsMaxDirentSize];
     Dirent* de = reinterpret_cast<Dirent*>(data);
@@ -1050,6 +1158,13 @@ zx_status_t VnodeMinfs::AppendDirent(DirArgs* args) {
         return status;
     }
 
+    if (dir_index_ != nullptr && dir_index_->Insert(args->name, args->offs.off) != ZX_OK) {
+        // The new name shares a hash with one which is already indexed, or
+        // memory ran out.
+        dir_index_.reset();
+        dir_index_failed_ = true;
+    }
+
     if (args->type == kMinfsTypeDir) {
         // Child directory has '..' which will point to parent directory
         inode_.link_count++;
@@ -1074,11 +1189,11 @@ zx_status_t VnodeMinfs::AppendDirent(DirArgs* args) {
 //  'offs': Offset info about where in the directory this direntry is located.
 //          Since 'func' may create / remove surrounding dirents, it is responsible for
 //          updating the offset information to access the next dirent.
-zx_status_t VnodeMinfs::ForEachDirent(DirArgs* args, const DirentCallback func) {
+zx_status_t VnodeMinfs::ForEachDirent(DirArgs* args, const DirentCallback func, size_t start) {
     char data[kMinfsMaxDirentSize];
     Dirent* de = (Dirent*) data;
-    args->offs.off = 0;
-    args->offs.off_prev = 0;
+    args->offs.off = start;
+    args->offs.off_prev = start;
     while (args->offs.off + MINFS_DIRENT_SIZE < kMinfsMaxDirectorySize) {
         xprintf("Reading dirent at offset %zd\n", args->offs.off);
         size_t r;
@@ -1186,6 +1301,20 @@ zx_status_t VnodeMinfs::Close() {
     ZX_DEBUG_ASSERT_MSG(fd_count_ > 0, "Closing ino with no fds open");
     fd_count_--;
 
+#ifdef __Fuchsia__
+    if (fd_count_ == 0) {
+        if (IsUnlinked()) {
+            // The file's blocks are about to be freed, so its dirty data need not be written.
+            DiscardDirty();
+        } else {
+            zx_status_t status = FlushDirty();
+            if (status != ZX_OK) {
+                FS_TRACE_ERROR("minfs: Failed to flush inode %u on close: %d\n", ino_, status);
+            }
+        }
+    }
+#endif
+
     if (fd_count_ == 0 && IsUnlinked()) {
         fbl::unique_ptr<Transaction> state;
         ZX_ASSERT(fs_->BeginTransaction(0, 0, &state) == ZX_OK);
@@ -1290,6 +1419,9 @@ zx_status_t VnodeMinfs::Write(const void* data, size_t len, size_t offset,
         fs_->UpdateWriteMetrics(*out_actual, ticker.End());
     });
 
+#ifdef __Fuchsia__
+    return WriteDelayed(data, len, offset, out_actual);
+#else
     blk_t reserve_blocks;
     // Calculate maximum number of blocks to reserve for this write operation.
     zx_status_t status = GetRequiredBlockCount(offset, len, &reserve_blocks);
@@ -1311,6 +1443,7 @@ zx_status_t VnodeMinfs::Write(const void* data, size_t len, size_t offset,
         fs_->CommitTransaction(fbl::move(state));
     }
     return ZX_OK;
+#endif
 }
 
 zx_status_t VnodeMinfs::Append(const void* data, size_t len, size_t* out_end,
@@ -1320,6 +1453,125 @@ zx_status_t VnodeMinfs::Append(const void* data, size_t len, size_t* out_end,
     return status;
 }
 
+#ifdef __Fuchsia__
+zx_status_t VnodeMinfs::WriteDelayed(const void* data, size_t len, size_t off,
+                                     size_t* out_actual) {
+    if (len == 0) {
+        return ZX_OK;
+    }
+    blk_t reserve_blocks;
+    zx_status_t status = GetRequiredBlockCount(off, len, &reserve_blocks);
+    if (status != ZX_OK) {
+        return status;
+    }
+    if (off >= kMinfsMaxFileSize) {
+        return ZX_ERR_FILE_BIG;
+    }
+    blk_t start = static_cast<blk_t>(off / kMinfsBlockSize);
+    blk_t end = static_cast<blk_t>(fbl::min(fbl::round_up(off + len, kMinfsBlockSize) /
+                                            kMinfsBlockSize, kMinfsMaxFileBlock));
+
+    // Only one run of blocks is kept dirty, so that a flush never allocates the holes
+    // between separate writes.
+    if (dirty_start_ != dirty_end_ &&
+        (end < dirty_start_ || start > dirty_end_ ||
+         fbl::max(end, dirty_end_) - fbl::min(start, dirty_start_) > kMaxDirtyBlocks)) {
+        if ((status = FlushDirty()) != ZX_OK) {
+            return status;
+        }
+    }
+    blk_t new_start = (dirty_start_ == dirty_end_) ? start : fbl::min(start, dirty_start_);
+    blk_t new_end = fbl::max(end, dirty_end_);
+
+    // Reserve enough blocks for the whole dirty range now, so that running out of space
+    // fails this write rather than the flush.
+    if ((status = GetRequiredBlockCount(new_start * kMinfsBlockSize,
+                                        (new_end - new_start) * kMinfsBlockSize,
+                                        &reserve_blocks)) != ZX_OK) {
+        return status;
+    }
+    size_t reserved = dirty_promise_ ? dirty_promise_->GetReserved() : 0;
+    if (reserve_blocks > reserved) {
+        fbl::unique_ptr<Transaction> state;
+        if ((status = fs_->BeginTransaction(0, reserve_blocks - reserved, &state)) != ZX_OK) {
+            return status;
+        }
+        if (dirty_promise_) {
+            dirty_promise_->Merge(state->RemoveBlockPromise());
+        } else {
+            dirty_promise_ = state->RemoveBlockPromise();
+        }
+        // Reserving blocks may have grown the partition, which must be written out.
+        if (state->GetWork()->BlkCount() > 0) {
+            fs_->CommitTransaction(fbl::move(state));
+        }
+    }
+
+    if ((status = WriteInternal(nullptr, data, len, off, out_actual)) != ZX_OK) {
+        return status;
+    }
+    inode_.modify_time = GetTimeUTC();
+    dirty_start_ = new_start;
+    dirty_end_ = fbl::max(dirty_end_, static_cast<blk_t>(
+            fbl::round_up(off + *out_actual, kMinfsBlockSize) / kMinfsBlockSize));
+
+    if (dirty_end_ - dirty_start_ >= kMaxDirtyBlocks) {
+        return FlushDirty();
+    }
+    if (!flush_task_.is_pending() && fs_->dispatcher() != nullptr) {
+        flush_task_.PostDelayed(fs_->dispatcher(), kDirtyFlushDelay);
+    }
+    return ZX_OK;
+}
+
+zx_status_t VnodeMinfs::FlushDirty() {
+    if (dirty_start_ == dirty_end_) {
+        return ZX_OK;
+    }
+    TRACE_DURATION("minfs", "VnodeMinfs::FlushDirty", "ino", ino_, "blocks",
+                   dirty_end_ - dirty_start_);
+    flush_task_.Cancel();
+
+    fbl::unique_ptr<Transaction> state;
+    ZX_ASSERT(fs_->BeginTransaction(0, 0, &state) == ZX_OK);
+    state->SetBlockPromise(fbl::move(dirty_promise_));
+
+    // The range is allocated in order, so its blocks are as contiguous as free space allows.
+    zx_status_t status = ZX_OK;
+    for (blk_t n = dirty_start_; n < dirty_end_; n++) {
+        blk_t bno;
+        if ((status = BlockGet(state.get(), n, &bno)) != ZX_OK) {
+            FS_TRACE_ERROR("minfs: Failed to allocate block %u of inode %u: %d\n",
+                           n, ino_, status);
+            break;
+        }
+        ZX_DEBUG_ASSERT(bno != 0);
+        state->GetWork()->EnqueueData(vmo_.get(), n, bno + fs_->Info().dat_block, 1);
+    }
+    dirty_start_ = 0;
+    dirty_end_ = 0;
+
+    InodeSync(state->GetWork(), kMxFsSyncDefault);
+    state->GetWork()->PinVnode(fbl::move(fbl::WrapRefPtr(this)));
+    fs_->CommitTransaction(fbl::move(state));
+    return status;
+}
+
+void VnodeMinfs::DiscardDirty() {
+    flush_task_.Cancel();
+    dirty_start_ = 0;
+    dirty_end_ = 0;
+    dirty_promise_.reset();
+}
+
+void VnodeMinfs::FlushDirtyTask() {
+    zx_status_t status = FlushDirty();
+    if (status != ZX_OK) {
+        FS_TRACE_ERROR("minfs: Failed to flush inode %u: %d\n", ino_, status);
+    }
+}
+#endif
+
 // Internal write. Usable on directories.
 zx_status_t VnodeMinfs::WriteInternal(Transaction* state, const void* data,
                                       size_t len, size_t off, size_t* actual) {
@@ -1364,13 +1616,20 @@ zx_status_t VnodeMinfs::WriteInternal(Transaction* state, const void* data,
             goto done;
         }
 
-        // Update this block on-disk
-        blk_t bno;
-        if ((status = BlockGet(state, n, &bno))) {
-            goto done;
+        // Update this block on-disk, unless the caller leaves that for a flush
+        if (state != nullptr) {
+            blk_t bno;
+            if ((status = BlockGet(state, n, &bno))) {
+                goto done;
+            }
+            ZX_DEBUG_ASSERT(bno != 0);
+            // Directory blocks are metadata, and are journaled.
+            if (IsDirectory()) {
+                state->GetWork()->Enqueue(vmo_.get(), n, bno + fs_->Info().dat_block, 1);
+            } else {
+                state->GetWork()->EnqueueData(vmo_.get(), n, bno + fs_->Info().dat_block, 1);
+            }
         }
-        ZX_DEBUG_ASSERT(bno != 0);
-        state->GetWork()->Enqueue(vmo_.get(), n, bno + fs_->Info().dat_block, 1);
 #else
         blk_t bno;
         if ((status = BlockGet(state, n, &bno))) {
@@ -1438,7 +1697,7 @@ zx_status_t VnodeMinfs::LookupInternal(fbl::RefPtr<fs::Vnode>* out, fbl::StringP
     auto get_metrics = fbl::MakeAutoCall([&ticker, &success, this]() {
         fs_->UpdateLookupMetrics(success, ticker.End());
     });
-    if ((status = ForEachDirent(&args, DirentCallbackFind)) < 0) {
+    if ((status = LookupDirent(&args)) < 0) {
         return status;
     }
     fbl::RefPtr<VnodeMinfs> vn;
@@ -1627,7 +1886,7 @@ zx_status_t VnodeMinfs::Create(fbl::RefPtr<fs::Vnode>* out, fbl::StringPiece nam
     args.name = name;
     // ensure file does not exist
     zx_status_t status;
-    if ((status = ForEachDirent(&args, DirentCallbackFind)) != ZX_ERR_NOT_FOUND) {
+    if ((status = LookupDirent(&args)) != ZX_ERR_NOT_FOUND) {
         return ZX_ERR_ALREADY_EXISTS;
     }
 
@@ -1638,7 +1897,7 @@ zx_status_t VnodeMinfs::Create(fbl::RefPtr<fs::Vnode>* out, fbl::StringPiece nam
     // before updating any other metadata.
     args.type = type;
     args.reclen = static_cast<uint32_t>(DirentSize(static_cast<uint8_t>(name.length())));
-    status = ForEachDirent(&args, DirentCallbackFindSpace);
+    status = FindDirentSpace(&args);
     if (status == ZX_ERR_NOT_FOUND) {
         return ZX_ERR_NO_SPACE;
     } else if (status != ZX_OK) {
@@ -1780,10 +2039,18 @@ zx_status_t VnodeMinfs::Truncate(size_t len) {
         fs_->UpdateTruncateMetrics(ticker.End());
     });
 
+    zx_status_t status;
+#ifdef __Fuchsia__
+    // Give the dirty blocks their place on disk first, so that truncation frees them.
+    if ((status = FlushDirty()) != ZX_OK) {
+        return status;
+    }
+#endif
+
     fbl::unique_ptr<Transaction> state;
     // Since we will only edit existing blocks, no new blocks are required.
     ZX_ASSERT(fs_->BeginTransaction(0, 0, &state) == ZX_OK);
-    zx_status_t status = TruncateInternal(state.get(), len);
+    status = TruncateInternal(state.get(), len);
     if (status == ZX_OK) {
         // Successful truncates update inode
         InodeSync(state->GetWork(), kMxFsSyncMtime);
@@ -1852,7 +2119,13 @@ zx_status_t VnodeMinfs::TruncateInternal(Transaction* state, size_t len) {
                     FS_TRACE_ERROR("minfs: Truncate failed to write last block: %d\n", r);
                     return ZX_ERR_IO;
                 }
-                state->GetWork()->Enqueue(vmo_.get(), rel_bno, bno + fs_->Info().dat_block, 1);
+                if (IsDirectory()) {
+                    state->GetWork()->Enqueue(vmo_.get(), rel_bno,
+                                              bno + fs_->Info().dat_block, 1);
+                } else {
+                    state->GetWork()->EnqueueData(vmo_.get(), rel_bno,
+                                                  bno + fs_->Info().dat_block, 1);
+                }
 #else
                 if (fs_->bc_->Readblk(bno + fs_->Info().dat_block, bdata)) {
                     return ZX_ERR_IO;
@@ -1928,7 +2201,7 @@ zx_status_t VnodeMinfs::Rename(fbl::RefPtr<fs::Vnode> _newdir, fbl::StringPiece
     // acquire the 'oldname' node (it must exist)
     DirArgs args = DirArgs();
     args.name = oldname;
-    if ((status = ForEachDirent(&args, DirentCallbackFind)) < 0) {
+    if ((status = LookupDirent(&args)) < 0) {
         return status;
     } else if ((status = fs_->VnodeGet(&oldvn, args.ino)) < 0) {
         return status;
@@ -1951,7 +2224,7 @@ zx_status_t VnodeMinfs::Rename(fbl::RefPtr<fs::Vnode> _newdir, fbl::StringPiece
     args.type = oldvn->IsDirectory() ? kMinfsTypeDir : kMinfsTypeFile;
     args.reclen = static_cast<uint32_t>(DirentSize(static_cast<uint8_t>(newname.length())));
 
-    status = newdir->ForEachDirent(&args, DirentCallbackFindSpace);
+    status = newdir->FindDirentSpace(&args);
     if (status == ZX_ERR_NOT_FOUND) {
         return ZX_ERR_NO_SPACE;
     } else if (status != ZX_OK) {
@@ -1977,7 +2250,11 @@ zx_status_t VnodeMinfs::Rename(fbl::RefPtr<fs::Vnode> _newdir, fbl::StringPiece
     args.state = state.get();
     args.name = newname;
     args.ino = oldvn->ino_;
-    status = newdir->ForEachDirent(&args, DirentCallbackAttemptRename);
+    DirArgs existing = DirArgs();
+    existing.name = newname;
+    if ((status = newdir->LookupDirent(&existing)) == ZX_OK) {
+        status = newdir->ForEachDirent(&args, DirentCallbackAttemptRename);
+    }
     if (status == ZX_ERR_NOT_FOUND) {
         // if 'newname' does not exist, create it
         args.offs = append_offs;
@@ -2039,7 +2316,7 @@ zx_status_t VnodeMinfs::Link(fbl::StringPiece name, fbl::RefPtr<fs::Vnode> _targ
     DirArgs args = DirArgs();
     args.name = name;
     zx_status_t status;
-    if ((status = ForEachDirent(&args, DirentCallbackFind)) != ZX_ERR_NOT_FOUND) {
+    if ((status = LookupDirent(&args)) != ZX_ERR_NOT_FOUND) {
         return (status == ZX_OK) ? ZX_ERR_ALREADY_EXISTS : status;
     }
 
@@ -2047,7 +2324,7 @@ zx_status_t VnodeMinfs::Link(fbl::StringPiece name, fbl::RefPtr<fs::Vnode> _targ
     // before updating any other metadata.
     args.type = kMinfsTypeFile; // We can't hard link directories
     args.reclen = static_cast<uint32_t>(DirentSize(static_cast<uint8_t>(name.length())));
-    status = ForEachDirent(&args, DirentCallbackFindSpace);
+    status = FindDirentSpace(&args);
     if (status == ZX_ERR_NOT_FOUND) {
         return ZX_ERR_NO_SPACE;
     } else if (status != ZX_OK) {
@@ -2094,6 +2371,11 @@ zx_status_t VnodeMinfs::GetHandles(uint32_t flags, zx_handle_t* hnd, uint32_t* t
 
 void VnodeMinfs::Sync(SyncCallback closure) {
     TRACE_DURATION("minfs", "VnodeMinfs::Sync");
+    zx_status_t status = FlushDirty();
+    if (status != ZX_OK) {
+        closure(status);
+        return;
+    }
     fs_->Sync([this, cb = fbl::move(closure)](zx_status_t status) {
         if (status != ZX_OK) {
             cb(status);
@@ -13,6 +13,7 @@
 #endif
 
 #include <fbl/algorithm.h>
+#include <fbl/alloc_checker.h>
 #include <fbl/intrusive_hash_table.h>
 #include <fbl/intrusive_single_list.h>
 #include <fbl/macros.h>
@@ -28,11 +29,11 @@ namespace minfs {
 
 #ifdef __Fuchsia__
 
-void WriteTxn::Enqueue(zx_handle_t vmo, uint64_t vmo_offset, uint64_t dev_offset,
-                       uint64_t nblocks) {
+void WriteTxn::EnqueueRequest(zx_handle_t vmo, uint64_t vmo_offset, uint64_t dev_offset,
+                              uint64_t nblocks, bool data) {
     ValidateVmoSize(vmo, static_cast<blk_t>(vmo_offset));
     for (size_t i = 0; i < requests_.size(); i++) {
-        if (requests_[i].vmo != vmo) {
+        if (requests_[i].vmo != vmo || requests_[i].data != data) {
             continue;
         }
 
@@ -57,6 +58,7 @@ void WriteTxn::Enqueue(zx_handle_t vmo, uint64_t vmo_offset, uint64_t dev_offset
     request.vmo_offset = vmo_offset;
     request.dev_offset = dev_offset;
     request.length = nblocks;
+    request.data = data;
     requests_.push_back(fbl::move(request));
 }
 
@@ -87,6 +89,34 @@ zx_status_t WriteTxn::Flush(zx_handle_t vmo, vmoid_t vmoid) {
     return status;
 }
 
+zx_status_t WriteTxn::Send(vmoid_t vmoid, bool data) {
+    ZX_DEBUG_ASSERT(vmoid != VMOID_INVALID);
+
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<block_fifo_request_t[]> blk_reqs(
+        new (&ac) block_fifo_request_t[requests_.size()]);
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    const uint32_t kDiskBlocksPerMinfsBlock = kMinfsBlockSize / bc_->DeviceBlockSize();
+    size_t count = 0;
+    for (size_t i = 0; i < requests_.size(); i++) {
+        if (requests_[i].data != data) {
+            continue;
+        }
+        blk_reqs[count].group = bc_->BlockGroupID();
+        blk_reqs[count].vmoid = vmoid;
+        blk_reqs[count].opcode = BLOCKIO_WRITE;
+        blk_reqs[count].vmo_offset = requests_[i].vmo_offset * kDiskBlocksPerMinfsBlock;
+        blk_reqs[count].dev_offset = requests_[i].dev_offset * kDiskBlocksPerMinfsBlock;
+        uint64_t length = requests_[i].length * kDiskBlocksPerMinfsBlock;
+        ZX_ASSERT_MSG(length < UINT32_MAX, "Too many blocks");
+        blk_reqs[count].length = static_cast<uint32_t>(length);
+        count++;
+    }
+    return bc_->Transaction(blk_reqs.get(), count);
+}
+
 size_t WriteTxn::BlkCount() const {
     size_t blocks_needed = 0;
     for (size_t i = 0; i < requests_.size(); i++) {
@@ -126,6 +156,16 @@ size_t WritebackWork::Complete(zx_handle_t vmo, vmoid_t vmoid) {
     return blk_count;
 }
 
+size_t WritebackWork::Finish(zx_status_t status) {
+    size_t blk_count = BlkCount();
+    Requests().reset();
+    if (closure_) {
+        closure_(status);
+    }
+    Reset();
+    return blk_count;
+}
+
 void WritebackWork::SetClosure(SyncCallback closure) {
     ZX_DEBUG_ASSERT(!closure_);
     closure_ = fbl::move(closure);
@@ -153,8 +193,10 @@ void WritebackWork::PinVnode(fbl::RefPtr<VnodeMinfs> vn) {
 #ifdef __Fuchsia__
 
 zx_status_t WritebackBuffer::Create(Bcache* bc, fzl::OwnedVmoMapper mapper,
+                                    fbl::unique_ptr<Journal> journal,
                                     fbl::unique_ptr<WritebackBuffer>* out) {
-    fbl::unique_ptr<WritebackBuffer> wb(new WritebackBuffer(bc, fbl::move(mapper)));
+    fbl::unique_ptr<WritebackBuffer> wb(new WritebackBuffer(bc, fbl::move(mapper),
+                                                            fbl::move(journal)));
     if (wb->mapper_.size() % kMinfsBlockSize != 0) {
         return ZX_ERR_INVALID_ARGS;
     } else if (cnd_init(&wb->consumer_cvar_) != thrd_success) {
@@ -175,8 +217,9 @@ zx_status_t WritebackBuffer::Create(Bcache* bc, fzl::OwnedVmoMapper mapper,
     return ZX_OK;
 }
 
-WritebackBuffer::WritebackBuffer(Bcache* bc, fzl::OwnedVmoMapper mapper) :
-    bc_(bc), unmounting_(false), mapper_(fbl::move(mapper)),
+WritebackBuffer::WritebackBuffer(Bcache* bc, fzl::OwnedVmoMapper mapper,
+                                 fbl::unique_ptr<Journal> journal) :
+    bc_(bc), journal_(fbl::move(journal)), unmounting_(false), mapper_(fbl::move(mapper)),
     cap_(mapper_.size() / kMinfsBlockSize) {}
 
 WritebackBuffer::~WritebackBuffer() {
@@ -270,6 +313,7 @@ void WritebackBuffer::CopyToBufferLocked(WriteTxn* txn) {
             request.vmo_offset = 0;
             request.dev_offset = dev_offset;
             request.length = wb_len;
+            request.data = reqs[i].data;
             i++;
             reqs.insert(i, request);
         }
@@ -310,24 +354,119 @@ void WritebackBuffer::Enqueue(fbl::unique_ptr<WritebackWork> work) {
     cnd_signal(&consumer_cvar_);
 }
 
+namespace {
+
+// Returns true if |work| writes file data over any of the blocks of |metadata|.
+bool OverwritesMetadata(WritebackWork& work, const fbl::Vector<WriteRequest>& metadata) {
+    auto& reqs = work.Requests();
+    for (size_t i = 0; i < reqs.size(); i++) {
+        if (!reqs[i].data) {
+            continue;
+        }
+        for (size_t j = 0; j < metadata.size(); j++) {
+            if (reqs[i].dev_offset < metadata[j].dev_offset + metadata[j].length &&
+                metadata[j].dev_offset < reqs[i].dev_offset + reqs[i].length) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+size_t MetadataBlkCount(WritebackWork& work) {
+    auto& reqs = work.Requests();
+    size_t blocks = 0;
+    for (size_t i = 0; i < reqs.size(); i++) {
+        if (!reqs[i].data) {
+            blocks += reqs[i].length;
+        }
+    }
+    return blocks;
+}
+
+} // namespace
+
+size_t WritebackBuffer::CommitBatch(WorkQueue* batch) {
+    size_t blks_consumed = 0;
+    while (!batch->is_empty()) {
+        TRACE_DURATION("minfs", "WritebackBuffer::CommitBatch");
+        // Gather as much work as fits in one journal entry. Work which writes
+        // file data over metadata from earlier in the group starts a new group,
+        // since replaying the entry would write the metadata back over it.
+        fbl::Vector<fbl::unique_ptr<WritebackWork>> group;
+        fbl::Vector<WriteRequest> metadata;
+        size_t metadata_blocks = 0;
+        while (!batch->is_empty()) {
+            WritebackWork& work = batch->front();
+            size_t work_blocks = MetadataBlkCount(work);
+            if (!group.is_empty() &&
+                (metadata_blocks + work_blocks > journal_->EntryCapacity() ||
+                 OverwritesMetadata(work, metadata))) {
+                break;
+            }
+            auto& reqs = work.Requests();
+            for (size_t i = 0; i < reqs.size(); i++) {
+                if (!reqs[i].data) {
+                    metadata.push_back(reqs[i]);
+                }
+            }
+            metadata_blocks += work_blocks;
+            group.push_back(batch->pop());
+        }
+
+        // The file data needs no journal entry, but is written before the
+        // entry's flush so that newly allocated blocks never appear to hold
+        // anything but their new contents. Each unit of work is written in
+        // turn, so that later writes of a block land after earlier ones.
+        zx_status_t status = ZX_OK;
+        for (size_t i = 0; i < group.size() && status == ZX_OK; i++) {
+            status = group[i]->Write(buffer_vmoid_, true);
+        }
+        if (status == ZX_OK) {
+            status = journal_->Commit(metadata, mapper_.start(), buffer_vmoid_);
+        }
+        for (size_t i = 0; i < group.size() && status == ZX_OK; i++) {
+            status = group[i]->Write(buffer_vmoid_, false);
+        }
+        for (size_t i = 0; i < group.size(); i++) {
+            blks_consumed += group[i]->Finish(status);
+            TRACE_FLOW_END("minfs", "writeback",
+                           reinterpret_cast<trace_flow_id_t>(group[i].get()));
+        }
+    }
+    return blks_consumed;
+}
+
 int WritebackBuffer::WritebackThread(void* arg) {
     WritebackBuffer* b = reinterpret_cast<WritebackBuffer*>(arg);
 
     b->writeback_lock_.Acquire();
     while (true) {
         while (!b->work_queue_.is_empty()) {
-            auto work = b->work_queue_.pop();
             TRACE_DURATION("minfs", "WritebackBuffer::WritebackThread");
-
-            // Stay unlocked while processing a unit of work
-            b->writeback_lock_.Release();
-
-            // TODO(smklein): We could add additional validation that the blocks
-            // in "work" are contiguous and in the range of [start_, len_) (including
-            // wraparound).
-            size_t blks_consumed = work->Complete(b->mapper_.vmo().get(), b->buffer_vmoid_);
-            TRACE_FLOW_END("minfs", "writeback", reinterpret_cast<trace_flow_id_t>(work.get()));
-            work = nullptr;
+            size_t blks_consumed;
+            if (b->journal_ != nullptr) {
+                // All the work which is waiting shares journal entries.
+                WorkQueue batch;
+                while (!b->work_queue_.is_empty()) {
+                    batch.push(b->work_queue_.pop());
+                }
+                b->writeback_lock_.Release();
+                blks_consumed = b->CommitBatch(&batch);
+            } else {
+                auto work = b->work_queue_.pop();
+
+                // Stay unlocked while processing a unit of work
+                b->writeback_lock_.Release();
+
+                // TODO(smklein): We could add additional validation that the blocks
+                // in "work" are contiguous and in the range of [start_, len_) (including
+                // wraparound).
+                blks_consumed = work->Complete(b->mapper_.vmo().get(), b->buffer_vmoid_);
+                TRACE_FLOW_END("minfs", "writeback",
+                               reinterpret_cast<trace_flow_id_t>(work.get()));
+                work = nullptr;
+            }
 
             // Relock before checking the state of the queue
             b->writeback_lock_.Acquire();
@@ -0,0 +1,88 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include <fbl/algorithm.h>
+
+namespace perftest {
+
+// A histogram of latencies in nanoseconds, in fixed memory however many
+// operations a test runs.  Each power of two is split into 16 buckets, so
+// percentiles are accurate to within about 6%.
+class LatencyHistogram {
+public:
+    LatencyHistogram() { memset(buckets_, 0, sizeof(buckets_)); }
+
+    void Add(uint64_t value) {
+        buckets_[BucketOf(value)]++;
+        count_++;
+        sum_ += value;
+        min_ = fbl::min(min_, value);
+        max_ = fbl::max(max_, value);
+    }
+
+    void Merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < kNumBuckets; i++) {
+            buckets_[i] += other.buckets_[i];
+        }
+        count_ += other.count_;
+        sum_ += other.sum_;
+        min_ = fbl::min(min_, other.min_);
+        max_ = fbl::max(max_, other.max_);
+    }
+
+    uint64_t count() const { return count_; }
+    uint64_t min() const { return count_ ? min_ : 0; }
+    uint64_t max() const { return max_; }
+    uint64_t mean() const { return count_ ? sum_ / count_ : 0; }
+
+    // Returns the latency which |fraction| of the operations took at most,
+    // rounded down to the start of its bucket.
+    uint64_t Percentile(double fraction) const {
+        uint64_t rank = static_cast<uint64_t>(fraction * static_cast<double>(count_));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kNumBuckets; i++) {
+            seen += buckets_[i];
+            if (seen > rank) {
+                return fbl::clamp(BucketStart(i), min(), max_);
+            }
+        }
+        return max_;
+    }
+
+private:
+    static constexpr size_t kSubBits = 4;
+    static constexpr size_t kSubBuckets = 1u << kSubBits;
+    static constexpr size_t kNumBuckets = (64 - kSubBits + 1) * kSubBuckets;
+
+    static size_t BucketOf(uint64_t value) {
+        if (value < kSubBuckets) {
+            return static_cast<size_t>(value);
+        }
+        size_t msb = 63 - __builtin_clzll(value);
+        size_t sub = static_cast<size_t>(value >> (msb - kSubBits)) & (kSubBuckets - 1);
+        return (msb - kSubBits + 1) * kSubBuckets + sub;
+    }
+
+    static uint64_t BucketStart(size_t bucket) {
+        if (bucket < kSubBuckets) {
+            return bucket;
+        }
+        size_t msb = bucket / kSubBuckets + kSubBits - 1;
+        uint64_t sub = bucket % kSubBuckets;
+        return (kSubBuckets + sub) << (msb - kSubBits);
+    }
+
+    uint64_t buckets_[kNumBuckets];
+    uint64_t count_ = 0;
+    uint64_t sum_ = 0;
+    uint64_t min_ = UINT64_MAX;
+    uint64_t max_ = 0;
+};
+
+} // namespace perftest
@@ -56,7 +56,7 @@ void LauncherImpl::OnHandleReady(async_dispatcher_t* dispatcher, async::WaitBase
     }
 
     if (signal->observed & ZX_CHANNEL_READABLE) {
-        fidl::MessageBuffer buffer;
+        fidl::MessageBuffer buffer(fidl::MessageBufferPool::Default());
         for (uint64_t i = 0; i < signal->count; i++) {
             status = ReadAndDispatchMessage(&buffer);
             if (status == ZX_ERR_SHOULD_WAIT)
@@ -8,6 +8,7 @@
 #include <zircon/syscalls.h>
 #include <lib/sync/completion.h>
 #include <lib/sync/mutex.h>
+#include <lib/sync/internal/spin.h>
 
 namespace condition_impl_internal {
 
@@ -45,32 +46,14 @@ struct MutexOps {
 // Note that this library is used by libc, and as such needs to use
 // '_zx_' function names for syscalls and not the regular 'zx_' names.
 
-static inline void spin() {
-#if defined(__x86_64__)
-    __asm__ __volatile__("pause"
-                         :
-                         :
-                         : "memory");
-#elif defined(__aarch64__)
-    __atomic_thread_fence(__ATOMIC_SEQ_CST);
-#else
-#error Please define spin() for your architecture
-#endif
-}
-
 static inline bool cas(int* ptr, int* expected, int desired) {
     return __atomic_compare_exchange_n(ptr, expected, desired, false,
                                        __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
 }
 
 static inline void wait(int* futex, int current_value) {
-    int spins = 100;
-    while (spins--) {
-        if (__atomic_load_n(futex, __ATOMIC_SEQ_CST) == current_value) {
-            spin();
-        } else {
-            return;
-        }
+    if (sync_spin_while_equal(futex, current_value)) {
+        return;
     }
     while (__atomic_load_n(futex, __ATOMIC_SEQ_CST) == current_value) {
         _zx_futex_wait(futex, current_value, ZX_TIME_INFINITE);
@@ -0,0 +1,50 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef LIB_SYNC_INTERNAL_SPIN_H_
+#define LIB_SYNC_INTERNAL_SPIN_H_
+
+#include <stdbool.h>
+
+#include <zircon/compiler.h>
+#include <zircon/types.h>
+
+__BEGIN_CDECLS
+
+// Tells the CPU that the current thread is polling a value which another
+// CPU is expected to change soon.
+static inline void sync_spin_pause(void) {
+#if defined(__x86_64__)
+    __asm__ __volatile__("pause"
+                         :
+                         :
+                         : "memory");
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield"
+                         :
+                         :
+                         : "memory");
+#else
+#error Please define sync_spin_pause() for your architecture
+#endif
+}
+
+// Spins while |*futex| holds |value|, in the hope that the thread holding
+// the lock it represents releases it before the caller would have to go to
+// sleep in the kernel.
+//
+// The number of iterations is bounded and adapts to the number of
+// iterations it has recently taken for the value at this address to change,
+// so that callers keep spinning on locks with short critical sections but
+// quickly give up on locks which are held for a long time.  Consecutive
+// polls are spaced out with exponential backoff.  There is no spinning on
+// single-CPU systems.
+//
+// Returns true if the value changed, false if the caller should wait for
+// it in the kernel.
+bool sync_spin_while_equal(zx_futex_t* futex, int value);
+
+__END_CDECLS
+
+#endif // LIB_SYNC_INTERNAL_SPIN_H_
@@ -67,6 +67,17 @@ zx_status_t sync_mutex_trylock(sync_mutex_t* mutex);
 // Does nothing if the mutex is already unlocked.
 void sync_mutex_unlock(sync_mutex_t* mutex) __TA_RELEASE(mutex);
 
+// Priority-inheriting variants of the above.
+//
+// A mutex locked with these functions records the thread holding it, and the
+// threads blocked waiting for it lend their priority to that thread until it
+// releases the mutex. A given mutex must only ever be used with the |_pi|
+// functions, and cannot be used with |sync_condition_t|.
+void sync_mutex_lock_pi(sync_mutex_t* mutex) __TA_ACQUIRE(mutex);
+zx_status_t sync_mutex_timedlock_pi(sync_mutex_t* mutex, zx_time_t deadline);
+zx_status_t sync_mutex_trylock_pi(sync_mutex_t* mutex);
+void sync_mutex_unlock_pi(sync_mutex_t* mutex) __TA_RELEASE(mutex);
+
 __END_CDECLS
 
 #endif // LIB_SYNC_MUTEX_H_
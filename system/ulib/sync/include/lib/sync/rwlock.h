@@ -0,0 +1,77 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef LIB_SYNC_RWLOCK_H_
+#define LIB_SYNC_RWLOCK_H_
+
+#include <zircon/compiler.h>
+#include <zircon/types.h>
+
+__BEGIN_CDECLS
+
+// The number of reader counters in a |sync_rwlock_t|.
+#define SYNC_RWLOCK_NUM_SLOTS 8
+
+// A reader-writer lock for data which is read much more often than it is
+// written, with a preference for writers.
+//
+// The |pthread_rwlock_t| lock in the standard library keeps its readers in
+// a single counter, so every reader writes to the same cache line and
+// readers running on different CPUs slow each other down.
+//
+// |sync_rwlock| instead spreads its readers over |SYNC_RWLOCK_NUM_SLOTS|
+// counters, each on its own cache line, chosen by the reading thread.
+// Readers only read the shared state of the lock, so they don't contend
+// with each other unless they happen to share a counter.  In exchange,
+// writers have to check every counter, which makes write locking more
+// expensive.
+//
+// Once a writer is waiting for the lock, new readers wait for it to be
+// released, so readers cannot starve writers.
+//
+// A read lock must be released by the thread which acquired it.  The lock
+// is non-recursive: a thread which holds a read lock must not try to
+// acquire it again, since a writer might be waiting for the lock.
+typedef struct __TA_CAPABILITY("mutex") sync_rwlock {
+    // The counters are padded rather than aligned so that rwlocks can be
+    // embedded in objects allocated with malloc().
+    struct {
+        zx_futex_t readers;
+        char padding[64 - sizeof(zx_futex_t)];
+    } slots[SYNC_RWLOCK_NUM_SLOTS];
+
+    // Non-zero while a writer is waiting for or holding the lock.  Both
+    // waiting readers and waiting writers sleep on this futex.
+    zx_futex_t writer;
+
+#ifdef __cplusplus
+    sync_rwlock()
+        : slots(), writer(0) {}
+#endif
+} sync_rwlock_t;
+
+#if !defined(__cplusplus)
+#define SYNC_RWLOCK_INIT ((sync_rwlock_t){{{0}}})
+#endif
+
+// Locks the rwlock for reading.
+//
+// The current thread will block until no writer holds or is waiting for the
+// lock.
+void sync_rwlock_read_lock(sync_rwlock_t* rwlock) __TA_ACQUIRE_SHARED(rwlock);
+
+// Unlocks the rwlock, which the current thread holds for reading.
+void sync_rwlock_read_unlock(sync_rwlock_t* rwlock) __TA_RELEASE_SHARED(rwlock);
+
+// Locks the rwlock for writing.
+//
+// The current thread will block until no other thread holds the lock.
+void sync_rwlock_write_lock(sync_rwlock_t* rwlock) __TA_ACQUIRE(rwlock);
+
+// Unlocks the rwlock, which the current thread holds for writing.
+void sync_rwlock_write_unlock(sync_rwlock_t* rwlock) __TA_RELEASE(rwlock);
+
+__END_CDECLS
+
+#endif // LIB_SYNC_RWLOCK_H_
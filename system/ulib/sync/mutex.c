@@ -4,6 +4,8 @@
 
 #include <lib/sync/mutex.h>
 
+#include <lib/sync/internal/spin.h>
+#include <zircon/process.h>
 #include <zircon/syscalls.h>
 #include <stdatomic.h>
 
@@ -21,6 +23,23 @@ enum {
     LOCKED_WITH_WAITERS = 2
 };
 
+// When the mutex is held by another thread but nobody is waiting for it yet,
+// spin briefly in the hope that it is released soon, and try to claim it
+// with |new_state| if it was.  Spinning and claiming the mutex like this
+// avoids the cost of sleeping in, and being woken up by, the kernel for
+// short critical sections.
+//
+// On failure, |*old_state| is updated with the mutex's current state.
+static bool spin_lock(sync_mutex_t* mutex, int new_state, int* old_state) {
+    if (*old_state != LOCKED_WITHOUT_WAITERS ||
+        !sync_spin_while_equal(&mutex->futex, LOCKED_WITHOUT_WAITERS)) {
+        return false;
+    }
+    *old_state = UNLOCKED;
+    return atomic_compare_exchange_strong(&mutex->futex, old_state,
+                                          new_state);
+}
+
 // On success, this will leave the mutex in the LOCKED_WITH_WAITERS state.
 static zx_status_t lock_slow_path(sync_mutex_t* mutex, zx_time_t deadline,
                                   int old_state) {
@@ -63,7 +82,8 @@ zx_status_t sync_mutex_timedlock(sync_mutex_t* mutex, zx_time_t deadline) {
     // memory barrier that locking a mutex is required to execute.
     int old_state = UNLOCKED;
     if (atomic_compare_exchange_strong(&mutex->futex, &old_state,
-                                       LOCKED_WITHOUT_WAITERS)) {
+                                       LOCKED_WITHOUT_WAITERS) ||
+        spin_lock(mutex, LOCKED_WITHOUT_WAITERS, &old_state)) {
         return ZX_OK;
     }
     return lock_slow_path(mutex, deadline, old_state);
@@ -79,7 +99,8 @@ void sync_mutex_lock(sync_mutex_t* mutex) __TA_NO_THREAD_SAFETY_ANALYSIS {
 void sync_mutex_lock_with_waiter(sync_mutex_t* mutex) __TA_NO_THREAD_SAFETY_ANALYSIS {
     int old_state = UNLOCKED;
     if (atomic_compare_exchange_strong(&mutex->futex, &old_state,
-                                       LOCKED_WITH_WAITERS)) {
+                                       LOCKED_WITH_WAITERS) ||
+        spin_lock(mutex, LOCKED_WITH_WAITERS, &old_state)) {
         return;
     }
     zx_status_t status = lock_slow_path(mutex, ZX_TIME_INFINITE, old_state);
@@ -122,3 +143,82 @@ void sync_mutex_unlock(sync_mutex_t* mutex) __TA_NO_THREAD_SAFETY_ANALYSIS {
             break;
     }
 }
+
+// Priority-inheriting mutexes store the handle of the thread holding them
+// in the futex, so that waiters can tell the kernel whom to lend their
+// priority to.  Thread handles are never 0 and never have PI_CONTESTED
+// set, which marks the mutex as having waiters.
+#define PI_CONTESTED ((int)0x80000000)
+
+zx_status_t sync_mutex_trylock_pi(sync_mutex_t* mutex) {
+    int old_state = UNLOCKED;
+    if (atomic_compare_exchange_strong(&mutex->futex, &old_state,
+                                       (int)_zx_thread_self())) {
+        return ZX_OK;
+    }
+    return ZX_ERR_BAD_STATE;
+}
+
+zx_status_t sync_mutex_timedlock_pi(sync_mutex_t* mutex, zx_time_t deadline) {
+    const int self = (int)_zx_thread_self();
+    int old_state = UNLOCKED;
+    if (atomic_compare_exchange_strong(&mutex->futex, &old_state, self)) {
+        return ZX_OK;
+    }
+
+    for (;;) {
+        // Mark the mutex as contested so that the owner wakes us up, then
+        // wait while lending our priority to the owner.
+        int contested = old_state | PI_CONTESTED;
+        if (old_state != UNLOCKED &&
+            (old_state == contested ||
+             atomic_compare_exchange_strong(&mutex->futex, &old_state,
+                                            contested))) {
+            zx_handle_t owner = (zx_handle_t)(contested & ~PI_CONTESTED);
+            zx_status_t status = _zx_futex_wait_pi(&mutex->futex, contested,
+                                                   owner, deadline);
+            if (status != ZX_OK && status != ZX_ERR_BAD_STATE &&
+                status != ZX_ERR_TIMED_OUT) {
+                // The owner exited without unlocking, or is ourselves.
+                // Nobody can lend it a priority, so just wait.
+                status = _zx_futex_wait(&mutex->futex, contested, deadline);
+            }
+            if (status == ZX_ERR_TIMED_OUT)
+                return ZX_ERR_TIMED_OUT;
+        }
+
+        // As in lock_slow_path(), claim the mutex as contested, since other
+        // threads may still be waiting for it.
+        old_state = UNLOCKED;
+        if (atomic_compare_exchange_strong(&mutex->futex, &old_state,
+                                           self | PI_CONTESTED)) {
+            return ZX_OK;
+        }
+    }
+}
+
+void sync_mutex_lock_pi(sync_mutex_t* mutex) __TA_NO_THREAD_SAFETY_ANALYSIS {
+    zx_status_t status = sync_mutex_timedlock_pi(mutex, ZX_TIME_INFINITE);
+    if (status != ZX_OK) {
+        __builtin_trap();
+    }
+}
+
+void sync_mutex_unlock_pi(sync_mutex_t* mutex) __TA_NO_THREAD_SAFETY_ANALYSIS {
+    int old_state = atomic_exchange(&mutex->futex, UNLOCKED);
+
+    // As in sync_mutex_unlock(), |mutex| must not be dereferenced from
+    // this point onwards.
+
+    if (old_state == UNLOCKED) {
+        __builtin_trap();
+    }
+    if (old_state & PI_CONTESTED) {
+        // Waking a single waiter makes the kernel move the priority lent
+        // by the remaining waiters over to it.
+        zx_status_t status = _zx_futex_wake(&mutex->futex, 1);
+        if (status != ZX_OK) {
+            __builtin_trap();
+        }
+    }
+}
@@ -13,6 +13,8 @@ MODULE_SRCS += \
     $(LOCAL_DIR)/completion.c \
     $(LOCAL_DIR)/condition.cpp \
     $(LOCAL_DIR)/mutex.c \
+    $(LOCAL_DIR)/rwlock.c \
+    $(LOCAL_DIR)/spin.c \
 
 MODULE_LIBS := \
     system/ulib/zircon \
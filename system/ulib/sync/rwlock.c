@@ -0,0 +1,141 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <lib/sync/rwlock.h>
+
+#include <lib/sync/internal/spin.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <zircon/process.h>
+#include <zircon/syscalls.h>
+
+// The writer futex is a mutex as in mutex.c, except that readers wait
+// on it too, so that releasing it wakes up all of its waiters.
+//
+// All values must be 0 when unlocked so that rwlocks can be allocated in
+// BSS segments (zero-initialized data).
+enum {
+    UNLOCKED = 0,
+    LOCKED_WITHOUT_WAITERS = 1,
+    LOCKED_WITH_WAITERS = 2
+};
+
+// Set in a reader counter while a writer waits for the count to drop to
+// zero.  The low bits count the readers using that counter.
+#define WRITER_WAITING 0x40000000
+
+// Readers of a given thread always use the same counter, so that they
+// release the counter they incremented.  The thread's handle is cheap to
+// get and unique while the thread is running.
+static zx_futex_t* get_readers(sync_rwlock_t* rwlock) {
+    uintptr_t handle = (uintptr_t)_zx_thread_self();
+    size_t index = ((handle >> 2) ^ (handle >> 8)) % SYNC_RWLOCK_NUM_SLOTS;
+    return &rwlock->slots[index].readers;
+}
+
+static void release_readers(zx_futex_t* readers) {
+    // Wake up the writer if this was the last reader it was waiting for.
+    // As in sync_mutex_unlock(), the rwlock could have been freed by the
+    // time the writer is woken up, which is harmless.
+    if (atomic_fetch_sub(readers, 1) == WRITER_WAITING + 1) {
+        zx_status_t status = _zx_futex_wake(readers, 1);
+        if (status != ZX_OK) {
+            __builtin_trap();
+        }
+    }
+}
+
+// Waits until the writer futex is no longer |state|, which must not
+// be UNLOCKED.
+static void wait_for_writer(sync_rwlock_t* rwlock, int state) {
+    if (sync_spin_while_equal(&rwlock->writer, state)) {
+        return;
+    }
+    if (state == LOCKED_WITH_WAITERS ||
+        atomic_compare_exchange_strong(&rwlock->writer, &state,
+                                       LOCKED_WITH_WAITERS)) {
+        _zx_futex_wait(&rwlock->writer, LOCKED_WITH_WAITERS,
+                       ZX_TIME_INFINITE);
+    }
+}
+
+void sync_rwlock_read_lock(sync_rwlock_t* rwlock) __TA_NO_THREAD_SAFETY_ANALYSIS {
+    zx_futex_t* readers = get_readers(rwlock);
+    for (;;) {
+        // New readers wait for a pending writer rather than delaying it.
+        int state = atomic_load(&rwlock->writer);
+        if (state == UNLOCKED) {
+            // Announce this reader before checking for writers again.
+            // Writers do the opposite, and these operations are
+            // sequentially consistent, so either the writer sees this
+            // reader or this reader sees the writer.
+            atomic_fetch_add(readers, 1);
+            state = atomic_load(&rwlock->writer);
+            if (state == UNLOCKED) {
+                return;
+            }
+            release_readers(readers);
+        }
+        wait_for_writer(rwlock, state);
+    }
+}
+
+void sync_rwlock_read_unlock(sync_rwlock_t* rwlock) __TA_NO_THREAD_SAFETY_ANALYSIS {
+    release_readers(get_readers(rwlock));
+}
+
+void sync_rwlock_write_lock(sync_rwlock_t* rwlock) __TA_NO_THREAD_SAFETY_ANALYSIS {
+    // Claim the writer futex as in sync_mutex_lock().  Readers stop
+    // acquiring the rwlock from this point on.
+    int state = UNLOCKED;
+    if (!atomic_compare_exchange_strong(&rwlock->writer, &state,
+                                        LOCKED_WITHOUT_WAITERS)) {
+        for (;;) {
+            if (state == LOCKED_WITH_WAITERS ||
+                (state == LOCKED_WITHOUT_WAITERS &&
+                 atomic_compare_exchange_strong(&rwlock->writer, &state,
+                                                LOCKED_WITH_WAITERS))) {
+                _zx_futex_wait(&rwlock->writer, LOCKED_WITH_WAITERS,
+                               ZX_TIME_INFINITE);
+            }
+
+            // Other threads may still be waiting, so the futex must be
+            // left as LOCKED_WITH_WAITERS.
+            state = UNLOCKED;
+            if (atomic_compare_exchange_strong(&rwlock->writer, &state,
+                                               LOCKED_WITH_WAITERS)) {
+                break;
+            }
+        }
+    }
+
+    // Wait for the readers which already hold the rwlock to release it.
+    // New readers back off as soon as they see the writer, so each
+    // counter only needs to be flagged while waiting for it to drain.
+    for (size_t i = 0; i < SYNC_RWLOCK_NUM_SLOTS; i++) {
+        zx_futex_t* readers = &rwlock->slots[i].readers;
+        int value = atomic_fetch_or(readers, WRITER_WAITING) | WRITER_WAITING;
+        while (value != WRITER_WAITING) {
+            if (!sync_spin_while_equal(readers, value)) {
+                _zx_futex_wait(readers, value, ZX_TIME_INFINITE);
+            }
+            value = atomic_load(readers);
+        }
+        atomic_fetch_and(readers, ~WRITER_WAITING);
+    }
+}
+
+void sync_rwlock_write_unlock(sync_rwlock_t* rwlock) __TA_NO_THREAD_SAFETY_ANALYSIS {
+    // As in sync_mutex_unlock(), |rwlock| must not be dereferenced after
+    // this swap.
+    int state = atomic_exchange(&rwlock->writer, UNLOCKED);
+    if (state == LOCKED_WITH_WAITERS) {
+        // Both readers and writers may be waiting.  Wake them all up and
+        // let them race for the rwlock.
+        zx_status_t status = _zx_futex_wake(&rwlock->writer, UINT32_MAX);
+        if (status != ZX_OK) {
+            __builtin_trap();
+        }
+    }
+}
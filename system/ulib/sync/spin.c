@@ -0,0 +1,77 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <lib/sync/internal/spin.h>
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include <zircon/syscalls.h>
+
+// Spin counts are measured in calls to sync_spin_pause().
+
+// The most a caller spins for before going to sleep.  This is roughly the
+// cost of waiting for a futex and being woken up again.
+#define MAX_SPINS 200
+
+// The most calls to sync_spin_pause() between two polls of the value.
+#define MAX_BACKOFF 16
+
+// Estimates of the number of spins it takes for a contended lock to be
+// released, in the style of glibc's adaptive mutexes.  The lock types using
+// this have no room to keep an estimate per lock, so locks share the entries
+// of a small table indexed by their address instead.  The table is
+// zero-initialized so that it can be used during early startup.
+#define NUM_ESTIMATES 64
+static atomic_int g_spin_estimates[NUM_ESTIMATES];
+
+// 0 until first used.
+static atomic_int g_num_cpus;
+
+static atomic_int* get_estimate(zx_futex_t* futex) {
+    uintptr_t addr = (uintptr_t)futex;
+    // Locks are at least 4-byte aligned and often embedded in larger
+    // objects, so mix in the higher bits too.
+    size_t index = ((addr >> 2) ^ (addr >> 8) ^ (addr >> 14)) % NUM_ESTIMATES;
+    return &g_spin_estimates[index];
+}
+
+bool sync_spin_while_equal(zx_futex_t* futex, int value) {
+    int num_cpus = atomic_load_explicit(&g_num_cpus, memory_order_relaxed);
+    if (num_cpus == 0) {
+        num_cpus = (int)_zx_system_get_num_cpus();
+        atomic_store_explicit(&g_num_cpus, num_cpus, memory_order_relaxed);
+    }
+    if (num_cpus < 2)
+        return false;
+
+    // Spin for up to about twice the usual time it takes to get the lock,
+    // so that the estimate can also grow.
+    atomic_int* estimate = get_estimate(futex);
+    int old_estimate = atomic_load_explicit(estimate, memory_order_relaxed);
+    int max_spins = 2 * old_estimate + 10;
+    if (max_spins > MAX_SPINS)
+        max_spins = MAX_SPINS;
+
+    bool changed = false;
+    int spins = 0;
+    int backoff = 1;
+    while (spins < max_spins) {
+        for (int i = 0; i < backoff; i++)
+            sync_spin_pause();
+        spins += backoff;
+        if (atomic_load_explicit(futex, memory_order_acquire) != value) {
+            changed = true;
+            break;
+        }
+        if (backoff < MAX_BACKOFF)
+            backoff *= 2;
+    }
+
+    // Move the estimate an eighth of the way towards this observation.
+    // Racing updates from other threads may be lost, which is harmless.
+    atomic_store_explicit(estimate, old_estimate + (spins - old_estimate) / 8,
+                          memory_order_relaxed);
+    return changed;
+}
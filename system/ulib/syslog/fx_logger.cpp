@@ -5,6 +5,7 @@
 #include <fbl/algorithm.h>
 #include <fbl/auto_lock.h>
 #include <fbl/string_buffer.h>
+#include <lib/zx/vmar.h>
 #include <zircon/assert.h>
 
 #include <lib/syslog/logger.h>
@@ -28,6 +29,75 @@ zx_koid_t GetCurrentThreadKoid() {
 
 } // namespace
 
+fx_logger::~fx_logger() {
+    if (ring_ != nullptr) {
+        zx::vmar::root_self()->unmap(reinterpret_cast<uintptr_t>(ring_), ring_mapping_size_);
+    }
+}
+
+void fx_logger::MapRing(zx::vmo vmo) {
+    uint64_t size;
+    if (vmo.get_size(&size) != ZX_OK || size < FX_LOG_RING_DATA_OFFSET) {
+        return;
+    }
+    uintptr_t addr;
+    if (zx::vmar::root_self()->map(0, vmo, 0, size, ZX_VM_PERM_READ | ZX_VM_PERM_WRITE,
+                                   &addr) != ZX_OK) {
+        return;
+    }
+    auto ring = reinterpret_cast<fx_log_ring_header_t*>(addr);
+    uint32_t data_size = __atomic_load_n(&ring->data_size, __ATOMIC_RELAXED);
+    if (__atomic_load_n(&ring->magic, __ATOMIC_ACQUIRE) != FX_LOG_RING_MAGIC ||
+        data_size < FX_LOG_RING_MIN_DATA_SIZE || (data_size & (data_size - 1)) != 0 ||
+        FX_LOG_RING_DATA_OFFSET + data_size > size) {
+        zx::vmar::root_self()->unmap(addr, size);
+        return;
+    }
+    ring_vmo_ = fbl::move(vmo);
+    ring_ = ring;
+    ring_mapping_size_ = size;
+}
+
+zx_status_t fx_logger::WriteToRing(const fx_log_packet_t* packet, size_t size) {
+    char* data = reinterpret_cast<char*>(ring_) + FX_LOG_RING_DATA_OFFSET;
+    const uint64_t data_size = ring_->data_size;
+    const uint64_t record_len = FX_LOG_RING_RECORD_ALIGN(FX_LOG_RING_RECORD_HEADER_LEN + size);
+
+    // Reserve room for the record, and for padding up to the end of the
+    // data area if it would not fit before it.
+    uint64_t head = __atomic_load_n(&ring_->head, __ATOMIC_RELAXED);
+    uint64_t pad_len;
+    do {
+        uint64_t tail = __atomic_load_n(&ring_->tail, __ATOMIC_ACQUIRE);
+        uint64_t offset = head & (data_size - 1);
+        pad_len = data_size - offset < record_len ? data_size - offset : 0;
+        if (head + pad_len + record_len - tail > data_size) {
+            __atomic_fetch_add(&ring_->dropped, 1, __ATOMIC_RELAXED);
+            return ZX_ERR_SHOULD_WAIT;
+        }
+    } while (!__atomic_compare_exchange_n(&ring_->head, &head, head + pad_len + record_len,
+                                          true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    if (pad_len != 0) {
+        auto word = reinterpret_cast<uint32_t*>(data + (head & (data_size - 1)));
+        __atomic_store_n(word, static_cast<uint32_t>(pad_len) | FX_LOG_RING_RECORD_PAD_FLAG,
+                         __ATOMIC_RELEASE);
+        head += pad_len;
+    }
+    char* record = data + (head & (data_size - 1));
+    memcpy(record + FX_LOG_RING_RECORD_HEADER_LEN, packet, size);
+    // Publishing the record and checking on the reader must not be
+    // reordered, or a reader going idle could miss it.
+    __atomic_store_n(reinterpret_cast<uint32_t*>(record), static_cast<uint32_t>(record_len),
+                     __ATOMIC_SEQ_CST);
+
+    if (__atomic_load_n(&ring_->reader_idle, __ATOMIC_SEQ_CST) != 0 &&
+        __atomic_exchange_n(&ring_->reader_idle, 0, __ATOMIC_SEQ_CST) != 0) {
+        return ring_vmo_.signal(0, ZX_USER_SIGNAL_0);
+    }
+    return ZX_OK;
+}
+
 void fx_logger::ActivateFallback(int fallback_fd) {
     fbl::AutoLock lock(&fallback_mutex_);
     if (logger_fd_.load(fbl::memory_order_relaxed) != -1) {
@@ -51,9 +121,9 @@ void fx_logger::ActivateFallback(int fallback_fd) {
     logger_fd_.store(fallback_fd, fbl::memory_order_relaxed);
 }
 
-zx_status_t fx_logger::VLogWriteToSocket(fx_log_severity_t severity,
-                                         const char* tag, const char* msg,
-                                         va_list args, bool perform_format) {
+zx_status_t fx_logger::VLogWriteToService(fx_log_severity_t severity,
+                                          const char* tag, const char* msg,
+                                          va_list args, bool perform_format) {
     zx_time_t time = zx_clock_get_monotonic();
     fx_log_packet_t packet;
     memset(&packet, 0, sizeof(packet));
@@ -113,6 +183,13 @@ zx_status_t fx_logger::VLogWriteToSocket(fx_log_severity_t severity,
     }
     auto size = sizeof(packet.metadata) + msg_pos + count + 1;
     ZX_DEBUG_ASSERT(size <= sizeof(packet));
+    if (ring_ != nullptr) {
+        auto status = WriteToRing(&packet, size);
+        if (status != ZX_OK) {
+            dropped_logs_.fetch_add(1);
+        }
+        return status;
+    }
     auto status = socket_.write(0, &packet, size, nullptr);
     if (status == ZX_ERR_BAD_STATE || status == ZX_ERR_PEER_CLOSED) {
         ActivateFallback(-1);
@@ -202,8 +279,8 @@ zx_status_t fx_logger::VLogWrite(fx_log_severity_t severity, const char* tag,
     int fd = logger_fd_.load(fbl::memory_order_relaxed);
     if (fd != -1) {
         status = VLogWriteToFd(fd, severity, tag, msg, args, perform_format);
-    } else if (socket_.is_valid()) {
-        status = VLogWriteToSocket(severity, tag, msg, args, perform_format);
+    } else if (socket_.is_valid() || ring_ != nullptr) {
+        status = VLogWriteToService(severity, tag, msg, args, perform_format);
     } else {
         return ZX_ERR_BAD_STATE;
     }
@@ -6,6 +6,7 @@
 #define ZIRCON_SYSTEM_ULIB_SYSLOG_FX_LOGGER_H_
 
 #include <lib/syslog/logger.h>
+#include <lib/syslog/wire_format.h>
 
 #include <fbl/mutex.h>
 #include <fbl/string.h>
@@ -14,6 +15,7 @@
 #include <lib/zx/process.h>
 #include <lib/zx/socket.h>
 #include <lib/zx/thread.h>
+#include <lib/zx/vmo.h>
 
 namespace {
 
@@ -24,6 +26,13 @@ zx_koid_t GetKoid(zx_handle_t handle) {
     return status == ZX_OK ? info.koid : ZX_KOID_INVALID;
 }
 
+zx_obj_type_t GetType(zx_handle_t handle) {
+    zx_info_handle_basic_t info;
+    zx_status_t status = zx_object_get_info(handle, ZX_INFO_HANDLE_BASIC, &info,
+                                            sizeof(info), nullptr, nullptr);
+    return status == ZX_OK ? info.type : ZX_OBJ_TYPE_NONE;
+}
+
 zx_koid_t GetCurrentProcessKoid() {
     auto koid = GetKoid(zx_process_self());
     ZX_DEBUG_ASSERT(koid != ZX_KOID_INVALID);
@@ -39,16 +48,21 @@ public:
     // So they should be validated before calling this constructor.
     fx_logger(const fx_logger_config_t* config) {
         pid_ = GetCurrentProcessKoid();
-        socket_.reset(config->log_service_channel);
+        if (GetType(config->log_service_channel) == ZX_OBJ_TYPE_VMO) {
+            MapRing(zx::vmo(config->log_service_channel));
+        } else {
+            socket_.reset(config->log_service_channel);
+        }
         fd_to_close_.reset(config->console_fd);
         logger_fd_.store(config->console_fd, fbl::memory_order_relaxed);
         SetSeverity(config->min_severity);
-        ZX_DEBUG_ASSERT(fd_to_close_ != socket_.is_valid());
+        ZX_DEBUG_ASSERT((config->console_fd != -1) !=
+                        (config->log_service_channel != ZX_HANDLE_INVALID));
         AddTags(config->tags, config->num_tags);
         dropped_logs_.store(0, fbl::memory_order_relaxed);
     }
 
-    ~fx_logger() = default;
+    ~fx_logger();
 
     zx_status_t VLogWrite(fx_log_severity_t severity, const char* tag,
                           const char* format, va_list args) {
@@ -75,8 +89,14 @@ private:
     zx_status_t VLogWrite(fx_log_severity_t severity, const char* tag,
                           const char* format, va_list args, bool perform_format);
 
-    zx_status_t VLogWriteToSocket(fx_log_severity_t severity, const char* tag,
-                                  const char* msg, va_list args, bool perform_format);
+    zx_status_t VLogWriteToService(fx_log_severity_t severity, const char* tag,
+                                   const char* msg, va_list args, bool perform_format);
+
+    // Takes |vmo| as the shared memory ring, if it holds a valid one.
+    void MapRing(zx::vmo vmo);
+
+    // Publishes |size| bytes of |packet| in the shared memory ring.
+    zx_status_t WriteToRing(const fx_log_packet_t* packet, size_t size);
 
     zx_status_t VLogWriteToFd(int fd, fx_log_severity_t severity, const char* tag,
                               const char* msg, va_list args, bool perform_format);
@@ -88,6 +108,12 @@ private:
     fbl::atomic<uint32_t> dropped_logs_;
     fbl::atomic<int> logger_fd_;
     zx::socket socket_;
+
+    // The shared memory ring, if the log service handed us one instead of
+    // a socket.
+    zx::vmo ring_vmo_;
+    fx_log_ring_header_t* ring_ = nullptr;
+    size_t ring_mapping_size_ = 0;
     fbl::Vector<fbl::String> tags_;
 
     // This field is just used to close fd when
@@ -35,4 +35,50 @@ typedef struct fx_log_packet {
     char data[FX_LOG_MAX_DATAGRAM_LEN - sizeof(fx_log_metadata_t)];
 } fx_log_packet_t;
 
+// Shared memory ring transport.
+//
+// Instead of a socket the log service may hand the logger a VMO holding a
+// ring of packets, passed as |log_service_channel|.  Writing a log is then
+// a memory write, with no syscall unless the reader is asleep.  The VMO
+// starts with an fx_log_ring_header_t, initialized by whoever creates the
+// ring, followed by the data area at FX_LOG_RING_DATA_OFFSET.
+//
+// Any number of writers reserve space by advancing |head| with a
+// compare-and-swap, copy their record in, and then store its length word,
+// which publishes it.  A record which would run past the end of the data
+// area is preceded by a padding record filling the rest of it.  When the
+// ring is too full for a record the writer drops it and increments
+// |dropped|.
+//
+// The single reader consumes the published record at |tail|, if any, zeroes
+// the space it took and then advances |tail| past it.  Before waiting it
+// sets |reader_idle| and checks the ring once more; a writer which finds
+// |reader_idle| set after publishing a record clears it and raises
+// ZX_USER_SIGNAL_0 on the VMO.
+//
+// All fields are accessed atomically; |head|, |tail| and the record length
+// words are byte offsets which only ever grow, taken modulo |data_size|.
+typedef struct fx_log_ring_header {
+    uint32_t magic;
+    // The size of the data area in bytes.  A power of two, at least
+    // FX_LOG_RING_MIN_DATA_SIZE.
+    uint32_t data_size;
+    uint64_t head;
+    uint64_t tail;
+    uint32_t reader_idle;
+    uint32_t dropped;
+} fx_log_ring_header_t;
+
+#define FX_LOG_RING_MAGIC (0x676f6c66) // "flog"
+#define FX_LOG_RING_DATA_OFFSET (64)
+#define FX_LOG_RING_MIN_DATA_SIZE (4096)
+
+// Each record starts with a length word, giving the size of the whole
+// record including the word, followed by 4 bytes of padding and then an
+// fx_log_packet_t trimmed to its used length.  Records are 8 byte aligned.
+#define FX_LOG_RING_RECORD_PAD_FLAG (0x80000000u)
+#define FX_LOG_RING_RECORD_LEN_MASK (0x7fffffffu)
+#define FX_LOG_RING_RECORD_HEADER_LEN (8)
+#define FX_LOG_RING_RECORD_ALIGN(n) (((n) + 7) & ~((size_t)7))
+
 #endif // LIB_SYSLOG_WIRE_FORMAT_H_
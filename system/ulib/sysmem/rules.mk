@@ -20,6 +20,7 @@ MODULE_HEADER_DEPS := \
     system/ulib/svc \
 
 MODULE_STATIC_LIBS := \
+    system/ulib/async.cpp \
     system/ulib/async \
     system/ulib/fidl \
     system/ulib/fbl \
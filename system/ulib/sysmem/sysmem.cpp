@@ -5,8 +5,14 @@
 #include <lib/sysmem/sysmem.h>
 
 #include <fbl/algorithm.h>
+#include <fbl/alloc_checker.h>
+#include <fbl/intrusive_double_list.h>
+#include <fbl/intrusive_single_list.h>
+#include <fbl/unique_ptr.h>
 #include <fuchsia/sysmem/c/fidl.h>
+#include <lib/async/cpp/wait.h>
 #include <lib/fidl/bind.h>
+#include <lib/zx/eventpair.h>
 #include <lib/zx/vmo.h>
 #include <string.h>
 #include <lib/syslog/global.h>
@@ -14,6 +20,8 @@
 #include <zircon/syscalls.h>
 
 constexpr char kTag[] = "sysmem";
+constexpr uint32_t kMaxBufferCount =
+    sizeof(fuchsia_sysmem_BufferCollectionInfo::vmos) / sizeof(zx_handle_t);
 
 namespace {
 
@@ -112,44 +120,201 @@ zx_status_t PickImageFormat(const fuchsia_sysmem_BufferSpec& spec,
     return ZX_OK;
 }
 
-} // namespace
-
-static zx_status_t Allocator_AllocateCollection(void* ctx,
-                                                uint32_t buffer_count,
-                                                const fuchsia_sysmem_BufferSpec* spec,
-                                                const fuchsia_sysmem_BufferUsage* usage,
-                                                fidl_txn_t* txn) {
-    fuchsia_sysmem_BufferCollectionInfo info;
-    memset(&info, 0, sizeof(info));
+zx_status_t AllocateBuffers(uint32_t buffer_count,
+                            const fuchsia_sysmem_BufferSpec& spec,
+                            fuchsia_sysmem_BufferCollectionInfo* info) {
+    memset(info, 0, sizeof(*info));
     // Most basic usage of the allocator: create vmos with no special vendor format:
     // 1) Pick which format gets used.  For the simple case, just use whatever format was given.
     //    We also assume here that the format is an ImageFormat
     // TODO(FIDL-204/kulakowski) Make this a union again when C bindings
     // are rationalized, and put this assertion back.
-    // ZX_ASSERT(info.format.tag == fuchsia_sysmem_BufferSpecTag_image);
-    zx_status_t status = PickImageFormat(*spec, &info.format.image, &info.vmo_size);
+    // ZX_ASSERT(info->format.tag == fuchsia_sysmem_BufferSpecTag_image);
+    zx_status_t status = PickImageFormat(spec, &info->format.image, &info->vmo_size);
     if (status != ZX_OK) {
         FX_LOG(ERROR, kTag, "Failed to pick format for Buffer Collection\n");
-        return fuchsia_sysmem_AllocatorAllocateCollection_reply(txn, status, &info);
+        return status;
     }
 
     // 3) Allocate the buffers.  This will be specialized for different formats.
-    info.buffer_count = buffer_count;
+    info->buffer_count = buffer_count;
     for (uint32_t i = 0; i < buffer_count; ++i) {
-        status = zx_vmo_create(info.vmo_size, 0, &info.vmos[i]);
+        status = zx_vmo_create(info->vmo_size, 0, &info->vmos[i]);
         if (status != ZX_OK) {
             // Close the handles we created already.  We do not support partial allocations.
             for (uint32_t j = 0; j < i; ++j) {
-                zx_handle_close(info.vmos[j]);
-                info.vmos[j] = ZX_HANDLE_INVALID;
+                zx_handle_close(info->vmos[j]);
+                info->vmos[j] = ZX_HANDLE_INVALID;
             }
-            info.buffer_count = 0;
+            info->buffer_count = 0;
             FX_LOG(ERROR, kTag, "Failed to allocate Buffer Collection\n");
-            return fuchsia_sysmem_AllocatorAllocateCollection_reply(txn, ZX_ERR_NO_MEMORY, &info);
+            return ZX_ERR_NO_MEMORY;
         }
     }
     // If everything is happy and allocated, can give ZX_OK:
-    return fuchsia_sysmem_AllocatorAllocateCollection_reply(txn, ZX_OK, &info);
+    return ZX_OK;
+}
+
+// The rights a client of a shared collection gets to the buffers.  Clients
+// which only read the buffers (display scanout, sampling from them, ...) get
+// VMOs without write rights.
+zx_rights_t VmoRightsForUsage(const fuchsia_sysmem_BufferUsage& usage) {
+    constexpr uint32_t kCpuWrite = fuchsia_sysmem_cpuUsageWrite | fuchsia_sysmem_cpuUsageWriteOften;
+    constexpr uint32_t kVulkanWrite = fuchsia_sysmem_vulkanUsageTransferDst |
+                                      fuchsia_sysmem_vulkanUsageStorage |
+                                      fuchsia_sysmem_vulkanUsageColorAttachment |
+                                      fuchsia_sysmem_vulkanUsageStencilAttachment |
+                                      fuchsia_sysmem_vulkanUsageTransientAttachment;
+    constexpr uint32_t kVideoWrite = fuchsia_sysmem_videoUsageHwDecoder |
+                                     fuchsia_sysmem_videoUsageHwProtected;
+
+    zx_rights_t rights = ZX_RIGHT_DUPLICATE | ZX_RIGHT_TRANSFER | ZX_RIGHT_READ | ZX_RIGHT_MAP |
+                         ZX_RIGHT_GET_PROPERTY;
+    if ((usage.cpu & kCpuWrite) || (usage.vulkan & kVulkanWrite) || (usage.video & kVideoWrite)) {
+        rights |= ZX_RIGHT_WRITE;
+    }
+    return rights;
+}
+
+// A collection of buffers shared among several clients.  The coordinator's
+// AllocateSharedCollection() and each client's BindSharedCollection() may
+// arrive in any order; they are matched up by the koid of the token peer,
+// and the buffers are allocated once every token has been closed.
+class SharedCollection : public fbl::DoublyLinkedListable<fbl::unique_ptr<SharedCollection>> {
+public:
+    // Returns the collection for |peer_koid|, creating it if this is the first
+    // request to name it.
+    static SharedCollection* Get(zx_koid_t peer_koid) {
+        for (auto& collection : collections_) {
+            if (collection.peer_koid_ == peer_koid) {
+                return &collection;
+            }
+        }
+
+        fbl::AllocChecker ac;
+        fbl::unique_ptr<SharedCollection> collection(new (&ac) SharedCollection(peer_koid));
+        if (!ac.check()) {
+            return nullptr;
+        }
+        SharedCollection* ret = collection.get();
+        collections_.push_back(fbl::move(collection));
+        return ret;
+    }
+
+    zx_status_t SetAllocation(async_dispatcher_t* dispatcher, uint32_t buffer_count,
+                              const fuchsia_sysmem_BufferSpec& spec, zx::eventpair token_peer,
+                              fidl_txn_t* txn) {
+        if (token_peer_.is_valid()) {
+            return ZX_ERR_INVALID_ARGS;
+        }
+        token_peer_ = fbl::move(token_peer);
+        buffer_count_ = buffer_count;
+        spec_ = spec;
+
+        wait_.set_object(token_peer_.get());
+        wait_.set_trigger(ZX_EVENTPAIR_PEER_CLOSED);
+        zx_status_t status = wait_.Begin(dispatcher);
+        if (status != ZX_OK) {
+            token_peer_.reset();
+            return status;
+        }
+        allocate_txn_ = fidl_async_txn_create(txn);
+        return ZX_OK;
+    }
+
+    zx_status_t AddClient(const fuchsia_sysmem_BufferUsage& usage, fidl_txn_t* txn) {
+        fbl::AllocChecker ac;
+        fbl::unique_ptr<Client> client(new (&ac) Client);
+        if (!ac.check()) {
+            return ZX_ERR_NO_MEMORY;
+        }
+        client->usage = usage;
+        client->txn = fidl_async_txn_create(txn);
+        clients_.push_front(fbl::move(client));
+        return ZX_OK;
+    }
+
+private:
+    struct Client : public fbl::SinglyLinkedListable<fbl::unique_ptr<Client>> {
+        fuchsia_sysmem_BufferUsage usage;
+        fidl_async_txn_t* txn;
+    };
+
+    explicit SharedCollection(zx_koid_t peer_koid)
+        : peer_koid_(peer_koid), wait_(this) {}
+
+    void OnTokensClosed(async_dispatcher_t* dispatcher, async::WaitBase* wait, zx_status_t status,
+                        const zx_packet_signal_t* signal) {
+        fuchsia_sysmem_BufferCollectionInfo info;
+        memset(&info, 0, sizeof(info));
+        if (status == ZX_OK) {
+            status = clients_.is_empty() ? ZX_ERR_BAD_STATE
+                                         : AllocateBuffers(buffer_count_, spec_, &info);
+        }
+
+        // Each client gets its own handles to the same VMOs, so that every
+        // participant works on the buffers directly.
+        while (!clients_.is_empty()) {
+            fbl::unique_ptr<Client> client = clients_.pop_front();
+            fuchsia_sysmem_BufferCollectionInfo client_info;
+            memset(&client_info, 0, sizeof(client_info));
+            zx_status_t client_status = status;
+            if (client_status == ZX_OK) {
+                client_info = info;
+                zx_rights_t rights = VmoRightsForUsage(client->usage);
+                for (uint32_t i = 0; i < info.buffer_count; ++i) {
+                    client_info.vmos[i] = ZX_HANDLE_INVALID;
+                    client_status = zx_handle_duplicate(info.vmos[i], rights,
+                                                        &client_info.vmos[i]);
+                    if (client_status != ZX_OK) {
+                        for (uint32_t j = 0; j < i; ++j) {
+                            zx_handle_close(client_info.vmos[j]);
+                        }
+                        memset(&client_info, 0, sizeof(client_info));
+                        break;
+                    }
+                }
+            }
+            fuchsia_sysmem_AllocatorBindSharedCollection_reply(fidl_async_txn_borrow(client->txn),
+                                                                client_status, &client_info);
+            fidl_async_txn_complete(client->txn, true);
+        }
+
+        for (uint32_t i = 0; i < info.buffer_count; ++i) {
+            zx_handle_close(info.vmos[i]);
+        }
+
+        fuchsia_sysmem_AllocatorAllocateSharedCollection_reply(
+            fidl_async_txn_borrow(allocate_txn_), status);
+        fidl_async_txn_complete(allocate_txn_, true);
+
+        // This deletes us.
+        collections_.erase(*this);
+    }
+
+    static fbl::DoublyLinkedList<fbl::unique_ptr<SharedCollection>> collections_;
+
+    const zx_koid_t peer_koid_;
+    zx::eventpair token_peer_;
+    uint32_t buffer_count_ = 0;
+    fuchsia_sysmem_BufferSpec spec_;
+    fidl_async_txn_t* allocate_txn_ = nullptr;
+    fbl::SinglyLinkedList<fbl::unique_ptr<Client>> clients_;
+    async::WaitMethod<SharedCollection, &SharedCollection::OnTokensClosed> wait_;
+};
+
+fbl::DoublyLinkedList<fbl::unique_ptr<SharedCollection>> SharedCollection::collections_;
+
+} // namespace
+
+static zx_status_t Allocator_AllocateCollection(void* ctx,
+                                                uint32_t buffer_count,
+                                                const fuchsia_sysmem_BufferSpec* spec,
+                                                const fuchsia_sysmem_BufferUsage* usage,
+                                                fidl_txn_t* txn) {
+    fuchsia_sysmem_BufferCollectionInfo info;
+    zx_status_t status = AllocateBuffers(buffer_count, *spec, &info);
+    return fuchsia_sysmem_AllocatorAllocateCollection_reply(txn, status, &info);
 }
 
 static zx_status_t Allocator_AllocateSharedCollection(void* ctx,
@@ -157,7 +322,27 @@ static zx_status_t Allocator_AllocateSharedCollection(void* ctx,
                                                       const fuchsia_sysmem_BufferSpec* spec,
                                                       zx_handle_t token_peer,
                                                       fidl_txn_t* txn) {
-    return fuchsia_sysmem_AllocatorAllocateSharedCollection_reply(txn, ZX_ERR_NOT_SUPPORTED);
+    zx::eventpair peer(token_peer);
+    zx_info_handle_basic_t handle_info;
+    zx_status_t status = peer.get_info(ZX_INFO_HANDLE_BASIC, &handle_info, sizeof(handle_info),
+                                       nullptr, nullptr);
+    if (status != ZX_OK) {
+        return fuchsia_sysmem_AllocatorAllocateSharedCollection_reply(txn, ZX_ERR_INVALID_ARGS);
+    }
+    if (buffer_count == 0 || buffer_count > kMaxBufferCount) {
+        return fuchsia_sysmem_AllocatorAllocateSharedCollection_reply(txn, ZX_ERR_INVALID_ARGS);
+    }
+
+    SharedCollection* collection = SharedCollection::Get(handle_info.koid);
+    if (collection == nullptr) {
+        return fuchsia_sysmem_AllocatorAllocateSharedCollection_reply(txn, ZX_ERR_NO_MEMORY);
+    }
+    status = collection->SetAllocation(static_cast<async_dispatcher_t*>(ctx), buffer_count, *spec,
+                                       fbl::move(peer), txn);
+    if (status != ZX_OK) {
+        return fuchsia_sysmem_AllocatorAllocateSharedCollection_reply(txn, status);
+    }
+    return ZX_ERR_ASYNC;
 }
 
 static zx_status_t Allocator_BindSharedCollection(void* ctx,
@@ -166,7 +351,29 @@ static zx_status_t Allocator_BindSharedCollection(void* ctx,
                                                   fidl_txn_t* txn) {
     fuchsia_sysmem_BufferCollectionInfo info;
     memset(&info, 0, sizeof(info));
-    return fuchsia_sysmem_AllocatorBindSharedCollection_reply(txn, ZX_ERR_NOT_SUPPORTED, &info);
+
+    // The token's peer is the handle the coordinator passes to
+    // AllocateSharedCollection(), so the collection is keyed by its koid.
+    zx::eventpair client_token(token);
+    zx_info_handle_basic_t handle_info;
+    zx_status_t status = client_token.get_info(ZX_INFO_HANDLE_BASIC, &handle_info,
+                                               sizeof(handle_info), nullptr, nullptr);
+    if (status != ZX_OK) {
+        return fuchsia_sysmem_AllocatorBindSharedCollection_reply(txn, ZX_ERR_INVALID_ARGS, &info);
+    }
+
+    SharedCollection* collection = SharedCollection::Get(handle_info.related_koid);
+    if (collection == nullptr) {
+        return fuchsia_sysmem_AllocatorBindSharedCollection_reply(txn, ZX_ERR_NO_MEMORY, &info);
+    }
+    status = collection->AddClient(*usage, txn);
+    if (status != ZX_OK) {
+        return fuchsia_sysmem_AllocatorBindSharedCollection_reply(txn, status, &info);
+    }
+
+    // Closing our copy of the token is what lets the collection allocate once
+    // every client has enlisted.
+    return ZX_ERR_ASYNC;
 }
 
 static constexpr const fuchsia_sysmem_Allocator_ops_t allocator_ops = {
@@ -178,9 +385,10 @@ static constexpr const fuchsia_sysmem_Allocator_ops_t allocator_ops = {
 static zx_status_t connect(void* ctx, async_dispatcher_t* dispatcher,
                            const char* service_name, zx_handle_t request) {
     if (!strcmp(service_name, fuchsia_sysmem_Allocator_Name)) {
+        // Shared collections need the dispatcher to wait for their tokens.
         return fidl_bind(dispatcher, request,
                          (fidl_dispatch_t*)fuchsia_sysmem_Allocator_dispatch,
-                         ctx, &allocator_ops);
+                         dispatcher, &allocator_ops);
     }
 
     zx_handle_close(request);
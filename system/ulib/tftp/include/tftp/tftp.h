@@ -155,6 +155,10 @@ typedef tftp_status (*tftp_file_read_cb)(void* data,
 // less than or equal to the original value to indicate a partial write.
 // |length| is only used as an output parameter if the returned status is
 // TFTP_NO_ERROR.
+//
+// If the destination can't accept more data yet, TFTP_ERR_SHOULD_WAIT may be
+// returned: the block being written is dropped, to be written again when the
+// sender retransmits it, rather than failing the transfer.
 typedef tftp_status (*tftp_file_write_cb)(const void* data,
                                           size_t* length,
                                           off_t offset,
@@ -268,7 +272,9 @@ tftp_status tftp_prepare_data(tftp_session* session,
 // which is |msg_len| bytes long. |buf_sz| represents the total size of
 // |msg_buf|, which may be used to assemble the next packet to send.
 // |timeout_ms| is set to the next timeout value the user of the library should
-// use when waiting for a response. |file_cookie| will be passed to the tftp
+// use when waiting for a response, which doubles with each consecutive timeout
+// (up to four times the negotiated timeout) until a message is received from
+// the peer. |file_cookie| will be passed to the tftp
 // callback functions. On return, TFTP_ERR_TIMED out is returned if the maximum
 // number of timeouts has been exceeded. If a message should be sent out,
 // |msg_len| will be set to the size of the message.
@@ -47,6 +47,8 @@ typedef struct tftp_data_msg_t {
 #define DEFAULT_WINDOWSIZE 1
 #define DEFAULT_MODE MODE_OCTET
 #define DEFAULT_MAX_TIMEOUTS 5
+// Each consecutive timeout doubles the next one, up to (timeout << MAX_TIMEOUT_BACKOFF_SHIFT).
+#define MAX_TIMEOUT_BACKOFF_SHIFT 2
 #define DEFAULT_USE_OPCODE_PREFIX true
 
 typedef struct tftp_options_t {
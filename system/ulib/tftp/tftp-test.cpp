@@ -1043,6 +1043,68 @@ static bool test_tftp_receive_data(void) {
     END_TEST;
 }
 
+static bool test_tftp_receive_data_should_wait(void) {
+    BEGIN_TEST;
+
+    test_state ts;
+    ts.reset(1024, 1024, 1500);
+    tftp_file_interface ifc = {NULL,
+            [](const char* filename, size_t size, void* cookie) -> tftp_status {
+                return 0;
+            }, NULL, NULL, NULL};
+    tftp_session_set_file_interface(ts.session, &ifc);
+
+    char req_buf[256];
+    req_buf[0] = 0x00;
+    req_buf[1] = OPCODE_WRQ;
+    size_t req_buf_sz = 2 + snprintf(&req_buf[2], sizeof(req_buf) - 2,
+                                     "%s%cOCTET%cTSIZE%c%d",
+                                     kRemoteFilename, '\0', '\0', '\0', 1024)
+                          + 1;
+
+    ASSERT_LT(req_buf_sz, (int)sizeof(req_buf), "insufficient space for WRQ message");
+    auto status = tftp_process_msg(ts.session, req_buf, req_buf_sz, ts.out, &ts.outlen,
+                                   &ts.timeout, nullptr);
+    ASSERT_EQ(TFTP_NO_ERROR, status, "receive write request failed");
+    ASSERT_TRUE(verify_response_opcode(ts, OPCODE_OACK), "bad response");
+
+    uint8_t data_buf[516] = {
+        0x00, 0x03,  // Opcode (DATA)
+        0x00, 0x01,  // Block
+        0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff, // Data; compiler will fill out the rest with zeros
+    };
+
+    // A destination which can't take the data yet drops the block, and re-ACKs block 0
+    ifc.write = [](const void* data, size_t* length, off_t offset, void* file_cookie)
+                    -> tftp_status {
+                    return TFTP_ERR_SHOULD_WAIT;
+                };
+    tftp_session_set_file_interface(ts.session, &ifc);
+
+    ts.outlen = ts.out_size;
+    status = tftp_process_msg(ts.session, data_buf, sizeof(data_buf), ts.out, &ts.outlen,
+                              &ts.timeout, nullptr);
+    EXPECT_EQ(TFTP_NO_ERROR, status, "deferred write should not fail the transfer");
+    ASSERT_TRUE(verify_response_opcode(ts, OPCODE_ACK), "bad response");
+    EXPECT_EQ(0, ntohs(static_cast<tftp_data_msg*>(ts.out)->block), "bad ack block");
+    EXPECT_EQ(0, ts.session->block_number, "dropped block should not advance block number");
+
+    // The retransmitted block is written once the destination is ready
+    ifc.write = mock_write;
+    tftp_session_set_file_interface(ts.session, &ifc);
+
+    tx_test_data td;
+    ts.outlen = ts.out_size;
+    status = tftp_process_msg(ts.session, data_buf, sizeof(data_buf), ts.out, &ts.outlen,
+                              &ts.timeout, &td);
+    EXPECT_EQ(TFTP_NO_ERROR, status, "receive data failed");
+    EXPECT_TRUE(verify_response_opcode(ts, OPCODE_ACK), "bad response");
+    EXPECT_TRUE(verify_write_data(data_buf + 4, td), "bad write data");
+    EXPECT_EQ(1, ts.session->block_number, "tftp session block number mismatch");
+
+    END_TEST;
+}
+
 static bool test_tftp_receive_data_final_block(void) {
     BEGIN_TEST;
 
@@ -1484,6 +1546,61 @@ static bool test_tftp_send_data_receive_ack(void) {
     END_TEST;
 }
 
+static bool test_tftp_send_data_timeout_backoff(void) {
+    BEGIN_TEST;
+
+    test_state ts;
+    ts.reset(1024, 1024, 1500);
+
+    auto status = tftp_generate_request(ts.session, SEND_FILE, kLocalFilename, kRemoteFilename,
+        MODE_OCTET, ts.msg_size, NULL, NULL, NULL, ts.out, &ts.outlen, &ts.timeout);
+    EXPECT_EQ(TFTP_NO_ERROR, status, "error generating write request");
+    EXPECT_TRUE(verify_write_request(ts), "bad write request");
+
+    uint8_t oack_buf[] = {
+        0x00, 0x06,                     // Opcode (OACK)
+        'T', 'S', 'I', 'Z', 'E', 0x00,  // Option
+        '1', '0', '2', '4', 0x00,       // TSIZE value
+    };
+
+    tftp_file_interface ifc = {NULL, NULL, mock_read, NULL, NULL};
+    tftp_session_set_file_interface(ts.session, &ifc);
+
+    tx_test_data td;
+    status = tftp_process_msg(ts.session, oack_buf, sizeof(oack_buf), ts.out, &ts.outlen, &ts.timeout, &td);
+    ASSERT_EQ(TFTP_NO_ERROR, status, "receive error");
+    EXPECT_EQ(1000 * DEFAULT_TIMEOUT, ts.timeout, "bad timeout");
+
+    // Each timeout doubles the next one, up to a limit, and resends the first block
+    uint32_t expected_timeouts[] = {2000, 4000, 4000};
+    for (uint32_t expected_timeout : expected_timeouts) {
+        ts.outlen = ts.out_size;
+        status = tftp_timeout(ts.session, ts.out, &ts.outlen, ts.out_size, &ts.timeout, &td);
+        ASSERT_EQ(TFTP_NO_ERROR, status, "timeout error");
+        EXPECT_EQ(expected_timeout, ts.timeout, "bad timeout");
+        EXPECT_EQ(ts.outlen, sizeof(tftp_data_msg) + DEFAULT_BLOCKSIZE, "bad outlen");
+        EXPECT_TRUE(verify_read_data(ts, td), "bad test data");
+    }
+
+    uint8_t ack_buf[] = {
+        0x00, 0x04,  // Opcode (ACK)
+        0x00, 0x01,  // Block
+    };
+
+    // Hearing from the peer returns to the negotiated timeout
+    td.expected.block = 2;
+    td.expected.offset += DEFAULT_BLOCKSIZE;
+    td.expected.data[1] = 'f';
+    ts.outlen = ts.out_size;
+    status = tftp_process_msg(ts.session, ack_buf, sizeof(ack_buf), ts.out, &ts.outlen, &ts.timeout, &td);
+    EXPECT_EQ(TFTP_NO_ERROR, status, "receive error");
+    EXPECT_EQ(1000 * DEFAULT_TIMEOUT, ts.timeout, "bad timeout");
+    EXPECT_EQ(0, ts.session->consecutive_timeouts, "timeout count not reset");
+    EXPECT_TRUE(verify_read_data(ts, td), "bad test data");
+
+    END_TEST;
+}
+
 static bool test_tftp_send_data_receive_final_ack(void) {
     BEGIN_TEST;
 
@@ -2045,6 +2162,7 @@ RUN_TEST(test_tftp_receive_data_windowsize)
 RUN_TEST(test_tftp_receive_data_skipped_block)
 RUN_TEST(test_tftp_receive_data_windowsize_skipped_block)
 RUN_TEST(test_tftp_receive_data_block_wrapping)
+RUN_TEST(test_tftp_receive_data_should_wait)
 END_TEST_CASE(tftp_receive_data)
 
 BEGIN_TEST_CASE(tftp_send_data)
@@ -2054,6 +2172,7 @@ RUN_TEST(test_tftp_send_data_receive_ack_skipped_block)
 RUN_TEST(test_tftp_send_data_receive_ack_window_size)
 RUN_TEST(test_tftp_send_data_receive_ack_block_wrapping)
 RUN_TEST(test_tftp_send_data_receive_ack_skip_block_wrap)
+RUN_TEST(test_tftp_send_data_timeout_backoff)
 END_TEST_CASE(tftp_send_data)
 
 BEGIN_TEST_CASE(tftp_send_err)
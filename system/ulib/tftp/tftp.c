@@ -728,6 +728,9 @@ tftp_status tftp_handle_data(tftp_session* session,
             // TODO(tkilbourn): assert that these function pointers are set
             size_t wr = len;
             ret = session->file_interface.write(buf, &wr, off, cookie);
+            if (ret == TFTP_ERR_SHOULD_WAIT) {
+                break;
+            }
             if (ret < 0) {
                 xprintf("Error writing: %d\n", ret);
                 return ret;
@@ -736,8 +739,16 @@ tftp_status tftp_handle_data(tftp_session* session,
             off += wr;
             len -= wr;
         }
-        session->block_number++;
-        session->window_index++;
+        if (len > 0) {
+            // The destination can't take the block yet. Drop it, and ACK the last block we
+            // did take: the sender ignores the duplicate ACK, but it shows we're still alive,
+            // and the block is sent again when the sender times out.
+            xprintf("Write deferred: dropping block %" PRIu64 "\n", session->block_number + 1);
+            session->window_index = session->window_size;
+        } else {
+            session->block_number++;
+            session->window_index++;
+        }
     } else if (block_delta > 1) {
         // Force sending a ACK with the last block_number we received
         xprintf("Skipped: got %" PRIu64 ", expected %" PRIu64 "\n",
@@ -1037,6 +1048,11 @@ tftp_status tftp_timeout(tftp_session* session,
     if (++session->consecutive_timeouts > session->max_timeouts) {
         return TFTP_ERR_TIMED_OUT;
     }
+    // Back off, so that a slow or congested peer (e.g., one writing a large window out to
+    // disk) isn't flooded with retransmissions. The timeout returns to the negotiated value
+    // as soon as a message is received from the peer.
+    uint32_t backoff_shift = MIN(session->consecutive_timeouts, MAX_TIMEOUT_BACKOFF_SHIFT);
+    *timeout_ms = (1000 * session->timeout) << backoff_shift;
     // It's possible our previous transmission was dropped because of checksum errors.
     // Use a different opcode prefix when we resend.
     if (session->use_opcode_prefix) {
@@ -10,6 +10,11 @@
 // threads/strings and then refering to them by a numeric id. For performance
 // each thread in the application maintains its own cache.
 //
+// Likewise, non-durable records are allocated from chunks of the rolling
+// buffers leased to each thread so that threads don't contend on a shared
+// allocation pointer. The unused part of a chunk is covered by a padding
+// record which readers skip.
+//
 // Oneshot: The trace buffer is just one large buffer, and records are written
 // until the buffer is full after which all further records are dropped.
 //
@@ -87,6 +92,30 @@ namespace {
 // The next context generation number.
 fbl::atomic<uint32_t> g_next_generation{1u};
 
+// The chunk of a rolling buffer leased to the current thread.
+// See |trace_context::AllocChunkedRecord()|.
+struct RecordChunk {
+    // The generation of the context the chunk was leased from, or zero if
+    // no chunk has been leased.
+    uint32_t generation;
+
+    // The wrapped count of the rolling buffer the chunk was leased from.
+    uint32_t wrapped_count;
+
+    // The next free word in the chunk, and the end of the chunk.
+    uint64_t* next;
+    uint64_t* end;
+};
+thread_local RecordChunk tls_record_chunk{};
+
+// Writes a record which readers skip over to fill |num_words| words.
+void WritePaddingRecord(uint64_t* ptr, size_t num_words) {
+    *ptr = RecordFields::Type::Make(ToUnderlyingType(RecordType::kMetadata)) |
+           RecordFields::RecordSize::Make(num_words) |
+           MetadataRecordFields::MetadataType::Make(
+               ToUnderlyingType(MetadataType::kPadding));
+}
+
 } // namespace
 } // namespace trace
 
@@ -113,6 +142,50 @@ uint64_t* trace_context::AllocRecord(size_t num_bytes) {
         return nullptr;
     static_assert(TRACE_ENCODED_RECORD_MAX_LENGTH < kMaxRollingBufferSize, "");
 
+    if (likely(use_record_chunks_ && num_bytes <= kMaxChunkedRecordSize))
+        return AllocChunkedRecord(num_bytes);
+
+    uint32_t wrapped_count;
+    return AllocRollingRecord(num_bytes, &wrapped_count);
+}
+
+uint64_t* trace_context::AllocChunkedRecord(size_t num_bytes) {
+    static_assert(kRecordChunkSize <= trace::RecordFields::kMaxRecordSizeBytes,
+                  "padding must fit in a single record");
+    static_assert(kMaxChunkedRecordSize <= kRecordChunkSize, "");
+
+    trace::RecordChunk* chunk = &trace::tls_record_chunk;
+    size_t num_words = num_bytes >> 3;
+
+    // A chunk can no longer be written to once its rolling buffer has been
+    // switched out, or once tracing has stopped because the durable buffer
+    // filled.
+    if (unlikely(chunk->generation != generation_ ||
+                 chunk->wrapped_count != CurrentWrappedCount() ||
+                 IsDurableBufferFull() ||
+                 static_cast<size_t>(chunk->end - chunk->next) < num_words)) {
+        uint32_t wrapped_count;
+        uint64_t* start = AllocRollingRecord(kRecordChunkSize, &wrapped_count);
+        if (unlikely(!start)) {
+            // The record was dropped along with the chunk. The current chunk,
+            // if any, is left in place for smaller records.
+            return nullptr;
+        }
+        chunk->generation = generation_;
+        chunk->wrapped_count = wrapped_count;
+        chunk->next = start;
+        chunk->end = start + (kRecordChunkSize >> 3);
+    }
+
+    uint64_t* ptr = chunk->next;
+    chunk->next += num_words;
+    if (chunk->next != chunk->end)
+        trace::WritePaddingRecord(chunk->next, chunk->end - chunk->next);
+    return ptr;
+}
+
+uint64_t* trace_context::AllocRollingRecord(size_t num_bytes,
+                                            uint32_t* out_wrapped_count) {
     // For the circular and streaming cases, try at most once for each buffer.
     // Note: Keep the normal case of one successful pass the fast path.
     // E.g., We don't do a mode comparison unless we have to.
@@ -128,6 +201,7 @@ uint64_t* trace_context::AllocRecord(size_t num_bytes) {
         // Note: There's no worry of an overflow in the calcs here.
         if (likely(buffer_offset + num_bytes <= rolling_buffer_size_)) {
             uint8_t* ptr = rolling_buffer_start_[buffer_number] + buffer_offset;
+            *out_wrapped_count = wrapped_count;
             return reinterpret_cast<uint64_t*>(ptr); // success!
         }
 
@@ -372,6 +446,8 @@ void trace_context::ComputeBufferSizes() {
         __UNREACHABLE;
     }
 
+    use_record_chunks_ = rolling_buffer_size_ >= kMinChunkedBufferSize;
+
     durable_buffer_current_.store(0);
     durable_buffer_full_mark_.store(0);
     rolling_buffer_current_.store(0);
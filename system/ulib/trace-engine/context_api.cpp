@@ -127,6 +127,15 @@ struct ContextCache {
     // Storage for the string entries.
     StringEntry string_entries[kMaxStringEntries];
 
+    // Maximum number of static string literals which can be looked up by
+    // slot.  Literals which were not assigned a slot use |string_table|.
+    static constexpr uint32_t kMaxLiteralSlots = 512;
+
+    // Static string literal table.
+    // Maps the slot of a static string literal to its entry in |string_table|,
+    // or nullptr if the literal has not been registered by this thread yet.
+    StringEntry* literal_table[kMaxLiteralSlots]{};
+
     // Maximum number of external thread references to cache per thread.
     static constexpr size_t kMaxThreadEntries = 4;
 
@@ -140,6 +149,14 @@ struct ContextCache {
 };
 thread_local fbl::unique_ptr<ContextCache> tls_cache{};
 
+// The slot of a static string literal which could not be assigned one.
+constexpr uint32_t kNoLiteralSlot = UINT32_MAX;
+
+// The next slot to assign to a static string literal.
+// Slots are assigned once per process and start at 1 since |slot| is
+// zero-initialized until the literal is first registered.
+fbl::atomic<uint32_t> g_next_literal_slot{1u};
+
 ContextCache* GetCurrentContextCache(uint32_t generation) {
     ContextCache* cache = tls_cache.get();
     if (likely(cache)) {
@@ -155,6 +172,7 @@ ContextCache* GetCurrentContextCache(uint32_t generation) {
     cache->thread_ref = trace_make_unknown_thread_ref();
     cache->string_table.clear();
     cache->thread_table.clear();
+    memset(cache->literal_table, 0, sizeof(cache->literal_table));
     return cache;
 }
 
@@ -180,6 +198,48 @@ StringEntry* CacheStringEntry(uint32_t generation,
     return entry;
 }
 
+// Gets the slot of a static string literal, assigning it one the first time
+// it is registered.  Returns |kNoLiteralSlot| once all slots have been taken.
+uint32_t GetLiteralSlot(trace_string_literal_t* literal) {
+    uint32_t slot = __atomic_load_n(&literal->slot, __ATOMIC_RELAXED);
+    if (likely(slot))
+        return slot;
+
+    slot = g_next_literal_slot.fetch_add(1u, fbl::memory_order_relaxed);
+    if (unlikely(slot > ContextCache::kMaxLiteralSlots)) {
+        // Avoid wrapping the counter.
+        g_next_literal_slot.store(ContextCache::kMaxLiteralSlots + 1u,
+                                  fbl::memory_order_relaxed);
+        slot = kNoLiteralSlot;
+    }
+
+    // Another thread may have registered the literal concurrently, in which
+    // case its slot wins and ours goes unused.
+    uint32_t expected = 0u;
+    if (!__atomic_compare_exchange_n(&literal->slot, &expected, slot, false,
+                                     __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        return expected;
+    return slot;
+}
+
+StringEntry* CacheStaticStringEntry(uint32_t generation,
+                                    trace_string_literal_t* literal) {
+    uint32_t slot = GetLiteralSlot(literal);
+    if (unlikely(slot == kNoLiteralSlot))
+        return CacheStringEntry(generation, literal->string);
+
+    ContextCache* cache = GetCurrentContextCache(generation);
+    if (unlikely(!cache))
+        return nullptr;
+
+    StringEntry*& entry = cache->literal_table[slot - 1u];
+    if (likely(entry))
+        return entry;
+
+    entry = CacheStringEntry(generation, literal->string);
+    return entry;
+}
+
 ThreadEntry* CacheThreadEntry(uint32_t generation, zx_koid_t thread_koid) {
     ContextCache* cache = GetCurrentContextCache(generation);
     if (unlikely(!cache))
@@ -485,21 +545,15 @@ bool WriteThreadRecord(trace_context_t* context, trace_thread_index_t index,
     return false;
 }
 
-// N.B. This may only return false if |check_category| is true.
-
-bool RegisterString(trace_context_t* context,
-                    const char* string_literal,
-                    bool check_category,
-                    trace_string_ref_t* out_ref_optional) {
-    if (unlikely(!string_literal || !*string_literal)) {
-        if (check_category)
-            return false; // NULL and empty strings are not valid categories
-        if (out_ref_optional)
-            *out_ref_optional = trace_make_empty_string_ref();
-        return true;
-    }
+// N.B. These may only return false if |check_category| is true.
 
-    StringEntry* entry = CacheStringEntry(context->generation(), string_literal);
+// Registers a string using its thread-local cache entry, or nullptr if it
+// could not be cached.
+bool RegisterStringEntry(trace_context_t* context,
+                         StringEntry* entry,
+                         const char* string_literal,
+                         bool check_category,
+                         trace_string_ref_t* out_ref_optional) {
     if (likely(entry)) {
         // Fast path: using the thread-local cache.
         if (check_category) {
@@ -554,6 +608,41 @@ bool RegisterString(trace_context_t* context,
     return true;
 }
 
+bool RegisterString(trace_context_t* context,
+                    const char* string_literal,
+                    bool check_category,
+                    trace_string_ref_t* out_ref_optional) {
+    if (unlikely(!string_literal || !*string_literal)) {
+        if (check_category)
+            return false; // NULL and empty strings are not valid categories
+        if (out_ref_optional)
+            *out_ref_optional = trace_make_empty_string_ref();
+        return true;
+    }
+
+    StringEntry* entry = CacheStringEntry(context->generation(), string_literal);
+    return RegisterStringEntry(context, entry, string_literal, check_category,
+                               out_ref_optional);
+}
+
+bool RegisterStaticString(trace_context_t* context,
+                          trace_string_literal_t* literal,
+                          bool check_category,
+                          trace_string_ref_t* out_ref_optional) {
+    const char* string_literal = literal->string;
+    if (unlikely(!string_literal || !*string_literal)) {
+        if (check_category)
+            return false; // NULL and empty strings are not valid categories
+        if (out_ref_optional)
+            *out_ref_optional = trace_make_empty_string_ref();
+        return true;
+    }
+
+    StringEntry* entry = CacheStaticStringEntry(context->generation(), literal);
+    return RegisterStringEntry(context, entry, string_literal, check_category,
+                               out_ref_optional);
+}
+
 } // namespace
 } // namespace trace
 
@@ -599,6 +688,21 @@ bool trace_context_register_category_literal(
     return trace::RegisterString(context, category_literal, true, out_ref);
 }
 
+void trace_context_register_static_string_literal(
+    trace_context_t* context,
+    trace_string_literal_t* literal,
+    trace_string_ref_t* out_ref) {
+    bool result = trace::RegisterStaticString(context, literal, false, out_ref);
+    ZX_DEBUG_ASSERT(result);
+}
+
+bool trace_context_register_static_category_literal(
+    trace_context_t* context,
+    trace_string_literal_t* literal,
+    trace_string_ref_t* out_ref) {
+    return trace::RegisterStaticString(context, literal, true, out_ref);
+}
+
 void trace_context_register_current_thread(
     trace_context_t* context,
     trace_thread_ref_t* out_ref) {
@@ -121,6 +121,21 @@ private:
 
     static_assert(kBufferOffsetBits + kWrappedCounterBits <= 64, "");
 
+    // Non-durable records are allocated from chunks of the rolling buffers
+    // leased to each thread, so that the common case touches only
+    // thread-local state instead of contending on |rolling_buffer_current_|.
+    // The unused tail of a chunk is covered by a padding record so that the
+    // buffer can be read at any time.
+    static constexpr size_t kRecordChunkSize = 4096;
+
+    // Records larger than this are allocated directly from the rolling
+    // buffer rather than leave much of a chunk unused.
+    static constexpr size_t kMaxChunkedRecordSize = kRecordChunkSize / 8;
+
+    // Chunks are only leased from rolling buffers at least this big, which
+    // bounds the space lost when a chunk doesn't fit at the end of a buffer.
+    static constexpr size_t kMinChunkedBufferSize = 64 * kRecordChunkSize;
+
     // The physical buffer must be at least this big.
     // Mostly this is here to simplify buffer size calculations.
     // It's as small as it is to simplify some testcases.
@@ -198,6 +213,13 @@ private:
         return GetWrappedCount(current);
     }
 
+    uint64_t* AllocChunkedRecord(size_t num_bytes);
+
+    // Allocates |num_bytes| directly from the current rolling buffer.
+    // |*out_wrapped_count| is set to the wrapped count of the buffer the
+    // record was allocated from.
+    uint64_t* AllocRollingRecord(size_t num_bytes, uint32_t* out_wrapped_count);
+
     void ComputeBufferSizes();
 
     void MarkDurableBufferFull(uint64_t last_offset);
@@ -263,6 +285,9 @@ private:
     // The size of both rolling buffers.
     size_t rolling_buffer_size_;
 
+    // True if records are allocated from chunks leased to each thread.
+    bool use_record_chunks_;
+
     // Current allocation pointer for durable records.
     // This only used in circular and streaming modes.
     // Starts at |durable_buffer_start| and grows from there.
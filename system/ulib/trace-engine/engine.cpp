@@ -497,6 +497,23 @@ trace_context_t* trace_acquire_context_for_category(const char* category_literal
     return context;
 }
 
+trace_context_t* trace_acquire_context_for_static_category(
+    trace_string_literal_t* category,
+    trace_string_ref_t* out_ref) {
+    // This is marked likely because tracing is usually disabled and we want
+    // to return as quickly as possible from this function.
+    trace_context_t* context = trace_acquire_context();
+    if (likely(!context))
+        return nullptr;
+
+    if (!trace_context_register_static_category_literal(context, category, out_ref)) {
+        trace_release_context(context);
+        return nullptr;
+    }
+
+    return context;
+}
+
 // thread-safe, never-fail, lock-free
 void trace_release_context(trace_context_t* context) {
     ZX_DEBUG_ASSERT(context == g_context);
@@ -135,6 +135,42 @@ __EXPORT bool trace_context_register_category_literal(
     const char* category_literal,
     trace_string_ref_t* out_ref);
 
+// Registers a static string literal into the string table.
+//
+// Behaves like |trace_context_register_string_literal()| except that the
+// string is cached in a slot assigned to |literal| rather than keyed by its
+// address, which makes subsequent registrations cheaper.
+//
+// |context| must be a valid trace context reference.
+// |literal| must be a static string literal, see |trace_string_literal_t|.
+// |out_ref| points to where the registered string reference should be returned.
+//
+// This function is thread-safe.
+__EXPORT void trace_context_register_static_string_literal(
+    trace_context_t* context,
+    trace_string_literal_t* literal,
+    trace_string_ref_t* out_ref);
+
+// Registers a category given as a static string literal into the string
+// table, if it is enabled.
+//
+// Behaves like |trace_context_register_category_literal()| except that the
+// string is cached in a slot assigned to |literal| rather than keyed by its
+// address, which makes subsequent registrations cheaper.
+//
+// |context| must be a valid trace context reference.
+// |literal| must be a static string literal, see |trace_string_literal_t|.
+// |out_ref| points to where the registered string reference should be returned.
+//
+// Returns true and registers the string if the category is enabled, otherwise
+// returns false and does not modify |*out_ref|.
+//
+// This function is thread-safe.
+__EXPORT bool trace_context_register_static_category_literal(
+    trace_context_t* context,
+    trace_string_literal_t* literal,
+    trace_string_ref_t* out_ref);
+
 // Registers the current thread into the thread table.
 //
 // Writes a process and/or thread kernel object record into the trace buffer if
@@ -127,9 +127,28 @@ __EXPORT trace_context_t* trace_acquire_context(void);
 __EXPORT trace_context_t* trace_acquire_context_for_category(const char* category_literal,
                                                     trace_string_ref_t* out_ref);
 
+// Acquires a reference to the trace engine's context, only if the specified
+// category is enabled.  Must be balanced by a call to |trace_release_context()|
+// when the result is non-NULL.
+//
+// Behaves like |trace_acquire_context_for_category()| except that the
+// category is registered with |trace_context_register_static_category_literal()|.
+//
+// |category| must be a static string literal, see |trace_string_literal_t|.
+// |out_ref| points to where the registered string reference should be returned.
+//
+// Returns a valid trace context if tracing is enabled for the specified category.
+// Returns NULL otherwise.
+//
+// This function is thread-safe.
+__EXPORT trace_context_t* trace_acquire_context_for_static_category(
+    trace_string_literal_t* category,
+    trace_string_ref_t* out_ref);
+
 // Releases a reference to the trace engine's context.
-// Must balance a prior successful call to |trace_acquire_context()|
-// or |trace_acquire_context_for_category()|.
+// Must balance a prior successful call to |trace_acquire_context()|,
+// |trace_acquire_context_for_category()| or
+// |trace_acquire_context_for_static_category()|.
 //
 // |context| must be a valid trace context reference.
 //
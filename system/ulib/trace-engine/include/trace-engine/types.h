@@ -145,6 +145,25 @@ static inline trace_string_ref_t trace_make_indexed_string_ref(trace_string_inde
     return ref;
 }
 
+// A string literal with static storage duration which the trace engine can
+// look up without hashing its address.
+//
+// The tracing macros declare one of these for the category and name of each
+// event.  The engine assigns it a slot in its per-thread string caches the
+// first time it is registered, so subsequent registrations in the same
+// trace session only need to load the cached string reference.
+//
+// |string| must be a null-terminated static string constant.
+// |slot| must be initialized to zero and is private to the trace engine.
+typedef struct trace_string_literal {
+    const char* string;
+    uint32_t slot;
+} trace_string_literal_t;
+
+// Initializer for a |trace_string_literal_t|.
+#define TRACE_STRING_LITERAL_INIT(string_literal_value) \
+    { (string_literal_value), 0u }
+
 // A thread reference which is either encoded inline or indirectly by thread table index.
 typedef struct trace_thread_ref {
     trace_encoded_thread_ref_t encoded_value;
@@ -326,6 +345,7 @@ static inline trace_arg_t trace_make_arg(trace_string_ref_t name_ref,
 typedef enum {
     TRACE_BLOB_TYPE_DATA = 1,
     TRACE_BLOB_TYPE_LAST_BRANCH = 2,
+    TRACE_BLOB_TYPE_CALLSTACK = 3,
 } trace_blob_type_t;
 
 // The maximum size of a blob.
@@ -369,6 +389,8 @@ enum class MetadataType {
     kProviderInfo = 1,
     kProviderSection = 2,
     kProviderEvent = 3,
+    // Fills otherwise unused space in the buffer. Carries no data.
+    kPadding = 4,
 };
 
 // Enumerates all provider events.
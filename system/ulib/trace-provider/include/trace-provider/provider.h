@@ -111,6 +111,36 @@ trace_provider_t* trace_provider_create_synchronously(async_dispatcher_t* dispat
 // Destroys the trace provider.
 void trace_provider_destroy(trace_provider_t* provider);
 
+// The category which turns on sampling.  Unlike other categories it is
+// only enabled when named explicitly, not when a trace enables all of them.
+//
+// While it is enabled, the trace provider periodically suspends the threads
+// of its process and records their call stacks.  Each sample is an instant
+// event named "sample" in this category on the sampled thread, followed by
+// a blob record of type TRACE_BLOB_TYPE_CALLSTACK holding a
+// |cpuperf_callstack_record_t| with the stack, as for cpuperf samples.
+// Stacks are recovered by following frame pointers.
+#define TRACE_PROVIDER_SAMPLING_CATEGORY "cpu:profile"
+
+// Bounds on the cost of sampling.  Zero fields select the defaults.
+typedef struct trace_provider_sampling_options {
+    // Time between samples.  Defaults to 10ms.
+    zx_duration_t period;
+
+    // Maximum number of threads sampled each period.  Processes with more
+    // threads have them sampled in turn.  Defaults to 16.
+    uint32_t max_threads;
+
+    // Maximum number of frames recorded for each stack.  Defaults to, and
+    // is at most, 32.
+    uint32_t max_frames;
+} trace_provider_sampling_options_t;
+
+// Sets how |provider| samples its process.  Takes effect from the next
+// trace which enables TRACE_PROVIDER_SAMPLING_CATEGORY.
+void trace_provider_set_sampling_options(trace_provider_t* provider,
+                                         const trace_provider_sampling_options_t* options);
+
 __END_CDECLS
 
 #ifdef __cplusplus
@@ -37,7 +37,7 @@ void TraceProviderImpl::Start(trace_buffering_mode_t buffering_mode,
                               fbl::Vector<fbl::String> enabled_categories) {
     Session::StartEngine(
         dispatcher_, buffering_mode, fbl::move(buffer), fbl::move(fifo),
-        fbl::move(enabled_categories));
+        fbl::move(enabled_categories), sampling_options_);
 }
 
 void TraceProviderImpl::Stop() {
@@ -295,3 +295,10 @@ void trace_provider_destroy(trace_provider_t* provider) {
     ZX_DEBUG_ASSERT(provider);
     delete static_cast<trace::internal::TraceProviderImpl*>(provider);
 }
+
+void trace_provider_set_sampling_options(trace_provider_t* provider,
+                                         const trace_provider_sampling_options_t* options) {
+    ZX_DEBUG_ASSERT(provider);
+    ZX_DEBUG_ASSERT(options);
+    static_cast<trace::internal::TraceProviderImpl*>(provider)->set_sampling_options(*options);
+}
@@ -26,6 +26,10 @@ public:
     TraceProviderImpl(async_dispatcher_t* dispatcher, zx::channel channel);
     ~TraceProviderImpl();
 
+    void set_sampling_options(const trace_provider_sampling_options_t& options) {
+        sampling_options_ = options;
+    }
+
 private:
     class Connection final {
     public:
@@ -55,6 +59,7 @@ private:
 
     async_dispatcher_t* const dispatcher_;
     Connection connection_;
+    trace_provider_sampling_options_t sampling_options_{};
 
     DISALLOW_COPY_ASSIGN_AND_MOVE(TraceProviderImpl);
 };
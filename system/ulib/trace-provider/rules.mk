@@ -12,6 +12,7 @@ MODULE_COMPILEFLAGS += -fvisibility=hidden
 MODULE_SRCS := \
     $(LOCAL_DIR)/handler.cpp \
     $(LOCAL_DIR)/provider_impl.cpp \
+    $(LOCAL_DIR)/sampler.cpp \
     $(LOCAL_DIR)/session.cpp \
     $(LOCAL_DIR)/trace_provider.fidl.client.cpp \
     $(LOCAL_DIR)/trace_provider.fidl.tables.cpp \
@@ -19,6 +20,7 @@ MODULE_SRCS := \
     $(LOCAL_DIR)/utils.cpp \
 
 MODULE_STATIC_LIBS := \
+    system/ulib/inspector \
     system/ulib/trace \
     system/ulib/async.cpp \
     system/ulib/async \
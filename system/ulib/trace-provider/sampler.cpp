@@ -0,0 +1,200 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "sampler.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <fbl/algorithm.h>
+#include <fbl/alloc_checker.h>
+#include <inspector/inspector.h>
+#include <lib/zircon-internal/device/cpu-trace/cpu-perf.h>
+#include <lib/zx/suspend_token.h>
+#include <lib/zx/thread.h>
+#include <lib/zx/time.h>
+#include <trace-engine/instrumentation.h>
+#include <zircon/assert.h>
+#include <zircon/process.h>
+#include <zircon/status.h>
+#include <zircon/syscalls.h>
+#include <zircon/syscalls/debug.h>
+#include <zircon/syscalls/object.h>
+
+#include "utils.h"
+
+namespace trace {
+namespace internal {
+namespace {
+
+constexpr zx_duration_t kDefaultPeriod = ZX_MSEC(10);
+constexpr uint32_t kDefaultMaxThreads = 16;
+
+// How long to wait for a thread to stop.  A thread which is blocked in a
+// syscall stops at once; a running one stops at its next interrupt.
+constexpr zx_duration_t kSuspendTimeout = ZX_MSEC(1);
+
+zx_koid_t GetKoid(zx_handle_t handle) {
+    zx_info_handle_basic_t info;
+    zx_status_t status = zx_object_get_info(handle, ZX_INFO_HANDLE_BASIC,
+                                            &info, sizeof(info), nullptr, nullptr);
+    return status == ZX_OK ? info.koid : ZX_KOID_INVALID;
+}
+
+} // namespace
+
+Sampler::Sampler(const trace_provider_sampling_options_t& options, zx::event stop_event)
+    : period_(options.period > 0 ? options.period : kDefaultPeriod),
+      max_threads_(options.max_threads > 0 ? options.max_threads : kDefaultMaxThreads),
+      max_frames_(options.max_frames > 0
+                      ? fbl::min(options.max_frames, CPUPERF_MAX_NUM_CALLSTACK_FRAMES)
+                      : CPUPERF_MAX_NUM_CALLSTACK_FRAMES),
+      pid_(GetPid()),
+      stop_event_(fbl::move(stop_event)) {}
+
+Sampler::~Sampler() {
+    zx_status_t status = stop_event_.signal(0u, ZX_EVENT_SIGNALED);
+    ZX_DEBUG_ASSERT(status == ZX_OK);
+    thrd_join(thread_, nullptr);
+}
+
+fbl::unique_ptr<Sampler> Sampler::Start(const trace_provider_sampling_options_t& options) {
+    zx::event stop_event;
+    zx_status_t status = zx::event::create(0u, &stop_event);
+    if (status != ZX_OK) {
+        fprintf(stderr, "Sampler: error creating event, status=%d(%s)\n",
+                status, zx_status_get_string(status));
+        return nullptr;
+    }
+
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<Sampler> sampler(new (&ac) Sampler(options, fbl::move(stop_event)));
+    if (!ac.check()) {
+        return nullptr;
+    }
+    if (thrd_create_with_name(&sampler->thread_, &Sampler::ThreadEntry, sampler.get(),
+                              "trace-sampler") != thrd_success) {
+        fprintf(stderr, "Sampler: error creating thread\n");
+        return nullptr;
+    }
+    return sampler;
+}
+
+int Sampler::ThreadEntry(void* arg) {
+    static_cast<Sampler*>(arg)->Run();
+    return 0;
+}
+
+void Sampler::Run() {
+    self_koid_ = GetKoid(zx_thread_self());
+
+    zx::time deadline = zx::clock::get_monotonic();
+    for (;;) {
+        deadline += zx::duration(period_);
+        zx_status_t status = stop_event_.wait_one(ZX_EVENT_SIGNALED, deadline, nullptr);
+        if (status != ZX_ERR_TIMED_OUT) {
+            break;
+        }
+        // Don't try to catch up on periods missed while we were descheduled.
+        zx::time now = zx::clock::get_monotonic();
+        if (deadline < now) {
+            deadline = now;
+        }
+        SampleThreads();
+    }
+}
+
+void Sampler::SampleThreads() {
+    size_t actual = 0;
+    size_t avail = 0;
+    zx_status_t status = zx_object_get_info(zx_process_self(), ZX_INFO_PROCESS_THREADS,
+                                            koids_, sizeof(koids_), &actual, &avail);
+    if (status != ZX_OK || actual == 0) {
+        return;
+    }
+
+    // Take the threads in turn, so that all of them are sampled when there
+    // are more than |max_threads_|.
+    size_t count = fbl::min(actual, static_cast<size_t>(max_threads_));
+    size_t start = next_thread_ % actual;
+    for (size_t i = 0; i < count; i++) {
+        zx_koid_t koid = koids_[(start + i) % actual];
+        if (koid != self_koid_) {
+            SampleThread(koid);
+        }
+    }
+    next_thread_ = start + count;
+}
+
+void Sampler::SampleThread(zx_koid_t koid) {
+    zx::thread thread;
+    zx_status_t status = zx_object_get_child(zx_process_self(), koid, ZX_RIGHT_SAME_RIGHTS,
+                                             thread.reset_and_get_address());
+    if (status != ZX_OK) {
+        // The thread has exited.
+        return;
+    }
+
+    cpuperf_callstack_record_t stack;
+    memset(&stack, 0, sizeof(stack));
+    stack.header.type = CPUPERF_RECORD_CALLSTACK;
+    stack.header.event = CPUPERF_EVENT_ID_NONE;
+    stack.pid = pid_;
+    stack.tid = koid;
+
+    trace_ticks_t ticks;
+    {
+        zx::suspend_token token;
+        if (thread.suspend(&token) != ZX_OK) {
+            return;
+        }
+        zx_signals_t observed = 0u;
+        status = thread.wait_one(ZX_THREAD_SUSPENDED | ZX_THREAD_TERMINATED,
+                                 zx::deadline_after(zx::duration(kSuspendTimeout)), &observed);
+        if (status != ZX_OK || !(observed & ZX_THREAD_SUSPENDED)) {
+            return;
+        }
+        ticks = zx_ticks_get();
+
+        zx_thread_state_general_regs_t regs;
+        if (thread.read_state(ZX_THREAD_STATE_GENERAL_REGS, &regs, sizeof(regs)) != ZX_OK) {
+            return;
+        }
+#if defined(__x86_64__)
+        uintptr_t pc = regs.rip, sp = regs.rsp, fp = regs.rbp;
+#elif defined(__aarch64__)
+        uintptr_t pc = regs.pc, sp = regs.sp, fp = regs.r[29];
+#else
+#error "unsupported architecture"
+#endif
+        uintptr_t frames[CPUPERF_MAX_NUM_CALLSTACK_FRAMES];
+        size_t num_frames = inspector_unwind_frame_pointers(zx_process_self(), pc, sp, fp,
+                                                            frames, max_frames_);
+        stack.num_frames = static_cast<uint16_t>(num_frames);
+        for (size_t i = 0; i < num_frames; i++) {
+            stack.frames[i] = frames[i];
+        }
+        // Closing the token resumes the thread.
+    }
+
+    trace_string_ref_t category_ref;
+    trace_context_t* context = trace_acquire_context_for_category(
+        TRACE_PROVIDER_SAMPLING_CATEGORY, &category_ref);
+    if (!context) {
+        return;
+    }
+    trace_thread_ref_t thread_ref = trace_context_make_registered_thread(context, pid_, koid);
+    trace_string_ref_t name_ref;
+    trace_context_register_string_literal(context, "sample", &name_ref);
+    trace_context_write_instant_event_record(context, ticks, &thread_ref, &category_ref,
+                                             &name_ref, TRACE_SCOPE_THREAD, nullptr, 0u);
+    trace_string_ref_t blob_name_ref;
+    trace_context_register_string_literal(context, "callstack", &blob_name_ref);
+    trace_context_write_blob_record(context, TRACE_BLOB_TYPE_CALLSTACK, &blob_name_ref,
+                                    &stack, CPUPERF_CALLSTACK_RECORD_SIZE(&stack));
+    trace_release_context(context);
+}
+
+} // namespace internal
+} // namespace trace
@@ -0,0 +1,62 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <threads.h>
+
+#include <fbl/macros.h>
+#include <fbl/unique_ptr.h>
+#include <lib/zx/event.h>
+#include <trace-provider/provider.h>
+#include <zircon/types.h>
+
+namespace trace {
+namespace internal {
+
+// Periodically samples the call stacks of the threads of this process into
+// the trace buffer, from a thread of its own.
+//
+// A sampled thread is suspended only while its registers and stack are
+// read, which allocates nothing and takes no locks, so sampling cannot
+// deadlock against the thread.  Records are written after it resumes.
+class Sampler final {
+public:
+    // Starts sampling.  Returns nullptr if the sampling thread could not be
+    // started.
+    static fbl::unique_ptr<Sampler> Start(const trace_provider_sampling_options_t& options);
+
+    // Stops sampling, waiting for the sampling thread to exit.
+    ~Sampler();
+
+private:
+    Sampler(const trace_provider_sampling_options_t& options, zx::event stop_event);
+
+    static int ThreadEntry(void* arg);
+    void Run();
+    void SampleThreads();
+    void SampleThread(zx_koid_t koid);
+
+    // Threads beyond this many are never sampled.
+    static constexpr size_t kMaxThreadKoids = 256;
+
+    const zx_duration_t period_;
+    const uint32_t max_threads_;
+    const uint32_t max_frames_;
+    const zx_koid_t pid_;
+
+    // Signaled with ZX_EVENT_SIGNALED to stop the sampling thread.
+    zx::event stop_event_;
+    thrd_t thread_;
+
+    // Written by the sampling thread only.
+    zx_koid_t self_koid_ = ZX_KOID_INVALID;
+    size_t next_thread_ = 0;
+    zx_koid_t koids_[kMaxThreadKoids];
+
+    DISALLOW_COPY_ASSIGN_AND_MOVE(Sampler);
+};
+
+} // namespace internal
+} // namespace trace
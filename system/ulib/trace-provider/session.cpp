@@ -22,13 +22,15 @@ namespace internal {
 
 Session::Session(void* buffer, size_t buffer_num_bytes,
                  zx::fifo fifo,
-                 fbl::Vector<fbl::String> enabled_categories)
+                 fbl::Vector<fbl::String> enabled_categories,
+                 const trace_provider_sampling_options_t& sampling_options)
     : buffer_(buffer),
       buffer_num_bytes_(buffer_num_bytes),
       fifo_(fbl::move(fifo)),
       fifo_wait_(this, fifo_.get(),
                  ZX_FIFO_READABLE | ZX_FIFO_PEER_CLOSED),
-      enabled_categories_(fbl::move(enabled_categories)) {
+      enabled_categories_(fbl::move(enabled_categories)),
+      sampling_options_(sampling_options) {
     // Build a quick lookup table for IsCategoryEnabled().
     for (const auto& cat : enabled_categories_) {
         auto entry = fbl::make_unique<StringSetEntry>(cat.c_str());
@@ -47,7 +49,8 @@ Session::~Session() {
 void Session::StartEngine(async_dispatcher_t* dispatcher,
                           trace_buffering_mode_t buffering_mode,
                           zx::vmo buffer, zx::fifo fifo,
-                          fbl::Vector<fbl::String> enabled_categories) {
+                          fbl::Vector<fbl::String> enabled_categories,
+                          const trace_provider_sampling_options_t& sampling_options) {
     ZX_DEBUG_ASSERT(buffer);
     ZX_DEBUG_ASSERT(fifo);
 
@@ -94,7 +97,7 @@ void Session::StartEngine(async_dispatcher_t* dispatcher,
 
     auto session = new Session(reinterpret_cast<void*>(buffer_ptr),
                                buffer_num_bytes, fbl::move(fifo),
-                               fbl::move(enabled_categories));
+                               fbl::move(enabled_categories), sampling_options);
 
     status = session->fifo_wait_.Begin(dispatcher);
     if (status != ZX_OK) {
@@ -218,10 +221,19 @@ void Session::TraceStarted() {
     auto status = fifo_.write(sizeof(packet), &packet, 1, nullptr);
     ZX_DEBUG_ASSERT(status == ZX_OK ||
                     status == ZX_ERR_PEER_CLOSED);
+
+    // Sampling suspends threads, so unlike other categories it has to be
+    // asked for by name.
+    if (enabled_category_set_.find(TRACE_PROVIDER_SAMPLING_CATEGORY) !=
+        enabled_category_set_.end()) {
+        sampler_ = Sampler::Start(sampling_options_);
+    }
 }
 
 void Session::TraceStopped(async_dispatcher_t* dispatcher, zx_status_t disposition,
                            size_t buffer_bytes_written) {
+    // The engine has stopped handing out contexts, so the sampler can no
+    // longer write anything; it is joined when the session is deleted.
     // There's no need to notify the trace manager that records were dropped
     // here. That can be determined from the buffer header.
     delete this;
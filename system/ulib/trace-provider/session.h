@@ -15,6 +15,9 @@
 #include <fbl/unique_ptr.h>
 #include <fbl/vector.h>
 #include <lib/zircon-internal/fnv1hash.h>
+#include <trace-provider/provider.h>
+
+#include "sampler.h"
 
 namespace trace {
 namespace internal {
@@ -24,12 +27,14 @@ public:
     static void StartEngine(async_dispatcher_t* dispatcher,
                             trace_buffering_mode_t buffering_mode,
                             zx::vmo buffer, zx::fifo fifo,
-                            fbl::Vector<fbl::String> enabled_categories);
+                            fbl::Vector<fbl::String> enabled_categories,
+                            const trace_provider_sampling_options_t& sampling_options);
     static void StopEngine();
 
 private:
     Session(void* buffer, size_t buffer_num_bytes, zx::fifo fifo,
-                     fbl::Vector<fbl::String> enabled_categories);
+                     fbl::Vector<fbl::String> enabled_categories,
+                     const trace_provider_sampling_options_t& sampling_options);
     ~Session() override;
 
     // |trace::TraceHandler|
@@ -93,6 +98,10 @@ private:
         CategoryStringKeyTraits>;
     StringSet enabled_category_set_;
 
+    const trace_provider_sampling_options_t sampling_options_;
+    // Non-null while sampling.
+    fbl::unique_ptr<Sampler> sampler_;
+
     DISALLOW_COPY_ASSIGN_AND_MOVE(Session);
 };
 
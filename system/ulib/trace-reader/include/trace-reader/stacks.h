@@ -0,0 +1,63 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <fbl/flat_hash_map.h>
+#include <fbl/function.h>
+#include <fbl/macros.h>
+#include <fbl/string.h>
+#include <trace-reader/records.h>
+
+namespace trace {
+
+// Aggregates sampled call stacks into the "folded stacks" format read by
+// flame graph tools: one line per distinct stack, with its frames from the
+// root down separated by semicolons, followed by a space and the number of
+// times the stack was sampled.
+//
+//     1234;0x1f00e2;0x1f0147;0x2ad91c 17
+//
+// The first frame is the koid of the sampled process, so that stacks from
+// different processes are kept apart.  The rest are program counters,
+// which are left for the flame graph tooling to symbolize.
+//
+// Stacks come from blob records of type TRACE_BLOB_TYPE_CALLSTACK, as
+// written by trace-provider's sampling and by cpuperf.
+class StackAggregator final {
+public:
+    // Called once for each distinct stack.
+    using StackVisitor = fbl::Function<void(const fbl::String& folded_stack,
+                                            uint64_t count)>;
+
+    StackAggregator();
+    ~StackAggregator();
+
+    // Adds the stack in |record| if it is a callstack blob, and ignores it
+    // otherwise.  Returns false if the record is a malformed callstack.
+    bool AddRecord(const Record& record);
+
+    // The number of stacks added.
+    uint64_t total_samples() const { return total_samples_; }
+
+    // Calls |visitor| for each distinct stack, in no particular order.
+    void ForEachStack(StackVisitor visitor) const;
+
+private:
+    struct HashTraits {
+        static size_t GetHash(const fbl::String& key);
+        static bool EqualTo(const fbl::String& a, const fbl::String& b) {
+            return a == b;
+        }
+    };
+
+    fbl::FlatHashMap<fbl::String, uint64_t, HashTraits> counts_;
+    uint64_t total_samples_ = 0u;
+
+    DISALLOW_COPY_ASSIGN_AND_MOVE(StackAggregator);
+};
+
+} // namespace trace
@@ -150,6 +150,9 @@ bool TraceReader::ReadMetadataRecord(Chunk& record, RecordHeader header) {
         }
         break;
     }
+    case MetadataType::kPadding:
+        // Nothing to report: padding only fills unused space.
+        break;
     default: {
         // Ignore unknown metadata types for forward compatibility.
         ReportError(fbl::StringPrintf(
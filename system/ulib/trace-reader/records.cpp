@@ -43,7 +43,7 @@ const char* ThreadStateToString(ThreadState state) {
 }
 
 const char* ObjectTypeToString(zx_obj_type_t type) {
-    static_assert(ZX_OBJ_TYPE_LAST == 28, "need to update switch below");
+    static_assert(ZX_OBJ_TYPE_LAST == 29, "need to update switch below");
 
     switch (type) {
     case ZX_OBJ_TYPE_PROCESS:
@@ -92,6 +92,8 @@ const char* ObjectTypeToString(zx_obj_type_t type) {
         return "pmt";
     case ZX_OBJ_TYPE_SUSPEND_TOKEN:
         return "suspend-token";
+    case ZX_OBJ_TYPE_PAGER:
+        return "pager";
     default:
         return "???";
     }
@@ -207,6 +209,9 @@ void MetadataContent::Destroy() {
     case MetadataType::kProviderEvent:
         provider_event_.~ProviderEvent();
         break;
+    case MetadataType::kPadding:
+        // Padding is never reported.
+        break;
     }
 }
 
@@ -222,6 +227,8 @@ void MetadataContent::MoveFrom(MetadataContent&& other) {
     case MetadataType::kProviderEvent:
         new (&provider_event_) ProviderEvent(fbl::move(other.provider_event_));
         break;
+    case MetadataType::kPadding:
+        break;
     }
 }
 
@@ -248,6 +255,8 @@ fbl::String MetadataContent::ToString() const {
         return fbl::StringPrintf("ProviderEvent(id: %" PRId32 ", %s)",
                                  provider_event_.id, name.c_str());
     }
+    case MetadataType::kPadding:
+        break;
     }
     ZX_ASSERT(false);
 }
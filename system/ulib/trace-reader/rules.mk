@@ -14,10 +14,12 @@ MODULE_COMPILEFLAGS += -fvisibility=hidden
 MODULE_SRCS = \
     $(LOCAL_DIR)/reader.cpp \
     $(LOCAL_DIR)/reader_internal.cpp \
-    $(LOCAL_DIR)/records.cpp
+    $(LOCAL_DIR)/records.cpp \
+    $(LOCAL_DIR)/stacks.cpp
 
 MODULE_STATIC_LIBS := \
     system/ulib/trace-engine \
+    system/ulib/zircon-internal \
     system/ulib/zxcpp \
     system/ulib/fbl
 
@@ -37,10 +39,12 @@ MODULE_COMPILEFLAGS += -fvisibility=hidden
 
 MODULE_SRCS = \
     $(LOCAL_DIR)/reader.cpp \
-    $(LOCAL_DIR)/records.cpp
+    $(LOCAL_DIR)/records.cpp \
+    $(LOCAL_DIR)/stacks.cpp
 
 MODULE_COMPILEFLAGS := \
     -Isystem/ulib/trace-engine/include \
+    -Isystem/ulib/zircon-internal/include \
     -Isystem/ulib/fbl/include
 
 MODULE_HOST_LIBS := \
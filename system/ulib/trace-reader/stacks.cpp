@@ -0,0 +1,87 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <trace-reader/stacks.h>
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <fbl/alloc_checker.h>
+#include <fbl/string_buffer.h>
+#include <lib/zircon-internal/device/cpu-trace/cpu-perf.h>
+
+namespace trace {
+namespace {
+
+// Enough for the process koid and CPUPERF_MAX_NUM_CALLSTACK_FRAMES 64-bit
+// program counters, each with its separator.
+constexpr size_t kMaxFoldedStackLength = 24u + CPUPERF_MAX_NUM_CALLSTACK_FRAMES * 20u;
+
+} // namespace
+
+size_t StackAggregator::HashTraits::GetHash(const fbl::String& key) {
+    // 64-bit FNV-1a, with a final mix so that the low bits used to pick a
+    // slot depend on the whole string.
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < key.length(); i++) {
+        hash ^= static_cast<uint8_t>(key[i]);
+        hash *= 0x100000001b3ull;
+    }
+    hash ^= hash >> 33;
+    return static_cast<size_t>(hash);
+}
+
+StackAggregator::StackAggregator() = default;
+
+StackAggregator::~StackAggregator() = default;
+
+bool StackAggregator::AddRecord(const Record& record) {
+    if (record.type() != RecordType::kBlob) {
+        return true;
+    }
+    const Record::Blob& blob = record.GetBlob();
+    if (blob.type != TRACE_BLOB_TYPE_CALLSTACK) {
+        return true;
+    }
+
+    // The record is truncated after its last frame.
+    cpuperf_callstack_record_t stack;
+    if (blob.blob_size < offsetof(cpuperf_callstack_record_t, frames) ||
+        blob.blob_size > sizeof(stack)) {
+        return false;
+    }
+    memcpy(&stack, blob.blob, blob.blob_size);
+    if (stack.num_frames > CPUPERF_MAX_NUM_CALLSTACK_FRAMES ||
+        blob.blob_size < CPUPERF_CALLSTACK_RECORD_SIZE(&stack)) {
+        return false;
+    }
+
+    fbl::StringBuffer<kMaxFoldedStackLength> folded;
+    folded.AppendPrintf("%" PRIu64, stack.pid);
+    for (size_t i = stack.num_frames; i > 0; i--) {
+        folded.AppendPrintf(";%#" PRIx64, stack.frames[i - 1]);
+    }
+
+    fbl::AllocChecker ac;
+    fbl::String key(folded.data(), folded.length(), &ac);
+    if (!ac.check()) {
+        return false;
+    }
+    uint64_t* count = counts_.insert_or_find(fbl::move(key), 0u, &ac);
+    if (count == nullptr) {
+        return false;
+    }
+    ++*count;
+    ++total_samples_;
+    return true;
+}
+
+void StackAggregator::ForEachStack(StackVisitor visitor) const {
+    for (const auto& entry : counts_) {
+        visitor(entry.key, entry.value);
+    }
+}
+
+} // namespace trace
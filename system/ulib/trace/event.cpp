@@ -10,10 +10,10 @@
 namespace {
 
 struct EventHelper {
-    EventHelper(trace_context_t* context, const char* name_literal)
+    EventHelper(trace_context_t* context, trace_string_literal_t* name_literal)
         : ticks(zx_ticks_get()) {
         trace_context_register_current_thread(context, &thread_ref);
-        trace_context_register_string_literal(context, name_literal, &name_ref);
+        trace_context_register_static_string_literal(context, name_literal, &name_ref);
     }
 
     trace_ticks_t const ticks;
@@ -23,13 +23,13 @@ struct EventHelper {
 
 struct VThreadEventHelper {
     VThreadEventHelper(trace_context_t* context,
-                       const char* name_literal,
+                       trace_string_literal_t* name_literal,
                        const char* vthread_literal,
                        trace_vthread_id_t vthread_id)
         : ticks(zx_ticks_get()) {
         trace_context_register_vthread(
             context, ZX_KOID_INVALID, vthread_literal, vthread_id, &thread_ref);
-        trace_context_register_string_literal(context, name_literal, &name_ref);
+        trace_context_register_static_string_literal(context, name_literal, &name_ref);
     }
 
     trace_ticks_t const ticks;
@@ -42,7 +42,7 @@ struct VThreadEventHelper {
 void trace_internal_write_instant_event_record_and_release_context(
     trace_context_t* context,
     const trace_string_ref_t* category_ref,
-    const char* name_literal,
+    trace_string_literal_t* name_literal,
     trace_scope_t scope,
     const trace_arg_t* args, size_t num_args) {
     EventHelper helper(context, name_literal);
@@ -55,7 +55,7 @@ void trace_internal_write_instant_event_record_and_release_context(
 void trace_internal_write_counter_event_record_and_release_context(
     trace_context_t* context,
     const trace_string_ref_t* category_ref,
-    const char* name_literal,
+    trace_string_literal_t* name_literal,
     trace_counter_id_t counter_id,
     const trace_arg_t* args, size_t num_args) {
     EventHelper helper(context, name_literal);
@@ -68,7 +68,7 @@ void trace_internal_write_counter_event_record_and_release_context(
 void trace_internal_write_duration_begin_event_record_and_release_context(
     trace_context_t* context,
     const trace_string_ref_t* category_ref,
-    const char* name_literal,
+    trace_string_literal_t* name_literal,
     const trace_arg_t* args, size_t num_args) {
     EventHelper helper(context, name_literal);
     trace_context_write_duration_begin_event_record(
@@ -80,7 +80,7 @@ void trace_internal_write_duration_begin_event_record_and_release_context(
 void trace_internal_write_duration_end_event_record_and_release_context(
     trace_context_t* context,
     const trace_string_ref_t* category_ref,
-    const char* name_literal,
+    trace_string_literal_t* name_literal,
     const trace_arg_t* args, size_t num_args) {
     EventHelper helper(context, name_literal);
     trace_context_write_duration_end_event_record(
@@ -92,7 +92,7 @@ void trace_internal_write_duration_end_event_record_and_release_context(
 void trace_internal_write_async_begin_event_record_and_release_context(
     trace_context_t* context,
     const trace_string_ref_t* category_ref,
-    const char* name_literal,
+    trace_string_literal_t* name_literal,
     trace_async_id_t async_id,
     const trace_arg_t* args, size_t num_args) {
     EventHelper helper(context, name_literal);
@@ -105,7 +105,7 @@ void trace_internal_write_async_begin_event_record_and_release_context(
 void trace_internal_write_async_instant_event_record_and_release_context(
     trace_context_t* context,
     const trace_string_ref_t* category_ref,
-    const char* name_literal,
+    trace_string_literal_t* name_literal,
     trace_async_id_t async_id,
     const trace_arg_t* args, size_t num_args) {
     EventHelper helper(context, name_literal);
@@ -118,7 +118,7 @@ void trace_internal_write_async_instant_event_record_and_release_context(
 void trace_internal_write_async_end_event_record_and_release_context(
     trace_context_t* context,
     const trace_string_ref_t* category_ref,
-    const char* name_literal,
+    trace_string_literal_t* name_literal,
     trace_async_id_t async_id,
     const trace_arg_t* args, size_t num_args) {
     EventHelper helper(context, name_literal);
@@ -131,7 +131,7 @@ void trace_internal_write_async_end_event_record_and_release_context(
 void trace_internal_write_flow_begin_event_record_and_release_context(
     trace_context_t* context,
     const trace_string_ref_t* category_ref,
-    const char* name_literal,
+    trace_string_literal_t* name_literal,
     trace_flow_id_t flow_id,
     const trace_arg_t* args, size_t num_args) {
     EventHelper helper(context, name_literal);
@@ -144,7 +144,7 @@ void trace_internal_write_flow_begin_event_record_and_release_context(
 void trace_internal_write_flow_step_event_record_and_release_context(
     trace_context_t* context,
     const trace_string_ref_t* category_ref,
-    const char* name_literal,
+    trace_string_literal_t* name_literal,
     trace_flow_id_t flow_id,
     const trace_arg_t* args, size_t num_args) {
     EventHelper helper(context, name_literal);
@@ -157,7 +157,7 @@ void trace_internal_write_flow_step_event_record_and_release_context(
 void trace_internal_write_flow_end_event_record_and_release_context(
     trace_context_t* context,
     const trace_string_ref_t* category_ref,
-    const char* name_literal,
+    trace_string_literal_t* name_literal,
     trace_flow_id_t flow_id,
     const trace_arg_t* args, size_t num_args) {
     EventHelper helper(context, name_literal);
@@ -191,7 +191,7 @@ void trace_internal_write_blob_record_and_release_context(
 void trace_internal_write_vthread_duration_begin_event_record_and_release_context(
     trace_context_t* context,
     const trace_string_ref_t* category_ref,
-    const char* name_literal,
+    trace_string_literal_t* name_literal,
     const char* vthread_literal,
     trace_vthread_id_t vthread_id,
     const trace_arg_t* args, size_t num_args) {
@@ -205,7 +205,7 @@ void trace_internal_write_vthread_duration_begin_event_record_and_release_contex
 void trace_internal_write_vthread_duration_end_event_record_and_release_context(
     trace_context_t* context,
     const trace_string_ref_t* category_ref,
-    const char* name_literal,
+    trace_string_literal_t* name_literal,
     const char* vthread_literal,
     trace_vthread_id_t vthread_id,
     const trace_arg_t* args, size_t num_args) {
@@ -219,7 +219,7 @@ void trace_internal_write_vthread_duration_end_event_record_and_release_context(
 void trace_internal_write_vthread_flow_begin_event_record_and_release_context(
     trace_context_t* context,
     const trace_string_ref_t* category_ref,
-    const char* name_literal,
+    trace_string_literal_t* name_literal,
     const char* vthread_literal,
     trace_vthread_id_t vthread_id,
     trace_flow_id_t flow_id,
@@ -234,7 +234,7 @@ void trace_internal_write_vthread_flow_begin_event_record_and_release_context(
 void trace_internal_write_vthread_flow_step_event_record_and_release_context(
     trace_context_t* context,
     const trace_string_ref_t* category_ref,
-    const char* name_literal,
+    trace_string_literal_t* name_literal,
     const char* vthread_literal,
     trace_vthread_id_t vthread_id,
     trace_flow_id_t flow_id,
@@ -249,7 +249,7 @@ void trace_internal_write_vthread_flow_step_event_record_and_release_context(
 void trace_internal_write_vthread_flow_end_event_record_and_release_context(
     trace_context_t* context,
     const trace_string_ref_t* category_ref,
-    const char* name_literal,
+    trace_string_literal_t* name_literal,
     const char* vthread_literal,
     trace_vthread_id_t vthread_id,
     trace_flow_id_t flow_id,
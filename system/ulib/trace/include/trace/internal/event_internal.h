@@ -25,6 +25,15 @@ __BEGIN_CDECLS
 // Variable used to refer to the current trace category's string ref.
 #define TRACE_INTERNAL_CATEGORY_REF __trace_category_ref
 
+// Variable used to refer to the current trace event's name as a static
+// string literal.
+#define TRACE_INTERNAL_NAME_LITERAL __trace_name_literal
+
+// Static string literals declared for the current trace event's category
+// and name.
+#define TRACE_INTERNAL_STATIC_CATEGORY_LITERAL __trace_static_category_literal
+#define TRACE_INTERNAL_STATIC_NAME_LITERAL __trace_static_name_literal
+
 // Makes a string literal string ref.
 #define TRACE_INTERNAL_MAKE_LITERAL_STRING_REF(string_literal_value) \
     (trace_context_make_registered_string_literal(                   \
@@ -88,75 +97,100 @@ __BEGIN_CDECLS
 #endif // NTRACE
 
 // Scaffolding for a trace macro that has a category (such as a trace event).
+// The category and name are declared as static string literals so that the
+// trace engine can look up their string refs without hashing them.
 #ifndef NTRACE
-#define TRACE_INTERNAL_EVENT_RECORD(category_literal, stmt, args...) \
-    do {                                                             \
-        trace_string_ref_t TRACE_INTERNAL_CATEGORY_REF;              \
-        trace_context_t* TRACE_INTERNAL_CONTEXT =                    \
-            trace_acquire_context_for_category(                      \
-                (category_literal),                                  \
-                &TRACE_INTERNAL_CATEGORY_REF);                       \
-        if (unlikely(TRACE_INTERNAL_CONTEXT)) {                      \
-            TRACE_INTERNAL_DECLARE_ARGS(args);                       \
-            stmt;                                                    \
-        }                                                            \
+#define TRACE_INTERNAL_EVENT_RECORD(category_literal, name_literal, stmt, args...) \
+    do {                                                                           \
+        static trace_string_literal_t TRACE_INTERNAL_STATIC_CATEGORY_LITERAL =     \
+            TRACE_STRING_LITERAL_INIT(category_literal);                           \
+        static trace_string_literal_t TRACE_INTERNAL_STATIC_NAME_LITERAL =         \
+            TRACE_STRING_LITERAL_INIT(name_literal);                               \
+        TRACE_INTERNAL_STATIC_EVENT_RECORD(                                        \
+            &TRACE_INTERNAL_STATIC_CATEGORY_LITERAL,                               \
+            &TRACE_INTERNAL_STATIC_NAME_LITERAL,                                   \
+            stmt, args);                                                           \
+    } while (0)
+#define TRACE_INTERNAL_STATIC_EVENT_RECORD(category, name, stmt, args...) \
+    do {                                                                  \
+        trace_string_literal_t* TRACE_INTERNAL_NAME_LITERAL = (name);     \
+        trace_string_ref_t TRACE_INTERNAL_CATEGORY_REF;                   \
+        trace_context_t* TRACE_INTERNAL_CONTEXT =                         \
+            trace_acquire_context_for_static_category(                    \
+                (category),                                               \
+                &TRACE_INTERNAL_CATEGORY_REF);                            \
+        if (unlikely(TRACE_INTERNAL_CONTEXT)) {                           \
+            TRACE_INTERNAL_DECLARE_ARGS(args);                            \
+            stmt;                                                         \
+        }                                                                 \
     } while (0)
 #else
-#define TRACE_INTERNAL_EVENT_RECORD(category_literal, stmt, args...) \
-    do {                                                             \
-        if (0) {                                                     \
-            trace_string_ref_t TRACE_INTERNAL_CATEGORY_REF;          \
-            trace_context_t* TRACE_INTERNAL_CONTEXT = 0;             \
-            TRACE_INTERNAL_DECLARE_ARGS(args);                       \
-            stmt;                                                    \
-        }                                                            \
+#define TRACE_INTERNAL_EVENT_RECORD(category_literal, name_literal, stmt, args...) \
+    do {                                                                           \
+        if (0) {                                                                   \
+            trace_string_literal_t* TRACE_INTERNAL_NAME_LITERAL = 0;               \
+            trace_string_ref_t TRACE_INTERNAL_CATEGORY_REF;                        \
+            trace_context_t* TRACE_INTERNAL_CONTEXT = 0;                           \
+            TRACE_INTERNAL_DECLARE_ARGS(args);                                     \
+            stmt;                                                                  \
+        }                                                                          \
     } while (0)
 #endif // NTRACE
 
-#define TRACE_INTERNAL_INSTANT(category_literal, name_literal, scope, args...)      \
+#define TRACE_INTERNAL_INSTANT(category_literal, name_literal, scope, args...)                   \
+    TRACE_INTERNAL_EVENT_RECORD(                                                                 \
+        (category_literal), (name_literal),                                                      \
+        trace_internal_write_instant_event_record_and_release_context(                           \
+            TRACE_INTERNAL_CONTEXT,                                                              \
+            &TRACE_INTERNAL_CATEGORY_REF,                                                        \
+            TRACE_INTERNAL_NAME_LITERAL, (scope), TRACE_INTERNAL_ARGS, TRACE_INTERNAL_NUM_ARGS), \
+        args)
+
+#define TRACE_INTERNAL_COUNTER(category_literal, name_literal, counter_id, args...) \
     TRACE_INTERNAL_EVENT_RECORD(                                                    \
-        (category_literal),                                                         \
-        trace_internal_write_instant_event_record_and_release_context(              \
+        (category_literal), (name_literal),                                         \
+        trace_internal_write_counter_event_record_and_release_context(              \
             TRACE_INTERNAL_CONTEXT,                                                 \
             &TRACE_INTERNAL_CATEGORY_REF,                                           \
-            (name_literal), (scope), TRACE_INTERNAL_ARGS, TRACE_INTERNAL_NUM_ARGS), \
+            TRACE_INTERNAL_NAME_LITERAL,                                            \
+            (counter_id), TRACE_INTERNAL_ARGS, TRACE_INTERNAL_NUM_ARGS),            \
         args)
 
-#define TRACE_INTERNAL_COUNTER(category_literal, name_literal, counter_id, args...)      \
-    TRACE_INTERNAL_EVENT_RECORD(                                                         \
-        (category_literal),                                                              \
-        trace_internal_write_counter_event_record_and_release_context(                   \
-            TRACE_INTERNAL_CONTEXT,                                                      \
-            &TRACE_INTERNAL_CATEGORY_REF,                                                \
-            (name_literal), (counter_id), TRACE_INTERNAL_ARGS, TRACE_INTERNAL_NUM_ARGS), \
-        args)
+#define TRACE_INTERNAL_WRITE_DURATION_BEGIN                               \
+    trace_internal_write_duration_begin_event_record_and_release_context( \
+        TRACE_INTERNAL_CONTEXT,                                           \
+        &TRACE_INTERNAL_CATEGORY_REF,                                     \
+        TRACE_INTERNAL_NAME_LITERAL, TRACE_INTERNAL_ARGS, TRACE_INTERNAL_NUM_ARGS)
 
 #define TRACE_INTERNAL_DURATION_BEGIN(category_literal, name_literal, args...) \
     TRACE_INTERNAL_EVENT_RECORD(                                               \
-        (category_literal),                                                    \
-        trace_internal_write_duration_begin_event_record_and_release_context(  \
-            TRACE_INTERNAL_CONTEXT,                                            \
-            &TRACE_INTERNAL_CATEGORY_REF,                                      \
-            (name_literal), TRACE_INTERNAL_ARGS, TRACE_INTERNAL_NUM_ARGS),     \
-        args)
+        (category_literal), (name_literal),                                    \
+        TRACE_INTERNAL_WRITE_DURATION_BEGIN, args)
+
+#define TRACE_INTERNAL_WRITE_DURATION_END                               \
+    trace_internal_write_duration_end_event_record_and_release_context( \
+        TRACE_INTERNAL_CONTEXT,                                         \
+        &TRACE_INTERNAL_CATEGORY_REF,                                   \
+        TRACE_INTERNAL_NAME_LITERAL, TRACE_INTERNAL_ARGS, TRACE_INTERNAL_NUM_ARGS)
 
 #define TRACE_INTERNAL_DURATION_END(category_literal, name_literal, args...) \
     TRACE_INTERNAL_EVENT_RECORD(                                             \
-        (category_literal),                                                  \
-        trace_internal_write_duration_end_event_record_and_release_context(  \
-            TRACE_INTERNAL_CONTEXT,                                          \
-            &TRACE_INTERNAL_CATEGORY_REF,                                    \
-            (name_literal), TRACE_INTERNAL_ARGS, TRACE_INTERNAL_NUM_ARGS),   \
-        args)
+        (category_literal), (name_literal),                                  \
+        TRACE_INTERNAL_WRITE_DURATION_END, args)
 
 #ifndef NTRACE
 #define TRACE_INTERNAL_DECLARE_DURATION_SCOPE(variable, category_literal, name_literal) \
+    static trace_string_literal_t variable##_category =                                 \
+        TRACE_STRING_LITERAL_INIT(category_literal);                                    \
+    static trace_string_literal_t variable##_name =                                     \
+        TRACE_STRING_LITERAL_INIT(name_literal);                                        \
     __attribute__((cleanup(trace_internal_cleanup_duration_scope)))                     \
         trace_internal_duration_scope_t variable;                                       \
-    trace_internal_make_duration_scope(&variable, (category_literal), (name_literal))
+    trace_internal_make_duration_scope(&variable, &variable##_category, &variable##_name)
 #define TRACE_INTERNAL_DURATION_(scope_label, scope_category_literal, scope_name_literal, args...)  \
     TRACE_INTERNAL_DECLARE_DURATION_SCOPE(scope_label, scope_category_literal, scope_name_literal); \
-    TRACE_INTERNAL_DURATION_BEGIN(scope_label.category_literal, scope_label.name_literal, args)
+    TRACE_INTERNAL_STATIC_EVENT_RECORD(scope_label.category, scope_label.name,                      \
+                                       TRACE_INTERNAL_WRITE_DURATION_BEGIN, args)
 #define TRACE_INTERNAL_DURATION(category_literal, name_literal, args...) \
     TRACE_INTERNAL_DURATION_(TRACE_INTERNAL_SCOPE_LABEL(), (category_literal), (name_literal), args)
 #else
@@ -164,58 +198,64 @@ __BEGIN_CDECLS
     TRACE_INTERNAL_DURATION_BEGIN((category_literal), (name_literal), args)
 #endif // NTRACE
 
-#define TRACE_INTERNAL_ASYNC_BEGIN(category_literal, name_literal, async_id, args...)  \
-    TRACE_INTERNAL_EVENT_RECORD(                                                       \
-        (category_literal),                                                            \
-        trace_internal_write_async_begin_event_record_and_release_context(             \
-            TRACE_INTERNAL_CONTEXT,                                                    \
-            &TRACE_INTERNAL_CATEGORY_REF,                                              \
-            (name_literal), (async_id), TRACE_INTERNAL_ARGS, TRACE_INTERNAL_NUM_ARGS), \
+#define TRACE_INTERNAL_ASYNC_BEGIN(category_literal, name_literal, async_id, args...) \
+    TRACE_INTERNAL_EVENT_RECORD(                                                      \
+        (category_literal), (name_literal),                                           \
+        trace_internal_write_async_begin_event_record_and_release_context(            \
+            TRACE_INTERNAL_CONTEXT,                                                   \
+            &TRACE_INTERNAL_CATEGORY_REF,                                             \
+            TRACE_INTERNAL_NAME_LITERAL,                                              \
+            (async_id), TRACE_INTERNAL_ARGS, TRACE_INTERNAL_NUM_ARGS),                \
         args)
 
 #define TRACE_INTERNAL_ASYNC_INSTANT(category_literal, name_literal, async_id, args...) \
     TRACE_INTERNAL_EVENT_RECORD(                                                        \
-        (category_literal),                                                             \
+        (category_literal), (name_literal),                                             \
         trace_internal_write_async_instant_event_record_and_release_context(            \
             TRACE_INTERNAL_CONTEXT,                                                     \
             &TRACE_INTERNAL_CATEGORY_REF,                                               \
-            (name_literal), (async_id), TRACE_INTERNAL_ARGS, TRACE_INTERNAL_NUM_ARGS),  \
+            TRACE_INTERNAL_NAME_LITERAL,                                                \
+            (async_id), TRACE_INTERNAL_ARGS, TRACE_INTERNAL_NUM_ARGS),                  \
         args)
 
-#define TRACE_INTERNAL_ASYNC_END(category_literal, name_literal, async_id, args...)    \
-    TRACE_INTERNAL_EVENT_RECORD(                                                       \
-        (category_literal),                                                            \
-        trace_internal_write_async_end_event_record_and_release_context(               \
-            TRACE_INTERNAL_CONTEXT,                                                    \
-            &TRACE_INTERNAL_CATEGORY_REF,                                              \
-            (name_literal), (async_id), TRACE_INTERNAL_ARGS, TRACE_INTERNAL_NUM_ARGS), \
+#define TRACE_INTERNAL_ASYNC_END(category_literal, name_literal, async_id, args...) \
+    TRACE_INTERNAL_EVENT_RECORD(                                                    \
+        (category_literal), (name_literal),                                         \
+        trace_internal_write_async_end_event_record_and_release_context(            \
+            TRACE_INTERNAL_CONTEXT,                                                 \
+            &TRACE_INTERNAL_CATEGORY_REF,                                           \
+            TRACE_INTERNAL_NAME_LITERAL,                                            \
+            (async_id), TRACE_INTERNAL_ARGS, TRACE_INTERNAL_NUM_ARGS),              \
         args)
 
-#define TRACE_INTERNAL_FLOW_BEGIN(category_literal, name_literal, flow_id, args...)   \
-    TRACE_INTERNAL_EVENT_RECORD(                                                      \
-        (category_literal),                                                           \
-        trace_internal_write_flow_begin_event_record_and_release_context(             \
-            TRACE_INTERNAL_CONTEXT,                                                   \
-            &TRACE_INTERNAL_CATEGORY_REF,                                             \
-            (name_literal), (flow_id), TRACE_INTERNAL_ARGS, TRACE_INTERNAL_NUM_ARGS), \
+#define TRACE_INTERNAL_FLOW_BEGIN(category_literal, name_literal, flow_id, args...) \
+    TRACE_INTERNAL_EVENT_RECORD(                                                    \
+        (category_literal), (name_literal),                                         \
+        trace_internal_write_flow_begin_event_record_and_release_context(           \
+            TRACE_INTERNAL_CONTEXT,                                                 \
+            &TRACE_INTERNAL_CATEGORY_REF,                                           \
+            TRACE_INTERNAL_NAME_LITERAL,                                            \
+            (flow_id), TRACE_INTERNAL_ARGS, TRACE_INTERNAL_NUM_ARGS),               \
         args)
 
-#define TRACE_INTERNAL_FLOW_STEP(category_literal, name_literal, flow_id, args...)    \
-    TRACE_INTERNAL_EVENT_RECORD(                                                      \
-        (category_literal),                                                           \
-        trace_internal_write_flow_step_event_record_and_release_context(              \
-            TRACE_INTERNAL_CONTEXT,                                                   \
-            &TRACE_INTERNAL_CATEGORY_REF,                                             \
-            (name_literal), (flow_id), TRACE_INTERNAL_ARGS, TRACE_INTERNAL_NUM_ARGS), \
+#define TRACE_INTERNAL_FLOW_STEP(category_literal, name_literal, flow_id, args...) \
+    TRACE_INTERNAL_EVENT_RECORD(                                                   \
+        (category_literal), (name_literal),                                        \
+        trace_internal_write_flow_step_event_record_and_release_context(           \
+            TRACE_INTERNAL_CONTEXT,                                                \
+            &TRACE_INTERNAL_CATEGORY_REF,                                          \
+            TRACE_INTERNAL_NAME_LITERAL,                                           \
+            (flow_id), TRACE_INTERNAL_ARGS, TRACE_INTERNAL_NUM_ARGS),              \
         args)
 
-#define TRACE_INTERNAL_FLOW_END(category_literal, name_literal, flow_id, args...)     \
-    TRACE_INTERNAL_EVENT_RECORD(                                                      \
-        (category_literal),                                                           \
-        trace_internal_write_flow_end_event_record_and_release_context(               \
-            TRACE_INTERNAL_CONTEXT,                                                   \
-            &TRACE_INTERNAL_CATEGORY_REF,                                             \
-            (name_literal), (flow_id), TRACE_INTERNAL_ARGS, TRACE_INTERNAL_NUM_ARGS), \
+#define TRACE_INTERNAL_FLOW_END(category_literal, name_literal, flow_id, args...) \
+    TRACE_INTERNAL_EVENT_RECORD(                                                  \
+        (category_literal), (name_literal),                                       \
+        trace_internal_write_flow_end_event_record_and_release_context(           \
+            TRACE_INTERNAL_CONTEXT,                                               \
+            &TRACE_INTERNAL_CATEGORY_REF,                                         \
+            TRACE_INTERNAL_NAME_LITERAL,                                          \
+            (flow_id), TRACE_INTERNAL_ARGS, TRACE_INTERNAL_NUM_ARGS),             \
         args)
 
 #define TRACE_INTERNAL_KERNEL_OBJECT(handle, args...)                             \
@@ -239,123 +279,126 @@ __BEGIN_CDECLS
 #define TRACE_INTERNAL_VTHREAD_DURATION_BEGIN(category_literal, name_literal, vthread_literal, \
                                               vthread_id, args...)                             \
     TRACE_INTERNAL_EVENT_RECORD(                                                               \
-        (category_literal),                                                                    \
+        (category_literal), (name_literal),                                                    \
         trace_internal_write_vthread_duration_begin_event_record_and_release_context(          \
             TRACE_INTERNAL_CONTEXT,                                                            \
             &TRACE_INTERNAL_CATEGORY_REF,                                                      \
-            (name_literal), (vthread_literal), (vthread_id), TRACE_INTERNAL_ARGS,              \
+            TRACE_INTERNAL_NAME_LITERAL, (vthread_literal), (vthread_id), TRACE_INTERNAL_ARGS, \
             TRACE_INTERNAL_NUM_ARGS),                                                          \
         args)
 
-#define TRACE_INTERNAL_VTHREAD_DURATION_END(category_literal, name_literal, vthread_literal, \
-                                            vthread_id, args...)                             \
-    TRACE_INTERNAL_EVENT_RECORD(                                                             \
-        (category_literal),                                                                  \
-        trace_internal_write_vthread_duration_end_event_record_and_release_context(          \
-            TRACE_INTERNAL_CONTEXT,                                                          \
-            &TRACE_INTERNAL_CATEGORY_REF,                                                    \
-            (name_literal), (vthread_literal), (vthread_id), TRACE_INTERNAL_ARGS,            \
-            TRACE_INTERNAL_NUM_ARGS),                                                        \
+#define TRACE_INTERNAL_VTHREAD_DURATION_END(category_literal, name_literal, vthread_literal,   \
+                                            vthread_id, args...)                               \
+    TRACE_INTERNAL_EVENT_RECORD(                                                               \
+        (category_literal), (name_literal),                                                    \
+        trace_internal_write_vthread_duration_end_event_record_and_release_context(            \
+            TRACE_INTERNAL_CONTEXT,                                                            \
+            &TRACE_INTERNAL_CATEGORY_REF,                                                      \
+            TRACE_INTERNAL_NAME_LITERAL, (vthread_literal), (vthread_id), TRACE_INTERNAL_ARGS, \
+            TRACE_INTERNAL_NUM_ARGS),                                                          \
         args)
 
-#define TRACE_INTERNAL_VTHREAD_FLOW_BEGIN(category_literal, name_literal, vthread_literal,   \
-                                          vthread_id, flow_id, args...)                      \
-    TRACE_INTERNAL_EVENT_RECORD(                                                             \
-        (category_literal),                                                                  \
-        trace_internal_write_vthread_flow_begin_event_record_and_release_context(            \
-            TRACE_INTERNAL_CONTEXT,                                                          \
-            &TRACE_INTERNAL_CATEGORY_REF,                                                    \
-            (name_literal), (vthread_literal), (vthread_id), (flow_id), TRACE_INTERNAL_ARGS, \
-            TRACE_INTERNAL_NUM_ARGS),                                                        \
+#define TRACE_INTERNAL_VTHREAD_FLOW_BEGIN(category_literal, name_literal, vthread_literal, \
+                                          vthread_id, flow_id, args...)                    \
+    TRACE_INTERNAL_EVENT_RECORD(                                                           \
+        (category_literal), (name_literal),                                                \
+        trace_internal_write_vthread_flow_begin_event_record_and_release_context(          \
+            TRACE_INTERNAL_CONTEXT,                                                        \
+            &TRACE_INTERNAL_CATEGORY_REF,                                                  \
+            TRACE_INTERNAL_NAME_LITERAL,                                                   \
+            (vthread_literal), (vthread_id), (flow_id), TRACE_INTERNAL_ARGS,               \
+            TRACE_INTERNAL_NUM_ARGS),                                                      \
         args)
 
-#define TRACE_INTERNAL_VTHREAD_FLOW_STEP(category_literal, name_literal, vthread_literal,    \
-                                         vthread_id, flow_id, args...)                       \
-    TRACE_INTERNAL_EVENT_RECORD(                                                             \
-        (category_literal),                                                                  \
-        trace_internal_write_vthread_flow_step_event_record_and_release_context(             \
-            TRACE_INTERNAL_CONTEXT,                                                          \
-            &TRACE_INTERNAL_CATEGORY_REF,                                                    \
-            (name_literal), (vthread_literal), (vthread_id), (flow_id), TRACE_INTERNAL_ARGS, \
-            TRACE_INTERNAL_NUM_ARGS),                                                        \
+#define TRACE_INTERNAL_VTHREAD_FLOW_STEP(category_literal, name_literal, vthread_literal, \
+                                         vthread_id, flow_id, args...)                    \
+    TRACE_INTERNAL_EVENT_RECORD(                                                          \
+        (category_literal), (name_literal),                                               \
+        trace_internal_write_vthread_flow_step_event_record_and_release_context(          \
+            TRACE_INTERNAL_CONTEXT,                                                       \
+            &TRACE_INTERNAL_CATEGORY_REF,                                                 \
+            TRACE_INTERNAL_NAME_LITERAL,                                                  \
+            (vthread_literal), (vthread_id), (flow_id), TRACE_INTERNAL_ARGS,              \
+            TRACE_INTERNAL_NUM_ARGS),                                                     \
         args)
 
-#define TRACE_INTERNAL_VTHREAD_FLOW_END(category_literal, name_literal, vthread_literal,     \
-                                        vthread_id, flow_id, args...)                        \
-    TRACE_INTERNAL_EVENT_RECORD(                                                             \
-        (category_literal),                                                                  \
-        trace_internal_write_vthread_flow_end_event_record_and_release_context(              \
-            TRACE_INTERNAL_CONTEXT,                                                          \
-            &TRACE_INTERNAL_CATEGORY_REF,                                                    \
-            (name_literal), (vthread_literal), (vthread_id), (flow_id), TRACE_INTERNAL_ARGS, \
-            TRACE_INTERNAL_NUM_ARGS),                                                        \
+#define TRACE_INTERNAL_VTHREAD_FLOW_END(category_literal, name_literal, vthread_literal, \
+                                        vthread_id, flow_id, args...)                    \
+    TRACE_INTERNAL_EVENT_RECORD(                                                         \
+        (category_literal), (name_literal),                                              \
+        trace_internal_write_vthread_flow_end_event_record_and_release_context(          \
+            TRACE_INTERNAL_CONTEXT,                                                      \
+            &TRACE_INTERNAL_CATEGORY_REF,                                                \
+            TRACE_INTERNAL_NAME_LITERAL,                                                 \
+            (vthread_literal), (vthread_id), (flow_id), TRACE_INTERNAL_ARGS,             \
+            TRACE_INTERNAL_NUM_ARGS),                                                    \
         args)
 
 void trace_internal_write_instant_event_record_and_release_context(
     trace_context_t* context,
     const trace_string_ref_t* category_ref,
-    const char* name_literal,
+    trace_string_literal_t* name_literal,
     trace_scope_t scope,
     const trace_arg_t* args, size_t num_args);
 
 void trace_internal_write_counter_event_record_and_release_context(
     trace_context_t* context,
     const trace_string_ref_t* category_ref,
-    const char* name_literal,
+    trace_string_literal_t* name_literal,
     uint64_t counter_id,
     const trace_arg_t* args, size_t num_args);
 
 void trace_internal_write_duration_begin_event_record_and_release_context(
     trace_context_t* context,
     const trace_string_ref_t* category_ref,
-    const char* name_literal,
+    trace_string_literal_t* name_literal,
     const trace_arg_t* args, size_t num_args);
 
 void trace_internal_write_duration_end_event_record_and_release_context(
     trace_context_t* context,
     const trace_string_ref_t* category_ref,
-    const char* name_literal,
+    trace_string_literal_t* name_literal,
     const trace_arg_t* args, size_t num_args);
 
 void trace_internal_write_async_begin_event_record_and_release_context(
     trace_context_t* context,
     const trace_string_ref_t* category_ref,
-    const char* name_literal,
+    trace_string_literal_t* name_literal,
     trace_async_id_t async_id,
     const trace_arg_t* args, size_t num_args);
 
 void trace_internal_write_async_instant_event_record_and_release_context(
     trace_context_t* context,
     const trace_string_ref_t* category_ref,
-    const char* name_literal,
+    trace_string_literal_t* name_literal,
     trace_async_id_t async_id,
     const trace_arg_t* args, size_t num_args);
 
 void trace_internal_write_async_end_event_record_and_release_context(
     trace_context_t* context,
     const trace_string_ref_t* category_ref,
-    const char* name_literal,
+    trace_string_literal_t* name_literal,
     trace_async_id_t async_id,
     const trace_arg_t* args, size_t num_args);
 
 void trace_internal_write_flow_begin_event_record_and_release_context(
     trace_context_t* context,
     const trace_string_ref_t* category_ref,
-    const char* name_literal,
+    trace_string_literal_t* name_literal,
     trace_flow_id_t flow_id,
     const trace_arg_t* args, size_t num_args);
 
 void trace_internal_write_flow_step_event_record_and_release_context(
     trace_context_t* context,
     const trace_string_ref_t* category_ref,
-    const char* name_literal,
+    trace_string_literal_t* name_literal,
     trace_flow_id_t flow_id,
     const trace_arg_t* args, size_t num_args);
 
 void trace_internal_write_flow_end_event_record_and_release_context(
     trace_context_t* context,
     const trace_string_ref_t* category_ref,
-    const char* name_literal,
+    trace_string_literal_t* name_literal,
     trace_flow_id_t flow_id,
     const trace_arg_t* args, size_t num_args);
 
@@ -373,7 +416,7 @@ void trace_internal_write_blob_record_and_release_context(
 void trace_internal_write_vthread_duration_begin_event_record_and_release_context(
     trace_context_t* context,
     const trace_string_ref_t* category_ref,
-    const char* name_literal,
+    trace_string_literal_t* name_literal,
     const char* vthread_literal,
     trace_vthread_id_t vthread_id,
     const trace_arg_t* args, size_t num_args);
@@ -381,7 +424,7 @@ void trace_internal_write_vthread_duration_begin_event_record_and_release_contex
 void trace_internal_write_vthread_duration_end_event_record_and_release_context(
     trace_context_t* context,
     const trace_string_ref_t* category_ref,
-    const char* name_literal,
+    trace_string_literal_t* name_literal,
     const char* vthread_literal,
     trace_vthread_id_t vthread_id,
     const trace_arg_t* args, size_t num_args);
@@ -389,7 +432,7 @@ void trace_internal_write_vthread_duration_end_event_record_and_release_context(
 void trace_internal_write_vthread_flow_begin_event_record_and_release_context(
     trace_context_t* context,
     const trace_string_ref_t* category_ref,
-    const char* name_literal,
+    trace_string_literal_t* name_literal,
     const char* vthread_literal,
     trace_vthread_id_t vthread_id,
     trace_flow_id_t flow_id,
@@ -398,7 +441,7 @@ void trace_internal_write_vthread_flow_begin_event_record_and_release_context(
 void trace_internal_write_vthread_flow_step_event_record_and_release_context(
     trace_context_t* context,
     const trace_string_ref_t* category_ref,
-    const char* name_literal,
+    trace_string_literal_t* name_literal,
     const char* vthread_literal,
     trace_vthread_id_t vthread_id,
     trace_flow_id_t flow_id,
@@ -407,7 +450,7 @@ void trace_internal_write_vthread_flow_step_event_record_and_release_context(
 void trace_internal_write_vthread_flow_end_event_record_and_release_context(
     trace_context_t* context,
     const trace_string_ref_t* category_ref,
-    const char* name_literal,
+    trace_string_literal_t* name_literal,
     const char* vthread_literal,
     trace_vthread_id_t vthread_id,
     trace_flow_id_t flow_id,
@@ -416,20 +459,21 @@ void trace_internal_write_vthread_flow_end_event_record_and_release_context(
 #ifndef NTRACE
 // When "destroyed" (by the cleanup attribute), writes a duration end event.
 typedef struct {
-    const char* category_literal;
-    const char* name_literal;
+    trace_string_literal_t* category;
+    trace_string_literal_t* name;
 } trace_internal_duration_scope_t;
 
 static inline void trace_internal_make_duration_scope(
     trace_internal_duration_scope_t* scope,
-    const char* category_literal, const char* name_literal) {
-    scope->category_literal = category_literal;
-    scope->name_literal = name_literal;
+    trace_string_literal_t* category, trace_string_literal_t* name) {
+    scope->category = category;
+    scope->name = name;
 }
 
 static inline void trace_internal_cleanup_duration_scope(
     trace_internal_duration_scope_t* scope) {
-    TRACE_INTERNAL_DURATION_END(scope->category_literal, scope->name_literal);
+    TRACE_INTERNAL_STATIC_EVENT_RECORD(scope->category, scope->name,
+                                       TRACE_INTERNAL_WRITE_DURATION_END);
 }
 #endif // NTRACE
 
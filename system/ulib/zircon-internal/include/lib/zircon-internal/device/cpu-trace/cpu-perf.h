@@ -21,7 +21,7 @@
 __BEGIN_CDECLS
 
 // API version number (useful when doing incompatible upgrades)
-#define CPUPERF_API_VERSION 3
+#define CPUPERF_API_VERSION 4
 
 // Buffer format version
 #define CPUPERF_BUFFER_VERSION 0
@@ -72,6 +72,8 @@ typedef enum {
   CPUPERF_RECORD_PC = 5,
   // The record is a |cpuperf_last_branch_record_t|.
   CPUPERF_RECORD_LAST_BRANCH = 6,
+  // The record is a |cpuperf_callstack_record_t|.
+  CPUPERF_RECORD_CALLSTACK = 7,
 } cpuperf_record_type_t;
 
 // Trace buffer space is expensive, we want to keep records small.
@@ -251,6 +253,40 @@ typedef struct {
     (sizeof(cpuperf_last_branch_record_t) - \
      (CPUPERF_MAX_NUM_LAST_BRANCH - (lbr)->num_branches) * sizeof((lbr)->branches[0]))
 
+// Record the call stack at the time data was collected.
+// It is expected that this record follows a TIME record.
+// Note that this record is variable-length.
+// The stack is recovered by following frame pointers, so frames of code
+// built without them are missed.
+// This is used when doing gprof-like profiling.
+typedef struct {
+    cpuperf_record_header_t header;
+    // Number of entries in |frames|, kernel and user.
+    uint16_t num_frames;
+    // Number of entries at the front of |frames| that are kernel addresses.
+    // The rest are userspace addresses.
+    uint16_t num_kernel_frames;
+    // The aspace id at the time data was collected.
+    // The meaning of the value is architecture-specific.
+    // In the case of x86 this is the cr3 value.
+    uint64_t aspace;
+    // The koids of the process and thread that were running, or zero if a
+    // kernel thread was running.
+    zx_koid_t pid;
+    zx_koid_t tid;
+    // The return addresses, most recent first: |frames[0]| is the pc that
+    // was interrupted.
+    // Note that the emitted record may be smaller than this, as indicated by
+    // |num_frames|.
+#define CPUPERF_MAX_NUM_CALLSTACK_FRAMES (32u)
+    uint64_t frames[CPUPERF_MAX_NUM_CALLSTACK_FRAMES];
+} CPUPERF_ALIGN_RECORD cpuperf_callstack_record_t;
+
+// Return the size of valid call stack record |cs|.
+#define CPUPERF_CALLSTACK_RECORD_SIZE(cs) \
+    (sizeof(cpuperf_callstack_record_t) - \
+     (CPUPERF_MAX_NUM_CALLSTACK_FRAMES - (cs)->num_frames) * sizeof((cs)->frames[0]))
+
 // The properties of this system.
 typedef struct {
     // S/W API version = CPUPERF_API_VERSION.
@@ -301,7 +337,7 @@ typedef struct {
     // TODO(dje): hypervisor, host/guest os/user
     uint32_t flags[CPUPERF_MAX_EVENTS];
 // Valid bits in |flags|.
-#define CPUPERF_CONFIG_FLAG_MASK      0x1f
+#define CPUPERF_CONFIG_FLAG_MASK      0x3f
 // Collect os data.
 #define CPUPERF_CONFIG_FLAG_OS        (1u << 0)
 // Collect userspace data.
@@ -319,6 +355,11 @@ typedef struct {
 // This is only available when the underlying system supports it.
 // TODO(dje): Provide knob to specify how many branches.
 #define CPUPERF_CONFIG_FLAG_LAST_BRANCH (1u << 4)
+// Collect the call stack, kernel and user.
+// Call stacks are emitted as CPUPERF_RECORD_CALLSTACK records.
+// Like CPUPERF_CONFIG_FLAG_LAST_BRANCH this requires the event to be its
+// own timebase.
+#define CPUPERF_CONFIG_FLAG_CALLSTACK (1u << 5)
 } cpuperf_config_t;
 
 ///////////////////////////////////////////////////////////////////////////////
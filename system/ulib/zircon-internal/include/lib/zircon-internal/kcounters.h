@@ -0,0 +1,54 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <stdint.h>
+#include <assert.h>
+#include <zircon/compiler.h>
+
+__BEGIN_CDECLS
+
+// The kernel publishes its counters (see kernel/include/lib/counters.h) as
+// two read-only VMOs, which devmgr installs as files under /boot/kernel:
+//
+// KCOUNTERS_DESC_VMO_NAME holds a kcounters_desc_header_t followed by
+// |num_counters| kcounters_desc_entry_t, sorted by name.  It never changes.
+//
+// KCOUNTERS_ARENA_VMO_NAME holds the live counter values: |max_cpus|
+// arrays of |num_counters| int64_t, one array per cpu, in the order of the
+// descriptors.  A counter's value is the sum over the cpus.  The slots are
+// updated without synchronization, so each one should be read with a single
+// 64-bit load; the sum is only an approximation while the counter moves.
+
+#define KCOUNTERS_DESC_VMO_NAME     "counters/desc"
+#define KCOUNTERS_ARENA_VMO_NAME    "counters/arena"
+
+#define KCOUNTERS_MAGIC             UINT64_C(0x53524e544e434b5a) // "ZKCNTNRS"
+
+// Bumped whenever the layout changes incompatibly.  Readers should reject
+// versions they don't know.
+#define KCOUNTERS_VERSION           1u
+
+#define KCOUNTERS_NAME_LEN          56u
+
+typedef struct kcounters_desc_header {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t num_counters;
+    uint32_t max_cpus;
+    // Size of one kcounters_desc_entry_t, for forward compatibility.
+    uint32_t entry_size;
+} kcounters_desc_header_t;
+
+typedef struct kcounters_desc_entry {
+    // NUL-terminated; longer names are truncated.
+    char name[KCOUNTERS_NAME_LEN];
+    uint64_t reserved;
+} kcounters_desc_entry_t;
+
+static_assert(sizeof(kcounters_desc_header_t) == 24, "");
+static_assert(sizeof(kcounters_desc_entry_t) == 64, "");
+
+__END_CDECLS
@@ -10,6 +10,7 @@
 
 KTRACE_DEF(0x000,32B,VERSION,META) // version
 KTRACE_DEF(0x001,32B,TICKS_PER_MS,META) // lo32, hi32
+KTRACE_DEF(0x002,32B,CPU_BUFFER,META) // cpu, len_lo, len_hi: the next len bytes were on cpu
 
 KTRACE_DEF(0x020,NAME,KTHREAD_NAME,META) // ktid, 0, name[]
 KTRACE_DEF(0x021,NAME,THREAD_NAME,META) // tid, pid, name[]
@@ -19,6 +20,7 @@ KTRACE_DEF(0x024,NAME,IRQ_NAME,META) // num, 0, name[]
 KTRACE_DEF(0x025,NAME,PROBE_NAME,META) // num, 0, name[]
 KTRACE_DEF(0x026,NAME,VCPU_META,META) // meta, 0, name[]
 KTRACE_DEF(0x027,NAME,VCPU_EXIT_META,META) // meta, 0, name[]
+KTRACE_DEF(0x028,NAME,LOCK_CLASS_NAME,META) // id, 0, name[]
 
 KTRACE_DEF(0x030,16B,IRQ_ENTER,IRQ) // (irqn << 8) | cpu
 KTRACE_DEF(0x031,16B,IRQ_EXIT,IRQ) // (irqn << 8) | cpu
@@ -59,6 +61,9 @@ KTRACE_DEF(0x160,32B,KWAIT_BLOCK,SCHEDULER) // queue_hi, queue_hi
 KTRACE_DEF(0x161,32B,KWAIT_WAKE,SCHEDULER) // queue_hi, queue_hi, is_mutex
 KTRACE_DEF(0x162,32B,KWAIT_UNBLOCK,SCHEDULER) // queue_hi, queue_hi, blocked_status
 
+KTRACE_DEF(0x163,32B,LOCK_CONTENDED,SCHEDULER) // id, wait_ns, caller_hi, caller_lo
+KTRACE_DEF(0x164,32B,LOCK_PROFILE,SCHEDULER) // id, acquisitions, contended, wait_us
+
 KTRACE_DEF(0x170,32B,VCPU_ENTER,TASKS)
 KTRACE_DEF(0x171,32B,VCPU_EXIT,TASKS) // meta, exit_address_hi, exit_address_lo
 KTRACE_DEF(0x172,32B,VCPU_BLOCK,TASKS) // meta
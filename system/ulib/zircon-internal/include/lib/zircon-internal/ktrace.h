@@ -25,6 +25,10 @@ __BEGIN_CDECLS
 #define KTRACE_TAG_32B(e,g)       KTRACE_TAG(e,g,32)
 #define KTRACE_TAG_NAME(e,g)      KTRACE_TAG(e,g,48)
 
+// Padding fills the space a record was too large for at the end of a chunk of
+// a circular buffer. It has no group and only its tag is written.
+#define KTRACE_TAG_PAD(siz)       KTRACE_TAG(0,0,siz)
+
 #define KTRACE_LEN(tag)           (((tag)&0xF)<<3)
 #define KTRACE_GROUP(tag)         (((tag)>>20)&0xFFF)
 #define KTRACE_EVENT(tag)         (((tag)>>8)&0xFFF)
@@ -83,10 +87,19 @@ enum {
 #define TAG_PROBE_16(n) KTRACE_TAG(((n)|0x800),KTRACE_GRP_PROBE,16)
 #define TAG_PROBE_24(n) KTRACE_TAG(((n)|0x800),KTRACE_GRP_PROBE,24)
 
+// Boot timeline spans are probes named KTRACE_BOOT_PREFIX "component:step",
+// written by the kernel's init hooks and by userboot, devmgr, devhosts and
+// fshost. The first argument is KTRACE_BOOT_BEGIN or KTRACE_BOOT_END and the
+// second depends on the step: an init level, a koid or a status.
+#define KTRACE_BOOT_PREFIX "boot:"
+#define KTRACE_BOOT_BEGIN 1
+#define KTRACE_BOOT_END   2
+
 // Actions for ktrace control
 #define KTRACE_ACTION_START     1 // options = grpmask, 0 = all
 #define KTRACE_ACTION_STOP      2 // options ignored
 #define KTRACE_ACTION_REWIND    3 // options ignored
 #define KTRACE_ACTION_NEW_PROBE 4 // options ignored, ptr = name
+#define KTRACE_ACTION_START_CIRCULAR 5 // options = grpmask, 0 = all
 
 __END_CDECLS
@@ -12,6 +12,12 @@
 
 extern __LOCAL const struct vdso_constants DATA_CONSTANTS;
 
+// This one is not const: the kernel updates it while processes run.
+// See lib/vdso-time-values.h for how to read it.
+#include <lib/vdso-time-values.h>
+
+extern __LOCAL struct vdso_time_values DATA_TIME_VALUES;
+
 extern "C" {
 
 // This declares the VDSO_zx_* aliases for the vDSO entry points.
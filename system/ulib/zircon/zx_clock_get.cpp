@@ -0,0 +1,36 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "private.h"
+
+// Read DATA_TIME_VALUES.utc_offset under the kernel's sequence lock.
+static int64_t utc_offset(void) {
+    uint64_t seq;
+    int64_t offset;
+    do {
+        seq = __atomic_load_n(&DATA_TIME_VALUES.seq, __ATOMIC_ACQUIRE);
+        offset = __atomic_load_n(&DATA_TIME_VALUES.utc_offset,
+                                 __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while (unlikely((seq & 1) != 0 ||
+                      seq != __atomic_load_n(&DATA_TIME_VALUES.seq,
+                                             __ATOMIC_RELAXED)));
+    return offset;
+}
+
+zx_time_t _zx_clock_get(zx_clock_t clock_id) {
+    if (likely(DATA_CONSTANTS.clock_monotonic_via_ticks)) {
+        switch (clock_id) {
+        case ZX_CLOCK_MONOTONIC:
+            return VDSO_zx_clock_get_monotonic();
+        case ZX_CLOCK_UTC:
+            return VDSO_zx_clock_get_monotonic() + utc_offset();
+        }
+    }
+
+    // ZX_CLOCK_THREAD needs the kernel's accounting of the thread.
+    return SYSCALL_zx_clock_get_via_kernel(clock_id);
+}
+
+VDSO_INTERFACE_FUNCTION(zx_clock_get);
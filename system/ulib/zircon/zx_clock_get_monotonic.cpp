@@ -0,0 +1,23 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <lib/fixed_point.h>
+
+#include "private.h"
+
+zx_time_t _zx_clock_get_monotonic(void) {
+    if (unlikely(!DATA_CONSTANTS.clock_monotonic_via_ticks))
+        return SYSCALL_zx_clock_get_monotonic_via_kernel();
+
+    // This is the same arithmetic the kernel's current_time() does on the
+    // same counter, so the result agrees exactly with the syscall's.
+    const struct fp_32_64 ns_per_tick = {
+        DATA_CONSTANTS.ns_per_tick.l0,
+        DATA_CONSTANTS.ns_per_tick.l32,
+        DATA_CONSTANTS.ns_per_tick.l64,
+    };
+    return u64_mul_u64_fp32_64(VDSO_zx_ticks_get(), ns_per_tick);
+}
+
+VDSO_INTERFACE_FUNCTION(zx_clock_get_monotonic);
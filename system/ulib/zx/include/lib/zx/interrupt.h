@@ -50,6 +50,10 @@ public:
     zx_status_t ack() {
         return zx_interrupt_ack(get());
     }
+
+    zx_status_t set_affinity(uint32_t options, uint32_t cpu) {
+        return zx_interrupt_set_affinity(get(), options, cpu);
+    }
 };
 
 using unowned_interrupt = unowned<interrupt>;
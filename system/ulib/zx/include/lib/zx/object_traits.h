@@ -17,6 +17,7 @@ class guest;
 class fifo;
 class interrupt;
 class pmt;
+class pager;
 
 // The default traits supports:
 // - event
@@ -69,6 +70,13 @@ template <> struct object_traits<pmt> {
     static constexpr bool has_peer_handle = false;
 };
 
+template <> struct object_traits<pager> {
+    static constexpr bool supports_duplication = true;
+    static constexpr bool supports_user_signal = false;
+    static constexpr bool supports_wait = false;
+    static constexpr bool has_peer_handle = false;
+};
+
 template <> struct object_traits<socket> {
     static constexpr bool supports_duplication = true;
     static constexpr bool supports_user_signal = true;
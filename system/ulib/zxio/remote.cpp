@@ -11,6 +11,10 @@
 
 #define ZXIO_REMOTE_CHUNK_SIZE 8192
 
+// Transfers of at least this many bytes are moved through a VMO in a single
+// round trip, rather than in chunks of |ZXIO_REMOTE_CHUNK_SIZE|.
+#define ZXIO_REMOTE_VMO_THRESHOLD (64 * 1024)
+
 static zx_status_t zxio_remote_release(zxio_t* io, zx_handle_t* out_handle) {
     zxio_remote_t* rio = reinterpret_cast<zxio_remote_t*>(io);
     zx_handle_t control = rio->control;
@@ -65,6 +69,86 @@ static zx_status_t zxio_remote_attr_set(zxio_t* io, uint32_t flags, const zxio_n
     return io_status != ZX_OK ? io_status : status;
 }
 
+// Reads up to |capacity| bytes through a VMO, at |offset| if |at| is set and
+// at the seek offset otherwise. Returns ZX_ERR_NOT_SUPPORTED if the server
+// doesn't read into VMOs.
+static zx_status_t zxio_remote_read_vmo(zxio_remote_t* rio, bool at, size_t offset,
+                                        uint8_t* buffer, size_t capacity,
+                                        size_t* out_actual) {
+    zx_handle_t vmo, transfer;
+    zx_status_t status = zx_vmo_create(capacity, 0, &vmo);
+    if (status != ZX_OK) {
+        return status;
+    }
+    if ((status = zx_handle_duplicate(vmo, ZX_RIGHT_SAME_RIGHTS, &transfer)) != ZX_OK) {
+        zx_handle_close(vmo);
+        return status;
+    }
+
+    size_t actual = 0u;
+    zx_status_t io_status;
+    if (at) {
+        io_status = fuchsia_io_FileReadVmoAt(rio->control, capacity, offset, transfer, 0,
+                                             &status, &actual);
+    } else {
+        io_status = fuchsia_io_FileReadVmo(rio->control, capacity, transfer, 0, &status,
+                                           &actual);
+    }
+    if (io_status != ZX_OK) {
+        status = io_status;
+    } else if (status == ZX_OK && actual > capacity) {
+        status = ZX_ERR_IO;
+    }
+    if (status == ZX_OK) {
+        status = zx_vmo_read(vmo, buffer, 0, actual);
+    }
+    zx_handle_close(vmo);
+    if (status != ZX_OK) {
+        return status;
+    }
+    *out_actual = actual;
+    return ZX_OK;
+}
+
+// Writes |capacity| bytes through a VMO, at |offset| if |at| is set and at
+// the seek offset otherwise. Returns ZX_ERR_NOT_SUPPORTED if the server
+// doesn't write from VMOs.
+static zx_status_t zxio_remote_write_vmo(zxio_remote_t* rio, bool at, size_t offset,
+                                         const uint8_t* buffer, size_t capacity,
+                                         size_t* out_actual) {
+    zx_handle_t vmo;
+    zx_status_t status = zx_vmo_create(capacity, 0, &vmo);
+    if (status != ZX_OK) {
+        return status;
+    }
+    if ((status = zx_vmo_write(vmo, buffer, 0, capacity)) != ZX_OK) {
+        zx_handle_close(vmo);
+        return status;
+    }
+
+    // The VMO isn't read again, so it is handed to the server.
+    size_t actual = 0u;
+    zx_status_t io_status;
+    if (at) {
+        io_status = fuchsia_io_FileWriteVmoAt(rio->control, capacity, offset, vmo, 0,
+                                              &status, &actual);
+    } else {
+        io_status = fuchsia_io_FileWriteVmo(rio->control, capacity, vmo, 0, &status,
+                                            &actual);
+    }
+    if (io_status != ZX_OK) {
+        return io_status;
+    }
+    if (status != ZX_OK) {
+        return status;
+    }
+    if (actual > capacity) {
+        return ZX_ERR_IO;
+    }
+    *out_actual = actual;
+    return ZX_OK;
+}
+
 static zx_status_t zxio_remote_read_once(zxio_remote_t* rio, uint8_t* buffer,
                                          size_t capacity, size_t* out_actual) {
     size_t actual = 0u;
@@ -88,6 +172,13 @@ static zx_status_t zxio_remote_read(zxio_t* io, void* data, size_t capacity,
                                     size_t* out_actual) {
     zxio_remote_t* rio = reinterpret_cast<zxio_remote_t*>(io);
     uint8_t* buffer = static_cast<uint8_t*>(data);
+    if (capacity >= ZXIO_REMOTE_VMO_THRESHOLD) {
+        zx_status_t status = zxio_remote_read_vmo(rio, false, 0, buffer, capacity,
+                                                  out_actual);
+        if (status != ZX_ERR_NOT_SUPPORTED) {
+            return status;
+        }
+    }
     size_t received = 0;
     while (capacity > 0) {
         size_t chunk = (capacity > ZXIO_REMOTE_CHUNK_SIZE) ? ZXIO_REMOTE_CHUNK_SIZE : capacity;
@@ -131,6 +222,13 @@ static zx_status_t zxio_remote_read_at(zxio_t* io, size_t offset, void* data,
                                        size_t capacity, size_t* out_actual) {
     zxio_remote_t* rio = reinterpret_cast<zxio_remote_t*>(io);
     uint8_t* buffer = static_cast<uint8_t*>(data);
+    if (capacity >= ZXIO_REMOTE_VMO_THRESHOLD) {
+        zx_status_t status = zxio_remote_read_vmo(rio, true, offset, buffer, capacity,
+                                                  out_actual);
+        if (status != ZX_ERR_NOT_SUPPORTED) {
+            return status;
+        }
+    }
     size_t received = 0;
     while (capacity > 0) {
         size_t chunk = (capacity > ZXIO_REMOTE_CHUNK_SIZE) ? ZXIO_REMOTE_CHUNK_SIZE : capacity;
@@ -175,6 +273,13 @@ static zx_status_t zxio_remote_write(zxio_t* io, const void* data,
                                      size_t capacity, size_t* out_actual) {
     zxio_remote_t* rio = reinterpret_cast<zxio_remote_t*>(io);
     const uint8_t* buffer = static_cast<const uint8_t*>(data);
+    if (capacity >= ZXIO_REMOTE_VMO_THRESHOLD) {
+        zx_status_t status = zxio_remote_write_vmo(rio, false, 0, buffer, capacity,
+                                                   out_actual);
+        if (status != ZX_ERR_NOT_SUPPORTED) {
+            return status;
+        }
+    }
     size_t sent = 0u;
     while (capacity > 0) {
         size_t chunk = (capacity > ZXIO_REMOTE_CHUNK_SIZE) ? ZXIO_REMOTE_CHUNK_SIZE : capacity;
@@ -220,6 +325,13 @@ static zx_status_t zxio_remote_write_at(zxio_t* io, size_t offset,
                                         size_t* out_actual) {
     zxio_remote_t* rio = reinterpret_cast<zxio_remote_t*>(io);
     const uint8_t* buffer = static_cast<const uint8_t*>(data);
+    if (capacity >= ZXIO_REMOTE_VMO_THRESHOLD) {
+        zx_status_t status = zxio_remote_write_vmo(rio, true, offset, buffer, capacity,
+                                                   out_actual);
+        if (status != ZX_ERR_NOT_SUPPORTED) {
+            return status;
+        }
+    }
     size_t sent = 0u;
     while (capacity > 0) {
         size_t chunk = (capacity > ZXIO_REMOTE_CHUNK_SIZE) ? ZXIO_REMOTE_CHUNK_SIZE : capacity;
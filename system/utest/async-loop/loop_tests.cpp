@@ -751,6 +751,48 @@ bool task_test() {
     END_TEST;
 }
 
+bool task_order_test() {
+    BEGIN_TEST;
+
+    async::Loop loop(&kAsyncLoopConfigNoAttachToThread);
+
+    zx::time start_time = async::Now(loop.dispatcher());
+    TestTask task1;
+    QuitTask task2;
+    TestTask task3;
+    TestTask task4;
+
+    // Tasks which are already due run earliest deadline first, regardless of
+    // the order they were posted in or of any delayed tasks pending before them.
+    EXPECT_EQ(ZX_OK, task1.PostForTime(loop.dispatcher(), start_time + zx::sec(3600)), "post 1");
+    EXPECT_EQ(ZX_OK, task2.PostForTime(loop.dispatcher(), start_time), "post 2");
+    EXPECT_EQ(ZX_OK, task3.PostForTime(loop.dispatcher(), start_time - zx::msec(1)), "post 3");
+    EXPECT_EQ(ZX_OK, task4.PostForTime(loop.dispatcher(), start_time), "post 4");
+
+    EXPECT_EQ(ZX_ERR_CANCELED, loop.Run(), "run loop");
+    EXPECT_EQ(0u, task1.run_count, "run count 1");
+    EXPECT_EQ(1u, task2.run_count, "run count 2");
+    EXPECT_EQ(1u, task3.run_count, "run count 3");
+    EXPECT_EQ(ZX_OK, task3.last_status, "status 3");
+    EXPECT_EQ(0u, task4.run_count, "run count 4");
+
+    // A due task left over when the loop quit can still be canceled.
+    EXPECT_EQ(ZX_OK, task4.Cancel(loop.dispatcher()), "cancel 4");
+    QuitTask task5;
+    EXPECT_EQ(ZX_OK, task5.PostForTime(loop.dispatcher(), start_time + zx::msec(1)), "post 5");
+    EXPECT_EQ(ZX_OK, loop.ResetQuit());
+    EXPECT_EQ(ZX_ERR_CANCELED, loop.Run(), "run loop");
+    EXPECT_EQ(0u, task1.run_count, "run count 1");
+    EXPECT_EQ(0u, task4.run_count, "run count 4");
+    EXPECT_EQ(1u, task5.run_count, "run count 5");
+
+    loop.Shutdown();
+    EXPECT_EQ(1u, task1.run_count, "run count 1");
+    EXPECT_EQ(ZX_ERR_CANCELED, task1.last_status, "status 1");
+
+    END_TEST;
+}
+
 bool task_shutdown_test() {
     BEGIN_TEST;
 
@@ -1087,6 +1129,38 @@ protected:
     }
 };
 
+class ThreadRecordingTask : public QuitTask {
+public:
+    ThreadRecordingTask() = default;
+
+    thrd_t thread{};
+
+protected:
+    void Handle(async_dispatcher_t* dispatcher, zx_status_t status) override {
+        thread = thrd_current();
+        QuitTask::Handle(dispatcher, status);
+    }
+};
+
+class PostingReceiver : public TestReceiver {
+public:
+    PostingReceiver(TestTask* task)
+        : task_(task) {}
+
+    thrd_t thread{};
+    zx_status_t post_result = ZX_ERR_INTERNAL;
+
+protected:
+    TestTask* task_;
+
+    void Handle(async_dispatcher_t* dispatcher, zx_status_t status,
+                const zx_packet_user_t* data) override {
+        TestReceiver::Handle(dispatcher, status, data);
+        thread = thrd_current();
+        post_result = task_->Post(dispatcher);
+    }
+};
+
 class ThreadAssertReceiver : public TestReceiver {
 public:
     ThreadAssertReceiver(ConcurrencyMeasure* measure)
@@ -1271,6 +1345,33 @@ bool threads_tasks_run_sequentially_test() {
     END_TEST;
 }
 
+// A task which is due when a handler posts it runs on the handler's thread.
+bool threads_tasks_posted_by_handler_run_on_handler_thread_test() {
+    const size_t num_threads = 4;
+
+    BEGIN_TEST;
+
+    async::Loop loop(&kAsyncLoopConfigNoAttachToThread);
+    for (size_t i = 0; i < num_threads; i++) {
+        EXPECT_EQ(ZX_OK, loop.StartThread(), "start thread");
+    }
+
+    ThreadRecordingTask task;
+    PostingReceiver receiver(&task);
+    EXPECT_EQ(ZX_OK, receiver.QueuePacket(loop.dispatcher(), nullptr), "queue packet");
+
+    // Wait until quitted by the task.
+    loop.JoinThreads();
+
+    EXPECT_EQ(1u, receiver.run_count, "receiver run count");
+    EXPECT_EQ(ZX_OK, receiver.post_result, "post task");
+    EXPECT_EQ(1u, task.run_count, "task run count");
+    EXPECT_EQ(ZX_OK, task.last_status, "task status");
+    EXPECT_TRUE(thrd_equal(receiver.thread, task.thread), "task ran on handler thread");
+
+    END_TEST;
+}
+
 // The goal here is to schedule a lot of work and see whether it runs
 // on as many threads as we expected it to.
 bool threads_receivers_run_concurrently_test() {
@@ -1379,6 +1480,7 @@ RUN_TEST(wait_test)
 RUN_TEST(wait_unwaitable_handle_test)
 RUN_TEST(wait_shutdown_test)
 RUN_TEST(task_test)
+RUN_TEST(task_order_test)
 RUN_TEST(task_shutdown_test)
 RUN_TEST(receiver_test)
 RUN_TEST(receiver_shutdown_test)
@@ -1390,6 +1492,7 @@ for (int i = 0; i < 3; i++) {
     RUN_TEST(threads_shutdown)
     RUN_TEST(threads_waits_run_concurrently_test)
     RUN_TEST(threads_tasks_run_sequentially_test)
+    RUN_TEST(threads_tasks_posted_by_handler_run_on_handler_thread_test)
     RUN_TEST(threads_receivers_run_concurrently_test)
     RUN_TEST(threads_exceptions_run_concurrently_test)
 }
@@ -7,6 +7,7 @@
 #include <stdint.h>
 #include <sys/stat.h>
 
+#include <blobfs/chunked.h>
 #include <blobfs/format.h>
 #include <digest/digest.h>
 #include <digest/merkle-tree.h>
@@ -159,6 +160,66 @@ bool MakeBlob(fbl::String fs_path, size_t blob_size, unsigned int* seed,
     END_HELPER;
 }
 
+fbl::String GetNameForAlgorithm(blobfs::CompressionAlgorithm algorithm) {
+    switch (algorithm) {
+    case blobfs::CompressionAlgorithm::kLz4:
+        return "Lz4";
+    case blobfs::CompressionAlgorithm::kLz4Hc:
+        return "Lz4Hc";
+    }
+
+    return "";
+}
+
+// Measures how quickly a blob compressed with |algorithm| is decompressed in
+// memory, which is the CPU time traded for the blocks the algorithm saves.
+// The blob is made of random words, so that it compresses about as well as
+// text does.
+bool DecompressTest(blobfs::CompressionAlgorithm algorithm, size_t blob_size,
+                    perftest::RepeatState* state, Fixture* fixture) {
+    BEGIN_HELPER;
+    static const char* const kWords[] = {
+        "blob", "block", "chunk", "digest", "merkle", "node", "tree", "verify",
+        "zircon", "fuchsia", "kernel", "vmo", "page", "read", "write", "flash",
+    };
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<uint8_t[]> data(new (&ac) uint8_t[blob_size]);
+    ASSERT_TRUE(ac.check());
+    size_t offset = 0;
+    while (offset < blob_size) {
+        const char* word = kWords[rand_r(fixture->mutable_seed()) % fbl::count_of(kWords)];
+        for (size_t i = 0; word[i] != '\0' && offset < blob_size; i++) {
+            data[offset++] = word[i];
+        }
+        if (offset < blob_size) {
+            data[offset++] = ' ';
+        }
+    }
+
+    const size_t buf_size = blobfs::ChunkedCompressor::BufferMax(blob_size);
+    fbl::unique_ptr<uint8_t[]> compressed(new (&ac) uint8_t[buf_size]);
+    ASSERT_TRUE(ac.check());
+    blobfs::ChunkedCompressor compressor;
+    ASSERT_EQ(compressor.Initialize(compressed.get(), buf_size, blob_size, algorithm), ZX_OK);
+    ASSERT_EQ(compressor.Update(data.get(), blob_size), ZX_OK);
+    ASSERT_EQ(compressor.End(), ZX_OK);
+    printf("%s compresses %zu bytes to %zu bytes\n", GetNameForAlgorithm(algorithm).c_str(),
+           blob_size, compressor.Size());
+
+    blobfs::ChunkedDecompressor decompressor;
+    ASSERT_EQ(decompressor.Init(compressed.get(), compressor.Size(), compressor.Size(),
+                                blob_size),
+              ZX_OK);
+    fbl::unique_ptr<uint8_t[]> out(new (&ac) uint8_t[blob_size]);
+    ASSERT_TRUE(ac.check());
+
+    while (state->KeepRunning()) {
+        ASSERT_EQ(decompressor.DecompressAll(compressed.get(), out.get(), 1), ZX_OK);
+    }
+    ASSERT_EQ(memcmp(out.get(), data.get(), blob_size), 0);
+    END_HELPER;
+}
+
 // Returns a path within the fs such that it is a valid blobpath.
 // The generated path is 'root_path/0....0'.
 fbl::String GetNegativeLookupPath(const fbl::String& fs_path) {
@@ -329,6 +390,14 @@ bool RunBenchmark(int argc, char** argv) {
         ReadOrder::kSequentialReverse,
         ReadOrder::kRandom,
     };
+    const blobfs::CompressionAlgorithm algorithms[] = {
+        blobfs::CompressionAlgorithm::kLz4,
+        blobfs::CompressionAlgorithm::kLz4Hc,
+    };
+    const size_t decompress_sizes[] = {
+        128 * 1024,       // 128 Kb
+        8 * 1024 * 1024,  // 8 MB
+    };
 
     if (!fs_test_utils::ParseCommandLineArgs(argc, argv, &f_opts, &p_opts)) {
         return false;
@@ -384,6 +453,24 @@ bool RunBenchmark(int argc, char** argv) {
         }
     }
 
+    TestCaseInfo decompress_testcase;
+    decompress_testcase.teardown = false;
+    decompress_testcase.sample_count = kSampleCount;
+    for (auto algorithm : algorithms) {
+        for (auto blob_size : decompress_sizes) {
+            TestInfo decompress_test;
+            decompress_test.name = fbl::StringPrintf(
+                "%s/Decompress/%s/%s", disk_format_string_[f_opts.fs_type],
+                GetNameForAlgorithm(algorithm).c_str(), GetNameForSize(blob_size).c_str());
+            decompress_test.test_fn = [algorithm, blob_size](perftest::RepeatState* state,
+                                                             fs_test_utils::Fixture* fixture) {
+                return DecompressTest(algorithm, blob_size, state, fixture);
+            };
+            decompress_testcase.tests.push_back(fbl::move(decompress_test));
+        }
+    }
+    testcases.push_back(fbl::move(decompress_testcase));
+
     return fs_test_utils::RunTestCases(f_opts, p_opts, testcases);
 }
 
@@ -13,6 +13,8 @@
 #include <utime.h>
 
 #include <blobfs/format.h>
+#include <blobfs/chunked.h>
+#include <blobfs/extent-index.h>
 #include <blobfs/lz4.h>
 #include <digest/digest.h>
 #include <digest/merkle-tree.h>
@@ -30,6 +32,7 @@
 #include <fvm/fvm.h>
 #include <lib/async-loop/cpp/loop.h>
 #include <lib/fdio/io.h>
+#include <lib/fdio/util.h>
 #include <lib/fzl/fdio.h>
 #include <lib/memfs/memfs.h>
 #include <unittest/unittest.h>
@@ -818,6 +821,57 @@ static bool TestMmap(BlobfsTest* blobfsTest) {
     END_HELPER;
 }
 
+// Readable blobs are read from their VMO by the client. Check that reads and
+// seeks behave as they do through the server, including once the connection
+// is handed to another file descriptor part way through the blob.
+static bool TestReadImmutable(BlobfsTest* blobfsTest) {
+    BEGIN_HELPER;
+    fbl::unique_ptr<blob_info_t> info;
+    ASSERT_TRUE(GenerateRandomBlob(1 << 14, &info));
+
+    fbl::unique_fd fd;
+    ASSERT_TRUE(MakeBlob(info.get(), &fd));
+    ASSERT_EQ(close(fd.release()), 0);
+    fd.reset(open(info->path, O_RDONLY));
+    ASSERT_TRUE(fd, "Failed to-reopen blob");
+
+    const off_t half = static_cast<off_t>(info->size_data / 2);
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<char[]> buf(new (&ac) char[info->size_data]);
+    ASSERT_TRUE(ac.check());
+    ASSERT_EQ(pread(fd.get(), buf.get(), info->size_data, 1),
+              static_cast<ssize_t>(info->size_data - 1));
+    ASSERT_EQ(memcmp(buf.get(), &info->data[1], info->size_data - 1), 0);
+    ASSERT_EQ(pread(fd.get(), buf.get(), 1, info->size_data + 1), 0);
+
+    ASSERT_EQ(lseek(fd.get(), 0, SEEK_CUR), 0);
+    ASSERT_LT(lseek(fd.get(), -1, SEEK_SET), 0);
+    ASSERT_EQ(lseek(fd.get(), -1, SEEK_END), static_cast<off_t>(info->size_data - 1));
+    ASSERT_EQ(read(fd.get(), buf.get(), 2), 1);
+    ASSERT_EQ(buf[0], info->data[info->size_data - 1]);
+    ASSERT_EQ(read(fd.get(), buf.get(), 1), 0);
+
+    ASSERT_EQ(lseek(fd.get(), 0, SEEK_SET), 0);
+    ASSERT_EQ(read(fd.get(), buf.get(), half), half);
+    ASSERT_EQ(memcmp(buf.get(), info->data.get(), half), 0);
+    ASSERT_EQ(lseek(fd.get(), 0, SEEK_CUR), half);
+
+    zx_handle_t handles[FDIO_MAX_HANDLES];
+    uint32_t types[FDIO_MAX_HANDLES];
+    zx_status_t count = fdio_transfer_fd(fd.release(), 0, handles, types);
+    ASSERT_GT(count, 0);
+    int raw_fd;
+    ASSERT_EQ(fdio_create_fd(handles, types, count, &raw_fd), ZX_OK);
+    fd.reset(raw_fd);
+    ASSERT_EQ(read(fd.get(), buf.get(), info->size_data),
+              static_cast<ssize_t>(info->size_data - half));
+    ASSERT_EQ(memcmp(buf.get(), &info->data[half], info->size_data - half), 0);
+
+    ASSERT_EQ(close(fd.release()), 0);
+    ASSERT_EQ(unlink(info->path), 0);
+    END_HELPER;
+}
+
 static bool TestMmapUseAfterClose(BlobfsTest* blobfsTest) {
     BEGIN_HELPER;
     for (size_t i = 10; i < 16; i++) {
@@ -2367,6 +2421,176 @@ static bool TestCompressorBufferTooSmall(void) {
     END_TEST;
 }
 
+// Ensure chunks of a blob compressed by ChunkedCompressor decompress both
+// all at once and on their own.
+static bool TestChunkedCompressorRoundTrip(void) {
+    BEGIN_TEST;
+    const size_t blob_size = 10 * blobfs::kChunkSize + 1234;
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<uint8_t[]> data(new (&ac) uint8_t[blob_size]);
+    ASSERT_TRUE(ac.check());
+    unsigned int seed = 0;
+    for (size_t i = 0; i < blob_size; i++) {
+        // Alternate between runs of random and repeated data, so that some
+        // chunks compress while others are stored as is.
+        data[i] = (i / blobfs::kChunkSize) % 2 ? static_cast<uint8_t>(rand_r(&seed))
+                                               : static_cast<uint8_t>(i % 7);
+    }
+
+    const size_t buf_size = blobfs::ChunkedCompressor::BufferMax(blob_size);
+    fbl::unique_ptr<uint8_t[]> buf(new (&ac) uint8_t[buf_size]);
+    ASSERT_TRUE(ac.check());
+    blobfs::ChunkedCompressor c;
+    ASSERT_EQ(c.Initialize(buf.get(), buf_size, blob_size), ZX_OK);
+    // Feed the data in pieces which don't line up with chunks.
+    for (size_t offset = 0; offset < blob_size; offset += 5000) {
+        ASSERT_EQ(c.Update(&data[offset], fbl::min(blob_size - offset, size_t{5000})), ZX_OK);
+    }
+    ASSERT_EQ(c.End(), ZX_OK);
+    ASSERT_LT(c.Size(), blob_size);
+
+    blobfs::ChunkedDecompressor d;
+    ASSERT_EQ(d.Init(buf.get(), c.Size(), c.Size(), blob_size), ZX_OK);
+    ASSERT_EQ(d.ChunkCount(), 11u);
+    fbl::unique_ptr<uint8_t[]> out(new (&ac) uint8_t[blob_size]);
+    ASSERT_TRUE(ac.check());
+    ASSERT_EQ(d.DecompressAll(buf.get(), out.get(), 4), ZX_OK);
+    ASSERT_EQ(memcmp(out.get(), data.get(), blob_size), 0);
+
+    // Decompress the last chunk alone, from a copy of just its bytes.
+    uint64_t first, last, offset, length;
+    d.ChunksFor(blob_size - 1, 1, &first, &last);
+    ASSERT_EQ(first, 10u);
+    ASSERT_EQ(last, 10u);
+    d.CompressedRange(first, last, &offset, &length);
+    fbl::unique_ptr<uint8_t[]> chunk(new (&ac) uint8_t[length]);
+    ASSERT_TRUE(ac.check());
+    memcpy(chunk.get(), &buf[offset], length);
+    memset(out.get(), 0, blob_size);
+    ASSERT_EQ(d.ChunkLength(first), 1234u);
+    ASSERT_EQ(d.DecompressChunk(first, chunk.get(), offset, out.get()), ZX_OK);
+    ASSERT_EQ(memcmp(out.get(), &data[first * blobfs::kChunkSize], 1234), 0);
+    END_TEST;
+}
+
+// Ensure LZ4HC stores a blob in no more space than LZ4, and that the result
+// decompresses the same way.
+static bool TestChunkedCompressorHighCompression(void) {
+    BEGIN_TEST;
+    const size_t blob_size = 4 * blobfs::kChunkSize;
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<uint8_t[]> data(new (&ac) uint8_t[blob_size]);
+    ASSERT_TRUE(ac.check());
+    unsigned int seed = 0;
+    for (size_t i = 0; i < blob_size; i++) {
+        data[i] = static_cast<uint8_t>('a' + rand_r(&seed) % 4);
+    }
+
+    const size_t buf_size = blobfs::ChunkedCompressor::BufferMax(blob_size);
+    size_t sizes[2];
+    const blobfs::CompressionAlgorithm algorithms[] = {
+        blobfs::CompressionAlgorithm::kLz4,
+        blobfs::CompressionAlgorithm::kLz4Hc,
+    };
+    for (size_t i = 0; i < fbl::count_of(algorithms); i++) {
+        fbl::unique_ptr<uint8_t[]> buf(new (&ac) uint8_t[buf_size]);
+        ASSERT_TRUE(ac.check());
+        blobfs::ChunkedCompressor c;
+        ASSERT_EQ(c.Initialize(buf.get(), buf_size, blob_size, algorithms[i]), ZX_OK);
+        ASSERT_EQ(c.Update(data.get(), blob_size), ZX_OK);
+        ASSERT_EQ(c.End(), ZX_OK);
+        sizes[i] = c.Size();
+
+        blobfs::ChunkedDecompressor d;
+        ASSERT_EQ(d.Init(buf.get(), c.Size(), c.Size(), blob_size), ZX_OK);
+        fbl::unique_ptr<uint8_t[]> out(new (&ac) uint8_t[blob_size]);
+        ASSERT_TRUE(ac.check());
+        ASSERT_EQ(d.DecompressAll(buf.get(), out.get(), 1), ZX_OK);
+        ASSERT_EQ(memcmp(out.get(), data.get(), blob_size), 0);
+    }
+    ASSERT_LE(sizes[1], sizes[0]);
+    END_TEST;
+}
+
+// Ensure a seek table which points outside the compressed blob is rejected.
+static bool TestChunkedDecompressorBadSeekTable(void) {
+    BEGIN_TEST;
+    const size_t blob_size = 3 * blobfs::kChunkSize;
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<uint8_t[]> data(new (&ac) uint8_t[blob_size]);
+    ASSERT_TRUE(ac.check());
+    memset(data.get(), 'a', blob_size);
+
+    const size_t buf_size = blobfs::ChunkedCompressor::BufferMax(blob_size);
+    fbl::unique_ptr<uint8_t[]> buf(new (&ac) uint8_t[buf_size]);
+    ASSERT_TRUE(ac.check());
+    blobfs::ChunkedCompressor c;
+    ASSERT_EQ(c.Initialize(buf.get(), buf_size, blob_size), ZX_OK);
+    ASSERT_EQ(c.Update(data.get(), blob_size), ZX_OK);
+    ASSERT_EQ(c.End(), ZX_OK);
+
+    blobfs::ChunkedDecompressor d;
+    ASSERT_EQ(d.Init(buf.get(), c.Size(), c.Size(), blob_size), ZX_OK);
+    // The blob is shorter than its chunks claim.
+    ASSERT_EQ(d.Init(buf.get(), c.Size(), c.Size() - 1, blob_size), ZX_ERR_IO_DATA_INTEGRITY);
+    // The blob is a different size than the one compressed.
+    ASSERT_EQ(d.Init(buf.get(), c.Size(), c.Size(), blob_size - 1), ZX_ERR_IO_DATA_INTEGRITY);
+
+    // The second chunk overlaps the first.
+    blobfs::SeekEntry entry;
+    uint8_t* second = &buf[sizeof(blobfs::ChunkedHeader) + sizeof(blobfs::SeekEntry)];
+    memcpy(&entry, second, sizeof(entry));
+    entry.compressed_offset--;
+    memcpy(second, &entry, sizeof(entry));
+    ASSERT_EQ(d.Init(buf.get(), c.Size(), c.Size(), blob_size), ZX_ERR_IO_DATA_INTEGRITY);
+    END_TEST;
+}
+
+// Ensure free extents are merged, split and found by length.
+static bool TestExtentIndex(void) {
+    BEGIN_TEST;
+    blobfs::ExtentIndex index;
+    uint64_t start;
+    ASSERT_EQ(index.Find(1, &start), ZX_ERR_NO_SPACE);
+
+    ASSERT_EQ(index.Insert(0, 10), ZX_OK);
+    ASSERT_EQ(index.Insert(20, 4), ZX_OK);
+    ASSERT_EQ(index.Insert(30, 6), ZX_OK);
+    ASSERT_EQ(index.ExtentCount(), 3);
+    ASSERT_EQ(index.FreeBlocks(), 20);
+    ASSERT_EQ(index.LargestExtent(), 10);
+
+    // The shortest extent which fits is chosen.
+    ASSERT_EQ(index.Find(4, &start), ZX_OK);
+    ASSERT_EQ(start, 20);
+    ASSERT_EQ(index.Find(5, &start), ZX_OK);
+    ASSERT_EQ(start, 30);
+    ASSERT_EQ(index.Find(11, &start), ZX_ERR_NO_SPACE);
+
+    // Removing the middle of an extent splits it in two.
+    ASSERT_EQ(index.Remove(2, 3), ZX_OK);
+    ASSERT_EQ(index.ExtentCount(), 4);
+    ASSERT_EQ(index.LargestExtent(), 6);
+    ASSERT_EQ(index.Find(5, &start), ZX_OK);
+    ASSERT_EQ(start, 5);
+    ASSERT_EQ(index.Remove(1, 2), ZX_ERR_NOT_FOUND);
+    ASSERT_EQ(index.Remove(9, 2), ZX_ERR_NOT_FOUND);
+
+    // Returning blocks merges them with their neighbours.
+    ASSERT_EQ(index.Insert(2, 3), ZX_OK);
+    ASSERT_EQ(index.Insert(10, 10), ZX_OK);
+    ASSERT_EQ(index.ExtentCount(), 2);
+    ASSERT_EQ(index.LargestExtent(), 24);
+    ASSERT_EQ(index.Insert(24, 6), ZX_OK);
+    ASSERT_EQ(index.ExtentCount(), 1);
+    ASSERT_EQ(index.FreeBlocks(), 36);
+
+    ASSERT_EQ(index.Remove(0, 36), ZX_OK);
+    ASSERT_EQ(index.ExtentCount(), 0);
+    ASSERT_EQ(index.Find(1, &start), ZX_ERR_NO_SPACE);
+    END_TEST;
+}
+
 static bool TestCreateFailure(void) {
     BEGIN_TEST;
     BlobfsTest blobfsTest(FsTestType::kNormal);
@@ -2604,6 +2828,7 @@ RUN_TESTS(MEDIUM, TestNullBlob)
 RUN_TESTS(MEDIUM, TestCompressibleBlob)
 RUN_TESTS(MEDIUM, TestMmap)
 RUN_TESTS(MEDIUM, TestMmapUseAfterClose)
+RUN_TESTS(MEDIUM, TestReadImmutable)
 RUN_TESTS(MEDIUM, TestReaddir)
 RUN_TESTS(MEDIUM, TestDiskTooSmall)
 RUN_TEST_FVM(MEDIUM, TestQueryInfo)
@@ -2639,6 +2864,10 @@ RUN_TEST_FVM(MEDIUM, ResizePartition)
 RUN_TEST_FVM(MEDIUM, CorruptAtMount)
 RUN_TESTS(LARGE, CreateWriteReopen)
 RUN_TEST(TestCompressorBufferTooSmall)
+RUN_TEST(TestChunkedCompressorRoundTrip)
+RUN_TEST(TestChunkedCompressorHighCompression)
+RUN_TEST(TestChunkedDecompressorBadSeekTable)
+RUN_TEST(TestExtentIndex)
 RUN_TEST_MEDIUM(TestCreateFailure)
 RUN_TEST_MEDIUM(TestExtendFailure)
 RUN_TEST_LARGE(TestLargeBlob)
@@ -225,6 +225,42 @@ bool TestExchangeMultiThread() {
     END_TEST;
 }
 
+// Exposes the shards of a counter.
+class ShardedCounter : public BaseCounter {
+public:
+    Type LoadShard(size_t shard) const { return shards_[shard].value.load(kMemoryOrder); }
+};
+
+int IncrementOnceFn(void* args) {
+    static_cast<ShardedCounter*>(args)->Increment();
+    return thrd_success;
+}
+
+// Verify that threads are spread over the shards, and that reads and exchanges merge them.
+bool TestShardMerge() {
+    BEGIN_TEST;
+    ShardedCounter counter;
+
+    // Shards are handed out round robin, so this many new threads use every shard.
+    for (uint64_t i = 0; i < kThreads; ++i) {
+        thrd_t thread_id;
+        ASSERT_EQ(thrd_create(&thread_id, IncrementOnceFn, &counter), thrd_success);
+        thrd_join(thread_id, nullptr);
+    }
+    static_assert(kThreads >= kShards, "");
+    for (size_t shard = 0; shard < kShards; ++shard) {
+        EXPECT_GT(counter.LoadShard(shard), 0);
+    }
+    EXPECT_EQ(counter.Load(), kThreads);
+
+    BaseCounter moved(fbl::move(counter));
+    EXPECT_EQ(counter.Load(), 0);
+    EXPECT_EQ(moved.Load(), kThreads);
+    EXPECT_EQ(moved.Exchange(), kThreads);
+    EXPECT_EQ(moved.Load(), 0);
+    END_TEST;
+}
+
 // Verify that the metadata used to create the counter is part of the flushes observation
 // and that the current value of the counter is correct, plus resets to 0 after flush.
 bool TestFlush() {
@@ -349,6 +385,7 @@ RUN_TEST(TestExchange)
 RUN_TEST(TestExchangeByVal)
 RUN_TEST(TestIncrementMultiThread)
 RUN_TEST(TestExchangeMultiThread)
+RUN_TEST(TestShardMerge)
 END_TEST_CASE(BaseCounterTest)
 
 BEGIN_TEST_CASE(RemoteCounterTest)
@@ -8,6 +8,7 @@
 #include <zircon/syscalls.h>
 #include <zircon/syscalls/object.h>
 #include <unittest/unittest.h>
+#include <limits.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -1025,6 +1026,48 @@ static bool channel_write_different_sizes(void) {
     END_TEST;
 }
 
+static bool channel_stats(void) {
+    BEGIN_TEST;
+
+    zx_handle_t channel[2];
+    ASSERT_EQ(zx_channel_create(0, &channel[0], &channel[1]), ZX_OK, "");
+
+    zx_handle_t vmo;
+    ASSERT_EQ(zx_vmo_create(PAGE_SIZE * 4, 0, &vmo), ZX_OK, "");
+
+    char data[100] = {0};
+    ASSERT_EQ(zx_channel_write(channel[0], 0, data, sizeof(data), NULL, 0), ZX_OK, "");
+    ASSERT_EQ(zx_channel_write(channel[0], 0, data, 10, &vmo, 1), ZX_OK, "");
+
+    uint32_t actual_bytes, actual_handles;
+    ASSERT_EQ(zx_channel_read(channel[1], 0, data, NULL, sizeof(data), 0, &actual_bytes,
+                              &actual_handles), ZX_OK, "");
+
+    zx_info_channel_stats_t info;
+    ASSERT_EQ(zx_object_get_info(channel[0], ZX_INFO_CHANNEL_STATS, &info, sizeof(info),
+                                 NULL, NULL), ZX_OK, "");
+    EXPECT_EQ(info.messages_sent, 2u, "");
+    EXPECT_EQ(info.messages_received, 0u, "");
+    EXPECT_EQ(info.bytes_copied_in, 110u, "");
+    EXPECT_EQ(info.bytes_copied_out, 0u, "");
+    EXPECT_EQ(info.vmo_bytes_moved, PAGE_SIZE * 4u, "");
+
+    ASSERT_EQ(zx_object_get_info(channel[1], ZX_INFO_CHANNEL_STATS, &info, sizeof(info),
+                                 NULL, NULL), ZX_OK, "");
+    EXPECT_EQ(info.messages_sent, 0u, "");
+    EXPECT_EQ(info.messages_received, 1u, "");
+    EXPECT_EQ(info.bytes_copied_in, 0u, "");
+    EXPECT_EQ(info.bytes_copied_out, sizeof(data), "");
+    EXPECT_EQ(info.vmo_bytes_moved, 0u, "");
+
+    EXPECT_EQ(zx_object_get_info(channel[1], ZX_INFO_CHANNEL_STATS, &info, sizeof(info) - 1,
+                                 NULL, NULL), ZX_ERR_BUFFER_TOO_SMALL, "");
+
+    EXPECT_EQ(zx_handle_close(channel[0]), ZX_OK, "");
+    EXPECT_EQ(zx_handle_close(channel[1]), ZX_OK, "");
+    END_TEST;
+}
+
 BEGIN_TEST_CASE(channel_tests)
 RUN_TEST(channel_test)
 RUN_TEST(channel_read_error_test)
@@ -1042,6 +1085,7 @@ RUN_TEST(channel_nest)
 RUN_TEST(channel_disallow_write_to_self)
 RUN_TEST(channel_read_etc)
 RUN_TEST(channel_write_different_sizes)
+RUN_TEST(channel_stats)
 END_TEST_CASE(channel_tests)
 
 #ifndef BUILD_COMBINED_TESTS
@@ -0,0 +1,121 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <unittest/unittest.h>
+#include <zircon/syscalls.h>
+#include <zircon/syscalls/log.h>
+
+#define kNumRecords 32u
+
+static const char kTag[] = "debuglog-test batch";
+
+static bool debuglog_read_batch_test(void) {
+    BEGIN_TEST;
+
+    // The reader starts at the oldest record, so it sees everything
+    // written after this.
+    zx_handle_t reader;
+    ASSERT_EQ(zx_debuglog_create(ZX_HANDLE_INVALID, ZX_LOG_FLAG_READABLE, &reader), ZX_OK, "");
+    zx_handle_t writer;
+    ASSERT_EQ(zx_debuglog_create(ZX_HANDLE_INVALID, 0, &writer), ZX_OK, "");
+
+    for (unsigned i = 0; i < kNumRecords; i++) {
+        char msg[64];
+        int len = snprintf(msg, sizeof(msg), "%s %u", kTag, i);
+        ASSERT_EQ(zx_debuglog_write(writer, 0, msg, len), ZX_OK, "");
+    }
+
+    char buf[ZX_LOG_RECORD_MAX * 8] __ALIGNED(8);
+    unsigned seen = 0;
+    unsigned reads = 0;
+    for (;;) {
+        zx_status_t status = zx_debuglog_read(reader, ZX_LOG_READ_BATCH, buf, sizeof(buf));
+        if (status == ZX_ERR_SHOULD_WAIT) {
+            break;
+        }
+        ASSERT_GT(status, 0, "");
+        ASSERT_LE((size_t)status, sizeof(buf), "");
+        reads++;
+
+        size_t actual = status;
+        size_t off = 0;
+        while (off < actual) {
+            ASSERT_EQ(off % 8, 0u, "records must be 8 byte aligned");
+            zx_log_record_t* rec = (zx_log_record_t*)(buf + off);
+            ASSERT_LE(off + sizeof(*rec) + rec->datalen, actual, "record overruns the read");
+            off += ZX_LOG_RECORD_ALIGN(sizeof(*rec) + rec->datalen);
+
+            if (rec->datalen <= strlen(kTag) || memcmp(rec->data, kTag, strlen(kTag))) {
+                continue;
+            }
+            char expected[64];
+            int len = snprintf(expected, sizeof(expected), "%s %u", kTag, seen);
+            EXPECT_EQ((size_t)len, rec->datalen, "");
+            EXPECT_EQ(memcmp(expected, rec->data, len), 0, "records out of order");
+            seen++;
+        }
+        EXPECT_EQ(off, actual, "");
+    }
+    EXPECT_EQ(seen, kNumRecords, "");
+    // Many records came back per read.
+    EXPECT_LT(reads, kNumRecords, "");
+
+    ASSERT_EQ(zx_handle_close(writer), ZX_OK, "");
+    ASSERT_EQ(zx_handle_close(reader), ZX_OK, "");
+
+    END_TEST;
+}
+
+static bool debuglog_read_single_test(void) {
+    BEGIN_TEST;
+
+    zx_handle_t log;
+    ASSERT_EQ(zx_debuglog_create(ZX_HANDLE_INVALID, ZX_LOG_FLAG_READABLE, &log), ZX_OK, "");
+    ASSERT_EQ(zx_debuglog_write(log, 0, kTag, strlen(kTag)), ZX_OK, "");
+
+    // Without the batch option a read returns one record.
+    char buf[ZX_LOG_RECORD_MAX * 4] __ALIGNED(8);
+    zx_status_t status = zx_debuglog_read(log, 0, buf, sizeof(buf));
+    ASSERT_GT(status, 0, "");
+    zx_log_record_t* rec = (zx_log_record_t*)buf;
+    EXPECT_EQ((size_t)status, sizeof(*rec) + rec->datalen, "");
+
+    ASSERT_EQ(zx_handle_close(log), ZX_OK, "");
+
+    END_TEST;
+}
+
+static bool debuglog_read_bad_args_test(void) {
+    BEGIN_TEST;
+
+    zx_handle_t log;
+    ASSERT_EQ(zx_debuglog_create(ZX_HANDLE_INVALID, ZX_LOG_FLAG_READABLE, &log), ZX_OK, "");
+    ASSERT_EQ(zx_debuglog_write(log, 0, kTag, strlen(kTag)), ZX_OK, "");
+
+    char buf[ZX_LOG_RECORD_MAX] __ALIGNED(8);
+    EXPECT_EQ(zx_debuglog_read(log, ~ZX_LOG_READ_BATCH, buf, sizeof(buf)),
+              ZX_ERR_INVALID_ARGS, "");
+    // A batch must have room for the largest record.
+    EXPECT_EQ(zx_debuglog_read(log, ZX_LOG_READ_BATCH, buf, sizeof(buf) - 1),
+              ZX_ERR_BUFFER_TOO_SMALL, "");
+
+    ASSERT_EQ(zx_handle_close(log), ZX_OK, "");
+
+    END_TEST;
+}
+
+BEGIN_TEST_CASE(debuglog_tests)
+RUN_TEST(debuglog_read_batch_test)
+RUN_TEST(debuglog_read_single_test)
+RUN_TEST(debuglog_read_bad_args_test)
+END_TEST_CASE(debuglog_tests)
+
+#ifndef BUILD_COMBINED_TESTS
+int main(int argc, char** argv) {
+    return unittest_run_all_tests(argc, argv) ? 0 : -1;
+}
+#endif
@@ -133,11 +133,67 @@ static bool signal_peer_closed_test(void) {
     END_TEST;
 }
 
+static bool signal_many_test(void) {
+    BEGIN_TEST;
+
+    zx_handle_t a[2], b[2];
+    ASSERT_EQ(zx_eventpair_create(0, &a[0], &a[1]), ZX_OK, "");
+    ASSERT_EQ(zx_eventpair_create(0, &b[0], &b[1]), ZX_OK, "");
+
+    zx_signal_item_t items[3] = {
+        {a[0], 0u, 0u, ZX_USER_SIGNAL_0},
+        {b[0], ZX_SIGNAL_ITEM_PEER, 0u, ZX_USER_SIGNAL_1},
+        {a[0], 0u, ZX_USER_SIGNAL_0, ZX_USER_SIGNAL_2},
+    };
+    size_t actual = 0u;
+    EXPECT_EQ(zx_object_signal_many(items, 3u, &actual), ZX_OK, "");
+    EXPECT_EQ(actual, 3u, "");
+    // The items are applied in order.
+    check_signals_state(a[0], ZX_USER_SIGNAL_2);
+    check_signals_state(a[1], 0u);
+    check_signals_state(b[0], 0u);
+    check_signals_state(b[1], ZX_USER_SIGNAL_1);
+
+    // A bad handle anywhere in the batch leaves every object untouched.
+    zx_handle_t bad = a[1];
+    ASSERT_EQ(zx_handle_close(bad), ZX_OK, "");
+    zx_signal_item_t bad_items[2] = {
+        {a[0], 0u, ZX_USER_SIGNAL_2, 0u},
+        {bad, 0u, 0u, ZX_USER_SIGNAL_0},
+    };
+    EXPECT_EQ(zx_object_signal_many(bad_items, 2u, NULL), ZX_ERR_BAD_HANDLE, "");
+    check_signals_state(a[0], ZX_USER_SIGNAL_2 | ZX_EVENTPAIR_PEER_CLOSED);
+
+    // Signaling fails part way through on the closed peer.
+    zx_signal_item_t peer_items[3] = {
+        {b[0], 0u, 0u, ZX_USER_SIGNAL_3},
+        {a[0], ZX_SIGNAL_ITEM_PEER, 0u, ZX_USER_SIGNAL_0},
+        {b[0], 0u, ZX_USER_SIGNAL_3, 0u},
+    };
+    actual = 0u;
+    EXPECT_EQ(zx_object_signal_many(peer_items, 3u, &actual), ZX_ERR_PEER_CLOSED, "");
+    EXPECT_EQ(actual, 1u, "");
+    check_signals_state(b[0], ZX_USER_SIGNAL_3);
+
+    EXPECT_EQ(zx_object_signal_many(items, 1u, NULL), ZX_OK, "");
+    items[0].options = 2u;
+    EXPECT_EQ(zx_object_signal_many(items, 1u, NULL), ZX_ERR_INVALID_ARGS, "");
+    EXPECT_EQ(zx_object_signal_many(items, ZX_SIGNAL_MANY_MAX_ITEMS + 1, NULL),
+              ZX_ERR_OUT_OF_RANGE, "");
+
+    EXPECT_EQ(zx_handle_close(a[0]), ZX_OK, "");
+    EXPECT_EQ(zx_handle_close(b[0]), ZX_OK, "");
+    EXPECT_EQ(zx_handle_close(b[1]), ZX_OK, "");
+
+    END_TEST;
+}
+
 BEGIN_TEST_CASE(eventpair_tests)
 RUN_TEST(create_test)
 RUN_TEST(signal_test)
 RUN_TEST(signal_peer_test)
 RUN_TEST(signal_peer_closed_test)
+RUN_TEST(signal_many_test)
 END_TEST_CASE(eventpair_tests)
 
 #ifndef BUILD_COMBINED_TESTS
@@ -161,10 +161,72 @@ static bool options_test(void) {
     END_TEST;
 }
 
+static bool threshold_test(void) {
+    BEGIN_TEST;
+
+    zx_handle_t a, b;
+    uint64_t n[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    enum { ELEM_SZ = sizeof(n[0]) };
+    size_t actual;
+    size_t value;
+
+    ASSERT_EQ(zx_fifo_create(8, ELEM_SZ, 0, &a, &b), ZX_OK, "");
+
+    // Thresholds above the element count are rejected.
+    value = 9;
+    EXPECT_EQ(zx_object_set_property(b, ZX_PROP_FIFO_RX_THRESHOLD, &value, sizeof(value)),
+              ZX_ERR_INVALID_ARGS, "");
+    EXPECT_EQ(zx_object_set_property(a, ZX_PROP_FIFO_TX_THRESHOLD, &value, sizeof(value)),
+              ZX_ERR_INVALID_ARGS, "");
+
+    value = 4;
+    EXPECT_EQ(zx_object_set_property(b, ZX_PROP_FIFO_RX_THRESHOLD, &value, sizeof(value)),
+              ZX_OK, "");
+    value = 6;
+    EXPECT_EQ(zx_object_set_property(a, ZX_PROP_FIFO_TX_THRESHOLD, &value, sizeof(value)),
+              ZX_OK, "");
+    value = 0;
+    EXPECT_EQ(zx_object_get_property(b, ZX_PROP_FIFO_RX_THRESHOLD, &value, sizeof(value)),
+              ZX_OK, "");
+    EXPECT_EQ(value, 4u, "");
+    EXPECT_SIGNALS(a, ZX_FIFO_WRITABLE | ZX_FIFO_WRITE_THRESHOLD);
+    EXPECT_SIGNALS(b, ZX_FIFO_WRITABLE);
+
+    // Readable, but still under the read threshold.
+    EXPECT_EQ(zx_fifo_write(a, ELEM_SZ, n, 3, &actual), ZX_OK, "");
+    EXPECT_EQ(actual, 3u, "");
+    EXPECT_SIGNALS(a, ZX_FIFO_WRITABLE);
+    EXPECT_SIGNALS(b, ZX_FIFO_WRITABLE | ZX_FIFO_READABLE);
+
+    EXPECT_EQ(zx_fifo_write(a, ELEM_SZ, n, 1, &actual), ZX_OK, "");
+    EXPECT_SIGNALS(b, ZX_FIFO_WRITABLE | ZX_FIFO_READABLE | ZX_FIFO_READ_THRESHOLD);
+
+    // Draining below both thresholds flips them back.
+    EXPECT_EQ(zx_fifo_read(b, ELEM_SZ, n, 2, &actual), ZX_OK, "");
+    EXPECT_EQ(actual, 2u, "");
+    EXPECT_SIGNALS(a, ZX_FIFO_WRITABLE | ZX_FIFO_WRITE_THRESHOLD);
+    EXPECT_SIGNALS(b, ZX_FIFO_WRITABLE | ZX_FIFO_READABLE);
+
+    // Zero disables the signal.
+    value = 0;
+    EXPECT_EQ(zx_object_set_property(a, ZX_PROP_FIFO_TX_THRESHOLD, &value, sizeof(value)),
+              ZX_OK, "");
+    EXPECT_SIGNALS(a, ZX_FIFO_WRITABLE);
+
+    zx_handle_close(b);
+    value = 1;
+    EXPECT_EQ(zx_object_set_property(a, ZX_PROP_FIFO_TX_THRESHOLD, &value, sizeof(value)),
+              ZX_ERR_PEER_CLOSED, "");
+    zx_handle_close(a);
+
+    END_TEST;
+}
+
 BEGIN_TEST_CASE(fifo_tests)
 RUN_TEST(basic_test)
 RUN_TEST(peer_closed_test)
 RUN_TEST(options_test)
+RUN_TEST(threshold_test)
 END_TEST_CASE(fifo_tests)
 
 #ifndef BUILD_COMBINED_TESTS
@@ -539,6 +539,62 @@ static bool TestEventSignaling() {
     END_TEST;
 }
 
+static bool TestFutexWaitPiBadOwner() {
+    BEGIN_TEST;
+    int32_t futex_value = 123;
+    zx_handle_t self = thrd_get_zx_handle(thrd_current());
+
+    zx_status_t rc = zx_futex_wait_pi(&futex_value, futex_value, self, ZX_TIME_INFINITE);
+    EXPECT_EQ(rc, ZX_ERR_INVALID_ARGS, "waiting on ourselves should fail");
+
+    rc = zx_futex_wait_pi(&futex_value, futex_value, ZX_HANDLE_INVALID, ZX_TIME_INFINITE);
+    EXPECT_EQ(rc, ZX_ERR_BAD_HANDLE, "the owner should be checked");
+
+    zx_handle_t event;
+    ASSERT_EQ(zx_event_create(0, &event), ZX_OK, "");
+    rc = zx_futex_wait_pi(&futex_value, futex_value, event, ZX_TIME_INFINITE);
+    EXPECT_EQ(rc, ZX_ERR_WRONG_TYPE, "the owner should be a thread");
+    EXPECT_EQ(zx_handle_close(event), ZX_OK, "");
+
+    zx_handle_t weak;
+    ASSERT_EQ(zx_handle_duplicate(self, ZX_RIGHTS_BASIC, &weak), ZX_OK, "");
+    rc = zx_futex_wait_pi(&futex_value, futex_value, weak, ZX_TIME_INFINITE);
+    EXPECT_EQ(rc, ZX_ERR_ACCESS_DENIED, "the owner handle should be able to manage the thread");
+    EXPECT_EQ(zx_handle_close(weak), ZX_OK, "");
+    END_TEST;
+}
+
+struct PiWaiterArgs {
+    volatile int32_t futex;
+    zx_handle_t owner;
+    zx_status_t status;
+};
+
+static int pi_waiter_thread(void* arg) {
+    auto args = static_cast<PiWaiterArgs*>(arg);
+    args->status = zx_futex_wait_pi(const_cast<int32_t*>(&args->futex), args->futex,
+                                    args->owner, ZX_TIME_INFINITE);
+    return 0;
+}
+
+// Check that priority-inheriting waiters are woken like plain ones.
+static bool TestFutexWaitPiWakeup() {
+    BEGIN_TEST;
+    PiWaiterArgs args = {};
+    args.owner = thrd_get_zx_handle(thrd_current());
+    args.status = ZX_ERR_INTERNAL;
+
+    thrd_t thread;
+    ASSERT_EQ(thrd_create_with_name(&thread, pi_waiter_thread, &args, "pi waiter"),
+              thrd_success, "");
+    ASSERT_TRUE(wait_until_blocked_on_some_futex(thrd_get_zx_handle(thread)));
+
+    ASSERT_EQ(zx_futex_wake(const_cast<int32_t*>(&args.futex), 1), ZX_OK, "");
+    ASSERT_EQ(thrd_join(thread, NULL), thrd_success, "");
+    EXPECT_EQ(args.status, ZX_OK, "the waiter should have been woken");
+    END_TEST;
+}
+
 BEGIN_TEST_CASE(futex_tests)
 RUN_TEST(TestFutexWaitValueMismatch);
 RUN_TEST(TestFutexWaitTimeout);
@@ -558,6 +614,8 @@ RUN_TEST(TestFutexThreadKilled);
 RUN_TEST(TestFutexThreadSuspended);
 RUN_TEST(TestFutexMisaligned);
 RUN_TEST(TestEventSignaling);
+RUN_TEST(TestFutexWaitPiBadOwner);
+RUN_TEST(TestFutexWaitPiWakeup);
 END_TEST_CASE(futex_tests)
 
 #ifndef BUILD_COMBINED_TESTS
@@ -115,6 +115,44 @@ static bool interrupt_port_bound_test(void) {
     END_TEST;
 }
 
+// Tests Interrupts bound to a port in polling mode
+static bool interrupt_port_bound_poll_test(void) {
+    BEGIN_TEST;
+
+    zx_handle_t vinth;
+    zx_handle_t port_handle_bind;
+    zx_time_t signaled_timestamp_1 = 12345;
+    zx_time_t signaled_timestamp_2 = 67890;
+    uint32_t key = 789;
+    zx_port_packet_t out;
+    zx_handle_t rsrc = get_root_resource();
+
+    ASSERT_EQ(zx_interrupt_create(rsrc, 0, ZX_INTERRUPT_VIRTUAL, &vinth), ZX_OK, "");
+    ASSERT_EQ(zx_port_create(1, &port_handle_bind), ZX_OK, "");
+
+    ASSERT_EQ(zx_interrupt_bind(vinth, port_handle_bind, key, ~ZX_INTERRUPT_BIND_POLL),
+              ZX_ERR_INVALID_ARGS, "");
+    ASSERT_EQ(zx_interrupt_bind(vinth, port_handle_bind, key, ZX_INTERRUPT_BIND_POLL),
+              ZX_OK, "");
+
+    // Interrupts taken while polling are delivered once the interrupt is re-armed
+    ASSERT_EQ(zx_interrupt_trigger(vinth, 0, signaled_timestamp_1), ZX_OK, "");
+    ASSERT_EQ(zx_port_wait(port_handle_bind, ZX_TIME_INFINITE, &out), ZX_OK, "");
+    ASSERT_EQ(out.interrupt.timestamp, signaled_timestamp_1, "");
+    ASSERT_EQ(out.key, key, "");
+    ASSERT_EQ(zx_interrupt_trigger(vinth, 0, signaled_timestamp_2), ZX_OK, "");
+    ASSERT_EQ(zx_port_wait(port_handle_bind, 0, &out), ZX_ERR_TIMED_OUT, "");
+    ASSERT_EQ(zx_interrupt_ack(vinth), ZX_OK, "");
+    ASSERT_EQ(zx_port_wait(port_handle_bind, ZX_TIME_INFINITE, &out), ZX_OK, "");
+    ASSERT_EQ(out.interrupt.timestamp, signaled_timestamp_2, "");
+    ASSERT_EQ(zx_interrupt_ack(vinth), ZX_OK, "");
+
+    ASSERT_EQ(zx_handle_close(vinth), ZX_OK, "");
+    ASSERT_EQ(zx_handle_close(port_handle_bind), ZX_OK, "");
+
+    END_TEST;
+}
+
 // Tests support for virtual interrupts
 static bool interrupt_test(void) {
     BEGIN_TEST;
@@ -189,9 +227,33 @@ static bool interrupt_suspend_test(void) {
     END_TEST;
 }
 
+// Tests steering interrupts which cannot be steered
+static bool interrupt_set_affinity_test(void) {
+    BEGIN_TEST;
+
+    zx_handle_t vinth;
+    zx_handle_t rsrc = get_root_resource();
+    uint32_t num_cpus = zx_system_get_num_cpus();
+    ASSERT_EQ(zx_interrupt_create(rsrc, 0, ZX_INTERRUPT_VIRTUAL, &vinth), ZX_OK, "");
+
+    ASSERT_EQ(zx_interrupt_set_affinity(vinth, 1, 0), ZX_ERR_INVALID_ARGS, "");
+    ASSERT_EQ(zx_interrupt_set_affinity(vinth, 0, num_cpus), ZX_ERR_OUT_OF_RANGE, "");
+    // Virtual interrupts aren't taken by any CPU
+    ASSERT_EQ(zx_interrupt_set_affinity(vinth, 0, num_cpus - 1), ZX_ERR_NOT_SUPPORTED, "");
+
+    ASSERT_EQ(zx_interrupt_destroy(vinth), ZX_OK, "");
+    ASSERT_EQ(zx_interrupt_set_affinity(vinth, 0, 0), ZX_ERR_CANCELED, "");
+
+    ASSERT_EQ(zx_handle_close(vinth), ZX_OK, "");
+
+    END_TEST;
+}
+
 BEGIN_TEST_CASE(interrupt_tests)
 RUN_TEST(interrupt_test)
 RUN_TEST(interrupt_port_bound_test)
+RUN_TEST(interrupt_port_bound_poll_test)
 RUN_TEST(interrupt_port_non_bindable_test)
 RUN_TEST(interrupt_suspend_test)
+RUN_TEST(interrupt_set_affinity_test)
 END_TEST_CASE(interrupt_tests)
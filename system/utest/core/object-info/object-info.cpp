@@ -14,8 +14,14 @@
 #include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <fbl/algorithm.h>
+#include <fbl/unique_ptr.h>
+
+__BEGIN_CDECLS;
+extern zx_handle_t get_root_resource(void);
+__END_CDECLS;
 
 #define LOCAL_TRACE 0
 #define LTRACEF(str, x...)                                  \
@@ -90,6 +96,46 @@ bool task_stats_smoke() {
     END_TEST;
 }
 
+// Tests that ZX_INFO_TASK_SCHED_STATS counts our own scheduling and that
+// processes and jobs report at least as much as the threads they contain.
+bool task_sched_stats_smoke() {
+    BEGIN_TEST;
+    for (int i = 0; i < 10; i++) {
+        zx_nanosleep(zx_deadline_after(ZX_USEC(100)));
+    }
+
+    zx_info_task_sched_stats_t thread_info;
+    ASSERT_EQ(zx_object_get_info(zx_thread_self(), ZX_INFO_TASK_SCHED_STATS,
+                                 &thread_info, sizeof(thread_info), nullptr, nullptr),
+              ZX_OK);
+    ASSERT_GT(thread_info.total_runtime, 0);
+    ASSERT_GT(thread_info.context_switches, 0u);
+    ASSERT_GE(thread_info.total_run_queue_wait, thread_info.max_run_queue_wait);
+
+    uint64_t waits = 0;
+    for (size_t i = 0; i < ZX_INFO_RUN_QUEUE_WAIT_BUCKETS; i++) {
+        waits += thread_info.run_queue_wait_histogram[i];
+    }
+    ASSERT_LE(waits, thread_info.context_switches);
+
+    zx_info_task_sched_stats_t process_info;
+    ASSERT_EQ(zx_object_get_info(zx_process_self(), ZX_INFO_TASK_SCHED_STATS,
+                                 &process_info, sizeof(process_info), nullptr, nullptr),
+              ZX_OK);
+    ASSERT_GE(process_info.total_runtime, thread_info.total_runtime);
+    ASSERT_GE(process_info.context_switches, thread_info.context_switches);
+    ASSERT_GE(process_info.max_run_queue_wait, thread_info.max_run_queue_wait);
+
+    zx_info_task_sched_stats_t job_info;
+    ASSERT_EQ(zx_object_get_info(zx_job_default(), ZX_INFO_TASK_SCHED_STATS,
+                                 &job_info, sizeof(job_info), nullptr, nullptr),
+              ZX_OK);
+    ASSERT_GE(job_info.total_runtime, process_info.total_runtime);
+    ASSERT_GE(job_info.context_switches, process_info.context_switches);
+    ASSERT_GE(job_info.preemptions, process_info.preemptions);
+    END_TEST;
+}
+
 // Structs to keep track of VMARs/mappings in the test child process.
 struct TestMapping {
     uintptr_t base;
@@ -794,6 +840,137 @@ bool process_vmos_smoke() {
     END_TEST;
 }
 
+// zx_object_get_info_paged() tests
+
+// Reads all of the |topic| records of |process| into |entries|, |page| records
+// per call to zx_object_get_info_paged().
+template <typename EntryType>
+bool read_paged(zx_handle_t process, uint32_t topic, size_t page,
+                EntryType* entries, size_t max, size_t* count) {
+    BEGIN_HELPER;
+    *count = 0;
+    uint64_t cursor = ZX_INFO_CURSOR_START;
+    while (cursor != ZX_INFO_CURSOR_END) {
+        const size_t n = fbl::min(page, max - *count);
+        ASSERT_GT(n, 0u, "ran out of room");
+        size_t actual;
+        uint64_t next;
+        ASSERT_EQ(zx_object_get_info_paged(process, topic, cursor,
+                                           entries + *count, n * sizeof(EntryType),
+                                           &actual, &next),
+                  ZX_OK);
+        EXPECT_LE(actual, n);
+        if (next != ZX_INFO_CURSOR_END) {
+            // A page is only short at the end.
+            ASSERT_EQ(actual, n);
+            ASSERT_NE(next, cursor, "no progress");
+        }
+        *count += actual;
+        cursor = next;
+    }
+    END_HELPER;
+}
+
+// Tests that paging through ZX_INFO_PROCESS_MAPS returns the same entries as
+// reading them all at once.
+bool process_maps_paged_matches() {
+    BEGIN_TEST;
+    const TestMappingInfo* test_info;
+    const zx_handle_t process = get_test_process_etc(&test_info);
+    ASSERT_NONNULL(test_info, "get_test_process_etc");
+
+    const size_t max = test_info->num_mappings * 4;
+    fbl::unique_ptr<zx_info_maps_t[]> maps(new zx_info_maps_t[max]);
+    size_t actual;
+    size_t avail;
+    ASSERT_EQ(zx_object_get_info(process, ZX_INFO_PROCESS_MAPS,
+                                 maps.get(), max * sizeof(zx_info_maps_t),
+                                 &actual, &avail),
+              ZX_OK);
+    ASSERT_EQ(actual, avail);
+
+    // One entry at a time resumes the walk at every node, including the
+    // aspace and root VMAR, which share a base.
+    for (size_t page = 1; page <= 3; page++) {
+        fbl::unique_ptr<zx_info_maps_t[]> paged(new zx_info_maps_t[max]);
+        size_t count;
+        ASSERT_TRUE(read_paged(process, ZX_INFO_PROCESS_MAPS, page,
+                               paged.get(), max, &count));
+        // mini-process won't have changed its mappings since the first read.
+        ASSERT_EQ(actual, count);
+        for (size_t i = 0; i < count; i++) {
+            char msg[64];
+            snprintf(msg, sizeof(msg), "page %zu entry %zu", page, i);
+            EXPECT_EQ(maps[i].type, paged[i].type, msg);
+            EXPECT_EQ(maps[i].base, paged[i].base, msg);
+            EXPECT_EQ(maps[i].size, paged[i].size, msg);
+            EXPECT_EQ(maps[i].depth, paged[i].depth, msg);
+        }
+    }
+    END_TEST;
+}
+
+// Tests that paging through ZX_INFO_PROCESS_VMOS returns the same VMOs as
+// reading them all at once.
+bool process_vmos_paged_matches() {
+    BEGIN_TEST;
+    const TestMappingInfo* test_info;
+    const zx_handle_t process = get_test_process_etc(&test_info);
+    ASSERT_NONNULL(test_info, "get_test_process_etc");
+
+    const size_t max = test_info->num_mappings + 1 + 8;
+    fbl::unique_ptr<zx_info_vmo_t[]> vmos(new zx_info_vmo_t[max]);
+    size_t actual;
+    size_t avail;
+    ASSERT_EQ(zx_object_get_info(process, ZX_INFO_PROCESS_VMOS,
+                                 vmos.get(), max * sizeof(zx_info_vmo_t),
+                                 &actual, &avail),
+              ZX_OK);
+    ASSERT_EQ(actual, avail);
+
+    fbl::unique_ptr<zx_info_vmo_t[]> paged(new zx_info_vmo_t[max]);
+    size_t count;
+    ASSERT_TRUE(read_paged(process, ZX_INFO_PROCESS_VMOS, 2,
+                           paged.get(), max, &count));
+    ASSERT_EQ(actual, count);
+    for (size_t i = 0; i < count; i++) {
+        char msg[64];
+        snprintf(msg, sizeof(msg), "entry %zu", i);
+        EXPECT_EQ(vmos[i].koid, paged[i].koid, msg);
+        EXPECT_EQ(vmos[i].flags, paged[i].flags, msg);
+    }
+    END_TEST;
+}
+
+// Tests that a process may page through its own maps, which
+// zx_object_get_info() refuses.
+bool process_maps_paged_self_succeeds() {
+    BEGIN_TEST;
+    zx_info_maps_t maps[4];
+    size_t actual;
+    uint64_t next;
+    ASSERT_EQ(zx_object_get_info_paged(zx_process_self(), ZX_INFO_PROCESS_MAPS,
+                                       ZX_INFO_CURSOR_START, maps, sizeof(maps),
+                                       &actual, &next),
+              ZX_OK);
+    ASSERT_EQ(actual, fbl::count_of(maps));
+    EXPECT_NE(next, ZX_INFO_CURSOR_END);
+    EXPECT_EQ(maps[0].type, (uint32_t)ZX_INFO_MAPS_TYPE_ASPACE);
+    EXPECT_EQ(maps[1].type, (uint32_t)ZX_INFO_MAPS_TYPE_VMAR);
+    END_TEST;
+}
+
+// Tests that zx_object_get_info_paged() only takes the topics it can page.
+bool paged_unsupported_topic_fails() {
+    BEGIN_TEST;
+    zx_info_handle_basic_t info;
+    EXPECT_EQ(zx_object_get_info_paged(zx_process_self(), ZX_INFO_HANDLE_BASIC,
+                                       ZX_INFO_CURSOR_START, &info, sizeof(info),
+                                       nullptr, nullptr),
+              ZX_ERR_NOT_SUPPORTED);
+    END_TEST;
+}
+
 // ZX_INFO_JOB_PROCESS/ZX_INFO_JOB_CHILDREN tests
 
 // Returns a job with the structure:
@@ -957,6 +1134,50 @@ bool handle_stats_control() {
     return true;
 }
 
+const zx_info_kmem_object_cache_t* find_cache(const zx_info_kmem_object_cache_t* caches,
+                                              size_t count, const char* name) {
+    for (size_t i = 0; i < count; i++) {
+        if (!strcmp(caches[i].name, name)) {
+            return &caches[i];
+        }
+    }
+    return nullptr;
+}
+
+bool object_caches_smoke() {
+    BEGIN_TEST;
+    constexpr size_t kChannels = 64;
+    zx_handle_t channels[kChannels * 2];
+    for (size_t i = 0; i < kChannels; i++) {
+        ASSERT_EQ(zx_channel_create(0, &channels[i * 2], &channels[i * 2 + 1]), ZX_OK);
+    }
+
+    zx_info_kmem_object_cache_t caches[8];
+    size_t actual;
+    size_t avail;
+    ASSERT_EQ(zx_object_get_info(get_root_resource(), ZX_INFO_KMEM_OBJECT_CACHES,
+                                 caches, sizeof(caches), &actual, &avail),
+              ZX_OK);
+    EXPECT_EQ(actual, avail);
+
+    // only channels and events are cached for now
+    EXPECT_NONNULL(find_cache(caches, actual, "event"));
+    const zx_info_kmem_object_cache_t* channel = find_cache(caches, actual, "channel");
+    ASSERT_NONNULL(channel);
+    EXPECT_GT(channel->object_size, 0u);
+    EXPECT_GE(channel->slab_size, channel->object_size);
+    EXPECT_LE(channel->slab_count, channel->max_slab_count);
+    // other processes may be creating channels too, but the ones held here
+    // are live throughout
+    EXPECT_GE(channel->live_objects, kChannels * 2);
+    EXPECT_GE(channel->slab_count * channel->slab_size, kChannels * 2 * channel->object_size);
+
+    for (zx_handle_t h : channels) {
+        zx_handle_close(h);
+    }
+    END_TEST;
+}
+
 } // namespace
 
 // Tests that should pass for any topic. Use the wrappers below instead of
@@ -1013,6 +1234,11 @@ RUN_TEST((wrong_handle_type_fails<ZX_INFO_PROCESS_VMOS, zx_info_vmo_t, zx_thread
 RUN_TEST((missing_rights_fails<ZX_INFO_PROCESS_VMOS, zx_info_vmo_t, get_test_process,
                                ZX_RIGHT_INSPECT>));
 
+RUN_TEST(process_maps_paged_matches);
+RUN_TEST(process_vmos_paged_matches);
+RUN_TEST(process_maps_paged_self_succeeds);
+RUN_TEST(paged_unsupported_topic_fails);
+
 RUN_TEST(job_processes_smoke);
 RUN_MULTI_ENTRY_TESTS(ZX_INFO_JOB_PROCESSES, zx_koid_t, get_test_job);
 RUN_TEST((wrong_handle_type_fails<ZX_INFO_JOB_PROCESSES, zx_koid_t, get_test_process>));
@@ -1053,6 +1279,13 @@ RUN_SINGLE_ENTRY_TESTS(ZX_INFO_THREAD_STATS, zx_info_thread_stats_t, zx_thread_s
 RUN_TEST((wrong_handle_type_fails<ZX_INFO_THREAD_STATS, zx_info_thread_t, get_test_job>));
 RUN_TEST((wrong_handle_type_fails<ZX_INFO_THREAD_STATS, zx_info_thread_t, get_test_process>));
 
+RUN_TEST(task_sched_stats_smoke);
+RUN_SINGLE_ENTRY_TESTS(ZX_INFO_TASK_SCHED_STATS, zx_info_task_sched_stats_t, zx_thread_self);
+RUN_SINGLE_ENTRY_TESTS(ZX_INFO_TASK_SCHED_STATS, zx_info_task_sched_stats_t, get_test_process);
+RUN_SINGLE_ENTRY_TESTS(ZX_INFO_TASK_SCHED_STATS, zx_info_task_sched_stats_t, get_test_job);
+RUN_TEST((wrong_handle_type_fails<ZX_INFO_TASK_SCHED_STATS, zx_info_task_sched_stats_t,
+                                  zx_vmar_root_self>));
+
 // ZX_INFO_PROCESS_THREADS tests.
 // TODO(dbort): Use RUN_MULTI_ENTRY_TESTS instead. |short_buffer_succeeds| and
 // |partially_unmapped_buffer_fails| currently fail because those tests expect
@@ -1071,7 +1304,14 @@ RUN_TEST((invalid_handle_fails<ZX_INFO_THREAD_EXCEPTION_REPORT, zx_exception_rep
 
 // TODO(dbort): Test resource topics
 // RUN_MULTI_ENTRY_TESTS(ZX_INFO_CPU_STATS, zx_info_cpu_stats_t, get_root_resource);
+// RUN_MULTI_ENTRY_TESTS(ZX_INFO_CPU_SCHED_STATS, zx_info_cpu_sched_stats_t, get_root_resource);
 // RUN_SINGLE_ENTRY_TESTS(ZX_INFO_KMEM_STATS, zx_info_kmem_stats_t, get_root_resource);
+// RUN_MULTI_ENTRY_TESTS(ZX_INFO_KMEM_NUMA_STATS, zx_info_kmem_numa_node_t, get_root_resource);
+RUN_TEST(object_caches_smoke);
+RUN_TEST((invalid_handle_fails<ZX_INFO_KMEM_OBJECT_CACHES, zx_info_kmem_object_cache_t>));
+RUN_TEST((wrong_handle_type_fails<ZX_INFO_KMEM_OBJECT_CACHES, zx_info_kmem_object_cache_t,
+                                  get_test_process>));
+// RUN_MULTI_ENTRY_TESTS(ZX_INFO_SYSCALL_STATS, zx_info_syscall_stats_t, get_root_resource);
 
 RUN_TEST(handle_count_valid);
 
@@ -0,0 +1,295 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string.h>
+#include <threads.h>
+
+#include <lib/zx/pager.h>
+#include <lib/zx/port.h>
+#include <lib/zx/vmar.h>
+#include <lib/zx/vmo.h>
+#include <zircon/rights.h>
+#include <zircon/syscalls.h>
+#include <zircon/syscalls/port.h>
+
+#include <unittest/unittest.h>
+
+namespace {
+
+constexpr uint64_t kKey = 42;
+constexpr uint64_t kVmoSize = 4 * PAGE_SIZE;
+
+// Fills each page of the aux vmo with a byte that depends on the page's
+// offset in the pager vmo, so that misplaced pages are caught.
+bool supply_range(const zx::pager& pager, const zx::vmo& vmo, uint64_t offset, uint64_t length) {
+    zx::vmo aux;
+    ASSERT_EQ(zx::vmo::create(length, 0, &aux), ZX_OK);
+
+    uint8_t buf[PAGE_SIZE];
+    for (uint64_t off = 0; off < length; off += PAGE_SIZE) {
+        memset(buf, static_cast<int>((offset + off) / PAGE_SIZE + 1), sizeof(buf));
+        ASSERT_EQ(aux.write(buf, off, sizeof(buf)), ZX_OK);
+    }
+
+    ASSERT_EQ(pager.supply_pages(vmo, offset, length, aux, 0), ZX_OK);
+
+    // the pages were moved out of the aux vmo
+    ASSERT_EQ(aux.read(buf, 0, sizeof(buf)), ZX_OK);
+    EXPECT_EQ(buf[0], 0u);
+    return true;
+}
+
+struct reader_args {
+    zx_handle_t vmo;
+    uint64_t offset;
+    uint8_t data;
+    zx_status_t status;
+};
+
+int reader(void* arg) {
+    auto args = static_cast<reader_args*>(arg);
+    args->status = zx_vmo_read(args->vmo, &args->data, args->offset, 1);
+    return 0;
+}
+
+bool create_test() {
+    BEGIN_TEST;
+
+    zx::pager pager;
+    ASSERT_EQ(zx::pager::create(0, &pager), ZX_OK);
+    zx::port port;
+    ASSERT_EQ(zx::port::create(0, &port), ZX_OK);
+
+    zx::vmo vmo;
+    EXPECT_EQ(pager.create_vmo(port, kKey, kVmoSize, 1, &vmo), ZX_ERR_INVALID_ARGS);
+    ASSERT_EQ(pager.create_vmo(port, kKey, kVmoSize, 0, &vmo), ZX_OK);
+
+    uint64_t size;
+    ASSERT_EQ(vmo.get_size(&size), ZX_OK);
+    EXPECT_EQ(size, kVmoSize);
+
+    zx::pager bad_pager;
+    EXPECT_EQ(zx::pager::create(1, &bad_pager), ZX_ERR_INVALID_ARGS);
+
+    END_TEST;
+}
+
+bool read_request_test() {
+    BEGIN_TEST;
+
+    zx::pager pager;
+    ASSERT_EQ(zx::pager::create(0, &pager), ZX_OK);
+    zx::port port;
+    ASSERT_EQ(zx::port::create(0, &port), ZX_OK);
+    zx::vmo vmo;
+    ASSERT_EQ(pager.create_vmo(port, kKey, kVmoSize, 0, &vmo), ZX_OK);
+
+    reader_args args = {vmo.get(), 2 * PAGE_SIZE + 5, 0, ZX_ERR_INTERNAL};
+    thrd_t thread;
+    ASSERT_EQ(thrd_create(&thread, reader, &args), thrd_success);
+
+    zx_port_packet_t packet;
+    ASSERT_EQ(port.wait(zx::time::infinite(), &packet), ZX_OK);
+    EXPECT_EQ(packet.key, kKey);
+    EXPECT_EQ(packet.type, ZX_PKT_TYPE_PAGE_REQUEST);
+    EXPECT_EQ(packet.page_request.command, ZX_PAGER_VMO_READ);
+    EXPECT_EQ(packet.page_request.offset, 2 * PAGE_SIZE);
+    EXPECT_GE(packet.page_request.length, PAGE_SIZE);
+    EXPECT_LE(packet.page_request.offset + packet.page_request.length, kVmoSize);
+
+    ASSERT_TRUE(supply_range(pager, vmo, packet.page_request.offset, PAGE_SIZE));
+
+    ASSERT_EQ(thrd_join(thread, nullptr), thrd_success);
+    EXPECT_EQ(args.status, ZX_OK);
+    EXPECT_EQ(args.data, 3u);
+
+    // a page that was supplied is not requested again
+    uint8_t data;
+    ASSERT_EQ(vmo.read(&data, 2 * PAGE_SIZE, 1), ZX_OK);
+    EXPECT_EQ(data, 3u);
+
+    END_TEST;
+}
+
+bool fault_request_test() {
+    BEGIN_TEST;
+
+    zx::pager pager;
+    ASSERT_EQ(zx::pager::create(0, &pager), ZX_OK);
+    zx::port port;
+    ASSERT_EQ(zx::port::create(0, &port), ZX_OK);
+    zx::vmo vmo;
+    ASSERT_EQ(pager.create_vmo(port, kKey, kVmoSize, 0, &vmo), ZX_OK);
+
+    // supplying the pages up front means faults never have to wait
+    ASSERT_TRUE(supply_range(pager, vmo, 0, kVmoSize));
+
+    uintptr_t addr;
+    ASSERT_EQ(zx::vmar::root_self()->map(0, vmo, 0, kVmoSize, ZX_VM_PERM_READ, &addr), ZX_OK);
+    auto ptr = reinterpret_cast<const volatile uint8_t*>(addr);
+    for (uint64_t off = 0; off < kVmoSize; off += PAGE_SIZE) {
+        EXPECT_EQ(ptr[off], static_cast<uint8_t>(off / PAGE_SIZE + 1));
+    }
+    ASSERT_EQ(zx::vmar::root_self()->unmap(addr, kVmoSize), ZX_OK);
+
+    zx_port_packet_t packet;
+    EXPECT_EQ(port.wait(zx::time(0), &packet), ZX_ERR_TIMED_OUT);
+
+    END_TEST;
+}
+
+// Supplying only the faulting page of a readahead range must not strand a
+// thread waiting for a later page of the range.
+bool partial_supply_test() {
+    BEGIN_TEST;
+
+    zx::pager pager;
+    ASSERT_EQ(zx::pager::create(0, &pager), ZX_OK);
+    zx::port port;
+    ASSERT_EQ(zx::port::create(0, &port), ZX_OK);
+    zx::vmo vmo;
+    ASSERT_EQ(pager.create_vmo(port, kKey, kVmoSize, 0, &vmo), ZX_OK);
+
+    reader_args first = {vmo.get(), 0, 0, ZX_ERR_INTERNAL};
+    thrd_t first_thread;
+    ASSERT_EQ(thrd_create(&first_thread, reader, &first), thrd_success);
+
+    zx_port_packet_t packet;
+    ASSERT_EQ(port.wait(zx::time::infinite(), &packet), ZX_OK);
+    EXPECT_EQ(packet.page_request.offset, 0u);
+
+    // whether this reader waits on the first request or faults after the
+    // supply below, its page gets requested on its own
+    reader_args second = {vmo.get(), PAGE_SIZE, 0, ZX_ERR_INTERNAL};
+    thrd_t second_thread;
+    ASSERT_EQ(thrd_create(&second_thread, reader, &second), thrd_success);
+
+    ASSERT_TRUE(supply_range(pager, vmo, 0, PAGE_SIZE));
+    ASSERT_EQ(thrd_join(first_thread, nullptr), thrd_success);
+    EXPECT_EQ(first.status, ZX_OK);
+    EXPECT_EQ(first.data, 1u);
+
+    ASSERT_EQ(port.wait(zx::time::infinite(), &packet), ZX_OK);
+    EXPECT_EQ(packet.page_request.command, ZX_PAGER_VMO_READ);
+    EXPECT_EQ(packet.page_request.offset, PAGE_SIZE);
+    ASSERT_TRUE(supply_range(pager, vmo, PAGE_SIZE, PAGE_SIZE));
+    ASSERT_EQ(thrd_join(second_thread, nullptr), thrd_success);
+    EXPECT_EQ(second.status, ZX_OK);
+    EXPECT_EQ(second.data, 2u);
+
+    END_TEST;
+}
+
+bool supply_errors_test() {
+    BEGIN_TEST;
+
+    zx::pager pager;
+    ASSERT_EQ(zx::pager::create(0, &pager), ZX_OK);
+    zx::port port;
+    ASSERT_EQ(zx::port::create(0, &port), ZX_OK);
+    zx::vmo vmo;
+    ASSERT_EQ(pager.create_vmo(port, kKey, kVmoSize, 0, &vmo), ZX_OK);
+    zx::vmo aux;
+    ASSERT_EQ(zx::vmo::create(kVmoSize, 0, &aux), ZX_OK);
+
+    EXPECT_EQ(pager.supply_pages(vmo, 1, PAGE_SIZE, aux, 0), ZX_ERR_INVALID_ARGS);
+    EXPECT_EQ(pager.supply_pages(vmo, 0, PAGE_SIZE, aux, 1), ZX_ERR_INVALID_ARGS);
+    EXPECT_EQ(pager.supply_pages(vmo, kVmoSize, PAGE_SIZE, aux, 0), ZX_ERR_OUT_OF_RANGE);
+
+    // only vmos created by the pager can be supplied
+    EXPECT_EQ(pager.supply_pages(aux, 0, PAGE_SIZE, aux, 0), ZX_ERR_INVALID_ARGS);
+    zx::pager other_pager;
+    ASSERT_EQ(zx::pager::create(0, &other_pager), ZX_OK);
+    EXPECT_EQ(other_pager.supply_pages(vmo, 0, PAGE_SIZE, aux, 0), ZX_ERR_INVALID_ARGS);
+
+    // the aux vmo can't be backed by a pager
+    zx::vmo vmo2;
+    ASSERT_EQ(pager.create_vmo(port, kKey, kVmoSize, 0, &vmo2), ZX_OK);
+    EXPECT_EQ(pager.supply_pages(vmo, 0, PAGE_SIZE, vmo2, 0), ZX_ERR_INVALID_ARGS);
+
+    // supplying needs write rights on both the pager and the vmo
+    zx::pager ro_pager;
+    ASSERT_EQ(pager.duplicate(ZX_DEFAULT_PAGER_RIGHTS & ~ZX_RIGHT_WRITE, &ro_pager), ZX_OK);
+    EXPECT_EQ(ro_pager.supply_pages(vmo, 0, PAGE_SIZE, aux, 0), ZX_ERR_ACCESS_DENIED);
+    zx::vmo ro_vmo;
+    ASSERT_EQ(vmo.duplicate(ZX_RIGHT_READ | ZX_RIGHT_DUPLICATE | ZX_RIGHT_TRANSFER, &ro_vmo),
+              ZX_OK);
+    EXPECT_EQ(pager.supply_pages(ro_vmo, 0, PAGE_SIZE, aux, 0), ZX_ERR_ACCESS_DENIED);
+
+    // nor have clones
+    zx::vmo clone;
+    ASSERT_EQ(aux.clone(ZX_VMO_CLONE_COPY_ON_WRITE, 0, kVmoSize, &clone), ZX_OK);
+    EXPECT_EQ(pager.supply_pages(vmo, 0, PAGE_SIZE, aux, 0), ZX_ERR_BAD_STATE);
+
+    END_TEST;
+}
+
+bool close_pager_test() {
+    BEGIN_TEST;
+
+    zx::pager pager;
+    ASSERT_EQ(zx::pager::create(0, &pager), ZX_OK);
+    zx::port port;
+    ASSERT_EQ(zx::port::create(0, &port), ZX_OK);
+    zx::vmo vmo;
+    ASSERT_EQ(pager.create_vmo(port, kKey, kVmoSize, 0, &vmo), ZX_OK);
+
+    reader_args args = {vmo.get(), 0, 0, ZX_OK};
+    thrd_t thread;
+    ASSERT_EQ(thrd_create(&thread, reader, &args), thrd_success);
+
+    zx_port_packet_t packet;
+    ASSERT_EQ(port.wait(zx::time::infinite(), &packet), ZX_OK);
+    EXPECT_EQ(packet.page_request.command, ZX_PAGER_VMO_READ);
+
+    // the reader fails once nobody is left to supply the page
+    pager.reset();
+    ASSERT_EQ(thrd_join(thread, nullptr), thrd_success);
+    EXPECT_NE(args.status, ZX_OK);
+
+    ASSERT_EQ(port.wait(zx::time::infinite(), &packet), ZX_OK);
+    EXPECT_EQ(packet.key, kKey);
+    EXPECT_EQ(packet.page_request.command, ZX_PAGER_VMO_COMPLETE);
+
+    END_TEST;
+}
+
+bool close_vmo_test() {
+    BEGIN_TEST;
+
+    zx::pager pager;
+    ASSERT_EQ(zx::pager::create(0, &pager), ZX_OK);
+    zx::port port;
+    ASSERT_EQ(zx::port::create(0, &port), ZX_OK);
+    zx::vmo vmo;
+    ASSERT_EQ(pager.create_vmo(port, kKey, kVmoSize, 0, &vmo), ZX_OK);
+
+    vmo.reset();
+
+    zx_port_packet_t packet;
+    ASSERT_EQ(port.wait(zx::time::infinite(), &packet), ZX_OK);
+    EXPECT_EQ(packet.key, kKey);
+    EXPECT_EQ(packet.type, ZX_PKT_TYPE_PAGE_REQUEST);
+    EXPECT_EQ(packet.page_request.command, ZX_PAGER_VMO_COMPLETE);
+
+    END_TEST;
+}
+
+} // namespace
+
+BEGIN_TEST_CASE(pager_tests)
+RUN_TEST(create_test)
+RUN_TEST(read_request_test)
+RUN_TEST(fault_request_test)
+RUN_TEST(partial_supply_test)
+RUN_TEST(supply_errors_test)
+RUN_TEST(close_pager_test)
+RUN_TEST(close_vmo_test)
+END_TEST_CASE(pager_tests)
+
+#ifndef BUILD_COMBINED_TESTS
+int main(int argc, char** argv) {
+    return unittest_run_all_tests(argc, argv) ? 0 : -1;
+}
+#endif
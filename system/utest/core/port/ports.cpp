@@ -77,6 +77,54 @@ static bool queue_and_close_test(void) {
     END_TEST;
 }
 
+static bool wait_many_test(void) {
+    BEGIN_TEST;
+    zx_status_t status;
+
+    zx_handle_t port;
+    status = zx_port_create(0, &port);
+    EXPECT_EQ(status, ZX_OK, "could not create port");
+
+    zx_port_packet_t out[40] = {};
+    size_t actual = 0u;
+
+    status = zx_port_wait_many(port, 0, out, 0u, &actual);
+    EXPECT_EQ(status, ZX_ERR_INVALID_ARGS);
+
+    status = zx_port_wait_many(port, zx_deadline_after(ZX_USEC(1)), out,
+                               fbl::count_of(out), &actual);
+    EXPECT_EQ(status, ZX_ERR_TIMED_OUT);
+
+    // Queue more packets than the kernel dequeues in a single batch.
+    for (uint64_t ix = 0; ix < 35u; ++ix) {
+        const zx_port_packet_t in = {ix, ZX_PKT_TYPE_USER, 0, {{}}};
+        status = zx_port_queue(port, &in);
+        EXPECT_EQ(status, ZX_OK);
+    }
+
+    status = zx_port_wait_many(port, ZX_TIME_INFINITE, out, 3u, &actual);
+    EXPECT_EQ(status, ZX_OK);
+    EXPECT_EQ(actual, 3u);
+
+    status = zx_port_wait_many(port, ZX_TIME_INFINITE, out + 3, fbl::count_of(out) - 3u,
+                               &actual);
+    EXPECT_EQ(status, ZX_OK);
+    EXPECT_EQ(actual, 32u);
+
+    for (uint64_t ix = 0; ix < 35u; ++ix) {
+        EXPECT_EQ(out[ix].key, ix);
+        EXPECT_EQ(out[ix].type, ZX_PKT_TYPE_USER);
+    }
+
+    status = zx_port_wait_many(port, 0, out, fbl::count_of(out), nullptr);
+    EXPECT_EQ(status, ZX_ERR_TIMED_OUT);
+
+    status = zx_handle_close(port);
+    EXPECT_EQ(status, ZX_OK);
+
+    END_TEST;
+}
+
 static bool queue_too_many(void) {
     BEGIN_TEST;
     zx_status_t status;
@@ -331,6 +379,62 @@ static bool async_wait_event_test_repeat(void) {
     END_TEST;
 }
 
+static bool async_wait_event_test_level(void) {
+    BEGIN_TEST;
+
+    zx_handle_t port;
+    ASSERT_EQ(zx_port_create(0, &port), ZX_OK);
+
+    zx_handle_t ev[2];
+    ASSERT_EQ(zx_event_create(0u, &ev[0]), ZX_OK);
+    ASSERT_EQ(zx_event_create(0u, &ev[1]), ZX_OK);
+
+    for (uint64_t ix = 0; ix != fbl::count_of(ev); ++ix) {
+        EXPECT_EQ(zx_object_wait_async(ev[ix], port, ix, ZX_EVENT_SIGNALED,
+                                       ZX_WAIT_ASYNC_LEVEL), ZX_OK);
+    }
+
+    zx_port_packet_t out = {};
+    EXPECT_EQ(zx_port_wait(port, 0ull, &out), ZX_ERR_TIMED_OUT);
+
+    // While the signal stays asserted, every wait reports it again.
+    EXPECT_EQ(zx_object_signal(ev[1], 0u, ZX_EVENT_SIGNALED), ZX_OK);
+    for (int ix = 0; ix != 3; ++ix) {
+        ASSERT_EQ(zx_port_wait(port, 0ull, &out), ZX_OK);
+        EXPECT_EQ(out.type, ZX_PKT_TYPE_SIGNAL_REP);
+        EXPECT_EQ(out.key, 1u);
+        EXPECT_EQ(out.signal.trigger, ZX_EVENT_SIGNALED);
+        EXPECT_EQ(out.signal.observed, ZX_EVENT_SIGNALED);
+    }
+
+    // Ready objects take turns, and each is reported once per batch.
+    EXPECT_EQ(zx_object_signal(ev[0], 0u, ZX_EVENT_SIGNALED), ZX_OK);
+    zx_port_packet_t batch[4] = {};
+    size_t actual = 0u;
+    ASSERT_EQ(zx_port_wait_many(port, 0ull, batch, fbl::count_of(batch), &actual), ZX_OK);
+    ASSERT_EQ(actual, 2u);
+    EXPECT_EQ(batch[0].key + batch[1].key, 1u);
+
+    // Once deasserted, the packet leaves the queue until the next assertion.
+    EXPECT_EQ(zx_object_signal(ev[0], ZX_EVENT_SIGNALED, 0u), ZX_OK);
+    EXPECT_EQ(zx_object_signal(ev[1], ZX_EVENT_SIGNALED, 0u), ZX_OK);
+    EXPECT_EQ(zx_port_wait(port, 0ull, &out), ZX_ERR_TIMED_OUT);
+
+    EXPECT_EQ(zx_object_signal(ev[0], 0u, ZX_EVENT_SIGNALED), ZX_OK);
+    ASSERT_EQ(zx_port_wait(port, 0ull, &out), ZX_OK);
+    EXPECT_EQ(out.key, 0u);
+
+    // Cancelling removes the queued packet and stops reporting.
+    EXPECT_EQ(zx_port_cancel(port, ev[0], 0u), ZX_OK);
+    EXPECT_EQ(zx_port_wait(port, 0ull, &out), ZX_ERR_TIMED_OUT);
+
+    EXPECT_EQ(zx_handle_close(port), ZX_OK);
+    EXPECT_EQ(zx_handle_close(ev[0]), ZX_OK);
+    EXPECT_EQ(zx_handle_close(ev[1]), ZX_OK);
+
+    END_TEST;
+}
+
 // Check that zx_object_wait_async() returns an error if it is passed an
 // invalid option.
 static bool async_wait_invalid_option() {
@@ -340,7 +444,7 @@ static bool async_wait_invalid_option() {
     zx_handle_t event;
     ASSERT_EQ(zx_event_create(0u, &event), ZX_OK);
     const uint64_t kKey = 0;
-    const uint32_t kInvalidOption = ZX_WAIT_ASYNC_REPEATING + 1;
+    const uint32_t kInvalidOption = ZX_WAIT_ASYNC_LEVEL + 1;
     EXPECT_EQ(zx_object_wait_async(event, port, kKey, ZX_EVENT_SIGNALED,
                                    kInvalidOption), ZX_ERR_INVALID_ARGS);
     ASSERT_EQ(zx_handle_close(event), ZX_OK);
@@ -591,6 +695,10 @@ static bool threads_event_repeat() {
     return threads_event(ZX_WAIT_ASYNC_REPEATING);
 }
 
+static bool threads_event_level() {
+    return threads_event(ZX_WAIT_ASYNC_LEVEL);
+}
+
 
 static constexpr uint32_t kStressCount = 20000u;
 static constexpr uint64_t kSleeps[] = { 0, 10, 2, 0, 15, 0};
@@ -680,10 +788,12 @@ static bool cancel_stress() {
 BEGIN_TEST_CASE(port_tests)
 RUN_TEST(basic_test)
 RUN_TEST(queue_and_close_test)
+RUN_TEST(wait_many_test)
 RUN_TEST(queue_too_many)
 RUN_TEST(async_wait_channel_test)
 RUN_TEST(async_wait_event_test_single)
 RUN_TEST(async_wait_event_test_repeat)
+RUN_TEST(async_wait_event_test_level)
 RUN_TEST(async_wait_invalid_option)
 RUN_TEST(async_wait_close_order_1)
 RUN_TEST(async_wait_close_order_2)
@@ -699,6 +809,7 @@ RUN_TEST(cancel_event_key_once_after)
 RUN_TEST(cancel_event_key_repeat_after)
 RUN_TEST(threads_event_once)
 RUN_TEST(threads_event_repeat)
+RUN_TEST(threads_event_level)
 RUN_TEST_LARGE(cancel_stress)
 END_TEST_CASE(port_tests)
 
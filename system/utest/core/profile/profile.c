@@ -61,7 +61,83 @@ static bool change_priority_via_profile(void) {
     END_TEST;
 }
 
+static bool make_deadline_profile_fails(void) {
+    BEGIN_TEST;
+
+    zx_handle_t rrh = get_root_resource();
+    if (rrh == ZX_HANDLE_INVALID) {
+        unittest_printf("no root resource. skipping test\n");
+    } else {
+        zx_handle_t profile;
+        zx_profile_info_t profile_info = { 0 };
+        profile_info.type = ZX_PROFILE_INFO_DEADLINE;
+
+        // capacity must fit in the deadline, and the deadline in the period.
+        profile_info.deadline.capacity = ZX_MSEC(2);
+        profile_info.deadline.relative_deadline = ZX_MSEC(1);
+        profile_info.deadline.period = ZX_MSEC(10);
+        ASSERT_EQ(zx_profile_create(rrh, &profile_info, &profile), ZX_ERR_INVALID_ARGS, "");
+
+        profile_info.deadline.capacity = ZX_MSEC(1);
+        profile_info.deadline.relative_deadline = ZX_MSEC(20);
+        ASSERT_EQ(zx_profile_create(rrh, &profile_info, &profile), ZX_ERR_INVALID_ARGS, "");
+
+        profile_info.deadline.capacity = 0;
+        profile_info.deadline.relative_deadline = ZX_MSEC(10);
+        ASSERT_EQ(zx_profile_create(rrh, &profile_info, &profile), ZX_ERR_INVALID_ARGS, "");
+    }
+
+    END_TEST;
+}
+
+static bool deadline_via_profile(void) {
+    BEGIN_TEST;
+
+    zx_handle_t rrh = get_root_resource();
+    if (rrh == ZX_HANDLE_INVALID) {
+        unittest_printf("no root resource. skipping test\n");
+    } else {
+        zx_profile_info_t profile_info = { 0 };
+        profile_info.type = ZX_PROFILE_INFO_DEADLINE;
+        profile_info.deadline.capacity = ZX_MSEC(1);
+        profile_info.deadline.relative_deadline = ZX_MSEC(5);
+        profile_info.deadline.period = ZX_MSEC(10);
+
+        zx_handle_t deadline;
+        ASSERT_EQ(zx_profile_create(rrh, &profile_info, &deadline), ZX_OK, "");
+
+        // A reservation of the whole cpu is never admitted.
+        profile_info.deadline.capacity = ZX_MSEC(10);
+        profile_info.deadline.relative_deadline = ZX_MSEC(10);
+        zx_handle_t too_big;
+        ASSERT_EQ(zx_profile_create(rrh, &profile_info, &too_big), ZX_OK, "");
+
+        profile_info.type = ZX_PROFILE_INFO_SCHEDULER;
+        profile_info.scheduler.priority = ZX_PRIORITY_DEFAULT;
+        zx_handle_t priority;
+        ASSERT_EQ(zx_profile_create(rrh, &profile_info, &priority), ZX_OK, "");
+
+        ASSERT_EQ(zx_object_set_profile(zx_thread_self(), deadline, 0), ZX_OK, "");
+        // Run through a few periods, both spinning past the budget and sleeping.
+        zx_time_t end = zx_deadline_after(ZX_MSEC(30));
+        while (zx_clock_get_monotonic() < end) {
+        }
+        zx_nanosleep(zx_deadline_after(ZX_MSEC(5)));
+
+        ASSERT_EQ(zx_object_set_profile(zx_thread_self(), too_big, 0), ZX_ERR_NO_RESOURCES, "");
+        ASSERT_EQ(zx_object_set_profile(zx_thread_self(), priority, 0), ZX_OK, "");
+
+        ASSERT_EQ(zx_handle_close(deadline), ZX_OK, "");
+        ASSERT_EQ(zx_handle_close(too_big), ZX_OK, "");
+        ASSERT_EQ(zx_handle_close(priority), ZX_OK, "");
+    }
+
+    END_TEST;
+}
+
 BEGIN_TEST_CASE(profile_tests)
 RUN_TEST(make_profile_fails)
 RUN_TEST(change_priority_via_profile)
+RUN_TEST(make_deadline_profile_fails)
+RUN_TEST(deadline_via_profile)
 END_TEST_CASE(profile_tests)
@@ -754,6 +754,85 @@ static bool socket_short_write(void) {
     END_TEST;
 }
 
+static bool socket_set_rx_buf_max(void) {
+    BEGIN_TEST;
+
+    zx_status_t status;
+
+    zx_handle_t h0, h1;
+    status = zx_socket_create(0, &h0, &h1);
+    ASSERT_EQ(status, ZX_OK, "");
+
+    size_t default_max = 0u;
+    status = zx_object_get_property(h1, ZX_PROP_SOCKET_RX_BUF_MAX, &default_max,
+                                    sizeof(default_max));
+    EXPECT_EQ(status, ZX_OK, "");
+
+    // Grow the receive buffer well past its default.
+    size_t rx_buf_max = 4 * default_max;
+    status = zx_object_set_property(h1, ZX_PROP_SOCKET_RX_BUF_MAX, &rx_buf_max,
+                                    sizeof(rx_buf_max));
+    EXPECT_EQ(status, ZX_OK, "");
+
+    size_t tx_buf_max = 0u;
+    status = zx_object_get_property(h0, ZX_PROP_SOCKET_TX_BUF_MAX, &tx_buf_max,
+                                    sizeof(tx_buf_max));
+    EXPECT_EQ(status, ZX_OK, "");
+    EXPECT_EQ(tx_buf_max, rx_buf_max, "");
+
+    // A single write can now fill the larger buffer.
+    const size_t buffer_size = rx_buf_max + 1;
+    unsigned char* buffer = malloc(buffer_size);
+    ASSERT_NONNULL(buffer, "");
+    for (size_t i = 0; i < buffer_size; i++) {
+        buffer[i] = (unsigned char)(i * 7);
+    }
+    size_t written = 0u;
+    status = zx_socket_write(h0, 0u, buffer, buffer_size, &written);
+    EXPECT_EQ(status, ZX_OK, "");
+    EXPECT_EQ(written, rx_buf_max, "");
+    EXPECT_EQ(get_satisfied_signals(h0) & ZX_SOCKET_WRITABLE, 0u, "");
+
+    // Can't shrink below what is already buffered.
+    status = zx_object_set_property(h1, ZX_PROP_SOCKET_RX_BUF_MAX, &default_max,
+                                    sizeof(default_max));
+    EXPECT_EQ(status, ZX_ERR_BAD_STATE, "");
+
+    unsigned char* readback = malloc(rx_buf_max);
+    ASSERT_NONNULL(readback, "");
+    size_t nread = 0u;
+    status = zx_socket_read(h1, 0u, readback, rx_buf_max, &nread);
+    EXPECT_EQ(status, ZX_OK, "");
+    EXPECT_EQ(nread, rx_buf_max, "");
+    EXPECT_EQ(memcmp(readback, buffer, rx_buf_max), 0, "");
+
+    // Out of range values are rejected.
+    size_t zero = 0u;
+    status = zx_object_set_property(h1, ZX_PROP_SOCKET_RX_BUF_MAX, &zero, sizeof(zero));
+    EXPECT_EQ(status, ZX_ERR_OUT_OF_RANGE, "");
+    size_t huge = SIZE_MAX;
+    status = zx_object_set_property(h1, ZX_PROP_SOCKET_RX_BUF_MAX, &huge, sizeof(huge));
+    EXPECT_EQ(status, ZX_ERR_OUT_OF_RANGE, "");
+    size_t too_big = 4 * default_max + 1;
+    status = zx_object_set_property(h1, ZX_PROP_SOCKET_RX_BUF_MAX, &too_big, sizeof(too_big));
+    EXPECT_EQ(status, ZX_ERR_OUT_OF_RANGE, "");
+
+    // Shrinking an empty socket works, and limits writes again.
+    status = zx_object_set_property(h1, ZX_PROP_SOCKET_RX_BUF_MAX, &default_max,
+                                    sizeof(default_max));
+    EXPECT_EQ(status, ZX_OK, "");
+    status = zx_socket_write(h0, 0u, buffer, buffer_size, &written);
+    EXPECT_EQ(status, ZX_OK, "");
+    EXPECT_EQ(written, default_max, "");
+
+    free(readback);
+    free(buffer);
+    zx_handle_close(h0);
+    zx_handle_close(h1);
+
+    END_TEST;
+}
+
 static bool socket_datagram(void) {
     BEGIN_TEST;
 
@@ -859,6 +938,115 @@ static bool socket_datagram_no_short_write(void) {
     END_TEST;
 }
 
+static bool socket_vectored(void) {
+    BEGIN_TEST;
+
+    zx_status_t status;
+    size_t count;
+
+    zx_handle_t h0, h1;
+    status = zx_socket_create(0, &h0, &h1);
+    ASSERT_EQ(status, ZX_OK, "");
+
+    char a[] = "abc";
+    char b[] = "defgh";
+    zx_iovec_t wr_iov[] = {
+        { a, 3u },
+        { NULL, 0u },
+        { b, 5u },
+    };
+    status = zx_socket_writev(h0, 0u, wr_iov, 3u, &count);
+    EXPECT_EQ(status, ZX_OK, "");
+    EXPECT_EQ(count, 8u, "");
+
+    // The data comes back out as one stream, split however the reader likes.
+    char c[2];
+    char d[10];
+    zx_iovec_t rd_iov[] = {
+        { c, sizeof(c) },
+        { d, sizeof(d) },
+    };
+    status = zx_socket_readv(h1, 0u, rd_iov, 2u, &count);
+    EXPECT_EQ(status, ZX_OK, "");
+    EXPECT_EQ(count, 8u, "");
+    EXPECT_EQ(memcmp(c, "ab", 2u), 0, "");
+    EXPECT_EQ(memcmp(d, "cdefgh", 6u), 0, "");
+
+    status = zx_socket_readv(h1, 0u, rd_iov, 2u, &count);
+    EXPECT_EQ(status, ZX_ERR_SHOULD_WAIT, "");
+
+    zx_iovec_t too_many[ZX_SOCKET_IOV_MAX + 1] = {};
+    status = zx_socket_writev(h0, 0u, too_many, ZX_SOCKET_IOV_MAX + 1, &count);
+    EXPECT_EQ(status, ZX_ERR_OUT_OF_RANGE, "");
+
+    zx_iovec_t bad = { NULL, 1u };
+    status = zx_socket_writev(h0, 0u, &bad, 1u, &count);
+    EXPECT_EQ(status, ZX_ERR_INVALID_ARGS, "");
+
+    status = zx_socket_writev(h0, ZX_SOCKET_CONTROL, wr_iov, 3u, &count);
+    EXPECT_EQ(status, ZX_ERR_INVALID_ARGS, "");
+
+    zx_handle_close(h1);
+
+    status = zx_socket_writev(h0, 0u, wr_iov, 3u, &count);
+    EXPECT_EQ(status, ZX_ERR_PEER_CLOSED, "");
+
+    zx_handle_close(h0);
+    END_TEST;
+}
+
+static bool socket_vectored_datagram(void) {
+    BEGIN_TEST;
+
+    zx_status_t status;
+    size_t count;
+
+    zx_handle_t h0, h1;
+    status = zx_socket_create(ZX_SOCKET_DATAGRAM, &h0, &h1);
+    ASSERT_EQ(status, ZX_OK, "");
+
+    // The buffers of one writev call form a single datagram.
+    char a[] = "packet";
+    char b[] = "1";
+    zx_iovec_t wr_iov[] = {
+        { a, 6u },
+        { b, 1u },
+    };
+    status = zx_socket_writev(h0, 0u, wr_iov, 2u, &count);
+    EXPECT_EQ(status, ZX_OK, "");
+    EXPECT_EQ(count, 7u, "");
+    status = zx_socket_write(h0, 0u, "packet2", 7u, &count);
+    EXPECT_EQ(status, ZX_OK, "");
+
+    status = zx_socket_read(h1, 0u, NULL, 0u, &count);
+    EXPECT_EQ(status, ZX_OK, "");
+    EXPECT_EQ(count, 7u, "");
+
+    // A read that is too small truncates the datagram and drops the rest.
+    char c[4];
+    char d[2];
+    zx_iovec_t rd_iov[] = {
+        { c, sizeof(c) },
+        { d, sizeof(d) },
+    };
+    status = zx_socket_readv(h1, 0u, rd_iov, 2u, &count);
+    EXPECT_EQ(status, ZX_OK, "");
+    EXPECT_EQ(count, 6u, "");
+    EXPECT_EQ(memcmp(c, "pack", 4u), 0, "");
+    EXPECT_EQ(memcmp(d, "et", 2u), 0, "");
+
+    char e[8];
+    status = zx_socket_read(h1, 0u, e, sizeof(e), &count);
+    EXPECT_EQ(status, ZX_OK, "");
+    EXPECT_EQ(count, 7u, "");
+    EXPECT_EQ(memcmp(e, "packet2", 7u), 0, "");
+
+    zx_handle_close(h0);
+    zx_handle_close(h1);
+
+    END_TEST;
+}
+
 static bool socket_control_plane_absent(void) {
     BEGIN_TEST;
 
@@ -1164,8 +1352,11 @@ RUN_TEST(socket_bytes_outstanding)
 RUN_TEST(socket_bytes_outstanding_shutdown_write)
 RUN_TEST(socket_bytes_outstanding_shutdown_read)
 RUN_TEST(socket_short_write)
+RUN_TEST(socket_set_rx_buf_max)
 RUN_TEST(socket_datagram)
 RUN_TEST(socket_datagram_no_short_write)
+RUN_TEST(socket_vectored)
+RUN_TEST(socket_vectored_datagram)
 RUN_TEST(socket_control_plane_absent)
 RUN_TEST(socket_control_plane)
 RUN_TEST(socket_control_plane_shutdown)
@@ -204,10 +204,88 @@ static bool test_timeout_elapsed(void) {
     END_TEST;
 }
 
+// Short critical sections make waiters take the adaptive spinning path
+// rather than sleeping in the kernel.
+#define NUM_CONTENDED_THREADS 4
+#define NUM_CONTENDED_ITERATIONS 20000
+
+static sync_mutex_t g_contended_mutex = SYNC_MUTEX_INIT;
+static int g_contended_counter = 0;
+
+static int contended_mutex_thread(void* arg) {
+    for (int times = 0; times < NUM_CONTENDED_ITERATIONS; times++) {
+        sync_mutex_lock(&g_contended_mutex);
+        g_contended_counter++;
+        sync_mutex_unlock(&g_contended_mutex);
+    }
+    return 0;
+}
+
+static bool test_contended_mutexes(void) TA_NO_THREAD_SAFETY_ANALYSIS {
+    BEGIN_TEST;
+    thrd_t threads[NUM_CONTENDED_THREADS];
+
+    zx_time_t start = zx_clock_get(ZX_CLOCK_MONOTONIC);
+    for (int i = 0; i < NUM_CONTENDED_THREADS; i++) {
+        ASSERT_EQ(thrd_create_with_name(&threads[i], contended_mutex_thread, NULL,
+                                        "contended"),
+                  thrd_success, "failed to create thread");
+    }
+    for (int i = 0; i < NUM_CONTENDED_THREADS; i++) {
+        ASSERT_EQ(thrd_join(threads[i], NULL), thrd_success, "failed to join");
+    }
+    zx_duration_t elapsed = zx_time_sub_time(zx_clock_get(ZX_CLOCK_MONOTONIC), start);
+    unittest_printf("%d contended lock/unlock pairs took %" PRId64 " ns\n",
+                    NUM_CONTENDED_THREADS * NUM_CONTENDED_ITERATIONS, elapsed);
+
+    EXPECT_EQ(g_contended_counter, NUM_CONTENDED_THREADS * NUM_CONTENDED_ITERATIONS,
+              "lost an update under the mutex");
+    EXPECT_EQ(sync_mutex_trylock(&g_contended_mutex), ZX_OK, "mutex should be unlocked");
+    sync_mutex_unlock(&g_contended_mutex);
+
+    END_TEST;
+}
+
+static sync_mutex_t g_pi_mutex = SYNC_MUTEX_INIT;
+static int g_pi_counter = 0;
+
+static int pi_mutex_thread(void* arg) {
+    for (int times = 0; times < 200; times++) {
+        sync_mutex_lock_pi(&g_pi_mutex);
+        int value = g_pi_counter;
+        zx_nanosleep(zx_deadline_after(ZX_USEC(1)));
+        g_pi_counter = value + 1;
+        sync_mutex_unlock_pi(&g_pi_mutex);
+    }
+    return 0;
+}
+
+static bool test_pi_mutexes(void) TA_NO_THREAD_SAFETY_ANALYSIS {
+    BEGIN_TEST;
+    thrd_t thread1, thread2, thread3;
+
+    thrd_create_with_name(&thread1, pi_mutex_thread, NULL, "thread 1");
+    thrd_create_with_name(&thread2, pi_mutex_thread, NULL, "thread 2");
+    thrd_create_with_name(&thread3, pi_mutex_thread, NULL, "thread 3");
+
+    thrd_join(thread1, NULL);
+    thrd_join(thread2, NULL);
+    thrd_join(thread3, NULL);
+
+    EXPECT_EQ(g_pi_counter, 600, "lost an update under the mutex");
+    EXPECT_EQ(sync_mutex_trylock_pi(&g_pi_mutex), ZX_OK, "mutex should be unlocked");
+    EXPECT_EQ(sync_mutex_trylock_pi(&g_pi_mutex), ZX_ERR_BAD_STATE, "mutex should be locked");
+    sync_mutex_unlock_pi(&g_pi_mutex);
+
+    END_TEST;
+}
+
 BEGIN_TEST_CASE(sync_mutex_tests)
 RUN_TEST(test_mutexes)
 RUN_TEST(test_try_mutexes)
 RUN_TEST(test_timeout_elapsed)
+RUN_TEST(test_contended_mutexes)
+RUN_TEST(test_pi_mutexes)
 END_TEST_CASE(sync_mutex_tests)
 
 #ifndef BUILD_COMBINED_TESTS
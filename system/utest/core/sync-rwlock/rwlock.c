@@ -0,0 +1,147 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <lib/sync/rwlock.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <threads.h>
+#include <unittest/unittest.h>
+#include <zircon/syscalls.h>
+#include <zircon/thread_annotations.h>
+#include <zircon/types.h>
+
+static sync_rwlock_t g_rwlock = SYNC_RWLOCK_INIT;
+
+// Only modified by writers, but always in two steps, so that readers can
+// check that they never observe a writer in progress.
+static volatile int g_first;
+static volatile int g_second;
+static atomic_int g_torn_reads;
+
+static int reader_thread(void* arg) {
+    for (int times = 0; times < 20000; times++) {
+        sync_rwlock_read_lock(&g_rwlock);
+        if (g_first != g_second) {
+            atomic_fetch_add(&g_torn_reads, 1);
+        }
+        sync_rwlock_read_unlock(&g_rwlock);
+    }
+    return 0;
+}
+
+static int writer_thread(void* arg) {
+    for (int times = 0; times < 2000; times++) {
+        sync_rwlock_write_lock(&g_rwlock);
+        g_first++;
+        zx_nanosleep(zx_deadline_after(ZX_USEC(1)));
+        g_second++;
+        sync_rwlock_write_unlock(&g_rwlock);
+    }
+    return 0;
+}
+
+static bool test_readers_and_writers(void) {
+    BEGIN_TEST;
+    thrd_t readers[4];
+    thrd_t writers[2];
+
+    for (size_t i = 0; i < countof(readers); i++) {
+        ASSERT_EQ(thrd_create_with_name(&readers[i], reader_thread, NULL, "reader"),
+                  thrd_success, "");
+    }
+    for (size_t i = 0; i < countof(writers); i++) {
+        ASSERT_EQ(thrd_create_with_name(&writers[i], writer_thread, NULL, "writer"),
+                  thrd_success, "");
+    }
+    for (size_t i = 0; i < countof(readers); i++) {
+        ASSERT_EQ(thrd_join(readers[i], NULL), thrd_success, "");
+    }
+    for (size_t i = 0; i < countof(writers); i++) {
+        ASSERT_EQ(thrd_join(writers[i], NULL), thrd_success, "");
+    }
+
+    EXPECT_EQ(atomic_load(&g_torn_reads), 0, "reader ran concurrently with a writer");
+    EXPECT_EQ(g_first, 4000, "lost an update under the write lock");
+    EXPECT_EQ(g_second, 4000, "lost an update under the write lock");
+
+    END_TEST;
+}
+
+typedef struct {
+    sync_rwlock_t rwlock;
+    atomic_int order;
+    int writer_order;
+    int reader_order;
+} preference_args;
+
+static int preference_writer(void* ctx) TA_NO_THREAD_SAFETY_ANALYSIS {
+    preference_args* args = ctx;
+    sync_rwlock_write_lock(&args->rwlock);
+    args->writer_order = atomic_fetch_add(&args->order, 1);
+    sync_rwlock_write_unlock(&args->rwlock);
+    return 0;
+}
+
+static int preference_reader(void* ctx) TA_NO_THREAD_SAFETY_ANALYSIS {
+    preference_args* args = ctx;
+    sync_rwlock_read_lock(&args->rwlock);
+    args->reader_order = atomic_fetch_add(&args->order, 1);
+    sync_rwlock_read_unlock(&args->rwlock);
+    return 0;
+}
+
+static bool test_concurrent_readers(void) {
+    BEGIN_TEST;
+
+    // The reader must get the rwlock while this thread holds it for reading.
+    preference_args args = {.rwlock = SYNC_RWLOCK_INIT};
+    sync_rwlock_read_lock(&args.rwlock);
+    thrd_t reader;
+    ASSERT_EQ(thrd_create(&reader, preference_reader, &args), thrd_success, "");
+    ASSERT_EQ(thrd_join(reader, NULL), thrd_success, "");
+    EXPECT_EQ(args.reader_order, 0, "");
+    sync_rwlock_read_unlock(&args.rwlock);
+
+    END_TEST;
+}
+
+static bool test_writer_preference(void) {
+    BEGIN_TEST;
+
+    preference_args args = {.rwlock = SYNC_RWLOCK_INIT};
+    sync_rwlock_read_lock(&args.rwlock);
+
+    // Wait for the writer to start waiting for the read lock to be released.
+    thrd_t writer;
+    ASSERT_EQ(thrd_create(&writer, preference_writer, &args), thrd_success, "");
+    while (atomic_load(&args.rwlock.writer) == 0) {
+        zx_nanosleep(zx_deadline_after(ZX_USEC(100)));
+    }
+
+    // A new reader must now queue up behind the writer.
+    thrd_t reader;
+    ASSERT_EQ(thrd_create(&reader, preference_reader, &args), thrd_success, "");
+    zx_nanosleep(zx_deadline_after(ZX_MSEC(10)));
+    EXPECT_EQ(atomic_load(&args.order), 0, "a thread got the rwlock too early");
+
+    sync_rwlock_read_unlock(&args.rwlock);
+    ASSERT_EQ(thrd_join(writer, NULL), thrd_success, "");
+    ASSERT_EQ(thrd_join(reader, NULL), thrd_success, "");
+    EXPECT_EQ(args.writer_order, 0, "the writer should get the rwlock first");
+    EXPECT_EQ(args.reader_order, 1, "the reader should get the rwlock last");
+
+    END_TEST;
+}
+
+BEGIN_TEST_CASE(sync_rwlock_tests)
+RUN_TEST(test_readers_and_writers)
+RUN_TEST(test_concurrent_readers)
+RUN_TEST(test_writer_preference)
+END_TEST_CASE(sync_rwlock_tests)
+
+#ifndef BUILD_COMBINED_TESTS
+int main(int argc, char** argv) {
+    return unittest_run_all_tests(argc, argv) ? 0 : -1;
+}
+#endif
@@ -1991,6 +1991,69 @@ bool partial_unmap_with_vmar_offset() {
     END_TEST;
 }
 
+// Returns the number of bytes committed to |vmo|, or 0 on failure.
+uint64_t committed_bytes(zx_handle_t vmo) {
+    zx_info_vmo_t info;
+    if (zx_object_get_info(vmo, ZX_INFO_VMO, &info, sizeof(info), nullptr, nullptr) != ZX_OK) {
+        return 0;
+    }
+    return info.committed_bytes;
+}
+
+bool map_commit_test() {
+    BEGIN_TEST;
+
+    constexpr size_t kVmoSize = PAGE_SIZE * 4;
+    zx_handle_t vmo;
+    ASSERT_EQ(zx_vmo_create(kVmoSize, 0, &vmo), ZX_OK);
+
+    // Committing a read-only mapping allocates nothing; the zero page backs it.
+    uintptr_t mapping_addr;
+    ASSERT_EQ(zx_vmar_map(zx_vmar_root_self(), ZX_VM_PERM_READ | ZX_VM_COMMIT,
+                          0, vmo, 0, kVmoSize, &mapping_addr),
+              ZX_OK);
+    EXPECT_EQ(committed_bytes(vmo), 0u);
+    EXPECT_EQ(reinterpret_cast<volatile uint8_t*>(mapping_addr)[kVmoSize - 1], 0u);
+    EXPECT_EQ(zx_vmar_unmap(zx_vmar_root_self(), mapping_addr, kVmoSize), ZX_OK);
+
+    // Committing a writable mapping commits every page of it, and only those,
+    // starting at the VMO offset.
+    ASSERT_EQ(zx_vmar_map(zx_vmar_root_self(), ZX_VM_PERM_READ | ZX_VM_PERM_WRITE | ZX_VM_COMMIT,
+                          0, vmo, PAGE_SIZE, kVmoSize - 2 * PAGE_SIZE, &mapping_addr),
+              ZX_OK);
+    EXPECT_EQ(committed_bytes(vmo), kVmoSize - 2 * PAGE_SIZE);
+    reinterpret_cast<volatile uint8_t*>(mapping_addr)[0] = 1;
+    uint8_t byte;
+    size_t actual;
+    EXPECT_EQ(zx_vmo_read(vmo, &byte, PAGE_SIZE, 1), ZX_OK);
+    EXPECT_EQ(byte, 1u);
+    EXPECT_EQ(committed_bytes(vmo), kVmoSize - 2 * PAGE_SIZE);
+    EXPECT_EQ(zx_vmar_unmap(zx_vmar_root_self(), mapping_addr, kVmoSize - 2 * PAGE_SIZE), ZX_OK);
+
+    // So is mapping in a range at an offset.
+    ASSERT_EQ(zx_vmar_map(zx_vmar_root_self(), ZX_VM_PERM_READ | ZX_VM_MAP_RANGE,
+                          0, vmo, PAGE_SIZE, PAGE_SIZE, &mapping_addr),
+              ZX_OK);
+    EXPECT_EQ(zx_process_read_memory(zx_process_self(), mapping_addr, &byte, 1, &actual), ZX_OK);
+    EXPECT_EQ(byte, 1u);
+    EXPECT_EQ(zx_vmar_unmap(zx_vmar_root_self(), mapping_addr, PAGE_SIZE), ZX_OK);
+
+    // A mapping which extends past the end of the VMO cannot be committed.
+    EXPECT_EQ(zx_vmar_map(zx_vmar_root_self(), ZX_VM_PERM_READ | ZX_VM_PERM_WRITE | ZX_VM_COMMIT,
+                          0, vmo, PAGE_SIZE, kVmoSize, &mapping_addr),
+              ZX_ERR_OUT_OF_RANGE);
+
+    // Nor can a commit replace existing mappings.
+    EXPECT_EQ(zx_vmar_map(zx_vmar_root_self(),
+                          ZX_VM_PERM_READ | ZX_VM_SPECIFIC_OVERWRITE | ZX_VM_COMMIT,
+                          0, vmo, 0, kVmoSize, &mapping_addr),
+              ZX_ERR_INVALID_ARGS);
+
+    EXPECT_EQ(zx_handle_close(vmo), ZX_OK);
+
+    END_TEST;
+}
+
 } // namespace
 
 BEGIN_TEST_CASE(vmar_tests)
@@ -2021,6 +2084,7 @@ RUN_TEST(unmap_large_uncommitted_test);
 RUN_TEST(partial_unmap_and_read);
 RUN_TEST(partial_unmap_and_write);
 RUN_TEST(partial_unmap_with_vmar_offset);
+RUN_TEST(map_commit_test);
 END_TEST_CASE(vmar_tests)
 
 #ifndef BUILD_COMBINED_TESTS
@@ -351,6 +351,21 @@ bool TestSP800_TC(Cipher::Algorithm cipher, const char* xkey, const char* xiv, c
     EXPECT_OK(decrypt.InitDecrypt(cipher, key, iv));
     EXPECT_OK(decrypt.Decrypt(ctext.get(), len, tmp));
     EXPECT_EQ(memcmp(tmp, ptext.get(), len), 0);
+
+    // As a random access cipher, the first data unit uses the IV unchanged.
+    uint64_t alignment = 1;
+    while (alignment < len) {
+        alignment <<= 1;
+    }
+    encrypt.Reset();
+    EXPECT_OK(encrypt.InitEncrypt(cipher, key, iv, alignment));
+    EXPECT_OK(encrypt.Encrypt(ptext.get(), 0, len, tmp));
+    EXPECT_EQ(memcmp(tmp, ctext.get(), len), 0);
+
+    decrypt.Reset();
+    EXPECT_OK(decrypt.InitDecrypt(cipher, key, iv, alignment));
+    EXPECT_OK(decrypt.Decrypt(ctext.get(), 0, len, tmp));
+    EXPECT_EQ(memcmp(tmp, ptext.get(), len), 0);
     END_TEST;
 }
 
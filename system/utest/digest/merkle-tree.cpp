@@ -626,6 +626,51 @@ bool VerifyBadLeaves(void) {
     END_TEST;
 }
 
+// Used by CreateParallelAll below.
+bool CreateParallel(size_t data_len, const char* digest) {
+    zx_status_t rc;
+    static uint8_t tree[sizeof(gTree)];
+    size_t tree_len = MerkleTree::GetTreeLength(data_len);
+    Digest actual;
+    ASSERT_OK(MerkleTree::CreateParallel(gData, data_len, tree, tree_len, &actual, 4));
+    Digest expected;
+    ASSERT_OK(expected.Parse(digest, strlen(digest)));
+    ASSERT_TRUE(actual == expected, "Incorrect root digest");
+    ASSERT_OK(MerkleTree::Create(gData, data_len, gTree, tree_len, &actual));
+    ASSERT_EQ(memcmp(tree, gTree, tree_len), 0, "Incorrect tree");
+    return true;
+}
+
+bool CreateParallelAll(void) {
+    BEGIN_TEST;
+    for (size_t i = 0; i < kNumCases; ++i) {
+        if (!CreateParallel(kCases[i].data_len, kCases[i].digest)) {
+            unittest_printf_critical(
+                "CreateParallelAll failed with data length of %zu\n",
+                kCases[i].data_len);
+        }
+    }
+    END_TEST;
+}
+
+bool VerifyParallelBadLeaves(void) {
+    BEGIN_TEST_WITH_RC;
+    size_t tree_len = MerkleTree::GetTreeLength(kUnalignedLarge);
+    Digest digest;
+    ASSERT_OK(MerkleTree::CreateParallel(gData, kUnalignedLarge, gTree, tree_len, &digest, 4));
+    ASSERT_OK(MerkleTree::VerifyParallel(gData, kUnalignedLarge, gTree, tree_len, 0,
+                                         kUnalignedLarge, digest, 4));
+    // Corrupt the last node, which is hashed by the last thread.
+    gData[kUnalignedLarge - 1] ^= 1;
+    ASSERT_OK(MerkleTree::VerifyParallel(gData, kUnalignedLarge, gTree, tree_len, 0,
+                                         kLarge, digest, 4));
+    ASSERT_ERR(ZX_ERR_IO_DATA_INTEGRITY,
+               MerkleTree::VerifyParallel(gData, kUnalignedLarge, gTree, tree_len, 0,
+                                          kUnalignedLarge, digest, 4));
+    gData[kUnalignedLarge - 1] ^= 1;
+    END_TEST;
+}
+
 bool CreateAndVerifyHugePRNGData(void) {
     BEGIN_TEST_WITH_RC;
     Digest digest;
@@ -739,5 +784,7 @@ RUN_TEST(VerifyGoodPartOfBadTree)
 RUN_TEST(VerifyBadTree)
 RUN_TEST(VerifyGoodPartOfBadLeaves)
 RUN_TEST(VerifyBadLeaves)
+RUN_TEST(CreateParallelAll)
+RUN_TEST(VerifyParallelBadLeaves)
 RUN_TEST(CreateAndVerifyHugePRNGData)
 END_TEST_CASE(MerkleTreeTests)
@@ -333,6 +333,29 @@ public:
         return call_status;
     }
 
+    zx_status_t GetQueueCount(uint32_t* count) {
+        return zircon_ethernet_DeviceGetQueueCount(svc_.get(), count);
+    }
+
+    zx_status_t GetQueueFifos(uint32_t queue, uint32_t cpu, zircon_ethernet_Fifos* fifos) {
+        zx_status_t call_status = ZX_OK;
+        zx_status_t status = zircon_ethernet_DeviceGetQueueFifos(svc_.get(), queue, cpu,
+                                                                 &call_status, fifos);
+        if (status != ZX_OK) {
+            return status;
+        }
+        return call_status;
+    }
+
+    zx_status_t SetRss(const zircon_ethernet_RssConfig& config) {
+        zx_status_t call_status = ZX_OK;
+        zx_status_t status = zircon_ethernet_DeviceSetRss(svc_.get(), &config, &call_status);
+        if (status != ZX_OK) {
+            return status;
+        }
+        return call_status;
+    }
+
     fzl::fifo<zircon_ethernet_FifoEntry>* tx_fifo() { return &tx_; }
     fzl::fifo<zircon_ethernet_FifoEntry>* rx_fifo() { return &rx_; }
     uint32_t tx_depth() { return tx_depth_; }
@@ -541,6 +564,33 @@ static bool EthernetStartTest() {
     END_TEST;
 }
 
+static bool EthernetSingleQueueTest() {
+    BEGIN_TEST;
+
+    zx::socket sock;
+    EthernetClient client;
+    EthernetOpenInfo info(__func__);
+    ASSERT_TRUE(OpenFirstClientHelper(&sock, &client, info));
+
+    // Ethertap devices have only the queue GetFifos() opened.
+    uint32_t count = 0;
+    EXPECT_EQ(ZX_OK, client.GetQueueCount(&count));
+    EXPECT_EQ(1u, count);
+
+    zircon_ethernet_Fifos fifos;
+    EXPECT_EQ(ZX_ERR_ALREADY_BOUND,
+              client.GetQueueFifos(0, zircon_ethernet_QUEUE_CPU_ANY, &fifos));
+    EXPECT_EQ(ZX_ERR_OUT_OF_RANGE,
+              client.GetQueueFifos(1, zircon_ethernet_QUEUE_CPU_ANY, &fifos));
+
+    zircon_ethernet_RssConfig rss = {};
+    rss.hash_types = zircon_ethernet_RSS_HASH_TCP_IPV4;
+    EXPECT_EQ(ZX_ERR_NOT_SUPPORTED, client.SetRss(rss));
+
+    ASSERT_TRUE(EthernetCleanupHelper(&sock, &client));
+    END_TEST;
+}
+
 static bool EthernetLinkStatusTest() {
     BEGIN_TEST;
     // Create the ethertap device
@@ -894,6 +944,7 @@ static bool EthernetDataTest_Recv() {
 BEGIN_TEST_CASE(EthernetSetupTests)
 RUN_TEST_MEDIUM(EthernetStartTest)
 RUN_TEST_MEDIUM(EthernetLinkStatusTest)
+RUN_TEST_MEDIUM(EthernetSingleQueueTest)
 END_TEST_CASE(EthernetSetupTests)
 
 BEGIN_TEST_CASE(EthernetConfigTests)
@@ -0,0 +1,190 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stdint.h>
+#include <string.h>
+
+#include <fbl/arena.h>
+#include <fbl/string.h>
+#include <fbl/vector.h>
+#include <unittest/unittest.h>
+
+namespace {
+
+constexpr size_t kChunkSize = 1024;
+
+struct Point {
+    Point(int x, int y)
+        : x(x), y(y) {}
+
+    int x;
+    int y;
+};
+
+bool IsAligned(const void* ptr, size_t alignment) {
+    return (reinterpret_cast<uintptr_t>(ptr) & (alignment - 1)) == 0;
+}
+
+bool allocate_test() {
+    BEGIN_TEST;
+
+    fbl::Arena arena(kChunkSize);
+
+    char* a = static_cast<char*>(arena.Allocate(10, 1));
+    ASSERT_NONNULL(a);
+    char* b = static_cast<char*>(arena.Allocate(10, 1));
+    ASSERT_NONNULL(b);
+    // Small allocations come from the same chunk, one after the other.
+    EXPECT_EQ(a + 10, b);
+    memset(a, 'a', 10);
+    memset(b, 'b', 10);
+    EXPECT_EQ('a', a[9]);
+
+    void* c = arena.Allocate(1);
+    ASSERT_NONNULL(c);
+    EXPECT_TRUE(IsAligned(c, alignof(max_align_t)));
+    void* d = arena.Allocate(3, 4);
+    ASSERT_NONNULL(d);
+    EXPECT_TRUE(IsAligned(d, 4));
+
+    Point* point = arena.New<Point>(3, 4);
+    ASSERT_NONNULL(point);
+    EXPECT_TRUE(IsAligned(point, alignof(Point)));
+    EXPECT_EQ(3, point->x);
+    EXPECT_EQ(4, point->y);
+
+    END_TEST;
+}
+
+bool chunk_overflow_test() {
+    BEGIN_TEST;
+
+    fbl::Arena arena(kChunkSize);
+
+    // Fill more than one chunk, checking that no allocation overlaps the
+    // previous one.
+    char* prev = nullptr;
+    for (size_t i = 0; i < 3 * kChunkSize / 100; i++) {
+        char* ptr = static_cast<char*>(arena.Allocate(100, 1));
+        ASSERT_NONNULL(ptr);
+        memset(ptr, static_cast<int>(i), 100);
+        if (prev != nullptr) {
+            EXPECT_EQ(static_cast<char>(i - 1), prev[99]);
+        }
+        prev = ptr;
+    }
+
+    END_TEST;
+}
+
+bool large_allocation_test() {
+    BEGIN_TEST;
+
+    fbl::Arena arena(kChunkSize);
+
+    char* small = static_cast<char*>(arena.Allocate(8, 1));
+    ASSERT_NONNULL(small);
+    char* large = static_cast<char*>(arena.Allocate(4 * kChunkSize));
+    ASSERT_NONNULL(large);
+    memset(large, 0xff, 4 * kChunkSize);
+    // The large allocation doesn't use up the current chunk.
+    EXPECT_EQ(small + 8, arena.Allocate(8, 1));
+
+    END_TEST;
+}
+
+bool reset_reuses_chunks_test() {
+    BEGIN_TEST;
+
+    fbl::Arena arena(kChunkSize);
+
+    void* first = arena.Allocate(kChunkSize / 4);
+    ASSERT_NONNULL(first);
+    for (int i = 0; i < 8; i++) {
+        ASSERT_NONNULL(arena.Allocate(kChunkSize / 4));
+    }
+
+    arena.Reset();
+
+    // The chunks are reused, so the first allocation after a reset lands
+    // in one of the chunks from before it.
+    void* after = arena.Allocate(kChunkSize / 4);
+    ASSERT_NONNULL(after);
+    arena.Reset();
+    void* again = arena.Allocate(kChunkSize / 4);
+    EXPECT_EQ(after, again);
+
+    END_TEST;
+}
+
+bool vector_test() {
+    BEGIN_TEST;
+
+    fbl::Arena arena(kChunkSize);
+
+    fbl::Vector<int, fbl::ArenaAllocatorTraits> vector{fbl::ArenaAllocatorTraits(&arena)};
+    for (int i = 0; i < 100; i++) {
+        fbl::AllocChecker ac;
+        vector.push_back(i, &ac);
+        ASSERT_TRUE(ac.check());
+    }
+    ASSERT_EQ(100u, vector.size());
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQ(i, vector[i]);
+    }
+
+    // The allocator moves along with the storage.
+    fbl::Vector<int, fbl::ArenaAllocatorTraits> moved(fbl::move(vector));
+    EXPECT_EQ(100u, moved.size());
+    fbl::AllocChecker ac;
+    moved.push_back(100, &ac);
+    ASSERT_TRUE(ac.check());
+    EXPECT_EQ(100, moved[100]);
+
+    END_TEST;
+}
+
+bool string_test() {
+    BEGIN_TEST;
+
+    fbl::Arena arena(kChunkSize);
+
+    {
+        fbl::AllocChecker ac;
+        fbl::String empty("", 0u, &arena, &ac);
+        EXPECT_TRUE(ac.check());
+        EXPECT_TRUE(empty.empty());
+    }
+
+    {
+        fbl::AllocChecker ac;
+        fbl::String str(fbl::StringPiece("hello"), &arena, &ac);
+        ASSERT_TRUE(ac.check());
+        EXPECT_STR_EQ("hello", str.c_str());
+        EXPECT_EQ(5u, str.length());
+
+        // Copies share the buffer, and releasing every one of them must
+        // not free it: it belongs to the arena.
+        fbl::String copy(str);
+        EXPECT_EQ(str.data(), copy.data());
+        copy.clear();
+        str = fbl::String("world");
+        EXPECT_STR_EQ("world", str.c_str());
+    }
+
+    arena.Reset();
+
+    END_TEST;
+}
+
+} // namespace
+
+BEGIN_TEST_CASE(arena_tests)
+RUN_TEST(allocate_test)
+RUN_TEST(chunk_overflow_test)
+RUN_TEST(large_allocation_test)
+RUN_TEST(reset_reuses_chunks_test)
+RUN_TEST(vector_test)
+RUN_TEST(string_test)
+END_TEST_CASE(arena_tests)
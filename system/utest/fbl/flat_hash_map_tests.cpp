@@ -0,0 +1,206 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <fbl/flat_hash_map.h>
+#include <fbl/string.h>
+#include <fbl/string_piece.h>
+#include <fbl/unique_ptr.h>
+#include <unittest/unittest.h>
+
+namespace {
+
+using IntMap = fbl::FlatHashMap<uint64_t, uint64_t>;
+
+// Puts every key in the same group, to exercise probing.
+struct CollidingHashTraits {
+    static size_t GetHash(const uint64_t& key) { return key & 0x7f; }
+    static bool EqualTo(const uint64_t& key1, const uint64_t& key2) { return key1 == key2; }
+};
+
+struct StringHashTraits {
+    static size_t GetHash(const fbl::String& key) {
+        // FNV-1a, then mixed so that the high bits are usable.
+        uint64_t h = 0xcbf29ce484222325ull;
+        for (char c : fbl::StringPiece(key)) {
+            h = (h ^ static_cast<uint8_t>(c)) * 0x100000001b3ull;
+        }
+        return fbl::DefaultFlatHashTraits<uint64_t>::GetHash(h);
+    }
+    static bool EqualTo(const fbl::String& key1, const fbl::String& key2) { return key1 == key2; }
+};
+
+bool empty_test() {
+    BEGIN_TEST;
+
+    IntMap map;
+    EXPECT_TRUE(map.is_empty());
+    EXPECT_EQ(0u, map.size());
+    EXPECT_NULL(map.find(1));
+    EXPECT_FALSE(map.erase(1));
+    EXPECT_TRUE(map.begin() == map.end());
+
+    END_TEST;
+}
+
+bool insert_find_test() {
+    BEGIN_TEST;
+
+    constexpr uint64_t kCount = 1000;
+
+    IntMap map;
+    for (uint64_t i = 0; i < kCount; i++) {
+        fbl::AllocChecker ac;
+        uint64_t* value = map.insert_or_find(i, i * 2, &ac);
+        ASSERT_TRUE(ac.check());
+        ASSERT_NONNULL(value);
+        EXPECT_EQ(i * 2, *value);
+    }
+    EXPECT_EQ(kCount, map.size());
+    EXPECT_GE(map.capacity(), kCount);
+
+    for (uint64_t i = 0; i < kCount; i++) {
+        const uint64_t* value = map.find(i);
+        ASSERT_NONNULL(value);
+        EXPECT_EQ(i * 2, *value);
+    }
+    EXPECT_NULL(map.find(kCount));
+
+    // Inserting an existing key finds it instead.
+    fbl::AllocChecker ac;
+    uint64_t* value = map.insert_or_find(7, 0, &ac);
+    ASSERT_TRUE(ac.check());
+    ASSERT_NONNULL(value);
+    EXPECT_EQ(14u, *value);
+    EXPECT_EQ(kCount, map.size());
+
+    value = map.insert_or_replace(7, 1, &ac);
+    ASSERT_TRUE(ac.check());
+    ASSERT_NONNULL(value);
+    EXPECT_EQ(1u, *value);
+    EXPECT_EQ(1u, *map.find(7));
+    EXPECT_EQ(kCount, map.size());
+
+    END_TEST;
+}
+
+bool erase_test() {
+    BEGIN_TEST;
+
+    constexpr uint64_t kCount = 500;
+
+    fbl::FlatHashMap<uint64_t, uint64_t, CollidingHashTraits> map;
+    for (int round = 0; round < 4; round++) {
+        for (uint64_t i = 0; i < kCount; i++) {
+            fbl::AllocChecker ac;
+            ASSERT_NONNULL(map.insert_or_find(i, i, &ac));
+            ASSERT_TRUE(ac.check());
+        }
+        // Erase the even keys, and check the odd ones can still be found
+        // past the holes.
+        for (uint64_t i = 0; i < kCount; i += 2) {
+            EXPECT_TRUE(map.erase(i));
+            EXPECT_FALSE(map.erase(i));
+        }
+        EXPECT_EQ(kCount / 2, map.size());
+        for (uint64_t i = 0; i < kCount; i++) {
+            if (i % 2 == 0) {
+                EXPECT_NULL(map.find(i));
+            } else {
+                ASSERT_NONNULL(map.find(i));
+                EXPECT_EQ(i, *map.find(i));
+            }
+        }
+    }
+
+    map.clear();
+    EXPECT_TRUE(map.is_empty());
+    EXPECT_NULL(map.find(1));
+
+    END_TEST;
+}
+
+bool iterate_test() {
+    BEGIN_TEST;
+
+    IntMap map;
+    uint64_t expected_sum = 0;
+    for (uint64_t i = 1; i <= 100; i++) {
+        fbl::AllocChecker ac;
+        ASSERT_NONNULL(map.insert_or_find(i, i * 3, &ac));
+        ASSERT_TRUE(ac.check());
+        expected_sum += i;
+    }
+
+    uint64_t sum = 0;
+    size_t count = 0;
+    for (const auto& entry : map) {
+        EXPECT_EQ(entry.key * 3, entry.value);
+        sum += entry.key;
+        count++;
+    }
+    EXPECT_EQ(100u, count);
+    EXPECT_EQ(expected_sum, sum);
+
+    END_TEST;
+}
+
+bool move_only_values_test() {
+    BEGIN_TEST;
+
+    fbl::FlatHashMap<fbl::String, fbl::unique_ptr<int>, StringHashTraits> map;
+    for (int i = 0; i < 50; i++) {
+        fbl::AllocChecker ac;
+        fbl::unique_ptr<int> value(new int(i));
+        char name[16];
+        snprintf(name, sizeof(name), "key%d", i);
+        ASSERT_NONNULL(map.insert_or_find(fbl::String(name), fbl::move(value), &ac));
+        ASSERT_TRUE(ac.check());
+    }
+
+    fbl::unique_ptr<int>* value = map.find(fbl::String("key42"));
+    ASSERT_NONNULL(value);
+    EXPECT_EQ(42, **value);
+    EXPECT_TRUE(map.erase(fbl::String("key42")));
+    EXPECT_NULL(map.find(fbl::String("key42")));
+
+    decltype(map) moved(fbl::move(map));
+    EXPECT_TRUE(map.is_empty());
+    EXPECT_EQ(49u, moved.size());
+    ASSERT_NONNULL(moved.find(fbl::String("key7")));
+
+    END_TEST;
+}
+
+bool reserve_test() {
+    BEGIN_TEST;
+
+    IntMap map;
+    fbl::AllocChecker ac;
+    map.reserve(100, &ac);
+    ASSERT_TRUE(ac.check());
+    size_t capacity = map.capacity();
+    EXPECT_GE(capacity, 100u);
+
+    for (uint64_t i = 0; i < 100; i++) {
+        ASSERT_NONNULL(map.insert_or_find(i, i, &ac));
+        ASSERT_TRUE(ac.check());
+    }
+    EXPECT_EQ(capacity, map.capacity());
+
+    END_TEST;
+}
+
+} // namespace
+
+BEGIN_TEST_CASE(flat_hash_map_tests)
+RUN_TEST(empty_test)
+RUN_TEST(insert_find_test)
+RUN_TEST(erase_test)
+RUN_TEST(iterate_test)
+RUN_TEST(move_only_values_test)
+RUN_TEST(reserve_test)
+END_TEST_CASE(flat_hash_map_tests)
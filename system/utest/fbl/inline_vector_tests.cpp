@@ -0,0 +1,184 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <fbl/alloc_checker.h>
+#include <fbl/inline_vector.h>
+#include <fbl/unique_ptr.h>
+#include <fbl/vector.h>
+#include <unittest/unittest.h>
+
+namespace {
+
+// Counts the heap allocations made by the vectors under test.
+struct CountingAllocatorTraits {
+    static void* Allocate(size_t size) {
+        allocations++;
+        return fbl::DefaultAllocatorTraits::Allocate(size);
+    }
+
+    static void Deallocate(void* object) {
+        if (object != nullptr) {
+            deallocations++;
+        }
+        fbl::DefaultAllocatorTraits::Deallocate(object);
+    }
+
+    static size_t allocations;
+    static size_t deallocations;
+};
+
+size_t CountingAllocatorTraits::allocations = 0;
+size_t CountingAllocatorTraits::deallocations = 0;
+
+struct FailingAllocatorTraits {
+    static void* Allocate(size_t size) { return nullptr; }
+    static void Deallocate(void* object) { ZX_ASSERT(object == nullptr); }
+};
+
+constexpr size_t kInline = 4;
+
+using IntVector = fbl::InlineVector<int, kInline, CountingAllocatorTraits>;
+using PtrVector = fbl::InlineVector<fbl::unique_ptr<int>, kInline, CountingAllocatorTraits>;
+
+bool inline_storage_test() {
+    BEGIN_TEST;
+
+    CountingAllocatorTraits::allocations = 0;
+    {
+        IntVector vector;
+        EXPECT_TRUE(vector.is_empty());
+        EXPECT_TRUE(vector.is_inline());
+        EXPECT_EQ(kInline, vector.capacity());
+
+        for (int i = 0; i < static_cast<int>(kInline); i++) {
+            fbl::AllocChecker ac;
+            vector.push_back(i, &ac);
+            ASSERT_TRUE(ac.check());
+        }
+        EXPECT_TRUE(vector.is_inline());
+        EXPECT_EQ(0u, CountingAllocatorTraits::allocations);
+
+        EXPECT_EQ(0, vector.erase(0));
+        vector.insert(0, 0);
+        EXPECT_TRUE(vector.is_inline());
+        EXPECT_EQ(kInline, vector.size());
+        for (int i = 0; i < static_cast<int>(kInline); i++) {
+            EXPECT_EQ(i, vector[i]);
+        }
+    }
+    EXPECT_EQ(0u, CountingAllocatorTraits::allocations);
+
+    END_TEST;
+}
+
+bool spill_to_heap_test() {
+    BEGIN_TEST;
+
+    CountingAllocatorTraits::allocations = 0;
+    CountingAllocatorTraits::deallocations = 0;
+    {
+        IntVector vector;
+        for (int i = 0; i < 100; i++) {
+            vector.push_back(i);
+        }
+        EXPECT_FALSE(vector.is_inline());
+        EXPECT_GE(vector.capacity(), 100u);
+        for (int i = 0; i < 100; i++) {
+            EXPECT_EQ(i, vector[i]);
+        }
+
+        // Popping back down moves the elements back inline.
+        while (vector.size() > 1) {
+            vector.pop_back();
+        }
+        EXPECT_TRUE(vector.is_inline());
+        EXPECT_EQ(kInline, vector.capacity());
+        EXPECT_EQ(0, vector[0]);
+        EXPECT_EQ(CountingAllocatorTraits::allocations,
+                  CountingAllocatorTraits::deallocations);
+    }
+    EXPECT_EQ(CountingAllocatorTraits::allocations, CountingAllocatorTraits::deallocations);
+
+    END_TEST;
+}
+
+bool move_test() {
+    BEGIN_TEST;
+
+    CountingAllocatorTraits::allocations = 0;
+    CountingAllocatorTraits::deallocations = 0;
+    {
+        // Moving an inline vector moves its elements.
+        PtrVector a;
+        a.push_back(fbl::unique_ptr<int>(new int(1)));
+        a.push_back(fbl::unique_ptr<int>(new int(2)));
+        PtrVector b(fbl::move(a));
+        EXPECT_TRUE(a.is_empty());
+        EXPECT_TRUE(b.is_inline());
+        ASSERT_EQ(2u, b.size());
+        EXPECT_EQ(1, *b[0]);
+        EXPECT_EQ(2, *b[1]);
+
+        // Moving a vector on the heap takes its storage.
+        PtrVector c;
+        for (int i = 0; i < 10; i++) {
+            c.push_back(fbl::unique_ptr<int>(new int(i)));
+        }
+        const fbl::unique_ptr<int>* storage = c.get();
+        b = fbl::move(c);
+        EXPECT_TRUE(c.is_empty());
+        EXPECT_TRUE(c.is_inline());
+        EXPECT_EQ(storage, b.get());
+        ASSERT_EQ(10u, b.size());
+        for (int i = 0; i < 10; i++) {
+            EXPECT_EQ(i, *b[i]);
+        }
+
+        // And back again.
+        c = fbl::move(b);
+        EXPECT_EQ(storage, c.get());
+        EXPECT_EQ(1u, CountingAllocatorTraits::allocations -
+                          CountingAllocatorTraits::deallocations);
+    }
+    EXPECT_EQ(CountingAllocatorTraits::allocations, CountingAllocatorTraits::deallocations);
+
+    END_TEST;
+}
+
+bool allocation_failure_test() {
+    BEGIN_TEST;
+
+    fbl::InlineVector<int, kInline, FailingAllocatorTraits> vector;
+    fbl::AllocChecker ac;
+    vector.reserve(kInline, &ac);
+    EXPECT_TRUE(ac.check());
+    for (int i = 0; i < static_cast<int>(kInline); i++) {
+        vector.push_back(i, &ac);
+        ASSERT_TRUE(ac.check());
+    }
+
+    // Growing past the inline storage fails, and the vector is unchanged.
+    vector.push_back(100, &ac);
+    EXPECT_FALSE(ac.check());
+    vector.insert(0, 100, &ac);
+    EXPECT_FALSE(ac.check());
+    vector.reserve(kInline + 1, &ac);
+    EXPECT_FALSE(ac.check());
+    EXPECT_TRUE(vector.is_inline());
+    ASSERT_EQ(kInline, vector.size());
+    for (int i = 0; i < static_cast<int>(kInline); i++) {
+        EXPECT_EQ(i, vector[i]);
+    }
+
+    END_TEST;
+}
+
+} // namespace
+
+BEGIN_TEST_CASE(inline_vector_tests)
+RUN_TEST(inline_storage_test)
+RUN_TEST(spill_to_heap_test)
+RUN_TEST(move_test)
+RUN_TEST(allocation_failure_test)
+END_TEST_CASE(inline_vector_tests)
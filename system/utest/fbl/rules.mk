@@ -10,13 +10,16 @@ LOCAL_DIR := $(GET_LOCAL_DIR)
 
 fbl_common_tests := \
     $(LOCAL_DIR)/algorithm_tests.cpp \
+    $(LOCAL_DIR)/arena_tests.cpp \
     $(LOCAL_DIR)/array_tests.cpp \
     $(LOCAL_DIR)/atomic_tests.cpp \
     $(LOCAL_DIR)/auto_call_tests.cpp \
+    $(LOCAL_DIR)/flat_hash_map_tests.cpp \
     $(LOCAL_DIR)/forward_tests.cpp \
     $(LOCAL_DIR)/function_tests.cpp \
     $(LOCAL_DIR)/initializer_list_tests.cpp \
     $(LOCAL_DIR)/integer_sequence_tests.cpp \
+    $(LOCAL_DIR)/inline_vector_tests.cpp \
     $(LOCAL_DIR)/intrusive_container_tests.cpp \
     $(LOCAL_DIR)/intrusive_doubly_linked_list_tests.cpp \
     $(LOCAL_DIR)/intrusive_hash_table_dll_tests.cpp \
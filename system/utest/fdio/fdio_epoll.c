@@ -0,0 +1,90 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <unittest/unittest.h>
+
+bool epoll_level_test(void) {
+    BEGIN_TEST;
+
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0, "socketpair failed");
+
+    int epfd = epoll_create1(0);
+    ASSERT_GE(epfd, 0, "epoll_create1 failed");
+
+    struct epoll_event ev = {.events = EPOLLIN, .data.u64 = 7u};
+    EXPECT_EQ(epoll_ctl(epfd, EPOLL_CTL_ADD, fds[1], &ev), 0, "EPOLL_CTL_ADD failed");
+    EXPECT_EQ(epoll_ctl(epfd, EPOLL_CTL_ADD, fds[1], &ev), -1, "duplicate add succeeded");
+    EXPECT_EQ(errno, EEXIST, "");
+
+    struct epoll_event out[4];
+    EXPECT_EQ(epoll_wait(epfd, out, 4, 0), 0, "nothing should be ready");
+
+    char buf[4] = "abc";
+    EXPECT_EQ(write(fds[0], buf, 4), 4, "write failed");
+
+    // Level triggered: the fd is reported on every call until it is drained.
+    for (int i = 0; i < 2; i++) {
+        EXPECT_EQ(epoll_wait(epfd, out, 4, 1000), 1, "fd not ready");
+        EXPECT_EQ(out[0].events & EPOLLIN, (uint32_t)EPOLLIN, "");
+        EXPECT_EQ(out[0].data.u64, 7u, "");
+    }
+
+    EXPECT_EQ(read(fds[1], buf, 4), 4, "read failed");
+    EXPECT_EQ(epoll_wait(epfd, out, 4, 0), 0, "drained fd still ready");
+
+    EXPECT_EQ(epoll_ctl(epfd, EPOLL_CTL_DEL, fds[1], NULL), 0, "EPOLL_CTL_DEL failed");
+    EXPECT_EQ(epoll_ctl(epfd, EPOLL_CTL_DEL, fds[1], NULL), -1, "double delete succeeded");
+    EXPECT_EQ(errno, ENOENT, "");
+
+    EXPECT_EQ(write(fds[0], buf, 4), 4, "write failed");
+    EXPECT_EQ(epoll_wait(epfd, out, 4, 0), 0, "deleted fd reported");
+
+    EXPECT_EQ(close(epfd), 0, "");
+    EXPECT_EQ(close(fds[0]), 0, "");
+    EXPECT_EQ(close(fds[1]), 0, "");
+
+    END_TEST;
+}
+
+bool epoll_oneshot_test(void) {
+    BEGIN_TEST;
+
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0, "socketpair failed");
+
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    ASSERT_GE(epfd, 0, "epoll_create1 failed");
+
+    struct epoll_event ev = {.events = EPOLLIN | EPOLLONESHOT, .data.fd = fds[1]};
+    EXPECT_EQ(epoll_ctl(epfd, EPOLL_CTL_ADD, fds[1], &ev), 0, "EPOLL_CTL_ADD failed");
+
+    char buf[4] = "abc";
+    EXPECT_EQ(write(fds[0], buf, 4), 4, "write failed");
+
+    struct epoll_event out[4];
+    EXPECT_EQ(epoll_wait(epfd, out, 4, 1000), 1, "fd not ready");
+    EXPECT_EQ(out[0].data.fd, fds[1], "");
+    EXPECT_EQ(epoll_wait(epfd, out, 4, 0), 0, "oneshot fd reported twice");
+
+    // Re-arming reports the still-pending data again.
+    EXPECT_EQ(epoll_ctl(epfd, EPOLL_CTL_MOD, fds[1], &ev), 0, "EPOLL_CTL_MOD failed");
+    EXPECT_EQ(epoll_wait(epfd, out, 4, 1000), 1, "re-armed fd not ready");
+
+    EXPECT_EQ(close(epfd), 0, "");
+    EXPECT_EQ(close(fds[0]), 0, "");
+    EXPECT_EQ(close(fds[1]), 0, "");
+
+    END_TEST;
+}
+
+BEGIN_TEST_CASE(fdio_epoll_test)
+RUN_TEST(epoll_level_test);
+RUN_TEST(epoll_oneshot_test);
+END_TEST_CASE(fdio_epoll_test)
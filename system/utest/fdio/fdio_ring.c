@@ -0,0 +1,215 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <lib/fdio/ring.h>
+#include <zircon/syscalls.h>
+
+#include <unittest/unittest.h>
+
+static bool reap_one(fdio_ring_t* ring, fdio_ring_cqe_t* cqe) {
+    BEGIN_HELPER;
+    size_t actual;
+    ASSERT_EQ(fdio_ring_reap(ring, cqe, 1, zx_deadline_after(ZX_SEC(5)), &actual), ZX_OK, "");
+    ASSERT_EQ(actual, 1u, "");
+    END_HELPER;
+}
+
+bool ring_file_test(void) {
+    BEGIN_TEST;
+
+    int dirfd = open("/tmp", O_RDONLY | O_DIRECTORY);
+    ASSERT_GE(dirfd, 0, "");
+    unlinkat(dirfd, "fdio-ring-test", 0);
+
+    fdio_ring_t* ring;
+    ASSERT_EQ(fdio_ring_create(8, ZX_HANDLE_INVALID, 0, &ring), ZX_OK, "");
+
+    fdio_ring_sqe_t sqe = {
+        .opcode = FDIO_RING_OP_OPEN,
+        .fd = dirfd,
+        .path = "fdio-ring-test",
+        .flags = O_RDWR | O_CREAT,
+        .mode = 0644,
+        .user_data = 1,
+    };
+    size_t submitted;
+    ASSERT_EQ(fdio_ring_submit(ring, &sqe, 1, &submitted), ZX_OK, "");
+    ASSERT_EQ(submitted, 1u, "");
+    fdio_ring_cqe_t cqe;
+    ASSERT_TRUE(reap_one(ring, &cqe), "");
+    ASSERT_EQ(cqe.status, ZX_OK, "");
+    ASSERT_EQ(cqe.user_data, 1u, "");
+    int fd = (int)cqe.result;
+
+    // Writes to different offsets are all in flight at once.
+    char data[3][4] = {"abc", "def", "ghi"};
+    fdio_ring_sqe_t writes[3];
+    for (int i = 0; i < 3; i++) {
+        writes[i] = (fdio_ring_sqe_t){
+            .opcode = FDIO_RING_OP_WRITE,
+            .fd = fd,
+            .buf = data[i],
+            .len = 4,
+            .offset = i * 4,
+            .user_data = 10 + i,
+        };
+    }
+    ASSERT_EQ(fdio_ring_submit(ring, writes, 3, &submitted), ZX_OK, "");
+    ASSERT_EQ(submitted, 3u, "");
+    uint64_t seen = 0;
+    for (int i = 0; i < 3; i++) {
+        ASSERT_TRUE(reap_one(ring, &cqe), "");
+        EXPECT_EQ(cqe.status, ZX_OK, "");
+        EXPECT_EQ(cqe.result, 4, "");
+        seen |= 1u << (cqe.user_data - 10);
+    }
+    EXPECT_EQ(seen, 7u, "");
+
+    fdio_ring_sqe_t ops[2] = {
+        {.opcode = FDIO_RING_OP_FSYNC, .fd = fd, .user_data = 20},
+        {.opcode = FDIO_RING_OP_READ, .fd = fd, .len = 8, .offset = 4, .user_data = 21},
+    };
+    char buf[8] = {};
+    ops[1].buf = buf;
+    ASSERT_EQ(fdio_ring_submit(ring, ops, 2, &submitted), ZX_OK, "");
+    for (int i = 0; i < 2; i++) {
+        ASSERT_TRUE(reap_one(ring, &cqe), "");
+        EXPECT_EQ(cqe.status, ZX_OK, "");
+        if (cqe.user_data == 21) {
+            EXPECT_EQ(cqe.result, 8, "");
+        }
+    }
+    EXPECT_EQ(memcmp(buf, "def\0ghi\0", 8), 0, "");
+
+    // Operations on bad file descriptors still complete.
+    sqe = (fdio_ring_sqe_t){.opcode = FDIO_RING_OP_FSYNC, .fd = -1, .user_data = 30};
+    ASSERT_EQ(fdio_ring_submit(ring, &sqe, 1, &submitted), ZX_OK, "");
+    ASSERT_TRUE(reap_one(ring, &cqe), "");
+    EXPECT_EQ(cqe.status, ZX_ERR_BAD_HANDLE, "");
+
+    fdio_ring_destroy(ring);
+    EXPECT_EQ(close(fd), 0, "");
+    EXPECT_EQ(unlinkat(dirfd, "fdio-ring-test", 0), 0, "");
+    EXPECT_EQ(close(dirfd), 0, "");
+
+    END_TEST;
+}
+
+bool ring_shared_file_test(void) {
+    BEGIN_TEST;
+
+    int fd = open("/tmp/fdio-ring-shared-test", O_RDWR | O_CREAT | O_TRUNC, 0644);
+    ASSERT_GE(fd, 0, "");
+    ASSERT_EQ(write(fd, "abcd", 4), 4, "");
+
+    fdio_ring_t* first;
+    ASSERT_EQ(fdio_ring_create(1, ZX_HANDLE_INVALID, 0, &first), ZX_OK, "");
+    fdio_ring_t* second;
+    ASSERT_EQ(fdio_ring_create(1, ZX_HANDLE_INVALID, 0, &second), ZX_OK, "");
+
+    char buf[2][4] = {};
+    fdio_ring_sqe_t sqe = {
+        .opcode = FDIO_RING_OP_READ,
+        .fd = fd,
+        .buf = buf[0],
+        .len = 4,
+        .offset = 0,
+        .user_data = 1,
+    };
+    size_t submitted;
+    ASSERT_EQ(fdio_ring_submit(first, &sqe, 1, &submitted), ZX_OK, "");
+
+    // The first ring's read stays in flight until it's reaped, and until then
+    // the second ring can't read the file's replies.
+    sqe.buf = buf[1];
+    sqe.user_data = 2;
+    ASSERT_EQ(fdio_ring_submit(second, &sqe, 1, &submitted), ZX_OK, "");
+    fdio_ring_cqe_t cqe;
+    ASSERT_TRUE(reap_one(second, &cqe), "");
+    EXPECT_EQ(cqe.user_data, 2u, "");
+    EXPECT_EQ(cqe.status, ZX_ERR_BAD_STATE, "");
+
+    ASSERT_TRUE(reap_one(first, &cqe), "");
+    EXPECT_EQ(cqe.user_data, 1u, "");
+    EXPECT_EQ(cqe.status, ZX_OK, "");
+    EXPECT_EQ(cqe.result, 4, "");
+    EXPECT_EQ(memcmp(buf[0], "abcd", 4), 0, "");
+
+    // Once it has, the second ring can.
+    ASSERT_EQ(fdio_ring_submit(second, &sqe, 1, &submitted), ZX_OK, "");
+    ASSERT_TRUE(reap_one(second, &cqe), "");
+    EXPECT_EQ(cqe.status, ZX_OK, "");
+    EXPECT_EQ(cqe.result, 4, "");
+    EXPECT_EQ(memcmp(buf[1], "abcd", 4), 0, "");
+
+    fdio_ring_destroy(first);
+    fdio_ring_destroy(second);
+    EXPECT_EQ(close(fd), 0, "");
+    EXPECT_EQ(unlink("/tmp/fdio-ring-shared-test"), 0, "");
+
+    END_TEST;
+}
+
+bool ring_socket_test(void) {
+    BEGIN_TEST;
+
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0, "socketpair failed");
+
+    zx_handle_t port;
+    ASSERT_EQ(zx_port_create(0, &port), ZX_OK, "");
+    fdio_ring_t* ring;
+    ASSERT_EQ(fdio_ring_create(1, port, 100, &ring), ZX_OK, "");
+
+    char buf[4] = {};
+    fdio_ring_sqe_t sqe = {
+        .opcode = FDIO_RING_OP_READ,
+        .fd = fds[1],
+        .buf = buf,
+        .len = sizeof(buf),
+        .offset = -1,
+        .user_data = 7,
+    };
+    size_t submitted;
+    ASSERT_EQ(fdio_ring_submit(ring, &sqe, 1, &submitted), ZX_OK, "");
+    EXPECT_EQ(fdio_ring_submit(ring, &sqe, 1, &submitted), ZX_ERR_SHOULD_WAIT, "ring is full");
+
+    // Nothing completes until there is something to read.
+    fdio_ring_cqe_t cqe;
+    size_t actual;
+    EXPECT_EQ(fdio_ring_reap(ring, &cqe, 1, 0, &actual), ZX_ERR_SHOULD_WAIT, "");
+    EXPECT_EQ(write(fds[0], "abc", 4), 4, "write failed");
+
+    zx_port_packet_t packet;
+    ASSERT_EQ(zx_port_wait(port, zx_deadline_after(ZX_SEC(5)), &packet), ZX_OK, "");
+    EXPECT_EQ(packet.key, 100u, "");
+    ASSERT_EQ(fdio_ring_process(ring, &packet), ZX_OK, "");
+    ASSERT_EQ(fdio_ring_reap(ring, &cqe, 1, 0, &actual), ZX_OK, "");
+    ASSERT_EQ(actual, 1u, "");
+    EXPECT_EQ(cqe.user_data, 7u, "");
+    EXPECT_EQ(cqe.status, ZX_OK, "");
+    EXPECT_EQ(cqe.result, 4, "");
+    EXPECT_EQ(memcmp(buf, "abc", 4), 0, "");
+
+    packet.key = 1;
+    EXPECT_EQ(fdio_ring_process(ring, &packet), ZX_ERR_NOT_FOUND, "");
+
+    fdio_ring_destroy(ring);
+    zx_handle_close(port);
+    EXPECT_EQ(close(fds[0]), 0, "");
+    EXPECT_EQ(close(fds[1]), 0, "");
+
+    END_TEST;
+}
+
+BEGIN_TEST_CASE(fdio_ring_test)
+RUN_TEST(ring_file_test);
+RUN_TEST(ring_shared_file_test);
+RUN_TEST(ring_socket_test);
+END_TEST_CASE(fdio_ring_test)
@@ -10,10 +10,12 @@ MODULE_TYPE := usertest
 
 MODULE_SRCS += \
     $(LOCAL_DIR)/main.c \
+    $(LOCAL_DIR)/fdio_epoll.c \
     $(LOCAL_DIR)/fdio_handle_fd.c \
     $(LOCAL_DIR)/fdio_open_max.c \
     $(LOCAL_DIR)/fdio_root.c \
     $(LOCAL_DIR)/fdio_path_canonicalize.c \
+    $(LOCAL_DIR)/fdio_ring.c \
     $(LOCAL_DIR)/fdio_socket.c \
     $(LOCAL_DIR)/fdio_socketpair.c
 
@@ -139,6 +139,59 @@ bool decode_null_decode_parameters() {
     END_TEST;
 }
 
+bool decode_plain_data() {
+    BEGIN_TEST;
+
+    plain_data_message_layout message = {};
+    message.inline_struct.data_0 = 0x0123456789abcdefull;
+    message.inline_struct.data_1 = 0xdeadbeefu;
+
+    const char* error = nullptr;
+    auto status = fidl_decode(&plain_data_message_type, &message, sizeof(message), nullptr, 0u,
+                              &error);
+
+    EXPECT_EQ(status, ZX_OK);
+    EXPECT_NULL(error, error);
+    EXPECT_EQ(message.inline_struct.data_0, 0x0123456789abcdefull);
+    EXPECT_EQ(message.inline_struct.data_1, 0xdeadbeefu);
+
+    END_TEST;
+}
+
+bool decode_plain_data_extra_bytes_error() {
+    BEGIN_TEST;
+
+    uint8_t bytes[sizeof(plain_data_message_layout) + FIDL_ALIGNMENT] = {};
+
+    const char* error = nullptr;
+    auto status = fidl_decode(&plain_data_message_type, bytes, ArraySize(bytes), nullptr, 0u,
+                              &error);
+
+    EXPECT_EQ(status, ZX_ERR_INVALID_ARGS);
+    EXPECT_NONNULL(error);
+
+    END_TEST;
+}
+
+bool decode_plain_data_extra_handles_error() {
+    BEGIN_TEST;
+
+    plain_data_message_layout message = {};
+
+    zx_handle_t handles[] = {
+        dummy_handle_0,
+    };
+
+    const char* error = nullptr;
+    auto status = fidl_decode(&plain_data_message_type, &message, sizeof(message), handles,
+                              ArrayCount(handles), &error);
+
+    EXPECT_EQ(status, ZX_ERR_INVALID_ARGS);
+    EXPECT_NONNULL(error);
+
+    END_TEST;
+}
+
 bool decode_single_present_handle() {
     BEGIN_TEST;
 
@@ -1841,6 +1894,12 @@ BEGIN_TEST_CASE(null_parameters)
 RUN_TEST(decode_null_decode_parameters)
 END_TEST_CASE(null_parameters)
 
+BEGIN_TEST_CASE(plain_data)
+RUN_TEST(decode_plain_data)
+RUN_TEST(decode_plain_data_extra_bytes_error)
+RUN_TEST(decode_plain_data_extra_handles_error)
+END_TEST_CASE(plain_data)
+
 BEGIN_TEST_CASE(handles)
 RUN_TEST(decode_single_present_handle)
 RUN_TEST(decode_too_many_handles_specified_error)
@@ -160,6 +160,45 @@ bool encode_null_encode_parameters() {
     END_TEST;
 }
 
+bool encode_plain_data() {
+    BEGIN_TEST;
+
+    plain_data_message_layout message = {};
+    message.inline_struct.data_0 = 0x0123456789abcdefull;
+    message.inline_struct.data_1 = 0xdeadbeefu;
+
+    zx_handle_t handles[1] = {};
+
+    const char* error = nullptr;
+    uint32_t actual_handles = 42u;
+    auto status = fidl_encode(&plain_data_message_type, &message, sizeof(message), handles,
+                              ArrayCount(handles), &actual_handles, &error);
+
+    EXPECT_EQ(status, ZX_OK);
+    EXPECT_NULL(error, error);
+    EXPECT_EQ(actual_handles, 0u);
+    EXPECT_EQ(message.inline_struct.data_0, 0x0123456789abcdefull);
+    EXPECT_EQ(message.inline_struct.data_1, 0xdeadbeefu);
+
+    END_TEST;
+}
+
+bool encode_plain_data_extra_bytes_error() {
+    BEGIN_TEST;
+
+    uint8_t bytes[sizeof(plain_data_message_layout) + FIDL_ALIGNMENT] = {};
+
+    const char* error = nullptr;
+    uint32_t actual_handles = 0u;
+    auto status = fidl_encode(&plain_data_message_type, bytes, ArraySize(bytes), nullptr, 0u,
+                              &actual_handles, &error);
+
+    EXPECT_EQ(status, ZX_ERR_INVALID_ARGS);
+    EXPECT_NONNULL(error);
+
+    END_TEST;
+}
+
 bool encode_single_present_handle() {
     BEGIN_TEST;
 
@@ -1743,6 +1782,11 @@ BEGIN_TEST_CASE(null_parameters)
 RUN_TEST(encode_null_encode_parameters)
 END_TEST_CASE(null_parameters)
 
+BEGIN_TEST_CASE(plain_data)
+RUN_TEST(encode_plain_data)
+RUN_TEST(encode_plain_data_extra_bytes_error)
+END_TEST_CASE(plain_data)
+
 BEGIN_TEST_CASE(handles)
 RUN_TEST(encode_single_present_handle)
 RUN_TEST(encode_single_present_handle_unaligned_error)
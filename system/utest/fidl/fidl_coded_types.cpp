@@ -91,6 +91,11 @@ const fidl_type_t bounded_2_nonnullable_vector_of_uint32 = fidl_type_t(
 const fidl_type_t bounded_2_nullable_vector_of_uint32 = fidl_type_t(
     fidl::FidlCodedVector(nullptr, 2, sizeof(uint32_t), fidl::kNullable));
 
+// Plain data messages. The fidl compiler only emits the fields which need
+// coding, so a message without pointers or handles has none.
+const fidl_type_t plain_data_message_type = fidl_type_t(fidl::FidlCodedStruct(
+    nullptr, 0u, sizeof(plain_data_inline_data), "plain_data_message"));
+
 // Handle messages.
 static const fidl::FidlField nonnullable_handle_message_fields[] = {
     fidl::FidlField(&nonnullable_handle,
@@ -10,6 +10,8 @@
 extern "C" {
 #endif
 
+extern const fidl_type_t plain_data_message_type;
+
 extern const fidl_type_t nonnullable_handle;
 extern const fidl_type_t nullable_handle;
 extern const fidl_type_t nullable_channel_handle;
@@ -9,6 +9,19 @@
 #include <stdalign.h>
 #include <lib/fidl/coding.h>
 
+// Plain data types, with no out-of-line storage or handles.
+struct plain_data_inline_data {
+    alignas(FIDL_ALIGNMENT)
+    fidl_message_header_t header;
+    uint64_t data_0;
+    uint32_t data_1;
+    uint8_t data_2[12];
+};
+struct plain_data_message_layout {
+    alignas(FIDL_ALIGNMENT)
+    plain_data_inline_data inline_struct;
+};
+
 // Handle types.
 struct nonnullable_handle_inline_data {
     alignas(FIDL_ALIGNMENT)
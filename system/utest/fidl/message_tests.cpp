@@ -3,6 +3,7 @@
 // found in the LICENSE file.
 
 #include <lib/fidl/cpp/builder.h>
+#include <lib/fidl/cpp/message_buffer.h>
 #include <lib/fidl/cpp/message_builder.h>
 #include <lib/fidl/cpp/message.h>
 #include <lib/fidl/cpp/string_view.h>
@@ -91,9 +92,50 @@ bool message_builder_test() {
     END_TEST;
 }
 
+bool message_buffer_pool_test() {
+    BEGIN_TEST;
+
+    fidl::MessageBufferPool pool;
+
+    uint8_t* first_bytes = nullptr;
+    {
+        fidl::MessageBuffer buffer(&pool);
+        EXPECT_EQ(buffer.bytes_capacity(), ZX_CHANNEL_MAX_MSG_BYTES);
+        EXPECT_EQ(buffer.handles_capacity(), ZX_CHANNEL_MAX_MSG_HANDLES);
+        first_bytes = buffer.bytes();
+    }
+
+    // The buffer released by the first |MessageBuffer| is reused.
+    {
+        fidl::MessageBuffer buffer(&pool);
+        EXPECT_EQ(buffer.bytes(), first_bytes);
+
+        // A message read into the buffer is a view of its memory.
+        zx::channel h1, h2;
+        ASSERT_EQ(zx::channel::create(0, &h1, &h2), ZX_OK);
+        fidl_message_header_t header = {};
+        header.txid = 7u;
+        header.ordinal = 42u;
+        ASSERT_EQ(h1.write(0, &header, sizeof(header), nullptr, 0), ZX_OK);
+
+        fidl::Message message = buffer.CreateEmptyMessage();
+        ASSERT_EQ(message.Read(h2.get(), 0), ZX_OK);
+        EXPECT_EQ(message.bytes().data(), buffer.bytes());
+        EXPECT_EQ(message.txid(), 7u);
+        EXPECT_EQ(message.ordinal(), 42u);
+
+        // Buffers acquired while the pool is empty are allocated.
+        fidl::MessageBuffer other(&pool);
+        EXPECT_NE(other.bytes(), buffer.bytes());
+    }
+
+    END_TEST;
+}
+
 }  // namespace
 
 BEGIN_TEST_CASE(message_tests)
 RUN_NAMED_TEST("Message test", message_test)
 RUN_NAMED_TEST("MessageBuilder test", message_builder_test)
+RUN_NAMED_TEST("MessageBufferPool test", message_buffer_pool_test)
 END_TEST_CASE(message_tests);
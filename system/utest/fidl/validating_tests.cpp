@@ -127,6 +127,34 @@ bool validate_null_validate_parameters() {
     END_TEST;
 }
 
+bool validate_plain_data() {
+    BEGIN_TEST;
+
+    plain_data_message_layout message = {};
+
+    const char* error = nullptr;
+    auto status = fidl_validate(&plain_data_message_type, &message, sizeof(message), 0u, &error);
+
+    EXPECT_EQ(status, ZX_OK);
+    EXPECT_NULL(error, error);
+
+    END_TEST;
+}
+
+bool validate_plain_data_extra_handles_error() {
+    BEGIN_TEST;
+
+    plain_data_message_layout message = {};
+
+    const char* error = nullptr;
+    auto status = fidl_validate(&plain_data_message_type, &message, sizeof(message), 1u, &error);
+
+    EXPECT_EQ(status, ZX_ERR_INVALID_ARGS);
+    EXPECT_NONNULL(error);
+
+    END_TEST;
+}
+
 bool validate_single_present_handle() {
     BEGIN_TEST;
 
@@ -1560,6 +1588,11 @@ BEGIN_TEST_CASE(null_parameters)
 RUN_TEST(validate_null_validate_parameters)
 END_TEST_CASE(null_parameters)
 
+BEGIN_TEST_CASE(plain_data)
+RUN_TEST(validate_plain_data)
+RUN_TEST(validate_plain_data_extra_handles_error)
+END_TEST_CASE(plain_data)
+
 BEGIN_TEST_CASE(handles)
 RUN_TEST(validate_single_present_handle)
 RUN_TEST(validate_too_many_handles_specified_error)
@@ -0,0 +1,350 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+
+#include <lib/fit/promise.h>
+#include <unittest/unittest.h>
+
+namespace {
+
+// Tracks the tickets of a single task and counts the times it is resumed.
+class fake_resolver final : public fit::suspended_task::resolver {
+public:
+    uint64_t outstanding_tickets() const { return tickets_; }
+    uint64_t resume_count() const { return resumes_; }
+
+    fit::suspended_task::ticket obtain_ticket() {
+        tickets_++;
+        return 1;
+    }
+
+    fit::suspended_task::ticket duplicate_ticket(
+        fit::suspended_task::ticket ticket) override {
+        tickets_++;
+        return ticket;
+    }
+
+    void resolve_ticket(fit::suspended_task::ticket ticket,
+                        bool resume_task) override {
+        tickets_--;
+        if (resume_task)
+            resumes_++;
+    }
+
+private:
+    uint64_t tickets_ = 0;
+    uint64_t resumes_ = 0;
+};
+
+// Runs promises directly, without an executor.
+class fake_context final : public fit::context {
+public:
+    fit::executor* executor() const override { return nullptr; }
+
+    fit::suspended_task suspend_task() override {
+        return fit::suspended_task(&resolver, resolver.obtain_ticket());
+    }
+
+    fake_resolver resolver;
+};
+
+// Returns a promise which completes with |value| after |polls| evaluations.
+fit::promise<int, std::string> make_delayed_promise(int polls, int value) {
+    return fit::make_promise([polls, value]() mutable -> fit::result<int, std::string> {
+               if (polls-- > 0)
+                   return fit::pending();
+               return fit::ok(value);
+           })
+        .box();
+}
+
+bool empty_promise() {
+    BEGIN_TEST;
+
+    fit::promise<> empty;
+    EXPECT_FALSE(empty);
+
+    fit::promise<> null(nullptr);
+    EXPECT_FALSE(null);
+
+    END_TEST;
+}
+
+bool make_promise_handler_signatures() {
+    BEGIN_TEST;
+
+    fake_context context;
+
+    // Handler with context, returning a result.
+    auto a = fit::make_promise([&](fit::context& ctx) -> fit::result<int> {
+        EXPECT_EQ(&context, &ctx);
+        return fit::ok(1);
+    });
+    EXPECT_TRUE(a);
+    EXPECT_EQ(1, a(context).value());
+    EXPECT_FALSE(a);
+
+    // Handler without context, returning void.
+    bool ran = false;
+    auto b = fit::make_promise([&ran] { ran = true; });
+    EXPECT_TRUE(b(context).is_ok());
+    EXPECT_TRUE(ran);
+
+    // Handlers returning ok and error results.
+    auto c = fit::make_promise([] { return fit::ok(std::string("ok")); });
+    EXPECT_TRUE(c(context).value() == "ok");
+    auto d = fit::make_promise([] { return fit::error(42); });
+    EXPECT_EQ(42, d(context).error());
+
+    // Handler returning another promise.
+    auto e = fit::make_promise([] { return make_delayed_promise(1, 7); });
+    EXPECT_TRUE(e(context).is_pending());
+    EXPECT_EQ(7, e(context).value());
+    EXPECT_FALSE(e);
+
+    END_TEST;
+}
+
+bool make_result_promises() {
+    BEGIN_TEST;
+
+    fake_context context;
+
+    auto ok = fit::make_ok_promise(5);
+    EXPECT_EQ(5, ok(context).value());
+
+    auto void_ok = fit::make_ok_promise();
+    EXPECT_TRUE(void_ok(context).is_ok());
+
+    auto error = fit::make_error_promise(std::string("bad"));
+    EXPECT_TRUE(error(context).error() == "bad");
+
+    auto result = fit::make_result_promise<int, int>(fit::error(3));
+    EXPECT_EQ(3, result(context).error());
+
+    END_TEST;
+}
+
+bool pending_handler_is_invoked_again() {
+    BEGIN_TEST;
+
+    fake_context context;
+    int invocations = 0;
+    auto p = fit::make_promise([&]() -> fit::result<> {
+        if (++invocations < 3)
+            return fit::pending();
+        return fit::ok();
+    });
+
+    EXPECT_TRUE(p(context).is_pending());
+    EXPECT_TRUE(p(context).is_pending());
+    EXPECT_TRUE(p(context).is_ok());
+    EXPECT_EQ(3, invocations);
+    EXPECT_FALSE(p);
+
+    END_TEST;
+}
+
+bool then_combinator() {
+    BEGIN_TEST;
+
+    fake_context context;
+
+    auto p = make_delayed_promise(1, 10)
+                 .then([](fit::result<int, std::string>& result) -> fit::result<std::string> {
+                     return fit::ok(std::to_string(result.value()));
+                 });
+    EXPECT_TRUE(p(context).is_pending());
+    EXPECT_TRUE(p(context).value() == "10");
+
+    auto q = fit::make_error_promise(std::string("bad"))
+                 .then([](fit::context& ctx, fit::result<void, std::string>& result) {
+                     return fit::ok(result.is_error());
+                 });
+    EXPECT_TRUE(q(context).value());
+
+    END_TEST;
+}
+
+bool and_then_combinator() {
+    BEGIN_TEST;
+
+    fake_context context;
+
+    int value = 0;
+    auto p = make_delayed_promise(1, 10)
+                 .and_then([](int& value) { return fit::ok(value * 2); })
+                 .and_then([](fit::context& ctx, int& value) {
+                     return make_delayed_promise(1, value + 1);
+                 })
+                 .and_then([&value](int& result) { value = result; });
+    EXPECT_TRUE(p(context).is_pending());
+    EXPECT_TRUE(p(context).is_pending());
+    EXPECT_TRUE(p(context).is_ok());
+    EXPECT_EQ(21, value);
+
+    // Errors skip the handler.
+    bool ran = false;
+    auto q = fit::make_error_promise<int>(std::string("bad"))
+                 .and_then([&ran](int& value) { ran = true; });
+    EXPECT_TRUE(q(context).error() == "bad");
+    EXPECT_FALSE(ran);
+
+    // Void values invoke the handler without arguments.
+    auto r = fit::make_ok_promise().and_then([] { return fit::ok(3); });
+    EXPECT_EQ(3, r(context).value());
+
+    END_TEST;
+}
+
+bool or_else_combinator() {
+    BEGIN_TEST;
+
+    fake_context context;
+
+    auto p = fit::make_error_promise<int>(std::string("bad"))
+                 .or_else([](std::string& error) {
+                     return fit::ok(static_cast<int>(error.size()));
+                 });
+    EXPECT_EQ(3, p(context).value());
+
+    // Values skip the handler.
+    bool ran = false;
+    auto q = fit::make_ok_promise<int, std::string>(4)
+                 .or_else([&ran](std::string& error) -> fit::result<int, int> {
+                     ran = true;
+                     return fit::error(1);
+                 });
+    EXPECT_EQ(4, q(context).value());
+    EXPECT_FALSE(ran);
+
+    END_TEST;
+}
+
+bool inspect_and_discard_result() {
+    BEGIN_TEST;
+
+    fake_context context;
+
+    int seen = 0;
+    auto p = make_delayed_promise(1, 8)
+                 .inspect([&seen](fit::result<int, std::string>& result) {
+                     seen = result.value();
+                 })
+                 .discard_result();
+    EXPECT_TRUE(p(context).is_pending());
+    EXPECT_EQ(0, seen);
+    EXPECT_TRUE(p(context).is_ok());
+    EXPECT_EQ(8, seen);
+
+    END_TEST;
+}
+
+bool join_promises() {
+    BEGIN_TEST;
+
+    fake_context context;
+
+    auto p = fit::join_promises(make_delayed_promise(2, 1),
+                                fit::make_error_promise(std::string("bad")),
+                                make_delayed_promise(0, 3));
+    EXPECT_TRUE(p(context).is_pending());
+    EXPECT_TRUE(p(context).is_pending());
+    auto result = p(context);
+    ASSERT_TRUE(result.is_ok());
+    EXPECT_EQ(1, std::get<0>(result.value()).value());
+    EXPECT_TRUE(std::get<1>(result.value()).error() == "bad");
+    EXPECT_EQ(3, std::get<2>(result.value()).value());
+    EXPECT_FALSE(p);
+
+    END_TEST;
+}
+
+bool box_and_take_continuation() {
+    BEGIN_TEST;
+
+    fake_context context;
+
+    fit::promise<int> boxed =
+        fit::make_ok_promise(1)
+            .and_then([](int& value) { return fit::ok(value + 1); })
+            .box();
+    EXPECT_TRUE(boxed);
+    EXPECT_EQ(2, boxed(context).value());
+
+    auto p = fit::make_ok_promise(5);
+    auto continuation = p.take_continuation();
+    EXPECT_FALSE(p);
+    EXPECT_EQ(5, continuation(context).value());
+
+    END_TEST;
+}
+
+bool suspended_task_tickets() {
+    BEGIN_TEST;
+
+    fake_context context;
+    fit::suspended_task saved;
+
+    auto p = fit::make_promise([&](fit::context& ctx) -> fit::result<> {
+        if (context.resolver.resume_count() == 0) {
+            saved = ctx.suspend_task();
+            return fit::pending();
+        }
+        return fit::ok();
+    });
+    EXPECT_TRUE(p(context).is_pending());
+    EXPECT_TRUE(saved);
+    EXPECT_EQ(1u, context.resolver.outstanding_tickets());
+
+    fit::suspended_task copy(saved);
+    EXPECT_EQ(2u, context.resolver.outstanding_tickets());
+    copy.reset();
+    EXPECT_FALSE(copy);
+    EXPECT_EQ(1u, context.resolver.outstanding_tickets());
+    EXPECT_EQ(0u, context.resolver.resume_count());
+
+    saved.resume_task();
+    EXPECT_FALSE(saved);
+    EXPECT_EQ(0u, context.resolver.outstanding_tickets());
+    EXPECT_EQ(1u, context.resolver.resume_count());
+    EXPECT_TRUE(p(context).is_ok());
+
+    END_TEST;
+}
+
+bool pending_task() {
+    BEGIN_TEST;
+
+    fake_context context;
+
+    fit::pending_task empty;
+    EXPECT_FALSE(empty);
+
+    fit::pending_task task(make_delayed_promise(1, 0));
+    EXPECT_TRUE(task);
+    EXPECT_FALSE(task(context));
+    EXPECT_TRUE(task(context));
+    EXPECT_FALSE(task);
+
+    END_TEST;
+}
+
+} // namespace
+
+BEGIN_TEST_CASE(promise_tests)
+RUN_TEST(empty_promise)
+RUN_TEST(make_promise_handler_signatures)
+RUN_TEST(make_result_promises)
+RUN_TEST(pending_handler_is_invoked_again)
+RUN_TEST(then_combinator)
+RUN_TEST(and_then_combinator)
+RUN_TEST(or_else_combinator)
+RUN_TEST(inspect_and_discard_result)
+RUN_TEST(join_promises)
+RUN_TEST(box_and_take_continuation)
+RUN_TEST(suspended_task_tickets)
+RUN_TEST(pending_task)
+END_TEST_CASE(promise_tests)
@@ -0,0 +1,160 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+
+#include <lib/fit/result.h>
+#include <unittest/unittest.h>
+
+namespace {
+
+struct copyable {
+    int value;
+};
+
+struct move_only {
+    move_only(const move_only&) = delete;
+    move_only(move_only&&) = default;
+    move_only& operator=(const move_only&) = delete;
+    move_only& operator=(move_only&&) = default;
+
+    int value;
+};
+
+bool states() {
+    BEGIN_TEST;
+
+    fit::result<> good = fit::ok();
+    EXPECT_EQ(fit::result_state::ok, good.state());
+    EXPECT_TRUE(good);
+    EXPECT_TRUE(good.is_ok());
+    EXPECT_FALSE(good.is_error());
+    EXPECT_FALSE(good.is_pending());
+
+    fit::result<> bad = fit::error();
+    EXPECT_EQ(fit::result_state::error, bad.state());
+    EXPECT_TRUE(bad);
+    EXPECT_FALSE(bad.is_ok());
+    EXPECT_TRUE(bad.is_error());
+    EXPECT_FALSE(bad.is_pending());
+
+    fit::result<> pending = fit::pending();
+    EXPECT_EQ(fit::result_state::pending, pending.state());
+    EXPECT_FALSE(pending);
+    EXPECT_FALSE(pending.is_ok());
+    EXPECT_FALSE(pending.is_error());
+    EXPECT_TRUE(pending.is_pending());
+
+    fit::result<> default_init;
+    EXPECT_EQ(fit::result_state::pending, default_init.state());
+
+    END_TEST;
+}
+
+bool void_value_and_error() {
+    BEGIN_TEST;
+
+    fit::result<> good = fit::ok();
+    EXPECT_EQ(fit::result_state::ok, good.state());
+    fit::ok_result<> taken_ok = good.take_ok_result();
+    (void)taken_ok;
+    EXPECT_EQ(fit::result_state::pending, good.state());
+
+    fit::result<> bad = fit::error();
+    EXPECT_EQ(fit::result_state::error, bad.state());
+    fit::error_result<> taken_error = bad.take_error_result();
+    (void)taken_error;
+    EXPECT_EQ(fit::result_state::pending, bad.state());
+
+    END_TEST;
+}
+
+bool copyable_value() {
+    BEGIN_TEST;
+
+    fit::result<copyable> result = fit::ok<copyable>({42});
+    EXPECT_EQ(42, result.value().value);
+
+    fit::result<copyable> copy(result);
+    EXPECT_EQ(42, copy.value().value);
+    EXPECT_EQ(42, result.value().value);
+
+    copyable value = result.take_value();
+    EXPECT_EQ(42, value.value);
+    EXPECT_EQ(fit::result_state::pending, result.state());
+
+    END_TEST;
+}
+
+bool move_only_value_and_error() {
+    BEGIN_TEST;
+
+    fit::result<move_only, move_only> good = fit::ok<move_only>({42});
+    EXPECT_EQ(42, good.value().value);
+
+    fit::result<move_only, move_only> moved(std::move(good));
+    EXPECT_EQ(fit::result_state::pending, good.state());
+    EXPECT_EQ(42, moved.value().value);
+
+    fit::ok_result<move_only> taken_ok = moved.take_ok_result();
+    EXPECT_EQ(42, taken_ok.value.value);
+    EXPECT_EQ(fit::result_state::pending, moved.state());
+
+    fit::result<move_only, move_only> bad = fit::error<move_only>({55});
+    EXPECT_EQ(55, bad.error().value);
+
+    moved = std::move(bad);
+    EXPECT_EQ(fit::result_state::pending, bad.state());
+    EXPECT_EQ(55, moved.error().value);
+
+    move_only taken_error = moved.take_error();
+    EXPECT_EQ(55, taken_error.value);
+    EXPECT_EQ(fit::result_state::pending, moved.state());
+
+    END_TEST;
+}
+
+bool converting_constructors() {
+    BEGIN_TEST;
+
+    fit::result<std::string, std::string> good = fit::ok("hello");
+    EXPECT_TRUE(good.value() == "hello");
+
+    fit::result<std::string, std::string> bad = fit::error("oops");
+    EXPECT_TRUE(bad.error() == "oops");
+
+    fit::result<int64_t> widened = fit::ok(int32_t(-5));
+    EXPECT_EQ(-5, widened.value());
+
+    END_TEST;
+}
+
+bool swapping() {
+    BEGIN_TEST;
+
+    fit::result<int, char> a, b, c;
+    a = fit::ok(42);
+    b = fit::error('x');
+
+    a.swap(b);
+    EXPECT_EQ('x', a.error());
+    EXPECT_EQ(42, b.value());
+
+    swap(b, c);
+    EXPECT_EQ(42, c.value());
+    EXPECT_TRUE(b.is_pending());
+
+    END_TEST;
+}
+
+} // namespace
+
+BEGIN_TEST_CASE(result_tests)
+RUN_TEST(states)
+RUN_TEST(void_value_and_error)
+RUN_TEST(copyable_value)
+RUN_TEST(move_only_value_and_error)
+RUN_TEST(converting_constructors)
+RUN_TEST(swapping)
+END_TEST_CASE(result_tests)
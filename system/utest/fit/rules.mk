@@ -13,6 +13,8 @@ fit_tests := \
     $(LOCAL_DIR)/main.c \
     $(LOCAL_DIR)/nullable_tests.cpp \
     $(LOCAL_DIR)/optional_tests.cpp \
+    $(LOCAL_DIR)/promise_tests.cpp \
+    $(LOCAL_DIR)/result_tests.cpp \
     $(LOCAL_DIR)/variant_tests.cpp \
 
 # Userspace tests.
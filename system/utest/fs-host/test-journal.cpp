@@ -0,0 +1,161 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fbl/unique_fd.h>
+#include <fbl/unique_ptr.h>
+#include <lib/cksum.h>
+#include <minfs/bcache.h>
+#include <minfs/format.h>
+#include <minfs/fsck.h>
+#include <minfs/journal.h>
+
+#include "util.h"
+
+namespace {
+
+using minfs::blk_t;
+using minfs::kMinfsBlockSize;
+
+bool OpenDisk(fbl::unique_ptr<minfs::Bcache>* out, minfs::Superblock* info) {
+    BEGIN_HELPER;
+    fbl::unique_fd disk(open(MOUNT_PATH, O_RDWR));
+    ASSERT_TRUE(disk);
+    struct stat stats;
+    ASSERT_EQ(fstat(disk.get(), &stats), 0);
+    uint32_t blocks = static_cast<uint32_t>(stats.st_size / kMinfsBlockSize);
+    ASSERT_EQ(minfs::Bcache::Create(out, fbl::move(disk), blocks), ZX_OK);
+
+    uint8_t blk[kMinfsBlockSize];
+    ASSERT_EQ((*out)->Readblk(0, blk), ZX_OK);
+    memcpy(info, blk, sizeof(*info));
+    ASSERT_GE(info->jnl_block_count, minfs::kMinfsMinimumJournalBlocks);
+    END_HELPER;
+}
+
+// Writes an entry to |half| of the journal which fills |target| with |fill|.
+bool WriteEntry(minfs::Bcache* bc, const minfs::Superblock& info, blk_t half, uint64_t sequence,
+                blk_t target, uint8_t fill, bool complete) {
+    BEGIN_HELPER;
+    const blk_t start = info.jnl_block + half * (info.jnl_block_count / 2);
+    fbl::unique_ptr<minfs::JournalHeader> header(new minfs::JournalHeader());
+    header->magic = minfs::kMinfsJournalHeaderMagic;
+    header->sequence = sequence;
+    header->block_count = 1;
+    header->target[0] = target;
+    ASSERT_EQ(bc->Writeblk(start, header.get()), ZX_OK);
+
+    uint8_t blk[kMinfsBlockSize];
+    memset(blk, fill, sizeof(blk));
+    ASSERT_EQ(bc->Writeblk(start + 1, blk), ZX_OK);
+    uint32_t checksum = crc32(0, reinterpret_cast<const uint8_t*>(header.get()),
+                              kMinfsBlockSize);
+    checksum = crc32(checksum, blk, kMinfsBlockSize);
+
+    memset(blk, 0, sizeof(blk));
+    auto commit = reinterpret_cast<minfs::JournalCommit*>(blk);
+    commit->magic = minfs::kMinfsJournalCommitMagic;
+    commit->sequence = sequence;
+    // An entry whose commit block doesn't match was cut short.
+    commit->checksum = complete ? checksum : checksum + 1;
+    ASSERT_EQ(bc->Writeblk(start + 2, blk), ZX_OK);
+    END_HELPER;
+}
+
+bool CheckBlockFill(minfs::Bcache* bc, blk_t bno, uint8_t fill) {
+    BEGIN_HELPER;
+    uint8_t blk[kMinfsBlockSize];
+    uint8_t expected[kMinfsBlockSize];
+    memset(expected, fill, sizeof(expected));
+    ASSERT_EQ(bc->Readblk(bno, blk), ZX_OK);
+    ASSERT_EQ(memcmp(blk, expected, sizeof(blk)), 0);
+    END_HELPER;
+}
+
+bool TestJournalReplay() {
+    BEGIN_TEST;
+    fbl::unique_ptr<minfs::Bcache> bc;
+    minfs::Superblock info;
+    ASSERT_TRUE(OpenDisk(&bc, &info));
+
+    // The last data block is not in use.
+    const blk_t target = info.dat_block + info.block_count - 1;
+    ASSERT_TRUE(WriteEntry(bc.get(), info, 1, 7, target, 0xa5, true));
+
+    bool pending;
+    ASSERT_EQ(minfs::CheckJournal(bc.get(), &info, &pending), ZX_OK);
+    ASSERT_TRUE(pending);
+    ASSERT_EQ(minfs::ReplayJournal(bc.get(), &info), ZX_OK);
+    ASSERT_TRUE(CheckBlockFill(bc.get(), target, 0xa5));
+
+    // Replaying erases the journal.
+    ASSERT_EQ(minfs::CheckJournal(bc.get(), &info, &pending), ZX_OK);
+    ASSERT_FALSE(pending);
+    ASSERT_TRUE(CheckBlockFill(bc.get(), info.jnl_block, 0));
+
+    ASSERT_EQ(run_fsck(), 0);
+    END_TEST;
+}
+
+bool TestJournalReplayNewestComplete() {
+    BEGIN_TEST;
+    fbl::unique_ptr<minfs::Bcache> bc;
+    minfs::Superblock info;
+    ASSERT_TRUE(OpenDisk(&bc, &info));
+
+    const blk_t target = info.dat_block + info.block_count - 1;
+    ASSERT_TRUE(WriteEntry(bc.get(), info, 0, 3, target, 0x11, true));
+    ASSERT_TRUE(WriteEntry(bc.get(), info, 1, 4, target, 0x22, false));
+    ASSERT_EQ(minfs::ReplayJournal(bc.get(), &info), ZX_OK);
+    ASSERT_TRUE(CheckBlockFill(bc.get(), target, 0x11));
+
+    // An entry which was already written in place changes nothing.
+    ASSERT_TRUE(WriteEntry(bc.get(), info, 1, 5, target, 0x11, true));
+    bool pending;
+    ASSERT_EQ(minfs::CheckJournal(bc.get(), &info, &pending), ZX_OK);
+    ASSERT_FALSE(pending);
+    ASSERT_EQ(minfs::ReplayJournal(bc.get(), &info), ZX_OK);
+    ASSERT_TRUE(CheckBlockFill(bc.get(), target, 0x11));
+    END_TEST;
+}
+
+bool TestVersionWithoutJournal() {
+    BEGIN_TEST;
+    fbl::unique_ptr<minfs::Bcache> bc;
+    minfs::Superblock info;
+    ASSERT_TRUE(OpenDisk(&bc, &info));
+
+    // Make the volume look like one written before the journal existed.
+    uint8_t blk[kMinfsBlockSize];
+    ASSERT_EQ(bc->Readblk(0, blk), ZX_OK);
+    auto sb = reinterpret_cast<minfs::Superblock*>(blk);
+    sb->version = minfs::kMinfsVersionNoJournal;
+    sb->jnl_block = 0;
+    sb->jnl_block_count = 0;
+    ASSERT_EQ(bc->Writeblk(0, blk), ZX_OK);
+    memcpy(&info, blk, sizeof(info));
+
+    bool pending;
+    ASSERT_EQ(minfs::CheckJournal(bc.get(), &info, &pending), ZX_OK);
+    ASSERT_FALSE(pending);
+    ASSERT_EQ(minfs::CheckSuperblock(&info, bc.get()), ZX_OK);
+
+    // Such a volume can't claim to have a journal.
+    info.jnl_block = minfs::kMinfsJournalStart;
+    info.jnl_block_count = minfs::kMinfsMinimumJournalBlocks;
+    ASSERT_NE(minfs::CheckSuperblock(&info, bc.get()), ZX_OK);
+    END_TEST;
+}
+
+} // namespace
+
+RUN_MINFS_TESTS(journal_tests,
+    RUN_TEST_MEDIUM(TestJournalReplay)
+    RUN_TEST_MEDIUM(TestJournalReplayNewestComplete)
+    RUN_TEST_MEDIUM(TestVersionWithoutJournal)
+)
@@ -0,0 +1,121 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <fbl/ref_ptr.h>
+#include <fbl/string.h>
+#include <fs/synchronous-vfs.h>
+#include <fs/vfs.h>
+#include <fs/vnode.h>
+
+#include <unittest/unittest.h>
+
+namespace {
+
+// A directory holding at most one entry, which counts how often it is looked up.
+class CountingDir : public fs::Vnode {
+public:
+    void SetEntry(fbl::StringPiece name, fbl::RefPtr<fs::Vnode> vn) {
+        name_ = name;
+        entry_ = fbl::move(vn);
+    }
+
+    int lookups() const { return lookups_; }
+
+    zx_status_t Lookup(fbl::RefPtr<fs::Vnode>* out, fbl::StringPiece name) final {
+        lookups_++;
+        if (!entry_ || name_.ToStringPiece() != name) {
+            return ZX_ERR_NOT_FOUND;
+        }
+        *out = entry_;
+        return ZX_OK;
+    }
+
+    zx_status_t Unlink(fbl::StringPiece name, bool must_be_dir) final {
+        if (!entry_ || name_.ToStringPiece() != name) {
+            return ZX_ERR_NOT_FOUND;
+        }
+        entry_.reset();
+        return ZX_OK;
+    }
+
+private:
+    int lookups_ = 0;
+    fbl::String name_;
+    fbl::RefPtr<fs::Vnode> entry_;
+};
+
+bool Open(fs::Vfs* vfs, fbl::RefPtr<fs::Vnode> root, fbl::StringPiece path,
+          zx_status_t expected) {
+    BEGIN_HELPER;
+    fbl::RefPtr<fs::Vnode> vn;
+    fbl::StringPiece remaining;
+    EXPECT_EQ(expected, vfs->Open(fbl::move(root), &vn, path, &remaining,
+                                  ZX_FS_FLAG_VNODE_REF_ONLY, 0));
+    END_HELPER;
+}
+
+bool TestNameCacheHits() {
+    BEGIN_TEST;
+
+    auto root = fbl::AdoptRef(new CountingDir());
+    auto a = fbl::AdoptRef(new CountingDir());
+    auto b = fbl::AdoptRef(new CountingDir());
+    auto c = fbl::AdoptRef(new CountingDir());
+    root->SetEntry("a", a);
+    a->SetEntry("b", b);
+    b->SetEntry("c", c);
+
+    fs::SynchronousVfs vfs;
+    ASSERT_EQ(ZX_OK, vfs.SetNameCacheCapacity(16));
+    ASSERT_TRUE(Open(&vfs, root, "a/b/c", ZX_OK));
+    ASSERT_TRUE(Open(&vfs, root, "a/b/c", ZX_OK));
+
+    // The directories walked through are only looked up once; the final
+    // component is looked up each time.
+    EXPECT_EQ(1, root->lookups());
+    EXPECT_EQ(1, a->lookups());
+    EXPECT_EQ(2, b->lookups());
+    fs::Vfs::NameCacheStats stats = vfs.GetNameCacheStats();
+    EXPECT_EQ(2u, stats.hits);
+    EXPECT_EQ(2u, stats.misses);
+
+    // Without the cache, every directory is looked up again.
+    ASSERT_EQ(ZX_OK, vfs.SetNameCacheCapacity(0));
+    ASSERT_TRUE(Open(&vfs, root, "a/b/c", ZX_OK));
+    EXPECT_EQ(2, root->lookups());
+    EXPECT_EQ(2, a->lookups());
+
+    END_TEST;
+}
+
+bool TestNameCacheUnlink() {
+    BEGIN_TEST;
+
+    auto root = fbl::AdoptRef(new CountingDir());
+    auto a = fbl::AdoptRef(new CountingDir());
+    auto b = fbl::AdoptRef(new CountingDir());
+    root->SetEntry("a", a);
+    a->SetEntry("b", b);
+
+    fs::SynchronousVfs vfs;
+    ASSERT_EQ(ZX_OK, vfs.SetNameCacheCapacity(16));
+    ASSERT_TRUE(Open(&vfs, root, "a/b/c", ZX_ERR_NOT_FOUND));
+    EXPECT_EQ(1, a->lookups());
+
+    // Unlinking "b" forgets it, so walking through it fails.
+    ASSERT_EQ(ZX_OK, vfs.Unlink(a, "b"));
+    ASSERT_TRUE(Open(&vfs, root, "a/b/c", ZX_ERR_NOT_FOUND));
+    EXPECT_EQ(2, a->lookups());
+    EXPECT_EQ(1, root->lookups());
+
+    ASSERT_EQ(ZX_OK, vfs.SetNameCacheCapacity(0));
+    END_TEST;
+}
+
+} // namespace
+
+BEGIN_TEST_CASE(name_cache_tests)
+RUN_TEST(TestNameCacheHits)
+RUN_TEST(TestNameCacheUnlink)
+END_TEST_CASE(name_cache_tests)
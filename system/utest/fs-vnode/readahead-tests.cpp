@@ -0,0 +1,51 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <fs/readahead.h>
+
+#include <unittest/unittest.h>
+
+namespace {
+
+bool TestReadaheadSequential() {
+    BEGIN_TEST;
+
+    fs::Readahead readahead(2, 8);
+    // The window doubles with each read which follows the last, up to its
+    // limit.
+    EXPECT_EQ(3u, readahead.Advance(0, 1));
+    EXPECT_EQ(5u, readahead.Advance(3, 1));
+    EXPECT_EQ(9u, readahead.Advance(8, 1));
+    EXPECT_EQ(9u, readahead.Advance(17, 1));
+    EXPECT_EQ(8u, readahead.window());
+
+    END_TEST;
+}
+
+bool TestReadaheadRandom() {
+    BEGIN_TEST;
+
+    fs::Readahead readahead(2, 8, 10);
+    // Reads which don't start where the stream does aren't read ahead of.
+    EXPECT_EQ(1u, readahead.Advance(0, 1));
+    EXPECT_EQ(1u, readahead.Advance(5, 1));
+    EXPECT_EQ(0u, readahead.window());
+
+    // A stream can start over from wherever the last read ended.
+    EXPECT_EQ(3u, readahead.Advance(6, 1));
+    EXPECT_EQ(5u, readahead.Advance(9, 1));
+    EXPECT_EQ(1u, readahead.Advance(0, 1));
+
+    readahead.Reset();
+    EXPECT_EQ(3u, readahead.Advance(10, 1));
+
+    END_TEST;
+}
+
+} // namespace
+
+BEGIN_TEST_CASE(readahead_tests)
+RUN_TEST(TestReadaheadSequential)
+RUN_TEST(TestReadaheadRandom)
+END_TEST_CASE(readahead_tests)
@@ -10,8 +10,10 @@ MODULE_TYPE := usertest
 
 MODULE_SRCS += \
     $(LOCAL_DIR)/lazy-dir-tests.cpp \
+    $(LOCAL_DIR)/name-cache-tests.cpp \
     $(LOCAL_DIR)/pseudo-dir-tests.cpp \
     $(LOCAL_DIR)/pseudo-file-tests.cpp \
+    $(LOCAL_DIR)/readahead-tests.cpp \
     $(LOCAL_DIR)/remote-dir-tests.cpp \
     $(LOCAL_DIR)/service-tests.cpp \
     $(LOCAL_DIR)/teardown-tests.cpp \
@@ -2,6 +2,8 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <string.h>
+
 #include <fs/managed-vfs.h>
 #include <fs/synchronous-vfs.h>
 #include <fs/vnode.h>
@@ -94,6 +96,48 @@ bool send_sync(const zx::channel& client) {
     END_HELPER;
 }
 
+bool send_getattr(const zx::channel& client) {
+    BEGIN_HELPER;
+    fuchsia_io_NodeGetAttrRequest request;
+    request.hdr.txid = 6;
+    request.hdr.ordinal = fuchsia_io_NodeGetAttrOrdinal;
+    ASSERT_EQ(client.write(0, &request, sizeof(request), nullptr, 0), ZX_OK);
+    END_HELPER;
+}
+
+bool wait_getattr(const zx::channel& client, zx::duration timeout) {
+    BEGIN_HELPER;
+    ASSERT_EQ(client.wait_one(ZX_CHANNEL_READABLE, zx::deadline_after(timeout), nullptr),
+              ZX_OK);
+    fuchsia_io_NodeGetAttrResponse response;
+    uint32_t actual;
+    ASSERT_EQ(client.read(0, &response, sizeof(response), &actual, nullptr, 0, nullptr), ZX_OK);
+    ASSERT_EQ(actual, sizeof(response));
+    ASSERT_EQ(response.s, ZX_OK);
+    END_HELPER;
+}
+
+// A Vnode whose Getattr blocks the dispatcher thread handling it until
+// |release| is signalled.
+class BlockingGetattrVnode : public FdCountVnode {
+public:
+    BlockingGetattrVnode(sync_completion_t* started, sync_completion_t* release) :
+        started_(started), release_(release) {}
+
+    zx_status_t Getattr(vnattr_t* a) final {
+        memset(a, 0, sizeof(*a));
+        if (started_ != nullptr) {
+            sync_completion_signal(started_);
+            sync_completion_wait(release_, ZX_TIME_INFINITE);
+        }
+        return ZX_OK;
+    }
+
+private:
+    sync_completion_t* started_;
+    sync_completion_t* release_;
+};
+
 // Helper function which creates a VFS with a served Vnode,
 // starts a sync request, and then closes the connection to the client
 // in the middle of the async callback.
@@ -337,6 +381,52 @@ bool TestSynchronousTeardown() {
     END_TEST;
 }
 
+// Test that a connection is served while another connection of the same
+// VFS is blocked on a different dispatcher thread.
+bool TestConcurrentConnections() {
+    BEGIN_TEST;
+
+    async::Loop loop(&kAsyncLoopConfigNoAttachToThread);
+    auto vfs = fbl::make_unique<fs::ManagedVfs>(loop.dispatcher());
+    ASSERT_EQ(loop.StartThread(), ZX_OK);
+    ASSERT_EQ(loop.StartThread(), ZX_OK);
+
+    sync_completion_t started;
+    sync_completion_t release;
+    auto blocking = fbl::AdoptRef(new BlockingGetattrVnode(&started, &release));
+    auto quick = fbl::AdoptRef(new BlockingGetattrVnode(nullptr, nullptr));
+    zx::channel client, server, client2, server2;
+    ASSERT_EQ(zx::channel::create(0, &client, &server), ZX_OK);
+    ASSERT_EQ(zx::channel::create(0, &client2, &server2), ZX_OK);
+    ASSERT_EQ(blocking->Open(0, nullptr), ZX_OK);
+    ASSERT_EQ(blocking->Serve(vfs.get(), fbl::move(server), 0), ZX_OK);
+    ASSERT_EQ(quick->Open(0, nullptr), ZX_OK);
+    ASSERT_EQ(quick->Serve(vfs.get(), fbl::move(server2), 0), ZX_OK);
+    blocking = nullptr;
+    quick = nullptr;
+
+    // Block one dispatcher thread in the first connection.
+    ASSERT_TRUE(send_getattr(client));
+    ASSERT_EQ(sync_completion_wait(&started, ZX_SEC(3)), ZX_OK);
+
+    // The second connection is still answered.
+    ASSERT_TRUE(send_getattr(client2));
+    ASSERT_TRUE(wait_getattr(client2, zx::sec(3)));
+
+    sync_completion_signal(&release);
+    ASSERT_TRUE(wait_getattr(client, zx::sec(3)));
+
+    sync_completion_t shutdown_done;
+    vfs->Shutdown([&shutdown_done](zx_status_t status) {
+        ZX_ASSERT(status == ZX_OK);
+        sync_completion_signal(&shutdown_done);
+    });
+    ASSERT_EQ(sync_completion_wait(&shutdown_done, ZX_SEC(3)), ZX_OK);
+    vfs = nullptr;
+
+    END_TEST;
+}
+
 } // namespace
 
 BEGIN_TEST_CASE(teardown_tests)
@@ -346,4 +436,5 @@ RUN_TEST(TestTeardownDeleteThis)
 RUN_TEST(TestTeardownSlowAsyncCallback)
 RUN_TEST(TestTeardownSlowClone)
 RUN_TEST(TestSynchronousTeardown)
+RUN_TEST(TestConcurrentConnections)
 END_TEST_CASE(teardown_tests)
@@ -2,6 +2,7 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <errno.h>
 #include <fcntl.h>
 #include <math.h>
 #include <stdint.h>
@@ -89,6 +90,40 @@ bool test_blksize(void) {
     END_TEST;
 }
 
+bool test_stat(void) {
+    BEGIN_TEST;
+
+    struct stat buf;
+    ASSERT_EQ(stat("::missing", &buf), -1, "");
+    ASSERT_EQ(errno, ENOENT, "");
+    ASSERT_EQ(stat("::missing/child", &buf), -1, "");
+    ASSERT_EQ(errno, ENOENT, "");
+
+    int fd = open("::file.txt", O_CREAT | O_RDWR, 0644);
+    ASSERT_GT(fd, 0, "");
+    ASSERT_EQ(stat("::file.txt", &buf), 0, "");
+    ASSERT_TRUE(S_ISREG(buf.st_mode), "");
+    ASSERT_EQ(buf.st_size, 0, "");
+
+    // Each stat sees the file as it is now.
+    char data[] = "hello";
+    ASSERT_EQ(write(fd, data, sizeof(data)), (ssize_t)sizeof(data), "");
+    struct stat fbuf;
+    ASSERT_EQ(fstat(fd, &fbuf), 0, "");
+    ASSERT_EQ(stat("::file.txt", &buf), 0, "");
+    ASSERT_EQ(buf.st_size, (off_t)sizeof(data), "");
+    ASSERT_EQ(buf.st_ino, fbuf.st_ino, "");
+    ASSERT_EQ(close(fd), 0, "");
+
+    ASSERT_EQ(stat("::file.txt/child", &buf), -1, "");
+    ASSERT_EQ(stat("::", &buf), 0, "");
+    ASSERT_TRUE(S_ISDIR(buf.st_mode), "");
+
+    ASSERT_EQ(unlink("::file.txt"), 0, "");
+
+    END_TEST;
+}
+
 bool test_parent_directory_time(void) {
     BEGIN_TEST;
 
@@ -168,5 +203,6 @@ bool test_parent_directory_time(void) {
 RUN_FOR_ALL_FILESYSTEMS(attr_tests,
     RUN_TEST_MEDIUM(test_attr)
     RUN_TEST_MEDIUM(test_blksize)
+    RUN_TEST_MEDIUM(test_stat)
     RUN_TEST_MEDIUM(test_parent_directory_time)
 )
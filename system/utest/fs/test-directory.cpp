@@ -80,6 +80,71 @@ bool TestDirectoryLarge(void) {
     END_TEST;
 }
 
+// Looks up, replaces, and renames entries in a directory large enough that
+// filesystems may index its names rather than searching it linearly.
+bool TestDirectoryManyLookups(void) {
+    BEGIN_TEST;
+
+    ASSERT_EQ(mkdir("::many", 0755), 0);
+    const int num_files = 512;
+    char path[PATH_MAX];
+    char other[PATH_MAX];
+    for (int i = 0; i < num_files; i++) {
+        snprintf(path, sizeof(path), "::many/file%d", i);
+        int fd = open(path, O_RDWR | O_CREAT | O_EXCL, 0644);
+        ASSERT_GT(fd, 0);
+        ASSERT_EQ(close(fd), 0);
+    }
+
+    // Free every third entry, then fill the holes with differently named ones.
+    for (int i = 0; i < num_files; i += 3) {
+        snprintf(path, sizeof(path), "::many/file%d", i);
+        ASSERT_EQ(unlink(path), 0);
+    }
+    for (int i = 0; i < num_files; i += 3) {
+        snprintf(path, sizeof(path), "::many/replacement%d", i);
+        int fd = open(path, O_RDWR | O_CREAT | O_EXCL, 0644);
+        ASSERT_GT(fd, 0);
+        ASSERT_EQ(close(fd), 0);
+    }
+
+    // Rename a few entries in place.
+    for (int i = 1; i < num_files; i += 7) {
+        snprintf(path, sizeof(path), "::many/file%d", i);
+        snprintf(other, sizeof(other), "::many/renamed%d", i);
+        if (i % 3 != 0) {
+            ASSERT_EQ(rename(path, other), 0);
+        }
+    }
+
+    struct stat s;
+    for (int i = 0; i < num_files; i++) {
+        bool unlinked = i % 3 == 0;
+        bool renamed = !unlinked && i % 7 == 1;
+        snprintf(path, sizeof(path), "::many/file%d", i);
+        ASSERT_EQ(stat(path, &s), (unlinked || renamed) ? -1 : 0);
+        snprintf(path, sizeof(path), "::many/replacement%d", i);
+        ASSERT_EQ(stat(path, &s), unlinked ? 0 : -1);
+        snprintf(path, sizeof(path), "::many/renamed%d", i);
+        ASSERT_EQ(stat(path, &s), renamed ? 0 : -1);
+    }
+
+    // A name that was never created is not found, and can't be unlinked.
+    ASSERT_EQ(stat("::many/missing", &s), -1);
+    ASSERT_EQ(unlink("::many/missing"), -1);
+
+    for (int i = 0; i < num_files; i++) {
+        bool unlinked = i % 3 == 0;
+        bool renamed = !unlinked && i % 7 == 1;
+        snprintf(path, sizeof(path), "::many/%s%d",
+                 unlinked ? "replacement" : (renamed ? "renamed" : "file"), i);
+        ASSERT_EQ(unlink(path), 0);
+    }
+    ASSERT_EQ(rmdir("::many"), 0);
+
+    END_TEST;
+}
+
 bool TestDirectoryMax(void) {
     BEGIN_TEST;
 
@@ -463,6 +528,7 @@ RUN_FOR_ALL_FILESYSTEMS(directory_tests,
     RUN_TEST_MEDIUM(TestDirectoryCoalesceLargeRecord)
     RUN_TEST_MEDIUM(TestDirectoryFilenameMax)
     RUN_TEST_LARGE(TestDirectoryLarge)
+    RUN_TEST_LARGE(TestDirectoryManyLookups)
     RUN_TEST_MEDIUM(TestDirectoryTrailingSlash)
     RUN_TEST_MEDIUM(TestDirectoryReaddir)
     RUN_TEST_LARGE(TestDirectoryReaddirRmAll)
@@ -172,6 +172,81 @@ bool TestPersistWithData(void) {
     END_TEST;
 }
 
+// Writes files through many small appends, interleaved between files and broken up by
+// overwrites and holes, so that data with no blocks of its own yet must reach the disk.
+bool TestPersistSmallAppends(void) {
+    BEGIN_TEST;
+
+    if (!test_info->can_be_mounted) {
+        fprintf(stderr, "Filesystem cannot be mounted; cannot test persistence\n");
+        return true;
+    }
+
+    const char* const files[] = {
+        "::appended",
+        "::appended-with-holes",
+    };
+    constexpr size_t kChunk = 100;
+    constexpr size_t kChunks = 300;
+    constexpr off_t kHoleStart = 20000;
+    constexpr off_t kHoleEnd = 200000;
+    const size_t kSizes[] = {
+        kChunk * kChunks,
+        kHoleEnd + kChunk * kChunks - kHoleStart,
+    };
+
+    int fds[fbl::count_of(files)];
+    for (size_t i = 0; i < fbl::count_of(files); i++) {
+        fds[i] = open(files[i], O_RDWR | O_CREAT | O_EXCL, 0644);
+        ASSERT_GT(fds[i], 0);
+    }
+    uint8_t buf[kChunk];
+    for (size_t c = 0; c < kChunks; c++) {
+        for (size_t i = 0; i < fbl::count_of(files); i++) {
+            if (i == 1 && lseek(fds[i], 0, SEEK_CUR) == kHoleStart) {
+                ASSERT_EQ(lseek(fds[i], kHoleEnd, SEEK_SET), kHoleEnd);
+            }
+            memset(buf, static_cast<int>(c + i), sizeof(buf));
+            ASSERT_EQ(write(fds[i], buf, sizeof(buf)), sizeof(buf));
+        }
+    }
+    // Rewrite the start of the first file once its later blocks exist.
+    memset(buf, 0xff, sizeof(buf));
+    ASSERT_EQ(pwrite(fds[0], buf, sizeof(buf), 0), sizeof(buf));
+    for (size_t i = 0; i < fbl::count_of(files); i++) {
+        ASSERT_EQ(close(fds[i]), 0);
+    }
+
+    ASSERT_TRUE(check_remount(), "Could not remount filesystem");
+
+    for (size_t i = 0; i < fbl::count_of(files); i++) {
+        int fd = open(files[i], O_RDONLY, 0644);
+        ASSERT_GT(fd, 0);
+        struct stat st;
+        ASSERT_EQ(fstat(fd, &st), 0);
+        ASSERT_EQ(st.st_size, static_cast<off_t>(kSizes[i]));
+
+        size_t c = 0;
+        for (off_t off = 0; off < static_cast<off_t>(kSizes[i]); off += kChunk) {
+            ASSERT_EQ(read(fd, buf, sizeof(buf)), sizeof(buf));
+            uint8_t expected = 0;
+            if (i != 1 || off < kHoleStart || off >= kHoleEnd) {
+                expected = static_cast<uint8_t>(c++ + i);
+            }
+            if (i == 0 && off == 0) {
+                expected = 0xff;
+            }
+            for (size_t j = 0; j < sizeof(buf); j++) {
+                ASSERT_EQ(buf[j], expected);
+            }
+        }
+        ASSERT_EQ(close(fd), 0);
+        ASSERT_EQ(unlink(files[i]), 0);
+    }
+
+    END_TEST;
+}
+
 constexpr size_t kMaxLoopLength = 26;
 
 template <bool MoveDirectory, size_t LoopLength, size_t Moves>
@@ -268,6 +343,7 @@ RUN_FOR_ALL_FILESYSTEMS(persistence_tests,
     RUN_TEST_LARGE((TestPersistWithData<8192>))
     RUN_TEST_LARGE((TestPersistWithData<8192 + 1>))
     RUN_TEST_LARGE((TestPersistWithData<8192 * 128>))
+    RUN_TEST_MEDIUM(TestPersistSmallAppends)
     RUN_TEST_MEDIUM((TestRenameLoop<false, 2, 2>));
     RUN_TEST_LARGE((TestRenameLoop<false, 2, 100>));
     RUN_TEST_LARGE((TestRenameLoop<false, 15, 100>));
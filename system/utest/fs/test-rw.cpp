@@ -112,9 +112,56 @@ bool TestOffsetOperations(void) {
     END_TEST;
 }
 
+// Test that reads and writes large enough to be moved through a VMO
+// transfer the same bytes, and move the seek pointer the same way, as
+// smaller ones.
+bool TestLargeOperations(void) {
+    BEGIN_TEST;
+
+    srand(0xDEADBEEF);
+
+    constexpr size_t kBufferSize = 1 << 18;
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<uint8_t[]> expected(new (&ac) uint8_t[kBufferSize]);
+    ASSERT_TRUE(ac.check());
+    fbl::unique_ptr<uint8_t[]> buf(new (&ac) uint8_t[kBufferSize]);
+    ASSERT_TRUE(ac.check());
+    for (size_t i = 0; i < kBufferSize; i++) {
+        expected[i] = static_cast<uint8_t>(rand());
+    }
+
+    const char* filename = "::large_ops";
+    fbl::unique_fd fd(open(filename, O_RDWR | O_CREAT, 0644));
+    ASSERT_TRUE(fd);
+
+    ASSERT_EQ(write(fd.get(), expected.get(), kBufferSize), kBufferSize);
+    ASSERT_EQ(lseek(fd.get(), 0, SEEK_CUR), kBufferSize);
+    ASSERT_EQ(pwrite(fd.get(), expected.get(), kBufferSize, kBufferSize), kBufferSize);
+    ASSERT_EQ(lseek(fd.get(), 0, SEEK_CUR), kBufferSize);
+
+    // Reads stop at the end of the file.
+    ASSERT_EQ(lseek(fd.get(), 1, SEEK_SET), 1);
+    ASSERT_EQ(read(fd.get(), buf.get(), kBufferSize), kBufferSize);
+    ASSERT_EQ(memcmp(buf.get(), expected.get() + 1, kBufferSize - 1), 0);
+    ASSERT_EQ(buf[kBufferSize - 1], expected[0]);
+    ASSERT_EQ(pread(fd.get(), buf.get(), kBufferSize, kBufferSize + 1), kBufferSize - 1);
+    ASSERT_EQ(memcmp(buf.get(), expected.get() + 1, kBufferSize - 1), 0);
+    ASSERT_EQ(lseek(fd.get(), 0, SEEK_CUR), kBufferSize + 1);
+
+    struct stat st;
+    ASSERT_EQ(fstat(fd.get(), &st), 0);
+    ASSERT_EQ(st.st_size, static_cast<ssize_t>(2 * kBufferSize));
+
+    ASSERT_EQ(close(fd.release()), 0);
+    ASSERT_EQ(unlink(filename), 0);
+
+    END_TEST;
+}
+
 }  // namespace
 
 RUN_FOR_ALL_FILESYSTEMS(rw_tests,
     RUN_TEST_MEDIUM(TestZeroLengthOperations)
     RUN_TEST_MEDIUM(TestOffsetOperations)
+    RUN_TEST_MEDIUM(TestLargeOperations)
 )
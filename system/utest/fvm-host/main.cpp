@@ -41,6 +41,7 @@ typedef enum {
     SPARSE,         // Sparse container
     SPARSE_LZ4,     // Sparse container compressed with LZ4
     SPARSE_ZXCRYPT, // Sparse,container to be stored on a zxcrypt volume
+    SPARSE_CHUNKED, // Sparse container compressed in independent chunks
     FVM,            // Explicitly created FVM container
     FVM_NEW,        // FVM container created on FvmContainer::Create
     FVM_OFFSET,     // FVM container created at an offset within a file
@@ -156,9 +157,12 @@ bool AddPartitions(Container* container) {
     END_HELPER;
 }
 
+// Sparse containers with these flags are compressed, and stored at |sparse_lz4_path|.
+constexpr uint32_t kCompressedFlags = fvm::kSparseFlagLz4 | fvm::kSparseFlagChunked;
+
 bool CreateSparse(uint32_t flags, size_t slice_size) {
     BEGIN_HELPER;
-    const char* path = ((flags & fvm::kSparseFlagLz4) != 0) ? sparse_lz4_path : sparse_path;
+    const char* path = ((flags & kCompressedFlags) != 0) ? sparse_lz4_path : sparse_path;
     unittest_printf("Creating sparse container: %s\n", path);
     fbl::unique_ptr<SparseContainer> sparseContainer;
     ASSERT_EQ(SparseContainer::Create(path, slice_size, flags, &sparseContainer), ZX_OK,
@@ -189,7 +193,7 @@ bool ReportContainer(const char* path, off_t offset) {
 }
 
 bool ReportSparse(uint32_t flags) {
-    if ((flags & fvm::kSparseFlagLz4) != 0) {
+    if ((flags & kCompressedFlags) != 0) {
         unittest_printf("Decompressing sparse file\n");
         if (fvm::decompress_sparse(sparse_lz4_path, sparse_path) != ZX_OK) {
             return false;
@@ -364,7 +368,7 @@ bool PopulatePartitions(size_t ndirs, size_t nfiles, size_t max_size) {
 
 bool DestroySparse(uint32_t flags) {
     BEGIN_HELPER;
-    if ((flags & fvm::kSparseFlagLz4) != 0) {
+    if ((flags & kCompressedFlags) != 0) {
         unittest_printf("Destroying compressed sparse container: %s\n", sparse_lz4_path);
         ASSERT_EQ(unlink(sparse_lz4_path), 0, "Failed to unlink path");
     } else {
@@ -442,6 +446,12 @@ bool CreateReportDestroy(container_t type, size_t slice_size) {
         ASSERT_TRUE(DestroySparse(fvm::kSparseFlagZxcrypt));
         break;
     }
+    case SPARSE_CHUNKED: {
+        ASSERT_TRUE(CreateSparse(fvm::kSparseFlagChunked, slice_size));
+        ASSERT_TRUE(ReportSparse(fvm::kSparseFlagChunked));
+        ASSERT_TRUE(DestroySparse(fvm::kSparseFlagChunked));
+        break;
+    }
     case FVM: {
         ASSERT_TRUE(CreateFvm(true, 0, slice_size));
         ASSERT_TRUE(ReportFvm(0));
@@ -616,6 +626,7 @@ bool Cleanup() {
     RUN_TEST_MEDIUM((TestEmptyPartitions<SPARSE, slice_size>)) \
     RUN_TEST_MEDIUM((TestEmptyPartitions<SPARSE_LZ4, slice_size>)) \
     RUN_TEST_MEDIUM((TestEmptyPartitions<SPARSE_ZXCRYPT, slice_size>)) \
+    RUN_TEST_MEDIUM((TestEmptyPartitions<SPARSE_CHUNKED, slice_size>)) \
     RUN_TEST_MEDIUM((TestEmptyPartitions<FVM, slice_size>)) \
     RUN_TEST_MEDIUM((TestEmptyPartitions<FVM_NEW, slice_size>)) \
     RUN_TEST_MEDIUM((TestEmptyPartitions<FVM_OFFSET, slice_size>))
@@ -624,6 +635,7 @@ bool Cleanup() {
     RUN_TEST_MEDIUM((TestPartitions<SPARSE, num_dirs, num_files, max_size, slice_size>)) \
     RUN_TEST_MEDIUM((TestPartitions<SPARSE_LZ4, num_dirs, num_files, max_size, slice_size>)) \
     RUN_TEST_MEDIUM((TestPartitions<SPARSE_ZXCRYPT, num_dirs, num_files, max_size, slice_size>)) \
+    RUN_TEST_MEDIUM((TestPartitions<SPARSE_CHUNKED, num_dirs, num_files, max_size, slice_size>)) \
     RUN_TEST_MEDIUM((TestPartitions<FVM, num_dirs, num_files, max_size, slice_size>)) \
     RUN_TEST_MEDIUM((TestPartitions<FVM_NEW, num_dirs, num_files, max_size, slice_size>)) \
     RUN_TEST_MEDIUM((TestPartitions<FVM_OFFSET, num_dirs, num_files, max_size, slice_size>))
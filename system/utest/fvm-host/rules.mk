@@ -51,5 +51,6 @@ MODULE_HOST_LIBS := \
     system/ulib/fs.hostlib \
     system/ulib/digest.hostlib \
     system/uapp/blobfs.hostlib \
+    third_party/ulib/cksum.hostlib \
 
 include make/module.mk
@@ -1486,6 +1486,12 @@ bool TestSliceAccessContiguous() {
                                   info.block_size * 2));
     }
 
+    // The physical slices are contiguous, so nothing was split.
+    fvm_split_stats_t stats;
+    ASSERT_EQ(ioctl_block_fvm_get_split_stats(vp_fd, &stats), sizeof(stats));
+    ASSERT_GT(stats.total_ops, 0);
+    ASSERT_EQ(stats.split_ops, 0);
+
     ASSERT_EQ(close(vp_fd), 0);
     ASSERT_EQ(close(fd), 0);
     ASSERT_TRUE(FVMCheckSliceSize(fvm_driver, 64lu * (1 << 20)));
@@ -1714,6 +1720,14 @@ bool TestSliceAccessNonContiguousPhysical() {
                 }
             }
         }
+
+        // Every op which crossed slices was split, one op per slice, and
+        // none of them needed more than the pool.
+        fvm_split_stats_t stats;
+        ASSERT_EQ(ioctl_block_fvm_get_split_stats(vparts[i].fd, &stats), sizeof(stats));
+        ASSERT_GT(stats.split_ops, 0);
+        ASSERT_GE(stats.split_txns, 2 * stats.split_ops);
+        ASSERT_EQ(stats.pool_misses, 0);
         ASSERT_EQ(close(vparts[i].fd), 0);
     }
 
@@ -2524,6 +2538,85 @@ bool TestCorruptionRegression() {
     END_TEST;
 }
 
+// Each metadata update only writes the blocks which changed since that copy
+// was last written; the older copy must still be whole.
+bool TestCorruptionRegressionIncremental() {
+    BEGIN_TEST;
+    char ramdisk_path[PATH_MAX];
+    char fvm_driver[PATH_MAX];
+    ASSERT_EQ(StartFVMTest(512, 1 << 20, 64lu * (1 << 20), ramdisk_path, fvm_driver), 0, "error mounting FVM");
+    int ramdisk_fd = open(ramdisk_path, O_RDWR);
+    ASSERT_GT(ramdisk_fd, 0);
+
+    int fd = open(fvm_driver, O_RDWR);
+    ASSERT_GT(fd, 0);
+    fvm_info_t fvm_info;
+    ASSERT_GT(ioctl_block_fvm_query(fd, &fvm_info), 0);
+    size_t slice_size = fvm_info.slice_size;
+
+    // Allocate one VPart (writes to backup)
+    alloc_req_t request;
+    memset(&request, 0, sizeof(request));
+    request.slice_count = 1;
+    memcpy(request.guid, kTestUniqueGUID, GUID_LEN);
+    strcpy(request.name, kTestPartName1);
+    memcpy(request.type, kTestPartGUIDData, GUID_LEN);
+    int vp_fd = fvm_allocate_partition(fd, &request);
+    ASSERT_GT(vp_fd, 0);
+
+    // Extend the vpart three times, writing to the primary, backup, and
+    // primary again.
+    extend_request_t erequest;
+    for (size_t i = 1; i <= 3; i++) {
+        erequest.offset = i;
+        erequest.length = 1;
+        ASSERT_EQ(ioctl_block_fvm_extend(vp_fd, &erequest), 0);
+    }
+    block_info_t info;
+    ASSERT_GE(ioctl_block_get_info(vp_fd, &info), 0);
+    ASSERT_EQ(info.block_count * info.block_size, slice_size * 4);
+    size_t blocks_per_slice = slice_size / info.block_size;
+    for (size_t i = 0; i < 4; i++) {
+        ASSERT_TRUE(CheckWriteReadBlock(vp_fd, i * blocks_per_slice, 1));
+    }
+
+    ASSERT_EQ(close(vp_fd), 0);
+
+    // Corrupt the (primary) metadata and rebind.
+    // The backup, written by the second extension, will be used.
+    off_t off = 0;
+    uint8_t buf[FVM_BLOCK_SIZE];
+    ASSERT_EQ(lseek(ramdisk_fd, off, SEEK_SET), off);
+    ASSERT_EQ(read(ramdisk_fd, buf, sizeof(buf)), sizeof(buf));
+    buf[128]++;
+    ASSERT_EQ(lseek(ramdisk_fd, off, SEEK_SET), off);
+    ASSERT_EQ(write(ramdisk_fd, buf, sizeof(buf)), sizeof(buf));
+
+    const partition_entry_t entries[] = {
+        {kTestPartName1, 1},
+    };
+    fd = FVMRebind(fd, ramdisk_path, entries, 1);
+    ASSERT_GT(fd, 0, "Failed to rebind FVM driver");
+    vp_fd = open_partition(kTestUniqueGUID, kTestPartGUIDData, 0, nullptr);
+    ASSERT_GT(vp_fd, 0);
+
+    // Only the last extension is lost.
+    ASSERT_GE(ioctl_block_get_info(vp_fd, &info), 0);
+    ASSERT_EQ(info.block_count * info.block_size, slice_size * 3);
+    for (size_t i = 0; i < 3; i++) {
+        ASSERT_TRUE(CheckWriteReadBlock(vp_fd, i * blocks_per_slice, 1));
+    }
+    ASSERT_TRUE(CheckNoAccessBlock(vp_fd, 3 * blocks_per_slice, 1));
+
+    // Clean up
+    ASSERT_EQ(close(vp_fd), 0);
+    ASSERT_EQ(close(fd), 0);
+    ASSERT_EQ(close(ramdisk_fd), 0);
+    ASSERT_TRUE(FVMCheckSliceSize(fvm_driver, 64lu * (1 << 20)));
+    ASSERT_EQ(EndFVMTest(ramdisk_path), 0, "unmounting FVM");
+    END_TEST;
+}
+
 bool TestCorruptionUnrecoverable() {
     BEGIN_TEST;
     char ramdisk_path[PATH_MAX];
@@ -2984,6 +3077,7 @@ RUN_TEST_LARGE(TestMounting)
 RUN_TEST_LARGE(TestMkfs)
 RUN_TEST_MEDIUM(TestCorruptionOk)
 RUN_TEST_MEDIUM(TestCorruptionRegression)
+RUN_TEST_MEDIUM(TestCorruptionRegressionIncremental)
 RUN_TEST_MEDIUM(TestCorruptionUnrecoverable)
 RUN_TEST_LARGE((TestRandomOpMultithreaded<1, /* persistent= */ false>))
 RUN_TEST_LARGE((TestRandomOpMultithreaded<3, /* persistent= */ false>))
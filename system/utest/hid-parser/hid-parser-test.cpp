@@ -5,6 +5,7 @@
 #include <assert.h>
 #include <stdio.h>
 
+#include <hid-parser/extract.h>
 #include <hid-parser/item.h>
 #include <hid-parser/parser.h>
 #include <hid-parser/usages.h>
@@ -658,6 +659,89 @@ static bool parse_asus_touch() {
    END_TEST;
 }
 
+static bool extract_boot_mouse() {
+    BEGIN_TEST;
+
+    hid::DeviceDescriptor* dev = nullptr;
+    auto res = hid::ParseReportDescriptor(
+        boot_mouse_r_desc, sizeof(boot_mouse_r_desc), &dev);
+    ASSERT_EQ(res, hid::ParseResult::kParseOk);
+
+    hid::InputExtractors* ex = nullptr;
+    ASSERT_EQ(hid::CreateInputExtractors(dev, &ex), hid::ParseResult::kParseOk);
+
+    // No report id, so any first byte finds the only report.
+    EXPECT_FALSE(ex->has_report_id);
+    ASSERT_EQ(ex->rep_count, 1u);
+    auto rpt = hid::FindInputExtractor(ex, 0x05);
+    ASSERT_TRUE(rpt != nullptr);
+
+    // The padding field is left out.
+    ASSERT_EQ(rpt->count, 5u);
+    EXPECT_EQ(rpt->byte_sz, 3u);
+    EXPECT_EQ(rpt->fields[3].bit_offset, 8u);
+    EXPECT_EQ(rpt->fields[3].field, &dev->report[0].first_field[4]);
+    EXPECT_TRUE(rpt->fields[3].is_signed);
+    EXPECT_FALSE(rpt->fields[0].is_signed);
+
+    // Buttons 1 and 3 down, X = -2, Y = 3.
+    const uint8_t report[] = { 0x05, 0xfe, 0x03 };
+    int32_t values[5];
+    ASSERT_TRUE(hid::ExtractInputReport(*rpt, report, sizeof(report), values));
+    EXPECT_EQ(values[0], 1);
+    EXPECT_EQ(values[1], 0);
+    EXPECT_EQ(values[2], 1);
+    EXPECT_EQ(values[3], -2);
+    EXPECT_EQ(values[4], 3);
+
+    // Without a physical range, physical values are logical ones.
+    EXPECT_EQ(hid::ToPhysical(rpt->fields[3], values[3]), -2.0f);
+
+    // A short report is refused.
+    EXPECT_FALSE(hid::ExtractInputReport(*rpt, report, 2, values));
+
+    hid::FreeInputExtractors(ex);
+    hid::FreeDeviceDescriptor(dev);
+    END_TEST;
+}
+
+static bool extract_adaf_trinket() {
+    BEGIN_TEST;
+
+    hid::DeviceDescriptor* dev = nullptr;
+    auto res = hid::ParseReportDescriptor(
+        trinket_r_desc, sizeof(trinket_r_desc), &dev);
+    ASSERT_EQ(res, hid::ParseResult::kParseOk);
+
+    hid::InputExtractors* ex = nullptr;
+    ASSERT_EQ(hid::CreateInputExtractors(dev, &ex), hid::ParseResult::kParseOk);
+    EXPECT_TRUE(ex->has_report_id);
+
+    // Report id 1 is the boot mouse again, after the report id byte.
+    auto rpt = hid::FindInputExtractor(ex, 1);
+    ASSERT_TRUE(rpt != nullptr);
+    EXPECT_EQ(rpt->report_id, 1);
+    ASSERT_EQ(rpt->count, 5u);
+    EXPECT_EQ(rpt->byte_sz, 4u);
+    EXPECT_EQ(rpt->fields[0].bit_offset, 8u);
+
+    const uint8_t report[] = { 0x01, 0x02, 0x81, 0x7f };
+    int32_t values[5];
+    ASSERT_TRUE(hid::ExtractInputReport(*rpt, report, sizeof(report), values));
+    EXPECT_EQ(values[0], 0);
+    EXPECT_EQ(values[1], 1);
+    EXPECT_EQ(values[2], 0);
+    EXPECT_EQ(values[3], -127);
+    EXPECT_EQ(values[4], 127);
+
+    // There is no report id 5.
+    EXPECT_TRUE(hid::FindInputExtractor(ex, 5) == nullptr);
+
+    hid::FreeInputExtractors(ex);
+    hid::FreeDeviceDescriptor(dev);
+    END_TEST;
+}
+
 BEGIN_TEST_CASE(hidparser_tests)
 RUN_TEST(itemize_acer12_rpt1)
 RUN_TEST(itemize_eve_tablet_rpt)
@@ -667,6 +751,8 @@ RUN_TEST(parse_ps3_controller)
 RUN_TEST(parse_acer12_touch)
 RUN_TEST(parse_eve_tablet)
 RUN_TEST(parse_asus_touch)
+RUN_TEST(extract_boot_mouse)
+RUN_TEST(extract_adaf_trinket)
 END_TEST_CASE(hidparser_tests)
 
 int main(int argc, char** argv) {
@@ -683,6 +683,39 @@ static bool guest_set_trap_with_io() {
     END_TEST;
 }
 
+static bool guest_set_trap_with_io_port() {
+    BEGIN_TEST;
+
+    test_t test;
+    ASSERT_TRUE(setup(&test, guest_set_trap_with_io_start, guest_set_trap_with_io_end));
+    if (!test.supported) {
+        // The hypervisor isn't supported, so don't run the test.
+        return true;
+    }
+
+    zx::port port;
+    ASSERT_EQ(zx::port::create(0, &port), ZX_OK);
+
+    // Trap on writes to TRAP_PORT, delivered through the port.
+    ASSERT_EQ(test.guest.set_trap(ZX_GUEST_TRAP_IO, TRAP_PORT, 1, port, kTrapKey), ZX_OK);
+
+    // The VCPU continues past the write to the exit.
+    zx_port_packet_t packet = {};
+    ASSERT_EQ(test.vcpu.resume(&packet), ZX_OK);
+    EXPECT_EQ(packet.type, ZX_PKT_TYPE_GUEST_MEM);
+    EXPECT_EQ(packet.guest_mem.addr, EXIT_TEST_ADDR);
+
+    ASSERT_EQ(port.wait(zx::time::infinite(), &packet), ZX_OK);
+    EXPECT_EQ(packet.key, kTrapKey);
+    EXPECT_EQ(packet.type, ZX_PKT_TYPE_GUEST_IO);
+    EXPECT_EQ(packet.guest_io.port, TRAP_PORT);
+    EXPECT_FALSE(packet.guest_io.input);
+
+    ASSERT_TRUE(teardown(&test));
+
+    END_TEST;
+}
+
 BEGIN_TEST_CASE(guest)
 RUN_TEST(vcpu_resume)
 RUN_TEST(vcpu_read_write_state)
@@ -696,6 +729,7 @@ RUN_TEST(vcpu_fp)
 RUN_TEST(vcpu_fp_aarch32)
 #elif __x86_64__
 RUN_TEST(guest_set_trap_with_io)
+RUN_TEST(guest_set_trap_with_io_port)
 RUN_TEST(vcpu_hlt)
 RUN_TEST(vcpu_pause)
 RUN_TEST(vcpu_write_cr0)
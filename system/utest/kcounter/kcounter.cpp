@@ -0,0 +1,133 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <fbl/unique_fd.h>
+#include <lib/fdio/io.h>
+#include <lib/fzl/vmo-mapper.h>
+#include <lib/zircon-internal/kcounters.h>
+#include <lib/zx/channel.h>
+#include <lib/zx/vmo.h>
+#include <unittest/unittest.h>
+
+namespace {
+
+bool MapFile(const char* path, fzl::VmoMapper* mapper, zx::vmo* out_vmo) {
+    BEGIN_HELPER;
+
+    fbl::unique_fd fd(open(path, O_RDONLY));
+    ASSERT_TRUE(fd, path);
+    zx::vmo vmo;
+    ASSERT_EQ(ZX_OK, fdio_get_vmo_exact(fd.get(), vmo.reset_and_get_address()));
+    uint64_t size;
+    ASSERT_EQ(ZX_OK, vmo.get_size(&size));
+    ASSERT_EQ(ZX_OK, mapper->Map(vmo, 0u, size, ZX_VM_PERM_READ));
+    if (out_vmo) {
+        *out_vmo = fbl::move(vmo);
+    }
+
+    END_HELPER;
+}
+
+const kcounters_desc_header_t* Header(const fzl::VmoMapper& desc) {
+    return static_cast<const kcounters_desc_header_t*>(desc.start());
+}
+
+// Returns the index of |name|, or -1.
+ssize_t Find(const fzl::VmoMapper& desc, const char* name) {
+    const kcounters_desc_header_t* header = Header(desc);
+    auto entries = reinterpret_cast<const kcounters_desc_entry_t*>(header + 1);
+    for (size_t i = 0; i < header->num_counters; i++) {
+        if (strcmp(entries[i].name, name) == 0) {
+            return static_cast<ssize_t>(i);
+        }
+    }
+    return -1;
+}
+
+int64_t Value(const fzl::VmoMapper& desc, const fzl::VmoMapper& arena, size_t index) {
+    const kcounters_desc_header_t* header = Header(desc);
+    auto slots = static_cast<const int64_t*>(arena.start());
+    int64_t sum = 0;
+    for (size_t cpu = 0; cpu < header->max_cpus; cpu++) {
+        sum += __atomic_load_n(&slots[cpu * header->num_counters + index], __ATOMIC_RELAXED);
+    }
+    return sum;
+}
+
+bool layout_test() {
+    BEGIN_TEST;
+
+    fzl::VmoMapper desc;
+    ASSERT_TRUE(MapFile("/boot/kernel/" KCOUNTERS_DESC_VMO_NAME, &desc, nullptr));
+    ASSERT_GE(desc.size(), sizeof(kcounters_desc_header_t));
+    const kcounters_desc_header_t* header = Header(desc);
+    EXPECT_EQ(KCOUNTERS_MAGIC, header->magic);
+    EXPECT_EQ(KCOUNTERS_VERSION, header->version);
+    EXPECT_EQ(sizeof(kcounters_desc_entry_t), header->entry_size);
+    EXPECT_GT(header->num_counters, 0u);
+    ASSERT_LE(sizeof(*header) + header->num_counters * sizeof(kcounters_desc_entry_t),
+              desc.size());
+
+    // The names are sorted, and so unique.
+    auto entries = reinterpret_cast<const kcounters_desc_entry_t*>(header + 1);
+    for (size_t i = 1; i < header->num_counters; i++) {
+        EXPECT_LT(strcmp(entries[i - 1].name, entries[i].name), 0);
+    }
+
+    fzl::VmoMapper arena;
+    zx::vmo arena_vmo;
+    ASSERT_TRUE(MapFile("/boot/kernel/" KCOUNTERS_ARENA_VMO_NAME, &arena, &arena_vmo));
+    EXPECT_GE(arena.size(), header->max_cpus * header->num_counters * sizeof(int64_t));
+
+    // The counters are read-only.
+    zx_info_handle_basic_t info;
+    ASSERT_EQ(ZX_OK, arena_vmo.get_info(ZX_INFO_HANDLE_BASIC, &info, sizeof(info),
+                                        nullptr, nullptr));
+    EXPECT_EQ(0u, info.rights & ZX_RIGHT_WRITE);
+
+    END_TEST;
+}
+
+bool live_values_test() {
+    BEGIN_TEST;
+
+    fzl::VmoMapper desc;
+    fzl::VmoMapper arena;
+    ASSERT_TRUE(MapFile("/boot/kernel/" KCOUNTERS_DESC_VMO_NAME, &desc, nullptr));
+    ASSERT_TRUE(MapFile("/boot/kernel/" KCOUNTERS_ARENA_VMO_NAME, &arena, nullptr));
+    ssize_t index = Find(desc, "kernel.channel.messages");
+    ASSERT_GE(index, 0);
+
+    int64_t before = Value(desc, arena, index);
+
+    constexpr int kMessages = 100;
+    zx::channel a, b;
+    ASSERT_EQ(ZX_OK, zx::channel::create(0u, &a, &b));
+    for (int i = 0; i < kMessages; i++) {
+        uint8_t byte = 0u;
+        ASSERT_EQ(ZX_OK, a.write(0u, &byte, sizeof(byte), nullptr, 0u));
+        uint32_t actual_bytes;
+        ASSERT_EQ(ZX_OK, b.read(0u, &byte, sizeof(byte), &actual_bytes, nullptr, 0u, nullptr));
+    }
+
+    // Other processes receive messages too.
+    EXPECT_GE(Value(desc, arena, index) - before, kMessages);
+
+    END_TEST;
+}
+
+} // namespace
+
+BEGIN_TEST_CASE(kcounter_tests)
+RUN_TEST(layout_test)
+RUN_TEST(live_values_test)
+END_TEST_CASE(kcounter_tests)
+
+int main(int argc, char** argv) {
+    return unittest_run_all_tests(argc, argv) ? 0 : -1;
+}
@@ -125,9 +125,45 @@ static bool argument_size_test(void) {
     return ok;
 }
 
+static bool template_test(void) {
+    BEGIN_TEST;
+
+    zx_handle_t vmo;
+    ASSERT_EQ(launchpad_vmo_from_file("/boot/bin/sh", &vmo), ZX_OK, "");
+    launchpad_template_t* tmpl = NULL;
+    ASSERT_EQ(launchpad_template_create(vmo, &tmpl), ZX_OK, "");
+
+    // Each process stamped out of the template runs on its own.
+    for (int i = 0; i < 3; ++i) {
+        launchpad_t* lp;
+        ASSERT_EQ(launchpad_create(ZX_HANDLE_INVALID, "template test", &lp),
+                  ZX_OK, "");
+        const char* const argv[] = { "/boot/bin/sh", "-c", "exit 7" };
+        EXPECT_EQ(launchpad_set_args(lp, countof(argv), argv), ZX_OK, "");
+        EXPECT_EQ(launchpad_load_from_template(lp, tmpl), ZX_OK, "");
+
+        zx_handle_t proc = ZX_HANDLE_INVALID;
+        const char* errmsg = "???";
+        ASSERT_EQ(launchpad_go(lp, &proc, &errmsg), ZX_OK, errmsg);
+
+        EXPECT_EQ(zx_object_wait_one(proc, ZX_PROCESS_TERMINATED,
+                                     ZX_TIME_INFINITE, NULL), ZX_OK, "");
+        zx_info_process_t info;
+        EXPECT_EQ(zx_object_get_info(proc, ZX_INFO_PROCESS,
+                                     &info, sizeof(info), NULL, NULL), ZX_OK, "");
+        EXPECT_EQ(zx_handle_close(proc), ZX_OK, "");
+        EXPECT_EQ(info.return_code, 7, "shell exit status");
+    }
+
+    launchpad_template_destroy(tmpl);
+
+    END_TEST;
+}
+
 BEGIN_TEST_CASE(launchpad_tests)
 RUN_TEST(launchpad_test);
 RUN_TEST(argument_size_test);
+RUN_TEST(template_test);
 END_TEST_CASE(launchpad_tests)
 
 int main(int argc, char **argv)
@@ -0,0 +1,94 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <malloc.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <zircon/process.h>
+#include <zircon/syscalls.h>
+#include <zircon/syscalls/object.h>
+
+#include <unittest/unittest.h>
+
+// Big enough to be allocated from its own extent rather than a slab.
+#define LARGE_SIZE (4u << 20)
+
+// Refreshes the statistics mallctl() reports and returns the number of
+// bytes currently allocated.
+static size_t stats_allocated(void) {
+    uint64_t epoch = 1;
+    size_t len = sizeof(epoch);
+    if (mallctl("epoch", &epoch, &len, &epoch, len) != 0)
+        return 0;
+    size_t allocated = 0;
+    len = sizeof(allocated);
+    if (mallctl("stats.allocated", &allocated, &len, NULL, 0) != 0)
+        return 0;
+    return allocated;
+}
+
+static size_t private_bytes(void) {
+    zx_info_task_stats_t info;
+    if (zx_object_get_info(zx_process_self(), ZX_INFO_TASK_STATS, &info, sizeof(info),
+                           NULL, NULL) != ZX_OK)
+        return 0;
+    return info.mem_private_bytes;
+}
+
+static bool stats_allocated_test(void) {
+    BEGIN_TEST;
+
+    size_t before = stats_allocated();
+    char* block = malloc(LARGE_SIZE);
+    ASSERT_NONNULL(block, "");
+    EXPECT_GE(stats_allocated(), before + LARGE_SIZE, "allocation not counted");
+    free(block);
+    EXPECT_LT(stats_allocated(), before + LARGE_SIZE, "free not counted");
+
+    END_TEST;
+}
+
+static void count_printed(void* opaque, const char* str) {
+    *(size_t*)opaque += strlen(str);
+}
+
+static bool stats_print_test(void) {
+    BEGIN_TEST;
+
+    // Only check that printing calls back with something.
+    size_t printed = 0;
+    malloc_stats_print(count_printed, &printed, NULL);
+    EXPECT_GT(printed, 0u, "");
+
+    END_TEST;
+}
+
+// Purging freed pages has to give the memory back to the system.
+static bool purge_decommits_test(void) {
+    BEGIN_TEST;
+
+    char* block = malloc(LARGE_SIZE);
+    ASSERT_NONNULL(block, "");
+    memset(block, 0xa5, LARGE_SIZE);
+    size_t committed = private_bytes();
+    free(block);
+
+    // 4096 is MALLCTL_ARENAS_ALL.
+    ASSERT_EQ(mallctl("arena.4096.purge", NULL, NULL, NULL, 0), 0, "");
+    EXPECT_LE(private_bytes() + LARGE_SIZE / 2, committed, "freed pages still committed");
+
+    END_TEST;
+}
+
+BEGIN_TEST_CASE(malloc_tests)
+RUN_TEST(stats_allocated_test)
+RUN_TEST(stats_print_test)
+RUN_TEST(purge_decommits_test)
+END_TEST_CASE(malloc_tests)
+
+int main(int argc, char** argv) {
+    return unittest_run_all_tests(argc, argv) ? 0 : -1;
+}
@@ -85,6 +85,61 @@ bool TestMemfsBasic() {
     END_TEST;
 }
 
+bool TestMemfsAppendGrowth() {
+    BEGIN_TEST;
+
+    async::Loop loop(&kAsyncLoopConfigNoAttachToThread);
+    ASSERT_EQ(loop.StartThread(), ZX_OK);
+
+    memfs_filesystem_t* vfs;
+    zx_handle_t root;
+    ASSERT_EQ(memfs_create_filesystem(loop.dispatcher(), &vfs, &root), ZX_OK);
+    uint32_t type = PA_FDIO_REMOTE;
+    int raw_root_fd;
+    ASSERT_EQ(fdio_create_fd(&root, &type, 1, &raw_root_fd), ZX_OK);
+    fbl::unique_fd root_fd(raw_root_fd);
+
+    fbl::unique_fd fd(openat(root_fd.get(), "file-a", O_CREAT | O_RDWR | O_APPEND));
+    ASSERT_TRUE(fd);
+
+    // Small appends, which repeatedly cross page boundaries, leave the file
+    // exactly as long as what was written, whatever room its VMO grew.
+    constexpr size_t kChunk = 100;
+    constexpr size_t kChunks = 5 * PAGE_SIZE / kChunk;
+    uint8_t chunk[kChunk];
+    for (size_t i = 0; i < kChunks; i++) {
+        memset(chunk, static_cast<int>(i), sizeof(chunk));
+        ASSERT_EQ(write(fd.get(), chunk, sizeof(chunk)), static_cast<ssize_t>(sizeof(chunk)));
+    }
+    struct stat st;
+    ASSERT_EQ(fstat(fd.get(), &st), 0);
+    ASSERT_EQ(st.st_size, static_cast<off_t>(kChunks * kChunk));
+
+    ASSERT_EQ(lseek(fd.get(), 0, SEEK_SET), 0);
+    for (size_t i = 0; i < kChunks; i++) {
+        ASSERT_EQ(read(fd.get(), chunk, sizeof(chunk)), static_cast<ssize_t>(sizeof(chunk)));
+        for (size_t j = 0; j < sizeof(chunk); j++) {
+            ASSERT_EQ(chunk[j], static_cast<uint8_t>(i));
+        }
+    }
+    ASSERT_EQ(read(fd.get(), chunk, sizeof(chunk)), 0);
+
+    // Reading past the end after the file is extended sees zeroes.
+    ASSERT_EQ(ftruncate(fd.get(), kChunks * kChunk + kChunk), 0);
+    ASSERT_EQ(read(fd.get(), chunk, sizeof(chunk)), static_cast<ssize_t>(sizeof(chunk)));
+    for (size_t j = 0; j < sizeof(chunk); j++) {
+        ASSERT_EQ(chunk[j], 0);
+    }
+
+    fd.reset();
+    root_fd.reset();
+    sync_completion_t unmounted;
+    memfs_free_filesystem(vfs, &unmounted);
+    ASSERT_EQ(sync_completion_wait(&unmounted, ZX_SEC(3)), ZX_OK);
+
+    END_TEST;
+}
+
 bool TestMemfsLimitPages() {
     BEGIN_TEST;
 
@@ -281,6 +336,7 @@ bool TestMemfsCloseDuringAccess() {
 BEGIN_TEST_CASE(memfs_tests)
 RUN_TEST(TestMemfsNull)
 RUN_TEST(TestMemfsBasic)
+RUN_TEST(TestMemfsAppendGrowth)
 RUN_TEST(TestMemfsLimitPages)
 RUN_TEST(TestMemfsInstall)
 RUN_TEST(TestMemfsCloseDuringAccess)
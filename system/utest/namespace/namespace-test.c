@@ -5,10 +5,12 @@
 #include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <threads.h>
 #include <unistd.h>
 
 #include <launchpad/launchpad.h>
@@ -85,8 +87,117 @@ static bool namespace_create_test(void) {
     END_TEST;
 }
 
+static bool namespace_bind_test(void) {
+    BEGIN_TEST;
+
+    fdio_ns_t* ns;
+    ASSERT_EQ(fdio_ns_create(&ns), ZX_OK, "");
+
+    int fd = open("/tmp", O_RDONLY | O_DIRECTORY);
+    ASSERT_GT(fd, 0, "");
+    ASSERT_EQ(fdio_ns_bind_fd(ns, "/a/b", fd), ZX_OK, "");
+    EXPECT_EQ(fdio_ns_bind_fd(ns, "/a/b", fd), ZX_ERR_ALREADY_EXISTS, "");
+    EXPECT_EQ(fdio_ns_bind_fd(ns, "/a", fd), ZX_ERR_ALREADY_EXISTS, "");
+    EXPECT_EQ(fdio_ns_bind_fd(ns, "/a/b/c", fd), ZX_ERR_NOT_SUPPORTED, "");
+
+    // A bind which fails partway down its path leaves nothing behind.
+    EXPECT_EQ(fdio_ns_bind_fd(ns, "/x/y/../z", fd), ZX_ERR_INVALID_ARGS, "");
+    zx_handle_t h0, h1;
+    ASSERT_EQ(zx_channel_create(0, &h0, &h1), ZX_OK, "");
+    EXPECT_EQ(fdio_ns_connect(ns, "/x", 0, h0), ZX_ERR_NOT_FOUND, "");
+    zx_handle_close(h1);
+
+    // Intermediate vnodes can't be connected to, mount points can.
+    ASSERT_EQ(zx_channel_create(0, &h0, &h1), ZX_OK, "");
+    EXPECT_EQ(fdio_ns_connect(ns, "/a", 0, h0), ZX_ERR_NOT_SUPPORTED, "");
+    zx_handle_close(h1);
+    ASSERT_EQ(zx_channel_create(0, &h0, &h1), ZX_OK, "");
+    EXPECT_EQ(fdio_ns_connect(ns, "/a/b", 0, h0), ZX_OK, "");
+    zx_handle_close(h1);
+
+    ASSERT_EQ(close(fd), 0, "");
+    ASSERT_EQ(fdio_ns_destroy(ns), ZX_OK, "");
+
+    END_TEST;
+}
+
+#define LOOKUP_THREADS 4
+#define LOOKUP_BINDS 32
+
+typedef struct {
+    fdio_ns_t* ns;
+    atomic_int* done;
+    int failures;
+} lookup_args_t;
+
+static int lookup_thread(void* arg) {
+    lookup_args_t* args = arg;
+    while (atomic_load(args->done) == 0) {
+        zx_handle_t h0, h1;
+        if (zx_channel_create(0, &h0, &h1) != ZX_OK) {
+            args->failures++;
+            break;
+        }
+        // Present from the start, so every lookup must find it,
+        // however many binds happen alongside.
+        if (fdio_ns_connect(args->ns, "/svc/first", 0, h0) != ZX_OK) {
+            args->failures++;
+        }
+        zx_handle_close(h1);
+    }
+    return 0;
+}
+
+static bool namespace_concurrent_lookup_test(void) {
+    BEGIN_TEST;
+
+    fdio_ns_t* ns;
+    ASSERT_EQ(fdio_ns_create(&ns), ZX_OK, "");
+    int fd = open("/tmp", O_RDONLY | O_DIRECTORY);
+    ASSERT_GT(fd, 0, "");
+    ASSERT_EQ(fdio_ns_bind_fd(ns, "/svc/first", fd), ZX_OK, "");
+
+    atomic_int done = ATOMIC_VAR_INIT(0);
+    lookup_args_t args[LOOKUP_THREADS];
+    thrd_t threads[LOOKUP_THREADS];
+    for (int n = 0; n < LOOKUP_THREADS; n++) {
+        args[n].ns = ns;
+        args[n].done = &done;
+        args[n].failures = 0;
+        ASSERT_EQ(thrd_create(&threads[n], lookup_thread, &args[n]), thrd_success, "");
+    }
+
+    for (int n = 0; n < LOOKUP_BINDS; n++) {
+        char path[32];
+        snprintf(path, sizeof(path), "/svc/%d/dir", n);
+        EXPECT_EQ(fdio_ns_bind_fd(ns, path, fd), ZX_OK, "");
+    }
+
+    atomic_store(&done, 1);
+    for (int n = 0; n < LOOKUP_THREADS; n++) {
+        ASSERT_EQ(thrd_join(threads[n], NULL), thrd_success, "");
+        EXPECT_EQ(args[n].failures, 0, "");
+    }
+
+    for (int n = 0; n < LOOKUP_BINDS; n++) {
+        char path[32];
+        snprintf(path, sizeof(path), "/svc/%d/dir", n);
+        zx_handle_t h0, h1;
+        ASSERT_EQ(zx_channel_create(0, &h0, &h1), ZX_OK, "");
+        EXPECT_EQ(fdio_ns_connect(ns, path, 0, h0), ZX_OK, "");
+        zx_handle_close(h1);
+    }
+
+    ASSERT_EQ(close(fd), 0, "");
+    ASSERT_EQ(fdio_ns_destroy(ns), ZX_OK, "");
+
+    END_TEST;
+}
+
 BEGIN_TEST_CASE(namespace_tests)
 RUN_TEST_MEDIUM(namespace_create_test)
+RUN_TEST(namespace_bind_test)
+RUN_TEST_MEDIUM(namespace_concurrent_lookup_test)
 END_TEST_CASE(namespace_tests)
 
 int main(int argc, char** argv) {
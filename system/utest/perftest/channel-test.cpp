@@ -0,0 +1,110 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <threads.h>
+
+#include <fbl/string_printf.h>
+#include <fbl/unique_ptr.h>
+#include <lib/zx/channel.h>
+#include <perftest/perftest.h>
+#include <zircon/assert.h>
+#include <zircon/syscalls.h>
+
+namespace {
+
+// Measure the times taken to write a message to a channel and to read it
+// back from the other end, on one thread.
+bool ChannelWriteReadTest(perftest::RepeatState* state, uint32_t size) {
+    state->SetBytesProcessedPerRun(size);
+    state->DeclareStep("write");
+    state->DeclareStep("read");
+
+    zx::channel a, b;
+    ZX_ASSERT(zx::channel::create(0, &a, &b) == ZX_OK);
+    fbl::unique_ptr<uint8_t[]> buffer(new uint8_t[size]());
+
+    while (state->KeepRunning()) {
+        ZX_ASSERT(a.write(0, buffer.get(), size, nullptr, 0) == ZX_OK);
+        state->NextStep();
+        uint32_t actual_bytes;
+        ZX_ASSERT(b.read(0, buffer.get(), size, &actual_bytes, nullptr, 0,
+                         nullptr) == ZX_OK);
+    }
+    return true;
+}
+
+// Replies to each message on |channel| with the same bytes, until the peer
+// is closed.
+int EchoThread(void* arg) {
+    zx::channel channel(static_cast<zx_handle_t>(reinterpret_cast<uintptr_t>(arg)));
+    fbl::unique_ptr<uint8_t[]> buffer(new uint8_t[ZX_CHANNEL_MAX_MSG_BYTES]);
+    for (;;) {
+        zx_signals_t observed;
+        ZX_ASSERT(channel.wait_one(ZX_CHANNEL_READABLE | ZX_CHANNEL_PEER_CLOSED,
+                                   zx::time::infinite(), &observed) == ZX_OK);
+        if (!(observed & ZX_CHANNEL_READABLE)) {
+            return 0;
+        }
+        uint32_t actual_bytes;
+        ZX_ASSERT(channel.read(0, buffer.get(), ZX_CHANNEL_MAX_MSG_BYTES, &actual_bytes,
+                               nullptr, 0, nullptr) == ZX_OK);
+        ZX_ASSERT(channel.write(0, buffer.get(), actual_bytes, nullptr, 0) == ZX_OK);
+    }
+}
+
+// Measure the time taken by zx_channel_call() to another thread, which
+// echoes the message back: a round trip with two context switches, or two
+// cross-CPU wakeups if the threads run on different CPUs.
+bool ChannelCallTest(perftest::RepeatState* state, uint32_t size) {
+    state->SetBytesProcessedPerRun(size);
+
+    zx::channel client, server;
+    ZX_ASSERT(zx::channel::create(0, &client, &server) == ZX_OK);
+    thrd_t thread;
+    ZX_ASSERT(thrd_create(&thread, EchoThread,
+                          reinterpret_cast<void*>(
+                              static_cast<uintptr_t>(server.release()))) == thrd_success);
+
+    fbl::unique_ptr<uint8_t[]> request(new uint8_t[size]());
+    fbl::unique_ptr<uint8_t[]> reply(new uint8_t[size]);
+    zx_channel_call_args_t args = {
+        .wr_bytes = request.get(),
+        .wr_handles = nullptr,
+        .rd_bytes = reply.get(),
+        .rd_handles = nullptr,
+        .wr_num_bytes = size,
+        .wr_num_handles = 0,
+        .rd_num_bytes = size,
+        .rd_num_handles = 0,
+    };
+    while (state->KeepRunning()) {
+        uint32_t actual_bytes, actual_handles;
+        ZX_ASSERT(client.call(0, zx::time::infinite(), &args, &actual_bytes,
+                              &actual_handles) == ZX_OK);
+    }
+
+    client.reset();
+    ZX_ASSERT(thrd_join(thread, nullptr) == thrd_success);
+    return true;
+}
+
+void RegisterTests() {
+    static const uint32_t kSizesBytes[] = {
+        64,
+        1024,
+        32768,
+        65536,
+    };
+    for (auto size : kSizesBytes) {
+        auto name = fbl::StringPrintf("Channel/WriteRead/%ubytes", size);
+        perftest::RegisterTest(name.c_str(), ChannelWriteReadTest, size);
+    }
+    for (auto size : kSizesBytes) {
+        auto name = fbl::StringPrintf("Channel/Call/CrossThread/%ubytes", size);
+        perftest::RegisterTest(name.c_str(), ChannelCallTest, size);
+    }
+}
+PERFTEST_CTOR(RegisterTests);
+
+}  // namespace
@@ -0,0 +1,84 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <threads.h>
+
+#include <lib/zx/event.h>
+#include <lib/zx/eventpair.h>
+#include <perftest/perftest.h>
+#include <zircon/assert.h>
+
+namespace {
+
+// Measure the times taken to set and to clear a signal on an event that
+// nothing waits on.
+bool EventSignalTest(perftest::RepeatState* state) {
+    state->DeclareStep("set");
+    state->DeclareStep("clear");
+
+    zx::event event;
+    ZX_ASSERT(zx::event::create(0, &event) == ZX_OK);
+    while (state->KeepRunning()) {
+        ZX_ASSERT(event.signal(0, ZX_EVENT_SIGNALED) == ZX_OK);
+        state->NextStep();
+        ZX_ASSERT(event.signal(ZX_EVENT_SIGNALED, 0) == ZX_OK);
+    }
+    return true;
+}
+
+// Measure the time taken by zx_object_wait_one() on a signal that is
+// already asserted, so that it returns without blocking.
+bool EventWaitSignaledTest(perftest::RepeatState* state) {
+    zx::event event;
+    ZX_ASSERT(zx::event::create(0, &event) == ZX_OK);
+    ZX_ASSERT(event.signal(0, ZX_EVENT_SIGNALED) == ZX_OK);
+    while (state->KeepRunning()) {
+        ZX_ASSERT(event.wait_one(ZX_EVENT_SIGNALED, zx::time::infinite(), nullptr) == ZX_OK);
+    }
+    return true;
+}
+
+// Clears each ZX_USER_SIGNAL_0 on its end of the eventpair and raises it
+// on the peer, until the peer is closed.
+int EventPongThread(void* arg) {
+    auto* event = static_cast<zx::eventpair*>(arg);
+    for (;;) {
+        zx_signals_t observed;
+        ZX_ASSERT(event->wait_one(ZX_USER_SIGNAL_0 | ZX_EVENTPAIR_PEER_CLOSED,
+                                  zx::time::infinite(), &observed) == ZX_OK);
+        if (!(observed & ZX_USER_SIGNAL_0)) {
+            return 0;
+        }
+        ZX_ASSERT(event->signal(ZX_USER_SIGNAL_0, 0) == ZX_OK);
+        ZX_ASSERT(event->signal_peer(0, ZX_USER_SIGNAL_0) == ZX_OK);
+    }
+}
+
+// Measure the time taken to wake another thread by signaling an eventpair
+// and to be woken by it in return.
+bool EventRoundTripTest(perftest::RepeatState* state) {
+    zx::eventpair event, peer;
+    ZX_ASSERT(zx::eventpair::create(0, &event, &peer) == ZX_OK);
+    thrd_t thread;
+    ZX_ASSERT(thrd_create(&thread, EventPongThread, &peer) == thrd_success);
+
+    while (state->KeepRunning()) {
+        ZX_ASSERT(event.signal_peer(0, ZX_USER_SIGNAL_0) == ZX_OK);
+        ZX_ASSERT(event.wait_one(ZX_USER_SIGNAL_0, zx::time::infinite(), nullptr) == ZX_OK);
+        ZX_ASSERT(event.signal(ZX_USER_SIGNAL_0, 0) == ZX_OK);
+    }
+
+    event.reset();
+    ZX_ASSERT(thrd_join(thread, nullptr) == thrd_success);
+    return true;
+}
+
+void RegisterTests() {
+    perftest::RegisterTest("Event/Signal", EventSignalTest);
+    perftest::RegisterTest("Event/WaitSignaled", EventWaitSignaledTest);
+    perftest::RegisterTest("Event/RoundTrip/CrossThread", EventRoundTripTest);
+}
+PERFTEST_CTOR(RegisterTests);
+
+}  // namespace
@@ -0,0 +1,254 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stddef.h>
+#include <string.h>
+
+#include <fbl/string_printf.h>
+#include <fbl/unique_ptr.h>
+#include <lib/fidl/coding.h>
+#include <lib/fidl/cpp/builder.h>
+#include <lib/fidl/cpp/message.h>
+#include <lib/fidl/internal.h>
+#include <lib/zx/channel.h>
+#include <perftest/perftest.h>
+#include <zircon/assert.h>
+#include <zircon/syscalls.h>
+
+namespace {
+
+// The number of elements in the vector, handle array and struct chain of
+// the message shapes below.
+constexpr uint32_t kStringCount = 16;
+constexpr uint32_t kHandleCount = ZX_CHANNEL_MAX_MSG_HANDLES;
+constexpr uint32_t kNodeCount = 8;
+
+constexpr char kString[] = "a string of 24 bytes....";
+
+// A small struct with no pointers or handles.  The fidl compiler emits no
+// fields for it.
+struct SmallStruct {
+    alignas(FIDL_ALIGNMENT)
+    fidl_message_header_t header;
+    uint64_t data_0;
+    uint32_t data_1;
+    uint32_t data_2;
+};
+
+const fidl_type_t kSmallStructType = fidl_type_t(fidl::FidlCodedStruct(
+    nullptr, 0u, sizeof(SmallStruct), "SmallStruct"));
+
+// A vector of strings.
+struct VectorOfStrings {
+    alignas(FIDL_ALIGNMENT)
+    fidl_message_header_t header;
+    fidl_vector_t strings;
+};
+
+const fidl_type_t kString32 =
+    fidl_type_t(fidl::FidlCodedString(32u, fidl::kNonnullable));
+const fidl_type_t kVectorOfString32 = fidl_type_t(fidl::FidlCodedVector(
+    &kString32, kStringCount, sizeof(fidl_string_t), fidl::kNonnullable));
+const fidl::FidlField kVectorOfStringsFields[] = {
+    fidl::FidlField(&kVectorOfString32, offsetof(VectorOfStrings, strings)),
+};
+const fidl_type_t kVectorOfStringsType = fidl_type_t(fidl::FidlCodedStruct(
+    kVectorOfStringsFields, 1u, sizeof(VectorOfStrings), "VectorOfStrings"));
+
+// A chain of nested out-of-line structs.
+struct Node {
+    alignas(FIDL_ALIGNMENT)
+    uint64_t data;
+    Node* next;
+};
+
+struct NestedStructs {
+    alignas(FIDL_ALIGNMENT)
+    fidl_message_header_t header;
+    Node* root;
+};
+
+extern const fidl_type_t kNodeType;
+const fidl_type_t kNodePointer =
+    fidl_type_t(fidl::FidlCodedStructPointer(&kNodeType.coded_struct));
+const fidl::FidlField kNodeFields[] = {
+    fidl::FidlField(&kNodePointer, offsetof(Node, next)),
+};
+const fidl_type_t kNodeType = fidl_type_t(fidl::FidlCodedStruct(
+    kNodeFields, 1u, sizeof(Node), "Node"));
+const fidl::FidlField kNestedStructsFields[] = {
+    fidl::FidlField(&kNodePointer, offsetof(NestedStructs, root)),
+};
+const fidl_type_t kNestedStructsType = fidl_type_t(fidl::FidlCodedStruct(
+    kNestedStructsFields, 1u, sizeof(NestedStructs), "NestedStructs"));
+
+// As many handles as a channel message can carry.
+struct HandleArray {
+    alignas(FIDL_ALIGNMENT)
+    fidl_message_header_t header;
+    zx_handle_t handles[kHandleCount];
+};
+
+const fidl_type_t kEventHandle =
+    fidl_type_t(fidl::FidlCodedHandle(ZX_OBJ_TYPE_EVENT, fidl::kNonnullable));
+const fidl_type_t kEventHandleArray = fidl_type_t(fidl::FidlCodedArray(
+    &kEventHandle, sizeof(zx_handle_t) * kHandleCount, sizeof(zx_handle_t)));
+const fidl::FidlField kHandleArrayFields[] = {
+    fidl::FidlField(&kEventHandleArray, offsetof(HandleArray, handles)),
+};
+const fidl_type_t kHandleArrayType = fidl_type_t(fidl::FidlCodedStruct(
+    kHandleArrayFields, 1u, sizeof(HandleArray), "HandleArray"));
+
+void BuildSmallStruct(fidl::Builder* builder) {
+    SmallStruct* message = builder->New<SmallStruct>();
+    message->data_0 = 1u;
+    message->data_1 = 2u;
+    message->data_2 = 3u;
+}
+
+void BuildVectorOfStrings(fidl::Builder* builder) {
+    VectorOfStrings* message = builder->New<VectorOfStrings>();
+    fidl_string_t* strings = builder->NewArray<fidl_string_t>(kStringCount);
+    message->strings.count = kStringCount;
+    message->strings.data = strings;
+    for (uint32_t i = 0; i < kStringCount; i++) {
+        char* data = builder->NewArray<char>(sizeof(kString) - 1);
+        memcpy(data, kString, sizeof(kString) - 1);
+        strings[i].size = sizeof(kString) - 1;
+        strings[i].data = data;
+    }
+}
+
+void BuildNestedStructs(fidl::Builder* builder) {
+    NestedStructs* message = builder->New<NestedStructs>();
+    Node** link = &message->root;
+    for (uint32_t i = 0; i < kNodeCount; i++) {
+        Node* node = builder->New<Node>();
+        node->data = i;
+        *link = node;
+        link = &node->next;
+    }
+}
+
+void BuildHandleArray(fidl::Builder* builder) {
+    HandleArray* message = builder->New<HandleArray>();
+    for (uint32_t i = 0; i < kHandleCount; i++) {
+        ZX_ASSERT(zx_event_create(0u, &message->handles[i]) == ZX_OK);
+    }
+}
+
+struct MessageShape {
+    const char* name;
+    const fidl_type_t* type;
+    void (*build)(fidl::Builder* builder);
+};
+
+const MessageShape kMessageShapes[] = {
+    {"SmallStruct", &kSmallStructType, BuildSmallStruct},
+    {"VectorOfStrings", &kVectorOfStringsType, BuildVectorOfStrings},
+    {"NestedStructs", &kNestedStructsType, BuildNestedStructs},
+    {"HandleArray", &kHandleArrayType, BuildHandleArray},
+};
+
+// A message of a given shape, in decoded form, along with its storage.
+class TestMessage {
+public:
+    explicit TestMessage(const MessageShape* shape)
+        : type_(shape->type), bytes_(new uint8_t[ZX_CHANNEL_MAX_MSG_BYTES]) {
+        fidl::Builder builder(bytes_.get(), ZX_CHANNEL_MAX_MSG_BYTES);
+        shape->build(&builder);
+        message_ = fidl::Message(builder.Finalize(),
+                                 fidl::HandlePart(handles_, kHandleCount));
+    }
+
+    ~TestMessage() {
+        // Move the handles out of the message so that |message_| closes
+        // them.
+        Encode();
+    }
+
+    void Encode() { ZX_ASSERT(message_.Encode(type_, nullptr) == ZX_OK); }
+    void Decode() { ZX_ASSERT(message_.Decode(type_, nullptr) == ZX_OK); }
+    void Validate() { ZX_ASSERT(message_.Validate(type_, nullptr) == ZX_OK); }
+    void Write(const zx::channel& channel) {
+        ZX_ASSERT(message_.Write(channel.get(), 0u) == ZX_OK);
+    }
+    void Read(const zx::channel& channel) {
+        ZX_ASSERT(message_.Read(channel.get(), 0u) == ZX_OK);
+    }
+
+    uint32_t num_bytes() const { return message_.bytes().actual(); }
+
+private:
+    const fidl_type_t* const type_;
+    fbl::unique_ptr<uint8_t[]> bytes_;
+    zx_handle_t handles_[kHandleCount];
+    fidl::Message message_;
+};
+
+// Measure the times taken to encode a message in place and to decode it
+// again.
+bool EncodeDecodeTest(perftest::RepeatState* state, const MessageShape* shape) {
+    state->DeclareStep("encode");
+    state->DeclareStep("decode");
+
+    TestMessage message(shape);
+    while (state->KeepRunning()) {
+        message.Encode();
+        state->NextStep();
+        message.Decode();
+    }
+    return true;
+}
+
+// Measure the time taken to validate an encoded message.
+bool ValidateTest(perftest::RepeatState* state, const MessageShape* shape) {
+    TestMessage message(shape);
+    message.Encode();
+    state->SetBytesProcessedPerRun(message.num_bytes());
+    while (state->KeepRunning()) {
+        message.Validate();
+    }
+    message.Decode();
+    return true;
+}
+
+// Measure the time taken to send a message through a Zircon channel,
+// including encoding it beforehand and decoding it afterwards.
+bool ChannelRoundTripTest(perftest::RepeatState* state, const MessageShape* shape) {
+    state->DeclareStep("encode");
+    state->DeclareStep("write");
+    state->DeclareStep("read");
+    state->DeclareStep("decode");
+
+    zx::channel channel0;
+    zx::channel channel1;
+    ZX_ASSERT(zx::channel::create(0u, &channel0, &channel1) == ZX_OK);
+
+    TestMessage message(shape);
+    while (state->KeepRunning()) {
+        message.Encode();
+        state->NextStep();
+        message.Write(channel0);
+        state->NextStep();
+        message.Read(channel1);
+        state->NextStep();
+        message.Decode();
+    }
+    return true;
+}
+
+void RegisterTests() {
+    for (const MessageShape& shape : kMessageShapes) {
+        auto name = fbl::StringPrintf("Fidl/EncodeDecode/%s", shape.name);
+        perftest::RegisterTest(name.c_str(), EncodeDecodeTest, &shape);
+        name = fbl::StringPrintf("Fidl/Validate/%s", shape.name);
+        perftest::RegisterTest(name.c_str(), ValidateTest, &shape);
+        name = fbl::StringPrintf("Fidl/ChannelRoundTrip/%s", shape.name);
+        perftest::RegisterTest(name.c_str(), ChannelRoundTripTest, &shape);
+    }
+}
+PERFTEST_CTOR(RegisterTests);
+
+}  // namespace
@@ -0,0 +1,88 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <threads.h>
+
+#include <perftest/perftest.h>
+#include <zircon/assert.h>
+#include <zircon/syscalls.h>
+
+namespace {
+
+// Measure the time taken by zx_futex_wake() when there are no waiters.
+bool FutexWakeNoWaitersTest() {
+    static zx_futex_t futex = 0;
+    ZX_ASSERT(zx_futex_wake(&futex, 1) == ZX_OK);
+    return true;
+}
+
+// Measure the time taken by zx_futex_wait() when the futex's value does
+// not match, so that it returns without blocking.
+bool FutexWaitMismatchTest() {
+    static zx_futex_t futex = 0;
+    ZX_ASSERT(zx_futex_wait(&futex, 1, ZX_TIME_INFINITE) == ZX_ERR_BAD_STATE);
+    return true;
+}
+
+// Whose turn it is, in FutexRoundTripTest.
+enum : zx_futex_t {
+    kMainTurn = 0,
+    kHelperTurn = 1,
+    kQuit = 2,
+};
+
+zx_futex_t Load(const zx_futex_t* futex) {
+    return __atomic_load_n(futex, __ATOMIC_ACQUIRE);
+}
+
+void Store(zx_futex_t* futex, zx_futex_t value) {
+    __atomic_store_n(futex, value, __ATOMIC_RELEASE);
+}
+
+int FutexHelperThread(void* arg) {
+    auto* turn = static_cast<zx_futex_t*>(arg);
+    for (;;) {
+        zx_futex_t value;
+        while ((value = Load(turn)) == kMainTurn) {
+            zx_status_t status = zx_futex_wait(turn, kMainTurn, ZX_TIME_INFINITE);
+            ZX_ASSERT(status == ZX_OK || status == ZX_ERR_BAD_STATE);
+        }
+        if (value == kQuit) {
+            return 0;
+        }
+        Store(turn, kMainTurn);
+        ZX_ASSERT(zx_futex_wake(turn, 1) == ZX_OK);
+    }
+}
+
+// Measure the time taken to wake another thread blocked in
+// zx_futex_wait() and to be woken by it in return.
+bool FutexRoundTripTest(perftest::RepeatState* state) {
+    zx_futex_t turn = kMainTurn;
+    thrd_t thread;
+    ZX_ASSERT(thrd_create(&thread, FutexHelperThread, &turn) == thrd_success);
+
+    while (state->KeepRunning()) {
+        Store(&turn, kHelperTurn);
+        ZX_ASSERT(zx_futex_wake(&turn, 1) == ZX_OK);
+        while (Load(&turn) == kHelperTurn) {
+            zx_status_t status = zx_futex_wait(&turn, kHelperTurn, ZX_TIME_INFINITE);
+            ZX_ASSERT(status == ZX_OK || status == ZX_ERR_BAD_STATE);
+        }
+    }
+
+    Store(&turn, kQuit);
+    ZX_ASSERT(zx_futex_wake(&turn, 1) == ZX_OK);
+    ZX_ASSERT(thrd_join(thread, nullptr) == thrd_success);
+    return true;
+}
+
+void RegisterTests() {
+    perftest::RegisterSimpleTest<FutexWakeNoWaitersTest>("Futex/WakeNoWaiters");
+    perftest::RegisterSimpleTest<FutexWaitMismatchTest>("Futex/WaitMismatch");
+    perftest::RegisterTest("Futex/RoundTrip/CrossThread", FutexRoundTripTest);
+}
+PERFTEST_CTOR(RegisterTests);
+
+}  // namespace
@@ -0,0 +1,176 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stdint.h>
+
+#include <fbl/flat_hash_map.h>
+#include <fbl/intrusive_hash_table.h>
+#include <fbl/intrusive_single_list.h>
+#include <fbl/string_printf.h>
+#include <fbl/unique_ptr.h>
+#include <fbl/vector.h>
+#include <perftest/perftest.h>
+
+namespace {
+
+// Tests compare lookups in fbl::HashTable, whose buckets are intrusive
+// linked lists, with lookups in fbl::FlatHashMap.  The keys are spread out
+// so that neither table gets them in order.
+uint64_t KeyForIndex(size_t index) {
+    return index * 0x9e3779b97f4a7c15ull;
+}
+
+struct Node : public fbl::SinglyLinkedListable<fbl::unique_ptr<Node>> {
+    explicit Node(uint64_t key)
+        : key(key), value(key) {}
+
+    uint64_t GetKey() const { return key; }
+    static size_t GetHash(uint64_t key) {
+        return fbl::DefaultFlatHashTraits<uint64_t>::GetHash(key);
+    }
+
+    uint64_t key;
+    uint64_t value;
+};
+
+// Enough buckets that the chains stay short for all the sizes below.
+using IntrusiveTable = fbl::HashTable<uint64_t, fbl::unique_ptr<Node>,
+                                      fbl::SinglyLinkedList<fbl::unique_ptr<Node>>,
+                                      size_t, 4099>;
+using FlatTable = fbl::FlatHashMap<uint64_t, uint64_t>;
+
+// Test performance of looking up keys which are present in an intrusive
+// hash table of the given size.
+bool IntrusiveFindTest(perftest::RepeatState* state, size_t size) {
+    IntrusiveTable table;
+    for (size_t i = 0; i < size; i++) {
+        table.insert(fbl::unique_ptr<Node>(new Node(KeyForIndex(i))));
+    }
+
+    size_t i = 0;
+    while (state->KeepRunning()) {
+        auto it = table.find(KeyForIndex(i));
+        perftest::DoNotOptimize(it->value);
+        i = (i + 1 == size) ? 0 : i + 1;
+    }
+    return true;
+}
+
+// Test performance of looking up keys which are present in a flat hash
+// map of the given size.
+bool FlatFindTest(perftest::RepeatState* state, size_t size) {
+    FlatTable table;
+    for (size_t i = 0; i < size; i++) {
+        fbl::AllocChecker ac;
+        table.insert_or_find(KeyForIndex(i), KeyForIndex(i), &ac);
+        ZX_ASSERT(ac.check());
+    }
+
+    size_t i = 0;
+    while (state->KeepRunning()) {
+        uint64_t* value = table.find(KeyForIndex(i));
+        perftest::DoNotOptimize(*value);
+        i = (i + 1 == size) ? 0 : i + 1;
+    }
+    return true;
+}
+
+// Test performance of looking up keys which are absent.  These have to
+// walk a whole chain or probe until an empty slot.
+bool IntrusiveFindMissTest(perftest::RepeatState* state, size_t size) {
+    IntrusiveTable table;
+    for (size_t i = 0; i < size; i++) {
+        table.insert(fbl::unique_ptr<Node>(new Node(KeyForIndex(i))));
+    }
+
+    size_t i = size;
+    while (state->KeepRunning()) {
+        bool found = table.find(KeyForIndex(i)).IsValid();
+        perftest::DoNotOptimize(found);
+        i = (i + 1 == 2 * size) ? size : i + 1;
+    }
+    return true;
+}
+
+bool FlatFindMissTest(perftest::RepeatState* state, size_t size) {
+    FlatTable table;
+    for (size_t i = 0; i < size; i++) {
+        fbl::AllocChecker ac;
+        table.insert_or_find(KeyForIndex(i), KeyForIndex(i), &ac);
+        ZX_ASSERT(ac.check());
+    }
+
+    size_t i = size;
+    while (state->KeepRunning()) {
+        bool found = table.find(KeyForIndex(i)) != nullptr;
+        perftest::DoNotOptimize(found);
+        i = (i + 1 == 2 * size) ? size : i + 1;
+    }
+    return true;
+}
+
+// Test performance of filling and then emptying a table.
+bool IntrusiveInsertEraseTest(perftest::RepeatState* state, size_t size) {
+    fbl::Vector<fbl::unique_ptr<Node>> nodes;
+    for (size_t i = 0; i < size; i++) {
+        nodes.push_back(fbl::unique_ptr<Node>(new Node(KeyForIndex(i))));
+    }
+
+    IntrusiveTable table;
+    while (state->KeepRunning()) {
+        for (size_t i = 0; i < size; i++) {
+            table.insert(fbl::move(nodes[i]));
+        }
+        for (size_t i = 0; i < size; i++) {
+            nodes[i] = table.erase(KeyForIndex(i));
+        }
+    }
+    return true;
+}
+
+bool FlatInsertEraseTest(perftest::RepeatState* state, size_t size) {
+    FlatTable table;
+    fbl::AllocChecker ac;
+    table.reserve(size, &ac);
+    ZX_ASSERT(ac.check());
+
+    while (state->KeepRunning()) {
+        for (size_t i = 0; i < size; i++) {
+            table.insert_or_find(KeyForIndex(i), KeyForIndex(i), &ac);
+            ZX_ASSERT(ac.check());
+        }
+        for (size_t i = 0; i < size; i++) {
+            table.erase(KeyForIndex(i));
+        }
+    }
+    return true;
+}
+
+void RegisterTests() {
+    static const size_t kSizes[] = {
+        16,
+        1024,
+        16384,
+    };
+    static const struct {
+        const char* name;
+        bool (*func)(perftest::RepeatState* state, size_t size);
+    } kTests[] = {
+        {"Intrusive/Find", IntrusiveFindTest},
+        {"Flat/Find", FlatFindTest},
+        {"Intrusive/FindMiss", IntrusiveFindMissTest},
+        {"Flat/FindMiss", FlatFindMissTest},
+        {"Intrusive/InsertErase", IntrusiveInsertEraseTest},
+        {"Flat/InsertErase", FlatInsertEraseTest},
+    };
+    for (const auto& test : kTests) {
+        for (auto size : kSizes) {
+            auto name = fbl::StringPrintf("HashTable/%s/%zu", test.name, size);
+            perftest::RegisterTest(name.c_str(), test.func, size);
+        }
+    }
+}
+PERFTEST_CTOR(RegisterTests);
+
+}  // namespace
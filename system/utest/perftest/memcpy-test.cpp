@@ -29,8 +29,15 @@ bool MemcpyTest(perftest::RepeatState* state, size_t size) {
 }
 
 void RegisterTests() {
+    // The small sizes cover each of the size classes the x86-64 string
+    // functions handle without a loop.
     static const size_t kSizesBytes[] = {
+        8,
+        32,
+        128,
+        256,
         1000,
+        4096,
         100000,
     };
     for (auto size : kSizesBytes) {
@@ -0,0 +1,75 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string.h>
+
+#include <digest/digest.h>
+#include <digest/merkle-tree.h>
+#include <fbl/string_printf.h>
+#include <fbl/unique_ptr.h>
+#include <perftest/perftest.h>
+#include <zircon/assert.h>
+
+namespace {
+
+using digest::Digest;
+using digest::MerkleTree;
+
+// Test performance of building the Merkle tree of a blob of the given size,
+// hashing each level on the given number of threads.
+bool MerkleTreeCreateTest(perftest::RepeatState* state, size_t size, size_t threads) {
+    state->SetBytesProcessedPerRun(size);
+
+    fbl::unique_ptr<uint8_t[]> data(new uint8_t[size]);
+    size_t tree_len = MerkleTree::GetTreeLength(size);
+    fbl::unique_ptr<uint8_t[]> tree(new uint8_t[tree_len]);
+    memset(data.get(), 0xff, size);
+
+    Digest digest;
+    while (state->KeepRunning()) {
+        ZX_ASSERT(MerkleTree::CreateParallel(data.get(), size, tree.get(), tree_len,
+                                             &digest, threads) == ZX_OK);
+    }
+    return true;
+}
+
+// Test performance of verifying all of a blob of the given size.
+bool MerkleTreeVerifyTest(perftest::RepeatState* state, size_t size, size_t threads) {
+    state->SetBytesProcessedPerRun(size);
+
+    fbl::unique_ptr<uint8_t[]> data(new uint8_t[size]);
+    size_t tree_len = MerkleTree::GetTreeLength(size);
+    fbl::unique_ptr<uint8_t[]> tree(new uint8_t[tree_len]);
+    memset(data.get(), 0xff, size);
+
+    Digest digest;
+    ZX_ASSERT(MerkleTree::Create(data.get(), size, tree.get(), tree_len, &digest) == ZX_OK);
+    while (state->KeepRunning()) {
+        ZX_ASSERT(MerkleTree::VerifyParallel(data.get(), size, tree.get(), tree_len, 0, size,
+                                             digest, threads) == ZX_OK);
+    }
+    return true;
+}
+
+void RegisterTests() {
+    static const size_t kSizesBytes[] = {
+        1 << 20,
+        16 << 20,
+    };
+    static const size_t kThreads[] = {
+        1,
+        4,
+    };
+    for (auto size : kSizesBytes) {
+        for (auto threads : kThreads) {
+            auto name = fbl::StringPrintf("MerkleTree/Create/%zubytes/%zuthreads", size, threads);
+            perftest::RegisterTest(name.c_str(), MerkleTreeCreateTest, size, threads);
+            name = fbl::StringPrintf("MerkleTree/Verify/%zubytes/%zuthreads", size, threads);
+            perftest::RegisterTest(name.c_str(), MerkleTreeVerifyTest, size, threads);
+        }
+    }
+}
+PERFTEST_CTOR(RegisterTests);
+
+}  // namespace
@@ -4,6 +4,7 @@
 
 #include <threads.h>
 
+#include <fbl/atomic.h>
 #include <perftest/perftest.h>
 
 namespace {
@@ -24,8 +25,49 @@ bool MutexLockUnlockTest(perftest::RepeatState* state) {
     return true;
 }
 
+// Measure the times taken to lock and unlock a C11 mutex with short
+// critical sections while another thread keeps locking and unlocking it
+// too.  Waiting for the mutex is usually cheaper to do by spinning than by
+// sleeping in the kernel in this case.
+bool MutexContendedLockUnlockTest(perftest::RepeatState* state) {
+    state->DeclareStep("lock");
+    state->DeclareStep("unlock");
+
+    struct Contender {
+        mtx_t mutex;
+        fbl::atomic<bool> done{false};
+        uint64_t counter = 0;
+    } contender;
+    ZX_ASSERT(mtx_init(&contender.mutex, mtx_plain) == thrd_success);
+
+    thrd_t thread;
+    auto contend = [](void* arg) -> int {
+        auto* contender = static_cast<Contender*>(arg);
+        while (!contender->done.load()) {
+            ZX_ASSERT(mtx_lock(&contender->mutex) == thrd_success);
+            contender->counter++;
+            ZX_ASSERT(mtx_unlock(&contender->mutex) == thrd_success);
+        }
+        return 0;
+    };
+    ZX_ASSERT(thrd_create(&thread, contend, &contender) == thrd_success);
+
+    while (state->KeepRunning()) {
+        ZX_ASSERT(mtx_lock(&contender.mutex) == thrd_success);
+        contender.counter++;
+        state->NextStep();
+        ZX_ASSERT(mtx_unlock(&contender.mutex) == thrd_success);
+    }
+
+    contender.done.store(true);
+    ZX_ASSERT(thrd_join(thread, nullptr) == thrd_success);
+    mtx_destroy(&contender.mutex);
+    return true;
+}
+
 void RegisterTests() {
     perftest::RegisterTest("MutexLockUnlock", MutexLockUnlockTest);
+    perftest::RegisterTest("MutexContendedLockUnlock", MutexContendedLockUnlockTest);
 }
 PERFTEST_CTOR(RegisterTests);
 
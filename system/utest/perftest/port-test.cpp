@@ -0,0 +1,87 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <threads.h>
+
+#include <lib/zx/port.h>
+#include <perftest/perftest.h>
+#include <zircon/assert.h>
+#include <zircon/syscalls/port.h>
+
+namespace {
+
+zx_port_packet_t MakeUserPacket() {
+    zx_port_packet_t packet = {};
+    packet.type = ZX_PKT_TYPE_USER;
+    return packet;
+}
+
+// Measure the times taken to queue a user packet on a port and to dequeue
+// it again, on one thread.
+bool PortQueueWaitTest(perftest::RepeatState* state) {
+    state->DeclareStep("queue");
+    state->DeclareStep("wait");
+
+    zx::port port;
+    ZX_ASSERT(zx::port::create(0, &port) == ZX_OK);
+    const zx_port_packet_t packet = MakeUserPacket();
+
+    while (state->KeepRunning()) {
+        ZX_ASSERT(port.queue(&packet) == ZX_OK);
+        state->NextStep();
+        zx_port_packet_t received;
+        ZX_ASSERT(port.wait(zx::time::infinite(), &received) == ZX_OK);
+    }
+    return true;
+}
+
+struct PortPair {
+    zx::port ping;
+    zx::port pong;
+};
+
+// Forwards each packet from |ping| to |pong|.  A packet with a nonzero key
+// asks it to exit.
+int PortPongThread(void* arg) {
+    auto* ports = static_cast<PortPair*>(arg);
+    for (;;) {
+        zx_port_packet_t packet;
+        ZX_ASSERT(ports->ping.wait(zx::time::infinite(), &packet) == ZX_OK);
+        if (packet.key != 0) {
+            return 0;
+        }
+        ZX_ASSERT(ports->pong.queue(&packet) == ZX_OK);
+    }
+}
+
+// Measure the time taken to pass a packet to another thread through one
+// port and to get it back through another.
+bool PortRoundTripTest(perftest::RepeatState* state) {
+    PortPair ports;
+    ZX_ASSERT(zx::port::create(0, &ports.ping) == ZX_OK);
+    ZX_ASSERT(zx::port::create(0, &ports.pong) == ZX_OK);
+    thrd_t thread;
+    ZX_ASSERT(thrd_create(&thread, PortPongThread, &ports) == thrd_success);
+
+    const zx_port_packet_t packet = MakeUserPacket();
+    while (state->KeepRunning()) {
+        ZX_ASSERT(ports.ping.queue(&packet) == ZX_OK);
+        zx_port_packet_t received;
+        ZX_ASSERT(ports.pong.wait(zx::time::infinite(), &received) == ZX_OK);
+    }
+
+    zx_port_packet_t quit = MakeUserPacket();
+    quit.key = 1;
+    ZX_ASSERT(ports.ping.queue(&quit) == ZX_OK);
+    ZX_ASSERT(thrd_join(thread, nullptr) == thrd_success);
+    return true;
+}
+
+void RegisterTests() {
+    perftest::RegisterTest("Port/QueueWait", PortQueueWaitTest);
+    perftest::RegisterTest("Port/RoundTrip/CrossThread", PortRoundTripTest);
+}
+PERFTEST_CTOR(RegisterTests);
+
+}  // namespace
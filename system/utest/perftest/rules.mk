@@ -9,17 +9,28 @@ MODULE := $(LOCAL_DIR)
 MODULE_TYPE := usertest
 
 MODULE_SRCS += \
+    $(LOCAL_DIR)/channel-test.cpp \
     $(LOCAL_DIR)/clock-test.cpp \
+    $(LOCAL_DIR)/event-test.cpp \
+    $(LOCAL_DIR)/fidl-test.cpp \
+    $(LOCAL_DIR)/futex-test.cpp \
     $(LOCAL_DIR)/handle-creation-test.cpp \
+    $(LOCAL_DIR)/hash-table-test.cpp \
     $(LOCAL_DIR)/malloc-test.cpp \
     $(LOCAL_DIR)/memcpy-test.cpp \
+    $(LOCAL_DIR)/merkle-tree-test.cpp \
     $(LOCAL_DIR)/mutex-test.cpp \
     $(LOCAL_DIR)/null-test.cpp \
+    $(LOCAL_DIR)/port-test.cpp \
     $(LOCAL_DIR)/process-test.cpp \
     $(LOCAL_DIR)/results-test.cpp \
     $(LOCAL_DIR)/runner-test.cpp \
     $(LOCAL_DIR)/sleep-test.cpp \
+    $(LOCAL_DIR)/string-test.cpp \
     $(LOCAL_DIR)/syscalls-test.cpp \
+    $(LOCAL_DIR)/thread-test.cpp \
+    $(LOCAL_DIR)/vmar-test.cpp \
+    $(LOCAL_DIR)/vmo-test.cpp \
 
 MODULE_NAME := perf-test
 
@@ -29,15 +40,18 @@ MODULE_STATIC_LIBS := \
     system/ulib/async-loop.cpp \
     system/ulib/async.cpp \
     system/ulib/fbl \
+    system/ulib/fidl \
     system/ulib/perftest \
     system/ulib/trace \
     system/ulib/trace-provider \
     system/ulib/zx \
     system/ulib/zxcpp \
+    third_party/ulib/uboringssl \
 
 MODULE_LIBS := \
     system/ulib/async.default \
     system/ulib/c \
+    system/ulib/digest \
     system/ulib/fdio \
     system/ulib/launchpad \
     system/ulib/trace-engine \
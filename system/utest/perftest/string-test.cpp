@@ -0,0 +1,122 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string.h>
+
+#include <fbl/string_printf.h>
+#include <fbl/unique_ptr.h>
+#include <perftest/perftest.h>
+
+namespace {
+
+// Test performance of memmove() between overlapping halves of a buffer,
+// in the direction that has to copy backwards.
+bool MemmoveTest(perftest::RepeatState* state, size_t size) {
+    state->SetBytesProcessedPerRun(size);
+
+    fbl::unique_ptr<char[]> buf(new char[size + 1]);
+    memset(buf.get(), 0, size + 1);
+
+    while (state->KeepRunning()) {
+        memmove(buf.get() + 1, buf.get(), size);
+        perftest::DoNotOptimize(buf.get());
+    }
+    return true;
+}
+
+// Test performance of memset() on a block of the given size.
+bool MemsetTest(perftest::RepeatState* state, size_t size) {
+    state->SetBytesProcessedPerRun(size);
+
+    fbl::unique_ptr<char[]> buf(new char[size]);
+
+    while (state->KeepRunning()) {
+        memset(buf.get(), 0, size);
+        perftest::DoNotOptimize(buf.get());
+    }
+    return true;
+}
+
+// Test performance of memcmp() on two equal blocks, which have to be
+// compared all the way to the end.
+bool MemcmpTest(perftest::RepeatState* state, size_t size) {
+    state->SetBytesProcessedPerRun(size);
+
+    fbl::unique_ptr<char[]> buf1(new char[size]);
+    fbl::unique_ptr<char[]> buf2(new char[size]);
+    memset(buf1.get(), 0, size);
+    memset(buf2.get(), 0, size);
+
+    while (state->KeepRunning()) {
+        perftest::DoNotOptimize(buf1.get());
+        perftest::DoNotOptimize(buf2.get());
+        int result = memcmp(buf1.get(), buf2.get(), size);
+        perftest::DoNotOptimize(result);
+    }
+    return true;
+}
+
+// Test performance of strlen() on a string of the given length.
+bool StrlenTest(perftest::RepeatState* state, size_t size) {
+    state->SetBytesProcessedPerRun(size);
+
+    fbl::unique_ptr<char[]> str(new char[size + 1]);
+    memset(str.get(), 'a', size);
+    str[size] = '\0';
+
+    while (state->KeepRunning()) {
+        perftest::DoNotOptimize(str.get());
+        size_t result = strlen(str.get());
+        perftest::DoNotOptimize(result);
+    }
+    return true;
+}
+
+// Test performance of memchr() on a block which only contains the byte
+// being searched for at its end.
+bool MemchrTest(perftest::RepeatState* state, size_t size) {
+    state->SetBytesProcessedPerRun(size);
+
+    fbl::unique_ptr<char[]> buf(new char[size]);
+    memset(buf.get(), 0, size);
+    buf[size - 1] = 1;
+
+    while (state->KeepRunning()) {
+        perftest::DoNotOptimize(buf.get());
+        void* result = memchr(buf.get(), 1, size);
+        perftest::DoNotOptimize(result);
+    }
+    return true;
+}
+
+void RegisterTests() {
+    static const size_t kSizesBytes[] = {
+        8,
+        32,
+        128,
+        256,
+        1000,
+        4096,
+        100000,
+    };
+    static const struct {
+        const char* name;
+        bool (*func)(perftest::RepeatState* state, size_t size);
+    } kTests[] = {
+        {"Memmove", MemmoveTest},
+        {"Memset", MemsetTest},
+        {"Memcmp", MemcmpTest},
+        {"Strlen", StrlenTest},
+        {"Memchr", MemchrTest},
+    };
+    for (const auto& test : kTests) {
+        for (auto size : kSizesBytes) {
+            auto name = fbl::StringPrintf("%s/%zubytes", test.name, size);
+            perftest::RegisterTest(name.c_str(), test.func, size);
+        }
+    }
+}
+PERFTEST_CTOR(RegisterTests);
+
+}  // namespace
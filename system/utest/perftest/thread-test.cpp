@@ -0,0 +1,37 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <threads.h>
+
+#include <perftest/perftest.h>
+#include <zircon/assert.h>
+
+namespace {
+
+int NopThread(void* arg) {
+    return 0;
+}
+
+// Measure the times taken to create and start a C11 thread which exits at
+// once, and to join it.  This includes allocating and freeing the thread's
+// stacks as well as the kernel's thread creation and teardown.
+bool ThreadCreateJoinTest(perftest::RepeatState* state) {
+    state->DeclareStep("create");
+    state->DeclareStep("join");
+
+    while (state->KeepRunning()) {
+        thrd_t thread;
+        ZX_ASSERT(thrd_create(&thread, NopThread, nullptr) == thrd_success);
+        state->NextStep();
+        ZX_ASSERT(thrd_join(thread, nullptr) == thrd_success);
+    }
+    return true;
+}
+
+void RegisterTests() {
+    perftest::RegisterTest("Thread/CreateJoin", ThreadCreateJoinTest);
+}
+PERFTEST_CTOR(RegisterTests);
+
+}  // namespace
@@ -0,0 +1,53 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <fbl/string_printf.h>
+#include <lib/zx/vmar.h>
+#include <lib/zx/vmo.h>
+#include <perftest/perftest.h>
+#include <zircon/assert.h>
+
+namespace {
+
+// Measure the times taken to map a committed VMO into the root VMAR and to
+// unmap it again.  With |map_range|, mapping also populates the page
+// tables, which otherwise happens on the first access to each page.
+bool VmarMapUnmapTest(perftest::RepeatState* state, size_t size, bool map_range) {
+    state->DeclareStep("map");
+    state->DeclareStep("unmap");
+
+    zx::vmo vmo;
+    ZX_ASSERT(zx::vmo::create(size, 0, &vmo) == ZX_OK);
+    ZX_ASSERT(vmo.op_range(ZX_VMO_OP_COMMIT, 0, size, nullptr, 0) == ZX_OK);
+    zx_vm_option_t options = ZX_VM_PERM_READ | ZX_VM_PERM_WRITE;
+    if (map_range) {
+        options |= ZX_VM_MAP_RANGE;
+    }
+
+    while (state->KeepRunning()) {
+        uintptr_t address;
+        ZX_ASSERT(zx::vmar::root_self()->map(0, vmo, 0, size, options, &address) == ZX_OK);
+        state->NextStep();
+        ZX_ASSERT(zx::vmar::root_self()->unmap(address, size) == ZX_OK);
+    }
+    return true;
+}
+
+void RegisterTests() {
+    static const size_t kSizesBytes[] = {
+        4096,
+        65536,
+        1 << 20,
+    };
+    for (auto size : kSizesBytes) {
+        for (bool map_range : {false, true}) {
+            auto name = fbl::StringPrintf("Vmar/MapUnmap%s/%zubytes",
+                                          map_range ? "/MapRange" : "", size);
+            perftest::RegisterTest(name.c_str(), VmarMapUnmapTest, size, map_range);
+        }
+    }
+}
+PERFTEST_CTOR(RegisterTests);
+
+}  // namespace
@@ -0,0 +1,95 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <fbl/string_printf.h>
+#include <fbl/unique_ptr.h>
+#include <lib/zx/vmo.h>
+#include <perftest/perftest.h>
+#include <zircon/assert.h>
+
+namespace {
+
+// Measure the times taken to create a VMO, to write to all of it, which
+// commits its pages, and to close it.
+bool VmoCreateWriteCloseTest(perftest::RepeatState* state, size_t size) {
+    state->SetBytesProcessedPerRun(size);
+    state->DeclareStep("create");
+    state->DeclareStep("write");
+    state->DeclareStep("close");
+
+    fbl::unique_ptr<char[]> buffer(new char[size]());
+    while (state->KeepRunning()) {
+        zx::vmo vmo;
+        ZX_ASSERT(zx::vmo::create(size, 0, &vmo) == ZX_OK);
+        state->NextStep();
+        ZX_ASSERT(vmo.write(buffer.get(), 0, size) == ZX_OK);
+        state->NextStep();
+        vmo.reset();
+    }
+    return true;
+}
+
+// Measure the time taken to read from or write to a VMO whose pages are
+// all committed already.
+bool VmoReadOrWriteTest(perftest::RepeatState* state, size_t size, bool do_write) {
+    state->SetBytesProcessedPerRun(size);
+
+    zx::vmo vmo;
+    ZX_ASSERT(zx::vmo::create(size, 0, &vmo) == ZX_OK);
+    fbl::unique_ptr<char[]> buffer(new char[size]());
+    ZX_ASSERT(vmo.write(buffer.get(), 0, size) == ZX_OK);
+
+    while (state->KeepRunning()) {
+        if (do_write) {
+            ZX_ASSERT(vmo.write(buffer.get(), 0, size) == ZX_OK);
+        } else {
+            ZX_ASSERT(vmo.read(buffer.get(), 0, size) == ZX_OK);
+        }
+    }
+    return true;
+}
+
+// Measure the times taken to make a copy-on-write clone of a committed
+// VMO and to close the clone.
+bool VmoCloneTest(perftest::RepeatState* state, size_t size) {
+    state->DeclareStep("clone");
+    state->DeclareStep("close");
+
+    zx::vmo vmo;
+    ZX_ASSERT(zx::vmo::create(size, 0, &vmo) == ZX_OK);
+    ZX_ASSERT(vmo.op_range(ZX_VMO_OP_COMMIT, 0, size, nullptr, 0) == ZX_OK);
+
+    while (state->KeepRunning()) {
+        zx::vmo clone;
+        ZX_ASSERT(vmo.clone(ZX_VMO_CLONE_COPY_ON_WRITE, 0, size, &clone) == ZX_OK);
+        state->NextStep();
+        clone.reset();
+    }
+    return true;
+}
+
+void RegisterTests() {
+    static const size_t kSizesBytes[] = {
+        4096,
+        65536,
+        1 << 20,
+    };
+    for (auto size : kSizesBytes) {
+        auto name = fbl::StringPrintf("Vmo/CreateWriteClose/%zubytes", size);
+        perftest::RegisterTest(name.c_str(), VmoCreateWriteCloseTest, size);
+    }
+    for (auto size : kSizesBytes) {
+        for (bool do_write : {false, true}) {
+            auto name = fbl::StringPrintf("Vmo/%s/%zubytes", do_write ? "Write" : "Read", size);
+            perftest::RegisterTest(name.c_str(), VmoReadOrWriteTest, size, do_write);
+        }
+    }
+    for (auto size : kSizesBytes) {
+        auto name = fbl::StringPrintf("Vmo/Clone/%zubytes", size);
+        perftest::RegisterTest(name.c_str(), VmoCloneTest, size);
+    }
+}
+PERFTEST_CTOR(RegisterTests);
+
+}  // namespace
@@ -322,6 +322,46 @@ static bool channel_depth_test(void) {
     END_TEST;
 }
 
+static bool thread_timer_slack_test(void) {
+    BEGIN_TEST;
+
+    zx_handle_t thread = zx_thread_self();
+    zx_duration_t slack = -1;
+    ASSERT_EQ(zx_object_get_property(thread, ZX_PROP_THREAD_TIMER_SLACK,
+                                     &slack, sizeof(slack)), ZX_OK, "");
+    EXPECT_EQ(slack, 0, "default slack");
+
+    slack = ZX_MSEC(5);
+    ASSERT_EQ(zx_object_set_property(thread, ZX_PROP_THREAD_TIMER_SLACK,
+                                     &slack, sizeof(slack)), ZX_OK, "");
+    slack = 0;
+    ASSERT_EQ(zx_object_get_property(thread, ZX_PROP_THREAD_TIMER_SLACK,
+                                     &slack, sizeof(slack)), ZX_OK, "");
+    EXPECT_EQ(slack, ZX_MSEC(5), "");
+
+    // Waits still don't time out early.
+    zx_time_t deadline = zx_deadline_after(ZX_MSEC(1));
+    EXPECT_EQ(zx_object_wait_one(thread, ZX_THREAD_TERMINATED, deadline, NULL),
+              ZX_ERR_TIMED_OUT, "");
+    EXPECT_GE(zx_clock_get_monotonic(), deadline, "");
+
+    slack = -1;
+    EXPECT_EQ(zx_object_set_property(thread, ZX_PROP_THREAD_TIMER_SLACK,
+                                     &slack, sizeof(slack)), ZX_ERR_INVALID_ARGS, "");
+
+    slack = 0;
+    ASSERT_EQ(zx_object_set_property(thread, ZX_PROP_THREAD_TIMER_SLACK,
+                                     &slack, sizeof(slack)), ZX_OK, "");
+
+    zx_handle_t event;
+    ASSERT_EQ(zx_event_create(0, &event), ZX_OK, "");
+    EXPECT_EQ(zx_object_get_property(event, ZX_PROP_THREAD_TIMER_SLACK,
+                                     &slack, sizeof(slack)), ZX_ERR_WRONG_TYPE, "");
+    zx_handle_close(event);
+
+    END_TEST;
+}
+
 #if defined(__x86_64__)
 
 static uintptr_t read_gs(void) {
@@ -448,6 +488,7 @@ RUN_TEST(vmo_name_test);
 RUN_TEST(channel_name_test);
 RUN_TEST(socket_buffer_test);
 RUN_TEST(channel_depth_test);
+RUN_TEST(thread_timer_slack_test);
 #if defined(__x86_64__)
 RUN_TEST(fs_invalid_test)
 RUN_TEST(gs_test)
@@ -576,6 +576,159 @@ bool RamdiskTestFifoBasic(void) {
     END_TEST;
 }
 
+bool RamdiskTestFifoAddFifo(void) {
+    BEGIN_TEST;
+    fbl::unique_ptr<RamdiskTest> ramdisk;
+    ASSERT_TRUE(RamdiskTest::Create(PAGE_SIZE, 512, &ramdisk));
+
+    // Fifos can only be added to a running fifo server
+    zx::fifo fifo;
+    ssize_t expected = sizeof(fifo);
+    ASSERT_EQ(ioctl_block_add_fifo(ramdisk->fd(), fifo.reset_and_get_address()),
+              ZX_ERR_BAD_STATE);
+    ASSERT_EQ(ioctl_block_get_fifos(ramdisk->fd(), fifo.reset_and_get_address()),
+              expected, "Failed to get FIFO");
+    zx::fifo extra_fifo;
+    ASSERT_EQ(ioctl_block_add_fifo(ramdisk->fd(), extra_fifo.reset_and_get_address()),
+              expected, "Failed to add FIFO");
+
+    uint64_t vmo_size = PAGE_SIZE * 3;
+    zx_handle_t vmo;
+    ASSERT_EQ(zx_vmo_create(vmo_size, 0, &vmo), ZX_OK, "Failed to create VMO");
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<uint8_t[]> buf(new (&ac) uint8_t[vmo_size]);
+    ASSERT_TRUE(ac.check());
+    fill_random(buf.get(), vmo_size);
+    ASSERT_EQ(zx_vmo_write(vmo, buf.get(), 0, vmo_size), ZX_OK);
+
+    vmoid_t vmoid;
+    expected = sizeof(vmoid_t);
+    zx_handle_t xfer_vmo;
+    ASSERT_EQ(zx_handle_duplicate(vmo, ZX_RIGHT_SAME_RIGHTS, &xfer_vmo), ZX_OK);
+    ASSERT_EQ(ioctl_block_attach_vmo(ramdisk->fd(), &xfer_vmo, &vmoid), expected,
+              "Failed to attach vmo");
+
+    block_client::Client client;
+    ASSERT_EQ(block_client::Client::Create(fbl::move(fifo), &client), ZX_OK);
+    ASSERT_EQ(client.GroupCount(), static_cast<size_t>(MAX_TXN_GROUP_COUNT));
+    ASSERT_EQ(client.AddFifo(fbl::move(extra_fifo)), ZX_OK);
+    ASSERT_EQ(client.GroupCount(), static_cast<size_t>(2 * MAX_TXN_GROUP_COUNT));
+
+    // Write through a group of the added fifo, using the vmoid attached to
+    // the first one, then read back through the first fifo.
+    block_fifo_request_t requests[2];
+    requests[0].group      = MAX_TXN_GROUP_COUNT;
+    requests[0].vmoid      = vmoid;
+    requests[0].opcode     = BLOCKIO_WRITE;
+    requests[0].length     = 1;
+    requests[0].vmo_offset = 0;
+    requests[0].dev_offset = 0;
+
+    requests[1].group      = MAX_TXN_GROUP_COUNT;
+    requests[1].vmoid      = vmoid;
+    requests[1].opcode     = BLOCKIO_WRITE;
+    requests[1].length     = 2;
+    requests[1].vmo_offset = 1;
+    requests[1].dev_offset = 100;
+
+    ASSERT_EQ(client.Transaction(&requests[0], fbl::count_of(requests)), ZX_OK);
+
+    fbl::unique_ptr<uint8_t[]> out(new (&ac) uint8_t[vmo_size]());
+    ASSERT_TRUE(ac.check());
+    ASSERT_EQ(zx_vmo_write(vmo, out.get(), 0, vmo_size), ZX_OK);
+    for (size_t i = 0; i < fbl::count_of(requests); i++) {
+        requests[i].group = 0;
+        requests[i].opcode = BLOCKIO_READ;
+    }
+    ASSERT_EQ(client.Transaction(&requests[0], fbl::count_of(requests)), ZX_OK);
+    ASSERT_EQ(zx_vmo_read(vmo, out.get(), 0, vmo_size), ZX_OK);
+    ASSERT_EQ(memcmp(buf.get(), out.get(), vmo_size), 0, "Read data not equal to written data");
+
+    // Closing the fifo server closes the added fifo too
+    ASSERT_EQ(ioctl_block_fifo_close(ramdisk->fd()), ZX_OK, "Failed to close fifo");
+    requests[0].group = MAX_TXN_GROUP_COUNT;
+    ASSERT_NE(client.Transaction(&requests[0], 1), ZX_OK);
+
+    ASSERT_EQ(zx_handle_close(vmo), ZX_OK);
+    END_TEST;
+}
+
+bool RamdiskTestFifoPolled(void) {
+    BEGIN_TEST;
+    fbl::unique_ptr<RamdiskTest> ramdisk;
+    ASSERT_TRUE(RamdiskTest::Create(PAGE_SIZE, 512, &ramdisk));
+
+    zx::fifo fifo;
+    ssize_t expected = sizeof(fifo);
+    ASSERT_EQ(ioctl_block_get_fifos(ramdisk->fd(), fifo.reset_and_get_address()),
+              expected, "Failed to get FIFO");
+    groupid_t group = 0;
+
+    uint64_t vmo_size = PAGE_SIZE * 3;
+    zx_handle_t vmo;
+    ASSERT_EQ(zx_vmo_create(vmo_size, 0, &vmo), ZX_OK, "Failed to create VMO");
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<uint8_t[]> buf(new (&ac) uint8_t[vmo_size]);
+    ASSERT_TRUE(ac.check());
+    fill_random(buf.get(), vmo_size);
+    ASSERT_EQ(zx_vmo_write(vmo, buf.get(), 0, vmo_size), ZX_OK);
+
+    vmoid_t vmoid;
+    expected = sizeof(vmoid_t);
+    zx_handle_t xfer_vmo;
+    ASSERT_EQ(zx_handle_duplicate(vmo, ZX_RIGHT_SAME_RIGHTS, &xfer_vmo), ZX_OK);
+    ASSERT_EQ(ioctl_block_attach_vmo(ramdisk->fd(), &xfer_vmo, &vmoid), expected,
+              "Failed to attach vmo");
+
+    block_client::Client client;
+    ASSERT_EQ(block_client::Client::Create(fbl::move(fifo), &client), ZX_OK);
+    ASSERT_EQ(client.EnablePolling(ramdisk->fd(), zx::usec(50)), ZX_OK);
+    ASSERT_EQ(client.EnablePolling(ramdisk->fd(), zx::usec(50)), ZX_ERR_ALREADY_BOUND);
+
+    block_fifo_request_t requests[2];
+    requests[0].group      = group;
+    requests[0].vmoid      = vmoid;
+    requests[0].opcode     = BLOCKIO_WRITE;
+    requests[0].length     = 1;
+    requests[0].vmo_offset = 0;
+    requests[0].dev_offset = 0;
+
+    requests[1].group      = group;
+    requests[1].vmoid      = vmoid;
+    requests[1].opcode     = BLOCKIO_WRITE;
+    requests[1].length     = 2;
+    requests[1].vmo_offset = 1;
+    requests[1].dev_offset = 100;
+
+    // Go around the completion ring a few times, giving the polling thread
+    // time to fall asleep in between.
+    for (size_t i = 0; i < 2 * BLOCK_COMPLETION_RING_SIZE; i++) {
+        requests[0].opcode = BLOCKIO_WRITE;
+        requests[1].opcode = BLOCKIO_WRITE;
+        ASSERT_EQ(client.Transaction(&requests[0], fbl::count_of(requests)), ZX_OK);
+        if (i % 16 == 0) {
+            zx::nanosleep(zx::deadline_after(zx::msec(1)));
+        }
+    }
+
+    fbl::unique_ptr<uint8_t[]> out(new (&ac) uint8_t[vmo_size]());
+    ASSERT_TRUE(ac.check());
+    ASSERT_EQ(zx_vmo_write(vmo, out.get(), 0, vmo_size), ZX_OK);
+    requests[0].opcode = BLOCKIO_READ;
+    requests[1].opcode = BLOCKIO_READ;
+    ASSERT_EQ(client.Transaction(&requests[0], fbl::count_of(requests)), ZX_OK);
+    ASSERT_EQ(zx_vmo_read(vmo, out.get(), 0, vmo_size), ZX_OK);
+    ASSERT_EQ(memcmp(buf.get(), out.get(), vmo_size), 0, "Read data not equal to written data");
+
+    // Bad requests still get their responses
+    requests[0].vmoid = static_cast<vmoid_t>(vmoid + 5);
+    requests[0].opcode = BLOCKIO_READ;
+    ASSERT_EQ(client.Transaction(&requests[0], 1), ZX_ERR_IO);
+
+    ASSERT_EQ(zx_handle_close(vmo), ZX_OK);
+    END_TEST;
+}
+
 bool RamdiskTestFifoNoGroup(void) {
     BEGIN_TEST;
     // Set up the initial handshake connection with the ramdisk
@@ -883,6 +1036,72 @@ bool RamdiskTestFifoMultipleVmoMultithreaded(void) {
     END_TEST;
 }
 
+bool RamdiskTestFifoPerfMultithreaded(void) {
+    BEGIN_TEST;
+    const size_t kBlockSize = PAGE_SIZE;
+    fbl::unique_ptr<RamdiskTest> ramdisk;
+    ASSERT_TRUE(RamdiskTest::Create(kBlockSize, 1 << 12, &ramdisk));
+
+    ramdisk_perf_t perf = {};
+    perf.threads = RAMDISK_MAX_THREADS + 1;
+    ASSERT_EQ(ioctl_ramdisk_set_perf(ramdisk->fd(), &perf), ZX_ERR_INVALID_ARGS);
+    perf.threads = 4;
+    perf.flags = RAMDISK_PERF_FLAG_COMMIT;
+    perf.latency_ns = ZX_USEC(100);
+    perf.max_iops = 100000;
+    ASSERT_EQ(ioctl_ramdisk_set_perf(ramdisk->fd(), &perf), ZX_OK);
+
+    // Sleeping only makes sense one request at a time.
+    uint64_t one = 1;
+    ASSERT_EQ(ioctl_ramdisk_sleep_after(ramdisk->fd(), &one), ZX_ERR_BAD_STATE);
+
+    zx::fifo fifo;
+    ssize_t expected = sizeof(fifo);
+    ASSERT_EQ(ioctl_block_get_fifos(ramdisk->fd(),
+              fifo.reset_and_get_address()), expected, "Failed to get FIFO");
+
+    block_client::Client client;
+    ASSERT_EQ(block_client::Client::Create(fbl::move(fifo), &client), ZX_OK);
+
+    size_t num_threads = MAX_TXN_GROUP_COUNT;
+    fbl::AllocChecker ac;
+    fbl::Array<TestVmoObject> objs(new (&ac) TestVmoObject[num_threads](), num_threads);
+    ASSERT_TRUE(ac.check());
+
+    fbl::Array<thrd_t> threads(new (&ac) thrd_t[num_threads](), num_threads);
+    ASSERT_TRUE(ac.check());
+
+    fbl::Array<TestThreadArg> thread_args(new (&ac) TestThreadArg[num_threads](),
+                                          num_threads);
+    ASSERT_TRUE(ac.check());
+
+    for (size_t i = 0; i < num_threads; i++) {
+        thread_args[i].obj = &objs[i];
+        thread_args[i].i = i;
+        thread_args[i].objs = objs.size();
+        thread_args[i].fd = ramdisk->fd();
+        thread_args[i].client = &client;
+        thread_args[i].group = static_cast<groupid_t>(i);
+        thread_args[i].kBlockSize = kBlockSize;
+        ASSERT_EQ(thrd_create(&threads[i], fifo_vmo_thread, &thread_args[i]),
+                  thrd_success);
+    }
+
+    for (size_t i = 0; i < num_threads; i++) {
+        int res;
+        ASSERT_EQ(thrd_join(threads[i], &res), thrd_success);
+        ASSERT_EQ(res, 0);
+    }
+
+    // Back to one thread, sleeping works again.
+    perf = {};
+    ASSERT_EQ(ioctl_ramdisk_set_perf(ramdisk->fd(), &perf), ZX_OK);
+    ASSERT_EQ(ioctl_ramdisk_sleep_after(ramdisk->fd(), &one), ZX_OK);
+    ASSERT_EQ(ioctl_ramdisk_wake_up(ramdisk->fd()), ZX_OK);
+
+    END_TEST;
+}
+
 bool RamdiskTestFifoUncleanShutdown(void) {
     BEGIN_TEST;
     // Set up the ramdisk
@@ -1591,8 +1810,11 @@ RUN_TEST_SMALL(RamdiskTestMultiple)
 RUN_TEST_SMALL(RamdiskTestFifoNoOp)
 RUN_TEST_SMALL(RamdiskTestFifoBasic)
 RUN_TEST_SMALL(RamdiskTestFifoNoGroup)
+RUN_TEST_SMALL(RamdiskTestFifoAddFifo)
+RUN_TEST_SMALL(RamdiskTestFifoPolled)
 RUN_TEST_SMALL(RamdiskTestFifoMultipleVmo)
 RUN_TEST_SMALL(RamdiskTestFifoMultipleVmoMultithreaded)
+RUN_TEST_SMALL(RamdiskTestFifoPerfMultithreaded)
 // TODO(smklein): Test ops across different vmos
 RUN_TEST_SMALL(RamdiskTestFifoUncleanShutdown)
 RUN_TEST_SMALL(RamdiskTestFifoLargeOpsCount)
@@ -0,0 +1,452 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <zircon/process.h>
+#include <zircon/syscalls.h>
+
+#include <unittest/unittest.h>
+
+// Each function is checked against a byte loop at every size up to
+// SMALL_SIZE_MAX, which takes in all the size classes of the vector
+// versions, and at sizes around the thresholds above which memcpy, memmove
+// and memset use "rep movsb" and "rep stosb". At the small sizes every
+// buffer is placed at every offset within the widest vector (AVX2).
+
+#define SMALL_SIZE_MAX 1100
+#define ALIGN_MAX 32
+#define LARGE_SIZE_MAX (65536 + 7)
+
+// untouched bytes kept on both sides of every destination
+#define GUARD 64
+
+#define BUF_SIZE (GUARD + ALIGN_MAX + 2 * LARGE_SIZE_MAX + GUARD)
+
+#define SRC_SEED 0x01
+#define DST_SEED 0x80
+
+static const size_t large_sizes[] = {
+    2047, 2048, 2049, 4095, 4096, 4097, 8191, 8192, 8193, LARGE_SIZE_MAX,
+};
+static const size_t large_aligns[] = {0, 1, 15, 16, 31};
+
+static uint8_t src_buf[BUF_SIZE];
+static uint8_t dst_buf[BUF_SIZE];
+static uint8_t ref_buf[BUF_SIZE];
+
+// Doesn't repeat within a buffer, so that bytes copied from the wrong
+// place are caught.
+static uint8_t pattern(size_t i, uint8_t seed) {
+    return (uint8_t)((i * 7) ^ (i >> 8) ^ (i >> 16) ^ seed);
+}
+
+static void fill(uint8_t* buf, size_t len, uint8_t seed) {
+    for (size_t i = 0; i < len; i++) {
+        buf[i] = pattern(i, seed);
+    }
+}
+
+static void ref_memmove(uint8_t* d, const uint8_t* s, size_t n) {
+    if (d < s) {
+        for (size_t i = 0; i < n; i++) {
+            d[i] = s[i];
+        }
+    } else {
+        for (size_t i = n; i-- > 0;) {
+            d[i] = s[i];
+        }
+    }
+}
+
+static int ref_memcmp(const uint8_t* a, const uint8_t* b, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (a[i] != b[i]) {
+            return a[i] < b[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+static size_t ref_strlen(const uint8_t* s) {
+    size_t n = 0;
+    while (s[n]) {
+        n++;
+    }
+    return n;
+}
+
+static const uint8_t* ref_memchr(const uint8_t* s, uint8_t c, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (s[i] == c) {
+            return s + i;
+        }
+    }
+    return NULL;
+}
+
+static int sign(int x) {
+    return (x > 0) - (x < 0);
+}
+
+// Checks that the first |len| bytes of dst_buf hold the pattern, apart from
+// the |n| bytes at |start|, which must match |expected|, and puts the
+// pattern back.
+static bool check_dst(const char* name, size_t start, const uint8_t* expected, size_t n,
+                      size_t len) {
+    bool ok = true;
+    for (size_t i = 0; i < len && ok; i++) {
+        uint8_t want = (i >= start && i - start < n) ? expected[i - start] : pattern(i, DST_SEED);
+        if (dst_buf[i] != want) {
+            unittest_printf_critical("\n%s of %zu bytes to offset %zu: byte %zu is 0x%02x, "
+                                     "not 0x%02x\n",
+                                     name, n, start - GUARD, i, dst_buf[i], want);
+            ok = false;
+        }
+    }
+    for (size_t i = 0; i < n; i++) {
+        dst_buf[start + i] = pattern(start + i, DST_SEED);
+    }
+    return ok;
+}
+
+typedef void* (*copy_fn)(void*, const void*, size_t);
+
+// Copies |n| bytes from offset |src_align| of src_buf to offset |dst_align|
+// of dst_buf and checks that the copy, and nothing but the copy, landed.
+static bool check_copy(const char* name, copy_fn fn, size_t n, size_t src_align,
+                       size_t dst_align) {
+    const uint8_t* s = src_buf + src_align;
+    size_t start = GUARD + dst_align;
+    void* ret = fn(dst_buf + start, s, n);
+    if (ret != dst_buf + start) {
+        unittest_printf_critical("\n%s returned %p instead of %p\n", name, ret,
+                                 dst_buf + start);
+        return false;
+    }
+    return check_dst(name, start, s, n, start + n + GUARD);
+}
+
+static bool check_copies(const char* name, copy_fn fn) {
+    BEGIN_HELPER;
+    fill(src_buf, sizeof(src_buf), SRC_SEED);
+    fill(dst_buf, sizeof(dst_buf), DST_SEED);
+
+    for (size_t n = 0; n <= SMALL_SIZE_MAX; n++) {
+        for (size_t src_align = 0; src_align < ALIGN_MAX; src_align++) {
+            for (size_t dst_align = 0; dst_align < ALIGN_MAX; dst_align++) {
+                ASSERT_TRUE(check_copy(name, fn, n, src_align, dst_align), "small copy");
+            }
+        }
+    }
+    for (size_t i = 0; i < countof(large_sizes); i++) {
+        for (size_t j = 0; j < countof(large_aligns); j++) {
+            for (size_t k = 0; k < countof(large_aligns); k++) {
+                ASSERT_TRUE(check_copy(name, fn, large_sizes[i], large_aligns[j],
+                                       large_aligns[k]),
+                            "large copy");
+            }
+        }
+    }
+    END_HELPER;
+}
+
+// Moves |n| bytes from offset |src| to offset |dst| within dst_buf, and
+// checks the result against a byte loop doing the same in ref_buf.
+static bool check_overlap(size_t n, size_t src, size_t dst) {
+    size_t len = GUARD + (src > dst ? src : dst) + n + GUARD;
+    fill(dst_buf, len, DST_SEED);
+    fill(ref_buf, len, DST_SEED);
+
+    void* ret = memmove(dst_buf + GUARD + dst, dst_buf + GUARD + src, n);
+    ref_memmove(ref_buf + GUARD + dst, ref_buf + GUARD + src, n);
+    if (ret != dst_buf + GUARD + dst) {
+        unittest_printf_critical("\nmemmove returned %p instead of %p\n", ret,
+                                 dst_buf + GUARD + dst);
+        return false;
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (dst_buf[i] != ref_buf[i]) {
+            unittest_printf_critical("\nmemmove of %zu bytes from offset %zu to offset %zu: "
+                                     "byte %zu is 0x%02x, not 0x%02x\n",
+                                     n, src, dst, i, dst_buf[i], ref_buf[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Overlaps of up to a few vectors, and of half and all but one byte of the
+// range, in both directions.
+static bool check_overlaps(size_t n, size_t align) {
+    BEGIN_HELPER;
+    const size_t deltas[] = {
+        0, 1, 2, 3, 7, 8, 15, 16, 17, 31, 32, 33, 63, 64, 65, 127, 128, 129, n / 2, n - 1,
+    };
+    for (size_t i = 0; i < countof(deltas); i++) {
+        size_t delta = deltas[i];
+        if (delta >= n && delta != 0) {
+            continue;
+        }
+        ASSERT_TRUE(check_overlap(n, align, align + delta), "backward overlap");
+        ASSERT_TRUE(check_overlap(n, align + delta, align), "forward overlap");
+    }
+    END_HELPER;
+}
+
+static bool check_memset(size_t n, size_t align, int c) {
+    size_t start = GUARD + align;
+    for (size_t i = 0; i < n; i++) {
+        ref_buf[i] = (uint8_t)c;
+    }
+    void* ret = memset(dst_buf + start, c, n);
+    if (ret != dst_buf + start) {
+        unittest_printf_critical("\nmemset returned %p instead of %p\n", ret,
+                                 dst_buf + start);
+        return false;
+    }
+    return check_dst("memset", start, ref_buf, n, start + n + GUARD);
+}
+
+// Compares the |n| bytes at |a| and |b| both ways round and checks that
+// memcmp agrees with a byte loop on the sign of the result.
+static bool check_memcmp(const uint8_t* a, const uint8_t* b, size_t n) {
+    int got = sign(memcmp(a, b, n));
+    int want = ref_memcmp(a, b, n);
+    int got_reversed = sign(memcmp(b, a, n));
+    if (got != want || got_reversed != -want) {
+        unittest_printf_critical("\nmemcmp of %zu bytes at %p and %p gave %d and %d, "
+                                 "not %d and %d\n",
+                                 n, a, b, got, got_reversed, want, -want);
+        return false;
+    }
+    return true;
+}
+
+// Fills dst_buf so that each byte at offset |b_align| + i is the byte at
+// offset |a_align| + i of src_buf.
+static void fill_shifted(size_t a_align, size_t b_align) {
+    for (size_t i = 0; i < GUARD + ALIGN_MAX + SMALL_SIZE_MAX + GUARD; i++) {
+        dst_buf[i] = pattern(i + a_align - b_align, SRC_SEED);
+    }
+}
+
+static bool check_memcmps(size_t n, size_t a_align, size_t b_align) {
+    BEGIN_HELPER;
+    const uint8_t* a = src_buf + a_align;
+    uint8_t* b = dst_buf + b_align;
+
+    // the bytes right after the range differ, so reading them is caught
+    b[n] ^= 1;
+    EXPECT_TRUE(check_memcmp(a, b, n), "equal ranges");
+    const size_t diffs[] = {0, n - 1, (a_align * ALIGN_MAX + b_align) % (n ? n : 1)};
+    for (size_t i = 0; i < countof(diffs) && n > 0; i++) {
+        // flipping the top bit checks the bytes are compared unsigned
+        b[diffs[i]] ^= 0x80;
+        EXPECT_TRUE(check_memcmp(a, b, n), "one byte differs");
+        b[diffs[i]] ^= 0x80;
+    }
+    b[n] ^= 1;
+    END_HELPER;
+}
+
+static bool memcpy_test(void) {
+    BEGIN_TEST;
+    ASSERT_TRUE(check_copies("memcpy", memcpy), "memcpy");
+    END_TEST;
+}
+
+static bool memmove_test(void) {
+    BEGIN_TEST;
+    ASSERT_TRUE(check_copies("memmove", memmove), "memmove");
+    END_TEST;
+}
+
+static bool memmove_overlap_test(void) {
+    BEGIN_TEST;
+    for (size_t n = 0; n <= SMALL_SIZE_MAX; n++) {
+        // the offset goes round all the alignments as the size grows
+        ASSERT_TRUE(check_overlaps(n, n % ALIGN_MAX), "small overlap");
+    }
+    // overlapping moves must not take the "rep movsb" path, which only
+    // copies forwards
+    for (size_t i = 0; i < countof(large_sizes); i++) {
+        for (size_t j = 0; j < countof(large_aligns); j++) {
+            ASSERT_TRUE(check_overlaps(large_sizes[i], large_aligns[j]), "large overlap");
+        }
+    }
+    END_TEST;
+}
+
+static bool memset_test(void) {
+    BEGIN_TEST;
+    fill(dst_buf, sizeof(dst_buf), DST_SEED);
+
+    // only the low byte of the value is stored
+    const int values[] = {0, 0x5a, 0xa5, 0xff, 0x3c3};
+    for (size_t v = 0; v < countof(values); v++) {
+        for (size_t n = 0; n <= SMALL_SIZE_MAX; n++) {
+            for (size_t align = 0; align < ALIGN_MAX; align++) {
+                ASSERT_TRUE(check_memset(n, align, values[v]), "small memset");
+            }
+        }
+        for (size_t i = 0; i < countof(large_sizes); i++) {
+            for (size_t j = 0; j < countof(large_aligns); j++) {
+                ASSERT_TRUE(check_memset(large_sizes[i], large_aligns[j], values[v]),
+                            "large memset");
+            }
+        }
+    }
+    END_TEST;
+}
+
+static bool memcmp_test(void) {
+    BEGIN_TEST;
+    fill(src_buf, sizeof(src_buf), SRC_SEED);
+
+    for (size_t a_align = 0; a_align < ALIGN_MAX; a_align++) {
+        for (size_t b_align = 0; b_align < ALIGN_MAX; b_align++) {
+            fill_shifted(a_align, b_align);
+            for (size_t n = 0; n <= SMALL_SIZE_MAX; n++) {
+                ASSERT_TRUE(check_memcmps(n, a_align, b_align), "memcmp");
+            }
+        }
+    }
+    END_TEST;
+}
+
+static bool strlen_test(void) {
+    BEGIN_TEST;
+    // no zero bytes, and plenty with the top bit set
+    for (size_t i = 0; i < sizeof(dst_buf); i++) {
+        dst_buf[i] = pattern(i, DST_SEED) | 1;
+    }
+
+    for (size_t align = 0; align < ALIGN_MAX; align++) {
+        for (size_t n = 0; n <= SMALL_SIZE_MAX; n++) {
+            uint8_t* s = dst_buf + align;
+            uint8_t saved = s[n];
+            s[n] = 0;
+            size_t got = strlen((const char*)s);
+            size_t want = ref_strlen(s);
+            s[n] = saved;
+            ASSERT_EQ(got, want, "strlen");
+        }
+    }
+    END_TEST;
+}
+
+static bool memchr_test(void) {
+    BEGIN_TEST;
+    const uint8_t chars[] = {0x00, 0x01, 0x7f, 0x80, 0xff};
+    for (size_t c = 0; c < countof(chars); c++) {
+        // leave |chars[c]| out of the buffer, so that it's found only where
+        // it's put below
+        for (size_t i = 0; i < sizeof(dst_buf); i++) {
+            uint8_t b = pattern(i, DST_SEED);
+            dst_buf[i] = b == chars[c] ? (uint8_t)(b ^ 0x10) : b;
+        }
+
+        for (size_t align = 0; align < ALIGN_MAX; align++) {
+            for (size_t n = 0; n <= SMALL_SIZE_MAX; n++) {
+                uint8_t* s = dst_buf + align;
+                uint8_t saved_end = s[n];
+                // right after the range, where it mustn't be found
+                s[n] = chars[c];
+
+                // |n| means not in the range at all
+                const size_t positions[] = {n, 0, n - 1, n / 2, (align * 37) % (n ? n : 1)};
+                for (size_t p = 0; p < countof(positions); p++) {
+                    size_t pos = positions[p];
+                    if (pos > n) {
+                        continue;
+                    }
+                    uint8_t saved = s[pos];
+                    s[pos] = chars[c];
+                    // only the low byte of the value is looked for
+                    int value = (p % 2) ? chars[c] | 0x100 : chars[c];
+                    const void* got = memchr(s, value, n);
+                    const void* want = ref_memchr(s, chars[c], n);
+                    s[pos] = saved;
+                    ASSERT_EQ((uintptr_t)got, (uintptr_t)want, "memchr");
+                }
+                s[n] = saved_end;
+            }
+        }
+    }
+    END_TEST;
+}
+
+// The vector versions read whole vectors, but must never touch the page
+// after the end of a buffer, so these put the end of each buffer at the
+// end of a page with nothing mapped after it.
+static bool page_end_test(void) {
+    BEGIN_TEST;
+    zx_handle_t vmar;
+    uintptr_t addr;
+    ASSERT_EQ(zx_vmar_allocate(zx_vmar_root_self(),
+                               ZX_VM_CAN_MAP_READ | ZX_VM_CAN_MAP_WRITE |
+                                   ZX_VM_CAN_MAP_SPECIFIC,
+                               0, 2 * PAGE_SIZE, &vmar, &addr),
+              ZX_OK, "");
+    zx_handle_t vmo;
+    ASSERT_EQ(zx_vmo_create(PAGE_SIZE, 0, &vmo), ZX_OK, "");
+    ASSERT_EQ(zx_vmar_map(vmar, ZX_VM_PERM_READ | ZX_VM_PERM_WRITE | ZX_VM_SPECIFIC, 0, vmo,
+                          0, PAGE_SIZE, &addr),
+              ZX_OK, "");
+    zx_handle_close(vmo);
+    uint8_t* page = (uint8_t*)addr;
+    uint8_t* end = page + PAGE_SIZE;
+    for (size_t i = 0; i < PAGE_SIZE; i++) {
+        page[i] = pattern(i, SRC_SEED) | 1;
+    }
+    fill(dst_buf, sizeof(dst_buf), DST_SEED);
+
+    for (size_t n = 0; n <= SMALL_SIZE_MAX; n++) {
+        const uint8_t* s = end - n;
+        size_t start = GUARD + n % ALIGN_MAX;
+        memcpy(dst_buf + start, s, n);
+        ASSERT_TRUE(check_dst("memcpy", start, s, n, start + n + GUARD), "memcpy");
+
+        // a copy of the range in ref_buf compares equal
+        ref_memmove(ref_buf, s, n);
+        ASSERT_EQ(memcmp(s, ref_buf, n), 0, "memcmp");
+        ASSERT_EQ(memcmp(ref_buf, s, n), 0, "memcmp");
+
+        const uint8_t absent = 0;
+        ASSERT_NULL(memchr(s, absent, n), "memchr");
+
+        if (n > 0) {
+            uint8_t* str = end - n;
+            uint8_t saved = end[-1];
+            end[-1] = 0;
+            size_t len = strlen((const char*)str);
+            end[-1] = saved;
+            ASSERT_EQ(len, n - 1, "strlen");
+        }
+    }
+
+    zx_vmar_destroy(vmar);
+    zx_handle_close(vmar);
+    END_TEST;
+}
+
+BEGIN_TEST_CASE(string_tests)
+RUN_TEST(memcpy_test)
+RUN_TEST(memmove_test)
+RUN_TEST(memmove_overlap_test)
+RUN_TEST(memset_test)
+RUN_TEST(memcmp_test)
+RUN_TEST(strlen_test)
+RUN_TEST(memchr_test)
+RUN_TEST(page_end_test)
+END_TEST_CASE(string_tests)
+
+int main(int argc, char** argv) {
+    return unittest_run_all_tests(argc, argv) ? 0 : -1;
+}
@@ -12,6 +12,7 @@ MODULE_SRCS += \
     $(LOCAL_DIR)/main.c \
     $(LOCAL_DIR)/syslog_tests.c \
     $(LOCAL_DIR)/syslog_socket_tests.cpp \
+    $(LOCAL_DIR)/syslog_ring_tests.cpp \
 
 MODULE_NAME := syslog-test
 
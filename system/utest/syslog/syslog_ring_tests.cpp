@@ -0,0 +1,216 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <fbl/type_support.h>
+#include <lib/syslog/global.h>
+#include <lib/syslog/wire_format.h>
+#include <lib/zx/vmar.h>
+#include <lib/zx/vmo.h>
+#include <unittest/unittest.h>
+
+#include <string.h>
+
+__BEGIN_CDECLS
+
+// This does not come from header file as this function should only be used in
+// tests and is not for general use.
+void fx_log_reset_global(void);
+
+__END_CDECLS
+
+namespace {
+
+constexpr uint32_t kDataSize = FX_LOG_RING_MIN_DATA_SIZE;
+constexpr size_t kVmoSize = FX_LOG_RING_DATA_OFFSET + kDataSize;
+
+class Cleanup {
+public:
+    Cleanup() { fx_log_reset_global(); }
+    ~Cleanup() { fx_log_reset_global(); }
+};
+
+// Plays the part of the log service: creates a ring, hands it to the global
+// logger and reads records back out.
+class RingReader {
+public:
+    ~RingReader() {
+        if (header_ != nullptr) {
+            zx::vmar::root_self()->unmap(reinterpret_cast<uintptr_t>(header_), kVmoSize);
+        }
+    }
+
+    bool Init() {
+        BEGIN_HELPER;
+        ASSERT_EQ(ZX_OK, zx::vmo::create(kVmoSize, 0, &vmo_));
+        uintptr_t addr;
+        ASSERT_EQ(ZX_OK, zx::vmar::root_self()->map(0, vmo_, 0, kVmoSize,
+                                                    ZX_VM_PERM_READ | ZX_VM_PERM_WRITE, &addr));
+        header_ = reinterpret_cast<fx_log_ring_header_t*>(addr);
+        header_->data_size = kDataSize;
+        __atomic_store_n(&header_->magic, FX_LOG_RING_MAGIC, __ATOMIC_RELEASE);
+
+        zx::vmo dup;
+        ASSERT_EQ(ZX_OK, vmo_.duplicate(ZX_RIGHT_SAME_RIGHTS, &dup));
+        fx_logger_config_t config = {.min_severity = FX_LOG_INFO,
+                                     .console_fd = -1,
+                                     .log_service_channel = dup.release(),
+                                     .tags = nullptr,
+                                     .num_tags = 0};
+        ASSERT_EQ(ZX_OK, fx_log_init_with_config(&config));
+        END_HELPER;
+    }
+
+    // Copies the next record into |packet|, skipping padding.  Returns
+    // false if there is none.
+    bool Read(fx_log_packet_t* packet) {
+        char* data = reinterpret_cast<char*>(header_) + FX_LOG_RING_DATA_OFFSET;
+        for (;;) {
+            uint64_t tail = __atomic_load_n(&header_->tail, __ATOMIC_RELAXED);
+            char* record = data + (tail & (kDataSize - 1));
+            uint32_t word = __atomic_load_n(reinterpret_cast<uint32_t*>(record),
+                                            __ATOMIC_ACQUIRE);
+            if (word == 0) {
+                return false;
+            }
+            uint32_t len = word & FX_LOG_RING_RECORD_LEN_MASK;
+            bool pad = (word & FX_LOG_RING_RECORD_PAD_FLAG) != 0;
+            if (!pad) {
+                memset(packet, 0, sizeof(*packet));
+                memcpy(packet, record + FX_LOG_RING_RECORD_HEADER_LEN,
+                       len - FX_LOG_RING_RECORD_HEADER_LEN);
+            }
+            memset(record, 0, len);
+            __atomic_store_n(&header_->tail, tail + len, __ATOMIC_RELEASE);
+            if (!pad) {
+                return true;
+            }
+        }
+    }
+
+    fx_log_ring_header_t* header() { return header_; }
+    const zx::vmo& vmo() { return vmo_; }
+
+private:
+    zx::vmo vmo_;
+    fx_log_ring_header_t* header_ = nullptr;
+};
+
+// Returns the message of |packet|, past its tags.
+const char* PacketMessage(const fx_log_packet_t* packet) {
+    size_t pos = 0;
+    while (packet->data[pos] != 0) {
+        pos += packet->data[pos] + 1;
+    }
+    return packet->data + pos + 1;
+}
+
+bool TestRingWrite(void) {
+    BEGIN_TEST;
+    Cleanup cleanup;
+    RingReader reader;
+    ASSERT_TRUE(reader.Init());
+
+    FX_LOGF(INFO, nullptr, "%d, %s", 10, "just some number");
+    FX_LOG(WARNING, "tag", "second message");
+
+    fx_log_packet_t packet;
+    ASSERT_TRUE(reader.Read(&packet));
+    EXPECT_EQ(FX_LOG_INFO, packet.metadata.severity);
+    EXPECT_STR_EQ("10, just some number", PacketMessage(&packet), "");
+    ASSERT_TRUE(reader.Read(&packet));
+    EXPECT_EQ(FX_LOG_WARNING, packet.metadata.severity);
+    EXPECT_EQ(3, packet.data[0]);
+    EXPECT_STR_EQ("second message", PacketMessage(&packet), "");
+    EXPECT_FALSE(reader.Read(&packet));
+    END_TEST;
+}
+
+bool TestRingWrapAndOverflow(void) {
+    BEGIN_TEST;
+    Cleanup cleanup;
+    RingReader reader;
+    ASSERT_TRUE(reader.Init());
+
+    // Fill the ring until writes are dropped.
+    char msg[300];
+    memset(msg, 'x', sizeof(msg) - 1);
+    msg[sizeof(msg) - 1] = 0;
+    int written = 0;
+    while (fx_logger_log(fx_log_get_logger(), FX_LOG_INFO, nullptr, msg) == ZX_OK) {
+        written++;
+        ASSERT_LT(written, 100);
+    }
+    EXPECT_GT(written, 1);
+    EXPECT_EQ(1u, __atomic_load_n(&reader.header()->dropped, __ATOMIC_RELAXED));
+
+    // Draining the ring makes room again, and records wrap around the end
+    // of the data area.
+    fx_log_packet_t packet;
+    for (int round = 0; round < 3; round++) {
+        int read = 0;
+        while (reader.Read(&packet)) {
+            EXPECT_STR_EQ(msg, PacketMessage(&packet), "");
+            // Records written after the drop say how many were lost.
+            EXPECT_EQ(round == 0 ? 0u : 1u, packet.metadata.dropped_logs);
+            read++;
+        }
+        EXPECT_EQ(written, read);
+        for (int i = 0; i < written; i++) {
+            ASSERT_EQ(ZX_OK, fx_logger_log(fx_log_get_logger(), FX_LOG_INFO, nullptr, msg));
+        }
+    }
+    END_TEST;
+}
+
+bool TestRingDoorbell(void) {
+    BEGIN_TEST;
+    Cleanup cleanup;
+    RingReader reader;
+    ASSERT_TRUE(reader.Init());
+
+    // Nobody is rung while the reader is awake.
+    FX_LOG(INFO, nullptr, "awake");
+    zx_signals_t pending;
+    EXPECT_EQ(ZX_ERR_TIMED_OUT, reader.vmo().wait_one(ZX_USER_SIGNAL_0, zx::time(), &pending));
+
+    __atomic_store_n(&reader.header()->reader_idle, 1, __ATOMIC_SEQ_CST);
+    FX_LOG(INFO, nullptr, "asleep");
+    EXPECT_EQ(ZX_OK, reader.vmo().wait_one(ZX_USER_SIGNAL_0, zx::time(), &pending));
+    EXPECT_EQ(0u, __atomic_load_n(&reader.header()->reader_idle, __ATOMIC_SEQ_CST));
+
+    fx_log_packet_t packet;
+    ASSERT_TRUE(reader.Read(&packet));
+    EXPECT_STR_EQ("awake", PacketMessage(&packet), "");
+    ASSERT_TRUE(reader.Read(&packet));
+    EXPECT_STR_EQ("asleep", PacketMessage(&packet), "");
+    END_TEST;
+}
+
+bool TestRingBadHeader(void) {
+    BEGIN_TEST;
+    Cleanup cleanup;
+
+    // A VMO which does not hold a ring leaves the logger with nowhere to
+    // write.
+    zx::vmo vmo;
+    ASSERT_EQ(ZX_OK, zx::vmo::create(kVmoSize, 0, &vmo));
+    fx_logger_config_t config = {.min_severity = FX_LOG_INFO,
+                                 .console_fd = -1,
+                                 .log_service_channel = vmo.release(),
+                                 .tags = nullptr,
+                                 .num_tags = 0};
+    ASSERT_EQ(ZX_OK, fx_log_init_with_config(&config));
+    EXPECT_EQ(ZX_ERR_BAD_STATE,
+              fx_logger_log(fx_log_get_logger(), FX_LOG_INFO, nullptr, "lost"));
+    END_TEST;
+}
+
+} // namespace
+
+BEGIN_TEST_CASE(syslog_ring_tests)
+RUN_TEST(TestRingWrite)
+RUN_TEST(TestRingWrapAndOverflow)
+RUN_TEST(TestRingDoorbell)
+RUN_TEST(TestRingBadHeader)
+END_TEST_CASE(syslog_ring_tests)
@@ -220,6 +220,30 @@ static bool coalesce_test_late() {
     return coalesce_test(ZX_TIMER_SLACK_LATE);
 }
 
+// zx_clock_get and zx_clock_get_monotonic can be answered by the vDSO
+// without entering the kernel, while zx_clock_get_new always asks the
+// kernel.  Interleaving them must never make time go backwards.
+static bool vdso_clock_matches_kernel() {
+    BEGIN_TEST;
+
+    for (int i = 0; i < 1000; ++i) {
+        zx_time_t kernel_mono, kernel_utc;
+        zx_time_t before = zx_clock_get_monotonic();
+        ASSERT_EQ(zx_clock_get_new(ZX_CLOCK_MONOTONIC, &kernel_mono), ZX_OK);
+        zx_time_t after = zx_clock_get(ZX_CLOCK_MONOTONIC);
+        EXPECT_LE(before, kernel_mono);
+        EXPECT_LE(kernel_mono, after);
+
+        before = zx_clock_get(ZX_CLOCK_UTC);
+        ASSERT_EQ(zx_clock_get_new(ZX_CLOCK_UTC, &kernel_utc), ZX_OK);
+        after = zx_clock_get(ZX_CLOCK_UTC);
+        EXPECT_LE(before, kernel_utc);
+        EXPECT_LE(kernel_utc, after);
+    }
+
+    END_TEST;
+}
+
 BEGIN_TEST_CASE(timers_test)
 RUN_TEST(deadline_after)
 RUN_TEST(timer_set_negative_deadline)
@@ -233,6 +257,7 @@ RUN_TEST(restart_test)
 RUN_TEST(edge_cases)
 RUN_TEST(restart_race)
 RUN_TEST(signals_asserted_immediately)
+RUN_TEST(vdso_clock_matches_kernel)
 END_TEST_CASE(timers_test)
 
 int main(int argc, char** argv) {
@@ -8,6 +8,7 @@
 
 #include <fbl/algorithm.h>
 #include <fbl/vector.h>
+#include <trace-engine/fields.h>
 #include <unittest/unittest.h>
 
 namespace {
@@ -178,6 +179,39 @@ bool empty_buffer_test() {
     END_TEST;
 }
 
+bool padding_record_test() {
+    BEGIN_TEST;
+
+    fbl::Vector<trace::Record> records;
+    fbl::String error;
+    trace::TraceReader reader(MakeRecordConsumer(&records), MakeErrorHandler(&error));
+
+    uint64_t kData[] = {
+        // A padding record of three words.
+        trace::RecordFields::Type::Make(
+            trace::ToUnderlyingType(trace::RecordType::kMetadata)) |
+            trace::RecordFields::RecordSize::Make(3) |
+            trace::MetadataRecordFields::MetadataType::Make(
+                trace::ToUnderlyingType(trace::MetadataType::kPadding)),
+        0,
+        0,
+        // An initialization record.
+        trace::RecordFields::Type::Make(
+            trace::ToUnderlyingType(trace::RecordType::kInitialization)) |
+            trace::RecordFields::RecordSize::Make(2),
+        1000,
+    };
+
+    trace::Chunk chunk(kData, fbl::count_of(kData));
+    EXPECT_TRUE(reader.ReadRecords(chunk));
+    ASSERT_EQ(1, records.size());
+    EXPECT_EQ(trace::RecordType::kInitialization, records[0].type());
+    EXPECT_EQ(1000, records[0].GetInitialization().ticks_per_second);
+    EXPECT_TRUE(error.empty());
+
+    END_TEST;
+}
+
 // NOTE: Most of the reader is covered by the libtrace tests.
 
 } // namespace
@@ -187,4 +221,5 @@ RUN_TEST(empty_chunk_test)
 RUN_TEST(non_empty_chunk_test)
 RUN_TEST(initial_state_test)
 RUN_TEST(empty_buffer_test)
+RUN_TEST(padding_record_test)
 END_TEST_CASE(reader_tests)
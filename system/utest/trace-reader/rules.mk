@@ -7,7 +7,8 @@ LOCAL_DIR := $(GET_LOCAL_DIR)
 reader_tests := \
     $(LOCAL_DIR)/main.c \
     $(LOCAL_DIR)/reader_tests.cpp \
-    $(LOCAL_DIR)/records_tests.cpp
+    $(LOCAL_DIR)/records_tests.cpp \
+    $(LOCAL_DIR)/stacks_tests.cpp
 
 # Userspace tests.
 
@@ -22,6 +23,7 @@ MODULE_NAME := trace-reader-test
 MODULE_STATIC_LIBS := \
     system/ulib/trace-reader \
     system/ulib/trace-engine \
+    system/ulib/zircon-internal \
     system/ulib/zx \
     system/ulib/zxcpp \
     system/ulib/fbl
@@ -53,6 +55,7 @@ MODULE_HOST_LIBS := \
 MODULE_COMPILEFLAGS := \
     -Isystem/ulib/trace-engine/include \
     -Isystem/ulib/trace-reader/include \
+    -Isystem/ulib/zircon-internal/include \
     -Isystem/ulib/fbl/include \
     -Isystem/ulib/unittest/include \
 
@@ -0,0 +1,85 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <trace-reader/stacks.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#include <lib/zircon-internal/device/cpu-trace/cpu-perf.h>
+#include <unittest/unittest.h>
+
+namespace {
+
+cpuperf_callstack_record_t MakeStack(zx_koid_t pid, const uint64_t* frames,
+                                     uint16_t num_frames) {
+    cpuperf_callstack_record_t stack;
+    memset(&stack, 0, sizeof(stack));
+    stack.header.type = CPUPERF_RECORD_CALLSTACK;
+    stack.pid = pid;
+    stack.num_frames = num_frames;
+    memcpy(stack.frames, frames, num_frames * sizeof(frames[0]));
+    return stack;
+}
+
+trace::Record MakeBlob(const cpuperf_callstack_record_t& stack) {
+    return trace::Record(trace::Record::Blob{
+        TRACE_BLOB_TYPE_CALLSTACK, "callstack", &stack,
+        CPUPERF_CALLSTACK_RECORD_SIZE(&stack)});
+}
+
+bool fold_stacks_test() {
+    BEGIN_TEST;
+
+    const uint64_t frames[] = {0x30, 0x20, 0x10};
+    cpuperf_callstack_record_t a = MakeStack(5, frames, 3);
+    cpuperf_callstack_record_t b = MakeStack(5, frames + 1, 2);
+
+    trace::StackAggregator aggregator;
+    EXPECT_TRUE(aggregator.AddRecord(MakeBlob(a)));
+    EXPECT_TRUE(aggregator.AddRecord(MakeBlob(b)));
+    EXPECT_TRUE(aggregator.AddRecord(MakeBlob(a)));
+    EXPECT_EQ(3u, aggregator.total_samples());
+
+    size_t stacks = 0u;
+    aggregator.ForEachStack([&](const fbl::String& folded, uint64_t count) {
+        stacks++;
+        if (folded == "5;0x10;0x20;0x30") {
+            EXPECT_EQ(2u, count);
+        } else {
+            EXPECT_STR_EQ("5;0x10;0x20", folded.c_str());
+            EXPECT_EQ(1u, count);
+        }
+    });
+    EXPECT_EQ(2u, stacks);
+
+    END_TEST;
+}
+
+bool ignore_other_records_test() {
+    BEGIN_TEST;
+
+    trace::StackAggregator aggregator;
+    const char data[] = "abc";
+    EXPECT_TRUE(aggregator.AddRecord(trace::Record(trace::Record::Blob{
+        TRACE_BLOB_TYPE_DATA, "name", data, sizeof(data)})));
+
+    // A callstack blob too short for its frames is rejected.
+    const uint64_t frames[] = {0x10, 0x20};
+    cpuperf_callstack_record_t stack = MakeStack(5, frames, 2);
+    EXPECT_FALSE(aggregator.AddRecord(trace::Record(trace::Record::Blob{
+        TRACE_BLOB_TYPE_CALLSTACK, "callstack", &stack,
+        CPUPERF_CALLSTACK_RECORD_SIZE(&stack) - sizeof(frames[0])})));
+
+    EXPECT_EQ(0u, aggregator.total_samples());
+
+    END_TEST;
+}
+
+} // namespace
+
+BEGIN_TEST_CASE(stacks_tests)
+RUN_TEST(fold_stacks_test)
+RUN_TEST(ignore_other_records_test)
+END_TEST_CASE(stacks_tests)
@@ -332,6 +332,61 @@ String(index: 4, "string2")
     END_TRACE_TEST;
 }
 
+bool TestRegisterStaticStringLiteral() {
+    BEGIN_TRACE_TEST;
+
+    fixture_start_tracing();
+
+    static trace_string_literal_t empty_literal = TRACE_STRING_LITERAL_INIT("");
+    static trace_string_literal_t literal1 = TRACE_STRING_LITERAL_INIT("string1");
+    static trace_string_literal_t literal2 = TRACE_STRING_LITERAL_INIT("string2");
+    static trace_string_literal_t enabled_category = TRACE_STRING_LITERAL_INIT("+enabled");
+    static trace_string_literal_t disabled_category = TRACE_STRING_LITERAL_INIT("-disabled");
+
+    trace_string_ref_t empty;
+    trace_string_ref_t a1, a2;
+    trace_string_ref_t b1, b2;
+    trace_string_ref_t c1, c2;
+    {
+        auto context = trace::TraceContext::Acquire();
+
+        trace_context_register_static_string_literal(context.get(), &empty_literal, &empty);
+
+        trace_context_register_static_string_literal(context.get(), &literal1, &a1);
+        trace_context_register_static_string_literal(context.get(), &literal2, &a2);
+
+        trace_context_register_static_string_literal(context.get(), &literal1, &b1);
+        trace_context_register_static_string_literal(context.get(), &literal2, &b2);
+
+        EXPECT_TRUE(trace_context_register_static_category_literal(
+            context.get(), &enabled_category, &c1));
+        EXPECT_TRUE(trace_context_register_static_category_literal(
+            context.get(), &enabled_category, &c2));
+        EXPECT_FALSE(trace_context_register_static_category_literal(
+            context.get(), &disabled_category, &c2));
+    }
+
+    EXPECT_TRUE(trace_is_empty_string_ref(&empty));
+
+    EXPECT_TRUE(trace_is_indexed_string_ref(&a1));
+    EXPECT_TRUE(trace_is_indexed_string_ref(&a2));
+    EXPECT_TRUE(trace_is_indexed_string_ref(&c1));
+
+    EXPECT_EQ(a1.encoded_value, b1.encoded_value);
+    EXPECT_EQ(a2.encoded_value, b2.encoded_value);
+    EXPECT_EQ(c1.encoded_value, c2.encoded_value);
+
+    EXPECT_NE(a1.encoded_value, a2.encoded_value);
+
+    ASSERT_RECORDS(R"X(String(index: 1, "string1")
+String(index: 2, "string2")
+String(index: 3, "+enabled")
+)X",
+                   "");
+
+    END_TRACE_TEST;
+}
+
 bool TestRegisterStringLiteralTableOverflow() {
     BEGIN_TRACE_TEST;
 
@@ -408,6 +463,44 @@ bool TestEventWithInlineEverything() {
     END_TRACE_TEST;
 }
 
+bool TestEventsFromConcurrentThreads() {
+    BEGIN_TRACE_TEST;
+
+    fixture_start_tracing();
+
+    // Each thread allocates records from its own part of the buffer:
+    // check that none of the records get lost or mangled.
+    constexpr size_t kNumThreads = 4u;
+    constexpr size_t kEventsPerThread = 1000u;
+    thrd_t threads[kNumThreads];
+    for (auto& thread : threads) {
+        int result = thrd_create(&thread, [](void* arg) {
+            for (size_t i = 0; i < kEventsPerThread; ++i) {
+                TRACE_INSTANT("+enabled", "name", TRACE_SCOPE_GLOBAL,
+                              "k1", TA_INT32(1));
+            }
+            return 0;
+        }, nullptr);
+        ASSERT_EQ(thrd_success, result);
+    }
+    for (auto& thread : threads) {
+        int result = thrd_join(thread, nullptr);
+        ASSERT_EQ(thrd_success, result);
+    }
+
+    fbl::Vector<trace::Record> records;
+    ASSERT_N_RECORDS(0u, /*empty*/, "", &records);
+
+    size_t num_events = 0u;
+    for (const auto& record : records) {
+        if (record.type() == trace::RecordType::kEvent)
+            ++num_events;
+    }
+    EXPECT_EQ(kNumThreads * kEventsPerThread, num_events);
+
+    END_TRACE_TEST;
+}
+
 bool TestCircularMode() {
     const size_t kBufferSize = 4096u;
     BEGIN_TRACE_TEST_ETC(kNoAttachToThread,
@@ -692,9 +785,11 @@ RUN_TEST(TestRegisterCurrentThread)
 RUN_TEST(TestRegisterCurrentThreadMultipleThreads)
 RUN_TEST(TestRegisterStringLiteral)
 RUN_TEST(TestRegisterStringLiteralMultipleThreads)
+RUN_TEST(TestRegisterStaticStringLiteral)
 RUN_TEST(TestRegisterStringLiteralTableOverflow)
 RUN_TEST(TestMaximumRecordLength)
 RUN_TEST(TestEventWithInlineEverything)
+RUN_TEST(TestEventsFromConcurrentThreads)
 RUN_TEST(TestCircularMode)
 RUN_TEST(TestStreamingMode)
 RUN_TEST(TestShutdownWhenFull)
@@ -459,6 +459,100 @@ bool vmo_info_test() {
     END_TEST;
 }
 
+bool vmo_working_set_info_test() {
+    BEGIN_TEST;
+
+    const size_t len = PAGE_SIZE * 4;
+    zx_handle_t vmo;
+    ASSERT_EQ(ZX_OK, zx_vmo_create(len, 0, &vmo));
+
+    zx_info_vmo_working_set_t info;
+    ASSERT_EQ(ZX_OK, zx_object_get_info(vmo, ZX_INFO_VMO_WORKING_SET, &info, sizeof(info),
+                                        nullptr, nullptr));
+    EXPECT_EQ(0u, info.committed_bytes);
+    EXPECT_EQ(0u, info.working_set_bytes);
+
+    // Commit two pages; the working set can't be larger than that.
+    uint8_t buf[PAGE_SIZE * 2] = {1};
+    ASSERT_EQ(ZX_OK, zx_vmo_write(vmo, buf, 0, sizeof(buf)));
+    ASSERT_EQ(ZX_OK, zx_object_get_info(vmo, ZX_INFO_VMO_WORKING_SET, &info, sizeof(info),
+                                        nullptr, nullptr));
+    EXPECT_EQ(sizeof(buf), info.committed_bytes);
+    EXPECT_LE(info.working_set_bytes, info.committed_bytes);
+
+    EXPECT_EQ(ZX_ERR_BUFFER_TOO_SMALL,
+              zx_object_get_info(vmo, ZX_INFO_VMO_WORKING_SET, &info, sizeof(info) - 1,
+                                 nullptr, nullptr));
+
+    EXPECT_EQ(ZX_OK, zx_handle_close(vmo));
+    END_TEST;
+}
+
+bool vmo_transfer_data_test() {
+    BEGIN_TEST;
+
+    const size_t len = PAGE_SIZE * 4;
+    zx_handle_t src, dst;
+    ASSERT_EQ(ZX_OK, zx_vmo_create(len, 0, &src));
+    ASSERT_EQ(ZX_OK, zx_vmo_create(len, 0, &dst));
+
+    uint8_t buf[PAGE_SIZE * 2];
+    for (size_t i = 0; i < sizeof(buf); i++) {
+        buf[i] = static_cast<uint8_t>(i * 7);
+    }
+    ASSERT_EQ(ZX_OK, zx_vmo_write(src, buf, 0, sizeof(buf)));
+
+    // A copy may start anywhere and leaves the source alone.
+    ASSERT_EQ(ZX_OK, zx_vmo_transfer_data(dst, 0, 3, 100, src, 17));
+    uint8_t out[PAGE_SIZE * 2];
+    ASSERT_EQ(ZX_OK, zx_vmo_read(dst, out, 3, 100));
+    EXPECT_EQ(0, memcmp(out, buf + 17, 100));
+    ASSERT_EQ(ZX_OK, zx_vmo_read(src, out, 0, sizeof(buf)));
+    EXPECT_EQ(0, memcmp(out, buf, sizeof(buf)));
+
+    // A move takes the source's pages, which then reads as zeroes.
+    ASSERT_EQ(ZX_OK, zx_vmo_transfer_data(dst, ZX_VMO_TRANSFER_MOVE, PAGE_SIZE * 2,
+                                          sizeof(buf), src, 0));
+    ASSERT_EQ(ZX_OK, zx_vmo_read(dst, out, PAGE_SIZE * 2, sizeof(buf)));
+    EXPECT_EQ(0, memcmp(out, buf, sizeof(buf)));
+    ASSERT_EQ(ZX_OK, zx_vmo_read(src, out, 0, sizeof(buf)));
+    uint8_t zeroes[PAGE_SIZE * 2] = {};
+    EXPECT_EQ(0, memcmp(out, zeroes, sizeof(buf)));
+
+    // Pages a clone can see stay put, so they are copied instead.
+    zx_handle_t clone;
+    ASSERT_EQ(ZX_OK, zx_vmo_write(src, buf, 0, sizeof(buf)));
+    ASSERT_EQ(ZX_OK, zx_vmo_clone(src, ZX_VMO_CLONE_COPY_ON_WRITE, 0, len, &clone));
+    ASSERT_EQ(ZX_OK, zx_vmo_transfer_data(dst, ZX_VMO_TRANSFER_MOVE, 0, PAGE_SIZE, src, 0));
+    ASSERT_EQ(ZX_OK, zx_vmo_read(dst, out, 0, PAGE_SIZE));
+    EXPECT_EQ(0, memcmp(out, buf, PAGE_SIZE));
+    ASSERT_EQ(ZX_OK, zx_vmo_read(clone, out, 0, PAGE_SIZE));
+    EXPECT_EQ(0, memcmp(out, buf, PAGE_SIZE));
+    EXPECT_EQ(ZX_OK, zx_handle_close(clone));
+
+    // Moves need whole pages, and ranges within one vmo may not overlap.
+    EXPECT_EQ(ZX_ERR_INVALID_ARGS,
+              zx_vmo_transfer_data(dst, ZX_VMO_TRANSFER_MOVE, 0, 100, src, 0));
+    EXPECT_EQ(ZX_ERR_INVALID_ARGS,
+              zx_vmo_transfer_data(src, 0, PAGE_SIZE, PAGE_SIZE * 2, src, 0));
+    EXPECT_EQ(ZX_ERR_INVALID_ARGS, zx_vmo_transfer_data(dst, 1u << 31, 0, 100, src, 0));
+    EXPECT_EQ(ZX_ERR_OUT_OF_RANGE, zx_vmo_transfer_data(dst, 0, len, PAGE_SIZE, src, 0));
+
+    // Moving needs to write the source too.
+    zx_handle_t read_only;
+    ASSERT_EQ(ZX_OK, zx_handle_duplicate(src, ZX_RIGHT_READ, &read_only));
+    EXPECT_EQ(ZX_OK, zx_vmo_transfer_data(dst, 0, 0, PAGE_SIZE, read_only, 0));
+    EXPECT_EQ(ZX_ERR_ACCESS_DENIED,
+              zx_vmo_transfer_data(dst, ZX_VMO_TRANSFER_MOVE, 0, PAGE_SIZE, read_only, 0));
+    EXPECT_EQ(ZX_ERR_ACCESS_DENIED, zx_vmo_transfer_data(read_only, 0, 0, PAGE_SIZE, src, 0));
+    EXPECT_EQ(ZX_OK, zx_handle_close(read_only));
+
+    EXPECT_EQ(ZX_OK, zx_handle_close(src));
+    EXPECT_EQ(ZX_OK, zx_handle_close(dst));
+
+    END_TEST;
+}
+
 bool vmo_no_resize_clone_test() {
     const size_t len = PAGE_SIZE * 4;
     zx_handle_t vmo = ZX_HANDLE_INVALID;
@@ -1801,6 +1895,8 @@ RUN_TEST(vmo_resize_hazard);
 RUN_TEST(vmo_clone_resize_clone_hazard);
 RUN_TEST(vmo_clone_resize_parent_ok);
 RUN_TEST(vmo_info_test);
+RUN_TEST(vmo_working_set_info_test);
+RUN_TEST(vmo_transfer_data_test);
 RUN_TEST_LARGE(vmo_unmap_coherency);
 END_TEST_CASE(vmo_tests)
 
@@ -258,6 +258,17 @@ bool TestDevice::ReadVmo(zx_off_t off, size_t len) {
     END_HELPER;
 }
 
+bool TestDevice::ReadVmoAt(zx_off_t vmo_off, zx_off_t off, size_t len) {
+    BEGIN_HELPER;
+    ASSERT_OK(block_fifo_txn(BLOCKIO_READ, off, len, vmo_off));
+    vmo_off *= block_size_;
+    off *= block_size_;
+    len *= block_size_;
+    ASSERT_OK(vmo_.read(as_read_.get() + off, vmo_off, len));
+    ASSERT_EQ(memcmp(as_read_.get() + off, to_write_.get() + off, len), 0);
+    END_HELPER;
+}
+
 bool TestDevice::WriteVmo(zx_off_t off, size_t len) {
     BEGIN_HELPER;
     ASSERT_OK(vmo_write(off * block_size_, len * block_size_));
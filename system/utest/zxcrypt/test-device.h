@@ -100,11 +100,11 @@ public:
     // Sends a request over the block fifo to read or write the blocks given by |off| and |len|,
     // according to the given |opcode|.  The data sent or received can be accessed using |vmo_write|
     // or |vmo_read|, respectively.  |off| and |len| are in blocks.
-    zx_status_t block_fifo_txn(uint16_t opcode, uint64_t off, uint64_t len) {
+    zx_status_t block_fifo_txn(uint16_t opcode, uint64_t off, uint64_t len, uint64_t vmo_off = 0) {
         req_.opcode = opcode;
         req_.length = static_cast<uint32_t>(len);
         req_.dev_offset = off;
-        req_.vmo_offset = 0;
+        req_.vmo_offset = vmo_off;
         return ::block_fifo_txn(client_, &req_, 1);
     }
 
@@ -150,6 +150,10 @@ public:
     bool ReadVmo(zx_off_t off, size_t len);
     bool WriteVmo(zx_off_t off, size_t len);
 
+    // Like |ReadVmo|, but has the data read land |vmo_off| blocks into the VMO.  |vmo_off| need not
+    // be page aligned.
+    bool ReadVmoAt(zx_off_t vmo_off, zx_off_t off, size_t len);
+
     // Test helper that flips a (pseudo)random bit in the key at the given |slot| in the given
     // |block|. The call to |srand| in main.c guarantees the same bit will be chosen for a given
     // test iteration.
@@ -10,6 +10,7 @@
 
 #include <crypto/bytes.h>
 #include <crypto/cipher.h>
+#include <fbl/algorithm.h>
 #include <fbl/unique_fd.h>
 #include <fvm/fvm.h>
 #include <unittest/unittest.h>
@@ -402,6 +403,23 @@ bool TestVmoAllBlocks(Volume::Version version, bool fvm) {
 }
 DEFINE_EACH_DEVICE(TestVmoAllBlocks);
 
+bool TestVmoUnaligned(Volume::Version version, bool fvm) {
+    BEGIN_TEST;
+
+    TestDevice device;
+    ASSERT_TRUE(device.Bind(version, fvm));
+    size_t n = fbl::min(device.block_count(), static_cast<size_t>(8));
+
+    // Reads are decrypted in place in the VMO, wherever in a page they land.
+    EXPECT_TRUE(device.WriteVmo(0, n));
+    for (size_t vmo_off = 1; vmo_off < n; ++vmo_off) {
+        EXPECT_TRUE(device.ReadVmoAt(vmo_off, 0, n - vmo_off));
+    }
+
+    END_TEST;
+}
+DEFINE_EACH_DEVICE(TestVmoUnaligned);
+
 bool TestVmoOutOfBounds(Volume::Version version, bool fvm) {
     BEGIN_TEST;
 
@@ -550,6 +568,7 @@ RUN_EACH_DEVICE(TestVmoZeroLength)
 RUN_EACH_DEVICE(TestVmoFirstBlock)
 RUN_EACH_DEVICE(TestVmoLastBlock)
 RUN_EACH_DEVICE(TestVmoAllBlocks)
+RUN_EACH_DEVICE(TestVmoUnaligned)
 RUN_EACH_DEVICE(TestVmoOutOfBounds)
 RUN_EACH_DEVICE(TestVmoOneToMany)
 RUN_EACH_DEVICE(TestVmoManyToOne)
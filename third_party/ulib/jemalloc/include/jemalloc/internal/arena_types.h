@@ -9,6 +9,10 @@
 
 /* Default decay time in seconds. */
 #define	DECAY_TIME_DEFAULT	10
+#ifdef __Fuchsia__
+/* Default decay time for "profile:throughput". */
+#define	DECAY_TIME_THROUGHPUT	30
+#endif
 /* Number of event ticks between time checks. */
 #define	DECAY_NTICKS_PER_UPDATE	1000
 
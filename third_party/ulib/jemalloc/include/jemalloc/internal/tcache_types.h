@@ -35,6 +35,10 @@ typedef struct tcaches_s tcaches_t;
 
 /* (1U << opt_lg_tcache_max) is used to compute tcache_maxclass. */
 #define	LG_TCACHE_MAXCLASS_DEFAULT	15
+#ifdef __Fuchsia__
+/* lg_tcache_max for "profile:throughput". */
+#define	LG_TCACHE_MAXCLASS_THROUGHPUT	17
+#endif
 
 /*
  * TCACHE_GC_SWEEP is the approximate number of allocation events between
@@ -43,6 +43,10 @@ bool	opt_utrace = false;
 bool	opt_xmalloc = false;
 bool	opt_zero = false;
 unsigned	opt_narenas = 0;
+#ifdef __Fuchsia__
+// Set by "profile:throughput"; see malloc_conf_init().
+static bool	opt_narenas_per_cpu = false;
+#endif
 
 unsigned	ncpus;
 
@@ -1038,6 +1042,31 @@ malloc_conf_init(void)
 			}
 
 			CONF_HANDLE_BOOL(opt_abort, "abort", true)
+#ifdef __Fuchsia__
+			// "profile:throughput" tunes for servers which allocate
+			// heavily from many threads: one arena per CPU, larger
+			// thread caches, and slower decay so that freed pages
+			// are decommitted less often and fault back in less
+			// often.  Options after it in the same string still
+			// override its settings.
+			if (CONF_MATCH("profile")) {
+				if (CONF_MATCH_VALUE("throughput")) {
+					opt_narenas = 0;
+					opt_narenas_per_cpu = true;
+					if (config_tcache) {
+						opt_tcache = true;
+						opt_lg_tcache_max =
+						    LG_TCACHE_MAXCLASS_THROUGHPUT;
+					}
+					opt_decay_time =
+					    DECAY_TIME_THROUGHPUT;
+				} else if (!CONF_MATCH_VALUE("default")) {
+					malloc_conf_error("Invalid conf value",
+					    k, klen, v, vlen);
+				}
+				continue;
+			}
+#endif
 			if (strncmp("dss", k, klen) == 0) {
 				int i;
 				bool match = false;
@@ -1277,6 +1306,10 @@ malloc_init_hard_finish(tsdn_t *tsdn)
 			opt_narenas = ncpus << 2;
 		else
 			opt_narenas = 1;
+#ifdef __Fuchsia__
+		if (opt_narenas_per_cpu)
+			opt_narenas = ncpus;
+#endif
 	}
 	narenas_auto = opt_narenas;
 	/*
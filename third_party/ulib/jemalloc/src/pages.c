@@ -98,6 +98,15 @@ static zx_status_t fuchsia_pages_free(void* addr, size_t size) {
 	return _zx_vmar_unmap(pages_vmar, ptr, size);
 }
 
+// All heap pages are mapped from pages_vmo at their offset within
+// pages_vmar, so returning them to the system is a single decommit of the
+// same range of the VMO.  They read back as zero afterwards.
+static zx_status_t fuchsia_pages_decommit(void* addr, size_t size) {
+	uint64_t offset = (uintptr_t)addr - pages_base;
+	return _zx_vmo_op_range(pages_vmo, ZX_VMO_OP_DECOMMIT, offset, size,
+	    NULL, 0);
+}
+
 static void* fuchsia_pages_trim(void* ret, void* addr, size_t size,
     size_t alloc_size, size_t leadsize) {
 	size_t trailsize = alloc_size - leadsize - size;
@@ -291,6 +300,8 @@ pages_purge_forced(void *addr, size_t size)
 
 #if defined(JEMALLOC_PURGE_MADVISE_DONTNEED)
 	return (madvise(addr, size, MADV_DONTNEED) != 0);
+#elif defined(__Fuchsia__)
+	return (fuchsia_pages_decommit(addr, size) != ZX_OK);
 #else
 	not_reached();
 #endif
@@ -9,3 +9,4 @@
 #define REL_DTPOFF R_AARCH64_TLS_DTPREL64
 #define REL_TPOFF R_AARCH64_TLS_TPREL64
 #define REL_TLSDESC R_AARCH64_TLSDESC
+#define REL_IRELATIVE R_AARCH64_IRELATIVE
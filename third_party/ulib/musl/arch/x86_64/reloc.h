@@ -8,3 +8,4 @@
 #define REL_DTPOFF R_X86_64_DTPOFF64
 #define REL_TPOFF R_X86_64_TPOFF64
 #define REL_TLSDESC R_X86_64_TLSDESC
+#define REL_IRELATIVE R_X86_64_IRELATIVE
@@ -1994,6 +1994,7 @@ typedef Elf32_Addr Elf32_Conflict;
 #define R_AARCH64_TLS_DTPREL64 1029
 #define R_AARCH64_TLS_TPREL64 1030
 #define R_AARCH64_TLSDESC 1031
+#define R_AARCH64_IRELATIVE 1032
 
 #define R_ARM_NONE 0
 #define R_ARM_PC24 1
@@ -17,6 +17,15 @@ void* memalign(size_t, size_t);
 
 size_t malloc_usable_size(void*);
 
+// Allocator introspection and tuning, as provided by jemalloc.  For
+// example, mallctl("stats.allocated", ...) reads the number of bytes
+// currently allocated, after mallctl("epoch", ...) has refreshed the
+// statistics.  The allocator's options can be set per process with the
+// MALLOC_CONF environment variable, e.g. MALLOC_CONF=profile:throughput.
+int mallctl(const char* name, void* oldp, size_t* oldlenp, void* newp, size_t newlen);
+void malloc_stats_print(void (*write_cb)(void*, const char*), void* cbopaque,
+                        const char* opts);
+
 #ifdef __cplusplus
 }
 #endif
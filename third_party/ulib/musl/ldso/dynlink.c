@@ -44,6 +44,8 @@ static void early_init(void);
 static void error(const char*, ...);
 static void debugmsg(const char*, ...);
 static zx_status_t get_library_vmo(const char* name, zx_handle_t* vmo);
+static void get_library_vmos(size_t count, const char* const* names,
+                             zx_status_t* results, zx_handle_t* vmos);
 static void loader_svc_config(const char* config);
 
 #define MAXP2(a, b) (-(-(a) & -(b)))
@@ -379,7 +381,8 @@ static Sym* gnu_lookup_filtered(uint32_t h1, uint32_t* hashtab,
 }
 
 #define OK_TYPES \
-    (1 << STT_NOTYPE | 1 << STT_OBJECT | 1 << STT_FUNC | 1 << STT_COMMON | 1 << STT_TLS)
+    (1 << STT_NOTYPE | 1 << STT_OBJECT | 1 << STT_FUNC | 1 << STT_COMMON | 1 << STT_TLS | \
+     1 << STT_GNU_IFUNC)
 #define OK_BINDS (1 << STB_GLOBAL | 1 << STB_WEAK | 1 << STB_GNU_UNIQUE)
 
 __NO_SAFESTACK NO_ASAN
@@ -429,6 +432,15 @@ static struct symdef find_sym(struct dso* dso, const char* s, int need_def) {
 
 __attribute__((__visibility__("hidden"))) ptrdiff_t __tlsdesc_static(void), __tlsdesc_dynamic(void);
 
+// An STT_GNU_IFUNC symbol or an IRELATIVE relocation points at a resolver
+// function, which returns the address of the implementation best suited to
+// this machine.  Resolvers can be called before the DSO defining them has
+// been relocated, so they must not depend on any relocations.  The ones in
+// libc itself are called by stage 2 (see __dls2 below).
+__NO_SAFESTACK NO_ASAN static size_t call_ifunc_resolver(size_t resolver) {
+    return ((size_t (*)(void))resolver)();
+}
+
 __NO_SAFESTACK NO_ASAN static void do_relocs(struct dso* dso, size_t* rel,
                                              size_t rel_size, size_t stride) {
     ElfW(Addr) base = dso->l_map.l_addr;
@@ -496,6 +508,8 @@ __NO_SAFESTACK NO_ASAN static void do_relocs(struct dso* dso, size_t* rel,
 
         sym_val = def.sym ? saddr(def.dso, def.sym->st_value) : 0;
         tls_val = def.sym ? def.sym->st_value : 0;
+        if (def.sym && (def.sym->st_info & 0xf) == STT_GNU_IFUNC)
+            sym_val = call_ifunc_resolver(sym_val);
 
         switch (type) {
         case REL_NONE:
@@ -510,6 +524,9 @@ __NO_SAFESTACK NO_ASAN static void do_relocs(struct dso* dso, size_t* rel,
         case REL_RELATIVE:
             *reloc_addr = base + addend;
             break;
+        case REL_IRELATIVE:
+            *reloc_addr = call_ifunc_resolver(base + addend);
+            break;
         case REL_COPY:
             memcpy(reloc_addr, (void*)sym_val, sym->st_size);
             break;
@@ -1420,23 +1437,72 @@ __NO_SAFESTACK static zx_status_t load_library(const char* name, int rtld_mode,
     return status;
 }
 
+// The most loader service requests sent together by load_deps.
+#define LOADER_SVC_BATCH_MAX 16
+
 __NO_SAFESTACK static void load_deps(struct dso* p) {
     for (; p; p = dso_next(p)) {
         struct dso** deps = NULL;
         // The two preallocated DSOs don't get space allocated for ->deps.
         if (runtime && p->deps == NULL && p != &ldso && p != &vdso)
             deps = p->deps = p->buf;
+
+        // Ask for all the dependencies that aren't loaded yet at once,
+        // rather than waiting on the loader service for each in turn.
+        const char* names[LOADER_SVC_BATCH_MAX];
+        zx_status_t results[LOADER_SVC_BATCH_MAX];
+        zx_handle_t vmos[LOADER_SVC_BATCH_MAX];
+        size_t nfetch = 0;
+        for (size_t i = 0; p->l_map.l_ld[i].d_tag &&
+                           nfetch < LOADER_SVC_BATCH_MAX; i++) {
+            if (p->l_map.l_ld[i].d_tag != DT_NEEDED)
+                continue;
+            const char* name = p->strings + p->l_map.l_ld[i].d_un.d_val;
+            if (!*name || find_library(name) != NULL)
+                continue;
+            size_t j = 0;
+            while (j < nfetch && strcmp(names[j], name))
+                ++j;
+            if (j == nfetch)
+                names[nfetch++] = name;
+        }
+        // A lone request gains nothing from going through the batch.
+        if (nfetch > 1)
+            get_library_vmos(nfetch, names, results, vmos);
+        else
+            nfetch = 0;
+
         for (size_t i = 0; p->l_map.l_ld[i].d_tag; i++) {
             if (p->l_map.l_ld[i].d_tag != DT_NEEDED)
                 continue;
             const char* name = p->strings + p->l_map.l_ld[i].d_un.d_val;
+            size_t j = 0;
+            while (j < nfetch && (names[j] == NULL || strcmp(names[j], name)))
+                ++j;
             struct dso* dep;
-            zx_status_t status = load_library(name, 0, p, &dep);
+            zx_status_t status;
+            if (j < nfetch) {
+                // Each fetched VMO is used once; repeats of the name find
+                // the library it loaded.
+                names[j] = NULL;
+                status = results[j];
+                if (status == ZX_OK) {
+                    status = load_library_vmo(vmos[j], name, 0, p, &dep);
+                    _zx_handle_close(vmos[j]);
+                }
+            } else {
+                status = load_library(name, 0, p, &dep);
+            }
             if (status != ZX_OK) {
                 error("Error loading shared library %s: %s (needed by %s)",
                       name, _zx_status_get_string(status), p->l_map.l_name);
-                if (runtime)
+                if (runtime) {
+                    for (j = 0; j < nfetch; ++j) {
+                        if (names[j] != NULL && results[j] == ZX_OK)
+                            _zx_handle_close(vmos[j]);
+                    }
                     longjmp(*rtld_fail, 1);
+                }
             } else if (deps != NULL) {
                 *deps++ = dep;
             }
@@ -2236,6 +2302,13 @@ static void* addr2dso(size_t a) {
 
 void* __tls_get_addr(size_t*);
 
+static void* dlsym_addr(struct dso* p, const Sym* sym) {
+    void* addr = laddr(p, sym->st_value);
+    if ((sym->st_info & 0xf) == STT_GNU_IFUNC)
+        addr = (void*)call_ifunc_resolver((size_t)addr);
+    return addr;
+}
+
 static bool find_sym_for_dlsym(struct dso* p,
                                const char* name,
                                uint32_t* name_gnu_hash,
@@ -2256,7 +2329,7 @@ static bool find_sym_for_dlsym(struct dso* p,
         return true;
     }
     if (sym && sym->st_value && (1 << (sym->st_info & 0xf) & OK_TYPES)) {
-        *result = laddr(p, sym->st_value);
+        *result = dlsym_addr(p, sym);
         return true;
     }
     if (p->deps) {
@@ -2284,7 +2357,7 @@ static void* do_dlsym(struct dso* p, const char* s, void* ra) {
             goto failed;
         if ((def.sym->st_info & 0xf) == STT_TLS)
             return __tls_get_addr((size_t[]){def.dso->tls_id, def.sym->st_value});
-        return laddr(def.dso, def.sym->st_value);
+        return dlsym_addr(def.dso, def.sym);
     }
     if (__dl_invalid_handle(p))
         return 0;
@@ -2476,6 +2549,109 @@ __NO_SAFESTACK static zx_status_t get_library_vmo(const char* name,
                           ZX_HANDLE_INVALID, result);
 }
 
+// Look up all of |names| at once: the LDMSG_OP_LOAD_OBJECT requests are all
+// written before waiting for any reply, so the lot costs a single round
+// trip.  The service sees the same requests it would one at a time, so this
+// works with any implementation of the protocol.  The status for |names[i]|
+// goes in |results[i]|, and when that is ZX_OK the VMO goes in |vmos[i]|.
+__NO_SAFESTACK static void get_library_vmos(size_t count,
+                                           const char* const* names,
+                                           zx_status_t* results,
+                                           zx_handle_t* vmos) {
+    // Transaction IDs with the high bit set are the kernel's, for
+    // zx_channel_call.  Keep counting across batches so a late reply to
+    // an abandoned one can't be taken for a reply to this one.
+    static uint32_t next_txid;
+
+    bool sent[LOADER_SVC_BATCH_MAX] = {};
+    bool answered[LOADER_SVC_BATCH_MAX] = {};
+    size_t pending = 0;
+    uint32_t first_txid = 0;
+    for (size_t i = 0; i < count; ++i) {
+        vmos[i] = ZX_HANDLE_INVALID;
+        results[i] = ZX_ERR_UNAVAILABLE;
+    }
+    if (loader_svc == ZX_HANDLE_INVALID) {
+        error("cannot look up \"%s\" with no loader service", names[0]);
+        return;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        ldmsg_req_t req;
+        memset(&req.header, 0, sizeof(req.header));
+        req.header.ordinal = LDMSG_OP_LOAD_OBJECT;
+        next_txid = (next_txid + 1) & 0x7fffffff;
+        if (next_txid == 0)
+            next_txid = 1;
+        req.header.txid = next_txid;
+        if (i == 0)
+            first_txid = next_txid;
+        else if (next_txid != first_txid + i)
+            break; // Wrapped around; ask for the rest one at a time.
+
+        size_t req_len;
+        zx_status_t status = ldmsg_req_encode(&req, &req_len,
+                                              names[i], strlen(names[i]));
+        if (status == ZX_OK)
+            status = _zx_channel_write(loader_svc, 0, &req, req_len, NULL, 0);
+        if (status != ZX_OK)
+            break;
+        sent[i] = true;
+        ++pending;
+    }
+
+    while (pending > 0) {
+        ldmsg_rsp_t rsp;
+        zx_handle_t handle = ZX_HANDLE_INVALID;
+        uint32_t reply_size, handle_count;
+        zx_status_t status = _zx_channel_read(loader_svc, 0, &rsp, &handle,
+                                              sizeof(rsp), 1,
+                                              &reply_size, &handle_count);
+        if (status == ZX_ERR_SHOULD_WAIT) {
+            status = _zx_object_wait_one(
+                loader_svc, ZX_CHANNEL_READABLE | ZX_CHANNEL_PEER_CLOSED,
+                ZX_TIME_INFINITE, NULL);
+            if (status == ZX_OK)
+                continue;
+        }
+        if (status != ZX_OK) {
+            error("_zx_channel_read from loader service: %d (%s)",
+                  status, _zx_status_get_string(status));
+            break;
+        }
+
+        size_t i = rsp.header.txid - first_txid;
+        if (rsp.header.txid < first_txid || i >= count ||
+            !sent[i] || answered[i]) {
+            // Not a reply to this batch.
+            if (handle_count > 0)
+                _zx_handle_close(handle);
+            continue;
+        }
+        --pending;
+        answered[i] = true;
+
+        if (reply_size != ldmsg_rsp_get_size(&rsp) ||
+            rsp.header.ordinal != LDMSG_OP_LOAD_OBJECT ||
+            (rsp.rv != ZX_OK && handle_count > 0)) {
+            error("bad loader service reply for \"%s\"", names[i]);
+            if (handle_count > 0)
+                _zx_handle_close(handle);
+            results[i] = ZX_ERR_INVALID_ARGS;
+        } else {
+            results[i] = rsp.rv;
+            vmos[i] = handle;
+        }
+    }
+
+    // Anything not answered here is looked up again one at a time, the
+    // way it would have been without the batch.
+    for (size_t i = 0; i < count; ++i) {
+        if (!answered[i])
+            results[i] = get_library_vmo(names[i], &vmos[i]);
+    }
+}
+
 __NO_SAFESTACK zx_status_t dl_clone_loader_service(zx_handle_t* out) {
     if (loader_svc == ZX_HANDLE_INVALID) {
         return ZX_ERR_UNAVAILABLE;
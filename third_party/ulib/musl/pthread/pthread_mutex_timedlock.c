@@ -1,7 +1,9 @@
 #include "threads_impl.h"
 
+#include <lib/sync/internal/spin.h>
+
 int pthread_mutex_timedlock(pthread_mutex_t* restrict m, const struct timespec* restrict at) {
-    if ((m->_m_type & PTHREAD_MUTEX_MASK) == PTHREAD_MUTEX_NORMAL &&
+    if (m->_m_type == PTHREAD_MUTEX_NORMAL &&
         !a_cas_shim(&m->_m_lock, 0, EBUSY))
         return 0;
 
@@ -11,9 +13,13 @@ int pthread_mutex_timedlock(pthread_mutex_t* restrict m, const struct timespec*
     if (r != EBUSY)
         return r;
 
-    int spins = 100;
-    while (spins-- && atomic_load(&m->_m_lock) && !atomic_load(&m->_m_waiters))
-        a_spin();
+    // Spin briefly in the hope that the owner releases the mutex soon,
+    // unless other threads are already waiting for it.
+    if (!atomic_load(&m->_m_waiters)) {
+        int lock = atomic_load(&m->_m_lock);
+        if (lock)
+            sync_spin_while_equal(&m->_m_lock, lock);
+    }
 
     while ((r = pthread_mutex_trylock(m)) == EBUSY) {
         if (!(r = atomic_load(&m->_m_lock)))
@@ -25,7 +31,11 @@ int pthread_mutex_timedlock(pthread_mutex_t* restrict m, const struct timespec*
         atomic_fetch_add(&m->_m_waiters, 1);
         t = r | PTHREAD_MUTEX_OWNED_LOCK_BIT;
         a_cas_shim(&m->_m_lock, r, t);
-        r = __timedwait(&m->_m_lock, t, CLOCK_REALTIME, at);
+        if (m->_m_type & PTHREAD_MUTEX_PRIO_INHERIT_BIT)
+            r = __timedwait_pi(&m->_m_lock, t, r & PTHREAD_MUTEX_OWNED_LOCK_MASK,
+                               CLOCK_REALTIME, at);
+        else
+            r = __timedwait(&m->_m_lock, t, CLOCK_REALTIME, at);
         atomic_fetch_sub(&m->_m_waiters, 1);
         if (r)
             break;
@@ -33,6 +33,7 @@ enum {
     REL_TLSDESC,
     REL_FUNCDESC,
     REL_FUNCDESC_VAL,
+    REL_IRELATIVE,
 };
 
 #include "reloc.h"
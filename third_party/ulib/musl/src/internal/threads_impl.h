@@ -116,6 +116,9 @@ static inline struct pthread* tp_to_pthread(void* tp) {
 // The bit used in the recursive and errorchecking cases, which track thread owners.
 #define PTHREAD_MUTEX_OWNED_LOCK_BIT 0x80000000
 #define PTHREAD_MUTEX_OWNED_LOCK_MASK 0x7fffffff
+// Set in the type of PTHREAD_PRIO_INHERIT mutexes.  These track their owner
+// whatever their type, so that waiters can lend it their priority.
+#define PTHREAD_MUTEX_PRIO_INHERIT_BIT 0x4
 
 extern void* __pthread_tsd_main[];
 extern volatile size_t __pthread_tsd_size;
@@ -154,6 +157,11 @@ void __private_cond_signal(void* condvar, int n) ATTR_LIBC_VISIBILITY;
 int __timedwait(atomic_int*, int, clockid_t, const struct timespec*)
     ATTR_LIBC_VISIBILITY;
 
+// Like __timedwait(), but lends the priority of the calling thread to the
+// thread whose handle is |owner| while waiting.
+int __timedwait_pi(atomic_int*, int, zx_handle_t owner, clockid_t, const struct timespec*)
+    ATTR_LIBC_VISIBILITY;
+
 // Loading a library can introduce more thread_local variables. Thread
 // allocation bases bookkeeping decisions based on the current state
 // of thread_locals in the program, so thread creation needs to be
@@ -70,11 +70,23 @@ LOCAL_SRCS += \
 
 else ifeq ($(ARCH),x86)
 
+# Without ASan, these choose between SSE2 and AVX2 versions via IFUNC
+# when libc is loaded.  The ASan runtime needs the plain functions, which
+# it intercepts via the __asan_* aliases the assembly versions provide.
+ifeq ($(call TOBOOL,$(USE_ASAN)),false)
+LOCAL_SRCS += \
+    $(GET_LOCAL_DIR)/x86_64/cpu-features.c \
+    $(GET_LOCAL_DIR)/x86_64/memmove.c \
+    $(GET_LOCAL_DIR)/x86_64/memset.c \
+
+else
 LOCAL_SRCS += \
     $(GET_LOCAL_DIR)/x86_64/memcpy.S \
     $(GET_LOCAL_DIR)/x86_64/memmove.S \
     $(GET_LOCAL_DIR)/x86_64/memset.S \
 
+endif
+
 else
 
 LOCAL_SRCS += \
@@ -107,14 +119,25 @@ LOCAL_SRCS += \
 else
 
 LOCAL_SRCS += \
-    $(GET_LOCAL_DIR)/memchr.c \
-    $(GET_LOCAL_DIR)/memcmp.c \
     $(GET_LOCAL_DIR)/strchr.c \
     $(GET_LOCAL_DIR)/strchrnul.c \
     $(GET_LOCAL_DIR)/strcmp.c \
     $(GET_LOCAL_DIR)/strcpy.c \
-    $(GET_LOCAL_DIR)/strlen.c \
     $(GET_LOCAL_DIR)/strncmp.c \
     $(GET_LOCAL_DIR)/strnlen.c \
 
+ifeq ($(ARCH):$(call TOBOOL,$(USE_ASAN)),x86:false)
+LOCAL_SRCS += \
+    $(GET_LOCAL_DIR)/x86_64/memchr.c \
+    $(GET_LOCAL_DIR)/x86_64/memcmp.c \
+    $(GET_LOCAL_DIR)/x86_64/strlen.c \
+
+else
+LOCAL_SRCS += \
+    $(GET_LOCAL_DIR)/memchr.c \
+    $(GET_LOCAL_DIR)/memcmp.c \
+    $(GET_LOCAL_DIR)/strlen.c \
+
+endif
+
 endif
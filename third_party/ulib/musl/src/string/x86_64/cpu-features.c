@@ -0,0 +1,61 @@
+#include "cpu-features.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <zircon/compiler.h>
+
+// Set once the other bits have been computed.  Threads racing to compute
+// them all store the same value.
+#define FEATURES_KNOWN (1u << 31)
+
+static unsigned int features;
+
+// CPUID.1:ECX
+#define CPUID_1_ECX_OSXSAVE (1u << 27)
+#define CPUID_1_ECX_AVX (1u << 28)
+// CPUID.(EAX=7,ECX=0):EBX
+#define CPUID_7_EBX_AVX2 (1u << 5)
+#define CPUID_7_EBX_ERMS (1u << 9)
+// XCR0 bits for the SSE and AVX register state.
+#define XCR0_SSE_AVX (UINT64_C(1) << 1 | UINT64_C(1) << 2)
+
+__NO_SAFESTACK static void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t* eax,
+                                 uint32_t* ebx, uint32_t* ecx, uint32_t* edx) {
+    __asm__("cpuid"
+            : "=a"(*eax), "=b"(*ebx), "=c"(*ecx), "=d"(*edx)
+            : "a"(leaf), "c"(subleaf));
+}
+
+__NO_SAFESTACK static uint64_t xgetbv(uint32_t reg) {
+    uint32_t lo, hi;
+    __asm__("xgetbv"
+            : "=a"(lo), "=d"(hi)
+            : "c"(reg));
+    return (uint64_t)hi << 32 | lo;
+}
+
+__NO_SAFESTACK unsigned int __x86_string_features(void) {
+    unsigned int result = __atomic_load_n(&features, __ATOMIC_RELAXED);
+    if (result & FEATURES_KNOWN)
+        return result;
+
+    result = FEATURES_KNOWN;
+    uint32_t max_leaf, ebx, ecx, edx;
+    cpuid(0, 0, &max_leaf, &ebx, &ecx, &edx);
+    if (max_leaf >= 7) {
+        uint32_t eax;
+        cpuid(1, 0, &eax, &ebx, &ecx, &edx);
+        // AVX2 is only usable if the kernel saves and restores the AVX
+        // register state.
+        bool avx = (ecx & CPUID_1_ECX_OSXSAVE) && (ecx & CPUID_1_ECX_AVX) &&
+                   (xgetbv(0) & XCR0_SSE_AVX) == XCR0_SSE_AVX;
+        cpuid(7, 0, &eax, &ebx, &ecx, &edx);
+        if (avx && (ebx & CPUID_7_EBX_AVX2))
+            result |= X86_STRING_AVX2;
+        if (ebx & CPUID_7_EBX_ERMS)
+            result |= X86_STRING_ERMS;
+    }
+
+    __atomic_store_n(&features, result, __ATOMIC_RELAXED);
+    return result;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "libc.h"
+
+// The CPU features which the string functions' IFUNC resolvers select
+// implementations by.
+#define X86_STRING_AVX2 (1u << 0)
+#define X86_STRING_ERMS (1u << 1)
+
+// Returns the X86_STRING_* bits supported by this CPU.
+//
+// This is called by IFUNC resolvers, which run before libc has been
+// relocated, so it and everything it calls only use PC-relative
+// references to hidden symbols.
+unsigned int __x86_string_features(void) ATTR_LIBC_VISIBILITY;
@@ -0,0 +1,35 @@
+// Template for memchr.c; see vec.h.
+
+VEC_TARGET __NO_SAFESTACK static void* VEC_NAME(memchr)(const void* src, int c, size_t n) {
+    if (!n)
+        return NULL;
+
+    // As in strlen, only aligned vectors are loaded, so reading the bytes
+    // around the buffer is safe.  Matches past the end are ignored.
+    const unsigned char* s = src;
+    uintptr_t misalign = (uintptr_t)s & (VEC_SIZE - 1);
+    const unsigned char* p = s - misalign;
+    VEC needle = VEC_SET1(c);
+    uint32_t mask = VEC_EQ_MASK(VEC_LOAD(p), needle) >> misalign;
+    if (mask) {
+        size_t i = __builtin_ctz(mask);
+        return i < n ? (void*)(s + i) : NULL;
+    }
+    size_t scanned = VEC_SIZE - misalign;
+    if (n <= scanned)
+        return NULL;
+    n -= scanned;
+
+    // |n| is now the number of bytes left from |p + VEC_SIZE|.
+    for (;;) {
+        p += VEC_SIZE;
+        mask = VEC_EQ_MASK(VEC_LOAD(p), needle);
+        if (mask) {
+            size_t i = __builtin_ctz(mask);
+            return i < n ? (void*)(p + i) : NULL;
+        }
+        if (n <= VEC_SIZE)
+            return NULL;
+        n -= VEC_SIZE;
+    }
+}
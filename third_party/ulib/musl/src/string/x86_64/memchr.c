@@ -0,0 +1,17 @@
+#include <string.h>
+
+#define VEC_SIZE 16
+#include "vec.h"
+#include "memchr-vec.h"
+#undef VEC_SIZE
+
+#define VEC_SIZE 32
+#include "vec.h"
+#include "memchr-vec.h"
+#undef VEC_SIZE
+
+__NO_SAFESTACK static __typeof(memchr)* resolve_memchr(void) {
+    return (__x86_string_features() & X86_STRING_AVX2) ? __memchr_avx2 : __memchr_sse2;
+}
+
+void* memchr(const void* src, int c, size_t n) __attribute__((ifunc("resolve_memchr")));
@@ -0,0 +1,83 @@
+// Template for memcmp.c; see vec.h.
+
+#ifndef MEMCMP_SMALL_DEFINED
+#define MEMCMP_SMALL_DEFINED
+
+// Returns the difference between the first differing bytes of |l| and
+// |r| at or after |offset|, given the bitwise difference |diff| of the
+// little-endian words loaded from there.
+__NO_SAFESTACK static inline int diff_bytes(const unsigned char* l, const unsigned char* r,
+                                            size_t offset, uint64_t diff) {
+    size_t i = offset + __builtin_ctzll(diff) / 8;
+    return l[i] - r[i];
+}
+
+// Like diff_bytes(), but for a mask with one bit set for each byte which
+// differs, as computed from a vector comparison.
+__NO_SAFESTACK static inline int diff_mask(const unsigned char* l, const unsigned char* r,
+                                           size_t offset, uint32_t mask) {
+    size_t i = offset + __builtin_ctz(mask);
+    return l[i] - r[i];
+}
+
+// Compares fewer than 16 bytes.
+__NO_SAFESTACK static inline int compare_below_16(const unsigned char* l,
+                                                  const unsigned char* r, size_t n) {
+    if (n >= 8) {
+        uint64_t diff = *(const unaligned_u64*)l ^ *(const unaligned_u64*)r;
+        if (diff)
+            return diff_bytes(l, r, 0, diff);
+        diff = *(const unaligned_u64*)(l + n - 8) ^ *(const unaligned_u64*)(r + n - 8);
+        return diff ? diff_bytes(l, r, n - 8, diff) : 0;
+    }
+    if (n >= 4) {
+        uint32_t diff = *(const unaligned_u32*)l ^ *(const unaligned_u32*)r;
+        if (diff)
+            return diff_bytes(l, r, 0, diff);
+        diff = *(const unaligned_u32*)(l + n - 4) ^ *(const unaligned_u32*)(r + n - 4);
+        return diff ? diff_bytes(l, r, n - 4, diff) : 0;
+    }
+    for (; n && *l == *r; n--, l++, r++)
+        ;
+    return n ? *l - *r : 0;
+}
+
+#endif // MEMCMP_SMALL_DEFINED
+
+VEC_TARGET __NO_SAFESTACK static int VEC_NAME(memcmp)(const void* vl, const void* vr, size_t n) {
+    const unsigned char* l = vl;
+    const unsigned char* r = vr;
+
+    if (n < VEC_SIZE) {
+#if VEC_SIZE > 16
+        if (n >= 16) {
+            uint32_t ne = ~(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(
+                _mm_loadu_si128((const __m128i*)l), _mm_loadu_si128((const __m128i*)r)));
+            ne &= VEC_MASK_ALL(16);
+            if (ne)
+                return diff_mask(l, r, 0, ne);
+            size_t offset = n - 16;
+            ne = ~(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(
+                _mm_loadu_si128((const __m128i*)(l + offset)),
+                _mm_loadu_si128((const __m128i*)(r + offset))));
+            ne &= VEC_MASK_ALL(16);
+            return ne ? diff_mask(l, r, offset, ne) : 0;
+        }
+#endif
+        return compare_below_16(l, r, n);
+    }
+
+    // Compare whole vectors, then the last vector, which may overlap the
+    // previous one.  Each bit set in |ne| is a byte which differs.
+    size_t offset = 0;
+    for (; offset < n - VEC_SIZE; offset += VEC_SIZE) {
+        uint32_t ne = ~VEC_EQ_MASK(VEC_LOADU(l + offset), VEC_LOADU(r + offset)) &
+                      VEC_MASK_ALL(VEC_SIZE);
+        if (ne)
+            return diff_mask(l, r, offset, ne);
+    }
+    offset = n - VEC_SIZE;
+    uint32_t ne = ~VEC_EQ_MASK(VEC_LOADU(l + offset), VEC_LOADU(r + offset)) &
+                  VEC_MASK_ALL(VEC_SIZE);
+    return ne ? diff_mask(l, r, offset, ne) : 0;
+}
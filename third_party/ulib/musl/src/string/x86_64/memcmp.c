@@ -0,0 +1,17 @@
+#include <string.h>
+
+#define VEC_SIZE 16
+#include "vec.h"
+#include "memcmp-vec.h"
+#undef VEC_SIZE
+
+#define VEC_SIZE 32
+#include "vec.h"
+#include "memcmp-vec.h"
+#undef VEC_SIZE
+
+__NO_SAFESTACK static __typeof(memcmp)* resolve_memcmp(void) {
+    return (__x86_string_features() & X86_STRING_AVX2) ? __memcmp_avx2 : __memcmp_sse2;
+}
+
+int memcmp(const void* vl, const void* vr, size_t n) __attribute__((ifunc("resolve_memcmp")));
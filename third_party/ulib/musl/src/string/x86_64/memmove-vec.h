@@ -0,0 +1,125 @@
+// Template for memmove.c; see vec.h.
+
+#ifndef MEMMOVE_SMALL_DEFINED
+#define MEMMOVE_SMALL_DEFINED
+
+// Copies fewer than 16 bytes.  Every load happens before the stores, so
+// this also works for overlapping buffers.
+__NO_SAFESTACK static inline void move_below_16(unsigned char* d, const unsigned char* s,
+                                                size_t n) {
+    if (n >= 8) {
+        uint64_t a = *(const unaligned_u64*)s;
+        uint64_t b = *(const unaligned_u64*)(s + n - 8);
+        *(unaligned_u64*)d = a;
+        *(unaligned_u64*)(d + n - 8) = b;
+    } else if (n >= 4) {
+        uint32_t a = *(const unaligned_u32*)s;
+        uint32_t b = *(const unaligned_u32*)(s + n - 4);
+        *(unaligned_u32*)d = a;
+        *(unaligned_u32*)(d + n - 4) = b;
+    } else if (n >= 2) {
+        uint16_t a = *(const unaligned_u16*)s;
+        uint16_t b = *(const unaligned_u16*)(s + n - 2);
+        *(unaligned_u16*)d = a;
+        *(unaligned_u16*)(d + n - 2) = b;
+    } else if (n == 1) {
+        *d = *s;
+    }
+}
+
+#endif // MEMMOVE_SMALL_DEFINED
+
+// Copies more than 8 vectors.
+VEC_TARGET __NO_SAFESTACK static void VEC_NAME(memmove_large)(unsigned char* d,
+                                                            const unsigned char* s,
+                                                            size_t n) {
+    // The first and last vectors are loaded up front and stored last, so
+    // that the loops below can use aligned stores and don't need to handle
+    // the ends of the buffer.
+    VEC head = VEC_LOADU(s);
+    VEC tail = VEC_LOADU(s + n - VEC_SIZE);
+
+    if ((uintptr_t)d - (uintptr_t)s >= n) {
+        // |d| doesn't start inside the source, so copying forwards never
+        // overwrites source bytes which haven't been read yet.
+        if (n >= ERMS_THRESHOLD(VEC_SIZE) && (uintptr_t)s - (uintptr_t)d >= n &&
+            (__x86_string_features() & X86_STRING_ERMS)) {
+            __asm__ volatile("rep movsb"
+                             : "+D"(d), "+S"(s), "+c"(n)
+                             :
+                             : "memory");
+            return;
+        }
+        unsigned char* end = d + n - VEC_SIZE;
+        size_t skip = VEC_SIZE - ((uintptr_t)d & (VEC_SIZE - 1));
+        unsigned char* dp = d + skip;
+        const unsigned char* sp = s + skip;
+        for (; dp < end; dp += VEC_SIZE, sp += VEC_SIZE)
+            VEC_STORE(dp, VEC_LOADU(sp));
+        VEC_STOREU(end, tail);
+        VEC_STOREU(d, head);
+    } else {
+        // |d| starts inside the source, so copy backwards.
+        unsigned char* dp = (unsigned char*)((uintptr_t)(d + n) & -VEC_SIZE);
+        const unsigned char* sp = s + (dp - d);
+        for (; dp > d + VEC_SIZE; dp -= VEC_SIZE, sp -= VEC_SIZE)
+            VEC_STORE(dp - VEC_SIZE, VEC_LOADU(sp - VEC_SIZE));
+        VEC_STOREU(d, head);
+        VEC_STOREU(d + n - VEC_SIZE, tail);
+    }
+}
+
+// Implements both memcpy and memmove.  Up to 8 vectors are copied by
+// loading all of them before storing any, which handles overlap for free.
+VEC_TARGET __NO_SAFESTACK static void* VEC_NAME(memmove)(void* dest, const void* src,
+                                                     size_t n) {
+    unsigned char* d = dest;
+    const unsigned char* s = src;
+
+    if (n < VEC_SIZE) {
+#if VEC_SIZE > 16
+        if (n >= 16) {
+            __m128i a = _mm_loadu_si128((const __m128i*)s);
+            __m128i b = _mm_loadu_si128((const __m128i*)(s + n - 16));
+            _mm_storeu_si128((__m128i*)d, a);
+            _mm_storeu_si128((__m128i*)(d + n - 16), b);
+            return dest;
+        }
+#endif
+        move_below_16(d, s, n);
+    } else if (n <= 2 * VEC_SIZE) {
+        VEC a = VEC_LOADU(s);
+        VEC b = VEC_LOADU(s + n - VEC_SIZE);
+        VEC_STOREU(d, a);
+        VEC_STOREU(d + n - VEC_SIZE, b);
+    } else if (n <= 4 * VEC_SIZE) {
+        VEC a = VEC_LOADU(s);
+        VEC b = VEC_LOADU(s + VEC_SIZE);
+        VEC c = VEC_LOADU(s + n - 2 * VEC_SIZE);
+        VEC e = VEC_LOADU(s + n - VEC_SIZE);
+        VEC_STOREU(d, a);
+        VEC_STOREU(d + VEC_SIZE, b);
+        VEC_STOREU(d + n - 2 * VEC_SIZE, c);
+        VEC_STOREU(d + n - VEC_SIZE, e);
+    } else if (n <= 8 * VEC_SIZE) {
+        VEC a = VEC_LOADU(s);
+        VEC b = VEC_LOADU(s + VEC_SIZE);
+        VEC c = VEC_LOADU(s + 2 * VEC_SIZE);
+        VEC e = VEC_LOADU(s + 3 * VEC_SIZE);
+        VEC f = VEC_LOADU(s + n - 4 * VEC_SIZE);
+        VEC g = VEC_LOADU(s + n - 3 * VEC_SIZE);
+        VEC h = VEC_LOADU(s + n - 2 * VEC_SIZE);
+        VEC i = VEC_LOADU(s + n - VEC_SIZE);
+        VEC_STOREU(d, a);
+        VEC_STOREU(d + VEC_SIZE, b);
+        VEC_STOREU(d + 2 * VEC_SIZE, c);
+        VEC_STOREU(d + 3 * VEC_SIZE, e);
+        VEC_STOREU(d + n - 4 * VEC_SIZE, f);
+        VEC_STOREU(d + n - 3 * VEC_SIZE, g);
+        VEC_STOREU(d + n - 2 * VEC_SIZE, h);
+        VEC_STOREU(d + n - VEC_SIZE, i);
+    } else {
+        VEC_NAME(memmove_large)(d, s, n);
+    }
+    return dest;
+}
@@ -0,0 +1,32 @@
+#include <string.h>
+#include <zircon/sanitizer.h>
+
+#define VEC_SIZE 16
+#include "vec.h"
+#include "memmove-vec.h"
+#undef VEC_SIZE
+
+#define VEC_SIZE 32
+#include "vec.h"
+#include "memmove-vec.h"
+#undef VEC_SIZE
+
+// The dynamic linker calls these to pick the implementation of the
+// functions below when it binds references to them.
+__NO_SAFESTACK static __typeof(memmove)* resolve_memmove(void) {
+    return (__x86_string_features() & X86_STRING_AVX2) ? __memmove_avx2 : __memmove_sse2;
+}
+
+__NO_SAFESTACK static __typeof(memcpy)* resolve_memcpy(void) {
+    return resolve_memmove();
+}
+
+void* memmove(void* dest, const void* src, size_t n)
+    __attribute__((ifunc("resolve_memmove")));
+void* __unsanitized_memmove(void* dest, const void* src, size_t n)
+    __attribute__((ifunc("resolve_memmove")));
+
+void* memcpy(void* restrict dest, const void* restrict src, size_t n)
+    __attribute__((ifunc("resolve_memcpy")));
+void* __unsanitized_memcpy(void* restrict dest, const void* restrict src, size_t n)
+    __attribute__((ifunc("resolve_memcpy")));
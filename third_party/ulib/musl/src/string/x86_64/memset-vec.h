@@ -0,0 +1,67 @@
+// Template for memset.c; see vec.h.
+
+#ifndef MEMSET_SMALL_DEFINED
+#define MEMSET_SMALL_DEFINED
+
+// Sets fewer than 16 bytes.
+__NO_SAFESTACK static inline void set_below_16(unsigned char* d, int c, size_t n) {
+    uint64_t v = (unsigned char)c * UINT64_C(0x0101010101010101);
+    if (n >= 8) {
+        *(unaligned_u64*)d = v;
+        *(unaligned_u64*)(d + n - 8) = v;
+    } else if (n >= 4) {
+        *(unaligned_u32*)d = (uint32_t)v;
+        *(unaligned_u32*)(d + n - 4) = (uint32_t)v;
+    } else if (n >= 2) {
+        *(unaligned_u16*)d = (uint16_t)v;
+        *(unaligned_u16*)(d + n - 2) = (uint16_t)v;
+    } else if (n == 1) {
+        *d = (unsigned char)c;
+    }
+}
+
+#endif // MEMSET_SMALL_DEFINED
+
+VEC_TARGET __NO_SAFESTACK static void* VEC_NAME(memset)(void* dest, int c, size_t n) {
+    unsigned char* d = dest;
+
+    if (n < VEC_SIZE) {
+#if VEC_SIZE > 16
+        if (n >= 16) {
+            __m128i v = _mm_set1_epi8((char)c);
+            _mm_storeu_si128((__m128i*)d, v);
+            _mm_storeu_si128((__m128i*)(d + n - 16), v);
+            return dest;
+        }
+#endif
+        set_below_16(d, c, n);
+        return dest;
+    }
+
+    VEC v = VEC_SET1(c);
+    if (n <= 2 * VEC_SIZE) {
+        VEC_STOREU(d, v);
+        VEC_STOREU(d + n - VEC_SIZE, v);
+    } else if (n <= 4 * VEC_SIZE) {
+        VEC_STOREU(d, v);
+        VEC_STOREU(d + VEC_SIZE, v);
+        VEC_STOREU(d + n - 2 * VEC_SIZE, v);
+        VEC_STOREU(d + n - VEC_SIZE, v);
+    } else if (n >= ERMS_THRESHOLD(VEC_SIZE) &&
+               (__x86_string_features() & X86_STRING_ERMS)) {
+        __asm__ volatile("rep stosb"
+                         : "+D"(d), "+c"(n)
+                         : "a"(c)
+                         : "memory");
+    } else {
+        // Store the unaligned ends separately so that the loop can use
+        // aligned stores.
+        VEC_STOREU(d, v);
+        VEC_STOREU(d + n - VEC_SIZE, v);
+        unsigned char* end = d + n - VEC_SIZE;
+        unsigned char* p = (unsigned char*)((uintptr_t)(d + VEC_SIZE) & -VEC_SIZE);
+        for (; p < end; p += VEC_SIZE)
+            VEC_STORE(p, v);
+    }
+    return dest;
+}
@@ -0,0 +1,25 @@
+#include <string.h>
+#include <zircon/sanitizer.h>
+
+#define VEC_SIZE 16
+#include "vec.h"
+#include "memset-vec.h"
+#undef VEC_SIZE
+
+#define VEC_SIZE 32
+#include "vec.h"
+#include "memset-vec.h"
+#undef VEC_SIZE
+
+__NO_SAFESTACK static __typeof(memset)* resolve_memset(void) {
+    return (__x86_string_features() & X86_STRING_AVX2) ? __memset_avx2 : __memset_sse2;
+}
+
+void* memset(void* dest, int c, size_t n) __attribute__((ifunc("resolve_memset")));
+void* __unsanitized_memset(void* dest, int c, size_t n) __attribute__((ifunc("resolve_memset")));
+
+// This name is called from inside libc to avoid going through the PLT,
+// including by the dynamic linker before it has relocated libc, so it is
+// bound directly to the implementation that works on every CPU.
+void* __libc_memset(void* dest, int c, size_t n) ATTR_LIBC_VISIBILITY
+    __attribute__((alias("__memset_sse2")));
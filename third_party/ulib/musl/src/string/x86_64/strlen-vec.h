@@ -0,0 +1,18 @@
+// Template for strlen.c; see vec.h.
+
+VEC_TARGET __NO_SAFESTACK static size_t VEC_NAME(strlen)(const char* s) {
+    // Only aligned vectors are loaded.  They never cross a page boundary,
+    // so reading the bytes around the string is safe.
+    uintptr_t misalign = (uintptr_t)s & (VEC_SIZE - 1);
+    const char* p = s - misalign;
+    VEC zero = VEC_SET1(0);
+    uint32_t mask = VEC_EQ_MASK(VEC_LOAD(p), zero) >> misalign;
+    if (mask)
+        return __builtin_ctz(mask);
+    for (;;) {
+        p += VEC_SIZE;
+        mask = VEC_EQ_MASK(VEC_LOAD(p), zero);
+        if (mask)
+            return p - s + __builtin_ctz(mask);
+    }
+}
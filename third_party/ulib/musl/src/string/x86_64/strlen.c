@@ -0,0 +1,17 @@
+#include <string.h>
+
+#define VEC_SIZE 16
+#include "vec.h"
+#include "strlen-vec.h"
+#undef VEC_SIZE
+
+#define VEC_SIZE 32
+#include "vec.h"
+#include "strlen-vec.h"
+#undef VEC_SIZE
+
+__NO_SAFESTACK static __typeof(strlen)* resolve_strlen(void) {
+    return (__x86_string_features() & X86_STRING_AVX2) ? __strlen_avx2 : __strlen_sse2;
+}
+
+size_t strlen(const char* s) __attribute__((ifunc("resolve_strlen")));
@@ -0,0 +1,65 @@
+// This file is included once for each vector width by the string function
+// templates, so that the same code can be compiled for SSE2 and AVX2.
+// Define VEC_SIZE to 16 or 32 before including it.
+
+#include <immintrin.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <zircon/compiler.h>
+
+#include "cpu-features.h"
+
+#undef VEC
+#undef VEC_TARGET
+#undef VEC_NAME
+#undef VEC_LOAD
+#undef VEC_LOADU
+#undef VEC_STORE
+#undef VEC_STOREU
+#undef VEC_SET1
+#undef VEC_EQ_MASK
+
+#if VEC_SIZE == 16
+
+#define VEC __m128i
+#define VEC_TARGET
+#define VEC_NAME(name) __##name##_sse2
+#define VEC_LOAD(p) _mm_load_si128((const __m128i*)(p))
+#define VEC_LOADU(p) _mm_loadu_si128((const __m128i*)(p))
+#define VEC_STORE(p, v) _mm_store_si128((__m128i*)(p), (v))
+#define VEC_STOREU(p, v) _mm_storeu_si128((__m128i*)(p), (v))
+#define VEC_SET1(c) _mm_set1_epi8((char)(c))
+#define VEC_EQ_MASK(a, b) ((uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8((a), (b))))
+
+#elif VEC_SIZE == 32
+
+#define VEC __m256i
+#define VEC_TARGET __attribute__((target("avx2")))
+#define VEC_NAME(name) __##name##_avx2
+#define VEC_LOAD(p) _mm256_load_si256((const __m256i*)(p))
+#define VEC_LOADU(p) _mm256_loadu_si256((const __m256i*)(p))
+#define VEC_STORE(p, v) _mm256_store_si256((__m256i*)(p), (v))
+#define VEC_STOREU(p, v) _mm256_storeu_si256((__m256i*)(p), (v))
+#define VEC_SET1(c) _mm256_set1_epi8((char)(c))
+#define VEC_EQ_MASK(a, b) ((uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8((a), (b))))
+
+#else
+#error "VEC_SIZE must be 16 or 32"
+#endif
+
+#ifndef VEC_COMMON_DEFINED
+#define VEC_COMMON_DEFINED
+
+// Mask with one bit for each byte of a vector.
+#define VEC_MASK_ALL(size) ((uint32_t)((UINT64_C(1) << (size)) - 1))
+
+// Above this size, "rep movsb" and "rep stosb" beat vector loops on CPUs
+// with ERMS, as in glibc.
+#define ERMS_THRESHOLD(size) (2048 * ((size) / 16))
+
+// Scalar accesses for the sizes below a vector.
+typedef uint64_t __attribute__((__may_alias__, __aligned__(1))) unaligned_u64;
+typedef uint32_t __attribute__((__may_alias__, __aligned__(1))) unaligned_u32;
+typedef uint16_t __attribute__((__may_alias__, __aligned__(1))) unaligned_u16;
+
+#endif // VEC_COMMON_DEFINED
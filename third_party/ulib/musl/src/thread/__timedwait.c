@@ -28,3 +28,27 @@ int __timedwait(atomic_int* futex, int val, clockid_t clk, const struct timespec
         __builtin_trap();
     }
 }
+
+int __timedwait_pi(atomic_int* futex, int val, zx_handle_t owner, clockid_t clk,
+                   const struct timespec* at) {
+    zx_time_t deadline = ZX_TIME_INFINITE;
+
+    if (at) {
+        int ret = __timespec_to_deadline(at, clk, &deadline);
+        if (ret)
+            return ret;
+    }
+
+    switch (_zx_futex_wait_pi(futex, val, owner, deadline)) {
+    case ZX_OK:
+    case ZX_ERR_BAD_STATE:
+        return 0;
+    case ZX_ERR_TIMED_OUT:
+        return ETIMEDOUT;
+    default:
+        // The owner exited without unlocking the mutex, or is the calling
+        // thread relocking a normal mutex. There is nobody to lend our
+        // priority to, so wait without doing so.
+        return __timedwait(futex, val, clk, at);
+    }
+}